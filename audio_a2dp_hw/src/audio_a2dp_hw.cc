@@ -59,6 +59,7 @@
 #include "osi/include/socket_utils/sockets.h"
 
 #include "audio_a2dp_hw.h"
+#include "udrv/include/uipc_shm.h"
 
 #ifdef BT_AUDIO_SYSTRACE_LOG
 #include <cutils/trace.h>
@@ -146,6 +147,8 @@ struct a2dp_stream_common {
   std::recursive_mutex* mutex;  // See note below on mutex acquisition order.
   int ctrl_fd;
   int audio_fd;
+  uipc_shm_t* audio_shm;  // PCM ring next to the data socket, if any
+  bool use_audio_shm;     // only the output stream produces into the ring
   size_t buffer_sz;
   struct a2dp_config cfg;
   a2dp_state_t state;
@@ -913,6 +916,8 @@ static void a2dp_stream_common_init(struct a2dp_stream_common* common) {
 
   common->ctrl_fd = AUDIO_SKT_DISCONNECTED;
   common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  common->audio_shm = NULL;
+  common->use_audio_shm = false;
   common->state = AUDIO_A2DP_STATE_STOPPED;
 
   /* manages max capacity of socket pipe */
@@ -927,6 +932,14 @@ static void a2dp_stream_common_destroy(struct a2dp_stream_common* common) {
   common->mutex = NULL;
 }
 
+static void disconnect_audio_datapath(struct a2dp_stream_common* common) {
+  uipc_shm_free(common->audio_shm);
+  common->audio_shm = NULL;
+
+  skt_disconnect(common->audio_fd);
+  common->audio_fd = AUDIO_SKT_DISCONNECTED;
+}
+
 static int start_audio_datapath(struct a2dp_stream_common* common) {
   INFO("state %d", common->state);
 
@@ -983,6 +996,11 @@ static int start_audio_datapath(struct a2dp_stream_common* common) {
         ERROR("Audiopath start failed - error opening data socket");
         goto error;
       }
+    } else if (common->use_audio_shm) {
+      /* the stack only creates the ring when the PCM ring is enabled; without
+         it the data keeps going through the socket */
+      common->audio_shm = uipc_shm_attach(A2DP_DATA_PATH UIPC_SHM_PATH_SUFFIX);
+      if (common->audio_shm) INFO("writing PCM through the shared ring");
     }
   }
   common->state = (a2dp_state_t)AUDIO_A2DP_STATE_STARTED;
@@ -1017,8 +1035,7 @@ static int stop_audio_datapath(struct a2dp_stream_common* common) {
   common->state = (a2dp_state_t)AUDIO_A2DP_STATE_STOPPED;
 
   /* disconnect audio path */
-  skt_disconnect(common->audio_fd);
-  common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  disconnect_audio_datapath(common);
 
   return 0;
 }
@@ -1044,9 +1061,7 @@ static int suspend_audio_datapath(struct a2dp_stream_common* common,
     common->state = AUDIO_A2DP_STATE_SUSPENDED;
 
   /* disconnect audio path */
-  skt_disconnect(common->audio_fd);
-
-  common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  disconnect_audio_datapath(common);
   return 0;
 }
 
@@ -1114,7 +1129,12 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
       ATRACE_BEGIN(trace_buf);
   }
   #endif
-  sent = skt_write(out->common.audio_fd, buffer, write_bytes);
+  if (out->common.audio_shm) {
+    sent = (int)uipc_shm_write(out->common.audio_shm, buffer, write_bytes,
+                               SOCK_SEND_TIMEOUT_MS);
+  } else {
+    sent = skt_write(out->common.audio_fd, buffer, write_bytes);
+  }
   #ifdef BT_AUDIO_SYSTRACE_LOG
   if (PERF_SYSTRACE)
   {
@@ -1130,8 +1150,7 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
       ERROR("ignore data write failure");
     }
 
-    skt_disconnect(out->common.audio_fd);
-    out->common.audio_fd = AUDIO_SKT_DISCONNECTED;
+    disconnect_audio_datapath(&out->common);
     if ((out->common.state != AUDIO_A2DP_STATE_SUSPENDED) &&
             (out->common.state != AUDIO_A2DP_STATE_STOPPING)) {
       out->common.state = AUDIO_A2DP_STATE_STOPPED;
@@ -1782,6 +1801,7 @@ static int adev_open_output_stream(struct audio_hw_device* dev,
 
   /* initialize a2dp specifics */
   a2dp_stream_common_init(&out->common);
+  out->common.use_audio_shm = true;
 
   // Make sure we always have the feeding parameters configured
   btav_a2dp_codec_config_t codec_config;
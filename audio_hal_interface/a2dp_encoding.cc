@@ -59,6 +59,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE
 #include "a2dp_vendor_aptx_adaptive.h"
 #include "a2dp_aac.h"
 #include "bta/av/bta_av_int.h"
+#include "btif_a2dp_latency.h"
 #include "btif_a2dp_source.h"
 #include "btif_av.h"
 #include "btif_av_co.h"
@@ -174,7 +175,8 @@ class A2dpTransport : public ::bluetooth::audio::IBluetoothTransportInstance {
       LOG(WARNING) << __func__ << ": Not active";
       return false;
     }
-    *remote_delay_report = remote_delay_report_;
+    *remote_delay_report =
+        btif_a2dp_latency_get_presentation_delay(remote_delay_report_);
     *total_bytes_read = total_bytes_read_;
     *data_position = data_position_;
     VLOG(2) << __func__ << ": delay=" << remote_delay_report_
@@ -294,7 +296,8 @@ class A2dpTransport_2_1 : public ::bluetooth::audio::IBluetoothTransportInstance
       LOG(WARNING) << __func__ << ": Not active";
       return false;
     }
-    *remote_delay_report = remote_delay_report_;
+    *remote_delay_report =
+        btif_a2dp_latency_get_presentation_delay(remote_delay_report_);
     *total_bytes_read = total_bytes_read_;
     *data_position = data_position_;
     VLOG(2) << __func__ << ": delay=" << remote_delay_report_
@@ -54,6 +54,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE
 #include "a2dp_encoding.h"
 
 #include "a2dp_sbc_constants.h"
+#include "btif_a2dp_latency.h"
 #include "btif_a2dp_source.h"
 #include "btif_av.h"
 #include "btif_av_co.h"
@@ -157,7 +158,9 @@ void A2dpTransport::StopRequest() {
 bool A2dpTransport::GetPresentationPosition(uint64_t* remote_delay_report_ns,
                                             uint64_t* total_bytes_read,
                                             timespec* data_position) {
-  *remote_delay_report_ns = remote_delay_report_ * 100000ULL;
+  *remote_delay_report_ns =
+      btif_a2dp_latency_get_presentation_delay(remote_delay_report_) *
+      100000ULL;
   *total_bytes_read = total_bytes_read_;
   *data_position = data_position_;
   LOG(INFO) << __func__ << "AIDL: delay=" << remote_delay_report_
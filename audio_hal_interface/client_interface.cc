@@ -24,6 +24,8 @@
 #include <vendor/qti/hardware/bluetooth_audio/2.1/IBluetoothAudioProvidersFactory.h>
 #include <base/logging.h>
 #include <hidl/MQDescriptor.h>
+#include <string.h>
+#include <algorithm>
 #include <future>
 
 #include "osi/include/log.h"
@@ -47,6 +49,57 @@ using DataMQ = ::android::hardware::MessageQueue<
 static constexpr int kDefaultDataReadTimeoutMs = 3;      // 3 ms
 static constexpr int kDefaultDataReadPollIntervalMs = 1;  // non-blocking poll
 
+static uint32_t pcm_bytes_per_second(const PcmParameters& pcm_config) {
+  uint32_t sample_rate;
+  switch (pcm_config.sampleRate) {
+    case SampleRate::RATE_16000:
+      sample_rate = 16000;
+      break;
+    case SampleRate::RATE_24000:
+      sample_rate = 24000;
+      break;
+    case SampleRate::RATE_32000:
+      sample_rate = 32000;
+      break;
+    case SampleRate::RATE_44100:
+      sample_rate = 44100;
+      break;
+    case SampleRate::RATE_48000:
+      sample_rate = 48000;
+      break;
+    case SampleRate::RATE_88200:
+      sample_rate = 88200;
+      break;
+    case SampleRate::RATE_96000:
+      sample_rate = 96000;
+      break;
+    case SampleRate::RATE_176400:
+      sample_rate = 176400;
+      break;
+    case SampleRate::RATE_192000:
+      sample_rate = 192000;
+      break;
+    default:
+      return 0;
+  }
+  uint32_t bytes_per_sample;
+  switch (pcm_config.bitsPerSample) {
+    case BitsPerSample::BITS_16:
+      bytes_per_sample = 2;
+      break;
+    case BitsPerSample::BITS_24:
+      bytes_per_sample = 3;
+      break;
+    case BitsPerSample::BITS_32:
+      bytes_per_sample = 4;
+      break;
+    default:
+      return 0;
+  }
+  uint32_t channels = pcm_config.channelMode == ChannelMode::STEREO ? 2 : 1;
+  return sample_rate * bytes_per_sample * channels;
+}
+
 std::ostream& operator<<(std::ostream& os, const BluetoothAudioCtrlAck& ack) {
   switch (ack) {
     case BluetoothAudioCtrlAck::SUCCESS_FINISHED:
@@ -285,6 +338,8 @@ BluetoothAudioClientInterface::BluetoothAudioClientInterface(
       stack_if_2_1_(nullptr),
       session_started_(false),
       mDataMQ(nullptr),
+      data_mq_event_flag_(nullptr),
+      data_mq_bytes_per_second_(0),
       external_mutex_(mutex),
       death_recipient_(new BluetoothAudioDeathRecipient(this, message_loop)) {}
 
@@ -299,8 +354,14 @@ BluetoothAudioClientInterface::BluetoothAudioClientInterface(
       stack_if_2_1_(nullptr),
       session_started_(false),
       mDataMQ(nullptr),
+      data_mq_event_flag_(nullptr),
+      data_mq_bytes_per_second_(0),
       external_mutex_(mutex),
       death_recipient_(new BluetoothAudioDeathRecipient(this, message_loop)) {}
+BluetoothAudioClientInterface::~BluetoothAudioClientInterface() {
+  close_data_path();
+}
+
 std::vector<audioCapabilities>
 BluetoothAudioClientInterface::GetAudioCapabilities() const {
   return capabilities_;
@@ -566,7 +627,7 @@ int BluetoothAudioClientInterface::StartSession() {
     }
   }
   if (tempDataMQ && tempDataMQ->isValid()) {
-    mDataMQ = std::move(tempDataMQ);
+    open_data_path(std::move(tempDataMQ));
   } else if (sink_2_1_ && sink_2_1_->GetSessionType() ==
                  SessionType::A2DP_HARDWARE_OFFLOAD_DATAPATH &&
              session_status == BluetoothAudioStatus::SUCCESS) {
@@ -672,7 +733,7 @@ int BluetoothAudioClientInterface::EndSession() {
     LOG(ERROR) << __func__ << ": BluetoothAudioHal nullptr";
     return -EINVAL;
   }
-  mDataMQ = nullptr;
+  close_data_path();
   if (provider_2_1_ != nullptr) {
     auto hidl_retval = provider_2_1_->endSession();
     if (!hidl_retval.isOk()) {
@@ -697,56 +758,156 @@ int BluetoothAudioClientInterface::EndSession() {
   return 0;
 }
 
-size_t BluetoothAudioClientInterface::ReadAudioData(uint8_t* p_buf,
-                                                    uint32_t len) {
+void BluetoothAudioClientInterface::open_data_path(
+    std::unique_ptr<DataMQ> data_mq) {
+  close_data_path();
+  mDataMQ = std::move(data_mq);
+
+  PcmParameters pcm_config =
+      sink_2_1_ ? sink_2_1_->GetAudioConfiguration().pcmConfig
+                : sink_->GetAudioConfiguration().pcmConfig;
+  data_mq_bytes_per_second_ = pcm_bytes_per_second(pcm_config);
+
+  std::atomic<uint32_t>* event_flag_word = mDataMQ->getEventFlagWord();
+  if (event_flag_word != nullptr &&
+      ::android::hardware::EventFlag::createEventFlag(
+          event_flag_word, &data_mq_event_flag_) != ::android::OK) {
+    LOG(WARNING) << __func__ << ": cannot map the data path event flag";
+    data_mq_event_flag_ = nullptr;
+  }
+  LOG(INFO) << __func__ << ": " << data_mq_bytes_per_second_
+            << " bytes/s, event flag=" << (data_mq_event_flag_ != nullptr);
+}
+
+void BluetoothAudioClientInterface::close_data_path() {
+  if (data_mq_event_flag_ != nullptr) {
+    ::android::hardware::EventFlag::deleteEventFlag(&data_mq_event_flag_);
+    data_mq_event_flag_ = nullptr;
+  }
+  mDataMQ = nullptr;
+  data_mq_bytes_per_second_ = 0;
+}
+
+// Waits until |len| bytes are queued or |timeout_ms| passed. With an event
+// flag the HAL wakes it on each write. Without one it sleeps once for the
+// time the HAL needs to produce the missing bytes, rather than polling.
+bool BluetoothAudioClientInterface::wait_for_audio_data(size_t len,
+                                                        int timeout_ms) {
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(timeout_ms);
+  while (true) {
+    size_t available = mDataMQ->availableToRead();
+    if (available >= len) return true;
+
+    auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) return false;
+    auto remaining = deadline - now;
+
+    if (data_mq_event_flag_ != nullptr) {
+      uint32_t state = 0;
+      int64_t remaining_ns =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(remaining)
+              .count();
+      data_mq_event_flag_->wait(::android::hardware::kFmqNotEmpty, &state,
+                                remaining_ns);
+      continue;
+    }
+
+    auto missing = std::chrono::milliseconds(kDefaultDataReadPollIntervalMs);
+    if (data_mq_bytes_per_second_ != 0) {
+      missing = std::max(
+          missing, std::chrono::milliseconds(
+                       (len - available) * 1000 / data_mq_bytes_per_second_));
+    }
+    if (missing > remaining) {
+      std::this_thread::sleep_for(remaining);
+    } else {
+      std::this_thread::sleep_for(missing);
+    }
+  }
+}
+
+size_t BluetoothAudioClientInterface::AcquireAudioData(uint32_t len,
+                                                       int timeout_ms,
+                                                       AudioDataSpans* spans) {
+  memset(spans, 0, sizeof(*spans));
   if (provider_ == nullptr && provider_2_1_ == nullptr) {
     LOG(ERROR) << __func__ << ": BluetoothAudioHal nullptr";
     return 0;
   }
-  if (p_buf == nullptr || len == 0) return 0;
+  if (len == 0 || mDataMQ == nullptr || !mDataMQ->isValid()) return 0;
 
-  size_t total_read = 0;
-  int timeout_ms = kDefaultDataReadTimeoutMs;
-  do {
-    if (mDataMQ == nullptr || !mDataMQ->isValid()) break;
+  if (!wait_for_audio_data(len, timeout_ms)) {
+    VLOG(1) << __func__ << ": underflow " << mDataMQ->availableToRead() << "/"
+            << len << " after " << timeout_ms << " ms";
+  }
 
-    size_t avail_to_read = mDataMQ->availableToRead();
-    if (avail_to_read) {
-      if (avail_to_read > len - total_read) {
-        avail_to_read = len - total_read;
-      }
-      if (mDataMQ->read(p_buf + total_read, avail_to_read) == 0) {
-        LOG(WARNING) << __func__ << ": len=" << len
-                     << " total_read=" << total_read << " failed";
-        break;
-      }
-      total_read += avail_to_read;
-    } else if (timeout_ms >= kDefaultDataReadPollIntervalMs) {
-      std::this_thread::sleep_for(
-          std::chrono::milliseconds(kDefaultDataReadPollIntervalMs));
-      timeout_ms -= kDefaultDataReadPollIntervalMs;
-      continue;
-    } else {
-      LOG(WARNING) << __func__ << ": " << (len - total_read) << "/" << len
-                   << " no data " << (kDefaultDataReadTimeoutMs - timeout_ms)
-                   << " ms";
-      break;
-    }
-  } while (total_read < len);
+  size_t queued = mDataMQ->availableToRead();
+  size_t to_read = std::min<size_t>(queued, len);
+  if (to_read == 0) return 0;
 
-  if (timeout_ms <
-          (kDefaultDataReadTimeoutMs - kDefaultDataReadPollIntervalMs) &&
-      timeout_ms >= kDefaultDataReadPollIntervalMs) {
-    VLOG(1) << __func__ << ": underflow " << len << " -> " << total_read
-            << " read " << (kDefaultDataReadTimeoutMs - timeout_ms) << " ms";
-  } else {
-    VLOG(2) << __func__ << ": " << len << " -> " << total_read << " read";
+  DataMQ::MemTransaction transaction;
+  if (!mDataMQ->beginRead(to_read, &transaction)) {
+    LOG(WARNING) << __func__ << ": len=" << len << " mapping " << to_read
+                 << " failed";
+    return 0;
+  }
+  const auto& first = transaction.getFirstRegion();
+  const auto& second = transaction.getSecondRegion();
+  spans->data[0] = first.getAddress();
+  spans->length[0] = first.getLength();
+  spans->data[1] = second.getAddress();
+  spans->length[1] = second.getLength();
+
+  clock_gettime(CLOCK_MONOTONIC, &spans->timestamp);
+  if (data_mq_bytes_per_second_ != 0) {
+    uint64_t now_ns = spans->timestamp.tv_sec * 1000000000ull +
+                      spans->timestamp.tv_nsec;
+    uint64_t queued_ns = queued * 1000000000ull / data_mq_bytes_per_second_;
+    uint64_t written_ns = now_ns > queued_ns ? now_ns - queued_ns : 0;
+    spans->timestamp.tv_sec = written_ns / 1000000000ull;
+    spans->timestamp.tv_nsec = written_ns % 1000000000ull;
+  }
+  VLOG(2) << __func__ << ": " << len << " -> " << spans->total() << " mapped";
+  return spans->total();
+}
+
+void BluetoothAudioClientInterface::ReleaseAudioData(size_t len) {
+  if (len == 0 || mDataMQ == nullptr) return;
+  if (!mDataMQ->commitRead(len)) {
+    LOG(WARNING) << __func__ << ": len=" << len << " failed";
+    return;
+  }
+  if (data_mq_event_flag_ != nullptr) {
+    data_mq_event_flag_->wake(::android::hardware::kFmqNotFull);
   }
   if (sink_2_1_) {
-    sink_2_1_->LogBytesRead(total_read);
+    sink_2_1_->LogBytesRead(len);
   } else {
-    sink_->LogBytesRead(total_read);
+    sink_->LogBytesRead(len);
+  }
+}
+
+size_t BluetoothAudioClientInterface::ReadAudioData(uint8_t* p_buf,
+                                                    uint32_t len) {
+  if (p_buf == nullptr || len == 0) return 0;
+
+  AudioDataSpans spans;
+  size_t total_read =
+      AcquireAudioData(len, kDefaultDataReadTimeoutMs, &spans);
+  if (total_read == 0) {
+    if (sink_2_1_) {
+      sink_2_1_->LogBytesRead(0);
+    } else if (sink_) {
+      sink_->LogBytesRead(0);
+    }
+    return 0;
+  }
+  memcpy(p_buf, spans.data[0], spans.length[0]);
+  if (spans.length[1] != 0) {
+    memcpy(p_buf + spans.length[0], spans.data[1], spans.length[1]);
   }
+  ReleaseAudioData(total_read);
   return total_read;
 }
 
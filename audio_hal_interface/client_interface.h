@@ -23,6 +23,7 @@
 #include <vendor/qti/hardware/bluetooth_audio/2.0/types.h>
 #include <vendor/qti/hardware/bluetooth_audio/2.1/IBluetoothAudioProvider.h>
 #include <vendor/qti/hardware/bluetooth_audio/2.1/types.h>
+#include <fmq/EventFlag.h>
 #include <fmq/MessageQueue.h>
 #include <hardware/audio.h>
 #include "osi/include/thread.h"
@@ -191,6 +192,19 @@ class IBluetoothTransportInstance_2_1 {
   AudioConfiguration_2_1 audio_config_2_1_;
 };
 
+// PCM mapped from the data path without copying it. The queue is a ring, so
+// the bytes may wrap into a second region. They stay in the queue until
+// released.
+struct AudioDataSpans {
+  const uint8_t* data[2];
+  size_t length[2];
+  // CLOCK_MONOTONIC time at which the HAL wrote the first byte, estimated from
+  // how much PCM was queued ahead of the read
+  timespec timestamp;
+
+  size_t total() const { return length[0] + length[1]; }
+};
+
 // common object is shared between different kind of SessionType
 class BluetoothAudioDeathRecipient;
 
@@ -209,7 +223,7 @@ class BluetoothAudioClientInterface {
       IBluetoothTransportInstance_2_1* sink,
        thread_t* message_loop, std::mutex* mutex);
   //BluetoothAudioClientInterface();
-  ~BluetoothAudioClientInterface() = default;
+  ~BluetoothAudioClientInterface();
   std::vector<audioCapabilities> GetAudioCapabilities() const;
 
   std::vector<audioCapabilities_2_1> GetAudioCapabilities_2_1() const;
@@ -241,6 +255,14 @@ class BluetoothAudioClientInterface {
   // Read data from audio  HAL through fmq
   size_t ReadAudioData(uint8_t* p_buf, uint32_t len);
 
+  // Waits up to |timeout_ms| for |len| bytes to be queued and maps up to |len|
+  // of them into |spans|. Returns how many were mapped. Every successful call
+  // must be followed by ReleaseAudioData before the next one.
+  size_t AcquireAudioData(uint32_t len, int timeout_ms, AudioDataSpans* spans);
+
+  // Hands the |len| bytes mapped by AcquireAudioData back to the HAL
+  void ReleaseAudioData(size_t len);
+
   // Write data to audio HAL through fmq
   size_t WriteAudioData(uint8_t* p_buf, uint32_t len);
 
@@ -256,6 +278,13 @@ class BluetoothAudioClientInterface {
   // Helper function to connect to an IBluetoothAudioProvider
   void fetch_audio_provider();
 
+  // Helpers for the data path, set up and torn down with |mDataMQ|
+  void open_data_path(std::unique_ptr<::android::hardware::MessageQueue<
+                          uint8_t, ::android::hardware::kSynchronizedReadWrite>>
+                          data_mq);
+  void close_data_path();
+  bool wait_for_audio_data(size_t len, int timeout_ms);
+
   IBluetoothTransportInstance* sink_;
   IBluetoothTransportInstance_2_1* sink_2_1_;
   android::sp<BluetoothAudioProvider> provider_;
@@ -268,6 +297,10 @@ class BluetoothAudioClientInterface {
   std::unique_ptr<::android::hardware::MessageQueue<
       uint8_t, ::android::hardware::kSynchronizedReadWrite>>
       mDataMQ;
+  // Woken by the HAL on writes if it set the queue up with an event flag
+  ::android::hardware::EventFlag* data_mq_event_flag_;
+  // PCM rate of the session, used to batch waits and estimate timestamps
+  uint32_t data_mq_bytes_per_second_;
   mutable std::mutex *external_mutex_;
   android::sp<BluetoothAudioDeathRecipient> death_recipient_;
 };
@@ -30,6 +30,7 @@ using AudioConfiguration =
       vendor::qti::hardware::bluetooth_audio::V2_0::AudioConfiguration;
 using AudioConfiguration_2_1 =
       vendor::qti::hardware::bluetooth_audio::V2_1::AudioConfiguration;
+using ::bluetooth::audio::AudioDataSpans;
 using ::bluetooth::audio::BitsPerSample;
 using ::bluetooth::audio::BluetoothAudioCtrlAck;
 using ::bluetooth::audio::ChannelMode;
@@ -40,6 +41,9 @@ using ::bluetooth::audio::hearing_aid::StreamCallbacks;
 
 std::mutex internal_mutex_;
 
+// How long a read waits for the HAL to complete a frame
+static constexpr int kReadTimeoutMs = 3;
+
 // Transport implementation for Hearing Aids
 class HearingAidTransport
     : public bluetooth::audio::IBluetoothTransportInstance {
@@ -422,6 +426,21 @@ size_t read(uint8_t* p_buf, uint32_t len) {
   return hearing_aid_hal_client_if->ReadAudioData(p_buf, len);
 }
 
+size_t read(std::vector<uint8_t>* data, uint32_t len) {
+  std::unique_lock<std::mutex> guard(internal_mutex_);
+  data->clear();
+  if (!is_hal_2_0_enabled()) return 0;
+  AudioDataSpans spans;
+  size_t bytes_read =
+      hearing_aid_hal_client_if->AcquireAudioData(len, kReadTimeoutMs, &spans);
+  if (bytes_read == 0) return 0;
+  data->reserve(bytes_read);
+  data->insert(data->end(), spans.data[0], spans.data[0] + spans.length[0]);
+  data->insert(data->end(), spans.data[1], spans.data[1] + spans.length[1]);
+  hearing_aid_hal_client_if->ReleaseAudioData(bytes_read);
+  return bytes_read;
+}
+
 // Update Hearing Aids delay report to BluetoothAudio HAL
 void set_remote_delay(uint16_t delay_report_ms) {
   if (!is_hal_2_0_enabled()) {
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <functional>
+#include <vector>
 #include "osi/include/thread.h"
 
 namespace bluetooth {
@@ -49,6 +50,10 @@ void set_remote_delay(uint16_t delay_report_ms);
 // Read from the FMQ of BluetoothAudio HAL
 size_t read(uint8_t* p_buf, uint32_t len);
 
+// Read up to |len| bytes from the FMQ straight into |data|, which is resized
+// to what was read
+size_t read(std::vector<uint8_t>* data, uint32_t len);
+
 }  // namespace hearing_aid
 }  // namespace audio
 }  // namespace bluetooth
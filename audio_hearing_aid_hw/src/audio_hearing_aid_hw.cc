@@ -43,6 +43,7 @@
 #include "osi/include/socket_utils/sockets.h"
 
 #include "audio_hearing_aid_hw.h"
+#include "udrv/include/uipc_shm.h"
 
 /*****************************************************************************
  *  Constants & Macros
@@ -109,6 +110,8 @@ struct ha_stream_common {
   std::recursive_mutex* mutex;  // See note below on mutex acquisition order.
   int ctrl_fd;
   int audio_fd;
+  uipc_shm_t* audio_shm;  // PCM ring next to the data socket, if any
+  bool use_audio_shm;     // only the output stream produces into the ring
   size_t buffer_sz;
   struct ha_config cfg;
   ha_state_t state;
@@ -776,6 +779,8 @@ static void ha_stream_common_init(struct ha_stream_common* common) {
 
   common->ctrl_fd = AUDIO_SKT_DISCONNECTED;
   common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  common->audio_shm = NULL;
+  common->use_audio_shm = false;
   common->state = AUDIO_HA_STATE_STOPPED;
 
   /* manages max capacity of socket pipe */
@@ -785,10 +790,22 @@ static void ha_stream_common_init(struct ha_stream_common* common) {
 static void ha_stream_common_destroy(struct ha_stream_common* common) {
   FNLOG();
 
+  uipc_shm_free(common->audio_shm);
+  common->audio_shm = NULL;
+
   delete common->mutex;
   common->mutex = NULL;
 }
 
+static void disconnect_audio_datapath(struct ha_stream_common* common) {
+  /* out_write may still be writing into the ring without the stream lock;
+     the ring is unmapped once the path is started again or the stream goes */
+  if (common->audio_shm) uipc_shm_shutdown(common->audio_shm);
+
+  skt_disconnect(common->audio_fd);
+  common->audio_fd = AUDIO_SKT_DISCONNECTED;
+}
+
 static int start_audio_datapath(struct ha_stream_common* common) {
   INFO("state %d", common->state);
 
@@ -811,6 +828,16 @@ static int start_audio_datapath(struct ha_stream_common* common) {
       ERROR("Audiopath start failed - error opening data socket");
       goto error;
     }
+
+    uipc_shm_free(common->audio_shm);
+    common->audio_shm = NULL;
+    if (common->use_audio_shm) {
+      /* the stack only creates the ring when the PCM ring is enabled; without
+         it the data keeps going through the socket */
+      common->audio_shm =
+          uipc_shm_attach(HEARING_AID_DATA_PATH UIPC_SHM_PATH_SUFFIX);
+      if (common->audio_shm) INFO("writing PCM through the shared ring");
+    }
   }
   common->state = (ha_state_t)AUDIO_HA_STATE_STARTED;
   return 0;
@@ -838,8 +865,7 @@ static int stop_audio_datapath(struct ha_stream_common* common) {
   common->state = (ha_state_t)AUDIO_HA_STATE_STOPPED;
 
   /* disconnect audio path */
-  skt_disconnect(common->audio_fd);
-  common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  disconnect_audio_datapath(common);
 
   return 0;
 }
@@ -858,9 +884,7 @@ static int suspend_audio_datapath(struct ha_stream_common* common,
     common->state = AUDIO_HA_STATE_SUSPENDED;
 
   /* disconnect audio path */
-  skt_disconnect(common->audio_fd);
-
-  common->audio_fd = AUDIO_SKT_DISCONNECTED;
+  disconnect_audio_datapath(common);
 
   return 0;
 }
@@ -910,13 +934,20 @@ static ssize_t out_write(struct audio_stream_out* stream, const void* buffer,
           out->common.audio_fd);
   }
 
-  lock.unlock();
-  sent = skt_write(out->common.audio_fd, buffer, write_bytes);
-  lock.lock();
+  {
+    uipc_shm_t* audio_shm = out->common.audio_shm;
+    lock.unlock();
+    if (audio_shm) {
+      sent = (int)uipc_shm_write(audio_shm, buffer, write_bytes,
+                                 SOCK_SEND_TIMEOUT_MS);
+    } else {
+      sent = skt_write(out->common.audio_fd, buffer, write_bytes);
+    }
+    lock.lock();
+  }
 
   if (sent == -1) {
-    skt_disconnect(out->common.audio_fd);
-    out->common.audio_fd = AUDIO_SKT_DISCONNECTED;
+    disconnect_audio_datapath(&out->common);
     if ((out->common.state != AUDIO_HA_STATE_SUSPENDED) &&
         (out->common.state != AUDIO_HA_STATE_STOPPING)) {
       out->common.state = AUDIO_HA_STATE_STOPPED;
@@ -1551,6 +1582,7 @@ static int adev_open_output_stream(struct audio_hw_device* dev,
 
   /* initialize ha specifics */
   ha_stream_common_init(&out->common);
+  out->common.use_audio_shm = true;
 
   // Make sure we always have the feeding parameters configured
   btav_a2dp_codec_config_t codec_config;
@@ -24,6 +24,10 @@
 
 #include <string.h>
 
+#include <map>
+#include <string>
+#include <vector>
+
 #include "bt_common.h"
 #include "bta_ag_at.h"
 #include "log/log.h"
@@ -33,6 +37,109 @@
  *  Constants
  ****************************************************************************/
 
+/* Number of leading command characters an AT table is indexed by */
+#define BTA_AG_AT_KEY_LEN 3
+
+/* Index of an AT command table */
+typedef struct {
+  /* entries keyed by the first (up to BTA_AG_AT_KEY_LEN) command characters,
+   * in uppercase; each list is kept in table order */
+  std::map<std::string, std::vector<uint16_t>> cmds;
+  uint16_t num_cmds; /* index of the table terminator */
+} tBTA_AG_AT_INDEX;
+
+/* Indexes of the command tables seen so far. The tables are constant, so an
+ * index is built the first time a table is used and kept from then on. */
+static std::map<const tBTA_AG_AT_CMD*, tBTA_AG_AT_INDEX> bta_ag_at_indexes;
+
+/******************************************************************************
+ *
+ * Function         bta_ag_at_key
+ *
+ * Description      Return the first |len| characters of |p_str| in uppercase,
+ *                  or fewer if |p_str| is shorter.
+ *
+ *
+ * Returns          std::string
+ *
+ *****************************************************************************/
+static std::string bta_ag_at_key(const char* p_str, size_t len) {
+  std::string key;
+  for (size_t i = 0; i < len && p_str[i] != 0; i++) {
+    char c = p_str[i];
+    if (c >= 'a' && c <= 'z') c -= 0x20;
+    key.push_back(c);
+  }
+  return key;
+}
+
+/******************************************************************************
+ *
+ * Function         bta_ag_at_get_index
+ *
+ * Description      Return the index of AT command table |p_tbl|, building it
+ *                  on first use.
+ *
+ *
+ * Returns          Reference to the table index
+ *
+ *****************************************************************************/
+static const tBTA_AG_AT_INDEX& bta_ag_at_get_index(
+    const tBTA_AG_AT_CMD* p_tbl) {
+  auto it = bta_ag_at_indexes.find(p_tbl);
+  if (it != bta_ag_at_indexes.end()) return it->second;
+
+  tBTA_AG_AT_INDEX& index = bta_ag_at_indexes[p_tbl];
+  uint16_t idx;
+  for (idx = 0; p_tbl[idx].p_cmd[0] != 0; idx++) {
+    index.cmds[bta_ag_at_key(p_tbl[idx].p_cmd, BTA_AG_AT_KEY_LEN)].push_back(
+        idx);
+  }
+  index.num_cmds = idx;
+  return index;
+}
+
+/******************************************************************************
+ *
+ * Function         bta_ag_at_find_cmd
+ *
+ * Description      Find the entry of AT command table |p_tbl| that matches the
+ *                  command in |p_buf|. Like a walk of the whole table, the
+ *                  first entry in table order whose command is a prefix of
+ *                  |p_buf| wins, but only entries sharing the leading
+ *                  characters of |p_buf| are compared.
+ *
+ *
+ * Returns          Index of the matching entry, or of the table terminator
+ *                  if there is none.
+ *
+ *****************************************************************************/
+static uint16_t bta_ag_at_find_cmd(const tBTA_AG_AT_CMD* p_tbl,
+                                   const char* p_buf) {
+  const tBTA_AG_AT_INDEX& index = bta_ag_at_get_index(p_tbl);
+  uint16_t found = index.num_cmds;
+
+  /* Commands shorter than the key length only share a shorter key with
+   * |p_buf|, so every key length has to be looked at. */
+  for (size_t len = 1; len <= BTA_AG_AT_KEY_LEN; len++) {
+    std::string key = bta_ag_at_key(p_buf, len);
+    if (key.size() < len) break;
+
+    auto it = index.cmds.find(key);
+    if (it == index.cmds.end()) continue;
+
+    for (uint16_t idx : it->second) {
+      if (idx >= found) break;
+      if (!utl_strucmp(p_tbl[idx].p_cmd, p_buf)) {
+        found = idx;
+        break;
+      }
+    }
+  }
+
+  return found;
+}
+
 /******************************************************************************
  *
  * Function         bta_ag_at_init
@@ -82,12 +189,8 @@ void bta_ag_process_at(tBTA_AG_AT_CB* p_cb, char* p_end) {
   uint8_t arg_type;
   char* p_arg;
   int16_t int_arg = 0;
-  /* loop through at command table looking for match */
-  for (idx = 0; p_cb->p_at_tbl[idx].p_cmd[0] != 0; idx++) {
-    if (!utl_strucmp(p_cb->p_at_tbl[idx].p_cmd, p_cb->p_cmd_buf)) {
-      break;
-    }
-  }
+  /* look up the command in the at command table */
+  idx = bta_ag_at_find_cmd(p_cb->p_at_tbl, p_cb->p_cmd_buf);
 
   /* if there is a match; verify argument type */
   if (p_cb->p_at_tbl[idx].p_cmd[0] != 0) {
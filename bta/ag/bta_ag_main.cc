@@ -28,6 +28,7 @@
 #include "bta_ag_int.h"
 #include "bta_api.h"
 #include "bta_sys.h"
+#include "osi/include/footprint.h"
 #include "osi/include/osi.h"
 #include "utl.h"
 
@@ -576,6 +577,7 @@ static void bta_ag_api_enable(tBTA_AG_DATA* p_data) {
     alarm_free(bta_ag_cb.scb[i].xsco_conn_collision_timer);
   }
   memset(&bta_ag_cb, 0, sizeof(tBTA_AG_CB));
+  footprint_set("bta_ag", "control_block", sizeof(tBTA_AG_CB));
 
   /* store callback function */
   bta_ag_cb.p_cback = p_data->api_enable.p_cback;
@@ -87,6 +87,8 @@
 #endif
 #include "device/include/device_iot_config.h"
 #include "osi/include/allocator.h"
+#include "osi/include/counters.h"
+#include "osi/include/time.h"
 
 /*****************************************************************************
  *  Constants
@@ -427,6 +429,31 @@ static void bta_av_st_rc_timer(tBTA_AV_SCB* p_scb,
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_av_post_cached_evt
+ *
+ * Description      Post a stream event answered from the SEP cache, the way
+ *                  the AVDTP confirmation would have been. num_seps is only
+ *                  used for BTA_AV_STR_DISC_OK_EVT.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void bta_av_post_cached_evt(tBTA_AV_SCB* p_scb, uint16_t event,
+                                   uint8_t avdt_event, uint8_t num_seps) {
+  tBTA_AV_STR_MSG* p_msg =
+      (tBTA_AV_STR_MSG*)osi_calloc(sizeof(tBTA_AV_STR_MSG));
+
+  p_msg->hdr.event = event;
+  p_msg->hdr.layer_specific = p_scb->hndl;
+  p_msg->bd_addr = p_scb->peer_addr;
+  p_msg->avdt_event = avdt_event;
+  p_msg->msg.discover_cfm.p_sep_info = p_scb->sep_info;
+  p_msg->msg.discover_cfm.num_seps = num_seps;
+  bta_sys_sendmsg(p_msg);
+}
+
 /*******************************************************************************
  *
  * Function         bta_av_next_getcap
@@ -463,6 +490,15 @@ static bool bta_av_next_getcap(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
         p_scb->p_cap = (tAVDT_CFG*)osi_malloc(sizeof(tAVDT_CFG));
       }
 
+      if (p_scb->sep_cache_used &&
+          bta_av_sep_cache_get_cap(p_scb->peer_addr, p_scb->sep_info[i].seid,
+                                   p_scb->p_cap)) {
+        bta_av_post_cached_evt(p_scb, BTA_AV_STR_GETCAP_OK_EVT,
+                               AVDT_GETCAP_CFM_EVT, 0);
+        sent_cmd = true;
+        break;
+      }
+
       if ((p_scb->avdt_version >= AVDT_VERSION_SYNC) &&
           (A2DP_GetAvdtpVersion() >= AVDT_VERSION_SYNC)) {
         p_req = AVDT_GetAllCapReq;
@@ -677,6 +713,11 @@ void bta_av_sink_data_cback(uint8_t handle, BT_HDR* p_pkt, uint32_t time_stamp,
     osi_free(p_pkt);
     return;
   }
+  /* AVDTP has consumed the media packet header: keep the timestamp there */
+  if (p_pkt->offset >= BTA_AV_SINK_MEDIA_TS_LEN) {
+    memcpy((uint8_t*)(p_pkt + 1) + p_pkt->offset - BTA_AV_SINK_MEDIA_TS_LEN,
+           &time_stamp, BTA_AV_SINK_MEDIA_TS_LEN);
+  }
   p_pkt->event = BTA_AV_SINK_MEDIA_DATA_EVT;
   p_scb->seps[p_scb->sep_idx].p_app_sink_data_cback(BTA_AV_SINK_MEDIA_DATA_EVT,
                                                     (tBTA_AV_MEDIA*)p_pkt, p_scb->peer_addr);
@@ -1673,6 +1714,9 @@ void bta_av_str_opened(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
   msg.peer_addr = p_scb->peer_addr;
   p_scb->l2c_cid = AVDT_GetL2CapChannel(p_scb->avdt_handle);
   bta_av_conn_chg((tBTA_AV_DATA*)&msg);
+  /* keep what was discovered for the next connection */
+  bta_av_sep_cache_commit(p_scb->peer_addr);
+  p_scb->sep_cache_used = false;
   /* set the congestion flag, so AV would not send media packets by accident */
   p_scb->cong = true;
   p_scb->offload_start_pending = false;
@@ -1757,7 +1801,7 @@ void bta_av_str_opened(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
     while (!list_is_empty(p_scb->a2dp_list)) {
       BT_HDR* p_buf = (BT_HDR*)list_front(p_scb->a2dp_list);
       list_remove(p_scb->a2dp_list, p_buf);
-      osi_free(p_buf);
+      bta_av_free_audio_buf(p_buf);
     }
 #if (TWS_ENABLED == TRUE)
     APPL_TRACE_DEBUG("%s:audio count  = %d ",__func__, bta_av_cb.audio_open_cnt);
@@ -1978,6 +2022,10 @@ void bta_av_disc_results(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
   p_scb->num_seps = p_data->str_msg.msg.discover_cfm.num_seps;
   APPL_TRACE_DEBUG("%s: initiator UUID 0x%x, num_seps = %d",
                  __func__, uuid_int, p_scb->num_seps);
+  if (!p_scb->sep_cache_used && uuid_int == UUID_SERVCLASS_AUDIO_SOURCE) {
+    bta_av_sep_cache_begin(p_scb->peer_addr, p_scb->avdt_version,
+                           p_scb->sep_info, p_scb->num_seps);
+  }
 
   for (i = 0; i < p_scb->num_seps; i++) {
     /* steam not in use, is a sink, and is audio */
@@ -2218,6 +2266,16 @@ void bta_av_open_failed(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
 
   APPL_TRACE_ERROR("%s: peer_addr=%s", __func__,
                    p_scb->peer_addr.ToString().c_str());
+
+  if (p_scb->sep_cache_used) {
+    /* What the peer reported before no longer holds, discover it again */
+    APPL_TRACE_WARNING("%s: cached SEPs failed, rediscovering", __func__);
+    bta_av_sep_cache_remove(p_scb->peer_addr);
+    bta_av_set_scb_sst_opening(p_scb);
+    bta_av_discover_req(p_scb, p_data);
+    return;
+  }
+
   p_scb->open_status = BTA_AV_FAIL_STREAM;
   bta_av_cco_close(p_scb, p_data);
 
@@ -2298,6 +2356,9 @@ void bta_av_getcap_results(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
     return;
   }
 
+  if (!p_scb->sep_cache_used)
+    bta_av_sep_cache_add_cap(p_scb->peer_addr, p_info->seid, p_scb->p_cap);
+
 
   media_type = A2DP_GetMediaType(p_scb->p_cap->codec_info);
   codec_type = A2DP_GetCodecType(p_scb->p_cap->codec_info);
@@ -2460,6 +2521,21 @@ void bta_av_setconfig_rej(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
  *
  ******************************************************************************/
 void bta_av_discover_req(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
+  uint8_t num_seps = 0;
+
+  /* a bonded sink is configured from what it reported last time */
+  p_scb->sep_cache_used =
+      (p_scb->uuid_int == UUID_SERVCLASS_AUDIO_SOURCE) &&
+      bta_av_sep_cache_load(p_scb->peer_addr, p_scb->avdt_version,
+                            p_scb->sep_info, BTA_AV_NUM_SEPS, &num_seps);
+  if (p_scb->sep_cache_used) {
+    APPL_TRACE_DEBUG("%s: %d cached SEPs for %s", __func__, num_seps,
+                     p_scb->peer_addr.ToString().c_str());
+    bta_av_post_cached_evt(p_scb, BTA_AV_STR_DISC_OK_EVT,
+                           AVDT_DISCOVER_CFM_EVT, num_seps);
+    return;
+  }
+
   /* send avdtp discover request */
   APPL_TRACE_DEBUG("%s: hdi is: %d , pscb is %x\n", __func__, p_scb->hdi, p_scb);
   uint16_t status;
@@ -2497,6 +2573,19 @@ void bta_av_conn_failed(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
  * Returns          void
  *
  ******************************************************************************/
+/* Start latency histograms, registered on first use */
+static counters_metric_t* bta_av_start_rsp_metric(void) {
+  static counters_metric_t* metric =
+      counters_register_histogram("bta_av", "start_rsp", "ms");
+  return metric;
+}
+
+static counters_metric_t* bta_av_first_packet_metric(void) {
+  static counters_metric_t* metric =
+      counters_register_histogram("bta_av", "start_to_first_packet", "ms");
+  return metric;
+}
+
 void bta_av_do_start(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
   uint8_t policy = HCI_ENABLE_SNIFF_MODE;
   uint8_t cur_role = BTM_ROLE_UNDEFINED;
@@ -2527,6 +2616,7 @@ void bta_av_do_start(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
     p_scb->role |= BTA_AV_ROLE_START_INT;
     bta_sys_busy(BTA_ID_AV, p_scb->hdi, p_scb->peer_addr);
 
+    p_scb->start_req_ms = time_get_os_boottime_ms();
     AVDT_StartReq(&p_scb->avdt_handle, 1);
 #if (TWS_STATE_ENABLED == TRUE)
     p_scb->start_pending = true;
@@ -2564,6 +2654,9 @@ void bta_av_str_stopped(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
   APPL_TRACE_ERROR("%s: audio_open_cnt=%d, p_data %p", __func__,
                    bta_av_cb.audio_open_cnt, p_data);
 
+  p_scb->start_req_ms = 0;
+  p_scb->started_ms = 0;
+
   bta_sys_idle(BTA_ID_AV, p_scb->hdi, p_scb->peer_addr);
   if ((bta_av_cb.features & BTA_AV_FEAT_MASTER) == 0 ||
       bta_av_cb.audio_open_cnt == 1)
@@ -2603,7 +2696,7 @@ void bta_av_str_stopped(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
     while (!list_is_empty(p_scb->a2dp_list)) {
       p_buf = (BT_HDR*)list_front(p_scb->a2dp_list);
       list_remove(p_scb->a2dp_list, p_buf);
-      osi_free(p_buf);
+      bta_av_free_audio_buf(p_buf);
     }
 
     /* drop the audio buffers queued in L2CAP */
@@ -2922,6 +3015,10 @@ void bta_av_data_path(tBTA_AV_SCB* p_scb, UNUSED_ATTR tBTA_AV_DATA* p_data) {
        * L2CAP (see above).
        */
 
+      /* AVDTP writes its headers in place, send our own copy if other
+       * channels still hold this buffer */
+      p_buf = bta_av_claim_audio_buf(p_buf);
+
       /* opt is a bit mask, it could have several options set */
       opt = AVDT_DATA_OPT_NONE;
       if (p_scb->no_rtp_hdr) {
@@ -2967,6 +3064,12 @@ void bta_av_data_path(tBTA_AV_SCB* p_scb, UNUSED_ATTR tBTA_AV_DATA* p_data) {
         m_pt &= ~AVDT_MARKER_SET;
       }
       AVDT_WriteReqOpt(p_scb->avdt_handle, p_buf, timestamp, m_pt, opt);
+      if (p_scb->started_ms != 0) {
+        counters_histogram_record(
+            bta_av_first_packet_metric(),
+            time_get_os_boottime_ms() - p_scb->started_ms);
+        p_scb->started_ms = 0;
+      }
       for (size_t i = 0; i < extra_fragments.size(); i++) {
         if (i + 1 == extra_fragments.size()) {
           // Set the RTP Marker bit for the last fragment
@@ -2990,7 +3093,7 @@ void bta_av_data_path(tBTA_AV_SCB* p_scb, UNUSED_ATTR tBTA_AV_DATA* p_data) {
         } else {
           /* too many buffers in a2dp_list, drop it. */
           bta_av_co_audio_drop(p_scb->hndl);
-          osi_free(p_buf);
+          bta_av_free_audio_buf(p_buf);
         }
       }
     }
@@ -3026,6 +3129,17 @@ void bta_av_start_ok(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
 #endif
   p_scb->current_codec = bta_av_get_a2dp_current_codec();
 
+  /* A remote start is timed from here, a local one from the Start request */
+  uint64_t now_ms = time_get_os_boottime_ms();
+  if (p_scb->start_req_ms != 0) {
+    counters_histogram_record(bta_av_start_rsp_metric(),
+                              now_ms - p_scb->start_req_ms);
+    if (p_scb->started_ms == 0) p_scb->started_ms = p_scb->start_req_ms;
+    p_scb->start_req_ms = 0;
+  } else if (p_scb->started_ms == 0) {
+    p_scb->started_ms = now_ms;
+  }
+
   if (p_scb->sco_suspend) {
     p_scb->sco_suspend = false;
   }
@@ -3214,6 +3328,8 @@ void bta_av_start_ok(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data) {
  *
  ******************************************************************************/
 void bta_av_start_failed(tBTA_AV_SCB* p_scb, UNUSED_ATTR tBTA_AV_DATA* p_data) {
+  p_scb->start_req_ms = 0;
+  p_scb->started_ms = 0;
   if (p_scb->started == false && p_scb->co_started == false) {
     bta_sys_idle(BTA_ID_AV, p_scb->hdi, p_scb->peer_addr);
     notify_start_failed(p_scb);
@@ -3702,7 +3818,7 @@ void bta_av_rcfg_open(tBTA_AV_SCB* p_scb, UNUSED_ATTR tBTA_AV_DATA* p_data) {
     while (!list_is_empty(p_scb->a2dp_list)) {
       BT_HDR* p_buf = (BT_HDR*)list_front(p_scb->a2dp_list);
       list_remove(p_scb->a2dp_list, p_buf);
-      osi_free(p_buf);
+      bta_av_free_audio_buf(p_buf);
     }
 
     /* open the stream with the new config */
@@ -2898,7 +2898,7 @@ void bta_av_dereg_comp(tBTA_AV_DATA* p_data) {
         while (!list_is_empty(p_scb->a2dp_list)) {
           p_buf = (BT_HDR*)list_front(p_scb->a2dp_list);
           list_remove(p_scb->a2dp_list, p_buf);
-          osi_free(p_buf);
+          bta_av_free_audio_buf(p_buf);
         }
       }
 
@@ -305,6 +305,23 @@ void BTA_AvOffloadStartRsp(tBTA_AV_HNDL hndl, tBTA_AV_STATUS status) {
   bta_sys_sendmsg(p_buf);
 }
 
+/*******************************************************************************
+ *
+ * Function         BTA_AvGetSinkMediaTimestamp
+ *
+ * Description      Get the RTP timestamp of a sink media packet.
+ *
+ * Returns          RTP timestamp of |p_pkt|
+ *
+ ******************************************************************************/
+uint32_t BTA_AvGetSinkMediaTimestamp(const BT_HDR* p_pkt) {
+  uint32_t time_stamp;
+  memcpy(&time_stamp,
+         (const uint8_t*)(p_pkt + 1) + p_pkt->offset - BTA_AV_SINK_MEDIA_TS_LEN,
+         BTA_AV_SINK_MEDIA_TS_LEN);
+  return time_stamp;
+}
+
 /*******************************************************************************
  *
  * Function         BTA_AvStop
@@ -47,7 +47,7 @@ void bta_av_ci_src_data_ready(tBTA_AV_CHNL chnl) {
   p_buf->layer_specific = chnl;
   p_buf->event = BTA_AV_CI_SRC_DATA_READY_EVT;
 
-  bta_sys_sendmsg(p_buf);
+  bta_sys_sendmsg_prio(p_buf, BTU_TASK_PRIO_MEDIA);
 }
 
 /*******************************************************************************
@@ -704,6 +704,9 @@ struct tBTA_AV_SCB {
   bool vendor_start;
   tBTA_AV_CI_SETCONFIG *cache_setconfig;
   int rc_ccb_alloc_handle;
+  uint64_t start_req_ms; /* when AVDTP Start was sent, 0 if none pending */
+  uint64_t started_ms;   /* when streaming started, 0 once data flows */
+  bool sep_cache_used; /* remote SEPs and capabilities came from the cache */
 };
 
 #define BTA_AV_RC_ROLE_MASK 0x10
@@ -877,6 +880,7 @@ extern bool bta_av_is_scb_incoming(tBTA_AV_SCB* p_scb);
 extern void bta_av_set_scb_sst_init(tBTA_AV_SCB* p_scb);
 extern bool bta_av_is_scb_init(tBTA_AV_SCB* p_scb);
 extern void bta_av_set_scb_sst_incoming(tBTA_AV_SCB* p_scb);
+extern void bta_av_set_scb_sst_opening(tBTA_AV_SCB* p_scb);
 extern tBTA_AV_LCB* bta_av_find_lcb(const RawAddress& addr, uint8_t op);
 extern bool bta_av_is_multicast_enabled();
 extern void bta_av_free_scb(tBTA_AV_SCB* p_scb);
@@ -884,6 +888,8 @@ extern void bta_av_free_scb(tBTA_AV_SCB* p_scb);
 /* main functions */
 extern void bta_av_api_deregister(tBTA_AV_DATA* p_data);
 extern void bta_av_dup_audio_buf(tBTA_AV_SCB* p_scb, BT_HDR* p_buf);
+extern BT_HDR* bta_av_claim_audio_buf(BT_HDR* p_buf);
+extern void bta_av_free_audio_buf(BT_HDR* p_buf);
 extern void bta_av_sm_execute(tBTA_AV_CB* p_cb, uint16_t event,
                               tBTA_AV_DATA* p_data);
 extern void bta_av_ssm_execute(tBTA_AV_SCB* p_scb, uint16_t event,
@@ -985,6 +991,22 @@ extern void bta_av_offload_rsp(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data);
 extern void bta_av_vendor_offload_stop(tBTA_AV_SCB* p_scb);
 extern void bta_av_disc_fail_as_acp(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data);
 extern void bta_av_handle_collision(tBTA_AV_SCB* p_scb, tBTA_AV_DATA* p_data);
+
+/* remote SEP cache */
+extern bool bta_av_sep_cache_load(const RawAddress& peer_addr,
+                                  uint16_t avdt_version,
+                                  tAVDT_SEP_INFO* p_sep_info, uint8_t max_seps,
+                                  uint8_t* p_num_seps);
+extern bool bta_av_sep_cache_get_cap(const RawAddress& peer_addr, uint8_t seid,
+                                     tAVDT_CFG* p_cap);
+extern void bta_av_sep_cache_begin(const RawAddress& peer_addr,
+                                   uint16_t avdt_version,
+                                   const tAVDT_SEP_INFO* p_sep_info,
+                                   uint8_t num_seps);
+extern void bta_av_sep_cache_add_cap(const RawAddress& peer_addr, uint8_t seid,
+                                     const tAVDT_CFG* p_cap);
+extern void bta_av_sep_cache_commit(const RawAddress& peer_addr);
+extern void bta_av_sep_cache_remove(const RawAddress& peer_addr);
 #if (TWS_ENABLED == TRUE)
 extern void bta_av_set_tws_chn_mode(tBTA_AV_SCB* p_scb, bool adjust);
 #endif
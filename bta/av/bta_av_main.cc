@@ -59,6 +59,7 @@
 
 #include <base/logging.h>
 #include <string.h>
+#include <unordered_map>
 
 #include "bt_target.h"
 #include "osi/include/log.h"
@@ -1496,12 +1497,20 @@ uint16_t bta_av_chk_mtu(tBTA_AV_SCB* p_scb, UNUSED_ATTR uint16_t mtu) {
   return ret_mtu;
 }
 
+/* Audio buffers shared between the a2dp_list of several channels, with the
+ * number of channels holding them besides the first one. Only accessed from
+ * the BTA thread. */
+static std::unordered_map<BT_HDR*, uint8_t> bta_av_shared_audio_bufs;
+
 /*******************************************************************************
  *
  * Function         bta_av_dup_audio_buf
  *
  * Description      dup the audio data to the q_info.a2dp of other audio
- *                  channels
+ *                  channels. The other channels hold a reference to p_buf;
+ *                  the payload is only copied when a channel sends it (see
+ *                  bta_av_claim_audio_buf), and not at all for buffers that
+ *                  are dropped before.
  *
  * Returns          void
  *
@@ -1514,7 +1523,6 @@ void bta_av_dup_audio_buf(tBTA_AV_SCB* p_scb, BT_HDR* p_buf) {
     return;
   }
 
-  uint16_t copy_size = BT_HDR_SIZE + p_buf->len + p_buf->offset;
   for (int i = 0; i < BTA_AV_NUM_STRS; i++) {
     tBTA_AV_SCB* p_scbi = bta_av_cb.p_scb[i];
 
@@ -1524,21 +1532,64 @@ void bta_av_dup_audio_buf(tBTA_AV_SCB* p_scb, BT_HDR* p_buf) {
     if (!(bta_av_cb.conn_audio & BTA_AV_HNDL_TO_MSK(i)))
       continue; /* Audio is not connected */
 
-    /* Enqueue the data */
-    BT_HDR* p_new = (BT_HDR*)osi_malloc(copy_size);
-    memcpy(p_new, p_buf, copy_size);
-    list_append(p_scbi->a2dp_list, p_new);
+    /* Enqueue a reference to the data */
+    bta_av_shared_audio_bufs[p_buf]++;
+    list_append(p_scbi->a2dp_list, p_buf);
 
     if (list_length(p_scbi->a2dp_list) > p_bta_av_cfg->audio_mqs) {
       // Drop the oldest packet
       bta_av_co_audio_drop(p_scbi->hndl);
       BT_HDR* p_buf_drop = static_cast<BT_HDR*>(list_front(p_scbi->a2dp_list));
       list_remove(p_scbi->a2dp_list, p_buf_drop);
-      osi_free(p_buf_drop);
+      bta_av_free_audio_buf(p_buf_drop);
     }
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_av_claim_audio_buf
+ *
+ * Description      Take ownership of an audio buffer from a2dp_list before
+ *                  handing it to AVDTP, which writes its headers in place.
+ *                  A buffer other channels still hold is copied, the last
+ *                  holder gets the buffer itself.
+ *
+ * Returns          The buffer to send, owned by the caller
+ *
+ ******************************************************************************/
+BT_HDR* bta_av_claim_audio_buf(BT_HDR* p_buf) {
+  auto it = bta_av_shared_audio_bufs.find(p_buf);
+  if (it == bta_av_shared_audio_bufs.end()) return p_buf;
+
+  if (--it->second == 0) bta_av_shared_audio_bufs.erase(it);
+
+  uint16_t copy_size = BT_HDR_SIZE + p_buf->len + p_buf->offset;
+  BT_HDR* p_new = (BT_HDR*)osi_malloc(copy_size);
+  memcpy(p_new, p_buf, copy_size);
+  return p_new;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_av_free_audio_buf
+ *
+ * Description      Release an audio buffer removed from a2dp_list without
+ *                  sending it. It is freed once no channel holds it anymore.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_av_free_audio_buf(BT_HDR* p_buf) {
+  auto it = bta_av_shared_audio_bufs.find(p_buf);
+  if (it == bta_av_shared_audio_bufs.end()) {
+    osi_free(p_buf);
+    return;
+  }
+
+  if (--it->second == 0) bta_av_shared_audio_bufs.erase(it);
+}
+
 /*******************************************************************************
  *
  * Function         bta_av_sm_execute
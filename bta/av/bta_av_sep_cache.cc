@@ -0,0 +1,296 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This module remembers the stream endpoints and their capabilities found
+ *  on bonded peers, so that a reconnection can configure the stream without
+ *  AVDTP Discover and Get (All) Capabilities.
+ *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include <map>
+#include <vector>
+
+#include "bt_target.h"
+#include "bta_av_int.h"
+#include "btif/include/btif_config.h"
+#include "btm_int.h"
+#include "osi/include/properties.h"
+
+/* Layout version of the stored blob */
+#define BTA_AV_SEP_CACHE_FORMAT 1
+
+#define BTA_AV_SEP_CACHE_HDR_LEN 4
+#define BTA_AV_SEP_CACHE_SEP_LEN 4
+#define BTA_AV_SEP_CACHE_CAP_LEN (AVDT_CODEC_SIZE + AVDT_PROTECT_SIZE + 8)
+
+typedef struct {
+  tAVDT_SEP_INFO info;
+  bool has_cap;
+  tAVDT_CFG cap;
+} tBTA_AV_CACHED_SEP;
+
+typedef struct {
+  uint16_t avdt_version;
+  bool stored; /* read from the storage rather than discovered */
+  std::vector<tBTA_AV_CACHED_SEP> seps;
+} tBTA_AV_SEP_CACHE;
+
+/* Entries being discovered, or replayed from the storage, per peer */
+static std::map<RawAddress, tBTA_AV_SEP_CACHE> bta_av_sep_cache;
+
+static bool bta_av_sep_cache_enabled(void) {
+  static bool enabled =
+      osi_property_get_bool("persist.vendor.btstack.a2dp.sep_cache", true);
+  return enabled;
+}
+
+static std::vector<uint8_t> bta_av_sep_cache_serialize(
+    const tBTA_AV_SEP_CACHE& entry) {
+  size_t len = BTA_AV_SEP_CACHE_HDR_LEN;
+  for (const tBTA_AV_CACHED_SEP& sep : entry.seps) {
+    len += BTA_AV_SEP_CACHE_SEP_LEN;
+    if (sep.has_cap) len += BTA_AV_SEP_CACHE_CAP_LEN;
+  }
+
+  std::vector<uint8_t> blob(len);
+  uint8_t* p = blob.data();
+  UINT8_TO_STREAM(p, BTA_AV_SEP_CACHE_FORMAT);
+  UINT16_TO_STREAM(p, entry.avdt_version);
+  UINT8_TO_STREAM(p, entry.seps.size());
+  for (const tBTA_AV_CACHED_SEP& sep : entry.seps) {
+    UINT8_TO_STREAM(p, sep.info.seid);
+    UINT8_TO_STREAM(p, sep.info.media_type);
+    UINT8_TO_STREAM(p, sep.info.tsep);
+    UINT8_TO_STREAM(p, sep.has_cap);
+    if (!sep.has_cap) continue;
+    UINT8_TO_STREAM(p, sep.cap.num_codec);
+    ARRAY_TO_STREAM(p, sep.cap.codec_info, AVDT_CODEC_SIZE);
+    UINT8_TO_STREAM(p, sep.cap.num_protect);
+    ARRAY_TO_STREAM(p, sep.cap.protect_info, AVDT_PROTECT_SIZE);
+    UINT16_TO_STREAM(p, sep.cap.psc_mask);
+    UINT8_TO_STREAM(p, sep.cap.recov_type);
+    UINT8_TO_STREAM(p, sep.cap.recov_mrws);
+    UINT8_TO_STREAM(p, sep.cap.recov_mnmp);
+    UINT8_TO_STREAM(p, sep.cap.hdrcmp_mask);
+  }
+  return blob;
+}
+
+static bool bta_av_sep_cache_parse(const uint8_t* p, size_t len,
+                                   tBTA_AV_SEP_CACHE* p_entry) {
+  if (len < BTA_AV_SEP_CACHE_HDR_LEN) return false;
+  const uint8_t* p_end = p + len;
+
+  uint8_t format, num_seps;
+  STREAM_TO_UINT8(format, p);
+  STREAM_TO_UINT16(p_entry->avdt_version, p);
+  STREAM_TO_UINT8(num_seps, p);
+  if (format != BTA_AV_SEP_CACHE_FORMAT || num_seps == 0 ||
+      num_seps > BTA_AV_NUM_SEPS)
+    return false;
+
+  p_entry->seps.resize(num_seps);
+  for (tBTA_AV_CACHED_SEP& sep : p_entry->seps) {
+    if (p_end - p < BTA_AV_SEP_CACHE_SEP_LEN) return false;
+    memset(&sep, 0, sizeof(sep));
+    STREAM_TO_UINT8(sep.info.seid, p);
+    STREAM_TO_UINT8(sep.info.media_type, p);
+    STREAM_TO_UINT8(sep.info.tsep, p);
+    STREAM_TO_UINT8(sep.has_cap, p);
+    if (!sep.has_cap) continue;
+
+    if (p_end - p < BTA_AV_SEP_CACHE_CAP_LEN) return false;
+    STREAM_TO_UINT8(sep.cap.num_codec, p);
+    STREAM_TO_ARRAY(sep.cap.codec_info, p, AVDT_CODEC_SIZE);
+    STREAM_TO_UINT8(sep.cap.num_protect, p);
+    STREAM_TO_ARRAY(sep.cap.protect_info, p, AVDT_PROTECT_SIZE);
+    STREAM_TO_UINT16(sep.cap.psc_mask, p);
+    STREAM_TO_UINT8(sep.cap.recov_type, p);
+    STREAM_TO_UINT8(sep.cap.recov_mrws, p);
+    STREAM_TO_UINT8(sep.cap.recov_mnmp, p);
+    STREAM_TO_UINT8(sep.cap.hdrcmp_mask, p);
+  }
+  return p == p_end;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_av_sep_cache_load
+ *
+ * Description      Look up the stream endpoints stored for the peer. The entry
+ *                  is only used if it was found with the same AVDTP version.
+ *
+ * Returns          true and the endpoints in p_sep_info if there is one.
+ *
+ ******************************************************************************/
+bool bta_av_sep_cache_load(const RawAddress& peer_addr, uint16_t avdt_version,
+                           tAVDT_SEP_INFO* p_sep_info, uint8_t max_seps,
+                           uint8_t* p_num_seps) {
+  bta_av_sep_cache.erase(peer_addr);
+  if (!bta_av_sep_cache_enabled()) return false;
+
+  std::string bdstr = peer_addr.ToString();
+  size_t len = btif_config_get_bin_length(bdstr, AVDTP_SEP_CACHE_CONFIG_KEY);
+  if (len == 0) return false;
+
+  std::vector<uint8_t> blob(len);
+  tBTA_AV_SEP_CACHE entry = {};
+  if (!btif_config_get_bin(bdstr, AVDTP_SEP_CACHE_CONFIG_KEY, blob.data(),
+                           &len) ||
+      !bta_av_sep_cache_parse(blob.data(), len, &entry)) {
+    APPL_TRACE_WARNING("%s: dropping unreadable entry for %s", __func__,
+                       bdstr.c_str());
+    btif_config_remove(bdstr, AVDTP_SEP_CACHE_CONFIG_KEY);
+    return false;
+  }
+
+  if (entry.avdt_version != avdt_version || entry.seps.size() > max_seps) {
+    APPL_TRACE_DEBUG("%s: %s cached with AVDTP 0x%x, now 0x%x", __func__,
+                     bdstr.c_str(), entry.avdt_version, avdt_version);
+    return false;
+  }
+
+  for (size_t i = 0; i < entry.seps.size(); i++) {
+    p_sep_info[i] = entry.seps[i].info;
+  }
+  *p_num_seps = entry.seps.size();
+  entry.stored = true;
+  bta_av_sep_cache[peer_addr] = std::move(entry);
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_av_sep_cache_get_cap
+ *
+ * Description      Get the capabilities of the endpoint seid of a peer whose
+ *                  endpoints were loaded with bta_av_sep_cache_load.
+ *
+ * Returns          true if the capabilities are known.
+ *
+ ******************************************************************************/
+bool bta_av_sep_cache_get_cap(const RawAddress& peer_addr, uint8_t seid,
+                              tAVDT_CFG* p_cap) {
+  auto it = bta_av_sep_cache.find(peer_addr);
+  if (it == bta_av_sep_cache.end()) return false;
+
+  for (const tBTA_AV_CACHED_SEP& sep : it->second.seps) {
+    if (sep.info.seid != seid || !sep.has_cap) continue;
+    memcpy(p_cap, &sep.cap, sizeof(tAVDT_CFG));
+    return true;
+  }
+  return false;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_av_sep_cache_begin
+ *
+ * Description      Start recording the result of an AVDTP discovery.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_av_sep_cache_begin(const RawAddress& peer_addr, uint16_t avdt_version,
+                            const tAVDT_SEP_INFO* p_sep_info,
+                            uint8_t num_seps) {
+  if (!bta_av_sep_cache_enabled()) return;
+
+  tBTA_AV_SEP_CACHE& entry = bta_av_sep_cache[peer_addr];
+  entry.avdt_version = avdt_version;
+  entry.stored = false;
+  entry.seps.clear();
+  for (uint8_t i = 0; i < num_seps; i++) {
+    tBTA_AV_CACHED_SEP sep;
+    memset(&sep, 0, sizeof(sep));
+    sep.info = p_sep_info[i];
+    /* whether it is in use is only known after discovering again */
+    sep.info.in_use = false;
+    entry.seps.push_back(sep);
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_av_sep_cache_add_cap
+ *
+ * Description      Record the capabilities of the discovered endpoint seid.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_av_sep_cache_add_cap(const RawAddress& peer_addr, uint8_t seid,
+                              const tAVDT_CFG* p_cap) {
+  auto it = bta_av_sep_cache.find(peer_addr);
+  if (it == bta_av_sep_cache.end()) return;
+
+  for (tBTA_AV_CACHED_SEP& sep : it->second.seps) {
+    if (sep.info.seid != seid) continue;
+    memcpy(&sep.cap, p_cap, sizeof(tAVDT_CFG));
+    sep.has_cap = true;
+    return;
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_av_sep_cache_commit
+ *
+ * Description      Store what was discovered on the peer once the stream it
+ *                  was used for opened. Only bonded peers are stored.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_av_sep_cache_commit(const RawAddress& peer_addr) {
+  auto it = bta_av_sep_cache.find(peer_addr);
+  if (it == bta_av_sep_cache.end()) return;
+
+  if (!it->second.stored && !it->second.seps.empty() &&
+      btm_sec_is_a_bonded_dev(peer_addr)) {
+    std::vector<uint8_t> blob = bta_av_sep_cache_serialize(it->second);
+    btif_config_set_bin(peer_addr.ToString(), AVDTP_SEP_CACHE_CONFIG_KEY,
+                        blob.data(), blob.size());
+    btif_config_save();
+  }
+  bta_av_sep_cache.erase(it);
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_av_sep_cache_remove
+ *
+ * Description      Forget the endpoints of the peer, e.g. when it rejected a
+ *                  configuration made from them.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_av_sep_cache_remove(const RawAddress& peer_addr) {
+  bta_av_sep_cache.erase(peer_addr);
+
+  std::string bdstr = peer_addr.ToString();
+  if (btif_config_exist(bdstr, AVDTP_SEP_CACHE_CONFIG_KEY)) {
+    btif_config_remove(bdstr, AVDTP_SEP_CACHE_CONFIG_KEY);
+    btif_config_save();
+  }
+}
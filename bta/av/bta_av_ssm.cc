@@ -30,6 +30,7 @@
 #include "bt_target.h"
 #include "bta_av_co.h"
 #include "bta_av_int.h"
+#include "bta_sys_sm.h"
 #include "btif/include/btif_av.h"
 
 /*****************************************************************************
@@ -43,7 +44,8 @@ enum {
   BTA_AV_OPENING_SST,
   BTA_AV_OPEN_SST,
   BTA_AV_RCFG_SST,
-  BTA_AV_CLOSING_SST
+  BTA_AV_CLOSING_SST,
+  BTA_AV_NUM_SST
 };
 
 /* state machine action enumeration list */
@@ -106,13 +108,17 @@ enum {
 #define BTA_AV_SIGNORE BTA_AV_NUM_SACTIONS
 
 /* state table information */
-/* #define BTA_AV_SACTION_COL           0       position of actions */
 #define BTA_AV_SACTIONS 2    /* number of actions */
-#define BTA_AV_SNEXT_STATE 2 /* position of next state */
-#define BTA_AV_NUM_COLS 3    /* number of columns in state tables */
+/* number of events in state tables */
+#define BTA_AV_NUM_SEVTS (BTA_AV_COLLISION_EVT - BTA_AV_FIRST_SSM_EVT + 1)
+
+typedef tBTA_SYS_SM<tBTA_AV_SCB, tBTA_AV_DATA, BTA_AV_NUM_SST,
+                    BTA_AV_NUM_SEVTS, BTA_AV_SACTIONS, BTA_AV_SIGNORE>
+    tBTA_AV_SSM;
+typedef tBTA_AV_SSM::tROW tBTA_AV_SST_ROW;
 
 /* state table for init state */
-static const uint8_t bta_av_sst_init[][BTA_AV_NUM_COLS] = {
+static const tBTA_AV_SST_ROW bta_av_sst_init[] = {
     /* Event                     Action 1               Action 2 Next state */
     /* AP_OPEN_EVT */ {BTA_AV_DO_DISC, BTA_AV_SIGNORE, BTA_AV_OPENING_SST},
     /* AP_CLOSE_EVT */ {BTA_AV_CLEANUP, BTA_AV_SIGNORE, BTA_AV_INIT_SST},
@@ -162,7 +168,7 @@ static const uint8_t bta_av_sst_init[][BTA_AV_NUM_COLS] = {
     /* COLLISION_EVT */ {BTA_AV_SIGNORE, BTA_AV_SIGNORE, BTA_AV_INIT_SST}};
 
 /* state table for incoming state */
-static const uint8_t bta_av_sst_incoming[][BTA_AV_NUM_COLS] = {
+static const tBTA_AV_SST_ROW bta_av_sst_incoming[] = {
     /* Event                     Action 1               Action 2 Next state */
     /* AP_OPEN_EVT */ {BTA_AV_OPEN_AT_INC, BTA_AV_SIGNORE, BTA_AV_INCOMING_SST},
     /* AP_CLOSE_EVT */ {BTA_AV_CCO_CLOSE, BTA_AV_DISCONNECT_REQ,
@@ -232,7 +238,7 @@ static const uint8_t bta_av_sst_incoming[][BTA_AV_NUM_COLS] = {
     /* COLLISION_EVT */ {BTA_AV_SIGNORE, BTA_AV_SIGNORE, BTA_AV_INCOMING_SST}};
 
 /* state table for opening state */
-static const uint8_t bta_av_sst_opening[][BTA_AV_NUM_COLS] = {
+static const tBTA_AV_SST_ROW bta_av_sst_opening[] = {
     /* Event                     Action 1               Action 2 Next state */
     /* AP_OPEN_EVT */ {BTA_AV_SIGNORE, BTA_AV_SIGNORE, BTA_AV_OPENING_SST},
     /* AP_CLOSE_EVT */ {BTA_AV_DO_CLOSE, BTA_AV_STR_CLOSED, BTA_AV_INIT_SST},
@@ -301,7 +307,7 @@ static const uint8_t bta_av_sst_opening[][BTA_AV_NUM_COLS] = {
     /* COLLISION_EVT */ {BTA_AV_HANDLE_COLLISION, BTA_AV_SIGNORE, BTA_AV_INIT_SST}};
 
 /* state table for open state */
-static const uint8_t bta_av_sst_open[][BTA_AV_NUM_COLS] = {
+static const tBTA_AV_SST_ROW bta_av_sst_open[] = {
     /* Event                     Action 1               Action 2 Next state */
     /* AP_OPEN_EVT */ {BTA_AV_SIGNORE, BTA_AV_SIGNORE, BTA_AV_OPEN_SST},
     /* AP_CLOSE_EVT */ {BTA_AV_DO_CLOSE, BTA_AV_SIGNORE, BTA_AV_CLOSING_SST},
@@ -359,7 +365,7 @@ static const uint8_t bta_av_sst_open[][BTA_AV_NUM_COLS] = {
     /* COLLISION_EVT */ {BTA_AV_SIGNORE, BTA_AV_SIGNORE, BTA_AV_OPEN_SST}};
 
 /* state table for reconfig state */
-static const uint8_t bta_av_sst_rcfg[][BTA_AV_NUM_COLS] = {
+static const tBTA_AV_SST_ROW bta_av_sst_rcfg[] = {
     /* Event                     Action 1               Action 2 Next state */
     /* AP_OPEN_EVT */ {BTA_AV_SIGNORE, BTA_AV_SIGNORE, BTA_AV_RCFG_SST},
     /* AP_CLOSE_EVT */ {BTA_AV_DISCONNECT_REQ, BTA_AV_SIGNORE,
@@ -417,7 +423,7 @@ static const uint8_t bta_av_sst_rcfg[][BTA_AV_NUM_COLS] = {
     /* COLLISION_EVT */ {BTA_AV_SIGNORE, BTA_AV_SIGNORE, BTA_AV_RCFG_SST}};
 
 /* state table for closing state */
-static const uint8_t bta_av_sst_closing[][BTA_AV_NUM_COLS] = {
+static const tBTA_AV_SST_ROW bta_av_sst_closing[] = {
     /* Event                     Action 1               Action 2 Next state */
     /* AP_OPEN_EVT */ {BTA_AV_SIGNORE, BTA_AV_SIGNORE, BTA_AV_CLOSING_SST},
     /* AP_CLOSE_EVT */ {BTA_AV_DISCONNECT_REQ, BTA_AV_STR_CLOSED,
@@ -482,13 +488,12 @@ static const uint8_t bta_av_sst_closing[][BTA_AV_NUM_COLS] = {
                                      BTA_AV_CLOSING_SST},
     /* COLLISION_EVT */ {BTA_AV_SIGNORE, BTA_AV_SIGNORE, BTA_AV_CLOSING_SST}};
 
-/* type for state table */
-typedef const uint8_t (*tBTA_AV_SST_TBL)[BTA_AV_NUM_COLS];
+/* state table, a table of the wrong size fails to build */
+static const tBTA_AV_SSM::tTABLE* const bta_av_sst_tbl[] = {
+    &bta_av_sst_init, &bta_av_sst_incoming, &bta_av_sst_opening,
+    &bta_av_sst_open, &bta_av_sst_rcfg,     &bta_av_sst_closing};
 
-/* state table */
-static const tBTA_AV_SST_TBL bta_av_sst_tbl[] = {
-    bta_av_sst_init, bta_av_sst_incoming, bta_av_sst_opening,
-    bta_av_sst_open, bta_av_sst_rcfg,     bta_av_sst_closing};
+static const tBTA_AV_SSM bta_av_ssm(bta_av_sst_tbl);
 
 static const char* bta_av_sst_code(uint8_t state);
 
@@ -524,9 +529,8 @@ bool bta_av_is_rcfg_sst(tBTA_AV_SCB* p_scb) {
  ******************************************************************************/
 void bta_av_ssm_execute(tBTA_AV_SCB* p_scb, uint16_t event,
                         tBTA_AV_DATA* p_data) {
-  tBTA_AV_SST_TBL state_table;
-  uint8_t action;
-  int i, xx;
+  uint8_t next_state;
+  int xx;
 
   if (p_scb == NULL) {
     /* this stream is not registered */
@@ -557,13 +561,16 @@ void bta_av_ssm_execute(tBTA_AV_SCB* p_scb, uint16_t event,
                      p_scb->hndl, event, bta_av_evt_code(event), p_scb->state,
                      bta_av_sst_code(p_scb->state));
 
-  /* look up the state table for the current state */
-  state_table = bta_av_sst_tbl[p_scb->state];
-
   event -= BTA_AV_FIRST_SSM_EVT;
+  if (!tBTA_AV_SSM::IsValid(p_scb->state, event)) {
+    APPL_TRACE_ERROR("%s: invalid event 0x%x in state %d", __func__,
+                     event + BTA_AV_FIRST_SSM_EVT, p_scb->state);
+    return;
+  }
+  next_state = bta_av_ssm.NextState(p_scb->state, event);
 
   if ((p_scb->state != BTA_AV_OPENING_SST) &&
-      (state_table[event][BTA_AV_SNEXT_STATE] == BTA_AV_OPENING_SST)) {
+      (next_state == BTA_AV_OPENING_SST)) {
     int idx = (p_scb->hndl & BTA_AV_HNDL_MSK) - 1;
     RawAddress addr = btif_av_get_addr_by_index(idx);
     AVDT_UpdateServiceBusyState(true, addr);
@@ -574,8 +581,7 @@ void bta_av_ssm_execute(tBTA_AV_SCB* p_scb, uint16_t event,
       if (bta_av_cb.p_scb[xx]) {
         if ((bta_av_cb.p_scb[xx]->state == BTA_AV_OPENING_SST) &&
             (bta_av_cb.p_scb[xx] == p_scb) &&
-            (state_table[event][BTA_AV_SNEXT_STATE] !=
-             BTA_AV_OPENING_SST)) {
+            (next_state != BTA_AV_OPENING_SST)) {
           keep_busy = false;
           break;
         }
@@ -585,17 +591,8 @@ void bta_av_ssm_execute(tBTA_AV_SCB* p_scb, uint16_t event,
       AVDT_UpdateServiceBusyState(false, p_scb->peer_addr);
   }
 
-  /* set next state */
-  p_scb->state = state_table[event][BTA_AV_SNEXT_STATE];
-
-  /* execute action functions */
-  for (i = 0; i < BTA_AV_SACTIONS; i++) {
-    action = state_table[event][i];
-    if (action != BTA_AV_SIGNORE) {
-      (*p_scb->p_act_tbl[action])(p_scb, p_data);
-    } else
-      break;
-  }
+  /* set next state and execute action functions */
+  bta_av_ssm.Execute(&p_scb->state, event, p_scb->p_act_tbl, p_scb, p_data);
 }
 
 /*******************************************************************************
@@ -692,6 +689,22 @@ void bta_av_set_scb_sst_incoming(tBTA_AV_SCB* p_scb) {
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_av_set_scb_sst_opening
+ *
+ * Description      Set SST state to opening.
+ *                  Use this function to change SST outside of state machine.
+ *
+ * Returns          None
+ *
+ ******************************************************************************/
+void bta_av_set_scb_sst_opening(tBTA_AV_SCB* p_scb) {
+  if (p_scb) {
+    p_scb->state = BTA_AV_OPENING_SST;
+  }
+}
+
 /*****************************************************************************
  *  Debug Functions
  ****************************************************************************/
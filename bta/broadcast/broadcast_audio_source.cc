@@ -0,0 +1,311 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_bta_broadcast"
+
+#include "bta_broadcast_audio_source.h"
+
+#include <base/bind.h>
+#include <base/logging.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "btm_iso_tx.h"
+#include "btu.h"
+#include "osi/include/alarm.h"
+#include "osi/include/allocator.h"
+#include "osi/include/time.h"
+
+namespace {
+
+enum {
+  STAGE_READ = 0,  // PCM frame from the HAL
+  STAGE_SPLIT,     // Channels for the encoders
+  STAGE_ENCODE,    // One BIS encoder, on a worker thread
+  STAGE_FAN_OUT,   // First encoder posted to last one done
+  STAGE_SUBMIT,    // SDUs handed to the ISO transmit path
+  STAGE_MAX
+};
+
+const char* stage_names[STAGE_MAX] = {"read", "split", "encode", "fan out",
+                                      "submit"};
+
+struct StageStats {
+  uint64_t count;
+  uint64_t total_us;
+  uint64_t max_us;
+
+  void Add(uint64_t us) {
+    count++;
+    total_us += us;
+    max_us = std::max(max_us, us);
+  }
+};
+
+struct SourceStats {
+  StageStats stages[STAGE_MAX];
+  uint64_t intervals;
+  uint64_t underflows;  // Frames the HAL could not fill, padded with silence
+  uint64_t busy_ticks;  // Intervals skipped while encoders were still running
+  uint64_t no_buffer;   // SDUs with no ISO transmit buffer
+  uint64_t dropped;     // SDUs the ISO transmit path refused
+};
+
+struct BisJob {
+  uint16_t bis_handle;
+  size_t input;  // Index in Session::inputs
+  std::unique_ptr<BroadcastBisEncoder> encoder;
+  // Owned by the worker encoding it until its reply ran.
+  BT_HDR* p_sdu;
+  uint64_t encode_us;
+};
+
+struct Session {
+  BroadcastAudioConfig config;
+  BroadcastPcmReader reader;
+  uint16_t samples_per_sdu;
+  uint32_t bytes_per_frame;
+  uint64_t anchor_us;
+  uint64_t next_tick;
+  std::vector<uint8_t> pcm;
+  // One buffer per PCM channel (or downmix) some BIS is encoded from, read
+  // by the workers while encoders are running.
+  std::vector<uint8_t> input_channels;
+  std::vector<std::vector<int16_t>> inputs;
+  std::vector<BisJob> bises;
+  size_t pending;  // Encoders still running
+  uint64_t fan_out_start_us;
+};
+
+std::shared_ptr<Session> session;
+alarm_t* audio_timer = nullptr;
+SourceStats stats;
+
+void send_audio_data(void* data);
+
+void arm_timer(Session* p_session, uint64_t now_us) {
+  uint64_t due_us = p_session->anchor_us +
+                    p_session->next_tick * p_session->config.sdu_interval_us;
+  period_ms_t delay_ms = due_us > now_us ? (due_us - now_us + 999) / 1000 : 0;
+  alarm_set_on_mloop(audio_timer, delay_ms, send_audio_data, nullptr);
+}
+
+void split_channels(Session* p_session) {
+  const int16_t* pcm = (const int16_t*)p_session->pcm.data();
+  uint8_t num_channels = p_session->config.num_channels;
+
+  for (size_t i = 0; i < p_session->inputs.size(); i++) {
+    int16_t* out = p_session->inputs[i].data();
+    uint8_t channel = p_session->input_channels[i];
+    if (channel != BROADCAST_CHANNEL_DOWNMIX) {
+      for (uint16_t n = 0; n < p_session->samples_per_sdu; n++)
+        out[n] = pcm[n * num_channels + channel];
+      continue;
+    }
+    for (uint16_t n = 0; n < p_session->samples_per_sdu; n++) {
+      int32_t sum = 0;
+      for (uint8_t c = 0; c < num_channels; c++)
+        sum += pcm[n * num_channels + c];
+      out[n] = sum / num_channels;
+    }
+  }
+}
+
+// Runs on a worker thread, touching only its own BIS and the inputs, which
+// nobody writes while encoders are running.
+void encode_bis(std::shared_ptr<Session> p_session, size_t index) {
+  BisJob* p_job = &p_session->bises[index];
+  BT_HDR* p_sdu = p_job->p_sdu;
+  uint64_t start_us = time_get_os_boottime_us();
+  p_sdu->len = p_job->encoder->Encode(
+      p_session->inputs[p_job->input].data(), p_session->samples_per_sdu,
+      (uint8_t*)(p_sdu + 1) + p_sdu->offset, p_session->config.max_sdu);
+  p_job->encode_us = time_get_os_boottime_us() - start_us;
+}
+
+void on_bis_encoded(std::shared_ptr<Session> p_session) {
+  if (--p_session->pending != 0) return;
+
+  bool current = p_session == session;
+  uint64_t start_us = time_get_os_boottime_us();
+  if (current) {
+    stats.stages[STAGE_FAN_OUT].Add(start_us - p_session->fan_out_start_us);
+  }
+
+  // All SDUs of the interval go to the ISO transmit path together
+  for (auto& job : p_session->bises) {
+    BT_HDR* p_sdu = job.p_sdu;
+    if (p_sdu == nullptr) continue;
+    job.p_sdu = nullptr;
+    if (!current || p_sdu->len == 0) {
+      osi_free(p_sdu);
+      continue;
+    }
+    stats.stages[STAGE_ENCODE].Add(job.encode_us);
+    if (!btm_iso_tx_write(job.bis_handle, p_sdu)) stats.dropped++;
+  }
+
+  if (current) {
+    stats.stages[STAGE_SUBMIT].Add(time_get_os_boottime_us() - start_us);
+  }
+}
+
+void send_audio_data(void* data) {
+  if (!session) return;
+  Session* p_session = session.get();
+
+  uint64_t now_us = time_get_os_boottime_us();
+  p_session->next_tick++;
+  arm_timer(p_session, now_us);
+
+  if (p_session->pending != 0) {
+    stats.busy_ticks++;
+    return;
+  }
+  stats.intervals++;
+
+  // Read once for all the BISes
+  uint32_t bytes_read =
+      p_session->reader(p_session->pcm.data(), p_session->bytes_per_frame);
+  if (bytes_read < p_session->bytes_per_frame) {
+    memset(p_session->pcm.data() + bytes_read, 0,
+           p_session->bytes_per_frame - bytes_read);
+    stats.underflows++;
+  }
+  uint64_t read_us = time_get_os_boottime_us();
+  stats.stages[STAGE_READ].Add(read_us - now_us);
+
+  split_channels(p_session);
+  uint64_t split_us = time_get_os_boottime_us();
+  stats.stages[STAGE_SPLIT].Add(split_us - read_us);
+
+  // Take every buffer before the first encoder runs, so that none of them
+  // can finish the interval early
+  for (auto& job : p_session->bises) {
+    job.p_sdu = btm_iso_tx_get_buf(job.bis_handle);
+    if (job.p_sdu == nullptr) {
+      stats.no_buffer++;
+      continue;
+    }
+    p_session->pending++;
+  }
+
+  p_session->fan_out_start_us = split_us;
+  for (size_t i = 0; i < p_session->bises.size(); i++) {
+    if (p_session->bises[i].p_sdu == nullptr) continue;
+    do_in_worker_thread_and_reply(FROM_HERE,
+                                  base::Bind(&encode_bis, session, i),
+                                  base::Bind(&on_bis_encoded, session));
+  }
+}
+
+}  // namespace
+
+bool BroadcastAudioSource::Start(const BroadcastAudioConfig& config,
+                                 std::vector<BroadcastBisConfig> bises,
+                                 BroadcastPcmReader reader) {
+  uint64_t samples =
+      (uint64_t)config.sample_rate * config.sdu_interval_us / 1000000;
+  if (config.num_channels == 0 || samples == 0 || samples > UINT16_MAX ||
+      bises.empty() || !reader) {
+    LOG(ERROR) << __func__ << ": invalid configuration";
+    return false;
+  }
+
+  Stop();
+
+  auto p_session = std::make_shared<Session>();
+  p_session->config = config;
+  p_session->reader = std::move(reader);
+  p_session->samples_per_sdu = samples;
+  p_session->bytes_per_frame = samples * config.num_channels * sizeof(int16_t);
+  p_session->pcm.resize(p_session->bytes_per_frame);
+  p_session->pending = 0;
+
+  for (auto& bis : bises) {
+    uint8_t channel = bis.channel;
+    if (channel != BROADCAST_CHANNEL_DOWNMIX &&
+        channel >= config.num_channels) {
+      LOG(ERROR) << __func__ << ": BIS " << loghex(bis.bis_handle)
+                 << " from missing channel " << +channel;
+      return false;
+    }
+    if (!bis.encoder) {
+      LOG(ERROR) << __func__ << ": BIS " << loghex(bis.bis_handle)
+                 << " has no encoder";
+      return false;
+    }
+    if (config.num_channels == 1) channel = 0;
+
+    // BISes of the same channel, such as quality tiers, share its input
+    auto it = std::find(p_session->input_channels.begin(),
+                        p_session->input_channels.end(), channel);
+    size_t input = it - p_session->input_channels.begin();
+    if (it == p_session->input_channels.end()) {
+      p_session->input_channels.push_back(channel);
+      p_session->inputs.emplace_back(samples);
+    }
+    p_session->bises.push_back(
+        {bis.bis_handle, input, std::move(bis.encoder), nullptr, 0});
+  }
+
+  LOG(INFO) << __func__ << ": " << p_session->bises.size() << " BIS from "
+            << p_session->inputs.size() << " channels, "
+            << +config.num_channels << " x " << config.sample_rate
+            << " Hz, SDU interval " << config.sdu_interval_us << " us";
+
+  memset(&stats, 0, sizeof(stats));
+  if (audio_timer == nullptr) audio_timer = alarm_new("bta.broadcast_audio");
+  session = p_session;
+  p_session->anchor_us = time_get_os_boottime_us();
+  p_session->next_tick = 1;
+  arm_timer(p_session.get(), p_session->anchor_us);
+  return true;
+}
+
+void BroadcastAudioSource::Stop() {
+  if (!session) return;
+
+  LOG(INFO) << __func__;
+  alarm_cancel(audio_timer);
+  // Encoders still running keep the session until their replies ran
+  session.reset();
+}
+
+void BroadcastAudioSource::DebugDump(int fd) {
+  if (!session) return;
+
+  dprintf(fd, "\nBroadcast Audio Source:\n");
+  dprintf(fd,
+          "  intervals: %llu  underflows: %llu  busy: %llu  no buffer: %llu  "
+          "dropped: %llu\n",
+          (unsigned long long)stats.intervals,
+          (unsigned long long)stats.underflows,
+          (unsigned long long)stats.busy_ticks,
+          (unsigned long long)stats.no_buffer,
+          (unsigned long long)stats.dropped);
+  for (int i = 0; i < STAGE_MAX; i++) {
+    const StageStats& stage = stats.stages[i];
+    dprintf(fd, "  %-8s avg/max: %llu/%llu us\n", stage_names[i],
+            (unsigned long long)(stage.count ? stage.total_us / stage.count
+                                             : 0),
+            (unsigned long long)stage.max_us);
+  }
+}
@@ -15,6 +15,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <list>
+#include <vector>
 #include <base/strings/string_number_conversions.h>
 #include "bt_trace.h"
 #include "bta_atp_locator_api.h"
@@ -31,6 +32,14 @@
 #endif
 
 #define AOA_ALGO_INPUT_PATH_PREFIX "/data/misc/bluedroid/aoa_algo_input_"
+// Set to dump every IQ report handed to the AoA algorithm to a file
+#define AOA_ALGO_INPUT_DUMP_PROPERTY "persist.vendor.btstack.aoa_algo_input_dump"
+// Algorithm input buffers reused round-robin. The algorithm may keep the
+// last few packets it was given, so a buffer is reused only after this many
+// reports.
+#define AOA_ALGO_INPUT_POOL_SIZE 16
+// HCI event type, event code, length and sub event code
+#define AOA_ALGO_INPUT_HDR_LEN 4
 extern bool gAoaAlgoInitialized;
 #ifdef AOA_ALGO_INT
 extern AOA_STATUS (*gAoaIfInitHandle)(Int32, AoAConfig*);
@@ -182,24 +191,29 @@ Uint64 timeInMilliseconds(void) {
   return (((Uint64)tv.tv_sec)*1000)+(tv.tv_usec/1000);
 }
 
+// Called for every LE Connection IQ Report, so the input is built in a
+// pooled buffer and only formatted when the dump property is set.
 void convertHciEvtResultToAlgoInput(uint8_t* p, uint16_t evt_len) {
-  LOG(INFO) << __func__;
-  uint8_t algo_input_arr[evt_len+3]; //HCI evt + opcode(3E) + len + subevt code
+  VLOG(1) << __func__;
   uint64_t arrival_time = timeInMilliseconds();
   uint16_t data_len = evt_len+3;
-  uint8_t* p_algo_input = (uint8_t*) osi_malloc(data_len);
-  std::string algo_input_str = "";
-  char input_str[255] = {0};
+
+  std::vector<uint8_t>& algo_input = mAlgoInputPool[mAlgoInputPoolNext];
+  mAlgoInputPoolNext = (mAlgoInputPoolNext + 1) % AOA_ALGO_INPUT_POOL_SIZE;
+  algo_input.resize(evt_len + AOA_ALGO_INPUT_HDR_LEN);
+  uint8_t* p_algo_input = algo_input.data();
 
   p_algo_input[0] = 4; //HCI event
   p_algo_input[1] = 0x3E; //BLE HCI event code
   p_algo_input[2] = evt_len; //Length
   p_algo_input[3] = 0x16; //BLE subevent code, LE Conn IQ Report event
 
-  memcpy(&p_algo_input[4], p, evt_len);
-  std::vector<uint8_t> values(p_algo_input, p_algo_input + (evt_len + 3));
+  memcpy(&p_algo_input[AOA_ALGO_INPUT_HDR_LEN], p, evt_len);
 
-  if (data_len > 0) {
+  if (mDumpAlgoInput) {
+    std::vector<uint8_t> values(p_algo_input, p_algo_input + data_len);
+    std::string algo_input_str = "";
+    char input_str[255] = {0};
     for (int i=0; i< data_len; i++) {
       snprintf(input_str, sizeof(input_str), "%02x", p_algo_input[i]);
       algo_input_str.append(input_str);
@@ -207,10 +221,10 @@ void convertHciEvtResultToAlgoInput(uint8_t* p, uint16_t evt_len) {
         algo_input_str.append(",");
       }
     }
+    LOG(INFO) << __func__ << " Printing HCI LE Conn IQ Report event results : ";
+    LOG(INFO) << __func__ << algo_input_str.c_str();
+    DumpAoaAlgoInputsToFile(values, algo_input_str);
   }
-  LOG(INFO) << __func__ << " Printing HCI LE Conn IQ Report event results : ";
-  LOG(INFO) << __func__ << algo_input_str.c_str();
-  DumpAoaAlgoInputsToFile(values, algo_input_str);
 
   UpdateAoaAlgoMeasurement(arrival_time, data_len, p_algo_input);
 }
@@ -270,7 +284,7 @@ void InitializeAoaAlgo() {
 }
 
 void UpdateAoaAlgoMeasurement(uint64_t arrival_time, uint16_t data_length, uint8_t* p_data) {
-  LOG(INFO) << __func__;
+  VLOG(1) << __func__;
   AoARawPacket aoa_raw_pkt;
   aoa_raw_pkt.arrivalTime = arrival_time;
   aoa_raw_pkt.dataLen = data_length;
@@ -315,6 +329,10 @@ AoaResultsCollector(const RawAddress& address, AtpLocatorImpl *atpLocatorImpl):
                    mAtpLocatorImpl(atpLocatorImpl) {
   LOG(INFO) << __func__ << " constructor AoaResultsCollector called";
 #ifdef AOA_ALGO_INT
+  mDumpAlgoInput = osi_property_get_bool(AOA_ALGO_INPUT_DUMP_PROPERTY, false);
+  for (auto& buffer : mAlgoInputPool) {
+    buffer.reserve(UINT8_MAX + AOA_ALGO_INPUT_HDR_LEN);
+  }
   InitializeAoaAlgo();
 #endif
 }
@@ -323,6 +341,11 @@ public:
   AoAConfig mAlgoAoaConfig;
 #endif
 private:
+#ifdef AOA_ALGO_INT
+  bool mDumpAlgoInput = false;
+  std::vector<uint8_t> mAlgoInputPool[AOA_ALGO_INPUT_POOL_SIZE];
+  size_t mAlgoInputPoolNext = 0;
+#endif
   RawAddress m_bd_addrs;
 
   AtpLocatorImpl* mAtpLocatorImpl;
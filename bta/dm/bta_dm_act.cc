@@ -88,6 +88,7 @@
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/properties.h"
+#include "osi/include/trace_ring.h"
 #include "sdp_api.h"
 #include "bta_sdp_api.h"
 #include "stack/btm/btm_ble_int.h"
@@ -127,6 +128,7 @@ static void bta_dm_rem_name_cback(const RawAddress& bd_addr,
 static void bta_dm_remname_cback(void* p);
 static void bta_dm_find_services(const RawAddress& bd_addr);
 static void bta_dm_discover_next_device(void);
+static tBTM_INQ_INFO* bta_dm_build_disc_order(void);
 static void bta_dm_sdp_callback(uint16_t sdp_status);
 static uint8_t bta_dm_authorize_cback(const RawAddress& bd_addr,
                                       DEV_CLASS dev_class, BD_NAME bd_name,
@@ -1520,6 +1522,7 @@ void bta_dm_search_start(tBTA_DM_MSG* p_data) {
   }
 
   BTM_ClearInqDb(NULL);
+  bta_dm_search_cb.disc_order_cnt = 0;
   /* save search params */
   bta_dm_search_cb.p_search_cback = p_data->search.p_cback;
   bta_dm_search_cb.services = p_data->search.services;
@@ -1626,6 +1629,7 @@ void bta_dm_discover(tBTA_DM_MSG* p_data) {
   bta_dm_search_cb.peer_name[0] = 0;
   bta_dm_search_cb.sdp_search = p_data->discover.sdp_search;
   bta_dm_search_cb.p_btm_inq_info = BTM_InqDbRead(p_data->discover.bd_addr);
+  bta_dm_search_cb.disc_order_cnt = 0;
   bta_dm_search_cb.transport = p_data->discover.transport;
 
   bta_dm_search_cb.name_discover_done = false;
@@ -1813,7 +1817,7 @@ void bta_dm_inq_cmpl(tBTA_DM_MSG* p_data) {
   data.inq_cmpl.num_resps = p_data->inq_cmpl.num;
   bta_dm_search_cb.p_search_cback(BTA_DM_INQ_CMPL_EVT, &data);
 
-  bta_dm_search_cb.p_btm_inq_info = BTM_InqDbFirst();
+  bta_dm_search_cb.p_btm_inq_info = bta_dm_build_disc_order();
   if (bta_dm_search_cb.p_btm_inq_info != NULL) {
     /* start name and service discovery from the first device on inquiry result
      */
@@ -2619,6 +2623,61 @@ static void bta_dm_find_services(const RawAddress& bd_addr) {
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_dm_disc_order_rank
+ *
+ * Description      Rank of an inquiry result in the discovery order. Results
+ *                  that need no remote name request cost no air time and are
+ *                  reported first, then the others from the strongest signal
+ *                  down: a name request to a device at the edge of range
+ *                  costs a full page timeout when it fails, and the device
+ *                  next to the user is the one the pairing screen waits for.
+ *
+ * Returns          rank, lower is visited first
+ *
+ ******************************************************************************/
+static int bta_dm_disc_order_rank(const tBTM_INQ_INFO* p_info) {
+  if (p_info->appl_knows_rem_name ||
+      p_info->results.device_type == BT_DEVICE_TYPE_BLE)
+    return INT8_MIN - 1;
+  if (p_info->results.rssi == BTM_INQ_RES_IGNORE_RSSI) return INT8_MAX + 1;
+  return -p_info->results.rssi;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_dm_build_disc_order
+ *
+ * Description      Orders the inquiry results for name and service discovery
+ *
+ * Returns          first inquiry result to discover, NULL if none
+ *
+ ******************************************************************************/
+static tBTM_INQ_INFO* bta_dm_build_disc_order(void) {
+  uint8_t cnt = 0;
+
+  for (tBTM_INQ_INFO* p_info = BTM_InqDbFirst();
+       p_info != NULL && cnt < BTM_INQ_DB_SIZE;
+       p_info = BTM_InqDbNext(p_info)) {
+    /* insertion sort, stable so equal ranks keep the inquiry order */
+    int rank = bta_dm_disc_order_rank(p_info);
+    uint8_t i = cnt++;
+    while (i > 0 &&
+           bta_dm_disc_order_rank(bta_dm_search_cb.p_disc_order[i - 1]) >
+               rank) {
+      bta_dm_search_cb.p_disc_order[i] = bta_dm_search_cb.p_disc_order[i - 1];
+      i--;
+    }
+    bta_dm_search_cb.p_disc_order[i] = p_info;
+  }
+
+  bta_dm_search_cb.disc_order_cnt = cnt;
+  bta_dm_search_cb.disc_order_idx = 0;
+  APPL_TRACE_DEBUG("%s: %d inquiry results", __func__, cnt);
+  return cnt ? bta_dm_search_cb.p_disc_order[0] : NULL;
+}
+
 /*******************************************************************************
  *
  * Function         bta_dm_discover_next_device
@@ -2632,8 +2691,18 @@ static void bta_dm_discover_next_device(void) {
   APPL_TRACE_DEBUG("bta_dm_discover_next_device");
 
   /* searching next device on inquiry result */
-  bta_dm_search_cb.p_btm_inq_info =
-      BTM_InqDbNext(bta_dm_search_cb.p_btm_inq_info);
+  if (bta_dm_search_cb.disc_order_idx < bta_dm_search_cb.disc_order_cnt &&
+      bta_dm_search_cb.p_btm_inq_info ==
+          bta_dm_search_cb.p_disc_order[bta_dm_search_cb.disc_order_idx]) {
+    bta_dm_search_cb.disc_order_idx++;
+    bta_dm_search_cb.p_btm_inq_info =
+        (bta_dm_search_cb.disc_order_idx < bta_dm_search_cb.disc_order_cnt)
+            ? bta_dm_search_cb.p_disc_order[bta_dm_search_cb.disc_order_idx]
+            : NULL;
+  } else {
+    bta_dm_search_cb.p_btm_inq_info =
+        BTM_InqDbNext(bta_dm_search_cb.p_btm_inq_info);
+  }
   if (bta_dm_search_cb.p_btm_inq_info != NULL) {
     bta_dm_search_cb.name_discover_done = false;
     bta_dm_search_cb.peer_name[0] = 0;
@@ -4984,7 +5053,8 @@ static void bta_dm_observe_results_cb(tBTM_INQ_RESULTS* p_inq, uint8_t* p_eir,
                                       uint16_t eir_len) {
   tBTA_DM_SEARCH result;
   tBTM_INQ_INFO* p_inq_info;
-  APPL_TRACE_DEBUG("bta_dm_observe_results_cb");
+  TRACE_RING_LOG(VERBOSE, LOG_TAG, "%s %s rssi:%d", __func__,
+                 TRACE_RING_ADDRESS(p_inq->remote_bd_addr), p_inq->rssi);
 
   result.inq_res.bd_addr = p_inq->remote_bd_addr;
   result.inq_res.rssi = p_inq->rssi;
@@ -651,6 +651,37 @@ typedef uint8_t tBTA_DM_CONN_STATE;
 #define BTA_DM_DI_ACP_SNIFF 0x04 /* set this bit if peer init sniff */
 typedef uint8_t tBTA_DM_DEV_INFO;
 
+/* Adaptive sniff idle timeout. A sniff period that ends before
+ * BTA_DM_PM_SHORT_SNIFF_MS doubles the idle time the link has to see before it
+ * is put in sniff again, up to BTA_DM_PM_MAX_TIMEOUT_SHIFT doublings and
+ * BTA_DM_PM_MAX_ADAPT_TIMEOUT_MS. Each sniff period longer than
+ * BTA_DM_PM_LONG_SNIFF_MS halves it again. */
+#ifndef BTA_DM_PM_SHORT_SNIFF_MS
+#define BTA_DM_PM_SHORT_SNIFF_MS 2000
+#endif
+
+#ifndef BTA_DM_PM_LONG_SNIFF_MS
+#define BTA_DM_PM_LONG_SNIFF_MS 10000
+#endif
+
+#ifndef BTA_DM_PM_MAX_TIMEOUT_SHIFT
+#define BTA_DM_PM_MAX_TIMEOUT_SHIFT 3
+#endif
+
+#ifndef BTA_DM_PM_MAX_ADAPT_TIMEOUT_MS
+#define BTA_DM_PM_MAX_ADAPT_TIMEOUT_MS 30000
+#endif
+
+/* Traffic history of a link, used to adapt its sniff idle timeout */
+typedef struct {
+  uint64_t last_activity_ms; /* last time a service was busy or link woke up */
+  uint32_t avg_gap_ms;       /* moving average of the gaps between activity */
+  uint64_t sniff_start_ms;   /* time the link entered sniff mode, 0 if not */
+  uint8_t timeout_shift;     /* idle timeout is doubled this many times */
+  uint16_t short_sniffs;     /* sniff periods that ended early */
+  uint16_t sniff_count;      /* sniff periods entered */
+} tBTA_DM_PM_TRAFFIC;
+
 /* set power mode request type */
 #define BTA_DM_PM_RESTART 1
 #define BTA_DM_PM_NEW_REQ 2
@@ -670,6 +701,7 @@ typedef struct {
 #endif
   tBTA_DM_PM_ACTION pm_mode_attempted;
   tBTA_DM_PM_ACTION pm_mode_failed;
+  tBTA_DM_PM_TRAFFIC pm_traffic;
   bool remove_dev_pending;
   uint16_t conn_handle;
   tBT_TRANSPORT transport;
@@ -818,6 +850,10 @@ typedef struct {
   alarm_t* discovery_cb_alarm; /* timer to notify upper layer about discovery complete */
   RawAddress pending_close_bda; /* pending GATT channel remote device address */
   std::queue<tBTA_DM_MSG *> p_disc_queue;
+  /* inquiry results in the order name and service discovery visits them */
+  tBTM_INQ_INFO* p_disc_order[BTM_INQ_DB_SIZE];
+  uint8_t disc_order_cnt;
+  uint8_t disc_order_idx;
 } tBTA_DM_SEARCH_CB;
 
 /* DI control block */
@@ -37,6 +37,7 @@
 #include "btm_api.h"
 
 #include "device/include/interop.h"
+#include "osi/include/time.h"
 
 extern fixed_queue_t* btu_bta_alarm_queue;
 
@@ -58,6 +59,9 @@ static void bta_dm_pm_set_sniff_policy(tBTA_DM_PEER_DEVICE* p_dev,
                                        bool bDisable);
 static void bta_dm_pm_stop_timer_by_index(tBTA_PM_TIMER* p_timer,
                                           uint8_t timer_idx);
+static void bta_dm_pm_note_activity(tBTA_DM_PEER_DEVICE* p_dev);
+static period_ms_t bta_dm_pm_adapt_timeout(tBTA_DM_PEER_DEVICE* p_dev,
+                                           period_ms_t timeout_ms);
 
 #if (BTM_SSR_INCLUDED == TRUE)
 #if (BTA_HH_INCLUDED == TRUE)
@@ -323,6 +327,114 @@ static void bta_dm_pm_stop_timer_by_index(tBTA_PM_TIMER* p_timer,
   alarm_cancel(p_timer->timer[timer_idx]);
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_dm_pm_note_activity
+ *
+ * Description      Record traffic on a link: a service reporting busy, or
+ *                  the link leaving sniff mode. Activity closer together
+ *                  than the shortest sniff period is one burst and does not
+ *                  count as a gap.
+ *
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void bta_dm_pm_note_activity(tBTA_DM_PEER_DEVICE* p_dev) {
+  tBTA_DM_PM_TRAFFIC* p_traffic = &p_dev->pm_traffic;
+  uint64_t now_ms = time_get_os_boottime_ms();
+
+  if (p_traffic->last_activity_ms != 0) {
+    uint64_t gap_ms = now_ms - p_traffic->last_activity_ms;
+    if (gap_ms < BTA_DM_PM_SHORT_SNIFF_MS / 4) {
+      p_traffic->last_activity_ms = now_ms;
+      return;
+    }
+    if (gap_ms > BTA_DM_PM_MAX_ADAPT_TIMEOUT_MS)
+      gap_ms = BTA_DM_PM_MAX_ADAPT_TIMEOUT_MS;
+
+    if (p_traffic->avg_gap_ms == 0)
+      p_traffic->avg_gap_ms = gap_ms;
+    else
+      p_traffic->avg_gap_ms = (3 * p_traffic->avg_gap_ms + gap_ms) / 4;
+  }
+  p_traffic->last_activity_ms = now_ms;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_dm_pm_sniff_ended
+ *
+ * Description      Update the idle timeout of a link that left sniff mode
+ *                  from how long the sniff period lasted. Short periods mean
+ *                  the link is woken up by traffic right after going to
+ *                  sniff, so the idle timeout grows; it only shrinks again
+ *                  after clearly longer periods, which keeps the link from
+ *                  flipping between the two.
+ *
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void bta_dm_pm_sniff_ended(tBTA_DM_PEER_DEVICE* p_dev) {
+  tBTA_DM_PM_TRAFFIC* p_traffic = &p_dev->pm_traffic;
+
+  if (p_traffic->sniff_start_ms == 0) return;
+
+  uint64_t dwell_ms = time_get_os_boottime_ms() - p_traffic->sniff_start_ms;
+  p_traffic->sniff_start_ms = 0;
+
+  if (dwell_ms < BTA_DM_PM_SHORT_SNIFF_MS) {
+    p_traffic->short_sniffs++;
+    if (p_traffic->timeout_shift < BTA_DM_PM_MAX_TIMEOUT_SHIFT)
+      p_traffic->timeout_shift++;
+  } else if (dwell_ms > BTA_DM_PM_LONG_SNIFF_MS) {
+    if (p_traffic->timeout_shift > 0) p_traffic->timeout_shift--;
+  }
+
+  APPL_TRACE_DEBUG(
+      "%s: %s sniff lasted %llu ms (%d of %d short), timeout shift %d",
+      __func__, p_dev->peer_bdaddr.ToString().c_str(),
+      (unsigned long long)dwell_ms, p_traffic->short_sniffs,
+      p_traffic->sniff_count, p_traffic->timeout_shift);
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_dm_pm_adapt_timeout
+ *
+ * Description      Adapt the idle timeout before sniff mode, taken from the
+ *                  power mode tables, to the traffic seen on the link. While
+ *                  the link keeps leaving sniff early the timeout is scaled
+ *                  up and, when traffic arrives at a steady pace, stretched
+ *                  past the expected gap to the next burst.
+ *
+ *
+ * Returns          Idle timeout to use, in milliseconds
+ *
+ ******************************************************************************/
+static period_ms_t bta_dm_pm_adapt_timeout(tBTA_DM_PEER_DEVICE* p_dev,
+                                           period_ms_t timeout_ms) {
+  const tBTA_DM_PM_TRAFFIC* p_traffic = &p_dev->pm_traffic;
+
+  if (p_traffic->timeout_shift == 0) return timeout_ms;
+
+  period_ms_t adapted_ms = timeout_ms << p_traffic->timeout_shift;
+  period_ms_t expected_gap_ms =
+      p_traffic->avg_gap_ms + p_traffic->avg_gap_ms / 4;
+  if (p_traffic->avg_gap_ms > timeout_ms && expected_gap_ms > adapted_ms)
+    adapted_ms = expected_gap_ms;
+  if (adapted_ms > BTA_DM_PM_MAX_ADAPT_TIMEOUT_MS)
+    adapted_ms = BTA_DM_PM_MAX_ADAPT_TIMEOUT_MS;
+  if (adapted_ms < timeout_ms) adapted_ms = timeout_ms;
+
+  APPL_TRACE_DEBUG("%s: %s idle timeout %llu -> %llu ms (gap %u ms)",
+                   __func__, p_dev->peer_bdaddr.ToString().c_str(),
+                   (unsigned long long)timeout_ms,
+                   (unsigned long long)adapted_ms, p_traffic->avg_gap_ms);
+  return adapted_ms;
+}
+
 /*******************************************************************************
  *
  * Function         bta_dm_pm_cback
@@ -353,6 +465,8 @@ static void bta_dm_pm_cback(tBTA_SYS_CONN_STATUS status, uint8_t id,
     APPL_TRACE_DEBUG("bta_dm_pm_cback: No peer device found");
     return;
   }
+
+  if (status == BTA_SYS_CONN_BUSY) bta_dm_pm_note_activity(p_dev);
   /* find if there is an power mode entry for the service */
   for (i = 1; i <= p_bta_dm_pm_cfg[0].app_id; i++) {
     if ((p_bta_dm_pm_cfg[i].id == id) &&
@@ -660,6 +774,9 @@ static void bta_dm_pm_set_mode(const RawAddress& peer_addr,
       }
     }
   }
+
+  if ((pm_action & BTA_DM_PM_SNIFF) && (timeout_ms > 0))
+    timeout_ms = bta_dm_pm_adapt_timeout(p_peer_device, timeout_ms);
   /* if need to start a timer */
   if ((pm_req != BTA_DM_PM_EXECUTE) && (timeout_ms > 0)) {
     for (i = 0; i < BTA_DM_NUM_PM_TIMER; i++) {
@@ -1041,6 +1158,11 @@ void bta_dm_pm_btm_status(tBTA_DM_MSG* p_data) {
                              BTA_DM_PM_RESTART);
         }
       } else {
+        /* woken up from sniff, most likely by traffic */
+        if (p_dev->pm_traffic.sniff_start_ms != 0) {
+          bta_dm_pm_sniff_ended(p_dev);
+          bta_dm_pm_note_activity(p_dev);
+        }
 #if (BTM_SSR_INCLUDED == TRUE)
         if (p_dev->prev_low) {
           /* need to send the SSR paramaters to controller again */
@@ -1082,6 +1204,10 @@ void bta_dm_pm_btm_status(tBTA_DM_MSG* p_data) {
          * in sniff mode from host side.
          */
         bta_dm_pm_stop_timer(p_data->pm_status.bd_addr);
+        if (p_dev->pm_traffic.sniff_start_ms == 0) {
+          p_dev->pm_traffic.sniff_start_ms = time_get_os_boottime_ms();
+          p_dev->pm_traffic.sniff_count++;
+        }
       } else {
         p_dev->info &=
             ~(BTA_DM_DI_SET_SNIFF | BTA_DM_DI_INT_SNIFF | BTA_DM_DI_ACP_SNIFF);
@@ -65,12 +65,14 @@
 #include "bt_common.h"
 #include "bt_target.h"
 #include "bta_closure_api.h"
+#include "bta_gatt_queue.h"
 #include "bta_gattc_int.h"
 #include "bta_sys.h"
 #include "btif/include/btif_debug_conn.h"
 #include "l2c_api.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/time.h"
 #include "stack/l2cap/l2c_int.h"
 #include "utl.h"
 #include "device/include/interop.h"
@@ -267,6 +269,12 @@ void bta_gattc_register(const Uuid& app_uuid, tBTA_GATTC_CBACK* p_cback,
         /* BTA use the same client interface as BTE GATT statck */
         client_if = bta_gattc_cb.cl_rcb[i].client_if;
 
+        /* packing delays Write Commands, so it is off unless configured */
+        int32_t pack_ms = osi_property_get_int32(
+            "persist.vendor.btstack.gattc_write_pack_ms", 0);
+        if (pack_ms > 0 && pack_ms <= UINT16_MAX)
+          GATTC_SetWritePacking(client_if, pack_ms);
+
         do_in_bta_thread(FROM_HERE,
                           base::Bind(&bta_gattc_start_if, client_if));
 
@@ -1333,6 +1341,14 @@ void bta_gattc_cfg_mtu_cmpl(tBTA_GATTC_CLCB* p_clcb,
   (*p_clcb->p_rcb->p_cback)(BTA_GATTC_CFG_MTU_EVT, &cb_data);
 }
 
+/** account the application callback that started at |start_us| to |p_clcb| */
+static void bta_gattc_cback_done(tBTA_GATTC_CLCB* p_clcb, uint64_t start_us) {
+  uint64_t elapsed_us = time_get_os_boottime_us() - start_us;
+  p_clcb->cback_count++;
+  p_clcb->cback_total_us += elapsed_us;
+  if (elapsed_us > p_clcb->cback_max_us) p_clcb->cback_max_us = elapsed_us;
+}
+
 /** operation completed */
 void bta_gattc_op_cmpl(tBTA_GATTC_CLCB* p_clcb, tBTA_GATTC_DATA* p_data) {
   uint8_t op = (uint8_t)p_data->op_cmpl.op_code;
@@ -1393,12 +1409,16 @@ void bta_gattc_op_cmpl(tBTA_GATTC_CLCB* p_clcb, tBTA_GATTC_DATA* p_data) {
   }
 
   /* service handle change void the response, discard it */
+  uint64_t start_us = time_get_os_boottime_us();
   if (op == GATTC_OPTYPE_READ) {
     bta_gattc_read_cmpl(p_clcb, &p_data->op_cmpl);
+    bta_gattc_cback_done(p_clcb, start_us);
   } else if (op == GATTC_OPTYPE_WRITE) {
     bta_gattc_write_cmpl(p_clcb, &p_data->op_cmpl);
+    bta_gattc_cback_done(p_clcb, start_us);
   } else if (op == GATTC_OPTYPE_EXE_WRITE) {
     bta_gattc_exec_cmpl(p_clcb, &p_data->op_cmpl);
+    bta_gattc_cback_done(p_clcb, start_us);
   } else if (op == GATTC_OPTYPE_CONFIG) {
     bta_gattc_cfg_mtu_cmpl(p_clcb, &p_data->op_cmpl);
 
@@ -1825,25 +1845,30 @@ void bta_gattc_proc_other_indication(tBTA_GATTC_CLCB* p_clcb, uint8_t op,
     }
   }
 
-  p_notify->is_notify = (op == GATTC_OPTYPE_INDICATION) ? false : true;
-  p_notify->len = p_data->att_value.len;
-  p_notify->bda = p_clcb->bda;
-  memcpy(p_notify->value, p_data->att_value.value, p_data->att_value.len);
-  p_notify->conn_id = p_clcb->bta_conn_id;
+  if (!p_clcb->p_rcb->p_cback) return;
+
+  /* fill the event in place, the value is copied only the bytes it has */
+  tBTA_GATTC bta_gattc;
+  tBTA_GATTC_NOTIFY& notify = bta_gattc.notify;
+  notify.handle = p_notify->handle;
+  notify.trans_id = p_notify->trans_id;
+  notify.is_notify = (op == GATTC_OPTYPE_INDICATION) ? false : true;
+  notify.len = p_data->att_value.len;
+  notify.bda = p_clcb->bda;
+  memcpy(notify.value, p_data->att_value.value, p_data->att_value.len);
+  notify.conn_id = p_clcb->bta_conn_id;
 
 #ifdef ADV_AUDIO_FEATURE
   if (is_remote_support_adv_audio(p_clcb->bda)) {
-    auto itr = dev_addr_map.find(p_notify->conn_id);
+    auto itr = dev_addr_map.find(notify.conn_id);
     if (itr != dev_addr_map.end()) {
-      p_notify->bda = itr->second;
+      notify.bda = itr->second;
     }
   }
 #endif
-  if (p_clcb->p_rcb->p_cback) {
-    tBTA_GATTC bta_gattc;
-    bta_gattc.notify = *p_notify;
-    (*p_clcb->p_rcb->p_cback)(BTA_GATTC_NOTIF_EVT, &bta_gattc);
-  }
+  uint64_t start_us = time_get_os_boottime_us();
+  (*p_clcb->p_rcb->p_cback)(BTA_GATTC_NOTIF_EVT, &bta_gattc);
+  bta_gattc_cback_done(p_clcb, start_us);
 }
 
 /** process indication/notification */
@@ -1878,8 +1903,8 @@ void bta_gattc_process_indicate(uint16_t conn_id, tGATTC_OPTYPE op,
     return;
   }
 
-  LOG(INFO) << __func__ << " conn_id " << conn_id << " gatt_if "
-    << loghex(gatt_if);
+  VLOG(1) << __func__ << " conn_id " << conn_id << " gatt_if "
+          << loghex(gatt_if);
   tBTA_GATTC_CLCB* p_clcb = bta_gattc_find_clcb_by_conn_id(conn_id);
 
   notify.handle = handle;
@@ -1899,7 +1924,6 @@ void bta_gattc_process_indicate(uint16_t conn_id, tGATTC_OPTYPE op,
   /* if app registered for the notification */
   if (bta_gattc_check_notif_registry(p_clrcb, p_srcb, &notify)) {
     /* connection not open yet */
-  LOG(ERROR) << __func__ << " conn_id " << conn_id << " gatt_if " << gatt_if;
     if (p_clcb == NULL) {
       p_clcb = bta_gattc_clcb_alloc(gatt_if, remote_bda, transport);
 
@@ -1975,6 +1999,8 @@ void bta_gattc_cmpl_sendmsg(uint16_t conn_id, tGATTC_OPTYPE op,
 
 /** congestion callback for BTA GATT client */
 static void bta_gattc_cong_cback(uint16_t conn_id, bool congested) {
+  BtaGattQueue::CongestionChanged(conn_id, congested);
+
   tBTA_GATTC_CLCB* p_clcb = bta_gattc_find_clcb_by_conn_id(conn_id);
   if (!p_clcb || !p_clcb->p_rcb->p_cback) return;
 
@@ -24,6 +24,7 @@
 
 #include "bt_target.h"
 
+#include <stdio.h>
 #include <string.h>
 
 #include <base/bind.h>
@@ -32,9 +33,11 @@
 #include "bt_common.h"
 #include "bta_closure_api.h"
 #include "bta_gatt_api.h"
+#include "bta_gatt_queue.h"
 #include "bta_gattc_int.h"
 #include "bta_sys.h"
 #include "device/include/controller.h"
+#include "osi/include/time.h"
 #include "stack/btm/btm_int_types.h"
 #include "btif/include/btif_storage.h"
 
@@ -354,6 +357,29 @@ const gatt::Service* BTA_GATTC_GetOwningService(uint16_t conn_id,
   return bta_gattc_get_service_for_handle(conn_id, handle);
 }
 
+/*******************************************************************************
+ *
+ * Function         BTA_GATTC_GetDatabaseHash
+ *
+ * Description      This function is called to get the hash of the GATT
+ *                  database discovered or loaded for the given server.
+ *
+ * Parameters       conn_id: connection ID which identify the server.
+ *                  p_hash: output parameter which will contain the hash
+ *
+ * Returns          true if the database is available, false otherwise.
+ *
+ ******************************************************************************/
+bool BTA_GATTC_GetDatabaseHash(uint16_t conn_id, Octet16* p_hash) {
+  tBTA_GATTC_CLCB* p_clcb = bta_gattc_find_clcb_by_conn_id(conn_id);
+
+  if (p_clcb == NULL || p_clcb->p_srcb == NULL || p_hash == NULL) return false;
+  if (p_clcb->p_srcb->gatt_database.IsEmpty()) return false;
+
+  *p_hash = p_clcb->p_srcb->gatt_database.Hash();
+  return true;
+}
+
 /*******************************************************************************
  *
  * Function         BTA_GATTC_GetGattDb
@@ -839,3 +865,104 @@ void BTA_GATTC_ResetGattDb(const RawAddress& remote_bda) {
   do_in_bta_thread(FROM_HERE,
                    base::Bind(&bta_gattc_cache_reset, remote_bda));
 }
+
+/*******************************************************************************
+ *
+ * Function         BTA_GATTC_GetConnStats
+ *
+ * Description      Get the latency and throughput counters of a connection.
+ *
+ * Returns          true if the connection exists and |p_stats| was filled.
+ *
+ ******************************************************************************/
+bool BTA_GATTC_GetConnStats(uint16_t conn_id, tBTA_GATTC_CONN_STATS* p_stats) {
+  CHECK(p_stats != NULL);
+
+  tBTA_GATTC_CLCB* p_clcb = bta_gattc_find_clcb_by_conn_id(conn_id);
+  if (p_clcb == NULL) return false;
+  if (!GATTC_GetConnStats(conn_id, &p_stats->link)) return false;
+
+  p_stats->queue_depth = BtaGattQueue::QueueDepth(conn_id);
+  p_stats->queue_max_depth = BtaGattQueue::MaxQueueDepth(conn_id);
+  p_stats->cback_count = p_clcb->cback_count;
+  p_stats->cback_max_us = p_clcb->cback_max_us;
+  p_stats->cback_total_us = p_clcb->cback_total_us;
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         BTA_GATTC_DumpConnStats
+ *
+ * Description      Dump the counters of all client connections.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void BTA_GATTC_DumpConnStats(int fd) {
+  static const char* const rtt_op_names[GATTC_RTT_OPCODE_SLOTS] = {
+      NULL,           "mtu",        "find_info",
+      "find_by_type", "read_type",  "read",
+      "read_blob",    "read_multi", "read_group",
+      "write",        NULL,         "prep_write",
+      "exec_write",   NULL,         NULL,
+      NULL,           "read_multi_var"};
+  uint64_t now_ms = time_get_os_boottime_ms();
+
+  dprintf(fd, "\nGATT client connections:\n");
+
+  for (int i = 0; i < BTA_GATTC_CLCB_MAX; i++) {
+    const tBTA_GATTC_CLCB& clcb = bta_gattc_cb.clcb[i];
+    if (!clcb.in_use) continue;
+
+    tBTA_GATTC_CONN_STATS stats;
+    if (!BTA_GATTC_GetConnStats(clcb.bta_conn_id, &stats)) continue;
+
+    const tGATTC_CONN_STATS& link = stats.link;
+    uint64_t elapsed_s =
+        (now_ms > link.start_ms) ? (now_ms - link.start_ms) / 1000 : 0;
+    if (elapsed_s == 0) elapsed_s = 1;
+
+    dprintf(fd, "  conn_id=0x%04x %s\n", clcb.bta_conn_id,
+            clcb.bda.ToString().c_str());
+    dprintf(fd,
+            "    ntf=%u ind=%u value_bytes=%llu (%llu ntf/s, %llu B/s)\n",
+            link.ntf_rcvd, link.ind_rcvd,
+            (unsigned long long)link.value_bytes_rcvd,
+            (unsigned long long)(link.ntf_rcvd / elapsed_s),
+            (unsigned long long)(link.value_bytes_rcvd / elapsed_s));
+    if (link.writes_packed) {
+      dprintf(fd, "    writes_packed=%u pack_flushes=%u\n", link.writes_packed,
+              link.pack_flushes);
+    }
+    dprintf(fd, "    queue depth=%u max=%u\n", stats.queue_depth,
+            stats.queue_max_depth);
+    dprintf(fd, "    callbacks=%u avg_us=%llu max_us=%u\n", stats.cback_count,
+            (unsigned long long)(stats.cback_count
+                                     ? stats.cback_total_us / stats.cback_count
+                                     : 0),
+            stats.cback_max_us);
+
+    for (int slot = 0; slot < GATTC_RTT_OPCODE_SLOTS; slot++) {
+      const tGATTC_RTT_STATS& rtt = link.rtt[slot];
+      if (rtt.count == 0) continue;
+
+      dprintf(fd, "    rtt %s: count=%u avg_ms=%llu max_ms=%u hist=",
+              rtt_op_names[slot] ? rtt_op_names[slot] : "other", rtt.count,
+              (unsigned long long)(rtt.total_ms / rtt.count), rtt.max_ms);
+      for (int bucket = 0; bucket < GATTC_RTT_HIST_BUCKETS; bucket++)
+        dprintf(fd, "%s%u", bucket ? "/" : "", rtt.hist[bucket]);
+      dprintf(fd, "\n");
+    }
+
+    for (int b = 0; b < link.num_bearers; b++) {
+      const tGATT_BEARER_STATS& bearer = link.bearers[b];
+      dprintf(fd,
+              "    bearer lcid=0x%04x apps=%u tx=%u/%lluB rx=%u/%lluB "
+              "srtt_ms=%u\n",
+              bearer.lcid, bearer.num_apps, bearer.tx_pdus,
+              (unsigned long long)bearer.tx_bytes, bearer.rx_pdus,
+              (unsigned long long)bearer.rx_bytes, bearer.srtt_ms);
+    }
+  }
+}
@@ -21,8 +21,12 @@
 #include <base/logging.h>
 #include <base/strings/string_number_conversions.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
+#include <list>
 #include <string>
 #include <vector>
 
@@ -44,6 +48,12 @@ using std::vector;
 // Default expired time is 7 days
 #define GATT_HASH_EXPIRED_TIME 604800
 
+// Number of recently used databases kept in memory
+#define GATT_DB_LRU_SIZE 8
+
+/* Cache file layout: version, number of attributes, attributes */
+#define GATT_CACHE_HDR_SIZE (2 * sizeof(uint16_t))
+
 static void bta_gattc_hash_remove_least_recently_used_if_possible();
 
 static void bta_gattc_generate_cache_file_name(char* buffer, size_t buffer_len,
@@ -61,11 +71,69 @@ static void bta_gattc_generate_hash_file_name(char* buffer, size_t buffer_len,
 
 static gatt::Database EMPTY_DB;
 
+/* A recently used database. Address files are hard links to the hash file of
+ * the database, so both are recognized by the inode of the file. The
+ * modification time guards against an inode reused by another file. */
+typedef struct {
+  Octet16 hash;
+  dev_t dev;
+  ino_t ino;
+  time_t mtime;
+  gatt::Database db;
+} tBTA_GATTC_DB_LRU_ENTRY;
+
+static std::list<tBTA_GATTC_DB_LRU_ENTRY> db_lru;
+
+static const gatt::Database* bta_gattc_lru_find_by_hash(const Octet16& hash) {
+  for (auto it = db_lru.begin(); it != db_lru.end(); it++) {
+    if (it->hash != hash) continue;
+    db_lru.splice(db_lru.begin(), db_lru, it);
+    return &db_lru.front().db;
+  }
+  return nullptr;
+}
+
+static const gatt::Database* bta_gattc_lru_find_by_file(const char* fname) {
+  struct stat st;
+  if (stat(fname, &st) != 0) return nullptr;
+
+  for (auto it = db_lru.begin(); it != db_lru.end(); it++) {
+    if (it->dev != st.st_dev || it->ino != st.st_ino ||
+        it->mtime != st.st_mtime)
+      continue;
+    db_lru.splice(db_lru.begin(), db_lru, it);
+    return &db_lru.front().db;
+  }
+  return nullptr;
+}
+
+/* Remember |db| with |hash|, stored in the file |fname|. */
+static void bta_gattc_lru_add(const Octet16& hash, const char* fname,
+                              const gatt::Database& db) {
+  struct stat st;
+  if (stat(fname, &st) != 0) return;
+
+  for (auto it = db_lru.begin(); it != db_lru.end(); it++) {
+    if (it->hash == hash) {
+      db_lru.erase(it);
+      break;
+    }
+  }
+
+  db_lru.push_front(tBTA_GATTC_DB_LRU_ENTRY{.hash = hash,
+                                            .dev = st.st_dev,
+                                            .ino = st.st_ino,
+                                            .mtime = st.st_mtime,
+                                            .db = db});
+  if (db_lru.size() > GATT_DB_LRU_SIZE) db_lru.pop_back();
+}
+
 /*******************************************************************************
  *
  * Function         bta_gattc_load_db
  *
- * Description      Load GATT database from storage.
+ * Description      Load GATT database from storage. The file is mapped into
+ *                  memory and its attributes are used in place.
  *
  * Parameter        fname: input file name
  *
@@ -74,49 +142,48 @@ static gatt::Database EMPTY_DB;
  *
  ******************************************************************************/
 static gatt::Database bta_gattc_load_db(const char* fname) {
-  FILE* fd = fopen(fname, "rb");
-  if (!fd) {
+  int fd = open(fname, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
     LOG(ERROR) << __func__ << ": can't open GATT cache file " << fname
                << " for reading, error: " << strerror(errno);
     return EMPTY_DB;
   }
 
-  uint16_t cache_ver = 0;
-  uint16_t num_attr = 0;
-
-  if (fread(&cache_ver, sizeof(uint16_t), 1, fd) != 1) {
-    LOG(ERROR) << __func__ << ": can't read GATT cache version from: " << fname;
-    goto done;
-  }
-
-  if (cache_ver != GATT_CACHE_VERSION) {
-    LOG(ERROR) << __func__ << ": wrong GATT cache version: " << fname;
-    goto done;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < GATT_CACHE_HDR_SIZE) {
+    LOG(ERROR) << __func__ << ": can't read GATT cache header from: " << fname;
+    close(fd);
+    return EMPTY_DB;
   }
 
-  if (fread(&num_attr, sizeof(uint16_t), 1, fd) != 1) {
-    LOG(ERROR) << __func__
-               << ": can't read number of GATT attributes: " << fname;
-    goto done;
+  size_t size = st.st_size;
+  void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    LOG(ERROR) << __func__ << ": can't map GATT cache file " << fname
+               << ", error: " << strerror(errno);
+    return EMPTY_DB;
   }
 
-  {
-    std::vector<StoredAttribute> attr(num_attr);
-
-    if (fread(attr.data(), sizeof(StoredAttribute), num_attr, fd) != num_attr) {
-      LOG(ERROR) << __func__ << ": can't read GATT attributes: " << fname;
-      goto done;
-    }
+  const uint16_t* p_hdr = (const uint16_t*)map;
+  uint16_t cache_ver = p_hdr[0];
+  uint16_t num_attr = p_hdr[1];
+  gatt::Database result = EMPTY_DB;
 
-    fclose(fd);
+  if (cache_ver != GATT_CACHE_VERSION) {
+    LOG(ERROR) << __func__ << ": wrong GATT cache version: " << fname;
+  } else if (size < GATT_CACHE_HDR_SIZE + num_attr * sizeof(StoredAttribute)) {
+    LOG(ERROR) << __func__ << ": can't read GATT attributes: " << fname;
+  } else {
     bool success = false;
-    gatt::Database result = gatt::Database::Deserialize(attr, &success);
-    return success ? result : EMPTY_DB;
+    result = gatt::Database::Deserialize(
+        (const StoredAttribute*)((const uint8_t*)map + GATT_CACHE_HDR_SIZE),
+        num_attr, &success);
+    if (!success) result = EMPTY_DB;
   }
 
-done:
-  fclose(fd);
-  return EMPTY_DB;
+  munmap(map, size);
+  return result;
 }
 
 /*******************************************************************************
@@ -134,7 +201,13 @@ done:
 gatt::Database bta_gattc_cache_load(const RawAddress& server_bda) {
   char fname[255] = {0};
   bta_gattc_generate_cache_file_name(fname, sizeof(fname), server_bda);
-  return bta_gattc_load_db(fname);
+
+  const gatt::Database* p_db = bta_gattc_lru_find_by_file(fname);
+  if (p_db) return *p_db;
+
+  gatt::Database db = bta_gattc_load_db(fname);
+  if (!db.IsEmpty()) bta_gattc_lru_add(db.Hash(), fname, db);
+  return db;
 }
 
 /*******************************************************************************
@@ -150,9 +223,15 @@ gatt::Database bta_gattc_cache_load(const RawAddress& server_bda) {
  *
  ******************************************************************************/
 gatt::Database bta_gattc_hash_load(const Octet16& hash) {
+  const gatt::Database* p_db = bta_gattc_lru_find_by_hash(hash);
+  if (p_db) return *p_db;
+
   char fname[255] = {0};
   bta_gattc_generate_hash_file_name(fname, sizeof(fname), hash);
-  return bta_gattc_load_db(fname);
+
+  gatt::Database db = bta_gattc_load_db(fname);
+  if (!db.IsEmpty()) bta_gattc_lru_add(hash, fname, db);
+  return db;
 }
 
 /*******************************************************************************
@@ -271,7 +350,10 @@ bool bta_gattc_hash_write(const Octet16& hash, const gatt::Database& database) {
   char fname[255] = {0};
   bta_gattc_generate_hash_file_name(fname, sizeof(fname), hash);
   bta_gattc_hash_remove_least_recently_used_if_possible();
-  return bta_gattc_store_db(fname, database.Serialize());
+  if (!bta_gattc_store_db(fname, database.Serialize())) return false;
+
+  bta_gattc_lru_add(hash, fname, database);
+  return true;
 }
 
 /*******************************************************************************
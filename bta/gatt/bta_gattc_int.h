@@ -287,6 +287,11 @@ typedef struct {
   tGATT_STATUS status;
   uint16_t reason;
   uint16_t handle;
+
+  /* time spent in application callbacks, see BTA_GATTC_GetConnStats */
+  uint32_t cback_count;
+  uint32_t cback_max_us;
+  uint64_t cback_total_us;
 } tBTA_GATTC_CLCB;
 
 /* back ground connection tracking information */
@@ -16,6 +16,7 @@
 
 #include "bta_gatt_queue.h"
 
+#include <algorithm>
 #include <list>
 #include <unordered_map>
 #include <unordered_set>
@@ -28,6 +29,11 @@ constexpr uint8_t GATT_WRITE_CHAR = 3;
 constexpr uint8_t GATT_WRITE_DESC = 4;
 constexpr uint8_t GATT_CONFIG_MTU = 5;
 
+/* Maximum number of write commands handed to BTA GATTC at once on a pipelined
+ * connection. Keeps the stack queues short enough for the L2CAP congestion
+ * feedback to throttle the stream. */
+constexpr uint8_t GATT_MAX_WRITE_CMDS_IN_FLIGHT = 8;
+
 struct gatt_read_op_data {
   GATT_READ_OP_CB cb;
   void* cb_data;
@@ -36,11 +42,20 @@ struct gatt_read_op_data {
 std::unordered_map<uint16_t, std::list<gatt_operation>>
     BtaGattQueue::gatt_op_queue;
 std::unordered_set<uint16_t> BtaGattQueue::gatt_op_queue_executing;
+std::unordered_set<uint16_t> BtaGattQueue::gatt_op_queue_pipelined;
+std::unordered_set<uint16_t> BtaGattQueue::gatt_op_queue_congested;
+std::unordered_map<uint16_t, uint8_t> BtaGattQueue::gatt_write_cmds_in_flight;
+std::unordered_map<uint16_t, size_t> BtaGattQueue::gatt_op_queue_max_depth;
 
 void BtaGattQueue::mark_as_not_executing(uint16_t conn_id) {
   gatt_op_queue_executing.erase(conn_id);
 }
 
+bool BtaGattQueue::is_streamable(uint16_t conn_id, const gatt_operation& op) {
+  return op.type == GATT_WRITE_CHAR && op.write_type == GATT_WRITE_NO_RSP &&
+         gatt_op_queue_pipelined.count(conn_id);
+}
+
 void BtaGattQueue::gatt_read_op_finished(uint16_t conn_id, tGATT_STATUS status,
                                          uint16_t handle, uint16_t len,
                                          uint8_t* value, void* data) {
@@ -88,6 +103,36 @@ void BtaGattQueue::gatt_write_op_finished(uint16_t conn_id, tGATT_STATUS status,
   }
 }
 
+void BtaGattQueue::gatt_write_cmd_op_finished(uint16_t conn_id,
+                                              tGATT_STATUS status,
+                                              uint16_t handle, uint16_t len,
+                                              const uint8_t* value,
+                                              void* data) {
+  gatt_write_op_data* tmp = (gatt_write_op_data*)data;
+  GATT_WRITE_OP_CB tmp_cb = tmp->cb;
+  void* tmp_cb_data = tmp->cb_data;
+
+  APPL_TRACE_DEBUG("%s: conn_id=0x%x handle=%d status=%d", __func__, conn_id,
+    handle, status);
+
+  osi_free(data);
+
+  auto in_flight = gatt_write_cmds_in_flight.find(conn_id);
+  if (in_flight != gatt_write_cmds_in_flight.end() && in_flight->second > 0)
+    in_flight->second--;
+
+  /* The command went out, but the channel is full now. Slow down until the
+   * congestion is over. */
+  if (status == GATT_CONGESTED) gatt_op_queue_congested.insert(conn_id);
+
+  gatt_execute_next_op(conn_id);
+
+  if (tmp_cb) {
+    tmp_cb(conn_id, status, handle, len, value, tmp_cb_data);
+    return;
+  }
+}
+
 struct gatt_configure_mtu_op_data {
   GATT_CONFIGURE_MTU_OP_CB cb;
   void* cb_data;
@@ -125,17 +170,60 @@ void BtaGattQueue::gatt_execute_next_op(uint16_t conn_id) {
     return;
   }
 
+  size_t& max_depth = gatt_op_queue_max_depth[conn_id];
+  max_depth = std::max(max_depth, map_ptr->second.size());
+
   if (gatt_op_queue_executing.count(conn_id)) {
     APPL_TRACE_DEBUG("%s: can't enqueue next op, already executing", __func__);
     return;
   }
 
-  gatt_op_queue_executing.insert(conn_id);
-
   std::list<gatt_operation>& gatt_ops = map_ptr->second;
 
-  gatt_operation& op = gatt_ops.front();
+  /* Write commands of a pipelined connection are streamed without waiting for
+   * each other, any other operation waits until the stream has drained. BTA
+   * GATTC completes operations in the order they were issued, so callers see
+   * the same completion order as in the serialized mode. */
+  while (!gatt_ops.empty()) {
+    gatt_operation& op = gatt_ops.front();
+    uint8_t& in_flight = gatt_write_cmds_in_flight[conn_id];
+
+    if (is_streamable(conn_id, op)) {
+      uint8_t max_in_flight = gatt_op_queue_congested.count(conn_id)
+                                  ? 1
+                                  : GATT_MAX_WRITE_CMDS_IN_FLIGHT;
+      if (in_flight >= max_in_flight) {
+        APPL_TRACE_DEBUG("%s: %d write commands in flight", __func__,
+                         in_flight);
+        return;
+      }
+
+      in_flight++;
+      gatt_write_op_data* data =
+          (gatt_write_op_data*)osi_malloc(sizeof(gatt_write_op_data));
+      data->cb = op.write_cb;
+      data->cb_data = op.write_cb_data;
+      BTA_GATTC_WriteCharValue(conn_id, op.handle, op.write_type,
+                               std::move(op.value), GATT_AUTH_REQ_NONE,
+                               gatt_write_cmd_op_finished, data);
+      gatt_ops.pop_front();
+      continue;
+    }
+
+    if (in_flight > 0) {
+      APPL_TRACE_DEBUG("%s: waiting for %d write commands", __func__,
+                       in_flight);
+      return;
+    }
+
+    gatt_op_queue_executing.insert(conn_id);
+    execute_op(conn_id, op);
+    gatt_ops.pop_front();
+    return;
+  }
+}
 
+void BtaGattQueue::execute_op(uint16_t conn_id, gatt_operation& op) {
   APPL_TRACE_DEBUG("%s: op.type=%d, handle=%d", __func__, op.type,
     op.handle);
   if (op.type == GATT_READ_CHAR) {
@@ -179,8 +267,6 @@ void BtaGattQueue::gatt_execute_next_op(uint16_t conn_id) {
                                                           (op.value[1] << 8)),
                            gatt_configure_mtu_op_finished, data);
   }
-
-  gatt_ops.pop_front();
 }
 
 void BtaGattQueue::Clean(uint16_t conn_id) {
@@ -188,6 +274,41 @@ void BtaGattQueue::Clean(uint16_t conn_id) {
 
   gatt_op_queue.erase(conn_id);
   gatt_op_queue_executing.erase(conn_id);
+  gatt_op_queue_pipelined.erase(conn_id);
+  gatt_op_queue_congested.erase(conn_id);
+  gatt_write_cmds_in_flight.erase(conn_id);
+  gatt_op_queue_max_depth.erase(conn_id);
+}
+
+size_t BtaGattQueue::QueueDepth(uint16_t conn_id) {
+  auto map_ptr = gatt_op_queue.find(conn_id);
+  return (map_ptr == gatt_op_queue.end()) ? 0 : map_ptr->second.size();
+}
+
+size_t BtaGattQueue::MaxQueueDepth(uint16_t conn_id) {
+  auto map_ptr = gatt_op_queue_max_depth.find(conn_id);
+  return (map_ptr == gatt_op_queue_max_depth.end()) ? 0 : map_ptr->second;
+}
+
+void BtaGattQueue::SetPipelined(uint16_t conn_id, bool pipelined) {
+  APPL_TRACE_DEBUG("%s: conn_id=0x%x pipelined=%d", __func__, conn_id,
+                   pipelined);
+
+  if (pipelined) {
+    gatt_op_queue_pipelined.insert(conn_id);
+  } else {
+    gatt_op_queue_pipelined.erase(conn_id);
+  }
+  gatt_execute_next_op(conn_id);
+}
+
+void BtaGattQueue::CongestionChanged(uint16_t conn_id, bool congested) {
+  if (congested) {
+    gatt_op_queue_congested.insert(conn_id);
+    return;
+  }
+
+  if (gatt_op_queue_congested.erase(conn_id)) gatt_execute_next_op(conn_id);
 }
 
 void BtaGattQueue::ReadCharacteristic(uint16_t conn_id, uint16_t handle,
@@ -172,6 +172,9 @@ tBTA_GATTC_CLCB* bta_gattc_clcb_alloc(tGATT_IF client_if,
       p_clcb->transport = transport;
       p_clcb->bda = remote_bda;
       p_clcb->p_q_cmd = NULL;
+      p_clcb->cback_count = 0;
+      p_clcb->cback_max_us = 0;
+      p_clcb->cback_total_us = 0;
 
       p_clcb->p_rcb = bta_gattc_cl_get_regcb(client_if);
 
@@ -68,6 +68,7 @@
 #include "btif/include/btif_debug_conn.h"
 #include "btm_ble_api.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
 #include "utl.h"
 
 using base::StringPrintf;
@@ -254,6 +255,13 @@ void bta_gatts_register(tBTA_GATTS_CB* p_cb, tBTA_GATTS_DATA* p_msg) {
       if (!p_cb->rcb[first_unuse].gatt_if) {
         status = GATT_NO_RESOURCES;
       } else {
+        /* coalescing delays notifications, so it is off unless configured */
+        int32_t coalesce_ms = osi_property_get_int32(
+            "persist.vendor.btstack.gatts_ntf_coalesce_ms", 0);
+        if (coalesce_ms > 0 && coalesce_ms <= UINT16_MAX)
+          GATTS_SetNotificationCoalescing(p_cb->rcb[first_unuse].gatt_if,
+                                          coalesce_ms);
+
         tBTA_GATTS_INT_START_IF* p_buf = (tBTA_GATTS_INT_START_IF*)osi_malloc(
             sizeof(tBTA_GATTS_INT_START_IF));
         p_buf->hdr.event = BTA_GATTS_INT_START_IF_EVT;
@@ -467,6 +475,66 @@ void bta_gatts_indicate_handle(tBTA_GATTS_CB* p_cb, tBTA_GATTS_DATA* p_msg) {
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_gatts_notifications
+ *
+ * Description      GATTS send a batch of handle value notifications, coalesced
+ *                  per client.
+ *
+ * Returns          none.
+ *
+ ******************************************************************************/
+void bta_gatts_notifications(tBTA_GATTS_CB* p_cb, tBTA_GATTS_DATA* p_msg) {
+  tBTA_GATTS cb_data;
+
+  GATTS_NotificationBurstStart();
+  for (uint16_t i = 0; i < p_msg->api_ntfs.num_ntf; i++) {
+    const tBTA_GATTS_NTF& ntf = p_msg->api_ntfs.p_ntfs[i];
+    tGATT_STATUS status = GATT_ILLEGAL_PARAMETER;
+    tGATT_IF gatt_if;
+    RawAddress remote_bda;
+    tBTA_TRANSPORT transport;
+
+    tBTA_GATTS_SRVC_CB* p_srvc_cb =
+        bta_gatts_find_srvc_cb_by_attr_id(p_cb, ntf.attr_id);
+    if (p_srvc_cb == NULL) {
+      LOG(ERROR) << "Not a registered service attribute ID: "
+                 << loghex(ntf.attr_id);
+      continue;
+    }
+
+    if (!GATT_GetConnectionInfor(ntf.conn_id, &gatt_if, remote_bda,
+                                 &transport)) {
+      LOG(ERROR) << "Unknown connection_id=" << loghex(ntf.conn_id)
+                 << " fail sending notification";
+      continue;
+    }
+    tBTA_GATTS_RCB* p_rcb = bta_gatts_find_app_rcb_by_app_if(gatt_if);
+
+    if (GATTS_CheckStatusForApp(ntf.conn_id, false) != GATT_BUSY) {
+      status = GATTS_HandleValueNotification(ntf.conn_id, ntf.attr_id, ntf.len,
+                                             (uint8_t*)ntf.p_value);
+    } else {
+      status = GATT_BUSY;
+    }
+
+    /* if over BR_EDR, inform PM for mode change */
+    if (transport == BTA_TRANSPORT_BR_EDR) {
+      bta_sys_busy(BTA_ID_GATTS, BTA_ALL_APP_ID, remote_bda);
+      bta_sys_idle(BTA_ID_GATTS, BTA_ALL_APP_ID, remote_bda);
+    }
+
+    if (p_rcb && p_cb->rcb[p_srvc_cb->rcb_idx].p_cback) {
+      cb_data.req_data.status = status;
+      cb_data.req_data.conn_id = ntf.conn_id;
+
+      (*p_rcb->p_cback)(BTA_GATTS_CONF_EVT, &cb_data);
+    }
+  }
+  GATTS_NotificationBurstEnd();
+}
+
 /*******************************************************************************
  *
  * Function         bta_gatts_multi_notifications
@@ -256,6 +256,52 @@ void BTA_GATTS_HandleValueIndication(uint16_t conn_id, uint16_t attr_id,
   bta_sys_sendmsg(p_buf);
 }
 
+/*******************************************************************************
+ *
+ * Function         BTA_GATTS_HandleValueNotifications
+ *
+ * Description      This function is called to send a batch of notifications
+ *                  in one message.
+ *
+ * Parameters       p_ntfs - notifications to send.
+ *                  num_ntf - number of notifications.
+ *
+ * Returns          None
+ *
+ ******************************************************************************/
+void BTA_GATTS_HandleValueNotifications(const tBTA_GATTS_NTF* p_ntfs,
+                                        uint16_t num_ntf) {
+  size_t values_len = 0;
+  for (uint16_t i = 0; i < num_ntf; i++) {
+    if (p_ntfs[i].len > GATT_MAX_ATTR_LEN) {
+      LOG(ERROR) << __func__ << ": data to notify is too long";
+      return;
+    }
+    values_len += p_ntfs[i].len;
+  }
+  if (num_ntf == 0) return;
+
+  /* one buffer for the message, the notifications and all their values */
+  tBTA_GATTS_API_NOTIFICATIONS* p_buf =
+      (tBTA_GATTS_API_NOTIFICATIONS*)osi_malloc(
+          sizeof(tBTA_GATTS_API_NOTIFICATIONS) +
+          num_ntf * sizeof(tBTA_GATTS_NTF) + values_len);
+  p_buf->hdr.event = BTA_GATTS_API_NOTIFICATIONS_EVT;
+  p_buf->hdr.layer_specific = 0;
+  p_buf->num_ntf = num_ntf;
+  p_buf->p_ntfs = (tBTA_GATTS_NTF*)(p_buf + 1);
+
+  uint8_t* p_value = (uint8_t*)(p_buf->p_ntfs + num_ntf);
+  for (uint16_t i = 0; i < num_ntf; i++) {
+    p_buf->p_ntfs[i] = p_ntfs[i];
+    if (p_ntfs[i].len > 0) memcpy(p_value, p_ntfs[i].p_value, p_ntfs[i].len);
+    p_buf->p_ntfs[i].p_value = p_value;
+    p_value += p_ntfs[i].len;
+  }
+
+  bta_sys_sendmsg(p_buf);
+}
+
 /*******************************************************************************
  *
  * Function         BTA_GATTS_MultipleHandleValueNotification
@@ -49,7 +49,8 @@ enum {
   BTA_GATTS_API_CLOSE_EVT,
   BTA_GATTS_API_DISABLE_EVT,
   BTA_GATTS_API_CFG_MTU_EVT,
-  BTA_GATTS_API_MULTI_NOTIFICATION_EVT
+  BTA_GATTS_API_MULTI_NOTIFICATION_EVT,
+  BTA_GATTS_API_NOTIFICATIONS_EVT
 };
 typedef uint16_t tBTA_GATTS_INT_EVT;
 
@@ -97,6 +98,13 @@ typedef struct {
   std::vector<std::vector<uint8_t>> values;
 } tBTA_GATTS_API_MULTI_NOTIFICATION;
 
+/* The values of the notifications follow them in the same buffer */
+typedef struct {
+  BT_HDR hdr;
+  uint16_t num_ntf;
+  tBTA_GATTS_NTF* p_ntfs;
+} tBTA_GATTS_API_NOTIFICATIONS;
+
 typedef struct {
   BT_HDR hdr;
   uint32_t trans_id;
@@ -138,6 +146,7 @@ typedef union {
   tBTA_GATTS_INT_START_IF int_start_if;
   tBTA_GATTS_API_CFG_MTU api_mtu;
   tBTA_GATTS_API_MULTI_NOTIFICATION api_multi_ntf;
+  tBTA_GATTS_API_NOTIFICATIONS api_ntfs;
 } tBTA_GATTS_DATA;
 
 /* application registration control block */
@@ -190,6 +199,8 @@ extern void bta_gatts_send_rsp(tBTA_GATTS_CB* p_cb, tBTA_GATTS_DATA* p_msg);
 extern void bta_gatts_indicate_handle(tBTA_GATTS_CB* p_cb,
                                       tBTA_GATTS_DATA* p_msg);
 
+extern void bta_gatts_notifications(tBTA_GATTS_CB* p_cb,
+                                    tBTA_GATTS_DATA* p_msg);
 extern void bta_gatts_multi_notifications(tBTA_GATTS_CB* p_cb,
                                           tBTA_GATTS_DATA* p_msg);
 
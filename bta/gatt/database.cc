@@ -134,11 +134,17 @@ std::vector<StoredAttribute> Database::Serialize() const {
 
 Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
                                bool* success) {
+  return Deserialize(nv_attr.data(), nv_attr.size(), success);
+}
+
+Database Database::Deserialize(const StoredAttribute* nv_attr, size_t count,
+                               bool* success) {
   // clear reallocating
   Database result;
-  auto it = nv_attr.cbegin();
+  const StoredAttribute* it = nv_attr;
+  const StoredAttribute* end = nv_attr + count;
 
-  for (; it != nv_attr.cend(); ++it) {
+  for (; it != end; ++it) {
     const auto& attr = *it;
     if (attr.type != PRIMARY_SERVICE && attr.type != SECONDARY_SERVICE) break;
     result.services.emplace_back(
@@ -149,7 +155,7 @@ Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
   }
 
   auto current_service_it = result.services.begin();
-  for (; it != nv_attr.cend(); it++) {
+  for (; it != end; it++) {
     const auto& attr = *it;
 
     // go to the service this attribute belongs to; attributes are stored in
@@ -202,10 +208,62 @@ Database Database::Deserialize(const std::vector<StoredAttribute>& nv_attr,
       }
     }
   }
+  result.BuildHandleIndex();
   *success = true;
   return result;
 }
 
+void Database::BuildHandleIndex() {
+  handle_index.clear();
+
+  for (size_t s = 0; s < services.size(); s++) {
+    const Service& service = services[s];
+    for (size_t c = 0; c < service.characteristics.size(); c++) {
+      const Characteristic& charac = service.characteristics[c];
+      handle_index[charac.value_handle] = HandleIndexEntry{
+          .service = static_cast<uint16_t>(s),
+          .characteristic = static_cast<uint16_t>(c),
+          .descriptor = kNoDescriptor};
+
+      for (size_t d = 0; d < charac.descriptors.size(); d++) {
+        handle_index[charac.descriptors[d].handle] = HandleIndexEntry{
+            .service = static_cast<uint16_t>(s),
+            .characteristic = static_cast<uint16_t>(c),
+            .descriptor = static_cast<uint16_t>(d)};
+      }
+    }
+  }
+}
+
+const Characteristic* Database::FindCharacteristic(uint16_t handle) const {
+  auto it = handle_index.find(handle);
+  if (it == handle_index.end() || it->second.descriptor != kNoDescriptor)
+    return nullptr;
+
+  return &services[it->second.service]
+              .characteristics[it->second.characteristic];
+}
+
+const Descriptor* Database::FindDescriptor(uint16_t handle) const {
+  auto it = handle_index.find(handle);
+  if (it == handle_index.end() || it->second.descriptor == kNoDescriptor)
+    return nullptr;
+
+  return &services[it->second.service]
+              .characteristics[it->second.characteristic]
+              .descriptors[it->second.descriptor];
+}
+
+const Characteristic* Database::FindOwningCharacteristic(
+    uint16_t handle) const {
+  auto it = handle_index.find(handle);
+  if (it == handle_index.end() || it->second.descriptor == kNoDescriptor)
+    return nullptr;
+
+  return &services[it->second.service]
+              .characteristics[it->second.characteristic];
+}
+
 Octet16 Database::Hash() const {
   int len = 0;
   // Compute how much space we need to actually hold the data.
@@ -20,6 +20,7 @@
 
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -106,7 +107,10 @@ class Database {
 
   /* Clear the GATT database. This method forces relocation to ensure no extra
    * space is used unnecesarly */
-  void Clear() { std::vector<Service>().swap(services); }
+  void Clear() {
+    std::vector<Service>().swap(services);
+    handle_index.clear();
+  }
 
   /* Return list of services available in this database */
   const std::vector<Service>& Services() const { return services; }
@@ -118,13 +122,43 @@ class Database {
   static Database Deserialize(const std::vector<gatt::StoredAttribute>& nv_attr,
                               bool* success);
 
+  /* Same as above, for |count| attributes stored at |nv_attr|, e.g. in a
+   * memory mapped cache file. */
+  static Database Deserialize(const gatt::StoredAttribute* nv_attr,
+                              size_t count, bool* success);
+
   /* Return 128 bit unique identifier of this GATT database */
   Octet16 Hash() const;
 
+  /* Return the characteristic with value handle |handle|, nullptr if there is
+   * none. */
+  const Characteristic* FindCharacteristic(uint16_t handle) const;
+
+  /* Return the descriptor with handle |handle|, nullptr if there is none. */
+  const Descriptor* FindDescriptor(uint16_t handle) const;
+
+  /* Return the characteristic owning the descriptor with handle |handle|,
+   * nullptr if there is none. */
+  const Characteristic* FindOwningCharacteristic(uint16_t handle) const;
+
   friend class DatabaseBuilder;
 
  private:
+  /* Position of a characteristic value or descriptor in |services|. Positions
+   * rather than pointers keep the index valid when the database is copied. */
+  struct HandleIndexEntry {
+    uint16_t service;
+    uint16_t characteristic;
+    uint16_t descriptor; /* kNoDescriptor for a characteristic value */
+  };
+  static constexpr uint16_t kNoDescriptor = 0xffff;
+
+  /* Rebuild |handle_index| from |services|. Must be called after the services
+   * are complete. */
+  void BuildHandleIndex();
+
   std::vector<Service> services;
+  std::unordered_map<uint16_t, HandleIndexEntry> handle_index;
 };
 
 /* Find a service that should contain handle. Helper method for internal use
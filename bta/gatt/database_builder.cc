@@ -149,6 +149,9 @@ void DatabaseBuilder::AddDescriptor(uint16_t handle, const Uuid& uuid) {
   for (auto it = service->characteristics.begin();
        it != service->characteristics.end(); it++) {
     if (it->declaration_handle > handle) break;
+    // A sweep over the whole service also reports the declarations and
+    // values of the characteristics in between, they are not descriptors.
+    if (it->declaration_handle == handle || it->value_handle == handle) return;
     char_node = &(*it);
   }
 
@@ -181,12 +184,35 @@ DatabaseBuilder::CurrentlyExploredService() {
   return pending_service;
 }
 
-std::pair<uint16_t, uint16_t> DatabaseBuilder::NextDescriptorRangeToExplore() {
+std::pair<uint16_t, uint16_t> DatabaseBuilder::NextDescriptorRangeToExplore(
+    bool whole_service) {
   Service* service = FindService(database.services, pending_service.first);
   if (!service || service->characteristics.empty()) {
     return {HANDLE_MAX, HANDLE_MAX};
   }
 
+  if (whole_service) {
+    if (pending_characteristic != HANDLE_MIN) {
+      pending_characteristic = HANDLE_MAX;
+      return {HANDLE_MAX, HANDLE_MAX};
+    }
+
+    // Single range from the first descriptor slot to the end of the service.
+    // AddDescriptor() drops the characteristic declarations and values found
+    // on the way, so the result is the same as exploring each slot on its own.
+    pending_characteristic = HANDLE_MAX;
+    for (auto it = service->characteristics.cbegin();
+         it != service->characteristics.cend(); it++) {
+      auto next = std::next(it);
+      uint16_t start = it->declaration_handle + 2;
+      uint16_t end = (next != service->characteristics.end())
+                         ? next->declaration_handle - 1
+                         : service->end_handle;
+      if (start <= end) return {start, service->end_handle};
+    }
+    return {HANDLE_MAX, HANDLE_MAX};
+  }
+
   for (auto it = service->characteristics.cbegin();
        it != service->characteristics.cend(); it++) {
     if (it->declaration_handle > pending_characteristic) {
@@ -223,6 +249,9 @@ Descriptor* FindDescriptorByHandle(std::vector<Service>& services,
   for (auto it = service->characteristics.begin();
        it != service->characteristics.end(); it++) {
     if (it->declaration_handle > handle) break;
+    // A sweep over the whole service also reports the declarations and
+    // values of the characteristics in between, they are not descriptors.
+    if (it->declaration_handle == handle || it->value_handle == handle) return;
     char_node = &(*it);
   }
 
@@ -276,6 +305,7 @@ bool DatabaseBuilder::InProgress() const { return !database.services.empty(); }
 Database DatabaseBuilder::Build() {
   Database tmp = database;
   database.Clear();
+  tmp.BuildHandleIndex();
   return tmp;
 }
 
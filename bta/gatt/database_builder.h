@@ -47,9 +47,12 @@ class DatabaseBuilder {
   const std::pair<uint16_t, uint16_t>& CurrentlyExploredService();
 
   /* Return pair with start and end handle of the descriptor range to discover,
-   * or DatabaseBuilder::EXPLORE_END if no more descriptors left.
+   * or DatabaseBuilder::EXPLORE_END if no more descriptors left. If
+   * |whole_service| is true, all descriptors of the service are covered by a
+   * single range that also spans the characteristic declarations in between.
    */
-  std::pair<uint16_t, uint16_t> NextDescriptorRangeToExplore();
+  std::pair<uint16_t, uint16_t> NextDescriptorRangeToExplore(
+      bool whole_service = false);
 
   /* Return vector of "Characteristic Extended Properties" descriptors that must
    * be read as part of service discovery process */
@@ -190,7 +190,7 @@ extern void BTA_HdSendReport(tBTA_HD_REPORT* p_report) {
   p_buf->len = p_report->len;
   memcpy(p_buf->data, p_report->p_data, p_report->len);
 
-  bta_sys_sendmsg(p_buf);
+  bta_sys_sendmsg_prio(p_buf, BTU_TASK_PRIO_MEDIA);
 }
 
 /*******************************************************************************
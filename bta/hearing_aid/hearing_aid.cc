@@ -1230,61 +1230,75 @@ class HearingAidImpl : public HearingAid {
     // reallocations
     // TODO: this should basically fit the encoded data, tune the size later
     std::vector<uint8_t> encoded_data_left;
-    if (left) {
-      // TODO: instead of a magic number, we need to figure out the correct
-      // buffer size
-      encoded_data_left.resize(4000);
-      int encoded_size = 0;
-      if (chan_left.size() > 0) {
-          encoded_size = g722_encode(encoder_state_left, encoded_data_left.data(),
-                      (const int16_t*)chan_left.data(), chan_left.size());
-      } else {
-        LOG(ERROR) << "Error: No chan_left data to encode";
-      }
-      encoded_data_left.resize(encoded_size);
-
-      uint16_t cid = GAP_ConnGetL2CAPCid(left->gap_handle);
-      uint16_t packets_to_flush = L2CA_FlushChannel(cid, L2CAP_FLUSH_CHANS_GET);
-      if (packets_to_flush) {
-        VLOG(2) << left->address << " skipping " << packets_to_flush
-                << " packets";
-        left->audio_stats.packet_flush_count += packets_to_flush;
-        left->audio_stats.frame_flush_count++;
-        hearingDevices.StartRssiLog();
-      }
-      // flush all packets stuck in queue
-      L2CA_FlushChannel(cid, 0xffff);
-      check_and_do_rssi_read(left);
-    }
-
     std::vector<uint8_t> encoded_data_right;
-    if (right) {
-      // TODO: instead of a magic number, we need to figure out the correct
-      // buffer size
+
+    // A binaural pair is encoded in one pass over both channels
+    // TODO: instead of a magic number, we need to figure out the correct
+    // buffer size
+    if (left && right && chan_left.size() > 0) {
+      encoded_data_left.resize(4000);
       encoded_data_right.resize(4000);
-      int encoded_size = 0;
-      if (chan_right.size() > 0) {
-          encoded_size = g722_encode(encoder_state_right, encoded_data_right.data(),
-                      (const int16_t*)chan_right.data(), chan_right.size());
-      } else {
-        LOG(ERROR) << "Error: No chan_right data to encode";
-      }
+      int encoded_size = g722_encode_stereo(
+          encoder_state_left, encoder_state_right, encoded_data_left.data(),
+          encoded_data_right.data(), (const int16_t*)chan_left.data(),
+          (const int16_t*)chan_right.data(), chan_left.size());
+      encoded_data_left.resize(encoded_size);
       encoded_data_right.resize(encoded_size);
-
-      uint16_t cid = GAP_ConnGetL2CAPCid(right->gap_handle);
-      uint16_t packets_to_flush = L2CA_FlushChannel(cid, L2CAP_FLUSH_CHANS_GET);
-      if (packets_to_flush) {
-        VLOG(2) << right->address << " skipping " << packets_to_flush
-                << " packets";
-        right->audio_stats.packet_flush_count += packets_to_flush;
-        right->audio_stats.frame_flush_count++;
-        hearingDevices.StartRssiLog();
-      }
-      // flush all packets stuck in queue
-      L2CA_FlushChannel(cid, 0xffff);
-      check_and_do_rssi_read(right);
-    }
-
+    } else if (left && chan_left.size() > 0) {
+      encoded_data_left.resize(4000);
+      encoded_data_left.resize(
+          g722_encode(encoder_state_left, encoded_data_left.data(),
+                      (const int16_t*)chan_left.data(), chan_left.size()));
+    } else if (right && chan_right.size() > 0) {
+      encoded_data_right.resize(4000);
+      encoded_data_right.resize(
+          g722_encode(encoder_state_right, encoded_data_right.data(),
+                      (const int16_t*)chan_right.data(), chan_right.size()));
+    } else {
+      LOG(ERROR) << "Error: No audio data to encode";
+    }
+
+    if (left) FlushStaleAudio(left);
+    if (right) FlushStaleAudio(right);
+
+    SendAudioFrame(left, encoded_data_left, right, encoded_data_right);
+  }
+
+  /* Drops the packets of the previous frame still waiting in L2CAP, so that
+   * a device short of credits does not fall further behind, and records
+   * whether the channel had to wait for credits since the last frame. */
+  void FlushStaleAudio(HearingDevice* device) {
+    uint16_t cid = GAP_ConnGetL2CAPCid(device->gap_handle);
+    uint16_t packets_to_flush = L2CA_FlushChannel(cid, L2CAP_FLUSH_CHANS_GET);
+    if (packets_to_flush) {
+      VLOG(2) << device->address << " skipping " << packets_to_flush
+              << " packets";
+      device->audio_stats.packet_flush_count += packets_to_flush;
+      device->audio_stats.frame_flush_count++;
+      hearingDevices.StartRssiLog();
+    }
+    // flush all packets stuck in queue
+    L2CA_FlushChannel(cid, 0xffff);
+
+    tL2CAP_CHNL_STATS chnl_stats;
+    if (L2CA_GetChannelStats(cid, &chnl_stats)) {
+      AudioStats& stats = device->audio_stats;
+      if (chnl_stats.credit_stall_count > stats.last_credit_stall_count)
+        stats.frame_credit_starved_count++;
+      stats.last_credit_stall_count = chnl_stats.credit_stall_count;
+      stats.credit_stall_ms = chnl_stats.credit_stall_ms;
+    }
+    check_and_do_rssi_read(device);
+  }
+
+  /* Sends one encoded frame to one or both sides. For a binaural pair both
+   * packets of a slot are built first and then written back to back, so they
+   * leave in the same connection event window with the same sequence number.
+   */
+  void SendAudioFrame(HearingDevice* left,
+                      const std::vector<uint8_t>& encoded_data_left,
+                      HearingDevice* right,
+                      const std::vector<uint8_t>& encoded_data_right) {
     size_t encoded_data_size =
         std::max(encoded_data_left.size(), encoded_data_right.size());
 
@@ -1295,28 +1309,45 @@ class HearingAidImpl : public HearingAid {
       packet_size = encoded_data_size;
     VLOG(2) << "packet_size : " << packet_size;
     for (size_t i = 0; i < encoded_data_size; i += packet_size) {
+      BT_HDR* packet_left = nullptr;
+      BT_HDR* packet_right = nullptr;
       if (left) {
         left->audio_stats.packet_send_count++;
-        SendAudio(encoded_data_left.data() + i, packet_size, left);
+        packet_left =
+            BuildAudioPacket(encoded_data_left.data() + i, packet_size, left);
       }
       if (right) {
         right->audio_stats.packet_send_count++;
-        SendAudio(encoded_data_right.data() + i, packet_size, right);
+        packet_right =
+            BuildAudioPacket(encoded_data_right.data() + i, packet_size, right);
+      }
+
+      // One ear stalled while the other plays: the slot is lost for inter-ear
+      // sync even if both sides are otherwise healthy.
+      if (left && right &&
+          (packet_left == nullptr) != (packet_right == nullptr)) {
+        HearingDevice* stalled = packet_left ? right : left;
+        stalled->audio_stats.packet_unpaired_count++;
       }
+
+      if (packet_left) WriteAudioPacket(packet_left, left);
+      if (packet_right) WriteAudioPacket(packet_right, right);
       seq_counter++;
     }
     if (left) left->audio_stats.frame_send_count++;
     if (right) right->audio_stats.frame_send_count++;
   }
 
-  void SendAudio(uint8_t* encoded_data, uint16_t packet_size,
-                 HearingDevice* hearingAid) {
+  /* Returns the packet carrying |packet_size| bytes of |encoded_data| for
+   * |hearingAid|, or nullptr when that device is not playing yet. */
+  BT_HDR* BuildAudioPacket(const uint8_t* encoded_data, uint16_t packet_size,
+                           HearingDevice* hearingAid) {
     if (!hearingAid->playback_started || !hearingAid->command_acked) {
       VLOG(2) << __func__
               << ": Playback stalled, device=" << hearingAid->address
               << ", cmd send=" << hearingAid->playback_started
               << ", cmd acked=" << hearingAid->command_acked;
-      return;
+      return nullptr;
     }
 
     BT_HDR* audio_packet = malloc_l2cap_buf(packet_size + 1);
@@ -1326,7 +1357,10 @@ class HearingAidImpl : public HearingAid {
     memcpy(p, encoded_data, packet_size);
 
     DVLOG(2) << hearingAid->address << " : " << base::HexEncode(p, packet_size);
+    return audio_packet;
+  }
 
+  void WriteAudioPacket(BT_HDR* audio_packet, HearingDevice* hearingAid) {
     uint16_t result = GAP_ConnWriteData(hearingAid->gap_handle, audio_packet);
 
     if (result != BT_PASS) {
@@ -1481,7 +1515,12 @@ class HearingAidImpl : public HearingAid {
           << device.audio_stats.packet_flush_count
           << "\n    Frame counts (enqueued/flushed)                         : "
           << device.audio_stats.frame_send_count << " / "
-          << device.audio_stats.frame_flush_count << std::endl;
+          << device.audio_stats.frame_flush_count
+          << "\n    Frames short of credits / credit wait (ms)              : "
+          << device.audio_stats.frame_credit_starved_count << " / "
+          << device.audio_stats.credit_stall_ms
+          << "\n    Packets sent without the other side                     : "
+          << device.audio_stats.packet_unpaired_count << std::endl;
 
       DumpRssi(fd, device);
     }
@@ -66,14 +66,25 @@ void send_audio_data(void* audio_data) {
       (num_channels * sample_rate * data_interval_ms * (bit_rate / 8)) / 1000;
 
   uint16_t event;
-  uint8_t p_buf[bytes_per_tick];
+  std::vector<uint8_t> data;
 
   uint32_t bytes_read;
+  uint32_t available = 0;
   if (bluetooth::audio::hearing_aid::is_hal_2_0_enabled()) {
-    bytes_read = bluetooth::audio::hearing_aid::read(p_buf, bytes_per_tick);
+    // The FMQ is copied straight into the frame handed to the encoder
+    bytes_read = bluetooth::audio::hearing_aid::read(&data, bytes_per_tick);
+  } else if (UIPC_Ioctl(UIPC_CH_ID_AV_AUDIO, UIPC_REQ_RX_AVAILABLE,
+                        &available) &&
+             available < bytes_per_tick) {
+    // Only whole frames are taken, from the PCM ring or the socket: a short
+    // one is completed by the HAL and sent on the next tick rather than
+    // encoded in part.
+    bytes_read = 0;
   } else {
+    data.resize(bytes_per_tick);
     bytes_read = UIPC_Read(UIPC_CH_ID_AV_AUDIO, &event,
-                           p_buf, bytes_per_tick);
+                           data.data(), bytes_per_tick);
+    data.resize(bytes_read);
   }
 
   VLOG(2) << "bytes_read: " << bytes_read;
@@ -83,8 +94,6 @@ void send_audio_data(void* audio_data) {
     stats.media_read_last_underflow_us = time_get_os_boottime_us();
   }
 
-  std::vector<uint8_t> data(p_buf, p_buf + bytes_read);
-
   if (localAudioReceiver != nullptr) {
     localAudioReceiver->OnAudioDataReady(data);
   }
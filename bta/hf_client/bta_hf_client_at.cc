@@ -1497,25 +1497,91 @@ static char* bta_hf_client_process_unknown(tBTA_HF_CLIENT_CB* client_cb,
  */
 typedef char* (*tBTA_HF_CLIENT_PARSER_CALLBACK)(tBTA_HF_CLIENT_CB*, char*);
 
-static const tBTA_HF_CLIENT_PARSER_CALLBACK bta_hf_client_parser_cb[] = {
-    bta_hf_client_parse_ok,          bta_hf_client_parse_error,
-    bta_hf_client_parse_ring,        bta_hf_client_parse_brsf,
-    bta_hf_client_parse_cind,        bta_hf_client_parse_ciev,
-    bta_hf_client_parse_chld,        bta_hf_client_parse_bcs,
-    bta_hf_client_parse_bsir,        bta_hf_client_parse_cmeerror,
-    bta_hf_client_parse_vgm,         bta_hf_client_parse_vgme,
-    bta_hf_client_parse_vgs,         bta_hf_client_parse_vgse,
-    bta_hf_client_parse_bvra,        bta_hf_client_parse_clip,
-    bta_hf_client_parse_ccwa,        bta_hf_client_parse_cops,
-    bta_hf_client_parse_binp,        bta_hf_client_parse_clcc,
-    bta_hf_client_parse_cnum,        bta_hf_client_parse_btrh,
-    bta_hf_client_parse_busy,        bta_hf_client_parse_delayed,
-    bta_hf_client_parse_no_carrier,  bta_hf_client_parse_no_answer,
-    bta_hf_client_parse_blacklisted, bta_hf_client_process_unknown};
-
-/* calculate supported event list length */
-static const uint16_t bta_hf_client_parser_cb_count =
-    sizeof(bta_hf_client_parser_cb) / sizeof(bta_hf_client_parser_cb[0]);
+/* Parsers of the supported events, grouped by the first characters of the
+ * event following the leading <cr><lf> (the character after '+' for extended
+ * results). An event can only be matched by the parsers of its group, so only
+ * those are tried. Each list is NULL terminated and keeps the order in which
+ * the parsers used to be tried. */
+static const tBTA_HF_CLIENT_PARSER_CALLBACK bta_hf_client_parser_cb_o[] = {
+    bta_hf_client_parse_ok, NULL};
+
+static const tBTA_HF_CLIENT_PARSER_CALLBACK bta_hf_client_parser_cb_e[] = {
+    bta_hf_client_parse_error, NULL};
+
+static const tBTA_HF_CLIENT_PARSER_CALLBACK bta_hf_client_parser_cb_r[] = {
+    bta_hf_client_parse_ring, NULL};
+
+static const tBTA_HF_CLIENT_PARSER_CALLBACK bta_hf_client_parser_cb_b[] = {
+    bta_hf_client_parse_busy, bta_hf_client_parse_blacklisted, NULL};
+
+static const tBTA_HF_CLIENT_PARSER_CALLBACK bta_hf_client_parser_cb_d[] = {
+    bta_hf_client_parse_delayed, NULL};
+
+static const tBTA_HF_CLIENT_PARSER_CALLBACK bta_hf_client_parser_cb_n[] = {
+    bta_hf_client_parse_no_carrier, bta_hf_client_parse_no_answer, NULL};
+
+static const tBTA_HF_CLIENT_PARSER_CALLBACK bta_hf_client_parser_cb_plus_b[] = {
+    bta_hf_client_parse_brsf, bta_hf_client_parse_bcs,
+    bta_hf_client_parse_bsir, bta_hf_client_parse_bvra,
+    bta_hf_client_parse_binp, bta_hf_client_parse_btrh,
+    NULL};
+
+static const tBTA_HF_CLIENT_PARSER_CALLBACK bta_hf_client_parser_cb_plus_c[] = {
+    bta_hf_client_parse_cind, bta_hf_client_parse_ciev,
+    bta_hf_client_parse_chld, bta_hf_client_parse_cmeerror,
+    bta_hf_client_parse_clip, bta_hf_client_parse_ccwa,
+    bta_hf_client_parse_cops, bta_hf_client_parse_clcc,
+    bta_hf_client_parse_cnum, NULL};
+
+static const tBTA_HF_CLIENT_PARSER_CALLBACK bta_hf_client_parser_cb_plus_v[] = {
+    bta_hf_client_parse_vgm, bta_hf_client_parse_vgme,
+    bta_hf_client_parse_vgs, bta_hf_client_parse_vgse,
+    NULL};
+
+static const tBTA_HF_CLIENT_PARSER_CALLBACK bta_hf_client_parser_cb_none[] = {
+    NULL};
+
+/******************************************************************************
+ *
+ * Function         bta_hf_client_parser_lookup
+ *
+ * Description      Pick the parsers that could match the event at |buf|.
+ *
+ *
+ * Returns          NULL terminated list of parsers, possibly empty
+ *
+ ******************************************************************************/
+static const tBTA_HF_CLIENT_PARSER_CALLBACK* bta_hf_client_parser_lookup(
+    const char* buf) {
+  if (buf[0] != '\r' || buf[1] != '\n') return bta_hf_client_parser_cb_none;
+
+  switch (buf[2]) {
+    case 'O':
+      return bta_hf_client_parser_cb_o;
+    case 'E':
+      return bta_hf_client_parser_cb_e;
+    case 'R':
+      return bta_hf_client_parser_cb_r;
+    case 'B':
+      return bta_hf_client_parser_cb_b;
+    case 'D':
+      return bta_hf_client_parser_cb_d;
+    case 'N':
+      return bta_hf_client_parser_cb_n;
+    case '+':
+      switch (buf[3]) {
+        case 'B':
+          return bta_hf_client_parser_cb_plus_b;
+        case 'C':
+          return bta_hf_client_parser_cb_plus_c;
+        case 'V':
+          return bta_hf_client_parser_cb_plus_v;
+      }
+      break;
+  }
+
+  return bta_hf_client_parser_cb_none;
+}
 
 #ifdef BTA_HF_CLIENT_AT_DUMP
 static void bta_hf_client_dump_at(tBTA_HF_CLIENT_CB* client_cb) {
@@ -1555,11 +1621,15 @@ static void bta_hf_client_at_parse_start(tBTA_HF_CLIENT_CB* client_cb) {
 #endif
 
   while (*buf != '\0') {
-    int i;
-    char* tmp = NULL;
-
-    for (i = 0; i < bta_hf_client_parser_cb_count; i++) {
-      tmp = bta_hf_client_parser_cb[i](client_cb, buf);
+    const tBTA_HF_CLIENT_PARSER_CALLBACK* parser =
+        bta_hf_client_parser_lookup(buf);
+    char* tmp = buf;
+
+    /* the unknown event handler always comes last */
+    for (bool unknown = false; !unknown; parser++) {
+      unknown = (*parser == NULL);
+      tmp = unknown ? bta_hf_client_process_unknown(client_cb, buf)
+                    : (*parser)(client_cb, buf);
       if (tmp == NULL) {
         APPL_TRACE_ERROR("HFPCient: AT event/reply parsing failed, skipping");
         tmp = bta_hf_client_skip_unknown(client_cb, buf);
@@ -1568,10 +1638,7 @@ static void bta_hf_client_at_parse_start(tBTA_HF_CLIENT_CB* client_cb) {
 
       /* matched or unknown skipped, if unknown failed tmp is NULL so
          this is also handled */
-      if (tmp != buf) {
-        buf = tmp;
-        break;
-      }
+      if (tmp != buf) break;
     }
 
     /* could not skip unknown (received garbage?)... disconnect */
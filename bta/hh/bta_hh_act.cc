@@ -34,7 +34,9 @@
 #include "bta_sys.h"
 #include "btm_api.h"
 #include "l2c_api.h"
+#include "osi/include/footprint.h"
 #include "osi/include/osi.h"
+#include "osi/include/time.h"
 #include "utl.h"
 #define COUNTRY_CODE_RANGE_MAX 35
 /*****************************************************************************
@@ -73,8 +75,18 @@ void bta_hh_api_enable(tBTA_HH_DATA* p_data) {
   /* initialize BTE HID */
   HID_HostInit();
 
+  osi_free(bta_hh_cb.kdev);
   memset(&bta_hh_cb, 0, sizeof(tBTA_HH_CB));
 
+  /* The device control blocks only take memory while HID host is enabled */
+  bta_hh_cb.num_kdev = footprint_pool_entries(
+      "hh_devices", BTA_HH_MAX_DEVICE, BTA_HH_LOW_MEMORY_DEVICES);
+  bta_hh_cb.kdev = (tBTA_HH_DEV_CB*)osi_calloc(bta_hh_cb.num_kdev *
+                                               sizeof(tBTA_HH_DEV_CB));
+  footprint_set("bta_hh", "control_block", sizeof(tBTA_HH_CB));
+  footprint_set("bta_hh", "devices",
+                bta_hh_cb.num_kdev * sizeof(tBTA_HH_DEV_CB));
+
   HID_HostSetSecurityLevel("", p_data->api_enable.sec_mask);
 
   /* Register with L2CAP */
@@ -84,7 +96,7 @@ void bta_hh_api_enable(tBTA_HH_DATA* p_data) {
 
     status = BTA_HH_OK;
     /* initialize device CB */
-    for (xx = 0; xx < BTA_HH_MAX_DEVICE; xx++) {
+    for (xx = 0; xx < bta_hh_cb.num_kdev; xx++) {
       bta_hh_cb.kdev[xx].state = BTA_HH_IDLE_ST;
       bta_hh_cb.kdev[xx].hid_handle = BTA_HH_INVALID_HANDLE;
       bta_hh_cb.kdev[xx].index = xx;
@@ -132,7 +144,7 @@ void bta_hh_api_disable(void) {
   {
     bta_hh_cb.w4_disable = true;
 
-    for (xx = 0; xx < BTA_HH_MAX_DEVICE; xx++) {
+    for (xx = 0; xx < bta_hh_cb.num_kdev; xx++) {
       /* send API_CLOSE event to every connected device */
       if (bta_hh_cb.kdev[xx].state == BTA_HH_CONN_ST) {
         /* disconnect all connected devices */
@@ -632,9 +644,10 @@ void bta_hh_data_act(tBTA_HH_DEV_CB* p_cb, tBTA_HH_DATA* p_data) {
   BT_HDR* pdata = p_data->hid_cback.p_data;
   uint8_t* p_rpt = (uint8_t*)(pdata + 1) + pdata->offset;
 
-  bta_hh_co_data((uint8_t)p_data->hid_cback.hdr.layer_specific, p_rpt,
-                 pdata->len, p_cb->mode, p_cb->sub_class,
-                 p_cb->dscp_info.ctry_code, p_cb->addr, p_cb->app_id);
+  bta_hh_co_intr_data((uint8_t)p_data->hid_cback.hdr.layer_specific, p_rpt,
+                      pdata->len, p_cb->mode, p_cb->sub_class,
+                      p_cb->dscp_info.ctry_code, p_cb->addr, p_cb->app_id,
+                      p_data->hid_cback.rx_us);
 
   osi_free_and_reset((void**)&pdata);
 }
@@ -1154,6 +1167,7 @@ static void bta_hh_cback(uint8_t dev_handle, const RawAddress& addr,
                          uint8_t event, uint32_t data, BT_HDR* pdata) {
   uint16_t sm_event = BTA_HH_INVALID_EVT;
   uint8_t xx = 0;
+  uint64_t rx_us = 0;
 
 #if (BTA_HH_DEBUG == TRUE)
   APPL_TRACE_DEBUG("%s::HID_event [%s]", __func__,
@@ -1169,6 +1183,22 @@ static void bta_hh_cback(uint8_t dev_handle, const RawAddress& addr,
       break;
     case HID_HDEV_EVT_INTR_DATA:
       sm_event = BTA_HH_INT_DATA_EVT;
+      rx_us = time_get_os_boottime_us();
+#if (HID_HOST_LOW_LATENCY == TRUE)
+      /* HID and BTA share the main thread: a connected device does not need
+       * its reports to wait behind the queued BTA messages */
+      xx = bta_hh_dev_handle_to_cb_idx(dev_handle);
+      if (xx < bta_hh_cb.num_kdev &&
+          bta_hh_cb.kdev[xx].state == BTA_HH_CONN_ST) {
+        tBTA_HH_DEV_CB* p_cb = &bta_hh_cb.kdev[xx];
+        bta_hh_co_intr_data(dev_handle, (uint8_t*)(pdata + 1) + pdata->offset,
+                            pdata->len, p_cb->mode, p_cb->sub_class,
+                            p_cb->dscp_info.ctry_code, p_cb->addr,
+                            p_cb->app_id, rx_us);
+        osi_free(pdata);
+        return;
+      }
+#endif
       break;
     case HID_HDEV_EVT_HANDSHAKE:
       sm_event = BTA_HH_INT_HANDSK_EVT;
@@ -1184,14 +1214,14 @@ static void bta_hh_cback(uint8_t dev_handle, const RawAddress& addr,
       osi_free_and_reset((void**)&pdata);
       break;
     case HID_HDEV_EVT_VC_UNPLUG:
-      for (xx = 0; xx < BTA_HH_MAX_DEVICE; xx++) {
+      for (xx = 0; xx < bta_hh_cb.num_kdev; xx++) {
         if (bta_hh_cb.kdev[xx].hid_handle == dev_handle) {
           bta_hh_cb.kdev[xx].vp = true;
           break;
         }
       }
-      if (xx == BTA_HH_MAX_DEVICE) {
-        for (xx = 0; xx < BTA_HH_MAX_DEVICE; xx++) {
+      if (xx == bta_hh_cb.num_kdev) {
+        for (xx = 0; xx < bta_hh_cb.num_kdev; xx++) {
           /* No device matched entry for VC, check if VC receivied in waiting
            * for conn state */
           APPL_TRACE_DEBUG("bta_hh_cb.kdev[xx].state = %d",
@@ -1214,6 +1244,7 @@ static void bta_hh_cback(uint8_t dev_handle, const RawAddress& addr,
     p_buf->data = data;
     p_buf->addr = addr;
     p_buf->p_data = pdata;
+    p_buf->rx_us = rx_us;
 
     bta_sys_sendmsg(p_buf);
   }
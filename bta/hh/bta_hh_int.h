@@ -127,6 +127,7 @@ typedef struct {
   RawAddress addr;
   uint32_t data;
   BT_HDR* p_data;
+  uint64_t rx_us; /* receive time of an interrupt channel report */
 } tBTA_HH_CBACK_DATA;
 
 typedef struct {
@@ -213,6 +214,18 @@ typedef struct {
 #endif
 #endif
 
+/* Size of the per device map from characteristic value handle to report
+ * entry, used to find the report of an input notification. Must be a power
+ * of two. */
+#ifndef BTA_HH_LE_RPT_MAP_SIZE
+#define BTA_HH_LE_RPT_MAP_SIZE 64
+#endif
+
+typedef struct {
+  uint16_t handle; /* characteristic value handle, 0 if the slot is free */
+  tBTA_HH_LE_RPT* p_rpt;
+} tBTA_HH_LE_RPT_MAP_ENTRY;
+
 /* convert a HID handle to the LE CB index */
 #define BTA_HH_GET_LE_CB_IDX(x) (((x) >> 4) - 1)
 /* convert a GATT connection ID to HID device handle, it is the hi 4 bits of a
@@ -257,6 +270,8 @@ typedef struct {
   bool is_le_device;
   uint8_t total_srvc;
   tBTA_HH_LE_HID_SRVC hid_srvc[BTA_HH_LE_HID_SRVC_MAX];
+  tBTA_HH_LE_RPT_MAP_ENTRY rpt_handle_map[BTA_HH_LE_RPT_MAP_SIZE];
+  bool hogp_cached; /* HID service matches the persisted HOGP cache */
   uint16_t conn_id;
   bool in_bg_conn;
   uint8_t cur_srvc_index; /* currently discovering service index */
@@ -290,7 +305,10 @@ typedef struct {
                                              suppose BTA will connect
                                              to only one keyboard at
                                               the same time */
-  tBTA_HH_DEV_CB kdev[BTA_HH_MAX_DEVICE]; /* device control block */
+  tBTA_HH_DEV_CB* kdev;                   /* device control blocks,
+                                             allocated on enable */
+  uint8_t num_kdev;                       /* entries of kdev, at most
+                                             BTA_HH_MAX_DEVICE */
   tBTA_HH_DEV_CB* p_cur;                  /* current device control
                                                  block idx, used in sdp */
   uint8_t cb_index[BTA_HH_MAX_KNOWN];     /* maintain a CB index
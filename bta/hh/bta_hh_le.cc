@@ -41,7 +41,9 @@
 #include "btm_int.h"
 #include "device/include/interop.h"
 #include "osi/include/log.h"
+#include "osi/include/time.h"
 #include "srvc_api.h"
+#include "stack/btm/btm_ble_bgconn.h"
 #include "stack/include/l2c_api.h"
 #include "utl.h"
 
@@ -61,6 +63,11 @@ using std::vector;
 #define BTA_HH_LE_PROTO_REPORT_MODE 0x01
 
 #define BTA_LE_HID_RTP_UUID_MAX 5
+
+/* Layout of the persisted HOGP cache, see bta_hh_le_hogp_cache_save() */
+#define BTA_HH_LE_HOGP_CACHE_VERSION 1
+#define BTA_HH_LE_HOGP_CACHE_HDR_LEN (1 + OCTET16_LEN + 11)
+#define BTA_HH_LE_HOGP_CACHE_RPT_LEN 9
 static const uint16_t bta_hh_uuid_to_rtp_type[BTA_LE_HID_RTP_UUID_MAX][2] = {
     {GATT_UUID_HID_REPORT, BTA_HH_RPTT_INPUT},
     {GATT_UUID_HID_BT_KB_INPUT, BTA_HH_RPTT_INPUT},
@@ -319,7 +326,7 @@ tBTA_HH_DEV_CB* bta_hh_le_find_dev_cb_by_conn_id(uint16_t conn_id) {
   uint8_t i;
   tBTA_HH_DEV_CB* p_dev_cb = &bta_hh_cb.kdev[0];
 
-  for (i = 0; i < BTA_HH_MAX_DEVICE; i++, p_dev_cb++) {
+  for (i = 0; i < bta_hh_cb.num_kdev; i++, p_dev_cb++) {
     if (p_dev_cb->in_use && p_dev_cb->conn_id == conn_id) return p_dev_cb;
   }
   return NULL;
@@ -336,7 +343,7 @@ tBTA_HH_DEV_CB* bta_hh_le_find_dev_cb_by_bda(const RawAddress& bda) {
   uint8_t i;
   tBTA_HH_DEV_CB* p_dev_cb = &bta_hh_cb.kdev[0];
 
-  for (i = 0; i < BTA_HH_MAX_DEVICE; i++, p_dev_cb++) {
+  for (i = 0; i < bta_hh_cb.num_kdev; i++, p_dev_cb++) {
     if (p_dev_cb->in_use && p_dev_cb->addr == bda) return p_dev_cb;
   }
   return NULL;
@@ -399,6 +406,64 @@ tBTA_HH_LE_RPT* bta_hh_le_find_report_entry(
 
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_hh_le_rpt_map_find
+ *
+ * Description      find the report entry of an input notification by its
+ *                  characteristic value handle. Entries are validated against
+ *                  the report table, as it may have been reset since.
+ *
+ * Returns          the report entry, or NULL if the handle is not mapped
+ *
+ ******************************************************************************/
+static tBTA_HH_LE_RPT* bta_hh_le_rpt_map_find(tBTA_HH_DEV_CB* p_cb,
+                                              uint16_t handle) {
+  uint16_t slot = handle & (BTA_HH_LE_RPT_MAP_SIZE - 1);
+
+  for (uint16_t n = 0; n < BTA_HH_LE_RPT_MAP_SIZE; n++) {
+    tBTA_HH_LE_RPT_MAP_ENTRY* p_entry = &p_cb->rpt_handle_map[slot];
+    if (p_entry->handle == 0) return NULL;
+    if (p_entry->handle == handle) {
+      tBTA_HH_LE_RPT* p_rpt = p_entry->p_rpt;
+      if (p_rpt->in_use && p_rpt->char_inst_id == handle &&
+          p_rpt->srvc_inst_id == p_cb->hid_srvc[0].srvc_inst_id)
+        return p_rpt;
+      return NULL;
+    }
+    slot = (slot + 1) & (BTA_HH_LE_RPT_MAP_SIZE - 1);
+  }
+  return NULL;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_hh_le_rpt_map_add
+ *
+ * Description      map a characteristic value handle to its report entry.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void bta_hh_le_rpt_map_add(tBTA_HH_DEV_CB* p_cb, uint16_t handle,
+                                  tBTA_HH_LE_RPT* p_rpt) {
+  uint16_t slot = handle & (BTA_HH_LE_RPT_MAP_SIZE - 1);
+
+  if (handle == 0) return;
+
+  for (uint16_t n = 0; n < BTA_HH_LE_RPT_MAP_SIZE; n++) {
+    tBTA_HH_LE_RPT_MAP_ENTRY* p_entry = &p_cb->rpt_handle_map[slot];
+    if (p_entry->handle == 0 || p_entry->handle == handle) {
+      p_entry->handle = handle;
+      p_entry->p_rpt = p_rpt;
+      return;
+    }
+    slot = (slot + 1) & (BTA_HH_LE_RPT_MAP_SIZE - 1);
+  }
+  APPL_TRACE_WARNING("%s: report map full, handle 0x%04x not mapped", __func__,
+                     handle);
+}
+
 /*******************************************************************************
  *
  * Function         bta_hh_le_find_rpt_by_idtype
@@ -674,6 +739,166 @@ void bta_hh_le_deregister_input_notif(tBTA_HH_DEV_CB* p_dev_cb) {
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_hh_le_hogp_cache_save
+ *
+ * Description      Persist the HID service of a bonded device, so that the
+ *                  next connection can skip reading the report map, the
+ *                  report references and writing the client configurations.
+ *                  The cache is bound to the hash of the GATT database.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void bta_hh_le_hogp_cache_save(tBTA_HH_DEV_CB* p_cb) {
+  tBTA_HH_LE_HID_SRVC* p_srvc = &p_cb->hid_srvc[0];
+  Octet16 hash;
+  uint8_t num_rpt = 0;
+
+  if (!p_srvc->in_use || p_srvc->rpt_map == NULL ||
+      !btm_sec_is_a_bonded_dev(p_cb->addr) ||
+      !BTA_GATTC_GetDatabaseHash(p_cb->conn_id, &hash))
+    return;
+
+  for (int i = 0; i < BTA_HH_LE_RPT_MAX; i++)
+    if (p_srvc->report[i].in_use) num_rpt++;
+
+  uint16_t len = BTA_HH_LE_HOGP_CACHE_HDR_LEN +
+                 num_rpt * BTA_HH_LE_HOGP_CACHE_RPT_LEN + 2 +
+                 p_srvc->descriptor.dl_len;
+  uint8_t* p_data = (uint8_t*)osi_malloc(len);
+  uint8_t* pp = p_data;
+
+  UINT8_TO_STREAM(pp, BTA_HH_LE_HOGP_CACHE_VERSION);
+  ARRAY_TO_STREAM(pp, hash.data(), OCTET16_LEN);
+  UINT8_TO_STREAM(pp, p_srvc->srvc_inst_id);
+  UINT8_TO_STREAM(pp, p_srvc->incl_srvc_inst);
+  UINT16_TO_STREAM(pp, p_srvc->proto_mode_handle);
+  UINT8_TO_STREAM(pp, p_srvc->control_point_handle);
+  UINT16_TO_STREAM(pp, p_srvc->ext_rpt_ref);
+  UINT16_TO_STREAM(pp, p_cb->dscp_info.version);
+  UINT8_TO_STREAM(pp, p_cb->dscp_info.ctry_code);
+  UINT8_TO_STREAM(pp, p_cb->dscp_info.flag);
+  UINT8_TO_STREAM(pp, num_rpt);
+
+  for (int i = 0; i < BTA_HH_LE_RPT_MAX; i++) {
+    tBTA_HH_LE_RPT* p_rpt = &p_srvc->report[i];
+    if (!p_rpt->in_use) continue;
+    UINT16_TO_STREAM(pp, p_rpt->uuid);
+    UINT8_TO_STREAM(pp, p_rpt->rpt_id);
+    UINT8_TO_STREAM(pp, p_rpt->rpt_type);
+    UINT8_TO_STREAM(pp, p_rpt->srvc_inst_id);
+    UINT16_TO_STREAM(pp, p_rpt->char_inst_id);
+    UINT16_TO_STREAM(pp, p_rpt->client_cfg_value);
+  }
+
+  UINT16_TO_STREAM(pp, p_srvc->descriptor.dl_len);
+  ARRAY_TO_STREAM(pp, p_srvc->rpt_map, p_srvc->descriptor.dl_len);
+
+  bta_hh_le_co_hogp_cache_save(p_cb->addr, p_data, len, p_cb->app_id);
+  osi_free(p_data);
+  p_cb->hogp_cached = true;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_hh_le_hogp_cache_restore
+ *
+ * Description      Restore the HID service from the persisted HOGP cache if
+ *                  it was saved against the same GATT database. A stale cache
+ *                  is removed.
+ *
+ * Returns          true if the HID service was restored
+ *
+ ******************************************************************************/
+static bool bta_hh_le_hogp_cache_restore(tBTA_HH_DEV_CB* p_cb,
+                                         const gatt::Service* service) {
+  tBTA_HH_LE_HID_SRVC* p_srvc = &p_cb->hid_srvc[0];
+  Octet16 hash;
+  uint16_t len = 0;
+
+  if (!BTA_GATTC_GetDatabaseHash(p_cb->conn_id, &hash)) return false;
+
+  uint8_t* p_data = bta_hh_le_co_hogp_cache_load(p_cb->addr, &len, p_cb->app_id);
+  if (p_data == NULL) return false;
+
+  /* validate the whole cache before touching the service */
+  uint8_t* pp = p_data;
+  uint8_t version = 0, srvc_inst_id = 0, num_rpt = 0;
+  uint16_t map_len = 0;
+  bool valid = false;
+
+  if (len >= BTA_HH_LE_HOGP_CACHE_HDR_LEN + 2) {
+    STREAM_TO_UINT8(version, pp);
+    valid = (version == BTA_HH_LE_HOGP_CACHE_VERSION &&
+             memcmp(pp, hash.data(), OCTET16_LEN) == 0);
+    pp += OCTET16_LEN;
+    srvc_inst_id = pp[0];
+    num_rpt = p_data[BTA_HH_LE_HOGP_CACHE_HDR_LEN - 1];
+  }
+  if (valid) {
+    valid = (srvc_inst_id == (uint8_t)service->handle &&
+             num_rpt <= BTA_HH_LE_RPT_MAX &&
+             len >= BTA_HH_LE_HOGP_CACHE_HDR_LEN +
+                        num_rpt * BTA_HH_LE_HOGP_CACHE_RPT_LEN + 2);
+  }
+  if (valid) {
+    uint8_t* p_len = p_data + BTA_HH_LE_HOGP_CACHE_HDR_LEN +
+                     num_rpt * BTA_HH_LE_HOGP_CACHE_RPT_LEN;
+    STREAM_TO_UINT16(map_len, p_len);
+    valid = (map_len > 0 &&
+             len == BTA_HH_LE_HOGP_CACHE_HDR_LEN +
+                        num_rpt * BTA_HH_LE_HOGP_CACHE_RPT_LEN + 2 + map_len);
+  }
+
+  if (!valid) {
+    APPL_TRACE_WARNING("%s: stale HOGP cache for %s, rediscovering", __func__,
+                       p_cb->addr.ToString().c_str());
+    osi_free(p_data);
+    bta_hh_le_co_hogp_cache_reset(p_cb->addr, p_cb->app_id);
+    return false;
+  }
+
+  pp = p_data + 1 + OCTET16_LEN;
+  STREAM_TO_UINT8(p_srvc->srvc_inst_id, pp);
+  STREAM_TO_UINT8(p_srvc->incl_srvc_inst, pp);
+  STREAM_TO_UINT16(p_srvc->proto_mode_handle, pp);
+  STREAM_TO_UINT8(p_srvc->control_point_handle, pp);
+  STREAM_TO_UINT16(p_srvc->ext_rpt_ref, pp);
+  STREAM_TO_UINT16(p_cb->dscp_info.version, pp);
+  STREAM_TO_UINT8(p_cb->dscp_info.ctry_code, pp);
+  STREAM_TO_UINT8(p_cb->dscp_info.flag, pp);
+  pp++; /* num_rpt */
+
+  memset(p_srvc->report, 0, sizeof(p_srvc->report));
+  for (uint8_t i = 0; i < num_rpt; i++) {
+    tBTA_HH_LE_RPT* p_rpt = &p_srvc->report[i];
+    p_rpt->in_use = true;
+    p_rpt->index = i;
+    STREAM_TO_UINT16(p_rpt->uuid, pp);
+    STREAM_TO_UINT8(p_rpt->rpt_id, pp);
+    STREAM_TO_UINT8(p_rpt->rpt_type, pp);
+    STREAM_TO_UINT8(p_rpt->srvc_inst_id, pp);
+    STREAM_TO_UINT16(p_rpt->char_inst_id, pp);
+    STREAM_TO_UINT16(p_rpt->client_cfg_value, pp);
+  }
+
+  pp += 2; /* map_len */
+  osi_free_and_reset((void**)&p_srvc->rpt_map);
+  p_srvc->rpt_map = (uint8_t*)osi_malloc(map_len);
+  STREAM_TO_ARRAY(p_srvc->rpt_map, pp, map_len);
+  p_srvc->descriptor.dl_len = map_len;
+  p_srvc->descriptor.dsc_list = p_srvc->rpt_map;
+
+  osi_free(p_data);
+
+  APPL_TRACE_DEBUG("%s: restored %d reports, report map %d bytes", __func__,
+                   num_rpt, map_len);
+  p_cb->hogp_cached = true;
+  return true;
+}
+
 /*******************************************************************************
  *
  * Function         bta_hh_le_open_cmpl
@@ -689,6 +914,9 @@ void bta_hh_le_open_cmpl(tBTA_HH_DEV_CB* p_cb) {
     bta_hh_le_hid_report_dbg(p_cb);
 #endif
     bta_hh_le_register_input_notif(p_cb, 0, p_cb->mode, true);
+    if (p_cb->status == BTA_HH_OK && !p_cb->hogp_cached &&
+        (BTA_HH_LE_HID_SRVC_MAX == 1 || !p_cb->hid_srvc[1].in_use))
+      bta_hh_le_hogp_cache_save(p_cb);
     bta_hh_sm_execute(p_cb, BTA_HH_OPEN_CMPL_EVT, NULL);
 
 #if (BTA_HH_LE_RECONN == TRUE)
@@ -787,8 +1015,12 @@ bool bta_hh_le_write_rpt_clt_cfg(tBTA_HH_DEV_CB* p_cb) {
 
   for (i = p_cb->clt_cfg_idx; i < BTA_HH_LE_RPT_MAX && p_rpt->in_use;
        i++, p_rpt++) {
-    /* enable notification for all input report, regardless mode */
-    if (p_rpt->rpt_type == BTA_HH_RPTT_INPUT) {
+    /* enable notification for all input report, regardless mode. A report
+     * restored from the HOGP cache keeps its configuration on the bonded
+     * peer. */
+    if (p_rpt->rpt_type == BTA_HH_RPTT_INPUT &&
+        !(p_cb->hogp_cached &&
+          p_rpt->client_cfg_value == GATT_CLT_CONFIG_NOTIFICATION)) {
 //      p_cb->cur_srvc_index = srvc_inst_id;
       APPL_TRACE_ERROR("curent hid instance: %d",p_cb->cur_srvc_index );
       if (bta_hh_le_write_ccc(p_cb, p_rpt->char_inst_id,
@@ -1016,6 +1248,7 @@ void bta_hh_le_dis_cback(const RawAddress& addr, tDIS_VALUE* p_dis_value) {
  ******************************************************************************/
 void bta_hh_le_pri_service_discovery(tBTA_HH_DEV_CB* p_cb) {
   bta_hh_le_co_reset_rpt_cache(p_cb->addr, p_cb->app_id);
+  p_cb->hogp_cached = false;
 
   p_cb->disc_active |= (BTA_HH_LE_DISC_HIDS | BTA_HH_LE_DISC_DIS);
 
@@ -1242,6 +1475,9 @@ void bta_hh_gatt_open(tBTA_HH_DEV_CB* p_cb, tBTA_HH_DATA* p_buf) {
     bta_hh_cb.le_cb_index[BTA_HH_GET_LE_CB_IDX(p_cb->hid_handle)] = p_cb->index;
 
     BtaGattQueue::Clean(p_cb->conn_id);
+    /* output reports sent as write commands do not have to wait for each
+     * other, the queue still completes them in order */
+    BtaGattQueue::SetPipelined(p_cb->conn_id, true);
 
 #if (BTA_HH_DEBUG == TRUE)
     APPL_TRACE_DEBUG("hid_handle = %2x conn_id = %04x cb_index = %d",
@@ -1602,7 +1838,20 @@ void bta_hh_le_srvc_search_cmpl(tBTA_GATTC_SEARCH_CMPL* p_data) {
   uint8_t srvc_index = p_dev_cb->cur_srvc_index;
 
   bool have_hid = false;
+  bool hogp_cached = false;
   tBTA_HH_LE_RPT* p_rpt;
+
+  /* a bonded device with an unchanged database needs no HID reads */
+  if (srvc_index == 0) {
+    for (const gatt::Service& service : *services) {
+      if (service.uuid == Uuid::From16Bit(UUID_SERVCLASS_LE_HID) &&
+          service.is_primary) {
+        hogp_cached = bta_hh_le_hogp_cache_restore(p_dev_cb, &service);
+        break;
+      }
+    }
+  }
+
   for (const gatt::Service& service : *services) {
     if (service.uuid == Uuid::From16Bit(UUID_SERVCLASS_LE_HID) &&
         service.is_primary && !have_hid) {
@@ -1612,16 +1861,22 @@ void bta_hh_le_srvc_search_cmpl(tBTA_GATTC_SEARCH_CMPL* p_data) {
       srvc_index = p_dev_cb->cur_srvc_index;
       p_dev_cb->hid_srvc[srvc_index].in_use = true;
       p_dev_cb->hid_srvc[srvc_index].srvc_inst_id = service.handle;
-      p_dev_cb->hid_srvc[srvc_index].proto_mode_handle = 0;
-      p_dev_cb->hid_srvc[srvc_index].control_point_handle = 0;
 
-      bta_hh_le_search_hid_chars(p_dev_cb, &service);
+      if (hogp_cached) {
+        if (p_dev_cb->hid_srvc[srvc_index].proto_mode_handle != 0)
+          bta_hh_le_set_protocol_mode(p_dev_cb, p_dev_cb->mode);
+      } else {
+        p_dev_cb->hid_srvc[srvc_index].proto_mode_handle = 0;
+        p_dev_cb->hid_srvc[srvc_index].control_point_handle = 0;
+        bta_hh_le_search_hid_chars(p_dev_cb, &service);
+      }
       if (p_dev_cb->cur_srvc_index < BTA_HH_LE_HID_SRVC_MAX-1) {
          p_dev_cb->cur_srvc_index++;
          APPL_TRACE_DEBUG("%s: current service instance  %d", __func__,
                   srvc_index);
       }
-    } else if (service.uuid == Uuid::From16Bit(UUID_SERVCLASS_BATTERY)) {
+    } else if (service.uuid == Uuid::From16Bit(UUID_SERVCLASS_BATTERY) &&
+               !hogp_cached) {
     for (const gatt::Characteristic& p_char : service.characteristics) {
 
           if (p_char.uuid.As16Bit()== GATT_UUID_BATTERY_LEVEL) {
@@ -1690,9 +1945,9 @@ void bta_hh_le_srvc_search_cmpl(tBTA_GATTC_SEARCH_CMPL* p_data) {
  *
  ******************************************************************************/
 void bta_hh_le_input_rpt_notify(tBTA_GATTC_NOTIFY* p_data) {
+  uint64_t rx_us = time_get_os_boottime_us();
   tBTA_HH_DEV_CB* p_dev_cb = bta_hh_le_find_dev_cb_by_conn_id(p_data->conn_id);
   uint8_t app_id;
-  uint8_t* p_buf;
   tBTA_HH_LE_RPT* p_rpt;
 
   if (p_dev_cb == NULL) {
@@ -1702,6 +1957,23 @@ void bta_hh_le_input_rpt_notify(tBTA_GATTC_NOTIFY* p_data) {
     return;
   }
 
+  /* input reports seen before are found by handle, without going through the
+   * GATT database */
+  p_rpt = bta_hh_le_rpt_map_find(p_dev_cb, p_data->handle);
+  if (p_rpt != NULL) {
+    app_id = p_dev_cb->app_id;
+    if (p_rpt->uuid == GATT_UUID_HID_BT_MOUSE_INPUT)
+      app_id = BTA_HH_APP_ID_MI;
+    else if (p_rpt->uuid == GATT_UUID_HID_BT_KB_INPUT)
+      app_id = BTA_HH_APP_ID_KB;
+
+    bta_hh_co_le_input((uint8_t)p_dev_cb->hid_handle, p_rpt->rpt_id,
+                       p_data->value, p_data->len, p_dev_cb->mode,
+                       p_dev_cb->dscp_info.ctry_code, p_dev_cb->addr, app_id,
+                       rx_us);
+    return;
+  }
+
   const gatt::Characteristic* p_char =
       BTA_GATTC_GetCharacteristic(p_dev_cb->conn_id, p_data->handle);
   if (p_char == NULL) {
@@ -1738,22 +2010,14 @@ void bta_hh_le_input_rpt_notify(tBTA_GATTC_NOTIFY* p_data) {
   APPL_TRACE_DEBUG("%s Notification received on report ID: %d, conn_id: 0x%04x"
     ,__func__, p_rpt->rpt_id, p_data->conn_id);
 
-  /* need to append report ID to the head of data */
-  if (p_rpt->rpt_id != 0) {
-    p_buf = (uint8_t*)osi_malloc(p_data->len + 1);
-
-    p_buf[0] = p_rpt->rpt_id;
-    memcpy(&p_buf[1], p_data->value, p_data->len);
-    ++p_data->len;
-  } else {
-    p_buf = p_data->value;
-  }
-
-  bta_hh_co_data((uint8_t)p_dev_cb->hid_handle, p_buf, p_data->len,
-                 p_dev_cb->mode, 0, /* no sub class*/
-                 p_dev_cb->dscp_info.ctry_code, p_dev_cb->addr, app_id);
+  if (p_rpt->uuid != GATT_UUID_BATTERY_LEVEL)
+    bta_hh_le_rpt_map_add(p_dev_cb, p_data->handle, p_rpt);
 
-  if (p_buf != p_data->value) osi_free(p_buf);
+  /* the report ID is put at the head of data while writing it out */
+  bta_hh_co_le_input((uint8_t)p_dev_cb->hid_handle, p_rpt->rpt_id,
+                     p_data->value, p_data->len, p_dev_cb->mode,
+                     p_dev_cb->dscp_info.ctry_code, p_dev_cb->addr, app_id,
+                     rx_us);
 }
 
 /*******************************************************************************
@@ -2200,6 +2464,8 @@ static void bta_hh_le_add_dev_bg_conn(tBTA_HH_DEV_CB* p_cb, bool check_bond) {
     /* add device into BG connection to accept remote initiated connection */
     BTA_GATTC_Open(bta_hh_cb.gatt_if, p_cb->addr, false, GATT_TRANSPORT_LE,
                    false);
+    /* input devices are expected to be back as soon as they advertise */
+    BTM_BackgroundConnectSetHighPriority(p_cb->addr, true);
     p_cb->in_bg_conn = true;
   }
   return;
@@ -2254,6 +2520,7 @@ void bta_hh_le_remove_dev_bg_conn(tBTA_HH_DEV_CB* p_dev_cb) {
     p_dev_cb->in_bg_conn = false;
 
     BTA_GATTC_CancelOpen(bta_hh_cb.gatt_if, p_dev_cb->addr, false);
+    BTM_BackgroundConnectSetHighPriority(p_dev_cb->addr, false);
   }
 
   /* deregister all notifications */
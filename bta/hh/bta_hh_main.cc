@@ -432,7 +432,7 @@ bool bta_hh_hdl_event(BT_HDR* p_msg) {
         /* Special handling for vc unplug event before device is opened */
         index = bta_hh_find_cb(((tBTA_HH_CBACK_DATA *)p_msg)->addr);
       }
-      if ((index != BTA_HH_IDX_INVALID)  && (index < BTA_HH_MAX_DEVICE))
+      if ((index != BTA_HH_IDX_INVALID)  && (index < bta_hh_cb.num_kdev))
         p_cb = &bta_hh_cb.kdev[index];
 
 #if (BTA_HH_DEBUG == TRUE)
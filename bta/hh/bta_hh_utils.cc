@@ -21,6 +21,7 @@
 #if (BTA_HH_INCLUDED == TRUE)
 
 #include "bta_hh_int.h"
+#include "osi/include/footprint.h"
 #include "osi/include/osi.h"
 #include "device/include/interop.h"
 #include "device/include/interop_config.h"
@@ -80,7 +81,7 @@ uint8_t bta_hh_find_cb(const RawAddress& bda) {
   uint8_t xx;
 
   /* See how many active devices there are. */
-  for (xx = 0; xx < BTA_HH_MAX_DEVICE; xx++) {
+  for (xx = 0; xx < bta_hh_cb.num_kdev; xx++) {
     /* check if any active/known devices is a match */
     if ((bda == bta_hh_cb.kdev[xx].addr && !bda.IsEmpty())) {
 #if (BTA_HH_DEBUG == TRUE)
@@ -98,7 +99,7 @@ uint8_t bta_hh_find_cb(const RawAddress& bda) {
   }
 
   /* if no active device match, find a spot for it */
-  for (xx = 0; xx < BTA_HH_MAX_DEVICE; xx++) {
+  for (xx = 0; xx < bta_hh_cb.num_kdev; xx++) {
     if (!bta_hh_cb.kdev[xx].in_use) {
       bta_hh_cb.kdev[xx].addr = bda;
       break;
@@ -107,10 +108,10 @@ uint8_t bta_hh_find_cb(const RawAddress& bda) {
 /* If device list full, report BTA_HH_IDX_INVALID */
 #if (BTA_HH_DEBUG == TRUE)
   APPL_TRACE_DEBUG("bta_hh_find_cb:: index = %d while max = %d", xx,
-                   BTA_HH_MAX_DEVICE);
+                   bta_hh_cb.num_kdev);
 #endif
 
-  if (xx == BTA_HH_MAX_DEVICE) xx = BTA_HH_IDX_INVALID;
+  if (xx == bta_hh_cb.num_kdev) xx = BTA_HH_IDX_INVALID;
 
   return xx;
 }
@@ -400,7 +401,7 @@ tBTA_HH_STATUS bta_hh_read_ssr_param(const RawAddress& bd_addr,
   tBTA_HH_CB* p_cb = &bta_hh_cb;
   uint8_t i;
   uint16_t ssr_max_latency;
-  for (i = 0; i < BTA_HH_MAX_KNOWN; i++) {
+  for (i = 0; i < p_cb->num_kdev; i++) {
     if (p_cb->kdev[i].addr == bd_addr) {
       /* if remote device does not have HIDSSRHostMaxLatency attribute in SDP,
       set SSR max latency default value here.  */
@@ -453,7 +454,7 @@ tBTA_HH_STATUS bta_hh_read_ssr_param(const RawAddress& bd_addr,
 void bta_hh_cleanup_disable(tBTA_HH_STATUS status) {
   uint8_t xx;
   /* free buffer in CB holding report descriptors */
-  for (xx = 0; xx < BTA_HH_MAX_DEVICE; xx++) {
+  for (xx = 0; xx < bta_hh_cb.num_kdev; xx++) {
     osi_free_and_reset(
         (void**)&bta_hh_cb.kdev[xx].dscp_info.descriptor.dsc_list);
   }
@@ -469,7 +470,9 @@ void bta_hh_cleanup_disable(tBTA_HH_STATUS status) {
     bta_hh.status = status;
     (*bta_hh_cb.p_cback)(BTA_HH_DISABLE_EVT, &bta_hh);
     /* all connections are down, no waiting for diconnect */
+    osi_free(bta_hh_cb.kdev);
     memset(&bta_hh_cb, 0, sizeof(tBTA_HH_CB));
+    footprint_set("bta_hh", "devices", 0);
   }
 }
 
@@ -486,7 +489,7 @@ void bta_hh_cleanup_disable(tBTA_HH_STATUS status) {
  ******************************************************************************/
 uint8_t bta_hh_dev_handle_to_cb_idx(uint8_t dev_handle) {
   uint8_t index = BTA_HH_IDX_INVALID;
-  APPL_TRACE_WARNING("bta_hh_dev_handle_to_cb_idx dev_handle = %d", dev_handle);
+  APPL_TRACE_DEBUG("bta_hh_dev_handle_to_cb_idx dev_handle = %d", dev_handle);
 #if (BTA_HH_LE_INCLUDED == TRUE)
   if (BTA_HH_IS_LE_DEV_HDL(dev_handle)) {
     if (BTA_HH_IS_LE_DEV_HDL_VALID(dev_handle))
@@ -518,7 +521,7 @@ void bta_hh_trace_dev_db(void) {
 
   APPL_TRACE_DEBUG("bta_hh_trace_dev_db:: Device DB list********************");
 
-  for (xx = 0; xx < BTA_HH_MAX_DEVICE; xx++) {
+  for (xx = 0; xx < bta_hh_cb.num_kdev; xx++) {
     APPL_TRACE_DEBUG("kdev[%d] in_use[%d]  handle[%d] ", xx,
                      bta_hh_cb.kdev[xx].in_use, bta_hh_cb.kdev[xx].hid_handle);
 
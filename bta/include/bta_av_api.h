@@ -538,6 +538,10 @@ typedef struct {
   RawAddress bd_addr;
 } tBTA_AVK_CONFIG;
 
+/* Size of the RTP timestamp stored before the payload of a packet delivered
+ * with BTA_AV_SINK_MEDIA_DATA_EVT, see BTA_AvGetSinkMediaTimestamp() */
+#define BTA_AV_SINK_MEDIA_TS_LEN 4
+
 /* union of data associated with AV Media callback */
 typedef union {
   BT_HDR* p_data;
@@ -951,6 +955,21 @@ void BTA_AvOffloadStart(tBTA_AV_HNDL hndl, bool do_scrambling);
  *
  ******************************************************************************/
 void BTA_AvOffloadStartRsp(tBTA_AV_HNDL hndl, tBTA_AV_STATUS status);
+
+/*******************************************************************************
+ *
+ * Function         BTA_AvGetSinkMediaTimestamp
+ *
+ * Description      Get the RTP timestamp of a media packet delivered with
+ *                  BTA_AV_SINK_MEDIA_DATA_EVT. The timestamp is stored in the
+ *                  BTA_AV_SINK_MEDIA_TS_LEN bytes before the payload, in the
+ *                  headroom left by the media packet header. The sequence
+ *                  number is in |p_pkt->layer_specific|.
+ *
+ * Returns          RTP timestamp of |p_pkt|
+ *
+ ******************************************************************************/
+uint32_t BTA_AvGetSinkMediaTimestamp(const BT_HDR* p_pkt);
 void BTA_AvUpdateTWSDevice(bool isTwsDevice, tBTA_AV_HNDL hndl);
 void BTA_AVSetEarbudState(uint8_t state, tBTA_AV_HNDL hndl);
 void BTA_AVSetEarbudRole(uint8_t role, tBTA_AV_HNDL hndl);
@@ -0,0 +1,74 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Encoder of one BIS of a broadcast. An instance is only ever used by one
+// thread at a time, but not always the same one.
+class BroadcastBisEncoder {
+ public:
+  virtual ~BroadcastBisEncoder() = default;
+
+  // Encodes the |num_samples| 16 bit samples of one SDU interval from |pcm|
+  // into |p_sdu|, which holds up to |max_len| bytes. Returns the length of
+  // the SDU, 0 if nothing is to be sent for this interval.
+  virtual uint16_t Encode(const int16_t* pcm, uint16_t num_samples,
+                          uint8_t* p_sdu, uint16_t max_len) = 0;
+};
+
+// Channel of the PCM stream a BIS is encoded from.
+constexpr uint8_t BROADCAST_CHANNEL_DOWNMIX = 0xff;
+
+struct BroadcastBisConfig {
+  uint16_t bis_handle;
+  // Index of the PCM channel, or BROADCAST_CHANNEL_DOWNMIX for the average
+  // of all channels.
+  uint8_t channel;
+  std::unique_ptr<BroadcastBisEncoder> encoder;
+};
+
+struct BroadcastAudioConfig {
+  uint32_t sample_rate;
+  uint8_t num_channels;  // Interleaved 16 bit channels read from the HAL
+  uint32_t sdu_interval_us;
+  uint16_t max_sdu;
+};
+
+// Reads up to |len| bytes of PCM, normally the Read of the broadcast sink of
+// the audio HAL interface in audio_hal_interface/aidl/le_audio_software.h.
+using BroadcastPcmReader = std::function<size_t(uint8_t* p_buf, uint32_t len)>;
+
+// Source of the audio of a BIG we broadcast. On every SDU interval one frame
+// of PCM is read, split once into the channels the BISes are encoded from,
+// and the BISes are encoded in parallel on the worker threads. The SDUs of an
+// interval are handed to the ISO transmit path together once all encoders
+// are done. Runs on the main thread.
+class BroadcastAudioSource {
+ public:
+  static bool Start(const BroadcastAudioConfig& config,
+                    std::vector<BroadcastBisConfig> bises,
+                    BroadcastPcmReader reader);
+  static void Stop();
+  static void DebugDump(int fd);
+};
@@ -255,6 +255,17 @@ typedef struct {
   tGATT_STATUS status;
 } tBTA_GATTC_SUBRATE_CHG;
 
+/* Latency and throughput counters of a client connection, see
+ * BTA_GATTC_GetConnStats */
+typedef struct {
+  tGATTC_CONN_STATS link;   /* ATT counters of the underlying link */
+  uint16_t queue_depth;     /* operations in BtaGattQueue */
+  uint16_t queue_max_depth; /* highest queue_depth seen */
+  uint32_t cback_count;     /* notification and completion callbacks */
+  uint32_t cback_max_us;
+  uint64_t cback_total_us;
+} tBTA_GATTC_CONN_STATS;
+
 typedef union {
   tGATT_STATUS status;
 
@@ -411,6 +422,14 @@ typedef struct {
   uint16_t lens[BTA_GATTS_MULTI_MAX];
 } tBTA_GATTS_MULTI_NTF;
 
+/* One notification of BTA_GATTS_HandleValueNotifications */
+typedef struct {
+  uint16_t conn_id;
+  uint16_t attr_id;
+  uint16_t len;
+  const uint8_t* p_value;
+} tBTA_GATTS_NTF;
+
 /* GATTS callback data */
 typedef union {
   tBTA_GATTS_REG_OPER reg_oper;
@@ -613,6 +632,21 @@ extern const gatt::Characteristic* BTA_GATTC_GetOwningCharacteristic(
 extern const gatt::Service* BTA_GATTC_GetOwningService(uint16_t conn_id,
                                                        uint16_t handle);
 
+/*******************************************************************************
+ *
+ * Function         BTA_GATTC_GetDatabaseHash
+ *
+ * Description      This function is called to get the hash of the GATT
+ *                  database discovered or loaded for the given server.
+ *
+ * Parameters       conn_id: connection ID which identify the server.
+ *                  p_hash: output parameter which will contain the hash
+ *
+ * Returns          true if the database is available, false otherwise.
+ *
+ ******************************************************************************/
+extern bool BTA_GATTC_GetDatabaseHash(uint16_t conn_id, Octet16* p_hash);
+
 /*******************************************************************************
  *
  * Function         BTA_GATTC_GetGattDb
@@ -895,6 +929,34 @@ extern void BTA_GATTC_ConfigureMTU(uint16_t conn_id, uint16_t mtu,
  ******************************************************************************/
 extern void BTA_GATTC_ResetGattDb(const RawAddress& remote_bda);
 
+/*******************************************************************************
+ *
+ * Function         BTA_GATTC_GetConnStats
+ *
+ * Description      Get the latency and throughput counters of a connection:
+ *                  ATT response times, notification rate, queued operations
+ *                  and time spent in the application callbacks.
+ *
+ * Parameters       conn_id: connection ID.
+ *                  p_stats: filled with the counters.
+ *
+ * Returns          true if the connection exists and |p_stats| was filled.
+ *
+ ******************************************************************************/
+extern bool BTA_GATTC_GetConnStats(uint16_t conn_id,
+                                   tBTA_GATTC_CONN_STATS* p_stats);
+
+/*******************************************************************************
+ *
+ * Function         BTA_GATTC_DumpConnStats
+ *
+ * Description      Dump the counters of all client connections.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+extern void BTA_GATTC_DumpConnStats(int fd);
+
 /*******************************************************************************
  *  BTA GATT Server API
  ******************************************************************************/
@@ -1027,6 +1089,24 @@ extern void BTA_GATTS_HandleValueIndication(uint16_t conn_id, uint16_t attr_id,
                                             std::vector<uint8_t> value,
                                             bool need_confirm);
 
+/*******************************************************************************
+ *
+ * Function         BTA_GATTS_HandleValueNotifications
+ *
+ * Description      This function is called to send a batch of notifications,
+ *                  possibly to different clients, in one message. Their
+ *                  values are copied. They are coalesced per client and each
+ *                  is confirmed with BTA_GATTS_CONF_EVT as a single one.
+ *
+ * Parameters       p_ntfs - notifications to send.
+ *                  num_ntf - number of notifications.
+ *
+ * Returns          None
+ *
+ ******************************************************************************/
+extern void BTA_GATTS_HandleValueNotifications(const tBTA_GATTS_NTF* p_ntfs,
+                                               uint16_t num_ntf);
+
 /*******************************************************************************
  *
  * Function         BTA_GATTS_MultipleHandleValueNotification
@@ -31,6 +31,11 @@
  *
  * If you decide to use those methods in your app, make sure to not mix it with
  * existing BTA_GATTC_* API.
+ *
+ * In pipelined mode, write commands (GATT_WRITE_NO_RSP) are streamed without
+ * waiting for the previous one to complete. The stream is throttled while the
+ * channel is congested. Other operations still wait for everything issued
+ * before them, so callbacks are delivered in the order operations were queued.
  */
 class BtaGattQueue {
  public:
@@ -48,6 +53,12 @@ class BtaGattQueue {
                               tGATT_WRITE_TYPE write_type, GATT_WRITE_OP_CB cb,
                               void* cb_data);
   static void ConfigureMtu(uint16_t conn_id, uint16_t mtu);
+  static void SetPipelined(uint16_t conn_id, bool pipelined);
+  static void CongestionChanged(uint16_t conn_id, bool congested);
+  /* Number of operations waiting or executing for |conn_id|, and the highest
+   * number seen since the connection was last cleaned */
+  static size_t QueueDepth(uint16_t conn_id);
+  static size_t MaxQueueDepth(uint16_t conn_id);
 
   /* Holds pending GATT operations */
   struct gatt_operation {
@@ -68,12 +79,17 @@ class BtaGattQueue {
  private:
   static void mark_as_not_executing(uint16_t conn_id);
   static void gatt_execute_next_op(uint16_t conn_id);
+  static void execute_op(uint16_t conn_id, gatt_operation& op);
+  static bool is_streamable(uint16_t conn_id, const gatt_operation& op);
   static void gatt_read_op_finished(uint16_t conn_id, tGATT_STATUS status,
                                     uint16_t handle, uint16_t len,
                                     uint8_t* value, void* data);
   static void gatt_write_op_finished(uint16_t conn_id, tGATT_STATUS status,
                                      uint16_t handle, uint16_t len,
                                      const uint8_t* value, void* data);
+  static void gatt_write_cmd_op_finished(uint16_t conn_id, tGATT_STATUS status,
+                                         uint16_t handle, uint16_t len,
+                                         const uint8_t* value, void* data);
   static void gatt_configure_mtu_op_finished(uint16_t conn_id,
                                              tGATT_STATUS status, void* data);
 
@@ -81,4 +97,12 @@ class BtaGattQueue {
   static std::unordered_map<uint16_t, std::list<gatt_operation>> gatt_op_queue;
   // contain connection ids that currently execute operations
   static std::unordered_set<uint16_t> gatt_op_queue_executing;
+  // connection ids that stream write commands
+  static std::unordered_set<uint16_t> gatt_op_queue_pipelined;
+  // connection ids whose channel reported congestion
+  static std::unordered_set<uint16_t> gatt_op_queue_congested;
+  // number of streamed write commands not completed yet, per connection id
+  static std::unordered_map<uint16_t, uint8_t> gatt_write_cmds_in_flight;
+  // highest number of queued operations, per connection id
+  static std::unordered_map<uint16_t, size_t> gatt_op_queue_max_depth;
 };
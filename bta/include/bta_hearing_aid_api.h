@@ -59,6 +59,14 @@ struct AudioStats {
   size_t packet_send_count;
   size_t frame_flush_count;
   size_t frame_send_count;
+  /* Frames for which the L2CAP channel had to wait for peer credits */
+  size_t frame_credit_starved_count;
+  /* Total time the channel waited for credits, from L2CAP */
+  uint64_t credit_stall_ms;
+  /* L2CAP credit stall count seen at the previous frame */
+  uint32_t last_credit_stall_count;
+  /* Binaural slots where only the other side got its packet */
+  size_t packet_unpaired_count;
   std::deque<rssi_log> rssi_history;
 
   AudioStats() { Reset(); }
@@ -68,6 +76,10 @@ struct AudioStats {
     packet_send_count = 0;
     frame_flush_count = 0;
     frame_send_count = 0;
+    frame_credit_starved_count = 0;
+    credit_stall_ms = 0;
+    last_credit_stall_count = 0;
+    packet_unpaired_count = 0;
   }
 };
 
@@ -51,6 +51,44 @@ extern void bta_hh_co_data(uint8_t dev_handle, uint8_t* p_rpt, uint16_t len,
                            uint8_t ctry_code, const RawAddress& peer_addr,
                            uint8_t app_id);
 
+/*******************************************************************************
+ *
+ * Function         bta_hh_co_intr_data
+ *
+ * Description      This callout function is executed by HH when an input
+ *                  report is received in the interrupt channel. |rx_us| is
+ *                  the time the report was received, from
+ *                  time_get_os_boottime_us().
+ *
+ * Returns          void.
+ *
+ ******************************************************************************/
+extern void bta_hh_co_intr_data(uint8_t dev_handle, uint8_t* p_rpt,
+                                uint16_t len, tBTA_HH_PROTO_MODE mode,
+                                uint8_t sub_class, uint8_t ctry_code,
+                                const RawAddress& peer_addr, uint8_t app_id,
+                                uint64_t rx_us);
+
+/*******************************************************************************
+ *
+ * Function         bta_hh_co_le_input
+ *
+ * Description      This callout function is executed by HH when an input
+ *                  report notification is received from a HID over GATT
+ *                  device. A non zero |rpt_id| goes in front of the report
+ *                  data. |rx_us| is the time the notification was received,
+ *                  from time_get_os_boottime_us().
+ *
+ *
+ * Returns          void.
+ *
+ ******************************************************************************/
+extern void bta_hh_co_le_input(uint8_t dev_handle, uint8_t rpt_id,
+                               uint8_t* p_rpt, uint16_t len,
+                               tBTA_HH_PROTO_MODE mode, uint8_t ctry_code,
+                               const RawAddress& peer_addr, uint8_t app_id,
+                               uint64_t rx_us);
+
 /*******************************************************************************
  *
  * Function         bta_hh_co_open
@@ -156,6 +194,59 @@ extern tBTA_HH_RPT_CACHE_ENTRY* bta_hh_le_co_cache_load(
 extern void bta_hh_le_co_reset_rpt_cache(const RawAddress& remote_bda,
                                          uint8_t app_id);
 
+/*******************************************************************************
+ *
+ * Function         bta_hh_le_co_hogp_cache_save
+ *
+ * Description      This callout function is to save the HOGP cache of a
+ *                  bonded device: the HID service handles, the report table
+ *                  and the report map, serialized by HH.
+ *
+ * Parameters       remote_bda  - remote device address
+ *                  p_data      - serialized cache
+ *                  len         - length of the serialized cache
+ *                  app_id      - application id
+ *
+ * Returns          void.
+ *
+ ******************************************************************************/
+extern void bta_hh_le_co_hogp_cache_save(const RawAddress& remote_bda,
+                                         const uint8_t* p_data, uint16_t len,
+                                         uint8_t app_id);
+
+/*******************************************************************************
+ *
+ * Function         bta_hh_le_co_hogp_cache_load
+ *
+ * Description      This callout function is to load the HOGP cache saved by
+ *                  bta_hh_le_co_hogp_cache_save().
+ *
+ * Parameters       remote_bda  - remote device address
+ *                  p_len       - length of the returned cache
+ *                  app_id      - application id
+ *
+ * Returns          the serialized cache, to be freed with osi_free(), or NULL
+ *                  if there is none.
+ *
+ ******************************************************************************/
+extern uint8_t* bta_hh_le_co_hogp_cache_load(const RawAddress& remote_bda,
+                                             uint16_t* p_len, uint8_t app_id);
+
+/*******************************************************************************
+ *
+ * Function         bta_hh_le_co_hogp_cache_reset
+ *
+ * Description      This callout function is to remove the HOGP cache of a
+ *                  device.
+ *
+ * Parameters       remote_bda  - remote device address
+ *
+ * Returns          none
+ *
+ ******************************************************************************/
+extern void bta_hh_le_co_hogp_cache_reset(const RawAddress& remote_bda,
+                                          uint8_t app_id);
+
 #endif /* #if (BTA_HH_LE_INCLUDED == TRUE) */
 
 #endif /* BTA_HH_CO_H */
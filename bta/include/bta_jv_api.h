@@ -24,6 +24,8 @@
 #ifndef BTA_JV_API_H
 #define BTA_JV_API_H
 
+#include <vector>
+
 #include "bt_target.h"
 #include "bt_types.h"
 #include "bta_api.h"
@@ -666,6 +668,19 @@ tBTA_JV_STATUS BTA_JvL2capStopServer(uint16_t local_psm,
 tBTA_JV_STATUS BTA_JvL2capRead(uint32_t handle, uint32_t req_id,
                                uint8_t* p_data, uint16_t len);
 
+/*******************************************************************************
+ *
+ * Function         BTA_JvL2capReadBuf
+ *
+ * Description      This function takes the next received SDU of an L2CAP
+ *                  connection without copying it. The caller owns *pp_buf.
+ *
+ * Returns          BTA_JV_SUCCESS, if an SDU was returned in *pp_buf.
+ *                  BTA_JV_FAILURE, if there is none.
+ *
+ ******************************************************************************/
+tBTA_JV_STATUS BTA_JvL2capReadBuf(uint32_t handle, BT_HDR** pp_buf);
+
 /*******************************************************************************
  *
  * Function         BTA_JvL2capReady
@@ -679,6 +694,20 @@ tBTA_JV_STATUS BTA_JvL2capRead(uint32_t handle, uint32_t req_id,
  ******************************************************************************/
 tBTA_JV_STATUS BTA_JvL2capReady(uint32_t handle, uint32_t* p_data_size);
 
+/*******************************************************************************
+ *
+ * Function         BTA_JvL2capFlowControl
+ *
+ * Description      This function stops or restarts the data flow from the peer
+ *                  of an L2CAP connection. It takes effect on channels in
+ *                  ERTM mode only, basic mode has no flow control.
+ *
+ * Returns          BTA_JV_SUCCESS, if the channel was flow controlled.
+ *                  BTA_JV_FAILURE, otherwise.
+ *
+ ******************************************************************************/
+tBTA_JV_STATUS BTA_JvL2capFlowControl(uint32_t handle, bool enable);
+
 /*******************************************************************************
  *
  * Function         BTA_JvL2capWrite
@@ -695,6 +724,25 @@ tBTA_JV_STATUS BTA_JvL2capReady(uint32_t handle, uint32_t* p_data_size);
 tBTA_JV_STATUS BTA_JvL2capWrite(uint32_t handle, uint32_t req_id, BT_HDR* msg,
                                 uint32_t user_id);
 
+/*******************************************************************************
+ *
+ * Function         BTA_JvL2capWriteBatch
+ *
+ * Description      This function writes several SDUs to an L2CAP connection
+ *                  with a single message to the BTA thread. SDUs written
+ *                  while the channel is congested are queued in GAP rather
+ *                  than dropped. When the operation is complete,
+ *                  tBTA_JV_L2CAP_CBACK is called once with
+ *                  BTA_JV_L2CAP_WRITE_EVT for the total length. Works for
+ *                  PSM-based connections
+ *
+ * Returns          BTA_JV_SUCCESS, if the request is being processed.
+ *                  BTA_JV_FAILURE, otherwise.
+ *
+ ******************************************************************************/
+tBTA_JV_STATUS BTA_JvL2capWriteBatch(uint32_t handle, std::vector<BT_HDR*> msgs,
+                                     uint32_t user_id);
+
 /*******************************************************************************
  *
  * Function         BTA_JvL2capWriteFixed
@@ -44,6 +44,7 @@
 #include "gap_api.h"
 #include "l2c_api.h"
 #include "osi/include/allocator.h"
+#include "osi/include/open_hash_map.h"
 #include "port_api.h"
 #include "rfcdefs.h"
 #include "sdp_api.h"
@@ -78,9 +79,24 @@ struct fc_channel {
   uint16_t chan;
 };
 
+/* channel and peer of a connected client, the key of |fc_conns| */
+struct fc_conn_key {
+  uint16_t chan;
+  RawAddress remote_addr;
+
+  bool operator==(const fc_conn_key& other) const {
+    return chan == other.chan && remote_addr == other.remote_addr;
+  }
+};
+
 static struct fc_client* fc_clients;
 static struct fc_channel* fc_channels;
 static uint32_t fc_next_id;
+/* Clients by channel and peer, so that data indications do not walk the
+ * client lists. When several clients are connected to the same peer on a
+ * channel the most recent one is indexed, which is the one the lists would
+ * find first. */
+static system_bt_osi::OpenHashMap<fc_conn_key, struct fc_client*> fc_conns;
 
 static void fcchan_conn_chng_cbk(uint16_t chan, const RawAddress& bd_addr,
                                  bool connected, uint16_t reason,
@@ -1382,6 +1398,49 @@ void bta_jv_l2cap_write(uint32_t handle, uint32_t req_id, BT_HDR* msg,
   p_cb->p_cback(BTA_JV_L2CAP_WRITE_EVT, &bta_jv, user_id);
 }
 
+/*******************************************************************************
+ *
+ * Function     bta_jv_l2cap_write_batch
+ *
+ * Description  Write several SDUs to an L2CAP connection. Unlike
+ *              bta_jv_l2cap_write(), SDUs are handed to GAP even when the
+ *              channel is congested: GAP queues them until the congestion
+ *              clears, so a batch that congests the channel midway does not
+ *              lose its tail. The caller stops feeding the channel on the
+ *              congestion event, which bounds that queue.
+ *
+ * Returns      void
+ *
+ ******************************************************************************/
+void bta_jv_l2cap_write_batch(uint32_t handle, std::vector<BT_HDR*> msgs,
+                              uint32_t user_id, tBTA_JV_L2C_CB* p_cb) {
+  if (!p_cb->p_cback) {
+    /* See bta_jv_l2cap_write() */
+    LOG(ERROR) << __func__ << ": p_cb->p_cback == NULL";
+    for (BT_HDR* msg : msgs) osi_free(msg);
+    return;
+  }
+
+  tBTA_JV_L2CAP_WRITE evt_data;
+  memset(&evt_data, 0, sizeof(evt_data));
+  evt_data.status = BTA_JV_SUCCESS;
+  evt_data.handle = handle;
+
+  bta_jv_pm_conn_busy(p_cb->p_pm_cb);
+
+  for (BT_HDR* msg : msgs) {
+    evt_data.len += msg->len;
+    msg->event = BT_EVT_TO_BTU_SP_DATA;
+    if (GAP_ConnWriteData(handle, msg) != BT_PASS)
+      evt_data.status = BTA_JV_FAILURE;
+  }
+  evt_data.cong = p_cb->cong;
+
+  tBTA_JV bta_jv;
+  bta_jv.l2c_write = evt_data;
+  p_cb->p_cback(BTA_JV_L2CAP_WRITE_EVT, &bta_jv, user_id);
+}
+
 /*******************************************************************************
  *
  * Function     bta_jv_l2cap_write_fixed
@@ -1445,6 +1504,9 @@ static int bta_jv_port_data_co_cback(uint16_t port_handle, uint8_t* buf,
         return bta_co_rfc_data_outgoing_size(p_pcb->rfcomm_slot_id, (int*)buf);
       case DATA_CO_CALLBACK_TYPE_OUTGOING:
         return bta_co_rfc_data_outgoing(p_pcb->rfcomm_slot_id, buf, len);
+      case DATA_CO_CALLBACK_TYPE_OUTGOING_IOV:
+        return bta_co_rfc_data_outgoing_iov(p_pcb->rfcomm_slot_id,
+                                            (struct iovec*)buf, len);
       default:
         APPL_TRACE_ERROR("unknown callout type:%d", type);
         break;
@@ -2297,22 +2359,28 @@ static struct fc_channel* fcchan_get(uint16_t chan, char create) {
   return t;
 }
 
-/* pass NULL to find servers */
-static struct fc_client* fcclient_find_by_addr(struct fc_client* start,
-                                               const RawAddress* addr) {
-  struct fc_client* t = start;
+/* finds the listening client of a channel */
+static struct fc_client* fcclient_find_server(struct fc_channel* tc) {
+  struct fc_client* t = tc->clients;
 
-  while (t) {
-    /* match client if have addr */
-    if (addr && addr == &t->remote_addr) break;
+  while (t && !t->server) t = t->next_chan_list;
 
-    /* match server if do not have addr */
-    if (!addr && t->server) break;
+  return t;
+}
 
-    t = t->next_all_list;
-  }
+/* finds the client connected to |addr| on |chan| */
+static struct fc_client* fcclient_find_by_conn(uint16_t chan,
+                                               const RawAddress& addr) {
+  struct fc_client** p_t = fc_conns.Find({chan, addr});
 
-  return t;
+  return p_t ? *p_t : NULL;
+}
+
+/* sets the peer of a client and indexes it by channel and peer */
+static void fcclient_set_remote_addr(struct fc_client* t,
+                                     const RawAddress& addr) {
+  t->remote_addr = addr;
+  fc_conns.Insert({t->chan, addr}, t);
 }
 
 static struct fc_client* fcclient_find_by_id(uint32_t id) {
@@ -2395,6 +2463,20 @@ static void fcclient_free(struct fc_client* fc) {
     if (fc->server) tc->has_server = false;
   }
 
+  // drop it from the index, handing its entry to an older client connected
+  // to the same peer, if any
+  fc_conn_key key = {fc->chan, fc->remote_addr};
+  struct fc_client** p_indexed = fc_conns.Find(key);
+  if (p_indexed && *p_indexed == fc) {
+    fc_conns.Erase(key);
+    for (t = tc ? tc->clients : NULL; t; t = t->next_chan_list) {
+      if (!t->server && t->remote_addr == fc->remote_addr) {
+        fc_conns.Insert(key, t);
+        break;
+      }
+    }
+  }
+
   // free security id
   bta_jv_free_sec_id(&fc->sec_id);
 
@@ -2414,22 +2496,20 @@ static void fcchan_conn_chng_cbk(uint16_t chan, const RawAddress& bd_addr,
 
   tc = fcchan_get(chan, false);
   if (tc) {
-    t = fcclient_find_by_addr(
-        tc->clients,
-        &bd_addr);  // try to find an open socked for that addr
+    t = fcclient_find_by_conn(
+        chan, bd_addr);  // try to find an open socked for that addr
     if (t) {
       p_cback = t->p_cback;
       l2cap_socket_id = t->l2cap_socket_id;
     } else {
-      t = fcclient_find_by_addr(
-          tc->clients,
-          NULL);  // try to find a listening socked for that channel
+      t = fcclient_find_server(
+          tc);  // try to find a listening socked for that channel
       if (t) {
         // found: create a normal connection socket and assign the connection to
         // it
         new_conn = fcclient_alloc(chan, false, &t->sec_id);
         if (new_conn) {
-          new_conn->remote_addr = bd_addr;
+          fcclient_set_remote_addr(new_conn, bd_addr);
           new_conn->p_cback = NULL;     // for now
           new_conn->init_called = true; /*nop need to do it again */
 
@@ -2488,19 +2568,15 @@ static void fcchan_conn_chng_cbk(uint16_t chan, const RawAddress& bd_addr,
 static void fcchan_data_cbk(uint16_t chan, const RawAddress& bd_addr,
                             BT_HDR* p_buf) {
   tBTA_JV evt_data;
-  struct fc_channel* tc;
-  struct fc_client* t = NULL;
   tBTA_JV_L2CAP_CBACK* sock_cback = NULL;
   uint32_t sock_id;
 
-  tc = fcchan_get(chan, false);
-  if (tc) {
-    // try to find an open socked for that addr and channel
-    t = fcclient_find_by_addr(tc->clients, &bd_addr);
-  }
+  // try to find an open socked for that addr and channel
+  struct fc_client* t = fcclient_find_by_conn(chan, bd_addr);
 
   if (!t) {
     // no socket -> drop it
+    osi_free(p_buf);
     return;
   }
 
@@ -2539,7 +2615,7 @@ void bta_jv_l2cap_connect_le(tBTA_JV_MSG* p_data) {
 
   t->p_cback = cc->p_cback;
   t->l2cap_socket_id = cc->l2cap_socket_id;
-  t->remote_addr = cc->peer_bd_addr;
+  fcclient_set_remote_addr(t, cc->peer_bd_addr);
   id = t->id;
   t->init_called = false;
 
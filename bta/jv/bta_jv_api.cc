@@ -647,6 +647,25 @@ tBTA_JV_STATUS BTA_JvL2capRead(uint32_t handle, uint32_t req_id,
   return (status);
 }
 
+/*******************************************************************************
+ *
+ * Function         BTA_JvL2capReadBuf
+ *
+ * Description      This function takes the next received SDU of an L2CAP
+ *                  connection without copying it. The caller owns *pp_buf.
+ *
+ * Returns          BTA_JV_SUCCESS, if an SDU was returned in *pp_buf.
+ *                  BTA_JV_FAILURE, if there is none.
+ *
+ ******************************************************************************/
+tBTA_JV_STATUS BTA_JvL2capReadBuf(uint32_t handle, BT_HDR** pp_buf) {
+  if (handle < BTA_JV_MAX_L2C_CONN && bta_jv_cb.l2c_cb[handle].p_cback &&
+      GAP_ConnBTRead((uint16_t)handle, pp_buf) == BT_PASS)
+    return BTA_JV_SUCCESS;
+
+  return BTA_JV_FAILURE;
+}
+
 /*******************************************************************************
  *
  * Function         BTA_JvL2capReady
@@ -673,6 +692,30 @@ tBTA_JV_STATUS BTA_JvL2capReady(uint32_t handle, uint32_t* p_data_size) {
   return (status);
 }
 
+/*******************************************************************************
+ *
+ * Function         BTA_JvL2capFlowControl
+ *
+ * Description      This function stops or restarts the data flow from the peer
+ *                  of an L2CAP connection. It takes effect on channels in
+ *                  ERTM mode only, basic mode has no flow control.
+ *
+ * Returns          BTA_JV_SUCCESS, if the channel was flow controlled.
+ *                  BTA_JV_FAILURE, otherwise.
+ *
+ ******************************************************************************/
+tBTA_JV_STATUS BTA_JvL2capFlowControl(uint32_t handle, bool enable) {
+  APPL_TRACE_API("%s: %d enable:%d", __func__, handle, enable);
+
+  if (handle >= BTA_JV_MAX_L2C_CONN || !bta_jv_cb.l2c_cb[handle].p_cback)
+    return BTA_JV_FAILURE;
+
+  uint16_t cid = GAP_ConnGetL2CAPCid((uint16_t)handle);
+  if (cid && L2CA_FlowControl(cid, enable)) return BTA_JV_SUCCESS;
+
+  return BTA_JV_FAILURE;
+}
+
 /*******************************************************************************
  *
  * Function         BTA_JvL2capWrite
@@ -700,6 +743,34 @@ tBTA_JV_STATUS BTA_JvL2capWrite(uint32_t handle, uint32_t req_id, BT_HDR* msg,
   return BTA_JV_SUCCESS;
 }
 
+/*******************************************************************************
+ *
+ * Function         BTA_JvL2capWriteBatch
+ *
+ * Description      This function writes several SDUs to an L2CAP connection
+ *                  When the operation is complete, tBTA_JV_L2CAP_CBACK is
+ *                  called once with BTA_JV_L2CAP_WRITE_EVT. Works for
+ *                  PSM-based connections
+ *
+ * Returns          BTA_JV_SUCCESS, if the request is being processed.
+ *                  BTA_JV_FAILURE, otherwise.
+ *
+ ******************************************************************************/
+tBTA_JV_STATUS BTA_JvL2capWriteBatch(uint32_t handle, std::vector<BT_HDR*> msgs,
+                                     uint32_t user_id) {
+  APPL_TRACE_API("%s: %zu SDUs", __func__, msgs.size());
+
+  if (handle >= BTA_JV_MAX_L2C_CONN || !bta_jv_cb.l2c_cb[handle].p_cback) {
+    for (BT_HDR* msg : msgs) osi_free(msg);
+    return BTA_JV_FAILURE;
+  }
+
+  do_in_bta_thread(FROM_HERE,
+                   base::Bind(&bta_jv_l2cap_write_batch, handle, msgs,
+                              user_id, &bta_jv_cb.l2c_cb[handle]));
+  return BTA_JV_SUCCESS;
+}
+
 /*******************************************************************************
  *
  * Function         BTA_JvL2capWriteFixed
@@ -27,6 +27,7 @@
 #include "utils/include/bt_features.h"
 #include "bt_common.h"
 #include "bt_target.h"
+#include "btu.h"
 #include "osi/include/alarm.h"
 
 #include <base/logging.h>
@@ -231,6 +232,7 @@ extern void bta_sys_deregister(uint8_t id);
 extern bool bta_sys_is_register(uint8_t id);
 extern uint16_t bta_sys_get_sys_features(void);
 extern void bta_sys_sendmsg(void* p_msg);
+extern void bta_sys_sendmsg_prio(void* p_msg, tBTU_TASK_PRIO prio);
 extern void do_in_bta_thread(const base::Location& from_here,
                              const base::Closure& task);
 extern void bta_sys_start_timer(alarm_t* alarm, period_ms_t interval,
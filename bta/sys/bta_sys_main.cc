@@ -535,6 +535,22 @@ bool bta_sys_is_register(uint8_t id) { return bta_sys_cb.is_reg[id]; }
  *
  ******************************************************************************/
 void bta_sys_sendmsg(void* p_msg) {
+  /* Discovery can flood the main thread, keep it behind connection work */
+  uint8_t id = (uint8_t)(static_cast<BT_HDR*>(p_msg)->event >> 8);
+  bta_sys_sendmsg_prio(
+      p_msg, id == BTA_ID_DM_SEARCH ? BTU_TASK_PRIO_BULK : BTU_TASK_PRIO_CONN);
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_sys_sendmsg_prio
+ *
+ * Description      Send a message to BTA in the main thread lane |prio|.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void bta_sys_sendmsg_prio(void* p_msg, tBTU_TASK_PRIO prio) {
   base::MessageLoop* bta_message_loop = get_message_loop();
 
   if (!bta_message_loop || !bta_message_loop->task_runner().get()) {
@@ -542,8 +558,9 @@ void bta_sys_sendmsg(void* p_msg) {
     return;
   }
 
-  bta_message_loop->task_runner()->PostTask(
-      FROM_HERE, base::Bind(&bta_sys_event, static_cast<BT_HDR*>(p_msg)));
+  do_in_main_thread_prio(
+      prio, FROM_HERE,
+      base::Bind(&bta_sys_event, static_cast<BT_HDR*>(p_msg)));
 }
 
 /*******************************************************************************
@@ -564,7 +581,7 @@ void do_in_bta_thread(const base::Location& from_here,
     return;
   }
 
-  bta_message_loop->task_runner()->PostTask(from_here, task);
+  do_in_main_thread_prio(BTU_TASK_PRIO_CONN, from_here, task);
 }
 
 /*******************************************************************************
@@ -0,0 +1,84 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  Table driven state machine shared by the BTA modules.
+ *
+ ******************************************************************************/
+#ifndef BTA_SYS_SM_H
+#define BTA_SYS_SM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*****************************************************************************
+ *  Constants and data types
+ ****************************************************************************/
+
+/* One event of a state table: the actions to run, ended by the ignore
+ * action when there are fewer than NUM_ACTIONS, and the next state */
+template <size_t NUM_ACTIONS>
+struct tBTA_SYS_SST_ROW {
+  uint8_t action[NUM_ACTIONS];
+  uint8_t next_state;
+};
+
+/* State machine over one table per state, each with a row per event.
+ *
+ * The tables are taken as pointers to arrays of exactly NUM_EVTS rows, so a
+ * table missing a row, or a missing table, fails to build instead of being
+ * read out of bounds. Dispatch is an array lookup and the action calls; the
+ * event data is passed through untouched and never copied. */
+template <typename tCB, typename tDATA, size_t NUM_STATES, size_t NUM_EVTS,
+          size_t NUM_ACTIONS, uint8_t IGNORE>
+class tBTA_SYS_SM {
+ public:
+  typedef tBTA_SYS_SST_ROW<NUM_ACTIONS> tROW;
+  typedef tROW tTABLE[NUM_EVTS];
+  typedef void (*tACTION)(tCB* p_cb, tDATA* p_data);
+
+  constexpr explicit tBTA_SYS_SM(const tTABLE* const (&tables)[NUM_STATES])
+      : tables_(tables) {}
+
+  static constexpr bool IsValid(uint8_t state, size_t event) {
+    return state < NUM_STATES && event < NUM_EVTS;
+  }
+
+  /* Returns the state EVENT leads to from STATE */
+  uint8_t NextState(uint8_t state, size_t event) const {
+    return (*tables_[state])[event].next_state;
+  }
+
+  /* Moves *P_STATE to its next state for EVENT, then runs the actions of
+   * the transition from ACTIONS. The state is updated first so that actions
+   * see, and may override, the new state. */
+  void Execute(uint8_t* p_state, size_t event, const tACTION* actions,
+               tCB* p_cb, tDATA* p_data) const {
+    const tROW& row = (*tables_[*p_state])[event];
+    *p_state = row.next_state;
+    for (size_t i = 0; i < NUM_ACTIONS && row.action[i] != IGNORE; i++) {
+      (*actions[row.action[i]])(p_cb, p_data);
+    }
+  }
+
+ private:
+  const tTABLE* const (&tables_)[NUM_STATES];
+};
+
+#endif /* BTA_SYS_SM_H */
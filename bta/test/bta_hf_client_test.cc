@@ -26,6 +26,9 @@ class MessageLoop;
 }  // namespace base
 
 base::MessageLoop* get_message_loop() { return NULL; }
+void do_in_main_thread_prio(tBTU_TASK_PRIO prio,
+                            const base::Location& from_here,
+                            const base::Closure& task) {}
 
 namespace {
 const RawAddress bdaddr1({0x11, 0x22, 0x33, 0x44, 0x55, 0x66});
@@ -162,4 +162,37 @@ TEST(DatabaseBuilderTest, SecondaryServiceOutOfOrderTest) {
   EXPECT_EQ(result.Services()[4].is_primary, true);
 }
 
-}  // namespace gatt
\ No newline at end of file
+/* Verify that a descriptor sweep over the whole service yields the same
+ * database as exploring each characteristic on its own */
+TEST(DatabaseBuilderTest, WholeServiceDescriptorRangeTest) {
+  DatabaseBuilder builder;
+
+  builder.AddService(0x0001, 0x0009, SERVICE_1_UUID, true);
+  EXPECT_TRUE(builder.StartNextServiceExploration());
+
+  builder.AddCharacteristic(0x0002, 0x0003, SERVICE_1_CHAR_1_UUID, 0x12);
+  builder.AddCharacteristic(0x0005, 0x0006, SERVICE_1_CHAR_1_UUID, 0x12);
+
+  EXPECT_EQ(builder.NextDescriptorRangeToExplore(true),
+            make_pair_u16(0x0004, 0x0009));
+
+  // Find Information reports every handle in the range
+  builder.AddDescriptor(0x0004, SERVICE_1_CHAR_1_DESC_1_UUID);
+  builder.AddDescriptor(0x0005, Uuid::From16Bit(0x2803));
+  builder.AddDescriptor(0x0006, SERVICE_1_CHAR_1_UUID);
+  builder.AddDescriptor(0x0007, SERVICE_1_CHAR_1_DESC_1_UUID);
+
+  EXPECT_EQ(builder.NextDescriptorRangeToExplore(true),
+            make_pair_u16(0xffff, 0xffff));
+  EXPECT_FALSE(builder.StartNextServiceExploration());
+
+  Database result = builder.Build();
+  const auto& chars = result.Services()[0].characteristics;
+  ASSERT_EQ(chars.size(), 2u);
+  ASSERT_EQ(chars[0].descriptors.size(), 1u);
+  EXPECT_EQ(chars[0].descriptors[0].handle, 0x0004);
+  ASSERT_EQ(chars[1].descriptors.size(), 1u);
+  EXPECT_EQ(chars[1].descriptors[0].handle, 0x0007);
+}
+
+}  // namespace gatt
@@ -95,6 +95,62 @@ TEST(GattDatabaseTest, serialize_deserialize_binary_test) {
   EXPECT_EQ(serialized[5].value.characteristic_extended_properties, 0x0001);
 }
 
+/* This test makes sure that a database read from a flat array of stored
+ * attributes, as in a memory mapped cache file, round trips. */
+TEST(GattDatabaseTest, deserialize_from_flat_array_test) {
+  DatabaseBuilder builder;
+  builder.AddService(0x0001, 0x000f, SERVICE_1_UUID, true);
+  builder.AddService(0x0010, 0x001f, SERVICE_2_UUID, false);
+  builder.AddIncludedService(0x0002, SERVICE_2_UUID, 0x0010, 0x001f);
+  builder.AddCharacteristic(0x0003, 0x0004, SERVICE_1_CHAR_1_UUID, 0x02);
+  builder.AddDescriptor(0x0005, SERVICE_1_CHAR_1_DESC_1_UUID);
+  builder.AddDescriptor(0x0006, CHARACTERISTIC_EXTENDED_PROPERTIES);
+  builder.SetValueOfDescriptors({0x0001});
+
+  Database db = builder.Build();
+  std::vector<StoredAttribute> serialized = db.Serialize();
+
+  bool success = false;
+  Database result =
+      Database::Deserialize(serialized.data(), serialized.size(), &success);
+  EXPECT_TRUE(success);
+  EXPECT_EQ(result.Hash(), db.Hash());
+  EXPECT_EQ(result.Serialize().size(), serialized.size());
+}
+
+/* This test makes sure that handles resolve to the right characteristic or
+ * descriptor, also in a copy of the database. */
+TEST(GattDatabaseTest, find_by_handle_test) {
+  DatabaseBuilder builder;
+  builder.AddService(0x0001, 0x000f, SERVICE_1_UUID, true);
+  builder.AddCharacteristic(0x0002, 0x0003, SERVICE_1_CHAR_1_UUID, 0x02);
+  builder.AddDescriptor(0x0004, SERVICE_1_CHAR_1_DESC_1_UUID);
+  builder.AddService(0x0010, 0x001f, SERVICE_2_UUID, true);
+  builder.AddCharacteristic(0x0011, 0x0012, SERVICE_1_CHAR_1_UUID, 0x10);
+
+  Database built = builder.Build();
+  Database db = built;
+
+  const Characteristic* charac = db.FindCharacteristic(0x0012);
+  ASSERT_NE(charac, nullptr);
+  EXPECT_EQ(charac, &db.Services()[1].characteristics[0]);
+
+  const Descriptor* desc = db.FindDescriptor(0x0004);
+  ASSERT_NE(desc, nullptr);
+  EXPECT_EQ(desc, &db.Services()[0].characteristics[0].descriptors[0]);
+  EXPECT_EQ(db.FindOwningCharacteristic(0x0004),
+            &db.Services()[0].characteristics[0]);
+
+  // declarations and unknown handles do not resolve
+  EXPECT_EQ(db.FindCharacteristic(0x0002), nullptr);
+  EXPECT_EQ(db.FindCharacteristic(0x0004), nullptr);
+  EXPECT_EQ(db.FindDescriptor(0x0003), nullptr);
+  EXPECT_EQ(db.FindOwningCharacteristic(0x0020), nullptr);
+
+  db.Clear();
+  EXPECT_EQ(db.FindCharacteristic(0x0012), nullptr);
+}
+
 /* This test makes sure that Service represented in StoredAttribute have proper
  * binary format. */
 TEST(GattCacheTest, stored_attribute_to_binary_service_test) {
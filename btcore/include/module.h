@@ -19,6 +19,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "osi/include/future.h"
 #include "osi/include/thread.h"
@@ -57,6 +58,18 @@ void module_shut_down(const module_t* module);
 // If not initialized, does nothing.
 void module_clean_up(const module_t* module);
 
+// Initialize or start up the |count| modules in |modules| in parallel. Each
+// module runs on its own thread as soon as the modules it lists in
+// |dependencies| that are also in |modules| are done; the dependencies must
+// not form a cycle. Dependencies outside |modules| must already be done.
+// A module whose dependency failed is skipped. Returns true if every module
+// succeeded.
+bool module_init_parallel(const module_t* const* modules, size_t count);
+bool module_start_up_parallel(const module_t* const* modules, size_t count);
+
+// Logs how long each module took to initialize and start up.
+void module_log_startup_timing(void);
+
 // Temporary callbacked wrapper for module start up, so real modules can be
 // spliced into the current janky startup sequence. Runs on a separate thread,
 // which terminates when the module start up has finished. When module startup
@@ -22,13 +22,18 @@
 #include <dlfcn.h>
 #include <string.h>
 
+#include <inttypes.h>
+
+#include <condition_variable>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include "btcore/include/module.h"
 #include "osi/include/allocator.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/time.h"
 
 typedef enum {
   MODULE_STATE_NONE = 0,
@@ -41,17 +46,27 @@ typedef enum {
 
 static std::unordered_map<const module_t*, module_state_t> metadata;
 
+typedef struct {
+  uint64_t init_us;
+  uint64_t start_up_us;
+} module_timing_t;
+
+// Kept in the order the modules were first initialized or started
+static std::vector<std::pair<const module_t*, module_timing_t>> timing;
+
 // TODO(jamuraa): remove this lock after the startup sequence is clean
 static std::mutex metadata_mutex;
 
 static bool call_lifecycle_function(module_lifecycle_fn function);
 static module_state_t get_module_state(const module_t* module);
 static void set_module_state(const module_t* module, module_state_t state);
+static module_timing_t* get_module_timing_l(const module_t* module);
 
 void module_management_start(void) {}
 
 void module_management_stop(void) {
   metadata.clear();
+  timing.clear();
 }
 
 const module_t* get_module(const char* name) {
@@ -64,11 +79,16 @@ bool module_init(const module_t* module) {
   CHECK(module != NULL);
   CHECK(get_module_state(module) == MODULE_STATE_NONE);
 
+  uint64_t start_us = time_get_os_boottime_us();
   if (!call_lifecycle_function(module->init)) {
     LOG_ERROR(LOG_TAG, "%s Failed to initialize module \"%s\"", __func__,
               module->name);
     return false;
   }
+  {
+    std::lock_guard<std::mutex> lock(metadata_mutex);
+    get_module_timing_l(module)->init_us = time_get_os_boottime_us() - start_us;
+  }
 
   set_module_state(module, MODULE_STATE_INITIALIZED);
   return true;
@@ -86,12 +106,18 @@ bool module_start_up(const module_t* module) {
 
   LOG_INFO(LOG_TAG, "%s Starting module \"%s\"", __func__, module->name);
   set_module_state(module, MODULE_STATE_STARTING);
+  uint64_t start_us = time_get_os_boottime_us();
   if (!call_lifecycle_function(module->start_up)) {
     LOG_ERROR(LOG_TAG, "%s Failed to start up module \"%s\"", __func__,
               module->name);
     set_module_state(module, MODULE_STATE_STARTUP_ERROR);
     return false;
   }
+  {
+    std::lock_guard<std::mutex> lock(metadata_mutex);
+    get_module_timing_l(module)->start_up_us =
+        time_get_os_boottime_us() - start_us;
+  }
   LOG_INFO(LOG_TAG, "%s Started module \"%s\"", __func__, module->name);
 
   set_module_state(module, MODULE_STATE_STARTED);
@@ -139,6 +165,111 @@ void module_clean_up(const module_t* module) {
   set_module_state(module, MODULE_STATE_NONE);
 }
 
+// Parallel lifecycle steps
+
+typedef enum {
+  STEP_PENDING = 0,
+  STEP_DONE = 1,
+  STEP_FAILED = 2
+} step_state_t;
+
+typedef struct parallel_step_t parallel_step_t;
+
+typedef struct {
+  parallel_step_t* step;
+  size_t index;
+} parallel_task_t;
+
+struct parallel_step_t {
+  const module_t* const* modules;
+  size_t count;
+  bool (*fn)(const module_t* module);
+  std::mutex mutex;
+  std::condition_variable done;
+  std::vector<step_state_t> state;
+};
+
+// Returns the index of the module named |name| in the step, or |count|.
+static size_t find_in_step(const parallel_step_t* step, const char* name) {
+  for (size_t i = 0; i < step->count; i++)
+    if (!strcmp(step->modules[i]->name, name)) return i;
+  return step->count;
+}
+
+static void run_parallel_task(void* context) {
+  parallel_task_t* task = (parallel_task_t*)context;
+  parallel_step_t* step = task->step;
+  const module_t* module = step->modules[task->index];
+  bool deps_ok = true;
+
+  {
+    std::unique_lock<std::mutex> lock(step->mutex);
+    for (size_t d = 0;
+         d < BTCORE_MAX_MODULE_DEPENDENCIES && module->dependencies[d]; d++) {
+      size_t dep = find_in_step(step, module->dependencies[d]);
+      if (dep == step->count) continue;
+      step->done.wait(lock, [&] { return step->state[dep] != STEP_PENDING; });
+      if (step->state[dep] == STEP_FAILED) deps_ok = false;
+    }
+  }
+
+  if (!deps_ok)
+    LOG_ERROR(LOG_TAG, "%s skipping module \"%s\", a dependency failed",
+              __func__, module->name);
+  bool success = deps_ok && step->fn(module);
+
+  std::lock_guard<std::mutex> lock(step->mutex);
+  step->state[task->index] = success ? STEP_DONE : STEP_FAILED;
+  step->done.notify_all();
+}
+
+static bool run_parallel_step(const module_t* const* modules, size_t count,
+                              bool (*fn)(const module_t* module)) {
+  CHECK(modules != NULL);
+
+  parallel_step_t step;
+  step.modules = modules;
+  step.count = count;
+  step.fn = fn;
+  step.state.assign(count, STEP_PENDING);
+
+  std::vector<parallel_task_t> tasks(count);
+  std::vector<thread_t*> threads(count);
+  for (size_t i = 0; i < count; i++) {
+    tasks[i].step = &step;
+    tasks[i].index = i;
+    threads[i] = thread_new("module_step");
+    CHECK(threads[i] != NULL);
+    thread_post(threads[i], run_parallel_task, &tasks[i]);
+  }
+
+  // thread_free() joins the thread once its task has run
+  for (thread_t* thread : threads) thread_free(thread);
+
+  bool success = true;
+  for (step_state_t state : step.state) success &= (state == STEP_DONE);
+  return success;
+}
+
+bool module_init_parallel(const module_t* const* modules, size_t count) {
+  return run_parallel_step(modules, count, module_init);
+}
+
+bool module_start_up_parallel(const module_t* const* modules, size_t count) {
+  return run_parallel_step(modules, count, module_start_up);
+}
+
+void module_log_startup_timing(void) {
+  std::lock_guard<std::mutex> lock(metadata_mutex);
+
+  LOG_INFO(LOG_TAG, "%s module startup timing:", __func__);
+  for (const auto& entry : timing) {
+    LOG_INFO(LOG_TAG, "  %-24s init %6" PRIu64 " ms  start_up %6" PRIu64 " ms",
+             entry.first->name, entry.second.init_us / 1000,
+             entry.second.start_up_us / 1000);
+  }
+}
+
 static bool call_lifecycle_function(module_lifecycle_fn function) {
   // A NULL lifecycle function means it isn't needed, so assume success
   if (!function) return true;
@@ -164,6 +295,14 @@ static void set_module_state(const module_t* module, module_state_t state) {
   metadata[module] = state;
 }
 
+static module_timing_t* get_module_timing_l(const module_t* module) {
+  for (auto& entry : timing)
+    if (entry.first == module) return &entry.second;
+
+  timing.push_back(std::make_pair(module, module_timing_t{0, 0}));
+  return &timing.back().second;
+}
+
 // TODO(zachoverflow): remove when everything modulized
 // Temporary callback-wrapper-related code
 
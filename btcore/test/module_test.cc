@@ -0,0 +1,124 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2014 Google, Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <atomic>
+
+#include "osi/test/AllocationTestHarness.h"
+
+#include "btcore/include/module.h"
+#include "osi/include/future.h"
+#include "osi/include/osi.h"
+
+static std::atomic<int> sequence;
+static int first_done;
+static int second_done;
+static int third_done;
+
+static future_t* first_init(void) {
+  // Give the others a chance to run early if they ignored the dependency
+  usleep(20 * 1000);
+  first_done = ++sequence;
+  return NULL;
+}
+
+static future_t* second_init(void) {
+  second_done = ++sequence;
+  return NULL;
+}
+
+static future_t* third_init(void) {
+  third_done = ++sequence;
+  return NULL;
+}
+
+static future_t* failing_init(void) {
+  return future_new_immediate(FUTURE_FAIL);
+}
+
+static const module_t first_module = {.name = "first_module",
+                                      .init = first_init,
+                                      .start_up = NULL,
+                                      .shut_down = NULL,
+                                      .clean_up = NULL,
+                                      .dependencies = {NULL}};
+
+static const module_t second_module = {.name = "second_module",
+                                       .init = second_init,
+                                       .start_up = NULL,
+                                       .shut_down = NULL,
+                                       .clean_up = NULL,
+                                       .dependencies = {"first_module", NULL}};
+
+static const module_t third_module = {.name = "third_module",
+                                      .init = third_init,
+                                      .start_up = NULL,
+                                      .shut_down = NULL,
+                                      .clean_up = NULL,
+                                      .dependencies = {"second_module",
+                                                       "not_in_the_set", NULL}};
+
+static const module_t failing_module = {.name = "first_module",
+                                        .init = failing_init,
+                                        .start_up = NULL,
+                                        .shut_down = NULL,
+                                        .clean_up = NULL,
+                                        .dependencies = {NULL}};
+
+class ModuleTest : public AllocationTestHarness {
+ protected:
+  void SetUp() override {
+    AllocationTestHarness::SetUp();
+    module_management_start();
+    sequence = 0;
+    first_done = second_done = third_done = 0;
+  }
+
+  void TearDown() override {
+    module_management_stop();
+    AllocationTestHarness::TearDown();
+  }
+};
+
+TEST_F(ModuleTest, init_parallel_follows_dependencies) {
+  // Listed against the dependency order on purpose
+  const module_t* modules[] = {&third_module, &second_module, &first_module};
+
+  EXPECT_TRUE(module_init_parallel(modules, ARRAY_SIZE(modules)));
+  EXPECT_EQ(1, first_done);
+  EXPECT_EQ(2, second_done);
+  EXPECT_EQ(3, third_done);
+}
+
+TEST_F(ModuleTest, init_parallel_skips_dependents_of_failure) {
+  const module_t* modules[] = {&failing_module, &second_module, &third_module};
+
+  EXPECT_FALSE(module_init_parallel(modules, ARRAY_SIZE(modules)));
+  EXPECT_EQ(0, second_done);
+  EXPECT_EQ(0, third_done);
+}
+
+TEST_F(ModuleTest, start_up_parallel_without_start_up_functions) {
+  const module_t* modules[] = {&first_module, &second_module};
+
+  EXPECT_TRUE(module_init_parallel(modules, ARRAY_SIZE(modules)));
+  EXPECT_TRUE(module_start_up_parallel(modules, ARRAY_SIZE(modules)));
+  module_log_startup_timing();
+}
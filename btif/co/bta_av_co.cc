@@ -1017,9 +1017,13 @@ void* bta_av_co_audio_src_data_path(const uint8_t* p_codec_info,
 
 #if (BTA_AV_CO_CP_SCMS_T == TRUE)
   if (bta_av_co_cb.cp.active) {
-    p_buf->len++;
-    p_buf->offset--;
-    uint8_t* p = (uint8_t*)(p_buf + 1) + p_buf->offset;
+    uint8_t* p = AVDT_MediaBufPrepend(p_buf, AVDT_CP_HDR_SIZE);
+    if (p == NULL) {
+      APPL_TRACE_ERROR("%s: No space for CP header in packet, dropped",
+                       __func__);
+      osi_free(p_buf);
+      return NULL;
+    }
     *p = bta_av_co_cp_get_flag();
   }
 #endif
@@ -2222,6 +2226,7 @@ void bta_av_co_init(
 
   A2DP_SetOffloadStatus(a2dp_offload, a2dp_ofload_cap, isScramblingSupported,
                        is44p1kFreqSupported, offload_enabled_codecs_config);
+  A2DP_LoadCodecLibraries();
 
 /* SPLITA2DP */
   bool isMcastSupported = btif_av_is_multicast_supported();
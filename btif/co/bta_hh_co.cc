@@ -41,6 +41,7 @@
 #include "osi/include/osi.h"
 #include "osi/include/socket_utils/sockets.h"
 #include "osi/include/properties.h"
+#include "osi/include/time.h"
 
 const char* dev_path = "/dev/uhid";
 const char* hid_3d_audio_path = "/dev/socket/spatialaudio";
@@ -497,6 +498,10 @@ void bta_hh_co_open(uint8_t dev_handle, uint8_t sub_class,
         p_dev->local_vup = false;
         p_dev->fd_3d_audio = -1;
         p_dev->fd_3d_audio_connected = false;
+        p_dev->input_rpt_count = 0;
+        p_dev->input_rpt_lat_sum_us = 0;
+        p_dev->input_rpt_lat_max_us = 0;
+        memset(p_dev->input_rpt_lat_hist, 0, sizeof(p_dev->input_rpt_lat_hist));
 
         btif_hh_cb.device_num++;
         // This is a new device,open the uhid driver now.
@@ -601,6 +606,18 @@ void bta_hh_co_close(uint8_t dev_handle, uint8_t app_id) {
  *
  * Returns          void
  ******************************************************************************/
+// Wait a maximum of MAX_POLLING_ATTEMPTS x POLLING_SLEEP_DURATION in case
+// device creation is pending.
+static void bta_hh_co_wait_ready(btif_hh_device_t* p_dev) {
+  if (p_dev->fd >= 0) {
+    uint32_t polling_attempts = 0;
+    while (!p_dev->ready_for_data &&
+           polling_attempts++ < BTIF_HH_MAX_POLLING_ATTEMPTS) {
+      usleep(BTIF_HH_POLLING_SLEEP_DURATION_US);
+    }
+  }
+}
+
 void bta_hh_co_data(uint8_t dev_handle, uint8_t* p_rpt, uint16_t len,
                     tBTA_HH_PROTO_MODE mode, uint8_t sub_class,
                     uint8_t ctry_code, UNUSED_ATTR const RawAddress& peer_addr,
@@ -623,15 +640,7 @@ void bta_hh_co_data(uint8_t dev_handle, uint8_t* p_rpt, uint16_t len,
     return;
   }
 
-  // Wait a maximum of MAX_POLLING_ATTEMPTS x POLLING_SLEEP_DURATION in case
-  // device creation is pending.
-  if (p_dev->fd >= 0) {
-    uint32_t polling_attempts = 0;
-    while (!p_dev->ready_for_data &&
-           polling_attempts++ < BTIF_HH_MAX_POLLING_ATTEMPTS) {
-      usleep(BTIF_HH_POLLING_SLEEP_DURATION_US);
-    }
-  }
+  bta_hh_co_wait_ready(p_dev);
 
   // Send the HID data to the kernel.
   if ((p_dev->fd >= 0) && p_dev->ready_for_data) {
@@ -680,6 +689,121 @@ void bta_hh_co_data(uint8_t dev_handle, uint8_t* p_rpt, uint16_t len,
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_hh_co_input_latency
+ *
+ * Description      Account the latency of an input report written to uhid.
+ *
+ * Returns          void.
+ *
+ ******************************************************************************/
+static void bta_hh_co_input_latency(btif_hh_device_t* p_dev, uint64_t rx_us) {
+  uint64_t lat_us = time_get_os_boottime_us() - rx_us;
+  uint8_t bucket = 0;
+
+  p_dev->input_rpt_count++;
+  p_dev->input_rpt_lat_sum_us += lat_us;
+  if (lat_us > p_dev->input_rpt_lat_max_us)
+    p_dev->input_rpt_lat_max_us = (uint32_t)lat_us;
+
+  for (uint64_t bound = BTIF_HH_LAT_HIST_BASE_US;
+       lat_us >= bound && bucket < BTIF_HH_LAT_HIST_BUCKETS - 1; bound <<= 1)
+    bucket++;
+  p_dev->input_rpt_lat_hist[bucket]++;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_hh_co_intr_data
+ *
+ * Description      This callout function is executed by HH when an input
+ *                  report is received in the interrupt channel.
+ *
+ * Returns          void.
+ *
+ ******************************************************************************/
+void bta_hh_co_intr_data(uint8_t dev_handle, uint8_t* p_rpt, uint16_t len,
+                         tBTA_HH_PROTO_MODE mode, uint8_t sub_class,
+                         uint8_t ctry_code, const RawAddress& peer_addr,
+                         uint8_t app_id, uint64_t rx_us) {
+  bta_hh_co_data(dev_handle, p_rpt, len, mode, sub_class, ctry_code, peer_addr,
+                 app_id);
+
+  btif_hh_device_t* p_dev = btif_hh_find_connected_dev_by_handle(dev_handle);
+  if (p_dev != NULL && p_dev->fd >= 0 && p_dev->ready_for_data)
+    bta_hh_co_input_latency(p_dev, rx_us);
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_hh_co_le_input
+ *
+ * Description      This callout function is executed by HH when an input
+ *                  report notification is received from a HID over GATT
+ *                  device. The report is written straight into the uhid
+ *                  event, behind the report ID if there is one.
+ *
+ * Returns          void.
+ *
+ ******************************************************************************/
+void bta_hh_co_le_input(uint8_t dev_handle, uint8_t rpt_id, uint8_t* p_rpt,
+                        uint16_t len, tBTA_HH_PROTO_MODE mode,
+                        uint8_t ctry_code, const RawAddress& peer_addr,
+                        uint8_t app_id, uint64_t rx_us) {
+  uint16_t hdr_len = (rpt_id != 0) ? 1 : 0;
+  btif_hh_device_t* p_dev = btif_hh_find_connected_dev_by_handle(dev_handle);
+  if (p_dev == NULL) {
+    APPL_TRACE_WARNING("%s: Error: unknown HID device handle %d", __func__,
+                       dev_handle);
+    return;
+  }
+
+  if (btif_hh_cb.hid_3d_audio && (p_dev->attr_mask & HID_3D_AUDIO)) {
+    /* the 3D audio socket needs the whole report in one buffer */
+    uint8_t* p_buf = p_rpt;
+    if (hdr_len) {
+      p_buf = (uint8_t*)osi_malloc(len + hdr_len);
+      p_buf[0] = rpt_id;
+      memcpy(&p_buf[1], p_rpt, len);
+    }
+    bta_hh_co_data(dev_handle, p_buf, len + hdr_len, mode, 0, ctry_code,
+                   peer_addr, app_id);
+    if (p_buf != p_rpt) osi_free(p_buf);
+  } else {
+    bta_hh_co_wait_ready(p_dev);
+
+    if ((p_dev->fd < 0) || !p_dev->ready_for_data) {
+      APPL_TRACE_WARNING("%s: Error: fd = %d, ready %d, len = %d", __func__,
+                         p_dev->fd, p_dev->ready_for_data, len);
+      return;
+    }
+
+    struct uhid_event ev;
+    if (len + hdr_len > sizeof(ev.u.input.data)) {
+      APPL_TRACE_WARNING("%s: Report size greater than allowed size",
+                         __func__);
+      return;
+    }
+    /* uhid takes events shorter than struct uhid_event and zero fills the
+     * rest, so only the used part of the event is set and written */
+    ev.type = UHID_INPUT;
+    ev.u.input.size = len + hdr_len;
+    if (hdr_len) ev.u.input.data[0] = rpt_id;
+    memcpy(&ev.u.input.data[hdr_len], p_rpt, len);
+
+    size_t ev_len = sizeof(ev.type) + sizeof(ev.u.input.size) + len + hdr_len;
+    ssize_t ret;
+    OSI_NO_INTR(ret = write(p_dev->fd, &ev, ev_len));
+    if (ret != (ssize_t)ev_len) {
+      APPL_TRACE_ERROR("%s: Cannot write to uhid: %zd != %zu (%s)", __func__,
+                       ret, ev_len, strerror(errno));
+    }
+  }
+
+  bta_hh_co_input_latency(p_dev, rx_us);
+}
+
 /*******************************************************************************
  *
  * Function         bta_hh_co_send_hid_info
@@ -965,4 +1089,90 @@ void bta_hh_le_co_reset_rpt_cache(const RawAddress& remote_bda,
   BTIF_TRACE_DEBUG("%s() - Reset cache for bda %s", __func__, bdstr);
 }
 
+/*******************************************************************************
+ *
+ * Function         bta_hh_le_co_hogp_cache_save
+ *
+ * Description      This callout function is to save the HOGP cache of a
+ *                  bonded device: the HID service handles, the report table
+ *                  and the report map, serialized by HH.
+ *
+ * Parameters       remote_bda  - remote device address
+ *                  p_data      - serialized cache
+ *                  len         - length of the serialized cache
+ *                  app_id      - application id
+ *
+ * Returns          void.
+ *
+ ******************************************************************************/
+void bta_hh_le_co_hogp_cache_save(const RawAddress& remote_bda,
+                                  const uint8_t* p_data, uint16_t len,
+                                  UNUSED_ATTR uint8_t app_id) {
+  std::string addrstr = remote_bda.ToString();
+  const char* bdstr = addrstr.c_str();
+
+  btif_config_set_bin(bdstr, "HidHogpCache", p_data, len);
+  btif_config_save();
+
+  BTIF_TRACE_DEBUG("%s() - Saved %d bytes; dev=%s", __func__, len, bdstr);
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_hh_le_co_hogp_cache_load
+ *
+ * Description      This callout function is to load the HOGP cache saved by
+ *                  bta_hh_le_co_hogp_cache_save().
+ *
+ * Parameters       remote_bda  - remote device address
+ *                  p_len       - length of the returned cache
+ *                  app_id      - application id
+ *
+ * Returns          the serialized cache, to be freed with osi_free(), or NULL
+ *                  if there is none.
+ *
+ ******************************************************************************/
+uint8_t* bta_hh_le_co_hogp_cache_load(const RawAddress& remote_bda,
+                                      uint16_t* p_len,
+                                      UNUSED_ATTR uint8_t app_id) {
+  std::string addrstr = remote_bda.ToString();
+  const char* bdstr = addrstr.c_str();
+
+  size_t len = btif_config_get_bin_length(bdstr, "HidHogpCache");
+  if (!p_len || len == 0 || len > UINT16_MAX) return NULL;
+
+  uint8_t* p_data = (uint8_t*)osi_malloc(len);
+  if (!btif_config_get_bin(bdstr, "HidHogpCache", p_data, &len)) {
+    osi_free(p_data);
+    return NULL;
+  }
+  *p_len = (uint16_t)len;
+
+  BTIF_TRACE_DEBUG("%s() - Loaded %d bytes; dev=%s", __func__, *p_len, bdstr);
+
+  return p_data;
+}
+
+/*******************************************************************************
+ *
+ * Function         bta_hh_le_co_hogp_cache_reset
+ *
+ * Description      This callout function is to remove the HOGP cache of a
+ *                  device.
+ *
+ * Parameters       remote_bda  - remote device address
+ *
+ * Returns          none
+ *
+ ******************************************************************************/
+void bta_hh_le_co_hogp_cache_reset(const RawAddress& remote_bda,
+                                   UNUSED_ATTR uint8_t app_id) {
+  std::string addrstr = remote_bda.ToString();
+  const char* bdstr = addrstr.c_str();
+
+  if (btif_config_remove(bdstr, "HidHogpCache")) btif_config_save();
+
+  BTIF_TRACE_DEBUG("%s() - Reset HOGP cache for bda %s", __func__, bdstr);
+}
+
 #endif  // (BTA_HH_LE_INCLUDED == TRUE)
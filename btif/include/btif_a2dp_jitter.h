@@ -0,0 +1,75 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#ifndef BTIF_A2DP_JITTER_H
+#define BTIF_A2DP_JITTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Adaptive jitter buffer of the A2DP sink. Media packets are kept ordered by
+// RTP timestamp, and late or duplicate packets are dropped. Playout starts
+// once the buffered audio reaches a target depth that follows the measured
+// arrival jitter, and grows after each underrun. The drift between the clock
+// of the remote source and the local playout clock is compensated by
+// resampling the decoded audio by a few hundred ppm. The jitter buffer is
+// enabled with the persist.vendor.bt.a2dp.sink_jitter_buffer property.
+
+// Reads the configuration and drops all state. |clock_rate| is the RTP clock
+// rate of the stream in Hz. It should be called when the decoder is
+// configured. Buffered packets must have been flushed before.
+void btif_a2dp_jitter_init(uint32_t clock_rate);
+
+// Returns true if the jitter buffer is enabled.
+bool btif_a2dp_jitter_is_enabled(void);
+
+// Adds the media packet |p_pkt| with RTP |time_stamp| and sequence number
+// |seq|. |duration_us| is the audio duration of the packet and |now_us| the
+// arrival time. Returns the packet the caller must free: |p_pkt| itself when
+// it is late or a duplicate, the oldest packet when the buffer is full, or
+// NULL.
+void* btif_a2dp_jitter_put(void* p_pkt, uint32_t time_stamp, uint16_t seq,
+                           uint64_t duration_us, uint64_t now_us);
+
+// Returns the next packet to play in timestamp order, or NULL while the
+// buffer fills up to the target depth. The caller owns the packet.
+void* btif_a2dp_jitter_get(void);
+
+// Returns true once playout has started.
+bool btif_a2dp_jitter_is_playing(void);
+
+// Frees all buffered packets with |free_cb| and waits for the target depth
+// again before playout.
+void btif_a2dp_jitter_flush(void (*free_cb)(void*));
+
+// Reports that |level_us| of audio waits in the output of the sink, which
+// fills up to |target_us| before playing. The output level counts towards
+// the depth the clock drift correction keeps at target.
+void btif_a2dp_jitter_set_output_level(uint64_t level_us, uint64_t target_us);
+
+// Resamples |in_frames| frames of 16-bit PCM with |channels| channels from
+// |p_in| into |p_out| to compensate the clock drift. At most |out_frames|
+// frames are written. Returns the number of frames written.
+size_t btif_a2dp_jitter_resample(const int16_t* p_in, size_t in_frames,
+                                 uint8_t channels, int16_t* p_out,
+                                 size_t out_frames);
+
+// Dump the jitter buffer statistics to |fd|.
+void btif_a2dp_jitter_debug_dump(int fd);
+
+#endif /* BTIF_A2DP_JITTER_H */
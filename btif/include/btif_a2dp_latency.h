@@ -0,0 +1,61 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#ifndef BTIF_A2DP_LATENCY_H
+#define BTIF_A2DP_LATENCY_H
+
+#include <stdint.h>
+
+// Accounting of the delay audio sees on its way from the audio HAL to the
+// speaker of an A2DP sink. Each stage of the source pipeline keeps a running
+// estimate that is folded into the delay reported to the audio HAL together
+// with the AVDTP delay report of the remote device, so that presentation
+// positions match what is actually heard. The accounting is enabled with the
+// persist.vendor.bt.a2dp.latency_accounting property.
+
+typedef enum {
+  BTIF_A2DP_LATENCY_PCM,        // PCM waiting in the audio HAL ring buffer
+  BTIF_A2DP_LATENCY_ENCODER,    // Encoding one media task run
+  BTIF_A2DP_LATENCY_TX_QUEUE,   // Packets ahead in the TX queue
+  BTIF_A2DP_LATENCY_CONTROLLER, // Waiting in the controller for the air
+  BTIF_A2DP_LATENCY_REMOTE,     // AVDTP delay report of the remote device
+  BTIF_A2DP_LATENCY_NUM_STAGES
+} tBTIF_A2DP_LATENCY_STAGE;
+
+// Reads the configuration and clears all estimates. It should be called when
+// a stream starts.
+void btif_a2dp_latency_reset(void);
+
+// Adds the sample |delay_us| to the running estimate of |stage|. Each stage
+// must be updated from a single thread. It does nothing while the accounting
+// is disabled.
+void btif_a2dp_latency_update(tBTIF_A2DP_LATENCY_STAGE stage,
+                              uint64_t delay_us);
+
+// Returns the current estimate of |stage| in microseconds.
+uint64_t btif_a2dp_latency_get_us(tBTIF_A2DP_LATENCY_STAGE stage);
+
+// Returns the delay to report to the audio HAL in 1/10 ms, given the AVDTP
+// delay report |remote_delay| of the remote device in 1/10 ms. While the
+// accounting is disabled |remote_delay| is returned unchanged.
+uint16_t btif_a2dp_latency_get_presentation_delay(uint16_t remote_delay);
+
+// Dump the latency estimates to |fd|.
+void btif_a2dp_latency_debug_dump(int fd);
+
+#endif /* BTIF_A2DP_LATENCY_H */
@@ -0,0 +1,70 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#ifndef BTIF_A2DP_LINK_ADAPT_H
+#define BTIF_A2DP_LINK_ADAPT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "osi/include/time.h"
+#include "raw_address.h"
+
+// Closed-loop adaptation of the ACL link of an A2DP source stream. While
+// audio is streamed the link quality is sampled periodically from RSSI, the
+// Failed Contact Counter and the TX queue. When the link falls behind, the
+// automatic flush timeout is shortened so stale packets are flushed by the
+// baseband instead of piling up in the TX queue, 3 Mb/s EDR packet types are
+// avoided and the encoder is pushed towards a lower bitrate. The link is
+// restored step by step once it keeps up again. The feature is enabled with
+// the persist.vendor.bt.a2dp_link_adapt property.
+//
+// The same samples size the TX queue limit of the source when the
+// persist.vendor.bt.a2dp_queue_adapt property is set. The limit shrinks while
+// the link keeps up so that packets wait less before they are sent, and grows
+// back on flushes, dropouts and failed contacts. It applies to every codec;
+// adaptive bitrate encoders see the queue length scaled to the limit.
+
+// Starts adapting the link to |peer_address|. |encoder_interval_ms| is the
+// interval at which the encoder produces packets. It may be called from any
+// thread.
+void btif_a2dp_link_adapt_start(const RawAddress& peer_address,
+                                period_ms_t encoder_interval_ms);
+
+// Stops adapting and restores the flush timeout and packet types of the link.
+// It may be called from any thread.
+void btif_a2dp_link_adapt_stop(void);
+
+// Reports that encoded packets were dropped because the TX queue overflowed.
+void btif_a2dp_link_adapt_on_tx_dropout(void);
+
+// Returns the TX queue length to report to the encoder for the current queue
+// length |transmit_queue_length|. A degraded link is reported as a longer
+// queue so that an adaptive bitrate encoder steps down before packets are
+// dropped.
+size_t btif_a2dp_link_adapt_get_queue_length(size_t transmit_queue_length);
+
+// Returns the TX queue limit to use for the configured limit |max_limit|. The
+// limit always leaves room for |frames_n| more entries on top of a few
+// packets. Without queue adaptation |max_limit| is returned.
+size_t btif_a2dp_link_adapt_get_queue_limit(size_t max_limit, size_t frames_n);
+
+// Dump the link adaptation state to |fd|.
+void btif_a2dp_link_adapt_debug_dump(int fd);
+
+#endif /* BTIF_A2DP_LINK_ADAPT_H */
@@ -124,6 +124,19 @@ typedef struct {
   size_t media_read_total_underflow_bytes;
   size_t media_read_total_underflow_count;
   uint64_t media_read_last_underflow_us;
+
+  // Encodes deferred by the event driven scheduler, waiting for the link to
+  // drain the TX queue or for the audio HAL to deliver a full packet of PCM
+  size_t sched_credit_waits;
+  size_t sched_pcm_waits;
+
+  // Time spent in the encoder per media task run, and the headroom left to
+  // the encoder interval (in us). Overruns are runs longer than the interval.
+  size_t encode_count;
+  uint64_t encode_total_us;
+  uint64_t encode_max_us;
+  uint64_t encode_min_headroom_us;
+  size_t encode_overruns;
 } btif_media_stats_t;
 
 typedef struct {
@@ -136,6 +149,12 @@ typedef struct {
   alarm_t *remote_start_alarm;
   const tA2DP_ENCODER_INTERFACE* encoder_interface;
   period_ms_t encoder_interval_ms; /* Local copy of the encoder interval */
+  bool event_sched;        /* encode on PCM and link room, not a fixed tick */
+  bool media_running;      /* media task started in event driven mode */
+  uint32_t pcm_bytes_per_sec; /* PCM feeding rate for the event scheduler */
+  uint64_t last_encode_us; /* time of the last encode in event driven mode */
+  bool rt_handoff; /* tx_audio_queue is a lock-free single producer queue */
+  int encoder_cpu; /* CPU the media worker is pinned to, -1 if not pinned */
   btif_media_stats_t stats;
   btif_media_stats_t accumulated_stats;
   int last_remote_started_index;
@@ -477,6 +477,16 @@ bool btif_av_is_44p1kFreq_supported();
 ********************************************************************************/
 void btif_av_peer_config_dump();
 
+/******************************************************************************
+**
+** Function         btif_av_debug_dump
+**
+** Description      Dumps the state and event count of each AV peer to fd
+**
+** Returns          void
+********************************************************************************/
+void btif_av_debug_dump(int fd);
+
 /******************************************************************************
 **
 ** Function         btif_av_get_current_playing_dev_idx()
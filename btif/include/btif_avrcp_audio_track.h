@@ -26,6 +26,8 @@
  * volume control we should deprecate this file.
  */
 
+#include <stdint.h>
+
 /**
  * Creates an audio track object and returns a void handle. Use this handle to
  * the
@@ -69,6 +71,21 @@ void BtifAvrcpAudioTrackDelete(void* handle);
  * Writes the audio track data to file.
  *
  * Used only for debugging.
+ *
+ * In ring output mode the data is copied into the ring and the call never
+ * blocks; audio that does not fit is dropped.
  */
 int BtifAvrcpAudioTrackWriteData(void* handle, void* audioBuffer,
                                  int bufferLength);
+
+/**
+ * Gets the amount of audio waiting in the output ring and the level the
+ * ring fills up to before playback starts, both in microseconds.
+ *
+ * Returns false if the track does not use ring output. Ring output is enabled
+ * with the persist.vendor.bt.a2dp.sink_ring_output property: the track is
+ * then fed from a preallocated lock-free ring by the audio data callback on
+ * its own thread.
+ */
+bool BtifAvrcpAudioTrackGetRingLevel(void* handle, uint64_t* p_level_us,
+                                     uint64_t* p_target_us);
@@ -17,6 +17,7 @@
 #ifndef BTIF_BQR_H_
 #define BTIF_BQR_H_
 
+#include "btif_bqr_stats.h"
 #include "btm_api_types.h"
 #include "osi/include/leaky_bonded_queue.h"
 
@@ -311,6 +312,22 @@ void BqrVscCompleteCallback(tBTM_VSC_CMPL* p_vsc_cmpl_params);
 //   the Bluetooth controller via Vendor Specific Event.
 void AddBqrEventToQueue(uint8_t length, uint8_t* p_stream);
 
+// Get the link quality of a remote device, aggregated from the quality reports
+// received over the last |window_ms|. The fine statistics are used for up to
+// an hour, older ones only have an hourly resolution.
+//
+// @param bda The address of the remote device.
+// @param codec The btav_a2dp_codec_index_t the link was streaming, or
+//   kLinkStatsCodecNone / kLinkStatsCodecAny.
+// @param window_ms How far back to look, at most a day is kept.
+// @param summary Filled with the statistics of the window.
+// @return True if there were reports from the remote device in the window.
+bool GetLinkQualitySummary(const RawAddress& bda, int16_t codec,
+                           uint64_t window_ms, LinkQualityBucket* summary);
+
+// Log the link quality of the completed hours to the metrics.
+void ExportLinkQualityMetrics();
+
 // Parse the different type of Vendor Specific BQR RIE parameter.
 //
 // @param param_id Type of Vendor Specific BQR RIE parameter.
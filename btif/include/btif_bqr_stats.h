@@ -0,0 +1,168 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BTIF_BQR_STATS_H_
+#define BTIF_BQR_STATS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "raw_address.h"
+
+namespace bluetooth {
+namespace bqr {
+
+// Link quality statistics aggregated from Bluetooth Quality Reports.
+//
+// Every report is added to a per link time bucket instead of being kept. Each
+// link has a ring of fine buckets covering the last hour and a ring of coarse
+// buckets covering the last day, so older data is only kept at the coarse
+// resolution. The number of links is bounded too: the link updated least
+// recently makes room for a new one. Memory use is fixed.
+//
+// A link is a remote device together with the A2DP codec it streamed when the
+// report was received, so the quality of different codecs can be compared.
+//
+// Coarse buckets are handed to the export callback once they are complete, or
+// when their link is evicted.
+
+// Fine buckets: the last hour in 5 minute steps.
+static constexpr uint64_t kLinkStatsFineBucketMs = 5 * 60 * 1000;
+static constexpr size_t kLinkStatsFineBuckets = 12;
+// Coarse buckets: the last day in 1 hour steps.
+static constexpr uint64_t kLinkStatsCoarseBucketMs = 60 * 60 * 1000;
+static constexpr size_t kLinkStatsCoarseBuckets = 24;
+// Number of links tracked at the same time.
+static constexpr size_t kLinkStatsMaxLinks = 8;
+
+// Codec of a link that wasn't streaming A2DP.
+static constexpr int16_t kLinkStatsCodecNone = -1;
+// Matches every codec in queries.
+static constexpr int16_t kLinkStatsCodecAny = -2;
+
+// The values of one quality report that are aggregated. The counts are the
+// ones since the previous report.
+struct LinkQualitySample {
+  uint8_t quality_report_id = 0;
+  int8_t rssi = 0;
+  uint8_t snr = 0;
+  uint32_t retransmission_count = 0;
+  uint32_t no_rx_count = 0;
+  uint32_t nak_count = 0;
+  uint32_t flow_off_count = 0;
+  uint32_t buffer_overflow_bytes = 0;
+  uint32_t buffer_underflow_bytes = 0;
+};
+
+// Statistics of the reports received in one time bucket.
+struct LinkQualityBucket {
+  // Start of the bucket, in the clock passed to |LinkQualityStats|.
+  uint64_t start_ms = 0;
+  uint64_t duration_ms = 0;
+
+  uint32_t report_count = 0;
+  uint32_t approach_lsto_count = 0;
+  uint32_t a2dp_choppy_count = 0;
+  uint32_t sco_choppy_count = 0;
+
+  int64_t rssi_sum = 0;
+  int8_t rssi_min = 0;
+  int8_t rssi_max = 0;
+  uint64_t snr_sum = 0;
+  uint8_t snr_min = 0;
+
+  uint64_t retransmission_count = 0;
+  uint64_t no_rx_count = 0;
+  uint64_t nak_count = 0;
+  uint64_t flow_off_count = 0;
+  uint64_t buffer_overflow_bytes = 0;
+  uint64_t buffer_underflow_bytes = 0;
+
+  bool Empty() const { return report_count == 0; }
+  int8_t AverageRssi() const;
+  uint8_t AverageSnr() const;
+
+  void Add(const LinkQualitySample& sample);
+  // Adds the reports of |other|. The time range becomes the one covering
+  // both buckets.
+  void Merge(const LinkQualityBucket& other);
+};
+
+class LinkQualityStats {
+ public:
+  // Called without the internal lock held, so it may call back into the
+  // object.
+  using ExportCallback = std::function<void(
+      const RawAddress& bda, int16_t codec, const LinkQualityBucket& bucket)>;
+
+  explicit LinkQualityStats(ExportCallback export_callback);
+
+  // Adds a report of the link to |bda| using |codec| received at |now_ms|.
+  void AddSample(const RawAddress& bda, int16_t codec,
+                 const LinkQualitySample& sample, uint64_t now_ms);
+
+  // Exports the coarse buckets that are complete at |now_ms| and weren't
+  // exported yet.
+  void ExportCompleted(uint64_t now_ms);
+
+  // Merges the reports of |bda| received in [|since_ms|, |now_ms|] into
+  // |summary|, using the fine buckets when they cover the range. |codec| may
+  // be |kLinkStatsCodecAny|. Returns false if there were no reports.
+  bool GetSummary(const RawAddress& bda, int16_t codec, uint64_t since_ms,
+                  uint64_t now_ms, LinkQualityBucket* summary) const;
+
+  // Drops all statistics without exporting them.
+  void Clear();
+
+  // Dumps the last hour of every link to |fd|.
+  void Dump(int fd, uint64_t now_ms) const;
+
+ private:
+  struct Link {
+    bool in_use = false;
+    RawAddress bda;
+    int16_t codec = kLinkStatsCodecNone;
+    uint64_t last_update_ms = 0;
+    LinkQualityBucket fine[kLinkStatsFineBuckets];
+    LinkQualityBucket coarse[kLinkStatsCoarseBuckets];
+    bool coarse_exported[kLinkStatsCoarseBuckets] = {};
+  };
+
+  struct PendingExport {
+    RawAddress bda;
+    int16_t codec;
+    LinkQualityBucket bucket;
+  };
+
+  Link* FindOrAddLinkLocked(const RawAddress& bda, int16_t codec,
+                            std::vector<PendingExport>* exports);
+  static void CollectExportsLocked(Link* link, uint64_t now_ms, bool all,
+                                   std::vector<PendingExport>* exports);
+  void RunExports(const std::vector<PendingExport>& exports) const;
+
+  ExportCallback export_callback_;
+  mutable std::mutex lock_;
+  Link links_[kLinkStatsMaxLinks];
+};
+
+}  // namespace bqr
+}  // namespace bluetooth
+
+#endif  // BTIF_BQR_STATS_H_
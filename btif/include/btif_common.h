@@ -154,6 +154,12 @@ enum {
 
 typedef void(tBTIF_CBACK)(uint16_t event, char* p_param);
 typedef void(tBTIF_COPY_CBACK)(uint16_t event, char* p_dest, char* p_src);
+/* Runs an inline JNI task if |run|, and releases what its payload owns */
+typedef void(tBTIF_INLINE_CBACK)(void* p_payload, bool run);
+
+/* Payload bytes of a task that is posted to the JNI thread without
+ * allocation */
+#define BTIF_JNI_INLINE_PAYLOAD_SIZE 256
 
 /*******************************************************************************
  *  Type definitions and return values
@@ -177,6 +183,11 @@ typedef struct {
 extern bt_status_t do_in_jni_thread(const base::Closure& task);
 extern bt_status_t do_in_jni_thread(const base::Location& from_here,
                                     const base::Closure& task);
+/* Copy |len| bytes of |p_payload| into a preallocated slot and run
+ * |p_cback| with it in the JNI thread. Returns false if the task was not
+ * queued, the caller then posts it with do_in_jni_thread(). */
+extern bool do_in_jni_thread_inline(tBTIF_INLINE_CBACK* p_cback,
+                                    const void* p_payload, size_t len);
 /**
  * This template wraps callback into callback that will be executed on jni
  * thread
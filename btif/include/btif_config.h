@@ -37,6 +37,7 @@
 
 #define A2DP_VERSION_CONFIG_KEY "A2dpVersion"
 #define AVDTP_VERSION_CONFIG_KEY "AvdtpVersion"
+#define AVDTP_SEP_CACHE_CONFIG_KEY "AvdtpSepCache"
 #define HFP_VERSION_CONFIG_KEY "HfpVersion"
 #define AV_REM_CTRL_VERSION_CONFIG_KEY "AvrcpCtVersion"
 #define AV_REM_CTRL_TG_VERSION_CONFIG_KEY "AvrcpTgVersion"
@@ -75,6 +76,9 @@ bool btif_config_set_uint64(const char* section, const char* key,
 bool btif_config_set_bin(const std::string& section, const std::string& key,
                          const uint8_t* value, size_t length);
 bool btif_config_remove(const std::string& section, const std::string& key);
+// Decrypts all keys kept in the keystore with a single request, so that the
+// reads after it are served from the cache.
+void btif_config_prefetch_encrypted_keys(void);
 
 size_t btif_config_get_bin_length(const std::string& section, const std::string& key);
 
@@ -82,6 +86,12 @@ std::vector<RawAddress> btif_config_get_paired_devices();
 
 void btif_config_save(void);
 void btif_config_flush(void);
+// Schedules the write of bond keys and metadata. The changes made within the
+// bond commit period share one write.
+void btif_config_save_bond(void);
+// With strict bond durability, writes the pending bond data out now. Called
+// before a bond is reported.
+void btif_config_sync_bond(void);
 bool btif_config_clear(void);
 
 // TODO(zachoverflow): Eww...we need to move these out. These are peer specific,
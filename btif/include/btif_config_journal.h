@@ -0,0 +1,49 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "osi/include/config.h"
+
+// Append-only journal of the changes made to the persistent config since it
+// was last written out in full. The records are absolute (set a key, remove a
+// key, remove a section), so replaying a journal twice gives the same config.
+// Each record carries its own checksum; a torn record at the end of the file,
+// left by a crash during an append, ends the replay.
+//
+// A journal belongs to the config file of the same |generation|. It is not
+// replayed on top of any other file, e.g. the backup.
+
+// Starts an empty journal at |path| for the config file of |generation|,
+// replacing any previous one. Returns false on I/O error.
+bool btif_config_journal_reset(const char* path, uint64_t generation);
+
+// Appends the records turning |from| into |to| to the journal at |path| and
+// syncs it. |size| is set to the resulting journal size in bytes. Returns
+// false on I/O error, or if there is no journal at |path|.
+bool btif_config_journal_append(const char* path, const config_t& from,
+                                const config_t& to, size_t* size);
+
+// Applies the journal at |path| to |config| if it belongs to |generation|.
+// Returns the number of records applied, or -1 if there is no journal for
+// |generation|.
+int btif_config_journal_replay(const char* path, uint64_t generation,
+                               config_t* config);
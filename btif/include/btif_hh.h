@@ -50,6 +50,9 @@
 #define BTIF_HH_MAX_POLLING_ATTEMPTS 10
 #define BTIF_HH_POLLING_SLEEP_DURATION_US 5000
 
+#define BTIF_HH_LAT_HIST_BUCKETS 8
+#define BTIF_HH_LAT_HIST_BASE_US 125
+
 /*******************************************************************************
  *  Type definitions and return values
  ******************************************************************************/
@@ -89,6 +92,13 @@ typedef struct {
 #endif               //OFF_TARGET_TEST_ENABLED
   bool local_vup;  // Indicated locally initiated VUP
   uint8_t last_output_rpt_data[UHID_DATA_MAX];
+  // Input report latency, from notification or interrupt channel receive to
+  // uhid write. Histogram bucket 0 is below BTIF_HH_LAT_HIST_BASE_US, each
+  // next bucket doubles the bound, the last one is open ended.
+  uint32_t input_rpt_count;
+  uint64_t input_rpt_lat_sum_us;
+  uint32_t input_rpt_lat_max_us;
+  uint32_t input_rpt_lat_hist[BTIF_HH_LAT_HIST_BUCKETS];
 } btif_hh_device_t;
 
 /* Control block to maintain properties of devices */
@@ -124,6 +134,7 @@ extern bool btif_hh_add_added_dev(const RawAddress& bda,
                                   tBTA_HH_ATTR_MASK attr_mask);
 extern bt_status_t btif_hh_virtual_unplug(const RawAddress* bd_addr);
 extern void btif_hh_disconnect(RawAddress* bd_addr);
+extern void btif_debug_hh_dump(int fd);
 extern void btif_hh_service_registration(bool enable);
 extern void btif_hh_setreport(btif_hh_device_t* p_dev,
                               bthh_report_type_t r_type, uint16_t size,
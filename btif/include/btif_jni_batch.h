@@ -0,0 +1,122 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <base/bind.h>
+#include <stdint.h>
+#include <vector>
+
+#include "btif_common.h"
+#include "osi/include/alarm.h"
+#include "osi/include/properties.h"
+#include "osi/include/time.h"
+
+// Optional batching of high rate upcalls on the JNI thread. Events given to
+// |Add| are held until |max_events| of them are pending, or the oldest one is
+// |max_delay_us| old, and are then handed to the flush callback together. The
+// limits come from two system properties which are read on first use;
+// batching is off while |max_events| is below two.
+//
+// All methods except the construction must be called on the JNI thread. The
+// instances are expected to live as long as the process.
+template <typename T>
+class BtifJniBatch {
+ public:
+  using FlushCallback = void (*)(std::vector<T>* events);
+
+  BtifJniBatch(const char* name, const char* max_events_property,
+               const char* max_delay_property, FlushCallback flush)
+      : name_(name),
+        max_events_property_(max_events_property),
+        max_delay_property_(max_delay_property),
+        flush_(flush) {}
+
+  // Returns true if events should be given to |Add| rather than delivered
+  // one by one.
+  bool IsEnabled() {
+    if (!configured_) {
+      configured_ = true;
+      max_events_ = osi_property_get_int32(max_events_property_, 0);
+      max_delay_us_ = osi_property_get_int32(max_delay_property_, 5000);
+      if (max_events_ < 2) max_events_ = 0;
+      if (max_delay_us_ < 0) max_delay_us_ = 0;
+    }
+    return max_events_ != 0;
+  }
+
+  // Adds |event| to the pending batch, and flushes it when it is full.
+  void Add(T event) {
+    pending_.push_back(std::move(event));
+    if (pending_.size() >= (size_t)max_events_) {
+      Flush();
+      return;
+    }
+    if (pending_.size() > 1) return;
+
+    first_event_us_ = time_get_os_boottime_us();
+    if (alarm_ == nullptr) alarm_ = alarm_new(name_);
+    period_ms_t delay_ms = (max_delay_us_ + 999) / 1000;
+    alarm_set(alarm_, delay_ms, &BtifJniBatch::OnTimeout, this);
+  }
+
+  // Delivers the pending events, if any. Call it before any upcall that
+  // must not overtake them.
+  void Flush() {
+    if (pending_.empty()) return;
+    if (alarm_ != nullptr) alarm_cancel(alarm_);
+
+    std::vector<T> events;
+    events.swap(pending_);
+    flush_(&events);
+  }
+
+  // Drops the pending events.
+  void Clear() {
+    if (alarm_ != nullptr) alarm_cancel(alarm_);
+    pending_.clear();
+  }
+
+ private:
+  // The alarm fires on the alarm thread, while the batch belongs to the JNI
+  // thread. A timeout posted before the batch was flushed may arrive after
+  // the next batch was started, and is ignored unless that one is due too.
+  static void OnTimeout(void* data) {
+    BtifJniBatch* batch = static_cast<BtifJniBatch*>(data);
+    do_in_jni_thread(
+        base::Bind(&BtifJniBatch::FlushIfDue, base::Unretained(batch)));
+  }
+
+  void FlushIfDue() {
+    if (pending_.empty()) return;
+    if (time_get_os_boottime_us() - first_event_us_ < (uint64_t)max_delay_us_)
+      return;
+    Flush();
+  }
+
+  const char* name_;
+  const char* max_events_property_;
+  const char* max_delay_property_;
+  FlushCallback flush_;
+  bool configured_ = false;
+  int32_t max_events_ = 0;
+  int32_t max_delay_us_ = 0;
+  uint64_t first_event_us_ = 0;
+  alarm_t* alarm_ = nullptr;
+  std::vector<T> pending_;
+};
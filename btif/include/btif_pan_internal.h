@@ -79,8 +79,10 @@ typedef struct {
   int open_count;
   int flow;  // 1: outbound data flow on; 0: outbound data flow off
   btpan_conn_t conns[MAX_PAN_CONNS];
-  int congest_packet_size;
-  unsigned char congest_packet[1600];  // max ethernet packet size
+  // Frame read from the TAP driver that BNEP had no room for yet. The
+  // payload sits in a buffer ready for BNEP, the header is kept apart.
+  BT_HDR* congest_buf;
+  tETH_HDR congest_hdr;
 } btpan_cb_t;
 
 /*******************************************************************************
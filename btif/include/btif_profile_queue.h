@@ -38,6 +38,7 @@ void btif_queue_advance();
 void btif_queue_advance_by_uuid(uint16_t uuid, const RawAddress* bda);
 bt_status_t btif_queue_connect_next(void);
 void btif_queue_release();
+void btif_queue_debug_dump(int fd);
 
 
 typedef bt_status_t (*btif_disconnect_cb_t)(RawAddress* bda, uint16_t uuid);
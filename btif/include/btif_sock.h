@@ -26,3 +26,4 @@ btsock_interface_t* btif_sock_get_interface(void);
 
 bt_status_t btif_sock_init(uid_set_t* uid_set);
 void btif_sock_cleanup(void);
+void btif_sock_debug_dump(int fd);
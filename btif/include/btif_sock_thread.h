@@ -53,6 +53,11 @@ int btsock_thread_post_cmd(int handle, int cmd_type,
                            uint32_t user_id);
 int btsock_thread_create(btsock_signaled_cb callback,
                          btsock_cmd_cb cmd_callback);
+/* Creates |thread_count| socket threads behind a single handle. The fds given
+ * to the handle are spread over the threads by fd number, so |callback| may
+ * run on several threads at once. */
+int btsock_thread_create_sharded(btsock_signaled_cb callback,
+                                 btsock_cmd_cb cmd_callback, int thread_count);
 int btsock_thread_exit(int handle);
 
 #endif
@@ -198,6 +198,19 @@ bt_status_t btif_storage_add_bonded_device(RawAddress* remote_bd_addr,
  ******************************************************************************/
 bt_status_t btif_storage_remove_bonded_device(const RawAddress* remote_bd_addr);
 
+/*******************************************************************************
+ *
+ * Function         btif_storage_update_conn_profile
+ *
+ * Description      BTIF storage API - Stores the remote features of a bonded
+ *                  device, read back on its next connection to skip reading
+ *                  them from the device
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btif_storage_update_conn_profile(const RawAddress& bd_addr);
+
 /*******************************************************************************
 **
 ** Function         btif_storage_is_device_bonded
@@ -34,6 +34,24 @@ void uid_set_destroy(uid_set_t* set);
 void uid_set_add_tx(uid_set_t* set, int32_t app_uid, uint64_t bytes);
 void uid_set_add_rx(uid_set_t* set, int32_t app_uid, uint64_t bytes);
 
+/**
+ * Accounts |bytes| of received data held by the stack because the app hasn't
+ * read it yet. A negative value releases what was accounted before.
+ */
+void uid_set_add_buffered(uid_set_t* set, int32_t app_uid, int64_t bytes);
+
+/**
+ * Returns true if the received data held for |app_uid| is at or over the
+ * per-UID budget, BTIF_SOCK_UID_RX_BUDGET. Sockets should stop the data flow
+ * from the peer until the app catches up.
+ */
+bool uid_set_is_over_budget(uid_set_t* set, int32_t app_uid);
+
+/**
+ * Writes the received data currently held per UID to |fd|.
+ */
+void uid_set_debug_dump(uid_set_t* set, int fd);
+
 /**
  * Returns an array of bt_uid_traffic_t structs, where the end of the array
  * is signaled by an element with app_uid == -1.
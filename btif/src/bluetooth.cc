@@ -58,6 +58,8 @@
 #include <hardware/bt_vendor_rc.h>
 #include "bt_utils.h"
 #include "bta_sys.h"
+#include "bta/include/bta_broadcast_audio_source.h"
+#include "bta/include/bta_gatt_api.h"
 #include "bta/include/bta_hearing_aid_api.h"
 #include "bta/include/bta_hf_client_api.h"
 #include "btif/include/btif_debug_btsnoop.h"
@@ -70,6 +72,9 @@
 #include "device/include/controller.h"
 #include "btif_debug.h"
 #include "btif_keystore.h"
+#include "btif_hh.h"
+#include "btif_profile_queue.h"
+#include "btif_sock.h"
 #include "btif_storage.h"
 #include "device/include/device_iot_config.h"
 #include "btsnoop.h"
@@ -77,16 +82,30 @@
 #include "common/address_obfuscator.h"
 #include "common/os_utils.h"
 #include "device/include/interop.h"
+#include "hci_layer.h"
 #include "osi/include/alarm.h"
 #include "osi/include/allocation_tracker.h"
+#include "osi/include/counters.h"
+#include "osi/include/footprint.h"
 #include "osi/include/log.h"
 #include "osi/include/metrics.h"
 #include "osi/include/osi.h"
+#include "osi/include/packet_trace.h"
+#include "osi/include/trace_ring.h"
+#include "osi/include/properties.h"
 #include "osi/include/wakelock.h"
 #include "stack/gatt/connection_manager.h"
 #include "stack_manager.h"
 #include "stack_interface.h"
+#include "stack/include/ble_advertiser.h"
 #include "stack/include/btm_api.h"
+#include "stack/include/btm_conn_trace.h"
+#include "stack/include/btm_iso_tx.h"
+#include "stack/include/btu.h"
+#include "stack/include/gatt_api.h"
+#include "stack/include/l2c_api.h"
+#include "stack/include/port_api.h"
+#include "stack/include/smp_api.h"
 
 using base::Bind;
 using bluetooth::hearing_aid::HearingAidInterface;
@@ -195,6 +214,15 @@ static int init(bt_callbacks_t* callbacks, bool start_restricted,
 #ifdef BLUEDROID_DEBUG
   allocation_tracker_init();
 #endif
+  int32_t sampling_rate =
+      osi_property_get_int32("persist.vendor.bt.alloc_sampling_rate", 0);
+  allocation_tracker_set_sampling_rate(sampling_rate > 0 ? sampling_rate : 0);
+  // 1 collects packet latency histograms, 2 also exports them to ftrace.
+  int32_t packet_trace =
+      osi_property_get_int32("persist.vendor.bt.packet_trace", 0);
+  packet_trace_init(packet_trace > 0, packet_trace > 1);
+  trace_ring_init(
+      osi_property_get_bool("persist.vendor.bt.trace_ring", true));
 
   bt_hal_cbacks = callbacks;
   restricted_mode = start_restricted;
@@ -406,12 +434,24 @@ static int clear_event_filter() {
 static void dump(int fd, const char** arguments) {
   if (arguments != NULL && arguments[0] != NULL) {
     if (strncmp(arguments[0], "--proto-bin", 11) == 0) {
+      bluetooth::bqr::ExportLinkQualityMetrics();
+      counters_export_metrics();
       system_bt_osi::BluetoothMetricsLogger::GetInstance()->WriteBase64(fd,
                                                                         true);
       return;
     }
+    /* the rolling snoop log as a btsnoop file, nothing else is written */
+    if (strncmp(arguments[0], "--btsnoop-rolling", 17) == 0) {
+      if (!btsnoop_write_rolling_log(fd))
+        LOG_WARN(LOG_TAG, "%s: no rolling snoop log", __func__);
+      return;
+    }
   }
   btif_debug_conn_dump(fd);
+  btm_conn_trace_debug_dump(fd);
+  btm_iso_tx_debug_dump(fd);
+  BroadcastAudioSource::DebugDump(fd);
+  btif_queue_debug_dump(fd);
   btif_debug_bond_event_dump(fd);
   btif_debug_a2dp_dump(fd);
   btif_debug_config_dump(fd);
@@ -422,6 +462,21 @@ static void dump(int fd, const char** arguments) {
   wakelock_debug_dump(fd);
   osi_allocator_debug_dump(fd);
   alarm_debug_dump(fd);
+  BTU_DumpTaskLanes(fd);
+  hci_layer_debug_dump(fd);
+  packet_trace_debug_dump(fd);
+  trace_ring_debug_dump(fd);
+  counters_debug_dump(fd);
+  footprint_debug_dump(fd);
+  L2CA_DumpAclScheduler(fd);
+  L2CA_DumpChannelStats(fd);
+  PORT_DumpDlcStats(fd);
+  btif_sock_debug_dump(fd);
+  btif_debug_hh_dump(fd);
+  GATTS_DumpNotificationStats(fd);
+  SMP_DumpPairingStats(fd);
+  BTA_GATTC_DumpConnStats(fd);
+  BleAdvertisingManager::DebugDump(fd);
   HearingAid::DebugDump(fd);
   connection_manager::dump(fd);
   bluetooth::bqr::DebugDump(fd);
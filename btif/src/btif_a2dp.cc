@@ -483,6 +483,7 @@ void btif_a2dp_honor_remote_start(struct alarm_t **remote_start_alarm, int index
 }
 
 void btif_debug_a2dp_dump(int fd) {
+  btif_av_debug_dump(fd);
   btif_a2dp_source_debug_dump(fd);
   btif_a2dp_sink_debug_dump(fd);
 }
@@ -34,6 +34,7 @@
 #include "bt_common.h"
 #include "btif_a2dp.h"
 #include "btif_a2dp_control.h"
+#include "btif_a2dp_latency.h"
 #include "btif_a2dp_sink.h"
 #include "btif_a2dp_source.h"
 #include "btif_av.h"
@@ -288,6 +289,7 @@ static void btif_a2dp_recv_ctrl_data(void) {
 
         int idx = btif_av_get_current_playing_dev_idx();
         uint16_t audio_delay = (idx < btif_max_av_clients) ? delay_report_stats.audio_delay[idx]:0;
+        audio_delay = btif_a2dp_latency_get_presentation_delay(audio_delay);
         APPL_TRACE_DEBUG("Delay Rpt: total bytes read = %d", delay_report_stats.total_bytes_read);
         APPL_TRACE_DEBUG("Delay Rpt: delay = %d, index: %d", audio_delay, idx);
         UIPC_Send(UIPC_CH_ID_AV_CTRL, 0,
@@ -642,6 +644,7 @@ static void btif_a2dp_recv_ctrl_data(void) {
         btif_a2dp_command_ack(A2DP_CTRL_ACK_SUCCESS);
         int idx = btif_av_get_current_playing_dev_idx();
         uint16_t audio_delay = (idx < btif_max_av_clients) ? delay_report_stats.audio_delay[idx]:0;
+        audio_delay = btif_a2dp_latency_get_presentation_delay(audio_delay);
         APPL_TRACE_DEBUG("Delay Rpt: total bytes read = %d", delay_report_stats.total_bytes_read);
         APPL_TRACE_DEBUG("Delay Rpt: delay = %d, index: %d", audio_delay, idx);
         UIPC_Send(UIPC_CH_ID_AV_CTRL, 0,
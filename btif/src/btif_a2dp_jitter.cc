@@ -0,0 +1,346 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_btif_a2dp_jitter"
+
+#include "btif_a2dp_jitter.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+
+#include "osi/include/log.h"
+#include "osi/include/properties.h"
+
+#define BTIF_A2DP_JITTER_PROPERTY "persist.vendor.bt.a2dp.sink_jitter_buffer"
+
+/* Packets kept before the oldest one is dropped */
+#define BTIF_A2DP_JITTER_MAX_PACKETS 64
+
+/* Bounds of the target depth of the buffer */
+#define BTIF_A2DP_JITTER_MIN_DEPTH_US 40000
+#define BTIF_A2DP_JITTER_MAX_DEPTH_US 240000
+
+/* The target depth covers this many times the arrival jitter */
+#define BTIF_A2DP_JITTER_DEPTH_FACTOR 3
+
+/* Each underrun raises the target depth by this step. It decays by
+ * BTIF_A2DP_JITTER_DECAY_US every BTIF_A2DP_JITTER_DECAY_PACKETS packets
+ * played without underrun. */
+#define BTIF_A2DP_JITTER_UNDERRUN_STEP_US 20000
+#define BTIF_A2DP_JITTER_DECAY_US 5000
+#define BTIF_A2DP_JITTER_DECAY_PACKETS 1000
+
+/* Weight of a new sample in the average depth, as a power of two */
+#define BTIF_A2DP_JITTER_DEPTH_SHIFT 4
+
+/* Playout rate correction per ms of depth away from the target, and its
+ * bound */
+#define BTIF_A2DP_JITTER_PPM_PER_MS 10
+#define BTIF_A2DP_JITTER_MAX_PPM 1000
+
+typedef struct {
+  void* p_pkt;
+  uint32_t time_stamp;
+  uint16_t seq;
+  uint64_t duration_us;
+} tBTIF_A2DP_JITTER_ENTRY;
+
+typedef struct {
+  std::mutex lock;
+  bool enabled;
+  uint32_t clock_rate;
+
+  std::deque<tBTIF_A2DP_JITTER_ENTRY> packets;
+  uint64_t depth_us;
+  bool playing;
+
+  bool released_valid;
+  uint32_t last_released_ts;
+
+  /* Interarrival jitter as in RFC 3550, scaled by 16 */
+  bool arrival_valid;
+  uint64_t last_arrival_us;
+  uint32_t last_arrival_ts;
+  uint64_t jitter16_us;
+
+  uint64_t floor_us;
+  uint32_t clean_packets;
+  int64_t depth_avg_us;
+  std::atomic<int32_t> drift_ppm;
+
+  /* Audio waiting in the output after decoding */
+  uint64_t output_level_us;
+  uint64_t output_target_us;
+
+  /* Resampler state, only used from the sink thread. |pos| is the position
+   * of the next output frame in Q32 relative to |last|. */
+  uint64_t pos;
+  int16_t last[2];
+
+  uint32_t received;
+  uint32_t late;
+  uint32_t duplicate;
+  uint32_t overflow;
+  uint32_t underruns;
+  uint64_t max_jitter_us;
+} tBTIF_A2DP_JITTER_CB;
+
+static tBTIF_A2DP_JITTER_CB jitter_cb;
+
+static uint64_t jitter_target_us(void) {
+  uint64_t target = BTIF_A2DP_JITTER_MIN_DEPTH_US +
+                    BTIF_A2DP_JITTER_DEPTH_FACTOR * (jitter_cb.jitter16_us / 16);
+  target = std::max(target, jitter_cb.floor_us);
+  return std::min<uint64_t>(target, BTIF_A2DP_JITTER_MAX_DEPTH_US);
+}
+
+static void jitter_update_arrival(uint32_t time_stamp, uint64_t now_us) {
+  if (jitter_cb.arrival_valid && jitter_cb.clock_rate != 0) {
+    int64_t ts_delta_us = (int64_t)(int32_t)(time_stamp -
+                                             jitter_cb.last_arrival_ts) *
+                          1000000 / jitter_cb.clock_rate;
+    int64_t d = (int64_t)(now_us - jitter_cb.last_arrival_us) - ts_delta_us;
+    uint64_t abs_d = (uint64_t)(d < 0 ? -d : d);
+    jitter_cb.jitter16_us += abs_d - jitter_cb.jitter16_us / 16;
+    jitter_cb.max_jitter_us =
+        std::max(jitter_cb.max_jitter_us, jitter_cb.jitter16_us / 16);
+  }
+  jitter_cb.arrival_valid = true;
+  jitter_cb.last_arrival_us = now_us;
+  jitter_cb.last_arrival_ts = time_stamp;
+}
+
+static void jitter_reset_locked(void) {
+  jitter_cb.packets.clear();
+  jitter_cb.depth_us = 0;
+  jitter_cb.playing = false;
+  jitter_cb.released_valid = false;
+  jitter_cb.arrival_valid = false;
+  jitter_cb.depth_avg_us = 0;
+  jitter_cb.drift_ppm = 0;
+  jitter_cb.output_level_us = 0;
+  jitter_cb.output_target_us = 0;
+  jitter_cb.pos = 0;
+  jitter_cb.last[0] = jitter_cb.last[1] = 0;
+}
+
+void btif_a2dp_jitter_init(uint32_t clock_rate) {
+  std::lock_guard<std::mutex> lock(jitter_cb.lock);
+  jitter_cb.enabled = osi_property_get_bool(BTIF_A2DP_JITTER_PROPERTY, false);
+  jitter_cb.clock_rate = clock_rate;
+  jitter_reset_locked();
+  jitter_cb.jitter16_us = 0;
+  jitter_cb.floor_us = BTIF_A2DP_JITTER_MIN_DEPTH_US;
+  jitter_cb.clean_packets = 0;
+  jitter_cb.received = 0;
+  jitter_cb.late = 0;
+  jitter_cb.duplicate = 0;
+  jitter_cb.overflow = 0;
+  jitter_cb.underruns = 0;
+  jitter_cb.max_jitter_us = 0;
+  LOG_INFO(LOG_TAG, "%s: enabled: %s, clock rate: %u", __func__,
+           jitter_cb.enabled ? "true" : "false", clock_rate);
+}
+
+bool btif_a2dp_jitter_is_enabled(void) {
+  std::lock_guard<std::mutex> lock(jitter_cb.lock);
+  return jitter_cb.enabled;
+}
+
+void* btif_a2dp_jitter_put(void* p_pkt, uint32_t time_stamp, uint16_t seq,
+                           uint64_t duration_us, uint64_t now_us) {
+  std::lock_guard<std::mutex> lock(jitter_cb.lock);
+  jitter_cb.received++;
+
+  if (jitter_cb.released_valid) {
+    int32_t diff = (int32_t)(time_stamp - jitter_cb.last_released_ts);
+    if (diff <= 0) {
+      if (diff == 0) {
+        jitter_cb.duplicate++;
+      } else {
+        jitter_cb.late++;
+      }
+      LOG_VERBOSE(LOG_TAG, "%s: dropping packet seq %u ts %u", __func__, seq,
+                  time_stamp);
+      return p_pkt;
+    }
+  }
+
+  /* Packets mostly arrive in order: search the slot from the back */
+  auto it = jitter_cb.packets.end();
+  while (it != jitter_cb.packets.begin()) {
+    int32_t diff = (int32_t)(time_stamp - std::prev(it)->time_stamp);
+    if (diff == 0) {
+      jitter_cb.duplicate++;
+      return p_pkt;
+    }
+    if (diff > 0) break;
+    --it;
+  }
+
+  jitter_update_arrival(time_stamp, now_us);
+  jitter_cb.packets.insert(it, {p_pkt, time_stamp, seq, duration_us});
+  jitter_cb.depth_us += duration_us;
+
+  void* p_drop = NULL;
+  if (jitter_cb.packets.size() > BTIF_A2DP_JITTER_MAX_PACKETS) {
+    const tBTIF_A2DP_JITTER_ENTRY& oldest = jitter_cb.packets.front();
+    p_drop = oldest.p_pkt;
+    jitter_cb.depth_us -= oldest.duration_us;
+    jitter_cb.released_valid = true;
+    jitter_cb.last_released_ts = oldest.time_stamp;
+    jitter_cb.packets.pop_front();
+    jitter_cb.overflow++;
+  }
+
+  if (!jitter_cb.playing && jitter_cb.depth_us >= jitter_target_us()) {
+    LOG_VERBOSE(LOG_TAG, "%s: start playout at depth %llu us", __func__,
+                (unsigned long long)jitter_cb.depth_us);
+    jitter_cb.playing = true;
+  }
+  return p_drop;
+}
+
+void* btif_a2dp_jitter_get(void) {
+  std::lock_guard<std::mutex> lock(jitter_cb.lock);
+  if (!jitter_cb.playing) return NULL;
+
+  uint64_t target_us = jitter_target_us();
+  if (jitter_cb.packets.empty()) {
+    jitter_cb.playing = false;
+    jitter_cb.underruns++;
+    jitter_cb.floor_us =
+        std::min<uint64_t>(target_us + BTIF_A2DP_JITTER_UNDERRUN_STEP_US,
+                           BTIF_A2DP_JITTER_MAX_DEPTH_US);
+    jitter_cb.clean_packets = 0;
+    LOG_WARN(LOG_TAG, "%s: underrun, target depth %llu us", __func__,
+             (unsigned long long)jitter_cb.floor_us);
+    return NULL;
+  }
+
+  tBTIF_A2DP_JITTER_ENTRY entry = jitter_cb.packets.front();
+  jitter_cb.packets.pop_front();
+  jitter_cb.depth_us -= entry.duration_us;
+  jitter_cb.released_valid = true;
+  jitter_cb.last_released_ts = entry.time_stamp;
+
+  if (++jitter_cb.clean_packets >= BTIF_A2DP_JITTER_DECAY_PACKETS) {
+    jitter_cb.clean_packets = 0;
+    jitter_cb.floor_us =
+        std::max<uint64_t>(jitter_cb.floor_us - BTIF_A2DP_JITTER_DECAY_US,
+                           BTIF_A2DP_JITTER_MIN_DEPTH_US);
+  }
+
+  /* A source clock running faster than ours fills the buffer over the target:
+     play slightly faster, and slower when it drains */
+  int64_t depth_us = jitter_cb.depth_us + jitter_cb.output_level_us;
+  jitter_cb.depth_avg_us +=
+      (depth_us - jitter_cb.depth_avg_us) >> BTIF_A2DP_JITTER_DEPTH_SHIFT;
+  int64_t ppm = (jitter_cb.depth_avg_us -
+                 (int64_t)(target_us + jitter_cb.output_target_us)) *
+                BTIF_A2DP_JITTER_PPM_PER_MS / 1000;
+  jitter_cb.drift_ppm = (int32_t)std::min<int64_t>(
+      std::max<int64_t>(ppm, -BTIF_A2DP_JITTER_MAX_PPM),
+      BTIF_A2DP_JITTER_MAX_PPM);
+  return entry.p_pkt;
+}
+
+bool btif_a2dp_jitter_is_playing(void) {
+  std::lock_guard<std::mutex> lock(jitter_cb.lock);
+  return jitter_cb.playing;
+}
+
+void btif_a2dp_jitter_flush(void (*free_cb)(void*)) {
+  std::lock_guard<std::mutex> lock(jitter_cb.lock);
+  for (const tBTIF_A2DP_JITTER_ENTRY& entry : jitter_cb.packets)
+    free_cb(entry.p_pkt);
+  jitter_reset_locked();
+}
+
+void btif_a2dp_jitter_set_output_level(uint64_t level_us, uint64_t target_us) {
+  std::lock_guard<std::mutex> lock(jitter_cb.lock);
+  jitter_cb.output_level_us = level_us;
+  jitter_cb.output_target_us = target_us;
+}
+
+size_t btif_a2dp_jitter_resample(const int16_t* p_in, size_t in_frames,
+                                 uint8_t channels, int16_t* p_out,
+                                 size_t out_frames) {
+  if (in_frames == 0 || channels == 0 || channels > 2) return 0;
+
+  const int64_t one = (int64_t)1 << 32;
+  uint64_t step = one + ((int64_t)jitter_cb.drift_ppm * one) / 1000000;
+  uint64_t pos = jitter_cb.pos;
+  size_t n = 0;
+
+  /* Frame i of the input is at position i + 1, |last| at position 0 */
+  while ((pos >> 32) < in_frames && n < out_frames) {
+    size_t i = pos >> 32;
+    int64_t frac = (pos & 0xFFFFFFFF) >> 16;
+    for (uint8_t ch = 0; ch < channels; ch++) {
+      int32_t a = (i == 0) ? jitter_cb.last[ch] : p_in[(i - 1) * channels + ch];
+      int32_t b = p_in[i * channels + ch];
+      p_out[n * channels + ch] = (int16_t)(a + (((b - a) * frac) >> 16));
+    }
+    n++;
+    pos += step;
+  }
+
+  if ((pos >> 32) < in_frames) {
+    LOG_WARN(LOG_TAG, "%s: output full, dropping %zu frames", __func__,
+             in_frames - (size_t)(pos >> 32));
+    pos = (uint64_t)in_frames << 32;
+  }
+  jitter_cb.pos = pos - ((uint64_t)in_frames << 32);
+  for (uint8_t ch = 0; ch < channels; ch++)
+    jitter_cb.last[ch] = p_in[(in_frames - 1) * channels + ch];
+  return n;
+}
+
+void btif_a2dp_jitter_debug_dump(int fd) {
+  std::lock_guard<std::mutex> lock(jitter_cb.lock);
+  dprintf(fd, "\nA2DP Sink Jitter Buffer:\n");
+  dprintf(fd, "  Enabled: %s\n", jitter_cb.enabled ? "true" : "false");
+  if (!jitter_cb.enabled) return;
+
+  dprintf(fd, "  Playing: %s, clock rate: %u\n",
+          jitter_cb.playing ? "true" : "false", jitter_cb.clock_rate);
+  dprintf(fd, "  Buffered packets / depth in us          : %zu / %llu\n",
+          jitter_cb.packets.size(), (unsigned long long)jitter_cb.depth_us);
+  dprintf(fd, "  Target depth in us                      : %llu\n",
+          (unsigned long long)jitter_target_us());
+  dprintf(fd, "  Arrival jitter in us (current/max)      : %llu / %llu\n",
+          (unsigned long long)(jitter_cb.jitter16_us / 16),
+          (unsigned long long)jitter_cb.max_jitter_us);
+  dprintf(fd, "  Output level / target in us             : %llu / %llu\n",
+          (unsigned long long)jitter_cb.output_level_us,
+          (unsigned long long)jitter_cb.output_target_us);
+  dprintf(fd, "  Drift correction in ppm                 : %d\n",
+          jitter_cb.drift_ppm.load());
+  dprintf(fd,
+          "  Packets received / late / duplicate / overflow : %u / %u / %u / "
+          "%u\n",
+          jitter_cb.received, jitter_cb.late, jitter_cb.duplicate,
+          jitter_cb.overflow);
+  dprintf(fd, "  Underruns                               : %u\n",
+          jitter_cb.underruns);
+}
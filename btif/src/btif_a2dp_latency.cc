@@ -0,0 +1,106 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_btif_a2dp_latency"
+
+#include "btif_a2dp_latency.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include "osi/include/log.h"
+#include "osi/include/properties.h"
+
+#define BTIF_A2DP_LATENCY_PROPERTY "persist.vendor.bt.a2dp.latency_accounting"
+
+/* Weight of a new sample in the running estimates, as a power of two. */
+#define BTIF_A2DP_LATENCY_EWMA_SHIFT 3
+
+static const char* latency_stage_names[BTIF_A2DP_LATENCY_NUM_STAGES] = {
+    "PCM", "Encoder", "TX queue", "Controller", "Remote"};
+
+typedef struct {
+  std::atomic<bool> enabled;
+  std::atomic<uint64_t> estimate_us[BTIF_A2DP_LATENCY_NUM_STAGES];
+  std::atomic<uint64_t> max_us[BTIF_A2DP_LATENCY_NUM_STAGES];
+} tBTIF_A2DP_LATENCY_CB;
+
+static tBTIF_A2DP_LATENCY_CB latency_cb;
+
+void btif_a2dp_latency_reset(void) {
+  latency_cb.enabled =
+      osi_property_get_bool(BTIF_A2DP_LATENCY_PROPERTY, false);
+  for (int i = 0; i < BTIF_A2DP_LATENCY_NUM_STAGES; i++) {
+    latency_cb.estimate_us[i] = 0;
+    latency_cb.max_us[i] = 0;
+  }
+}
+
+void btif_a2dp_latency_update(tBTIF_A2DP_LATENCY_STAGE stage,
+                              uint64_t delay_us) {
+  if (!latency_cb.enabled || stage >= BTIF_A2DP_LATENCY_NUM_STAGES) return;
+
+  /* The first sample seeds the estimate */
+  uint64_t estimate = latency_cb.estimate_us[stage];
+  if (estimate == 0 || stage == BTIF_A2DP_LATENCY_REMOTE) {
+    estimate = delay_us;
+  } else if (delay_us > estimate) {
+    estimate += (delay_us - estimate) >> BTIF_A2DP_LATENCY_EWMA_SHIFT;
+  } else {
+    estimate -= (estimate - delay_us) >> BTIF_A2DP_LATENCY_EWMA_SHIFT;
+  }
+  latency_cb.estimate_us[stage] = estimate;
+  if (delay_us > latency_cb.max_us[stage]) latency_cb.max_us[stage] = delay_us;
+}
+
+uint64_t btif_a2dp_latency_get_us(tBTIF_A2DP_LATENCY_STAGE stage) {
+  if (stage >= BTIF_A2DP_LATENCY_NUM_STAGES) return 0;
+  return latency_cb.estimate_us[stage];
+}
+
+uint16_t btif_a2dp_latency_get_presentation_delay(uint16_t remote_delay) {
+  if (!latency_cb.enabled) return remote_delay;
+
+  btif_a2dp_latency_update(BTIF_A2DP_LATENCY_REMOTE, remote_delay * 100ULL);
+
+  uint64_t local_us = 0;
+  for (int i = 0; i < BTIF_A2DP_LATENCY_REMOTE; i++)
+    local_us += latency_cb.estimate_us[i];
+
+  uint64_t delay = remote_delay + local_us / 100;
+  return (uint16_t)std::min<uint64_t>(delay, UINT16_MAX);
+}
+
+void btif_a2dp_latency_debug_dump(int fd) {
+  dprintf(fd, "\nA2DP Latency Accounting:\n");
+  dprintf(fd, "  Enabled: %s\n", latency_cb.enabled ? "true" : "false");
+  if (!latency_cb.enabled) return;
+
+  uint64_t total_us = 0;
+  for (int i = 0; i < BTIF_A2DP_LATENCY_NUM_STAGES; i++) {
+    uint64_t estimate_us = latency_cb.estimate_us[i];
+    total_us += estimate_us;
+    dprintf(fd, "  %-10s delay in us (estimate/max) : %llu / %llu\n",
+            latency_stage_names[i], (unsigned long long)estimate_us,
+            (unsigned long long)latency_cb.max_us[i].load());
+  }
+  dprintf(fd, "  Total delay in us                     : %llu\n",
+          (unsigned long long)total_us);
+}
@@ -0,0 +1,448 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_btif_a2dp_link_adapt"
+
+#include "btif_a2dp_link_adapt.h"
+
+#include <base/bind.h>
+#include <base/logging.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include "bt_common.h"
+#include "bta_closure_api.h"
+#include "btif_a2dp_latency.h"
+#include "btm_api.h"
+#include "hcidefs.h"
+#include "l2c_api.h"
+#include "l2cdefs.h"
+#include "osi/include/alarm.h"
+#include "osi/include/log.h"
+#include "osi/include/osi.h"
+#include "osi/include/properties.h"
+
+#define BTIF_A2DP_LINK_ADAPT_PROPERTY "persist.vendor.bt.a2dp_link_adapt"
+#define BTIF_A2DP_QUEUE_ADAPT_PROPERTY "persist.vendor.bt.a2dp_queue_adapt"
+
+/* How often the link quality is sampled while streaming. */
+#define BTIF_A2DP_LINK_ADAPT_PERIOD_MS 1000
+
+/* Clean periods in a row before the link is restored by one level. */
+#define BTIF_A2DP_LINK_ADAPT_RECOVERY_PERIODS 5
+
+/* TX queue depth, in packets, at which the link is considered congested. */
+#define BTIF_A2DP_LINK_ADAPT_QUEUE_THRESHOLD 4
+
+/* Room, in packets, the TX queue limit always leaves on top of the packet
+ * being queued. */
+#define BTIF_A2DP_LINK_ADAPT_QUEUE_HEADROOM 4
+
+/* Packets the TX queue limit grows or shrinks by in one period. */
+#define BTIF_A2DP_LINK_ADAPT_QUEUE_STEP 2
+
+/* RSSI below which the signal is considered weak. For BR/EDR links the value
+ * is the distance from the golden receive power range in dB. */
+#define BTIF_A2DP_LINK_ADAPT_WEAK_RSSI (-10)
+
+#define BTIF_A2DP_LINK_ADAPT_NO_3MBPS_PKTS                                 \
+  (BTM_ACL_PKT_TYPES_MASK_NO_3_DH1 | BTM_ACL_PKT_TYPES_MASK_NO_3_DH3 | \
+   BTM_ACL_PKT_TYPES_MASK_NO_3_DH5)
+
+enum {
+  BTIF_A2DP_LINK_GOOD,
+  BTIF_A2DP_LINK_DEGRADED,
+  BTIF_A2DP_LINK_POOR,
+  BTIF_A2DP_LINK_NUM_LEVELS
+};
+
+typedef struct {
+  const char* name;
+  uint8_t flush_intervals;     /* Flush timeout in encoder intervals, 0 keeps
+                                  the timeout the link was started with */
+  uint16_t excluded_pkt_types; /* EDR packet types not to use */
+  uint8_t queue_bias;          /* Packets added to the reported queue length */
+} tBTIF_A2DP_LINK_LEVEL;
+
+static const tBTIF_A2DP_LINK_LEVEL link_levels[BTIF_A2DP_LINK_NUM_LEVELS] = {
+    {"good", 0, 0, 0},
+    {"degraded", 8, 0, 1},
+    {"poor", 4, BTIF_A2DP_LINK_ADAPT_NO_3MBPS_PKTS, 3},
+};
+
+typedef struct {
+  /* Only accessed on the BTU thread */
+  bool enabled;
+  bool queue_enabled;
+  bool active;
+  RawAddress peer_address;
+  period_ms_t encoder_interval_ms;
+  alarm_t* timer;
+  uint8_t clean_periods;
+  bool original_flush_known;
+  uint16_t original_flush_ms;
+  bool rssi_valid;
+  int8_t rssi;
+  uint16_t failed_contacts;
+  uint32_t level_changes;
+  uint8_t queue_clean_periods;
+  uint32_t queue_grows;
+  uint32_t queue_shrinks;
+
+  /* Shared with the media thread */
+  std::atomic<uint8_t> level;
+  std::atomic<uint32_t> dropouts;
+  std::atomic<size_t> queue_high_water;
+  std::atomic<size_t> queue_max;   /* Limit configured by the source */
+  std::atomic<size_t> queue_limit; /* 0 while no limit was computed yet */
+} tBTIF_A2DP_LINK_ADAPT_CB;
+
+static tBTIF_A2DP_LINK_ADAPT_CB link_adapt_cb;
+
+/* Flush timeout for |level| in ms, or 0 to leave the flush timeout alone. */
+static uint16_t btif_a2dp_link_adapt_flush_ms(uint8_t level) {
+  const tBTIF_A2DP_LINK_LEVEL* p_level = &link_levels[level];
+  if (!link_adapt_cb.original_flush_known) return 0;
+  if (p_level->flush_intervals == 0) return link_adapt_cb.original_flush_ms;
+
+  /* Limit to what fits the HCI command, never longer than the original */
+  uint32_t flush_ms = std::max<uint32_t>(
+      p_level->flush_intervals * link_adapt_cb.encoder_interval_ms,
+      L2CAP_NO_RETRANSMISSION + 1);
+  flush_ms = std::min<uint32_t>(flush_ms,
+                                HCI_MAX_AUTOMATIC_FLUSH_TIMEOUT * 5 / 8);
+  if (link_adapt_cb.original_flush_ms != L2CAP_NO_AUTOMATIC_FLUSH)
+    flush_ms = std::min<uint32_t>(flush_ms, link_adapt_cb.original_flush_ms);
+  return (uint16_t)flush_ms;
+}
+
+static void btif_a2dp_link_adapt_apply(uint8_t level) {
+  uint8_t old_level = link_adapt_cb.level;
+  const RawAddress& peer_address = link_adapt_cb.peer_address;
+
+  LOG_INFO(LOG_TAG, "%s: %s link %s -> %s", __func__,
+           peer_address.ToString().c_str(), link_levels[old_level].name,
+           link_levels[level].name);
+
+  uint16_t flush_ms = btif_a2dp_link_adapt_flush_ms(level);
+  if (flush_ms != 0 && !L2CA_SetFlushTimeout(peer_address, flush_ms)) {
+    LOG_WARN(LOG_TAG, "%s: cannot set flush timeout %u ms", __func__,
+             flush_ms);
+  }
+
+  uint16_t excluded = link_levels[level].excluded_pkt_types;
+  if (excluded != link_levels[old_level].excluded_pkt_types) {
+    tBTM_STATUS status = BTM_ExcludeAclPacketTypes(peer_address, excluded);
+    if (status != BTM_CMD_STARTED) {
+      LOG_WARN(LOG_TAG, "%s: cannot set packet types: status %d", __func__,
+               status);
+    }
+  }
+
+  link_adapt_cb.level = level;
+  link_adapt_cb.level_changes++;
+}
+
+/*******************************************************************************
+ *
+ * Function         btif_a2dp_link_adapt_evaluate
+ *
+ * Description      Moves the link one level down when the TX queue backed
+ *                  up or overflowed during the last period, and at least to
+ *                  the degraded level while the signal is weak. The Failed
+ *                  Contact Counter only counts as weak signal while the
+ *                  original flush timeout is in use, since a shortened flush
+ *                  timeout causes flushes by itself. The link goes back one
+ *                  level after a number of clean periods in a row.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void btif_a2dp_link_adapt_evaluate_link(uint32_t dropouts,
+                                              size_t queue_high_water) {
+  uint8_t level = link_adapt_cb.level;
+  bool congested = dropouts > 0 ||
+                   queue_high_water >= BTIF_A2DP_LINK_ADAPT_QUEUE_THRESHOLD;
+  bool weak = (link_adapt_cb.rssi_valid &&
+               link_adapt_cb.rssi < BTIF_A2DP_LINK_ADAPT_WEAK_RSSI) ||
+              (level == BTIF_A2DP_LINK_GOOD && link_adapt_cb.failed_contacts);
+
+  if (congested) {
+    link_adapt_cb.clean_periods = 0;
+    if (level < BTIF_A2DP_LINK_POOR) level++;
+  } else if (weak) {
+    link_adapt_cb.clean_periods = 0;
+    level = std::max<uint8_t>(level, BTIF_A2DP_LINK_DEGRADED);
+  } else if (level > BTIF_A2DP_LINK_GOOD &&
+             ++link_adapt_cb.clean_periods >=
+                 BTIF_A2DP_LINK_ADAPT_RECOVERY_PERIODS) {
+    link_adapt_cb.clean_periods = 0;
+    level--;
+  }
+
+  if (level != link_adapt_cb.level) btif_a2dp_link_adapt_apply(level);
+}
+
+/*******************************************************************************
+ *
+ * Function         btif_a2dp_link_adapt_evaluate_queue
+ *
+ * Description      Sizes the TX queue limit of the source. The limit starts
+ *                  at the configured maximum and shrinks step by step while
+ *                  the link keeps up, so packets wait less in the queue. It
+ *                  goes back to the maximum when packets were dropped, and
+ *                  grows by a step when the baseband reports failed contacts
+ *                  or the queue got close to the limit.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void btif_a2dp_link_adapt_evaluate_queue(uint32_t dropouts,
+                                               size_t queue_high_water) {
+  size_t max_limit = link_adapt_cb.queue_max;
+  if (max_limit == 0) return;
+
+  size_t old_limit = link_adapt_cb.queue_limit;
+  if (old_limit == 0 || old_limit > max_limit) old_limit = max_limit;
+  size_t limit = old_limit;
+  size_t min_limit =
+      std::min<size_t>(max_limit, BTIF_A2DP_LINK_ADAPT_QUEUE_HEADROOM);
+
+  if (dropouts > 0) {
+    link_adapt_cb.queue_clean_periods = 0;
+    limit = max_limit;
+  } else if (link_adapt_cb.failed_contacts ||
+             queue_high_water + BTIF_A2DP_LINK_ADAPT_QUEUE_HEADROOM >= limit) {
+    link_adapt_cb.queue_clean_periods = 0;
+    limit = std::min(max_limit, limit + BTIF_A2DP_LINK_ADAPT_QUEUE_STEP);
+  } else if (++link_adapt_cb.queue_clean_periods >=
+             BTIF_A2DP_LINK_ADAPT_RECOVERY_PERIODS) {
+    link_adapt_cb.queue_clean_periods = 0;
+    /* Never below what the queue needed during the period */
+    size_t needed = queue_high_water + BTIF_A2DP_LINK_ADAPT_QUEUE_HEADROOM + 1;
+    if (limit > BTIF_A2DP_LINK_ADAPT_QUEUE_STEP)
+      limit -= BTIF_A2DP_LINK_ADAPT_QUEUE_STEP;
+    limit = std::max(limit, std::max(needed, min_limit));
+  }
+
+  if (limit > old_limit) link_adapt_cb.queue_grows++;
+  if (limit < old_limit) link_adapt_cb.queue_shrinks++;
+  if (limit != old_limit) {
+    LOG_VERBOSE(LOG_TAG, "%s: TX queue limit %zu -> %zu (max %zu)", __func__,
+                old_limit, limit, max_limit);
+  }
+  link_adapt_cb.queue_limit = limit;
+}
+
+static void btif_a2dp_link_adapt_evaluate(void) {
+  uint32_t dropouts = link_adapt_cb.dropouts.exchange(0);
+  size_t queue_high_water = link_adapt_cb.queue_high_water.exchange(0);
+
+  if (link_adapt_cb.enabled)
+    btif_a2dp_link_adapt_evaluate_link(dropouts, queue_high_water);
+  if (link_adapt_cb.queue_enabled)
+    btif_a2dp_link_adapt_evaluate_queue(dropouts, queue_high_water);
+  link_adapt_cb.failed_contacts = 0;
+
+  /* A packet is flushed at the latest when the flush timeout expires, on
+   * average it waits about half of it in the controller. */
+  uint16_t flush_ms = btif_a2dp_link_adapt_flush_ms(link_adapt_cb.level);
+  if (flush_ms != 0 && flush_ms != L2CAP_NO_AUTOMATIC_FLUSH)
+    btif_a2dp_latency_update(BTIF_A2DP_LATENCY_CONTROLLER, flush_ms * 1000 / 2);
+}
+
+static void btif_a2dp_link_adapt_rssi_cb(void* data) {
+  tBTM_RSSI_RESULT* result = (tBTM_RSSI_RESULT*)data;
+  if (result == nullptr || result->status != BTM_SUCCESS) return;
+  if (!link_adapt_cb.active || result->rem_bda != link_adapt_cb.peer_address)
+    return;
+
+  link_adapt_cb.rssi_valid = true;
+  link_adapt_cb.rssi = result->rssi;
+}
+
+static void btif_a2dp_link_adapt_failed_contact_counter_cb(void* data) {
+  tBTM_FAILED_CONTACT_COUNTER_RESULT* result =
+      (tBTM_FAILED_CONTACT_COUNTER_RESULT*)data;
+  if (result == nullptr || result->status != BTM_SUCCESS) return;
+  if (!link_adapt_cb.active || result->rem_bda != link_adapt_cb.peer_address)
+    return;
+
+  link_adapt_cb.failed_contacts = std::max(link_adapt_cb.failed_contacts,
+                                           result->failed_contact_counter);
+}
+
+static void btif_a2dp_link_adapt_flush_timeout_cb(void* data) {
+  tBTM_AUTOMATIC_FLUSH_TIMEOUT_RESULT* result =
+      (tBTM_AUTOMATIC_FLUSH_TIMEOUT_RESULT*)data;
+  if (result == nullptr || result->status != BTM_SUCCESS) return;
+  if (!link_adapt_cb.active || result->rem_bda != link_adapt_cb.peer_address)
+    return;
+
+  /* Only the timeout set up by the AV profile is worth restoring */
+  if (link_adapt_cb.original_flush_known ||
+      link_adapt_cb.level != BTIF_A2DP_LINK_GOOD)
+    return;
+
+  uint16_t slots = result->automatic_flush_timeout;
+  link_adapt_cb.original_flush_ms =
+      slots ? (uint16_t)std::max(slots * 5 / 8, L2CAP_NO_RETRANSMISSION + 1)
+            : L2CAP_NO_AUTOMATIC_FLUSH;
+  link_adapt_cb.original_flush_known = true;
+}
+
+/* Reads the link quality for the next evaluation. A read fails while one
+ * issued elsewhere is still pending, that sample is skipped then. */
+static void btif_a2dp_link_adapt_read_link(void) {
+  const RawAddress& peer_address = link_adapt_cb.peer_address;
+
+  BTM_ReadRSSI(peer_address, btif_a2dp_link_adapt_rssi_cb);
+  BTM_ReadFailedContactCounter(peer_address,
+                               btif_a2dp_link_adapt_failed_contact_counter_cb);
+  if (!link_adapt_cb.original_flush_known) {
+    BTM_ReadAutomaticFlushTimeout(peer_address,
+                                  btif_a2dp_link_adapt_flush_timeout_cb);
+  }
+}
+
+static void btif_a2dp_link_adapt_timer_cb(UNUSED_ATTR void* context) {
+  if (!link_adapt_cb.active) return;
+
+  btif_a2dp_link_adapt_evaluate();
+  btif_a2dp_link_adapt_read_link();
+  alarm_set_on_mloop(link_adapt_cb.timer, BTIF_A2DP_LINK_ADAPT_PERIOD_MS,
+                     btif_a2dp_link_adapt_timer_cb, NULL);
+}
+
+static void btif_a2dp_link_adapt_start_on_btu(RawAddress peer_address,
+                                              period_ms_t encoder_interval_ms) {
+  link_adapt_cb.enabled =
+      osi_property_get_bool(BTIF_A2DP_LINK_ADAPT_PROPERTY, false);
+  link_adapt_cb.queue_enabled =
+      osi_property_get_bool(BTIF_A2DP_QUEUE_ADAPT_PROPERTY, false);
+  if (!link_adapt_cb.enabled && !link_adapt_cb.queue_enabled) return;
+
+  /* A new stream on another link restores the previous one first */
+  if (link_adapt_cb.active && link_adapt_cb.peer_address == peer_address) {
+    link_adapt_cb.encoder_interval_ms = encoder_interval_ms;
+    return;
+  }
+  if (link_adapt_cb.active &&
+      link_adapt_cb.level != BTIF_A2DP_LINK_GOOD)
+    btif_a2dp_link_adapt_apply(BTIF_A2DP_LINK_GOOD);
+
+  LOG_INFO(LOG_TAG, "%s: peer %s encoder interval %u ms", __func__,
+           peer_address.ToString().c_str(), (uint32_t)encoder_interval_ms);
+
+  link_adapt_cb.active = true;
+  link_adapt_cb.peer_address = peer_address;
+  link_adapt_cb.encoder_interval_ms = encoder_interval_ms;
+  link_adapt_cb.clean_periods = 0;
+  link_adapt_cb.original_flush_known = false;
+  link_adapt_cb.rssi_valid = false;
+  link_adapt_cb.failed_contacts = 0;
+  link_adapt_cb.level = BTIF_A2DP_LINK_GOOD;
+  link_adapt_cb.dropouts = 0;
+  link_adapt_cb.queue_high_water = 0;
+  link_adapt_cb.queue_clean_periods = 0;
+  link_adapt_cb.queue_limit = 0;
+
+  if (link_adapt_cb.timer == NULL)
+    link_adapt_cb.timer = alarm_new("btif.a2dp_link_adapt_timer");
+  btif_a2dp_link_adapt_read_link();
+  alarm_set_on_mloop(link_adapt_cb.timer, BTIF_A2DP_LINK_ADAPT_PERIOD_MS,
+                     btif_a2dp_link_adapt_timer_cb, NULL);
+}
+
+static void btif_a2dp_link_adapt_stop_on_btu(void) {
+  if (!link_adapt_cb.active) return;
+
+  alarm_cancel(link_adapt_cb.timer);
+  if (link_adapt_cb.level != BTIF_A2DP_LINK_GOOD)
+    btif_a2dp_link_adapt_apply(BTIF_A2DP_LINK_GOOD);
+  link_adapt_cb.active = false;
+  link_adapt_cb.queue_limit = 0;
+}
+
+void btif_a2dp_link_adapt_start(const RawAddress& peer_address,
+                                period_ms_t encoder_interval_ms) {
+  do_in_bta_thread(FROM_HERE, base::Bind(&btif_a2dp_link_adapt_start_on_btu,
+                                         peer_address, encoder_interval_ms));
+}
+
+void btif_a2dp_link_adapt_stop(void) {
+  do_in_bta_thread(FROM_HERE, base::Bind(&btif_a2dp_link_adapt_stop_on_btu));
+}
+
+void btif_a2dp_link_adapt_on_tx_dropout(void) { link_adapt_cb.dropouts++; }
+
+size_t btif_a2dp_link_adapt_get_queue_length(size_t transmit_queue_length) {
+  size_t high_water = link_adapt_cb.queue_high_water;
+  while (transmit_queue_length > high_water &&
+         !link_adapt_cb.queue_high_water.compare_exchange_weak(
+             high_water, transmit_queue_length)) {
+  }
+
+  /* Scale the length to the configured limit the encoder is tuned for, so
+   * that it reacts to how full the queue is rather than to its length. */
+  size_t limit = link_adapt_cb.queue_limit;
+  size_t max_limit = link_adapt_cb.queue_max;
+  if (limit != 0 && limit < max_limit)
+    transmit_queue_length = transmit_queue_length * max_limit / limit;
+
+  return transmit_queue_length + link_levels[link_adapt_cb.level].queue_bias;
+}
+
+size_t btif_a2dp_link_adapt_get_queue_limit(size_t max_limit,
+                                            size_t frames_n) {
+  link_adapt_cb.queue_max = max_limit;
+
+  size_t limit = link_adapt_cb.queue_limit;
+  if (limit == 0 || limit > max_limit) return max_limit;
+  size_t min_limit = std::min<size_t>(
+      max_limit, frames_n + BTIF_A2DP_LINK_ADAPT_QUEUE_HEADROOM);
+  return std::max(limit, min_limit);
+}
+
+void btif_a2dp_link_adapt_debug_dump(int fd) {
+  dprintf(fd, "\nA2DP Link Adaptation:\n");
+  dprintf(fd, "  Enabled link/queue: %s / %s  Active: %s\n",
+          link_adapt_cb.enabled ? "true" : "false",
+          link_adapt_cb.queue_enabled ? "true" : "false",
+          link_adapt_cb.active ? "true" : "false");
+  if (!link_adapt_cb.active) return;
+
+  uint8_t level = link_adapt_cb.level;
+  dprintf(fd, "  Peer: %s  Level: %s  Level changes: %u\n",
+          link_adapt_cb.peer_address.ToString().c_str(),
+          link_levels[level].name, link_adapt_cb.level_changes);
+  if (link_adapt_cb.original_flush_known)
+    dprintf(fd, "  Flush timeout original/current (ms): %u / %u\n",
+            link_adapt_cb.original_flush_ms,
+            btif_a2dp_link_adapt_flush_ms(level));
+  if (link_adapt_cb.rssi_valid)
+    dprintf(fd, "  Last RSSI: %d\n", link_adapt_cb.rssi);
+  if (link_adapt_cb.queue_enabled && link_adapt_cb.queue_limit != 0)
+    dprintf(fd,
+            "  TX queue limit current/max: %zu / %zu  Grows/shrinks: %u / "
+            "%u\n",
+            link_adapt_cb.queue_limit.load(), link_adapt_cb.queue_max.load(),
+            link_adapt_cb.queue_grows, link_adapt_cb.queue_shrinks);
+}
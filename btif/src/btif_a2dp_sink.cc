@@ -27,12 +27,14 @@
 
 #include "bt_common.h"
 #include "btif_a2dp.h"
+#include "btif_a2dp_jitter.h"
 #include "btif_a2dp_sink.h"
 #include "btif_av.h"
 #include "btif_av_co.h"
 #include "btif_avrcp_audio_track.h"
 #include "btif_util.h"
 #include "osi/include/fixed_queue.h"
+#include "osi/include/list.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/thread.h"
@@ -89,6 +91,7 @@ typedef struct {
   uint16_t offset;
   uint16_t layer_specific;
   uint64_t enque_ns;
+  uint32_t time_stamp; /* RTP timestamp */
 } tBT_SBC_HDR;
 
 extern uint64_t btif_update_reported_delay(uint64_t inst_delay);
@@ -119,6 +122,9 @@ static uint32_t btif_a2dp_sink_context_data[CODEC_DATA_WORDS(
     2, SBC_CODEC_FAST_FILTER_BUFFERS)];
 static int16_t
     btif_a2dp_sink_pcm_data[15 * SBC_MAX_SAMPLES_PER_FRAME * SBC_MAX_CHANNELS];
+/* Decoded audio after the clock drift correction of the jitter buffer */
+static int16_t btif_a2dp_sink_resampled_data[16 * SBC_MAX_SAMPLES_PER_FRAME *
+                                             SBC_MAX_CHANNELS];
 
 static void btif_a2dp_sink_startup_delayed(void* context);
 static void btif_a2dp_sink_shutdown_delayed(void* context);
@@ -221,6 +227,7 @@ void btif_a2dp_sink_shutdown(void) {
 }
 
 static void btif_a2dp_sink_shutdown_delayed(UNUSED_ATTR void* context) {
+  btif_a2dp_jitter_flush(osi_free);
   fixed_queue_free(btif_a2dp_sink_cb.rx_audio_queue, NULL);
   btif_a2dp_sink_cb.rx_audio_queue = NULL;
 
@@ -367,7 +374,9 @@ static void btif_a2dp_sink_audio_handle_start_decoding(void) {
 
 static void btif_a2dp_sink_handle_inc_media(tBT_SBC_HDR* p_msg) {
   uint8_t* sbc_start_frame = ((uint8_t*)(p_msg + 1) + p_msg->offset + 1);
+#ifndef OI_CODEC_SBC_DECODE_FRAMES
   int count;
+#endif
   uint32_t pcmBytes, availPcmBytes;
   int16_t* pcmDataPointer =
       btif_a2dp_sink_pcm_data; /* Will be overwritten on next packet receipt */
@@ -385,6 +394,21 @@ static void btif_a2dp_sink_handle_inc_media(tBT_SBC_HDR* p_msg) {
   APPL_TRACE_DEBUG("%s Number of SBC frames %d, frame_len %d", __func__,
                    num_sbc_frames, sbc_frame_len);
 
+#ifdef OI_CODEC_SBC_DECODE_FRAMES
+  /* Decode all frames of the packet with one call */
+  uint32_t frames = num_sbc_frames;
+  pcmBytes = availPcmBytes;
+  status = OI_CODEC_SBC_DecodeFrames(
+      &btif_a2dp_sink_context, (const OI_BYTE**)&sbc_start_frame,
+      &sbc_frame_len, pcmDataPointer, &pcmBytes, &frames);
+  if (!OI_SUCCESS(status)) {
+    APPL_TRACE_ERROR("%s: Decoding failure: %d after %u frames", __func__,
+                     status, frames);
+  }
+  availPcmBytes -= pcmBytes;
+  p_msg->offset += (p_msg->len - 1) - sbc_frame_len;
+  p_msg->len = sbc_frame_len + 1;
+#else
   for (count = 0; count < num_sbc_frames && sbc_frame_len != 0; count++) {
     pcmBytes = availPcmBytes;
     status = OI_CODEC_SBC_DecodeFrame(
@@ -400,14 +424,46 @@ static void btif_a2dp_sink_handle_inc_media(tBT_SBC_HDR* p_msg) {
     p_msg->offset += (p_msg->len - 1) - sbc_frame_len;
     p_msg->len = sbc_frame_len + 1;
   }
+#endif
+
+  void* p_pcm = btif_a2dp_sink_pcm_data;
+  uint32_t pcm_len = sizeof(btif_a2dp_sink_pcm_data) - availPcmBytes;
+  if (btif_a2dp_jitter_is_enabled()) {
+    /* The decoder always outputs 16-bit samples */
+    uint8_t channels = (uint8_t)btif_a2dp_sink_cb.channel_count;
+    size_t frame_size = channels * sizeof(int16_t);
+    size_t frames = btif_a2dp_jitter_resample(
+        btif_a2dp_sink_pcm_data, pcm_len / frame_size, channels,
+        btif_a2dp_sink_resampled_data,
+        sizeof(btif_a2dp_sink_resampled_data) / frame_size);
+    p_pcm = btif_a2dp_sink_resampled_data;
+    pcm_len = frames * frame_size;
+  }
 
 #ifndef OS_GENERIC
-  BtifAvrcpAudioTrackWriteData(
-      btif_a2dp_sink_cb.audio_track, (void*)btif_a2dp_sink_pcm_data,
-      (sizeof(btif_a2dp_sink_pcm_data) - availPcmBytes));
+  BtifAvrcpAudioTrackWriteData(btif_a2dp_sink_cb.audio_track, p_pcm, pcm_len);
 #endif
 }
 
+/* Moves the packets due for playout from the jitter buffer to the decoder
+ * queue until it holds the frames of one tick. */
+static void btif_a2dp_sink_jitter_dequeue(void) {
+  int queued_frames = 0;
+  list_t* list = fixed_queue_get_list(btif_a2dp_sink_cb.rx_audio_queue);
+  for (const list_node_t* node = list_begin(list); node != list_end(list);
+       node = list_next(node)) {
+    queued_frames +=
+        ((tBT_SBC_HDR*)list_node(node))->num_frames_to_be_processed;
+  }
+
+  while (queued_frames < btif_a2dp_sink_cb.frames_to_process) {
+    tBT_SBC_HDR* p_msg = (tBT_SBC_HDR*)btif_a2dp_jitter_get();
+    if (p_msg == NULL) break;
+    queued_frames += p_msg->num_frames_to_be_processed;
+    fixed_queue_enqueue(btif_a2dp_sink_cb.rx_audio_queue, p_msg);
+  }
+}
+
 static void btif_a2dp_sink_avk_handle_timer(UNUSED_ATTR void* context) {
   tBT_SBC_HDR* p_msg;
   int num_sbc_frames;
@@ -415,6 +471,11 @@ static void btif_a2dp_sink_avk_handle_timer(UNUSED_ATTR void* context) {
   uint64_t inst_delay = 0;       /* avg delay incurred per frame in 20 ms */
   uint64_t inst_delay_total = 0; /* sum of delay for all frames processed till now */
 
+  if (btif_a2dp_jitter_is_enabled() && !btif_a2dp_sink_cb.rx_flush &&
+      btif_a2dp_sink_cb.rx_focus_state == BTIF_A2DP_SINK_FOCUS_GRANTED) {
+    btif_a2dp_sink_jitter_dequeue();
+  }
+
   if (fixed_queue_is_empty(btif_a2dp_sink_cb.rx_audio_queue)) {
     APPL_TRACE_DEBUG("%s: empty queue", __func__);
     return;
@@ -429,6 +490,7 @@ static void btif_a2dp_sink_avk_handle_timer(UNUSED_ATTR void* context) {
   /* Play only in BTIF_A2DP_SINK_FOCUS_GRANTED case */
   if (btif_a2dp_sink_cb.rx_flush) {
     fixed_queue_flush(btif_a2dp_sink_cb.rx_audio_queue, osi_free);
+    btif_a2dp_jitter_flush(osi_free);
     return;
   }
 
@@ -478,6 +540,14 @@ static void btif_a2dp_sink_avk_handle_timer(UNUSED_ATTR void* context) {
     osi_free(p_msg);
   } while (num_frames_to_process > 0);
 
+#ifndef OS_GENERIC
+  uint64_t level_us, target_us;
+  if (BtifAvrcpAudioTrackGetRingLevel(btif_a2dp_sink_cb.audio_track, &level_us,
+                                      &target_us)) {
+    btif_a2dp_jitter_set_output_level(level_us, target_us);
+  }
+#endif
+
   if (btif_is_sink_delay_report_supported()) {
     inst_delay = inst_delay_total / btif_a2dp_sink_cb.frames_to_process;
     btif_update_reported_delay(inst_delay);
@@ -497,6 +567,7 @@ static void btif_a2dp_sink_audio_rx_flush_event(void) {
   APPL_TRACE_DEBUG("%s", __func__);
 
   fixed_queue_flush(btif_a2dp_sink_cb.rx_audio_queue, osi_free);
+  btif_a2dp_jitter_flush(osi_free);
 }
 
 static void btif_a2dp_sink_decoder_update_event(
@@ -540,6 +611,8 @@ static void btif_a2dp_sink_decoder_update_event(
   btif_a2dp_sink_cb.sample_rate = sample_rate;
   btif_a2dp_sink_cb.channel_count = channel_count;
   btif_a2dp_sink_cb.bits_per_sample = bits_per_sample;
+  /* The RTP clock of A2DP media runs at the sampling frequency */
+  btif_a2dp_jitter_init(sample_rate);
 
   btif_a2dp_sink_cb.rx_flush = false;
   APPL_TRACE_DEBUG("%s: Reset to Sink role", __func__);
@@ -586,7 +659,8 @@ uint8_t btif_a2dp_sink_enqueue_buf(BT_HDR* p_pkt) {
   if (btif_a2dp_sink_cb.rx_flush) /* Flush enabled, do not enqueue */
     return fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue);
 
-  if (fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue) ==
+  bool jitter_enabled = btif_a2dp_jitter_is_enabled();
+  if (!jitter_enabled && fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue) ==
       MAX_INPUT_A2DP_FRAME_QUEUE_SZ) {
     uint8_t ret = fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue);
     osi_free(fixed_queue_try_dequeue(btif_a2dp_sink_cb.rx_audio_queue));
@@ -604,13 +678,27 @@ uint8_t btif_a2dp_sink_enqueue_buf(BT_HDR* p_pkt) {
   p_msg->len = p_pkt->len;
   p_msg->offset = 0;
   p_msg->layer_specific = p_pkt->layer_specific;
+  p_msg->time_stamp = BTA_AvGetSinkMediaTimestamp(p_pkt);
 
-  if (btif_is_sink_delay_report_supported()) {
+  if (btif_is_sink_delay_report_supported() || jitter_enabled) {
     struct timespec ts_now;
     clock_gettime(CLOCK_BOOTTIME, &ts_now);
     p_msg->enque_ns = (uint64_t)ts_now.tv_sec * 1000000000 + ts_now.tv_nsec;
   }
 
+  if (jitter_enabled && btif_a2dp_sink_cb.frames_to_process != 0) {
+    uint64_t duration_us = (uint64_t)p_msg->num_frames_to_be_processed *
+                           BTIF_SINK_MEDIA_TIME_TICK_MS * 1000 /
+                           btif_a2dp_sink_cb.frames_to_process;
+    osi_free(btif_a2dp_jitter_put(p_msg, p_msg->time_stamp,
+                                  p_msg->layer_specific, duration_us,
+                                  p_msg->enque_ns / 1000));
+    if (btif_a2dp_jitter_is_playing()) {
+      btif_a2dp_sink_audio_handle_start_decoding();
+    }
+    return fixed_queue_length(btif_a2dp_sink_cb.rx_audio_queue);
+  }
+
   BTIF_TRACE_VERBOSE("%s: frames to process %d, len %d", __func__,
                      p_msg->num_frames_to_be_processed, p_msg->len);
   fixed_queue_enqueue(btif_a2dp_sink_cb.rx_audio_queue, p_msg);
@@ -624,7 +712,8 @@ uint8_t btif_a2dp_sink_enqueue_buf(BT_HDR* p_pkt) {
 }
 
 void btif_a2dp_sink_audio_rx_flush_req(void) {
-  if (fixed_queue_is_empty(btif_a2dp_sink_cb.rx_audio_queue)) {
+  if (fixed_queue_is_empty(btif_a2dp_sink_cb.rx_audio_queue) &&
+      !btif_a2dp_jitter_is_enabled()) {
     /* Queue is already empty */
     return;
   }
@@ -634,9 +723,7 @@ void btif_a2dp_sink_audio_rx_flush_req(void) {
   fixed_queue_enqueue(btif_a2dp_sink_cb.cmd_msg_queue, p_buf);
 }
 
-void btif_a2dp_sink_debug_dump(UNUSED_ATTR int fd) {
-  // Nothing to do
-}
+void btif_a2dp_sink_debug_dump(int fd) { btif_a2dp_jitter_debug_dump(fd); }
 
 void btif_a2dp_sink_set_focus_state_req(btif_a2dp_sink_focus_state_t state) {
   tBTIF_MEDIA_SINK_FOCUS_UPDATE* p_buf =
@@ -657,6 +744,7 @@ static void btif_a2dp_sink_set_focus_state_event(
   btif_a2dp_sink_cb.rx_focus_state = state;
   if (btif_a2dp_sink_cb.rx_focus_state == BTIF_A2DP_SINK_FOCUS_NOT_GRANTED) {
     fixed_queue_flush(btif_a2dp_sink_cb.rx_audio_queue, osi_free);
+    btif_a2dp_jitter_flush(osi_free);
     btif_a2dp_sink_cb.rx_flush = true;
   } else if (btif_a2dp_sink_cb.rx_focus_state == BTIF_A2DP_SINK_FOCUS_GRANTED) {
     btif_a2dp_sink_cb.rx_flush = false;
@@ -31,8 +31,10 @@
 #include <cutils/trace.h>
 #endif
 #include <limits.h>
+#include <sched.h>
 #include <string.h>
 #include <algorithm>
+#include <atomic>
 
 #if (OFF_TARGET_TEST_ENABLED == FALSE)
 #include "audio_hal_interface/a2dp_encoding.h"
@@ -49,15 +51,20 @@ using ::bluetooth::audio::a2dp::SessionType;
 #include "bta_av_ci.h"
 #include "btif_a2dp.h"
 #include "btif_a2dp_control.h"
+#include "btif_a2dp_latency.h"
+#include "btif_a2dp_link_adapt.h"
 #include "btif_a2dp_source.h"
 #include "btif_av.h"
 #include "btif_av_co.h"
 #include "btif_util.h"
+#include "osi/include/counters.h"
+#include "osi/include/debug_snapshot.h"
 #include "osi/include/fixed_queue.h"
 #include "osi/include/log.h"
 #include "osi/include/metrics.h"
 #include "osi/include/mutex.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
 #include "osi/include/thread.h"
 #include "osi/include/time.h"
 #include "uipc.h"
@@ -79,6 +86,20 @@ using system_bt_osi::A2dpSessionMetrics;
  */
 #define MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ (MAX_PCM_FRAME_NUM_PER_TICK * 2)
 #define BTIF_UNBLOCK_AUDIO_START_TOUT 3000
+
+/* Encode when a packet worth of PCM is queued and the link has room instead
+ * of on a fixed media tick */
+#define BTIF_A2DP_SOURCE_EVENT_SCHED_PROPERTY "persist.vendor.bt.a2dp.event_sched"
+
+/* Hand encoded packets to the BTA thread through a lock-free single
+ * producer/single consumer queue, and pin the media worker to a CPU */
+#define BTIF_A2DP_SOURCE_RT_HANDOFF_PROPERTY "persist.vendor.bt.a2dp.rt_handoff"
+#define BTIF_A2DP_SOURCE_ENCODER_CPU_PROPERTY \
+  "persist.vendor.bt.a2dp.encoder_cpu"
+
+/* Room for the largest dynamic TX queue plus packets that wait for the BTA
+ * thread to drop them after a flush */
+#define BTIF_A2DP_SOURCE_RT_TX_QUEUE_SZ 512
 #define BTIF_REMOTE_START_TOUT 3000
 enum {
   BTIF_A2DP_SOURCE_STATE_OFF,
@@ -134,6 +155,22 @@ static void btif_a2dp_source_shutdown_delayed(void* context);
 static uint8_t btif_a2dp_source_dynamic_audio_buffer_size =
     MAX_OUTPUT_A2DP_FRAME_QUEUE_SZ;
 
+/* Set by the event driven scheduler when the TX queue is full; the next
+ * dequeue by the lower layer kicks the media task. Read from the BTA thread. */
+static std::atomic<bool> btif_a2dp_source_credit_wait(false);
+
+/* With the lock-free handoff only the BTA thread may dequeue from the TX
+ * queue. Other threads flush it by moving the flush mark up to the number of
+ * packets enqueued so far; the BTA thread drops packets below the mark. */
+static std::atomic<uint64_t> btif_a2dp_source_tx_enqueued(0);
+static std::atomic<uint64_t> btif_a2dp_source_tx_dequeued(0);
+static std::atomic<uint64_t> btif_a2dp_source_tx_flush_mark(0);
+
+/* Lifetime counters; |btif_a2dp_source_cb.stats| only covers a session */
+static counters_metric_t* btif_a2dp_source_encode_us;
+static counters_metric_t* btif_a2dp_source_tx_dropouts;
+static counters_metric_t* btif_a2dp_source_tx_dropped_packets;
+
 static void btif_a2dp_source_audio_tx_start_event(void);
 static void btif_a2dp_source_audio_tx_stop_event(void);
 static void btif_a2dp_source_audio_tx_flush_event(BT_HDR* p_msg);
@@ -146,6 +183,9 @@ static void btif_a2dp_source_encoder_init_req(
 static bool btif_a2dp_source_audio_tx_flush_req(void);
 static void btif_a2dp_source_alarm_cb(void* context);
 static void btif_a2dp_source_audio_handle_timer(void* context);
+static uint32_t btif_a2dp_source_pcm_rate(void);
+static size_t btif_a2dp_source_tx_queue_length(void);
+static size_t btif_a2dp_source_tx_queue_flush(void);
 static uint32_t btif_a2dp_source_read_callback(uint8_t* p_buf, uint32_t len);
 static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
                                               uint32_t bytes_read);
@@ -240,6 +280,16 @@ void btif_a2dp_source_accumulate_stats(btif_media_stats_t* src,
   dst->media_read_total_underflow_count +=
       src->media_read_total_underflow_count;
   dst->media_read_last_underflow_us = src->media_read_last_underflow_us;
+  dst->sched_credit_waits += src->sched_credit_waits;
+  dst->sched_pcm_waits += src->sched_pcm_waits;
+  if (src->encode_count != 0 &&
+      (dst->encode_count == 0 ||
+       src->encode_min_headroom_us < dst->encode_min_headroom_us))
+    dst->encode_min_headroom_us = src->encode_min_headroom_us;
+  dst->encode_count += src->encode_count;
+  dst->encode_total_us += src->encode_total_us;
+  dst->encode_max_us = std::max(dst->encode_max_us, src->encode_max_us);
+  dst->encode_overruns += src->encode_overruns;
   btif_a2dp_source_accumulate_scheduling_stats(&src->tx_queue_enqueue_stats,
                                                &dst->tx_queue_enqueue_stats);
   btif_a2dp_source_accumulate_scheduling_stats(&src->tx_queue_dequeue_stats,
@@ -255,6 +305,13 @@ bool btif_a2dp_source_startup(void) {
 
   memset(&btif_a2dp_source_cb, 0, sizeof(btif_a2dp_source_cb));
   btif_a2dp_source_state = BTIF_A2DP_SOURCE_STATE_STARTING_UP;
+
+  btif_a2dp_source_encode_us =
+      counters_register_histogram("a2dp_source", "encode", "us");
+  btif_a2dp_source_tx_dropouts =
+      counters_register_counter("a2dp_source", "tx_dropouts");
+  btif_a2dp_source_tx_dropped_packets =
+      counters_register_counter("a2dp_source", "tx_dropped_packets");
   btif_a2dp_source_cb.last_remote_started_index = -1;
   btif_a2dp_source_cb.last_started_index_pointer = NULL;
   APPL_TRACE_EVENT("## A2DP SOURCE START MEDIA THREAD ##");
@@ -268,7 +325,23 @@ bool btif_a2dp_source_startup(void) {
     return false;
   }
 
-  btif_a2dp_source_cb.tx_audio_queue = fixed_queue_new(SIZE_MAX);
+  btif_a2dp_source_cb.rt_handoff =
+      osi_property_get_bool(BTIF_A2DP_SOURCE_RT_HANDOFF_PROPERTY, false);
+  btif_a2dp_source_cb.encoder_cpu = -1;
+  btif_a2dp_source_tx_enqueued = 0;
+  btif_a2dp_source_tx_dequeued = 0;
+  btif_a2dp_source_tx_flush_mark = 0;
+  if (btif_a2dp_source_cb.rt_handoff) {
+    btif_a2dp_source_cb.tx_audio_queue =
+        fixed_queue_new_spsc(BTIF_A2DP_SOURCE_RT_TX_QUEUE_SZ);
+    if (btif_a2dp_source_cb.tx_audio_queue == NULL) {
+      APPL_TRACE_WARNING("%s: no lock-free TX queue, using a locked queue",
+                         __func__);
+      btif_a2dp_source_cb.rt_handoff = false;
+    }
+  }
+  if (!btif_a2dp_source_cb.rt_handoff)
+    btif_a2dp_source_cb.tx_audio_queue = fixed_queue_new(SIZE_MAX);
 
   btif_a2dp_source_cb.cmd_msg_queue = fixed_queue_new(SIZE_MAX);
   fixed_queue_register_dequeue(
@@ -289,6 +362,20 @@ static void btif_a2dp_source_startup_delayed(UNUSED_ATTR void* context) {
 #if (OFF_TARGET_TEST_ENABLED == FALSE)
   raise_priority_a2dp(TASK_HIGH_MEDIA);
 #endif
+  if (btif_a2dp_source_cb.rt_handoff) {
+    int cpu = osi_property_get_int32(BTIF_A2DP_SOURCE_ENCODER_CPU_PROPERTY, -1);
+    if (cpu >= 0 && cpu < CPU_SETSIZE) {
+      cpu_set_t cpu_set;
+      CPU_ZERO(&cpu_set);
+      CPU_SET(cpu, &cpu_set);
+      if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) == 0) {
+        btif_a2dp_source_cb.encoder_cpu = cpu;
+      } else {
+        APPL_TRACE_ERROR("%s: unable to pin the media worker to CPU %d: %s",
+                         __func__, cpu, strerror(errno));
+      }
+    }
+  }
   if (!btif_a2dp_source_is_hal_v2_supported()) {
     btif_a2dp_control_init();
   }
@@ -360,10 +447,17 @@ bool btif_a2dp_source_media_task_is_shutting_down(void) {
   return (btif_a2dp_source_state == BTIF_A2DP_SOURCE_STATE_SHUTTING_DOWN);
 }
 
-bool btif_a2dp_source_is_streaming(void) {
+/* The media alarm is one-shot in event driven mode, so it is not armed while
+ * an encode is running or a credit kick is pending. */
+static bool btif_a2dp_source_media_running(void) {
+  if (btif_a2dp_source_cb.event_sched) return btif_a2dp_source_cb.media_running;
   return alarm_is_scheduled(btif_a2dp_source_cb.media_alarm);
 }
 
+bool btif_a2dp_source_is_streaming(void) {
+  return btif_a2dp_source_media_running();
+}
+
 bool btif_a2dp_source_is_remote_start(void) {
   return alarm_is_scheduled(btif_a2dp_source_cb.remote_start_alarm);
 }
@@ -954,7 +1048,7 @@ void btif_a2dp_source_set_tx_flush(bool enable) {
 static void btif_a2dp_source_audio_tx_start_event(void) {
   APPL_TRACE_DEBUG(
       "%s media_alarm is %srunning, streaming %s", __func__,
-      alarm_is_scheduled(btif_a2dp_source_cb.media_alarm) ? "" : "not ",
+      btif_a2dp_source_media_running() ? "" : "not ",
       btif_a2dp_source_is_streaming() ? "true" : "false");
 
   /* Reset the media feeding state */
@@ -965,23 +1059,39 @@ static void btif_a2dp_source_audio_tx_start_event(void) {
       "starting timer %dms",
       btif_a2dp_source_cb.encoder_interface->get_encoder_interval_ms());
 
+  btif_a2dp_source_cb.event_sched =
+      osi_property_get_bool(BTIF_A2DP_SOURCE_EVENT_SCHED_PROPERTY, false);
+  btif_a2dp_source_cb.pcm_bytes_per_sec = btif_a2dp_source_pcm_rate();
+  btif_a2dp_source_cb.last_encode_us = time_get_os_boottime_us();
+  btif_a2dp_source_credit_wait = false;
+  btif_a2dp_latency_reset();
+
   alarm_free(btif_a2dp_source_cb.media_alarm);
   btif_a2dp_source_cb.media_alarm =
-      alarm_new_periodic("btif.a2dp_source_media_alarm");
+      btif_a2dp_source_cb.event_sched
+          ? alarm_new("btif.a2dp_source_media_alarm")
+          : alarm_new_periodic("btif.a2dp_source_media_alarm");
   if (btif_a2dp_source_cb.media_alarm == NULL) {
     LOG_ERROR(LOG_TAG, "%s unable to allocate media alarm", __func__);
     return;
   }
+  btif_a2dp_source_cb.media_running = true;
 
   alarm_set(btif_a2dp_source_cb.media_alarm,
             btif_a2dp_source_cb.encoder_interface->get_encoder_interval_ms(),
             btif_a2dp_source_alarm_cb, NULL);
+
+  RawAddress peer_bda;
+  btif_av_get_active_peer_addr(&peer_bda);
+  btif_a2dp_link_adapt_start(
+      peer_bda,
+      btif_a2dp_source_cb.encoder_interface->get_encoder_interval_ms());
 }
 
 static void btif_a2dp_source_audio_tx_stop_event(void) {
   APPL_TRACE_DEBUG(
       "%s media_alarm is %srunning, streaming %s", __func__,
-      alarm_is_scheduled(btif_a2dp_source_cb.media_alarm) ? "" : "not ",
+      btif_a2dp_source_media_running() ? "" : "not ",
       btif_a2dp_source_is_streaming() ? "true" : "false");
 
   uint8_t p_buf[AUDIO_STREAM_OUTPUT_BUFFER_SZ * 2];
@@ -1003,8 +1113,11 @@ static void btif_a2dp_source_audio_tx_stop_event(void) {
 
 
   /* Stop the timer first */
+  btif_a2dp_source_cb.media_running = false;
+  btif_a2dp_source_credit_wait = false;
   alarm_free(btif_a2dp_source_cb.media_alarm);
   btif_a2dp_source_cb.media_alarm = NULL;
+  btif_a2dp_link_adapt_stop();
 
   if (!btif_a2dp_source_is_hal_v2_supported()) {
     UIPC_Close(UIPC_CH_ID_AV_AUDIO);
@@ -1071,24 +1184,141 @@ static void btif_a2dp_source_alarm_cb(UNUSED_ATTR void* context) {
               btif_a2dp_source_audio_handle_timer, NULL);
 }
 
+/* Returns the PCM feeding rate of the current codec in bytes per second, or 0
+ * if it is not known. */
+static uint32_t btif_a2dp_source_pcm_rate(void) {
+  A2dpCodecConfig* a2dp_codec_config = bta_av_get_a2dp_current_codec();
+  uint8_t codec_info[AVDT_CODEC_SIZE];
+
+  if (a2dp_codec_config == nullptr ||
+      !a2dp_codec_config->copyOutOtaCodecConfig(codec_info))
+    return 0;
+
+  int sample_rate = A2DP_GetTrackSampleRate(codec_info);
+  int bits_per_sample = A2DP_GetTrackBitsPerSample(codec_info);
+  int channel_count = A2DP_GetTrackChannelCount(codec_info);
+  if (sample_rate <= 0 || bits_per_sample <= 0 || channel_count <= 0) return 0;
+
+  return sample_rate * channel_count * bits_per_sample / 8;
+}
+
+/* Arms the one-shot media alarm of the event driven scheduler. */
+static void btif_a2dp_source_schedule_encode(period_ms_t delay_ms) {
+  if (btif_a2dp_source_cb.media_alarm == NULL) return;
+  alarm_set(btif_a2dp_source_cb.media_alarm, std::max<period_ms_t>(delay_ms, 1),
+            btif_a2dp_source_alarm_cb, NULL);
+}
+
+/*******************************************************************************
+ *
+ * Function         btif_a2dp_source_ready_to_encode
+ *
+ * Description      Decides in event driven mode whether to encode now. Defers
+ *                  while the TX queue is full until the lower layer pulls a
+ *                  packet, and while the audio HAL has not queued the PCM the
+ *                  encoder is going to read for the time elapsed, for up to
+ *                  one encoder interval. The media alarm is re-armed for the
+ *                  deferred encode.
+ *
+ * Returns          true if the encoder should run now
+ *
+ ******************************************************************************/
+static bool btif_a2dp_source_ready_to_encode(uint64_t now_us) {
+  period_ms_t interval_ms = btif_a2dp_source_cb.encoder_interval_ms;
+  size_t credit_limit = std::max<size_t>(
+      btif_a2dp_link_adapt_get_queue_limit(
+          btif_a2dp_source_dynamic_audio_buffer_size, 0) /
+          2,
+      1);
+
+  if (btif_a2dp_source_tx_queue_length() >= credit_limit) {
+    /* the alarm only backs up a missing dequeue kick */
+    btif_a2dp_source_credit_wait = true;
+    btif_a2dp_source_cb.stats.sched_credit_waits++;
+    btif_a2dp_source_schedule_encode(interval_ms);
+    return false;
+  }
+  btif_a2dp_source_credit_wait = false;
+
+  uint64_t elapsed_us = now_us - btif_a2dp_source_cb.last_encode_us;
+  uint32_t available = 0;
+  if (btif_a2dp_source_cb.pcm_bytes_per_sec == 0 ||
+      btif_a2dp_source_is_hal_v2_supported() ||
+      !UIPC_Ioctl(UIPC_CH_ID_AV_AUDIO, UIPC_REQ_RX_AVAILABLE, &available) ||
+      elapsed_us >= 2 * interval_ms * 1000)
+    return true;
+
+  uint64_t needed =
+      elapsed_us * btif_a2dp_source_cb.pcm_bytes_per_sec / 1000000;
+  if (available >= needed) return true;
+
+  btif_a2dp_source_cb.stats.sched_pcm_waits++;
+  uint64_t missing_ms = (needed - available) * 1000 /
+                        btif_a2dp_source_cb.pcm_bytes_per_sec;
+  btif_a2dp_source_schedule_encode(
+      std::min<uint64_t>(missing_ms + 1, interval_ms));
+  return false;
+}
+
+// Records how long a media task run took to encode and how much of the
+// encoder interval was left.
+static void btif_a2dp_source_update_encode_stats(uint64_t encode_us) {
+  btif_media_stats_t* stats = &btif_a2dp_source_cb.stats;
+  uint64_t interval_us = btif_a2dp_source_cb.encoder_interval_ms * 1000;
+  uint64_t headroom_us = (encode_us < interval_us) ? interval_us - encode_us : 0;
+
+  if (stats->encode_count == 0 || headroom_us < stats->encode_min_headroom_us)
+    stats->encode_min_headroom_us = headroom_us;
+  stats->encode_count++;
+  stats->encode_total_us += encode_us;
+  stats->encode_max_us = std::max(stats->encode_max_us, encode_us);
+  if (encode_us > interval_us) stats->encode_overruns++;
+  counters_histogram_record(btif_a2dp_source_encode_us, encode_us);
+  btif_a2dp_latency_update(BTIF_A2DP_LATENCY_ENCODER, encode_us);
+}
+
+// Samples how long the PCM the encoder is about to read has been waiting in
+// the audio socket. With the audio HAL v2 the HAL accounts for its own
+// buffer.
+static void btif_a2dp_source_update_pcm_latency(void) {
+  uint32_t available = 0;
+  if (btif_a2dp_source_cb.pcm_bytes_per_sec == 0 ||
+      btif_a2dp_source_is_hal_v2_supported() ||
+      !UIPC_Ioctl(UIPC_CH_ID_AV_AUDIO, UIPC_REQ_RX_AVAILABLE, &available))
+    return;
+
+  btif_a2dp_latency_update(
+      BTIF_A2DP_LATENCY_PCM,
+      (uint64_t)available * 1000000 / btif_a2dp_source_cb.pcm_bytes_per_sec);
+}
+
 static void btif_a2dp_source_audio_handle_timer(UNUSED_ATTR void* context) {
   uint64_t timestamp_us = time_get_os_boottime_us();
   int curr_idx = btif_av_get_latest_device_idx_to_start();
   log_tstamps_us("A2DP Source tx timer", timestamp_us);
 
-  if (alarm_is_scheduled(btif_a2dp_source_cb.media_alarm)) {
+  if (btif_a2dp_source_media_running()) {
     CHECK(btif_a2dp_source_cb.encoder_interface != NULL);
-    size_t transmit_queue_length =
-        fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
+    if (btif_a2dp_source_cb.event_sched) {
+      if (!btif_a2dp_source_ready_to_encode(timestamp_us)) return;
+      btif_a2dp_source_cb.last_encode_us = timestamp_us;
+      btif_a2dp_source_schedule_encode(btif_a2dp_source_cb.encoder_interval_ms);
+    }
+    size_t transmit_queue_length = btif_a2dp_source_tx_queue_length();
 #ifndef OS_GENERIC
     ATRACE_INT("btif TX queue", transmit_queue_length);
 #endif
+    size_t reported_queue_length =
+        btif_a2dp_link_adapt_get_queue_length(transmit_queue_length);
     if (btif_a2dp_source_cb.encoder_interface->set_transmit_queue_length !=
         NULL) {
       btif_a2dp_source_cb.encoder_interface->set_transmit_queue_length(
-          transmit_queue_length);
+          reported_queue_length);
     }
+    btif_a2dp_source_update_pcm_latency();
     btif_a2dp_source_cb.encoder_interface->send_frames(timestamp_us);
+    btif_a2dp_source_update_encode_stats(time_get_os_boottime_us() -
+                                         timestamp_us);
     if (btif_av_check_flag_remote_suspend(curr_idx) || btif_a2dp_source_cb.tx_flush) {
       APPL_TRACE_ERROR("Don't signal data ready BTU task since remote suspended or tx_flush = %d", btif_a2dp_source_cb.tx_flush);
     } else {
@@ -1136,7 +1366,7 @@ static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
   APPL_TRACE_DEBUG("%s: tx_flush: %d", __func__, btif_a2dp_source_cb.tx_flush);
 
   /* Check if timer was stopped (media task stopped) */
-  if (!alarm_is_scheduled(btif_a2dp_source_cb.media_alarm)) {
+  if (!btif_a2dp_source_media_running()) {
     osi_free(p_buf);
     return false;
   }
@@ -1146,9 +1376,8 @@ static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
     LOG_DEBUG(LOG_TAG, "%s: tx suspended %d or remote suspended, discarded frame", __func__, btif_a2dp_source_cb.tx_flush);
 
     btif_a2dp_source_cb.stats.tx_queue_total_flushed_messages +=
-        fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
+        btif_a2dp_source_tx_queue_flush();
     btif_a2dp_source_cb.stats.tx_queue_last_flushed_us = now_us;
-    fixed_queue_flush(btif_a2dp_source_cb.tx_audio_queue, osi_free);
 
     osi_free(p_buf);
     return false;
@@ -1156,24 +1385,24 @@ static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
 
   // Check for TX queue overflow
   // TODO: Using frames_n here is probably wrong: should be "+ 1" instead.
-  if (fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue) + frames_n >
-      btif_a2dp_source_dynamic_audio_buffer_size) {
-    LOG_DEBUG(LOG_TAG, "%s: TX queue buffer size now=%u adding=%u max=%d",
-             __func__,
-             (uint32_t)fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue),
-             (uint32_t)frames_n, btif_a2dp_source_dynamic_audio_buffer_size);
+  size_t queue_limit = btif_a2dp_link_adapt_get_queue_limit(
+      btif_a2dp_source_dynamic_audio_buffer_size, frames_n);
+  if (btif_a2dp_source_tx_queue_length() + frames_n > queue_limit) {
+    LOG_DEBUG(LOG_TAG, "%s: TX queue buffer size now=%u adding=%u max=%u",
+             __func__, (uint32_t)btif_a2dp_source_tx_queue_length(),
+             (uint32_t)frames_n, (uint32_t)queue_limit);
     // Keep track of drop-outs
     btif_a2dp_source_cb.stats.tx_queue_dropouts++;
     btif_a2dp_source_cb.stats.tx_queue_last_dropouts_us = now_us;
+    counters_increment(btif_a2dp_source_tx_dropouts);
+    btif_a2dp_link_adapt_on_tx_dropout();
 
     // Flush all queued buffers
-    size_t drop_n = fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
+    size_t drop_n = btif_a2dp_source_tx_queue_flush();
     btif_a2dp_source_cb.stats.tx_queue_max_dropped_messages = std::max(
         drop_n, btif_a2dp_source_cb.stats.tx_queue_max_dropped_messages);
-    while (fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue)) {
-      btif_a2dp_source_cb.stats.tx_queue_total_dropped_messages++;
-      osi_free(fixed_queue_try_dequeue(btif_a2dp_source_cb.tx_audio_queue));
-    }
+    btif_a2dp_source_cb.stats.tx_queue_total_dropped_messages += drop_n;
+    counters_add(btif_a2dp_source_tx_dropped_packets, drop_n);
 
     // Request RSSI and Failed Contact Counter for log purposes if we had to
     // flush buffers.
@@ -1210,11 +1439,57 @@ static bool btif_a2dp_source_enqueue_callback(BT_HDR* p_buf, size_t frames_n,
       frames_n, btif_a2dp_source_cb.stats.tx_queue_max_frames_per_packet);
   CHECK(btif_a2dp_source_cb.encoder_interface != NULL);
 
+  /* the new packet waits for the media time of the packets ahead of it */
+  if (btif_a2dp_source_cb.pcm_bytes_per_sec != 0) {
+    btif_a2dp_latency_update(
+        BTIF_A2DP_LATENCY_TX_QUEUE,
+        (uint64_t)btif_a2dp_source_tx_queue_length() * bytes_read * 1000000 /
+            btif_a2dp_source_cb.pcm_bytes_per_sec);
+  }
+
+  if (btif_a2dp_source_cb.rt_handoff) {
+    /* never block the media worker, drop the packet if the BTA thread is
+     * too far behind */
+    if (!fixed_queue_try_enqueue(btif_a2dp_source_cb.tx_audio_queue, p_buf)) {
+      btif_a2dp_source_cb.stats.tx_queue_total_dropped_messages++;
+      counters_increment(btif_a2dp_source_tx_dropped_packets);
+      osi_free(p_buf);
+      return false;
+    }
+    btif_a2dp_source_tx_enqueued++;
+    return true;
+  }
+
   fixed_queue_enqueue(btif_a2dp_source_cb.tx_audio_queue, p_buf);
 
   return true;
 }
 
+// Returns the number of packets in the TX queue that are going to be sent.
+static size_t btif_a2dp_source_tx_queue_length(void) {
+  size_t length = fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
+  if (!btif_a2dp_source_cb.rt_handoff) return length;
+
+  uint64_t dequeued = btif_a2dp_source_tx_dequeued;
+  uint64_t flush_mark = btif_a2dp_source_tx_flush_mark;
+  if (flush_mark <= dequeued) return length;
+  uint64_t flushed = flush_mark - dequeued;
+  return (length > flushed) ? length - flushed : 0;
+}
+
+// Flushes the TX queue and returns the number of packets dropped. With the
+// lock-free handoff the packets are dropped by the BTA thread on its next
+// read.
+static size_t btif_a2dp_source_tx_queue_flush(void) {
+  size_t length = btif_a2dp_source_tx_queue_length();
+  if (btif_a2dp_source_cb.rt_handoff) {
+    btif_a2dp_source_tx_flush_mark = btif_a2dp_source_tx_enqueued.load();
+  } else {
+    fixed_queue_flush(btif_a2dp_source_cb.tx_audio_queue, osi_free);
+  }
+  return length;
+}
+
 static void btif_a2dp_source_audio_tx_flush_event(UNUSED_ATTR BT_HDR* p_msg) {
   /* Flush all enqueued audio buffers (encoded) */
   APPL_TRACE_DEBUG("%s", __func__);
@@ -1223,10 +1498,9 @@ static void btif_a2dp_source_audio_tx_flush_event(UNUSED_ATTR BT_HDR* p_msg) {
     btif_a2dp_source_cb.encoder_interface->feeding_flush();
 
   btif_a2dp_source_cb.stats.tx_queue_total_flushed_messages +=
-      fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue);
+      btif_a2dp_source_tx_queue_flush();
   btif_a2dp_source_cb.stats.tx_queue_last_flushed_us =
       time_get_os_boottime_us();
-  fixed_queue_flush(btif_a2dp_source_cb.tx_audio_queue, osi_free);
 
   if (!btif_a2dp_source_is_hal_v2_supported()) {
     UIPC_Ioctl(UIPC_CH_ID_AV_AUDIO, UIPC_REQ_RX_FLUSH, NULL);
@@ -1256,8 +1530,21 @@ static bool btif_a2dp_source_audio_tx_flush_req(void) {
 
 BT_HDR* btif_a2dp_source_audio_readbuf(void) {
   uint64_t now_us = time_get_os_boottime_us();
+  if (btif_a2dp_source_cb.rt_handoff) {
+    /* drop what was flushed since the last read */
+    uint64_t flush_mark = btif_a2dp_source_tx_flush_mark;
+    while (btif_a2dp_source_tx_dequeued < flush_mark) {
+      void* p_flushed =
+          fixed_queue_try_dequeue(btif_a2dp_source_cb.tx_audio_queue);
+      if (p_flushed == NULL) break;
+      osi_free(p_flushed);
+      btif_a2dp_source_tx_dequeued++;
+    }
+  }
   BT_HDR* p_buf =
       (BT_HDR*)fixed_queue_try_dequeue(btif_a2dp_source_cb.tx_audio_queue);
+  if (p_buf != NULL && btif_a2dp_source_cb.rt_handoff)
+    btif_a2dp_source_tx_dequeued++;
   APPL_TRACE_DEBUG("%s:", __func__);
   btif_a2dp_source_cb.stats.tx_queue_total_readbuf_calls++;
   btif_a2dp_source_cb.stats.tx_queue_last_readbuf_us = now_us;
@@ -1267,6 +1554,11 @@ BT_HDR* btif_a2dp_source_audio_readbuf(void) {
     update_scheduling_stats(&btif_a2dp_source_cb.stats.tx_queue_dequeue_stats,
                             now_us,
                             btif_a2dp_source_cb.encoder_interval_ms * 1000);
+
+    /* the link made room, run the encode the event scheduler deferred */
+    if (btif_a2dp_source_credit_wait.exchange(false))
+      thread_post(btif_a2dp_source_cb.worker_thread,
+                  btif_a2dp_source_audio_handle_timer, NULL);
   }
 
   return p_buf;
@@ -1276,7 +1568,7 @@ static void log_tstamps_us(const char* comment, uint64_t timestamp_us) {
   static uint64_t prev_us = 0;
   APPL_TRACE_DEBUG("[%s] ts %08llu, diff : %08llu, queue sz %d", comment,
                    timestamp_us, timestamp_us - prev_us,
-                   fixed_queue_length(btif_a2dp_source_cb.tx_audio_queue));
+                   btif_a2dp_source_tx_queue_length());
   prev_us = timestamp_us;
 }
 
@@ -1319,12 +1611,40 @@ static void update_scheduling_stats(scheduling_stats_t* stats, uint64_t now_us,
   }
 }
 
-void btif_a2dp_source_debug_dump(int fd) {
+// Stats shown by the dump, copied on the worker thread that updates them
+typedef struct {
+  btif_media_stats_t accumulated_stats;
+  bool event_sched;
+  bool rt_handoff;
+  int encoder_cpu;
+} btif_a2dp_source_dump_snapshot_t;
+
+static void btif_a2dp_source_take_dump_snapshot(
+    btif_a2dp_source_dump_snapshot_t* snapshot) {
   btif_a2dp_source_accumulate_stats(&btif_a2dp_source_cb.stats,
                                     &btif_a2dp_source_cb.accumulated_stats);
+  snapshot->accumulated_stats = btif_a2dp_source_cb.accumulated_stats;
+  snapshot->event_sched = btif_a2dp_source_cb.event_sched;
+  snapshot->rt_handoff = btif_a2dp_source_cb.rt_handoff;
+  snapshot->encoder_cpu = btif_a2dp_source_cb.encoder_cpu;
+}
+
+void btif_a2dp_source_debug_dump(int fd) {
+  dprintf(fd, "\nA2DP State:\n");
+
+  // The stats are copied on the worker thread, between two encoder ticks,
+  // and formatted here.
+  std::shared_ptr<btif_a2dp_source_dump_snapshot_t> snapshot =
+      debug_snapshot_take<btif_a2dp_source_dump_snapshot_t>(
+          btif_a2dp_source_cb.worker_thread,
+          btif_a2dp_source_take_dump_snapshot);
+  if (snapshot == nullptr) {
+    dprintf(fd, "  Worker thread busy, stats unavailable\n");
+    return;
+  }
+
   uint64_t now_us = time_get_os_boottime_us();
-  btif_media_stats_t* accumulated_stats =
-      &btif_a2dp_source_cb.accumulated_stats;
+  btif_media_stats_t* accumulated_stats = &snapshot->accumulated_stats;
   scheduling_stats_t* enqueue_stats =
       &accumulated_stats->tx_queue_enqueue_stats;
   scheduling_stats_t* dequeue_stats =
@@ -1332,7 +1652,6 @@ void btif_a2dp_source_debug_dump(int fd) {
   size_t ave_size;
   uint64_t ave_time_us;
 
-  dprintf(fd, "\nA2DP State:\n");
   dprintf(fd, "  TxQueue:\n");
 
   dprintf(fd,
@@ -1410,6 +1729,34 @@ void btif_a2dp_source_debug_dump(int fd) {
                     1000
               : 0);
 
+  dprintf(fd,
+          "  Event scheduler (enabled/credit waits/PCM waits)        : %s / "
+          "%zu / %zu\n",
+          snapshot->event_sched ? "true" : "false",
+          accumulated_stats->sched_credit_waits,
+          accumulated_stats->sched_pcm_waits);
+
+  dprintf(fd,
+          "  Lock-free handoff (enabled/encoder CPU)                 : %s / "
+          "%d\n",
+          snapshot->rt_handoff ? "true" : "false", snapshot->encoder_cpu);
+
+  ave_time_us = 0;
+  if (accumulated_stats->encode_count != 0)
+    ave_time_us =
+        accumulated_stats->encode_total_us / accumulated_stats->encode_count;
+  dprintf(fd,
+          "  Encode time in us (ave/max/min headroom)                : %llu / "
+          "%llu / %llu\n",
+          (unsigned long long)ave_time_us,
+          (unsigned long long)accumulated_stats->encode_max_us,
+          (unsigned long long)accumulated_stats->encode_min_headroom_us);
+
+  dprintf(fd,
+          "  Counts (encodes/overruns)                               : %zu / "
+          "%zu\n",
+          accumulated_stats->encode_count, accumulated_stats->encode_overruns);
+
   //
   // TxQueue enqueue stats
   //
@@ -1493,6 +1840,9 @@ void btif_a2dp_source_debug_dump(int fd) {
   if (a2dp_codecs != nullptr) {
     a2dp_codecs->debug_codec_dump(fd);
   }
+
+  btif_a2dp_link_adapt_debug_dump(fd);
+  btif_a2dp_latency_debug_dump(fd);
 }
 
 void btif_a2dp_source_update_metrics(void) {
@@ -1665,7 +2015,7 @@ bool btif_a2dp_source_start_session(const RawAddress& peer_address) {
 #endif
        SessionType::A2DP_SOFTWARE_ENCODING_DATAPATH) {
       APPL_TRACE_EVENT("%s Freeing queue from previous session", __func__);
-      fixed_queue_flush(btif_a2dp_source_cb.tx_audio_queue, osi_free);
+      btif_a2dp_source_tx_queue_flush();
     }
   }
   btif_a2dp_update_sink_latency_change();
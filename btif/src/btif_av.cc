@@ -104,8 +104,10 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE
 #include "btif_av_co.h"
 #include "btif_profile_queue.h"
 #include "btif_util.h"
+#include "btm_conn_trace.h"
 #include "btu.h"
 #include "osi/include/allocator.h"
+#include "osi/include/footprint.h"
 #include "osi/include/osi.h"
 #include "osi/include/properties.h"
 #include "btif/include/btif_a2dp_source.h"
@@ -255,6 +257,8 @@ typedef struct {
   bool fake_suspend_rsp;
   bool is_retry_reconfig;
   bool suspend_for_call;
+  uint32_t num_events;        /* events handled since the peer connected */
+  btif_sm_event_t last_event;
 } btif_av_cb_t;
 
 typedef struct {
@@ -614,6 +618,8 @@ static void btif_av_disconnect_queue_advance_by_uuid(const RawAddress* bd_addr)
  ******************************************************************************/
 static void btif_report_connection_state(btav_connection_state_t state,
                                          RawAddress* bd_addr) {
+  if (state == BTAV_CONNECTION_STATE_CONNECTED)
+    btm_conn_trace_profile_connected(*bd_addr, BT_TRANSPORT_BR_EDR, "A2DP");
   if (bt_av_sink_callbacks != NULL) {
     HAL_CBACK(bt_av_sink_callbacks, connection_state_cb, *bd_addr, state,
       btav_error_t{.status = bt_status_t::BT_STATUS_SUCCESS, .error_code = BTA_AV_SUCCESS});
@@ -690,6 +696,34 @@ void btif_av_peer_config_dump()
    }
 }
 
+/*******************************************************************************
+ *
+ * Function         btif_av_debug_dump
+ *
+ * Description      Dumps the state of each AV peer
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btif_av_debug_dump(int fd) {
+  dprintf(fd, "\nA2DP Peers:\n");
+  for (int i = 0; i < btif_max_av_clients; i++) {
+    const btif_av_cb_t& cb = btif_av_cb[i];
+    if (cb.sm_handle == NULL) continue;
+    btif_sm_state_t state = btif_sm_get_state(cb.sm_handle);
+    dprintf(fd, "  [%d] %s state: %s flags: 0x%x\n", i,
+            cb.peer_bda.ToString().c_str(),
+            dump_av_sm_state_name((btif_av_state_t)state), cb.flags);
+    dprintf(fd,
+            "      current_playing: %d remote_started: %d events: %u last: "
+            "%s\n",
+            cb.current_playing, cb.remote_started, cb.num_events,
+            cb.num_events ? dump_av_sm_event_name(
+                                (btif_av_sm_event_t)cb.last_event)
+                          : "none");
+  }
+}
+
 static void btif_update_source_codec(void* p_data) {
   BTIF_TRACE_DEBUG("%s:", __func__);
 
@@ -1086,6 +1120,7 @@ static bool btif_av_state_idle_handler(btif_sm_event_t event, void* p_data, int
       BTIF_TRACE_EVENT("%s: IDLE state for index: %d", __func__, index);
       memset(&btif_av_cb[index].peer_bda, 0, sizeof(RawAddress));
       btif_av_cb[index].flags = 0;
+      btif_av_cb[index].num_events = 0;
       btif_av_cb[index].edr_3mbps = false;
       btif_av_cb[index].edr = 0;
       btif_av_cb[index].current_playing = false;
@@ -1725,7 +1760,10 @@ static bool btif_av_state_opening_handler(btif_sm_event_t event, void* p_data,
          BTA_AvCloseRc(peer_handle);
        }
        BTA_AvClose(btif_av_cb[index].bta_handle);
-       btif_queue_advance();
+       btif_queue_advance_by_uuid(bt_av_sink_callbacks != NULL
+                                      ? UUID_SERVCLASS_AUDIO_SINK
+                                      : UUID_SERVCLASS_AUDIO_SOURCE,
+                                  &(btif_av_cb[index].peer_bda));
        btif_sm_change_state(btif_av_cb[index].sm_handle, BTIF_AV_STATE_IDLE);
        btif_report_connection_state_to_ba(BTAV_CONNECTION_STATE_DISCONNECTED);
        } break;
@@ -3764,9 +3802,11 @@ static void btif_av_handle_event(uint16_t event, char* p_param) {
       break;
   }
   BTIF_TRACE_DEBUG("Handle the AV event = %x on index = %d", event, index);
-  if (index >= 0 && index < btif_max_av_clients)
+  if (index >= 0 && index < btif_max_av_clients) {
+      btif_av_cb[index].num_events++;
+      btif_av_cb[index].last_event = event;
       btif_sm_dispatch(btif_av_cb[index].sm_handle, event, (void*)p_param);
-  else
+  } else
       BTIF_TRACE_ERROR("Unhandled Index = %d", index);
   btif_av_event_free_data(event, p_param);
 
@@ -3942,15 +3982,12 @@ bool btif_av_is_playing() {
  ******************************************************************************/
 static int btif_get_conn_state_of_device(RawAddress address) {
   btif_sm_state_t state = BTIF_AV_STATE_IDLE;
-  int i;
-  for (i = 0; i < btif_max_av_clients; i++) {
-    if (address == btif_av_cb[i].peer_bda) {
-      state = btif_sm_get_state(btif_av_cb[i].sm_handle);
-      BTIF_TRACE_EVENT("%s: index = %d, BD Found: %s, state: %s",
-           __func__, i, btif_av_cb[i].peer_bda.ToString().c_str(),
-           dump_av_sm_state_name((btif_av_state_t)state));
-      return state;
-    }
+  int i = btif_av_idx_by_bdaddr(&address);
+  if (i < btif_max_av_clients) {
+    state = btif_sm_get_state(btif_av_cb[i].sm_handle);
+    BTIF_TRACE_EVENT("%s: index = %d, BD Found: %s, state: %s",
+         __func__, i, btif_av_cb[i].peer_bda.ToString().c_str(),
+         dump_av_sm_state_name((btif_av_state_t)state));
   }
   return state;
 }
@@ -4473,6 +4510,7 @@ bt_status_t btif_av_init(int service_id) {
     }
 
     bta_av_co_init(codec_priorities_, offload_enabled_codecs_config_);
+    footprint_set("btif_av", "control_blocks", sizeof(btif_av_cb));
     /* Also initialize the AV state machine */
     for (int i = 0; i < btif_max_av_clients; i++) {
       btif_av_cb[i].sm_handle = btif_sm_init(
@@ -5222,12 +5260,8 @@ RawAddress btif_av_get_addr_by_index(int idx) {
  *
  ******************************************************************************/
 RawAddress btif_av_get_addr(RawAddress address) {
-  int i;
-  RawAddress not_found = RawAddress::kEmpty;
-  for (i = 0; i < btif_max_av_clients; i++)
-    if (btif_av_cb[i].peer_bda == address)
-      return btif_av_cb[i].peer_bda;
-  return not_found;
+  int i = btif_av_idx_by_bdaddr(&address);
+  return (i < btif_max_av_clients) ? btif_av_cb[i].peer_bda : RawAddress::kEmpty;
 }
 
 /******************************************************************************
@@ -6681,11 +6715,10 @@ bool btif_av_is_tws_suspend_triggered(int index) {
   return false;
 }
 bool btif_av_is_tws_enabled_for_dev(const RawAddress& rc_addr) {
-  for (int i = 0; i < btif_max_av_clients; i++) {
-    if (btif_av_cb[i].peer_bda == rc_addr) {
-      BTIF_TRACE_DEBUG("%s",__func__);
-      return btif_av_cb[i].tws_device;
-    }
+  int i = btif_av_idx_by_bdaddr(&rc_addr);
+  if (i < btif_max_av_clients) {
+    BTIF_TRACE_DEBUG("%s",__func__);
+    return btif_av_cb[i].tws_device;
   }
   return false;
 }
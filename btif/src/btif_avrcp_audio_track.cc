@@ -23,17 +23,47 @@
 #include <base/logging.h>
 #include <utils/StrongPointer.h>
 
+#include <algorithm>
+#include <atomic>
+
 #include "bt_target.h"
 #include "osi/include/log.h"
+#include "osi/include/properties.h"
 
 using namespace android;
 
+#define BTIF_AVRCP_RING_OUTPUT_PROPERTY \
+  "persist.vendor.bt.a2dp.sink_ring_output"
+
+// Audio the output ring holds, and the level it fills up to before the data
+// callback starts playing
+constexpr int kRingCapacityMs = 250;
+constexpr int kRingStartMs = 40;
+
+// Single producer / single consumer ring of float samples. The sink worker
+// thread only moves |writePos| and the audio data callback only moves
+// |readPos|; both count samples since creation and never wrap.
+typedef struct {
+  float* samples;
+  size_t mask;
+  size_t startLevel;
+  std::atomic<size_t> writePos;
+  std::atomic<size_t> readPos;
+  std::atomic<size_t> flushPos;
+  std::atomic<bool> flushPending;
+  bool playing; /* consumer only */
+  std::atomic<uint32_t> underruns;
+  std::atomic<uint32_t> overruns;
+} BtifAvrcpAudioRing;
+
 typedef struct {
   AAudioStream* stream;
   int bitsPerSample;
   int channelCount;
+  int sampleRate;
   float* buffer;
   size_t bufferLength;
+  BtifAvrcpAudioRing* ring;
 } BtifAvrcpAudioTrack;
 
 #if (DUMP_PCM_DATA == TRUE)
@@ -41,6 +71,73 @@ FILE* outputPcmSampleFile;
 char outputFilename[50] = "/data/misc/bluedroid/output_sample.pcm";
 #endif
 
+static aaudio_data_callback_result_t ringDataCallback(AAudioStream* stream,
+                                                     void* userData,
+                                                     void* audioData,
+                                                     int32_t numFrames) {
+  BtifAvrcpAudioTrack* trackHolder = static_cast<BtifAvrcpAudioTrack*>(userData);
+  BtifAvrcpAudioRing* ring = trackHolder->ring;
+  float* out = static_cast<float*>(audioData);
+  size_t wanted = (size_t)numFrames * trackHolder->channelCount;
+
+  size_t readPos = ring->readPos.load(std::memory_order_relaxed);
+  if (ring->flushPending.exchange(false, std::memory_order_acquire)) {
+    readPos = std::max(readPos, ring->flushPos.load(std::memory_order_relaxed));
+    ring->playing = false;
+  }
+  size_t level = ring->writePos.load(std::memory_order_acquire) - readPos;
+  if (!ring->playing && level >= ring->startLevel) ring->playing = true;
+
+  size_t count = ring->playing ? std::min(level, wanted) : 0;
+  for (size_t i = 0; i < count; i++)
+    out[i] = ring->samples[(readPos + i) & ring->mask];
+  if (count < wanted) {
+    std::fill(out + count, out + wanted, 0.0f);
+    if (ring->playing) {
+      ring->underruns++;
+      ring->playing = false;
+    }
+  }
+  ring->readPos.store(readPos + count, std::memory_order_release);
+  return AAUDIO_CALLBACK_RESULT_CONTINUE;
+}
+
+static BtifAvrcpAudioRing* ringCreate(int trackFreq, int channelCount) {
+  size_t capacity = (size_t)trackFreq * channelCount * kRingCapacityMs / 1000;
+  size_t size = 1;
+  while (size < capacity) size <<= 1;
+
+  BtifAvrcpAudioRing* ring = new BtifAvrcpAudioRing;
+  ring->samples = new float[size]();
+  ring->mask = size - 1;
+  ring->startLevel = (size_t)trackFreq * channelCount * kRingStartMs / 1000;
+  ring->writePos = 0;
+  ring->readPos = 0;
+  ring->flushPos = 0;
+  ring->flushPending = false;
+  ring->playing = false;
+  ring->underruns = 0;
+  ring->overruns = 0;
+  return ring;
+}
+
+// Copies whole frames of |count| samples at |samples| into the ring. Returns
+// the number of samples copied.
+static size_t ringWrite(BtifAvrcpAudioTrack* trackHolder, const float* samples,
+                        size_t count) {
+  BtifAvrcpAudioRing* ring = trackHolder->ring;
+  size_t writePos = ring->writePos.load(std::memory_order_relaxed);
+  size_t level = writePos - ring->readPos.load(std::memory_order_acquire);
+  size_t space = ring->mask + 1 - level;
+  size_t n = std::min(count, space);
+  n -= n % trackHolder->channelCount;
+  for (size_t i = 0; i < n; i++)
+    ring->samples[(writePos + i) & ring->mask] = samples[i];
+  ring->writePos.store(writePos + n, std::memory_order_release);
+  if (n < count) ring->overruns++;
+  return n;
+}
+
 void* BtifAvrcpAudioTrackCreate(int trackFreq, int bitsPerSample,
                                 int channelCount) {
   LOG_VERBOSE(LOG_TAG, "%s Track.cpp: btCreateTrack freq %d bps %d channel %d ",
@@ -55,15 +152,24 @@ void* BtifAvrcpAudioTrackCreate(int trackFreq, int bitsPerSample,
   AAudioStreamBuilder_setSessionId(builder, AAUDIO_SESSION_ID_ALLOCATE);
   AAudioStreamBuilder_setPerformanceMode(builder,
                                          AAUDIO_PERFORMANCE_MODE_LOW_LATENCY);
+
+  BtifAvrcpAudioTrack* trackHolder = new BtifAvrcpAudioTrack;
+  CHECK(trackHolder != NULL);
+  trackHolder->ring = NULL;
+  if (osi_property_get_bool(BTIF_AVRCP_RING_OUTPUT_PROPERTY, false)) {
+    trackHolder->ring = ringCreate(trackFreq, channelCount);
+    AAudioStreamBuilder_setDataCallback(builder, ringDataCallback,
+                                        trackHolder);
+  }
+
   result = AAudioStreamBuilder_openStream(builder, &stream);
   CHECK(result == AAUDIO_OK);
   AAudioStreamBuilder_delete(builder);
 
-  BtifAvrcpAudioTrack* trackHolder = new BtifAvrcpAudioTrack;
-  CHECK(trackHolder != NULL);
   trackHolder->stream = stream;
   trackHolder->bitsPerSample = bitsPerSample;
   trackHolder->channelCount = channelCount;
+  trackHolder->sampleRate = trackFreq;
   trackHolder->bufferLength =
       trackHolder->channelCount * AAudioStream_getBufferSizeInFrames(stream);
   trackHolder->buffer = new float[trackHolder->bufferLength]();
@@ -123,6 +229,13 @@ void BtifAvrcpAudioTrackDelete(void* handle) {
   if (trackHolder != NULL && trackHolder->stream != NULL) {
     LOG_VERBOSE(LOG_TAG, "%s Track.cpp: btStartTrack", __func__);
     AAudioStream_close(trackHolder->stream);
+    if (trackHolder->ring != NULL) {
+      LOG_INFO(LOG_TAG, "%s: output ring underruns %u overruns %u", __func__,
+               trackHolder->ring->underruns.load(),
+               trackHolder->ring->overruns.load());
+      delete[] trackHolder->ring->samples;
+      delete trackHolder->ring;
+    }
     delete trackHolder->buffer;
     delete trackHolder;
   }
@@ -145,6 +258,12 @@ void BtifAvrcpAudioTrackPause(void* handle) {
     LOG_VERBOSE(LOG_TAG, "%s Track.cpp: btPauseTrack", __func__);
     AAudioStream_requestPause(trackHolder->stream);
     AAudioStream_requestFlush(trackHolder->stream);
+    if (trackHolder->ring != NULL) {
+      // Only the data callback moves the read position: let it skip what
+      // was written so far
+      trackHolder->ring->flushPos = trackHolder->ring->writePos.load();
+      trackHolder->ring->flushPending.store(true, std::memory_order_release);
+    }
   }
 }
 
@@ -225,6 +344,17 @@ int BtifAvrcpAudioTrackWriteData(void* handle, void* audioBuffer,
 
   size_t sampleSize = sampleSizeFor(trackHolder);
   int transcodedCount = 0;
+  if (trackHolder->ring != NULL) {
+    do {
+      size_t count =
+          transcodeToPcmFloat(((uint8_t*)audioBuffer) + transcodedCount,
+                              bufferLength - transcodedCount, trackHolder);
+      ringWrite(trackHolder, trackHolder->buffer, count / sampleSize);
+      transcodedCount += count;
+    } while (transcodedCount < bufferLength);
+    return transcodedCount;
+  }
+
   do {
     transcodedCount +=
         transcodeToPcmFloat(((uint8_t*)audioBuffer) + transcodedCount,
@@ -240,3 +370,17 @@ int BtifAvrcpAudioTrackWriteData(void* handle, void* audioBuffer,
 
   return transcodedCount;
 }
+
+bool BtifAvrcpAudioTrackGetRingLevel(void* handle, uint64_t* p_level_us,
+                                     uint64_t* p_target_us) {
+  BtifAvrcpAudioTrack* trackHolder = static_cast<BtifAvrcpAudioTrack*>(handle);
+  if (trackHolder == NULL || trackHolder->ring == NULL) return false;
+
+  BtifAvrcpAudioRing* ring = trackHolder->ring;
+  size_t level = ring->writePos.load() - ring->readPos.load();
+  uint64_t samples_per_sec =
+      (uint64_t)trackHolder->sampleRate * trackHolder->channelCount;
+  *p_level_us = level * 1000000ULL / samples_per_sec;
+  *p_target_us = kRingStartMs * 1000ULL;
+  return true;
+}
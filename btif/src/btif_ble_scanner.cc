@@ -41,8 +41,11 @@
 #include "btif_dm.h"
 #include "btif_gatt.h"
 #include "btif_gatt_util.h"
+#include "btif_jni_batch.h"
 #include "btif_storage.h"
 #include "osi/include/log.h"
+#include "osi/include/properties.h"
+#include "osi/include/time.h"
 #include "vendor_api.h"
 #include "stack_manager.h"
 
@@ -91,6 +94,101 @@ void btif_address_cache_init(void) {
   remote_bdaddr_cache_ordered = {};
 }
 
+// Optional throttle for repeated advertising reports, configured by
+// |kScanDedupIntervalProperty| and accessed on the bta thread only. A report
+// for an (address, data) pair seen within the interval is dropped, unless its
+// RSSI moved by at least |kScanDedupRssiDeltaProperty| dB. Changed data
+// hashes to a different key and is always reported.
+const char* kScanDedupIntervalProperty =
+    "persist.vendor.bt.scan_dedup_interval_ms";
+const char* kScanDedupRssiDeltaProperty =
+    "persist.vendor.bt.scan_dedup_rssi_delta";
+
+// Open addressed, each key may live in one of |kScanDedupProbes| slots
+// starting at its home slot. Entries older than the interval may be reused.
+constexpr size_t kScanDedupSlots = 512;
+constexpr size_t kScanDedupProbes = 8;
+
+struct scan_dedup_entry_t {
+  uint64_t key;  // 0 means the slot was never used
+  uint32_t reported_ms;
+  int8_t rssi;
+};
+
+struct {
+  uint32_t interval_ms;
+  int rssi_delta;
+  scan_dedup_entry_t entries[kScanDedupSlots];
+} scan_dedup;
+
+void scan_dedup_reset(void) {
+  memset(&scan_dedup, 0, sizeof(scan_dedup));
+  scan_dedup.interval_ms =
+      osi_property_get_int32(kScanDedupIntervalProperty, 0);
+  scan_dedup.rssi_delta =
+      osi_property_get_int32(kScanDedupRssiDeltaProperty, 10);
+}
+
+uint64_t scan_dedup_key(const RawAddress& bda, const uint8_t* data,
+                        size_t len) {
+  // FNV-1a
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < sizeof(bda.address); i++) {
+    hash = (hash ^ bda.address[i]) * 1099511628211ULL;
+  }
+  for (size_t i = 0; i < len; i++) {
+    hash = (hash ^ data[i]) * 1099511628211ULL;
+  }
+  return hash ? hash : 1;
+}
+
+// Returns true if the report is to be delivered, false if it repeats one
+// delivered less than the interval ago.
+bool scan_dedup_should_report(const RawAddress& bda, int8_t rssi,
+                              const uint8_t* data, size_t len) {
+  if (scan_dedup.interval_ms == 0) return true;
+
+  uint32_t now = time_get_os_boottime_ms();
+  uint64_t key = scan_dedup_key(bda, data, len);
+  size_t home = key % kScanDedupSlots;
+
+  // Takes the matching slot, otherwise the one unused for the longest time.
+  scan_dedup_entry_t* victim = nullptr;
+  uint32_t victim_age = 0;
+  for (size_t i = 0; i < kScanDedupProbes; i++) {
+    scan_dedup_entry_t* entry =
+        &scan_dedup.entries[(home + i) % kScanDedupSlots];
+    uint32_t age = entry->key ? now - entry->reported_ms : UINT32_MAX;
+    if (entry->key == key) {
+      if (age < scan_dedup.interval_ms &&
+          abs(rssi - entry->rssi) < scan_dedup.rssi_delta)
+        return false;
+      victim = entry;
+      break;
+    }
+    if (!victim || age > victim_age) {
+      victim = entry;
+      victim_age = age;
+    }
+  }
+
+  victim->key = key;
+  victim->reported_ms = now;
+  victim->rssi = rssi;
+  return true;
+}
+
+void scan_result_batch_flush(std::vector<btgatt_scan_result_t>* results) {
+  if (bt_gatt_callbacks && bt_gatt_callbacks->scanner->scan_result_batch_cb)
+    bt_gatt_callbacks->scanner->scan_result_batch_cb(*results);
+}
+
+// Scan results for a scanner client which registered the batched callback,
+// configured by the properties below and accessed on the JNI thread only.
+BtifJniBatch<btgatt_scan_result_t> scan_result_batch(
+    "btif.scan_result_batch", "persist.vendor.bt.scan_batch_max_results",
+    "persist.vendor.bt.scan_batch_max_delay_us", &scan_result_batch_flush);
+
 void bta_batch_scan_threshold_cb(tBTM_BLE_REF_VALUE ref_value) {
   SCAN_CBACK_IN_JNI(batchscan_threshold_cb, ref_value);
 }
@@ -164,6 +262,25 @@ void bta_scan_results_cb_impl(RawAddress bd_addr, tBT_DEVICE_TYPE device_type,
   }
 
   btif_storage_set_remote_addr_type(&bd_addr, addr_type);
+
+  if (bt_gatt_callbacks && bt_gatt_callbacks->scanner->scan_result_batch_cb &&
+      scan_result_batch.IsEnabled()) {
+    btgatt_scan_result_t result;
+    result.event_type = ble_evt_type;
+    result.addr_type = addr_type;
+    result.bda = bd_addr;
+    result.primary_phy = ble_primary_phy;
+    result.secondary_phy = ble_secondary_phy;
+    result.advertising_sid = ble_advertising_sid;
+    result.tx_power = ble_tx_power;
+    result.rssi = rssi;
+    result.periodic_adv_int = ble_periodic_adv_int;
+    result.adv_data = std::move(value);
+    result.original_bda = original_bda;
+    scan_result_batch.Add(std::move(result));
+    return;
+  }
+
   HAL_CBACK(bt_gatt_callbacks, scanner->scan_result_cb, ble_evt_type, addr_type,
             &bd_addr, ble_primary_phy, ble_secondary_phy, ble_advertising_sid,
             ble_tx_power, rssi, ble_periodic_adv_int, std::move(value),
@@ -184,6 +301,11 @@ void bta_scan_results_cb(tBTA_DM_SEARCH_EVT event, tBTA_DM_SEARCH* p_data) {
     return;
   }
 
+  if (!scan_dedup_should_report(p_data->inq_res.bd_addr, p_data->inq_res.rssi,
+                                p_data->inq_res.p_eir,
+                                p_data->inq_res.eir_len))
+    return;
+
   vector<uint8_t> value;
   if (p_data->inq_res.p_eir) {
     value.insert(value.begin(), p_data->inq_res.p_eir,
@@ -246,12 +368,14 @@ class BleScannerInterfaceImpl : public BleScannerInterface {
     do_in_jni_thread(Bind(
         [](bool start) {
           if (!start) {
+            scan_result_batch.Flush();
             do_in_bta_thread(FROM_HERE,
                              Bind(&BTA_DmBleObserve, false, 0, nullptr));
             return;
           }
 
           btif_address_cache_init();
+          do_in_bta_thread(FROM_HERE, Bind(&scan_dedup_reset));
           do_in_bta_thread(
               FROM_HERE, Bind(&BTA_DmBleObserve, true, 0, bta_scan_results_cb));
         },
@@ -16,9 +16,13 @@
 
 #include <stdio.h>
 #include "btif_bqr.h"
+#include "btif_av.h"
+#include "btif_av_co.h"
 #include "btif_dm.h"
 #include "osi/include/leaky_bonded_queue.h"
+#include "osi/include/metrics.h"
 #include "osi/include/properties.h"
+#include "osi/include/time.h"
 #include "stack/btm/btm_int.h"
 #include "raw_address.h"
 
@@ -28,7 +32,9 @@ void btif_vendor_bqr_delivery_event(const RawAddress* bd_addr, const uint8_t* bq
 namespace bluetooth {
 namespace bqr {
 
+using system_bt_osi::BluetoothMetricsLogger;
 using system_bt_osi::LeakyBondedQueue;
+using system_bt_osi::LinkQualityMetrics;
 using std::chrono::system_clock;
 
 // The instance of BQR event queue
@@ -37,6 +43,48 @@ static std::unique_ptr<LeakyBondedQueue<BqrVseSubEvt>> kpBqrEventQueue(
 
 static uint16_t vendor_cap_supported_version;
 
+static void LogLinkQuality(const RawAddress& bda, int16_t codec,
+                           const LinkQualityBucket& bucket) {
+  LinkQualityMetrics metrics;
+  metrics.duration_ms = bucket.duration_ms;
+  if (codec >= 0) metrics.codec_index = codec;
+  metrics.report_count = bucket.report_count;
+  metrics.approach_lsto_count = bucket.approach_lsto_count;
+  metrics.a2dp_choppy_count = bucket.a2dp_choppy_count;
+  metrics.sco_choppy_count = bucket.sco_choppy_count;
+  metrics.rssi_average = bucket.AverageRssi();
+  metrics.rssi_min = bucket.rssi_min;
+  metrics.rssi_max = bucket.rssi_max;
+  metrics.snr_average = bucket.AverageSnr();
+  metrics.snr_min = bucket.snr_min;
+  metrics.retransmission_count = bucket.retransmission_count;
+  metrics.no_rx_count = bucket.no_rx_count;
+  metrics.nak_count = bucket.nak_count;
+  metrics.flow_off_count = bucket.flow_off_count;
+  metrics.buffer_overflow_bytes = bucket.buffer_overflow_bytes;
+  metrics.buffer_underflow_bytes = bucket.buffer_underflow_bytes;
+  BluetoothMetricsLogger::GetInstance()->LogLinkQualityEvent(bucket.start_ms,
+                                                             metrics);
+}
+
+// Link quality statistics of the remote devices, in Unix epoch milliseconds
+static LinkQualityStats link_quality_stats(LogLinkQuality);
+
+static uint64_t NowMs() { return time_gettimeofday_us() / 1000; }
+
+// Returns the codec streamed to |bda|, if any.
+static int16_t GetStreamingCodec(const RawAddress& bda) {
+  if (!btif_av_is_playing()) return kLinkStatsCodecNone;
+
+  RawAddress active_peer = RawAddress::kEmpty;
+  btif_av_get_active_peer_addr(&active_peer);
+  if (active_peer != bda) return kLinkStatsCodecNone;
+
+  A2dpCodecConfig* codec = bta_av_get_a2dp_current_codec();
+  if (codec == nullptr) return kLinkStatsCodecNone;
+  return codec->codecIndex();
+}
+
 static uint32_t GetVsQualityEventMask(uint32_t event_mask) {
   if (vendor_cap_supported_version < kBqrConnectFailVersion &&
       (event_mask & kQualityEventMaskConnectFail)) {
@@ -265,6 +313,22 @@ void AddBqrEventToQueue(uint8_t length, uint8_t* p_stream) {
 
   if (length >= kBqrParamTotalLen) {
     btif_vendor_bqr_delivery_event(&(p_bqr_event->bdaddr_), p_stream, length);
+
+    LinkQualitySample sample;
+    sample.quality_report_id = p_bqr_event->quality_report_id_;
+    sample.rssi = p_bqr_event->rssi_;
+    sample.snr = p_bqr_event->snr_;
+    sample.retransmission_count = p_bqr_event->retransmission_count_;
+    sample.no_rx_count = p_bqr_event->no_rx_count_;
+    sample.nak_count = p_bqr_event->nak_count_;
+    sample.flow_off_count = p_bqr_event->flow_off_count_;
+    sample.buffer_overflow_bytes = p_bqr_event->buffer_overflow_bytes_;
+    sample.buffer_underflow_bytes = p_bqr_event->buffer_underflow_bytes_;
+    link_quality_stats.AddSample(p_bqr_event->bdaddr_,
+                                 GetStreamingCodec(p_bqr_event->bdaddr_),
+                                 sample, NowMs());
+    btm_ble_phy_policy_link_quality(p_bqr_event->connection_handle_,
+                                    p_bqr_event->rssi_);
   } else {
     LOG(WARNING) << __func__ << ": BQR event doesn't contain remote address";
   }
@@ -446,7 +510,18 @@ void ConfigureBqr(const BqrConfiguration& bqr_config) {
                             param, BqrVscCompleteCallback);
 }
 
+bool GetLinkQualitySummary(const RawAddress& bda, int16_t codec,
+                           uint64_t window_ms, LinkQualityBucket* summary) {
+  uint64_t now_ms = NowMs();
+  uint64_t since_ms = now_ms > window_ms ? now_ms - window_ms : 0;
+  return link_quality_stats.GetSummary(bda, codec, since_ms, now_ms, summary);
+}
+
+void ExportLinkQualityMetrics() { link_quality_stats.ExportCompleted(NowMs()); }
+
 void DebugDump(int fd) {
+  link_quality_stats.Dump(fd, NowMs());
+
   dprintf(fd, "\nBT Quality Report Events: \n");
 
   if (kpBqrEventQueue->Empty()) {
@@ -0,0 +1,275 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "btif_bqr_stats.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "btif_bqr.h"
+
+namespace bluetooth {
+namespace bqr {
+
+int8_t LinkQualityBucket::AverageRssi() const {
+  return Empty() ? 0 : (int8_t)(rssi_sum / (int64_t)report_count);
+}
+
+uint8_t LinkQualityBucket::AverageSnr() const {
+  return Empty() ? 0 : (uint8_t)(snr_sum / report_count);
+}
+
+void LinkQualityBucket::Add(const LinkQualitySample& sample) {
+  if (Empty()) {
+    rssi_min = rssi_max = sample.rssi;
+    snr_min = sample.snr;
+  } else {
+    if (sample.rssi < rssi_min) rssi_min = sample.rssi;
+    if (sample.rssi > rssi_max) rssi_max = sample.rssi;
+    if (sample.snr < snr_min) snr_min = sample.snr;
+  }
+  report_count++;
+  switch (sample.quality_report_id) {
+    case QUALITY_REPORT_ID_APPROACH_LSTO:
+      approach_lsto_count++;
+      break;
+    case QUALITY_REPORT_ID_A2DP_AUDIO_CHOPPY:
+      a2dp_choppy_count++;
+      break;
+    case QUALITY_REPORT_ID_SCO_VOICE_CHOPPY:
+      sco_choppy_count++;
+      break;
+    default:
+      break;
+  }
+  rssi_sum += sample.rssi;
+  snr_sum += sample.snr;
+  retransmission_count += sample.retransmission_count;
+  no_rx_count += sample.no_rx_count;
+  nak_count += sample.nak_count;
+  flow_off_count += sample.flow_off_count;
+  buffer_overflow_bytes += sample.buffer_overflow_bytes;
+  buffer_underflow_bytes += sample.buffer_underflow_bytes;
+}
+
+void LinkQualityBucket::Merge(const LinkQualityBucket& other) {
+  if (other.Empty()) return;
+  if (Empty()) {
+    *this = other;
+    return;
+  }
+
+  uint64_t end = start_ms + duration_ms;
+  uint64_t other_end = other.start_ms + other.duration_ms;
+  if (other.start_ms < start_ms) start_ms = other.start_ms;
+  duration_ms = (other_end > end ? other_end : end) - start_ms;
+
+  if (other.rssi_min < rssi_min) rssi_min = other.rssi_min;
+  if (other.rssi_max > rssi_max) rssi_max = other.rssi_max;
+  if (other.snr_min < snr_min) snr_min = other.snr_min;
+  report_count += other.report_count;
+  approach_lsto_count += other.approach_lsto_count;
+  a2dp_choppy_count += other.a2dp_choppy_count;
+  sco_choppy_count += other.sco_choppy_count;
+  rssi_sum += other.rssi_sum;
+  snr_sum += other.snr_sum;
+  retransmission_count += other.retransmission_count;
+  no_rx_count += other.no_rx_count;
+  nak_count += other.nak_count;
+  flow_off_count += other.flow_off_count;
+  buffer_overflow_bytes += other.buffer_overflow_bytes;
+  buffer_underflow_bytes += other.buffer_underflow_bytes;
+}
+
+// Returns the bucket of |ring| for |now_ms|, resetting it if it still holds
+// an older period. |replaced| is set to the old content.
+static LinkQualityBucket* GetBucket(LinkQualityBucket* ring, size_t ring_size,
+                                    uint64_t bucket_ms, uint64_t now_ms,
+                                    LinkQualityBucket* replaced) {
+  uint64_t start = now_ms - now_ms % bucket_ms;
+  LinkQualityBucket* bucket = &ring[(start / bucket_ms) % ring_size];
+  if (bucket->Empty() || bucket->start_ms != start) {
+    if (replaced != nullptr) *replaced = *bucket;
+    *bucket = LinkQualityBucket();
+    bucket->start_ms = start;
+    bucket->duration_ms = bucket_ms;
+  }
+  return bucket;
+}
+
+LinkQualityStats::LinkQualityStats(ExportCallback export_callback)
+    : export_callback_(std::move(export_callback)) {}
+
+void LinkQualityStats::AddSample(const RawAddress& bda, int16_t codec,
+                                 const LinkQualitySample& sample,
+                                 uint64_t now_ms) {
+  std::vector<PendingExport> exports;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    Link* link = FindOrAddLinkLocked(bda, codec, &exports);
+    link->last_update_ms = now_ms;
+
+    GetBucket(link->fine, kLinkStatsFineBuckets, kLinkStatsFineBucketMs,
+              now_ms, nullptr)
+        ->Add(sample);
+
+    LinkQualityBucket replaced;
+    size_t index = (now_ms / kLinkStatsCoarseBucketMs) % kLinkStatsCoarseBuckets;
+    bool was_exported = link->coarse_exported[index];
+    LinkQualityBucket* coarse =
+        GetBucket(link->coarse, kLinkStatsCoarseBuckets,
+                  kLinkStatsCoarseBucketMs, now_ms, &replaced);
+    if (coarse->Empty()) {
+      // A new period: the old one leaves the ring, export it if nobody did
+      if (!replaced.Empty() && !was_exported)
+        exports.push_back({link->bda, link->codec, replaced});
+      link->coarse_exported[index] = false;
+    }
+    coarse->Add(sample);
+
+    CollectExportsLocked(link, now_ms, false, &exports);
+  }
+  RunExports(exports);
+}
+
+void LinkQualityStats::ExportCompleted(uint64_t now_ms) {
+  std::vector<PendingExport> exports;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    for (Link& link : links_) {
+      if (link.in_use) CollectExportsLocked(&link, now_ms, false, &exports);
+    }
+  }
+  RunExports(exports);
+}
+
+bool LinkQualityStats::GetSummary(const RawAddress& bda, int16_t codec,
+                                  uint64_t since_ms, uint64_t now_ms,
+                                  LinkQualityBucket* summary) const {
+  *summary = LinkQualityBucket();
+
+  // The fine ring only holds complete history for its own span
+  uint64_t fine_span = kLinkStatsFineBucketMs * (kLinkStatsFineBuckets - 1);
+  bool use_fine = now_ms - now_ms % kLinkStatsFineBucketMs <= since_ms + fine_span;
+
+  std::lock_guard<std::mutex> lock(lock_);
+  for (const Link& link : links_) {
+    if (!link.in_use || link.bda != bda) continue;
+    if (codec != kLinkStatsCodecAny && link.codec != codec) continue;
+
+    const LinkQualityBucket* ring = use_fine ? link.fine : link.coarse;
+    size_t ring_size = use_fine ? kLinkStatsFineBuckets : kLinkStatsCoarseBuckets;
+    for (size_t i = 0; i < ring_size; i++) {
+      const LinkQualityBucket& bucket = ring[i];
+      if (bucket.Empty()) continue;
+      if (bucket.start_ms + bucket.duration_ms <= since_ms) continue;
+      if (bucket.start_ms > now_ms) continue;
+      summary->Merge(bucket);
+    }
+  }
+  return !summary->Empty();
+}
+
+void LinkQualityStats::Clear() {
+  std::lock_guard<std::mutex> lock(lock_);
+  for (Link& link : links_) link = Link();
+}
+
+void LinkQualityStats::Dump(int fd, uint64_t now_ms) const {
+  std::lock_guard<std::mutex> lock(lock_);
+  dprintf(fd, "\nBT Quality Report Link Statistics (last hour): \n");
+
+  bool any = false;
+  for (const Link& link : links_) {
+    if (!link.in_use) continue;
+
+    LinkQualityBucket hour;
+    for (const LinkQualityBucket& bucket : link.fine) {
+      if (!bucket.Empty() &&
+          bucket.start_ms + kLinkStatsCoarseBucketMs > now_ms)
+        hour.Merge(bucket);
+    }
+    if (hour.Empty()) continue;
+    any = true;
+
+    dprintf(fd,
+            "  %s codec: %d reports: %" PRIu32 " (lsto: %" PRIu32
+            ", a2dp choppy: %" PRIu32 ", sco choppy: %" PRIu32 ")\n",
+            link.bda.ToString().c_str(), link.codec, hour.report_count,
+            hour.approach_lsto_count, hour.a2dp_choppy_count,
+            hour.sco_choppy_count);
+    dprintf(fd,
+            "    rssi avg/min/max: %d/%d/%d snr avg/min: %u/%u"
+            " retx: %" PRIu64 " no rx: %" PRIu64 " nak: %" PRIu64
+            " flow off: %" PRIu64 " overflow: %" PRIu64 " underflow: %" PRIu64
+            "\n",
+            hour.AverageRssi(), hour.rssi_min, hour.rssi_max,
+            hour.AverageSnr(), hour.snr_min, hour.retransmission_count,
+            hour.no_rx_count, hour.nak_count, hour.flow_off_count,
+            hour.buffer_overflow_bytes, hour.buffer_underflow_bytes);
+  }
+
+  if (!any) dprintf(fd, "No link statistics.\n");
+}
+
+LinkQualityStats::Link* LinkQualityStats::FindOrAddLinkLocked(
+    const RawAddress& bda, int16_t codec, std::vector<PendingExport>* exports) {
+  Link* free_link = nullptr;
+  Link* oldest = nullptr;
+  for (Link& link : links_) {
+    if (!link.in_use) {
+      if (free_link == nullptr) free_link = &link;
+      continue;
+    }
+    if (link.bda == bda && link.codec == codec) return &link;
+    if (oldest == nullptr || link.last_update_ms < oldest->last_update_ms)
+      oldest = &link;
+  }
+
+  Link* link = free_link;
+  if (link == nullptr) {
+    // Keep what the evicted link collected so far
+    CollectExportsLocked(oldest, 0, true, exports);
+    link = oldest;
+  }
+  *link = Link();
+  link->in_use = true;
+  link->bda = bda;
+  link->codec = codec;
+  return link;
+}
+
+void LinkQualityStats::CollectExportsLocked(
+    Link* link, uint64_t now_ms, bool all,
+    std::vector<PendingExport>* exports) {
+  for (size_t i = 0; i < kLinkStatsCoarseBuckets; i++) {
+    const LinkQualityBucket& bucket = link->coarse[i];
+    if (bucket.Empty() || link->coarse_exported[i]) continue;
+    if (!all && bucket.start_ms + bucket.duration_ms > now_ms) continue;
+    exports->push_back({link->bda, link->codec, bucket});
+    link->coarse_exported[i] = true;
+  }
+}
+
+void LinkQualityStats::RunExports(
+    const std::vector<PendingExport>& exports) const {
+  if (!export_callback_) return;
+  for (const PendingExport& e : exports)
+    export_callback_(e.bda, e.codec, e.bucket);
+}
+
+}  // namespace bqr
+}  // namespace bluetooth
@@ -30,6 +30,7 @@
 
 #include <base/logging.h>
 #include <ctype.h>
+#include <inttypes.h>
 #include <openssl/rand.h>
 #include <openssl/sha.h>
 #include <stdio.h>
@@ -46,6 +47,7 @@
 #include "btif_api.h"
 #include "btif_common.h"
 #include "btif_config_cache.h"
+#include "btif_config_journal.h"
 #include "btif_config_transcode.h"
 #include "btif_util.h"
 #include "common/address_obfuscator.h"
@@ -57,6 +59,7 @@
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/properties.h"
+#include "osi/include/time.h"
 
 #define BT_CONFIG_SOURCE_TAG_NUM 1010001
 #define TEMPORARY_SECTION_CAPACITY 10000
@@ -64,6 +67,7 @@
 #define INFO_SECTION "Info"
 #define FILE_TIMESTAMP "TimeCreated"
 #define FILE_SOURCE "FileSource"
+#define JOURNAL_GENERATION "JournalGeneration"
 #define TIME_STRING_LENGTH sizeof("YYYY-MM-DD HH:MM:SS")
 #define DISABLED "disabled"
 static const char* TIME_STRING_FORMAT = "%Y-%m-%d %H:%M:%S";
@@ -79,16 +83,35 @@ using bluetooth::common::AddressObfuscator;
 static const char* CONFIG_FILE_PATH = "bt_config.conf";
 static const char* CONFIG_BACKUP_PATH = "bt_config.bak";
 static const char* CONFIG_LEGACY_FILE_PATH = "bt_config.xml";
+static const char* CONFIG_JOURNAL_PATH = "bt_config.journal";
 #else   // !defined(OS_GENERIC)
 static const char* CONFIG_FILE_PATH = "/data/misc/bluedroid/bt_config.conf";
 static const char* CONFIG_BACKUP_PATH = "/data/misc/bluedroid/bt_config.bak";
 static const char* CONFIG_LEGACY_FILE_PATH =
     "/data/misc/bluedroid/bt_config.xml";
+static const char* CONFIG_JOURNAL_PATH =
+    "/data/misc/bluedroid/bt_config.journal";
 #endif  // defined(OS_GENERIC)
 static const period_ms_t CONFIG_SETTLE_PERIOD_MS = 3000;
+// The save may be deferred to share a wakeup with other alarms.
+static const period_ms_t CONFIG_SETTLE_SLACK_MS = 1000;
+// Saves append the changes to the journal, until it grows past this size and
+// the config file is written out in full again.
+static const size_t CONFIG_JOURNAL_COMPACT_SIZE = 64 * 1024;
+static const char* CONFIG_JOURNAL_PROPERTY = "persist.vendor.bt.config_journal";
+// Bond keys and metadata are committed together, at most once per this period,
+// instead of one write per key.
+static const period_ms_t BOND_COMMIT_PERIOD_MS = 500;
+static const char* BOND_COMMIT_PERIOD_PROPERTY =
+    "persist.vendor.bt.bond_commit_ms";
+// With strict durability the bond data is on flash before the bond is
+// reported to the application.
+static const char* BOND_COMMIT_STRICT_PROPERTY =
+    "persist.vendor.bt.bond_commit_strict";
 
 static void timer_config_save_cb(void* data);
 static void btif_config_write(uint16_t event, char* p_param);
+static bool btif_config_write_full(void);
 static bool is_factory_reset(void);
 static void delete_config_files(void);
 static void btif_config_remove_unpaired(config_t* config);
@@ -199,9 +222,37 @@ static void read_or_set_metrics_salt() {
 static std::recursive_mutex config_lock;  // protects operations on |config|.
 static alarm_t* config_timer;
 
+// Grouped bond commits, see btif_config_save_bond().
+static alarm_t* bond_commit_timer;
+static period_ms_t bond_commit_period_ms = BOND_COMMIT_PERIOD_MS;
+static bool bond_commit_strict;
+static bool bond_commit_pending;  // protected by |config_lock|
+
 // limited btif config cache capacity
 static BtifConfigCache btif_config_cache(TEMPORARY_SECTION_CAPACITY);
 
+// Journaled saves, not used in common criteria mode as the journal is not
+// covered by the config checksum. |config_journal_base| holds the persistent
+// sections as they are on flash, the config file plus its journal.
+static bool config_journal_enabled;
+static uint64_t config_journal_generation;
+static config_t config_journal_base;
+
+// Applies the journal of |config| to it. Returns true if the config must be
+// written out in full, to fold the journal in or to start one.
+static bool btif_config_journal_load(config_t* config) {
+  config_journal_generation =
+      config_get_uint64(*config, INFO_SECTION, JOURNAL_GENERATION, 0);
+  int applied = btif_config_journal_replay(
+      CONFIG_JOURNAL_PATH, config_journal_generation, config);
+  if (applied > 0)
+    LOG_INFO(LOG_TAG, "%s applied %d journal records", __func__, applied);
+  // A journal of another generation, e.g. when the backup was loaded, must not
+  // be mistaken for the one of the next file.
+  if (applied < 0) remove(CONFIG_JOURNAL_PATH);
+  return applied != 0;
+}
+
 // Module lifecycle functions
 
 static future_t* init(void) {
@@ -241,8 +292,18 @@ static future_t* init(void) {
     file_source = "Empty";
   }
 
+  config_journal_enabled = !is_common_criteria_mode() &&
+                           osi_property_get_bool(CONFIG_JOURNAL_PROPERTY, true);
+  bool write_full = config_journal_enabled &&
+                    btif_config_journal_load(config.get());
+
   // move persistent config data from btif_config file to btif config cache
   btif_config_cache.Init(std::move(config));
+  if (write_full) {
+    btif_config_write_full();
+  } else if (config_journal_enabled) {
+    config_journal_base = btif_config_cache.PersistentSectionCopy();
+  }
 
   if (!file_source.empty()) {
     btif_config_cache.SetString(INFO_SECTION, FILE_SOURCE, file_source);
@@ -281,30 +342,46 @@ static future_t* init(void) {
   // API support for it. There's no need to wake the system to
   // write back to disk.
   config_timer = alarm_new("btif.config");
-  if (!config_timer) {
+  bond_commit_timer = alarm_new("btif.config_bond");
+  if (!config_timer || !bond_commit_timer) {
     LOG_ERROR(LOG_TAG, "%s unable to create alarm.", __func__);
     goto error;
   }
 
+  {
+    int32_t period = osi_property_get_int32(BOND_COMMIT_PERIOD_PROPERTY,
+                                            BOND_COMMIT_PERIOD_MS);
+    bond_commit_period_ms = (period >= 0) ? period : BOND_COMMIT_PERIOD_MS;
+  }
+  bond_commit_strict =
+      osi_property_get_bool(BOND_COMMIT_STRICT_PROPERTY, false);
+  bond_commit_pending = false;
+
   LOG_EVENT_INT(BT_CONFIG_SOURCE_TAG_NUM, btif_config_source);
 
   return future_new_immediate(FUTURE_SUCCESS);
 
 error:
   alarm_free(config_timer);
+  alarm_free(bond_commit_timer);
   config.reset();
   btif_config_cache.Clear();
   config_timer = NULL;
+  bond_commit_timer = NULL;
   config = NULL;
   btif_config_source = NOT_LOADED;
   return future_new_immediate(FUTURE_FAIL);
 }
 
 static std::unique_ptr<config_t> btif_config_open(const char* filename) {
-
+  uint64_t start_us = time_get_os_boottime_us();
   std::unique_ptr<config_t> config = config_new(filename);
   if (!config) return nullptr;
 
+  LOG_INFO(LOG_TAG, "%s parsed %s: %zu sections in %" PRIu64 " us", __func__,
+           filename, config->sections.size(),
+           time_get_os_boottime_us() - start_us);
+
   if (!config_has_section(*config, "Adapter")) {
     LOG_ERROR(LOG_TAG, "Config is missing adapter section");
     return nullptr;
@@ -314,7 +391,13 @@ static std::unique_ptr<config_t> btif_config_open(const char* filename) {
 }
 
 static future_t* shut_down(void) {
-  btif_config_flush();
+  alarm_cancel(config_timer);
+  alarm_cancel(bond_commit_timer);
+  {
+    // Fold the journal into the config file while the stack is going down
+    std::unique_lock<std::recursive_mutex> lock(config_lock);
+    btif_config_write_full();
+  }
   return future_new_immediate(FUTURE_SUCCESS);
 }
 
@@ -323,9 +406,12 @@ static future_t* clean_up(void) {
 
   alarm_free(config_timer);
   config_timer = NULL;
+  alarm_free(bond_commit_timer);
+  bond_commit_timer = NULL;
 
   std::unique_lock<std::recursive_mutex> lock(config_lock);
   btif_config_cache.Clear();
+  config_journal_base.sections.clear();
   get_bluetooth_keystore_interface()->clear_map();
   return future_new_immediate(FUTURE_SUCCESS);
 }
@@ -458,6 +544,26 @@ static bool btif_in_encrypt_key_name_list(std::string key) {
                    key) != (encrypt_key_name_list + ENCRYPT_KEY_NAME_LIST_SIZE);
 }
 
+void btif_config_prefetch_encrypted_keys(void) {
+  std::vector<std::string> prefixes;
+  {
+    std::unique_lock<std::recursive_mutex> lock(config_lock);
+    config_t config = btif_config_cache.PersistentSectionCopy();
+    for (const section_t& section : config.sections.list()) {
+      for (const entry_t& entry : section.entries.list()) {
+        if (entry.value == ENCRYPTED_STR &&
+            btif_in_encrypt_key_name_list(entry.key))
+          prefixes.push_back(section.name + "-" + entry.key);
+      }
+    }
+  }
+  if (prefixes.empty()) return;
+
+  LOG_INFO(LOG_TAG, "%s fetching %zu encrypted keys", __func__,
+           prefixes.size());
+  get_bluetooth_keystore_interface()->prefetch_keys(prefixes);
+}
+
 bool btif_config_get_key_from_bin(const char* section, const char* key) {
   CHECK(section != NULL);
   CHECK(key != NULL);
@@ -622,26 +728,57 @@ std::vector<RawAddress> btif_config_get_paired_devices() {
 void btif_config_save(void) {
   CHECK(config_timer != NULL);
 
-  alarm_set(config_timer, CONFIG_SETTLE_PERIOD_MS, timer_config_save_cb, NULL);
+  alarm_set_with_slack(config_timer, CONFIG_SETTLE_PERIOD_MS,
+                       CONFIG_SETTLE_SLACK_MS, timer_config_save_cb, NULL);
 }
 
 void btif_config_flush(void) {
   CHECK(config_timer != NULL);
 
   alarm_cancel(config_timer);
+  alarm_cancel(bond_commit_timer);
   btif_config_write(0, NULL);
 }
 
+void btif_config_save_bond(void) {
+  CHECK(bond_commit_timer != NULL);
+
+  std::unique_lock<std::recursive_mutex> lock(config_lock);
+  // The first change opens the group, the ones after it ride along
+  if (bond_commit_pending) return;
+  bond_commit_pending = true;
+  alarm_set(bond_commit_timer, bond_commit_period_ms, timer_config_save_cb,
+            NULL);
+}
+
+void btif_config_sync_bond(void) {
+  CHECK(bond_commit_timer != NULL);
+
+  if (!bond_commit_strict) return;
+  {
+    std::unique_lock<std::recursive_mutex> lock(config_lock);
+    if (!bond_commit_pending) return;
+  }
+  btif_config_flush();
+}
+
 bool btif_config_clear(void) {
   CHECK(config_timer != NULL);
 
   alarm_cancel(config_timer);
+  alarm_cancel(bond_commit_timer);
 
   std::unique_lock<std::recursive_mutex> lock(config_lock);
 
+  bond_commit_pending = false;
   btif_config_cache.Clear();
-  bool ret = config_save(
-    btif_config_cache.PersistentSectionCopy(), CONFIG_FILE_PATH);
+  bool ret;
+  if (config_journal_enabled) {
+    ret = btif_config_write_full();
+  } else {
+    ret = config_save(btif_config_cache.PersistentSectionCopy(),
+                      CONFIG_FILE_PATH);
+  }
   btif_config_source = RESET;
 
   return ret;
@@ -658,15 +795,57 @@ static void btif_config_write(UNUSED_ATTR uint16_t event,
                               UNUSED_ATTR char* p_param) {
   CHECK(config_timer != NULL);
 
+  std::unique_lock<std::recursive_mutex> lock(config_lock);
+  // Whatever triggered this write, it carries the pending bond data too
+  bond_commit_pending = false;
+  if (config_journal_enabled) {
+    config_t current = btif_config_cache.PersistentSectionCopy();
+    size_t journal_size = 0;
+    if (btif_config_journal_append(CONFIG_JOURNAL_PATH, config_journal_base,
+                                   current, &journal_size) &&
+        journal_size < CONFIG_JOURNAL_COMPACT_SIZE) {
+      config_journal_base = std::move(current);
+      return;
+    }
+  }
+
+  btif_config_write_full();
+}
+
+// Writes the whole persistent config out. With the journal, the file gets the
+// next generation and an empty journal is started for it. Should the write
+// fail, the old journal stays valid for the backup the file was moved to.
+static bool btif_config_write_full(void) {
   std::unique_lock<std::recursive_mutex> lock(config_lock);
   rename(CONFIG_FILE_PATH, CONFIG_BACKUP_PATH);
 
-    config_save(btif_config_cache.PersistentSectionCopy(), CONFIG_FILE_PATH);
+  config_t config = btif_config_cache.PersistentSectionCopy();
+  uint64_t generation = config_journal_generation + 1;
+  if (config_journal_enabled)
+    config_set_uint64(&config, INFO_SECTION, JOURNAL_GENERATION, generation);
+
+  bool ret = config_save(config, CONFIG_FILE_PATH);
 
   if (is_common_criteria_mode()) {
     get_bluetooth_keystore_interface()->set_encrypt_key_or_remove_key(
         CONFIG_FILE_PREFIX, CONFIG_FILE_HASH);
   }
+
+  if (ret && config_journal_enabled) {
+    if (btif_config_journal_reset(CONFIG_JOURNAL_PATH, generation)) {
+      config_journal_generation = generation;
+      btif_config_cache.SetUint64(INFO_SECTION, JOURNAL_GENERATION,
+                                  generation);
+      config_journal_base = std::move(config);
+    } else {
+      // The old journal does not belong to the file any more
+      LOG_ERROR(LOG_TAG, "%s unable to start a journal, saving in full",
+                __func__);
+      remove(CONFIG_JOURNAL_PATH);
+      config_journal_enabled = false;
+    }
+  }
+  return ret;
 }
 
 void btif_debug_config_dump(int fd) {
@@ -703,6 +882,9 @@ void btif_debug_config_dump(int fd) {
   dprintf(fd, "  Devices loaded: %zu\n", devices.size());
   dprintf(fd, "  File created/tagged: %s\n", btif_config_time_created);
   dprintf(fd, "  File source: %s\n", file_source->c_str());
+  if (config_journal_enabled)
+    dprintf(fd, "  Journal generation: %llu\n",
+            (unsigned long long)config_journal_generation);
 }
 
 static bool is_factory_reset(void) {
@@ -714,5 +896,6 @@ static bool is_factory_reset(void) {
 static void delete_config_files(void) {
   remove(CONFIG_FILE_PATH);
   remove(CONFIG_BACKUP_PATH);
+  remove(CONFIG_JOURNAL_PATH);
   osi_property_set("persist.bluetooth.factoryreset", "false");
 }
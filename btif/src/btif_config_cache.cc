@@ -146,9 +146,8 @@ bool BtifConfigCache::RemoveKey(const std::string& section_name,
       paired_devices_list_.sections.erase(section_iter);
     } else if (!has_link_key_in_section(*section_iter)) {
       // if no link key in section after removal, move it to unpaired section
-      auto moved_section = std::move(*section_iter);
-      paired_devices_list_.sections.erase(section_iter);
-      unpaired_devices_cache_.Put(section_name, std::move(moved_section));
+      unpaired_devices_cache_.Put(
+          section_name, paired_devices_list_.sections.Take(section_iter));
     }
     return true;
   }
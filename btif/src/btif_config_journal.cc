@@ -0,0 +1,261 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_btif_config_journal"
+
+#include "btif_config_journal.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <string>
+#include <unordered_map>
+
+#include "osi/include/log.h"
+
+namespace {
+
+const char kJournalMagic[4] = {'B', 'T', 'J', '1'};
+const size_t kHeaderSize = sizeof(kJournalMagic) + sizeof(uint64_t);
+// A record is its payload length, the crc32 of the payload and the payload
+const size_t kRecordHeaderSize = 2 * sizeof(uint32_t);
+// Nothing in the config comes close, a larger length means a corrupt record
+const uint32_t kMaxRecordSize = 64 * 1024;
+
+enum : uint8_t {
+  JOURNAL_SET_KEY = 1,
+  JOURNAL_REMOVE_KEY = 2,
+  JOURNAL_REMOVE_SECTION = 3,
+};
+
+void put_string(std::string* out, const std::string& value) {
+  uint32_t len = value.size();
+  out->append((const char*)&len, sizeof(len));
+  out->append(value);
+}
+
+bool get_string(const uint8_t** p, const uint8_t* end, std::string* value) {
+  uint32_t len;
+  if ((size_t)(end - *p) < sizeof(len)) return false;
+  memcpy(&len, *p, sizeof(len));
+  *p += sizeof(len);
+  if ((size_t)(end - *p) < len) return false;
+  value->assign((const char*)*p, len);
+  *p += len;
+  return true;
+}
+
+void put_record(std::string* out, uint8_t op, const std::string& section,
+                const std::string* key, const std::string* value) {
+  std::string payload(1, (char)op);
+  put_string(&payload, section);
+  if (key) put_string(&payload, *key);
+  if (value) put_string(&payload, *value);
+
+  uint32_t len = payload.size();
+  uint32_t crc =
+      crc32(0, (const Bytef*)payload.data(), (uInt)payload.size());
+  out->append((const char*)&len, sizeof(len));
+  out->append((const char*)&crc, sizeof(crc));
+  out->append(payload);
+}
+
+bool apply_record(const uint8_t* p, const uint8_t* end, config_t* config) {
+  uint8_t op = *p++;
+  std::string section, key, value;
+  if (!get_string(&p, end, &section)) return false;
+
+  switch (op) {
+    case JOURNAL_SET_KEY: {
+      if (!get_string(&p, end, &key) || !get_string(&p, end, &value))
+        return false;
+      auto it = config->Find(section);
+      if (it == config->sections.end()) {
+        section_t new_section;
+        new_section.name = section;
+        config->sections.emplace_back(std::move(new_section));
+        it = std::prev(config->sections.end());
+      }
+      it->Set(key, value);
+      return true;
+    }
+    case JOURNAL_REMOVE_KEY: {
+      if (!get_string(&p, end, &key)) return false;
+      auto it = config->Find(section);
+      if (it != config->sections.end()) {
+        auto entry = it->Find(key);
+        if (entry != it->entries.end()) it->entries.erase(entry);
+      }
+      return true;
+    }
+    case JOURNAL_REMOVE_SECTION: {
+      auto it = config->Find(section);
+      if (it != config->sections.end()) config->sections.erase(it);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+bool sync_and_close(FILE* fp, const char* path) {
+  bool ok = fflush(fp) == 0;
+  if (ok && fsync(fileno(fp)) < 0) {
+    LOG_WARN(LOG_TAG, "%s unable to fsync '%s': %s", __func__, path,
+             strerror(errno));
+  }
+  return (fclose(fp) == 0) && ok;
+}
+
+}  // namespace
+
+bool btif_config_journal_reset(const char* path, uint64_t generation) {
+  FILE* fp = fopen(path, "wb");
+  if (!fp) {
+    LOG_ERROR(LOG_TAG, "%s unable to create '%s': %s", __func__, path,
+              strerror(errno));
+    return false;
+  }
+  bool ok = fwrite(kJournalMagic, sizeof(kJournalMagic), 1, fp) == 1 &&
+            fwrite(&generation, sizeof(generation), 1, fp) == 1;
+  ok = sync_and_close(fp, path) && ok;
+  if (!ok)
+    LOG_ERROR(LOG_TAG, "%s unable to write '%s': %s", __func__, path,
+              strerror(errno));
+  return ok;
+}
+
+bool btif_config_journal_append(const char* path, const config_t& from,
+                                const config_t& to, size_t* size) {
+  std::unordered_map<std::string, const section_t*> from_sections;
+  for (const section_t& section : from.sections)
+    from_sections[section.name] = &section;
+
+  std::string records;
+  for (const section_t& section : to.sections) {
+    auto found = from_sections.find(section.name);
+    const section_t* old_section =
+        found != from_sections.end() ? found->second : nullptr;
+    if (old_section) from_sections.erase(found);
+
+    std::unordered_map<std::string, const std::string*> old_entries;
+    if (old_section) {
+      for (const entry_t& entry : old_section->entries)
+        old_entries[entry.key] = &entry.value;
+    }
+    for (const entry_t& entry : section.entries) {
+      auto old_entry = old_entries.find(entry.key);
+      if (old_entry != old_entries.end()) {
+        bool changed = *old_entry->second != entry.value;
+        old_entries.erase(old_entry);
+        if (!changed) continue;
+      }
+      put_record(&records, JOURNAL_SET_KEY, section.name, &entry.key,
+                 &entry.value);
+    }
+    for (const auto& old_entry : old_entries)
+      put_record(&records, JOURNAL_REMOVE_KEY, section.name, &old_entry.first,
+                 nullptr);
+  }
+  for (const auto& old_section : from_sections)
+    put_record(&records, JOURNAL_REMOVE_SECTION, old_section.first, nullptr,
+               nullptr);
+
+  FILE* fp = fopen(path, "r+b");
+  if (!fp) {
+    LOG_ERROR(LOG_TAG, "%s unable to open '%s': %s", __func__, path,
+              strerror(errno));
+    return false;
+  }
+  bool ok = fseek(fp, 0, SEEK_END) == 0;
+  long offset = ftell(fp);
+  ok = ok && offset >= (long)kHeaderSize;
+  if (records.empty()) {
+    fclose(fp);
+  } else {
+    ok = ok && fwrite(records.data(), records.size(), 1, fp) == 1;
+    ok = sync_and_close(fp, path) && ok;
+  }
+  if (!ok) {
+    LOG_ERROR(LOG_TAG, "%s unable to append to '%s': %s", __func__, path,
+              strerror(errno));
+    return false;
+  }
+  *size = offset + records.size();
+  return true;
+}
+
+int btif_config_journal_replay(const char* path, uint64_t generation,
+                               config_t* config) {
+  FILE* fp = fopen(path, "rb");
+  if (!fp) return -1;
+
+  std::string contents;
+  char buffer[4096];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+    contents.append(buffer, read);
+  fclose(fp);
+
+  uint64_t journal_generation;
+  if (contents.size() < kHeaderSize ||
+      memcmp(contents.data(), kJournalMagic, sizeof(kJournalMagic)) != 0) {
+    LOG_WARN(LOG_TAG, "%s ignoring invalid journal '%s'", __func__, path);
+    return -1;
+  }
+  memcpy(&journal_generation, contents.data() + sizeof(kJournalMagic),
+         sizeof(journal_generation));
+  if (journal_generation != generation) {
+    LOG_WARN(LOG_TAG,
+             "%s ignoring journal of generation %llu, config is at %llu",
+             __func__, (unsigned long long)journal_generation,
+             (unsigned long long)generation);
+    return -1;
+  }
+
+  const uint8_t* data = (const uint8_t*)contents.data();
+  size_t offset = kHeaderSize;
+  int applied = 0;
+  while (contents.size() - offset >= kRecordHeaderSize) {
+    uint32_t len, crc;
+    memcpy(&len, data + offset, sizeof(len));
+    memcpy(&crc, data + offset + sizeof(len), sizeof(crc));
+    const uint8_t* payload = data + offset + kRecordHeaderSize;
+    if (len == 0 || len > kMaxRecordSize ||
+        contents.size() - offset - kRecordHeaderSize < len ||
+        crc32(0, payload, len) != crc)
+      break;
+    if (!apply_record(payload, payload + len, config)) break;
+    applied++;
+    offset += kRecordHeaderSize + len;
+  }
+
+  if (offset != contents.size()) {
+    // Drop the torn tail, so that later records are appended after the last
+    // good one.
+    LOG_WARN(LOG_TAG, "%s dropping %zu bytes at the end of '%s'", __func__,
+             contents.size() - offset, path);
+    if (truncate(path, offset) < 0)
+      LOG_ERROR(LOG_TAG, "%s unable to truncate '%s': %s", __func__, path,
+                strerror(errno));
+  }
+  return applied;
+}
@@ -41,6 +41,7 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <new>
 
 #include "bt_common.h"
 #include "bt_utils.h"
@@ -57,6 +58,7 @@
 #include "btif_uid.h"
 #include "btif_util.h"
 #include "btu.h"
+#include "common/inline_task_ring.h"
 #include "device/include/controller.h"
 #include "osi/include/fixed_queue.h"
 #include "osi/include/future.h"
@@ -138,6 +140,15 @@ static uid_set_t* uid_set = NULL;
 base::MessageLoop* message_loop_ = NULL;
 base::RunLoop* jni_run_loop = NULL;
 
+/* Preallocated queue in front of the JNI message loop. Tasks posted through
+ * it cost no allocation, only one drain task is posted per burst. */
+static const size_t BTIF_JNI_RING_SLOTS = 64;
+static const size_t BTIF_JNI_RING_BATCH = 16;
+static bluetooth::common::InlineTaskRing<BTIF_JNI_RING_SLOTS,
+                                         BTIF_JNI_INLINE_PAYLOAD_SIZE>
+    jni_task_ring;
+static base::Closure jni_ring_drain_closure;
+
 /*******************************************************************************
  *  Static functions
  ******************************************************************************/
@@ -203,15 +214,70 @@ static void btif_context_switched(void* p_msg) {
  *
  ******************************************************************************/
 
+static void btif_jni_ring_drain(void) {
+  if (jni_task_ring.Drain(BTIF_JNI_RING_BATCH) && message_loop_)
+    message_loop_->task_runner()->PostTask(FROM_HERE, jni_ring_drain_closure);
+}
+
+static void btif_jni_ring_context_switched(void* p_payload, bool run) {
+  if (run) btif_context_switched(p_payload);
+}
+
+static void btif_jni_ring_run_closure(void* p_payload, bool run) {
+  using base::Closure;
+  Closure* p_task = static_cast<Closure*>(p_payload);
+  if (run) p_task->Run();
+  p_task->~Closure();
+}
+
+/* Queue a task in jni_task_ring, |fill| constructs its payload in place */
+template <typename Fill>
+static bool btif_jni_ring_push(tBTIF_INLINE_CBACK* p_cback, size_t len,
+                               Fill fill) {
+  if (!message_loop_ || !message_loop_->task_runner().get()) return false;
+
+  bool schedule = false;
+  if (!jni_task_ring.Push(p_cback, len, fill, &schedule)) return false;
+
+  if (schedule)
+    message_loop_->task_runner()->PostTask(FROM_HERE, jni_ring_drain_closure);
+  return true;
+}
+
+bool do_in_jni_thread_inline(tBTIF_INLINE_CBACK* p_cback,
+                             const void* p_payload, size_t len) {
+  return btif_jni_ring_push(p_cback, len, [p_payload, len](void* p_slot) {
+    memcpy(p_slot, p_payload, len);
+  });
+}
+
 bt_status_t btif_transfer_context(tBTIF_CBACK* p_cback, uint16_t event,
                                   char* p_params, int param_len,
                                   tBTIF_COPY_CBACK* p_copy_cback) {
-  tBTIF_CONTEXT_SWITCH_CBACK* p_msg = (tBTIF_CONTEXT_SWITCH_CBACK*)osi_malloc(
-      sizeof(tBTIF_CONTEXT_SWITCH_CBACK) + param_len + 1);
-
   BTIF_TRACE_VERBOSE("btif_transfer_context event %d, len %d", event,
                      param_len);
 
+  /* small parameters are copied straight into the JNI task ring */
+  auto fill = [=](void* p_slot) {
+    tBTIF_CONTEXT_SWITCH_CBACK* p_msg = (tBTIF_CONTEXT_SWITCH_CBACK*)p_slot;
+    p_msg->hdr.event = BT_EVT_CONTEXT_SWITCH_EVT;
+    p_msg->p_cb = p_cback;
+    p_msg->event = event;
+    if (p_copy_cback) {
+      p_copy_cback(event, p_msg->p_param, p_params);
+    } else if (p_params) {
+      memcpy(p_msg->p_param, p_params, param_len);
+    }
+    p_msg->len = param_len;
+  };
+  if (btif_jni_ring_push(&btif_jni_ring_context_switched,
+                         sizeof(tBTIF_CONTEXT_SWITCH_CBACK) + param_len,
+                         fill))
+    return BT_STATUS_SUCCESS;
+
+  tBTIF_CONTEXT_SWITCH_CBACK* p_msg = (tBTIF_CONTEXT_SWITCH_CBACK*)osi_malloc(
+      sizeof(tBTIF_CONTEXT_SWITCH_CBACK) + param_len + 1);
+
   /* allocate and send message that will be executed in btif context */
   p_msg->hdr.event = BT_EVT_CONTEXT_SWITCH_EVT; /* internal event */
   p_msg->p_cb = p_cback;
@@ -243,6 +309,11 @@ bt_status_t do_in_jni_thread(const base::Location& from_here,
     return BT_STATUS_FAIL;
   }
 
+  if (btif_jni_ring_push(
+          &btif_jni_ring_run_closure, sizeof(base::Closure),
+          [&task](void* p_slot) { new (p_slot) base::Closure(task); }))
+    return BT_STATUS_SUCCESS;
+
   if (message_loop_->task_runner()->PostTask(from_here, task))
     return BT_STATUS_SUCCESS;
 
@@ -340,6 +411,7 @@ void run_message_loop(UNUSED_ATTR void* context) {
   // when we free it.
   base::AtExitManager exit_manager;
 
+  jni_ring_drain_closure = base::Bind(&btif_jni_ring_drain);
   message_loop_ = new base::MessageLoop(base::MessageLoop::Type::TYPE_DEFAULT);
 
   // Associate this workqueue thread with JNI.
@@ -352,6 +424,7 @@ void run_message_loop(UNUSED_ATTR void* context) {
 
   delete message_loop_;
   message_loop_ = NULL;
+  jni_task_ring.Clear();
 
   delete jni_run_loop;
   jni_run_loop = NULL;
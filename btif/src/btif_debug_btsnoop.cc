@@ -16,7 +16,12 @@
  *
  ******************************************************************************/
 
+#define LOG_TAG "bt_btif_debug_btsnoop"
+
+#include <algorithm>
+#include <deque>
 #include <mutex>
+#include <vector>
 
 #include <base/logging.h>
 #include <resolv.h>
@@ -26,8 +31,13 @@
 #include "btif/include/btif_debug_btsnoop.h"
 #include "hci/include/btsnoop_mem.h"
 #include "internal_include/bt_target.h"
+#include "osi/include/log.h"
+#include "osi/include/osi.h"
+#include "osi/include/properties.h"
 #include "osi/include/ringbuffer.h"
+#include "osi/include/thread.h"
 #include "osi/include/time.h"
+#include "stack/include/l2c_api.h"
 
 #define REDUCE_HCI_TYPE_TO_SIGNIFICANT_BITS(type) ((type) >> 8)
 
@@ -42,13 +52,36 @@ static const size_t BLOCK_SIZE = 16384;
 // Maximum line length in bugreport (should be multiple of 4 for base64 output)
 static const uint8_t MAX_LINE_LENGTH = 128;
 
+// Once this many bytes of packets are buffered, they are compressed into a
+// block in the background. Compressed blocks are kept, oldest evicted first,
+// until they exceed the memory budget.
+static const size_t COMPRESS_BLOCK_SIZE = (64 * 1024);
+#define BTSNOOZ_BUDGET_PROPERTY "persist.vendor.bt.btsnooz_budget_kb"
+static const int32_t BTSNOOZ_DEFAULT_BUDGET_KB = 1024;
+
+typedef struct {
+  std::vector<uint8_t> data;  // Raw deflate data ending on a byte boundary.
+  size_t uncompressed_length;
+  uLong adler;
+} compressed_block_t;
+
 static std::mutex buffer_mutex;
 static ringbuffer_t* buffer = NULL;
 static uint64_t last_timestamp_ms = 0;
+static bool compress_pending = false;  // guarded by |buffer_mutex|
+
+// Held while a block moves from |buffer| to |compressed_blocks| so that a
+// dump never misses it.
+static std::mutex compress_mutex;
+static std::deque<compressed_block_t> compressed_blocks;
+static size_t compressed_size = 0;
+static size_t compressed_budget = 0;
+static thread_t* compress_thread = NULL;
 
 static size_t btsnoop_calculate_packet_length(uint16_t type,
                                               const uint8_t* data,
                                               size_t length);
+static void compress_oldest_packets(void* context);
 
 __attribute__((no_sanitize("integer")))
 static void btsnoop_cb(const uint16_t type, const uint8_t* data,
@@ -60,7 +93,8 @@ static void btsnoop_cb(const uint16_t type, const uint8_t* data,
 
   std::lock_guard<std::mutex> lock(buffer_mutex);
 
-  // Make room in the ring buffer
+  // Make room in the ring buffer. This only drops packets if the compression
+  // thread falls behind.
 
   while (ringbuffer_available(buffer) <
          (included_length + sizeof(btsnooz_header_t))) {
@@ -78,6 +112,12 @@ static void btsnoop_cb(const uint16_t type, const uint8_t* data,
 
   ringbuffer_insert(buffer, (uint8_t*)&header, sizeof(btsnooz_header_t));
   ringbuffer_insert(buffer, data, included_length);
+
+  if (compress_thread && !compress_pending &&
+      ringbuffer_size(buffer) >= COMPRESS_BLOCK_SIZE) {
+    compress_pending = true;
+    thread_post(compress_thread, compress_oldest_packets, NULL);
+  }
 }
 
 static size_t btsnoop_calculate_packet_length(uint16_t type,
@@ -107,6 +147,7 @@ static size_t btsnoop_calculate_packet_length(uint16_t type,
       size_t len_hci_acl = HCI_ACL_HEADER_SIZE + L2CAP_HEADER_SIZE;
       // Check if we have enough data for an L2CAP header
       if (length > len_hci_acl) {
+        uint16_t handle = (data[0] | (data[1] << 8)) & 0x0FFF;
         uint16_t l2cap_cid =
             data[L2CAP_CID_OFFSET] | (data[L2CAP_CID_OFFSET + 1] << 8);
         if (l2cap_cid == L2CAP_SIGNALING_CID) {
@@ -114,6 +155,11 @@ static size_t btsnoop_calculate_packet_length(uint16_t type,
           // That way, the PSM setup is captured, allowing decoding of PSMs down
           // the road.
           return length;
+        } else if (L2CA_isMediaChannel(handle, l2cap_cid,
+                                       type == BT_EVT_TO_BTU_HCI_ACL)) {
+          // Media packets only keep their headers; they make up most of
+          // the traffic and nothing past the L2CAP header is useful.
+          return len_hci_acl;
         } else {
           // Otherwise, return as much as we reasonably can
           len_hci_acl = MAX_HCI_ACL_LEN;
@@ -132,101 +178,181 @@ static size_t btsnoop_calculate_packet_length(uint16_t type,
   }
 }
 
-static bool btsnoop_compress(ringbuffer_t* rb_dst, ringbuffer_t* rb_src) {
-  CHECK(rb_dst != NULL);
-  CHECK(rb_src != NULL);
-
+// Compresses |length| bytes at |data| into an independent raw deflate block.
+// The block ends with a sync flush so that blocks can be concatenated.
+static bool btsnoop_compress_block(const uint8_t* data, size_t length,
+                                   compressed_block_t* block) {
   z_stream zs;
   zs.zalloc = Z_NULL;
   zs.zfree = Z_NULL;
   zs.opaque = Z_NULL;
 
-  if (deflateInit(&zs, Z_DEFAULT_COMPRESSION) != Z_OK) return false;
+  if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK)
+    return false;
 
   bool rc = true;
-  uint8_t block_src[BLOCK_SIZE];
   uint8_t block_dst[BLOCK_SIZE];
 
-  const size_t num_blocks =
-      (ringbuffer_size(rb_src) + BLOCK_SIZE - 1) / BLOCK_SIZE;
-  for (size_t i = 0; i < num_blocks; ++i) {
-    zs.avail_in =
-        ringbuffer_peek(rb_src, i * BLOCK_SIZE, block_src, BLOCK_SIZE);
-    zs.next_in = block_src;
-
-    do {
-      zs.avail_out = BLOCK_SIZE;
-      zs.next_out = block_dst;
-
-      int err = deflate(&zs, (i == num_blocks - 1) ? Z_FINISH : Z_NO_FLUSH);
-      if (err == Z_STREAM_ERROR) {
-        rc = false;
-        break;
-      }
+  block->data.clear();
+  block->uncompressed_length = length;
+  block->adler = adler32(adler32(0L, Z_NULL, 0), data, length);
 
-      const size_t length = BLOCK_SIZE - zs.avail_out;
-      ringbuffer_insert(rb_dst, block_dst, length);
-    } while (zs.avail_out == 0);
-  }
+  zs.next_in = const_cast<uint8_t*>(data);
+  zs.avail_in = length;
+  do {
+    zs.avail_out = BLOCK_SIZE;
+    zs.next_out = block_dst;
+
+    if (deflate(&zs, Z_SYNC_FLUSH) == Z_STREAM_ERROR) {
+      rc = false;
+      break;
+    }
+
+    block->data.insert(block->data.end(), block_dst,
+                       block_dst + (BLOCK_SIZE - zs.avail_out));
+  } while (zs.avail_out == 0);
 
   deflateEnd(&zs);
   return rc;
 }
 
+// Copies whole packets from the front of |rb| into |out| until at least
+// |max_length| bytes have been taken or |rb| is empty. Packets are removed
+// from |rb| if |pop| is true.
+static void btsnoop_take_packets(ringbuffer_t* rb, size_t max_length, bool pop,
+                                 std::vector<uint8_t>* out) {
+  size_t offset = 0;
+  size_t available = ringbuffer_size(rb);
+  while (offset < max_length &&
+         available - offset >= sizeof(btsnooz_header_t)) {
+    btsnooz_header_t header;
+    ringbuffer_peek(rb, offset, (uint8_t*)&header, sizeof(btsnooz_header_t));
+    size_t packet_length = sizeof(btsnooz_header_t) + header.length - 1;
+
+    size_t start = out->size();
+    out->resize(start + packet_length);
+    ringbuffer_peek(rb, offset, out->data() + start, packet_length);
+    offset += packet_length;
+  }
+  if (pop) ringbuffer_delete(rb, offset);
+}
+
+static void compress_oldest_packets(UNUSED_ATTR void* context) {
+  std::lock_guard<std::mutex> compress_lock(compress_mutex);
+
+  std::vector<uint8_t> packets;
+  {
+    std::lock_guard<std::mutex> lock(buffer_mutex);
+    btsnoop_take_packets(buffer, COMPRESS_BLOCK_SIZE, true, &packets);
+    compress_pending = false;
+  }
+  if (packets.empty()) return;
+
+  compressed_block_t block;
+  if (!btsnoop_compress_block(packets.data(), packets.size(), &block)) {
+    LOG_ERROR(LOG_TAG, "%s unable to compress %zu bytes", __func__,
+              packets.size());
+    return;
+  }
+
+  compressed_size += block.data.size();
+  compressed_blocks.push_back(std::move(block));
+  while (compressed_size > compressed_budget && !compressed_blocks.empty()) {
+    compressed_size -= compressed_blocks.front().data.size();
+    compressed_blocks.pop_front();
+  }
+}
+
 void btif_debug_btsnoop_init(void) {
   if (buffer == NULL) buffer = ringbuffer_init(BTSNOOP_MEM_BUFFER_SIZE);
+
+  int32_t budget_kb = osi_property_get_int32(BTSNOOZ_BUDGET_PROPERTY,
+                                             BTSNOOZ_DEFAULT_BUDGET_KB);
+  {
+    std::lock_guard<std::mutex> lock(compress_mutex);
+    compressed_budget = budget_kb > 0 ? (size_t)budget_kb * 1024 : 0;
+  }
+
+  // Without a budget only the uncompressed ring buffer is kept.
+  if (compressed_budget && compress_thread == NULL) {
+    compress_thread = thread_new("btsnooz_compress");
+    if (compress_thread == NULL)
+      LOG_ERROR(LOG_TAG, "%s unable to create compression thread", __func__);
+  }
+
   btsnoop_mem_set_callback(btsnoop_cb);
 }
 
 void btif_debug_btsnoop_dump(int fd) {
-  ringbuffer_t* ringbuffer = ringbuffer_init(BTSNOOP_MEM_BUFFER_SIZE);
-  if (ringbuffer == NULL) {
-    dprintf(fd, "%s Unable to allocate memory for compression", __func__);
-    return;
-  }
-
-  // Prepend preamble
+  // The blocks are concatenated into a single zlib stream: the header, the
+  // raw deflate blocks, an empty final block and the checksum.
+  std::vector<uint8_t> out;
 
   btsnooz_preamble_t preamble;
   preamble.version = BTSNOOZ_CURRENT_VERSION;
-  preamble.last_timestamp_ms = last_timestamp_ms;
-  ringbuffer_insert(ringbuffer, (uint8_t*)&preamble,
-                    sizeof(btsnooz_preamble_t));
-
-  // Compress data
+  out.push_back(0x78);
+  out.push_back(0x9c);
 
-  uint8_t b64_in[3] = {0};
-  char b64_out[5] = {0};
+  bool rc = true;
+  size_t total_length = 0;
+  uLong adler = adler32(0L, Z_NULL, 0);
+  {
+    std::lock_guard<std::mutex> compress_lock(compress_mutex);
+    for (const compressed_block_t& block : compressed_blocks) {
+      out.insert(out.end(), block.data.begin(), block.data.end());
+      adler = adler32_combine(adler, block.adler, block.uncompressed_length);
+      total_length += block.uncompressed_length;
+    }
 
-  size_t line_length = 0;
+    std::vector<uint8_t> packets;
+    {
+      std::lock_guard<std::mutex> lock(buffer_mutex);
+      preamble.last_timestamp_ms = last_timestamp_ms;
+      btsnoop_take_packets(buffer, ringbuffer_size(buffer), false, &packets);
+    }
 
-  bool rc;
-  {
-    std::lock_guard<std::mutex> lock(buffer_mutex);
-    dprintf(fd, "--- BEGIN:BTSNOOP_LOG_SUMMARY (%zu bytes in) ---\n",
-            ringbuffer_size(buffer));
-    rc = btsnoop_compress(ringbuffer, buffer);
+    if (!packets.empty()) {
+      compressed_block_t block;
+      rc = btsnoop_compress_block(packets.data(), packets.size(), &block);
+      out.insert(out.end(), block.data.begin(), block.data.end());
+      adler = adler32_combine(adler, block.adler, block.uncompressed_length);
+      total_length += block.uncompressed_length;
+    }
   }
 
+  dprintf(fd, "--- BEGIN:BTSNOOP_LOG_SUMMARY (%zu bytes in) ---\n",
+          total_length);
+
   if (rc == false) {
     dprintf(fd, "%s Log compression failed", __func__);
-    goto error;
+    return;
   }
 
+  out.push_back(0x03);  // Empty final block.
+  out.push_back(0x00);
+  for (int shift = 24; shift >= 0; shift -= 8)
+    out.push_back((uint8_t)(adler >> shift));
+
+  // Prepend preamble
+
+  out.insert(out.begin(), (uint8_t*)&preamble,
+             (uint8_t*)&preamble + sizeof(btsnooz_preamble_t));
+
   // Base64 encode & output
 
-  while (ringbuffer_size(ringbuffer) > 0) {
-    size_t read = ringbuffer_pop(ringbuffer, b64_in, 3);
+  char b64_out[5] = {0};
+  size_t line_length = 0;
+
+  for (size_t offset = 0; offset < out.size(); offset += 3) {
+    size_t read = std::min(out.size() - offset, (size_t)3);
     if (line_length >= MAX_LINE_LENGTH) {
       dprintf(fd, "\n");
       line_length = 0;
     }
-    line_length += b64_ntop(b64_in, read, b64_out, 5);
+    line_length += b64_ntop(out.data() + offset, read, b64_out, 5);
     dprintf(fd, "%s", b64_out);
   }
 
   dprintf(fd, "\n--- END:BTSNOOP_LOG_SUMMARY ---\n");
-
-error:
-  ringbuffer_free(ringbuffer);
 }
@@ -316,6 +316,12 @@ tBTA_TRANSPORT btif_dm_SDP_interrupt_transport = BTA_TRANSPORT_UNKNOWN;
 static char btif_default_local_name[DEFAULT_LOCAL_NAME_MAX + 1] = {'\0'};
 static uid_set_t* uid_set = NULL;
 
+/* Read on every inquiry and discovery result */
+static osi_cached_property_t donglemode_prop_cache =
+    OSI_CACHED_PROPERTY("persist.bluetooth.donglemode");
+static osi_cached_property_t restrict_report_prop_cache =
+    OSI_CACHED_PROPERTY("bluetooth.restrict_discovered_device.enabled");
+
 /* A circular array to keep track of the most recent bond events */
 static btif_bond_event_t btif_dm_bond_events[MAX_BTIF_BOND_EVENT_ENTRIES + 1];
 
@@ -759,6 +765,8 @@ void bond_state_changed(bt_status_t status, const RawAddress& bd_addr,
   BTIF_TRACE_DEBUG("%s: state=%d, prev_state=%d, sdp_attempts = %d", __func__,
                    state, pairing_cb.state, pairing_cb.sdp_attempts);
 
+  if (state == BT_BOND_STATE_BONDED) btif_config_sync_bond();
+
   auto tmp = bd_addr;
   HAL_CBACK(bt_hal_cbacks, bond_state_changed_cb, status, &tmp, state, pairing_cb.fail_reason);
 
@@ -1791,8 +1799,8 @@ static void btif_dm_search_devices_evt(uint16_t event, char* p_param) {
         ASSERTC(status == BT_STATUS_SUCCESS,
                 "failed to save remote addr type (inquiry)", status);
 
-        bool restrict_report = osi_property_get_bool(
-            "bluetooth.restrict_discovered_device.enabled", false);
+        bool restrict_report =
+            osi_cached_property_get_bool(&restrict_report_prop_cache, false);
         if (restrict_report &&
             p_search_data->inq_res.device_type == BT_DEVICE_TYPE_BLE &&
             !(p_search_data->inq_res.ble_evt_type & BTM_BLE_CONNECTABLE_MASK)) {
@@ -1836,7 +1844,7 @@ static void btif_dm_search_devices_evt(uint16_t event, char* p_param) {
        */
       if (btif_dm_inquiry_in_progress == false) {
         char donglemode_prop[PROPERTY_VALUE_MAX] = "false";
-        if(osi_property_get("persist.bluetooth.donglemode", donglemode_prop, "false") &&
+        if(osi_cached_property_get(&donglemode_prop_cache, donglemode_prop, "false") &&
             !strcmp(donglemode_prop, "false")) {
           btgatt_filt_param_setup_t adv_filt_param;
           memset(&adv_filt_param, 0, sizeof(btgatt_filt_param_setup_t));
@@ -2309,6 +2317,7 @@ static void btif_dm_upstreams_evt(uint16_t event, char* p_param) {
       if (p_data->link_up.link_type == BT_TRANSPORT_BR_EDR) {
         num_active_br_edr_links++;
         BTIF_TRACE_DEBUG("num_active_br_edr_links is %d ", num_active_br_edr_links);
+        btif_storage_update_conn_profile(bd_addr);
       }
 
       if (!is_bonding_or_sdp() && btif_dm_SDP_interrupt && btif_dm_SDP_interrupt_bd_addr == bd_addr &&
@@ -2841,11 +2850,13 @@ static void bte_search_devices_evt(tBTA_DM_SEARCH_EVT event,
   BTIF_TRACE_DEBUG("%s event=%s param_len=%d", __func__,
                    dump_dm_search_event(event), param_len);
 
-  /* if remote name is available in EIR, set teh flag so that stack doesnt
-   * trigger RNR */
+  /* if remote name is available in EIR or was stored by an earlier discovery,
+   * set the flag so that stack doesnt trigger RNR. The stored name is the one
+   * reported with the inquiry result. */
   if (p_data && event == BTA_DM_INQ_RES_EVT)
     p_data->inq_res.remt_name_not_required =
-        check_eir_remote_name(p_data, NULL, NULL);
+        check_eir_remote_name(p_data, NULL, NULL) ||
+        check_cached_remote_name(p_data, NULL, NULL);
 
   btif_transfer_context(
       btif_dm_search_devices_evt, (uint16_t)event, (char*)p_data, param_len,
@@ -2978,7 +2989,7 @@ bt_status_t btif_dm_start_discovery(void) {
 #endif
 
   char donglemode_prop[PROPERTY_VALUE_MAX] = "false";
-  if(osi_property_get("persist.bluetooth.donglemode", donglemode_prop, "false") &&
+  if(osi_cached_property_get(&donglemode_prop_cache, donglemode_prop, "false") &&
       !strcmp(donglemode_prop, "false")) {
     /* Cleanup anything remaining on index 0 */
     do_in_bta_thread(
@@ -81,6 +81,7 @@
 #include "btif_dm.h"
 #include "btif_gatt.h"
 #include "btif_gatt_util.h"
+#include "btif_jni_batch.h"
 #include "btif_storage.h"
 #include "osi/include/log.h"
 #include "vendor_api.h"
@@ -143,9 +144,43 @@ namespace {
 
 uint8_t rssi_request_client_if;
 
+typedef struct {
+  int conn_id;
+  btgatt_notify_params_t params;
+} btif_gattc_batched_notify_t;
+
+/* Delivers each run of notifications of the same connection as one call */
+void btif_gattc_notify_batch_flush(
+    std::vector<btif_gattc_batched_notify_t>* notifications) {
+  if (!bt_gatt_callbacks || !bt_gatt_callbacks->client->notify_batch_cb)
+    return;
+
+  std::vector<btgatt_notify_params_t> run;
+  for (size_t i = 0; i < notifications->size(); i++) {
+    const btif_gattc_batched_notify_t& notify = (*notifications)[i];
+    run.push_back(notify.params);
+    if (i + 1 == notifications->size() ||
+        (*notifications)[i + 1].conn_id != notify.conn_id) {
+      bt_gatt_callbacks->client->notify_batch_cb(notify.conn_id, run);
+      run.clear();
+    }
+  }
+}
+
+/* Notifications for a client which registered the batched callback,
+ * configured by the properties below and accessed on the JNI thread only.
+ * The batch is flushed before indications and the other client events, so
+ * that Java still sees them in order. */
+BtifJniBatch<btif_gattc_batched_notify_t> notify_batch(
+    "btif.gattc_notify_batch", "persist.vendor.bt.gattc_batch_max_notify",
+    "persist.vendor.bt.gattc_batch_max_delay_us",
+    &btif_gattc_notify_batch_flush);
+
 void btif_gattc_upstreams_evt(uint16_t event, char* p_param) {
   LOG_VERBOSE(LOG_TAG, "%s: Event %d", __func__, event);
 
+  notify_batch.Flush();
+
   tBTA_GATTC* p_data = (tBTA_GATTC*)p_param;
   switch (event) {
     case BTA_GATTC_DEREG_EVT:
@@ -163,26 +198,6 @@ void btif_gattc_upstreams_evt(uint16_t event, char* p_param) {
       break;
     }
 
-    case BTA_GATTC_NOTIF_EVT: {
-      btgatt_notify_params_t data;
-
-      data.bda = p_data->notify.bda;
-      memcpy(data.value, p_data->notify.value, p_data->notify.len);
-
-      data.handle = p_data->notify.handle;
-      data.is_notify = p_data->notify.is_notify;
-      data.len = p_data->notify.len;
-
-      HAL_CBACK(bt_gatt_callbacks, client->notify_cb, p_data->notify.conn_id,
-                data);
-
-      if (!p_data->notify.is_notify)
-        BTA_GATTC_SendIndConfirm(p_data->notify.conn_id, p_data->notify.handle,
-            p_data->notify.trans_id);
-
-      break;
-    }
-
     case BTA_GATTC_OPEN_EVT: {
       VLOG(1) << "BTA_GATTC_OPEN_EVT " << p_data->open.remote_bda;
       HAL_CBACK(bt_gatt_callbacks, client->open_cb, p_data->open.conn_id,
@@ -266,7 +281,85 @@ void btif_gattc_upstreams_evt(uint16_t event, char* p_param) {
   }
 }
 
+static void btif_gattc_notify_evt(int conn_id, uint32_t trans_id,
+                                  btgatt_notify_params_t* p_data) {
+  if (p_data->is_notify && bt_gatt_callbacks &&
+      bt_gatt_callbacks->client->notify_batch_cb && notify_batch.IsEnabled()) {
+    notify_batch.Add({conn_id, *p_data});
+    return;
+  }
+
+  notify_batch.Flush();
+  HAL_CBACK(bt_gatt_callbacks, client->notify_cb, conn_id, *p_data);
+
+  if (!p_data->is_notify)
+    BTA_GATTC_SendIndConfirm(conn_id, p_data->handle, trans_id);
+}
+
+/* A notification as it is queued inline for the JNI thread, followed by
+ * |len| bytes of value */
+typedef struct {
+  uint16_t conn_id;
+  uint32_t trans_id;
+  RawAddress bda;
+  uint16_t handle;
+  uint16_t len;
+  bool is_notify;
+  uint8_t value[];
+} btif_gattc_inline_notify_t;
+
+static void btif_gattc_inline_notify_evt(void* p_payload, bool run) {
+  if (!run) return;
+
+  btif_gattc_inline_notify_t* p_notify =
+      (btif_gattc_inline_notify_t*)p_payload;
+  btgatt_notify_params_t params;
+  params.bda = p_notify->bda;
+  params.handle = p_notify->handle;
+  params.is_notify = p_notify->is_notify;
+  params.len = p_notify->len;
+  memcpy(params.value, p_notify->value, p_notify->len);
+  btif_gattc_notify_evt(p_notify->conn_id, p_notify->trans_id, &params);
+}
+
 void bta_gattc_cback(tBTA_GATTC_EVT event, tBTA_GATTC* p_data) {
+  if (event == BTA_GATTC_NOTIF_EVT) {
+    const tBTA_GATTC_NOTIFY& notify = p_data->notify;
+
+    /* Short values are copied into a preallocated slot of the JNI thread */
+    size_t inline_len = sizeof(btif_gattc_inline_notify_t) + notify.len;
+    if (inline_len <= BTIF_JNI_INLINE_PAYLOAD_SIZE) {
+      alignas(btif_gattc_inline_notify_t)
+          uint8_t payload[BTIF_JNI_INLINE_PAYLOAD_SIZE];
+      btif_gattc_inline_notify_t* p_notify =
+          (btif_gattc_inline_notify_t*)payload;
+      p_notify->conn_id = notify.conn_id;
+      p_notify->trans_id = notify.trans_id;
+      p_notify->bda = notify.bda;
+      p_notify->handle = notify.handle;
+      p_notify->len = notify.len;
+      p_notify->is_notify = notify.is_notify;
+      memcpy(p_notify->value, notify.value, notify.len);
+      if (do_in_jni_thread_inline(&btif_gattc_inline_notify_evt, payload,
+                                  inline_len))
+        return;
+    }
+
+    /* Notifications skip the generic context switch, which copies the whole
+     * tBTA_GATTC union. The HAL parameters are built once, with only the
+     * bytes of the value, and handed to the JNI thread as they are. */
+    btgatt_notify_params_t* params = new btgatt_notify_params_t;
+    params->bda = notify.bda;
+    params->handle = notify.handle;
+    params->is_notify = notify.is_notify;
+    params->len = notify.len;
+    memcpy(params->value, notify.value, notify.len);
+
+    do_in_jni_thread(Bind(&btif_gattc_notify_evt, notify.conn_id,
+                          notify.trans_id, Owned(params)));
+    return;
+  }
+
   bt_status_t status =
       btif_transfer_context(btif_gattc_upstreams_evt, (uint16_t)event,
                             (char*)p_data, sizeof(tBTA_GATTC), NULL);
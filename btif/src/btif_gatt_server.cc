@@ -67,6 +67,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+
 #include <hardware/bluetooth.h>
 #include <hardware/bt_gatt.h>
 
@@ -460,6 +462,27 @@ static bt_status_t btif_gatts_send_indication(int server_if,
   //       invoked without need for confirmation.
 }
 
+static bt_status_t btif_gatts_send_notifications(
+    int server_if, const btgatt_notification_t* notifications, size_t count) {
+  CHECK_BTGATT_INIT();
+
+  if (count == 0) return BT_STATUS_SUCCESS;
+  if (count > UINT16_MAX) return BT_STATUS_PARM_INVALID;
+
+  std::vector<tBTA_GATTS_NTF> ntfs(count);
+  for (size_t i = 0; i < count; i++) {
+    ntfs[i].conn_id = notifications[i].conn_id;
+    ntfs[i].attr_id = notifications[i].attribute_handle;
+    ntfs[i].len = std::min<size_t>(notifications[i].length, BTGATT_MAX_ATTR_LEN);
+    ntfs[i].p_value = notifications[i].value;
+  }
+
+  // The values are copied into a single message, which is the only task
+  // posted for the whole batch
+  BTA_GATTS_HandleValueNotifications(ntfs.data(), count);
+  return BT_STATUS_SUCCESS;
+}
+
 static void btif_gatts_send_response_impl(int conn_id, int trans_id, int status,
                                           btgatt_response_t response) {
   tGATTS_RSP rsp_struct;
@@ -503,4 +526,4 @@ const btgatt_server_interface_t btgattServerInterface = {
     btif_gatts_add_service,    btif_gatts_stop_service,
     btif_gatts_delete_service, btif_gatts_send_indication,
     btif_gatts_send_response,  btif_gatts_set_preferred_phy,
-    btif_gatts_read_phy};
+    btif_gatts_read_phy,       btif_gatts_send_notifications};
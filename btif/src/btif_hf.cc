@@ -79,6 +79,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "btif_hf.h"
 #include "btif_profile_queue.h"
 #include "btif_util.h"
+#include "btm_conn_trace.h"
 #include "osi/include/properties.h"
 #include <cutils/properties.h>
 #include "device/include/controller.h"
@@ -664,6 +665,8 @@ static void btif_hf_upstreams_evt(uint16_t event, char* p_param) {
 
       btif_hf_cb[idx].peer_feat = p_data->conn.peer_feat;
       btif_hf_cb[idx].state = BTHF_CONNECTION_STATE_SLC_CONNECTED;
+      btm_conn_trace_profile_connected(btif_hf_cb[idx].connected_bda,
+                                       BT_TRANSPORT_BR_EDR, "HFP");
 
       HAL_HF_CBACK(bt_hf_callbacks, ConnectionStateCallback, btif_hf_cb[idx].state,
                 &btif_hf_cb[idx].connected_bda);
@@ -673,6 +673,39 @@ void btif_hh_disconnect(RawAddress* bd_addr) {
     BTIF_TRACE_DEBUG("%s-- Error: device not connected:", __func__);
 }
 
+/*******************************************************************************
+ *
+ * Function         btif_debug_hh_dump
+ *
+ * Description      Dump the input report statistics of the connected HID
+ *                  devices
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btif_debug_hh_dump(int fd) {
+  dprintf(fd, "\nHID Host Input Reports:\n");
+  for (int i = 0; i < BTIF_HH_MAX_HID; i++) {
+    const btif_hh_device_t* p_dev = &btif_hh_cb.devices[i];
+    if (p_dev->dev_status != BTHH_CONN_STATE_CONNECTED) continue;
+
+    uint64_t avg_us = p_dev->input_rpt_count
+                          ? p_dev->input_rpt_lat_sum_us / p_dev->input_rpt_count
+                          : 0;
+    dprintf(fd,
+            "  %s: reports %u, latency to uhid avg %llu us, max %u us\n",
+            p_dev->bd_addr.ToString().c_str(), p_dev->input_rpt_count,
+            (unsigned long long)avg_us, p_dev->input_rpt_lat_max_us);
+
+    dprintf(fd, "    latency histogram:");
+    uint32_t bound_us = BTIF_HH_LAT_HIST_BASE_US;
+    for (int b = 0; b < BTIF_HH_LAT_HIST_BUCKETS - 1; b++, bound_us <<= 1)
+      dprintf(fd, " <%uus:%u", bound_us, p_dev->input_rpt_lat_hist[b]);
+    dprintf(fd, " >=%uus:%u\n", bound_us >> 1,
+            p_dev->input_rpt_lat_hist[BTIF_HH_LAT_HIST_BUCKETS - 1]);
+  }
+}
+
 /*******************************************************************************
  *
  * Function         btif_btif_hh_setreport
@@ -18,6 +18,7 @@
 
 #include <btif_common.h>
 #include <btif_keystore.h>
+#include "btif_config.h"
 #include "btif_storage.h"
 
 #include <base/bind.h>
@@ -26,7 +27,13 @@
 #include <hardware/bluetooth.h>
 #include <base/callback.h>
 
+#include <openssl/crypto.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
 #include <map>
+#include <mutex>
+#include <vector>
 
 using base::Bind;
 using base::Unretained;
@@ -35,6 +42,124 @@ using bluetooth::bluetooth_keystore::BluetoothKeystoreInterface;
 
 namespace bluetooth {
 namespace bluetooth_keystore {
+
+namespace {
+
+// Decrypted keys are kept in pages locked in RAM and left out of core dumps.
+// Blocks are carved from those pages by size class and reused; a freed block
+// is wiped before it goes back to its free list.
+class LockedPool {
+ public:
+  static LockedPool& Get() {
+    static LockedPool* pool = new LockedPool();
+    return *pool;
+  }
+
+  void* Allocate(size_t size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int size_class = SizeClass(size);
+    if (size_class < 0) return MapLocked(RoundToPage(size));
+
+    std::vector<void*>& blocks = free_blocks_[size_class];
+    if (blocks.empty()) {
+      char* page = static_cast<char*>(MapLocked(page_size_));
+      const size_t block_size = kBlockSizes[size_class];
+      for (size_t off = 0; off + block_size <= page_size_; off += block_size)
+        blocks.push_back(page + off);
+    }
+    void* block = blocks.back();
+    blocks.pop_back();
+    return block;
+  }
+
+  void Free(void* block, size_t size) {
+    OPENSSL_cleanse(block, size);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    int size_class = SizeClass(size);
+    if (size_class < 0) {
+      munmap(block, RoundToPage(size));
+      return;
+    }
+    free_blocks_[size_class].push_back(block);
+  }
+
+ private:
+  static constexpr size_t kBlockSizes[] = {32, 64, 128, 256, 512};
+  static constexpr int kNumSizeClasses =
+      sizeof(kBlockSizes) / sizeof(kBlockSizes[0]);
+
+  LockedPool() : page_size_(sysconf(_SC_PAGESIZE)) {}
+
+  static int SizeClass(size_t size) {
+    for (int i = 0; i < kNumSizeClasses; i++)
+      if (size <= kBlockSizes[i]) return i;
+    return -1;
+  }
+
+  size_t RoundToPage(size_t size) const {
+    return (size + page_size_ - 1) & ~(page_size_ - 1);
+  }
+
+  void* MapLocked(size_t length) {
+    void* addr = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    CHECK(addr != MAP_FAILED) << __func__ << ": out of memory";
+    if (mlock(addr, length) != 0 && !mlock_warned_) {
+      // Beyond RLIMIT_MEMLOCK the keys stay usable, only swappable
+      LOG(WARNING) << __func__ << ": unable to lock key memory";
+      mlock_warned_ = true;
+    }
+#ifdef MADV_DONTDUMP
+    madvise(addr, length, MADV_DONTDUMP);
+#endif
+    return addr;
+  }
+
+  const size_t page_size_;
+  std::mutex mutex_;
+  std::vector<void*> free_blocks_[kNumSizeClasses];
+  bool mlock_warned_ = false;
+};
+
+constexpr size_t LockedPool::kBlockSizes[];
+
+template <typename T>
+struct LockedAllocator {
+  using value_type = T;
+
+  LockedAllocator() = default;
+  template <typename U>
+  LockedAllocator(const LockedAllocator<U>&) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(LockedPool::Get().Allocate(n * sizeof(T)));
+  }
+  void deallocate(T* p, size_t n) { LockedPool::Get().Free(p, n * sizeof(T)); }
+};
+
+template <typename T, typename U>
+bool operator==(const LockedAllocator<T>&, const LockedAllocator<U>&) {
+  return true;
+}
+template <typename T, typename U>
+bool operator!=(const LockedAllocator<T>&, const LockedAllocator<U>&) {
+  return false;
+}
+
+using LockedString =
+    std::basic_string<char, std::char_traits<char>, LockedAllocator<char>>;
+// The nodes hold the values, short ones inline, so they are locked as well
+using LockedKeyMap =
+    std::map<std::string, LockedString, std::less<std::string>,
+             LockedAllocator<std::pair<const std::string, LockedString>>>;
+
+LockedString ToLocked(const std::string& value) {
+  return LockedString(value.data(), value.size());
+}
+
+}  // namespace
+
 class BluetoothKeystoreInterfaceImpl;
 std::unique_ptr<BluetoothKeystoreInterface> bluetoothKeystoreInstance;
 
@@ -45,9 +170,12 @@ class BluetoothKeystoreInterfaceImpl
   void init(BluetoothKeystoreCallbacks* callbacks) override {
     VLOG(2) << __func__;
     this->callbacks = callbacks;
-    // Get bonded devices number to get all bonded devices key.
-    do_in_jni_thread(
-        FROM_HERE, base::Bind([]() { btif_storage_get_num_bonded_devices(); }));
+    // Decrypt all the stored keys in one go, then get bonded devices number to
+    // convert the keys of all bonded devices if needed.
+    do_in_jni_thread(FROM_HERE, base::Bind([]() {
+                       btif_config_prefetch_encrypted_keys();
+                       btif_storage_get_num_bonded_devices();
+                     }));
   }
   void ConvertEncryptOrDecryptKeyIfNeeded() {
   }
@@ -61,17 +189,38 @@ class BluetoothKeystoreInterfaceImpl
       return false;
     }
 
+    std::lock_guard<std::mutex> lock(key_map_lock);
     // Save the value into a map.
-    key_map[prefix] = decryptedString;
+    key_map[prefix] = ToLocked(decryptedString);
 
-    do_in_jni_thread(
-        base::Bind(&bluetooth::bluetooth_keystore::BluetoothKeystoreCallbacks::
-                       set_encrypt_key_or_remove_key,
-                   base::Unretained(callbacks), prefix, decryptedString));
+    // The keys of a bond come in a burst; they are handed to the keystore in
+    // one go, and a key changed again before that is only encrypted once.
+    pending_map[prefix] = ToLocked(decryptedString);
+    if (!pending_flush_scheduled) {
+      pending_flush_scheduled = true;
+      do_in_jni_thread(FROM_HERE,
+                       base::Bind(&BluetoothKeystoreInterfaceImpl::flush_pending,
+                                  base::Unretained(this)));
+    }
 
     return true;
   }
 
+  void flush_pending() {
+    LockedKeyMap batch;
+    {
+      std::lock_guard<std::mutex> lock(key_map_lock);
+      batch.swap(pending_map);
+      pending_flush_scheduled = false;
+    }
+
+    VLOG(2) << __func__ << " keys: " << batch.size();
+    if (!callbacks) return;
+    for (const auto& entry : batch)
+      callbacks->set_encrypt_key_or_remove_key(
+          entry.first, std::string(entry.second.data(), entry.second.size()));
+  }
+
   std::string get_key(std::string prefix) override {
     VLOG(2) << __func__ << " prefix: " << prefix;
 
@@ -80,31 +229,60 @@ class BluetoothKeystoreInterfaceImpl
       return "";
     }
 
-    std::string decryptedString;
+    std::lock_guard<std::mutex> lock(key_map_lock);
     // try to find the key.
-    std::map<std::string, std::string>::iterator iter = key_map.find(prefix);
+    LockedKeyMap::iterator iter = key_map.find(prefix);
     if (iter == key_map.end()) {
-      decryptedString = callbacks->get_key(prefix);
+      std::string decryptedString = callbacks->get_key(prefix);
       // Save the value into a map.
-      key_map[prefix] = decryptedString;
+      key_map[prefix] = ToLocked(decryptedString);
       VLOG(2) << __func__ << ": get key from bluetoothkeystore.";
-    } else {
-      decryptedString = iter->second;
+      return decryptedString;
+    }
+    return std::string(iter->second.data(), iter->second.size());
+  }
+
+  void prefetch_keys(const std::vector<std::string>& prefixes) override {
+    if (!callbacks) {
+      LOG(WARNING) << __func__ << " callback isn't ready";
+      return;
+    }
+
+    std::vector<std::string> missing;
+    {
+      std::lock_guard<std::mutex> lock(key_map_lock);
+      for (const auto& prefix : prefixes)
+        if (key_map.find(prefix) == key_map.end()) missing.push_back(prefix);
+    }
+    if (missing.empty()) return;
+
+    std::map<std::string, std::string> keys = callbacks->get_keys(missing);
+
+    std::lock_guard<std::mutex> lock(key_map_lock);
+    for (auto& entry : keys) {
+      // A key set in the meantime is newer than the stored one
+      key_map.emplace(entry.first, ToLocked(entry.second));
+      OPENSSL_cleanse(&entry.second[0], entry.second.size());
     }
-    return decryptedString;
+    VLOG(1) << __func__ << ": " << keys.size() << " keys";
   }
 
   void clear_map() override {
     VLOG(2) << __func__;
 
-    std::map<std::string, std::string> empty_map;
+    std::lock_guard<std::mutex> lock(key_map_lock);
+    LockedKeyMap empty_map;
     key_map.swap(empty_map);
     key_map.clear();
   }
 
  private:
   BluetoothKeystoreCallbacks* callbacks = nullptr;
-  std::map<std::string, std::string> key_map;
+  std::mutex key_map_lock;  // protects |key_map| and |pending_map|
+  LockedKeyMap key_map;
+  // Updates not yet passed to the keystore, sent by flush_pending()
+  LockedKeyMap pending_map;
+  bool pending_flush_scheduled = false;
 };
 
 BluetoothKeystoreInterface* getBluetoothKeystoreInterface() {
@@ -41,10 +41,10 @@
 #include <stdio.h>
 #include <string.h>
 #include <sys/ioctl.h>
-#include <sys/poll.h>
 #include <sys/prctl.h>
 #include <sys/select.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -86,8 +86,6 @@
                        __func__, #s, __LINE__)                           \
   } while (0)
 
-#define MIN(x, y) (((x) < (y)) ? (x) : (y))
-
 btpan_cb_t btpan_cb;
 
 static bool jni_initialized;
@@ -157,6 +155,7 @@ void btif_pan_cleanup() {
   // Bluetooth is shuting down, invalidate all BTA PAN handles
   for (int i = 0; i < MAX_PAN_CONNS; i++)
     btpan_cleanup_conn(&btpan_cb.conns[i]);
+  osi_free_and_reset((void**)&btpan_cb.congest_buf);
 
   pan_disable();
   stack_initialized = false;
@@ -428,18 +427,22 @@ int btpan_tap_send(int tap_fd, const RawAddress& src, const RawAddress& dst,
     eth_hdr.h_dest = dst;
     eth_hdr.h_src = src;
     eth_hdr.h_proto = htons(proto);
-    char packet[TAP_MAX_PKT_WRITE_LEN + sizeof(tETH_HDR)];
-    memcpy(packet, &eth_hdr, sizeof(tETH_HDR));
     if (len > TAP_MAX_PKT_WRITE_LEN) {
       LOG_ERROR(LOG_TAG, "btpan_tap_send eth packet size:%d is exceeded limit!",
                 len);
       return -1;
     }
-    memcpy(packet + sizeof(tETH_HDR), buf, len);
 
-    /* Send data to network interface */
+    /* Send data to network interface, gathering the header and the payload
+     * straight from the BNEP buffer instead of copying them together */
+    struct iovec iov[2];
+    iov[0].iov_base = &eth_hdr;
+    iov[0].iov_len = sizeof(tETH_HDR);
+    iov[1].iov_base = (void*)buf;
+    iov[1].iov_len = len;
+
     ssize_t ret;
-    OSI_NO_INTR(ret = write(tap_fd, packet, len + sizeof(tETH_HDR)));
+    OSI_NO_INTR(ret = writev(tap_fd, iov, 2));
     BTIF_TRACE_DEBUG("ret:%d", ret);
     return (int)ret;
   }
@@ -511,6 +514,7 @@ static void btpan_close_conn(btpan_conn_t* conn) {
         btpan_tap_close(btpan_cb.tap_fd);
         btpan_cb.tap_fd = INVALID_FD;
       }
+      osi_free_and_reset((void**)&btpan_cb.congest_buf);
     }
   }
 }
@@ -561,25 +565,42 @@ static inline bool should_forward(tETH_HDR* hdr) {
   return false;
 }
 
-static int forward_bnep(tETH_HDR* eth_hdr, BT_HDR* hdr) {
+// Find the right connection to send this frame over.
+static btpan_conn_t* find_bnep_conn(tETH_HDR* eth_hdr) {
   int broadcast = eth_hdr->h_dest.address[0] & 1;
 
-  // Find the right connection to send this frame over.
   for (int i = 0; i < MAX_PAN_CONNS; i++) {
     uint16_t handle = btpan_cb.conns[i].handle;
     if (handle != (uint16_t)-1 &&
         (broadcast || btpan_cb.conns[i].eth_addr == eth_hdr->h_dest ||
-         btpan_cb.conns[i].peer == eth_hdr->h_dest)) {
-      int result = PAN_WriteBuf(handle, eth_hdr->h_dest, eth_hdr->h_src,
-                                ntohs(eth_hdr->h_proto), hdr, 0);
-      switch (result) {
-        case PAN_Q_SIZE_EXCEEDED:
-          return FORWARD_CONGEST;
-        case PAN_SUCCESS:
-          return FORWARD_SUCCESS;
-        default:
-          return FORWARD_FAILURE;
-      }
+         btpan_cb.conns[i].peer == eth_hdr->h_dest))
+      return &btpan_cb.conns[i];
+  }
+  return NULL;
+}
+
+// Broadcasts are copied to every link by PAN, so only unicast frames can be
+// dropped for lack of room in the BNEP queue.
+static bool forward_bnep_congested(tETH_HDR* eth_hdr) {
+  if (eth_hdr->h_dest.address[0] & 1) return false;
+
+  btpan_conn_t* conn = find_bnep_conn(eth_hdr);
+  return conn != NULL && PAN_IsTxQueueFull(conn->handle);
+}
+
+static int forward_bnep(tETH_HDR* eth_hdr, BT_HDR* hdr) {
+  btpan_conn_t* conn = find_bnep_conn(eth_hdr);
+
+  if (conn != NULL) {
+    int result = PAN_WriteBuf(conn->handle, eth_hdr->h_dest, eth_hdr->h_src,
+                              ntohs(eth_hdr->h_proto), hdr, 0);
+    switch (result) {
+      case PAN_Q_SIZE_EXCEEDED:
+        return FORWARD_CONGEST;
+      case PAN_SUCCESS:
+        return FORWARD_SUCCESS;
+      default:
+        return FORWARD_FAILURE;
     }
   }
   osi_free(hdr);
@@ -680,9 +701,7 @@ static void bta_pan_callback(tBTA_PAN_EVT event, tBTA_PAN* p_data) {
                         sizeof(tBTA_PAN), NULL);
 }
 
-#define IS_EXCEPTION(e) ((e) & (POLLHUP | POLLRDHUP | POLLERR | POLLNVAL))
 static void btu_exec_tap_fd_read(void* p_param) {
-  struct pollfd ufd;
   int fd = PTR_TO_INT(p_param);
 
   if (fd == INVALID_FD || fd != btpan_cb.tap_fd) return;
@@ -691,21 +710,27 @@ static void btu_exec_tap_fd_read(void* p_param) {
   // give other profiles a chance to run by limiting the amount of memory
   // PAN can use.
   for (int i = 0; i < PAN_BUF_MAX && btif_is_enabled() && btpan_cb.flow; i++) {
-    BT_HDR* buffer = (BT_HDR*)osi_malloc(PAN_BUF_SIZE);
-    buffer->offset = PAN_MINIMUM_OFFSET;
-    buffer->len = PAN_BUF_SIZE - sizeof(BT_HDR) - buffer->offset;
-
-    uint8_t* packet = (uint8_t*)buffer + sizeof(BT_HDR) + buffer->offset;
-
-    // If we don't have an undelivered packet left over, pull one from the TAP
-    // driver.
-    // We save it in the congest_packet right away in case we can't deliver it
-    // in this
-    // attempt.
-    if (!btpan_cb.congest_packet_size) {
+    // If we don't have an undelivered frame left over, pull one from the TAP
+    // driver. The Ethernet header is read apart and the payload lands right
+    // in the buffer given to BNEP, past the room for the BNEP and L2CAP
+    // headers, so the frame is not copied again on its way to the link.
+    if (!btpan_cb.congest_buf) {
+      BT_HDR* buffer = (BT_HDR*)osi_malloc(PAN_BUF_SIZE);
+      buffer->offset = PAN_MINIMUM_OFFSET;
+
+      struct iovec iov[2];
+      iov[0].iov_base = &btpan_cb.congest_hdr;
+      iov[0].iov_len = sizeof(tETH_HDR);
+      iov[1].iov_base = (uint8_t*)(buffer + 1) + buffer->offset;
+      iov[1].iov_len = PAN_BUF_SIZE - sizeof(BT_HDR) - buffer->offset;
+
       ssize_t ret;
-      OSI_NO_INTR(ret = read(fd, btpan_cb.congest_packet,
-                             sizeof(btpan_cb.congest_packet)));
+      OSI_NO_INTR(ret = readv(fd, iov, 2));
+      if (ret == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        // The TAP fd is non-blocking: the driver queue is drained.
+        osi_free(buffer);
+        break;
+      }
       switch (ret) {
         case -1:
           BTIF_TRACE_ERROR("%s unable to read from driver: %s", __func__,
@@ -721,43 +746,26 @@ static void btu_exec_tap_fd_read(void* p_param) {
           btsock_thread_add_fd(pan_pth, fd, 0, SOCK_THREAD_FD_RD, 0);
           return;
         default:
-          btpan_cb.congest_packet_size = ret;
           break;
       }
-    }
 
-    memcpy(packet, btpan_cb.congest_packet,
-           MIN(btpan_cb.congest_packet_size, buffer->len));
-    buffer->len = MIN(btpan_cb.congest_packet_size, buffer->len);
-
-    if (buffer->len > sizeof(tETH_HDR) && should_forward((tETH_HDR*)packet)) {
-      // Extract the ethernet header from the buffer since the PAN_WriteBuf
-      // inside
-      // forward_bnep can't handle two pointers that point inside the same GKI
-      // buffer.
-      tETH_HDR hdr;
-      memcpy(&hdr, packet, sizeof(tETH_HDR));
-
-      // Skip the ethernet header.
-      buffer->len -= sizeof(tETH_HDR);
-      buffer->offset += sizeof(tETH_HDR);
-      if (forward_bnep(&hdr, buffer) != FORWARD_CONGEST)
-        btpan_cb.congest_packet_size = 0;
-    } else {
-      BTIF_TRACE_WARNING("%s dropping packet of length %d", __func__,
-                         buffer->len);
-      btpan_cb.congest_packet_size = 0;
-      osi_free(buffer);
+      if (ret <= (ssize_t)sizeof(tETH_HDR) ||
+          !should_forward(&btpan_cb.congest_hdr)) {
+        BTIF_TRACE_WARNING("%s dropping packet of length %d", __func__,
+                           (int)ret);
+        osi_free(buffer);
+        continue;
+      }
+      buffer->len = ret - sizeof(tETH_HDR);
+      btpan_cb.congest_buf = buffer;
     }
 
-    // Bail out of the loop if reading from the TAP fd would block.
-    ufd.fd = fd;
-    ufd.events = POLLIN;
-    ufd.revents = 0;
+    // BNEP drops what it has no room for, so keep the frame until it has.
+    if (forward_bnep_congested(&btpan_cb.congest_hdr)) break;
 
-    int ret;
-    OSI_NO_INTR(ret = poll(&ufd, 1, 0));
-    if (ret <= 0 || IS_EXCEPTION(ufd.revents)) break;
+    BT_HDR* buffer = btpan_cb.congest_buf;
+    btpan_cb.congest_buf = NULL;
+    forward_bnep(&btpan_cb.congest_hdr, buffer);
   }
 
   if (btpan_cb.flow) {
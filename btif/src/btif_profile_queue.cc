@@ -21,6 +21,9 @@
  *  Filename:      btif_profile_queue.c
  *
  *  Description:   Bluetooth remote device connection queuing implementation.
+ *                 Profile connection requests of a remote device are
+ *                 serialized, those of different remote devices run
+ *                 concurrently as long as the profile can take them.
  *
  ******************************************************************************/
 
@@ -29,6 +32,7 @@
 #include "btif_profile_queue.h"
 
 #include <base/logging.h>
+#include <stdio.h>
 #include <string.h>
 #include <list>
 #include <map>
@@ -41,6 +45,7 @@
 #include "osi/include/list.h"
 #include "stack_manager.h"
 #include "osi/include/thread.h"
+#include "osi/include/time.h"
 #include "osi/include/alarm.h"
 /*******************************************************************************
  *  Local type definitions
@@ -61,8 +66,20 @@ typedef struct {
   uint16_t max_connections;
   bool busy;
   btif_connect_cb_t connect_cb;
+  uint32_t queued_ms;
+  uint32_t started_ms;
 } connect_node_t;
 
+/* A finished connection request, kept for the per device timelines */
+typedef struct {
+  RawAddress bda;
+  uint16_t uuid;
+  uint32_t queued_ms;
+  uint32_t started_ms; /* 0 if the request was dropped before it ran */
+  uint32_t done_ms;
+} connect_timeline_t;
+
+#define CONNECT_TIMELINE_SIZE 32
 
 /*******************************************************************************
  *  Static variables
@@ -72,6 +89,10 @@ static list_t* connect_queue;
 
 static const size_t MAX_REASONABLE_REQUESTS = 20;
 
+static connect_timeline_t connect_timeline[CONNECT_TIMELINE_SIZE];
+static size_t connect_timeline_count;
+static std::mutex connect_timeline_mutex;
+
 extern thread_t *bt_jni_workqueue_thread;
 /*******************************************************************************
  *  Queue helper functions
@@ -113,57 +134,101 @@ static void queue_int_add(connect_node_t* p_param) {
   }
   connect_node_t* p_node = (connect_node_t*)osi_malloc(sizeof(connect_node_t));
   memcpy(p_node, p_param, sizeof(connect_node_t));
+  p_node->busy = false;
+  p_node->queued_ms = time_get_os_boottime_ms();
+  p_node->started_ms = 0;
   list_append(connect_queue, p_node);
 }
 
-static void queue_int_advance() {
-  if (connect_queue && !list_is_empty(connect_queue)) {
-    connect_node_t* p_head = (connect_node_t*)list_front(connect_queue);
-    LOG_INFO(LOG_TAG,
-             "%s: removing connection request UUID=%04X, bd_addr=%s, busy=%d",
-             __func__, p_head->uuid, p_head->bda.ToString().c_str(),
-             p_head->busy);
-    list_remove(connect_queue, p_head);
+// Records the request in the timeline of its device and frees it.
+static void queue_int_remove(connect_node_t* p_node) {
+  {
+    std::unique_lock<std::mutex> lock(connect_timeline_mutex);
+    connect_timeline_t* entry =
+        &connect_timeline[connect_timeline_count % CONNECT_TIMELINE_SIZE];
+    entry->bda = p_node->bda;
+    entry->uuid = p_node->uuid;
+    entry->queued_ms = p_node->queued_ms;
+    entry->started_ms = p_node->started_ms;
+    entry->done_ms = time_get_os_boottime_ms();
+    connect_timeline_count++;
   }
+  list_remove(connect_queue, p_node);
 }
 
-static void queue_int_advance_by_uuid(connect_node_t* p_param) {
+// Returns true if |p_node| can be dispatched now: every earlier request of
+// the same device is done, and the profile has room for one more connection
+// in progress. Profiles registered for a single connection take them one at a
+// time.
+static bool queue_int_can_start(const connect_node_t* p_node) {
+  bool earlier = true;
+  uint16_t busy_same_uuid = 0;
 
-  if (!connect_queue || list_is_empty(connect_queue)) return;
+  for (const list_node_t* node = list_begin(connect_queue);
+       node != list_end(connect_queue); node = list_next(node)) {
+    const connect_node_t* p_other = (const connect_node_t*)list_node(node);
+    if (p_other == p_node) {
+      earlier = false;
+      continue;
+    }
+    if (earlier && p_other->bda == p_node->bda) return false;
+    if (p_other->busy && p_other->uuid == p_node->uuid) busy_same_uuid++;
+  }
 
-  list_node_t* node = list_begin(connect_queue);
-  connect_node_t* p_head = (connect_node_t*)list_node(node);
+  uint16_t max_conn = p_node->max_connections ? p_node->max_connections : 1;
+  return busy_same_uuid < max_conn;
+}
 
-  if (p_head == NULL)
-    return;
+static void queue_int_advance() {
+  if (!connect_queue || list_is_empty(connect_queue)) return;
 
-  if (((p_head->bda == p_param->bda) || (p_param->bda.IsEmpty()))
-       && (p_head->uuid == p_param->uuid)) {
-    LOG_WARN(LOG_TAG,"%s: queue advance UUID=%04X, bd_addr=%s",
-        __func__, p_head->uuid, p_head->bda.ToString().c_str());
-    btif_queue_advance();
-    return;
+  // Without a device to go by, finish the oldest request in progress.
+  connect_node_t* p_head = (connect_node_t*)list_front(connect_queue);
+  for (const list_node_t* node = list_begin(connect_queue);
+       node != list_end(connect_queue); node = list_next(node)) {
+    connect_node_t* p_node = (connect_node_t*)list_node(node);
+    if (p_node->busy) {
+      p_head = p_node;
+      break;
+    }
   }
 
-  // move the node to next
-  node = list_next(node);
+  LOG_INFO(LOG_TAG,
+           "%s: removing connection request UUID=%04X, bd_addr=%s, busy=%d",
+           __func__, p_head->uuid, p_head->bda.ToString().c_str(),
+           p_head->busy);
+  queue_int_remove(p_head);
+}
 
-  for (; node != list_end(connect_queue);) {
-    p_head = (connect_node_t*)list_node(node);
-    node = list_next(node);
+static void queue_int_advance_by_uuid(connect_node_t* p_param) {
+  if (!connect_queue || list_is_empty(connect_queue)) return;
 
-    if (((p_head->bda == p_param->bda) || (p_param->bda.IsEmpty()))
-        && (p_head->uuid == p_param->uuid)) {
-      LOG_WARN(LOG_TAG,"%s: deleting entry from queue UUID=%04X, bd_addr=%s",
-               __func__, p_head->uuid, p_head->bda.ToString().c_str());
-      list_remove(connect_queue,p_head);
-      return;
+  // Prefer the request in progress, else drop the first pending one.
+  connect_node_t* p_match = NULL;
+  for (const list_node_t* node = list_begin(connect_queue);
+       node != list_end(connect_queue); node = list_next(node)) {
+    connect_node_t* p_node = (connect_node_t*)list_node(node);
+
+    if (((p_node->bda == p_param->bda) || (p_param->bda.IsEmpty())) &&
+        (p_node->uuid == p_param->uuid)) {
+      if (!p_match) p_match = p_node;
+      if (p_node->busy) {
+        p_match = p_node;
+        break;
+      }
     }
   }
 
-  LOG_WARN(LOG_TAG,"%s: no entry found in queue UUID=%04X, bd_addr=%s",
-         __func__, p_param->uuid, p_param->bda.ToString().c_str());
-  return;
+  if (!p_match) {
+    LOG_WARN(LOG_TAG, "%s: no entry found in queue UUID=%04X, bd_addr=%s",
+             __func__, p_param->uuid, p_param->bda.ToString().c_str());
+    return;
+  }
+
+  LOG_WARN(LOG_TAG, "%s: %s entry from queue UUID=%04X, bd_addr=%s", __func__,
+           p_match->busy ? "advancing" : "deleting", p_match->uuid,
+           p_match->bda.ToString().c_str());
+  queue_int_remove(p_match);
 }
 
 static void queue_int_cleanup(uint16_t* p_uuid) {
@@ -187,7 +252,7 @@ static void queue_int_cleanup(uint16_t* p_uuid) {
                __func__, connection_request->uuid,
                connection_request->bda.ToString().c_str(),
                connection_request->busy);
-      list_remove(connect_queue, connection_request);
+      queue_int_remove(connection_request);
     }
   }
 }
@@ -298,23 +363,81 @@ void btif_queue_advance_by_uuid(uint16_t uuid, const RawAddress* bda) {
                                (char*)node, sizeof(connect_node_t), NULL);
 }
 
-// This function dispatches the next pending connect request. It is called from
-// stack_manager when the stack comes up.
+static connect_node_t* queue_int_next_startable() {
+  for (const list_node_t* node = list_begin(connect_queue);
+       node != list_end(connect_queue); node = list_next(node)) {
+    connect_node_t* p_node = (connect_node_t*)list_node(node);
+    if (!p_node->busy && queue_int_can_start(p_node)) return p_node;
+  }
+  return NULL;
+}
+
+// This function dispatches every pending connect request that can run now. It
+// is called from stack_manager when the stack comes up.
 bt_status_t btif_queue_connect_next(void) {
   if (!connect_queue || list_is_empty(connect_queue)) return BT_STATUS_FAIL;
 
-  connect_node_t* p_head = (connect_node_t*)list_front(connect_queue);
+  // If nothing can start, we return success anyway, since the connections
+  // have been queued...
+  bt_status_t status = BT_STATUS_SUCCESS;
+  connect_node_t* p_node;
+  while ((p_node = queue_int_next_startable()) != NULL) {
+    LOG_INFO(LOG_TAG,
+             "%s: executing connection request UUID=%04X, bd_addr=%s, "
+             "queued for %u ms",
+             __func__, p_node->uuid, p_node->bda.ToString().c_str(),
+             time_get_os_boottime_ms() - p_node->queued_ms);
+    p_node->busy = true;
+    p_node->started_ms = time_get_os_boottime_ms();
+    status = p_node->connect_cb(&p_node->bda, p_node->uuid);
+  }
+  return status;
+}
 
-  LOG_INFO(LOG_TAG,
-           "%s: executing connection request UUID=%04X, bd_addr=%s, busy=%d",
-           __func__, p_head->uuid, p_head->bda.ToString().c_str(),
-           p_head->busy);
-  // If the queue is currently busy, we return success anyway,
-  // since the connection has been queued...
-  if (p_head->busy) return BT_STATUS_SUCCESS;
+/*******************************************************************************
+ *
+ * Function         btif_queue_debug_dump
+ *
+ * Description      Dump the timeline of the recent connection requests of each
+ *                  remote device
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btif_queue_debug_dump(int fd) {
+  std::unique_lock<std::mutex> lock(connect_timeline_mutex);
+
+  size_t count = connect_timeline_count < CONNECT_TIMELINE_SIZE
+                     ? connect_timeline_count
+                     : CONNECT_TIMELINE_SIZE;
+  size_t first = connect_timeline_count - count;
+  std::map<RawAddress, std::list<const connect_timeline_t*>> per_device;
+  for (size_t i = first; i < connect_timeline_count; i++) {
+    const connect_timeline_t* entry =
+        &connect_timeline[i % CONNECT_TIMELINE_SIZE];
+    per_device[entry->bda].push_back(entry);
+  }
 
-  p_head->busy = true;
-  return p_head->connect_cb(&p_head->bda, p_head->uuid);
+  dprintf(fd, "\nProfile connection timelines:\n");
+  for (const auto& device : per_device) {
+    dprintf(fd, "  %s\n", device.first.ToString().c_str());
+    uint32_t base_ms = device.second.front()->queued_ms;
+    for (const connect_timeline_t* entry : device.second) {
+      if ((int32_t)(entry->queued_ms - base_ms) < 0) base_ms = entry->queued_ms;
+    }
+    for (const connect_timeline_t* entry : device.second) {
+      if (!entry->started_ms) {
+        dprintf(fd, "    uuid:%04x queued:+%u ms dropped after %u ms\n",
+                entry->uuid, entry->queued_ms - base_ms,
+                entry->done_ms - entry->queued_ms);
+        continue;
+      }
+      dprintf(fd, "    uuid:%04x queued:+%u ms waited:%u ms connect:%u ms\n",
+              entry->uuid, entry->queued_ms - base_ms,
+              entry->started_ms - entry->queued_ms,
+              entry->done_ms - entry->started_ms);
+    }
+  }
 }
 
 /*******************************************************************************
@@ -257,6 +257,35 @@ typedef struct {
   btrc_player_app_ext_attr_t ext_attrs[AVRC_MAX_APP_ATTR_SIZE];
 } btif_rc_player_app_settings_t;
 
+/* Number of built responses kept per peer */
+#define BTIF_RC_RSP_CACHE_SIZE 8
+/* scope, start item, end item, number of attributes and attribute IDs */
+#define BTIF_RC_RSP_CACHE_KEY_LEN (1 + 4 + 4 + 1 + 4 * BTRC_MAX_ELEM_ATTR_SIZE)
+#define BTIF_RC_RSP_CACHE_ELEM_ATTR 0
+#define BTIF_RC_RSP_CACHE_FOLDER_ITEMS 1
+
+typedef struct {
+  uint8_t pdu;
+  uint8_t ctype;
+  uint8_t len;
+  uint8_t data[BTIF_RC_RSP_CACHE_KEY_LEN];
+} btif_rc_rsp_key_t;
+
+typedef struct {
+  btif_rc_rsp_key_t key;
+  BT_HDR* p_rsp; /* built response, NULL if the entry is free */
+} btif_rc_rsp_entry_t;
+
+/* Responses of the media app to GetElementAttributes and GetFolderItems of
+ * one peer. They are only kept while the peer is registered for the event
+ * that would report their change, and are dropped on any such event. */
+typedef struct {
+  btif_rc_rsp_entry_t entry[BTIF_RC_RSP_CACHE_SIZE];
+  uint8_t next; /* entry to replace next */
+  btif_rc_rsp_key_t pending[2];
+  bool pending_valid[2];
+} btif_rc_rsp_cache_t;
+
 /* TODO : Merge btif_rc_reg_notifications_t and btif_rc_cmd_ctxt_t to a single
  * struct */
 typedef struct {
@@ -289,6 +318,13 @@ typedef struct {
   uint8_t tws_earbud_state;
 #endif
   bool rc_element_attr_app_req;  /* flag to track get_element_attr req */
+  btif_rc_rsp_cache_t rc_rsp_cache;
+  uint8_t rc_abs_vol_label;   /* SetAbsoluteVolume in flight, MAX_LABEL if none */
+  uint8_t rc_abs_vol_pending; /* volume held back behind it, MAX_VOLUME if none */
+  alarm_t* rc_abs_vol_timer;
+  /* last play status and position notified, see btif_rc_notif_is_noop */
+  uint32_t rc_notif_last_val[MAX_RC_NOTIFICATIONS];
+  bool rc_notif_last_valid[MAX_RC_NOTIFICATIONS];
 
 } btif_rc_device_cb_t;
 
@@ -368,6 +404,10 @@ static void send_metamsg_rsp(btif_rc_device_cb_t* p_dev, int index,
                              uint8_t label, tBTA_AV_CODE code,
                              tAVRC_RESPONSE* pmetamsg_resp);
 static void register_volumechange(uint8_t label, btif_rc_device_cb_t* p_dev);
+static void btif_rc_rsp_cache_flush(btif_rc_device_cb_t* p_dev);
+static void btif_rc_abs_vol_reset(btif_rc_device_cb_t* p_dev);
+static void btif_rc_abs_vol_done(btif_rc_device_cb_t* p_dev, uint8_t label);
+static void btif_rc_rsp_cache_flush_all(void);
 static void lbl_init();
 static void init_all_transactions(int index);
 static void btif_rc_init_txn_label_queue(btif_rc_device_cb_t *p_dev);
@@ -452,6 +492,8 @@ static bt_status_t set_volume(uint8_t volume, RawAddress*bd_addr);
  *  Static variables
  *****************************************************************************/
 static rc_cb_t btif_rc_cb;
+static std::mutex btif_rc_rsp_cache_lock;
+static std::mutex btif_rc_abs_vol_lock;
 static btif_rc_index_t device;
 static btrc_callbacks_t* bt_rc_callbacks = NULL;
 static btrc_ctrl_callbacks_t* bt_rc_ctrl_callbacks = NULL;
@@ -922,6 +964,9 @@ void handle_rc_connect(tBTA_AV_RC_OPEN* p_rc_open) {
 #if (TWS_ENABLED == TRUE)
   p_dev->rc_initial_volume = MAX_VOLUME;
 #endif
+  p_dev->rc_abs_vol_label = MAX_LABEL;
+  p_dev->rc_abs_vol_pending = MAX_VOLUME;
+  memset(p_dev->rc_notif_last_valid, 0, sizeof(p_dev->rc_notif_last_valid));
   p_dev->rc_only_peer_device = is_peer_avrcp_only_device(p_dev->rc_addr);
   p_dev->rc_connected = true;
   p_dev->rc_handle = p_rc_open->rc_handle;
@@ -993,6 +1038,8 @@ void handle_rc_disconnect(tBTA_AV_RC_CLOSE* p_rc_close) {
   }
   BTIF_TRACE_DEBUG("%s: Closing handle", __func__);
   init_all_transactions(idx);
+  btif_rc_rsp_cache_flush(p_dev);
+  btif_rc_abs_vol_reset(p_dev);
   /* check if there is another device connected */
   if (p_dev->rc_state == BTRC_CONNECTION_STATE_CONNECTED) {
     p_dev->rc_handle = BTIF_RC_HANDLE_NONE;
@@ -1497,6 +1544,9 @@ void btif_rc_handler(tBTA_AV_EVT event, tBTA_AV* p_data) {
       }
 
       if (btif_rc_cb.rc_multi_cb != NULL) {
+        btif_rc_rsp_cache_flush_all();
+        for (int idx = 0; idx < btif_max_rc_clients; idx++)
+          btif_rc_abs_vol_reset(&btif_rc_cb.rc_multi_cb[idx]);
         osi_free(btif_rc_cb.rc_multi_cb);
         btif_rc_cb.rc_multi_cb = NULL;
       }
@@ -1793,6 +1843,159 @@ static void btif_rc_init_txn_label_queue(btif_rc_device_cb_t *p_dev)
     }
 }
 
+/***************************************************************************
+ *  Function       btif_rc_rsp_cache_slot
+ *
+ *  - Argument:    rsp_index       Command index
+ *
+ *  - Description: Returns the pending slot of a cached command, -1 if the
+ *                 responses of the command are not cached.
+ *
+ ***************************************************************************/
+static int btif_rc_rsp_cache_slot(int rsp_index) {
+  if (rsp_index == IDX_GET_ELEMENT_ATTR_RSP) return BTIF_RC_RSP_CACHE_ELEM_ATTR;
+  if (rsp_index == IDX_GET_FOLDER_ITEMS_RSP)
+    return BTIF_RC_RSP_CACHE_FOLDER_ITEMS;
+  return -1;
+}
+
+/***************************************************************************
+ *  Function       btif_rc_rsp_cache_flush
+ *
+ *  - Argument:    p_dev           Dev pointer
+ *
+ *  - Description: Drops the cached responses of a peer.
+ *
+ ***************************************************************************/
+static void btif_rc_rsp_cache_flush(btif_rc_device_cb_t* p_dev) {
+  std::unique_lock<std::mutex> lock(btif_rc_rsp_cache_lock);
+  btif_rc_rsp_cache_t* p_cache = &p_dev->rc_rsp_cache;
+
+  for (int i = 0; i < BTIF_RC_RSP_CACHE_SIZE; i++)
+    osi_free_and_reset((void**)&p_cache->entry[i].p_rsp);
+  p_cache->pending_valid[BTIF_RC_RSP_CACHE_ELEM_ATTR] = false;
+  p_cache->pending_valid[BTIF_RC_RSP_CACHE_FOLDER_ITEMS] = false;
+}
+
+/***************************************************************************
+ *  Function       btif_rc_rsp_cache_flush_all
+ *
+ *  - Description: Drops the cached responses of all peers, the media app
+ *                 reported a change of track, player or content.
+ *
+ ***************************************************************************/
+static void btif_rc_rsp_cache_flush_all(void) {
+  if (btif_rc_cb.rc_multi_cb == NULL) return;
+
+  for (int idx = 0; idx < btif_max_rc_clients; idx++)
+    btif_rc_rsp_cache_flush(&btif_rc_cb.rc_multi_cb[idx]);
+}
+
+/***************************************************************************
+ *  Function       btif_rc_rsp_cache_send
+ *
+ *  - Argument:    p_dev           Dev pointer
+ *                 rsp_index       Command index
+ *                 p_key           Parameters of the command
+ *                 event_id        Event reporting a change of the response
+ *                 label           Label of the command
+ *
+ *  - Description: Answers a command from the cache. On a miss, the response
+ *                 of the media app is cached if the peer is registered for
+ *                 |event_id| and no other command of this kind is pending.
+ *
+ *  - Returns:     true if the command was answered
+ *
+ ***************************************************************************/
+static bool btif_rc_rsp_cache_send(btif_rc_device_cb_t* p_dev, int rsp_index,
+                                   const btif_rc_rsp_key_t* p_key,
+                                   uint8_t event_id, uint8_t label) {
+  std::unique_lock<std::mutex> lock(btif_rc_rsp_cache_lock);
+  btif_rc_rsp_cache_t* p_cache = &p_dev->rc_rsp_cache;
+  int slot = btif_rc_rsp_cache_slot(rsp_index);
+
+  if (slot < 0 || !p_dev->rc_notif[event_id - 1].bNotify) return false;
+
+  for (int i = 0; i < BTIF_RC_RSP_CACHE_SIZE; i++) {
+    const btif_rc_rsp_entry_t* p_entry = &p_cache->entry[i];
+    if (p_entry->p_rsp == NULL || p_entry->key.pdu != p_key->pdu ||
+        p_entry->key.ctype != p_key->ctype || p_entry->key.len != p_key->len ||
+        memcmp(p_entry->key.data, p_key->data, p_key->len) != 0)
+      continue;
+
+    uint16_t size = sizeof(BT_HDR) + p_entry->p_rsp->offset +
+                    p_entry->p_rsp->len;
+    BT_HDR* p_msg = (BT_HDR*)osi_malloc(size);
+    memcpy(p_msg, p_entry->p_rsp, size);
+    lock.unlock();
+
+    BTIF_TRACE_DEBUG("%s: %s answered from cache, label: %d", __func__,
+                     dump_rc_pdu(p_key->pdu), label);
+    BTA_AvMetaRsp(p_dev->rc_handle, label,
+                  get_rsp_type_code(AVRC_STS_NO_ERROR, p_key->ctype), p_msg);
+    return true;
+  }
+
+  p_cache->pending_valid[slot] = (p_dev->rc_pdu_info[rsp_index].size == 0);
+  if (p_cache->pending_valid[slot]) p_cache->pending[slot] = *p_key;
+  return false;
+}
+
+/***************************************************************************
+ *  Function       btif_rc_rsp_cache_store
+ *
+ *  - Argument:    p_dev           Dev pointer
+ *                 rsp_index       Command index
+ *                 p_msg           Built response of the media app
+ *
+ *  - Description: Keeps a copy of the response to the pending command.
+ *
+ ***************************************************************************/
+static void btif_rc_rsp_cache_store(btif_rc_device_cb_t* p_dev, int rsp_index,
+                                    const BT_HDR* p_msg) {
+  std::unique_lock<std::mutex> lock(btif_rc_rsp_cache_lock);
+  btif_rc_rsp_cache_t* p_cache = &p_dev->rc_rsp_cache;
+  int slot = btif_rc_rsp_cache_slot(rsp_index);
+
+  if (slot < 0 || !p_cache->pending_valid[slot]) return;
+  p_cache->pending_valid[slot] = false;
+
+  btif_rc_rsp_entry_t* p_entry = &p_cache->entry[p_cache->next];
+  p_cache->next = (p_cache->next + 1) % BTIF_RC_RSP_CACHE_SIZE;
+
+  uint16_t size = sizeof(BT_HDR) + p_msg->offset + p_msg->len;
+  osi_free(p_entry->p_rsp);
+  p_entry->p_rsp = (BT_HDR*)osi_malloc(size);
+  memcpy(p_entry->p_rsp, p_msg, size);
+  p_entry->key = p_cache->pending[slot];
+}
+
+/***************************************************************************
+ *  Function       btif_rc_rsp_key_init
+ *
+ *  - Description: Starts the cache key of a command.
+ *
+ ***************************************************************************/
+static void btif_rc_rsp_key_init(btif_rc_rsp_key_t* p_key, uint8_t pdu,
+                                 uint8_t ctype) {
+  p_key->pdu = pdu;
+  p_key->ctype = ctype;
+  p_key->len = 0;
+}
+
+/***************************************************************************
+ *  Function       btif_rc_rsp_key_add
+ *
+ *  - Description: Appends a command parameter to a cache key.
+ *
+ ***************************************************************************/
+static void btif_rc_rsp_key_add(btif_rc_rsp_key_t* p_key, const void* p_data,
+                                uint8_t len) {
+  if (p_key->len + len > BTIF_RC_RSP_CACHE_KEY_LEN) return;
+  memcpy(&p_key->data[p_key->len], p_data, len);
+  p_key->len += len;
+}
+
 /***************************************************************************
  *  Function       send_metamsg_rsp
  *
@@ -1881,6 +2084,8 @@ static void send_metamsg_rsp(btif_rc_device_cb_t* p_dev, int index,
     status = AVRC_BldResponse(p_dev->rc_handle, pmetamsg_resp, &p_msg);
 
     if (status == AVRC_STS_NO_ERROR) {
+      if (pmetamsg_resp->rsp.status == AVRC_STS_NO_ERROR)
+        btif_rc_rsp_cache_store(p_dev, index, p_msg);
       BTA_AvMetaRsp(p_dev->rc_handle, label, ctype, p_msg);
     } else {
       BTIF_TRACE_ERROR("%s: failed to build metamsg response. status: 0x%02x",
@@ -2181,6 +2386,14 @@ static void btif_rc_upstreams_evt(uint16_t event, tAVRC_COMMAND* pavrc_cmd,
                              AVRC_STS_BAD_PARAM, pavrc_cmd->cmd.opcode);
         return;
       }
+      btif_rc_rsp_key_t key;
+      btif_rc_rsp_key_init(&key, pavrc_cmd->pdu, ctype);
+      btif_rc_rsp_key_add(&key, &num_attr, sizeof(num_attr));
+      btif_rc_rsp_key_add(&key, element_attrs,
+                          num_attr * sizeof(element_attrs[0]));
+      if (btif_rc_rsp_cache_send(p_dev, IDX_GET_ELEMENT_ATTR_RSP, &key,
+                                 BTRC_EVT_TRACK_CHANGE, label))
+        break;
       fill_pdu_queue(IDX_GET_ELEMENT_ATTR_RSP, ctype, label, true, p_dev, pavrc_cmd->pdu);
       HAL_CBACK(bt_rc_callbacks, get_element_attr_cb, num_attr, element_attrs,
                 &rc_addr);
@@ -2232,6 +2445,24 @@ static void btif_rc_upstreams_evt(uint16_t event, tAVRC_COMMAND* pavrc_cmd,
                sizeof(uint32_t) * num_attr);
       }
 
+      uint8_t event_id = BTRC_EVT_UIDS_CHANGED;
+      if (pavrc_cmd->get_items.scope == AVRC_SCOPE_PLAYER_LIST)
+        event_id = BTRC_EVT_AVAL_PLAYER_CHANGE;
+      else if (pavrc_cmd->get_items.scope == AVRC_SCOPE_NOW_PLAYING)
+        event_id = BTRC_EVT_NOW_PLAYING_CONTENT_CHANGED;
+
+      btif_rc_rsp_key_t key;
+      btif_rc_rsp_key_init(&key, pavrc_cmd->pdu, ctype);
+      btif_rc_rsp_key_add(&key, &pavrc_cmd->get_items.scope, 1);
+      btif_rc_rsp_key_add(&key, &pavrc_cmd->get_items.start_item, 4);
+      btif_rc_rsp_key_add(&key, &pavrc_cmd->get_items.end_item, 4);
+      btif_rc_rsp_key_add(&key, &num_attr, 1);
+      if ((num_attr != 0xFF) && (num_attr != 0x00))
+        btif_rc_rsp_key_add(&key, attr_ids, sizeof(uint32_t) * num_attr);
+      if (btif_rc_rsp_cache_send(p_dev, IDX_GET_FOLDER_ITEMS_RSP, &key,
+                                 event_id, label))
+        break;
+
       fill_pdu_queue(IDX_GET_FOLDER_ITEMS_RSP, ctype, label, true, p_dev, pavrc_cmd->pdu);
       HAL_CBACK(bt_rc_callbacks, get_folder_items_cb,
                 pavrc_cmd->get_items.scope, pavrc_cmd->get_items.start_item,
@@ -2239,12 +2470,14 @@ static void btif_rc_upstreams_evt(uint16_t event, tAVRC_COMMAND* pavrc_cmd,
     } break;
 
     case AVRC_PDU_SET_ADDRESSED_PLAYER: {
+      btif_rc_rsp_cache_flush(p_dev);
       fill_pdu_queue(IDX_SET_ADDR_PLAYER_RSP, ctype, label, true, p_dev, pavrc_cmd->pdu);
       HAL_CBACK(bt_rc_callbacks, set_addressed_player_cb,
                 pavrc_cmd->addr_player.player_id, &rc_addr);
     } break;
 
     case AVRC_PDU_SET_BROWSED_PLAYER: {
+      btif_rc_rsp_cache_flush(p_dev);
       fill_pdu_queue(IDX_SET_BROWSED_PLAYER_RSP, ctype, label, true, p_dev, pavrc_cmd->pdu);
       HAL_CBACK(bt_rc_callbacks, set_browsed_player_cb,
                 pavrc_cmd->br_player.player_id, &rc_addr);
@@ -2281,12 +2514,14 @@ static void btif_rc_upstreams_evt(uint16_t event, tAVRC_COMMAND* pavrc_cmd,
     } break;
 
     case AVRC_PDU_CHANGE_PATH: {
+      btif_rc_rsp_cache_flush(p_dev);
       fill_pdu_queue(IDX_CHG_PATH_RSP, ctype, label, true, p_dev, pavrc_cmd->pdu);
       HAL_CBACK(bt_rc_callbacks, change_path_cb, pavrc_cmd->chg_path.direction,
                 pavrc_cmd->chg_path.folder_uid, &rc_addr);
     } break;
 
     case AVRC_PDU_SEARCH: {
+      btif_rc_rsp_cache_flush(p_dev);
       fill_pdu_queue(IDX_SEARCH_RSP, ctype, label, true, p_dev, pavrc_cmd->pdu);
       HAL_CBACK(bt_rc_callbacks, search_cb, pavrc_cmd->search.string.charset_id,
                 pavrc_cmd->search.string.str_len,
@@ -2526,6 +2761,7 @@ static bt_status_t init(btrc_callbacks_t* callbacks, int max_connections) {
   }
 
   if (btif_rc_cb.rc_multi_cb != NULL) {
+    btif_rc_rsp_cache_flush_all();
     osi_free(btif_rc_cb.rc_multi_cb);
     btif_rc_cb.rc_multi_cb = NULL;
   }
@@ -2537,6 +2773,8 @@ static bt_status_t init(btrc_callbacks_t* callbacks, int max_connections) {
            sizeof(btif_rc_cb.rc_multi_cb[idx]));
     btif_rc_cb.rc_multi_cb[idx].rc_vol_label = MAX_LABEL;
     btif_rc_cb.rc_multi_cb[idx].rc_volume = MAX_VOLUME;
+    btif_rc_cb.rc_multi_cb[idx].rc_abs_vol_label = MAX_LABEL;
+    btif_rc_cb.rc_multi_cb[idx].rc_abs_vol_pending = MAX_VOLUME;
 #if (TWS_ENABLED == TRUE)
     btif_rc_cb.rc_multi_cb[idx].rc_initial_volume = MAX_VOLUME;
 #endif
@@ -2567,6 +2805,7 @@ static bt_status_t init_ctrl(btrc_ctrl_callbacks_t* callbacks) {
   if (btif_device_in_sink_role())
     btif_max_rc_clients = btif_get_max_allowable_sink_connections();
   if (btif_rc_cb.rc_multi_cb != NULL) {
+    btif_rc_rsp_cache_flush_all();
     osi_free(btif_rc_cb.rc_multi_cb);
     btif_rc_cb.rc_multi_cb = NULL;
   }
@@ -2578,6 +2817,8 @@ static bt_status_t init_ctrl(btrc_ctrl_callbacks_t* callbacks) {
            sizeof(btif_rc_cb.rc_multi_cb[idx]));
     btif_rc_cb.rc_multi_cb[idx].rc_vol_label = MAX_LABEL;
     btif_rc_cb.rc_multi_cb[idx].rc_volume = MAX_VOLUME;
+    btif_rc_cb.rc_multi_cb[idx].rc_abs_vol_label = MAX_LABEL;
+    btif_rc_cb.rc_multi_cb[idx].rc_abs_vol_pending = MAX_VOLUME;
 
 #if (TWS_ENABLED == TRUE)
     btif_rc_cb.rc_multi_cb[idx].rc_initial_volume = MAX_VOLUME;
@@ -3111,6 +3352,15 @@ static bt_status_t register_notification_rsp(
 
   BTIF_TRACE_IMP("%s: isShoMcastEnabled: %d", __func__, isShoMcastEnabled);
 
+  /* The cached responses are stale once the media app reports a change */
+  if (type == BTRC_NOTIFICATION_TYPE_CHANGED &&
+      (event_id == BTRC_EVT_TRACK_CHANGE ||
+       event_id == BTRC_EVT_ADDR_PLAYER_CHANGE ||
+       event_id == BTRC_EVT_AVAL_PLAYER_CHANGE ||
+       event_id == BTRC_EVT_UIDS_CHANGED ||
+       event_id == BTRC_EVT_NOW_PLAYING_CONTENT_CHANGED))
+    btif_rc_rsp_cache_flush_all();
+
   if (isShoMcastEnabled == true) {
     return(register_notification_rsp_sho_mcast(event_id,
                                                type,
@@ -3159,6 +3409,11 @@ static bt_status_t register_notification_rsp(
         avrc_rsp.reg_notif.param.play_status = p_param->play_status;
         BTIF_TRACE_ERROR("%s: play_status: %d",__FUNCTION__,
                               avrc_rsp.reg_notif.param.play_status);
+        if (btif_rc_notif_is_noop(&btif_rc_cb.rc_multi_cb[idx], event_id,
+                                  type, p_param->play_status)) {
+          BTIF_TRACE_DEBUG("%s: play status unchanged, not notified", __func__);
+          continue;
+        }
         if ((avrc_rsp.reg_notif.param.play_status == PLAY_STATUS_PLAYING) &&
             (btif_av_check_flag_remote_suspend(av_index)) &&
             (type == BTRC_NOTIFICATION_TYPE_CHANGED)
@@ -3200,6 +3455,12 @@ static bt_status_t register_notification_rsp(
           BTIF_TRACE_WARNING("%s: Device in silent mode disallow sending play pos change",__func__);
           return BT_STATUS_UNHANDLED;
         }
+        if (btif_rc_notif_is_noop(&btif_rc_cb.rc_multi_cb[idx], event_id,
+                                  type, p_param->song_pos)) {
+          BTIF_TRACE_DEBUG("%s: play position unchanged, not notified",
+                           __func__);
+          continue;
+        }
         break;
       case BTRC_EVT_AVAL_PLAYER_CHANGE:
         break;
@@ -3804,6 +4065,181 @@ static bt_status_t get_total_num_of_items_rsp(RawAddress* bd_addr,
   return BT_STATUS_SUCCESS;
 }
 
+/***************************************************************************
+ *
+ * Function         btif_rc_abs_vol_timer_timeout_handler
+ *
+ * Description      The peer did not answer a SetAbsoluteVolume, send the
+ *                  volume held back behind it (Runs in BTIF context).
+ * Returns          None
+ *
+ **************************************************************************/
+static void btif_rc_abs_vol_timer_timeout_handler(UNUSED_ATTR uint16_t event,
+                                                  char* p_data) {
+  btif_rc_handle_t* rc_handle = (btif_rc_handle_t*)p_data;
+  btif_rc_device_cb_t* p_dev = btif_rc_get_device_by_handle(rc_handle->handle);
+  if (p_dev == NULL) return;
+
+  int idx = btif_rc_get_idx_by_bda(&p_dev->rc_addr);
+  uint8_t label = p_dev->rc_abs_vol_label;
+  if (idx == -1 || label == MAX_LABEL) return;
+
+  BTIF_TRACE_WARNING("%s: no response to SetAbsoluteVolume, label: %d",
+                     __func__, label);
+  release_transaction(label, idx);
+  btif_rc_abs_vol_done(p_dev, label);
+}
+
+static void btif_rc_abs_vol_timer_timeout(void* data) {
+  btif_rc_handle_t rc_handle;
+  rc_handle.handle = PTR_TO_UINT(data);
+  btif_transfer_context(btif_rc_abs_vol_timer_timeout_handler, 0,
+                        (char*)(&rc_handle), sizeof(btif_rc_handle_t), NULL);
+}
+
+/***************************************************************************
+ *
+ * Function         send_abs_vol_cmd
+ *
+ * Description      Send a SetAbsoluteVolume command to the peer at |idx| and
+ *                  hold back further volumes until it is answered.
+ *
+ * Returns          bt_status_t
+ *
+ **************************************************************************/
+static bt_status_t send_abs_vol_cmd(int idx, uint8_t volume) {
+  btif_rc_device_cb_t* p_dev = &btif_rc_cb.rc_multi_cb[idx];
+  rc_transaction_t* p_transaction = NULL;
+  tAVRC_COMMAND avrc_cmd = {0};
+  BT_HDR* p_msg = NULL;
+
+  avrc_cmd.volume.opcode = AVRC_OP_VENDOR;
+  avrc_cmd.volume.pdu = AVRC_PDU_SET_ABSOLUTE_VOLUME;
+  avrc_cmd.volume.status = AVRC_STS_NO_ERROR;
+  avrc_cmd.volume.volume = volume;
+
+  if (AVRC_BldCommand(&avrc_cmd, &p_msg) != AVRC_STS_NO_ERROR) {
+    BTIF_TRACE_ERROR("%s: failed to build absolute volume command", __func__);
+    return BT_STATUS_FAIL;
+  }
+
+  bt_status_t tran_status = get_transaction(&p_transaction, idx);
+  if (BT_STATUS_SUCCESS != tran_status || NULL == p_transaction) {
+    osi_free_and_reset((void**)&p_msg);
+    BTIF_TRACE_ERROR("%s: failed to obtain transaction details. status: 0x%02x",
+                     __func__, tran_status);
+    return BT_STATUS_FAIL;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(btif_rc_abs_vol_lock);
+    p_dev->rc_abs_vol_label = p_transaction->lbl;
+    p_dev->rc_abs_vol_pending = MAX_VOLUME;
+  }
+  if (p_dev->rc_abs_vol_timer == NULL)
+    p_dev->rc_abs_vol_timer = alarm_new("btif_rc.abs_vol_timer");
+  alarm_set_on_mloop(p_dev->rc_abs_vol_timer, BTIF_TIMEOUT_RC_CONTROL_CMD_MS,
+                     btif_rc_abs_vol_timer_timeout,
+                     UINT_TO_PTR(p_dev->rc_handle));
+
+  BTIF_TRACE_DEBUG("%s: msgreq being sent out with label: %d", __func__,
+                   p_transaction->lbl);
+  BTA_AvMetaCmd(p_dev->rc_handle, p_transaction->lbl, AVRC_CMD_CTRL, p_msg);
+  return BT_STATUS_SUCCESS;
+}
+
+/***************************************************************************
+ *
+ * Function         btif_rc_abs_vol_hold
+ *
+ * Description      A slider drag asks for a new volume faster than the peer
+ *                  answers SetAbsoluteVolume. While a command is in flight,
+ *                  only the latest volume is kept and sent once the peer
+ *                  answers, so the peer always ends up on the final value.
+ *
+ * Returns          true if |volume| was held back
+ *
+ **************************************************************************/
+static bool btif_rc_abs_vol_hold(btif_rc_device_cb_t* p_dev, uint8_t volume) {
+  std::unique_lock<std::mutex> lock(btif_rc_abs_vol_lock);
+  if (p_dev->rc_abs_vol_label == MAX_LABEL) return false;
+
+  BTIF_TRACE_DEBUG("%s: holding volume %d behind label %d", __func__, volume,
+                   p_dev->rc_abs_vol_label);
+  p_dev->rc_abs_vol_pending = volume;
+  return true;
+}
+
+/***************************************************************************
+ *
+ * Function         btif_rc_abs_vol_done
+ *
+ * Description      The SetAbsoluteVolume with |label| was answered or timed
+ *                  out, send the volume held back if the peer is not already
+ *                  on it.
+ *
+ * Returns          void
+ *
+ **************************************************************************/
+static void btif_rc_abs_vol_done(btif_rc_device_cb_t* p_dev, uint8_t label) {
+  uint8_t volume;
+  {
+    std::unique_lock<std::mutex> lock(btif_rc_abs_vol_lock);
+    if (p_dev->rc_abs_vol_label != label) return;
+    p_dev->rc_abs_vol_label = MAX_LABEL;
+    volume = p_dev->rc_abs_vol_pending;
+    p_dev->rc_abs_vol_pending = MAX_VOLUME;
+  }
+  alarm_cancel(p_dev->rc_abs_vol_timer);
+
+  int idx = btif_rc_get_idx_by_bda(&p_dev->rc_addr);
+  if (volume == MAX_VOLUME || volume == p_dev->rc_volume || idx == -1 ||
+      !p_dev->rc_connected)
+    return;
+  send_abs_vol_cmd(idx, volume);
+}
+
+/***************************************************************************
+ *
+ * Function         btif_rc_abs_vol_reset
+ *
+ * Description      Forgets the SetAbsoluteVolume in flight and the volume
+ *                  held back behind it.
+ *
+ * Returns          void
+ *
+ **************************************************************************/
+static void btif_rc_abs_vol_reset(btif_rc_device_cb_t* p_dev) {
+  std::unique_lock<std::mutex> lock(btif_rc_abs_vol_lock);
+  alarm_free(p_dev->rc_abs_vol_timer);
+  p_dev->rc_abs_vol_timer = NULL;
+  p_dev->rc_abs_vol_label = MAX_LABEL;
+  p_dev->rc_abs_vol_pending = MAX_VOLUME;
+}
+
+/***************************************************************************
+ *
+ * Function         btif_rc_notif_is_noop
+ *
+ * Description      Records the value notified for |event_id|. A CHANGED
+ *                  notification carrying the value the peer already has
+ *                  only costs airtime next to the A2DP stream.
+ *
+ * Returns          true if the notification can be skipped
+ *
+ **************************************************************************/
+static bool btif_rc_notif_is_noop(btif_rc_device_cb_t* p_dev, uint8_t event_id,
+                                  btrc_notification_type_t type,
+                                  uint32_t value) {
+  bool noop = type == BTRC_NOTIFICATION_TYPE_CHANGED &&
+              p_dev->rc_notif_last_valid[event_id - 1] &&
+              p_dev->rc_notif_last_val[event_id - 1] == value;
+
+  p_dev->rc_notif_last_val[event_id - 1] = value;
+  p_dev->rc_notif_last_valid[event_id - 1] = true;
+  return noop;
+}
+
 /***************************************************************************
  *
  * Function         set_volume_sho_mcast
@@ -3821,7 +4257,6 @@ static bt_status_t get_total_num_of_items_rsp(RawAddress* bd_addr,
 static bt_status_t set_volume_sho_mcast(uint8_t volume, RawAddress* bd_addr) {
   BTIF_TRACE_DEBUG("%s: volume: %d", __func__, volume);
   tAVRC_STS status = BT_STATUS_UNSUPPORTED;
-  rc_transaction_t* p_transaction = NULL;
 
   int idx = btif_rc_get_idx_by_bda(bd_addr);
   if (idx == -1) {
@@ -3829,6 +4264,9 @@ static bt_status_t set_volume_sho_mcast(uint8_t volume, RawAddress* bd_addr) {
     return (bt_status_t)BT_STATUS_FAIL;
   }
 
+  if (btif_rc_abs_vol_hold(&btif_rc_cb.rc_multi_cb[idx], volume))
+    return BT_STATUS_SUCCESS;
+
   if (btif_rc_cb.rc_multi_cb[idx].rc_volume == volume) {
     status = BT_STATUS_DONE;
     BTIF_TRACE_ERROR("%s: volume value already set earlier: 0x%02x", __func__,
@@ -3852,36 +4290,7 @@ static bt_status_t set_volume_sho_mcast(uint8_t volume, RawAddress* bd_addr) {
   BTIF_TRACE_DEBUG("%s: Peer supports absolute volume. newVolume: %d",
           __func__, volume);
 
-  status = BT_STATUS_FAIL;
-  tAVRC_COMMAND avrc_cmd = {0};
-  BT_HDR* p_msg = NULL;
-  avrc_cmd.volume.opcode = AVRC_OP_VENDOR;
-  avrc_cmd.volume.pdu = AVRC_PDU_SET_ABSOLUTE_VOLUME;
-  avrc_cmd.volume.status = AVRC_STS_NO_ERROR;
-  avrc_cmd.volume.volume = volume;
-
-  if (AVRC_BldCommand(&avrc_cmd, &p_msg) == AVRC_STS_NO_ERROR) {
-    bt_status_t tran_status = get_transaction(&p_transaction, idx);
-
-    if (BT_STATUS_SUCCESS == tran_status && NULL != p_transaction) {
-      BTIF_TRACE_DEBUG("%s: msgreq being sent out with label: %d",
-                       __func__, p_transaction->lbl);
-      BTA_AvMetaCmd(btif_rc_cb.rc_multi_cb[idx].rc_handle,
-                    p_transaction->lbl, AVRC_CMD_CTRL, p_msg);
-      status = BT_STATUS_SUCCESS;
-    } else {
-      osi_free_and_reset((void**)&p_msg);
-      BTIF_TRACE_ERROR(
-          "%s: failed to obtain transaction details. status: 0x%02x",
-          __func__, tran_status);
-      status = BT_STATUS_FAIL;
-    }
-  } else {
-    BTIF_TRACE_ERROR(
-        "%s: failed to build absolute volume command. status: 0x%02x",
-        __func__, status);
-    status = BT_STATUS_FAIL;
-  }
+  status = send_abs_vol_cmd(idx, volume);
 
   return (bt_status_t)status;
 }
@@ -3908,7 +4317,6 @@ static bt_status_t set_volume(uint8_t volume, RawAddress*bd_addr) {
   }
 
   tAVRC_STS status = BT_STATUS_UNSUPPORTED;
-  rc_transaction_t* p_transaction = NULL;
 
   for (int idx = 0; idx < btif_max_rc_clients; idx++) {
     if (!btif_rc_cb.rc_multi_cb[idx].rc_connected) {
@@ -3918,6 +4326,11 @@ static bt_status_t set_volume(uint8_t volume, RawAddress*bd_addr) {
       continue;
     }
 
+    if (btif_rc_abs_vol_hold(&btif_rc_cb.rc_multi_cb[idx], volume)) {
+      status = BT_STATUS_SUCCESS;
+      continue;
+    }
+
     if (btif_rc_cb.rc_multi_cb[idx].rc_volume == volume) {
       status = BT_STATUS_DONE;
       BTIF_TRACE_ERROR("%s: volume value already set earlier: 0x%02x", __func__,
@@ -3931,41 +4344,11 @@ static bt_status_t set_volume(uint8_t volume, RawAddress*bd_addr) {
       if ((btif_rc_cb.rc_multi_cb[idx].rc_features & BTA_AV_FEAT_RCTG) == 0) {
         status = BT_STATUS_NOT_READY;
         continue;
-      } else {
-        tAVRC_COMMAND avrc_cmd = {0};
-        BT_HDR* p_msg = NULL;
-
-        if (btif_rc_cb.rc_multi_cb[idx].rc_features & BTA_AV_FEAT_ADV_CTRL) {
-          BTIF_TRACE_DEBUG("%s: Peer supports absolute volume. newVolume: %d",
-                           __func__, volume);
-          avrc_cmd.volume.opcode = AVRC_OP_VENDOR;
-          avrc_cmd.volume.pdu = AVRC_PDU_SET_ABSOLUTE_VOLUME;
-          avrc_cmd.volume.status = AVRC_STS_NO_ERROR;
-          avrc_cmd.volume.volume = volume;
-
-          if (AVRC_BldCommand(&avrc_cmd, &p_msg) == AVRC_STS_NO_ERROR) {
-            bt_status_t tran_status = get_transaction(&p_transaction, idx);
-
-            if (BT_STATUS_SUCCESS == tran_status && NULL != p_transaction) {
-              BTIF_TRACE_DEBUG("%s: msgreq being sent out with label: %d",
-                               __func__, p_transaction->lbl);
-              BTA_AvMetaCmd(btif_rc_cb.rc_multi_cb[idx].rc_handle,
-                            p_transaction->lbl, AVRC_CMD_CTRL, p_msg);
-              status = BT_STATUS_SUCCESS;
-            } else {
-              osi_free_and_reset((void**)&p_msg);
-              BTIF_TRACE_ERROR(
-                  "%s: failed to obtain transaction details. status: 0x%02x",
-                  __func__, tran_status);
-              status = BT_STATUS_FAIL;
-            }
-          } else {
-            BTIF_TRACE_ERROR(
-                "%s: failed to build absolute volume command. status: 0x%02x",
-                __func__, status);
-            status = BT_STATUS_FAIL;
-          }
-        }
+      } else if (btif_rc_cb.rc_multi_cb[idx].rc_features &
+                 BTA_AV_FEAT_ADV_CTRL) {
+        BTIF_TRACE_DEBUG("%s: Peer supports absolute volume. newVolume: %d",
+                         __func__, volume);
+        status = send_abs_vol_cmd(idx, volume);
       }
     }
   }
@@ -4066,6 +4449,7 @@ static void handle_rc_metamsg_rsp(tBTA_AV_META_MSG* pmeta_msg,
         release_transaction(p_dev->rc_vol_label, idx);
       } else if (AVRC_PDU_SET_ABSOLUTE_VOLUME == avrc_response.rsp.pdu) {
         release_transaction(pmeta_msg->label, idx);
+        btif_rc_abs_vol_done(p_dev, pmeta_msg->label);
       }
       return;
     }
@@ -4102,6 +4486,10 @@ static void handle_rc_metamsg_rsp(tBTA_AV_META_MSG* pmeta_msg,
                    __func__, dump_rc_pdu(avrc_response.pdu));
   btif_rc_upstreams_rsp_evt((uint16_t)avrc_response.rsp.pdu, &avrc_response,
                             pmeta_msg->code, pmeta_msg->label, p_dev);
+
+  /* rc_volume now holds what the peer accepted, send what is held back */
+  if (AVRC_PDU_SET_ABSOLUTE_VOLUME == avrc_response.rsp.pdu)
+    btif_rc_abs_vol_done(p_dev, pmeta_msg->label);
 }
 
 /***************************************************************************
@@ -5905,6 +6293,7 @@ static void cleanup_ctrl() {
     for (int idx = 0; idx < btif_max_rc_clients; idx++) {
       alarm_free(btif_rc_cb.rc_multi_cb[idx].rc_play_status_timer);
     }
+    btif_rc_rsp_cache_flush_all();
     osi_free(btif_rc_cb.rc_multi_cb);
     btif_rc_cb.rc_multi_cb = NULL;
   }
@@ -7068,8 +7457,10 @@ static void sleep_ms(period_ms_t timeout_ms) {
 }
 
 static bool absolute_volume_disabled() {
+  static osi_cached_property_t disable_abs_vol =
+      OSI_CACHED_PROPERTY("persist.bluetooth.disableabsvol");
   char volume_disabled[PROPERTY_VALUE_MAX] = {0};
-  osi_property_get("persist.bluetooth.disableabsvol", volume_disabled, "false");
+  osi_cached_property_get(&disable_abs_vol, volume_disabled, "false");
   if (strncmp(volume_disabled, "true", 4) == 0) {
     BTIF_TRACE_WARNING("%s: Absolute volume disabled by property", __func__);
     return true;
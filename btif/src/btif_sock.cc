@@ -35,6 +35,7 @@
 #include "btif_sock_thread.h"
 #include "btif_uid.h"
 #include "btif_util.h"
+#include "osi/include/properties.h"
 #include "osi/include/thread.h"
 
 using bluetooth::Uuid;
@@ -55,8 +56,15 @@ static void btsock_request_max_tx_data_length(const RawAddress& bd_addr);
 
 static void btsock_signaled(int fd, int type, int flags, uint32_t user_id);
 
+// Number of poll threads the RFCOMM and L2CAP sockets are spread over. The
+// socket thread slots are shared with PAN, hence the small upper bound.
+static const char* kSockPollThreadsProperty =
+    "persist.vendor.bt.sock_poll_threads";
+static const int kMaxSockPollThreads = 4;
+
 static std::atomic_int thread_handle{-1};
 static thread_t* thread;
+static uid_set_t* sock_uid_set;
 
 btsock_interface_t* btif_sock_get_interface(void) {
   static btsock_interface_t interface = {
@@ -75,7 +83,11 @@ bt_status_t btif_sock_init(uid_set_t* uid_set) {
 
   bt_status_t status;
   btsock_thread_init();
-  thread_handle = btsock_thread_create(btsock_signaled, NULL);
+  int poll_threads = osi_property_get_int32(kSockPollThreadsProperty, 1);
+  if (poll_threads < 1) poll_threads = 1;
+  if (poll_threads > kMaxSockPollThreads) poll_threads = kMaxSockPollThreads;
+  thread_handle =
+      btsock_thread_create_sharded(btsock_signaled, NULL, poll_threads);
   if (thread_handle == -1) {
     LOG_ERROR(LOG_TAG, "%s unable to create btsock_thread.", __func__);
     goto error;
@@ -110,6 +122,7 @@ bt_status_t btif_sock_init(uid_set_t* uid_set) {
     goto error;
   }
 
+  sock_uid_set = uid_set;
   return BT_STATUS_SUCCESS;
 
 error:;
@@ -125,6 +138,7 @@ void btif_sock_cleanup(void) {
   int saved_handle = thread_handle;
   if (std::atomic_exchange(&thread_handle, -1) == -1) return;
 
+  sock_uid_set = NULL;
   btsock_thread_exit(saved_handle);
   btsock_rfc_cleanup();
   btsock_sco_cleanup();
@@ -132,6 +146,14 @@ void btif_sock_cleanup(void) {
   thread_free(thread);
   thread = NULL;
 }
+void btif_sock_debug_dump(int fd) {
+  if (thread_handle == -1) return;
+
+  btsock_rfc_debug_dump(fd);
+  btsock_l2cap_debug_dump(fd);
+  uid_set_debug_dump(sock_uid_set, fd);
+}
+
 static bt_status_t btsock_control_req(uint8_t dlci, const RawAddress& bd_addr,
                                       uint8_t modem_signal,
                                       uint8_t break_signal,
@@ -24,10 +24,13 @@
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <mutex>
+#include <vector>
 
+#include <base/bind.h>
 #include <hardware/bt_sock.h>
 
 #include "osi/include/allocator.h"
@@ -36,6 +39,7 @@
 #include "bt_common.h"
 #include "bt_target.h"
 #include "bta_api.h"
+#include "bta_closure_api.h"
 #include "bta_jv_api.h"
 #include "bta_jv_co.h"
 #include "btif_common.h"
@@ -54,11 +58,15 @@
 #include "port_api.h"
 #include "sdp_api.h"
 
-struct packet {
-  struct packet *next, *prev;
-  uint32_t len;
-  uint8_t* data;
-};
+/* Number of SDUs that can wait on a socket to be delivered to the app */
+#define L2CAP_SOCK_RX_RING_SIZE 512
+
+/* Number of SDUs handed to the app with one sendmmsg() */
+#define L2CAP_SOCK_TX_BATCH 16
+
+/* Number of SDUs of the app handed to L2CAP with one message to the BTA
+ * thread */
+#define L2CAP_SOCK_TX_WRITE_BATCH 8
 
 typedef struct l2cap_socket {
   struct l2cap_socket* prev;  // link to prev list item
@@ -74,19 +82,23 @@ typedef struct l2cap_socket {
   int app_fd;                 // fd from app's side
 
   unsigned bytes_buffered;
-  struct packet* first_packet;  // fist packet to be delivered to app
-  struct packet* last_packet;   // last packet to be delivered to app
+  BT_HDR** rx_ring;  // SDUs to be delivered to app, owned by the socket
+  uint16_t rx_head;  // index of the first SDU in rx_ring
+  uint16_t rx_count;  // number of SDUs in rx_ring
 
   unsigned fixed_chan : 1;        // fixed channel (or psm?)
   unsigned server : 1;            // is a server? (or connecting?)
   unsigned connected : 1;         // is connected?
   unsigned outgoing_congest : 1;  // should we hold?
   unsigned server_psm_sent : 1;   // The server shall only send PSM once.
+  unsigned rx_throttled : 1;      // data flow held off for the rx budgets
   bool is_le_coc;                 // is le connection oriented channel?
   uint16_t mps;
 } l2cap_socket;
 
 static bt_status_t btSock_start_l2cap_server_l(l2cap_socket* sock);
+static l2cap_socket* btsock_l2cap_find_by_id_l(uint32_t id);
+static void btsock_l2cap_free_l(l2cap_socket* sock);
 
 static std::mutex state_lock;
 
@@ -112,91 +124,113 @@ static void btsock_l2cap_cbk(tBTA_JV_EVT event, tBTA_JV* p_data,
  * wait
  *       confirming the l2cap_ind until we have more space in the buffer. */
 
-/* returns false if none - caller must free "data" memory when done with it */
-static char packet_get_head_l(l2cap_socket* sock, uint8_t** data,
-                              uint32_t* len) {
-  struct packet* p = sock->first_packet;
+/* returns the SDU at index |i| from the head of the ring */
+static BT_HDR* rx_ring_peek_l(l2cap_socket* sock, uint16_t i) {
+  return sock->rx_ring[(sock->rx_head + i) % L2CAP_SOCK_RX_RING_SIZE];
+}
 
-  if (!p) return false;
+/* frees the SDU at the head of the ring */
+static void rx_ring_pop_l(l2cap_socket* sock) {
+  BT_HDR* p_buf = sock->rx_ring[sock->rx_head];
 
-  if (data) *data = sock->first_packet->data;
-  if (len) *len = sock->first_packet->len;
-  sock->first_packet = p->next;
-  if (sock->first_packet)
-    sock->first_packet->prev = NULL;
-  else
-    sock->last_packet = NULL;
+  sock->bytes_buffered -= p_buf->len;
+  uid_set_add_buffered(uid_set, sock->app_uid, -(int64_t)p_buf->len);
+  osi_free(p_buf);
+  sock->rx_head = (sock->rx_head + 1) % L2CAP_SOCK_RX_RING_SIZE;
+  sock->rx_count--;
+}
 
-  if (len) sock->bytes_buffered -= *len;
+/* takes ownership of p_buf without copying it, returns true on success */
+static bool rx_ring_put_tail_l(l2cap_socket* sock, BT_HDR* p_buf) {
+  if (sock->bytes_buffered >= L2CAP_MAX_RX_BUFFER ||
+      sock->rx_count == L2CAP_SOCK_RX_RING_SIZE) {
+    LOG_ERROR(LOG_TAG, "%s: buffer overflow", __func__);
+    osi_free(p_buf);
+    return false;
+  }
 
-  osi_free(p);
+  sock->rx_ring[(sock->rx_head + sock->rx_count) % L2CAP_SOCK_RX_RING_SIZE] =
+      p_buf;
+  sock->rx_count++;
+  sock->bytes_buffered += p_buf->len;
+  uid_set_add_buffered(uid_set, sock->app_uid, p_buf->len);
 
   return true;
 }
 
-static struct packet* packet_alloc(const uint8_t* data, uint32_t len) {
-  struct packet* p = (struct packet*)osi_calloc(sizeof(*p));
-  uint8_t* buf = (uint8_t*)osi_malloc(len);
-
-  p->data = buf;
-  p->len = len;
-  memcpy(p->data, data, len);
-  return p;
+/* returns true if the socket shouldn't take more SDUs over from L2CAP, either
+ * because it holds enough already or its UID does */
+static bool rx_over_budget_l(l2cap_socket* sock) {
+  return sock->bytes_buffered >= L2CAP_MAX_RX_BUFFER ||
+         sock->rx_count == L2CAP_SOCK_RX_RING_SIZE ||
+         uid_set_is_over_budget(uid_set, sock->app_uid);
 }
 
-/* makes a copy of the data, returns true on success */
-static char packet_put_head_l(l2cap_socket* sock, const void* data,
-                              uint32_t len) {
-  struct packet* p = packet_alloc((const uint8_t*)data, len);
+/* Takes the received SDUs over from L2CAP, as they are, one per app message,
+ * while the socket is within its budgets. Past them the rest stays queued in
+ * L2CAP and the peer is flow controlled. Returns false if the connection must
+ * be dropped: the peer doesn't back off and the backlog keeps growing. */
+static bool rx_pull_sdus_l(l2cap_socket* sock, uint32_t* p_bytes_read) {
+  BT_HDR* p_buf;
 
-  /*
-   * We do not check size limits here since this is used to undo "getting" a
-   * packet that the user read incompletely. That is to say the packet was
-   * already in the queue. We do check thos elimits in packet_put_tail_l() since
-   * that function is used to put new data into the queue.
-   */
-
-  if (!p) return false;
+  *p_bytes_read = 0;
+  while (!rx_over_budget_l(sock)) {
+    if (BTA_JvL2capReadBuf(sock->handle, &p_buf) != BTA_JV_SUCCESS)
+      return true;
 
-  p->prev = NULL;
-  p->next = sock->first_packet;
-  sock->first_packet = p;
-  if (p->next)
-    p->next->prev = p;
-  else
-    sock->last_packet = p;
+    uint16_t len = p_buf->len;
+    if (!rx_ring_put_tail_l(sock, p_buf)) return false;
+    *p_bytes_read += len;
+  }
 
-  sock->bytes_buffered += len;
+  if (!sock->rx_throttled) {
+    APPL_TRACE_DEBUG("%s: hold data flow, sock_id:%d uid:%d buffered:%u",
+                     __func__, sock->id, sock->app_uid, sock->bytes_buffered);
+    sock->rx_throttled = 1;
+    BTA_JvL2capFlowControl(sock->handle, false);
+  }
 
+  uint32_t backlog = 0;
+  if (BTA_JvL2capReady(sock->handle, &backlog) == BTA_JV_SUCCESS &&
+      backlog > L2CAP_MAX_RX_BUFFER) {
+    LOG_ERROR(LOG_TAG, "%s: buffer overflow, backlog:%u", __func__, backlog);
+    return false;
+  }
   return true;
 }
 
-/* makes a copy of the data, returns true on success */
-static char packet_put_tail_l(l2cap_socket* sock, const void* data,
-                              uint32_t len) {
-  struct packet* p = packet_alloc((const uint8_t*)data, len);
+/* runs on the BTA thread once a throttled socket is back within its budgets */
+static void on_l2cap_rx_resume(uint32_t id) {
+  uint32_t bytes_read = 0;
 
-  if (sock->bytes_buffered >= L2CAP_MAX_RX_BUFFER) {
-    LOG_ERROR(LOG_TAG, "packet_put_tail_l: buffer overflow");
-    return false;
-  }
+  std::unique_lock<std::mutex> lock(state_lock);
+  l2cap_socket* sock = btsock_l2cap_find_by_id_l(id);
+  if (!sock || !sock->connected || sock->rx_throttled) return;
 
-  if (!p) {
-    LOG_ERROR(LOG_TAG, "packet_put_tail_l: unable to allocate packet...");
-    return false;
+  BTA_JvL2capFlowControl(sock->handle, true);
+  if (!rx_pull_sdus_l(sock, &bytes_read)) {
+    APPL_TRACE_DEBUG("%s: unable to push data to socket - closing channel",
+                     __func__);
+    BTA_JvL2capClose(sock->handle);
+    btsock_l2cap_free_l(sock);
+    return;
   }
 
-  p->next = NULL;
-  p->prev = sock->last_packet;
-  sock->last_packet = p;
-  if (p->prev)
-    p->prev->next = p;
-  else
-    sock->first_packet = p;
+  if (bytes_read) {
+    btsock_thread_add_fd(pth, sock->our_fd, BTSOCK_L2CAP, SOCK_THREAD_FD_WR,
+                         sock->id);
+    uid_set_add_rx(uid_set, sock->app_uid, bytes_read);
+  }
+}
 
-  sock->bytes_buffered += len;
+/* restarts the data flow of throttled sockets back within their budgets */
+static void rx_resume_throttled_l(void) {
+  for (l2cap_socket* sock = socks; sock; sock = sock->next) {
+    if (!sock->rx_throttled || rx_over_budget_l(sock)) continue;
 
-  return true;
+    sock->rx_throttled = 0;
+    do_in_bta_thread(FROM_HERE, base::Bind(&on_l2cap_rx_resume, sock->id));
+  }
 }
 
 static char is_inited(void) {
@@ -214,7 +248,6 @@ static l2cap_socket* btsock_l2cap_find_by_id_l(uint32_t id) {
 }
 
 static void btsock_l2cap_free_l(l2cap_socket* sock) {
-  uint8_t* buf;
   l2cap_socket* t = socks;
 
   while (t && t != sock) t = t->next;
@@ -237,7 +270,7 @@ static void btsock_l2cap_free_l(l2cap_socket* sock) {
     APPL_TRACE_ERROR("SOCK_LIST: free(id = %d) - NO app_fd!", sock->id);
   }
 
-  while (packet_get_head_l(sock, &buf, NULL)) osi_free(buf);
+  while (sock->rx_count) rx_ring_pop_l(sock);
 
   APPL_TRACE_DEBUG("%s: fixed_chan=%d, channel=%d is_le_soc=%d handle=%d sock_id:%d is_server=%d",
                      __func__, sock->fixed_chan, sock->channel, sock->is_le_coc, sock->handle,
@@ -279,7 +312,11 @@ static void btsock_l2cap_free_l(l2cap_socket* sock) {
   }
 
   APPL_TRACE_DEBUG("%s: free(id = %d)", __func__, sock->id);
+  osi_free(sock->rx_ring);
   osi_free(sock);
+
+  // What the socket held no longer counts against its UID.
+  rx_resume_throttled_l();
 }
 
 static l2cap_socket* btsock_l2cap_alloc_l(const char* name,
@@ -315,8 +352,10 @@ static l2cap_socket* btsock_l2cap_alloc_l(const char* name,
   if (name) strncpy(sock->name, name, sizeof(sock->name) - 1);
   if (addr) sock->addr = *addr;
 
-  sock->first_packet = NULL;
-  sock->last_packet = NULL;
+  sock->rx_ring =
+      (BT_HDR**)osi_calloc(L2CAP_SOCK_RX_RING_SIZE * sizeof(BT_HDR*));
+  sock->rx_head = 0;
+  sock->rx_count = 0;
 
   sock->mps = L2CAP_LE_MIN_MPS;
 
@@ -724,10 +763,10 @@ static void on_l2cap_data_ind(tBTA_JV* evt, uint32_t id) {
 
     tBTA_JV_LE_DATA_IND* p_le_data_ind = &evt->le_data_ind;
     BT_HDR* p_buf = p_le_data_ind->p_buf;
-    uint8_t* data = (uint8_t*)(p_buf + 1) + p_buf->offset;
+    uint16_t len = p_buf->len;
 
-    if (packet_put_tail_l(sock, data, p_buf->len)) {
-      bytes_read = p_buf->len;
+    if (rx_ring_put_tail_l(sock, p_buf)) {
+      bytes_read = len;
       btsock_thread_add_fd(pth, sock->our_fd, BTSOCK_L2CAP, SOCK_THREAD_FD_WR,
                            sock->id);
     } else {  // connection must be dropped
@@ -739,25 +778,18 @@ static void on_l2cap_data_ind(tBTA_JV* evt, uint32_t id) {
     }
 
   } else {
-    uint8_t buffer[L2CAP_MAX_SDU_LENGTH];
-    uint32_t count;
-
-    if (BTA_JvL2capReady(sock->handle, &count) == BTA_JV_SUCCESS) {
-      if (BTA_JvL2capRead(sock->handle, sock->id, buffer, count) ==
-          BTA_JV_SUCCESS) {
-        if (packet_put_tail_l(sock, buffer, count)) {
-          bytes_read = count;
-          btsock_thread_add_fd(pth, sock->our_fd, BTSOCK_L2CAP,
-                               SOCK_THREAD_FD_WR, sock->id);
-        } else {  // connection must be dropped
-          APPL_TRACE_DEBUG(
-              "on_l2cap_data_ind() unable to push data to socket"
-              " - closing channel");
-          BTA_JvL2capClose(sock->handle);
-          btsock_l2cap_free_l(sock);
-        }
-      }
+    if (!rx_pull_sdus_l(sock, &bytes_read)) {  // connection must be dropped
+      APPL_TRACE_DEBUG(
+          "on_l2cap_data_ind() unable to push data to socket"
+          " - closing channel");
+      BTA_JvL2capClose(sock->handle);
+      btsock_l2cap_free_l(sock);
+      sock = NULL;
     }
+
+    if (sock && bytes_read)
+      btsock_thread_add_fd(pth, sock->our_fd, BTSOCK_L2CAP, SOCK_THREAD_FD_WR,
+                           sock->id);
   }
 
   uid_set_add_rx(uid_set, app_uid, bytes_read);
@@ -1016,26 +1048,43 @@ bt_status_t btsock_l2cap_connect(const RawAddress* bd_addr, int channel,
  * (for example: unrecoverable error or no data)
  */
 static bool flush_incoming_que_on_wr_signal_l(l2cap_socket* sock) {
-  uint8_t* buf;
-  uint32_t len;
+  struct mmsghdr msgs[L2CAP_SOCK_TX_BATCH];
+  struct iovec iov[L2CAP_SOCK_TX_BATCH];
+
+  while (sock->rx_count) {
+    /* The socket is SOCK_SEQPACKET, so each SDU goes out as its own message,
+     * several of them per system call. */
+    int count = std::min((int)sock->rx_count, L2CAP_SOCK_TX_BATCH);
+    memset(msgs, 0, sizeof(msgs));
+    for (int i = 0; i < count; i++) {
+      BT_HDR* p_buf = rx_ring_peek_l(sock, i);
+      iov[i].iov_base = (uint8_t*)(p_buf + 1) + p_buf->offset;
+      iov[i].iov_len = p_buf->len;
+      msgs[i].msg_hdr.msg_iov = &iov[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
 
-  while (packet_get_head_l(sock, &buf, &len)) {
-    ssize_t sent;
-    OSI_NO_INTR(sent = send(sock->our_fd, buf, len, MSG_DONTWAIT));
+    int sent;
+    OSI_NO_INTR(sent = sendmmsg(sock->our_fd, msgs, count, MSG_DONTWAIT));
     int saved_errno = errno;
 
-    if (sent == (signed)len)
-      osi_free(buf);
-    else if (sent >= 0) {
-      packet_put_head_l(sock, buf + sent, len - sent);
-      osi_free(buf);
-      if (!sent) /* special case if other end not keeping up */
+    if (sent < 0) return saved_errno == EWOULDBLOCK || saved_errno == EAGAIN;
+
+    for (int i = 0; i < sent; i++) {
+      BT_HDR* p_buf = rx_ring_peek_l(sock, 0);
+      if (msgs[i].msg_len < p_buf->len) {
+        /* special case if other end not keeping up */
+        p_buf->offset += msgs[i].msg_len;
+        p_buf->len -= msgs[i].msg_len;
+        sock->bytes_buffered -= msgs[i].msg_len;
+        uid_set_add_buffered(uid_set, sock->app_uid,
+                             -(int64_t)msgs[i].msg_len);
         return true;
-    } else {
-      packet_put_head_l(sock, buf, len);
-      osi_free(buf);
-      return saved_errno == EWOULDBLOCK || saved_errno == EAGAIN;
+      }
+      rx_ring_pop_l(sock);
     }
+
+    if (sent < count) return true;
   }
 
   return false;
@@ -1054,6 +1103,48 @@ inline uint8_t* get_l2cap_sdu_start_ptr(BT_HDR* msg) {
   return (uint8_t*)(msg) + BT_HDR_SIZE + msg->offset;
 }
 
+/* Reads the SDUs the app has queued on a PSM based socket, up to
+ * L2CAP_SOCK_TX_WRITE_BATCH of them, and hands them to L2CAP with one
+ * message to the BTA thread. Bulk OBEX transfers such as cover art images are
+ * written as a stream of MTU sized SDUs and would otherwise cost a round trip
+ * through the BTA thread per SDU. |size| is the length of the first SDU. */
+static void read_outgoing_batch_l(l2cap_socket* sock, int fd, int size,
+                                  uint32_t user_id) {
+  std::vector<BT_HDR*> msgs;
+
+  while (msgs.size() < L2CAP_SOCK_TX_WRITE_BATCH) {
+    BT_HDR* buffer = malloc_l2cap_buf(size);
+    ssize_t count;
+    OSI_NO_INTR(count = recv(fd, get_l2cap_sdu_start_ptr(buffer), size,
+                             MSG_NOSIGNAL | MSG_DONTWAIT | MSG_TRUNC));
+    if (count <= 0) {
+      osi_free(buffer);
+      break;
+    }
+    if (count > size) {
+      LOG(ERROR) << "recv more than MPS. Data will be lost: " << count;
+      count = size;
+    }
+    buffer->len = count;
+    msgs.push_back(buffer);
+
+    /* Later SDUs are not measured with FIONREAD, allow the full MPS */
+    size = sock->mps;
+  }
+  DVLOG(2) << __func__ << ": SDUs received from socket: " << msgs.size();
+
+  if (msgs.empty()) {
+    /* Nothing was there after all, keep watching the socket */
+    btsock_thread_add_fd(pth, sock->our_fd, BTSOCK_L2CAP, SOCK_THREAD_FD_RD,
+                         sock->id);
+    return;
+  }
+
+  // will take care of freeing the buffers
+  if (BTA_JvL2capWriteBatch(sock->handle, msgs, user_id) != BTA_JV_SUCCESS)
+    APPL_TRACE_WARNING("%s: write failed, id %u", __func__, user_id);
+}
+
 void btsock_l2cap_signaled(int fd, int flags, uint32_t user_id) {
   char drop_it = false;
 
@@ -1077,36 +1168,36 @@ void btsock_l2cap_signaled(int fd, int flags, uint32_t user_id) {
            by BT spec). */
         size = std::min(size, (int)sock->mps);
 
-        BT_HDR* buffer = malloc_l2cap_buf(size);
-        /* The socket is created with SOCK_SEQPACKET, hence we read one message
-         * at the time. */
-        ssize_t count;
-        OSI_NO_INTR(count = recv(fd, get_l2cap_sdu_start_ptr(buffer), size,
-                                 MSG_NOSIGNAL | MSG_DONTWAIT | MSG_TRUNC));
-        if (count > L2CAP_LE_MAX_MPS) {
-          /* This can't happen thanks to check in BluetoothSocket.java but leave
-           * this in case this socket is ever used anywhere else*/
-          LOG(ERROR) << "recv more than MPS. Data will be lost: " << count;
-          count = L2CAP_LE_MAX_MPS;
-        }
+        if (!sock->fixed_chan) {
+          read_outgoing_batch_l(sock, fd, size, user_id);
+        } else {
+          BT_HDR* buffer = malloc_l2cap_buf(size);
+          /* The socket is created with SOCK_SEQPACKET, hence we read one
+           * message at the time. */
+          ssize_t count;
+          OSI_NO_INTR(count = recv(fd, get_l2cap_sdu_start_ptr(buffer), size,
+                                   MSG_NOSIGNAL | MSG_DONTWAIT | MSG_TRUNC));
+          if (count > L2CAP_LE_MAX_MPS) {
+            /* This can't happen thanks to check in BluetoothSocket.java but
+             * leave this in case this socket is ever used anywhere else*/
+            LOG(ERROR) << "recv more than MPS. Data will be lost: " << count;
+            count = L2CAP_LE_MAX_MPS;
+          }
 
-        /* When multiple packets smaller than MTU are flushed to the socket, the
-           size of the single packet read could be smaller than the ioctl
-           reported total size of awaiting packets. Hence, we adjust the buffer
-           length. */
-        buffer->len = count;
-        DVLOG(2) << __func__ << ": bytes received from socket: " << count;
+          /* When multiple packets smaller than MTU are flushed to the socket,
+             the size of the single packet read could be smaller than the ioctl
+             reported total size of awaiting packets. Hence, we adjust the
+             buffer length. */
+          buffer->len = count;
+          DVLOG(2) << __func__ << ": bytes received from socket: " << count;
 
-        if (sock->fixed_chan) {
           if (BTA_JvL2capWriteFixed(sock->channel, sock->addr,
                                     PTR_TO_UINT(buffer), btsock_l2cap_cbk,
-                                    get_l2cap_sdu_start_ptr(buffer), count, user_id) != BTA_JV_SUCCESS) {
+                                    get_l2cap_sdu_start_ptr(buffer), count,
+                                    user_id) != BTA_JV_SUCCESS) {
             // On fail, free the buffer
             on_l2cap_write_fail(buffer, count, user_id);
           }
-        } else {
-          // will take care of freeing buffer
-          BTA_JvL2capWrite(sock->handle, PTR_TO_UINT(buffer), buffer, user_id);
         }
       }
     } else
@@ -1117,6 +1208,7 @@ void btsock_l2cap_signaled(int fd, int flags, uint32_t user_id) {
     if (flush_incoming_que_on_wr_signal_l(sock) && sock->connected)
       btsock_thread_add_fd(pth, sock->our_fd, BTSOCK_L2CAP, SOCK_THREAD_FD_WR,
                            sock->id);
+    rx_resume_throttled_l();
   }
   if (drop_it || (flags & SOCK_THREAD_FD_EXCEPTION)) {
     int size = 0;
@@ -1124,3 +1216,18 @@ void btsock_l2cap_signaled(int fd, int flags, uint32_t user_id) {
       btsock_l2cap_free_l(sock);
   }
 }
+
+void btsock_l2cap_debug_dump(int fd) {
+  std::unique_lock<std::mutex> lock(state_lock);
+
+  dprintf(fd, "\nL2CAP sockets:\n");
+  for (l2cap_socket* sock = socks; sock; sock = sock->next) {
+    if (sock->server) continue;
+
+    dprintf(fd, "  id:%u %s %s:%d uid:%d buffered:%u bytes in %u SDUs%s\n",
+            sock->id, sock->addr.ToString().c_str(),
+            sock->fixed_chan ? "fixed_chan" : "psm", sock->channel,
+            sock->app_uid, sock->bytes_buffered, sock->rx_count,
+            sock->rx_throttled ? " (throttled)" : "");
+  }
+}
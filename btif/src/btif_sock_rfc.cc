@@ -26,6 +26,7 @@
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include <mutex>
@@ -103,6 +104,8 @@ typedef struct {
   int rfc_port_handle;
   int role;
   list_t* incoming_queue;
+  uint32_t rx_buffered;  // bytes in incoming_queue
+  bool rx_throttled;     // data flow held off for the UID receive budget
 } rfc_slot_t;
 
 static rfc_slot_t rfc_slots[MAX_RFC_CHANNEL];
@@ -117,6 +120,7 @@ static void jv_dm_cback(tBTA_JV_EVT event, tBTA_JV* p_data, uint32_t id);
 static uint32_t rfcomm_cback(tBTA_JV_EVT event, tBTA_JV* p_data,
                              uint32_t rfcomm_slot_id);
 static bool send_app_scn(rfc_slot_t* rs);
+static void rx_resume_throttled_l(void);
 
 static bool is_init_done(void) { return pth != -1; }
 
@@ -226,6 +230,8 @@ static rfc_slot_t* alloc_rfc_slot(const RawAddress* addr, const char* name,
   slot->security = security;
   slot->scn = channel;
   slot->app_uid = -1;
+  slot->rx_buffered = 0;
+  slot->rx_throttled = false;
 
   slot->is_service_uuid_valid = !uuid.IsEmpty();
   slot->service_uuid = uuid;
@@ -447,11 +453,17 @@ static void cleanup_rfc_slot(rfc_slot_t* slot) {
 
   free_rfc_slot_scn(slot);
   list_clear(slot->incoming_queue);
+  uid_set_add_buffered(uid_set, slot->app_uid, -(int64_t)slot->rx_buffered);
+  slot->rx_buffered = 0;
+  slot->rx_throttled = false;
 
   slot->rfc_port_handle = 0;
   memset(&slot->f, 0, sizeof(slot->f));
   slot->id = 0;
   slot->scn_notified = false;
+
+  // What the slot held no longer counts against its UID.
+  rx_resume_throttled_l();
 }
 
 static bool send_app_scn(rfc_slot_t* slot) {
@@ -760,6 +772,9 @@ static void jv_dm_cback(tBTA_JV_EVT event, tBTA_JV* p_data, uint32_t id) {
   }
 }
 
+// Maximum number of queued buffers written to the app with one sendmsg.
+#define RFC_SOCK_MAX_IOV 16
+
 typedef enum {
   SENT_FAILED,
   SENT_NONE,
@@ -790,10 +805,91 @@ static sent_status_t send_data_to_app(int fd, BT_HDR* p_buf) {
   return SENT_PARTIAL;
 }
 
+// Queues |p_buf| for the app and accounts it against the slot and its UID.
+static void rx_queue_append_l(rfc_slot_t* slot, BT_HDR* p_buf) {
+  list_append(slot->incoming_queue, p_buf);
+  slot->rx_buffered += p_buf->len;
+  uid_set_add_buffered(uid_set, slot->app_uid, p_buf->len);
+}
+
+// Releases |bytes| of the slot's queue that reached the app.
+static void rx_queue_release_l(rfc_slot_t* slot, size_t bytes) {
+  if (bytes > slot->rx_buffered) bytes = slot->rx_buffered;
+  slot->rx_buffered -= bytes;
+  uid_set_add_buffered(uid_set, slot->app_uid, -(int64_t)bytes);
+}
+
+// Restarts the data flow of slots that were held off for the receive budget of
+// their UID and whose app has caught up since.
+static void rx_resume_throttled_l(void) {
+  for (size_t i = 0; i < ARRAY_SIZE(rfc_slots); ++i) {
+    rfc_slot_t* slot = &rfc_slots[i];
+    if (!slot->id || !slot->rx_throttled) continue;
+    if (!list_is_empty(slot->incoming_queue) ||
+        uid_set_is_over_budget(uid_set, slot->app_uid))
+      continue;
+
+    slot->rx_throttled = false;
+    APPL_TRACE_DEBUG("%s enable data flow, rfc_port_handle:0x%x, uid:%d",
+                     __func__, slot->rfc_port_handle, slot->app_uid);
+    PORT_FlowControl_MaxCredit(slot->rfc_port_handle, true);
+  }
+}
+
+// Writes up to RFC_SOCK_MAX_IOV queued buffers to the app with one sendmsg.
+// Buffers that went out completely are removed from the queue and the first
+// one that did not is trimmed to the unsent bytes.
+static sent_status_t send_queue_to_app(rfc_slot_t* slot) {
+  int fd = slot->fd;
+  list_t* queue = slot->incoming_queue;
+  struct iovec iov[RFC_SOCK_MAX_IOV];
+  size_t iovcnt = 0;
+  size_t total = 0;
+  for (const list_node_t* node = list_begin(queue);
+       node != list_end(queue) && iovcnt < RFC_SOCK_MAX_IOV;
+       node = list_next(node)) {
+    BT_HDR* p_buf = (BT_HDR*)list_node(node);
+    iov[iovcnt].iov_base = p_buf->data + p_buf->offset;
+    iov[iovcnt].iov_len = p_buf->len;
+    total += p_buf->len;
+    iovcnt++;
+  }
+
+  ssize_t sent = 0;
+  if (total) {
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
+    OSI_NO_INTR(sent = sendmsg(fd, &msg, MSG_DONTWAIT));
+
+    if (sent == -1) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) return SENT_NONE;
+      LOG_ERROR(LOG_TAG, "%s error writing RFCOMM data back to app: %s",
+                __func__, strerror(errno));
+      return SENT_FAILED;
+    }
+
+    if (sent == 0) return SENT_FAILED;
+  }
+
+  rx_queue_release_l(slot, sent);
+  for (size_t i = 0; i < iovcnt; i++) {
+    BT_HDR* p_buf = (BT_HDR*)list_front(queue);
+    if ((size_t)sent < p_buf->len) {
+      p_buf->offset += sent;
+      p_buf->len -= sent;
+      return SENT_PARTIAL;
+    }
+    sent -= p_buf->len;
+    list_remove(queue, p_buf);
+  }
+  return SENT_ALL;
+}
+
 static bool flush_incoming_que_on_wr_signal(rfc_slot_t* slot) {
   while (!list_is_empty(slot->incoming_queue)) {
-    BT_HDR* p_buf = (BT_HDR*)list_front(slot->incoming_queue);
-    switch (send_data_to_app(slot->fd, p_buf)) {
+    switch (send_queue_to_app(slot)) {
       case SENT_NONE:
       case SENT_PARTIAL:
         // monitor the fd to get callback when app is ready to receive data
@@ -802,21 +898,21 @@ static bool flush_incoming_que_on_wr_signal(rfc_slot_t* slot) {
         return true;
 
       case SENT_ALL:
-        list_remove(slot->incoming_queue, p_buf);
         break;
 
       case SENT_FAILED:
-        list_remove(slot->incoming_queue, p_buf);
         return false;
     }
   }
 
-  // app is ready to receive data, tell stack to start the data flow
-  // fix me: need a jv flow control api to serialize the call in stack
-  APPL_TRACE_DEBUG(
-      "enable data flow, rfc_handle:0x%x, rfc_port_handle:0x%x, user_id:%d",
-      slot->rfc_handle, slot->rfc_port_handle, slot->id);
-  PORT_FlowControl_MaxCredit(slot->rfc_port_handle, true);
+  // The queue drained, which may bring other slots of the UID back within
+  // the budget too.
+  slot->rx_throttled = true;
+  rx_resume_throttled_l();
+  if (slot->rx_throttled) {
+    APPL_TRACE_DEBUG("%s uid:%d over receive budget, hold data flow, slot:%d",
+                     __func__, slot->app_uid, slot->id);
+  }
   return true;
 }
 
@@ -878,14 +974,19 @@ int bta_co_rfc_data_incoming(uint32_t id, BT_HDR* p_buf) {
     switch (send_data_to_app(slot->fd, p_buf)) {
       case SENT_NONE:
       case SENT_PARTIAL:
-        list_append(slot->incoming_queue, p_buf);
+        rx_queue_append_l(slot, p_buf);
         btsock_thread_add_fd(pth, slot->fd, BTSOCK_RFCOMM, SOCK_THREAD_FD_WR,
                              slot->id);
         break;
 
       case SENT_ALL:
         osi_free(p_buf);
-        ret = 1;  // Enable data flow.
+        if (uid_set_is_over_budget(uid_set, app_uid)) {
+          // Other sockets of the app hold too much, resumed as they drain.
+          slot->rx_throttled = true;
+        } else {
+          ret = 1;  // Enable data flow.
+        }
         break;
 
       case SENT_FAILED:
@@ -894,7 +995,7 @@ int bta_co_rfc_data_incoming(uint32_t id, BT_HDR* p_buf) {
         break;
     }
   } else {
-    list_append(slot->incoming_queue, p_buf);
+    rx_queue_append_l(slot, p_buf);
   }
 
   uid_set_add_rx(uid_set, app_uid, bytes_rx);
@@ -937,6 +1038,27 @@ int bta_co_rfc_data_outgoing(uint32_t id, uint8_t* buf, uint16_t size) {
   return true;
 }
 
+int bta_co_rfc_data_outgoing_iov(uint32_t id, struct iovec* iov, int iovcnt) {
+  std::unique_lock<std::recursive_mutex> lock(slot_lock);
+  rfc_slot_t* slot = find_rfc_slot_by_id(id);
+  if (!slot) return false;
+
+  ssize_t size = 0;
+  for (int i = 0; i < iovcnt; i++) size += iov[i].iov_len;
+
+  ssize_t received;
+  OSI_NO_INTR(received = readv(slot->fd, iov, iovcnt));
+
+  if (received != size) {
+    LOG_ERROR(LOG_TAG, "%s error receiving RFCOMM data from app: %s", __func__,
+              strerror(errno));
+    cleanup_rfc_slot(slot);
+    return false;
+  }
+
+  return true;
+}
+
 static rfc_slot_t* find_rfc_slot_by_scn(int scn)
 {
     int i;
@@ -1048,3 +1170,17 @@ bt_status_t btsock_rfc_set_sockopt(int channel, btsock_option_type_t option_name
 
     return status;
 }
+
+void btsock_rfc_debug_dump(int fd) {
+  std::unique_lock<std::recursive_mutex> lock(slot_lock);
+
+  dprintf(fd, "\nRFCOMM sockets:\n");
+  for (size_t i = 0; i < ARRAY_SIZE(rfc_slots); ++i) {
+    const rfc_slot_t* slot = &rfc_slots[i];
+    if (!slot->id || slot->f.server) continue;
+
+    dprintf(fd, "  id:%u %s scn:%d uid:%d buffered:%u bytes%s\n", slot->id,
+            slot->addr.ToString().c_str(), slot->scn, slot->app_uid,
+            slot->rx_buffered, slot->rx_throttled ? " (throttled)" : "");
+  }
+}
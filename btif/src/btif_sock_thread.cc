@@ -20,7 +20,7 @@
  *
  *  Filename:      btif_sock_thread.cc
  *
- *  Description:   socket select thread
+ *  Description:   socket epoll thread
  *
  ******************************************************************************/
 
@@ -38,8 +38,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/poll.h>
-#include <sys/select.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/un.h>
@@ -49,6 +49,8 @@
 
 #include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "bta_api.h"
 #include "btif_common.h"
@@ -66,40 +68,59 @@
 
 #define MAX_THREAD 8
 #define MAX_POLL 64
-#define POLL_EXCEPTION_EVENTS (POLLHUP | POLLRDHUP | POLLERR | POLLNVAL)
-#define IS_EXCEPTION(e) ((e)&POLL_EXCEPTION_EVENTS)
-#define IS_READ(e) ((e)&POLLIN)
-#define IS_WRITE(e) ((e)&POLLOUT)
+#define MAX_EPOLL_EVENTS 16
+#define EPOLL_EXCEPTION_EVENTS (EPOLLHUP | EPOLLRDHUP | EPOLLERR)
+#define IS_EXCEPTION(e) ((e)&EPOLL_EXCEPTION_EVENTS)
+#define IS_READ(e) ((e)&EPOLLIN)
+#define IS_WRITE(e) ((e)&EPOLLOUT)
+/* epoll data of the two control fds, the data fds use their poll slot index */
+#define WAKEUP_SLOT MAX_POLL
+#define CMD_SLOT (MAX_POLL + 1)
 /*cmd executes in socket poll thread */
-#define CMD_WAKEUP 1
-#define CMD_EXIT 2
-#define CMD_ADD_FD 3
-#define CMD_REMOVE_FD 4
 #define CMD_USER_PRIVATE 5
 
+/* The fds stay registered with the epoll instance of their thread for as long
+ * as they are monitored. Adds are applied from the calling thread, while
+ * removals are queued and the poll thread is woken through |wakeup_fd|, so
+ * that an fd is never closed under a running callback. The command socket
+ * only carries btsock_thread_post_cmd() now.
+ *
+ * An fd closed by its owner without btsock_thread_remove_fd_and_close() is
+ * dropped by the kernel without an event. Its slot is taken over by the next
+ * registration of the same fd number, or reclaimed when the slots run out. */
 typedef struct {
-  struct pollfd pfd;
+  int fd;
   uint32_t user_id;
   int type;
   int flags;
 } poll_slot_t;
 typedef struct {
+  int epoll_fd;
+  int wakeup_fd;
   int cmd_fdr, cmd_fdw;
+  std::mutex lock;  // guards the fields below
   int poll_count;
   poll_slot_t ps[MAX_POLL];
-  int psi[MAX_POLL];  // index of poll slot
+  std::unordered_map<int, int> fd_slot;  // fd to index in |ps|
+  std::vector<int> pending_removals;
+  bool exit_requested;
   pthread_t thread_id;
   btsock_signaled_cb callback;
   btsock_cmd_cb cmd_callback;
   int used;
+  /* threads a sharded handle spreads its fds over, this one included */
+  int shard_count;
+  int shards[MAX_THREAD];
 } thread_slot_t;
 static thread_slot_t ts[MAX_THREAD];
 
 static void* sock_poll_thread(void* arg);
 static inline void close_cmd_fd(int h);
+static int create_poll_thread(int h, btsock_signaled_cb callback,
+                              btsock_cmd_cb cmd_callback);
 
-static inline void add_poll(int h, int fd, int type, int flags,
-                            uint32_t user_id);
+static inline void add_poll_locked(int h, int fd, int type, int flags,
+                                   uint32_t user_id);
 
 static std::recursive_mutex thread_slot_lock;
 
@@ -128,7 +149,7 @@ static inline int create_thread(void* (*start_routine)(void*), void* arg,
   pthread_setschedparam(*thread_id, policy, &param);
   return ret;
 }
-static void init_poll(int cmd_fd);
+static bool init_poll(int h);
 static int alloc_thread_slot() {
   std::unique_lock<std::recursive_mutex> lock(thread_slot_lock);
   int i;
@@ -146,10 +167,19 @@ static int alloc_thread_slot() {
 static void free_thread_slot(int h) {
   if (0 <= h && h < MAX_THREAD) {
     close_cmd_fd(h);
+    std::unique_lock<std::mutex> lock(ts[h].lock);
+    ts[h].fd_slot.clear();
+    ts[h].pending_removals.clear();
+    ts[h].shard_count = 0;
     ts[h].used = 0;
   } else
     APPL_TRACE_ERROR("invalid thread handle:%d", h);
 }
+/* Returns the thread of the handle |h| that monitors |fd| */
+static inline int shard_of(int h, int fd) {
+  if (ts[h].shard_count <= 1) return h;
+  return ts[h].shards[(unsigned int)fd % ts[h].shard_count];
+}
 int btsock_thread_init() {
   static int initialized;
   APPL_TRACE_DEBUG("in initialized:%d", initialized);
@@ -157,61 +187,121 @@ int btsock_thread_init() {
     initialized = 1;
     int h;
     for (h = 0; h < MAX_THREAD; h++) {
+      ts[h].epoll_fd = ts[h].wakeup_fd = -1;
       ts[h].cmd_fdr = ts[h].cmd_fdw = -1;
       ts[h].used = 0;
       ts[h].thread_id = -1;
       ts[h].poll_count = 0;
       ts[h].callback = NULL;
       ts[h].cmd_callback = NULL;
+      ts[h].shard_count = 0;
     }
   }
   return true;
 }
 int btsock_thread_create(btsock_signaled_cb callback,
                          btsock_cmd_cb cmd_callback) {
+  return btsock_thread_create_sharded(callback, cmd_callback, 1);
+}
+int btsock_thread_create_sharded(btsock_signaled_cb callback,
+                                 btsock_cmd_cb cmd_callback,
+                                 int thread_count) {
   asrt(callback || cmd_callback);
-  int h = alloc_thread_slot();
-  APPL_TRACE_DEBUG("alloc_thread_slot ret:%d", h);
-  if (h >= 0) {
-    init_poll(h);
-    pthread_t thread;
-    int status = create_thread(sock_poll_thread, (void*)(uintptr_t)h, &thread);
-    if (status) {
-      APPL_TRACE_ERROR("create_thread failed: %s", strerror(status));
-      free_thread_slot(h);
-      return -1;
-    }
-
-    ts[h].thread_id = thread;
-    APPL_TRACE_DEBUG("h:%d, thread id:%d", h, ts[h].thread_id);
-    ts[h].callback = callback;
-    ts[h].cmd_callback = cmd_callback;
+  if (thread_count < 1) thread_count = 1;
+  if (thread_count > MAX_THREAD) thread_count = MAX_THREAD;
+
+  int shards[MAX_THREAD];
+  int created = 0;
+  for (; created < thread_count; created++) {
+    int h = alloc_thread_slot();
+    APPL_TRACE_DEBUG("alloc_thread_slot ret:%d", h);
+    if (h < 0) break;
+    if (create_poll_thread(h, callback, cmd_callback) != 0) break;
+    shards[created] = h;
   }
+
+  if (created == 0) return -1;
+  if (created < thread_count)
+    APPL_TRACE_WARNING("%s: only %d of %d socket threads created", __func__,
+                       created, thread_count);
+
+  int h = shards[0];
+  ts[h].shard_count = created;
+  memcpy(ts[h].shards, shards, created * sizeof(shards[0]));
   return h;
 }
+static int create_poll_thread(int h, btsock_signaled_cb callback,
+                              btsock_cmd_cb cmd_callback) {
+  if (!init_poll(h)) {
+    free_thread_slot(h);
+    return -1;
+  }
+  ts[h].callback = callback;
+  ts[h].cmd_callback = cmd_callback;
+
+  pthread_t thread;
+  int status = create_thread(sock_poll_thread, (void*)(uintptr_t)h, &thread);
+  if (status) {
+    APPL_TRACE_ERROR("create_thread failed: %s", strerror(status));
+    free_thread_slot(h);
+    return -1;
+  }
+
+  ts[h].thread_id = thread;
+  APPL_TRACE_DEBUG("h:%d, thread id:%d", h, ts[h].thread_id);
+  return 0;
+}
+
+static inline bool epoll_add_control_fd(int h, int fd, uint32_t slot) {
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  event.data.u64 = slot;
+  if (epoll_ctl(ts[h].epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+    APPL_TRACE_ERROR("epoll_ctl add fd:%d failed: %s", fd, strerror(errno));
+    return false;
+  }
+  return true;
+}
 
-/* create dummy socket pair used to wake up select loop */
-static inline void init_cmd_fd(int h) {
+/* create the epoll instance, its wakeup eventfd and the command socket pair */
+static inline bool init_cmd_fd(int h) {
   asrt(ts[h].cmd_fdr == -1 && ts[h].cmd_fdw == -1);
+  ts[h].epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (ts[h].epoll_fd < 0) {
+    APPL_TRACE_ERROR("epoll_create1 failed: %s", strerror(errno));
+    return false;
+  }
+  ts[h].wakeup_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (ts[h].wakeup_fd < 0) {
+    APPL_TRACE_ERROR("eventfd failed: %s", strerror(errno));
+    return false;
+  }
   if (socketpair(AF_UNIX, SOCK_STREAM, 0, &ts[h].cmd_fdr) < 0) {
     APPL_TRACE_ERROR("socketpair failed: %s", strerror(errno));
-    return;
+    return false;
   }
-  APPL_TRACE_DEBUG("h:%d, cmd_fdr:%d, cmd_fdw:%d", h, ts[h].cmd_fdr,
-                   ts[h].cmd_fdw);
-  // add the cmd fd for read & write
-  add_poll(h, ts[h].cmd_fdr, 0, SOCK_THREAD_FD_RD, 0);
+  APPL_TRACE_DEBUG("h:%d, epoll_fd:%d, cmd_fdr:%d, cmd_fdw:%d", h,
+                   ts[h].epoll_fd, ts[h].cmd_fdr, ts[h].cmd_fdw);
+  return epoll_add_control_fd(h, ts[h].wakeup_fd, WAKEUP_SLOT) &&
+         epoll_add_control_fd(h, ts[h].cmd_fdr, CMD_SLOT);
 }
 static inline void close_cmd_fd(int h) {
-  if (ts[h].cmd_fdr != -1) {
-    close(ts[h].cmd_fdr);
-    ts[h].cmd_fdr = -1;
-  }
-  if (ts[h].cmd_fdw != -1) {
-    close(ts[h].cmd_fdw);
-    ts[h].cmd_fdw = -1;
+  int* fds[] = {&ts[h].cmd_fdr, &ts[h].cmd_fdw, &ts[h].wakeup_fd,
+                &ts[h].epoll_fd};
+  for (int* fd : fds) {
+    if (*fd != -1) {
+      close(*fd);
+      *fd = -1;
+    }
   }
 }
+static inline bool wakeup_poll_thread(int h) {
+  uint64_t value = 1;
+  ssize_t ret;
+  OSI_NO_INTR(ret = write(ts[h].wakeup_fd, &value, sizeof(value)));
+  return ret == sizeof(value);
+}
 typedef struct {
   int id;
   int fd;
@@ -224,29 +314,20 @@ int btsock_thread_add_fd(int h, int fd, int type, int flags, uint32_t user_id) {
     APPL_TRACE_ERROR("invalid bt thread handle:%d", h);
     return false;
   }
-  if (ts[h].cmd_fdw == -1) {
+  if (ts[h].epoll_fd == -1) {
     APPL_TRACE_ERROR(
-        "cmd socket is not created. socket thread may not initialized");
+        "epoll fd is not created. socket thread may not initialized");
     return false;
   }
-  if (flags & SOCK_THREAD_ADD_FD_SYNC) {
-    // must executed in socket poll thread
-    if (ts[h].thread_id == pthread_self()) {
-      // cleanup one-time flags
-      flags &= ~SOCK_THREAD_ADD_FD_SYNC;
-      add_poll(h, fd, type, flags, user_id);
-      return true;
-    }
-    APPL_TRACE_DEBUG(
-        "THREAD_ADD_FD_SYNC is not called in poll thread, fallback to async");
-  }
-  sock_cmd_t cmd = {CMD_ADD_FD, fd, type, flags, user_id};
+  // The registration is applied right away from any thread, the flag is only
+  // kept for the callers.
+  flags &= ~SOCK_THREAD_ADD_FD_SYNC;
   APPL_TRACE_DEBUG("adding fd:%d, flags:0x%x", fd, flags);
 
-  ssize_t ret;
-  OSI_NO_INTR(ret = send(ts[h].cmd_fdw, &cmd, sizeof(cmd), 0));
-
-  return ret == sizeof(cmd);
+  int shard = shard_of(h, fd);
+  std::unique_lock<std::mutex> lock(ts[shard].lock);
+  add_poll_locked(shard, fd, type, flags, user_id);
+  return true;
 }
 
 bool btsock_thread_remove_fd_and_close(int thread_handle, int fd) {
@@ -259,12 +340,12 @@ bool btsock_thread_remove_fd_and_close(int thread_handle, int fd) {
     return false;
   }
 
-  sock_cmd_t cmd = {CMD_REMOVE_FD, fd, 0, 0, 0};
-
-  ssize_t ret;
-  OSI_NO_INTR(ret = send(ts[thread_handle].cmd_fdw, &cmd, sizeof(cmd), 0));
-
-  return ret == sizeof(cmd);
+  int shard = shard_of(thread_handle, fd);
+  {
+    std::unique_lock<std::mutex> lock(ts[shard].lock);
+    ts[shard].pending_removals.push_back(fd);
+  }
+  return wakeup_poll_thread(shard);
 }
 
 int btsock_thread_post_cmd(int h, int type, const unsigned char* data, int size,
@@ -305,64 +386,80 @@ int btsock_thread_wakeup(int h) {
     APPL_TRACE_ERROR("invalid bt thread handle:%d", h);
     return false;
   }
-  if (ts[h].cmd_fdw == -1) {
-    APPL_TRACE_ERROR("thread handle:%d, cmd socket is not created", h);
+  if (ts[h].wakeup_fd == -1) {
+    APPL_TRACE_ERROR("thread handle:%d, wakeup fd is not created", h);
     return false;
   }
-  sock_cmd_t cmd = {CMD_WAKEUP, 0, 0, 0, 0};
-
-  ssize_t ret;
-  OSI_NO_INTR(ret = send(ts[h].cmd_fdw, &cmd, sizeof(cmd), 0));
+  int shard_count = ts[h].shard_count > 1 ? ts[h].shard_count : 1;
+  bool woken = true;
+  for (int i = 0; i < shard_count; i++) {
+    int shard = shard_count > 1 ? ts[h].shards[i] : h;
+    woken &= wakeup_poll_thread(shard);
+  }
+  return woken;
+}
+static bool exit_poll_thread(int h) {
+  {
+    std::unique_lock<std::mutex> lock(ts[h].lock);
+    ts[h].exit_requested = true;
+  }
+  if (!wakeup_poll_thread(h)) return false;
 
-  return ret == sizeof(cmd);
+  if (ts[h].thread_id != -1) {
+    pthread_join(ts[h].thread_id, 0);
+    ts[h].thread_id = -1;
+  }
+  free_thread_slot(h);
+  return true;
 }
 int btsock_thread_exit(int h) {
   if (h < 0 || h >= MAX_THREAD) {
     APPL_TRACE_ERROR("invalid bt thread slot:%d", h);
     return false;
   }
-  if (ts[h].cmd_fdw == -1) {
-    APPL_TRACE_ERROR("cmd socket is not created");
+  if (ts[h].wakeup_fd == -1) {
+    APPL_TRACE_ERROR("wakeup fd is not created");
     return false;
   }
-  sock_cmd_t cmd = {CMD_EXIT, 0, 0, 0, 0};
 
-  ssize_t ret;
-  OSI_NO_INTR(ret = send(ts[h].cmd_fdw, &cmd, sizeof(cmd), 0));
-
-  if (ret == sizeof(cmd)) {
-    if (ts[h].thread_id != -1) {
-      pthread_join(ts[h].thread_id, 0);
-      ts[h].thread_id = -1;
-    }
-    free_thread_slot(h);
-    return true;
+  int shards[MAX_THREAD] = {h};
+  int shard_count = 1;
+  if (ts[h].shard_count > 1) {
+    shard_count = ts[h].shard_count;
+    memcpy(shards, ts[h].shards, shard_count * sizeof(shards[0]));
   }
-  return false;
+
+  bool exited = true;
+  for (int i = 0; i < shard_count; i++) exited &= exit_poll_thread(shards[i]);
+  return exited;
 }
-static void init_poll(int h) {
+static bool init_poll(int h) {
   int i;
   ts[h].poll_count = 0;
   ts[h].thread_id = -1;
   ts[h].callback = NULL;
   ts[h].cmd_callback = NULL;
+  ts[h].exit_requested = false;
+  ts[h].shard_count = 0;
+  ts[h].fd_slot.clear();
+  ts[h].pending_removals.clear();
   for (i = 0; i < MAX_POLL; i++) {
-    ts[h].ps[i].pfd.fd = -1;
-    ts[h].psi[i] = -1;
+    ts[h].ps[i].fd = -1;
   }
-  init_cmd_fd(h);
+  return init_cmd_fd(h);
 }
-static inline unsigned int flags2pevents(int flags) {
-  unsigned int pevents = 0;
-  if (flags & SOCK_THREAD_FD_WR) pevents |= POLLOUT;
-  if (flags & SOCK_THREAD_FD_RD) pevents |= POLLIN;
-  pevents |= POLL_EXCEPTION_EVENTS;
-  return pevents;
+static inline uint32_t flags2events(int flags) {
+  uint32_t events = 0;
+  if (flags & SOCK_THREAD_FD_WR) events |= EPOLLOUT;
+  if (flags & SOCK_THREAD_FD_RD) events |= EPOLLIN;
+  // EPOLLERR and EPOLLHUP are always reported
+  events |= EPOLLRDHUP;
+  return events;
 }
 
 static inline void set_poll(poll_slot_t* ps, int fd, int type, int flags,
                             uint32_t user_id) {
-  ps->pfd.fd = fd;
+  ps->fd = fd;
   ps->user_id = user_id;
   if (ps->type != 0 && ps->type != type)
     APPL_TRACE_ERROR(
@@ -370,46 +467,105 @@ static inline void set_poll(poll_slot_t* ps, int fd, int type, int flags,
         ps->type, type);
   ps->type = type;
   ps->flags = flags;
-  ps->pfd.events = flags2pevents(flags);
-  ps->pfd.revents = 0;
 }
-static inline void add_poll(int h, int fd, int type, int flags,
-                            uint32_t user_id) {
+static inline void epoll_update(int h, int op, int slot) {
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = flags2events(ts[h].ps[slot].flags);
+  event.data.u64 = slot;
+  int fd = ts[h].ps[slot].fd;
+  int ret = epoll_ctl(ts[h].epoll_fd, op, fd, &event);
+  // The fd number may have been closed and reused behind our back
+  if (ret < 0 && op == EPOLL_CTL_MOD && errno == ENOENT)
+    ret = epoll_ctl(ts[h].epoll_fd, EPOLL_CTL_ADD, fd, &event);
+  else if (ret < 0 && op == EPOLL_CTL_ADD && errno == EEXIST)
+    ret = epoll_ctl(ts[h].epoll_fd, EPOLL_CTL_MOD, fd, &event);
+  if (ret < 0)
+    APPL_TRACE_ERROR("epoll_ctl op:%d fd:%d failed: %s", op, fd,
+                     strerror(errno));
+}
+/* Frees the slots of fds which were closed without being removed */
+static void reclaim_closed_slots_locked(int h) {
+  for (int i = 0; i < MAX_POLL; i++) {
+    poll_slot_t* ps = &ts[h].ps[i];
+    if (ps->fd != -1 && fcntl(ps->fd, F_GETFD) < 0 && errno == EBADF) {
+      APPL_TRACE_WARNING("%s: fd:%d was closed while monitored", __func__,
+                         ps->fd);
+      ts[h].fd_slot.erase(ps->fd);
+      --ts[h].poll_count;
+      memset(ps, 0, sizeof(*ps));
+      ps->fd = -1;
+    }
+  }
+}
+static inline void add_poll_locked(int h, int fd, int type, int flags,
+                                   uint32_t user_id) {
   asrt(fd != -1);
-  int i;
-  int empty = -1;
   poll_slot_t* ps = ts[h].ps;
 
-  for (i = 0; i < MAX_POLL; i++) {
-    if (ps[i].pfd.fd == fd) {
+  auto it = ts[h].fd_slot.find(fd);
+  if (it != ts[h].fd_slot.end()) {
+    poll_slot_t* slot = &ps[it->second];
+    // A different owner means the old fd was closed and its number reused
+    if (slot->user_id != user_id || slot->type != type) {
+      slot->type = 0;
+      slot->flags = 0;
+    }
+    set_poll(slot, fd, type, flags | slot->flags, user_id);
+    epoll_update(h, EPOLL_CTL_MOD, it->second);
+    return;
+  }
+  if (ts[h].poll_count >= MAX_POLL) reclaim_closed_slots_locked(h);
+  for (int i = 0; i < MAX_POLL; i++) {
+    if (ps[i].fd == -1) {
       asrt(ts[h].poll_count < MAX_POLL);
-
-      set_poll(&ps[i], fd, type, flags | ps[i].flags, user_id);
+      set_poll(&ps[i], fd, type, flags, user_id);
+      ts[h].fd_slot[fd] = i;
+      ++ts[h].poll_count;
+      epoll_update(h, EPOLL_CTL_ADD, i);
       return;
-    } else if (empty < 0 && ps[i].pfd.fd == -1)
-      empty = i;
-  }
-  if (empty >= 0) {
-    asrt(ts[h].poll_count < MAX_POLL);
-    set_poll(&ps[empty], fd, type, flags, user_id);
-    ++ts[h].poll_count;
-    return;
+    }
   }
   APPL_TRACE_ERROR("exceeded max poll slot:%d!", MAX_POLL);
 }
-static inline void remove_poll(int h, poll_slot_t* ps, int flags) {
+static inline void remove_poll_locked(int h, int slot, int flags) {
+  poll_slot_t* ps = &ts[h].ps[slot];
   if (flags == ps->flags) {
     // all monitored events signaled. To remove it, just clear the slot
+    if (epoll_ctl(ts[h].epoll_fd, EPOLL_CTL_DEL, ps->fd, NULL) < 0)
+      APPL_TRACE_DEBUG("epoll_ctl del fd:%d: %s", ps->fd, strerror(errno));
+    ts[h].fd_slot.erase(ps->fd);
     --ts[h].poll_count;
     memset(ps, 0, sizeof(*ps));
-    ps->pfd.fd = -1;
+    ps->fd = -1;
   } else {
     // one read or one write monitor event signaled, removed the accordding bit
     ps->flags &= ~flags;
     // update the poll events mask
-    ps->pfd.events = flags2pevents(ps->flags);
+    epoll_update(h, EPOLL_CTL_MOD, slot);
   }
 }
+/* Applies the queued removals, returns false once the thread should exit */
+static bool process_wakeup(int h) {
+  uint64_t value;
+  ssize_t ret;
+  OSI_NO_INTR(ret = read(ts[h].wakeup_fd, &value, sizeof(value)));
+
+  std::vector<int> removals;
+  bool exit_requested;
+  {
+    std::unique_lock<std::mutex> lock(ts[h].lock);
+    removals.swap(ts[h].pending_removals);
+    for (int fd : removals) {
+      auto it = ts[h].fd_slot.find(fd);
+      if (it != ts[h].fd_slot.end())
+        remove_poll_locked(h, it->second, ts[h].ps[it->second].flags);
+    }
+    exit_requested = ts[h].exit_requested;
+  }
+  for (int fd : removals) close(fd);
+  return !exit_requested;
+}
 static int process_cmd_sock(int h) {
   sock_cmd_t cmd = {-1, 0, 0, 0, 0};
   int fd = ts[h].cmd_fdr;
@@ -423,28 +579,11 @@ static int process_cmd_sock(int h) {
   }
   APPL_TRACE_DEBUG("cmd.id:%d", cmd.id);
   switch (cmd.id) {
-    case CMD_ADD_FD:
-      add_poll(h, cmd.fd, cmd.type, cmd.flags, cmd.user_id);
-      break;
-    case CMD_REMOVE_FD:
-      for (int i = 1; i < MAX_POLL; ++i) {
-        poll_slot_t* poll_slot = &ts[h].ps[i];
-        if (poll_slot->pfd.fd == cmd.fd) {
-          remove_poll(h, poll_slot, poll_slot->flags);
-          break;
-        }
-      }
-      close(cmd.fd);
-      break;
-    case CMD_WAKEUP:
-      break;
     case CMD_USER_PRIVATE:
       asrt(ts[h].cmd_callback);
       if (ts[h].cmd_callback)
         ts[h].cmd_callback(fd, cmd.type, cmd.flags, cmd.user_id);
       break;
-    case CMD_EXIT:
-      return false;
     default:
       APPL_TRACE_DEBUG("unknown cmd: %d", cmd.id);
       break;
@@ -452,107 +591,83 @@ static int process_cmd_sock(int h) {
   return true;
 }
 
-static void print_events(short events) {
+static void print_events(uint32_t events) {
   std::string flags("");
-  if ((events)&POLLIN) flags += " POLLIN";
-  if ((events)&POLLPRI) flags += " POLLPRI";
-  if ((events)&POLLOUT) flags += " POLLOUT";
-  if ((events)&POLLERR) flags += " POLLERR";
-  if ((events)&POLLHUP) flags += " POLLHUP ";
-  if ((events)&POLLNVAL) flags += " POLLNVAL";
-  if ((events)&POLLRDHUP) flags += " POLLRDHUP";
+  if ((events)&EPOLLIN) flags += " EPOLLIN";
+  if ((events)&EPOLLPRI) flags += " EPOLLPRI";
+  if ((events)&EPOLLOUT) flags += " EPOLLOUT";
+  if ((events)&EPOLLERR) flags += " EPOLLERR";
+  if ((events)&EPOLLHUP) flags += " EPOLLHUP ";
+  if ((events)&EPOLLRDHUP) flags += " EPOLLRDHUP";
   APPL_TRACE_DEBUG("print poll event:%x = %s", (events), flags.c_str());
 }
 
-static void process_data_sock(int h, struct pollfd* pfds, int count) {
-  asrt(count <= ts[h].poll_count);
-  int i;
-  for (i = 1; i < ts[h].poll_count; i++) {
-    if (pfds[i].revents) {
-      int ps_i = ts[h].psi[i];
-      if(ts[h].ps[ps_i].pfd.fd <= 0) {
-        APPL_TRACE_ERROR("%s: Socket fd is not open", __FUNCTION__);
-        return;
-      }
-      asrt(pfds[i].fd == ts[h].ps[ps_i].pfd.fd);
-      uint32_t user_id = ts[h].ps[ps_i].user_id;
-      int type = ts[h].ps[ps_i].type;
-      int flags = 0;
-      print_events(pfds[i].revents);
-      if (IS_READ(pfds[i].revents)) {
-        flags |= SOCK_THREAD_FD_RD;
-      }
-      if (IS_WRITE(pfds[i].revents)) {
-        flags |= SOCK_THREAD_FD_WR;
-      }
-      if (IS_EXCEPTION(pfds[i].revents)) {
-        flags |= SOCK_THREAD_FD_EXCEPTION;
-        // remove the whole slot not flags
-        remove_poll(h, &ts[h].ps[ps_i], ts[h].ps[ps_i].flags);
-      } else if (flags)
-        remove_poll(h, &ts[h].ps[ps_i],
-                    flags);  // remove the monitor flags that already processed
-      if (flags) ts[h].callback(pfds[i].fd, type, flags, user_id);
-    }
-  }
-}
-
-static void prepare_poll_fds(int h, struct pollfd* pfds) {
-  int count = 0;
-  int ps_i = 0;
-  int pfd_i = 0;
-  asrt(ts[h].poll_count <= MAX_POLL);
-  memset(pfds, 0, sizeof(pfds[0]) * ts[h].poll_count);
-  while (count < ts[h].poll_count) {
-    if (ps_i >= MAX_POLL) {
-      APPL_TRACE_ERROR(
-          "exceed max poll range, ps_i:%d, MAX_POLL:%d, count:%d, "
-          "ts[h].poll_count:%d",
-          ps_i, MAX_POLL, count, ts[h].poll_count);
+static void process_data_sock(int h, int slot, uint32_t events) {
+  int fd, type, flags = 0;
+  uint32_t user_id;
+  {
+    std::unique_lock<std::mutex> lock(ts[h].lock);
+    poll_slot_t* ps = &ts[h].ps[slot];
+    if (ps->fd < 0) {
+      APPL_TRACE_ERROR("%s: Socket fd is not open", __func__);
       return;
     }
-    if (ts[h].ps[ps_i].pfd.fd >= 0 && pfd_i < MAX_POLL) {
-      pfds[pfd_i] = ts[h].ps[ps_i].pfd;
-      ts[h].psi[pfd_i] = ps_i;
-      count++;
-      pfd_i++;
+    fd = ps->fd;
+    user_id = ps->user_id;
+    type = ps->type;
+    print_events(events);
+    if (IS_READ(events)) {
+      flags |= SOCK_THREAD_FD_RD;
+    }
+    if (IS_WRITE(events)) {
+      flags |= SOCK_THREAD_FD_WR;
+    }
+    if (IS_EXCEPTION(events)) {
+      flags |= SOCK_THREAD_FD_EXCEPTION;
+      // remove the whole slot not flags
+      remove_poll_locked(h, slot, ps->flags);
+    } else if (flags) {
+      // remove the monitor flags that already processed
+      remove_poll_locked(h, slot, flags);
     }
-    ps_i++;
   }
+  if (flags) ts[h].callback(fd, type, flags, user_id);
 }
+
 static void* sock_poll_thread(void* arg) {
-  struct pollfd pfds[MAX_POLL];
-  memset(pfds, 0, sizeof(pfds));
+  struct epoll_event events[MAX_EPOLL_EVENTS];
   int h = (intptr_t)arg;
 
   prctl(PR_SET_NAME, (unsigned long)"btif_sock_poll", 0, 0, 0);
   for (;;) {
-    prepare_poll_fds(h, pfds);
     int ret;
-    OSI_NO_INTR(ret = poll(pfds, ts[h].poll_count, -1));
+    OSI_NO_INTR(ret = epoll_wait(ts[h].epoll_fd, events, MAX_EPOLL_EVENTS, -1));
     if (ret == -1) {
-      APPL_TRACE_ERROR("poll ret -1, exit the thread, errno:%d, err:%s", errno,
-                       strerror(errno));
+      APPL_TRACE_ERROR("epoll_wait ret -1, exit the thread, errno:%d, err:%s",
+                       errno, strerror(errno));
+      break;
+    }
+
+    // The data fds are served first, so that removals applied by the control
+    // fds cannot free a slot that still has an event in this batch.
+    bool wakeup = false, cmd = false;
+    for (int i = 0; i < ret; i++) {
+      uint32_t slot = (uint32_t)events[i].data.u64;
+      if (slot == WAKEUP_SLOT)
+        wakeup = true;
+      else if (slot == CMD_SLOT)
+        cmd = true;
+      else if (slot < MAX_POLL)
+        process_data_sock(h, slot, events[i].events);
+    }
+    if (cmd && !process_cmd_sock(h)) {
+      APPL_TRACE_DEBUG("h:%d, process_cmd_sock return false, exit...", h);
+      break;
+    }
+    if (wakeup && !process_wakeup(h)) {
+      APPL_TRACE_DEBUG("h:%d, exit requested, exit...", h);
       break;
     }
-    if (ret != 0) {
-      int need_process_data_fd = true;
-      if (pfds[0].revents)  // cmd fd always is the first one
-      {
-        asrt(pfds[0].fd == ts[h].cmd_fdr);
-        if (!process_cmd_sock(h)) {
-          APPL_TRACE_DEBUG("h:%d, process_cmd_sock return false, exit...", h);
-          break;
-        }
-        if (ret == 1)
-          need_process_data_fd = false;
-        else
-          ret--;  // exclude the cmd fd
-      }
-      if (need_process_data_fd) process_data_sock(h, pfds, ret);
-    } else {
-      APPL_TRACE_DEBUG("no data, select ret: %d", ret)
-    };
   }
   APPL_TRACE_DEBUG("socket poll thread exiting, h:%d", h);
   return 0;
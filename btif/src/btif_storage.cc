@@ -50,6 +50,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <mutex>
+#include <set>
 
 #include "bt_common.h"
 #include "bta_closure_api.h"
@@ -67,6 +69,7 @@
 #include "osi/include/config.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
 #include <inttypes.h>
 #include "stack/gatt/gatt_int.h"
 #include "stack/gatt/eatt_int.h"
@@ -92,6 +95,8 @@ using bluetooth::Uuid;
 #define BTIF_STORAGE_PATH_REMOTE_VER_MFCT "Manufacturer"
 #define BTIF_STORAGE_PATH_REMOTE_VER_VER "LmpVer"
 #define BTIF_STORAGE_PATH_REMOTE_VER_SUBVER "LmpSubVer"
+#define BTIF_STORAGE_PATH_REMOTE_FEATURES "RemoteFeatures"
+#define BTIF_STORAGE_PATH_REMOTE_FEATURES_TIME "RemoteFeaturesTime"
 #define BTIF_STORAGE_PATH_REMOTE_VALID_ADDR "ValidAddr"
 #define BTIF_STORAGE_PATH_REMOTE_MAPPING_ADDR "MapAddr"
 #define BTIF_STORAGE_PATH_REMOTE_ADV_AUDIO "IsAdvAudio"
@@ -113,6 +118,14 @@ using bluetooth::Uuid;
 #define BTIF_STORAGE_KEY_SVC_CHG_CCCD "ServiceChangedCCCD"
 #define BTIF_STORAGE_KEY_ENCR_DATA_CCCD "EncryptedDataKeyCCCD"
 
+/* When set, the link keys of BR/EDR-only bonded devices are given to BTM on
+ * first use instead of at startup */
+#define BTIF_STORAGE_LAZY_BONDED_LOAD_PROPERTY \
+  "persist.vendor.bt.lazy_bonded_load"
+
+/* Stored remote features older than this are read from the device again */
+#define BTIF_STORAGE_REMOTE_FEATURES_MAX_AGE_S (7 * 24 * 60 * 60)
+
 /* This is a local property to add a device found */
 #define BT_PROPERTY_REMOTE_DEVICE_TIMESTAMP 0xFF
 
@@ -208,6 +221,11 @@ bt_status_t btif_storage_find_ble_bonding_key(RawAddress* remote_bd_addr,
 bool btif_has_ble_keys(const std::string& bdstr);
 
 static bool prop_upd(const RawAddress* remote_bd_addr, bt_property_t *prop);
+
+/* Bonded devices whose link key is not in BTM yet, in lazy loading mode */
+static std::mutex lazy_bonded_devices_lock;
+static std::set<RawAddress> lazy_bonded_devices;
+static bool lazy_bonded_load_enabled = false;
 /*******************************************************************************
  *  Static functions
  ******************************************************************************/
@@ -637,7 +655,13 @@ static bt_status_t btif_in_fetch_bonded_devices(
     if (btif_config_get_bin(name, "LinkKey", link_key.data(), &size)) {
       int linkkey_type;
       if (btif_config_get_int(name, "LinkKeyType", &linkkey_type)) {
-        if (add) {
+        if (add && lazy_bonded_load_enabled && !btif_has_ble_keys(name)) {
+          // Given to BTM by btif_in_load_lazy_bonded_device on first use.
+          // LE devices are still loaded here, their identity keys are needed
+          // to resolve their addresses.
+          std::lock_guard<std::mutex> lock(lazy_bonded_devices_lock);
+          lazy_bonded_devices.insert(bd_addr);
+        } else if (add) {
           DEV_CLASS dev_class = {0, 0, 0};
           int cod;
           int pin_length = 0;
@@ -646,6 +670,8 @@ static bt_status_t btif_in_fetch_bonded_devices(
           btif_config_get_int(name, "PinLength", &pin_length);
           BTA_DmAddDevice(bd_addr, dev_class, link_key, 0, 0,
                           (uint8_t)linkkey_type, 0, pin_length);
+        }
+        if (add) {
 
           if (btif_config_get_int(name, "DevType", &device_type) &&
               (device_type == BT_DEVICE_TYPE_DUMO)) {
@@ -670,6 +696,137 @@ static bt_status_t btif_in_fetch_bonded_devices(
   return BT_STATUS_SUCCESS;
 }
 
+/*******************************************************************************
+ *
+ * Function         btif_in_load_lazy_bonded_device
+ *
+ * Description      BTM device loader. Adds the link key of |bd_addr| to BTM
+ *                  if it is a bonded device which was skipped at startup.
+ *                  Runs in the stack thread, from the BTM device lookup.
+ *
+ * Returns          true if the device was added to BTM
+ *
+ ******************************************************************************/
+static bool btif_in_load_lazy_bonded_device(const RawAddress& bd_addr) {
+  {
+    std::lock_guard<std::mutex> lock(lazy_bonded_devices_lock);
+    if (lazy_bonded_devices.erase(bd_addr) == 0) return false;
+  }
+
+  auto name = bd_addr.ToString();
+  LinkKey link_key;
+  size_t size = link_key.size();
+  int linkkey_type;
+  if (!btif_config_get_bin(name, "LinkKey", link_key.data(), &size) ||
+      !btif_config_get_int(name, "LinkKeyType", &linkkey_type))
+    return false;
+
+  DEV_CLASS dev_class = {0, 0, 0};
+  int cod;
+  int pin_length = 0;
+  if (btif_config_get_int(name, "DevClass", &cod))
+    uint2devclass((uint32_t)cod, dev_class);
+  btif_config_get_int(name, "PinLength", &pin_length);
+
+  // Same as BTA_DmAddDevice, without the trip through the BTA queue
+  BD_NAME bd_name = {0};
+  uint8_t features[HCI_FEATURE_BYTES_PER_PAGE * (HCI_EXT_FEATURES_PAGE_MAX + 1)] =
+      {0};
+  uint32_t trusted_mask[BTM_SEC_SERVICE_ARRAY_SIZE] = {0};
+  BTIF_TRACE_DEBUG("%s: restoring %s", __func__, name.c_str());
+  return BTM_SecAddDevice(bd_addr, dev_class, bd_name, features,
+                          trusted_mask, &link_key, (uint8_t)linkkey_type, 0,
+                          (uint8_t)pin_length);
+}
+
+/*******************************************************************************
+ *
+ * Function         btif_in_load_conn_profile
+ *
+ * Description      BTM connection profile loader. Restores the remote version
+ *                  and, if they were read recently enough, the remote features
+ *                  of a bonded device, so that its connection does not read
+ *                  them again. Runs in the stack thread.
+ *
+ * Returns          true if |p_profile| was filled
+ *
+ ******************************************************************************/
+static bool btif_in_load_conn_profile(const RawAddress& bd_addr,
+                                      tBTM_CONN_PROFILE* p_profile) {
+  auto name = bd_addr.ToString();
+  if (!btif_config_exist(name, "LinkKey")) return false;
+
+  int read_time;
+  int64_t now = time(NULL);
+  size_t size = sizeof(p_profile->feature_pages);
+  if (btif_config_get_int(name, BTIF_STORAGE_PATH_REMOTE_FEATURES_TIME,
+                          &read_time) &&
+      read_time <= now &&
+      now - read_time <= BTIF_STORAGE_REMOTE_FEATURES_MAX_AGE_S &&
+      btif_config_get_bin(name, BTIF_STORAGE_PATH_REMOTE_FEATURES,
+                          &p_profile->feature_pages[0][0], &size) &&
+      size > 0 && size % BTM_FEATURE_BYTES_PER_PAGE == 0) {
+    p_profile->num_read_pages = size / BTM_FEATURE_BYTES_PER_PAGE;
+  }
+
+  int lmp_version, manufacturer, lmp_subversion;
+  if (btif_config_get_int(name, BTIF_STORAGE_PATH_REMOTE_VER_VER,
+                          &lmp_version) &&
+      btif_config_get_int(name, BTIF_STORAGE_PATH_REMOTE_VER_MFCT,
+                          &manufacturer) &&
+      btif_config_get_int(name, BTIF_STORAGE_PATH_REMOTE_VER_SUBVER,
+                          &lmp_subversion)) {
+    p_profile->version_known = true;
+    p_profile->lmp_version = lmp_version;
+    p_profile->manufacturer = manufacturer;
+    p_profile->lmp_subversion = lmp_subversion;
+  }
+
+  return p_profile->num_read_pages || p_profile->version_known;
+}
+
+/*******************************************************************************
+ *
+ * Function         btif_storage_update_conn_profile
+ *
+ * Description      BTIF storage API - Stores the remote features of a bonded
+ *                  device once its connection is up, for
+ *                  btif_in_load_conn_profile. The read time is only updated
+ *                  when the stored features are missing, stale or different.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btif_storage_update_conn_profile(const RawAddress& bd_addr) {
+  auto name = bd_addr.ToString();
+  if (!btif_config_exist(name, "LinkKey")) return;
+
+  tBTM_CONN_PROFILE profile;
+  if (!BTM_SecReadConnProfile(bd_addr, &profile) ||
+      profile.num_read_pages == 0)
+    return;
+
+  size_t length = profile.num_read_pages * BTM_FEATURE_BYTES_PER_PAGE;
+  uint8_t stored[sizeof(profile.feature_pages)];
+  size_t stored_length = sizeof(stored);
+  int read_time;
+  int64_t now = time(NULL);
+  if (btif_config_get_bin(name, BTIF_STORAGE_PATH_REMOTE_FEATURES, stored,
+                          &stored_length) &&
+      stored_length == length &&
+      !memcmp(stored, &profile.feature_pages[0][0], length) &&
+      btif_config_get_int(name, BTIF_STORAGE_PATH_REMOTE_FEATURES_TIME,
+                          &read_time) &&
+      read_time <= now &&
+      now - read_time <= BTIF_STORAGE_REMOTE_FEATURES_MAX_AGE_S)
+    return;
+
+  btif_config_set_bin(name, BTIF_STORAGE_PATH_REMOTE_FEATURES,
+                      &profile.feature_pages[0][0], length);
+  btif_config_set_int(name, BTIF_STORAGE_PATH_REMOTE_FEATURES_TIME, (int)now);
+  btif_config_save();
+}
+
 static void btif_find_le_key(const uint8_t key_type,
                              RawAddress bd_addr, const uint8_t addr_type,
                              bool* device_added, bool* key_found) {
@@ -1046,8 +1203,8 @@ bt_status_t btif_storage_add_bonded_device(RawAddress* remote_bd_addr,
     btif_config_set_int(bdstr, "Restricted", 1);
   }
 
-  /* write bonded info immediately */
-  btif_config_flush();
+  /* committed with the rest of the bond */
+  btif_config_save_bond();
   return ret ? BT_STATUS_SUCCESS : BT_STATUS_FAIL;
 }
 
@@ -1067,6 +1224,11 @@ bt_status_t btif_storage_remove_bonded_device(
   const char* bdstr = addrstr.c_str();
   BTIF_TRACE_DEBUG("in bd addr:%s", bdstr);
 
+  {
+    std::lock_guard<std::mutex> lock(lazy_bonded_devices_lock);
+    lazy_bonded_devices.erase(*remote_bd_addr);
+  }
+
   btif_storage_remove_ble_bonding_keys(remote_bd_addr);
 
   int ret = 1;
@@ -1090,12 +1252,18 @@ bt_status_t btif_storage_remove_bonded_device(
     ret &= btif_config_remove(bdstr, "LmpVer");
   if (btif_config_exist(bdstr, "LmpSubVer"))
     ret &= btif_config_remove(bdstr, "LmpSubVer");
+  if (btif_config_exist(bdstr, BTIF_STORAGE_PATH_REMOTE_FEATURES))
+    ret &= btif_config_remove(bdstr, BTIF_STORAGE_PATH_REMOTE_FEATURES);
+  if (btif_config_exist(bdstr, BTIF_STORAGE_PATH_REMOTE_FEATURES_TIME))
+    ret &= btif_config_remove(bdstr, BTIF_STORAGE_PATH_REMOTE_FEATURES_TIME);
   if (btif_config_exist(bdstr, "Service"))
     ret &= btif_config_remove(bdstr, "Service");
   if (btif_config_exist(bdstr, "A2dpVersion"))
     ret &= btif_config_remove(bdstr, "A2dpVersion");
   if (btif_config_exist(bdstr, "AvdtpVersion"))
     ret &= btif_config_remove(bdstr, "AvdtpVersion");
+  if (btif_config_exist(bdstr, AVDTP_SEP_CACHE_CONFIG_KEY))
+    ret &= btif_config_remove(bdstr, AVDTP_SEP_CACHE_CONFIG_KEY);
   if (btif_config_exist(bdstr, "HfpVersion"))
     ret &= btif_config_remove(bdstr, "HfpVersion");
   if (btif_config_exist(bdstr, "AvrcpTgVersion"))
@@ -1264,7 +1432,24 @@ bt_status_t btif_storage_load_bonded_devices(void) {
 
   remove_devices_with_sample_ltk();
 
+  lazy_bonded_load_enabled =
+      osi_property_get_bool(BTIF_STORAGE_LAZY_BONDED_LOAD_PROPERTY, false);
+  {
+    std::lock_guard<std::mutex> lock(lazy_bonded_devices_lock);
+    lazy_bonded_devices.clear();
+  }
+  do_in_bta_thread(FROM_HERE,
+                   base::Bind(&BTM_SecRegisterDevLoader,
+                              lazy_bonded_load_enabled
+                                  ? &btif_in_load_lazy_bonded_device
+                                  : nullptr));
+  do_in_bta_thread(FROM_HERE, base::Bind(&BTM_SecRegisterConnProfileLoader,
+                                         &btif_in_load_conn_profile));
+
+  // The LE keys go to BTM through the same queue, in between
+  do_in_bta_thread(FROM_HERE, base::Bind(&BTM_BleResolvingListBatch, true));
   btif_in_fetch_bonded_devices(&bonded_devices, 1);
+  do_in_bta_thread(FROM_HERE, base::Bind(&BTM_BleResolvingListBatch, false));
 
   /* Now send the adapter_properties_cb with all adapter_properties */
   {
@@ -1449,7 +1634,7 @@ bt_status_t btif_storage_add_ble_bonding_key(RawAddress* remote_bd_addr,
   }
   int ret = btif_config_set_bin(remote_bd_addr->ToString().c_str(), name, key,
                                 key_length);
-  btif_config_save();
+  btif_config_save_bond();
   return ret ? BT_STATUS_SUCCESS : BT_STATUS_FAIL;
 }
 
@@ -1939,6 +2124,7 @@ bt_status_t btif_storage_remove_hid_info(const RawAddress& remote_bd_addr) {
   btif_config_remove(bdstr, "HidSSRMaxLatency");
   btif_config_remove(bdstr, "HidSSRMinTimeout");
   btif_config_remove(bdstr, "HidDescriptor");
+  btif_config_remove(bdstr, "HidHogpCache");
   btif_config_save();
   return BT_STATUS_SUCCESS;
 }
@@ -24,6 +24,8 @@
  ******************************************************************************/
 #include <mutex>
 
+#include <stdio.h>
+
 #include "bt_common.h"
 #include "btif_uid.h"
 
@@ -32,6 +34,8 @@ std::mutex set_lock;
 typedef struct uid_set_node_t {
   struct uid_set_node_t* next;
   bt_uid_traffic_t data;
+  uint64_t rx_buffered;       // received bytes not read by the app yet
+  uint64_t rx_buffered_peak;  // highest rx_buffered seen
 } uid_set_node_t;
 
 typedef struct uid_set_t {
@@ -88,6 +92,45 @@ void uid_set_add_rx(uid_set_t* set, int32_t app_uid, uint64_t bytes) {
   node->data.rx_bytes += bytes;
 }
 
+void uid_set_add_buffered(uid_set_t* set, int32_t app_uid, int64_t bytes) {
+  if (app_uid == -1 || bytes == 0 || set == NULL) return;
+
+  std::unique_lock<std::mutex> guard(set_lock);
+  uid_set_node_t* node = uid_set_find_or_create_node(set, app_uid);
+  if (bytes < 0 && (uint64_t)-bytes > node->rx_buffered) {
+    node->rx_buffered = 0;
+    return;
+  }
+  node->rx_buffered += bytes;
+  if (node->rx_buffered > node->rx_buffered_peak)
+    node->rx_buffered_peak = node->rx_buffered;
+}
+
+bool uid_set_is_over_budget(uid_set_t* set, int32_t app_uid) {
+  if (app_uid == -1 || set == NULL) return false;
+
+  std::unique_lock<std::mutex> guard(set_lock);
+  uid_set_node_t* node = set->head;
+  while (node && node->data.app_uid != app_uid) {
+    node = node->next;
+  }
+  return node && node->rx_buffered >= BTIF_SOCK_UID_RX_BUDGET;
+}
+
+void uid_set_debug_dump(uid_set_t* set, int fd) {
+  if (set == NULL) return;
+
+  std::unique_lock<std::mutex> guard(set_lock);
+  dprintf(fd, "\nSocket receive buffers per UID (budget %u bytes):\n",
+          (unsigned)BTIF_SOCK_UID_RX_BUDGET);
+  for (uid_set_node_t* node = set->head; node; node = node->next) {
+    if (!node->rx_buffered_peak) continue;
+    dprintf(fd, "  uid:%d buffered:%llu peak:%llu\n", node->data.app_uid,
+            (unsigned long long)node->rx_buffered,
+            (unsigned long long)node->rx_buffered_peak);
+  }
+}
+
 bt_uid_traffic_t* uid_set_read_and_clear(uid_set_t* set) {
   std::unique_lock<std::mutex> guard(set_lock);
 
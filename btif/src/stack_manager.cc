@@ -114,12 +114,17 @@ static void event_init_stack(void* context) {
     module_management_start();
     start_bt_logger();
 
-    module_init(get_module(OSI_MODULE));
-    module_init(get_module(BT_UTILS_MODULE));
+    // None of these depend on each other; loading the config files from
+    // storage dominates, so do it in parallel
+    const module_t* init_modules[] = {
+      get_module(OSI_MODULE),
+      get_module(BT_UTILS_MODULE),
 #if (BT_IOT_LOGGING_ENABLED == TRUE)
-    module_init(get_module(DEVICE_IOT_CONFIG_MODULE));
+      get_module(DEVICE_IOT_CONFIG_MODULE),
 #endif
-    module_init(get_module(BTIF_CONFIG_MODULE));
+      get_module(BTIF_CONFIG_MODULE),
+    };
+    module_init_parallel(init_modules, ARRAY_SIZE(init_modules));
 
     btif_stack_state(StackState::INITIALIZING);
 
@@ -162,12 +167,14 @@ static void event_start_up_stack(UNUSED_ATTR void* context) {
   hack_future = local_hack_future;
 
   // Include this for now to put btif config into a shutdown-able state
-  module_start_up(get_module(BTIF_CONFIG_MODULE));
-
-  btif_stack_state(StackState::TURNING_ON);
+  const module_t* start_up_modules[] = {
+    get_module(BTIF_CONFIG_MODULE),
 #if (BT_IOT_LOGGING_ENABLED == TRUE)
-  module_start_up(get_module(DEVICE_IOT_CONFIG_MODULE));
+    get_module(DEVICE_IOT_CONFIG_MODULE),
 #endif
+  };
+  btif_stack_state(StackState::TURNING_ON);
+  module_start_up_parallel(start_up_modules, ARRAY_SIZE(start_up_modules));
   bte_main_enable();
 
   if (future_await(local_hack_future) != FUTURE_SUCCESS) {
@@ -179,6 +186,7 @@ static void event_start_up_stack(UNUSED_ATTR void* context) {
 
   stack_is_running = true;
   LOG_INFO(LOG_TAG, "%s finished", __func__);
+  module_log_startup_timing();
   btif_thread_post(event_signal_stack_up, NULL);
 }
 
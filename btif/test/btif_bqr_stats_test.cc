@@ -0,0 +1,166 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "btif/include/btif_bqr.h"
+#include "btif/include/btif_bqr_stats.h"
+
+using bluetooth::bqr::LinkQualityBucket;
+using bluetooth::bqr::LinkQualitySample;
+using bluetooth::bqr::LinkQualityStats;
+using bluetooth::bqr::kLinkStatsCodecAny;
+using bluetooth::bqr::kLinkStatsCodecNone;
+using bluetooth::bqr::kLinkStatsCoarseBucketMs;
+using bluetooth::bqr::kLinkStatsFineBucketMs;
+using bluetooth::bqr::kLinkStatsMaxLinks;
+
+namespace {
+
+const RawAddress kDevice({0x00, 0x11, 0x22, 0x33, 0x44, 0x55});
+// A day into the clock, so nothing starts at zero
+const uint64_t kStartMs = 24 * kLinkStatsCoarseBucketMs;
+
+struct Exported {
+  RawAddress bda;
+  int16_t codec;
+  LinkQualityBucket bucket;
+};
+
+LinkQualitySample MakeSample(int8_t rssi, uint32_t retransmissions,
+                             uint8_t report_id = 0x01) {
+  LinkQualitySample sample;
+  sample.quality_report_id = report_id;
+  sample.rssi = rssi;
+  sample.snr = 20;
+  sample.retransmission_count = retransmissions;
+  return sample;
+}
+
+class BqrStatsTest : public ::testing::Test {
+ protected:
+  BqrStatsTest()
+      : stats_([this](const RawAddress& bda, int16_t codec,
+                      const LinkQualityBucket& bucket) {
+          exported_.push_back({bda, codec, bucket});
+        }) {}
+
+  std::vector<Exported> exported_;
+  LinkQualityStats stats_;
+};
+
+}  // namespace
+
+TEST_F(BqrStatsTest, test_summary_aggregates_reports) {
+  stats_.AddSample(kDevice, kLinkStatsCodecNone, MakeSample(-60, 3), kStartMs);
+  stats_.AddSample(kDevice, kLinkStatsCodecNone, MakeSample(-80, 5, 0x03),
+                   kStartMs + 1000);
+
+  LinkQualityBucket summary;
+  ASSERT_TRUE(stats_.GetSummary(kDevice, kLinkStatsCodecAny, kStartMs,
+                                kStartMs + 1000, &summary));
+  EXPECT_EQ(2u, summary.report_count);
+  EXPECT_EQ(1u, summary.a2dp_choppy_count);
+  EXPECT_EQ(-70, summary.AverageRssi());
+  EXPECT_EQ(-80, summary.rssi_min);
+  EXPECT_EQ(-60, summary.rssi_max);
+  EXPECT_EQ(8u, summary.retransmission_count);
+
+  RawAddress other({0x66, 0x55, 0x44, 0x33, 0x22, 0x11});
+  EXPECT_FALSE(stats_.GetSummary(other, kLinkStatsCodecAny, kStartMs,
+                                 kStartMs + 1000, &summary));
+}
+
+TEST_F(BqrStatsTest, test_summary_filters_codec_and_window) {
+  stats_.AddSample(kDevice, 0, MakeSample(-60, 1), kStartMs);
+  stats_.AddSample(kDevice, 1, MakeSample(-60, 2),
+                   kStartMs + 2 * kLinkStatsFineBucketMs);
+
+  LinkQualityBucket summary;
+  uint64_t now = kStartMs + 2 * kLinkStatsFineBucketMs;
+  ASSERT_TRUE(stats_.GetSummary(kDevice, 1, kStartMs, now, &summary));
+  EXPECT_EQ(2u, summary.retransmission_count);
+  ASSERT_TRUE(
+      stats_.GetSummary(kDevice, kLinkStatsCodecAny, kStartMs, now, &summary));
+  EXPECT_EQ(3u, summary.retransmission_count);
+  // The first report is older than the window
+  ASSERT_TRUE(stats_.GetSummary(kDevice, kLinkStatsCodecAny,
+                                kStartMs + kLinkStatsFineBucketMs, now,
+                                &summary));
+  EXPECT_EQ(2u, summary.retransmission_count);
+}
+
+TEST_F(BqrStatsTest, test_old_reports_only_kept_hourly) {
+  stats_.AddSample(kDevice, kLinkStatsCodecNone, MakeSample(-60, 4), kStartMs);
+  uint64_t now = kStartMs + 3 * kLinkStatsCoarseBucketMs;
+  stats_.AddSample(kDevice, kLinkStatsCodecNone, MakeSample(-60, 1), now);
+
+  LinkQualityBucket summary;
+  ASSERT_TRUE(stats_.GetSummary(kDevice, kLinkStatsCodecAny,
+                                now - 4 * kLinkStatsCoarseBucketMs, now,
+                                &summary));
+  EXPECT_EQ(5u, summary.retransmission_count);
+  ASSERT_TRUE(stats_.GetSummary(kDevice, kLinkStatsCodecAny,
+                                now - kLinkStatsFineBucketMs, now, &summary));
+  EXPECT_EQ(1u, summary.retransmission_count);
+}
+
+TEST_F(BqrStatsTest, test_completed_hours_exported_once) {
+  stats_.AddSample(kDevice, 2, MakeSample(-60, 4), kStartMs);
+  stats_.ExportCompleted(kStartMs + kLinkStatsCoarseBucketMs - 1);
+  EXPECT_TRUE(exported_.empty());
+
+  stats_.ExportCompleted(kStartMs + kLinkStatsCoarseBucketMs);
+  ASSERT_EQ(1u, exported_.size());
+  EXPECT_EQ(kDevice, exported_[0].bda);
+  EXPECT_EQ(2, exported_[0].codec);
+  EXPECT_EQ(kStartMs, exported_[0].bucket.start_ms);
+  EXPECT_EQ(kLinkStatsCoarseBucketMs, exported_[0].bucket.duration_ms);
+  EXPECT_EQ(4u, exported_[0].bucket.retransmission_count);
+
+  stats_.ExportCompleted(kStartMs + 2 * kLinkStatsCoarseBucketMs);
+  stats_.AddSample(kDevice, 2, MakeSample(-60, 1),
+                   kStartMs + 25 * kLinkStatsCoarseBucketMs);
+  EXPECT_EQ(1u, exported_.size());
+}
+
+TEST_F(BqrStatsTest, test_replaced_hour_exported) {
+  stats_.AddSample(kDevice, kLinkStatsCodecNone, MakeSample(-60, 4), kStartMs);
+  // Same slot of the ring a day later
+  stats_.AddSample(kDevice, kLinkStatsCodecNone, MakeSample(-60, 1),
+                   kStartMs + 24 * kLinkStatsCoarseBucketMs);
+  ASSERT_EQ(1u, exported_.size());
+  EXPECT_EQ(kStartMs, exported_[0].bucket.start_ms);
+  EXPECT_EQ(4u, exported_[0].bucket.retransmission_count);
+}
+
+TEST_F(BqrStatsTest, test_least_recent_link_evicted) {
+  for (size_t i = 0; i <= kLinkStatsMaxLinks; i++) {
+    RawAddress bda({0x00, 0x00, 0x00, 0x00, 0x00, (uint8_t)i});
+    stats_.AddSample(bda, kLinkStatsCodecNone, MakeSample(-60, 1),
+                     kStartMs + i);
+  }
+
+  // The first link made room for the last one, and its partial hour was kept
+  RawAddress first({0x00, 0x00, 0x00, 0x00, 0x00, 0x00});
+  ASSERT_EQ(1u, exported_.size());
+  EXPECT_EQ(first, exported_[0].bda);
+  LinkQualityBucket summary;
+  EXPECT_FALSE(stats_.GetSummary(first, kLinkStatsCodecAny, kStartMs,
+                                 kStartMs + kLinkStatsMaxLinks, &summary));
+}
@@ -0,0 +1,126 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "btif/include/btif_config_journal.h"
+
+namespace {
+
+const char* kJournalPath = "/tmp/btif_config_journal_test.journal";
+
+config_t make_config() {
+  config_t config;
+  config_set_string(&config, "Adapter", "Address", "01:02:03:04:05:06");
+  config_set_string(&config, "aa:bb:cc:dd:ee:ff", "Name", "Headset");
+  config_set_string(&config, "aa:bb:cc:dd:ee:ff", "LinkKey", "0123");
+  return config;
+}
+
+const std::string* get(const config_t& config, const std::string& section,
+                       const std::string& key) {
+  return config_get_string(config, section, key, nullptr);
+}
+
+class BtifConfigJournalTest : public ::testing::Test {
+ protected:
+  void SetUp() override { unlink(kJournalPath); }
+  void TearDown() override { unlink(kJournalPath); }
+};
+
+}  // namespace
+
+TEST_F(BtifConfigJournalTest, test_replay_applies_changes) {
+  config_t base = make_config();
+  ASSERT_TRUE(btif_config_journal_reset(kJournalPath, 7));
+
+  config_t changed = base;
+  config_set_string(&changed, "aa:bb:cc:dd:ee:ff", "Name", "Car");
+  config_remove_key(&changed, "aa:bb:cc:dd:ee:ff", "LinkKey");
+  config_set_string(&changed, "11:22:33:44:55:66", "LinkKey", "4567");
+  config_remove_section(&changed, "Adapter");
+  size_t size = 0;
+  ASSERT_TRUE(btif_config_journal_append(kJournalPath, base, changed, &size));
+  EXPECT_GT(size, 0u);
+
+  config_t replayed = make_config();
+  EXPECT_EQ(btif_config_journal_replay(kJournalPath, 7, &replayed), 4);
+  EXPECT_EQ(*get(replayed, "aa:bb:cc:dd:ee:ff", "Name"), "Car");
+  EXPECT_EQ(get(replayed, "aa:bb:cc:dd:ee:ff", "LinkKey"), nullptr);
+  EXPECT_EQ(*get(replayed, "11:22:33:44:55:66", "LinkKey"), "4567");
+  EXPECT_FALSE(config_has_section(replayed, "Adapter"));
+}
+
+TEST_F(BtifConfigJournalTest, test_unchanged_config_appends_nothing) {
+  config_t base = make_config();
+  ASSERT_TRUE(btif_config_journal_reset(kJournalPath, 1));
+  size_t first = 0, second = 0;
+  ASSERT_TRUE(btif_config_journal_append(kJournalPath, base, base, &first));
+  ASSERT_TRUE(btif_config_journal_append(kJournalPath, base, base, &second));
+  EXPECT_EQ(first, second);
+
+  config_t replayed = make_config();
+  EXPECT_EQ(btif_config_journal_replay(kJournalPath, 1, &replayed), 0);
+}
+
+TEST_F(BtifConfigJournalTest, test_other_generation_is_ignored) {
+  config_t base = make_config();
+  ASSERT_TRUE(btif_config_journal_reset(kJournalPath, 3));
+  config_t changed = base;
+  config_set_string(&changed, "Adapter", "Name", "Phone");
+  size_t size = 0;
+  ASSERT_TRUE(btif_config_journal_append(kJournalPath, base, changed, &size));
+
+  config_t replayed = make_config();
+  EXPECT_EQ(btif_config_journal_replay(kJournalPath, 4, &replayed), -1);
+  EXPECT_EQ(get(replayed, "Adapter", "Name"), nullptr);
+  EXPECT_EQ(btif_config_journal_replay("/tmp/does_not_exist.journal", 3,
+                                       &replayed),
+            -1);
+}
+
+TEST_F(BtifConfigJournalTest, test_torn_tail_is_dropped) {
+  config_t base = make_config();
+  ASSERT_TRUE(btif_config_journal_reset(kJournalPath, 2));
+  config_t first = base;
+  config_set_string(&first, "Adapter", "Name", "Phone");
+  size_t good_size = 0;
+  ASSERT_TRUE(
+      btif_config_journal_append(kJournalPath, base, first, &good_size));
+  config_t second = first;
+  config_set_string(&second, "Adapter", "Name", "Tablet");
+  size_t size = 0;
+  ASSERT_TRUE(btif_config_journal_append(kJournalPath, first, second, &size));
+
+  // Cut the last record short, as a crash during the append would
+  ASSERT_EQ(truncate(kJournalPath, size - 3), 0);
+
+  config_t replayed = make_config();
+  EXPECT_EQ(btif_config_journal_replay(kJournalPath, 2, &replayed), 1);
+  EXPECT_EQ(*get(replayed, "Adapter", "Name"), "Phone");
+
+  // The tail is gone, new records follow the last good one
+  ASSERT_TRUE(btif_config_journal_append(kJournalPath, first, second, &size));
+  EXPECT_GT(size, good_size);
+  replayed = make_config();
+  EXPECT_EQ(btif_config_journal_replay(kJournalPath, 2, &replayed), 2);
+  EXPECT_EQ(*get(replayed, "Adapter", "Name"), "Tablet");
+}
@@ -18,6 +18,7 @@
 #include <gtest/gtest.h>
 
 #include "btif/include/btif_profile_queue.h"
+#include "stack/include/sdpdefs.h"
 #include "stack_manager.h"
 
 static bool sStackRunning;
@@ -29,6 +30,8 @@ bt_status_t btif_test_queue_connect(uint16_t uuid, const RawAddress* bda,
   return btif_queue_connect(uuid, *bda, connect_cb, 1);
 }
 
+static int sConnectCount;
+
 static stack_manager_t sStackManager = {nullptr, nullptr, nullptr, nullptr,
                                         get_stack_is_running};
 
@@ -65,6 +68,7 @@ class BtifProfileQueueTest : public ::testing::Test {
   void SetUp() override {
     sStackRunning = true;
     sResult = NOT_SET;
+    sConnectCount = 0;
   };
   void TearDown() override { btif_queue_release(); };
 };
@@ -75,6 +79,7 @@ const RawAddress BtifProfileQueueTest::kTestAddr2{
     {0xAB, 0xCD, 0xEF, 0x12, 0x34, 0x56}};
 
 static bt_status_t test_connect_cb(RawAddress* bda, uint16_t uuid) {
+  sConnectCount++;
   sResult = UNKNOWN;
   if (*bda == BtifProfileQueueTest::kTestAddr1) {
     if (uuid == BtifProfileQueueTest::kTestUuid1) {
@@ -205,3 +210,49 @@ TEST_F(BtifProfileQueueTest, test_cleanup_both_reverse_order) {
   btif_queue_connect_next();
   EXPECT_EQ(sResult, NOT_SET);
 }
+
+TEST_F(BtifProfileQueueTest, test_different_devices_connect_concurrently) {
+  sResult = NOT_SET;
+  btif_test_queue_connect(kTestUuid1, &kTestAddr1, test_connect_cb);
+  EXPECT_EQ(sResult, UUID1_ADDR1);
+  // Another profile on another device doesn't wait for the first one
+  sResult = NOT_SET;
+  btif_test_queue_connect(kTestUuid2, &kTestAddr2, test_connect_cb);
+  EXPECT_EQ(sResult, UUID2_ADDR2);
+}
+
+TEST_F(BtifProfileQueueTest, test_same_device_stays_in_order) {
+  sResult = NOT_SET;
+  btif_test_queue_connect(kTestUuid1, &kTestAddr1, test_connect_cb);
+  EXPECT_EQ(sResult, UUID1_ADDR1);
+  // UUID2 on ADDR1 waits for UUID1 on ADDR1
+  sResult = NOT_SET;
+  btif_test_queue_connect(kTestUuid2, &kTestAddr1, test_connect_cb);
+  EXPECT_EQ(sResult, NOT_SET);
+  // ADDR2 doesn't wait for either of them
+  sResult = NOT_SET;
+  btif_test_queue_connect(UUID_SERVCLASS_AUDIO_SINK, &kTestAddr2,
+                          test_connect_cb);
+  EXPECT_EQ(sResult, UNKNOWN);
+  sResult = NOT_SET;
+  btif_queue_advance_by_uuid(kTestUuid1, &kTestAddr1);
+  EXPECT_EQ(sResult, UUID2_ADDR1);
+}
+
+TEST_F(BtifProfileQueueTest, test_multi_connection_profile_concurrent) {
+  btif_queue_connect(UUID_SERVCLASS_AUDIO_SINK, kTestAddr1, test_connect_cb,
+                     2);
+  btif_queue_connect(UUID_SERVCLASS_AUDIO_SINK, kTestAddr2, test_connect_cb,
+                     2);
+  EXPECT_EQ(sConnectCount, 2);
+}
+
+TEST_F(BtifProfileQueueTest, test_single_connection_profile_serialized) {
+  btif_queue_connect(UUID_SERVCLASS_AUDIO_SINK, kTestAddr1, test_connect_cb,
+                     1);
+  btif_queue_connect(UUID_SERVCLASS_AUDIO_SINK, kTestAddr2, test_connect_cb,
+                     1);
+  EXPECT_EQ(sConnectCount, 1);
+  btif_queue_advance_by_uuid(UUID_SERVCLASS_AUDIO_SINK, &kTestAddr1);
+  EXPECT_EQ(sConnectCount, 2);
+}
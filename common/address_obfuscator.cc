@@ -36,6 +36,7 @@ bool AddressObfuscator::IsSaltValid(const Octet32& salt_256bit) {
 void AddressObfuscator::Initialize(const Octet32& salt_256bit) {
   std::lock_guard<std::recursive_mutex> lock(instance_mutex_);
   salt_256bit_ = salt_256bit;
+  cache_.Clear();
 }
 
 bool AddressObfuscator::IsInitialized() {
@@ -44,6 +45,12 @@ bool AddressObfuscator::IsInitialized() {
 }
 
 std::string AddressObfuscator::Obfuscate(const RawAddress& address) {
+  Octet32 cached;
+  if (cache_.Get(address, &cached)) {
+    return std::string(reinterpret_cast<const char*>(cached.data()),
+                       cached.size());
+  }
+
   std::lock_guard<std::recursive_mutex> lock(instance_mutex_);
   CHECK(IsInitialized());
   std::array<uint8_t, EVP_MAX_MD_SIZE> result = {};
@@ -52,6 +59,8 @@ std::string AddressObfuscator::Obfuscate(const RawAddress& address) {
                address.address, address.kLength, result.data(),
                &out_len) != nullptr);
   CHECK_EQ(out_len, static_cast<unsigned int>(kOctet32Length));
+  std::copy(result.begin(), result.begin() + kOctet32Length, cached.begin());
+  cache_.Put(address, cached);
   return std::string(reinterpret_cast<const char*>(result.data()), out_len);
 }
 
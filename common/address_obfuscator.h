@@ -22,6 +22,8 @@
 #include <mutex>
 #include <string>
 
+#include "common/lru.h"
+#include "osi/include/open_hash_map.h"
 #include "raw_address.h"
 
 namespace bluetooth {
@@ -30,6 +32,8 @@ namespace common {
 class AddressObfuscator {
  public:
   static constexpr unsigned int kOctet32Length = 32;
+  // Number of addresses whose obfuscated ID is kept
+  static constexpr size_t kCacheCapacity = 256;
   using Octet32 = std::array<uint8_t, kOctet32Length>;
   static AddressObfuscator* GetInstance() {
     static auto instance = new AddressObfuscator();
@@ -47,7 +51,8 @@ class AddressObfuscator {
   static bool IsSaltValid(const Octet32& salt_256bit);
 
   /**
-   * Initialize this obfuscator with necessary parameters
+   * Initialize this obfuscator with necessary parameters, dropping the IDs
+   * cached with the previous salt
    *
    * @param salt_256bit a 256 bit salt used to hash the fixed length address
    */
@@ -61,15 +66,26 @@ class AddressObfuscator {
   /**
    * Obfuscate Bluetooth MAC address into an anonymous ID string
    *
+   * The IDs of recently obfuscated addresses are cached, so the HMAC is only
+   * computed on a miss. A hit only takes a shared lock of the cache.
+   *
    * @param address Bluetooth MAC address to be obfuscated
    * @return the obfuscated MAC address in 256 bit
    */
   std::string Obfuscate(const RawAddress& address);
 
  private:
-  AddressObfuscator() : salt_256bit_({0}) {}
+  AddressObfuscator()
+      : salt_256bit_({0}),
+        cache_(kCacheCapacity, "AddressObfuscator", 4,
+               LruEvictionPolicy::kClock) {}
   Octet32 salt_256bit_;
   std::recursive_mutex instance_mutex_;
+  // Filled and cleared with |instance_mutex_| held, so no entry computed
+  // with an old salt survives Initialize()
+  ShardedLruCache<RawAddress, Octet32,
+                  system_bt_osi::OpenHashMapHash<RawAddress>>
+      cache_;
 };
 
 }  // namespace common
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <stdio.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/lru.h"
+
+using ::benchmark::State;
+using bluetooth::common::LegacyLruCache;
+using bluetooth::common::LruEvictionPolicy;
+using bluetooth::common::ShardedLruCache;
+
+#define CACHE_CAPACITY 256
+#define NUM_KEYS 1024
+
+// Keys shaped like config section names, i.e. Bluetooth addresses.
+static std::vector<std::string> make_keys() {
+  std::vector<std::string> keys;
+  char name[18];
+  for (int i = 0; i < NUM_KEYS; i++) {
+    snprintf(name, sizeof(name), "00:11:22:33:%02x:%02x", (i >> 8) & 0xff,
+             i & 0xff);
+    keys.emplace_back(name);
+  }
+  return keys;
+}
+
+static const std::vector<std::string> g_keys = make_keys();
+
+// Mostly lookups with a miss-driven insert, as during LE scanning.
+template <typename Cache>
+static void run_workload(State& state, Cache* cache) {
+  size_t i = std::hash<std::thread::id>()(std::this_thread::get_id());
+  int value;
+  for (auto _ : state) {
+    // Skew towards a hot subset of keys.
+    const std::string& key =
+        g_keys[(i % 4 == 0) ? (i * 31) % NUM_KEYS : (i * 31) % 64];
+    if (!cache->Get(key, &value)) cache->Put(key, static_cast<int>(i));
+    i++;
+  }
+}
+
+static LegacyLruCache<std::string, int> g_legacy_cache(CACHE_CAPACITY,
+                                                       "benchmark");
+static ShardedLruCache<std::string, int> g_sharded_cache(CACHE_CAPACITY,
+                                                         "benchmark");
+static ShardedLruCache<std::string, int> g_clock_cache(
+    CACHE_CAPACITY, "benchmark", 8, LruEvictionPolicy::kClock);
+
+static void BM_LegacyLruCache(State& state) {
+  run_workload(state, &g_legacy_cache);
+}
+
+static void BM_ShardedLruCache(State& state) {
+  run_workload(state, &g_sharded_cache);
+}
+
+static void BM_ShardedClockCache(State& state) {
+  run_workload(state, &g_clock_cache);
+}
+
+BENCHMARK(BM_LegacyLruCache)->ThreadRange(1, 8);
+BENCHMARK(BM_ShardedLruCache)->ThreadRange(1, 8);
+BENCHMARK(BM_ShardedClockCache)->ThreadRange(1, 8);
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,164 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include <base/logging.h>
+
+namespace bluetooth {
+
+namespace common {
+
+/**
+ * A preallocated ring of small tasks for one consumer thread. A task is a
+ * function and up to |kPayloadSize| bytes of arguments, stored in the slot
+ * itself: posting and running a task never allocates.
+ *
+ * Producers call Push() from any thread. When it returns |schedule|, the
+ * ring went from idle to busy and the producer posts one Drain() to the
+ * consumer. When Push() fails the ring is full, or the task does not fit.
+ * The producer then posts the task through its regular path. The ring
+ * refuses tasks until it has drained, so a task never runs ahead of one
+ * posted earlier.
+ */
+template <size_t kSlots, size_t kPayloadSize>
+class InlineTaskRing {
+ public:
+  /* Runs the task if |run|, and destroys the payload in either case */
+  typedef void (*TaskFn)(void* payload, bool run);
+
+  struct Stats {
+    uint64_t pushed = 0;
+    uint64_t overflowed = 0;  // Refused while full or overflowed
+    uint64_t too_large = 0;
+    size_t max_depth = 0;
+  };
+
+  InlineTaskRing() = default;
+  InlineTaskRing(const InlineTaskRing&) = delete;
+  InlineTaskRing& operator=(const InlineTaskRing&) = delete;
+
+  /**
+   * Queue a task of |size| bytes of payload. |fill| is called with the slot
+   * payload and constructs the arguments in place.
+   *
+   * @param schedule set to true if the caller must post a Drain()
+   * @return false if the task was not queued
+   */
+  template <typename Fill>
+  bool Push(TaskFn fn, size_t size, Fill fill, bool* schedule) {
+    *schedule = false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (size > kPayloadSize) {
+      stats_.too_large++;
+      // Later tasks must not pass this one
+      if (count_ > 0 || scheduled_) overflowed_ = true;
+      return false;
+    }
+    if (overflowed_ || count_ == kSlots) {
+      stats_.overflowed++;
+      overflowed_ = true;
+      return false;
+    }
+
+    Slot& slot = slots_[(head_ + count_) % kSlots];
+    slot.fn = fn;
+    fill(static_cast<void*>(slot.payload));
+    count_++;
+    stats_.pushed++;
+    if (count_ > stats_.max_depth) stats_.max_depth = count_;
+
+    if (!scheduled_) {
+      scheduled_ = true;
+      *schedule = true;
+    }
+    return true;
+  }
+
+  /**
+   * Run queued tasks on the consumer thread. Stops after |max_tasks| unless
+   * the ring overflowed, in which case it runs until the ring is empty so
+   * the tasks posted on the regular path run after the ring ones.
+   *
+   * @return true if tasks remain and the caller must post Drain() again
+   */
+  bool Drain(size_t max_tasks) {
+    size_t run = 0;
+    while (true) {
+      Slot* slot;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (count_ == 0) {
+          scheduled_ = false;
+          overflowed_ = false;
+          return false;
+        }
+        if (run >= max_tasks && !overflowed_) return true;
+        slot = &slots_[head_];
+      }
+
+      // Producers never write a slot before it is released below
+      slot->fn(static_cast<void*>(slot->payload), true);
+      run++;
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      head_ = (head_ + 1) % kSlots;
+      count_--;
+    }
+  }
+
+  /**
+   * Drop all queued tasks without running them, once the consumer is gone
+   */
+  void Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (; count_ > 0; count_--) {
+      slots_[head_].fn(static_cast<void*>(slots_[head_].payload), false);
+      head_ = (head_ + 1) % kSlots;
+    }
+    scheduled_ = false;
+    overflowed_ = false;
+  }
+
+  Stats GetStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+  }
+
+ private:
+  struct Slot {
+    TaskFn fn;
+    alignas(std::max_align_t) uint8_t payload[kPayloadSize];
+  };
+
+  mutable std::mutex mutex_;
+  Slot slots_[kSlots];
+  size_t head_ = 0;
+  size_t count_ = 0;
+  bool scheduled_ = false;
+  bool overflowed_ = false;
+  Stats stats_;
+};
+
+}  // namespace common
+
+}  // namespace bluetooth
@@ -0,0 +1,122 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "inline_task_ring.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using bluetooth::common::InlineTaskRing;
+
+namespace {
+
+std::vector<int> ran;
+std::vector<int> dropped;
+
+void Record(void* payload, bool run) {
+  int value = *static_cast<int*>(payload);
+  if (run)
+    ran.push_back(value);
+  else
+    dropped.push_back(value);
+}
+
+template <typename Ring>
+bool PushInt(Ring* ring, int value, bool* schedule) {
+  return ring->Push(&Record, sizeof(int),
+                    [value](void* p) { *static_cast<int*>(p) = value; },
+                    schedule);
+}
+
+class InlineTaskRingTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ran.clear();
+    dropped.clear();
+  }
+};
+
+}  // namespace
+
+TEST_F(InlineTaskRingTest, schedules_once_per_burst) {
+  InlineTaskRing<4, 16> ring;
+  bool schedule = false;
+  EXPECT_TRUE(PushInt(&ring, 1, &schedule));
+  EXPECT_TRUE(schedule);
+  EXPECT_TRUE(PushInt(&ring, 2, &schedule));
+  EXPECT_FALSE(schedule);
+
+  EXPECT_FALSE(ring.Drain(10));
+  EXPECT_EQ(std::vector<int>({1, 2}), ran);
+
+  EXPECT_TRUE(PushInt(&ring, 3, &schedule));
+  EXPECT_TRUE(schedule);
+}
+
+TEST_F(InlineTaskRingTest, drain_stops_after_batch) {
+  InlineTaskRing<4, 16> ring;
+  bool schedule = false;
+  for (int i = 0; i < 3; i++) PushInt(&ring, i, &schedule);
+
+  EXPECT_TRUE(ring.Drain(2));
+  EXPECT_EQ(2u, ran.size());
+  EXPECT_FALSE(ring.Drain(2));
+  EXPECT_EQ(std::vector<int>({0, 1, 2}), ran);
+}
+
+TEST_F(InlineTaskRingTest, refuses_until_drained_after_overflow) {
+  InlineTaskRing<2, 16> ring;
+  bool schedule = false;
+  EXPECT_TRUE(PushInt(&ring, 1, &schedule));
+  EXPECT_TRUE(PushInt(&ring, 2, &schedule));
+  EXPECT_FALSE(PushInt(&ring, 3, &schedule));
+
+  // Not drained yet, so the ring keeps refusing and 3 cannot be passed
+  EXPECT_FALSE(PushInt(&ring, 4, &schedule));
+
+  // An overflowed ring drains completely, ignoring the batch size
+  EXPECT_FALSE(ring.Drain(1));
+  EXPECT_EQ(std::vector<int>({1, 2}), ran);
+  EXPECT_TRUE(PushInt(&ring, 5, &schedule));
+  EXPECT_TRUE(schedule);
+  EXPECT_EQ(2u, ring.GetStats().overflowed);
+}
+
+TEST_F(InlineTaskRingTest, too_large_task_blocks_busy_ring) {
+  InlineTaskRing<4, 8> ring;
+  bool schedule = false;
+  EXPECT_FALSE(ring.Push(&Record, 16, [](void*) {}, &schedule));
+  EXPECT_TRUE(PushInt(&ring, 1, &schedule));
+  EXPECT_FALSE(ring.Push(&Record, 16, [](void*) {}, &schedule));
+  EXPECT_FALSE(PushInt(&ring, 2, &schedule));
+  EXPECT_EQ(2u, ring.GetStats().too_large);
+}
+
+TEST_F(InlineTaskRingTest, clear_drops_tasks) {
+  InlineTaskRing<4, 16> ring;
+  bool schedule = false;
+  PushInt(&ring, 1, &schedule);
+  PushInt(&ring, 2, &schedule);
+  ring.Clear();
+  EXPECT_TRUE(ran.empty());
+  EXPECT_EQ(std::vector<int>({1, 2}), dropped);
+
+  EXPECT_TRUE(PushInt(&ring, 3, &schedule));
+  EXPECT_TRUE(schedule);
+}
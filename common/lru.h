@@ -18,16 +18,22 @@
 
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <iterator>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <optional>
+#include <shared_mutex>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include <base/logging.h>
 
+#include "osi/include/open_hash_map.h"
+
 namespace bluetooth {
 
 namespace common {
@@ -184,5 +190,311 @@ class LegacyLruCache {
   mutable std::recursive_mutex lru_mutex_;
 };
 
+enum class LruEvictionPolicy {
+  // Exact LRU order within a shard. Every hit relinks the entry, so lookups
+  // take the shard lock exclusively.
+  kLru,
+  // CLOCK approximation of LRU. A hit only sets a reference bit, so lookups
+  // share the shard lock and run concurrently.
+  kClock,
+};
+
+/**
+ * LRU cache split into independently locked shards.
+ *
+ * Entries live in a per-shard array preallocated at construction and are
+ * linked by index, and the key index is an OpenHashMap sized for the shard,
+ * so Get and Put never allocate (beyond what copying K and V does). Keys are
+ * assigned to shards by hash and eviction happens within a shard, so the
+ * cache as a whole is only approximately LRU.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>>
+class ShardedLruCache {
+ public:
+  using Node = std::pair<K, V>;
+
+  /**
+   * Constructor of the cache
+   *
+   * @param capacity maximum size of the cache, split evenly across shards
+   * @param log_tag, keyword to put at the head of log.
+   * @param num_shards number of independently locked shards
+   * @param policy eviction policy used within each shard
+   */
+  ShardedLruCache(const size_t& capacity, const std::string& log_tag,
+                  size_t num_shards = 8,
+                  LruEvictionPolicy policy = LruEvictionPolicy::kLru)
+      : policy_(policy) {
+    if (capacity == 0 || num_shards == 0) {
+      // don't allow invalid capacity
+      LOG(FATAL) << log_tag << " unable to have 0 LRU Cache capacity";
+    }
+    if (num_shards > capacity) num_shards = capacity;
+    size_t shard_capacity = (capacity + num_shards - 1) / num_shards;
+    for (size_t i = 0; i < num_shards; i++) {
+      shards_.emplace_back(std::make_unique<Shard>(shard_capacity));
+    }
+  }
+
+  // delete copy constructor
+  ShardedLruCache(ShardedLruCache const&) = delete;
+  ShardedLruCache& operator=(ShardedLruCache const&) = delete;
+
+  /**
+   * Clear the cache
+   */
+  void Clear() {
+    for (auto& shard : shards_) {
+      std::unique_lock<std::shared_mutex> lock(shard->mutex);
+      shard->Reset();
+    }
+  }
+
+  /**
+   * Get the value of a key, and mark the key as recently used, if there is
+   * one
+   *
+   * @param key
+   * @param value, output parameter of value of the key
+   * @return true if the cache has the key
+   */
+  bool Get(const K& key, V* value) {
+    CHECK(value != nullptr);
+    Shard& shard = ShardFor(key);
+    if (policy_ == LruEvictionPolicy::kClock) {
+      std::shared_lock<std::shared_mutex> lock(shard.mutex);
+      const uint32_t* index = shard.index.Find(key);
+      if (index == nullptr) return false;
+      Entry& entry = shard.entries[*index];
+      entry.referenced.store(true, std::memory_order_relaxed);
+      *value = entry.value;
+      return true;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    const uint32_t* index = shard.index.Find(key);
+    if (index == nullptr) return false;
+    shard.MoveToFront(*index);
+    *value = shard.entries[*index].value;
+    return true;
+  }
+
+  /**
+   * Check if the cache has the input key, and mark the key as recently used
+   * if there is one
+   *
+   * @param key
+   * @return true if the cache has the key
+   */
+  bool HasKey(const K& key) {
+    Shard& shard = ShardFor(key);
+    if (policy_ == LruEvictionPolicy::kClock) {
+      std::shared_lock<std::shared_mutex> lock(shard.mutex);
+      const uint32_t* index = shard.index.Find(key);
+      if (index == nullptr) return false;
+      shard.entries[*index].referenced.store(true, std::memory_order_relaxed);
+      return true;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    const uint32_t* index = shard.index.Find(key);
+    if (index == nullptr) return false;
+    shard.MoveToFront(*index);
+    return true;
+  }
+
+  /**
+   * Put a key-value pair to the cache, marking it as most recently used
+   *
+   * @param key
+   * @param value
+   * @return evicted node if a value is popped from the key's shard,
+   * std::nullopt if no value is popped.
+   */
+  std::optional<Node> Put(const K& key, V value) {
+    Shard& shard = ShardFor(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+
+    const uint32_t* existing = shard.index.Find(key);
+    if (existing != nullptr) {
+      uint32_t index = *existing;
+      shard.entries[index].value = std::move(value);
+      Touch(shard, index);
+      return std::nullopt;
+    }
+
+    std::optional<Node> ret = std::nullopt;
+    if (shard.free_head == kInvalidIndex) {
+      uint32_t victim = (policy_ == LruEvictionPolicy::kClock)
+                            ? shard.ClockVictim()
+                            : shard.tail;
+      Entry& entry = shard.entries[victim];
+      shard.index.Erase(entry.key);
+      ret = Node(std::move(entry.key), std::move(entry.value));
+      shard.Release(victim);
+    }
+
+    uint32_t index = shard.Acquire();
+    Entry& entry = shard.entries[index];
+    entry.key = key;
+    entry.value = std::move(value);
+    entry.referenced.store(true, std::memory_order_relaxed);
+    shard.index.Insert(key, index);
+    return ret;
+  }
+
+  /**
+   * Delete a key from cache
+   *
+   * @param key
+   * @return true if deleted successfully
+   */
+  bool Remove(const K& key) {
+    Shard& shard = ShardFor(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    const uint32_t* existing = shard.index.Find(key);
+    if (existing == nullptr) return false;
+
+    uint32_t index = *existing;
+    shard.index.Erase(key);
+    shard.entries[index].key = K();
+    shard.entries[index].value = V();
+    shard.Release(index);
+    return true;
+  }
+
+  /**
+   * Return size of the cache
+   *
+   * @return size of the cache
+   */
+  int Size() const {
+    size_t size = 0;
+    for (auto& shard : shards_) {
+      std::shared_lock<std::shared_mutex> lock(shard->mutex);
+      size += shard->index.Size();
+    }
+    return size;
+  }
+
+ private:
+  static constexpr uint32_t kInvalidIndex = UINT32_MAX;
+
+  struct Entry {
+    K key{};
+    V value{};
+    uint32_t prev = kInvalidIndex;
+    uint32_t next = kInvalidIndex;
+    bool in_use = false;
+    std::atomic<bool> referenced{false};
+  };
+
+  // In-use entries form a list from |head| (most recent) to |tail|; free
+  // entries are chained through |next| from |free_head|.
+  struct Shard {
+    explicit Shard(size_t capacity)
+        : capacity(capacity),
+          entries(new Entry[capacity]),
+          index(capacity) {
+      Reset();
+    }
+
+    void Reset() {
+      for (size_t i = 0; i < capacity; i++) {
+        entries[i].key = K();
+        entries[i].value = V();
+        entries[i].in_use = false;
+        entries[i].prev = kInvalidIndex;
+        entries[i].next = (i + 1 < capacity) ? i + 1 : kInvalidIndex;
+      }
+      head = tail = kInvalidIndex;
+      free_head = 0;
+      clock_hand = 0;
+      index.Clear();
+    }
+
+    void Unlink(uint32_t i) {
+      Entry& entry = entries[i];
+      if (entry.prev != kInvalidIndex)
+        entries[entry.prev].next = entry.next;
+      else
+        head = entry.next;
+      if (entry.next != kInvalidIndex)
+        entries[entry.next].prev = entry.prev;
+      else
+        tail = entry.prev;
+    }
+
+    void LinkFront(uint32_t i) {
+      Entry& entry = entries[i];
+      entry.prev = kInvalidIndex;
+      entry.next = head;
+      if (head != kInvalidIndex) entries[head].prev = i;
+      head = i;
+      if (tail == kInvalidIndex) tail = i;
+    }
+
+    void MoveToFront(uint32_t i) {
+      if (head == i) return;
+      Unlink(i);
+      LinkFront(i);
+    }
+
+    uint32_t Acquire() {
+      uint32_t i = free_head;
+      free_head = entries[i].next;
+      entries[i].in_use = true;
+      LinkFront(i);
+      return i;
+    }
+
+    void Release(uint32_t i) {
+      Unlink(i);
+      entries[i].in_use = false;
+      entries[i].prev = kInvalidIndex;
+      entries[i].next = free_head;
+      free_head = i;
+    }
+
+    // Sweeps the clock hand over the entries, giving referenced ones a
+    // second chance, and returns the first unreferenced one. Only called
+    // when the shard is full.
+    uint32_t ClockVictim() {
+      while (true) {
+        uint32_t i = clock_hand;
+        clock_hand = (clock_hand + 1) % capacity;
+        Entry& entry = entries[i];
+        if (!entry.in_use) continue;
+        if (!entry.referenced.exchange(false, std::memory_order_relaxed))
+          return i;
+      }
+    }
+
+    const size_t capacity;
+    std::unique_ptr<Entry[]> entries;
+    system_bt_osi::OpenHashMap<K, uint32_t, Hash> index;
+    uint32_t head;
+    uint32_t tail;
+    uint32_t free_head;
+    uint32_t clock_hand;
+    mutable std::shared_mutex mutex;
+  };
+
+  Shard& ShardFor(const K& key) {
+    uint64_t hash = static_cast<uint64_t>(Hash()(key)) * 0x9E3779B97F4A7C15ULL;
+    return *shards_[(hash >> 32) % shards_.size()];
+  }
+
+  void Touch(Shard& shard, uint32_t index) {
+    if (policy_ == LruEvictionPolicy::kClock)
+      shard.entries[index].referenced.store(true, std::memory_order_relaxed);
+    else
+      shard.MoveToFront(index);
+  }
+
+  const LruEvictionPolicy policy_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
 }  // namespace common
 }  // namespace bluetooth
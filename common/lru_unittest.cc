@@ -0,0 +1,113 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "lru.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using bluetooth::common::LruEvictionPolicy;
+using bluetooth::common::ShardedLruCache;
+
+TEST(ShardedLruCacheTest, get_put_remove) {
+  ShardedLruCache<int, std::string> cache(8, "test", 2);
+  std::string value;
+
+  EXPECT_FALSE(cache.Get(1, &value));
+  EXPECT_FALSE(cache.Put(1, "one"));
+  EXPECT_TRUE(cache.Get(1, &value));
+  EXPECT_EQ("one", value);
+  EXPECT_TRUE(cache.HasKey(1));
+
+  EXPECT_FALSE(cache.Put(1, "uno"));
+  EXPECT_TRUE(cache.Get(1, &value));
+  EXPECT_EQ("uno", value);
+  EXPECT_EQ(1, cache.Size());
+
+  EXPECT_TRUE(cache.Remove(1));
+  EXPECT_FALSE(cache.Remove(1));
+  EXPECT_FALSE(cache.HasKey(1));
+  EXPECT_EQ(0, cache.Size());
+}
+
+TEST(ShardedLruCacheTest, single_shard_evicts_least_recently_used) {
+  ShardedLruCache<int, int> cache(3, "test", 1);
+  cache.Put(1, 10);
+  cache.Put(2, 20);
+  cache.Put(3, 30);
+  EXPECT_TRUE(cache.HasKey(1));
+
+  auto evicted = cache.Put(4, 40);
+  ASSERT_TRUE(evicted);
+  EXPECT_EQ(2, evicted->first);
+  EXPECT_EQ(20, evicted->second);
+  EXPECT_EQ(3, cache.Size());
+  EXPECT_FALSE(cache.HasKey(2));
+  EXPECT_TRUE(cache.HasKey(1));
+}
+
+TEST(ShardedLruCacheTest, clock_gives_referenced_entries_a_second_chance) {
+  ShardedLruCache<int, int> cache(3, "test", 1, LruEvictionPolicy::kClock);
+  cache.Put(1, 10);
+  cache.Put(2, 20);
+  cache.Put(3, 30);
+
+  // The first sweep clears every reference bit, so the oldest entry goes.
+  auto evicted = cache.Put(4, 40);
+  ASSERT_TRUE(evicted);
+  EXPECT_EQ(1, evicted->first);
+
+  // 2 is referenced again, so 3 is the next victim.
+  EXPECT_TRUE(cache.HasKey(2));
+  evicted = cache.Put(5, 50);
+  ASSERT_TRUE(evicted);
+  EXPECT_EQ(3, evicted->first);
+  EXPECT_TRUE(cache.HasKey(2));
+}
+
+TEST(ShardedLruCacheTest, capacity_is_respected_across_shards) {
+  ShardedLruCache<int, int> cache(64, "test", 4);
+  for (int i = 0; i < 1000; i++) cache.Put(i, i);
+  EXPECT_EQ(64, cache.Size());
+
+  cache.Clear();
+  EXPECT_EQ(0, cache.Size());
+}
+
+TEST(ShardedLruCacheTest, concurrent_access) {
+  ShardedLruCache<int, int> cache(128, "test", 8, LruEvictionPolicy::kClock);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&cache, t]() {
+      int value;
+      for (int i = 0; i < 10000; i++) {
+        int key = (i * 7 + t) % 256;
+        if (cache.Get(key, &value)) {
+          EXPECT_EQ(key, value);
+        } else {
+          cache.Put(key, key);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  EXPECT_LE(cache.Size(), 128);
+}
@@ -34,7 +34,8 @@ MessageLoopThread::MessageLoopThread(const std::string& thread_name)
       run_loop_(nullptr),
       thread_(nullptr),
       thread_id_(-1),
-      linux_tid_(-1) {}
+      linux_tid_(-1),
+      task_profiler_(thread_name) {}
 
 MessageLoopThread::~MessageLoopThread() {
   std::lock_guard<std::recursive_mutex> api_lock(api_mutex_);
@@ -64,6 +65,10 @@ bool MessageLoopThread::DoInThread(const tracked_objects::Location& from_here,
                << ", from " << from_here.ToString();
     return false;
   }
+  if (task_profiler_.IsEnabled()) {
+    task = base::BindOnce(&MessageLoopThread::RunProfiledTask, &task_profiler_,
+                          from_here, TaskProfiler::NowUs(), std::move(task));
+  }
   if (!message_loop_->task_runner()->PostTask(from_here, std::move(task))) {
     LOG(ERROR) << __func__
                << ": failed to post task to message loop for thread " << *this
@@ -127,6 +132,16 @@ base::MessageLoop* MessageLoopThread::message_loop() const {
   return message_loop_;
 }
 
+TaskProfiler& MessageLoopThread::task_profiler() { return task_profiler_; }
+
+// Non API method, runs on the thread itself
+void MessageLoopThread::RunProfiledTask(
+    TaskProfiler* profiler, const tracked_objects::Location& from_here,
+    uint64_t posted_us, base::OnceClosure task) {
+  TaskProfiler::ScopedRun run(profiler, from_here, posted_us);
+  std::move(task).Run();
+}
+
 bool MessageLoopThread::EnableRealTimeScheduling() {
   std::lock_guard<std::recursive_mutex> api_lock(api_mutex_);
   if (!IsRunning()) {
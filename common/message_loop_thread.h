@@ -28,6 +28,7 @@
 #include <base/tracked_objects.h>
 
 #include "common/execution_barrier.h"
+#include "common/task_profiler.h"
 
 namespace bluetooth {
 
@@ -131,6 +132,14 @@ class MessageLoopThread final {
    */
   base::MessageLoop* message_loop() const;
 
+  /**
+   * Return the execution profile of the tasks posted through DoInThread().
+   * Profiling is off until it is enabled through the returned profiler.
+   *
+   * @return task profiler of this thread
+   */
+  TaskProfiler& task_profiler();
+
  private:
   /**
    * Static method to run the thread
@@ -152,6 +161,13 @@ class MessageLoopThread final {
    */
   void Run(std::shared_ptr<ExecutionBarrier> start_up_barrier);
 
+  /**
+   * Run |task| while timing it with |profiler|
+   */
+  static void RunProfiledTask(TaskProfiler* profiler,
+                              const tracked_objects::Location& from_here,
+                              uint64_t posted_us, base::OnceClosure task);
+
   mutable std::recursive_mutex api_mutex_;
   std::string thread_name_;
   base::MessageLoop* message_loop_;
@@ -160,6 +176,7 @@ class MessageLoopThread final {
   base::PlatformThreadId thread_id_;
   // Linux specific abstractions
   pid_t linux_tid_;
+  TaskProfiler task_profiler_;
 
   DISALLOW_COPY_AND_ASSIGN(MessageLoopThread);
 };
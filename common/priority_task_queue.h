@@ -0,0 +1,146 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include <base/logging.h>
+
+namespace bluetooth {
+
+namespace common {
+
+/**
+ * A set of FIFO lanes of tasks, served in priority order. Lane 0 has the
+ * highest priority. A task that has waited |max_wait_us| or longer is served
+ * before the tasks of higher priority lanes, so low priority lanes cannot
+ * starve. Tasks within a lane always run in the order they were pushed.
+ *
+ * Not thread safe: the owner serializes Push() and Pop().
+ */
+template <typename T>
+class PriorityTaskQueue {
+ public:
+  struct LaneStats {
+    uint64_t pushed = 0;
+    uint64_t popped = 0;
+    uint64_t aged = 0;  // Popped ahead of higher lanes after |max_wait_us|
+    uint64_t total_delay_us = 0;
+    uint64_t max_delay_us = 0;
+    size_t max_depth = 0;
+  };
+
+  /**
+   * @param num_lanes number of lanes, must not be zero
+   * @param max_wait_us time after which a queued task runs ahead of the tasks
+   * of higher priority lanes
+   */
+  PriorityTaskQueue(size_t num_lanes, uint64_t max_wait_us)
+      : lanes_(num_lanes), stats_(num_lanes), max_wait_us_(max_wait_us) {
+    CHECK(num_lanes > 0);
+  }
+
+  PriorityTaskQueue(PriorityTaskQueue const&) = delete;
+  PriorityTaskQueue& operator=(PriorityTaskQueue const&) = delete;
+
+  /**
+   * Queue |task| at the end of |lane|
+   *
+   * @param now_us current time, used for the queue delay
+   */
+  void Push(size_t lane, T task, uint64_t now_us) {
+    CHECK(lane < lanes_.size());
+    lanes_[lane].emplace_back(now_us, std::move(task));
+    LaneStats& stats = stats_[lane];
+    stats.pushed++;
+    if (lanes_[lane].size() > stats.max_depth)
+      stats.max_depth = lanes_[lane].size();
+  }
+
+  /**
+   * Take the next task to run: the oldest task that has waited |max_wait_us|,
+   * if any, otherwise the first task of the highest priority lane that is
+   * not empty.
+   *
+   * @param task where the task is moved to
+   * @param now_us current time, used for the queue delay
+   * @return false if all lanes are empty
+   */
+  bool Pop(T* task, uint64_t now_us) {
+    size_t lane = lanes_.size();
+    bool aged = false;
+    for (size_t i = 0; i < lanes_.size(); i++) {
+      if (lanes_[i].empty()) continue;
+      if (lane == lanes_.size()) {
+        lane = i;
+        continue;
+      }
+      // An aged task of a lower lane, older than the current choice
+      uint64_t queued_us = lanes_[i].front().first;
+      if (now_us - queued_us >= max_wait_us_ &&
+          queued_us < lanes_[lane].front().first) {
+        lane = i;
+        aged = true;
+      }
+    }
+    if (lane == lanes_.size()) return false;
+
+    uint64_t delay_us = now_us - lanes_[lane].front().first;
+    *task = std::move(lanes_[lane].front().second);
+    lanes_[lane].pop_front();
+
+    LaneStats& stats = stats_[lane];
+    stats.popped++;
+    if (aged) stats.aged++;
+    stats.total_delay_us += delay_us;
+    if (delay_us > stats.max_delay_us) stats.max_delay_us = delay_us;
+    return true;
+  }
+
+  /**
+   * Drop all queued tasks. The statistics are kept.
+   */
+  void Clear() {
+    for (auto& lane : lanes_) lane.clear();
+  }
+
+  bool IsEmpty() const {
+    for (const auto& lane : lanes_) {
+      if (!lane.empty()) return false;
+    }
+    return true;
+  }
+
+  size_t NumLanes() const { return lanes_.size(); }
+
+  size_t Size(size_t lane) const { return lanes_[lane].size(); }
+
+  const LaneStats& GetStats(size_t lane) const { return stats_[lane]; }
+
+ private:
+  std::vector<std::deque<std::pair<uint64_t, T>>> lanes_;
+  std::vector<LaneStats> stats_;
+  uint64_t max_wait_us_;
+};
+
+}  // namespace common
+
+}  // namespace bluetooth
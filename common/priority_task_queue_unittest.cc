@@ -0,0 +1,96 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "priority_task_queue.h"
+
+#include <gtest/gtest.h>
+
+using bluetooth::common::PriorityTaskQueue;
+
+TEST(PriorityTaskQueueTest, empty) {
+  PriorityTaskQueue<int> queue(3, 1000);
+  int task = 0;
+  EXPECT_TRUE(queue.IsEmpty());
+  EXPECT_FALSE(queue.Pop(&task, 0));
+}
+
+TEST(PriorityTaskQueueTest, serves_higher_lanes_first) {
+  PriorityTaskQueue<int> queue(3, 1000);
+  queue.Push(2, 20, 0);
+  queue.Push(1, 10, 1);
+  queue.Push(0, 1, 2);
+  queue.Push(2, 21, 3);
+  queue.Push(0, 2, 4);
+
+  int task = 0;
+  int expected[] = {1, 2, 10, 20, 21};
+  for (int value : expected) {
+    ASSERT_TRUE(queue.Pop(&task, 10));
+    EXPECT_EQ(value, task);
+  }
+  EXPECT_FALSE(queue.Pop(&task, 10));
+  EXPECT_TRUE(queue.IsEmpty());
+}
+
+TEST(PriorityTaskQueueTest, aged_task_runs_first) {
+  PriorityTaskQueue<int> queue(3, 1000);
+  queue.Push(2, 20, 0);
+  queue.Push(1, 10, 500);
+  queue.Push(0, 1, 900);
+
+  int task = 0;
+  // Nothing has waited long enough yet
+  ASSERT_TRUE(queue.Pop(&task, 999));
+  EXPECT_EQ(1, task);
+
+  // Both lower lane tasks are aged, the oldest runs first
+  queue.Push(0, 2, 1000);
+  ASSERT_TRUE(queue.Pop(&task, 1500));
+  EXPECT_EQ(20, task);
+  ASSERT_TRUE(queue.Pop(&task, 1500));
+  EXPECT_EQ(10, task);
+  ASSERT_TRUE(queue.Pop(&task, 1500));
+  EXPECT_EQ(2, task);
+
+  EXPECT_EQ(1U, queue.GetStats(2).aged);
+  EXPECT_EQ(1U, queue.GetStats(1).aged);
+  EXPECT_EQ(0U, queue.GetStats(0).aged);
+}
+
+TEST(PriorityTaskQueueTest, stats) {
+  PriorityTaskQueue<int> queue(2, 1000);
+  queue.Push(1, 10, 0);
+  queue.Push(1, 11, 100);
+  queue.Push(1, 12, 200);
+
+  int task = 0;
+  ASSERT_TRUE(queue.Pop(&task, 300));
+  ASSERT_TRUE(queue.Pop(&task, 400));
+
+  const auto& stats = queue.GetStats(1);
+  EXPECT_EQ(3U, stats.pushed);
+  EXPECT_EQ(2U, stats.popped);
+  EXPECT_EQ(600U, stats.total_delay_us);
+  EXPECT_EQ(300U, stats.max_delay_us);
+  EXPECT_EQ(3U, stats.max_depth);
+  EXPECT_EQ(1U, queue.Size(1));
+
+  queue.Clear();
+  EXPECT_TRUE(queue.IsEmpty());
+  EXPECT_EQ(3U, queue.GetStats(1).pushed);
+}
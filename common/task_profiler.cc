@@ -0,0 +1,116 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define ATRACE_TAG ATRACE_TAG_ALWAYS
+
+#include <algorithm>
+#include <chrono>
+
+#include <cutils/trace.h>
+#include <stdio.h>
+
+#include "task_profiler.h"
+
+namespace bluetooth {
+
+namespace common {
+
+TaskProfiler::ScopedRun::ScopedRun(TaskProfiler* profiler,
+                                   const base::Location& from_here,
+                                   uint64_t posted_us)
+    : profiler_(profiler && profiler->IsEnabled() ? profiler : nullptr),
+      from_here_(from_here),
+      posted_us_(posted_us),
+      start_us_(0) {
+  if (profiler_ == nullptr) return;
+  ATRACE_BEGIN(from_here_.function_name());
+  start_us_ = NowUs();
+}
+
+TaskProfiler::ScopedRun::~ScopedRun() {
+  if (profiler_ == nullptr) return;
+  uint64_t end_us = NowUs();
+  ATRACE_END();
+  uint64_t delay_us = start_us_ > posted_us_ ? start_us_ - posted_us_ : 0;
+  profiler_->Record(from_here_, delay_us, end_us - start_us_);
+}
+
+TaskProfiler::TaskProfiler(const std::string& name)
+    : name_(name), enabled_(false) {}
+
+uint64_t TaskProfiler::NowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void TaskProfiler::Record(const base::Location& from_here, uint64_t delay_us,
+                          uint64_t run_us) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Entry& entry =
+      entries_[Key(from_here.file_name(), from_here.line_number())];
+  if (entry.count == 0) entry.location = from_here.ToString();
+  entry.count++;
+  entry.total_run_us += run_us;
+  entry.max_run_us = std::max(entry.max_run_us, run_us);
+  entry.total_delay_us += delay_us;
+  entry.max_delay_us = std::max(entry.max_delay_us, delay_us);
+}
+
+std::vector<TaskProfiler::Entry> TaskProfiler::GetEntries() const {
+  std::vector<Entry> entries;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& it : entries_) entries.push_back(it.second);
+  }
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) {
+              return a.total_run_us > b.total_run_us;
+            });
+  return entries;
+}
+
+void TaskProfiler::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+}
+
+void TaskProfiler::Dump(int fd, size_t max_entries) const {
+  dprintf(fd, "\nTask profile of %s (%s):\n", name_.c_str(),
+          IsEnabled() ? "enabled" : "disabled");
+
+  std::vector<Entry> entries = GetEntries();
+  if (entries.empty()) return;
+
+  dprintf(fd, "  %8s %10s %8s %8s %8s %8s  %s\n", "count", "run(ms)",
+          "avg(us)", "max(us)", "avgq(us)", "maxq(us)", "location");
+  for (size_t i = 0; i < entries.size() && i < max_entries; i++) {
+    const Entry& entry = entries[i];
+    dprintf(fd, "  %8llu %10llu %8llu %8llu %8llu %8llu  %s\n",
+            (unsigned long long)entry.count,
+            (unsigned long long)(entry.total_run_us / 1000),
+            (unsigned long long)(entry.total_run_us / entry.count),
+            (unsigned long long)entry.max_run_us,
+            (unsigned long long)(entry.total_delay_us / entry.count),
+            (unsigned long long)entry.max_delay_us, entry.location.c_str());
+  }
+}
+
+}  // namespace common
+
+}  // namespace bluetooth
@@ -0,0 +1,119 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <base/location.h>
+
+namespace bluetooth {
+
+namespace common {
+
+/**
+ * Execution profile of the tasks posted to a thread, per posting location.
+ * Records how often each location posted, how long its tasks ran and how
+ * long they waited in the queue. While enabled each run is also emitted as
+ * an atrace slice named after the posting function, so it shows up in
+ * perfetto traces.
+ *
+ * Disabled by default. Recording is thread safe.
+ */
+class TaskProfiler final {
+ public:
+  struct Entry {
+    std::string location;
+    uint64_t count = 0;
+    uint64_t total_run_us = 0;
+    uint64_t max_run_us = 0;
+    uint64_t total_delay_us = 0;
+    uint64_t max_delay_us = 0;
+  };
+
+  /**
+   * Times one task while in scope: the queue delay from |posted_us| to the
+   * construction and the run time until destruction. Does nothing if
+   * |profiler| is null or disabled.
+   */
+  class ScopedRun final {
+   public:
+    ScopedRun(TaskProfiler* profiler, const base::Location& from_here,
+              uint64_t posted_us);
+    ~ScopedRun();
+
+   private:
+    TaskProfiler* profiler_;
+    const base::Location& from_here_;
+    uint64_t posted_us_;
+    uint64_t start_us_;
+
+    ScopedRun(const ScopedRun&) = delete;
+    ScopedRun& operator=(const ScopedRun&) = delete;
+  };
+
+  explicit TaskProfiler(const std::string& name);
+
+  void SetEnabled(bool enabled) { enabled_ = enabled; }
+  bool IsEnabled() const { return enabled_; }
+
+  /**
+   * Current time of the clock used for |posted_us|
+   */
+  static uint64_t NowUs();
+
+  /**
+   * Record one run of a task posted from |from_here|
+   */
+  void Record(const base::Location& from_here, uint64_t delay_us,
+              uint64_t run_us);
+
+  /**
+   * @return all entries, the ones with the longest total run time first
+   */
+  std::vector<Entry> GetEntries() const;
+
+  void Reset();
+
+  /**
+   * Print the |max_entries| entries with the longest total run time to |fd|
+   */
+  void Dump(int fd, size_t max_entries) const;
+
+ private:
+  // Locations are keyed by their file name literal and line
+  typedef std::pair<const char*, int> Key;
+
+  std::string name_;
+  std::atomic<bool> enabled_;
+  mutable std::mutex mutex_;
+  std::map<Key, Entry> entries_;
+
+  TaskProfiler(const TaskProfiler&) = delete;
+  TaskProfiler& operator=(const TaskProfiler&) = delete;
+};
+
+}  // namespace common
+
+}  // namespace bluetooth
@@ -0,0 +1,81 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <base/location.h>
+
+#include "task_profiler.h"
+
+using bluetooth::common::TaskProfiler;
+
+namespace {
+
+base::Location LocationA() { return FROM_HERE; }
+base::Location LocationB() { return FROM_HERE; }
+
+}  // namespace
+
+TEST(TaskProfilerTest, disabled_scoped_run_records_nothing) {
+  TaskProfiler profiler("test");
+  EXPECT_FALSE(profiler.IsEnabled());
+  base::Location location = LocationA();
+  { TaskProfiler::ScopedRun run(&profiler, location, TaskProfiler::NowUs()); }
+  { TaskProfiler::ScopedRun run(nullptr, location, TaskProfiler::NowUs()); }
+  EXPECT_TRUE(profiler.GetEntries().empty());
+}
+
+TEST(TaskProfilerTest, enabled_scoped_run_records_delay) {
+  TaskProfiler profiler("test");
+  profiler.SetEnabled(true);
+  base::Location location = LocationA();
+  uint64_t posted_us = TaskProfiler::NowUs() - 500;
+  { TaskProfiler::ScopedRun run(&profiler, location, posted_us); }
+
+  std::vector<TaskProfiler::Entry> entries = profiler.GetEntries();
+  ASSERT_EQ(1u, entries.size());
+  EXPECT_EQ(1u, entries[0].count);
+  EXPECT_GE(entries[0].max_delay_us, 500u);
+  EXPECT_EQ(location.ToString(), entries[0].location);
+}
+
+TEST(TaskProfilerTest, entries_per_location_by_total_run_time) {
+  TaskProfiler profiler("test");
+  base::Location a = LocationA();
+  base::Location b = LocationB();
+  profiler.Record(a, 10, 100);
+  profiler.Record(b, 20, 300);
+  profiler.Record(a, 30, 50);
+
+  std::vector<TaskProfiler::Entry> entries = profiler.GetEntries();
+  ASSERT_EQ(2u, entries.size());
+
+  EXPECT_EQ(b.ToString(), entries[0].location);
+  EXPECT_EQ(1u, entries[0].count);
+  EXPECT_EQ(300u, entries[0].total_run_us);
+
+  EXPECT_EQ(a.ToString(), entries[1].location);
+  EXPECT_EQ(2u, entries[1].count);
+  EXPECT_EQ(150u, entries[1].total_run_us);
+  EXPECT_EQ(100u, entries[1].max_run_us);
+  EXPECT_EQ(40u, entries[1].total_delay_us);
+  EXPECT_EQ(30u, entries[1].max_delay_us);
+
+  profiler.Reset();
+  EXPECT_TRUE(profiler.GetEntries().empty());
+}
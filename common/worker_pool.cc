@@ -0,0 +1,158 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <pthread.h>
+
+#include <base/logging.h>
+
+#include "worker_pool.h"
+
+namespace bluetooth {
+
+namespace common {
+
+WorkerPool::WorkerPool(const std::string& name)
+    : name_(name),
+      running_(false),
+      pending_(0),
+      next_worker_(0),
+      posted_(0),
+      run_(0),
+      stolen_(0) {}
+
+WorkerPool::~WorkerPool() { ShutDown(); }
+
+void WorkerPool::StartUp(size_t num_threads) {
+  CHECK(num_threads > 0);
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (running_) {
+    LOG(WARNING) << __func__ << ": pool " << name_ << " is already started";
+    return;
+  }
+
+  running_ = true;
+  for (size_t i = 0; i < num_threads; i++)
+    workers_.emplace_back(new Worker());
+  for (size_t i = 0; i < num_threads; i++)
+    workers_[i]->thread = std::thread(&WorkerPool::Run, this, i);
+}
+
+void WorkerPool::ShutDown() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_) return;
+    running_ = false;
+  }
+  cv_.notify_all();
+
+  for (auto& worker : workers_) worker->thread.join();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  workers_.clear();
+  pending_ = 0;
+}
+
+bool WorkerPool::PostTask(const base::Location& from_here,
+                          base::Closure task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_) {
+      LOG(ERROR) << __func__ << ": pool " << name_
+                 << " is not running, from " << from_here.ToString();
+      return false;
+    }
+
+    Worker* worker = workers_[next_worker_++ % workers_.size()].get();
+    {
+      std::lock_guard<std::mutex> worker_lock(worker->mutex);
+      worker->tasks.push_back(std::move(task));
+    }
+    pending_++;
+  }
+  posted_++;
+  cv_.notify_one();
+  return true;
+}
+
+bool WorkerPool::IsRunning() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return running_;
+}
+
+size_t WorkerPool::NumThreads() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return workers_.size();
+}
+
+WorkerPool::Stats WorkerPool::GetStats() const {
+  Stats stats;
+  stats.posted = posted_;
+  stats.run = run_;
+  stats.stolen = stolen_;
+  return stats;
+}
+
+bool WorkerPool::TakeTask(size_t index, base::Closure* task) {
+  {
+    Worker* own = workers_[index].get();
+    std::lock_guard<std::mutex> lock(own->mutex);
+    if (!own->tasks.empty()) {
+      *task = std::move(own->tasks.front());
+      own->tasks.pop_front();
+      return true;
+    }
+  }
+
+  for (size_t i = 1; i < workers_.size(); i++) {
+    Worker* victim = workers_[(index + i) % workers_.size()].get();
+    std::lock_guard<std::mutex> lock(victim->mutex);
+    if (!victim->tasks.empty()) {
+      *task = std::move(victim->tasks.back());
+      victim->tasks.pop_back();
+      stolen_++;
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkerPool::Run(size_t index) {
+  std::string thread_name = (name_ + std::to_string(index)).substr(0, 15);
+  pthread_setname_np(pthread_self(), thread_name.c_str());
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return !running_ || pending_ > 0; });
+      if (!running_) return;
+      pending_--;
+    }
+
+    // Every claimed task is queued before pending_ is raised, so a task for
+    // this claim is in one of the queues, maybe behind a concurrent steal.
+    base::Closure task;
+    while (!TakeTask(index, &task)) std::this_thread::yield();
+
+    task.Run();
+    run_++;
+  }
+}
+
+}  // namespace common
+
+}  // namespace bluetooth
@@ -0,0 +1,130 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <base/callback.h>
+#include <base/location.h>
+
+namespace bluetooth {
+
+namespace common {
+
+/**
+ * A small pool of worker threads for CPU heavy work that does not need to run
+ * on the stack main thread. Each worker has its own queue of tasks, a worker
+ * that runs out of work takes tasks from the back of the other queues.
+ *
+ * Tasks can run in any order and in parallel. A task must not touch state
+ * owned by another thread, results go back to their owner through a task
+ * posted by the task itself.
+ */
+class WorkerPool final {
+ public:
+  struct Stats {
+    uint64_t posted = 0;
+    uint64_t run = 0;
+    uint64_t stolen = 0;  // Run by a worker other than the one it was posted to
+  };
+
+  /**
+   * Create a worker pool. No thread runs until StartUp is called.
+   *
+   * @param name name of the worker threads
+   */
+  explicit WorkerPool(const std::string& name);
+
+  /**
+   * Shut the pool down if it is still running
+   */
+  ~WorkerPool();
+
+  /**
+   * Start |num_threads| worker threads. Repeated calls only start the pool
+   * once.
+   */
+  void StartUp(size_t num_threads);
+
+  /**
+   * Stop and join the worker threads. Tasks that did not start yet are
+   * dropped. Must not be called from a worker thread.
+   */
+  void ShutDown();
+
+  /**
+   * Post a task to run on one of the worker threads
+   *
+   * @param from_here location where this task is originated
+   * @param task task created through base::Bind()
+   * @return true if the task is scheduled, false if the pool is not running
+   */
+  bool PostTask(const base::Location& from_here, base::Closure task);
+
+  bool IsRunning() const;
+
+  size_t NumThreads() const;
+
+  Stats GetStats() const;
+
+ private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<base::Closure> tasks;
+    std::thread thread;
+  };
+
+  void Run(size_t index);
+
+  /**
+   * Take a task from the front of worker |index|, or else from the back of
+   * another worker.
+   *
+   * @return false if no worker has a task
+   */
+  bool TakeTask(size_t index, base::Closure* task);
+
+  std::string name_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  // Protects running_ and pending_, the worker queues have their own locks
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  bool running_;
+  size_t pending_;
+
+  std::atomic<size_t> next_worker_;
+  std::atomic<uint64_t> posted_;
+  std::atomic<uint64_t> run_;
+  std::atomic<uint64_t> stolen_;
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+};
+
+}  // namespace common
+
+}  // namespace bluetooth
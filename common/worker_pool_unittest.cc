@@ -0,0 +1,115 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#include <gtest/gtest.h>
+
+#include <base/bind.h>
+
+#include "worker_pool.h"
+
+using bluetooth::common::WorkerPool;
+
+namespace {
+
+struct Gate {
+  std::mutex mutex;
+  std::condition_variable cv;
+  int count = 0;
+
+  void Add() {
+    std::lock_guard<std::mutex> lock(mutex);
+    count++;
+    cv.notify_all();
+  }
+
+  bool WaitFor(int target) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return cv.wait_for(lock, std::chrono::seconds(5),
+                       [this, target] { return count >= target; });
+  }
+};
+
+void Count(Gate* gate) { gate->Add(); }
+
+// Blocks until |other| reached |target|, then counts in |gate|
+void CountAfter(Gate* other, int target, bool* released, Gate* gate) {
+  *released = other->WaitFor(target);
+  gate->Add();
+}
+
+}  // namespace
+
+TEST(WorkerPoolTest, post_before_start_up_fails) {
+  WorkerPool pool("bt_test_pool");
+  Gate gate;
+  EXPECT_FALSE(pool.IsRunning());
+  EXPECT_FALSE(pool.PostTask(FROM_HERE, base::Bind(&Count, &gate)));
+}
+
+TEST(WorkerPoolTest, runs_all_tasks) {
+  WorkerPool pool("bt_test_pool");
+  pool.StartUp(3);
+  EXPECT_TRUE(pool.IsRunning());
+  EXPECT_EQ(3u, pool.NumThreads());
+
+  Gate gate;
+  for (int i = 0; i < 100; i++)
+    EXPECT_TRUE(pool.PostTask(FROM_HERE, base::Bind(&Count, &gate)));
+  EXPECT_TRUE(gate.WaitFor(100));
+
+  pool.ShutDown();
+  EXPECT_FALSE(pool.IsRunning());
+  EXPECT_EQ(100u, pool.GetStats().posted);
+  EXPECT_EQ(100u, pool.GetStats().run);
+  EXPECT_FALSE(pool.PostTask(FROM_HERE, base::Bind(&Count, &gate)));
+}
+
+// The first task only finishes once the last one ran, which needs the second
+// worker to take it out of the queue of the first.
+TEST(WorkerPoolTest, idle_worker_steals) {
+  WorkerPool pool("bt_test_pool");
+  pool.StartUp(2);
+
+  Gate first, rest;
+  bool released = false;
+  pool.PostTask(FROM_HERE,
+                base::Bind(&CountAfter, &rest, 2, &released, &first));
+  pool.PostTask(FROM_HERE, base::Bind(&Count, &rest));
+  pool.PostTask(FROM_HERE, base::Bind(&Count, &rest));
+
+  EXPECT_TRUE(first.WaitFor(1));
+  EXPECT_TRUE(released);
+  pool.ShutDown();
+  EXPECT_GE(pool.GetStats().stolen, 1u);
+}
+
+TEST(WorkerPoolTest, restart) {
+  WorkerPool pool("bt_test_pool");
+  pool.StartUp(1);
+  pool.ShutDown();
+  pool.StartUp(2);
+
+  Gate gate;
+  EXPECT_TRUE(pool.PostTask(FROM_HERE, base::Bind(&Count, &gate)));
+  EXPECT_TRUE(gate.WaitFor(1));
+}
@@ -69,6 +69,9 @@
 #include <hardware/bt_av.h>
 #include "bt_configstore.h"
 #include <dlfcn.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
 #include <vector>
 #include "stack_config.h"
 #include <map>
@@ -76,6 +79,9 @@
 #include "device/include/profile_config.h"
 
 #define BTSNOOP_ENABLE_PROPERTY "persist.bluetooth.btsnoopenable"
+#define CONTROLLER_SNAPSHOT_PATH "/data/misc/bluedroid/bt_controller_cache.bin"
+#define CONTROLLER_SNAPSHOT_MAGIC 0x53435442 /* "BTCS" */
+#define CONTROLLER_SNAPSHOT_LAYOUT 1
 #define BTSNOOP_SOCLOG_PROPERTY "persist.vendor.service.bdroid.soclog"
 
 const bt_event_mask_t BLE_EVENT_MASK = {
@@ -204,6 +210,13 @@ static bool supports_ble_aoa();
 #define AWAIT_COMMAND(command) \
   static_cast<BT_HDR*>(future_await(hci->transmit_command_futured(command)))
 
+// Commands that don't depend on each other's results are queued together with
+// SEND_COMMAND and their responses collected in order with AWAIT_RESPONSE. The
+// HCI layer sends them as far as the controller's command credits allow, so a
+// group of reads costs one round trip instead of one per command.
+#define SEND_COMMAND(command) hci->transmit_command_futured(command)
+#define AWAIT_RESPONSE(future) static_cast<BT_HDR*>(future_await(future))
+
 // Module lifecycle functions
 
 void send_soc_log_command(bool value) {
@@ -273,6 +286,134 @@ bool is_soc_lpa_enh_pwr_enabled() {
   return strncmp(lpa_enh_pwr_enabled, "true", 4) == 0;
 }
 
+// Static controller capabilities, saved after a full start up and reused on
+// the next enable if the controller still reports the same version and
+// address. Only the results of read commands are kept: everything the host
+// writes to the controller is sent again after every reset.
+typedef struct {
+  uint32_t magic;
+  uint32_t layout;
+  bt_version_t bt_version;
+  RawAddress address;
+  uint16_t acl_data_size_classic;
+  uint16_t acl_buffer_count_classic;
+  uint8_t supported_commands[HCI_SUPPORTED_COMMANDS_ARRAY_SIZE];
+  bt_device_features_t features_classic[MAX_FEATURES_CLASSIC_PAGE_COUNT];
+  uint8_t last_features_classic_page_index;
+  bool ble_valid;
+  uint8_t ble_white_list_size;
+  uint16_t acl_data_size_ble;
+  uint8_t acl_buffer_count_ble;
+  uint16_t iso_data_packet_len;
+  uint8_t total_num_iso_data_packets;
+  uint8_t ble_supported_states[BLE_SUPPORTED_STATES_SIZE];
+  // As read from the controller, before the host support bits are set
+  bt_device_features_t features_ble;
+  uint8_t ble_resolving_list_max_size;
+  uint16_t ble_suggested_default_data_length;
+  uint16_t ble_maxium_advertising_data_length;
+  uint8_t ble_number_of_supported_advertising_sets;
+} controller_snapshot_t;
+
+static bool controller_snapshot_load(controller_snapshot_t* snapshot) {
+  FILE* fp = fopen(CONTROLLER_SNAPSHOT_PATH, "rb");
+  if (!fp) return false;
+
+  bool ok = fread(snapshot, sizeof(*snapshot), 1, fp) == 1 &&
+            snapshot->magic == CONTROLLER_SNAPSHOT_MAGIC &&
+            snapshot->layout == CONTROLLER_SNAPSHOT_LAYOUT;
+  fclose(fp);
+  if (!ok)
+    LOG_WARN(LOG_TAG, "%s ignoring invalid snapshot '%s'", __func__,
+             CONTROLLER_SNAPSHOT_PATH);
+  return ok;
+}
+
+static bool controller_snapshot_matches(const controller_snapshot_t* snapshot) {
+  return snapshot->bt_version.hci_version == bt_version.hci_version &&
+         snapshot->bt_version.hci_revision == bt_version.hci_revision &&
+         snapshot->bt_version.lmp_version == bt_version.lmp_version &&
+         snapshot->bt_version.manufacturer == bt_version.manufacturer &&
+         snapshot->bt_version.lmp_subversion == bt_version.lmp_subversion &&
+         snapshot->address == address;
+}
+
+static void controller_snapshot_restore(const controller_snapshot_t* snapshot) {
+  acl_data_size_classic = snapshot->acl_data_size_classic;
+  acl_buffer_count_classic = snapshot->acl_buffer_count_classic;
+  memcpy(supported_commands, snapshot->supported_commands,
+         sizeof(supported_commands));
+  memcpy(features_classic, snapshot->features_classic,
+         sizeof(features_classic));
+  last_features_classic_page_index =
+      snapshot->last_features_classic_page_index;
+  if (!snapshot->ble_valid) return;
+
+  ble_white_list_size = snapshot->ble_white_list_size;
+  acl_data_size_ble = snapshot->acl_data_size_ble;
+  acl_buffer_count_ble = snapshot->acl_buffer_count_ble;
+  iso_data_packet_len = snapshot->iso_data_packet_len;
+  total_num_iso_data_packets = snapshot->total_num_iso_data_packets;
+  memcpy(ble_supported_states, snapshot->ble_supported_states,
+         sizeof(ble_supported_states));
+  features_ble = snapshot->features_ble;
+  ble_resolving_list_max_size = snapshot->ble_resolving_list_max_size;
+  ble_suggested_default_data_length =
+      snapshot->ble_suggested_default_data_length;
+  ble_maxium_advertising_data_length =
+      snapshot->ble_maxium_advertising_data_length;
+  ble_number_of_supported_advertising_sets =
+      snapshot->ble_number_of_supported_advertising_sets;
+}
+
+static void controller_snapshot_save(const bt_device_features_t* raw_features_ble) {
+  controller_snapshot_t snapshot;
+  memset(&snapshot, 0, sizeof(snapshot));
+  snapshot.magic = CONTROLLER_SNAPSHOT_MAGIC;
+  snapshot.layout = CONTROLLER_SNAPSHOT_LAYOUT;
+  snapshot.bt_version = bt_version;
+  snapshot.address = address;
+  snapshot.acl_data_size_classic = acl_data_size_classic;
+  snapshot.acl_buffer_count_classic = acl_buffer_count_classic;
+  memcpy(snapshot.supported_commands, supported_commands,
+         sizeof(supported_commands));
+  memcpy(snapshot.features_classic, features_classic,
+         sizeof(features_classic));
+  snapshot.last_features_classic_page_index = last_features_classic_page_index;
+  snapshot.ble_valid = ble_supported;
+  if (ble_supported) {
+    snapshot.ble_white_list_size = ble_white_list_size;
+    snapshot.acl_data_size_ble = acl_data_size_ble;
+    snapshot.acl_buffer_count_ble = acl_buffer_count_ble;
+    snapshot.iso_data_packet_len = iso_data_packet_len;
+    snapshot.total_num_iso_data_packets = total_num_iso_data_packets;
+    memcpy(snapshot.ble_supported_states, ble_supported_states,
+           sizeof(ble_supported_states));
+    snapshot.features_ble = *raw_features_ble;
+    snapshot.ble_resolving_list_max_size = ble_resolving_list_max_size;
+    snapshot.ble_suggested_default_data_length =
+        ble_suggested_default_data_length;
+    snapshot.ble_maxium_advertising_data_length =
+        ble_maxium_advertising_data_length;
+    snapshot.ble_number_of_supported_advertising_sets =
+        ble_number_of_supported_advertising_sets;
+  }
+
+  FILE* fp = fopen(CONTROLLER_SNAPSHOT_PATH, "wb");
+  if (!fp) {
+    LOG_WARN(LOG_TAG, "%s unable to create '%s': %s", __func__,
+             CONTROLLER_SNAPSHOT_PATH, strerror(errno));
+    return;
+  }
+  bool ok = fwrite(&snapshot, sizeof(snapshot), 1, fp) == 1;
+  ok = (fclose(fp) == 0) && ok;
+  if (!ok) {
+    LOG_WARN(LOG_TAG, "%s unable to write '%s': %s", __func__,
+             CONTROLLER_SNAPSHOT_PATH, strerror(errno));
+    remove(CONTROLLER_SNAPSHOT_PATH);
+  }
+}
+
 static future_t* start_up(void) {
   BT_HDR* response;
   uint8_t adv_audio_support_mask = 0;
@@ -389,19 +530,91 @@ static future_t* start_up(void) {
   response = AWAIT_COMMAND(packet_factory->make_reset());
   packet_parser->parse_generic_command_complete(response);
 
+  // Everything up to page 0 of the features only depends on the reset, so
+  // queue it all at once. With a snapshot from an earlier enable only the
+  // version and address are read first, to check that it still applies.
+  controller_snapshot_t snapshot;
+  bool have_snapshot = controller_snapshot_load(&snapshot);
+  bool restored = false;
+  bool save_snapshot = false;
+  bt_device_features_t raw_features_ble = {};
+  future_t* buffer_size_future = NULL;
+  future_t* supported_commands_future = NULL;
+  future_t* features_future = NULL;
+  uint8_t page_number = 0;
+
   // Request the classic buffer size next
-  response = AWAIT_COMMAND(packet_factory->make_read_buffer_size());
-  packet_parser->parse_read_buffer_size_response(
-      response, &acl_data_size_classic, &acl_buffer_count_classic);
+  if (!have_snapshot)
+    buffer_size_future = SEND_COMMAND(packet_factory->make_read_buffer_size());
 
   // Tell the controller about our buffer sizes and buffer counts next
   // TODO(zachoverflow): factor this out. eww l2cap contamination. And why just
   // a hardcoded 10?
-  response = AWAIT_COMMAND(packet_factory->make_host_buffer_size(
-      L2CAP_MTU_SIZE, SCO_HOST_BUFFER_SIZE, L2CAP_HOST_FC_ACL_BUFS, 10));
+  future_t* host_buffer_size_future =
+      SEND_COMMAND(packet_factory->make_host_buffer_size(
+          L2CAP_MTU_SIZE, SCO_HOST_BUFFER_SIZE, L2CAP_HOST_FC_ACL_BUFS, 10));
 
+  // Read the local version info off the controller next, including
+  // information such as manufacturer and supported HCI version
+  future_t* version_future =
+      SEND_COMMAND(packet_factory->make_read_local_version_info());
+
+  // Read the bluetooth address off the controller next
+  future_t* bd_addr_future = SEND_COMMAND(packet_factory->make_read_bd_addr());
+
+  if (!have_snapshot) {
+    // Request the controller's supported commands next
+    supported_commands_future =
+        SEND_COMMAND(packet_factory->make_read_local_supported_commands());
+
+    // Read page 0 of the controller features next
+    features_future = SEND_COMMAND(
+        packet_factory->make_read_local_extended_features(page_number));
+  }
+
+  response = AWAIT_RESPONSE(host_buffer_size_future);
   packet_parser->parse_generic_command_complete(response);
 
+  response = AWAIT_RESPONSE(version_future);
+  packet_parser->parse_read_local_version_info_response(response, &bt_version);
+
+  response = AWAIT_RESPONSE(bd_addr_future);
+  packet_parser->parse_read_bd_addr_response(response, &address);
+
+  if (have_snapshot && controller_snapshot_matches(&snapshot)) {
+    LOG_INFO(LOG_TAG, "%s using the controller capabilities snapshot",
+             __func__);
+    controller_snapshot_restore(&snapshot);
+    raw_features_ble = features_ble;
+    restored = true;
+  } else {
+    save_snapshot = true;
+
+    if (have_snapshot) {
+      LOG_INFO(LOG_TAG, "%s controller changed, discarding the snapshot",
+               __func__);
+      buffer_size_future =
+          SEND_COMMAND(packet_factory->make_read_buffer_size());
+      supported_commands_future =
+          SEND_COMMAND(packet_factory->make_read_local_supported_commands());
+      features_future = SEND_COMMAND(
+          packet_factory->make_read_local_extended_features(page_number));
+    }
+
+    response = AWAIT_RESPONSE(buffer_size_future);
+    packet_parser->parse_read_buffer_size_response(
+        response, &acl_data_size_classic, &acl_buffer_count_classic);
+
+    response = AWAIT_RESPONSE(supported_commands_future);
+    packet_parser->parse_read_local_supported_commands_response(
+        response, supported_commands, HCI_SUPPORTED_COMMANDS_ARRAY_SIZE);
+
+    response = AWAIT_RESPONSE(features_future);
+    packet_parser->parse_read_local_extended_features_response(
+        response, &page_number, &last_features_classic_page_index,
+        features_classic, MAX_FEATURES_CLASSIC_PAGE_COUNT);
+  }
+
   if (is_soc_logging_enabled()) {
     LOG_INFO(LOG_TAG, "%s Send command to enable soc logging ", __func__);
     send_soc_log_command(true);
@@ -419,29 +632,6 @@ static future_t* start_up(void) {
     btm_enable_link_lpa_enh_pwr_ctrl((uint16_t)HCI_INVALID_HANDLE, true);
   }
 
-  // Read the local version info off the controller next, including
-  // information such as manufacturer and supported HCI version
-  response = AWAIT_COMMAND(packet_factory->make_read_local_version_info());
-  packet_parser->parse_read_local_version_info_response(response, &bt_version);
-
-  // Read the bluetooth address off the controller next
-  response = AWAIT_COMMAND(packet_factory->make_read_bd_addr());
-  packet_parser->parse_read_bd_addr_response(response, &address);
-
-  // Request the controller's supported commands next
-  response =
-      AWAIT_COMMAND(packet_factory->make_read_local_supported_commands());
-  packet_parser->parse_read_local_supported_commands_response(
-      response, supported_commands, HCI_SUPPORTED_COMMANDS_ARRAY_SIZE);
-
-  // Read page 0 of the controller features next
-  uint8_t page_number = 0;
-  response = AWAIT_COMMAND(
-      packet_factory->make_read_local_extended_features(page_number));
-  packet_parser->parse_read_local_extended_features_response(
-      response, &page_number, &last_features_classic_page_index,
-      features_classic, MAX_FEATURES_CLASSIC_PAGE_COUNT);
-
   CHECK(page_number == 0);
   page_number++;
 
@@ -470,7 +660,7 @@ static future_t* start_up(void) {
 
   // Done telling the controller about what page 0 features we support
   // Request the remaining feature pages
-  while (page_number <= last_features_classic_page_index &&
+  while (!restored && page_number <= last_features_classic_page_index &&
          page_number < MAX_FEATURES_CLASSIC_PAGE_COUNT) {
     response = AWAIT_COMMAND(
         packet_factory->make_read_local_extended_features(page_number));
@@ -518,79 +708,132 @@ static future_t* start_up(void) {
   ble_supported = last_features_classic_page_index >= 1 &&
                   HCI_LE_HOST_SUPPORTED(features_classic[1].as_array);
   if (ble_supported) {
-    // Request the ble white list size next
-    response = AWAIT_COMMAND(packet_factory->make_ble_read_white_list_size());
-    packet_parser->parse_ble_read_white_list_size_response(
-        response, &ble_white_list_size);
-
-    // Request the ble buffer size next
-    if (HCI_LE_READ_BUFFER_SIZE_V2_SUPPORTED(supported_commands)) {
-      response = AWAIT_COMMAND(packet_factory->make_ble_read_buffer_size_v2());
-      packet_parser->parse_ble_read_buffer_size_response(
-          response, &acl_data_size_ble, &acl_buffer_count_ble,
-          &iso_data_packet_len, &total_num_iso_data_packets);
-    } else {
-      response = AWAIT_COMMAND(packet_factory->make_ble_read_buffer_size());
-      packet_parser->parse_ble_read_buffer_size_response(
-          response, &acl_data_size_ble, &acl_buffer_count_ble, NULL, NULL);
-    }
+    bool ble_restored = restored && snapshot.ble_valid;
+    if (!ble_restored) {
+      save_snapshot = true;
+
+      // The first ble reads only depend on the supported commands, queue them
+      // together.
+      // Request the ble white list size next
+      future_t* white_list_size_future =
+          SEND_COMMAND(packet_factory->make_ble_read_white_list_size());
+
+      // Request the ble buffer size next
+      bool buffer_size_v2 =
+          HCI_LE_READ_BUFFER_SIZE_V2_SUPPORTED(supported_commands);
+      future_t* ble_buffer_size_future =
+          buffer_size_v2
+              ? SEND_COMMAND(packet_factory->make_ble_read_buffer_size_v2())
+              : SEND_COMMAND(packet_factory->make_ble_read_buffer_size());
+
+      // Request the ble supported states next
+      future_t* supported_states_future =
+          SEND_COMMAND(packet_factory->make_ble_read_supported_states());
+
+      // Request the ble supported features next
+      future_t* ble_features_future =
+          SEND_COMMAND(packet_factory->make_ble_read_local_supported_features());
+
+      response = AWAIT_RESPONSE(white_list_size_future);
+      packet_parser->parse_ble_read_white_list_size_response(
+          response, &ble_white_list_size);
+
+      response = AWAIT_RESPONSE(ble_buffer_size_future);
+      if (buffer_size_v2) {
+        packet_parser->parse_ble_read_buffer_size_response(
+            response, &acl_data_size_ble, &acl_buffer_count_ble,
+            &iso_data_packet_len, &total_num_iso_data_packets);
+      } else {
+        packet_parser->parse_ble_read_buffer_size_response(
+            response, &acl_data_size_ble, &acl_buffer_count_ble, NULL, NULL);
+      }
 
-    // Response of 0 indicates ble has the same buffer size as classic
-    if (acl_data_size_ble == 0) acl_data_size_ble = acl_data_size_classic;
+      // Response of 0 indicates ble has the same buffer size as classic
+      if (acl_data_size_ble == 0) acl_data_size_ble = acl_data_size_classic;
 
-    // Request the ble supported states next
-    response = AWAIT_COMMAND(packet_factory->make_ble_read_supported_states());
-    packet_parser->parse_ble_read_supported_states_response(
-        response, ble_supported_states, sizeof(ble_supported_states));
+      response = AWAIT_RESPONSE(supported_states_future);
+      packet_parser->parse_ble_read_supported_states_response(
+          response, ble_supported_states, sizeof(ble_supported_states));
 
-    // Request the ble supported features next
-    response =
-        AWAIT_COMMAND(packet_factory->make_ble_read_local_supported_features());
-    packet_parser->parse_ble_read_local_supported_features_response(
-        response, &features_ble);
+      response = AWAIT_RESPONSE(ble_features_future);
+      packet_parser->parse_ble_read_local_supported_features_response(
+          response, &features_ble);
+      raw_features_ble = features_ble;
+    }
+
+    // The next commands only depend on the ble features, queue them together
+    future_t* iso_host_support_future = NULL;
+    future_t* subrating_host_support_future = NULL;
+    future_t* resolving_list_size_future = NULL;
+    future_t* data_length_future = NULL;
+    future_t* adv_data_length_future = NULL;
+    future_t* adv_sets_future = NULL;
 
     // Set Host support for Isochrnous channel management
-    if (adv_audio_support_mask > 0 && (HCI_LE_CIS_MASTER_SUPPORT(features_ble.as_array)
-          || HCI_LE_CIS_SLAVE_SUPPORT(features_ble.as_array))) { //TODO: Add BIS Support check
-      response = AWAIT_COMMAND(
+    if (adv_audio_support_mask > 0 &&
+        (HCI_LE_CIS_MASTER_SUPPORT(features_ble.as_array) ||
+         HCI_LE_CIS_SLAVE_SUPPORT(features_ble.as_array))) { //TODO: Add BIS Support check
+      iso_host_support_future = SEND_COMMAND(
           packet_factory->make_ble_set_host_feature_cmd(ISO_CHANNEL_HOST_SUPPORT_BIT, 1));
-      packet_parser->parse_ble_set_host_feature_cmd(response);
-      HCI_LE_SET_CIS_HOST_SUPPORT(features_ble.as_array);
     }
 
     // Set Host support for LE connection subrating
     if (HCI_LE_CONN_SUBRATING_SUPPORT(features_ble.as_array)) {
-      response = AWAIT_COMMAND(
+      subrating_host_support_future = SEND_COMMAND(
           packet_factory->make_ble_set_host_feature_cmd(CONN_SUBRATING_HOST_SUPPORT_BIT, 1));
+    }
+
+    if (!ble_restored && HCI_LE_ENHANCED_PRIVACY_SUPPORTED(features_ble.as_array)) {
+      resolving_list_size_future =
+          SEND_COMMAND(packet_factory->make_ble_read_resolving_list_size());
+    }
+
+    if (!ble_restored && HCI_LE_DATA_LEN_EXT_SUPPORTED(features_ble.as_array)) {
+      data_length_future = SEND_COMMAND(
+          packet_factory->make_ble_read_suggested_default_data_length());
+    }
+
+    if (!ble_restored &&
+        HCI_LE_EXTENDED_ADVERTISING_SUPPORTED(features_ble.as_array)) {
+      adv_data_length_future = SEND_COMMAND(
+          packet_factory->make_ble_read_maximum_advertising_data_length());
+      adv_sets_future = SEND_COMMAND(
+          packet_factory->make_ble_read_number_of_supported_advertising_sets());
+    }
+
+    if (iso_host_support_future) {
+      response = AWAIT_RESPONSE(iso_host_support_future);
+      packet_parser->parse_ble_set_host_feature_cmd(response);
+      HCI_LE_SET_CIS_HOST_SUPPORT(features_ble.as_array);
+    }
+
+    if (subrating_host_support_future) {
+      response = AWAIT_RESPONSE(subrating_host_support_future);
       packet_parser->parse_ble_set_host_feature_cmd(response);
       HCI_LE_SET_CONN_SUBRATING_HOST_SUPPORT(features_ble.as_array);
     }
 
-    if (HCI_LE_ENHANCED_PRIVACY_SUPPORTED(features_ble.as_array)) {
-      response =
-          AWAIT_COMMAND(packet_factory->make_ble_read_resolving_list_size());
+    if (resolving_list_size_future) {
+      response = AWAIT_RESPONSE(resolving_list_size_future);
       packet_parser->parse_ble_read_resolving_list_size_response(
           response, &ble_resolving_list_max_size);
     }
 
-    if (HCI_LE_DATA_LEN_EXT_SUPPORTED(features_ble.as_array)) {
-      response = AWAIT_COMMAND(
-          packet_factory->make_ble_read_suggested_default_data_length());
+    if (data_length_future) {
+      response = AWAIT_RESPONSE(data_length_future);
       packet_parser->parse_ble_read_suggested_default_data_length_response(
           response, &ble_suggested_default_data_length);
     }
 
-    if (HCI_LE_EXTENDED_ADVERTISING_SUPPORTED(features_ble.as_array)) {
-      response = AWAIT_COMMAND(
-          packet_factory->make_ble_read_maximum_advertising_data_length());
+    if (adv_data_length_future) {
+      response = AWAIT_RESPONSE(adv_data_length_future);
       packet_parser->parse_ble_read_maximum_advertising_data_length(
           response, &ble_maxium_advertising_data_length);
 
-      response = AWAIT_COMMAND(
-          packet_factory->make_ble_read_number_of_supported_advertising_sets());
+      response = AWAIT_RESPONSE(adv_sets_future);
       packet_parser->parse_ble_read_number_of_supported_advertising_sets(
           response, &ble_number_of_supported_advertising_sets);
-    } else {
+    } else if (!HCI_LE_EXTENDED_ADVERTISING_SUPPORTED(features_ble.as_array)) {
       /* If LE Excended Advertising is not supported, use the default value */
       ble_maxium_advertising_data_length = 31;
     }
@@ -617,6 +860,8 @@ static future_t* start_up(void) {
     packet_parser->parse_generic_command_complete(response);
   }
 
+  if (save_snapshot) controller_snapshot_save(&raw_features_ble);
+
   if (simple_pairing_supported) {
     response =
         AWAIT_COMMAND(packet_factory->make_set_event_mask(&CLASSIC_EVENT_MASK));
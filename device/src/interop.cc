@@ -21,6 +21,10 @@
 #include <base/logging.h>
 #include <string.h>  // For memcmp
 
+#include <bitset>
+#include <mutex>
+#include <vector>
+
 #include "btcore/include/module.h"
 #include "device/include/interop.h"
 #include "device/include/interop_database.h"
@@ -32,15 +36,55 @@
   case const:                  \
     return #const;
 
+// Number of devices whose address matches are memoized
+#define INTEROP_DEVICE_CACHE_SIZE 16
+
+typedef std::bitset<END_OF_INTEROP_LIST> interop_feature_set_t;
+
+// Node of a prefix trie, over address bytes or name characters. The
+// features of a node apply to everything starting with the path to it.
+typedef struct {
+  uint8_t key;
+  std::vector<uint16_t> children;  // Indexes of the children, sorted by key
+  interop_feature_set_t features;
+} interop_trie_node_t;
+
+typedef std::vector<interop_trie_node_t> interop_trie_t;
+
+typedef struct {
+  RawAddress addr;
+  interop_feature_set_t features;
+} interop_device_t;
+
 static list_t* interop_list = NULL;
 
+// Protects the tries and the device cache below
+static std::mutex interop_lock;
+
+// Built from the fixed databases on first use, the address trie is rebuilt
+// with the dynamic entries whenever they change.
+static interop_trie_t interop_addr_trie;
+static interop_trie_t interop_name_trie;
+static bool interop_tries_built = false;
+
+// Features matching the address of recently checked devices. A device is
+// matched against the address trie once; later checks only test a bit.
+static interop_device_t interop_device_cache[INTEROP_DEVICE_CACHE_SIZE];
+static size_t interop_device_cache_count = 0;
+static size_t interop_device_cache_next = 0;
+
 static const char* interop_feature_string_(const interop_feature_t feature);
 static void interop_free_entry_(void* data);
 static void interop_lazy_init_(void);
-static bool interop_match_fixed_(const interop_feature_t feature,
-                                 const RawAddress* addr);
-static bool interop_match_dynamic_(const interop_feature_t feature,
-                                   const RawAddress* addr);
+static void interop_build_tries_(void);
+static void interop_build_addr_trie_(void);
+static void interop_trie_insert_(interop_trie_t* trie, const uint8_t* key,
+                                 size_t length,
+                                 const interop_feature_t feature);
+static interop_feature_set_t interop_trie_match_(const interop_trie_t& trie,
+                                                 const uint8_t* key,
+                                                 size_t length);
+static interop_feature_set_t interop_device_features_(const RawAddress* addr);
 
 // Interface functions
 
@@ -48,8 +92,7 @@ bool interop_match_addr(const interop_feature_t feature,
                         const RawAddress* addr) {
   CHECK(addr);
 
-  if (interop_match_fixed_(feature, addr) ||
-      interop_match_dynamic_(feature, addr)) {
+  if (interop_device_features_(addr).test(feature)) {
     LOG_WARN(LOG_TAG, "%s() Device %s is a match for interop workaround %s.",
              __func__, addr->ToString().c_str(),
              interop_feature_string_(feature));
@@ -62,21 +105,22 @@ bool interop_match_addr(const interop_feature_t feature,
 bool interop_match_name(const interop_feature_t feature, const char* name) {
   CHECK(name);
 
-  const size_t db_size =
-      sizeof(interop_name_database) / sizeof(interop_name_entry_t);
-  for (size_t i = 0; i != db_size; ++i) {
-    if (feature == interop_name_database[i].feature &&
-        strlen(name) >= interop_name_database[i].length &&
-        strncmp(name, interop_name_database[i].name,
-                interop_name_database[i].length) == 0) {
-      LOG_WARN(LOG_TAG,
-               "%s() Device with name: %s is a match for interop workaround %s",
-               __func__, name, interop_feature_string_(feature));
-      return true;
-    }
+  bool match;
+  {
+    std::lock_guard<std::mutex> lock(interop_lock);
+    interop_build_tries_();
+    match = interop_trie_match_(interop_name_trie,
+                                reinterpret_cast<const uint8_t*>(name),
+                                strlen(name))
+                .test(feature);
   }
 
-  return false;
+  if (match) {
+    LOG_WARN(LOG_TAG,
+             "%s() Device with name: %s is a match for interop workaround %s",
+             __func__, name, interop_feature_string_(feature));
+  }
+  return match;
 }
 
 bool interop_match_manufacturer(const interop_feature_t feature,
@@ -130,19 +174,29 @@ void interop_database_add(const uint16_t feature, const RawAddress* addr,
   entry->feature = static_cast<interop_feature_t>(feature);
   entry->length = length;
 
+  std::lock_guard<std::mutex> lock(interop_lock);
   interop_lazy_init_();
   list_append(interop_list, entry);
+  if (interop_tries_built) interop_build_addr_trie_();
 }
 
 void interop_database_clear() {
+  std::lock_guard<std::mutex> lock(interop_lock);
   if (interop_list) list_clear(interop_list);
+  if (interop_tries_built) interop_build_addr_trie_();
 }
 
 // Module life-cycle functions
 
 static future_t* interop_clean_up(void) {
+  std::lock_guard<std::mutex> lock(interop_lock);
   list_free(interop_list);
   interop_list = NULL;
+  interop_addr_trie.clear();
+  interop_name_trie.clear();
+  interop_tries_built = false;
+  interop_device_cache_count = 0;
+  interop_device_cache_next = 0;
   return future_new_immediate(FUTURE_SUCCESS);
 }
 
@@ -151,7 +205,7 @@ EXPORT_SYMBOL module_t interop_module = {
     .init = NULL,
     .start_up = NULL,
     .shut_down = NULL,
-    .clean_up = interop_clean_up
+    .clean_up = interop_clean_up,
     .dependencies = {NULL},
 };
 
@@ -189,38 +243,110 @@ static void interop_lazy_init_(void) {
   }
 }
 
-static bool interop_match_dynamic_(const interop_feature_t feature,
-                                   const RawAddress* addr) {
-  if (interop_list == NULL || list_length(interop_list) == 0) return false;
+// Must be called with |interop_lock| held
+static void interop_build_tries_(void) {
+  if (interop_tries_built) return;
 
-  const list_node_t* node = list_begin(interop_list);
-  while (node != list_end(interop_list)) {
-    interop_addr_entry_t* entry =
-        static_cast<interop_addr_entry_t*>(list_node(node));
-    CHECK(entry);
+  interop_name_trie.assign(1, interop_trie_node_t());
+  const size_t db_size =
+      sizeof(interop_name_database) / sizeof(interop_name_entry_t);
+  for (size_t i = 0; i != db_size; ++i) {
+    interop_trie_insert_(
+        &interop_name_trie,
+        reinterpret_cast<const uint8_t*>(interop_name_database[i].name),
+        interop_name_database[i].length, interop_name_database[i].feature);
+  }
 
-    if (feature == entry->feature &&
-        memcmp(addr, &entry->addr, entry->length) == 0)
-      return true;
+  interop_build_addr_trie_();
+  interop_tries_built = true;
+}
 
-    node = list_next(node);
+// Rebuilds the address trie from the dynamic entries; the fixed address
+// database is disabled in interop_database.h. Must be called with
+// |interop_lock| held.
+static void interop_build_addr_trie_(void) {
+  interop_addr_trie.assign(1, interop_trie_node_t());
+
+  if (interop_list != NULL) {
+    for (const list_node_t* node = list_begin(interop_list);
+         node != list_end(interop_list); node = list_next(node)) {
+      interop_addr_entry_t* entry =
+          static_cast<interop_addr_entry_t*>(list_node(node));
+      CHECK(entry);
+      interop_trie_insert_(&interop_addr_trie, entry->addr.address,
+                           entry->length, entry->feature);
+    }
   }
-  return false;
-}
 
-static bool interop_match_fixed_(const interop_feature_t feature,
-                                 const RawAddress* addr) {
-  CHECK(addr);
+  // Cached matches may be stale now
+  interop_device_cache_count = 0;
+  interop_device_cache_next = 0;
+}
 
-  const size_t db_size =
-      sizeof(interop_addr_database) / sizeof(interop_addr_entry_t);
-  for (size_t i = 0; i != db_size; ++i) {
-    if (feature == interop_addr_database[i].feature &&
-        memcmp(addr, &interop_addr_database[i].addr,
-               interop_addr_database[i].length) == 0) {
-      return true;
+static void interop_trie_insert_(interop_trie_t* trie, const uint8_t* key,
+                                 size_t length,
+                                 const interop_feature_t feature) {
+  if (feature < BEGINING_OF_INTEROP_LIST || feature >= END_OF_INTEROP_LIST)
+    return;
+
+  size_t node = 0;
+  for (size_t depth = 0; depth != length; ++depth) {
+    std::vector<uint16_t>& children = (*trie)[node].children;
+    auto it = children.begin();
+    while (it != children.end() && (*trie)[*it].key < key[depth]) ++it;
+
+    if (it != children.end() && (*trie)[*it].key == key[depth]) {
+      node = *it;
+      continue;
     }
+
+    CHECK(trie->size() < UINT16_MAX);
+    uint16_t child = trie->size();
+    children.insert(it, child);
+    trie->push_back(interop_trie_node_t());
+    trie->back().key = key[depth];
+    node = child;
   }
+  (*trie)[node].features.set(feature);
+}
 
-  return false;
+// Returns the features of all entries that are a prefix of |key|
+static interop_feature_set_t interop_trie_match_(const interop_trie_t& trie,
+                                                 const uint8_t* key,
+                                                 size_t length) {
+  interop_feature_set_t features;
+  if (trie.empty()) return features;
+
+  size_t node = 0;
+  for (size_t depth = 0; depth != length; ++depth) {
+    const std::vector<uint16_t>& children = trie[node].children;
+    auto it = children.begin();
+    while (it != children.end() && trie[*it].key < key[depth]) ++it;
+    if (it == children.end() || trie[*it].key != key[depth]) break;
+
+    node = *it;
+    features |= trie[node].features;
+  }
+  return features;
+}
+
+static interop_feature_set_t interop_device_features_(const RawAddress* addr) {
+  std::lock_guard<std::mutex> lock(interop_lock);
+  interop_build_tries_();
+
+  for (size_t i = 0; i != interop_device_cache_count; ++i) {
+    if (interop_device_cache[i].addr == *addr)
+      return interop_device_cache[i].features;
+  }
+
+  interop_device_t& device = interop_device_cache[interop_device_cache_next];
+  device.addr = *addr;
+  device.features =
+      interop_trie_match_(interop_addr_trie, addr->address, RawAddress::kLength);
+
+  interop_device_cache_next =
+      (interop_device_cache_next + 1) % INTEROP_DEVICE_CACHE_SIZE;
+  if (interop_device_cache_count < INTEROP_DEVICE_CACHE_SIZE)
+    interop_device_cache_count++;
+  return device.features;
 }
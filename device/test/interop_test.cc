@@ -67,6 +67,27 @@ TEST(InteropTest, test_dynamic) {
   EXPECT_FALSE(interop_match_addr(INTEROP_AUTO_RETRY_PAIRING, &test_address));
 }
 
+TEST(InteropTest, test_dynamic_nested_prefixes) {
+  RawAddress test_address;
+  RawAddress::FromString("aa:bb:cc:dd:ee:ff", test_address);
+  interop_database_add(INTEROP_DISABLE_ROLE_SWITCH, &test_address, 3);
+  EXPECT_TRUE(interop_match_addr(INTEROP_DISABLE_ROLE_SWITCH, &test_address));
+  EXPECT_FALSE(interop_match_addr(INTEROP_2MBPS_LINK_ONLY, &test_address));
+
+  // The match above is cached; adding a longer prefix must still be seen
+  interop_database_add(INTEROP_2MBPS_LINK_ONLY, &test_address, 5);
+  EXPECT_TRUE(interop_match_addr(INTEROP_DISABLE_ROLE_SWITCH, &test_address));
+  EXPECT_TRUE(interop_match_addr(INTEROP_2MBPS_LINK_ONLY, &test_address));
+
+  RawAddress other_address;
+  RawAddress::FromString("aa:bb:cc:dd:00:ff", other_address);
+  EXPECT_TRUE(interop_match_addr(INTEROP_DISABLE_ROLE_SWITCH, &other_address));
+  EXPECT_FALSE(interop_match_addr(INTEROP_2MBPS_LINK_ONLY, &other_address));
+
+  interop_database_clear();
+  EXPECT_FALSE(interop_match_addr(INTEROP_DISABLE_ROLE_SWITCH, &test_address));
+}
+
 TEST(InteropTest, test_name_hit) {
   EXPECT_TRUE(interop_match_name(INTEROP_DISABLE_AUTO_PAIRING, "BMW M3"));
   EXPECT_TRUE(interop_match_name(INTEROP_DISABLE_AUTO_PAIRING, "Audi"));
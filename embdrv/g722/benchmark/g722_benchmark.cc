@@ -0,0 +1,124 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+
+// Measures the G.722 encoder and decoder on hearing aid frames: 20 ms of PCM
+// at 16 kHz and 24 kHz, one channel at a time and as a binaural pair.
+
+#include <benchmark/benchmark.h>
+
+#include <math.h>
+#include <vector>
+
+#include "g722_enc_dec.h"
+
+using ::benchmark::State;
+
+static std::vector<int16_t> make_pcm(size_t samples, double step) {
+  std::vector<int16_t> pcm(samples);
+  for (size_t i = 0; i < samples; i++) {
+    pcm[i] = (int16_t)(12000 * sin(i * step) + 3000 * sin(i * step * 7.3));
+  }
+  return pcm;
+}
+
+// |state.range(0)| is the sample rate in Hz
+static size_t frame_samples(State& state) { return state.range(0) / 50; }
+
+static void BM_G722Encode(State& state) {
+  size_t samples = frame_samples(state);
+  std::vector<int16_t> pcm = make_pcm(samples, 0.031);
+  std::vector<uint8_t> out(samples);
+  g722_encode_state_t enc;
+  g722_encode_init(&enc, 64000, G722_PACKED);
+
+  for (auto _ : state) {
+    ::benchmark::DoNotOptimize(
+        g722_encode(&enc, out.data(), pcm.data(), samples));
+  }
+  state.SetItemsProcessed(state.iterations() * samples);
+}
+
+static void BM_G722EncodeTwoMono(State& state) {
+  size_t samples = frame_samples(state);
+  std::vector<int16_t> left = make_pcm(samples, 0.031);
+  std::vector<int16_t> right = make_pcm(samples, 0.017);
+  std::vector<uint8_t> out_left(samples);
+  std::vector<uint8_t> out_right(samples);
+  g722_encode_state_t enc_left;
+  g722_encode_state_t enc_right;
+  g722_encode_init(&enc_left, 64000, G722_PACKED);
+  g722_encode_init(&enc_right, 64000, G722_PACKED);
+
+  for (auto _ : state) {
+    ::benchmark::DoNotOptimize(
+        g722_encode(&enc_left, out_left.data(), left.data(), samples));
+    ::benchmark::DoNotOptimize(
+        g722_encode(&enc_right, out_right.data(), right.data(), samples));
+  }
+  state.SetItemsProcessed(state.iterations() * samples * 2);
+}
+
+static void BM_G722EncodeStereo(State& state) {
+  size_t samples = frame_samples(state);
+  std::vector<int16_t> left = make_pcm(samples, 0.031);
+  std::vector<int16_t> right = make_pcm(samples, 0.017);
+  std::vector<uint8_t> out_left(samples);
+  std::vector<uint8_t> out_right(samples);
+  g722_encode_state_t enc_left;
+  g722_encode_state_t enc_right;
+  g722_encode_init(&enc_left, 64000, G722_PACKED);
+  g722_encode_init(&enc_right, 64000, G722_PACKED);
+
+  for (auto _ : state) {
+    ::benchmark::DoNotOptimize(g722_encode_stereo(
+        &enc_left, &enc_right, out_left.data(), out_right.data(), left.data(),
+        right.data(), samples));
+  }
+  state.SetItemsProcessed(state.iterations() * samples * 2);
+}
+
+static void BM_G722Decode(State& state) {
+  size_t samples = frame_samples(state);
+  std::vector<int16_t> pcm = make_pcm(samples, 0.031);
+  std::vector<uint8_t> coded(samples);
+  g722_encode_state_t enc;
+  g722_encode_init(&enc, 64000, G722_PACKED);
+  int coded_len = g722_encode(&enc, coded.data(), pcm.data(), samples);
+
+  g722_decode_state_t dec;
+  g722_decode_init(&dec, 64000, G722_PACKED);
+  for (auto _ : state) {
+    ::benchmark::DoNotOptimize(
+        g722_decode(&dec, pcm.data(), coded.data(), coded_len, 0xFFFF));
+  }
+  state.SetItemsProcessed(state.iterations() * samples);
+}
+
+BENCHMARK(BM_G722Encode)->Arg(16000)->Arg(24000);
+BENCHMARK(BM_G722EncodeTwoMono)->Arg(16000)->Arg(24000);
+BENCHMARK(BM_G722EncodeStereo)->Arg(16000)->Arg(24000);
+BENCHMARK(BM_G722Decode)->Arg(16000)->Arg(24000);
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
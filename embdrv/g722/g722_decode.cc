@@ -30,6 +30,7 @@
 
 #include "g722_typedefs.h"
 #include "g722_enc_dec.h"
+#include "g722_qmf.h"
 
 #if !defined(FALSE)
 #define FALSE 0
@@ -252,168 +253,195 @@ static int16_t qm6[64] =
       1688,   1360,   1040,    728,
        432,    136,   -432,   -136
 };
-static int16_t qmf_coeffs_even[12] =
+/* Receive QMF taps, laid out for g722_qmf_block(). The even filter reads the
+   sums and the odd filter the differences of the two bands. */
+static const int16_t qmf_even[G722_QMF_TAPS] =
 {
-      3,  -11,   12,   32, -210,  951, 3876, -805,  362, -156,   53,  -11,
+       3,    0,  -11,    0,   12,    0,   32,    0,
+    -210,    0,  951,    0, 3876,    0, -805,    0,
+     362,    0, -156,    0,   53,    0,  -11,    0
 };
-static int16_t qmf_coeffs_odd[12] =
+static const int16_t qmf_odd[G722_QMF_TAPS] =
 {
-    -11,   53, -156,  362, -805, 3876, 951,  -210,   32,   12,  -11,    3
+       0,  -11,    0,   53,    0, -156,    0,  362,
+       0, -805,    0, 3876,    0,  951,    0, -210,
+       0,   32,    0,   12,    0,  -11,    0,    3
 };
 
-uint32_t g722_decode(g722_decode_state_t *s, int16_t amp[], const uint8_t g722_data[], int len, uint16_t gain)
+/* Runs the two ADPCM bands over one code and leaves the reconstructed low and
+   high band samples in |rlow| and |rhigh|. */
+static __inline void decode_code(g722_decode_state_t *s, int code, int *rlow,
+                                 int *rhigh)
 {
-
     int dlowt;
-    int rlow;
     int ihigh;
     int dhigh;
-    int rhigh;
-    int xout1;
-    int xout2;
+    int rl;
+    int rh;
     int wd1;
     int wd2;
     int wd3;
+
+#if BITS_PER_SAMPLE == 8
+    wd1 = code & 0x3F;
+    ihigh = (code >> 6) & 0x03;
+    wd2 = qm6[wd1];
+    wd1 >>= 2;
+#elif BITS_PER_SAMPLE == 7
+    wd1 = code & 0x1F;
+    ihigh = (code >> 5) & 0x03;
+    wd2 = qm5[wd1];
+    wd1 >>= 1;
+#elif BITS_PER_SAMPLE == 6
+   wd1 = code & 0x0F;
+   ihigh = (code >> 4) & 0x03;
+   wd2 = qm4[wd1];
+#endif
+    /* Block 5L, LOW BAND INVQBL */
+    wd2 = (s->band[0].det*wd2) >> 15;
+    /* Block 5L, RECONS */
+    rl = s->band[0].s + wd2;
+    /* Block 6L, LIMIT */
+
+    // ANDREA
+    // rlow=ssat(rlow,2<<14)
+    if (rl > 16383)
+    {
+        rl = 16383;
+    }
+    else if (rl < -16384)
+    {
+        rl = -16384;
+    }
+
+    /* Block 2L, INVQAL */
+    wd2 = qm4[wd1];
+    dlowt = (s->band[0].det*wd2) >> 15;
+
+    /* Block 3L, LOGSCL */
+    wd2 = rl42[wd1];
+    wd1 = (s->band[0].nb*127) >> 7;
+    wd1 += wl[wd2];
+    if (wd1 < 0)
+    {
+        wd1 = 0;
+    }
+    else if (wd1 > 18432)
+    {
+        wd1 = 18432;
+    }
+    s->band[0].nb = wd1;
+
+    /* Block 3L, SCALEL */
+    wd1 = (s->band[0].nb >> 6) & 31;
+    wd2 = 8 - (s->band[0].nb >> 11);
+    wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
+    s->band[0].det = wd3 << 2;
+
+    block4(&s->band[0], dlowt);
+
+    /* Block 2H, INVQAH */
+    wd2 = qm2[ihigh];
+    dhigh = (s->band[1].det*wd2) >> 15;
+    /* Block 5H, RECONS */
+    rh = dhigh + s->band[1].s;
+    /* Block 6H, LIMIT */
+
+    // ANDREA
+    // rhigh=ssat(rhigh,2<<14)
+
+    if (rh > 16383)
+        rh = 16383;
+    else if (rh < -16384)
+        rh = -16384;
+
+    /* Block 2H, INVQAH */
+    wd2 = rh2[ihigh];
+    wd1 = (s->band[1].nb*127) >> 7;
+    wd1 += wh[wd2];
+    if (wd1 < 0)
+        wd1 = 0;
+    else if (wd1 > 22528)
+        wd1 = 22528;
+    s->band[1].nb = wd1;
+
+    /* Block 3H, SCALEH */
+    wd1 = (s->band[1].nb >> 6) & 31;
+    wd2 = 10 - (s->band[1].nb >> 11);
+    wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
+    s->band[1].det = wd3 << 2;
+
+    block4(&s->band[1], dhigh);
+
+    *rlow = rl;
+    *rhigh = rh;
+}
+/*- End of function --------------------------------------------------------*/
+
+uint32_t g722_decode(g722_decode_state_t *s, int16_t amp[], const uint8_t g722_data[], int len, uint16_t gain)
+{
+    /* QMF input: the filter history followed by one block of band sums and
+       differences */
+    int16_t w[G722_QMF_HISTORY + 2*G722_QMF_BLOCK_PAIRS];
+    int32_t xout2[G722_QMF_BLOCK_PAIRS];
+    int32_t xout1[G722_QMF_BLOCK_PAIRS];
+    int rlow;
+    int rhigh;
+    int out1;
+    int out2;
     int code;
+    int pairs;
     uint32_t outlen;
     int i;
     int j;
 
     outlen = 0;
-    rhigh = 0;
 
     for (j = 0;  j < len;  )
     {
-#if PACKED_INPUT == 1
-        /* Unpack the code bits */
-        if (s->in_bits < s->bits_per_sample)
+        for (i = 0;  i < G722_QMF_HISTORY;  i++)
+            w[i] = (int16_t) s->x[i + 2];
+
+        /* Run the ADPCM over a block of codes first, then the receive QMF
+           over the whole block */
+        for (pairs = 0;  pairs < G722_QMF_BLOCK_PAIRS  &&  j < len;  pairs++)
         {
-            s->in_buffer |= (g722_data[j++] << s->in_bits);
-            s->in_bits += 8;
-        }
-        code = s->in_buffer & ((1 << s->bits_per_sample) - 1);
-        s->in_buffer >>= s->bits_per_sample;
-        s->in_bits -= s->bits_per_sample;
+#if PACKED_INPUT == 1
+            /* Unpack the code bits */
+            if (s->in_bits < s->bits_per_sample)
+            {
+                s->in_buffer |= (g722_data[j++] << s->in_bits);
+                s->in_bits += 8;
+            }
+            code = s->in_buffer & ((1 << s->bits_per_sample) - 1);
+            s->in_buffer >>= s->bits_per_sample;
+            s->in_bits -= s->bits_per_sample;
 #else
-        code = g722_data[j++];
-#endif
-
-#if BITS_PER_SAMPLE == 8
-        wd1 = code & 0x3F;
-        ihigh = (code >> 6) & 0x03;
-        wd2 = qm6[wd1];
-        wd1 >>= 2;
-#elif BITS_PER_SAMPLE == 7
-        wd1 = code & 0x1F;
-        ihigh = (code >> 5) & 0x03;
-        wd2 = qm5[wd1];
-        wd1 >>= 1;
-#elif BITS_PER_SAMPLE == 6
-       wd1 = code & 0x0F;
-       ihigh = (code >> 4) & 0x03;
-       wd2 = qm4[wd1];
+            code = g722_data[j++];
 #endif
-        /* Block 5L, LOW BAND INVQBL */
-        wd2 = (s->band[0].det*wd2) >> 15;
-        /* Block 5L, RECONS */
-        rlow = s->band[0].s + wd2;
-        /* Block 6L, LIMIT */
-
-        // ANDREA
-        // rlow=ssat(rlow,2<<14)
-        if (rlow > 16383)
-        {
-            rlow = 16383;
-        }
-        else if (rlow < -16384)
-        {
-            rlow = -16384;
+            decode_code(s, code, &rlow, &rhigh);
+            w[G722_QMF_HISTORY + 2*pairs] = (int16_t) (rlow + rhigh);
+            w[G722_QMF_HISTORY + 2*pairs + 1] = (int16_t) (rlow - rhigh);
         }
 
-        /* Block 2L, INVQAL */
-        wd2 = qm4[wd1];
-        dlowt = (s->band[0].det*wd2) >> 15;
+        g722_qmf_block(w, pairs, qmf_even, qmf_odd, xout2, xout1);
+        for (i = 0;  i < G722_QMF_TAPS;  i++)
+            s->x[i] = w[2*pairs - 2 + i];
 
-        /* Block 3L, LOGSCL */
-        wd2 = rl42[wd1];
-        wd1 = (s->band[0].nb*127) >> 7;
-        wd1 += wl[wd2];
-        if (wd1 < 0)
-        {
-            wd1 = 0;
-        }
-        else if (wd1 > 18432)
-        {
-            wd1 = 18432;
-        }
-        s->band[0].nb = wd1;
-
-        /* Block 3L, SCALEL */
-        wd1 = (s->band[0].nb >> 6) & 31;
-        wd2 = 8 - (s->band[0].nb >> 11);
-        wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
-        s->band[0].det = wd3 << 2;
-
-        block4(&s->band[0], dlowt);
-
-        /* Block 2H, INVQAH */
-        wd2 = qm2[ihigh];
-        dhigh = (s->band[1].det*wd2) >> 15;
-        /* Block 5H, RECONS */
-        rhigh = dhigh + s->band[1].s;
-        /* Block 6H, LIMIT */
-
-        // ANDREA
-        // rhigh=ssat(rhigh,2<<14)
-
-        if (rhigh > 16383)
-            rhigh = 16383;
-        else if (rhigh < -16384)
-            rhigh = -16384;
-
-        /* Block 2H, INVQAH */
-        wd2 = rh2[ihigh];
-        wd1 = (s->band[1].nb*127) >> 7;
-        wd1 += wh[wd2];
-        if (wd1 < 0)
-            wd1 = 0;
-        else if (wd1 > 22528)
-            wd1 = 22528;
-        s->band[1].nb = wd1;
-
-        /* Block 3H, SCALEH */
-        wd1 = (s->band[1].nb >> 6) & 31;
-        wd2 = 10 - (s->band[1].nb >> 11);
-        wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
-        s->band[1].det = wd3 << 2;
-
-        block4(&s->band[1], dhigh);
-
-        /* Apply the receive QMF */
-        for (i = 0;  i < 22;  i++)
-            s->x[i] = s->x[i + 2];
-        s->x[22] = rlow + rhigh;
-        s->x[23] = rlow - rhigh;
-
-        // we should get PERF numbers for the following loop
-        xout1 = 0;
-        xout2 = 0;
-        for (i = 0;  i < 12;  i++)
-        {
-            xout2 += s->x[2*i]   * qmf_coeffs_even[i];
-            xout1 += s->x[2*i+1] * qmf_coeffs_odd[i];
-        }
-        xout1 = NLDECOMPRESS_PREPROCESS_SAMPLE_WITH_GAIN((int16_t) __ssat16(xout1 >> 11), gain);
-        xout2 = NLDECOMPRESS_PREPROCESS_SAMPLE_WITH_GAIN((int16_t) __ssat16(xout2 >> 11), gain);
-        if (s->dac_pcm)
-        {
-            amp[outlen++] = ((int16_t) (xout1 >> 4) + 2048);
-            amp[outlen++] = ((int16_t) (xout2 >> 4) + 2048);
-        }
-        else
+        for (i = 0;  i < pairs;  i++)
         {
-            amp[outlen++] = xout1;
-            amp[outlen++] = xout2;
+            out1 = NLDECOMPRESS_PREPROCESS_SAMPLE_WITH_GAIN((int16_t) __ssat16(xout1[i] >> 11), gain);
+            out2 = NLDECOMPRESS_PREPROCESS_SAMPLE_WITH_GAIN((int16_t) __ssat16(xout2[i] >> 11), gain);
+            if (s->dac_pcm)
+            {
+                amp[outlen++] = ((int16_t) (out1 >> 4) + 2048);
+                amp[outlen++] = ((int16_t) (out2 >> 4) + 2048);
+            }
+            else
+            {
+                amp[outlen++] = out1;
+                amp[outlen++] = out2;
+            }
         }
     }
     return outlen;
@@ -31,6 +31,7 @@
 
 #include "g722_typedefs.h"
 #include "g722_enc_dec.h"
+#include "g722_qmf.h"
 
 #if !defined(FALSE)
 #define FALSE 0
@@ -259,17 +260,51 @@ static int16_t qm2[4] =
 {
     -7408,  -1616,   7408,   1616
 };
-static int16_t qmf_coeffs[12] =
-{
-       3,  -11,   12,   32, -210,  951, 3876, -805,  362, -156,   53,  -11,
-};
 static int16_t ihn[3] = {0, 1, 0};
 static int16_t ihp[3] = {0, 3, 2};
 static int16_t wh[3] = {0, -214, 798};
 static int16_t rh2[4] = {2, 1, 2, 1};
 
-int g722_encode(g722_encode_state_t *s, uint8_t g722_data[],
-                       const int16_t amp[], int len)
+/* Even and odd taps of the transmit QMF, interleaved for g722_qmf_block().
+   The sum filter gives the low band and the difference filter the high band. */
+static const int16_t qmf_sum[G722_QMF_TAPS] =
+{
+       3,  -11,  -11,   53,   12, -156,   32,  362,
+    -210, -805,  951, 3876, 3876,  951, -805, -210,
+     362,   32, -156,   12,   53,  -11,  -11,    3
+};
+static const int16_t qmf_diff[G722_QMF_TAPS] =
+{
+      -3,  -11,   11,   53,  -12, -156,  -32,  362,
+     210, -805, -951, 3876,-3876,  951,  805, -210,
+    -362,   32,  156,   12,  -53,  -11,   11,    3
+};
+
+/* Block 1L, QUANTL. The decision levels grow with the index, so the first
+   level above |wd| is found with a binary search over 1 .. 29. */
+static __inline int quantl(int wd, int det)
+{
+    int lo;
+    int hi;
+    int mid;
+
+    lo = 1;
+    hi = 30;
+    while (lo < hi)
+    {
+        mid = (lo + hi) >> 1;
+        if (wd < ((q6[mid]*det) >> 12))
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Runs the two ADPCM bands over one pair of sub-band samples and returns the
+   code for the pair. */
+static __inline int encode_sample(g722_encode_state_t *s, int xlow, int xhigh)
 {
     int dlow;
     int dhigh;
@@ -284,153 +319,221 @@ int g722_encode(g722_encode_state_t *s, uint8_t g722_data[],
     int eh;
     int mih;
     int i;
-    int j;
-    /* Low and high band PCM from the QMF */
-    int xlow;
-    int xhigh;
-    int g722_bytes;
-    /* Even and odd tap accumulators */
-    int sumeven;
-    int sumodd;
     int ihigh;
     int ilow;
     int code;
 
-    g722_bytes = 0;
-    xhigh = 0;
-    for (j = 0;  j < len;  )
-    {
-        if (s->itu_test_mode)
-        {
-            xlow =
-            xhigh = amp[j++] >> 1;
-        }
-        else
-        {
-            {
-                /* Apply the transmit QMF */
-                /* Shuffle the buffer down */
-                for (i = 0;  i < 22;  i++)
-                    s->x[i] = s->x[i + 2];
-                //TODO: if len is odd, then this can be a buffer overrun
-                s->x[22] = amp[j++];
-                s->x[23] = amp[j++];
-
-                /* Discard every other QMF output */
-                sumeven = 0;
-                sumodd = 0;
-                for (i = 0;  i < 12;  i++)
-                {
-                    sumodd += s->x[2*i]*qmf_coeffs[i];
-                    sumeven += s->x[2*i + 1]*qmf_coeffs[11 - i];
-                }
-                /* We shift by 12 to allow for the QMF filters (DC gain = 4096), plus 1
-                   to allow for us summing two filters, plus 1 to allow for the 15 bit
-                   input to the G.722 algorithm. */
-                xlow = (sumeven + sumodd) >> 14;
-                xhigh = (sumeven - sumodd) >> 14;
-
 #ifdef RUN_LIKE_REFERENCE_G722
-                /* The following lines are only used to verify bit-exactness
-                 * with reference implementation of G.722. Higher precision
-                 * is achieved without limiting the values.
-                 */
-                xlow = limitValues(xlow);
-                xhigh = limitValues(xhigh);
+    /* The following lines are only used to verify bit-exactness
+     * with reference implementation of G.722. Higher precision
+     * is achieved without limiting the values.
+     */
+    if (!s->itu_test_mode)
+    {
+        xlow = limitValues(xlow);
+        xhigh = limitValues(xhigh);
+    }
 #endif
-            }
-        }
-        /* Block 1L, SUBTRA */
-        el = saturate(xlow - s->band[0].s);
-
-        /* Block 1L, QUANTL */
-        wd = (el >= 0)  ?  el  :  -(el + 1);
-
-        for (i = 1;  i < 30;  i++)
-        {
-            wd1 = (q6[i]*s->band[0].det) >> 12;
-            if (wd < wd1)
-                break;
-        }
-        ilow = (el < 0)  ?  iln[i]  :  ilp[i];
-
-        /* Block 2L, INVQAL */
-        ril = ilow >> 2;
-        wd2 = qm4[ril];
-        dlow = (s->band[0].det*wd2) >> 15;
-
-        /* Block 3L, LOGSCL */
-        il4 = rl42[ril];
-        wd = (s->band[0].nb*127) >> 7;
-        s->band[0].nb = wd + wl[il4];
-        if (s->band[0].nb < 0)
-            s->band[0].nb = 0;
-        else if (s->band[0].nb > 18432)
-            s->band[0].nb = 18432;
-
-        /* Block 3L, SCALEL */
-        wd1 = (s->band[0].nb >> 6) & 31;
-        wd2 = 8 - (s->band[0].nb >> 11);
+    /* Block 1L, SUBTRA */
+    el = saturate(xlow - s->band[0].s);
+
+    /* Block 1L, QUANTL */
+    wd = (el >= 0)  ?  el  :  -(el + 1);
+
+    i = quantl(wd, s->band[0].det);
+    ilow = (el < 0)  ?  iln[i]  :  ilp[i];
+
+    /* Block 2L, INVQAL */
+    ril = ilow >> 2;
+    wd2 = qm4[ril];
+    dlow = (s->band[0].det*wd2) >> 15;
+
+    /* Block 3L, LOGSCL */
+    il4 = rl42[ril];
+    wd = (s->band[0].nb*127) >> 7;
+    s->band[0].nb = wd + wl[il4];
+    if (s->band[0].nb < 0)
+        s->band[0].nb = 0;
+    else if (s->band[0].nb > 18432)
+        s->band[0].nb = 18432;
+
+    /* Block 3L, SCALEL */
+    wd1 = (s->band[0].nb >> 6) & 31;
+    wd2 = 8 - (s->band[0].nb >> 11);
+    wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
+    s->band[0].det = wd3 << 2;
+
+    block4(&s->band[0], dlow);
+    {
+        int nb;
+
+        /* Block 1H, SUBTRA */
+        eh = saturate(xhigh - s->band[1].s);
+
+        /* Block 1H, QUANTH */
+        wd = (eh >= 0)  ?  eh  :  -(eh + 1);
+        wd1 = (564*s->band[1].det) >> 12;
+        mih = (wd >= wd1)  ?  2  :  1;
+        ihigh = (eh < 0)  ?  ihn[mih]  :  ihp[mih];
+
+        /* Block 2H, INVQAH */
+        wd2 = qm2[ihigh];
+        dhigh = (s->band[1].det*wd2) >> 15;
+
+        /* Block 3H, LOGSCH */
+        ih2 = rh2[ihigh];
+        wd = (s->band[1].nb*127) >> 7;
+
+        nb = wd + wh[ih2];
+        if (nb < 0)
+            nb = 0;
+        else if (nb > 22528)
+            nb = 22528;
+        s->band[1].nb = nb;
+
+        /* Block 3H, SCALEH */
+        wd1 = (s->band[1].nb >> 6) & 31;
+        wd2 = 10 - (s->band[1].nb >> 11);
         wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
-        s->band[0].det = wd3 << 2;
+        s->band[1].det = wd3 << 2;
 
-        block4(&s->band[0], dlow);
-        {
-            int nb;
-
-            /* Block 1H, SUBTRA */
-            eh = saturate(xhigh - s->band[1].s);
-
-            /* Block 1H, QUANTH */
-            wd = (eh >= 0)  ?  eh  :  -(eh + 1);
-            wd1 = (564*s->band[1].det) >> 12;
-            mih = (wd >= wd1)  ?  2  :  1;
-            ihigh = (eh < 0)  ?  ihn[mih]  :  ihp[mih];
-
-            /* Block 2H, INVQAH */
-            wd2 = qm2[ihigh];
-            dhigh = (s->band[1].det*wd2) >> 15;
-
-            /* Block 3H, LOGSCH */
-            ih2 = rh2[ihigh];
-            wd = (s->band[1].nb*127) >> 7;
-
-            nb = wd + wh[ih2];
-            if (nb < 0)
-                nb = 0;
-            else if (nb > 22528)
-                nb = 22528;
-            s->band[1].nb = nb;
-
-            /* Block 3H, SCALEH */
-            wd1 = (s->band[1].nb >> 6) & 31;
-            wd2 = 10 - (s->band[1].nb >> 11);
-            wd3 = (wd2 < 0)  ?  (ilb[wd1] << -wd2)  :  (ilb[wd1] >> wd2);
-            s->band[1].det = wd3 << 2;
-
-            block4(&s->band[1], dhigh);
+        block4(&s->band[1], dhigh);
 #if   BITS_PER_SAMPLE == 8
-            code = ((ihigh << 6) | ilow);
+        code = ((ihigh << 6) | ilow);
 #elif BITS_PER_SAMPLE == 7
-            code = ((ihigh << 6) | ilow) >> 1;
+        code = ((ihigh << 6) | ilow) >> 1;
 #elif BITS_PER_SAMPLE == 6
-            code = ((ihigh << 6) | ilow) >> 2;
+        code = ((ihigh << 6) | ilow) >> 2;
 #endif
-        }
+    }
+    return code;
+}
+/*- End of function --------------------------------------------------------*/
 
+static __inline int put_code(g722_encode_state_t *s, uint8_t g722_data[],
+                             int g722_bytes, int code)
+{
 #if PACKED_OUTPUT == 1
-            /* Pack the code bits */
-            s->out_buffer |= (code << s->out_bits);
-            s->out_bits += s->bits_per_sample;
-            if (s->out_bits >= 8)
-            {
-                g722_data[g722_bytes++] = (uint8_t) (s->out_buffer & 0xFF);
-                s->out_bits -= 8;
-                s->out_buffer >>= 8;
-            }
+    /* Pack the code bits */
+    s->out_buffer |= (code << s->out_bits);
+    s->out_bits += s->bits_per_sample;
+    if (s->out_bits >= 8)
+    {
+        g722_data[g722_bytes++] = (uint8_t) (s->out_buffer & 0xFF);
+        s->out_bits -= 8;
+        s->out_buffer >>= 8;
+    }
 #else
-            g722_data[g722_bytes++] = (uint8_t) code;
+    (void) s;
+    g722_data[g722_bytes++] = (uint8_t) code;
 #endif
+    return g722_bytes;
+}
+/*- End of function --------------------------------------------------------*/
+
+/* Applies the transmit QMF to |pairs| sample pairs of |amp|, leaving the sums
+   and differences in |sum| and |diff|. The filter history in |s| moves on by
+   the block. */
+static void tx_qmf(g722_encode_state_t *s, const int16_t amp[], int pairs,
+                   int32_t sum[], int32_t diff[])
+{
+    int16_t w[G722_QMF_HISTORY + 2*G722_QMF_BLOCK_PAIRS];
+    int i;
+
+    for (i = 0;  i < G722_QMF_HISTORY;  i++)
+        w[i] = (int16_t) s->x[i + 2];
+    memcpy(&w[G722_QMF_HISTORY], amp, 2*pairs*sizeof(w[0]));
+    g722_qmf_block(w, pairs, qmf_sum, qmf_diff, sum, diff);
+    for (i = 0;  i < G722_QMF_TAPS;  i++)
+        s->x[i] = w[2*pairs - 2 + i];
+}
+/*- End of function --------------------------------------------------------*/
+
+int g722_encode(g722_encode_state_t *s, uint8_t g722_data[],
+                       const int16_t amp[], int len)
+{
+    int32_t sum[G722_QMF_BLOCK_PAIRS];
+    int32_t diff[G722_QMF_BLOCK_PAIRS];
+    int g722_bytes;
+    int pairs;
+    int xlow;
+    int i;
+    int j;
+
+    g722_bytes = 0;
+    if (s->itu_test_mode)
+    {
+        for (j = 0;  j < len;  j++)
+        {
+            xlow = amp[j] >> 1;
+            g722_bytes = put_code(s, g722_data, g722_bytes,
+                                  encode_sample(s, xlow, xlow));
+        }
+        return g722_bytes;
+    }
+
+    /* A trailing odd sample has no partner for the QMF and is dropped */
+    for (j = 0;  j + 1 < len;  j += 2*pairs)
+    {
+        pairs = (len - j) >> 1;
+        if (pairs > G722_QMF_BLOCK_PAIRS)
+            pairs = G722_QMF_BLOCK_PAIRS;
+        tx_qmf(s, &amp[j], pairs, sum, diff);
+
+        /* We shift by 12 to allow for the QMF filters (DC gain = 4096), plus 1
+           to allow for us summing two filters, plus 1 to allow for the 15 bit
+           input to the G.722 algorithm. */
+        for (i = 0;  i < pairs;  i++)
+        {
+            g722_bytes = put_code(s, g722_data, g722_bytes,
+                                  encode_sample(s, sum[i] >> 14,
+                                                diff[i] >> 14));
+        }
+    }
+    return g722_bytes;
+}
+/*- End of function --------------------------------------------------------*/
+
+int g722_encode_stereo(g722_encode_state_t *left, g722_encode_state_t *right,
+                       uint8_t left_data[], uint8_t right_data[],
+                       const int16_t left_amp[], const int16_t right_amp[],
+                       int len)
+{
+    int32_t lsum[G722_QMF_BLOCK_PAIRS];
+    int32_t ldiff[G722_QMF_BLOCK_PAIRS];
+    int32_t rsum[G722_QMF_BLOCK_PAIRS];
+    int32_t rdiff[G722_QMF_BLOCK_PAIRS];
+    int g722_bytes;
+    int pairs;
+    int lcode;
+    int rcode;
+    int i;
+    int j;
+
+    if (left->itu_test_mode  ||  right->itu_test_mode)
+    {
+        g722_encode(right, right_data, right_amp, len);
+        return g722_encode(left, left_data, left_amp, len);
+    }
+
+    g722_bytes = 0;
+    for (j = 0;  j + 1 < len;  j += 2*pairs)
+    {
+        pairs = (len - j) >> 1;
+        if (pairs > G722_QMF_BLOCK_PAIRS)
+            pairs = G722_QMF_BLOCK_PAIRS;
+        tx_qmf(left, &left_amp[j], pairs, lsum, ldiff);
+        tx_qmf(right, &right_amp[j], pairs, rsum, rdiff);
+
+        /* The two channels share nothing, so running their ADPCM side by side
+           lets the two dependency chains overlap. */
+        for (i = 0;  i < pairs;  i++)
+        {
+            lcode = encode_sample(left, lsum[i] >> 14, ldiff[i] >> 14);
+            rcode = encode_sample(right, rsum[i] >> 14, rdiff[i] >> 14);
+            put_code(right, right_data, g722_bytes, rcode);
+            g722_bytes = put_code(left, left_data, g722_bytes, lcode);
+        }
     }
     return g722_bytes;
 }
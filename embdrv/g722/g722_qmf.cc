@@ -0,0 +1,133 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*! \file */
+
+/* Both G.722 QMFs are pairs of 24 tap FIR filters over 16 bit samples. A
+   block of outputs is computed in one pass with multiply-accumulate vectors:
+   NEON on ARM, SSE2 on x86, plain C elsewhere. */
+
+#include "g722_qmf.h"
+
+#if defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define G722_QMF_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define G722_QMF_SSE2
+#endif
+
+#if defined(G722_QMF_NEON)
+static __inline int32x4_t qmf_dot24(const int16_t *x, const int16_t *h)
+{
+    int16x8_t x0 = vld1q_s16(x);
+    int16x8_t x1 = vld1q_s16(x + 8);
+    int16x8_t x2 = vld1q_s16(x + 16);
+    int16x8_t h0 = vld1q_s16(h);
+    int16x8_t h1 = vld1q_s16(h + 8);
+    int16x8_t h2 = vld1q_s16(h + 16);
+    int32x4_t acc;
+
+    acc = vmull_s16(vget_low_s16(x0), vget_low_s16(h0));
+    acc = vmlal_s16(acc, vget_high_s16(x0), vget_high_s16(h0));
+    acc = vmlal_s16(acc, vget_low_s16(x1), vget_low_s16(h1));
+    acc = vmlal_s16(acc, vget_high_s16(x1), vget_high_s16(h1));
+    acc = vmlal_s16(acc, vget_low_s16(x2), vget_low_s16(h2));
+    acc = vmlal_s16(acc, vget_high_s16(x2), vget_high_s16(h2));
+    return acc;
+}
+
+static __inline int32_t qmf_sum(int32x4_t v)
+{
+#if defined(__aarch64__)
+    return vaddvq_s32(v);
+#else
+    int32x2_t t = vadd_s32(vget_low_s32(v), vget_high_s32(v));
+    return vget_lane_s32(vpadd_s32(t, t), 0);
+#endif
+}
+
+void g722_qmf_block(const int16_t x[], int pairs, const int16_t h_a[],
+                    const int16_t h_b[], int32_t out_a[], int32_t out_b[])
+{
+    int n;
+
+    for (n = 0;  n < pairs;  n++)
+    {
+        out_a[n] = qmf_sum(qmf_dot24(x + 2*n, h_a));
+        out_b[n] = qmf_sum(qmf_dot24(x + 2*n, h_b));
+    }
+}
+#elif defined(G722_QMF_SSE2)
+void g722_qmf_block(const int16_t x[], int pairs, const int16_t h_a[],
+                    const int16_t h_b[], int32_t out_a[], int32_t out_b[])
+{
+    const __m128i ha0 = _mm_loadu_si128((const __m128i *) h_a);
+    const __m128i ha1 = _mm_loadu_si128((const __m128i *) (h_a + 8));
+    const __m128i ha2 = _mm_loadu_si128((const __m128i *) (h_a + 16));
+    const __m128i hb0 = _mm_loadu_si128((const __m128i *) h_b);
+    const __m128i hb1 = _mm_loadu_si128((const __m128i *) (h_b + 8));
+    const __m128i hb2 = _mm_loadu_si128((const __m128i *) (h_b + 16));
+    int n;
+
+    for (n = 0;  n < pairs;  n++)
+    {
+        const int16_t *p = x + 2*n;
+        __m128i x0 = _mm_loadu_si128((const __m128i *) p);
+        __m128i x1 = _mm_loadu_si128((const __m128i *) (p + 8));
+        __m128i x2 = _mm_loadu_si128((const __m128i *) (p + 16));
+        __m128i a;
+        __m128i b;
+        __m128i t;
+
+        a = _mm_add_epi32(_mm_madd_epi16(x0, ha0), _mm_madd_epi16(x1, ha1));
+        a = _mm_add_epi32(a, _mm_madd_epi16(x2, ha2));
+        b = _mm_add_epi32(_mm_madd_epi16(x0, hb0), _mm_madd_epi16(x1, hb1));
+        b = _mm_add_epi32(b, _mm_madd_epi16(x2, hb2));
+
+        /* Reduce both accumulators at once: lane 0 is a, lane 1 is b */
+        t = _mm_add_epi32(_mm_unpacklo_epi32(a, b), _mm_unpackhi_epi32(a, b));
+        t = _mm_add_epi32(t, _mm_srli_si128(t, 8));
+        out_a[n] = _mm_cvtsi128_si32(t);
+        out_b[n] = _mm_cvtsi128_si32(_mm_srli_si128(t, 4));
+    }
+}
+#else
+void g722_qmf_block(const int16_t x[], int pairs, const int16_t h_a[],
+                    const int16_t h_b[], int32_t out_a[], int32_t out_b[])
+{
+    int n;
+    int k;
+
+    for (n = 0;  n < pairs;  n++)
+    {
+        const int16_t *p = x + 2*n;
+        int32_t a = 0;
+        int32_t b = 0;
+
+        for (k = 0;  k < G722_QMF_TAPS;  k++)
+        {
+            a += p[k]*h_a[k];
+            b += p[k]*h_b[k];
+        }
+        out_a[n] = a;
+        out_b[n] = b;
+    }
+}
+#endif
+/*- End of file ------------------------------------------------------------*/
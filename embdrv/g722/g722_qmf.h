@@ -0,0 +1,41 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/*! \file */
+
+#if !defined(_G722_QMF_H_)
+#define _G722_QMF_H_
+
+#include "g722_typedefs.h"
+
+/* Sample pairs the encoder and decoder run through the QMF per pass. 240
+   pairs is a 20 ms frame at 24 kHz. */
+#define G722_QMF_BLOCK_PAIRS 240
+
+/* Number of taps of the QMF, and of the history kept between blocks */
+#define G722_QMF_TAPS 24
+#define G722_QMF_HISTORY (G722_QMF_TAPS - 2)
+
+/* Runs two 24 tap filters over |x|, stepping two samples per output:
+       out_a[n] = sum(x[2n + k]*h_a[k]),  out_b[n] = sum(x[2n + k]*h_b[k])
+   for n = 0 .. pairs - 1. |x| holds 2*pairs + G722_QMF_HISTORY samples.
+   The result is bit exact with the scalar sums on every target. */
+void g722_qmf_block(const int16_t x[], int pairs, const int16_t h_a[],
+                    const int16_t h_b[], int32_t out_a[], int32_t out_b[]);
+
+#endif
@@ -67,6 +67,14 @@ Declarations of codec functions, data types, and macros.
 #define SBC_WBS_FRAME_LEN 62
 #define SBC_WBS_SAMPLES_PER_FRAME 128
 
+/* mSBC, the wideband speech codec of HFP: 16 kHz mono, 8 subbands, 15 blocks,
+ * loudness allocation and a bitpool of 26. The header only carries the
+ * syncword and the CRC. */
+#define SBC_MSBC_BITPOOL 26
+#define SBC_MSBC_NROF_BLOCKS 15
+#define SBC_MSBC_FRAME_LEN 57
+#define SBC_MSBC_SAMPLES_PER_FRAME 120
+
 #define SBC_HEADER_LEN 4
 #define SBC_MAX_FRAME_LEN                    \
   (SBC_HEADER_LEN +                          \
@@ -79,6 +87,7 @@ Declarations of codec functions, data types, and macros.
 
 #define OI_SBC_SYNCWORD 0x9c
 #define OI_SBC_ENHANCED_SYNCWORD 0x9d
+#define OI_SBC_MSBC_SYNCWORD 0xad
 
 /**@name Sampling frequencies */
 /**@{*/
@@ -208,6 +217,9 @@ typedef struct {
   OI_BYTE formatByte;
   uint8_t pcmStride;
   uint8_t maxChannels;
+  OI_BOOL useSimd; /**< Use the vector kernels, set by the decoder reset */
+  OI_BOOL mSbcEnabled; /**< Frames are mSBC, set by
+                          OI_CODEC_SBC_DecoderConfigureMSbc() */
 } OI_CODEC_SBC_COMMON_CONTEXT;
 
 /*
@@ -297,6 +309,17 @@ OI_STATUS OI_CODEC_SBC_DecoderReset(OI_CODEC_SBC_DECODER_CONTEXT* context,
 OI_STATUS OI_CODEC_SBC_DecoderLimit(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                     OI_BOOL enhanced, uint8_t subbands);
 
+/**
+ * This function configures the decoder for mSBC frames as used by the HFP
+ * wideband speech. It must be called after OI_CODEC_SBC_DecoderReset().
+ * After it is called, OI_CODEC_SBC_DecodeFrame() only accepts frames with
+ * the mSBC syncword and decodes them with the fixed mSBC parameters.
+ *
+ * @param context   Pointer to the decoder context structure.
+ */
+OI_STATUS OI_CODEC_SBC_DecoderConfigureMSbc(
+    OI_CODEC_SBC_DECODER_CONTEXT* context);
+
 /**
  * This function sets the decoder parameters for a raw decode where the decoder
  * parameters are not available in the sbc data stream.
@@ -395,6 +418,46 @@ OI_STATUS OI_CODEC_SBC_DecodeFrame(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                    uint32_t* frameBytes, int16_t* pcmData,
                                    uint32_t* pcmBytes);
 
+/** Defined when OI_CODEC_SBC_DecodeFrames() is available. */
+#define OI_CODEC_SBC_DECODE_FRAMES
+
+/**
+ * Decode consecutive SBC frames, e.g. all frames of one media packet, with
+ * one call. Decoding stops after |*frameCount| frames, when the frame data
+ * runs out, or at the first frame that fails to decode.
+ *
+ * @param context       Pointer to a decoder context structure, as for
+ *                      OI_CODEC_SBC_DecodeFrame().
+ *
+ * @param frameData     Address of a pointer to the SBC data to decode. This
+ *                      value will be updated to point past the last frame
+ *                      decoded.
+ *
+ * @param frameBytes    Pointer to a uint32_t containing the number of available
+ *                      bytes of frame data. This value will be updated to
+ *                      reflect the number of bytes remaining.
+ *
+ * @param pcmData       Address of an array of int16_t pairs, which will be
+ *                      populated with the decoded audio of all frames, one
+ *                      after the other. This address is not updated.
+ *
+ * @param pcmBytes      Pointer to a uint32_t in/out parameter. On input, it
+ *                      should contain the number of bytes available for pcm
+ *                      data. On output, it will contain the number of bytes
+ *                      written for all frames.
+ *
+ * @param frameCount    Pointer to a uint32_t in/out parameter. On input, the
+ *                      maximum number of frames to decode. On output, the
+ *                      number of frames decoded.
+ *
+ * @return OI_OK if every frame was decoded, otherwise the status of the frame
+ *         that failed. The frames before it are decoded either way.
+ */
+OI_STATUS OI_CODEC_SBC_DecodeFrames(OI_CODEC_SBC_DECODER_CONTEXT* context,
+                                    const OI_BYTE** frameData,
+                                    uint32_t* frameBytes, int16_t* pcmData,
+                                    uint32_t* pcmBytes, uint32_t* frameCount);
+
 /**
  * Calculate the number of SBC frames but don't decode. CRC's are not checked,
  * but the Sync word is found prior to count calculation.
@@ -215,6 +215,15 @@ PRIVATE void OI_SBC_SynthFrame(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                int16_t* pcm, OI_UINT start_block,
                                OI_UINT nrof_blocks);
 INLINE int32_t OI_SBC_Dequant(uint32_t raw, OI_UINT scale_factor, OI_UINT bits);
+PRIVATE void OI_SBC_DequantFrame(OI_CODEC_SBC_COMMON_CONTEXT* common);
+
+/* Vector kernels, see simd-sbc.c */
+PRIVATE OI_BOOL OI_SBC_SimdSupported(void);
+PRIVATE void OI_SBC_DequantFrame_simd(OI_CODEC_SBC_COMMON_CONTEXT* common,
+                                      OI_UINT join);
+PRIVATE void OI_SBC_SynthWindow80_simd(int16_t* pcm,
+                                       SBC_BUFFER_T const* RESTRICT buffer,
+                                       OI_UINT strideShift);
 PRIVATE OI_BOOL OI_SBC_ExamineCommandPacket(
     OI_CODEC_SBC_DECODER_CONTEXT* context, const OI_BYTE* data, uint32_t len);
 PRIVATE void OI_SBC_GenerateTestSignal(int16_t pcmData[][2],
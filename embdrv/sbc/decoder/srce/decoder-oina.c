@@ -114,6 +114,19 @@ OI_STATUS OI_CODEC_SBC_DecoderLimit(OI_CODEC_SBC_DECODER_CONTEXT* context,
   return OI_OK;
 }
 
+OI_STATUS OI_CODEC_SBC_DecoderConfigureMSbc(
+    OI_CODEC_SBC_DECODER_CONTEXT* context) {
+  if (context->common.maxChannels < 1) {
+    return OI_STATUS_INVALID_PARAMETERS;
+  }
+  context->enhancedEnabled = FALSE;
+  context->limitFrameFormat = FALSE;
+  context->common.mSbcEnabled = TRUE;
+  /* Make the next header read fill in the frame fields */
+  context->common.frameInfo.cachedInfo = 0xff;
+  return OI_OK;
+}
+
 /**
 @}
 */
@@ -73,6 +73,7 @@ INLINE OI_STATUS internal_DecoderReset(OI_CODEC_SBC_DECODER_CONTEXT* context,
   context->common.codecInfo = OI_Codec_Copyright;
   context->common.maxBitneed = 0;
   context->limitFrameFormat = FALSE;
+  context->common.useSimd = OI_SBC_SimdSupported();
   OI_SBC_ExpandFrameFields(&context->common.frameInfo);
 
   /*PLATFORM_DECODER_RESET(context);*/
@@ -90,6 +91,26 @@ INLINE void OI_SBC_ReadHeader(OI_CODEC_SBC_COMMON_CONTEXT* common,
   OI_CODEC_SBC_FRAME_INFO* frame = &common->frameInfo;
   uint8_t d1;
 
+  if (common->mSbcEnabled) {
+    OI_ASSERT(data[0] == OI_SBC_MSBC_SYNCWORD);
+    /* The two header bytes are reserved: the parameters are fixed */
+    if (frame->cachedInfo != 0) {
+      frame->freqIndex = SBC_FREQ_16000;
+      frame->frequency = freq_values[frame->freqIndex];
+      frame->blocks = SBC_BLOCKS_16;
+      frame->nrof_blocks = SBC_MSBC_NROF_BLOCKS;
+      frame->mode = SBC_MONO;
+      frame->nrof_channels = channel_values[frame->mode];
+      frame->alloc = SBC_LOUDNESS;
+      frame->subbands = SBC_SUBBANDS_8;
+      frame->nrof_subbands = band_values[frame->subbands];
+      frame->cachedInfo = 0;
+    }
+    frame->bitpool = SBC_MSBC_BITPOOL;
+    frame->crc = data[3];
+    return;
+  }
+
   OI_ASSERT(data[0] == OI_SBC_SYNCWORD || data[0] == OI_SBC_ENHANCED_SYNCWORD);
 
   /* Avoid filling out all these strucutures if we already remember the values
@@ -174,7 +195,8 @@ PRIVATE void OI_SBC_ReadScalefactors(OI_CODEC_SBC_COMMON_CONTEXT* common,
   }
 }
 
-/** Read quantized subband samples from the input bitstream and expand them. */
+/** Read quantized subband samples from the input bitstream. They are expanded
+ * afterwards by OI_SBC_DequantFrame(). */
 PRIVATE void OI_SBC_ReadSamples(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                 OI_BITSTREAM* global_bs) {
   OI_CODEC_SBC_COMMON_CONTEXT* common = &context->common;
@@ -189,33 +211,25 @@ PRIVATE void OI_SBC_ReadSamples(OI_CODEC_SBC_DECODER_CONTEXT* context,
   do {
     OI_UINT i;
     for (i = 0; i < iter_count; ++i) {
-      uint32_t sf_by4 = ((uint32_t*)common->scale_factor)[i];
       uint32_t bits_by4 = common->bits.uint32[i];
       OI_UINT n;
       for (n = 0; n < 4; ++n) {
-        int32_t dequant;
+        uint32_t raw;
         OI_UINT bits;
-        OI_INT sf;
 
         if (OI_CPU_BYTE_ORDER == OI_LITTLE_ENDIAN_BYTE_ORDER) {
           bits = bits_by4 & 0xFF;
           bits_by4 >>= 8;
-          sf = sf_by4 & 0xFF;
-          sf_by4 >>= 8;
         } else {
           bits = (bits_by4 >> 24) & 0xFF;
           bits_by4 <<= 8;
-          sf = (sf_by4 >> 24) & 0xFF;
-          sf_by4 <<= 8;
         }
         if (bits) {
-          uint32_t raw;
           OI_BITSTREAM_READUINT(raw, bits, ptr, value, bitPtr);
-          dequant = OI_SBC_Dequant(raw, sf, bits);
         } else {
-          dequant = 0;
+          raw = 0;
         }
-        *s++ = dequant;
+        *s++ = (int32_t)raw;
       }
     }
   } while (--nrof_blocks);
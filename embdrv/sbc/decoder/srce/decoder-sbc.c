@@ -50,6 +50,15 @@ PRIVATE OI_STATUS FindSyncword(OI_CODEC_SBC_DECODER_CONTEXT* context,
     return OI_CODEC_SBC_NOT_ENOUGH_HEADER_DATA;
   }
 
+  if (context->common.mSbcEnabled) {
+    while (*frameBytes && (**frameData != OI_SBC_MSBC_SYNCWORD)) {
+      (*frameBytes)--;
+      (*frameData)++;
+    }
+    context->common.frameInfo.enhanced = FALSE;
+    return *frameBytes ? OI_OK : OI_CODEC_SBC_NO_SYNCWORD;
+  }
+
 #ifdef SBC_ENHANCED
   if (context->limitFrameFormat && context->enhancedEnabled) {
     /* If the context is restricted, only search for specified SYNCWORD */
@@ -135,6 +144,7 @@ static OI_STATUS DecodeBody(OI_CODEC_SBC_DECODER_CONTEXT* context,
     } else {
       OI_SBC_ReadSamples(context, &bs);
     }
+    OI_SBC_DequantFrame(&context->common);
 
     context->bufferedBlocks = context->common.frameInfo.nrof_blocks;
   }
@@ -344,6 +354,35 @@ OI_STATUS OI_CODEC_SBC_DecodeFrame(OI_CODEC_SBC_DECODER_CONTEXT* context,
   return status;
 }
 
+OI_STATUS OI_CODEC_SBC_DecodeFrames(OI_CODEC_SBC_DECODER_CONTEXT* context,
+                                    const OI_BYTE** frameData,
+                                    uint32_t* frameBytes, int16_t* pcmData,
+                                    uint32_t* pcmBytes, uint32_t* frameCount) {
+  OI_STATUS status = OI_OK;
+  uint32_t maxFrames = *frameCount;
+  uint32_t pcmAvail = *pcmBytes;
+  uint32_t decoded = 0;
+
+  TRACE(("+OI_CODEC_SBC_DecodeFrames"));
+
+  while (decoded < maxFrames && *frameBytes > 0) {
+    uint32_t written = pcmAvail;
+    status = OI_CODEC_SBC_DecodeFrame(context, frameData, frameBytes, pcmData,
+                                      &written);
+    if (!OI_SUCCESS(status)) {
+      break;
+    }
+    pcmData += written / sizeof(int16_t);
+    pcmAvail -= written;
+    decoded++;
+  }
+
+  *pcmBytes -= pcmAvail;
+  *frameCount = decoded;
+  TRACE(("-OI_CODEC_SBC_DecodeFrames: %d frames, %d", decoded, status));
+  return status;
+}
+
 OI_STATUS OI_CODEC_SBC_SkipFrame(OI_CODEC_SBC_DECODER_CONTEXT* context,
                                  const OI_BYTE** frameData,
                                  uint32_t* frameBytes) {
@@ -210,6 +210,43 @@ INLINE int32_t OI_SBC_Dequant_Unscaled(uint32_t raw, OI_UINT scale_factor,
   return SCALE(result, 24 - scale_factor);
 }
 
+/**
+ Expands the raw samples that OI_SBC_ReadSamples() or OI_SBC_ReadSamplesJoint()
+ stored in the subband buffer, and undoes mid/side for the joint stereo
+ subbands.
+ */
+PRIVATE void OI_SBC_DequantFrame(OI_CODEC_SBC_COMMON_CONTEXT* common) {
+  OI_UINT nrof_blocks = common->frameInfo.nrof_blocks;
+  OI_UINT nrof_subbands = common->frameInfo.nrof_subbands;
+  OI_UINT n = common->frameInfo.nrof_channels * nrof_subbands;
+  OI_UINT join = common->frameInfo.mode == SBC_JOINT_STEREO
+                     ? common->frameInfo.join
+                     : 0;
+  int32_t* s = common->subdata;
+
+  if (common->useSimd) {
+    OI_SBC_DequantFrame_simd(common, join);
+    return;
+  }
+
+  do {
+    OI_UINT i;
+    for (i = 0; i < n; i++) {
+      s[i] = OI_SBC_Dequant((uint32_t)s[i], common->scale_factor[i],
+                            common->bits.uint8[i]);
+    }
+    for (i = 0; join && i < nrof_subbands; i++) {
+      if (join & (1 << (nrof_subbands - 1 - i))) {
+        int32_t mid = s[i];
+        int32_t side = s[nrof_subbands + i];
+        s[i] = mid + side;
+        s[nrof_subbands + i] = mid - side;
+      }
+    }
+    s += n;
+  } while (--nrof_blocks);
+}
+
 /**
 @}
 */
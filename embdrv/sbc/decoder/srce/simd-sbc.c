@@ -0,0 +1,305 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/**
+@file
+
+Vector versions of the dequantizer and of the 8-subband synthesis window for
+ARM NEON and for x86 with AVX2. Both use the same integer operations as the C
+code in dequant.c and synthesis-8-generated.c, in particular the per-term
+shifts of the generated window, so their output is bit exact with it.
+
+@ingroup codec_internal
+*/
+
+/**
+@addtogroup codec_internal
+@{
+*/
+
+#include "oi_codec_sbc_private.h"
+
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#define SBC_SIMD_NEON
+#include <arm_neon.h>
+#if !defined(__aarch64__)
+#include <sys/auxv.h>
+#ifndef HWCAP_NEON
+#define HWCAP_NEON (1 << 12)
+#endif
+#endif
+#define SBC_SIMD_TARGET
+#elif defined(__x86_64__) || defined(__i386__)
+#define SBC_SIMD_AVX2
+#include <immintrin.h>
+#define SBC_SIMD_TARGET __attribute__((target("avx2")))
+#endif
+
+#ifndef SBC_DEQUANT_LONG_SCALED_OFFSET
+#define SBC_DEQUANT_LONG_SCALED_OFFSET 1555931970
+#endif
+
+extern const uint32_t dequant_long_scaled[17];
+
+PRIVATE void SynthWindow80_generated(int16_t* pcm,
+                                     SBC_BUFFER_T const* RESTRICT buffer,
+                                     OI_UINT strideShift);
+
+PRIVATE OI_BOOL OI_SBC_SimdSupported(void) {
+#if defined(SBC_SIMD_NEON) && defined(__aarch64__)
+  return TRUE;
+#elif defined(SBC_SIMD_NEON)
+  return (getauxval(AT_HWCAP) & HWCAP_NEON) ? TRUE : FALSE;
+#elif defined(SBC_SIMD_AVX2)
+  return __builtin_cpu_supports("avx2") ? TRUE : FALSE;
+#else
+  return FALSE;
+#endif
+}
+
+#if defined(SBC_SIMD_NEON) || defined(SBC_SIMD_AVX2)
+
+/*
+ * Each of the eight outputs of SynthWindow80_generated() sums ten products
+ * which are taken from buffer[16 * k + 4 .. 16 * k + 12], k = 0..4. Term A of
+ * group k uses the lane order below from buffer + 16 * k + 5, term B the one
+ * from buffer + 16 * k + 4. Output 0 has no term B in group 0 and output 4
+ * has no term B at all; their coefficients are zero.
+ *
+ * The coefficients and shifts are those of synthesis-8-generated.c; a
+ * positive shift is applied to the left, a negative one to the right.
+ */
+static const int16_t synth80_coef[5][2][8] = {
+    {{8235, -3263, -10385, -16457, 10445, 16913, 11167, 9293},
+     {0, 29293, 24995, 19083, 0, -8443, -10337, -6087}},
+    {{26479, -5229, -309, -23641, -5297, 3687, 1917, 1247},
+     {-23167, 30835, 9161, -29015, 0, -301, -30605, -2893}},
+    {{9399, -27021, -23063, -12889, 22299, 15447, 8317, 23671},
+     {-17397, 31633, 27561, 6145, 0, 10255, 9553, 18055}},
+    {{26479, 17319, 2309, 24211, 10603, -18233, 22117, 11537},
+     {17397, 26663, 12705, 23469, 0, 9405, 16383, 1747}},
+    {{8235, 4555, 6239, 21223, 9539, 1499, 7543, 685},
+     {23167, 12419, 9251, 26913, 0, 26189, 8603, 8721}}};
+
+static const int32_t synth80_shift[5][2][8] = {
+    {{-3, -5, -6, -6, -4, -5, -4, -3}, {0, -5, -5, -5, 0, -7, -4, -2}},
+    {{-2, 0, 4, -2, 1, 1, 2, 3}, {-3, -3, -3, -4, 0, 5, -1, 3}},
+    {{3, 1, 1, 2, 2, 2, 3, 2}, {1, 1, 1, 3, 0, 2, 2, 1}},
+    {{-2, 1, 3, -1, 0, -3, -4, -1}, {1, -2, -1, -2, 0, -1, -2, 1}},
+    {{-3, -1, -3, -8, -4, -1, -3, 1}, {-3, -4, -4, -6, 0, -7, -6, -7}}};
+
+/* Byte shuffles picking halfwords [7 0 1 2 3 2 1 0] and [0 7 6 5 4 5 6 7] */
+static const uint8_t synth80_perm[2][16] = {
+    {14, 15, 0, 1, 2, 3, 4, 5, 6, 7, 4, 5, 2, 3, 0, 1},
+    {0, 1, 14, 15, 12, 13, 10, 11, 8, 9, 10, 11, 12, 13, 14, 15}};
+
+#endif
+
+#if defined(SBC_SIMD_NEON)
+
+static inline int16x8_t permute_s16(int16x8_t v, uint8x16_t idx) {
+#if defined(__aarch64__)
+  return vreinterpretq_s16_u8(vqtbl1q_u8(vreinterpretq_u8_s16(v), idx));
+#else
+  uint8x8x2_t table = {{vget_low_u8(vreinterpretq_u8_s16(v)),
+                        vget_high_u8(vreinterpretq_u8_s16(v))}};
+  return vreinterpretq_s16_u8(vcombine_u8(vtbl2_u8(table, vget_low_u8(idx)),
+                                          vtbl2_u8(table, vget_high_u8(idx))));
+#endif
+}
+
+/* Divides by 32768 rounding towards zero, like the C division */
+static inline int32x4_t div_32768(int32x4_t x) {
+  uint32x4_t bias = vshrq_n_u32(vreinterpretq_u32_s32(vshrq_n_s32(x, 31)), 17);
+  return vshrq_n_s32(vaddq_s32(x, vreinterpretq_s32_u32(bias)), 15);
+}
+
+PRIVATE void OI_SBC_SynthWindow80_simd(int16_t* pcm,
+                                       SBC_BUFFER_T const* RESTRICT buffer,
+                                       OI_UINT strideShift) {
+  int32x4_t lo = vdupq_n_s32(0);
+  int32x4_t hi = vdupq_n_s32(0);
+  uint8x16_t perm_a = vld1q_u8(synth80_perm[0]);
+  uint8x16_t perm_b = vld1q_u8(synth80_perm[1]);
+  int16_t out[8];
+  OI_UINT k, t, i;
+
+  for (k = 0; k < 5; k++) {
+    int16x8_t x[2];
+    x[0] = permute_s16(vld1q_s16(buffer + 16 * k + 5), perm_a);
+    x[1] = permute_s16(vld1q_s16(buffer + 16 * k + 4), perm_b);
+    for (t = 0; t < 2; t++) {
+      int16x8_t c = vld1q_s16(synth80_coef[k][t]);
+      int32x4_t p_lo = vmull_s16(vget_low_s16(x[t]), vget_low_s16(c));
+      int32x4_t p_hi = vmull_s16(vget_high_s16(x[t]), vget_high_s16(c));
+      lo = vaddq_s32(lo, vshlq_s32(p_lo, vld1q_s32(synth80_shift[k][t])));
+      hi = vaddq_s32(hi, vshlq_s32(p_hi, vld1q_s32(synth80_shift[k][t] + 4)));
+    }
+  }
+
+  /* The saturating narrow clips to int16 like CLIP_INT16 */
+  vst1q_s16(out, vcombine_s16(vqmovn_s32(div_32768(lo)),
+                              vqmovn_s32(div_32768(hi))));
+  for (i = 0; i < 8; i++) pcm[i << strideShift] = out[i];
+}
+
+#elif defined(SBC_SIMD_AVX2)
+
+/* Divides by 32768 rounding towards zero, like the C division */
+SBC_SIMD_TARGET static inline __m128i div_32768(__m128i x) {
+  __m128i bias = _mm_srli_epi32(_mm_srai_epi32(x, 31), 17);
+  return _mm_srai_epi32(_mm_add_epi32(x, bias), 15);
+}
+
+SBC_SIMD_TARGET static inline __m128i shift_s32(__m128i x, __m128i shift) {
+  __m128i left = _mm_max_epi32(shift, _mm_setzero_si128());
+  __m128i right = _mm_sub_epi32(left, shift);
+  return _mm_srav_epi32(_mm_sllv_epi32(x, left), right);
+}
+
+SBC_SIMD_TARGET PRIVATE void OI_SBC_SynthWindow80_simd(
+    int16_t* pcm, SBC_BUFFER_T const* RESTRICT buffer, OI_UINT strideShift) {
+  __m128i lo = _mm_setzero_si128();
+  __m128i hi = _mm_setzero_si128();
+  __m128i perm_a = _mm_loadu_si128((const __m128i*)synth80_perm[0]);
+  __m128i perm_b = _mm_loadu_si128((const __m128i*)synth80_perm[1]);
+  int16_t out[8];
+  OI_UINT k, t, i;
+
+  for (k = 0; k < 5; k++) {
+    __m128i x[2];
+    x[0] = _mm_shuffle_epi8(
+        _mm_loadu_si128((const __m128i*)(buffer + 16 * k + 5)), perm_a);
+    x[1] = _mm_shuffle_epi8(
+        _mm_loadu_si128((const __m128i*)(buffer + 16 * k + 4)), perm_b);
+    for (t = 0; t < 2; t++) {
+      __m128i c = _mm_loadu_si128((const __m128i*)synth80_coef[k][t]);
+      __m128i p_lo = _mm_mullo_epi16(x[t], c);
+      __m128i p_hi = _mm_mulhi_epi16(x[t], c);
+      lo = _mm_add_epi32(
+          lo, shift_s32(_mm_unpacklo_epi16(p_lo, p_hi),
+                        _mm_loadu_si128(
+                            (const __m128i*)synth80_shift[k][t])));
+      hi = _mm_add_epi32(
+          hi, shift_s32(_mm_unpackhi_epi16(p_lo, p_hi),
+                        _mm_loadu_si128(
+                            (const __m128i*)(synth80_shift[k][t] + 4))));
+    }
+  }
+
+  /* The saturating pack clips to int16 like CLIP_INT16 */
+  _mm_storeu_si128((__m128i*)out,
+                   _mm_packs_epi32(div_32768(lo), div_32768(hi)));
+  for (i = 0; i < 8; i++) pcm[i << strideShift] = out[i];
+}
+
+#else
+
+PRIVATE void OI_SBC_SynthWindow80_simd(int16_t* pcm,
+                                       SBC_BUFFER_T const* RESTRICT buffer,
+                                       OI_UINT strideShift) {
+  SynthWindow80_generated(pcm, buffer, strideShift);
+}
+
+#endif
+
+/**
+ * Dequantizes the raw samples of a frame in place and undoes joint stereo
+ * for the subbands set in |join|, like OI_SBC_Dequant() would for each
+ * sample. The multiplier, shift and mask of every subband are computed once
+ * per frame.
+ */
+#if defined(SBC_SIMD_NEON) || defined(SBC_SIMD_AVX2)
+SBC_SIMD_TARGET PRIVATE void OI_SBC_DequantFrame_simd(
+    OI_CODEC_SBC_COMMON_CONTEXT* common, OI_UINT join) {
+  OI_UINT nrof_subbands = common->frameInfo.nrof_subbands;
+  OI_UINT n = common->frameInfo.nrof_channels * nrof_subbands;
+  OI_UINT blk, i;
+  int32_t* s = common->subdata;
+  uint32_t mult[SBC_MAX_CHANNELS * SBC_MAX_BANDS];
+  int32_t shift[SBC_MAX_CHANNELS * SBC_MAX_BANDS];
+  int32_t keep[SBC_MAX_CHANNELS * SBC_MAX_BANDS];
+  int32_t joint[SBC_MAX_BANDS];
+
+  for (i = 0; i < n; i++) {
+    OI_UINT bits = common->bits.uint8[i];
+    mult[i] = bits > 1 ? dequant_long_scaled[bits] : 0;
+    shift[i] = common->scale_factor[i] - 15;
+    keep[i] = bits > 1 ? -1 : 0;
+  }
+  for (i = 0; i < nrof_subbands; i++) {
+    joint[i] = (join & (1 << (nrof_subbands - 1 - i))) ? -1 : 0;
+  }
+
+  for (blk = 0; blk < common->frameInfo.nrof_blocks; blk++) {
+    for (i = 0; i < n; i += 4) {
+#if defined(SBC_SIMD_NEON)
+      uint32x4_t d = vld1q_u32((const uint32_t*)s + i);
+      d = vmulq_u32(vaddq_u32(vshlq_n_u32(d, 1), vdupq_n_u32(1)),
+                    vld1q_u32(mult + i));
+      d = vsubq_u32(d, vdupq_n_u32(SBC_DEQUANT_LONG_SCALED_OFFSET));
+      int32x4_t r = vshlq_s32(vreinterpretq_s32_u32(d), vld1q_s32(shift + i));
+      vst1q_s32(s + i, vandq_s32(r, vld1q_s32(keep + i)));
+#else
+      __m128i d = _mm_loadu_si128((const __m128i*)(s + i));
+      d = _mm_mullo_epi32(
+          _mm_add_epi32(_mm_slli_epi32(d, 1), _mm_set1_epi32(1)),
+          _mm_loadu_si128((const __m128i*)(mult + i)));
+      d = _mm_sub_epi32(d, _mm_set1_epi32((int32_t)SBC_DEQUANT_LONG_SCALED_OFFSET));
+      d = _mm_srav_epi32(
+          d, _mm_sub_epi32(_mm_setzero_si128(),
+                           _mm_loadu_si128((const __m128i*)(shift + i))));
+      _mm_storeu_si128((__m128i*)(s + i),
+                       _mm_and_si128(d, _mm_loadu_si128(
+                                            (const __m128i*)(keep + i))));
+#endif
+    }
+    if (join) {
+      for (i = 0; i < nrof_subbands; i += 4) {
+#if defined(SBC_SIMD_NEON)
+        int32x4_t mid = vld1q_s32(s + i);
+        int32x4_t side = vld1q_s32(s + nrof_subbands + i);
+        uint32x4_t mask = vreinterpretq_u32_s32(vld1q_s32(joint + i));
+        vst1q_s32(s + i, vbslq_s32(mask, vaddq_s32(mid, side), mid));
+        vst1q_s32(s + nrof_subbands + i,
+                  vbslq_s32(mask, vsubq_s32(mid, side), side));
+#else
+        __m128i mid = _mm_loadu_si128((const __m128i*)(s + i));
+        __m128i side = _mm_loadu_si128((const __m128i*)(s + nrof_subbands + i));
+        __m128i mask = _mm_loadu_si128((const __m128i*)(joint + i));
+        _mm_storeu_si128((__m128i*)(s + i),
+                         _mm_blendv_epi8(mid, _mm_add_epi32(mid, side), mask));
+        _mm_storeu_si128(
+            (__m128i*)(s + nrof_subbands + i),
+            _mm_blendv_epi8(side, _mm_sub_epi32(mid, side), mask));
+#endif
+      }
+    }
+    s += n;
+  }
+}
+#else
+PRIVATE void OI_SBC_DequantFrame_simd(OI_CODEC_SBC_COMMON_CONTEXT* common,
+                                      OI_UINT join) {
+  OI_ASSERT(FALSE); /* OI_SBC_SimdSupported() returned FALSE */
+}
+#endif
+
+/**
+@}
+*/
@@ -303,8 +303,14 @@ PRIVATE void OI_SBC_SynthFrame_80(OI_CODEC_SBC_DECODER_CONTEXT* context,
 
     for (ch = 0; ch < nrof_channels; ch++) {
       DCT2_8(context->common.filterBuffer[ch] + offset, s);
-      SYNTH80(pcm + ch, context->common.filterBuffer[ch] + offset,
-              pcmStrideShift);
+      if (context->common.useSimd) {
+        OI_SBC_SynthWindow80_simd(
+            pcm + ch, context->common.filterBuffer[ch] + offset,
+            pcmStrideShift);
+      } else {
+        SYNTH80(pcm + ch, context->common.filterBuffer[ch] + offset,
+                pcmStrideShift);
+      }
       s += 8;
     }
     pcm += (8 << pcmStrideShift);
@@ -48,6 +48,15 @@ extern void SbcAnalysisFilter8(SBC_ENC_PARAMS* strEncParams, int16_t* input);
 extern void SBC_FastIDCT8(int32_t* pInVect, int32_t* pOutVect);
 extern void SBC_FastIDCT4(int32_t* x0, int32_t* pOutVect);
 
+/* Vector kernels, see sbc_analysis_simd.c */
+extern bool SbcSimdForceScalar;
+extern void SbcSimdInit(void);
+extern bool SbcSimdEnabled(void);
+extern void SbcWindowSimd(const int16_t* ps16X, const int16_t* ps16Coeffs,
+                          int32_t s32NumOfOutputs, int32_t* ps32Y);
+extern void SbcMaxAbsSimd(const int32_t* ps32SbBuf, int32_t s32Ch,
+                          int32_t s32NumOfBlocks, int32_t* ps32Max);
+
 extern uint32_t EncPacking(SBC_ENC_PARAMS* strEncParams, uint8_t* output);
 extern void EncQuantizer(SBC_ENC_PARAMS*);
 #if (SBC_DSP_OPT == TRUE)
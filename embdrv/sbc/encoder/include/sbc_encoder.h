@@ -63,6 +63,16 @@
 #define SBC_BLOCK_2 12
 #define SBC_BLOCK_3 16
 
+/* Frame formats. mSBC is the wideband speech codec of HFP: 16 kHz mono, 8
+ * subbands, 15 blocks, loudness allocation and a bitpool of 26. */
+#define SBC_FORMAT_GENERAL 0
+#define SBC_FORMAT_MSBC 1
+
+#define SBC_SYNC_WORD 0x9C
+#define SBC_MSBC_SYNC_WORD 0xAD
+#define SBC_MSBC_BLOCKS 15
+#define SBC_MSBC_BITPOOL 26
+
 #define SBC_NULL 0
 
 #ifndef SBC_MAX_NUM_FRAME
@@ -113,6 +123,14 @@
 #define SBC_IS_64_MULT_IN_WINDOW_ACCU FALSE
 #endif /*SBC_IS_64_MULT_IN_WINDOW_ACCU */
 
+/* Set SBC_SIMD_OPT to TRUE to run the windowing and the scale factor search
+ * with NEON or SSE2 when the CPU supports it. The output is bit exact with the
+ * C code. It only applies with SBC_IPAQ_OPT and 16 bit window coefficients.
+ */
+#ifndef SBC_SIMD_OPT
+#define SBC_SIMD_OPT TRUE
+#endif /* SBC_SIMD_OPT */
+
 /* Set SBC_IS_64_MULT_IN_IDCT to TRUE to use 64 bits multiplication in the DCT
  * of Matrixing
  */
@@ -189,6 +207,8 @@ typedef struct SBC_ENC_PARAMS_TAG {
 
   uint16_t FrameHeader;
 
+  uint8_t Format; /* SBC_FORMAT_GENERAL or SBC_FORMAT_MSBC */
+
 } SBC_ENC_PARAMS;
 
 #ifdef __cplusplus
@@ -199,6 +219,9 @@ extern "C" {
  * number of bytes written. */
 extern uint32_t SBC_Encode(SBC_ENC_PARAMS* strEncParams, int16_t* input,
                            uint8_t* output);
+/* Initialize the encoder with the parameters in |strEncParams|. With the
+ * SBC_FORMAT_MSBC format the mSBC parameters are set and the bit rate is
+ * ignored. */
 extern void SBC_Encoder_Init(SBC_ENC_PARAMS* strEncParams);
 
 #ifdef __cplusplus
@@ -1185,6 +1185,69 @@ static int16_t* s16X =
 #endif
 #endif
 
+#if (SBC_SIMD_OPT == TRUE) && (SBC_ARM_ASM_OPT == FALSE) && \
+    (SBC_IPAQ_OPT == TRUE) && (SBC_IS_64_MULT_IN_WINDOW_ACCU == FALSE)
+#define SBC_SIMD_WINDOW TRUE
+#else
+#define SBC_SIMD_WINDOW FALSE
+#endif
+
+#if (SBC_SIMD_WINDOW == TRUE)
+/* Window coefficients of output i and its mirror 2 * subbands - i, one row
+ * per tap, as used by the WINDOW_ACCU_x macros above. Output 0 needs no tap
+ * on the current sample, the middle output is symmetric. */
+static const int16_t as16Window8Rows[9][5] = {
+  {0, WIND_8_SUBBANDS_0_1, WIND_8_SUBBANDS_0_2, -WIND_8_SUBBANDS_0_2,
+   -WIND_8_SUBBANDS_0_1},
+  {WIND_8_SUBBANDS_1_0, WIND_8_SUBBANDS_1_1, WIND_8_SUBBANDS_1_2,
+   WIND_8_SUBBANDS_1_3, WIND_8_SUBBANDS_1_4},
+  {WIND_8_SUBBANDS_2_0, WIND_8_SUBBANDS_2_1, WIND_8_SUBBANDS_2_2,
+   WIND_8_SUBBANDS_2_3, WIND_8_SUBBANDS_2_4},
+  {WIND_8_SUBBANDS_3_0, WIND_8_SUBBANDS_3_1, WIND_8_SUBBANDS_3_2,
+   WIND_8_SUBBANDS_3_3, WIND_8_SUBBANDS_3_4},
+  {WIND_8_SUBBANDS_4_0, WIND_8_SUBBANDS_4_1, WIND_8_SUBBANDS_4_2,
+   WIND_8_SUBBANDS_4_3, WIND_8_SUBBANDS_4_4},
+  {WIND_8_SUBBANDS_5_0, WIND_8_SUBBANDS_5_1, WIND_8_SUBBANDS_5_2,
+   WIND_8_SUBBANDS_5_3, WIND_8_SUBBANDS_5_4},
+  {WIND_8_SUBBANDS_6_0, WIND_8_SUBBANDS_6_1, WIND_8_SUBBANDS_6_2,
+   WIND_8_SUBBANDS_6_3, WIND_8_SUBBANDS_6_4},
+  {WIND_8_SUBBANDS_7_0, WIND_8_SUBBANDS_7_1, WIND_8_SUBBANDS_7_2,
+   WIND_8_SUBBANDS_7_3, WIND_8_SUBBANDS_7_4},
+  {WIND_8_SUBBANDS_8_0, WIND_8_SUBBANDS_8_1, WIND_8_SUBBANDS_8_2,
+   WIND_8_SUBBANDS_8_1, WIND_8_SUBBANDS_8_0},
+};
+static const int16_t as16Window4Rows[5][5] = {
+  {0, WIND_4_SUBBANDS_0_1, WIND_4_SUBBANDS_0_2, -WIND_4_SUBBANDS_0_2,
+   -WIND_4_SUBBANDS_0_1},
+  {WIND_4_SUBBANDS_1_0, WIND_4_SUBBANDS_1_1, WIND_4_SUBBANDS_1_2,
+   WIND_4_SUBBANDS_1_3, WIND_4_SUBBANDS_1_4},
+  {WIND_4_SUBBANDS_2_0, WIND_4_SUBBANDS_2_1, WIND_4_SUBBANDS_2_2,
+   WIND_4_SUBBANDS_2_3, WIND_4_SUBBANDS_2_4},
+  {WIND_4_SUBBANDS_3_0, WIND_4_SUBBANDS_3_1, WIND_4_SUBBANDS_3_2,
+   WIND_4_SUBBANDS_3_3, WIND_4_SUBBANDS_3_4},
+  {WIND_4_SUBBANDS_4_0, WIND_4_SUBBANDS_4_1, WIND_4_SUBBANDS_4_2,
+   WIND_4_SUBBANDS_4_1, WIND_4_SUBBANDS_4_0},
+};
+
+/* The same coefficients laid out like the samples they multiply: tap t of
+ * output i is at [t * 2 * subbands + i] */
+static int16_t as16Window8[5 * 16];
+static int16_t as16Window4[5 * 8];
+
+static void SbcBuildWindowTable(const int16_t (*ps16Rows)[5],
+                                int32_t s32NumOfOutputs, int16_t* ps16Out) {
+  int32_t i, t;
+  int32_t s32Half = s32NumOfOutputs / 2;
+
+  for (t = 0; t < 5; t++) {
+    for (i = 0; i <= s32Half; i++)
+      ps16Out[t * s32NumOfOutputs + i] = ps16Rows[i][t];
+    for (i = 1; i < s32Half; i++)
+      ps16Out[t * s32NumOfOutputs + s32NumOfOutputs - i] = ps16Rows[i][4 - t];
+  }
+}
+#endif
+
 static int16_t ShiftCounter = 0;
 extern int16_t EncMaxShiftCounter;
 /****************************************************************************
@@ -1220,6 +1283,10 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
   s32NumOfChannels = pstrEncParams->s16NumOfChannels;
   s32NumOfBlocks = pstrEncParams->s16NumOfBlocks;
 
+#if (SBC_SIMD_WINDOW == TRUE)
+  bool bSimd = SbcSimdEnabled();
+#endif
+
   ps16PcmBuf = input;
 
   ps32SbBuf = pstrEncParams->s32SbBuffer;
@@ -1257,7 +1324,12 @@ void SbcAnalysisFilter4(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
     for (s32Ch = 0; s32Ch < s32NumOfChannels; s32Ch++) {
       ChOffset = s32Ch * Offset2 + Offset;
 
-      WINDOW_PARTIAL_4
+#if (SBC_SIMD_WINDOW == TRUE)
+      if (bSimd)
+        SbcWindowSimd(s16X + ChOffset, as16Window4, 8, s32DCTY);
+      else
+#endif
+        WINDOW_PARTIAL_4
 
       SBC_FastIDCT4(s32DCTY, ps32SbBuf);
 
@@ -1309,6 +1381,10 @@ void SbcAnalysisFilter8(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
   s32NumOfChannels = pstrEncParams->s16NumOfChannels;
   s32NumOfBlocks = pstrEncParams->s16NumOfBlocks;
 
+#if (SBC_SIMD_WINDOW == TRUE)
+  bool bSimd = SbcSimdEnabled();
+#endif
+
   ps16PcmBuf = input;
 
   ps32SbBuf = pstrEncParams->s32SbBuffer;
@@ -1370,7 +1446,12 @@ void SbcAnalysisFilter8(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
     for (s32Ch = 0; s32Ch < s32NumOfChannels; s32Ch++) {
       ChOffset = s32Ch * Offset2 + Offset;
 
-      WINDOW_PARTIAL_8
+#if (SBC_SIMD_WINDOW == TRUE)
+      if (bSimd)
+        SbcWindowSimd(s16X + ChOffset, as16Window8, 16, s32DCTY);
+      else
+#endif
+        WINDOW_PARTIAL_8
 
       SBC_FastIDCT8(s32DCTY, ps32SbBuf);
 
@@ -1397,4 +1478,9 @@ void SbcAnalysisFilter8(SBC_ENC_PARAMS* pstrEncParams, int16_t* input) {
 void SbcAnalysisInit(void) {
   memset(s16X, 0, ENC_VX_BUFFER_SIZE * sizeof(int16_t));
   ShiftCounter = 0;
+  SbcSimdInit();
+#if (SBC_SIMD_WINDOW == TRUE)
+  SbcBuildWindowTable(as16Window8Rows, 16, as16Window8);
+  SbcBuildWindowTable(as16Window4Rows, 8, as16Window4);
+#endif
 }
@@ -0,0 +1,174 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the vector versions of the analysis windowing and of
+ *  the scale factor search. Both only use exact integer arithmetic, so their
+ *  output is bit exact with the C code in sbc_analysis.c and sbc_encoder.c.
+ *
+ ******************************************************************************/
+#include "sbc_enc_func_declare.h"
+#include "sbc_encoder.h"
+
+#if (SBC_SIMD_OPT == TRUE) && (defined(__aarch64__) || defined(__ARM_NEON))
+#define SBC_SIMD_NEON
+#include <arm_neon.h>
+#if !defined(__aarch64__)
+#include <sys/auxv.h>
+#ifndef HWCAP_NEON
+#define HWCAP_NEON (1 << 12)
+#endif
+#endif
+#elif (SBC_SIMD_OPT == TRUE) && defined(__SSE2__)
+#define SBC_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+/* Number of taps of the analysis window per output */
+#define SBC_WINDOW_TAPS 5
+
+/* Lets a test or a benchmark compare against the C code */
+bool SbcSimdForceScalar = false;
+
+static bool sbc_simd_enabled = false;
+
+static bool sbc_simd_supported(void) {
+#if defined(SBC_SIMD_NEON) && defined(__aarch64__)
+  return true;
+#elif defined(SBC_SIMD_NEON)
+  return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#elif defined(SBC_SIMD_SSE2)
+  return true;
+#else
+  return false;
+#endif
+}
+
+/****************************************************************************
+ * SbcSimdInit - selects the vector kernels if the CPU supports them
+ *
+ * RETURNS : N/A
+ */
+void SbcSimdInit(void) {
+  sbc_simd_enabled = !SbcSimdForceScalar && sbc_simd_supported();
+}
+
+bool SbcSimdEnabled(void) { return sbc_simd_enabled; }
+
+/****************************************************************************
+ * SbcWindowSimd - computes the windowed partial sums of one block
+ *
+ * ps32Y[i] = sum over t of ps16Coeffs[t * n + i] * ps16X[t * n + i], for the
+ * |s32NumOfOutputs| (n) outputs and the five taps of the window. n is 8 for
+ * 4 subbands and 16 for 8 subbands.
+ *
+ * RETURNS : N/A
+ */
+void SbcWindowSimd(const int16_t* ps16X, const int16_t* ps16Coeffs,
+                   int32_t s32NumOfOutputs, int32_t* ps32Y) {
+  int32_t i, t;
+
+  for (i = 0; i < s32NumOfOutputs; i += 8) {
+#if defined(SBC_SIMD_NEON)
+    int32x4_t lo = vdupq_n_s32(0);
+    int32x4_t hi = vdupq_n_s32(0);
+    for (t = 0; t < SBC_WINDOW_TAPS; t++) {
+      int16x8_t x = vld1q_s16(ps16X + t * s32NumOfOutputs + i);
+      int16x8_t c = vld1q_s16(ps16Coeffs + t * s32NumOfOutputs + i);
+      lo = vmlal_s16(lo, vget_low_s16(x), vget_low_s16(c));
+      hi = vmlal_s16(hi, vget_high_s16(x), vget_high_s16(c));
+    }
+    vst1q_s32(ps32Y + i, lo);
+    vst1q_s32(ps32Y + i + 4, hi);
+#elif defined(SBC_SIMD_SSE2)
+    __m128i lo = _mm_setzero_si128();
+    __m128i hi = _mm_setzero_si128();
+    for (t = 0; t < SBC_WINDOW_TAPS; t++) {
+      __m128i x = _mm_loadu_si128(
+          (const __m128i*)(ps16X + t * s32NumOfOutputs + i));
+      __m128i c = _mm_loadu_si128(
+          (const __m128i*)(ps16Coeffs + t * s32NumOfOutputs + i));
+      /* Interleave the low and high halves into full 32 bit products */
+      __m128i p_lo = _mm_mullo_epi16(x, c);
+      __m128i p_hi = _mm_mulhi_epi16(x, c);
+      lo = _mm_add_epi32(lo, _mm_unpacklo_epi16(p_lo, p_hi));
+      hi = _mm_add_epi32(hi, _mm_unpackhi_epi16(p_lo, p_hi));
+    }
+    _mm_storeu_si128((__m128i*)(ps32Y + i), lo);
+    _mm_storeu_si128((__m128i*)(ps32Y + i + 4), hi);
+#else
+    int32_t j;
+    for (j = i; j < i + 8; j++) {
+      int32_t s32Temp = 0;
+      for (t = 0; t < SBC_WINDOW_TAPS; t++) {
+        s32Temp += (int32_t)ps16Coeffs[t * s32NumOfOutputs + j] *
+                   (int32_t)ps16X[t * s32NumOfOutputs + j];
+      }
+      ps32Y[j] = s32Temp;
+    }
+#endif
+  }
+}
+
+/****************************************************************************
+ * SbcMaxAbsSimd - finds the largest magnitude of each subband over a frame
+ *
+ * |ps32SbBuf| holds |s32NumOfBlocks| rows of |s32Ch| subband samples, one
+ * per channel and subband. |ps32Max| receives |s32Ch| values.
+ *
+ * RETURNS : N/A
+ */
+void SbcMaxAbsSimd(const int32_t* ps32SbBuf, int32_t s32Ch,
+                   int32_t s32NumOfBlocks, int32_t* ps32Max) {
+  int32_t s32Sb, s32Blk;
+
+  for (s32Sb = 0; s32Sb < s32Ch; s32Sb += 4) {
+    const int32_t* ps32Sb = ps32SbBuf + s32Sb;
+#if defined(SBC_SIMD_NEON)
+    int32x4_t max = vdupq_n_s32(0);
+    for (s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
+      max = vmaxq_s32(max, vabsq_s32(vld1q_s32(ps32Sb)));
+      ps32Sb += s32Ch;
+    }
+    vst1q_s32(ps32Max + s32Sb, max);
+#elif defined(SBC_SIMD_SSE2)
+    /* SSE2 has neither a 32 bit abs nor a 32 bit max */
+    __m128i max = _mm_setzero_si128();
+    for (s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
+      __m128i v = _mm_loadu_si128((const __m128i*)ps32Sb);
+      __m128i sign = _mm_srai_epi32(v, 31);
+      __m128i mag = _mm_sub_epi32(_mm_xor_si128(v, sign), sign);
+      __m128i gt = _mm_cmpgt_epi32(mag, max);
+      max = _mm_or_si128(_mm_and_si128(gt, mag), _mm_andnot_si128(gt, max));
+      ps32Sb += s32Ch;
+    }
+    _mm_storeu_si128((__m128i*)(ps32Max + s32Sb), max);
+#else
+    int32_t j;
+    for (j = 0; j < 4; j++) ps32Max[s32Sb + j] = 0;
+    for (s32Blk = 0; s32Blk < s32NumOfBlocks; s32Blk++) {
+      for (j = 0; j < 4; j++) {
+        if (ps32Max[s32Sb + j] < abs32(ps32Sb[j]))
+          ps32Max[s32Sb + j] = abs32(ps32Sb[j]);
+      }
+      ps32Sb += s32Ch;
+    }
+#endif
+  }
+}
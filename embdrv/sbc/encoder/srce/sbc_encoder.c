@@ -40,6 +40,8 @@ uint32_t SBC_Encode(SBC_ENC_PARAMS* pstrEncParams, int16_t* input,
   int32_t s32Sb;                 /* counter for sub-band*/
   uint32_t u32Count, maxBit = 0; /* loop count*/
   int32_t s32MaxValue;           /* temp variable to store max value */
+  int32_t as32MaxValue[SBC_BLK]; /* max value per sub-band, vector path */
+  bool bSimd = SbcSimdEnabled();
 
   int16_t* ps16ScfL;
   int32_t* SbBuffer;
@@ -62,12 +64,20 @@ uint32_t SBC_Encode(SBC_ENC_PARAMS* pstrEncParams, int16_t* input,
   ps16ScfL = pstrEncParams->as16ScaleFactor;
   s32Ch = pstrEncParams->s16NumOfChannels * s32NumOfSubBands;
 
+  if (bSimd)
+    SbcMaxAbsSimd(pstrEncParams->s32SbBuffer, s32Ch, s32NumOfBlocks,
+                  as32MaxValue);
+
   for (s32Sb = 0; s32Sb < s32Ch; s32Sb++) {
-    SbBuffer = pstrEncParams->s32SbBuffer + s32Sb;
-    s32MaxValue = 0;
-    for (s32Blk = s32NumOfBlocks; s32Blk > 0; s32Blk--) {
-      if (s32MaxValue < abs32(*SbBuffer)) s32MaxValue = abs32(*SbBuffer);
-      SbBuffer += s32Ch;
+    if (bSimd) {
+      s32MaxValue = as32MaxValue[s32Sb];
+    } else {
+      SbBuffer = pstrEncParams->s32SbBuffer + s32Sb;
+      s32MaxValue = 0;
+      for (s32Blk = s32NumOfBlocks; s32Blk > 0; s32Blk--) {
+        if (s32MaxValue < abs32(*SbBuffer)) s32MaxValue = abs32(*SbBuffer);
+        SbBuffer += s32Ch;
+      }
     }
 
     u32Count = (s32MaxValue > 0x800000) ? 9 : 0;
@@ -167,6 +177,15 @@ void SBC_Encoder_Init(SBC_ENC_PARAMS* pstrEncParams) {
   int16_t s16FrameLen;      /*to store frame length*/
   uint16_t HeaderParams;
 
+  /* mSBC has fixed parameters */
+  if (pstrEncParams->Format == SBC_FORMAT_MSBC) {
+    pstrEncParams->s16SamplingFreq = SBC_sf16000;
+    pstrEncParams->s16ChannelMode = SBC_MONO;
+    pstrEncParams->s16NumOfSubBands = SUB_BANDS_8;
+    pstrEncParams->s16NumOfBlocks = SBC_MSBC_BLOCKS;
+    pstrEncParams->s16AllocationMethod = SBC_LOUDNESS;
+  }
+
   /* Required number of channels */
   if (pstrEncParams->s16ChannelMode == SBC_MONO)
     pstrEncParams->s16NumOfChannels = 1;
@@ -228,6 +247,8 @@ void SBC_Encoder_Init(SBC_ENC_PARAMS* pstrEncParams) {
   }
 
   if (pstrEncParams->s16BitPool < 0) pstrEncParams->s16BitPool = 0;
+  if (pstrEncParams->Format == SBC_FORMAT_MSBC)
+    pstrEncParams->s16BitPool = SBC_MSBC_BITPOOL;
   /* sampling freq */
   HeaderParams = ((pstrEncParams->s16SamplingFreq & 3) << 6);
 
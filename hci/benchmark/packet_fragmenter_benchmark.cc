@@ -0,0 +1,213 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+// Times the ACL packet fragmenter on its own, behind a fake controller:
+//   BM_FragmentAndDispatch     - one outgoing L2CAP packet of |range| bytes
+//                                cut into ACL fragments, handed out one at a
+//                                time or in batches
+//   BM_ReassembleAndDispatch   - one incoming L2CAP packet of |range| bytes
+//                                put back together from its ACL fragments
+// The classic variants use the 1021 byte ACL buffers of a 3-DH5 capable
+// controller, the LE ones the 251 byte buffers of LE Data Length Extension.
+// One iteration is one L2CAP packet, processed as bytes.
+
+#include <benchmark/benchmark.h>
+
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "device/include/controller.h"
+#include "hci_internals.h"
+#include "osi/include/allocator.h"
+#include "osi/include/osi.h"
+#include "packet_fragmenter.h"
+
+using ::benchmark::State;
+
+namespace {
+
+constexpr uint16_t kHandle = 0x0042;
+constexpr uint16_t kAclDataSizeClassic = 1021;
+constexpr uint16_t kAclDataSizeBle = 251;
+constexpr uint16_t kLocalBleControllerId = 1;
+constexpr uint16_t kL2capHeaderSize = 4;
+
+const packet_fragmenter_t* fragmenter;
+controller_t controller;
+packet_fragmenter_callbacks_t callbacks;
+size_t fragments_sent;
+
+// Fragments handed to the reassembler are owned by the benchmark, which
+// reuses them for every iteration.
+std::vector<BT_HDR*> input_fragments;
+
+uint16_t get_acl_data_size_classic(void) { return kAclDataSizeClassic; }
+uint16_t get_acl_data_size_ble(void) { return kAclDataSizeBle; }
+
+void* benchmark_alloc(size_t size) { return osi_malloc(size); }
+
+void benchmark_free(void* ptr) {
+  for (BT_HDR* fragment : input_fragments) {
+    if (ptr == fragment) return;
+  }
+  osi_free(ptr);
+}
+
+const allocator_t benchmark_allocator = {benchmark_alloc, benchmark_free};
+
+void fragmented(BT_HDR* packet, bool send_transmit_finished) {
+  fragments_sent++;
+}
+
+void fragments_ready(BT_HDR* packet, const acl_fragment_t* fragments,
+                     size_t count, bool send_transmit_finished) {
+  fragments_sent += count;
+}
+
+void reassembled(BT_HDR* packet) {
+  benchmark::DoNotOptimize(packet->data[packet->len - 1]);
+  benchmark_free(packet);
+}
+
+void transmit_finished(BT_HDR* packet, bool all_fragments_sent) {}
+
+void setup(bool batched) {
+  controller.get_acl_data_size_classic = get_acl_data_size_classic;
+  controller.get_acl_data_size_ble = get_acl_data_size_ble;
+  callbacks.fragmented = fragmented;
+  callbacks.reassembled = reassembled;
+  callbacks.transmit_finished = transmit_finished;
+  callbacks.fragments_ready = batched ? fragments_ready : nullptr;
+  fragmenter =
+      packet_fragmenter_get_test_interface(&controller, &benchmark_allocator);
+  fragmenter->init(&callbacks);
+  fragments_sent = 0;
+}
+
+void teardown(State& state) {
+  fragmenter->cleanup();
+  for (BT_HDR* fragment : input_fragments) osi_free(fragment);
+  input_fragments.clear();
+  state.counters["fragments"] = benchmark::Counter(
+      fragments_sent, benchmark::Counter::kAvgIterations);
+}
+
+void BM_FragmentAndDispatch(State& state, uint16_t controller_id,
+                            bool batched) {
+  setup(batched);
+
+  uint16_t l2cap_len = state.range(0);
+  uint16_t acl_len = l2cap_len + HCI_ACL_PREAMBLE_SIZE;
+  BT_HDR* packet = (BT_HDR*)osi_calloc(sizeof(BT_HDR) + acl_len);
+
+  for (auto _ : state) {
+    // The fragmenter moves the packet along as it goes
+    packet->event = MSG_STACK_TO_HC_HCI_ACL | controller_id;
+    packet->offset = 0;
+    packet->len = acl_len;
+    packet->layer_specific = 0;
+    uint8_t* p = packet->data;
+    UINT16_TO_STREAM(p, kHandle | 0x2000);
+    UINT16_TO_STREAM(p, l2cap_len);
+    fragmenter->fragment_and_dispatch(packet);
+  }
+
+  osi_free(packet);
+  teardown(state);
+  state.SetBytesProcessed(state.iterations() * l2cap_len);
+}
+
+void BM_ReassembleAndDispatch(State& state, uint16_t acl_data_size) {
+  setup(false);
+
+  uint16_t l2cap_len = state.range(0);
+  std::vector<uint8_t> pdu(kL2capHeaderSize + l2cap_len, 0x5a);
+  uint8_t* p = pdu.data();
+  UINT16_TO_STREAM(p, l2cap_len);
+  UINT16_TO_STREAM(p, 0x0040);
+
+  for (size_t offset = 0; offset < pdu.size(); offset += acl_data_size) {
+    uint16_t len = std::min<size_t>(acl_data_size, pdu.size() - offset);
+    BT_HDR* fragment =
+        (BT_HDR*)osi_malloc(sizeof(BT_HDR) + HCI_ACL_PREAMBLE_SIZE + len);
+    p = fragment->data;
+    UINT16_TO_STREAM(p, kHandle | (offset == 0 ? 0x2000 : 0x1000));
+    UINT16_TO_STREAM(p, len);
+    memcpy(p, &pdu[offset], len);
+    fragment->event = MSG_HC_TO_STACK_HCI_ACL;
+    fragment->len = HCI_ACL_PREAMBLE_SIZE + len;
+    input_fragments.push_back(fragment);
+  }
+
+  for (auto _ : state) {
+    // The reassembler moves continuation fragments along as it copies them
+    for (BT_HDR* fragment : input_fragments) {
+      fragment->offset = 0;
+      fragmenter->reassemble_and_dispatch(fragment);
+    }
+    fragments_sent += input_fragments.size();
+  }
+
+  teardown(state);
+  state.SetBytesProcessed(state.iterations() * l2cap_len);
+}
+
+void register_benchmarks() {
+  const int sizes[] = {64, 672, 1017, 2048, 4096};
+  struct {
+    const char* name;
+    uint16_t controller_id;
+    bool batched;
+  } fragment_variants[] = {
+      {"BM_FragmentAndDispatch/classic", LOCAL_BR_EDR_CONTROLLER_ID, false},
+      {"BM_FragmentAndDispatch/classic_batched", LOCAL_BR_EDR_CONTROLLER_ID,
+       true},
+      {"BM_FragmentAndDispatch/le", kLocalBleControllerId, false},
+      {"BM_FragmentAndDispatch/le_batched", kLocalBleControllerId, true},
+  };
+  for (const auto& variant : fragment_variants) {
+    auto* benchmark = ::benchmark::RegisterBenchmark(
+        variant.name, BM_FragmentAndDispatch, variant.controller_id,
+        variant.batched);
+    for (int size : sizes) benchmark->Arg(size);
+  }
+
+  auto* classic = ::benchmark::RegisterBenchmark(
+      "BM_ReassembleAndDispatch/classic", BM_ReassembleAndDispatch,
+      kAclDataSizeClassic);
+  auto* le = ::benchmark::RegisterBenchmark("BM_ReassembleAndDispatch/le",
+                                            BM_ReassembleAndDispatch,
+                                            kAclDataSizeBle);
+  for (int size : sizes) {
+    classic->Arg(size);
+    le->Arg(size);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  register_benchmarks();
+
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,80 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bt_types.h"
+#include "osi/include/allocator.h"
+#include "osi/include/time.h"
+
+// Pre-dispatch stage for LE advertising report events. Exact duplicate
+// reports seen again within a time window can be dropped, and single-report
+// events can be merged into one multi-report event before they go up to btu.
+// Events that are not advertising reports pass through unchanged and in
+// order. All functions are thread safe.
+
+typedef struct {
+  // Reports identical to one seen less than this long ago are dropped. Zero
+  // disables duplicate filtering.
+  period_ms_t duplicate_window_ms;
+
+  // Maximum number of reports merged into one event. Zero or one disables
+  // coalescing.
+  size_t max_batch_reports;
+} adv_report_filter_config_t;
+
+typedef struct {
+  uint64_t reports_received;
+  uint64_t duplicates_dropped;
+  uint64_t reports_coalesced;  // Reports merged into an event with others.
+  uint64_t batches_dispatched;
+} adv_report_filter_stats_t;
+
+// Called with every event leaving the filter. Takes ownership of |packet|.
+typedef void (*adv_report_dispatch_cb)(BT_HDR* packet);
+
+typedef struct adv_report_filter_t {
+  // Configures the filter and resets its state and counters. Events leaving
+  // the filter are handed to |dispatch|.
+  void (*init)(const adv_report_filter_config_t* config,
+               adv_report_dispatch_cb dispatch);
+
+  // Drops any pending batch and the duplicate history.
+  void (*cleanup)(void);
+
+  // Takes ownership of the HCI event |packet| received at |now_ms|. Returns
+  // true if a batch is pending afterwards; the caller must then make sure
+  // |flush| is called within its coalescing delay.
+  bool (*process)(BT_HDR* packet, period_ms_t now_ms);
+
+  // Dispatches the pending batch, if any.
+  void (*flush)(void);
+
+  // Fills |stats| with the counters collected since |init|.
+  void (*get_stats)(adv_report_filter_stats_t* stats);
+} adv_report_filter_t;
+
+const adv_report_filter_t* adv_report_filter_get_interface();
+
+const adv_report_filter_t* adv_report_filter_get_test_interface(
+    const allocator_t* buffer_allocator_interface);
@@ -68,3 +68,8 @@ typedef struct btsnoop_t {
 } btsnoop_t;
 
 const btsnoop_t* btsnoop_get_interface(void);
+
+// Writes the rolling snoop log, if that capture mode is active, to |fd| as a
+// regular btsnoop file with the oldest packet first. Returns false if there
+// is no rolling log.
+bool btsnoop_write_rolling_log(int fd);
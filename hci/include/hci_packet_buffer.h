@@ -0,0 +1,41 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "bt_types.h"
+#include "osi/include/packet_buffer.h"
+
+// Conversions between |packet_buffer_t| and the |BT_HDR| buffers exchanged
+// with the HCI layer.
+
+// Wraps the payload of |buffer| in a packet buffer without copying it. The
+// |buffer->offset| bytes in front of the payload are available as headroom.
+// Ownership of |buffer| is transferred; it is freed once the last packet
+// referring to it is freed. |buffer| may not be NULL.
+packet_buffer_t* hci_packet_buffer_from_bt_hdr(BT_HDR* buffer);
+
+// Returns a new |BT_HDR| holding the contents of |packet| at |offset| bytes
+// into its data. This is the one place the payload is linearized, so it
+// should only be done when handing the packet to the HCI layer. |event| and
+// |layer_specific| are copied into the header. The returned buffer must be
+// freed with |osi_free|. |packet| may not be NULL and its length must fit in
+// a |BT_HDR|.
+BT_HDR* hci_packet_buffer_to_bt_hdr(const packet_buffer_t* packet,
+                                    uint16_t offset, uint16_t event,
+                                    uint16_t layer_specific);
@@ -0,0 +1,107 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bt_types.h"
+#include "hci_hal.h"
+#include "osi/include/allocator.h"
+#include "osi/include/time.h"
+
+// Replays the controller side of a btsnoop capture (H4 datalink, as written
+// by btsnoop.cc) in place of the HAL. Inbound packets are delivered with the
+// recorded spacing, scaled by the replay speed, and each one waits until the
+// stack has sent as many packets as were sent before it in the capture, so
+// that e.g. a Command Complete never overtakes its command. Outbound packets
+// are compared with the capture by their structure: the opcode and length of
+// commands, the handle, boundary flag, channel and length of ACL and SCO
+// data. While the replay runs it collects the CPU time and osi allocations of
+// the process and how long the stack took to answer inbound packets. All
+// functions are thread safe.
+
+typedef struct {
+  // Replay speed in percent of the recorded timing: 100 keeps it, 1000 is ten
+  // times faster. Zero delivers every packet as soon as the outbound packets
+  // it waits for were sent.
+  uint32_t speed_percent;
+
+  // Longest an inbound packet waits for the stack to send the outbound
+  // packets recorded before it. It is delivered anyway after that.
+  period_ms_t outbound_timeout_ms;
+} hci_replay_config_t;
+
+typedef struct {
+  uint64_t inbound_packets;  // Delivered to the stack.
+  uint64_t inbound_bytes;
+  uint64_t inbound_skipped;  // Truncated by a filtered capture.
+  uint64_t outbound_recorded;
+  uint64_t outbound_matched;     // Same structure as a recorded packet.
+  uint64_t outbound_mismatched;  // No recorded packet nearby had it.
+  uint64_t outbound_timeouts;    // The stack did not send in time.
+
+  // Time from delivering an inbound packet to the next outbound packet.
+  uint64_t response_count;
+  uint64_t response_total_us;
+  uint64_t response_max_us;
+
+  uint64_t wall_time_us;
+  uint64_t cpu_time_us;
+  // Counted while the replay runs, see |osi_allocator_get_sampled|.
+  size_t allocations;
+  size_t allocated_bytes;
+
+  bool finished;  // Every inbound packet of the capture was delivered.
+} hci_replay_stats_t;
+
+// Called on the replay thread with each inbound packet, as the HAL would have
+// handed it up. Takes ownership of |packet|.
+typedef void (*hci_replay_deliver_cb)(serial_data_type_t type, BT_HDR* packet);
+
+typedef struct hci_replay_t {
+  // Reads the capture at |path|. Returns false if it is not an H4 btsnoop
+  // file.
+  bool (*load)(const char* path);
+
+  // Starts delivering the inbound packets of the loaded capture to |deliver|
+  // and resets the statistics. Returns false if nothing was loaded.
+  bool (*start)(const hci_replay_config_t* config,
+                hci_replay_deliver_cb deliver);
+
+  // Stops the replay, waiting for a delivery in progress to finish.
+  void (*stop)(void);
+
+  // Compares the outbound packet |data| of |length| bytes, without the H4
+  // type byte, with the capture.
+  void (*transmit)(serial_data_type_t type, const uint8_t* data,
+                   size_t length);
+
+  // Fills |stats| with the counters of the current or last replay.
+  void (*get_stats)(hci_replay_stats_t* stats);
+
+  // Dumps the counters and the per-layer packet latencies to |fd|.
+  void (*debug_dump)(int fd);
+} hci_replay_t;
+
+const hci_replay_t* hci_replay_get_interface();
+
+const hci_replay_t* hci_replay_get_test_interface(
+    const allocator_t* buffer_allocator_interface);
@@ -19,6 +19,7 @@
 #pragma once
 
 #include "bt_types.h"
+#include "hci_internals.h"
 #include "hci_layer.h"
 #include "osi/include/allocator.h"
 
@@ -27,6 +28,28 @@ typedef void (*packet_reassembled_cb)(BT_HDR* packet);
 typedef void (*packet_fragmented_cb)(BT_HDR* packet,
                                      bool send_transmit_finished);
 
+// Maximum number of fragments handed to |fragments_ready| in one call.
+#define PACKET_FRAGMENTER_MAX_BATCH 64
+
+// One outgoing ACL fragment: its ACL header and the slice of the original
+// packet that follows it on the wire. |payload| points into the packet being
+// fragmented and stays valid for the duration of the callback.
+typedef struct {
+  uint8_t header[HCI_ACL_PREAMBLE_SIZE];
+  const uint8_t* payload;
+  uint16_t payload_length;
+} acl_fragment_t;
+
+// Called with up to |PACKET_FRAGMENTER_MAX_BATCH| consecutive fragments of
+// |packet|. The packet bytes are not modified while the fragments are built,
+// so the receiver may write them out as header/payload pairs without copying.
+// Once the callback returns the fragmenter may overwrite the bytes in front
+// of each payload.
+typedef void (*packet_fragments_ready_cb)(BT_HDR* packet,
+                                          const acl_fragment_t* fragments,
+                                          size_t count,
+                                          bool send_transmit_finished);
+
 typedef struct {
   // Called for every packet fragment.
   packet_fragmented_cb fragmented;
@@ -37,6 +60,10 @@ typedef struct {
   // Called when the fragmenter finishes sending all requested fragments,
   // but the packet has not been entirely sent.
   transmit_finished_cb transmit_finished;
+
+  // Optional. If set, ACL packets that need fragmenting are handed out as
+  // batches of fragments instead of calling |fragmented| once per fragment.
+  packet_fragments_ready_cb fragments_ready;
 } packet_fragmenter_callbacks_t;
 
 typedef struct packet_fragmenter_t {
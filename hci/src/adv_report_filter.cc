@@ -0,0 +1,270 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+
+#define LOG_TAG "bt_hci_adv_report_filter"
+
+#include "adv_report_filter.h"
+
+#include <base/logging.h>
+#include <string.h>
+
+#include <mutex>
+
+#include "buffer_allocator.h"
+#include "hci_internals.h"
+#include "hcidefs.h"
+#include "osi/include/log.h"
+
+// Report layouts as parsed by btm_ble_process_adv_pkt and
+// btm_ble_process_ext_adv_pkt: a fixed header whose last byte is the data
+// length, followed by the data (and the RSSI for legacy reports).
+#define LEGACY_REPORT_HEADER_SIZE 9
+#define EXTENDED_REPORT_HEADER_SIZE 24
+
+// Bits 5-6 of the extended report event type hold the data status.
+#define EXTENDED_DATA_STATUS(event_type) (((event_type) >> 5) & 0x03)
+
+// LE meta event header: subevent code and number of reports.
+#define ADV_REPORT_EVENT_HEADER_SIZE 2
+#define HCI_EVENT_MAX_PARAM_SIZE 255
+
+#define DUPLICATE_TABLE_SIZE 256
+
+typedef struct {
+  uint64_t hash;
+  period_ms_t last_seen;
+  bool used;
+} duplicate_entry_t;
+
+static const allocator_t* buffer_allocator;
+
+static std::mutex filter_mutex;
+static adv_report_filter_config_t filter_config;
+static adv_report_dispatch_cb dispatch_cb;
+static adv_report_filter_stats_t filter_stats;
+static duplicate_entry_t duplicates[DUPLICATE_TABLE_SIZE];
+
+// The batch being built and its subevent code, guarded by |filter_mutex|.
+static BT_HDR* pending_batch;
+static uint8_t pending_subevent;
+
+static void flush_locked(void);
+
+static void init(const adv_report_filter_config_t* config,
+                 adv_report_dispatch_cb dispatch) {
+  CHECK(config != NULL);
+  CHECK(dispatch != NULL);
+
+  std::lock_guard<std::mutex> lock(filter_mutex);
+  buffer_allocator->free(pending_batch);
+  pending_batch = NULL;
+  filter_config = *config;
+  dispatch_cb = dispatch;
+  memset(&filter_stats, 0, sizeof(filter_stats));
+  memset(duplicates, 0, sizeof(duplicates));
+}
+
+static void cleanup(void) {
+  std::lock_guard<std::mutex> lock(filter_mutex);
+  buffer_allocator->free(pending_batch);
+  pending_batch = NULL;
+  memset(duplicates, 0, sizeof(duplicates));
+}
+
+// Returns true if |packet| is an LE advertising report event carrying exactly
+// one well formed report, and points |report| and |report_length| at it.
+static bool get_single_report(const BT_HDR* packet, uint8_t* subevent,
+                              const uint8_t** report, size_t* report_length) {
+  const uint8_t* stream = packet->data + packet->offset;
+  if (packet->len < HCI_EVENT_PREAMBLE_SIZE + ADV_REPORT_EVENT_HEADER_SIZE)
+    return false;
+
+  uint8_t event_code = stream[0];
+  uint8_t param_length = stream[1];
+  if (event_code != HCI_BLE_EVENT || param_length < ADV_REPORT_EVENT_HEADER_SIZE ||
+      packet->len < HCI_EVENT_PREAMBLE_SIZE + param_length)
+    return false;
+
+  uint8_t num_reports = stream[3];
+  if (num_reports != 1) return false;
+
+  const uint8_t* data = stream + HCI_EVENT_PREAMBLE_SIZE +
+                        ADV_REPORT_EVENT_HEADER_SIZE;
+  size_t length = param_length - ADV_REPORT_EVENT_HEADER_SIZE;
+
+  switch (stream[2]) {
+    case HCI_BLE_ADV_PKT_RPT_EVT:
+      // Header, data and one byte of RSSI.
+      if (length < LEGACY_REPORT_HEADER_SIZE + 1 ||
+          length != LEGACY_REPORT_HEADER_SIZE +
+                        data[LEGACY_REPORT_HEADER_SIZE - 1] + 1)
+        return false;
+      break;
+    case HCI_LE_EXTENDED_ADVERTISING_REPORT_EVT:
+      if (length < EXTENDED_REPORT_HEADER_SIZE ||
+          length != EXTENDED_REPORT_HEADER_SIZE +
+                        data[EXTENDED_REPORT_HEADER_SIZE - 1])
+        return false;
+      break;
+    default:
+      return false;
+  }
+
+  *subevent = stream[2];
+  *report = data;
+  *report_length = length;
+  return true;
+}
+
+// FNV-1a over the subevent code and the report bytes.
+static uint64_t report_hash(uint8_t subevent, const uint8_t* report,
+                            size_t length) {
+  uint64_t hash = 1469598103934665603ULL;
+  hash = (hash ^ subevent) * 1099511628211ULL;
+  for (size_t i = 0; i < length; i++)
+    hash = (hash ^ report[i]) * 1099511628211ULL;
+  return hash;
+}
+
+static bool is_duplicate_locked(uint8_t subevent, const uint8_t* report,
+                                size_t length, period_ms_t now_ms) {
+  // Fragments of an incomplete extended report only make sense together.
+  if (subevent == HCI_LE_EXTENDED_ADVERTISING_REPORT_EVT) {
+    uint16_t event_type = report[0] | (report[1] << 8);
+    if (EXTENDED_DATA_STATUS(event_type) != 0) return false;
+  }
+
+  uint64_t hash = report_hash(subevent, report, length);
+  duplicate_entry_t* entry = &duplicates[hash % DUPLICATE_TABLE_SIZE];
+  if (entry->used && entry->hash == hash &&
+      now_ms - entry->last_seen < filter_config.duplicate_window_ms)
+    return true;
+
+  // Only a report that gets through restarts the window, so a steady
+  // advertiser is still reported once per window.
+  entry->hash = hash;
+  entry->last_seen = now_ms;
+  entry->used = true;
+  return false;
+}
+
+static void append_report_locked(const BT_HDR* packet, uint8_t subevent,
+                                 const uint8_t* report, size_t length) {
+  if (pending_batch &&
+      (pending_subevent != subevent ||
+       pending_batch->len + length >
+           HCI_EVENT_PREAMBLE_SIZE + HCI_EVENT_MAX_PARAM_SIZE))
+    flush_locked();
+
+  if (!pending_batch) {
+    pending_batch = (BT_HDR*)buffer_allocator->alloc(
+        sizeof(BT_HDR) + HCI_EVENT_PREAMBLE_SIZE + HCI_EVENT_MAX_PARAM_SIZE);
+    pending_batch->event = packet->event;
+    pending_batch->offset = 0;
+    pending_batch->layer_specific = packet->layer_specific;
+    pending_batch->len = HCI_EVENT_PREAMBLE_SIZE + ADV_REPORT_EVENT_HEADER_SIZE;
+    pending_batch->data[0] = HCI_BLE_EVENT;
+    pending_batch->data[2] = subevent;
+    pending_batch->data[3] = 0;
+    pending_subevent = subevent;
+  }
+
+  uint8_t* data = pending_batch->data;
+  memcpy(data + pending_batch->len, report, length);
+  pending_batch->len += length;
+  data[1] = pending_batch->len - HCI_EVENT_PREAMBLE_SIZE;
+  data[3]++;
+
+  if (data[3] > 1) {
+    // The first report of the batch is counted once a second one joins it.
+    filter_stats.reports_coalesced += (data[3] == 2) ? 2 : 1;
+  }
+
+  if (data[3] >= filter_config.max_batch_reports) flush_locked();
+}
+
+static void flush_locked(void) {
+  if (!pending_batch) return;
+
+  BT_HDR* batch = pending_batch;
+  pending_batch = NULL;
+  filter_stats.batches_dispatched++;
+  dispatch_cb(batch);
+}
+
+static bool process(BT_HDR* packet, period_ms_t now_ms) {
+  CHECK(packet != NULL);
+
+  std::lock_guard<std::mutex> lock(filter_mutex);
+  CHECK(dispatch_cb != NULL);
+
+  uint8_t subevent;
+  const uint8_t* report;
+  size_t length;
+  if (!get_single_report(packet, &subevent, &report, &length)) {
+    // Anything else must not overtake the reports received before it.
+    flush_locked();
+    dispatch_cb(packet);
+    return false;
+  }
+
+  filter_stats.reports_received++;
+
+  if (filter_config.duplicate_window_ms &&
+      is_duplicate_locked(subevent, report, length, now_ms)) {
+    filter_stats.duplicates_dropped++;
+    buffer_allocator->free(packet);
+    return pending_batch != NULL;
+  }
+
+  if (filter_config.max_batch_reports <= 1) {
+    dispatch_cb(packet);
+    return false;
+  }
+
+  append_report_locked(packet, subevent, report, length);
+  buffer_allocator->free(packet);
+  return pending_batch != NULL;
+}
+
+static void flush(void) {
+  std::lock_guard<std::mutex> lock(filter_mutex);
+  flush_locked();
+}
+
+static void get_stats(adv_report_filter_stats_t* stats) {
+  CHECK(stats != NULL);
+
+  std::lock_guard<std::mutex> lock(filter_mutex);
+  *stats = filter_stats;
+}
+
+static const adv_report_filter_t interface = {init, cleanup, process, flush,
+                                              get_stats};
+
+const adv_report_filter_t* adv_report_filter_get_interface() {
+  buffer_allocator = buffer_allocator_get_interface();
+  return &interface;
+}
+
+const adv_report_filter_t* adv_report_filter_get_test_interface(
+    const allocator_t* buffer_allocator_interface) {
+  buffer_allocator = buffer_allocator_interface;
+  return &interface;
+}
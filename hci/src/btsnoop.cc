@@ -18,6 +18,10 @@
 
 #define LOG_TAG "bt_snoop"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <mutex>
 
 #include <arpa/inet.h>
@@ -27,10 +31,13 @@
 #include <inttypes.h>
 #include <limits.h>
 #include <netinet/in.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/uio.h>
@@ -44,7 +51,9 @@
 #include "hci/include/btsnoop_mem.h"
 #include "hci_layer.h"
 #include "internal_include/bt_trace.h"
+#include "osi/include/allocator.h"
 #include "osi/include/log.h"
+#include "osi/include/osi.h"
 #include "osi/include/properties.h"
 #include "osi/include/time.h"
 #include "stack/include/hcimsgs.h"
@@ -86,6 +95,9 @@
   #define DEFAULT_BTSNOOP_PATH "btsnoop_hci.log"
 #endif  //OFF_TARGET_TEST_ENABLED
 #define BTSNOOP_MAX_PACKETS_PROPERTY "persist.bluetooth.btsnoopsize"
+// Size in KiB of the memory-mapped rolling snoop log. When set, packets are
+// appended to a fixed-size circular file instead of rotating snoop files.
+#define BTSNOOP_ROLLING_SIZE_PROPERTY "persist.vendor.bt.btsnoop_rolling_size"
 
 typedef enum {
   kCommandPacket = 1,
@@ -120,8 +132,10 @@ static std::mutex btsnoop_mutex;
 static std::mutex btSnoopFd_mutex;
 
 static int32_t packets_per_file;
-static int32_t packet_counter;
-static bool sock_snoop_active = false;
+// Both are also used by the writer thread, which can't take |btsnoop_mutex|:
+// shut_down() holds it while waiting for the writer to finish.
+static std::atomic<int32_t> packet_counter(0);
+static std::atomic<bool> sock_snoop_active(false);
 
 extern bt_logger_interface_t *logger_interface;
 int64_t gmt_offset;
@@ -140,6 +154,52 @@ static const char *cpbr_pattern = "\x0d\x0a+CPBR:";
 
 static uint8_t packet[DEFAULT_PACKET_SIZE];
 
+// Captured packets are copied into a ring and written out by a dedicated
+// writer thread, so the HCI thread never blocks on the snoop file or socket.
+// Each record is a btsnoop_header_t followed by the captured payload.
+// Producers are serialized by |btsnoop_mutex|; only the writer advances the
+// tail.
+#define SNOOP_RING_SIZE (256 * 1024)  // Must be a power of two.
+#define SNOOP_WRITER_FLUSH_MS 100
+#define SNOOP_WRITER_POLL_TIMEOUT_MS 100
+#define SNOOP_WRITER_MAX_BATCH (64 * 1024)
+
+static const char* SNOOP_WRITER_THREAD_NAME = "btsnoop_writer";
+
+static uint8_t* snoop_ring;
+static std::atomic<size_t> snoop_ring_head(0);
+static std::atomic<size_t> snoop_ring_tail(0);
+static std::atomic<uint32_t> snoop_dropped_packets(0);
+
+static pthread_t snoop_writer_thread;
+static bool snoop_writer_valid = false;
+static std::mutex snoop_writer_mutex;
+static std::condition_variable snoop_writer_cv;
+static bool snoop_writer_stop;  // guarded by |snoop_writer_mutex|
+
+// Layout of the rolling snoop log: this header followed by |data_size| bytes
+// of btsnoop records which wrap around at the end. The oldest complete
+// record starts at |tail| and |used| bytes of records follow it. All fields
+// are little endian; tools/scripts/btsnoop_rolling.py linearizes the file.
+#define SNOOP_ROLLING_MAGIC "btsnoopr"
+#define SNOOP_ROLLING_VERSION 1
+#define SNOOP_ROLLING_MIN_SIZE (1024 * 1024)
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;
+  uint64_t data_size;
+  uint64_t head;
+  uint64_t tail;
+  uint64_t used;
+} __attribute__((__packed__)) snoop_rolling_header_t;
+
+// The mapping is guarded by |snoop_rolling_mutex|.
+static std::mutex snoop_rolling_mutex;
+static snoop_rolling_header_t* snoop_rolling;
+static size_t snoop_rolling_map_size;
+
 // Channel tracking variables for filtering.
 
 // Keeps track of L2CAP channels that need to be filtered out of the snoop
@@ -369,9 +429,14 @@ static bool is_avdt_media_packet(const uint8_t *p, bool is_local_cid);
 static void delete_btsnoop_files(bool filtered);
 static std::string get_btsnoop_log_path(bool filtered);
 static std::string get_btsnoop_last_log_path(std::string log_path);
+static std::string get_btsnoop_rolling_log_path(std::string log_path);
 static void open_next_snoop_file();
+static bool snoop_rolling_open();
+static void snoop_rolling_close();
 static void btsnoop_write_packet(packet_type_t type, uint8_t* packet,
                                  bool is_received, uint64_t timestamp_us);
+static void snoop_writer_start();
+static void snoop_writer_stop_and_flush();
 
 // Module lifecycle functions
 
@@ -491,10 +556,11 @@ static future_t* start_up() {
   }
 
   if (is_btsnoop_enabled || is_vndbtsnoop_enabled) {
-    open_next_snoop_file();
+    if (!snoop_rolling_open()) open_next_snoop_file();
     packets_per_file = (//osi_property_get_int32(BTSNOOP_MAX_PACKETS_PROPERTY,
                                               DEFAULT_BTSNOOP_SIZE);
     btsnoop_net_open();
+    snoop_writer_start();
     START_SNOOP_LOGGING();
   }
   LOG_DEBUG(LOG_TAG, "%s: vendor_logging_level values is %d ", __func__, vendor_logging_level);
@@ -504,6 +570,15 @@ static future_t* start_up() {
 
 static future_t* shut_down(void) {
   std::lock_guard<std::mutex> lock(btsnoop_mutex);
+
+  // Write out whatever is still queued, and stop the writer from opening
+  // new files, before the files go away.
+  snoop_writer_stop_and_flush();
+  snoop_rolling_close();
+
+  if (logfile_fd != INVALID_FD) close(logfile_fd);
+  logfile_fd = INVALID_FD;
+
 #if (OFF_TARGET_TEST_ENABLED == FALSE)
   if (is_btsnoop_enabled) {
     if (is_btsnoop_filtered) {
@@ -517,9 +592,6 @@ static future_t* shut_down(void) {
   }
 #endif
 
-  if (logfile_fd != INVALID_FD) close(logfile_fd);
-  logfile_fd = INVALID_FD;
-
   if(is_vndbtsnoop_enabled) STOP_SNOOP_LOGGING();
   if (is_btsnoop_enabled) btsnoop_net_close();
 
@@ -576,7 +648,7 @@ static void capture(const BT_HDR* buffer, bool is_received) {
 
   btsnoop_mem_capture(buffer, timestamp_us);
 
-  if (logfile_fd == INVALID_FD) return;
+  if (logfile_fd == INVALID_FD && !snoop_rolling) return;
 
   switch (buffer->event & MSG_EVT_MASK) {
     case MSG_HC_TO_STACK_HCI_EVT:
@@ -901,6 +973,7 @@ static void delete_btsnoop_files(bool filtered) {
   auto log_path = get_btsnoop_log_path(filtered);
   remove(log_path.c_str());
   remove(get_btsnoop_last_log_path(log_path).c_str());
+  remove(get_btsnoop_rolling_log_path(log_path).c_str());
 }
 
 std::string get_btsnoop_log_path(bool filtered) {
@@ -916,6 +989,10 @@ std::string get_btsnoop_last_log_path(std::string btsnoop_path) {
   return btsnoop_path.append(".last");
 }
 
+std::string get_btsnoop_rolling_log_path(std::string btsnoop_path) {
+  return btsnoop_path.append(".rolling");
+}
+
 static void open_next_snoop_file() {
   packet_counter = 0;
 
@@ -1036,11 +1113,301 @@ static bool should_filter_log(bool is_received, uint8_t* packet) {
   return false;
 }
 
+static void snoop_ring_write(size_t position, const void* data, size_t length) {
+  size_t offset = position & (SNOOP_RING_SIZE - 1);
+  size_t first = std::min(length, (size_t)SNOOP_RING_SIZE - offset);
+  memcpy(snoop_ring + offset, data, first);
+  memcpy(snoop_ring, static_cast<const uint8_t*>(data) + first, length - first);
+}
+
+static void snoop_ring_read(size_t position, void* data, size_t length) {
+  size_t offset = position & (SNOOP_RING_SIZE - 1);
+  size_t first = std::min(length, (size_t)SNOOP_RING_SIZE - offset);
+  memcpy(data, snoop_ring + offset, first);
+  memcpy(static_cast<uint8_t*>(data) + first, snoop_ring, length - first);
+}
+
+static void snoop_writev_all(int fd, iovec* iov, int iovcnt) {
+  while (iovcnt > 0) {
+    ssize_t ret = TEMP_FAILURE_RETRY(writev(fd, iov, iovcnt));
+    if (ret < 0) {
+      LOG_ERROR(LOG_TAG, "%s writev failed errno %d (%s)", __func__, errno,
+                strerror(errno));
+      return;
+    }
+
+    size_t written = ret;
+    while (iovcnt > 0 && written >= iov->iov_len) {
+      written -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+    if (iovcnt > 0) {
+      iov->iov_base = static_cast<uint8_t*>(iov->iov_base) + written;
+      iov->iov_len -= written;
+    }
+  }
+}
+
+// Maps the rolling snoop log if it is configured. Returns false if regular
+// snoop files should be used instead.
+static bool snoop_rolling_open() {
+  int32_t size_kb = osi_property_get_int32(BTSNOOP_ROLLING_SIZE_PROPERTY, 0);
+  if (size_kb <= 0) return false;
+
+  size_t data_size = std::max((size_t)size_kb * 1024,
+                              (size_t)SNOOP_ROLLING_MIN_SIZE);
+  size_t map_size = sizeof(snoop_rolling_header_t) + data_size;
+  auto log_path =
+      get_btsnoop_rolling_log_path(get_btsnoop_log_path(is_btsnoop_filtered));
+
+  mode_t prevmask = umask(0);
+  int fd = open(log_path.c_str(), O_RDWR | O_CREAT | O_TRUNC,
+                S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
+  umask(prevmask);
+  if (fd == INVALID_FD) {
+    LOG(ERROR) << __func__ << ": unable to open '" << log_path
+               << "' : " << strerror(errno);
+    return false;
+  }
+
+  // Reserve the blocks up front so that capturing never grows the file.
+  if (posix_fallocate(fd, 0, map_size) != 0 && ftruncate(fd, map_size) != 0) {
+    LOG(ERROR) << __func__ << ": unable to size '" << log_path
+               << "' : " << strerror(errno);
+    close(fd);
+    return false;
+  }
+
+  void* map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    LOG(ERROR) << __func__ << ": unable to map '" << log_path
+               << "' : " << strerror(errno);
+    return false;
+  }
+
+  snoop_rolling_header_t* header = static_cast<snoop_rolling_header_t*>(map);
+  memcpy(header->magic, SNOOP_ROLLING_MAGIC, sizeof(header->magic));
+  header->version = SNOOP_ROLLING_VERSION;
+  header->header_size = sizeof(snoop_rolling_header_t);
+  header->data_size = data_size;
+  header->head = 0;
+  header->tail = 0;
+  header->used = 0;
+
+  std::lock_guard<std::mutex> lock(snoop_rolling_mutex);
+  snoop_rolling = header;
+  snoop_rolling_map_size = map_size;
+  LOG(INFO) << __func__ << ": rolling snoop log of " << data_size
+            << " bytes at '" << log_path << "'";
+  return true;
+}
+
+static void snoop_rolling_close() {
+  std::lock_guard<std::mutex> lock(snoop_rolling_mutex);
+  if (!snoop_rolling) return;
+
+  munmap(snoop_rolling, snoop_rolling_map_size);
+  snoop_rolling = NULL;
+  snoop_rolling_map_size = 0;
+}
+
+static uint8_t* snoop_rolling_data() {
+  return reinterpret_cast<uint8_t*>(snoop_rolling) +
+         sizeof(snoop_rolling_header_t);
+}
+
+// Appends the |length| bytes of whole records in |iov| to the rolling log,
+// retiring the oldest records to make room. Called with
+// |snoop_rolling_mutex| held.
+static void snoop_rolling_append(const iovec* iov, int iovcnt, size_t length) {
+  snoop_rolling_header_t* header = snoop_rolling;
+  uint8_t* data = snoop_rolling_data();
+  size_t data_size = header->data_size;
+  if (length > data_size) return;
+
+  while (header->used + length > data_size) {
+    btsnoop_header_t record;
+    uint8_t* out = reinterpret_cast<uint8_t*>(&record);
+    for (size_t i = 0; i < sizeof(record); i++)
+      out[i] = data[(header->tail + i) % data_size];
+    size_t record_length =
+        sizeof(btsnoop_header_t) + ntohl(record.length_captured) - 1;
+    header->tail = (header->tail + record_length) % data_size;
+    header->used -= record_length;
+  }
+
+  size_t head = header->head;
+  for (int i = 0; i < iovcnt; i++) {
+    const uint8_t* in = static_cast<const uint8_t*>(iov[i].iov_base);
+    size_t remaining = iov[i].iov_len;
+    while (remaining > 0) {
+      size_t chunk = std::min(remaining, data_size - head);
+      memcpy(data + head, in, chunk);
+      in += chunk;
+      remaining -= chunk;
+      head = (head + chunk) % data_size;
+    }
+  }
+
+  // Publish the new records only once they have been copied.
+  header->head = head;
+  header->used += length;
+}
+
+bool btsnoop_write_rolling_log(int fd) {
+  std::lock_guard<std::mutex> lock(snoop_rolling_mutex);
+  if (!snoop_rolling) return false;
+
+  const snoop_rolling_header_t* header = snoop_rolling;
+  const uint8_t* data = snoop_rolling_data();
+  size_t first = std::min((size_t)header->used,
+                          (size_t)(header->data_size - header->tail));
+  iovec iov[] = {
+      {const_cast<char*>("btsnoop\0\0\0\0\1\0\0\x3\xea"), 16},
+      {const_cast<uint8_t*>(data) + header->tail, first},
+      {const_cast<uint8_t*>(data), header->used - first}};
+  snoop_writev_all(fd, iov, 3);
+  return true;
+}
+
+// Writes the ring bytes in [start, end) with a single writev and releases
+// them to the producer.
+static void snoop_write_span(size_t start, size_t end) {
+  if (start == end) return;
+
+  size_t offset = start & (SNOOP_RING_SIZE - 1);
+  size_t length = end - start;
+  size_t first = std::min(length, (size_t)SNOOP_RING_SIZE - offset);
+  iovec iov[] = {{snoop_ring + offset, first}, {snoop_ring, length - first}};
+  int iovcnt = (first == length) ? 1 : 2;
+
+  for (int i = 0; i < iovcnt; i++)
+    btsnoop_net_write(iov[i].iov_base, iov[i].iov_len);
+
+  {
+    std::lock_guard<std::mutex> lock(snoop_rolling_mutex);
+    if (snoop_rolling) snoop_rolling_append(iov, iovcnt, length);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(btSnoopFd_mutex);
+    if (logfile_fd != INVALID_FD) {
+      struct pollfd fds;
+      fds.fd = logfile_fd;
+      fds.events = POLLOUT;
+
+      int status = poll(&fds, 1, SNOOP_WRITER_POLL_TIMEOUT_MS);
+      if (status > 0 && fds.revents & POLLOUT) {
+        snoop_writev_all(logfile_fd, iov, iovcnt);
+      } else if (status == 0) {
+        LOG_WARN(LOG_TAG, "%s poll() timeout", __func__);
+      } else if (status == -1) {
+        LOG_ERROR(LOG_TAG, "%s poll failed errno %d (%s)", __func__, errno,
+                  strerror(errno));
+      }
+    }
+  }
+
+  snoop_ring_tail.store(end, std::memory_order_release);
+}
+
+// Writes out every record queued in the ring, rotating the snoop file on
+// packet boundaries. Must only be called by the consumer of the ring.
+static void snoop_writer_drain() {
+  size_t start = snoop_ring_tail.load(std::memory_order_relaxed);
+  size_t end = start;
+  size_t head = snoop_ring_head.load(std::memory_order_acquire);
+
+  while (end != head) {
+    btsnoop_header_t header;
+    snoop_ring_read(end, &header, sizeof(btsnoop_header_t));
+
+    if (!sock_snoop_active && !snoop_rolling &&
+        packet_counter >= packets_per_file) {
+      snoop_write_span(start, end);
+      start = end;
+      open_next_snoop_file();
+    }
+    packet_counter++;
+
+    end += sizeof(btsnoop_header_t) + ntohl(header.length_captured) - 1;
+    if (end - start >= SNOOP_WRITER_MAX_BATCH) {
+      snoop_write_span(start, end);
+      start = end;
+    }
+  }
+
+  snoop_write_span(start, end);
+}
+
+static void* snoop_writer_fn(UNUSED_ATTR void* context) {
+  prctl(PR_SET_NAME, (unsigned long)SNOOP_WRITER_THREAD_NAME, 0, 0, 0);
+
+  std::unique_lock<std::mutex> lock(snoop_writer_mutex);
+  while (!snoop_writer_stop) {
+    snoop_writer_cv.wait_for(lock,
+                             std::chrono::milliseconds(SNOOP_WRITER_FLUSH_MS));
+    lock.unlock();
+    snoop_writer_drain();
+    lock.lock();
+  }
+  lock.unlock();
+
+  snoop_writer_drain();
+  return NULL;
+}
+
+// Called with |btsnoop_mutex| held.
+static void snoop_writer_start() {
+  if (!snoop_ring)
+    snoop_ring = static_cast<uint8_t*>(osi_malloc(SNOOP_RING_SIZE));
+  snoop_ring_head.store(0, std::memory_order_relaxed);
+  snoop_ring_tail.store(0, std::memory_order_relaxed);
+  snoop_dropped_packets.store(0, std::memory_order_relaxed);
+
+  {
+    std::lock_guard<std::mutex> lock(snoop_writer_mutex);
+    snoop_writer_stop = false;
+  }
+
+  // Without a writer thread, packets are written out as they are captured.
+  snoop_writer_valid = (pthread_create(&snoop_writer_thread, NULL,
+                                       snoop_writer_fn, NULL) == 0);
+  if (!snoop_writer_valid)
+    LOG_ERROR(LOG_TAG, "%s pthread_create failed: %s", __func__,
+              strerror(errno));
+}
+
+// Called with |btsnoop_mutex| held, so nothing is captured meanwhile.
+static void snoop_writer_stop_and_flush() {
+  if (!snoop_ring) return;
+
+  if (snoop_writer_valid) {
+    {
+      std::lock_guard<std::mutex> lock(snoop_writer_mutex);
+      snoop_writer_stop = true;
+    }
+    snoop_writer_cv.notify_one();
+    pthread_join(snoop_writer_thread, NULL);
+    snoop_writer_valid = false;
+  } else {
+    snoop_writer_drain();
+  }
+
+  uint32_t dropped = snoop_dropped_packets.load(std::memory_order_relaxed);
+  if (dropped)
+    LOG_WARN(LOG_TAG, "%s dropped %u snoop packets", __func__, dropped);
+
+  osi_free(snoop_ring);
+  snoop_ring = NULL;
+}
+
 static void btsnoop_write_packet(packet_type_t type, uint8_t* packet,
                                  bool is_received, uint64_t timestamp_us) {
   uint32_t length_he = 0;
   uint32_t flags = 0;
-  int status = 0;
 
   switch (type) {
     case kCommandPacket:
@@ -1076,34 +1443,36 @@ static void btsnoop_write_packet(packet_type_t type, uint8_t* packet,
       blacklisted ? htonl(L2C_HEADER_SIZE) : header.length_original;
   if (blacklisted) length_he = L2C_HEADER_SIZE;
   header.flags = htonl(flags);
-  header.dropped_packets = 0;
   header.timestamp = htonll(timestamp_us + BTSNOOP_EPOCH_DELTA);
   header.type = type;
 
-  btsnoop_net_write(&header, sizeof(btsnoop_header_t));
-  btsnoop_net_write(packet, length_he - 1);
+  if (!snoop_ring) return;
 
-  if (logfile_fd != INVALID_FD) {
-    packet_counter++;
-    if (!sock_snoop_active && packet_counter > packets_per_file) {
-      open_next_snoop_file();
-    }
+  // The type byte is the last byte of the header, so it is not part of the
+  // payload.
+  size_t payload_length = length_he - 1;
+  size_t record_length = sizeof(btsnoop_header_t) + payload_length;
+  size_t head = snoop_ring_head.load(std::memory_order_relaxed);
+  size_t used = head - snoop_ring_tail.load(std::memory_order_acquire);
+  if (SNOOP_RING_SIZE - used < record_length) {
+    snoop_dropped_packets.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
 
-    struct pollfd fds;
-    fds.fd = logfile_fd;
-    fds.events = POLLOUT;
-    iovec iov[] = {{&header, sizeof(btsnoop_header_t)},
-                   {reinterpret_cast<void*>(packet), length_he - 1}};
-
-    status = poll(&fds, 1, 0);
-    if(status > 0 && fds.revents & POLLOUT) {
-      TEMP_FAILURE_RETRY(writev(logfile_fd, iov, 2));
-    } else if (status == 0) {
-      LOG_WARN(LOG_TAG, "%s poll() timeout", __func__);
-    } else if (status == -1) {
-      LOG_ERROR(LOG_TAG, "%s poll failed errno %d (%s)",
-                    __func__, errno, strerror(errno));
-    }
+  // btsnoop expects the number of packets lost since the start of the log.
+  header.dropped_packets =
+      htonl(snoop_dropped_packets.load(std::memory_order_relaxed));
+  snoop_ring_write(head, &header, sizeof(btsnoop_header_t));
+  snoop_ring_write(head + sizeof(btsnoop_header_t), packet, payload_length);
+  snoop_ring_head.store(head + record_length, std::memory_order_release);
+
+  if (!snoop_writer_valid) {
+    snoop_writer_drain();
+  } else if (used < SNOOP_RING_SIZE / 2 &&
+             used + record_length >= SNOOP_RING_SIZE / 2) {
+    // Wake the writer early once half the ring is in use; otherwise it
+    // flushes in batches every SNOOP_WRITER_FLUSH_MS.
+    snoop_writer_cv.notify_one();
   }
 }
 
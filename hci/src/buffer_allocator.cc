@@ -18,8 +18,47 @@
 
 #include <base/logging.h>
 
+#include <mutex>
+
 #include "bt_common.h"
 #include "buffer_allocator.h"
+#include "osi/include/allocation_tracker.h"
+#include "osi/include/allocator_pool.h"
+#include "osi/include/properties.h"
+
+#define BUFFER_POOL_ENABLE_PROPERTY "persist.vendor.bt.buffer_pool.enable"
+
+// Buffers smaller than this are left to the system allocator.
+#define BUFFER_POOL_MIN_SIZE 256
+
+// HCI command and event sized buffers.
+#define BUFFER_POOL_SMALL_SIZE BT_SMALL_BUFFER_SIZE
+#define BUFFER_POOL_SMALL_COUNT 128
+
+// L2CAP MTU sized ACL buffers: header, L2CAP offset, MTU and FCS.
+#define BUFFER_POOL_MTU_SIZE (BT_HDR_SIZE + 16 + L2CAP_MTU_SIZE + 2)
+#define BUFFER_POOL_MTU_COUNT 128
+
+// Full sized stack buffers.
+#define BUFFER_POOL_DEFAULT_SIZE (BT_HDR_SIZE + BT_DEFAULT_BUFFER_SIZE)
+#define BUFFER_POOL_DEFAULT_COUNT 64
+
+static std::once_flag buffer_pool_init_flag;
+
+static void buffer_pool_init(void) {
+  if (!osi_property_get_bool(BUFFER_POOL_ENABLE_PROPERTY, false)) return;
+
+  const allocator_pool_class_t classes[] = {
+      {allocation_tracker_resize_for_canary(BUFFER_POOL_SMALL_SIZE),
+       BUFFER_POOL_SMALL_COUNT},
+      {allocation_tracker_resize_for_canary(BUFFER_POOL_MTU_SIZE),
+       BUFFER_POOL_MTU_COUNT},
+      {allocation_tracker_resize_for_canary(BUFFER_POOL_DEFAULT_SIZE),
+       BUFFER_POOL_DEFAULT_COUNT},
+  };
+  allocator_pool_init(classes, sizeof(classes) / sizeof(classes[0]),
+                      BUFFER_POOL_MIN_SIZE);
+}
 
 static void* buffer_alloc(size_t size) {
   CHECK(size <= BT_DEFAULT_BUFFER_SIZE);
@@ -28,4 +67,7 @@ static void* buffer_alloc(size_t size) {
 
 static const allocator_t interface = {buffer_alloc, osi_free};
 
-const allocator_t* buffer_allocator_get_interface() { return &interface; }
+const allocator_t* buffer_allocator_get_interface() {
+  std::call_once(buffer_pool_init_flag, buffer_pool_init);
+  return &interface;
+}
@@ -26,27 +26,34 @@
 #include <base/sequenced_task_runner.h>
 #include <base/threading/thread.h>
 
+#include <inttypes.h>
 #include <signal.h>
 #include <string.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include <chrono>
+#include <deque>
+#include <map>
 #include <mutex>
 
+#include "adv_report_filter.h"
 #include "btcore/include/module.h"
 #include "btsnoop.h"
 #include "buffer_allocator.h"
 #include "hci_inject.h"
 #include "hci_internals.h"
+#include "hci_replay.h"
 #include "hcidefs.h"
 #include "hcimsgs.h"
 #include "bt_utils.h"
 #include "osi/include/alarm.h"
 #include "osi/include/list.h"
 #include "osi/include/log.h"
+#include "osi/include/packet_trace.h"
 #include "osi/include/properties.h"
 #include "osi/include/reactor.h"
+#include "osi/include/time.h"
 #include "packet_fragmenter.h"
 #include "controller.h"
 
@@ -54,6 +61,9 @@
 
 extern void hci_initialize();
 extern hci_transmit_status_t hci_transmit(BT_HDR* packet);
+extern bool hci_supports_acl_fragments();
+extern hci_transmit_status_t hci_transmit_acl_fragments(
+    const acl_fragment_t* fragments, size_t count);
 extern void hci_close();
 extern int hci_open_firmware_log_file();
 extern void hci_close_firmware_log_file(int fd);
@@ -61,6 +71,16 @@ extern void hci_log_firmware_debug_packet(int fd, BT_HDR* packet);
 
 static int hci_firmware_log_fd = INVALID_FD;
 
+// Commands of a higher priority class are sent before queued commands of a
+// lower class when command scheduling is enabled. Order within a class is
+// always preserved.
+typedef enum {
+  COMMAND_PRIORITY_HIGH = 0,  // Connection, encryption and SCO setup.
+  COMMAND_PRIORITY_NORMAL,
+  COMMAND_PRIORITY_BULK,  // Vendor specific and scan configuration.
+  COMMAND_PRIORITY_COUNT,
+} command_priority_t;
+
 typedef struct {
   uint16_t opcode;
   future_t* complete_future;
@@ -69,8 +89,26 @@ typedef struct {
   void* context;
   BT_HDR* command;
   std::chrono::time_point<std::chrono::steady_clock> timestamp;
+  std::chrono::time_point<std::chrono::steady_clock> enqueue_timestamp;
+  command_priority_t priority;
 } waiting_command_t;
 
+// Latency histogram bucket |i| counts samples below 2^i ms; the last bucket
+// counts everything else.
+#define COMMAND_LATENCY_BUCKETS 12
+
+typedef struct {
+  uint32_t histogram[COMMAND_LATENCY_BUCKETS];
+  uint64_t total_us;
+  uint64_t max_us;
+} command_latency_t;
+
+typedef struct {
+  uint32_t count;
+  command_latency_t queue_wait;  // Enqueued until sent to the controller.
+  command_latency_t response;    // Sent until command complete or status.
+} command_stats_t;
+
 // Using a define here, because it can be stringified for the property lookup
 // Reducing startup timeout to less than 3sec to ensure that wakelock is aquired
 // during initialization
@@ -87,6 +125,21 @@ typedef struct {
 #define MAX_INC_CMD_TIMEOUT       3000
 #define INC_TIMEOUT_THRESHOLD     100
 
+#define HCI_COMMAND_SCHEDULING_PROPERTY "persist.vendor.bt.hci_cmd_scheduling"
+
+// LE advertising report filtering, all disabled by default. The window drops
+// exact duplicates, the delay is how long single reports may wait to be
+// merged into one event of at most the given number of reports.
+#define ADV_DUPLICATE_WINDOW_PROPERTY "persist.vendor.bt.adv_dedup_window_ms"
+#define ADV_COALESCE_DELAY_PROPERTY "persist.vendor.bt.adv_coalesce_ms"
+#define ADV_COALESCE_MAX_PROPERTY "persist.vendor.bt.adv_coalesce_max_reports"
+#define DEFAULT_ADV_COALESCE_MAX_REPORTS 8
+
+// A btsnoop capture to replay in place of the controller, and the replay
+// speed in percent of the recorded timing.
+#define HCI_REPLAY_FILE_PROPERTY "persist.vendor.bt.hci_replay.file"
+#define HCI_REPLAY_SPEED_PROPERTY "persist.vendor.bt.hci_replay.speed"
+
 // RT priority for HCI thread
 static const int BT_HCI_RT_PRIORITY = 1;
 
@@ -104,6 +157,9 @@ static bool enable_hcievent_debuglog = false;
 static const allocator_t* buffer_allocator;
 static const btsnoop_t* btsnoop;
 static const packet_fragmenter_t* packet_fragmenter;
+static const adv_report_filter_t* adv_report_filter;
+static const hci_replay_t* hci_replay;
+static bool hci_replay_active = false;
 
 static future_t* startup_future;
 static thread_t* thread;  // We own this
@@ -117,10 +173,19 @@ static alarm_t *hci_timeout_abort_timer;
 // Outbound-related
 static int command_credits = 1;
 static std::mutex command_credits_mutex;
-static std::queue<base::Closure> command_queue;
+// The queues and high water marks are guarded by |command_credits_mutex|.
+static std::deque<waiting_command_t*> command_queues[COMMAND_PRIORITY_COUNT];
+static size_t command_queue_high_water[COMMAND_PRIORITY_COUNT];
+static bool command_scheduling_enabled = false;
+
+static std::mutex command_stats_mutex;
+static std::map<uint16_t, command_stats_t> command_stats;
 
 // Inbound-related
 static alarm_t* command_response_timer;
+static bool adv_report_filter_enabled = false;
+static period_ms_t adv_coalesce_delay_ms;
+static alarm_t* adv_coalesce_timer;
 static list_t* commands_pending_response;
 static std::recursive_mutex commands_pending_response_mutex;
 
@@ -144,6 +209,8 @@ static waiting_command_t* get_waiting_command(command_opcode_t opcode);
 static int get_num_waiting_commands();
 
 static void event_finish_startup(void* context);
+static void adv_coalesce_timer_expired(void* context);
+static void dispatch_filtered_event(BT_HDR* packet);
 static void startup_timer_expired(void* context);
 
 static void enqueue_command(waiting_command_t* wait_entry);
@@ -155,6 +222,8 @@ static void command_timed_out(void* context);
 static void update_command_response_timer(void);
 
 static void transmit_fragment(BT_HDR* packet, bool send_transmit_finished);
+static void transmit_fragments(BT_HDR* packet, const acl_fragment_t* fragments,
+                               size_t count, bool send_transmit_finished);
 static void dispatch_reassembled(BT_HDR* packet);
 static void fragmenter_transmit_finished(BT_HDR* packet,
                                          bool all_fragments_sent);
@@ -169,7 +238,14 @@ void inc_rx_packet_counter() {
 }
 
 static const packet_fragmenter_callbacks_t packet_fragmenter_callbacks = {
-    transmit_fragment, dispatch_reassembled, fragmenter_transmit_finished};
+    transmit_fragment, dispatch_reassembled, fragmenter_transmit_finished,
+    NULL};
+
+// Used when the HAL can write a fragment header and its payload slice
+// without assembling them in one buffer first.
+static const packet_fragmenter_callbacks_t packet_fragmenter_batch_callbacks = {
+    transmit_fragment, dispatch_reassembled, fragmenter_transmit_finished,
+    transmit_fragments};
 
 void initialization_complete() {
   std::lock_guard<std::mutex> lock(message_loop_mutex);
@@ -187,7 +263,15 @@ void hci_event_received(const base::Location& from_here,
   btsnoop->capture(packet, true);
 
   if (!filter_incoming_event(packet)) {
-    send_data_upwards.Run(from_here, packet);
+    if (adv_report_filter_enabled) {
+      if (adv_report_filter->process(packet, time_get_os_boottime_ms()) &&
+          !alarm_is_scheduled(adv_coalesce_timer)) {
+        alarm_set(adv_coalesce_timer, adv_coalesce_delay_ms,
+                  adv_coalesce_timer_expired, NULL);
+      }
+    } else {
+      send_data_upwards.Run(from_here, packet);
+    }
   }
   if (enable_hcievent_debuglog == true) {
     LOG_DEBUG(LOG_TAG,"hci event end");
@@ -200,6 +284,7 @@ void acl_event_received(BT_HDR* packet) {
      LOG_DEBUG(LOG_TAG,"acl event start");
   }
   inc_rx_packet_counter();
+  packet_trace_mark(packet, PACKET_TRACE_RX_HCI_RECEIVED);
   btsnoop->capture(packet, true);
   packet_fragmenter->reassemble_and_dispatch(packet);
   if (enable_hcievent_debuglog == true) {
@@ -212,6 +297,58 @@ void sco_data_received(BT_HDR* packet) {
   packet_fragmenter->reassemble_and_dispatch(packet);
 }
 
+// Hands the packets of the capture up as the HAL would.
+static void hci_replay_deliver(serial_data_type_t type, BT_HDR* packet) {
+  switch (type) {
+    case DATA_TYPE_ACL:
+      acl_event_received(packet);
+      break;
+    case DATA_TYPE_SCO:
+      sco_data_received(packet);
+      break;
+    default:
+      hci_event_received(FROM_HERE, packet);
+      break;
+  }
+}
+
+static void hci_replay_initialize(void) {
+  hci_replay_config_t config;
+  config.speed_percent = osi_property_get_int32(HCI_REPLAY_SPEED_PROPERTY, 100);
+  config.outbound_timeout_ms = 0;
+  if (!hci_replay->start(&config, hci_replay_deliver)) {
+    LOG_ERROR(LOG_TAG, "%s unable to start the replay", __func__);
+    return;
+  }
+  initialization_complete();
+}
+
+static hci_transmit_status_t hci_replay_transmit(BT_HDR* packet) {
+  serial_data_type_t type = DATA_TYPE_COMMAND;
+  switch (packet->event & MSG_EVT_MASK) {
+    case MSG_STACK_TO_HC_HCI_ACL:
+      type = DATA_TYPE_ACL;
+      break;
+    case MSG_STACK_TO_HC_HCI_SCO:
+      type = DATA_TYPE_SCO;
+      break;
+  }
+  hci_replay->transmit(type, packet->data + packet->offset, packet->len);
+  return HCI_TRANSMIT_SUCCESS;
+}
+
+// Replays the capture named by HCI_REPLAY_FILE_PROPERTY, if any, instead of
+// opening the HAL.
+static void hci_replay_start_up(void) {
+  char path[PROPERTY_VALUE_MAX] = "";
+  osi_property_get(HCI_REPLAY_FILE_PROPERTY, path, "");
+  hci_replay_active = path[0] != '\0' && hci_replay->load(path);
+  if (hci_replay_active) {
+    LOG_WARN(LOG_TAG, "%s replaying %s instead of the controller", __func__,
+             path);
+  }
+}
+
 // Module lifecycle functions
 
 static future_t* hci_module_shut_down();
@@ -223,8 +360,9 @@ void message_loop_run(UNUSED_ATTR void* context) {
     run_loop_ = new base::RunLoop();
   }
 
-  message_loop_->task_runner()->PostTask(FROM_HERE,
-                                         base::Bind(&hci_initialize));
+  message_loop_->task_runner()->PostTask(
+      FROM_HERE,
+      base::Bind(hci_replay_active ? &hci_replay_initialize : &hci_initialize));
   run_loop_->Run();
 
   {
@@ -236,6 +374,55 @@ void message_loop_run(UNUSED_ATTR void* context) {
   }
 }
 
+static bool adv_report_filter_start_up(void) {
+  adv_report_filter_config_t config;
+  config.duplicate_window_ms =
+      osi_property_get_int32(ADV_DUPLICATE_WINDOW_PROPERTY, 0);
+  adv_coalesce_delay_ms = osi_property_get_int32(ADV_COALESCE_DELAY_PROPERTY, 0);
+  config.max_batch_reports = 1;
+  if (adv_coalesce_delay_ms > 0) {
+    config.max_batch_reports = osi_property_get_int32(
+        ADV_COALESCE_MAX_PROPERTY, DEFAULT_ADV_COALESCE_MAX_REPORTS);
+  }
+
+  adv_report_filter_enabled =
+      config.duplicate_window_ms > 0 || config.max_batch_reports > 1;
+  if (!adv_report_filter_enabled) return true;
+
+  adv_coalesce_timer = alarm_new("hci.adv_coalesce_timer");
+  if (!adv_coalesce_timer) {
+    LOG_ERROR(LOG_TAG, "%s unable to create advertising report timer.",
+              __func__);
+    adv_report_filter_enabled = false;
+    return false;
+  }
+
+  adv_report_filter->init(&config, dispatch_filtered_event);
+  LOG_INFO(LOG_TAG,
+           "%s advertising report filter: duplicate window %u ms, up to %zu "
+           "reports per event within %u ms",
+           __func__, (unsigned)config.duplicate_window_ms,
+           config.max_batch_reports, (unsigned)adv_coalesce_delay_ms);
+  return true;
+}
+
+static void adv_report_filter_shut_down(void) {
+  if (!adv_report_filter_enabled) return;
+
+  adv_report_filter_enabled = false;
+  alarm_free(adv_coalesce_timer);
+  adv_coalesce_timer = NULL;
+  adv_report_filter->cleanup();
+}
+
+static void adv_coalesce_timer_expired(UNUSED_ATTR void* context) {
+  adv_report_filter->flush();
+}
+
+static void dispatch_filtered_event(BT_HDR* packet) {
+  send_data_upwards.Run(FROM_HERE, packet);
+}
+
 static future_t* hci_module_start_up(void) {
   LOG_INFO(LOG_TAG, "%s", __func__);
 
@@ -244,6 +431,12 @@ static future_t* hci_module_start_up(void) {
   // This value can change when you get a command complete or command status
   // event.
   command_credits = 1;
+  command_scheduling_enabled =
+      osi_property_get_bool(HCI_COMMAND_SCHEDULING_PROPERTY, false);
+  {
+    std::lock_guard<std::mutex> lock(command_stats_mutex);
+    command_stats.clear();
+  }
 
   // For now, always use the default timeout on non-Android builds.
   period_ms_t startup_timeout_ms = DEFAULT_STARTUP_TIMEOUT_MS;
@@ -283,6 +476,8 @@ static future_t* hci_module_start_up(void) {
     goto error;
   }
 
+  if (!adv_report_filter_start_up()) goto error;
+
   thread = thread_new("hci_thread");
   if (!thread) {
     LOG_ERROR(LOG_TAG, "%s unable to create thread.", __func__);
@@ -306,7 +501,10 @@ static future_t* hci_module_start_up(void) {
   startup_future = local_startup_future;
   alarm_set(startup_timer, startup_timeout_ms, startup_timer_expired, NULL);
 
-  packet_fragmenter->init(&packet_fragmenter_callbacks);
+  hci_replay_start_up();
+  packet_fragmenter->init(!hci_replay_active && hci_supports_acl_fragments()
+                              ? &packet_fragmenter_batch_callbacks
+                              : &packet_fragmenter_callbacks);
 
   thread_post(thread, message_loop_run, NULL);
 
@@ -322,7 +520,12 @@ static future_t* hci_module_shut_down() {
   LOG_INFO(LOG_TAG, "%s", __func__);
 
   // Close HCI to prevent callbacks.
-  hci_close();
+  if (hci_replay_active) {
+    hci_replay->stop();
+    hci_replay_active = false;
+  } else {
+    hci_close();
+  }
 
   // Free the timers
   {
@@ -351,7 +554,20 @@ static future_t* hci_module_shut_down() {
     commands_pending_response = NULL;
   }
 
+  // Commands still waiting for credits will never be sent.
+  {
+    std::lock_guard<std::mutex> lock(command_credits_mutex);
+    for (auto& queue : command_queues) {
+      for (waiting_command_t* wait_entry : queue) {
+        buffer_allocator->free(wait_entry->command);
+        osi_free(wait_entry);
+      }
+      queue.clear();
+    }
+  }
+
   packet_fragmenter->cleanup();
+  adv_report_filter_shut_down();
 
   thread_free(thread);
   thread = NULL;
@@ -467,12 +683,92 @@ static void startup_timer_expired(UNUSED_ATTR void* context) {
   }
 }
 
+// Command scheduling and statistics functions
+static command_priority_t command_priority(uint16_t opcode) {
+  switch (opcode) {
+    case HCI_CREATE_CONNECTION:
+    case HCI_ACCEPT_CONNECTION_REQUEST:
+    case HCI_LINK_KEY_REQUEST_REPLY:
+    case HCI_SET_CONN_ENCRYPTION:
+    case HCI_SETUP_ESCO_CONNECTION:
+    case HCI_ACCEPT_ESCO_CONNECTION:
+    case HCI_ENH_SETUP_ESCO_CONNECTION:
+    case HCI_ENH_ACCEPT_ESCO_CONNECTION:
+    case HCI_BLE_CREATE_LL_CONN:
+    case HCI_LE_EXTENDED_CREATE_CONNECTION:
+    case HCI_BLE_START_ENC:
+    case HCI_BLE_LTK_REQ_REPLY:
+      return COMMAND_PRIORITY_HIGH;
+
+    case HCI_WRITE_PAGESCAN_CFG:
+    case HCI_WRITE_INQUIRYSCAN_CFG:
+    case HCI_BLE_WRITE_SCAN_PARAMS:
+    case HCI_BLE_WRITE_SCAN_ENABLE:
+    case HCI_LE_SET_EXTENDED_SCAN_PARAMETERS:
+    case HCI_LE_SET_EXTENDED_SCAN_ENABLE:
+      return COMMAND_PRIORITY_BULK;
+  }
+
+  if ((opcode & HCI_GRP_VENDOR_SPECIFIC) == HCI_GRP_VENDOR_SPECIFIC)
+    return COMMAND_PRIORITY_BULK;
+  return COMMAND_PRIORITY_NORMAL;
+}
+
+static void command_latency_add(command_latency_t* latency,
+                                std::chrono::steady_clock::duration elapsed) {
+  uint64_t elapsed_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+  size_t bucket = 0;
+  while (bucket < COMMAND_LATENCY_BUCKETS - 1 &&
+         elapsed_us >= (1000ULL << bucket))
+    bucket++;
+
+  latency->histogram[bucket]++;
+  latency->total_us += elapsed_us;
+  if (elapsed_us > latency->max_us) latency->max_us = elapsed_us;
+}
+
+// Records the response time of |wait_entry|, which just got its command
+// complete or command status event.
+static void command_stats_record(const waiting_command_t* wait_entry) {
+  auto now = std::chrono::steady_clock::now();
+
+  std::lock_guard<std::mutex> lock(command_stats_mutex);
+  command_stats_t& stats = command_stats[wait_entry->opcode];
+  stats.count++;
+  command_latency_add(&stats.queue_wait,
+                      wait_entry->timestamp - wait_entry->enqueue_timestamp);
+  command_latency_add(&stats.response, now - wait_entry->timestamp);
+}
+
+// Returns the next queued command to send, or NULL if there is none. Called
+// with |command_credits_mutex| held.
+static waiting_command_t* command_queue_pop() {
+  for (auto& queue : command_queues) {
+    if (queue.empty()) continue;
+    waiting_command_t* wait_entry = queue.front();
+    queue.pop_front();
+    return wait_entry;
+  }
+  return NULL;
+}
+
+static bool command_queues_empty() {
+  for (const auto& queue : command_queues) {
+    if (!queue.empty()) return false;
+  }
+  return true;
+}
+
 // Command/packet transmitting functions
 static void enqueue_command(waiting_command_t* wait_entry) {
-  base::Closure callback = base::Bind(&event_command_ready, wait_entry);
+  wait_entry->enqueue_timestamp = std::chrono::steady_clock::now();
+  wait_entry->priority = command_scheduling_enabled
+                             ? command_priority(wait_entry->opcode)
+                             : COMMAND_PRIORITY_NORMAL;
 
   std::lock_guard<std::mutex> command_credits_lock(command_credits_mutex);
-  if (command_credits > 0) {
+  if (command_credits > 0 && command_queues_empty()) {
     std::lock_guard<std::mutex> message_loop_lock(message_loop_mutex);
     if (message_loop_ == nullptr) {
       // HCI Layer was shut down
@@ -480,10 +776,14 @@ static void enqueue_command(waiting_command_t* wait_entry) {
       osi_free(wait_entry);
       return;
     }
-    message_loop_->task_runner()->PostTask(FROM_HERE, std::move(callback));
+    message_loop_->task_runner()->PostTask(
+        FROM_HERE, base::Bind(&event_command_ready, wait_entry));
     command_credits--;
   } else {
-    command_queue.push(std::move(callback));
+    auto& queue = command_queues[wait_entry->priority];
+    queue.push_back(wait_entry);
+    if (queue.size() > command_queue_high_water[wait_entry->priority])
+      command_queue_high_water[wait_entry->priority] = queue.size();
   }
 }
 
@@ -517,6 +817,15 @@ static void event_packet_ready(void* pkt) {
   packet_fragmenter->fragment_and_dispatch(packet);
 }
 
+static void check_transmit_status(hci_transmit_status_t status) {
+  if(status == HCI_TRANSMIT_DAEMON_DIED) {
+    LOG_ERROR(LOG_TAG, "%s: unable to send packet to hci hal daemon ", __func__);
+    usleep(100000);
+    LOG_ERROR(LOG_TAG, "%s: Killing bluetooth process due to TX failed ", __func__);
+    kill(getpid(), SIGKILL);
+  }
+}
+
 // Callback for the fragmenter to send a fragment
 static void transmit_fragment(BT_HDR* packet, bool send_transmit_finished) {
   btsnoop->capture(packet, false);
@@ -527,19 +836,44 @@ static void transmit_fragment(BT_HDR* packet, bool send_transmit_finished) {
    * process the event and frees the packet*/
   uint16_t event = packet->event & MSG_EVT_MASK;
 
-  hci_transmit_status_t status = hci_transmit(packet);
+  hci_transmit_status_t status =
+      hci_replay_active ? hci_replay_transmit(packet) : hci_transmit(packet);
+  check_transmit_status(status);
 
-  if(status == HCI_TRANSMIT_DAEMON_DIED) {
-    LOG_ERROR(LOG_TAG, "%s: unable to send packet to hci hal daemon ", __func__);
-    usleep(100000);
-    LOG_ERROR(LOG_TAG, "%s: Killing bluetooth process due to TX failed ", __func__);
-    kill(getpid(), SIGKILL);
-  }
+  if (event == MSG_STACK_TO_HC_HCI_ACL && send_transmit_finished)
+    packet_trace_mark(packet, PACKET_TRACE_TX_HCI_SENT);
 
   if (event != MSG_STACK_TO_HC_HCI_CMD && send_transmit_finished)
     buffer_allocator->free(packet);
 }
 
+// Callback for the fragmenter to send a batch of ACL fragments
+static void transmit_fragments(BT_HDR* packet, const acl_fragment_t* fragments,
+                               size_t count, bool send_transmit_finished) {
+  hci_transmit_status_t status = hci_transmit_acl_fragments(fragments, count);
+  check_transmit_status(status);
+
+  // The fragments are on the wire now, so the bytes in front of each payload
+  // can be overwritten to give btsnoop a contiguous copy of every fragment.
+  uint16_t offset = packet->offset;
+  uint16_t len = packet->len;
+  for (size_t i = 0; i < count; i++) {
+    uint8_t* start =
+        const_cast<uint8_t*>(fragments[i].payload) - HCI_ACL_PREAMBLE_SIZE;
+    memcpy(start, fragments[i].header, HCI_ACL_PREAMBLE_SIZE);
+    packet->offset = start - packet->data;
+    packet->len = fragments[i].payload_length + HCI_ACL_PREAMBLE_SIZE;
+    btsnoop->capture(packet, false);
+  }
+  packet->offset = offset;
+  packet->len = len;
+
+  if (send_transmit_finished) {
+    packet_trace_mark(packet, PACKET_TRACE_TX_HCI_SENT);
+    buffer_allocator->free(packet);
+  }
+}
+
 static void fragmenter_transmit_finished(BT_HDR* packet,
                                          bool all_fragments_sent) {
   if (all_fragments_sent) {
@@ -682,10 +1016,11 @@ void process_command_credits(int credits) {
   // Subtract commands in flight.
   command_credits = credits - get_num_waiting_commands();
 
-  while (command_credits > 0 && command_queue.size() > 0) {
-    message_loop_->task_runner()->PostTask(FROM_HERE,
-                                           std::move(command_queue.front()));
-    command_queue.pop();
+  while (command_credits > 0) {
+    waiting_command_t* wait_entry = command_queue_pop();
+    if (wait_entry == NULL) break;
+    message_loop_->task_runner()->PostTask(
+        FROM_HERE, base::Bind(&event_command_ready, wait_entry));
     command_credits--;
   }
 }
@@ -718,6 +1053,7 @@ static bool filter_incoming_event(BT_HDR* packet) {
                  __func__, opcode);
       }
     } else {
+      command_stats_record(wait_entry);
       update_command_response_timer();
       if (wait_entry->complete_callback) {
         wait_entry->complete_callback(packet, wait_entry->context);
@@ -750,6 +1086,7 @@ static bool filter_incoming_event(BT_HDR* packet) {
           "%s command status event with no matching command. opcode: 0x%04x",
           __func__, opcode);
     } else {
+      command_stats_record(wait_entry);
       update_command_response_timer();
       if (wait_entry->status_callback)
         wait_entry->status_callback(status, wait_entry->command,
@@ -905,6 +1242,8 @@ const hci_t* hci_layer_get_interface() {
   buffer_allocator = buffer_allocator_get_interface();
   btsnoop = btsnoop_get_interface();
   packet_fragmenter = packet_fragmenter_get_interface();
+  adv_report_filter = adv_report_filter_get_interface();
+  hci_replay = hci_replay_get_interface();
 
   init_layer_interface();
 
@@ -918,7 +1257,70 @@ const hci_t* hci_layer_get_test_interface(
   buffer_allocator = buffer_allocator_interface;
   btsnoop = btsnoop_interface;
   packet_fragmenter = packet_fragmenter_interface;
+  adv_report_filter = adv_report_filter_get_test_interface(buffer_allocator);
+  hci_replay = hci_replay_get_test_interface(buffer_allocator);
 
   init_layer_interface();
   return &interface;
 }
+
+static void command_latency_dump(int fd, const char* name,
+                                 const command_latency_t* latency,
+                                 uint32_t count) {
+  dprintf(fd, "      %-8s avg/max us : %" PRIu64 " / %" PRIu64 "  ms:", name,
+          count ? latency->total_us / count : 0, latency->max_us);
+  for (size_t i = 0; i < COMMAND_LATENCY_BUCKETS; i++) {
+    if (latency->histogram[i] == 0) continue;
+    if (i == COMMAND_LATENCY_BUCKETS - 1)
+      dprintf(fd, " >=%u:%u", 1u << (i - 1), latency->histogram[i]);
+    else
+      dprintf(fd, " <%u:%u", 1u << i, latency->histogram[i]);
+  }
+  dprintf(fd, "\n");
+}
+
+void hci_layer_debug_dump(int fd) {
+  static const char* priority_names[COMMAND_PRIORITY_COUNT] = {"high", "normal",
+                                                               "bulk"};
+
+  dprintf(fd, "\nHCI Command Queue:\n");
+  {
+    std::lock_guard<std::mutex> lock(command_credits_mutex);
+    dprintf(fd, "  Scheduling: %s  Credits: %d  Pending response: %d\n",
+            command_scheduling_enabled ? "enabled" : "disabled",
+            command_credits, get_num_waiting_commands());
+    for (size_t i = 0; i < COMMAND_PRIORITY_COUNT; i++) {
+      dprintf(fd, "  Queue %-6s queued/high water : %zu / %zu\n",
+              priority_names[i], command_queues[i].size(),
+              command_queue_high_water[i]);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(command_stats_mutex);
+    dprintf(fd, "  Command latency:\n");
+    for (const auto& entry : command_stats) {
+      const command_stats_t& stats = entry.second;
+      dprintf(fd, "    Opcode 0x%04x (%s) count: %u\n", entry.first,
+              priority_names[command_priority(entry.first)], stats.count);
+      command_latency_dump(fd, "queue", &stats.queue_wait, stats.count);
+      command_latency_dump(fd, "response", &stats.response, stats.count);
+    }
+  }
+
+  if (adv_report_filter_enabled) {
+    adv_report_filter_stats_t stats;
+    adv_report_filter->get_stats(&stats);
+    dprintf(fd, "\nLE Advertising Report Filter:\n");
+    dprintf(fd,
+            "  Reports received: %" PRIu64 "  duplicates dropped: %" PRIu64
+            "\n",
+            stats.reports_received, stats.duplicates_dropped);
+    dprintf(fd,
+            "  Reports coalesced: %" PRIu64 "  batches dispatched: %" PRIu64
+            "\n",
+            stats.reports_coalesced, stats.batches_dispatched);
+  }
+
+  if (hci_replay_active) hci_replay->debug_dump(fd);
+}
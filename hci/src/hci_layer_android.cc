@@ -28,6 +28,8 @@
 #include <base/logging.h>
 #include "buffer_allocator.h"
 #include "osi/include/log.h"
+#include "osi/include/osi.h"
+#include "packet_fragmenter.h"
 #include <cutils/properties.h>
 
 #include <android/hardware/bluetooth/1.0/IBluetoothHci.h>
@@ -233,6 +235,16 @@ hci_transmit_status_t hci_transmit(BT_HDR* packet) {
   return status;
 }
 
+// HIDL takes each ACL packet as one contiguous vector, so fragments are
+// always built in place and sent with |hci_transmit|.
+bool hci_supports_acl_fragments() { return false; }
+
+hci_transmit_status_t hci_transmit_acl_fragments(
+    UNUSED_ATTR const acl_fragment_t* fragments, UNUSED_ATTR size_t count) {
+  LOG_ERROR(LOG_TAG, "%s: fragment batches are not supported", __func__);
+  return HCI_TRANSMIT_INVALID_PKT;
+}
+
 int hci_open_firmware_log_file() {
   if (rename(LOG_PATH, LAST_LOG_PATH) == -1 && errno != ENOENT) {
     LOG_ERROR(LOG_TAG, "%s unable to rename '%s' to '%s': %s", __func__,
@@ -29,18 +29,22 @@
 #include <stdlib.h>
 #include <string.h>
 #include <algorithm>
+#include <vector>
 
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 
 #include "buffer_allocator.h"
 #include "hci_internals.h"
 #include "hci_layer.h"
+#include "osi/include/allocator.h"
 #include "osi/include/compat.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/properties.h"
+#include "packet_fragmenter.h"
 
 using base::Thread;
 
@@ -127,7 +131,7 @@ void monitor_socket_packet(int ctrl_fd, int fd) {
 
     uint8_t type = buf[0];
 
-    size_t packet_size = buf_size + BT_HDR_SIZE;
+    size_t packet_size = len - 1 + BT_HDR_SIZE;
     BT_HDR* packet =
         reinterpret_cast<BT_HDR*>(buffer_allocator->alloc(packet_size));
     packet->offset = 0;
@@ -173,95 +177,94 @@ void monitor_socket_packet(int ctrl_fd, int fd) {
   }
 }
 
-static int do_read(int fd, unsigned char* buf, size_t len)
-{
-  int bytes_left = len, bytes_read = 0, read_offset = 0;
-  while(bytes_left > 0) {
-    bytes_read = read(fd, buf + read_offset, bytes_left);
-    if(bytes_read < 0) {
-       LOG(ERROR) << "read fail Error " << strerror(errno);
-      return -1;
-    } else if (bytes_read == 0) {
-      LOG(INFO) << " read returned 0, read bytes"  << (len-bytes_left) << " expected len" << len;
-      return (len - bytes_left);
-    } else {
-      if(bytes_read < bytes_left) {
-        bytes_left -= bytes_read;
-        read_offset += bytes_read;
-      } else {
-        break;
-      }
-    }
+// Returns the size of the header that follows the H4 |type| byte, or 0 if
+// |type| is not a known packet type.
+static size_t h4_header_size(uint8_t type) {
+  switch (type) {
+    case HCI_PACKET_TYPE_COMMAND:
+      return BT_CMD_HDR_SIZE;
+    case HCI_PACKET_TYPE_ACL_DATA:
+      return BT_ACL_HDR_SIZE;
+    case HCI_PACKET_TYPE_SCO_DATA:
+      return BT_SCO_HDR_SIZE;
+    case HCI_PACKET_TYPE_EVENT:
+      return BT_EVT_HDR_SIZE;
+    default:
+      return 0;
   }
+}
 
-  return len;
+static size_t h4_payload_length(uint8_t type, const uint8_t* header) {
+  switch (type) {
+    case HCI_PACKET_TYPE_ACL_DATA:
+      return header[2] | (header[3] << 8);
+    case HCI_PACKET_TYPE_EVENT:
+      return header[1];
+    default:
+      return header[2];
+  }
 }
 
-void monitor_socket_stream(int ctrl_fd, int fd) {
-  const allocator_t* buffer_allocator = buffer_allocator_get_interface();
-  const size_t buf_size = 2000;
-  uint8_t buf[buf_size];
-  unsigned int packet_length;
-  ssize_t len = read(fd, buf, 1);
+// Copies the |length| bytes of an H4 packet of |type| from the receive
+// buffer into a buffer of exactly that size and hands it upward. An ACL
+// packet can be larger than the buffer allocator allows, so the buffer comes
+// from osi_malloc, which the allocator uses as well.
+static void h4_dispatch(uint8_t type, const uint8_t* data, size_t length) {
+  BT_HDR* packet = reinterpret_cast<BT_HDR*>(osi_malloc(BT_HDR_SIZE + length));
+  packet->offset = 0;
+  packet->layer_specific = 0;
+  packet->len = length;
+  memcpy(packet->data, data, length);
+
+  switch (type) {
+    case HCI_PACKET_TYPE_COMMAND:
+    case HCI_PACKET_TYPE_EVENT:
+      packet->event = MSG_HC_TO_STACK_HCI_EVT;
+      hci_event_received(FROM_HERE, packet);
+      break;
+    case HCI_PACKET_TYPE_ACL_DATA:
+      packet->event = MSG_HC_TO_STACK_HCI_ACL;
+      acl_event_received(packet);
+      break;
+    case HCI_PACKET_TYPE_SCO_DATA:
+      packet->event = MSG_HC_TO_STACK_HCI_SCO;
+      sco_data_received(packet);
+      break;
+  }
+}
 
-  while (len > 0) {
-    if (len == buf_size)
-      LOG(FATAL) << "This packet filled buffer, if it have continuation we "
-                    "don't know how to merge it, increase buffer size!";
+// Dispatches every complete H4 packet in the |length| bytes at |data| and
+// returns the number of bytes consumed. A trailing partial packet is left
+// for the next read.
+static size_t h4_parse(const uint8_t* data, size_t length) {
+  size_t consumed = 0;
+  while (consumed < length) {
+    uint8_t type = data[consumed];
+    size_t header_size = h4_header_size(type);
+    if (header_size == 0) LOG(FATAL) << "Unexpected event type: " << +type;
+
+    size_t available = length - consumed - 1;
+    if (available < header_size) break;
+    const uint8_t* packet = data + consumed + 1;
+    size_t packet_length = header_size + h4_payload_length(type, packet);
+    if (available < packet_length) break;
+
+    h4_dispatch(type, packet, packet_length);
+    consumed += 1 + packet_length;
+  }
+  return consumed;
+}
 
-    uint8_t type = buf[0];
+// Large enough for the biggest H4 packet: an ACL packet with a 16 bit length.
+#define H4_RX_BUFFER_SIZE (1 + BT_ACL_HDR_SIZE + 0xFFFF)
 
-    size_t packet_size = buf_size + BT_HDR_SIZE;
-    BT_HDR* packet =
-        reinterpret_cast<BT_HDR*>(buffer_allocator->alloc(packet_size));
-    packet->offset = 0;
-    packet->layer_specific = 0;
-    LOG(INFO) << "packet type:" << +type;
-    switch (type) {
-      case HCI_PACKET_TYPE_COMMAND:
-        len = do_read(fd,buf+1,BT_CMD_HDR_SIZE);
-        packet->event = MSG_HC_TO_STACK_HCI_EVT;
-        packet_length = buf[3];
-        packet->len = packet_length + BT_CMD_HDR_SIZE;
-        len = do_read(fd,buf+1,packet->len);
-        memcpy(packet->data, buf+1, packet->len);
-        hci_event_received(FROM_HERE, packet);
-        break;
-      case HCI_PACKET_TYPE_ACL_DATA:
-        len = do_read(fd,buf+1,BT_ACL_HDR_SIZE);
-        packet->event = MSG_HC_TO_STACK_HCI_ACL;
-        packet_length = (buf[4] << 8) + buf[3];
-        packet->len = packet_length + BT_ACL_HDR_SIZE;
-        LOG(INFO) << "total packet length to be read:" << packet->len;
-        LOG(INFO) << "packet_length:" << packet_length;
-        len = do_read(fd, buf+BT_ACL_HDR_SIZE+1, packet_length);
-        LOG(INFO) << "length of bytes read:" << +len;
-        memcpy(packet->data, buf+1, packet->len);
-        acl_event_received(packet);
-        break;
-      case HCI_PACKET_TYPE_SCO_DATA:
-        len = do_read(fd,buf+1,BT_SCO_HDR_SIZE);
-        packet->event = MSG_HC_TO_STACK_HCI_SCO;
-        packet_length = buf[3];
-        packet->len = packet_length + BT_CMD_HDR_SIZE;
-        len = do_read(fd,buf+1,packet->len);
-        memcpy(packet->data, buf+1, packet->len);
-        sco_data_received(packet);
-        break;
-      case HCI_PACKET_TYPE_EVENT:
-        len = do_read(fd,buf+1,BT_EVT_HDR_SIZE);
-        packet->event = MSG_HC_TO_STACK_HCI_EVT;
-        packet_length = buf[2];
-        packet->len = packet_length + BT_EVT_HDR_SIZE;
-        len = do_read(fd, buf+BT_EVT_HDR_SIZE+1, packet_length);
-        memcpy(packet->data, buf+1, packet->len);
-        hci_event_received(FROM_HERE, packet);
-        break;
-      default:
-        LOG(FATAL) << "Unexpected event type: " << +type;
-        break;
-    }
+void monitor_socket_stream(int ctrl_fd, int fd) {
+  // Read as much as the socket has and parse all packets in it, so that a
+  // burst of packets costs one read instead of two or three per packet.
+  std::vector<uint8_t> rx_buffer(H4_RX_BUFFER_SIZE);
+  size_t filled = 0;
 
+  while (true) {
     fd_set fds;
     FD_ZERO(&fds);
     FD_SET(ctrl_fd, &fds);
@@ -273,7 +276,25 @@ void monitor_socket_stream(int ctrl_fd, int fd) {
       LOG(INFO) << "exitting";
       return;
     }
-    len = read(fd, buf, 1);
+
+    ssize_t len;
+    OSI_NO_INTR(len = read(fd, rx_buffer.data() + filled,
+                           rx_buffer.size() - filled));
+    if (len < 0) {
+      LOG(ERROR) << "read fail Error " << strerror(errno);
+      return;
+    }
+    if (len == 0) {
+      LOG(INFO) << "read returned 0, " << filled << " bytes left unparsed";
+      return;
+    }
+    filled += len;
+
+    size_t consumed = h4_parse(rx_buffer.data(), filled);
+    if (consumed > 0) {
+      memmove(rx_buffer.data(), rx_buffer.data() + consumed, filled - consumed);
+      filled -= consumed;
+    }
   }
 }
 
@@ -418,6 +439,46 @@ hci_transmit_status_t hci_transmit(BT_HDR* packet) {
   return status;
 }
 
+bool hci_supports_acl_fragments() { return true; }
+
+hci_transmit_status_t hci_transmit_acl_fragments(
+    const acl_fragment_t* fragments, size_t count) {
+  static const uint8_t type = HCI_PACKET_TYPE_ACL_DATA;
+  struct iovec iov[3 * PACKET_FRAGMENTER_MAX_BATCH];
+
+  CHECK(bt_vendor_fd != -1);
+  CHECK(count <= PACKET_FRAGMENTER_MAX_BATCH);
+
+  // A stream socket takes the whole batch in one call; a packet socket needs
+  // one write per fragment so the driver sees the packet boundaries.
+  size_t per_write = use_stream_sock ? count : 1;
+  for (size_t sent = 0; sent < count; sent += per_write) {
+    size_t iovcnt = 0;
+    size_t total = 0;
+    for (size_t i = sent; i < sent + per_write; i++) {
+      iov[iovcnt].iov_base = const_cast<uint8_t*>(&type);
+      iov[iovcnt++].iov_len = 1;
+      iov[iovcnt].iov_base = const_cast<uint8_t*>(fragments[i].header);
+      iov[iovcnt++].iov_len = HCI_ACL_PREAMBLE_SIZE;
+      iov[iovcnt].iov_base = const_cast<uint8_t*>(fragments[i].payload);
+      iov[iovcnt++].iov_len = fragments[i].payload_length;
+      total += 1 + HCI_ACL_PREAMBLE_SIZE + fragments[i].payload_length;
+    }
+
+    ssize_t ret;
+    OSI_NO_INTR(ret = writev(bt_vendor_fd, iov, iovcnt));
+    if (ret == -1) {
+      LOG(FATAL) << strerror(errno);
+      return HCI_TRANSMIT_DAEMON_DIED;
+    }
+    if ((size_t)ret != total) {
+      LOG(ERROR) << "Should have send whole packet";
+      return HCI_TRANSMIT_DAEMON_DIED;
+    }
+  }
+  return HCI_TRANSMIT_SUCCESS;
+}
+
 #if (OFF_TARGET_TEST_ENABLED == FALSE)
 static int wait_hcidev(void) {
   struct sockaddr_hci addr;
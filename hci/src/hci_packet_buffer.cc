@@ -0,0 +1,54 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_hci_packet_buffer"
+
+#include "hci_packet_buffer.h"
+
+#include <base/logging.h>
+
+#include "osi/include/allocator.h"
+
+static void release_bt_hdr(void* context) { osi_free(context); }
+
+packet_buffer_t* hci_packet_buffer_from_bt_hdr(BT_HDR* buffer) {
+  CHECK(buffer != NULL);
+
+  return packet_buffer_new_external(buffer->data + buffer->offset,
+                                    buffer->offset, buffer->len,
+                                    release_bt_hdr, buffer);
+}
+
+BT_HDR* hci_packet_buffer_to_bt_hdr(const packet_buffer_t* packet,
+                                    uint16_t offset, uint16_t event,
+                                    uint16_t layer_specific) {
+  CHECK(packet != NULL);
+
+  size_t length = packet_buffer_length(packet);
+  CHECK(length <= UINT16_MAX);
+
+  BT_HDR* buffer =
+      static_cast<BT_HDR*>(osi_malloc(BT_HDR_SIZE + offset + length));
+  buffer->event = event;
+  buffer->len = length;
+  buffer->offset = offset;
+  buffer->layer_specific = layer_specific;
+  packet_buffer_copy_out(packet, 0, buffer->data + offset, length);
+
+  return buffer;
+}
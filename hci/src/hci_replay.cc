@@ -0,0 +1,489 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_hci_replay"
+
+#include "hci_replay.h"
+
+#include <base/logging.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "buffer_allocator.h"
+#include "hci_internals.h"
+#include "hci_layer.h"
+#include "osi/include/allocation_tracker.h"
+#include "osi/include/log.h"
+#include "osi/include/packet_trace.h"
+
+// btsnoop file header: identification pattern, version and datalink type,
+// the latter two big endian. Only the H4 datalink is written by btsnoop.cc.
+#define BTSNOOP_FILE_HEADER_SIZE 16
+#define BTSNOOP_VERSION 1
+#define BTSNOOP_DATALINK_H4 1002
+
+// Record header: original and captured length, flags, cumulative drops and
+// timestamp, all big endian.
+#define BTSNOOP_RECORD_HEADER_SIZE 24
+#define BTSNOOP_FLAG_RECEIVED 0x01
+
+// How far ahead of the next expected outbound packet a packet the stack sent
+// is looked for, so that independent commands sent in a different order
+// still match.
+#define REPLAY_MATCH_WINDOW 16
+
+#define REPLAY_DEFAULT_OUTBOUND_TIMEOUT_MS 2000
+
+typedef struct {
+  uint64_t timestamp_us;
+  serial_data_type_t type;
+  std::vector<uint8_t> data;
+  // Number of outbound packets recorded before this one.
+  size_t outbound_before;
+} inbound_record_t;
+
+typedef struct {
+  uint64_t timestamp_us;
+  uint64_t shape;
+} outbound_record_t;
+
+static const allocator_t* buffer_allocator;
+
+static std::mutex replay_mutex;
+static std::condition_variable replay_cv;
+static std::thread replay_thread;
+
+// The loaded capture, guarded by |replay_mutex|.
+static std::vector<inbound_record_t> inbound_records;
+static std::vector<outbound_record_t> outbound_records;
+static uint64_t loaded_skipped;
+
+// State of the running replay, guarded by |replay_mutex|.
+static hci_replay_config_t replay_config;
+static hci_replay_deliver_cb deliver_cb;
+static bool replay_running;
+static bool replay_stopping;
+static hci_replay_stats_t replay_stats;
+static std::vector<bool> outbound_matched;
+static size_t match_cursor;
+static size_t outbound_seen;
+static bool awaiting_response;
+static uint64_t last_delivery_us;
+
+// The live time of the latest record, inbound or outbound, the replay went
+// past, and its time in the capture. The next inbound packet is due the
+// recorded spacing, scaled, after it.
+static uint64_t anchor_live_us;
+static uint64_t anchor_recorded_us;
+
+static uint64_t start_wall_us;
+static uint64_t start_cpu_us;
+static size_t start_allocations;
+static size_t start_allocated_bytes;
+
+static uint32_t read_be32(const uint8_t* p) {
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+         ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint64_t read_be64(const uint8_t* p) {
+  return ((uint64_t)read_be32(p) << 32) | read_be32(p + 4);
+}
+
+static uint64_t now_us(void) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static uint64_t cpu_time_us(void) {
+  struct timespec ts;
+  if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0) return 0;
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// The parts of a packet that stay the same from one run to the next: what
+// the packet is and where it goes, but not the bytes it carries, which hold
+// random numbers, keys and addresses.
+static uint64_t packet_shape(serial_data_type_t type, const uint8_t* data,
+                             size_t length) {
+  uint64_t shape = (uint64_t)type << 56;
+  switch (type) {
+    case DATA_TYPE_COMMAND:
+      if (length < HCI_COMMAND_PREAMBLE_SIZE) break;
+      // opcode and parameter length
+      return shape | ((uint64_t)(data[0] | (data[1] << 8)) << 16) | data[2];
+    case DATA_TYPE_ACL: {
+      if (length < HCI_ACL_PREAMBLE_SIZE) break;
+      uint16_t handle_flags = data[0] | (data[1] << 8);
+      uint16_t acl_length = data[2] | (data[3] << 8);
+      uint16_t cid = 0;
+      // the L2CAP header only starts in the first fragment
+      bool first = ((handle_flags >> 12) & 0x03) != 0x01;
+      if (first && length >= HCI_ACL_PREAMBLE_SIZE + 4)
+        cid = data[6] | (data[7] << 8);
+      return shape | ((uint64_t)handle_flags << 32) | ((uint64_t)cid << 16) |
+             acl_length;
+    }
+    case DATA_TYPE_SCO:
+      if (length < HCI_SCO_PREAMBLE_SIZE) break;
+      return shape | ((uint64_t)(data[0] | (data[1] << 8)) << 16) | data[2];
+    default:
+      break;
+  }
+  return shape | length;
+}
+
+static bool load(const char* path) {
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) {
+    LOG_ERROR(LOG_TAG, "%s unable to open %s: %s", __func__, path,
+              strerror(errno));
+    return false;
+  }
+
+  std::vector<uint8_t> content;
+  uint8_t chunk[4096];
+  size_t read;
+  while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    content.insert(content.end(), chunk, chunk + read);
+  }
+  fclose(file);
+
+  if (content.size() < BTSNOOP_FILE_HEADER_SIZE ||
+      memcmp(content.data(), "btsnoop\0", 8) != 0 ||
+      read_be32(&content[8]) != BTSNOOP_VERSION ||
+      read_be32(&content[12]) != BTSNOOP_DATALINK_H4) {
+    LOG_ERROR(LOG_TAG, "%s %s is not an H4 btsnoop file", __func__, path);
+    return false;
+  }
+
+  std::vector<inbound_record_t> inbound;
+  std::vector<outbound_record_t> outbound;
+  uint64_t skipped = 0;
+  size_t offset = BTSNOOP_FILE_HEADER_SIZE;
+  while (content.size() - offset >= BTSNOOP_RECORD_HEADER_SIZE) {
+    const uint8_t* header = &content[offset];
+    uint32_t original_length = read_be32(header);
+    uint32_t captured_length = read_be32(header + 4);
+    uint32_t flags = read_be32(header + 8);
+    uint64_t timestamp_us = read_be64(header + 16);
+    offset += BTSNOOP_RECORD_HEADER_SIZE;
+    if (content.size() - offset < captured_length) break;
+    const uint8_t* payload = &content[offset];
+    offset += captured_length;
+
+    // the first byte is the H4 packet type
+    if (captured_length < 2) continue;
+    serial_data_type_t type = (serial_data_type_t)payload[0];
+    if (type < DATA_TYPE_COMMAND || type > DATA_TYPE_EVENT) continue;
+
+    if (flags & BTSNOOP_FLAG_RECEIVED) {
+      if (type == DATA_TYPE_COMMAND) continue;
+      if (captured_length < original_length) {
+        skipped++;
+        continue;
+      }
+      inbound_record_t record;
+      record.timestamp_us = timestamp_us;
+      record.type = type;
+      record.data.assign(payload + 1, payload + captured_length);
+      record.outbound_before = outbound.size();
+      inbound.push_back(std::move(record));
+    } else {
+      if (type == DATA_TYPE_EVENT) continue;
+      outbound.push_back(
+          {timestamp_us, packet_shape(type, payload + 1, captured_length - 1)});
+    }
+  }
+
+  LOG_INFO(LOG_TAG, "%s %s: %zu inbound, %zu outbound, %" PRIu64 " skipped",
+           __func__, path, inbound.size(), outbound.size(), skipped);
+
+  std::lock_guard<std::mutex> lock(replay_mutex);
+  if (replay_running) {
+    LOG_ERROR(LOG_TAG, "%s replay in progress", __func__);
+    return false;
+  }
+  inbound_records = std::move(inbound);
+  outbound_records = std::move(outbound);
+  loaded_skipped = skipped;
+  return true;
+}
+
+static void update_usage_locked(void) {
+  size_t allocations, allocated_bytes;
+  osi_allocator_get_sampled(&allocations, &allocated_bytes);
+  replay_stats.wall_time_us = now_us() - start_wall_us;
+  replay_stats.cpu_time_us = cpu_time_us() - start_cpu_us;
+  replay_stats.allocations = allocations - start_allocations;
+  replay_stats.allocated_bytes = allocated_bytes - start_allocated_bytes;
+}
+
+static void update_anchor_locked(uint64_t recorded_us) {
+  if (recorded_us < anchor_recorded_us) return;
+  anchor_recorded_us = recorded_us;
+  anchor_live_us = now_us();
+}
+
+static void replay_run(void) {
+  std::unique_lock<std::mutex> lock(replay_mutex);
+  // Packets that wait for the same outbound packets as one that timed out go
+  // on right away.
+  size_t given_up_before = 0;
+  for (const inbound_record_t& record : inbound_records) {
+    if (record.outbound_before > given_up_before &&
+        !replay_cv.wait_for(
+            lock,
+            std::chrono::milliseconds(replay_config.outbound_timeout_ms),
+            [&record] {
+              return replay_stopping ||
+                     outbound_seen >= record.outbound_before;
+            })) {
+      replay_stats.outbound_timeouts++;
+      given_up_before = record.outbound_before;
+      LOG_WARN(LOG_TAG, "%s %zu of %zu outbound packets sent, going on",
+               __func__, outbound_seen, record.outbound_before);
+    }
+
+    if (!replay_stopping && replay_config.speed_percent > 0 &&
+        record.timestamp_us > anchor_recorded_us) {
+      uint64_t gap_us = (record.timestamp_us - anchor_recorded_us) * 100 /
+                        replay_config.speed_percent;
+      auto due = std::chrono::steady_clock::time_point(
+          std::chrono::microseconds(anchor_live_us + gap_us));
+      replay_cv.wait_until(lock, due, [] { return replay_stopping; });
+    }
+    if (replay_stopping) break;
+
+    BT_HDR* packet = (BT_HDR*)buffer_allocator->alloc(BT_HDR_SIZE +
+                                                      record.data.size());
+    packet->offset = 0;
+    packet->len = record.data.size();
+    packet->layer_specific = 0;
+    switch (record.type) {
+      case DATA_TYPE_ACL:
+        packet->event = MSG_HC_TO_STACK_HCI_ACL;
+        break;
+      case DATA_TYPE_SCO:
+        packet->event = MSG_HC_TO_STACK_HCI_SCO;
+        break;
+      default:
+        packet->event = MSG_HC_TO_STACK_HCI_EVT;
+        break;
+    }
+    memcpy(packet->data, record.data.data(), record.data.size());
+
+    update_anchor_locked(record.timestamp_us);
+    replay_stats.inbound_packets++;
+    replay_stats.inbound_bytes += record.data.size();
+    last_delivery_us = now_us();
+    awaiting_response = true;
+
+    hci_replay_deliver_cb deliver = deliver_cb;
+    lock.unlock();
+    deliver(record.type, packet);
+    lock.lock();
+  }
+
+  update_usage_locked();
+  replay_stats.finished =
+      replay_stats.inbound_packets == inbound_records.size();
+  LOG_INFO(LOG_TAG,
+           "%s %s: %" PRIu64 " inbound, %" PRIu64 "/%" PRIu64
+           " outbound matched, %" PRIu64 " mismatched, %" PRIu64
+           " timeouts, cpu %" PRIu64 " us, %zu allocations",
+           __func__, replay_stats.finished ? "finished" : "stopped",
+           replay_stats.inbound_packets, replay_stats.outbound_matched,
+           replay_stats.outbound_recorded, replay_stats.outbound_mismatched,
+           replay_stats.outbound_timeouts, replay_stats.cpu_time_us,
+           replay_stats.allocations);
+}
+
+static bool start(const hci_replay_config_t* config,
+                  hci_replay_deliver_cb deliver) {
+  CHECK(config != NULL);
+  CHECK(deliver != NULL);
+
+  std::lock_guard<std::mutex> lock(replay_mutex);
+  if (replay_running || inbound_records.empty()) return false;
+
+  replay_config = *config;
+  if (replay_config.outbound_timeout_ms == 0)
+    replay_config.outbound_timeout_ms = REPLAY_DEFAULT_OUTBOUND_TIMEOUT_MS;
+  deliver_cb = deliver;
+  replay_stopping = false;
+  memset(&replay_stats, 0, sizeof(replay_stats));
+  replay_stats.inbound_skipped = loaded_skipped;
+  replay_stats.outbound_recorded = outbound_records.size();
+  outbound_matched.assign(outbound_records.size(), false);
+  match_cursor = 0;
+  outbound_seen = 0;
+  awaiting_response = false;
+  anchor_live_us = now_us();
+  anchor_recorded_us = inbound_records[0].timestamp_us;
+  if (!outbound_records.empty() &&
+      outbound_records[0].timestamp_us < anchor_recorded_us)
+    anchor_recorded_us = outbound_records[0].timestamp_us;
+
+  // Count every allocation and time every layer while replaying; a replay
+  // is a benchmark run, not a regular session.
+  allocation_tracker_set_sampling_rate(1);
+  if (!packet_trace_is_enabled()) packet_trace_init(true, false);
+  start_wall_us = now_us();
+  start_cpu_us = cpu_time_us();
+  osi_allocator_get_sampled(&start_allocations, &start_allocated_bytes);
+
+  replay_running = true;
+  replay_thread = std::thread(replay_run);
+  return true;
+}
+
+static void stop(void) {
+  {
+    std::lock_guard<std::mutex> lock(replay_mutex);
+    if (!replay_running) return;
+    replay_stopping = true;
+  }
+  replay_cv.notify_all();
+
+  if (replay_thread.get_id() != std::this_thread::get_id()) {
+    replay_thread.join();
+  } else {
+    replay_thread.detach();
+  }
+
+  std::lock_guard<std::mutex> lock(replay_mutex);
+  replay_running = false;
+}
+
+static void transmit(serial_data_type_t type, const uint8_t* data,
+                     size_t length) {
+  uint64_t shape = packet_shape(type, data, length);
+  {
+    std::lock_guard<std::mutex> lock(replay_mutex);
+    if (!replay_running) return;
+
+    uint64_t now = now_us();
+    if (awaiting_response) {
+      uint64_t response_us = now - last_delivery_us;
+      replay_stats.response_count++;
+      replay_stats.response_total_us += response_us;
+      if (response_us > replay_stats.response_max_us)
+        replay_stats.response_max_us = response_us;
+      awaiting_response = false;
+    }
+
+    size_t end = std::min(match_cursor + REPLAY_MATCH_WINDOW,
+                          outbound_records.size());
+    size_t index = match_cursor;
+    while (index < end &&
+           (outbound_matched[index] || outbound_records[index].shape != shape))
+      index++;
+    if (index < end) {
+      outbound_matched[index] = true;
+      replay_stats.outbound_matched++;
+      while (match_cursor < outbound_matched.size() &&
+             outbound_matched[match_cursor])
+        match_cursor++;
+    } else {
+      replay_stats.outbound_mismatched++;
+      if (replay_stats.outbound_mismatched <= 10) {
+        LOG_WARN(LOG_TAG,
+                 "%s packet %zu type %d shape 0x%016" PRIx64
+                 " not in the capture near packet %zu",
+                 __func__, outbound_seen, type, shape, match_cursor);
+      }
+    }
+
+    outbound_seen++;
+    if (outbound_seen <= outbound_records.size())
+      update_anchor_locked(outbound_records[outbound_seen - 1].timestamp_us);
+  }
+  replay_cv.notify_all();
+}
+
+static void get_stats(hci_replay_stats_t* stats) {
+  CHECK(stats != NULL);
+
+  std::lock_guard<std::mutex> lock(replay_mutex);
+  if (replay_running && !replay_stats.finished && !replay_stopping)
+    update_usage_locked();
+  *stats = replay_stats;
+}
+
+static void debug_dump(int fd) {
+  static const char* segment_names[PACKET_TRACE_SEGMENT_COUNT] = {
+      "TX L2CAP queue", "TX HCI", "TX total",
+      "RX HCI",         "RX L2CAP", "RX total"};
+
+  hci_replay_stats_t stats;
+  get_stats(&stats);
+
+  dprintf(fd, "\nHCI Replay:\n");
+  dprintf(fd, "  State: %s\n", stats.finished ? "finished" : "in progress");
+  dprintf(fd, "  Inbound packets/bytes/skipped : %" PRIu64 " / %" PRIu64
+          " / %" PRIu64 "\n",
+          stats.inbound_packets, stats.inbound_bytes, stats.inbound_skipped);
+  dprintf(fd, "  Outbound matched/recorded     : %" PRIu64 " / %" PRIu64 "\n",
+          stats.outbound_matched, stats.outbound_recorded);
+  dprintf(fd, "  Outbound mismatched/timeouts  : %" PRIu64 " / %" PRIu64 "\n",
+          stats.outbound_mismatched, stats.outbound_timeouts);
+  dprintf(fd, "  Response avg/max (us)         : %" PRIu64 " / %" PRIu64 "\n",
+          stats.response_count ? stats.response_total_us / stats.response_count
+                               : 0,
+          stats.response_max_us);
+  dprintf(fd, "  Wall/CPU time (us)            : %" PRIu64 " / %" PRIu64 "\n",
+          stats.wall_time_us, stats.cpu_time_us);
+  dprintf(fd, "  Allocations/bytes             : %zu / %zu\n",
+          stats.allocations, stats.allocated_bytes);
+
+  dprintf(fd, "  Layer latency avg/max (us):\n");
+  for (int i = 0; i < PACKET_TRACE_SEGMENT_COUNT; i++) {
+    packet_trace_stats_t segment;
+    packet_trace_get_stats((packet_trace_segment_t)i, &segment);
+    dprintf(fd, "    %-14s: %" PRIu64 " / %" PRIu64 " (%" PRIu64 " packets)\n",
+            segment_names[i],
+            segment.count ? segment.total_us / segment.count : 0,
+            segment.max_us, segment.count);
+  }
+}
+
+static const hci_replay_t interface = {load,     start,     stop,
+                                       transmit, get_stats, debug_dump};
+
+const hci_replay_t* hci_replay_get_interface() {
+  buffer_allocator = buffer_allocator_get_interface();
+  return &interface;
+}
+
+const hci_replay_t* hci_replay_get_test_interface(
+    const allocator_t* buffer_allocator_interface) {
+  buffer_allocator = buffer_allocator_interface;
+  return &interface;
+}
@@ -22,7 +22,6 @@
 
 #include <base/logging.h>
 #include <string.h>
-#include <unordered_map>
 
 #include "bt_target.h"
 #include "buffer_allocator.h"
@@ -30,6 +29,7 @@
 #include "hci_internals.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/packet_trace.h"
 
 #define APPLY_CONTINUATION_FLAG(handle) (((handle)&0xCFFF) | 0x1000)
 #define APPLY_START_FLAG(handle) (((handle)&0xCFFF) | 0x2000)
@@ -43,19 +43,136 @@
 #define POINT_TO_POINT 0
 #define L2CAP_HEADER_SIZE 4
 
+// ACL connection handles are 12 bits wide, but 0x0F00-0x0FFF are reserved.
+#define MAX_ACL_HANDLES 0x0F00
+
 // Our interface and callbacks
 
 static const allocator_t* buffer_allocator;
 static const controller_t* controller;
 static const packet_fragmenter_callbacks_t* callbacks;
 
-static std::unordered_map<uint16_t /* handle */, BT_HDR*> partial_packets;
+// Reassembly state of one connection handle. |partial| is the packet being
+// reassembled. |spare| is a buffer of |spare_size| bytes that was not handed
+// up, kept to serve the handle's next start fragment without allocating.
+typedef struct {
+  BT_HDR* partial;
+  BT_HDR* spare;
+  size_t spare_size;
+} reassembly_slot_t;
+
+// Indexed by connection handle.
+static reassembly_slot_t* reassembly_slots;
 
 static void init(const packet_fragmenter_callbacks_t* result_callbacks) {
   callbacks = result_callbacks;
+  if (!reassembly_slots)
+    reassembly_slots = (reassembly_slot_t*)osi_calloc(
+        MAX_ACL_HANDLES * sizeof(reassembly_slot_t));
+}
+
+static void cleanup() {
+  if (!reassembly_slots) return;
+
+  for (size_t i = 0; i < MAX_ACL_HANDLES; i++) {
+    buffer_allocator->free(reassembly_slots[i].partial);
+    buffer_allocator->free(reassembly_slots[i].spare);
+  }
+  osi_free_and_reset((void**)&reassembly_slots);
+}
+
+// Returns a buffer of at least |size| bytes for a reassembly on |slot|,
+// reusing its spare buffer if it is large enough.
+static BT_HDR* slot_alloc(reassembly_slot_t* slot, size_t size) {
+  if (slot->spare && slot->spare_size >= size) {
+    BT_HDR* buffer = slot->spare;
+    slot->spare = NULL;
+    return buffer;
+  }
+  return (BT_HDR*)buffer_allocator->alloc(size);
+}
+
+// Keeps the unfinished packet of |slot| as its spare buffer. |size| is the
+// size it was allocated with.
+static void slot_recycle_partial(reassembly_slot_t* slot, size_t size) {
+  if (slot->spare && slot->spare_size >= size) {
+    buffer_allocator->free(slot->partial);
+  } else {
+    buffer_allocator->free(slot->spare);
+    slot->spare = slot->partial;
+    slot->spare_size = size;
+  }
+  slot->partial = NULL;
 }
 
-static void cleanup() { partial_packets.clear(); }
+// Fragments |packet| without touching its bytes until a batch has been handed
+// to the fragments_ready callback. Only continuation headers the next call
+// needs are written back in place, which keeps partial transmission (see
+// |layer_specific| below) identical to the per-fragment path.
+static void fragment_and_dispatch_batched(BT_HDR* packet,
+                                          uint16_t max_data_size) {
+  acl_fragment_t fragments[PACKET_FRAGMENTER_MAX_BATCH];
+  size_t count = 0;
+
+  uint8_t* stream = packet->data + packet->offset;
+  uint16_t handle;
+  STREAM_TO_UINT16(handle, stream);
+  uint16_t continuation_handle = APPLY_CONTINUATION_FLAG(handle);
+
+  const uint8_t* payload = packet->data + packet->offset + HCI_ACL_PREAMBLE_SIZE;
+  uint16_t remaining = packet->len - HCI_ACL_PREAMBLE_SIZE;
+  bool first = true;
+  bool partial = false;
+
+  while (remaining > 0) {
+    uint16_t length = remaining > max_data_size ? max_data_size : remaining;
+    bool last = (length == remaining);
+
+    acl_fragment_t* fragment = &fragments[count++];
+    uint8_t* header = fragment->header;
+    UINT16_TO_STREAM(header, first ? handle : continuation_handle);
+    UINT16_TO_STREAM(header, length);
+    first = false;
+    fragment->payload = payload;
+    fragment->payload_length = length;
+
+    payload += length;
+    remaining -= length;
+    if (last) break;
+
+    // Apparently L2CAP can set layer_specific to a max number of segments to
+    // transmit
+    if (packet->layer_specific) {
+      packet->layer_specific--;
+      if (packet->layer_specific == 0) {
+        partial = true;
+        break;
+      }
+    }
+
+    if (count == PACKET_FRAGMENTER_MAX_BATCH) {
+      callbacks->fragments_ready(packet, fragments, count, false);
+      count = 0;
+    }
+  }
+
+  if (!partial) {
+    callbacks->fragments_ready(packet, fragments, count, true);
+    return;
+  }
+
+  callbacks->fragments_ready(packet, fragments, count, false);
+
+  // Hand the unsent remainder back with its continuation header in front.
+  packet->offset = payload - HCI_ACL_PREAMBLE_SIZE - packet->data;
+  packet->len = remaining + HCI_ACL_PREAMBLE_SIZE;
+  uint8_t* header = packet->data + packet->offset;
+  UINT16_TO_STREAM(header, continuation_handle);
+  UINT16_TO_STREAM(header, remaining);
+
+  packet->event = MSG_HC_TO_STACK_L2C_SEG_XMIT;
+  callbacks->transmit_finished(packet, false);
+}
 
 static void fragment_and_dispatch(BT_HDR* packet) {
   CHECK(packet != NULL);
@@ -77,6 +194,11 @@ static void fragment_and_dispatch(BT_HDR* packet) {
   uint16_t max_packet_size = max_data_size + HCI_ACL_PREAMBLE_SIZE;
   uint16_t remaining_length = packet->len;
 
+  if (callbacks->fragments_ready && remaining_length > max_packet_size) {
+    fragment_and_dispatch_batched(packet, max_data_size);
+    return;
+  }
+
   uint16_t continuation_handle;
   STREAM_TO_UINT16(continuation_handle, stream);
   continuation_handle = APPLY_CONTINUATION_FLAG(continuation_handle);
@@ -147,16 +269,19 @@ static void reassemble_and_dispatch(BT_HDR* packet) {
         buffer_allocator->free(packet);
         return;
       }
-      auto map_iter = partial_packets.find(handle);
-      if (map_iter != partial_packets.end()) {
+      if (handle >= MAX_ACL_HANDLES) {
+        LOG_WARN(LOG_TAG, "%s invalid handle 0x%04x", __func__, handle);
+        buffer_allocator->free(packet);
+        return;
+      }
+      reassembly_slot_t* slot = &reassembly_slots[handle];
+      if (slot->partial != nullptr) {
         LOG_WARN(LOG_TAG,
                  "%s found unfinished packet for handle with start packet. "
                  "Dropping old.",
                  __func__);
 
-        BT_HDR* hdl = map_iter->second;
-        partial_packets.erase(map_iter);
-        buffer_allocator->free(hdl);
+        slot_recycle_partial(slot, slot->partial->len + sizeof(BT_HDR));
       }
 
       if (acl_length < L2CAP_HEADER_SIZE) {
@@ -193,8 +318,7 @@ static void reassemble_and_dispatch(BT_HDR* packet) {
         return;
       }
 
-      BT_HDR* partial_packet =
-          (BT_HDR*)buffer_allocator->alloc(full_length + sizeof(BT_HDR));
+      BT_HDR* partial_packet = slot_alloc(slot, full_length + sizeof(BT_HDR));
       partial_packet->event = packet->event;
       partial_packet->len = full_length;
       partial_packet->offset = packet->len;
@@ -206,20 +330,22 @@ static void reassemble_and_dispatch(BT_HDR* packet) {
       STREAM_SKIP_UINT16(stream);  // skip the handle
       UINT16_TO_STREAM(stream, full_length - HCI_ACL_PREAMBLE_SIZE);
 
-      partial_packets[handle] = partial_packet;
+      slot->partial = partial_packet;
+      packet_trace_move(packet, partial_packet);
 
       // Free the old packet buffer, since we don't need it anymore
       buffer_allocator->free(packet);
     } else {
-      auto map_iter = partial_packets.find(handle);
-      if (map_iter == partial_packets.end()) {
+      reassembly_slot_t* slot =
+          handle < MAX_ACL_HANDLES ? &reassembly_slots[handle] : nullptr;
+      if (slot == nullptr || slot->partial == nullptr) {
         LOG_WARN(LOG_TAG,
                  "%s got continuation for unknown packet. Dropping it.",
                  __func__);
         buffer_allocator->free(packet);
         return;
       }
-      BT_HDR* partial_packet = map_iter->second;
+      BT_HDR* partial_packet = slot->partial;
 
       packet->offset = HCI_ACL_PREAMBLE_SIZE;
       uint16_t projected_offset =
@@ -236,13 +362,14 @@ static void reassemble_and_dispatch(BT_HDR* packet) {
 
       memcpy(partial_packet->data + partial_packet->offset,
              packet->data + packet->offset, packet->len - packet->offset);
+      packet_trace_forget(packet);
 
       // Free the old packet buffer, since we don't need it anymore
       buffer_allocator->free(packet);
       partial_packet->offset = projected_offset;
 
       if (partial_packet->offset == partial_packet->len) {
-        partial_packets.erase(handle);
+        slot->partial = NULL;
         partial_packet->offset = 0;
         callbacks->reassembled(partial_packet);
       }
@@ -0,0 +1,160 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <vector>
+
+#include "AllocationTestHarness.h"
+
+#include "adv_report_filter.h"
+#include "hci_layer.h"
+#include "hcidefs.h"
+#include "osi/include/allocator.h"
+
+static const adv_report_filter_t* filter;
+static std::vector<BT_HDR*> dispatched;
+
+static void dispatch(BT_HDR* packet) { dispatched.push_back(packet); }
+
+// Builds a legacy advertising report event with one report from the device
+// whose address ends in |address| and one byte of advertising data.
+static BT_HDR* make_report(uint8_t address, uint8_t adv_data, int8_t rssi) {
+  const uint8_t report[] = {
+      HCI_BLE_EVENT, 13, HCI_BLE_ADV_PKT_RPT_EVT, 1,
+      0x00,                                      // ADV_IND
+      0x00,                                      // public address
+      address, 0x11, 0x22, 0x33, 0x44, 0x55,
+      1, adv_data, (uint8_t)rssi};
+  BT_HDR* packet = (BT_HDR*)osi_malloc(sizeof(BT_HDR) + sizeof(report));
+  packet->event = MSG_HC_TO_STACK_HCI_EVT;
+  packet->offset = 0;
+  packet->len = sizeof(report);
+  packet->layer_specific = 0;
+  memcpy(packet->data, report, sizeof(report));
+  return packet;
+}
+
+static BT_HDR* make_event(uint8_t event_code) {
+  BT_HDR* packet = (BT_HDR*)osi_malloc(sizeof(BT_HDR) + 2);
+  packet->event = MSG_HC_TO_STACK_HCI_EVT;
+  packet->offset = 0;
+  packet->len = 2;
+  packet->layer_specific = 0;
+  packet->data[0] = event_code;
+  packet->data[1] = 0;
+  return packet;
+}
+
+class AdvReportFilterTest : public AllocationTestHarness {
+ protected:
+  void SetUp() override {
+    AllocationTestHarness::SetUp();
+    filter = adv_report_filter_get_test_interface(&allocator_malloc);
+    dispatched.clear();
+  }
+
+  void TearDown() override {
+    filter->cleanup();
+    for (BT_HDR* packet : dispatched) osi_free(packet);
+    dispatched.clear();
+    AllocationTestHarness::TearDown();
+  }
+
+  void Init(period_ms_t window_ms, size_t max_batch_reports) {
+    adv_report_filter_config_t config = {window_ms, max_batch_reports};
+    filter->init(&config, dispatch);
+  }
+};
+
+TEST_F(AdvReportFilterTest, test_other_events_pass_through) {
+  Init(100, 4);
+
+  EXPECT_FALSE(filter->process(make_event(HCI_COMMAND_COMPLETE_EVT), 0));
+  ASSERT_EQ(1u, dispatched.size());
+  EXPECT_EQ(HCI_COMMAND_COMPLETE_EVT, dispatched[0]->data[0]);
+}
+
+TEST_F(AdvReportFilterTest, test_duplicates_dropped_within_window) {
+  Init(100, 1);
+
+  filter->process(make_report(0x01, 0xAA, -40), 0);
+  filter->process(make_report(0x01, 0xAA, -40), 50);
+  filter->process(make_report(0x01, 0xAA, -41), 60);  // RSSI differs
+  filter->process(make_report(0x01, 0xAA, -40), 120);
+
+  EXPECT_EQ(3u, dispatched.size());
+
+  adv_report_filter_stats_t stats;
+  filter->get_stats(&stats);
+  EXPECT_EQ(4u, stats.reports_received);
+  EXPECT_EQ(1u, stats.duplicates_dropped);
+}
+
+TEST_F(AdvReportFilterTest, test_reports_coalesced) {
+  Init(0, 3);
+
+  EXPECT_TRUE(filter->process(make_report(0x01, 0xAA, -40), 0));
+  EXPECT_TRUE(filter->process(make_report(0x02, 0xBB, -50), 0));
+  EXPECT_TRUE(dispatched.empty());
+  EXPECT_FALSE(filter->process(make_report(0x03, 0xCC, -60), 0));
+
+  ASSERT_EQ(1u, dispatched.size());
+  BT_HDR* batch = dispatched[0];
+  const size_t report_size = 11;
+  EXPECT_EQ(2u + 2u + 3 * report_size, batch->len);
+  EXPECT_EQ(HCI_BLE_EVENT, batch->data[0]);
+  EXPECT_EQ(batch->len - 2, batch->data[1]);
+  EXPECT_EQ(HCI_BLE_ADV_PKT_RPT_EVT, batch->data[2]);
+  EXPECT_EQ(3, batch->data[3]);
+  for (size_t i = 0; i < 3; i++) {
+    const uint8_t* report = batch->data + 4 + i * report_size;
+    EXPECT_EQ(i + 1, report[2]);
+    EXPECT_EQ(0xAA + i * 0x11, report[9]);
+  }
+
+  adv_report_filter_stats_t stats;
+  filter->get_stats(&stats);
+  EXPECT_EQ(3u, stats.reports_coalesced);
+  EXPECT_EQ(1u, stats.batches_dispatched);
+}
+
+TEST_F(AdvReportFilterTest, test_other_event_flushes_batch_first) {
+  Init(0, 8);
+
+  EXPECT_TRUE(filter->process(make_report(0x01, 0xAA, -40), 0));
+  EXPECT_FALSE(filter->process(make_event(HCI_COMMAND_STATUS_EVT), 0));
+
+  ASSERT_EQ(2u, dispatched.size());
+  EXPECT_EQ(HCI_BLE_EVENT, dispatched[0]->data[0]);
+  EXPECT_EQ(1, dispatched[0]->data[3]);
+  EXPECT_EQ(HCI_COMMAND_STATUS_EVT, dispatched[1]->data[0]);
+}
+
+TEST_F(AdvReportFilterTest, test_flush) {
+  Init(0, 8);
+
+  EXPECT_TRUE(filter->process(make_report(0x01, 0xAA, -40), 0));
+  filter->flush();
+  EXPECT_EQ(1u, dispatched.size());
+
+  filter->flush();
+  EXPECT_EQ(1u, dispatched.size());
+}
@@ -0,0 +1,237 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "AllocationTestHarness.h"
+
+#include "hci_replay.h"
+#include "osi/include/allocator.h"
+
+static const hci_replay_t* replay;
+
+static std::mutex delivered_mutex;
+static std::condition_variable delivered_cv;
+static std::vector<serial_data_type_t> delivered;
+static std::vector<std::chrono::steady_clock::time_point> delivered_at;
+
+static void deliver(serial_data_type_t type, BT_HDR* packet) {
+  osi_free(packet);
+  std::lock_guard<std::mutex> lock(delivered_mutex);
+  delivered.push_back(type);
+  delivered_at.push_back(std::chrono::steady_clock::now());
+  delivered_cv.notify_all();
+}
+
+static bool wait_delivered(size_t count, int timeout_ms) {
+  std::unique_lock<std::mutex> lock(delivered_mutex);
+  return delivered_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                               [count] { return delivered.size() >= count; });
+}
+
+static size_t delivered_count() {
+  std::lock_guard<std::mutex> lock(delivered_mutex);
+  return delivered.size();
+}
+
+// HCI_Reset and an ACL packet on handle 0x0001 to the ATT channel.
+static const uint8_t reset[] = {0x03, 0x0c, 0x00};
+static const uint8_t acl[] = {0x01, 0x20, 0x07, 0x00, 0x03,
+                              0x00, 0x04, 0x00, 0x52, 0x03, 0x00};
+
+class HciReplayTest : public AllocationTestHarness {
+ protected:
+  void SetUp() override {
+    AllocationTestHarness::SetUp();
+    replay = hci_replay_get_test_interface(&allocator_malloc);
+    delivered.clear();
+    delivered_at.clear();
+
+    char name[] = "/tmp/hci_replay_test_XXXXXX";
+    int fd = mkstemp(name);
+    ASSERT_NE(-1, fd);
+    close(fd);
+    path_ = name;
+    capture_.clear();
+  }
+
+  void TearDown() override {
+    replay->stop();
+    unlink(path_.c_str());
+    AllocationTestHarness::TearDown();
+  }
+
+  void append_be32(uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8)
+      capture_.push_back(value >> shift);
+  }
+
+  void record(bool received, uint8_t type, const uint8_t* data, size_t length,
+              uint64_t timestamp_us) {
+    append_be32(length + 1);
+    append_be32(length + 1);
+    append_be32(received ? 1 : 0);
+    append_be32(0);
+    append_be32(timestamp_us >> 32);
+    append_be32(timestamp_us);
+    capture_.push_back(type);
+    capture_.insert(capture_.end(), data, data + length);
+  }
+
+  // An HCI_Reset, its Command Complete, an advertising report 100 ms later,
+  // then an ACL packet followed by its Number Of Completed Packets.
+  bool load_capture() {
+    static const uint8_t reset_complete[] = {0x0e, 0x04, 0x01,
+                                             0x03, 0x0c, 0x00};
+    static const uint8_t adv_report[] = {0x3e, 0x0c, 0x02, 0x01, 0x00,
+                                         0x00, 0x01, 0x02, 0x03, 0x04,
+                                         0x05, 0x06, 0x00, 0xc0};
+    static const uint8_t completed[] = {0x13, 0x05, 0x01,
+                                        0x01, 0x00, 0x01, 0x00};
+    record(false, DATA_TYPE_COMMAND, reset, sizeof(reset), 1000000);
+    record(true, DATA_TYPE_EVENT, reset_complete, sizeof(reset_complete),
+           1001000);
+    record(true, DATA_TYPE_EVENT, adv_report, sizeof(adv_report), 1101000);
+    record(false, DATA_TYPE_ACL, acl, sizeof(acl), 1102000);
+    record(true, DATA_TYPE_EVENT, completed, sizeof(completed), 1103000);
+    return write_capture();
+  }
+
+  bool write_capture() {
+    static const uint8_t header[] = {'b', 't', 's', 'n', 'o', 'o', 'p', 0,
+                                     0,   0,   0,   1,   0,   0,   0x03, 0xea};
+    FILE* file = fopen(path_.c_str(), "wb");
+    if (file == NULL) return false;
+    fwrite(header, 1, sizeof(header), file);
+    fwrite(capture_.data(), 1, capture_.size(), file);
+    fclose(file);
+    return replay->load(path_.c_str());
+  }
+
+  void start(uint32_t speed_percent, period_ms_t outbound_timeout_ms) {
+    hci_replay_config_t config;
+    config.speed_percent = speed_percent;
+    config.outbound_timeout_ms = outbound_timeout_ms;
+    ASSERT_TRUE(replay->start(&config, deliver));
+  }
+
+  std::string path_;
+  std::vector<uint8_t> capture_;
+};
+
+TEST_F(HciReplayTest, test_rejects_other_files) {
+  FILE* file = fopen(path_.c_str(), "wb");
+  ASSERT_TRUE(file != NULL);
+  fputs("not a capture", file);
+  fclose(file);
+
+  EXPECT_FALSE(replay->load(path_.c_str()));
+  EXPECT_FALSE(replay->load("/nonexistent/hci_replay_test"));
+}
+
+TEST_F(HciReplayTest, test_waits_for_recorded_outbound) {
+  ASSERT_TRUE(load_capture());
+  start(0, 5000);
+
+  // Nothing before the stack resets the controller
+  usleep(50000);
+  EXPECT_EQ(0u, delivered_count());
+
+  replay->transmit(DATA_TYPE_COMMAND, reset, sizeof(reset));
+  ASSERT_TRUE(wait_delivered(2, 1000));
+  usleep(50000);
+  EXPECT_EQ(2u, delivered_count());
+
+  replay->transmit(DATA_TYPE_ACL, acl, sizeof(acl));
+  ASSERT_TRUE(wait_delivered(3, 1000));
+  EXPECT_EQ(DATA_TYPE_EVENT, delivered[2]);
+
+  replay->stop();
+  hci_replay_stats_t stats;
+  replay->get_stats(&stats);
+  EXPECT_TRUE(stats.finished);
+  EXPECT_EQ(3u, stats.inbound_packets);
+  EXPECT_EQ(2u, stats.outbound_recorded);
+  EXPECT_EQ(2u, stats.outbound_matched);
+  EXPECT_EQ(0u, stats.outbound_mismatched);
+  EXPECT_EQ(0u, stats.outbound_timeouts);
+  // The HCI_Reset answers nothing
+  EXPECT_EQ(1u, stats.response_count);
+}
+
+TEST_F(HciReplayTest, test_compares_structure) {
+  ASSERT_TRUE(load_capture());
+  start(0, 5000);
+
+  // Another opcode first, then the ACL packet with a different payload
+  static const uint8_t read_version[] = {0x01, 0x10, 0x00};
+  uint8_t other_acl[sizeof(acl)];
+  memcpy(other_acl, acl, sizeof(acl));
+  other_acl[sizeof(acl) - 1] = 0x7f;
+  replay->transmit(DATA_TYPE_COMMAND, read_version, sizeof(read_version));
+  replay->transmit(DATA_TYPE_COMMAND, reset, sizeof(reset));
+  replay->transmit(DATA_TYPE_ACL, other_acl, sizeof(other_acl));
+  ASSERT_TRUE(wait_delivered(3, 1000));
+
+  replay->stop();
+  hci_replay_stats_t stats;
+  replay->get_stats(&stats);
+  EXPECT_EQ(2u, stats.outbound_matched);
+  EXPECT_EQ(1u, stats.outbound_mismatched);
+}
+
+TEST_F(HciReplayTest, test_goes_on_after_timeout) {
+  ASSERT_TRUE(load_capture());
+  start(0, 20);
+
+  ASSERT_TRUE(wait_delivered(3, 1000));
+  replay->stop();
+  hci_replay_stats_t stats;
+  replay->get_stats(&stats);
+  EXPECT_TRUE(stats.finished);
+  EXPECT_EQ(3u, stats.inbound_packets);
+  EXPECT_EQ(2u, stats.outbound_timeouts);
+}
+
+TEST_F(HciReplayTest, test_keeps_recorded_spacing) {
+  ASSERT_TRUE(load_capture());
+  start(100, 5000);
+
+  replay->transmit(DATA_TYPE_COMMAND, reset, sizeof(reset));
+  ASSERT_TRUE(wait_delivered(2, 1000));
+  auto gap = delivered_at[1] - delivered_at[0];
+  EXPECT_GE(gap, std::chrono::milliseconds(90));
+}
+
+TEST_F(HciReplayTest, test_scales_recorded_spacing) {
+  ASSERT_TRUE(load_capture());
+  start(1000, 5000);
+
+  replay->transmit(DATA_TYPE_COMMAND, reset, sizeof(reset));
+  ASSERT_TRUE(wait_delivered(2, 1000));
+  auto gap = delivered_at[1] - delivered_at[0];
+  EXPECT_GE(gap, std::chrono::milliseconds(9));
+  EXPECT_LT(gap, std::chrono::milliseconds(90));
+}
@@ -31,7 +31,7 @@
 
 DECLARE_TEST_MODES(init, set_data_sizes, no_fragmentation, fragmentation,
                    ble_no_fragmentation, ble_fragmentation,
-                   non_acl_passthrough_fragmentation, no_reassembly, reassembly,
+                   batched_fragmentation, non_acl_passthrough_fragmentation, no_reassembly, reassembly,
                    non_acl_passthrough_reassembly);
 
 #define LOCAL_BLE_CONTROLLER_ID 1
@@ -127,6 +127,41 @@ static void expect_packet_fragmented(uint16_t event, int max_acl_data_size,
   if (send_complete) osi_free(packet);
 }
 
+static void expect_fragments_batched(int max_acl_data_size, BT_HDR* packet,
+                                     const acl_fragment_t* fragments,
+                                     size_t count, const char* expected_data,
+                                     bool send_complete) {
+  // The packet itself must still hold the original, unfragmented data.
+  uint8_t* original = packet->data + packet->offset + HCI_ACL_PREAMBLE_SIZE;
+  EXPECT_EQ(0, memcmp(expected_data, original, strlen(expected_data)));
+
+  for (size_t i = 0; i < count; i++) {
+    const uint8_t* header = fragments[i].header;
+    uint16_t handle;
+    uint16_t length;
+    STREAM_TO_UINT16(handle, header);
+    STREAM_TO_UINT16(length, header);
+
+    if (packet_index == 0)
+      EXPECT_EQ(test_handle_start, handle);
+    else
+      EXPECT_EQ(test_handle_continuation, handle);
+
+    EXPECT_EQ(fragments[i].payload_length, length);
+    int length_remaining = strlen(expected_data) - data_size_sum;
+    if (length_remaining > max_acl_data_size)
+      EXPECT_EQ(max_acl_data_size, length);
+
+    EXPECT_EQ(0, memcmp(expected_data + data_size_sum, fragments[i].payload,
+                        length));
+    data_size_sum += length;
+    packet_index++;
+  }
+
+  EXPECT_TRUE(send_complete == (data_size_sum == strlen(expected_data)));
+  if (send_complete) osi_free(packet);
+}
+
 static void manufacture_packet_and_then_reassemble(uint16_t event,
                                                    uint16_t acl_size,
                                                    const char* data) {
@@ -237,6 +272,18 @@ DURING(non_acl_passthrough_fragmentation) AT_CALL(0) {
 UNEXPECTED_CALL;
 }
 
+STUB_FUNCTION(void, fragments_ready_callback,
+              (BT_HDR * packet, const acl_fragment_t* fragments, size_t count,
+               bool send_complete))
+DURING(batched_fragmentation) AT_CALL(0) {
+  expect_fragments_batched(10, packet, fragments, count, sample_data,
+                           send_complete);
+  return;
+}
+
+UNEXPECTED_CALL;
+}
+
 STUB_FUNCTION(void, reassembled_callback, (BT_HDR * packet))
 DURING(no_reassembly) AT_CALL(0) {
   expect_packet_reassembled(MSG_HC_TO_STACK_HCI_ACL, packet, small_sample_data);
@@ -265,7 +312,7 @@ UNEXPECTED_CALL;
 STUB_FUNCTION(uint16_t, get_acl_data_size_classic, (void))
 DURING(no_fragmentation, non_acl_passthrough_fragmentation, no_reassembly)
 return 42;
-DURING(fragmentation) return 10;
+DURING(fragmentation, batched_fragmentation) return 10;
 DURING(no_reassembly) return 1337;
 
 UNEXPECTED_CALL;
@@ -282,6 +329,7 @@ return 0;
 
 static void reset_for(TEST_MODES_T next) {
   RESET_CALL_COUNT(fragmented_callback);
+  RESET_CALL_COUNT(fragments_ready_callback);
   RESET_CALL_COUNT(reassembled_callback);
   RESET_CALL_COUNT(transmit_finished_callback);
   RESET_CALL_COUNT(get_acl_data_size_classic);
@@ -302,6 +350,7 @@ class PacketFragmenterTest : public AllocationTestHarness {
     callbacks.fragmented = fragmented_callback;
     callbacks.reassembled = reassembled_callback;
     callbacks.transmit_finished = transmit_finished_callback;
+    callbacks.fragments_ready = NULL;
     controller.get_acl_data_size_classic = get_acl_data_size_classic;
     controller.get_acl_data_size_ble = get_acl_data_size_ble;
 
@@ -358,6 +407,18 @@ TEST_F(PacketFragmenterTest, test_ble_fragment_necessary) {
   EXPECT_EQ(strlen(sample_data), data_size_sum);
 }
 
+TEST_F(PacketFragmenterTest, test_batched_fragment_necessary) {
+  reset_for(batched_fragmentation);
+  callbacks.fragments_ready = fragments_ready_callback;
+  BT_HDR* packet = manufacture_packet_for_fragmentation(MSG_STACK_TO_HC_HCI_ACL,
+                                                        sample_data);
+  fragmenter->fragment_and_dispatch(packet);
+
+  EXPECT_EQ(strlen(sample_data), data_size_sum);
+  EXPECT_CALL_COUNT(fragments_ready_callback, 1);
+  EXPECT_CALL_COUNT(fragmented_callback, 0);
+}
+
 TEST_F(PacketFragmenterTest, test_non_acl_passthrough_fragmentation) {
   reset_for(non_acl_passthrough_fragmentation);
   BT_HDR* packet = manufacture_packet_for_fragmentation(MSG_STACK_TO_HC_HCI_CMD,
@@ -43,11 +43,33 @@ typedef void (*scan_result_callback)(uint16_t event_type, uint8_t addr_type,
                                      int8_t rssi, uint16_t periodic_adv_int,
                                      std::vector<uint8_t> adv_data);
 
+/** A scan result, as given to the batched scan result callback */
+typedef struct {
+  uint16_t event_type;
+  uint8_t addr_type;
+  RawAddress bda;
+  uint8_t primary_phy;
+  uint8_t secondary_phy;
+  uint8_t advertising_sid;
+  int8_t tx_power;
+  int8_t rssi;
+  uint16_t periodic_adv_int;
+  std::vector<uint8_t> adv_data;
+  RawAddress original_bda;
+} btgatt_scan_result_t;
+
+/** Callback for several scan results at once, in the order they were
+ *  received. Optional, scan results are delivered one by one through
+ *  |scan_result_cb| when it is not set. */
+typedef void (*scan_result_batch_callback)(
+    const std::vector<btgatt_scan_result_t>& results);
+
 typedef struct {
   scan_result_callback scan_result_cb;
   batchscan_reports_callback batchscan_reports_cb;
   batchscan_threshold_callback batchscan_threshold_cb;
   track_adv_event_callback track_adv_event_cb;
+  scan_result_batch_callback scan_result_batch_cb;
 } btgatt_scanner_callbacks_t;
 
 class BleScannerInterface {
@@ -19,6 +19,7 @@
 #define ANDROID_INCLUDE_BT_GATT_CLIENT_H
 
 #include <stdint.h>
+#include <vector>
 #include "bt_common_types.h"
 #include "bt_gatt_types.h"
 
@@ -125,6 +126,12 @@ typedef void (*register_for_notification_callback)(int conn_id,
  */
 typedef void (*notify_callback)(int conn_id, const btgatt_notify_params_t& p_data);
 
+/** Callback for several notifications of a connection at once, in the order
+ *  they were received. Optional, notifications are delivered one by one
+ *  through |notify_cb| when it is not set. Indications are never batched. */
+typedef void (*notify_batch_callback)(
+    int conn_id, const std::vector<btgatt_notify_params_t>& notifications);
+
 /** Reports result of a GATT read operation */
 typedef void (*read_characteristic_callback)(int conn_id, int status,
                 btgatt_read_params_t *p_data);
@@ -203,6 +210,7 @@ typedef struct {
     phy_updated_callback                phy_updated_cb;
     conn_updated_callback               conn_updated_cb;
     service_changed_callback            service_changed_cb;
+    notify_batch_callback               notify_batch_cb;
 } btgatt_client_callbacks_t;
 
 /** Represents the standard BT-GATT client interface. */
@@ -41,6 +41,15 @@ typedef union
     uint16_t            handle;
 } btgatt_response_t;
 
+/** One notification of a send_notifications batch */
+typedef struct
+{
+    int               conn_id;
+    int               attribute_handle;
+    const uint8_t*    value;
+    size_t            length;
+} btgatt_notification_t;
+
 /** BT-GATT Server callback structure. */
 
 /** Callback invoked in response to register_server */
@@ -176,6 +185,14 @@ typedef struct {
         base::Callback<void(uint8_t tx_phy, uint8_t rx_phy, uint8_t status)>
             cb);
 
+    /** Send a batch of notifications, possibly to different remote devices.
+     *  The values are copied before the call returns. Each notification is
+     *  confirmed through indication_sent_cb as when sent with
+     *  send_indication. */
+    bt_status_t (*send_notifications)(int server_if,
+                                      const btgatt_notification_t* notifications,
+                                      size_t count);
+
 } btgatt_server_interface_t;
 
 __END_DECLS
@@ -14,6 +14,10 @@
  * limitations under the License.
  */
 
+#include <map>
+#include <string>
+#include <vector>
+
 namespace bluetooth {
 namespace bluetooth_keystore {
 
@@ -27,6 +31,15 @@ class BluetoothKeystoreCallbacks {
 
   /** Callback for get key. */
   virtual std::string get_key(std::string prefix) = 0;
+
+  /** Callback for getting several keys at once. Implementations backed by
+   * IPC should override it to fetch them in one round trip. */
+  virtual std::map<std::string, std::string> get_keys(
+      const std::vector<std::string>& prefixes) {
+    std::map<std::string, std::string> keys;
+    for (const auto& prefix : prefixes) keys[prefix] = get_key(prefix);
+    return keys;
+  }
 };
 
 class BluetoothKeystoreInterface {
@@ -43,6 +56,9 @@ class BluetoothKeystoreInterface {
   /** Interface for get key. */
   virtual std::string get_key(std::string prefix) = 0;
 
+  /** Interface for fetching the keys of |prefixes| into the cache at once. */
+  virtual void prefetch_keys(const std::vector<std::string>& prefixes) = 0;
+
   /** Interface for clear map. */
   virtual void clear_map() = 0;
 };
@@ -114,6 +114,12 @@
 #define BTA_HH_LE_INCLUDED TRUE
 #endif
 
+/* The number of HID device control blocks in low memory mode,
+ * persist.vendor.btstack.hh_devices_size overrides it. */
+#ifndef BTA_HH_LOW_MEMORY_DEVICES
+#define BTA_HH_LOW_MEMORY_DEVICES 2
+#endif
+
 #ifndef BTA_AR_INCLUDED
 #define BTA_AR_INCLUDED TRUE
 #endif
@@ -379,6 +385,18 @@
 #define BTM_INQ_DB_SIZE 40
 #endif
 
+/* The default size of the BTM inquiry database in low memory mode,
+ * persist.vendor.btstack.inq_db_size overrides it. */
+#ifndef BTM_INQ_DB_LOW_MEMORY_SIZE
+#define BTM_INQ_DB_LOW_MEMORY_SIZE 8
+#endif
+
+/* The number of address hash buckets of the BTM inquiry database. Must be a
+ * power of two; keep it at least the size of the database. */
+#ifndef BTM_INQ_DB_HASH_SIZE
+#define BTM_INQ_DB_HASH_SIZE 64
+#endif
+
 /* The default scan mode */
 #ifndef BTM_DEFAULT_SCAN_TYPE
 #define BTM_DEFAULT_SCAN_TYPE BTM_SCAN_TYPE_INTERLACED
@@ -711,6 +729,15 @@
 #define L2CAP_MAX_RX_BUFFER 0x100000
 #endif
 
+/*
+ * Max bytes of received socket data to buffer locally for all the RFCOMM and
+ * L2CAP sockets of one app UID. Past it sockets of the UID stop the data flow
+ * from their peers until the app reads - default is 4MB
+ */
+#ifndef BTIF_SOCK_UID_RX_BUDGET
+#define BTIF_SOCK_UID_RX_BUDGET 0x400000
+#endif
+
 #ifndef L2CAP_NO_IDLE_TIMEOUT
 #define L2CAP_NO_IDLE_TIMEOUT 0xFFFF
 #endif
@@ -882,6 +909,12 @@
 #define SDP_MAX_ATTR_LEN 400
 #endif
 
+/* The number of distinct UUIDs the server database indexes. When the records
+ * hold more, service searches fall back to scanning every record. */
+#ifndef SDP_MAX_UUID_INDEX
+#define SDP_MAX_UUID_INDEX 128
+#endif
+
 /* The maximum number of attribute filters supported by SDP databases. */
 #ifndef SDP_MAX_ATTR_FILTERS
 #define SDP_MAX_ATTR_FILTERS 15
@@ -903,6 +936,29 @@
 #define SDP_MAX_LIST_BYTE_COUNT 4096
 #endif
 
+/* The number of serialized service search attribute responses the server
+ * keeps for replay to peers repeating the same request. */
+#ifndef SDP_RSP_CACHE_SIZE
+#define SDP_RSP_CACHE_SIZE 8
+#endif
+
+/* The maximum length, in bytes, of the raw UUID and attribute sequences used
+ * as the key of a cached response. Longer requests are not cached. */
+#ifndef SDP_RSP_CACHE_MAX_KEY_LEN
+#define SDP_RSP_CACHE_MAX_KEY_LEN 64
+#endif
+
+/* The number of remote service search attribute results kept by the SDP
+ * client, and how long, in milliseconds, each of them is reused for repeat
+ * discoveries of the same peer. */
+#ifndef SDP_REMOTE_CACHE_SIZE
+#define SDP_REMOTE_CACHE_SIZE 8
+#endif
+
+#ifndef SDP_REMOTE_CACHE_TTL_MS
+#define SDP_REMOTE_CACHE_TTL_MS 60000
+#endif
+
 /* The maximum number of parameters in an SDP protocol element. */
 #ifndef SDP_MAX_PROTOCOL_PARAMS
 #define SDP_MAX_PROTOCOL_PARAMS 2
@@ -996,6 +1052,24 @@
 #define PORT_TX_BUF_HIGH_WM 10
 #endif
 
+/* The largest rx credit window granted to a DLC whose app keeps up with the
+ * incoming data. The window starts at the MTU based value and grows from
+ * there, it is only used with data callbacks. */
+#ifndef PORT_CREDIT_RX_MAX
+#define PORT_CREDIT_RX_MAX (2 * PORT_RX_BUF_HIGH_WM)
+#endif
+
+/* The number of frames a DLC may send before the next DLC on the same
+ * multiplexer gets a turn when the link resumes. */
+#ifndef PORT_TX_BUF_PER_TURN
+#define PORT_TX_BUF_PER_TURN 2
+#endif
+
+/* The maximum number of transmit buffers filled by one call-out read. */
+#ifndef PORT_CO_MAX_IOV
+#define PORT_CO_MAX_IOV 8
+#endif
+
 /* The port transmit queue high watermark level, in number of buffers. */
 #ifndef PORT_TX_BUF_CRITICAL_WM
 #define PORT_TX_BUF_CRITICAL_WM 15
@@ -1378,6 +1452,13 @@
 #define HID_HOST_REPAGE_WIN (2)
 #endif
 
+/* Low latency mode of the interrupt channel: input reports of a connected
+ * device are written to uhid from the HID callback instead of being queued
+ * to BTA first, and the channel gets the high L2CAP transmit priority. */
+#ifndef HID_HOST_LOW_LATENCY
+#define HID_HOST_LOW_LATENCY TRUE
+#endif
+
 /*************************************************************************
  * A2DP Definitions
  */
@@ -1529,4 +1610,16 @@ incoming connection
 #define EATT_IF_SUPPORTED TRUE
 #endif
 
+/******************************************************************************
+ *
+ * Low memory mode
+ *
+ *****************************************************************************/
+/* Default of persist.vendor.btstack.low_memory, which sizes the control
+ * block pools allocated on profile enable from system properties rather than
+ * for the maximum, see osi/include/footprint.h */
+#ifndef BT_LOW_MEMORY_MODE
+#define BT_LOW_MEMORY_MODE FALSE
+#endif
+
 #endif /* BT_TARGET_H */
@@ -90,6 +90,26 @@ extern void btu_hci_msg_process(BT_HDR* p_msg);
  *  Static functions
  ******************************************************************************/
 
+/* LE advertising reports can arrive by the hundred per second while scanning,
+ * queue them behind connection and ACL traffic. Everything else keeps its
+ * order in the connection lane. */
+static tBTU_TASK_PRIO hci_msg_task_prio(const BT_HDR* p_msg) {
+  if ((p_msg->event & BT_EVT_MASK) != BT_EVT_TO_BTU_HCI_EVT || p_msg->len < 3)
+    return BTU_TASK_PRIO_CONN;
+
+  const uint8_t* p = (const uint8_t*)(p_msg + 1) + p_msg->offset;
+  if (p[0] != HCI_BLE_EVENT) return BTU_TASK_PRIO_CONN;
+
+  switch (p[2]) {
+    case HCI_BLE_ADV_PKT_RPT_EVT:
+    case HCI_BLE_DIRECT_ADV_EVT:
+    case HCI_LE_EXTENDED_ADVERTISING_REPORT_EVT:
+      return BTU_TASK_PRIO_BULK;
+    default:
+      return BTU_TASK_PRIO_CONN;
+  }
+}
+
 /******************************************************************************
  *
  * Function         post_to_hci_message_loop
@@ -108,8 +128,8 @@ void post_to_hci_message_loop(const base::Location& from_here,
     return;
   }
 
-  hci_message_loop->task_runner()->PostTask(
-      from_here, base::Bind(&btu_hci_msg_process, p_msg));
+  do_in_main_thread_prio(hci_msg_task_prio(p_msg), from_here,
+                         base::Bind(&btu_hci_msg_process, p_msg));
 }
 
 /******************************************************************************
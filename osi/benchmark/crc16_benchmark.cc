@@ -0,0 +1,66 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+
+// Compares the CRC-16 implementations used for the L2CAP FCS over typical
+// frame sizes, from S-frames up to large ERTM I-frames.
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "osi/include/crc16.h"
+
+using ::benchmark::State;
+
+static void run_crc16(State& state, crc16_update_fn impl) {
+  if (impl == NULL) {
+    state.SkipWithError("not supported on this CPU");
+    return;
+  }
+
+  std::vector<uint8_t> frame(state.range(0), 0x5a);
+  for (auto _ : state) {
+    ::benchmark::DoNotOptimize(impl(0, frame.data(), frame.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * frame.size());
+}
+
+static void BM_Crc16Bytewise(State& state) {
+  run_crc16(state, crc16_update_bytewise);
+}
+
+static void BM_Crc16Slice8(State& state) {
+  run_crc16(state, crc16_update_slice8);
+}
+
+static void BM_Crc16Clmul(State& state) {
+  run_crc16(state, crc16_get_clmul_impl());
+}
+
+BENCHMARK(BM_Crc16Bytewise)->RangeMultiplier(4)->Range(8, 4096);
+BENCHMARK(BM_Crc16Slice8)->RangeMultiplier(4)->Range(8, 4096);
+BENCHMARK(BM_Crc16Clmul)->RangeMultiplier(4)->Range(8, 4096);
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,191 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+// Times the libosi primitives the stack uses on every packet or bond lookup:
+//   config    - config_get_* in a config holding |range| device sections,
+//               laid out like bt_config.conf
+//   queue     - fixed_queue enqueue and dequeue of |range| items, both on a
+//               locked queue and on a single producer single consumer one
+//   alarm     - alarm_set then alarm_cancel of |range| alarms, far enough
+//               in the future that none of them fires
+// One iteration handles every item once and items are reported as a rate, so
+// the reported time per item can be compared across ranges.
+
+#include <benchmark/benchmark.h>
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "osi/include/alarm.h"
+#include "osi/include/config.h"
+#include "osi/include/fixed_queue.h"
+
+using ::benchmark::State;
+
+namespace {
+
+constexpr period_ms_t kAlarmIntervalMs = 60 * 60 * 1000;
+
+// The keys btif_config writes for a bonded device
+const char* const kDeviceKeys[] = {
+    "Name",      "DevClass", "DevType",      "AddrType", "LinkKeyType",
+    "PinLength", "Service",  "Manufacturer", "LmpVer",   "LmpSubVer",
+    "Timestamp"};
+
+std::string device_section(int index) {
+  char section[18];
+  snprintf(section, sizeof(section), "00:11:22:33:%02x:%02x",
+           (index >> 8) & 0xff, index & 0xff);
+  return section;
+}
+
+std::unique_ptr<config_t> make_config(int num_devices,
+                                      std::vector<std::string>* p_sections) {
+  std::unique_ptr<config_t> config = config_new_empty();
+  config_set_string(config.get(), "Adapter", "Address", "00:11:22:33:44:55");
+  for (int i = 0; i < num_devices; i++) {
+    std::string section = device_section(i);
+    for (const char* key : kDeviceKeys)
+      config_set_string(config.get(), section, key, "1");
+    config_set_string(config.get(), section, "LinkKey",
+                      "00112233445566778899aabbccddeeff");
+    p_sections->push_back(section);
+  }
+  return config;
+}
+
+void BM_ConfigGetInt(State& state) {
+  std::vector<std::string> sections;
+  std::unique_ptr<config_t> config = make_config(state.range(0), &sections);
+  const std::string key = "DevType";
+  for (auto _ : state) {
+    for (const std::string& section : sections)
+      benchmark::DoNotOptimize(config_get_int(*config, section, key, 0));
+  }
+  state.SetItemsProcessed(state.iterations() * sections.size());
+}
+
+void BM_ConfigGetString(State& state) {
+  std::vector<std::string> sections;
+  std::unique_ptr<config_t> config = make_config(state.range(0), &sections);
+  const std::string key = "LinkKey";
+  for (auto _ : state) {
+    for (const std::string& section : sections)
+      benchmark::DoNotOptimize(
+          config_get_string(*config, section, key, nullptr));
+  }
+  state.SetItemsProcessed(state.iterations() * sections.size());
+}
+
+void BM_ConfigGetBool(State& state) {
+  std::vector<std::string> sections;
+  std::unique_ptr<config_t> config = make_config(state.range(0), &sections);
+  const std::string key = "Timestamp";
+  for (auto _ : state) {
+    for (const std::string& section : sections)
+      benchmark::DoNotOptimize(config_get_bool(*config, section, key, false));
+  }
+  state.SetItemsProcessed(state.iterations() * sections.size());
+}
+
+// A lookup of a device that is not bonded, as done for every new peer
+void BM_ConfigGetMissing(State& state) {
+  std::vector<std::string> sections;
+  std::unique_ptr<config_t> config = make_config(state.range(0), &sections);
+  const std::string section = device_section(0xffff);
+  const std::string key = "LinkKey";
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(config_get_string(*config, section, key, nullptr));
+  }
+}
+
+void run_fixed_queue(State& state, fixed_queue_t* queue) {
+  size_t count = state.range(0);
+  int item;
+  for (auto _ : state) {
+    for (size_t i = 0; i < count; i++) fixed_queue_enqueue(queue, &item);
+    for (size_t i = 0; i < count; i++)
+      benchmark::DoNotOptimize(fixed_queue_try_dequeue(queue));
+  }
+  fixed_queue_free(queue, nullptr);
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+void BM_FixedQueue(State& state) {
+  run_fixed_queue(state, fixed_queue_new(SIZE_MAX));
+}
+
+void BM_FixedQueueSpsc(State& state) {
+  run_fixed_queue(state, fixed_queue_new_spsc(state.range(0)));
+}
+
+void alarm_cb(void* data) {}
+
+void BM_AlarmSetCancel(State& state) {
+  std::vector<alarm_t*> alarms;
+  for (int i = 0; i < state.range(0); i++)
+    alarms.push_back(alarm_new("benchmark.alarm"));
+
+  for (auto _ : state) {
+    for (alarm_t* alarm : alarms)
+      alarm_set(alarm, kAlarmIntervalMs, alarm_cb, nullptr);
+    for (alarm_t* alarm : alarms) alarm_cancel(alarm);
+  }
+
+  for (alarm_t* alarm : alarms) alarm_free(alarm);
+  state.SetItemsProcessed(state.iterations() * alarms.size());
+}
+
+// Rearming an alarm that is already set, as the L2CAP and GATT idle timers
+// are on every packet
+void BM_AlarmReset(State& state) {
+  std::vector<alarm_t*> alarms;
+  for (int i = 0; i < state.range(0); i++) {
+    alarms.push_back(alarm_new("benchmark.alarm"));
+    alarm_set(alarms.back(), kAlarmIntervalMs, alarm_cb, nullptr);
+  }
+
+  for (auto _ : state) {
+    for (alarm_t* alarm : alarms)
+      alarm_set(alarm, kAlarmIntervalMs, alarm_cb, nullptr);
+  }
+
+  for (alarm_t* alarm : alarms) alarm_free(alarm);
+  state.SetItemsProcessed(state.iterations() * alarms.size());
+}
+
+}  // namespace
+
+BENCHMARK(BM_ConfigGetInt)->Arg(1)->Arg(16)->Arg(128);
+BENCHMARK(BM_ConfigGetString)->Arg(1)->Arg(16)->Arg(128);
+BENCHMARK(BM_ConfigGetBool)->Arg(1)->Arg(16)->Arg(128);
+BENCHMARK(BM_ConfigGetMissing)->Arg(1)->Arg(16)->Arg(128);
+BENCHMARK(BM_FixedQueue)->Arg(1)->Arg(64)->Arg(1024);
+BENCHMARK(BM_FixedQueueSpsc)->Arg(1)->Arg(64)->Arg(1024);
+BENCHMARK(BM_AlarmSetCancel)->Arg(1)->Arg(64)->Arg(1024);
+BENCHMARK(BM_AlarmReset)->Arg(1)->Arg(64)->Arg(1024);
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+  alarm_cleanup();
+}
@@ -78,6 +78,15 @@ void* alarm_free(alarm_t* alarm);
 void alarm_set(alarm_t* alarm, period_ms_t interval_ms, alarm_callback_t cb,
                void* data);
 
+// Sets an |alarm| like |alarm_set|, but allows the callback to be called up
+// to |slack_ms| milliseconds after |interval_ms| has elapsed. The alarm engine
+// uses that window to fire the alarm together with other alarms and avoid a
+// separate wakeup. Use it for timers that do not need precise timing. A
+// |slack_ms| of zero is equivalent to |alarm_set|.
+void alarm_set_with_slack(alarm_t* alarm, period_ms_t interval_ms,
+                          period_ms_t slack_ms, alarm_callback_t cb,
+                          void* data);
+
 // Sets an |alarm| to execute a callback in the main message loop. This function
 // is same as |alarm_set| except that the |cb| callback is scheduled for
 // execution in the context of the main message loop.
@@ -104,6 +113,13 @@ bool alarm_is_scheduled(const alarm_t* alarm);
 // TODO: Remove this function once PM timers can be re-factored
 period_ms_t alarm_get_remaining_ms(const alarm_t* alarm);
 
+// Selects the backend used to keep pending alarms: a hierarchical timing
+// wheel if |enabled| is true, or the sorted alarm list otherwise. The choice
+// takes effect the next time the alarm module initializes, i.e. before the
+// first alarm is created or after |alarm_cleanup|. Without a call to this
+// function the "persist.vendor.bt.alarm.timing_wheel" property decides.
+void alarm_set_timing_wheel(bool enabled);
+
 // Cleanup the alarm internal state.
 // This function should be called by the OSI module cleanup during
 // graceful shutdown.
@@ -57,3 +57,22 @@ void* allocation_tracker_notify_free(allocator_id_t allocator_id, void* ptr);
 // Get the full size for an allocation, taking into account the size of
 // canaries.
 size_t allocation_tracker_resize_for_canary(size_t size);
+
+// Enables sampling of allocation statistics for one in every |rate|
+// allocations on each thread. Sampled allocations are attributed to their
+// allocator, thread, size bucket and call site and reported by
+// |osi_allocator_debug_dump|. Sampling works whether or not the tracker has
+// been initialized and does not record individual allocations. A |rate| of
+// zero disables sampling, which is the default.
+void allocation_tracker_set_sampling_rate(uint32_t rate);
+
+// Notify the sampler of an allocation of |requested_size| bytes belonging to
+// |allocator_id| and made from |caller|, typically the return address of the
+// allocation function. Does nothing unless sampling is enabled.
+void allocation_tracker_sample_alloc(allocator_id_t allocator_id,
+                                     size_t requested_size, const void* caller);
+
+// Stores the number of sampled allocations and sampled bytes recorded for
+// |allocator_id| in |count| and |bytes|. Neither may be NULL.
+void allocation_tracker_get_sampled(allocator_id_t allocator_id, size_t* count,
+                                    size_t* bytes);
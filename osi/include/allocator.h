@@ -47,6 +47,12 @@ void osi_free(void* ptr);
 // |p_ptr| cannot be NULL.
 void osi_free_and_reset(void** p_ptr);
 
+// Stores the number of allocations made through the functions above, and
+// the octets they requested, in |count| and |bytes|. Only sampled
+// allocations are counted, see |allocation_tracker_set_sampling_rate|; with a
+// rate of 1 every allocation is. Neither |count| nor |bytes| may be NULL.
+void osi_allocator_get_sampled(size_t* count, size_t* bytes);
+
 // Dump allocation-related statistics and debug info to the |fd| file
 // descriptor.
 // The information is in user-readable text format. The |fd| must be valid.
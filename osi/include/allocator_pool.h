@@ -0,0 +1,72 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Optional size-class slab pool that sits behind |osi_malloc|, |osi_calloc|
+// and |osi_free|. Until |allocator_pool_init| is called every allocation goes
+// straight to the system allocator. Once enabled, requests whose real size
+// (including allocation tracker canaries) falls in a configured class are
+// served from a preallocated arena through a per-thread cache, falling back
+// to the system allocator when the class is exhausted.
+
+#define ALLOCATOR_POOL_MAX_CLASSES 4
+
+typedef struct {
+  size_t block_size;   // Usable bytes per block.
+  size_t block_count;  // Number of blocks preallocated for this class.
+} allocator_pool_class_t;
+
+typedef struct {
+  size_t block_size;
+  size_t block_count;
+  size_t in_use;      // Blocks currently handed out.
+  size_t high_water;  // Maximum of |in_use| since init.
+  size_t hits;        // Allocations served by the pool.
+  size_t misses;      // Allocations that fit the class but fell back.
+} allocator_pool_stats_t;
+
+// Enables the pool with |num_classes| size classes described by |classes|,
+// which must be sorted by increasing |block_size|. Requests smaller than
+// |min_size| bytes are never pooled. The pool can only be initialized once;
+// subsequent calls return false and leave the existing pool untouched.
+bool allocator_pool_init(const allocator_pool_class_t* classes,
+                         size_t num_classes, size_t min_size);
+
+// Returns true if |allocator_pool_init| has completed.
+bool allocator_pool_is_enabled(void);
+
+// Returns a block of at least |size| bytes from the pool, or NULL if the pool
+// is disabled, no class fits |size|, or the fitting class is exhausted.
+void* allocator_pool_alloc(size_t size);
+
+// Returns |ptr| to the pool if it was handed out by |allocator_pool_alloc|.
+// Returns false, without touching |ptr|, if it does not belong to the pool.
+bool allocator_pool_free(void* ptr);
+
+// Copies per-class statistics into |stats|, which must have room for
+// |max_classes| entries. Returns the number of entries written.
+size_t allocator_pool_get_stats(allocator_pool_stats_t* stats,
+                                size_t max_classes);
+
+// Dumps per-class pool statistics to the |fd| file descriptor.
+void allocator_pool_debug_dump(int fd);
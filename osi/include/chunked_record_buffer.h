@@ -0,0 +1,95 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <memory>
+#include <string>
+
+namespace system_bt_osi {
+
+/*
+ *   ChunkedRecordBuffer
+ *
+ * - Keeps already serialized records, e.g. protobuf fields, in fixed size
+ *   chunks. A record never spans two chunks; one larger than a chunk gets a
+ *   chunk of its own.
+ * - Beyond MAX_RECORDS records or MAX_BYTES bytes the oldest records are
+ *   dropped, so memory stays bounded however long the buffer is filled.
+ *   Emptied chunks are reused.
+ * - The records are read back by concatenating them in order, without
+ *   touching their content.
+ * - The buffer is not thread-safe.
+ *
+ */
+class ChunkedRecordBuffer {
+ public:
+  ChunkedRecordBuffer(size_t chunk_size, size_t max_bytes, size_t max_records);
+
+  /*
+   * Appends RECORD, dropping the oldest records if it doesn't fit the limits.
+   * A record larger than MAX_BYTES is dropped right away. Returns the number
+   * of records dropped.
+   */
+  size_t Append(const std::string& record);
+
+  /*
+   * Appends all records, oldest first, to OUT
+   */
+  void AppendTo(std::string* out) const;
+
+  /*
+   * Returns the number of records
+   */
+  size_t Size() const { return record_sizes_.size(); }
+
+  /*
+   * Returns the number of bytes in the records
+   */
+  size_t Bytes() const { return bytes_; }
+
+  /*
+   * Drops all records
+   */
+  void Clear();
+
+ private:
+  struct Chunk {
+    std::unique_ptr<uint8_t[]> data;
+    size_t capacity;
+    size_t begin;  // First byte of the oldest record in the chunk
+    size_t end;    // End of the newest record in the chunk
+  };
+
+  void DropOldest();
+  Chunk NewChunk(size_t capacity);
+
+  const size_t chunk_size_;
+  const size_t max_bytes_;
+  const size_t max_records_;
+  std::deque<Chunk> chunks_;
+  std::deque<uint32_t> record_sizes_;
+  size_t bytes_;
+  // Emptied chunk kept for reuse
+  Chunk spare_;
+};
+
+}  // namespace system_bt_osi
@@ -26,9 +26,12 @@
 // - All strings are case sensitive.
 
 #include <stdbool.h>
+#include <iterator>
 #include <list>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
 
 // The default section name to use if a key/value pair is not defined within
 // a section.
@@ -37,22 +40,147 @@
 //typedef struct config_t config_t;
 typedef struct config_section_node_t config_section_node_t;
 
+// A std::list which also indexes its elements by their |Key| member, so that
+// Find() does not scan the list. Iteration follows the insertion order. Short
+// lists, below |kIndexThreshold| elements, are scanned instead of indexed.
+// The key of an element must not be changed while it is in the list, unless
+// Reindex() is called afterwards; the other members may be changed freely.
+// Like std::list, the iterators stay valid until their element is erased.
+template <typename T, std::string T::*Key>
+class IndexedList {
+ public:
+  using iterator = typename std::list<T>::iterator;
+  using const_iterator = typename std::list<T>::const_iterator;
+
+  static constexpr size_t kIndexThreshold = 16;
+
+  IndexedList() = default;
+  IndexedList(const IndexedList& other) : list_(other.list_) { Reindex(); }
+  IndexedList(IndexedList&& other) = default;
+  IndexedList& operator=(const IndexedList& other) {
+    if (this != &other) {
+      list_ = other.list_;
+      Reindex();
+    }
+    return *this;
+  }
+  IndexedList& operator=(IndexedList&& other) = default;
+
+  iterator begin() { return list_.begin(); }
+  iterator end() { return list_.end(); }
+  const_iterator begin() const { return list_.begin(); }
+  const_iterator end() const { return list_.end(); }
+  size_t size() const { return list_.size(); }
+  bool empty() const { return list_.empty(); }
+  const std::list<T>& list() const { return list_; }
+
+  void clear() {
+    list_.clear();
+    index_.clear();
+    has_duplicates_ = false;
+  }
+
+  template <typename... Args>
+  T& emplace_back(Args&&... args) {
+    list_.emplace_back(std::forward<Args>(args)...);
+    iterator it = std::prev(list_.end());
+    if (!index_.empty() || list_.size() >= kIndexThreshold) {
+      if (index_.empty()) {
+        Reindex();
+      } else if (!index_.emplace((*it).*Key, it).second) {
+        // The first element of a key stays the one found
+        has_duplicates_ = true;
+      }
+    }
+    return *it;
+  }
+
+  iterator erase(const_iterator it) {
+    bool reindex = false;
+    if (!index_.empty()) {
+      auto found = index_.find((*it).*Key);
+      if (found != index_.end() && found->second == it) {
+        index_.erase(found);
+        reindex = has_duplicates_;
+      } else if (found == index_.end() || !has_duplicates_) {
+        // The key was changed in place, e.g. the element was moved from
+        reindex = true;
+      }
+    }
+    iterator next = list_.erase(it);
+    if (reindex) Reindex();
+    return next;
+  }
+
+  // Removes the element at |it| and returns it.
+  T Take(iterator it) {
+    std::string key = (*it).*Key;
+    T value = std::move(*it);
+    (*it).*Key = std::move(key);
+    erase(it);
+    return value;
+  }
+
+  iterator Find(const std::string& key) {
+    if (index_.empty()) return Scan<iterator>(list_, key);
+    auto found = index_.find(key);
+    return found != index_.end() ? found->second : list_.end();
+  }
+
+  const_iterator Find(const std::string& key) const {
+    if (index_.empty()) return Scan<const_iterator>(list_, key);
+    auto found = index_.find(key);
+    return found != index_.end() ? const_iterator(found->second) : list_.end();
+  }
+
+  // Sizes the index for |count| elements, when the list is expected to grow
+  // that large. Nothing is allocated for lists which stay short.
+  void reserve(size_t count) {
+    if (count >= kIndexThreshold) index_.reserve(count);
+  }
+
+  // Rebuilds the index, after the key of an element was changed in place.
+  void Reindex() {
+    index_.clear();
+    has_duplicates_ = false;
+    if (list_.size() < kIndexThreshold) return;
+    index_.reserve(list_.size());
+    for (iterator it = list_.begin(); it != list_.end(); ++it) {
+      if (!index_.emplace((*it).*Key, it).second) has_duplicates_ = true;
+    }
+  }
+
+ private:
+  template <typename Iterator, typename List>
+  static Iterator Scan(List& list, const std::string& key) {
+    for (Iterator it = list.begin(); it != list.end(); ++it) {
+      if ((*it).*Key == key) return it;
+    }
+    return list.end();
+  }
+
+  std::list<T> list_;
+  std::unordered_map<std::string, iterator> index_;
+  bool has_duplicates_ = false;
+};
+
 typedef struct {
   std::string key;
   std::string value;
 } entry_t;
 
-typedef struct {
+typedef struct section_t {
   std::string name;
-  std::list<entry_t> entries;
+  IndexedList<entry_t, &entry_t::key> entries;
   void Set(std::string key, std::string value);
-  std::list<entry_t>::iterator Find(const std::string& key);
+  IndexedList<entry_t, &entry_t::key>::iterator Find(const std::string& key);
   bool Has(const std::string& key);
 } section_t;
 
 struct config_t {
-  std::list<section_t> sections;
-  std::list<section_t>::iterator Find(const std::string& section);
+  IndexedList<section_t, &section_t::name> sections;
+  IndexedList<section_t, &section_t::name>::iterator Find(
+      const std::string& section);
   bool Has(const std::string& section);
 };
 
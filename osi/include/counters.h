@@ -0,0 +1,108 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Registry of performance counters shared by the whole stack. A module
+// registers its counters, gauges and histograms once by name and updates them
+// from any thread without taking a lock. Counter updates go to a per CPU
+// shard so concurrent writers don't bounce a cache line between cores; the
+// shards are summed when the counter is read.
+//
+// Registered metrics are never freed, so the returned pointers stay valid for
+// the lifetime of the process. At most |COUNTERS_MAX| metrics can be
+// registered; beyond that, or when a name is registered again with another
+// type, registration returns NULL. Every update function ignores a NULL
+// metric, so callers don't need to check.
+
+#define COUNTERS_MAX 128
+
+// Histogram buckets are log-linear: every power of two is split into four
+// buckets, so a bucket is at most 25% wider than its lower bound. Values up to
+// 3 have a bucket of their own, values of 2^32 and above share the last one.
+#define COUNTERS_HISTOGRAM_BUCKETS 124
+
+typedef enum {
+  COUNTERS_TYPE_COUNTER = 0,  // Monotonic count, e.g. packets dropped.
+  COUNTERS_TYPE_GAUGE,        // Current value, e.g. queue length.
+  COUNTERS_TYPE_HISTOGRAM,    // Distribution, e.g. latency in us.
+} counters_type_t;
+
+typedef struct counters_metric_t counters_metric_t;
+
+typedef struct {
+  uint64_t count;
+  uint64_t sum;
+  uint64_t max;
+  uint32_t buckets[COUNTERS_HISTOGRAM_BUCKETS];
+} counters_histogram_t;
+
+// Registers the metric |name| of |module|, or returns the one registered
+// before under the same names. |module| and |name| must be string literals or
+// otherwise outlive the process. |unit| of a histogram is only used to label
+// the dump, e.g. "us".
+counters_metric_t* counters_register_counter(const char* module,
+                                             const char* name);
+counters_metric_t* counters_register_gauge(const char* module,
+                                           const char* name);
+counters_metric_t* counters_register_histogram(const char* module,
+                                               const char* name,
+                                               const char* unit);
+
+// Adds |delta| to |counter|.
+void counters_add(counters_metric_t* counter, uint64_t delta);
+
+inline void counters_increment(counters_metric_t* counter) {
+  counters_add(counter, 1);
+}
+
+// Sets |gauge| to |value|, or adds |delta| to it.
+void counters_gauge_set(counters_metric_t* gauge, int64_t value);
+void counters_gauge_add(counters_metric_t* gauge, int64_t delta);
+
+// Adds a sample of |value| to |histogram|.
+void counters_histogram_record(counters_metric_t* histogram, uint64_t value);
+
+// Returns the value of a counter or gauge, 0 for NULL or a histogram.
+int64_t counters_get_value(const counters_metric_t* metric);
+
+// Copies the samples of |histogram| to |out|. Returns false if |histogram| is
+// NULL or not a histogram.
+bool counters_get_histogram(const counters_metric_t* histogram,
+                            counters_histogram_t* out);
+
+// Returns the lower bound of histogram bucket |bucket|.
+uint64_t counters_bucket_lower_bound(size_t bucket);
+
+// Returns the upper bound of the bucket holding the |percent| percentile of
+// |histogram|, 0 if it is empty.
+uint64_t counters_histogram_percentile(const counters_histogram_t* histogram,
+                                       unsigned percent);
+
+// Resets the values of all metrics. Registrations are kept.
+void counters_clear(void);
+
+// Dumps all metrics to |fd|, in registration order.
+void counters_debug_dump(int fd);
+
+// Logs a snapshot of all metrics through the BluetoothMetricsLogger.
+void counters_export_metrics(void);
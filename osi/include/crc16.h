@@ -0,0 +1,48 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// CRC-16 with the polynomial x^16 + x^15 + x^2 + 1 in bit-reflected form, as
+// used for the L2CAP frame check sequence. Each implementation computes the
+// same value; |crc16_update| picks the fastest one the CPU supports.
+
+typedef uint16_t (*crc16_update_fn)(uint16_t crc, const uint8_t* data,
+                                    size_t length);
+
+// Returns |crc| updated with the |length| bytes at |data|. Pass the initial
+// value to start a new CRC. |data| may be NULL only if |length| is zero.
+uint16_t crc16_update(uint16_t crc, const uint8_t* data, size_t length);
+
+// Reference implementation using one table lookup per byte.
+uint16_t crc16_update_bytewise(uint16_t crc, const uint8_t* data,
+                               size_t length);
+
+// Slicing-by-8 implementation using eight table lookups per 8 bytes.
+uint16_t crc16_update_slice8(uint16_t crc, const uint8_t* data, size_t length);
+
+// Returns the carry-less multiply implementation (PMULL on ARMv8, PCLMULQDQ on
+// x86-64), or NULL if this build or CPU does not support one.
+crc16_update_fn crc16_get_clmul_impl(void);
+
+// Returns the name of the implementation used by |crc16_update|.
+const char* crc16_get_impl_name(void);
@@ -0,0 +1,83 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "osi/include/thread.h"
+#include "osi/include/time.h"
+
+// Helpers to take the state shown by a debug dump on the thread that owns it.
+// The dump only holds the owning thread for as long as it takes to copy the
+// state into a snapshot; formatting the snapshot and writing it to the dump
+// file descriptor happen on the calling thread.
+
+// Default time to wait for the owning thread to take a snapshot. A thread
+// that is stuck longer shouldn't stall the whole dump.
+#define DEBUG_SNAPSHOT_TIMEOUT_MS 500
+
+// Posts a task to the thread that owns the state, returns false if it
+// couldn't be posted.
+typedef std::function<bool(const std::function<void()>& task)>
+    debug_snapshot_poster_t;
+
+// Runs |task| through |post| and waits up to |timeout_ms| for it to finish.
+// Returns true if it did. On a timeout |task| may still run later, so it must
+// only touch state it owns, see |debug_snapshot_take|.
+bool debug_snapshot_run(const debug_snapshot_poster_t& post,
+                        const std::function<void()>& task,
+                        period_ms_t timeout_ms);
+
+// Runs |task| on |thread| like |debug_snapshot_run|. |task| runs inline if
+// |thread| is NULL or the calling thread.
+bool debug_snapshot_run_on_thread(thread_t* thread,
+                                  const std::function<void()>& task,
+                                  period_ms_t timeout_ms);
+
+// Returns a snapshot filled in by |fill| on |thread|, or NULL if |thread|
+// didn't get to it within |timeout_ms|. A snapshot filled in late is freed
+// when |fill| returns.
+template <typename T>
+std::shared_ptr<T> debug_snapshot_take(
+    thread_t* thread, const std::function<void(T* snapshot)>& fill,
+    period_ms_t timeout_ms = DEBUG_SNAPSHOT_TIMEOUT_MS) {
+  std::shared_ptr<T> snapshot = std::make_shared<T>();
+  std::function<void(T*)> fill_copy = fill;
+  if (!debug_snapshot_run_on_thread(
+          thread, [snapshot, fill_copy] { fill_copy(snapshot.get()); },
+          timeout_ms))
+    return nullptr;
+  return snapshot;
+}
+
+// Same as above, for state owned by a thread that is reached through |post|,
+// e.g. a message loop.
+template <typename T>
+std::shared_ptr<T> debug_snapshot_take_posted(
+    const debug_snapshot_poster_t& post,
+    const std::function<void(T* snapshot)>& fill,
+    period_ms_t timeout_ms = DEBUG_SNAPSHOT_TIMEOUT_MS) {
+  std::shared_ptr<T> snapshot = std::make_shared<T>();
+  std::function<void(T*)> fill_copy = fill;
+  if (!debug_snapshot_run(
+          post, [snapshot, fill_copy] { fill_copy(snapshot.get()); },
+          timeout_ms))
+    return nullptr;
+  return snapshot;
+}
@@ -36,6 +36,17 @@ typedef void (*fixed_queue_cb)(fixed_queue_t* queue, void* context);
 // the returned queue with |fixed_queue_free|.
 fixed_queue_t* fixed_queue_new(size_t capacity);
 
+// Creates a new single-producer/single-consumer fixed queue with the given
+// |capacity|, which must be non-zero and bounded. The queue is backed by a
+// lock-free ring buffer: enqueue and dequeue only touch the eventfds exposed
+// through |fixed_queue_get_enqueue_fd| and |fixed_queue_get_dequeue_fd| when
+// the queue transitions between empty, non-empty and full. At most one thread
+// may enqueue and at most one thread may dequeue, flush or peek the first
+// element at any time. |fixed_queue_try_remove_from_queue| and
+// |fixed_queue_get_list| are not supported on such queues. Returns NULL on
+// failure. The caller must free the returned queue with |fixed_queue_free|.
+fixed_queue_t* fixed_queue_new_spsc(size_t capacity);
+
 // Frees a queue and (optionally) the enqueued elements.
 // |queue| is the queue to free. If the |free_cb| callback is not null,
 // it is called on each queue element to free it.
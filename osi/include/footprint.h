@@ -0,0 +1,62 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Memory footprint of the control blocks of the stack. Modules report the
+// bytes each of their pools keeps resident, both the static control blocks
+// and the pools allocated when a profile is enabled, and the report is part
+// of dumpsys.
+//
+// In low memory mode, for devices that only run a few profiles, the pools
+// allocated on enable are sized from the system properties
+// persist.vendor.btstack.<pool>_size, with small defaults. The mode is
+// selected by persist.vendor.btstack.low_memory, which defaults to the
+// BT_LOW_MEMORY_MODE build flag.
+
+// At most |FOOTPRINT_MAX| pools can be reported; further ones are dropped.
+#define FOOTPRINT_MAX 64
+
+// Returns true in low memory mode. The mode is read once, so that pools are
+// sized the same way for the lifetime of the process.
+bool footprint_low_memory_mode(void);
+
+// Returns the number of entries to allocate for |pool|, which holds at most
+// |max_entries|. Outside of low memory mode this is |max_entries|. In low
+// memory mode it is the value of persist.vendor.btstack.<pool>_size, or
+// |low_memory_entries| if it isn't set, clamped to [1, |max_entries|].
+size_t footprint_pool_entries(const char* pool, size_t max_entries,
+                              size_t low_memory_entries);
+
+// Sets the resident size of |pool| of |module| to |bytes|, 0 once it is
+// freed. |module| and |pool| must be string literals or otherwise outlive the
+// process.
+void footprint_set(const char* module, const char* pool, size_t bytes);
+
+// Returns the resident size of |pool| of |module|, or of all pools of
+// |module| if |pool| is NULL.
+size_t footprint_get(const char* module, const char* pool);
+
+// Forgets every reported pool.
+void footprint_clear(void);
+
+// Dumps the resident size of every module and its pools to |fd|.
+void footprint_debug_dump(int fd);
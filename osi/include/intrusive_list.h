@@ -0,0 +1,198 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+
+#include <iterator>
+
+namespace system_bt_osi {
+
+/*
+ *   IntrusiveListHook<T>
+ *
+ * - Links of a T in an IntrusiveList. Embed one in T for every list T can be
+ *   on at the same time and treat its fields as private.
+ * - A zero-initialized hook is not on any list, so objects from osi_calloc or
+ *   memset can be linked without further initialization.
+ * - Copying an object copies its links too. Code copying whole objects that
+ *   are on a list must keep the links of the destination.
+ */
+template <class T>
+struct IntrusiveListHook {
+  T* prev;
+  T* next;
+};
+
+/*
+ *   IntrusiveList<T, Hook>
+ *
+ * - IntrusiveList<T, &T::hook> is a doubly linked list of T threaded through
+ *   the IntrusiveListHook<T> member |hook|. Unlike list_t it never allocates:
+ *   linking and unlinking only update the hooks, and all of them are O(1),
+ *   including Remove and Contains.
+ * - The list does not own its elements. Removing an element, or destroying
+ *   the list, leaves the element alive; freeing it is up to the caller.
+ * - An element is on at most one list per hook. Contains assumes it is either
+ *   on this list or on none.
+ * - A zero-initialized list is a valid empty list, so it can live in control
+ *   blocks that are cleared with memset.
+ * - Iterators are invalidated by removing the element they point to. To
+ *   remove while walking, take Next() of an element before removing it.
+ * - The list is not thread-safe.
+ *
+ */
+template <class T, IntrusiveListHook<T> T::*Hook>
+class IntrusiveList {
+ public:
+  class iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using pointer = T*;
+    using reference = T&;
+
+    explicit iterator(T* elem) : elem_(elem) {}
+
+    T& operator*() const { return *elem_; }
+    T* operator->() const { return elem_; }
+    iterator& operator++() {
+      elem_ = (elem_->*Hook).next;
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator it = *this;
+      ++*this;
+      return it;
+    }
+    bool operator==(const iterator& other) const {
+      return elem_ == other.elem_;
+    }
+    bool operator!=(const iterator& other) const {
+      return elem_ != other.elem_;
+    }
+
+   private:
+    T* elem_;
+  };
+
+  constexpr IntrusiveList() : head_(nullptr), tail_(nullptr), size_(0) {}
+  IntrusiveList(const IntrusiveList&) = delete;
+  IntrusiveList& operator=(const IntrusiveList&) = delete;
+
+  bool Empty() const { return head_ == nullptr; }
+  size_t Size() const { return size_; }
+
+  T* Front() const { return head_; }
+  T* Back() const { return tail_; }
+
+  // Returns the element after |elem|, nullptr if |elem| is the last one.
+  static T* Next(const T* elem) { return (elem->*Hook).next; }
+
+  // Returns the element before |elem|, nullptr if |elem| is the first one.
+  static T* Prev(const T* elem) { return (elem->*Hook).prev; }
+
+  bool Contains(const T* elem) const {
+    const IntrusiveListHook<T>& hook = elem->*Hook;
+    return hook.prev != nullptr || hook.next != nullptr || head_ == elem;
+  }
+
+  void PushFront(T* elem) { InsertBetween(elem, nullptr, head_); }
+  void PushBack(T* elem) { InsertBetween(elem, tail_, nullptr); }
+
+  // Inserts |elem| right after |pos|, which must be on this list.
+  void InsertAfter(T* pos, T* elem) {
+    InsertBetween(elem, pos, (pos->*Hook).next);
+  }
+
+  // Inserts |elem| right before |pos|, which must be on this list.
+  void InsertBefore(T* pos, T* elem) {
+    InsertBetween(elem, (pos->*Hook).prev, pos);
+  }
+
+  // Unlinks |elem| if it is on the list. Returns true if it was.
+  bool Remove(T* elem) {
+    if (!Contains(elem)) return false;
+
+    IntrusiveListHook<T>& hook = elem->*Hook;
+    if (hook.prev != nullptr) {
+      (hook.prev->*Hook).next = hook.next;
+    } else {
+      head_ = hook.next;
+    }
+    if (hook.next != nullptr) {
+      (hook.next->*Hook).prev = hook.prev;
+    } else {
+      tail_ = hook.prev;
+    }
+    hook.prev = nullptr;
+    hook.next = nullptr;
+    size_--;
+    return true;
+  }
+
+  // Unlinks and returns the first element, nullptr if the list is empty.
+  T* PopFront() {
+    T* elem = head_;
+    if (elem != nullptr) Remove(elem);
+    return elem;
+  }
+
+  // Unlinks every element, leaving them alive.
+  void Clear() {
+    while (head_ != nullptr) PopFront();
+  }
+
+  // Returns the first element for which |pred| returns true, or nullptr.
+  template <class Pred>
+  T* Find(Pred pred) const {
+    for (T* elem = head_; elem != nullptr; elem = (elem->*Hook).next) {
+      if (pred(elem)) return elem;
+    }
+    return nullptr;
+  }
+
+  iterator begin() const { return iterator(head_); }
+  iterator end() const { return iterator(nullptr); }
+
+ private:
+  void InsertBetween(T* elem, T* prev, T* next) {
+    IntrusiveListHook<T>& hook = elem->*Hook;
+    hook.prev = prev;
+    hook.next = next;
+    if (prev != nullptr) {
+      (prev->*Hook).next = elem;
+    } else {
+      head_ = elem;
+    }
+    if (next != nullptr) {
+      (next->*Hook).prev = elem;
+    } else {
+      tail_ = elem;
+    }
+    size_++;
+  }
+
+  T* head_;
+  T* tail_;
+  size_t size_;
+};
+
+}  // namespace system_bt_osi
@@ -106,6 +106,66 @@ class A2dpSessionMetrics {
   int32_t buffer_underruns_count = -1;
 };
 
+/* Timing of an LE pairing, see SmpPairingEvent in bluetooth.proto. Times are
+ * in milliseconds.
+ * NOTE: Negative values are invalid and left out of the log
+ */
+struct SmpPairingMetrics {
+  int32_t status = -1;
+  bool secure_connections = false;
+  int32_t association_model = -1;
+  int32_t feature_exchange_ms = -1;
+  int32_t public_key_exchange_ms = -1;
+  int32_t dhkey_computation_ms = -1;
+  int32_t authentication_ms = -1;
+  int32_t authentication_round_trips = -1;
+  int32_t dhkey_check_ms = -1;
+  int32_t encryption_ms = -1;
+  int32_t key_distribution_ms = -1;
+  int32_t total_ms = -1;
+};
+
+/* Link quality of a period, see LinkQualityEvent in bluetooth.proto.
+ * NOTE: Negative values are invalid and left out of the log
+ */
+struct LinkQualityMetrics {
+  int64_t duration_ms = -1;
+  int32_t codec_index = -1;
+  int32_t report_count = -1;
+  int32_t approach_lsto_count = -1;
+  int32_t a2dp_choppy_count = -1;
+  int32_t sco_choppy_count = -1;
+  // RSSI is negative, so these are only valid if |report_count| is positive
+  int32_t rssi_average = 0;
+  int32_t rssi_min = 0;
+  int32_t rssi_max = 0;
+  int32_t snr_average = -1;
+  int32_t snr_min = -1;
+  int64_t retransmission_count = -1;
+  int64_t no_rx_count = -1;
+  int64_t nak_count = -1;
+  int64_t flow_off_count = -1;
+  int64_t buffer_overflow_bytes = -1;
+  int64_t buffer_underflow_bytes = -1;
+};
+
+/* Snapshot of a performance counter, see PerformanceCounter in
+ * bluetooth.proto. |type| is a counters_type_t.
+ * NOTE: Negative values are invalid and left out of the log
+ */
+struct PerformanceCounterMetrics {
+  std::string module;
+  std::string name;
+  int32_t type = -1;
+  int64_t value = -1;
+  int64_t count = -1;
+  int64_t sum = -1;
+  int64_t max = -1;
+  int64_t p50 = -1;
+  int64_t p90 = -1;
+  int64_t p99 = -1;
+};
+
 class BluetoothMetricsLogger {
  public:
   static BluetoothMetricsLogger* GetInstance() {
@@ -126,6 +186,36 @@ class BluetoothMetricsLogger {
   void LogPairEvent(uint32_t disconnect_reason, uint64_t timestamp_ms,
                     uint32_t device_class, device_type_t device_type);
 
+  /*
+   * Record the timing of an LE pairing
+   *
+   * Parameters:
+   *    timestamp_ms: Unix epoch time in milliseconds
+   *    metrics: per phase durations of the pairing
+   */
+  void LogSmpPairingEvent(uint64_t timestamp_ms,
+                          const SmpPairingMetrics& metrics);
+
+  /*
+   * Record the link quality of a period
+   *
+   * Parameters:
+   *    timestamp_ms: Unix epoch time in milliseconds of the period start
+   *    metrics: quality report statistics of the period
+   */
+  void LogLinkQualityEvent(uint64_t timestamp_ms,
+                           const LinkQualityMetrics& metrics);
+
+  /*
+   * Record the value of a performance counter
+   *
+   * Parameters:
+   *    timestamp_ms: Unix epoch time in milliseconds
+   *    metrics: value of the counter
+   */
+  void LogPerformanceCounter(uint64_t timestamp_ms,
+                             const PerformanceCounterMetrics& metrics);
+
   /*
    * Record a wake event
    *
@@ -224,12 +314,16 @@ class BluetoothMetricsLogger {
   void Reset();
 
   /*
-   * Maximum number of log entries for each session or event
+   * Maximum number of log entries for each session or event. Events are also
+   * dropped, oldest first, beyond 64 KiB of serialized events of each kind.
    */
   static const size_t kMaxNumBluetoothSession = 50;
   static const size_t kMaxNumPairEvent = 50;
   static const size_t kMaxNumWakeEvent = 1000;
   static const size_t kMaxNumScanEvent = 50;
+  static const size_t kMaxNumSmpPairingEvent = 50;
+  static const size_t kMaxNumLinkQualityEvent = 50;
+  static const size_t kMaxNumPerformanceCounter = 128;
 
  private:
   BluetoothMetricsLogger();
@@ -243,9 +337,10 @@ class BluetoothMetricsLogger {
   void CutoffSession();
 
   /*
-   * Build the internal metrics object using information gathered
+   * Write the serialized metrics gathered so far to SERIALIZED. Events are
+   * kept serialized as they are logged, so this only concatenates them.
    */
-  void Build();
+  void Build(std::string* serialized);
 
   /*
    * Reset objects related to current Bluetooth session
@@ -253,7 +348,7 @@ class BluetoothMetricsLogger {
   void ResetSession();
 
   /*
-   * Reset the underlining BluetoothLog object
+   * Reset the underlining BluetoothLog object and the serialized events
    */
   void ResetLog();
 
@@ -0,0 +1,240 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace system_bt_osi {
+
+/*
+ *   OpenHashMapHash<K>
+ *
+ * - Default hash for OpenHashMap. Integer keys (connection handles, CIDs) are
+ *   mixed with a multiplicative hash. Other trivially copyable keys, such as
+ *   RawAddress, are hashed over their bytes.
+ */
+template <class K, class Enable = void>
+struct OpenHashMapHash {
+  static_assert(std::is_trivially_copyable<K>::value,
+                "OpenHashMapHash requires a trivially copyable key");
+
+  size_t operator()(const K& key) const {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&key);
+    uint64_t hash = 1469598103934665603ULL;  // FNV-1a
+    for (size_t i = 0; i < sizeof(K); i++) {
+      hash ^= bytes[i];
+      hash *= 1099511628211ULL;
+    }
+    return static_cast<size_t>(hash ^ (hash >> 32));
+  }
+};
+
+template <class K>
+struct OpenHashMapHash<K, typename std::enable_if<std::is_integral<K>::value ||
+                                                  std::is_enum<K>::value>::type> {
+  size_t operator()(const K& key) const {
+    uint64_t hash = static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>(hash ^ (hash >> 32));
+  }
+};
+
+/*
+ *   OpenHashMap<K, V, Hash>
+ *
+ * - OpenHashMap<K, V> is an open-addressing hash map with linear probing that
+ *   stores keys and values inline in a single array. Unlike
+ *   std::unordered_map it does not allocate per insertion; memory is only
+ *   allocated when the table grows, which can be avoided entirely by passing
+ *   a large enough |initial_capacity|.
+ * - Erase uses backward-shift deletion, so lookups never slow down due to
+ *   tombstones.
+ * - Pointers returned by Find and Insert are invalidated by any subsequent
+ *   Insert or Erase.
+ * - The map is not thread-safe.
+ *
+ */
+template <class K, class V, class Hash = OpenHashMapHash<K>>
+class OpenHashMap {
+ public:
+  explicit OpenHashMap(size_t initial_capacity = 16);
+
+  /*
+   * Returns a pointer to the value stored for KEY, or nullptr if there is none
+   */
+  V* Find(const K& key);
+  const V* Find(const K& key) const;
+  /*
+   * Returns whether a value is stored for KEY
+   */
+  bool Contains(const K& key) const { return Find(key) != nullptr; }
+  /*
+   * Stores VALUE for KEY, replacing any previous value. Returns a pointer to
+   * the stored value
+   */
+  V* Insert(const K& key, V value);
+  /*
+   * Removes the value stored for KEY. Returns whether there was one
+   */
+  bool Erase(const K& key);
+  /*
+   * Removes all entries, keeping the allocated capacity
+   */
+  void Clear();
+  /*
+   * Calls FUNC(key, value) for every entry, in no particular order. The map
+   * must not be modified from FUNC
+   */
+  template <class F>
+  void ForEach(F func);
+  /*
+   * Returns the number of entries in the map
+   */
+  size_t Size() const { return size_; }
+  /*
+   * Returns whether the map is empty
+   */
+  bool Empty() const { return size_ == 0; }
+  /*
+   * Returns the number of slots in the table
+   */
+  size_t Capacity() const { return slots_.size(); }
+
+ private:
+  struct Slot {
+    bool used = false;
+    K key{};
+    V value{};
+  };
+
+  size_t IndexFor(const K& key) const { return hash_(key) & mask_; }
+  size_t FindIndex(const K& key) const;
+  void Grow();
+
+  std::vector<Slot> slots_;
+  size_t mask_;
+  size_t size_;
+  Hash hash_;
+};
+
+/*
+* Definitions must be in the header for template classes
+*/
+
+template <class K, class V, class Hash>
+OpenHashMap<K, V, Hash>::OpenHashMap(size_t initial_capacity) : size_(0) {
+  // Keep the load factor at or below 3/4 for |initial_capacity| entries.
+  size_t capacity = 8;
+  while (capacity * 3 < initial_capacity * 4) capacity <<= 1;
+  slots_.resize(capacity);
+  mask_ = capacity - 1;
+}
+
+template <class K, class V, class Hash>
+size_t OpenHashMap<K, V, Hash>::FindIndex(const K& key) const {
+  for (size_t i = IndexFor(key);; i = (i + 1) & mask_) {
+    const Slot& slot = slots_[i];
+    if (!slot.used) return slots_.size();
+    if (slot.key == key) return i;
+  }
+}
+
+template <class K, class V, class Hash>
+V* OpenHashMap<K, V, Hash>::Find(const K& key) {
+  size_t index = FindIndex(key);
+  return (index == slots_.size()) ? nullptr : &slots_[index].value;
+}
+
+template <class K, class V, class Hash>
+const V* OpenHashMap<K, V, Hash>::Find(const K& key) const {
+  size_t index = FindIndex(key);
+  return (index == slots_.size()) ? nullptr : &slots_[index].value;
+}
+
+template <class K, class V, class Hash>
+V* OpenHashMap<K, V, Hash>::Insert(const K& key, V value) {
+  if ((size_ + 1) * 4 > slots_.size() * 3) Grow();
+
+  size_t i = IndexFor(key);
+  while (slots_[i].used && !(slots_[i].key == key)) i = (i + 1) & mask_;
+
+  Slot& slot = slots_[i];
+  if (!slot.used) {
+    slot.used = true;
+    slot.key = key;
+    size_++;
+  }
+  slot.value = std::move(value);
+  return &slot.value;
+}
+
+template <class K, class V, class Hash>
+bool OpenHashMap<K, V, Hash>::Erase(const K& key) {
+  size_t hole = FindIndex(key);
+  if (hole == slots_.size()) return false;
+
+  // Shift following entries of the probe run back into the hole so that no
+  // tombstones are needed.
+  for (size_t i = (hole + 1) & mask_; slots_[i].used; i = (i + 1) & mask_) {
+    size_t home = IndexFor(slots_[i].key);
+    // Move the entry if its home slot is not cyclically in (hole, i].
+    if (((i - home) & mask_) >= ((i - hole) & mask_)) {
+      slots_[hole].key = std::move(slots_[i].key);
+      slots_[hole].value = std::move(slots_[i].value);
+      hole = i;
+    }
+  }
+
+  slots_[hole] = Slot();
+  size_--;
+  return true;
+}
+
+template <class K, class V, class Hash>
+void OpenHashMap<K, V, Hash>::Clear() {
+  for (Slot& slot : slots_) slot = Slot();
+  size_ = 0;
+}
+
+template <class K, class V, class Hash>
+template <class F>
+void OpenHashMap<K, V, Hash>::ForEach(F func) {
+  for (Slot& slot : slots_) {
+    if (slot.used) func(slot.key, slot.value);
+  }
+}
+
+template <class K, class V, class Hash>
+void OpenHashMap<K, V, Hash>::Grow() {
+  std::vector<Slot> old_slots(slots_.size() * 2);
+  old_slots.swap(slots_);
+  mask_ = slots_.size() - 1;
+  size_ = 0;
+
+  for (Slot& slot : old_slots) {
+    if (slot.used) Insert(slot.key, std::move(slot.value));
+  }
+}
+
+}  // namespace system_bt_osi
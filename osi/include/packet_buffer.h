@@ -0,0 +1,125 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+// A packet buffer is a chain of segments, each of which refers to a range of
+// bytes in a reference-counted storage block. Layers can prepend headers into
+// the headroom reserved in front of the first segment, clone a packet or split
+// it into fragments without copying the payload. Bytes visible to another
+// packet are never handed out again: prepending or appending claims unused
+// headroom or tailroom, or adds a new segment when there is none.
+
+typedef struct packet_buffer_t packet_buffer_t;
+
+// Headroom reserved in front of segments that the packet buffer allocates on
+// its own, e.g. when a header does not fit the existing headroom.
+#define PACKET_BUFFER_DEFAULT_HEADROOM 32
+
+// Called when the last reference to external storage goes away. |context| is
+// the value passed to |packet_buffer_new_external|.
+typedef void (*packet_buffer_release_cb)(void* context);
+
+// Returns a new packet of |size| bytes with |headroom| bytes reserved in front
+// of it for headers. The payload is uninitialized. The returned packet must be
+// freed with |packet_buffer_free|.
+packet_buffer_t* packet_buffer_new(size_t headroom, size_t size);
+
+// Returns a new packet holding a copy of the |size| bytes at |data|, with
+// |headroom| bytes reserved in front of it. |data| may be NULL only if |size|
+// is zero. The returned packet must be freed with |packet_buffer_free|.
+packet_buffer_t* packet_buffer_new_copy(size_t headroom, const void* data,
+                                        size_t size);
+
+// Wraps the |size| bytes at |data| without copying them. The |headroom| bytes
+// in front of |data| belong to the storage as well and may be used for
+// headers. |release| is called with |context| once no packet refers to the
+// storage anymore; it may be NULL. The returned packet must be freed with
+// |packet_buffer_free|.
+packet_buffer_t* packet_buffer_new_external(uint8_t* data, size_t headroom,
+                                            size_t size,
+                                            packet_buffer_release_cb release,
+                                            void* context);
+
+// Returns a new packet with the same contents as |packet| that shares its
+// storage. Prepending or appending to either packet does not change what the
+// other one contains. |packet| may not be NULL.
+packet_buffer_t* packet_buffer_clone(const packet_buffer_t* packet);
+
+// Frees |packet| and drops its references to the underlying storage. |packet|
+// may be NULL.
+void packet_buffer_free(packet_buffer_t* packet);
+
+// Returns the number of payload bytes in |packet|. |packet| may not be NULL.
+size_t packet_buffer_length(const packet_buffer_t* packet);
+
+// Returns the number of segments in |packet|. |packet| may not be NULL.
+size_t packet_buffer_segment_count(const packet_buffer_t* packet);
+
+// Returns the number of bytes that can be prepended to |packet| without
+// adding a segment. |packet| may not be NULL.
+size_t packet_buffer_headroom(const packet_buffer_t* packet);
+
+// Grows |packet| by |size| bytes at the front and returns a pointer to them
+// so the caller can write a header. The headroom is used when it is large
+// enough and not shared, otherwise a new segment is added. |size| must be
+// greater than zero. |packet| may not be NULL.
+uint8_t* packet_buffer_prepend(packet_buffer_t* packet, size_t size);
+
+// Grows |packet| by |size| bytes at the end and returns a pointer to them.
+// |size| must be greater than zero. |packet| may not be NULL.
+uint8_t* packet_buffer_append(packet_buffer_t* packet, size_t size);
+
+// Moves all segments of |tail| to the end of |packet| and frees |tail|. No
+// payload is copied. Neither argument may be NULL.
+void packet_buffer_concat(packet_buffer_t* packet, packet_buffer_t* tail);
+
+// Removes the first |size| bytes of |packet|. |size| may be at most
+// |packet_buffer_length|. |packet| may not be NULL.
+void packet_buffer_trim_front(packet_buffer_t* packet, size_t size);
+
+// Removes the last |size| bytes of |packet|. |size| may be at most
+// |packet_buffer_length|. |packet| may not be NULL.
+void packet_buffer_trim_back(packet_buffer_t* packet, size_t size);
+
+// Splits off the first |size| bytes of |packet| into a new packet that shares
+// storage with it, leaving the remainder in |packet|. Use it to fragment a
+// packet without copying. |size| may be at most |packet_buffer_length|.
+// |packet| may not be NULL. The returned packet must be freed with
+// |packet_buffer_free|.
+packet_buffer_t* packet_buffer_split(packet_buffer_t* packet, size_t size);
+
+// Fills |iov| with up to |max_iov| segments of |packet|, in order, and
+// returns the number of entries written. The entries stay valid until
+// |packet| is modified or freed. |packet| and |iov| may not be NULL.
+size_t packet_buffer_get_iovec(const packet_buffer_t* packet,
+                               struct iovec* iov, size_t max_iov);
+
+// Copies up to |size| bytes starting at byte |offset| of |packet| into
+// |dest| and returns the number of bytes copied. |packet| may not be NULL.
+size_t packet_buffer_copy_out(const packet_buffer_t* packet, size_t offset,
+                              void* dest, size_t size);
+
+// Returns a pointer to the payload if |packet| consists of a single segment,
+// NULL otherwise. |packet| may not be NULL.
+uint8_t* packet_buffer_data(const packet_buffer_t* packet);
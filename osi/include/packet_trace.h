@@ -0,0 +1,95 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Packet latency tracing. Layers mark a packet as it crosses their boundary;
+// the time between consecutive marks of the same packet is collected into
+// per-segment histograms. Packets are identified by their address, so a layer
+// that copies a packet into a new buffer must call |packet_trace_move|.
+// Marks cost a single atomic load while tracing is disabled. All functions
+// are thread safe.
+
+typedef enum {
+  // Outgoing: queued by L2CAP, handed to HCI, written to the controller.
+  PACKET_TRACE_TX_L2CAP_QUEUED = 0,
+  PACKET_TRACE_TX_L2CAP_SENT,
+  PACKET_TRACE_TX_HCI_SENT,
+  // Incoming: received from the controller, processed by L2CAP, delivered to
+  // the profile.
+  PACKET_TRACE_RX_HCI_RECEIVED,
+  PACKET_TRACE_RX_L2CAP_RECEIVED,
+  PACKET_TRACE_RX_DELIVERED,
+  PACKET_TRACE_POINT_COUNT,
+} packet_trace_point_t;
+
+typedef enum {
+  PACKET_TRACE_SEGMENT_TX_L2CAP_QUEUE = 0,  // Queued until sent to HCI.
+  PACKET_TRACE_SEGMENT_TX_HCI,              // Sent to HCI until written.
+  PACKET_TRACE_SEGMENT_TX_TOTAL,
+  PACKET_TRACE_SEGMENT_RX_HCI,    // Received until processed by L2CAP.
+  PACKET_TRACE_SEGMENT_RX_L2CAP,  // Processed by L2CAP until delivered.
+  PACKET_TRACE_SEGMENT_RX_TOTAL,
+  PACKET_TRACE_SEGMENT_COUNT,
+} packet_trace_segment_t;
+
+// Histogram bucket |i| counts samples below 2^i microseconds; the last bucket
+// counts everything else.
+#define PACKET_TRACE_HISTOGRAM_BUCKETS 20
+
+typedef struct {
+  uint64_t count;
+  uint64_t total_us;
+  uint64_t max_us;
+  uint32_t histogram[PACKET_TRACE_HISTOGRAM_BUCKETS];
+} packet_trace_stats_t;
+
+// Enables or disables tracing and clears all collected data. If
+// |ftrace_export| is true every sample is also written to the kernel trace
+// buffer as an atrace counter, which systrace and Perfetto can display.
+void packet_trace_init(bool enabled, bool ftrace_export);
+
+// Returns true if tracing is enabled.
+bool packet_trace_is_enabled(void);
+
+// Records that |packet| reached |point|. Marking a start point
+// (|PACKET_TRACE_TX_L2CAP_QUEUED| or |PACKET_TRACE_RX_HCI_RECEIVED|) begins a
+// new trace. A later point adds a sample for the time since the previous
+// mark, and the last point of a direction completes the trace. Marking the
+// current point again is ignored. A packet first seen at an intermediate
+// point starts its trace there.
+void packet_trace_mark(const void* packet, packet_trace_point_t point);
+
+// Moves the trace of |from| to |to|, e.g. when a fragment is copied into a
+// reassembly buffer.
+void packet_trace_move(const void* from, const void* to);
+
+// Drops the trace of |packet|, if any.
+void packet_trace_forget(const void* packet);
+
+// Copies the statistics of |segment| to |stats|. |stats| may not be NULL.
+void packet_trace_get_stats(packet_trace_segment_t segment,
+                            packet_trace_stats_t* stats);
+
+// Dumps the latency histograms to |fd|.
+void packet_trace_debug_dump(int fd);
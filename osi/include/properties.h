@@ -45,3 +45,38 @@ int osi_property_set(const char* key, const char* value);
 int32_t osi_property_get_int32(const char* key, int32_t default_value);
 
 bool osi_property_get_bool(const char* key, bool default_value);
+
+// A property whose value is kept between reads. Declare one per key with
+// static storage and read it with the osi_cached_property_get functions, e.g.
+//
+//   static osi_cached_property_t sbc_mq =
+//       OSI_CACHED_PROPERTY("persist.vendor.btstack.sbcmq");
+//   bool mq = osi_cached_property_get_bool(&sbc_mq, false);
+//
+// A read only goes back to the property service once the property changed,
+// which the change serials of the property area tell without a lookup.
+// The fields are private to properties.cc.
+typedef struct {
+  const char* key;
+  const void* pi;        // property info, NULL until the property exists
+  uint32_t area_serial;  // serial of the property area at the last read
+  uint32_t prop_serial;  // serial of the property at the last read
+  bool valid;
+  int len;
+  char value[PROPERTY_VALUE_MAX];
+} osi_cached_property_t;
+
+#define OSI_CACHED_PROPERTY(key) \
+  { (key), NULL, 0, 0, false, 0, {0} }
+
+// Same as osi_property_get, through the cache of |prop|.
+int osi_cached_property_get(osi_cached_property_t* prop, char* value,
+                            const char* default_value);
+
+// Same as osi_property_get_int32, through the cache of |prop|.
+int32_t osi_cached_property_get_int32(osi_cached_property_t* prop,
+                                      int32_t default_value);
+
+// Same as osi_property_get_bool, through the cache of |prop|.
+bool osi_cached_property_get_bool(osi_cached_property_t* prop,
+                                  bool default_value);
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "osi/include/osi.h"
@@ -41,6 +42,13 @@ typedef enum {
 // must be freed by calling |reactor_free|.
 reactor_t* reactor_new(void);
 
+// Creates a new reactor object that fetches up to |max_events| ready file
+// descriptors per wakeup and dispatches them as one batch. Larger batches
+// lower the per-event overhead for busy threads. |max_events| must be
+// greater than zero. Returns NULL on failure. The returned object must be
+// freed by calling |reactor_free|.
+reactor_t* reactor_new_with_max_events(size_t max_events);
+
 // Frees a reactor object created with |reactor_new|. |reactor| may be NULL.
 void reactor_free(reactor_t* reactor);
 
@@ -71,6 +79,16 @@ reactor_object_t* reactor_register(reactor_t* reactor, int fd, void* context,
                                    void (*read_ready)(void* context),
                                    void (*write_ready)(void* context));
 
+// Same as |reactor_register|, but the file descriptor is registered in
+// edge-triggered mode: |read_ready| and |write_ready| are called once each
+// time the file descriptor becomes readable or writeable, not for as long as
+// it stays so. The callbacks must therefore consume all available data (or
+// write until the call would block) before returning. Meant for high-rate,
+// non-blocking file descriptors. |reactor_change_registration| keeps the mode.
+reactor_object_t* reactor_register_edge_triggered(
+    reactor_t* reactor, int fd, void* context,
+    void (*read_ready)(void* context), void (*write_ready)(void* context));
+
 // Changes the subscription mode for the file descriptor represented by
 // |object|. If the caller has already registered a file descriptor with a
 // reactor, has a valid |object|, and decides to change the |read_ready| and/or
@@ -22,12 +22,23 @@
 
 typedef struct ringbuffer_t ringbuffer_t;
 
+// A region of the ringbuffer described as up to two contiguous parts. The
+// second part is only used when the region wraps around the end of the
+// buffer; |second| is NULL and |second_length| is 0 otherwise.
+typedef struct {
+  uint8_t* first;
+  size_t first_length;
+  uint8_t* second;
+  size_t second_length;
+} ringbuffer_span_t;
+
 // NOTE:
 // None of the functions below are thread safe when it comes to accessing the
 // *rb pointer. It is *NOT* possible to insert and pop/delete at the same time.
 // Callers must protect the *rb pointer separately.
 
 // Create a ringbuffer with the specified size
+// A |size| that is a power of two lets index arithmetic use a mask.
 // Returns NULL if memory allocation failed. Resulting pointer must be freed
 // using |ringbuffer_free|.
 ringbuffer_t* ringbuffer_init(const size_t size);
@@ -60,3 +71,25 @@ size_t ringbuffer_pop(ringbuffer_t* rb, uint8_t* p, size_t length);
 // Deletes |length| bytes from the ringbuffer starting from the head
 // Return actual number of bytes deleted.
 size_t ringbuffer_delete(ringbuffer_t* rb, size_t length);
+
+// Reserves up to |length| bytes of free space at the tail of the buffer and
+// describes it in |span| so that a producer can write into the ringbuffer
+// directly. Returns the number of bytes reserved, which can be less than
+// |length| if the buffer is nearly full. The data only becomes visible to
+// consumers once |ringbuffer_commit| is called.
+size_t ringbuffer_reserve(ringbuffer_t* rb, size_t length,
+                          ringbuffer_span_t* span);
+
+// Makes |length| bytes written into the span returned by |ringbuffer_reserve|
+// part of the buffer contents. Returns the number of bytes committed.
+size_t ringbuffer_commit(ringbuffer_t* rb, size_t length);
+
+// Describes up to |length| bytes of data at the head of the buffer in |span|
+// so that a consumer can read them in place. Returns the number of bytes in
+// |span|. The data stays in the buffer until |ringbuffer_release| is called.
+size_t ringbuffer_acquire(const ringbuffer_t* rb, size_t length,
+                          ringbuffer_span_t* span);
+
+// Removes |length| bytes acquired with |ringbuffer_acquire| from the head of
+// the buffer. Returns the number of bytes released.
+size_t ringbuffer_release(ringbuffer_t* rb, size_t length);
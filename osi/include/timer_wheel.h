@@ -0,0 +1,85 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "osi/include/time.h"
+
+// Hierarchical timing wheel with millisecond resolution. Insertion and
+// removal are O(1); expired entries are collected in batches when the wheel
+// is advanced. None of the functions below are thread safe; callers must
+// provide their own locking.
+
+typedef struct timer_wheel_t timer_wheel_t;
+typedef struct timer_wheel_slot_t timer_wheel_slot_t;
+
+// Intrusive wheel entry. Embed it in the object being scheduled and treat its
+// fields as private. A zero-initialized node is not pending.
+typedef struct timer_wheel_node_t {
+  struct timer_wheel_node_t* prev;
+  struct timer_wheel_node_t* next;
+  timer_wheel_slot_t* slot;
+  period_ms_t deadline;
+  void* context;
+} timer_wheel_node_t;
+
+// Iterator callback used by |timer_wheel_foreach|. |context| is the value
+// the node was inserted with.
+typedef void (*timer_wheel_iter_cb)(void* context, void* user_data);
+
+// Creates a new, empty wheel whose clock starts at |now_ms|. Returns NULL on
+// failure. The returned wheel must be freed with |timer_wheel_free|.
+timer_wheel_t* timer_wheel_new(period_ms_t now_ms);
+
+// Frees |wheel|. Pending nodes are simply forgotten. |wheel| may be NULL.
+void timer_wheel_free(timer_wheel_t* wheel);
+
+// Schedules |node| to expire at the absolute time |deadline_ms|. |context| is
+// returned by |timer_wheel_pop_expired| once the node expires. |node| must
+// not already be pending. Deadlines in the past expire on the next pop.
+void timer_wheel_insert(timer_wheel_t* wheel, timer_wheel_node_t* node,
+                        period_ms_t deadline_ms, void* context);
+
+// Removes |node| from |wheel| if it is pending. This function is idempotent.
+void timer_wheel_remove(timer_wheel_t* wheel, timer_wheel_node_t* node);
+
+// Returns true if |node| is currently pending in a wheel.
+bool timer_wheel_is_pending(const timer_wheel_node_t* node);
+
+// Returns the number of pending nodes in |wheel|, including expired nodes
+// that have not been popped yet.
+size_t timer_wheel_size(const timer_wheel_t* wheel);
+
+// Stores the earliest pending deadline in |deadline_ms| and returns true, or
+// returns false if |wheel| is empty.
+bool timer_wheel_next_deadline(timer_wheel_t* wheel, period_ms_t* deadline_ms);
+
+// Advances the wheel clock to |now_ms| and pops the next node whose deadline
+// is at or before |now_ms|. Nodes are returned in deadline order, and nodes
+// with the same deadline in insertion order. Returns the node's context, or
+// NULL if nothing has expired.
+void* timer_wheel_pop_expired(timer_wheel_t* wheel, period_ms_t now_ms);
+
+// Calls |callback| for every pending node, in no particular order. The wheel
+// must not be modified from |callback|.
+void timer_wheel_foreach(const timer_wheel_t* wheel,
+                         timer_wheel_iter_cb callback, void* user_data);
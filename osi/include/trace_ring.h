@@ -0,0 +1,187 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <type_traits>
+
+// Binary trace ring. Instead of formatting a message on every call, hot paths
+// record the address of a literal format string together with the raw
+// argument values; the text is only produced when the ring is dumped. Strings
+// passed for "%s" are copied into the record, so they don't need to outlive
+// the call. The ring keeps the last |TRACE_RING_SIZE| records. All functions
+// are thread safe.
+//
+// Levels above |TRACE_RING_LEVEL| are compiled out. A module lowers it by
+// defining TRACE_RING_LEVEL before including this header, or in its cflags.
+
+#define TRACE_RING_LEVEL_ERROR 1
+#define TRACE_RING_LEVEL_WARN 2
+#define TRACE_RING_LEVEL_INFO 3
+#define TRACE_RING_LEVEL_DEBUG 4
+#define TRACE_RING_LEVEL_VERBOSE 5
+
+#ifndef TRACE_RING_LEVEL
+#define TRACE_RING_LEVEL TRACE_RING_LEVEL_VERBOSE
+#endif
+
+#define TRACE_RING_SIZE 512
+#define TRACE_RING_MAX_ARGS 8
+#define TRACE_RING_STRING_SIZE 48
+
+// Size of a Bluetooth device address recorded with |TRACE_RING_ADDRESS|.
+#define TRACE_RING_ADDRESS_LEN 6
+
+typedef enum {
+  TRACE_RING_ARG_INT32 = 0,  // Integers promoted to at most 32 bits.
+  TRACE_RING_ARG_INT64,
+  TRACE_RING_ARG_DOUBLE,
+  TRACE_RING_ARG_POINTER,
+  TRACE_RING_ARG_STRING,   // |value| is the offset in |strings|.
+  TRACE_RING_ARG_ADDRESS,  // |value| is the offset in |strings|.
+} trace_ring_arg_kind_t;
+
+typedef struct {
+  uint64_t timestamp_us;
+  const char* tag;
+  const char* format;
+  uint8_t level;
+  uint8_t arg_count;
+  uint8_t strings_used;
+  uint8_t kinds[TRACE_RING_MAX_ARGS];
+  union {
+    uint64_t value;
+    double real;
+  } args[TRACE_RING_MAX_ARGS];
+  char strings[TRACE_RING_STRING_SIZE];
+} trace_ring_record_t;
+
+// A device address, recorded as its bytes and printed by "%s" as
+// "xx:xx:xx:xx:xx:xx". Use |TRACE_RING_ADDRESS| to build one.
+typedef struct {
+  const uint8_t* bytes;
+} trace_ring_address_t;
+
+#define TRACE_RING_ADDRESS(bd_addr) (trace_ring_address_t{(bd_addr).address})
+
+// Enables or disables recording and clears the ring.
+void trace_ring_init(bool enabled);
+
+// Returns true if records are kept.
+bool trace_ring_is_enabled(void);
+
+// Timestamps |record| and copies it into the ring.
+void trace_ring_commit(trace_ring_record_t* record);
+
+// Formats |record| into |buffer| of |size| bytes, which may not be zero.
+// Returns the length of the text, which is truncated to fit.
+size_t trace_ring_format(const trace_ring_record_t* record, char* buffer,
+                         size_t size);
+
+// Dumps the records still in the ring to |fd|, oldest first.
+void trace_ring_debug_dump(int fd);
+
+namespace trace_ring_internal {
+
+inline void add_string(trace_ring_record_t* record, trace_ring_arg_kind_t kind,
+                       const char* bytes, size_t len) {
+  size_t room = TRACE_RING_STRING_SIZE - record->strings_used;
+  uint8_t i = record->arg_count++;
+  record->kinds[i] = kind;
+  record->args[i].value = record->strings_used;
+  if (room == 0) return;
+  if (len > room - 1) len = room - 1;
+  memcpy(record->strings + record->strings_used, bytes, len);
+  record->strings[record->strings_used + len] = '\0';
+  record->strings_used += len + 1;
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value ||
+                               std::is_enum<T>::value>::type
+add_arg(trace_ring_record_t* record, T arg) {
+  uint8_t i = record->arg_count++;
+  record->kinds[i] =
+      sizeof(T) > sizeof(int) ? TRACE_RING_ARG_INT64 : TRACE_RING_ARG_INT32;
+  // Signed values are sign extended, the formatter truncates them again
+  record->args[i].value = std::is_signed<T>::value
+                              ? (uint64_t)(int64_t)arg
+                              : (uint64_t)arg;
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value>::type add_arg(
+    trace_ring_record_t* record, T arg) {
+  uint8_t i = record->arg_count++;
+  record->kinds[i] = TRACE_RING_ARG_DOUBLE;
+  record->args[i].real = arg;
+}
+
+inline void add_arg(trace_ring_record_t* record, const char* arg) {
+  if (arg == NULL) arg = "(null)";
+  add_string(record, TRACE_RING_ARG_STRING, arg, strlen(arg));
+}
+
+inline void add_arg(trace_ring_record_t* record, char* arg) {
+  add_arg(record, (const char*)arg);
+}
+
+inline void add_arg(trace_ring_record_t* record, trace_ring_address_t arg) {
+  add_string(record, TRACE_RING_ARG_ADDRESS, (const char*)arg.bytes,
+             TRACE_RING_ADDRESS_LEN);
+}
+
+inline void add_arg(trace_ring_record_t* record, const void* arg) {
+  uint8_t i = record->arg_count++;
+  record->kinds[i] = TRACE_RING_ARG_POINTER;
+  record->args[i].value = (uint64_t)(uintptr_t)arg;
+}
+
+template <typename... Args>
+inline void record(uint8_t level, const char* tag, const char* format,
+                   Args... args) {
+  static_assert(sizeof...(Args) <= TRACE_RING_MAX_ARGS,
+                "too many trace ring arguments");
+  if (!trace_ring_is_enabled()) return;
+
+  trace_ring_record_t record;
+  record.tag = tag;
+  record.format = format;
+  record.level = level;
+  record.arg_count = 0;
+  record.strings_used = 0;
+  int expand[] = {0, (add_arg(&record, args), 0)...};
+  (void)expand;
+  trace_ring_commit(&record);
+}
+
+}  // namespace trace_ring_internal
+
+// Records a message of |level| (ERROR, WARN, INFO, DEBUG or VERBOSE) in the
+// trace ring. |fmt| must be a string literal using printf conversions.
+#define TRACE_RING_LOG(level, tag, fmt, ...)                         \
+  do {                                                               \
+    if (TRACE_RING_LEVEL_##level <= TRACE_RING_LEVEL)                \
+      trace_ring_internal::record(TRACE_RING_LEVEL_##level, tag,     \
+                                  "" fmt, ##__VA_ARGS__);            \
+  } while (0)
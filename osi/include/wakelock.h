@@ -20,6 +20,7 @@
 
 #include <hardware/bluetooth.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 // Set the Bluetooth OS callouts to |callouts|.
 // This function should be called when native kernel wakelocks are not used
@@ -28,15 +29,33 @@
 void wakelock_set_os_callouts(bt_os_callouts_t* callouts);
 
 // Acquire the Bluetooth wakelock.
+// Same as wakelock_acquire_ref with the wakelock name as requester.
 // The function is thread safe.
 // Return true on success, otherwise false.
 bool wakelock_acquire(void);
 
 // Release the Bluetooth wakelock.
+// Same as wakelock_release_ref with the wakelock name as requester and
+// without lingering.
 // The function is thread safe.
 // Return true on success, otherwise false.
 bool wakelock_release(void);
 
+// Acquire a reference to the Bluetooth wakelock on behalf of |requester|.
+// The references of all requesters share one kernel wakelock, which is only
+// taken when there was none. Statistics are kept per |requester|.
+// The function is thread safe.
+// Return true on success, otherwise false.
+bool wakelock_acquire_ref(const char* requester);
+
+// Release a reference |requester| acquired with wakelock_acquire_ref.
+// Once no reference is left the kernel wakelock is kept for |linger_ms|,
+// so that a reference acquired again meanwhile does not take it again.
+// A |linger_ms| of 0 releases it right away.
+// The function is thread safe.
+// Return true on success, otherwise false.
+bool wakelock_release_ref(const char* requester, uint64_t linger_ms);
+
 // Cleanup the wakelock internal state.
 // This function should be called by the OSI module cleanup during
 // graceful shutdown.
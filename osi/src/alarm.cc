@@ -36,15 +36,21 @@
 
 #include <hardware/bluetooth.h>
 
+#include <algorithm>
 #include <mutex>
+#include <string>
+#include <vector>
 
 #include "osi/include/allocator.h"
+#include "osi/include/counters.h"
 #include "osi/include/fixed_queue.h"
-#include "osi/include/list.h"
+#include "osi/include/intrusive_list.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
 #include "osi/include/semaphore.h"
 #include "osi/include/thread.h"
+#include "osi/include/timer_wheel.h"
 #include "osi/include/wakelock.h"
 
 using base::Bind;
@@ -53,6 +59,9 @@ using base::MessageLoop;
 
 extern base::MessageLoop* get_message_loop();
 
+// Selects the timing wheel instead of the sorted list for pending alarms.
+#define ALARM_TIMING_WHEEL_PROPERTY "persist.vendor.bt.alarm.timing_wheel"
+
 // Callback and timer threads should run at RT priority in order to ensure they
 // meet audio deadlines.  Use this priority for all audio/timer related thread.
 static const int THREAD_RT_PRIORITY = 1;
@@ -96,6 +105,7 @@ struct alarm_t {
   std::shared_ptr<std::recursive_mutex> callback_mutex;
   period_ms_t creation_time;
   period_ms_t period;
+  period_ms_t slack;  // How late the alarm may fire to share a wakeup
   period_ms_t deadline;
   period_ms_t prev_deadline;  // Previous deadline - used for accounting of
                               // periodic timers
@@ -107,6 +117,9 @@ struct alarm_t {
 
   bool for_msg_loop;  // True, if the alarm should be processed on message loop
   CancelableClosureInStruct closure;  // posted to message loop for processing
+
+  timer_wheel_node_t wheel_node;  // Used when |alarm_wheel| is active
+  system_bt_osi::IntrusiveListHook<alarm_t> list_hook;  // Used in |alarms|
 };
 
 // If the next wakeup time is less than this threshold, we should acquire
@@ -114,6 +127,13 @@ struct alarm_t {
 // and out of suspend frequently. This value is externally visible to allow
 // unit tests to run faster. It should not be modified by production code.
 int64_t TIMER_INTERVAL_FOR_WAKELOCK_IN_MS = 3000;
+
+// How long the wakelock is kept after the last pending alarm went, so that
+// an alarm set right after does not take it again. This value is externally
+// visible to allow unit tests to check the release right away. It should not
+// be modified by production code.
+uint64_t TIMER_WAKELOCK_LINGER_MS = 10;
+static const char* WAKELOCK_REQUESTER = "alarm";
 static const clockid_t CLOCK_ID = CLOCK_BOOTTIME;
 
 #if (KERNEL_MISSING_CLOCK_BOOTTIME_ALARM == TRUE)
@@ -124,9 +144,20 @@ static const clockid_t CLOCK_ID_ALARM = CLOCK_BOOTTIME_ALARM;
 
 // This mutex ensures that the |alarm_set|, |alarm_cancel|, and alarm callback
 // functions execute serially and not concurrently. As a result, this mutex
-// also protects the |alarms| list.
+// also protects the |alarms| list and the |alarm_wheel|.
 static std::mutex alarms_mutex;
-static list_t* alarms;
+// Pending alarms are kept either in |alarms|, sorted by deadline, or in
+// |alarm_wheel| when the timing wheel backend was selected at initialization.
+// While the alarm module is initialized either |alarm_list_active| is set or
+// |alarm_wheel| is non-NULL.
+static system_bt_osi::IntrusiveList<alarm_t, &alarm_t::list_hook> alarms;
+static bool alarm_list_active;
+static timer_wheel_t* alarm_wheel;
+static int timing_wheel_requested = -1;  // -1: use ALARM_TIMING_WHEEL_PROPERTY
+// Deadline the root timer is currently programmed for, or UINT64_MAX.
+static period_ms_t root_deadline = UINT64_MAX;
+// Number of alarms that expired on a wakeup already taken by another alarm.
+static size_t coalesced_wakeups;
 static timer_t timer;
 static timer_t wakeup_timer;
 static bool timer_set;
@@ -140,14 +171,20 @@ static semaphore_t* alarm_expired;
 static thread_t* default_callback_thread;
 static fixed_queue_t* default_callback_queue;
 
+// How late callbacks start, over all alarms
+static counters_metric_t* callback_delay;
+
 static alarm_t* alarm_new_internal(const char* name, bool is_periodic);
+static bool alarms_initialized(void);
 static bool lazy_initialize(void);
 static period_ms_t now(void);
 static void alarm_set_internal(alarm_t* alarm, period_ms_t period,
-                               alarm_callback_t cb, void* data,
-                               fixed_queue_t* queue, bool for_msg_loop);
+                               period_ms_t slack, alarm_callback_t cb,
+                               void* data, fixed_queue_t* queue,
+                               bool for_msg_loop);
 static void* alarm_cancel_internal(alarm_t* alarm);
 static void remove_pending_alarm(alarm_t* alarm);
+static bool pending_alarm_is_next(const alarm_t* alarm);
 static void schedule_next_instance(alarm_t* alarm);
 static void reschedule_root_alarm(void);
 static void alarm_queue_ready(fixed_queue_t* queue, void* context);
@@ -175,7 +212,7 @@ alarm_t* alarm_new_periodic(const char* name) {
 
 static alarm_t* alarm_new_internal(const char* name, bool is_periodic) {
   // Make sure we have a list we can insert alarms into.
-  if (!alarms && !lazy_initialize()) {
+  if (!alarms_initialized() && !lazy_initialize()) {
     CHECK(false);  // if initialization failed, we should not continue
     return NULL;
   }
@@ -223,20 +260,28 @@ period_ms_t alarm_get_remaining_ms(const alarm_t* alarm) {
 
 void alarm_set(alarm_t* alarm, period_ms_t interval_ms, alarm_callback_t cb,
                void* data) {
-  alarm_set_internal(alarm, interval_ms, cb, data, default_callback_queue,
+  alarm_set_internal(alarm, interval_ms, 0, cb, data, default_callback_queue,
                      false);
 }
 
+void alarm_set_with_slack(alarm_t* alarm, period_ms_t interval_ms,
+                          period_ms_t slack_ms, alarm_callback_t cb,
+                          void* data) {
+  alarm_set_internal(alarm, interval_ms, slack_ms, cb, data,
+                     default_callback_queue, false);
+}
+
 void alarm_set_on_mloop(alarm_t* alarm, period_ms_t interval_ms,
                         alarm_callback_t cb, void* data) {
-  alarm_set_internal(alarm, interval_ms, cb, data, NULL, true);
+  alarm_set_internal(alarm, interval_ms, 0, cb, data, NULL, true);
 }
 
 // Runs in exclusion with alarm_cancel and timer_callback.
 static void alarm_set_internal(alarm_t* alarm, period_ms_t period,
-                               alarm_callback_t cb, void* data,
-                               fixed_queue_t* queue, bool for_msg_loop) {
-  CHECK(alarms != NULL);
+                               period_ms_t slack, alarm_callback_t cb,
+                               void* data, fixed_queue_t* queue,
+                               bool for_msg_loop) {
+  CHECK(alarms_initialized());
   CHECK(alarm != NULL);
   CHECK(cb != NULL);
 
@@ -244,6 +289,7 @@ static void alarm_set_internal(alarm_t* alarm, period_ms_t period,
 
   alarm->creation_time = now();
   alarm->period = period;
+  alarm->slack = slack;
   alarm->queue = queue;
   alarm->callback = cb;
   alarm->data = data;
@@ -254,7 +300,7 @@ static void alarm_set_internal(alarm_t* alarm, period_ms_t period,
 }
 
 void* alarm_cancel(alarm_t* alarm) {
-  CHECK(alarms != NULL);
+  CHECK(alarms_initialized());
   if (!alarm) return NULL;
   void* data = NULL;
 
@@ -274,8 +320,7 @@ void* alarm_cancel(alarm_t* alarm) {
 // Internal implementation of canceling an alarm.
 // The caller must hold the |alarms_mutex|
 static void* alarm_cancel_internal(alarm_t* alarm) {
-  bool needs_reschedule =
-      (!list_is_empty(alarms) && list_front(alarms) == alarm);
+  bool needs_reschedule = pending_alarm_is_next(alarm);
 
   remove_pending_alarm(alarm);
 
@@ -293,13 +338,18 @@ static void* alarm_cancel_internal(alarm_t* alarm) {
 }
 
 bool alarm_is_scheduled(const alarm_t* alarm) {
-  if ((alarms == NULL) || (alarm == NULL)) return false;
+  if (!alarms_initialized() || (alarm == NULL)) return false;
   return (alarm->callback != NULL);
 }
 
+void alarm_set_timing_wheel(bool enabled) {
+  std::lock_guard<std::mutex> lock(alarms_mutex);
+  timing_wheel_requested = enabled ? 1 : 0;
+}
+
 void alarm_cleanup(void) {
   // If lazy_initialize never ran there is nothing else to do
-  if (!alarms) return;
+  if (!alarms_initialized()) return;
 
   dispatcher_thread_active = false;
   semaphore_post(alarm_expired);
@@ -318,12 +368,20 @@ void alarm_cleanup(void) {
   semaphore_free(alarm_expired);
   alarm_expired = NULL;
 
-  list_free(alarms);
-  alarms = NULL;
+  alarms.Clear();
+  alarm_list_active = false;
+  timer_wheel_free(alarm_wheel);
+  alarm_wheel = NULL;
+  root_deadline = UINT64_MAX;
+  coalesced_wakeups = 0;
+}
+
+static bool alarms_initialized(void) {
+  return alarm_list_active || alarm_wheel != NULL;
 }
 
 static bool lazy_initialize(void) {
-  CHECK(alarms == NULL);
+  CHECK(!alarms_initialized());
 
   // timer_t doesn't have an invalid value so we must track whether
   // the |timer| variable is valid ourselves.
@@ -332,10 +390,19 @@ static bool lazy_initialize(void) {
 
   std::lock_guard<std::mutex> lock(alarms_mutex);
 
-  alarms = list_new(NULL);
-  if (!alarms) {
-    LOG_ERROR(LOG_TAG, "%s unable to allocate alarm list.", __func__);
-    goto error;
+  callback_delay = counters_register_histogram("alarm", "callback_delay", "ms");
+
+  bool use_timing_wheel =
+      (timing_wheel_requested < 0)
+          ? osi_property_get_bool(ALARM_TIMING_WHEEL_PROPERTY, false)
+          : (timing_wheel_requested == 1);
+  if (use_timing_wheel) {
+    struct timespec ts;
+    clock_gettime(CLOCK_ID, &ts);
+    alarm_wheel =
+        timer_wheel_new((ts.tv_sec * 1000LL) + (ts.tv_nsec / 1000000LL));
+  } else {
+    alarm_list_active = true;
   }
 
   if (!timer_create_internal(CLOCK_ID, &timer)) goto error;
@@ -395,14 +462,15 @@ error:
 
   if (timer_initialized) timer_delete(timer);
 
-  list_free(alarms);
-  alarms = NULL;
+  alarm_list_active = false;
+  timer_wheel_free(alarm_wheel);
+  alarm_wheel = NULL;
 
   return false;
 }
 
 static period_ms_t now(void) {
-  CHECK(alarms != NULL);
+  CHECK(alarms_initialized());
 
   struct timespec ts;
   if (clock_gettime(CLOCK_ID, &ts) == -1) {
@@ -417,7 +485,10 @@ static period_ms_t now(void) {
 // Remove alarm from internal alarm list and the processing queue
 // The caller must hold the |alarms_mutex|
 static void remove_pending_alarm(alarm_t* alarm) {
-  list_remove(alarms, alarm);
+  if (alarm_wheel)
+    timer_wheel_remove(alarm_wheel, &alarm->wheel_node);
+  else
+    alarms.Remove(alarm);
 
   if (alarm->for_msg_loop) {
     alarm->closure.i.Cancel();
@@ -430,12 +501,64 @@ static void remove_pending_alarm(alarm_t* alarm) {
   }
 }
 
+// Returns true if |alarm| is pending and holds the earliest deadline, i.e.
+// the root timer needs to be re-evaluated when it changes.
+// The caller must hold the |alarms_mutex|
+static bool pending_alarm_is_next(const alarm_t* alarm) {
+  if (alarm_wheel)
+    return timer_wheel_is_pending(&alarm->wheel_node) &&
+           alarm->deadline <= root_deadline;
+  return alarms.Front() == alarm;
+}
+
+// Returns the earliest pending deadline in |deadline|, or false if no alarm
+// is pending.
+// The caller must hold the |alarms_mutex|
+static bool pending_alarms_next_deadline(period_ms_t* deadline) {
+  if (alarm_wheel) return timer_wheel_next_deadline(alarm_wheel, deadline);
+  if (alarms.Empty()) return false;
+  *deadline = alarms.Front()->deadline;
+  return true;
+}
+
+// Removes and returns the next pending alarm whose deadline is at or before
+// |now_ms|, or NULL if there is none.
+// The caller must hold the |alarms_mutex|
+static alarm_t* pending_alarms_pop_expired(period_ms_t now_ms) {
+  if (alarm_wheel)
+    return static_cast<alarm_t*>(timer_wheel_pop_expired(alarm_wheel, now_ms));
+
+  alarm_t* alarm = alarms.Front();
+  if (alarm == NULL || alarm->deadline > now_ms) return NULL;
+  alarms.Remove(alarm);
+  return alarm;
+}
+
+// Picks the deadline for an alarm that is due at |deadline| but may fire up
+// to |slack| ms late. Prefers the wakeup that is already programmed, then a
+// boundary on a power-of-two grid derived from |slack|, so that independent
+// alarms with similar slack end up sharing a wakeup.
+// The caller must hold the |alarms_mutex|
+static period_ms_t deadline_with_slack(period_ms_t deadline,
+                                       period_ms_t slack) {
+  if (slack == 0) return deadline;
+  if (root_deadline >= deadline && root_deadline - deadline <= slack)
+    return root_deadline;
+
+  period_ms_t granularity = 1;
+  while (granularity <= slack / 2) granularity <<= 1;
+  return (deadline + granularity - 1) & ~(granularity - 1);
+}
+
+static size_t pending_alarms_count(void) {
+  return alarm_wheel ? timer_wheel_size(alarm_wheel) : alarms.Size();
+}
+
 // Must be called with |alarms_mutex| held
 static void schedule_next_instance(alarm_t* alarm) {
   // If the alarm is currently set and it's at the start of the list,
   // we'll need to re-schedule since we've adjusted the earliest deadline.
-  bool needs_reschedule =
-      (!list_is_empty(alarms) && list_front(alarms) == alarm);
+  bool needs_reschedule = pending_alarm_is_next(alarm);
   if (alarm->callback) remove_pending_alarm(alarm);
 
   // Calculate the next deadline for this alarm
@@ -443,28 +566,32 @@ static void schedule_next_instance(alarm_t* alarm) {
   period_ms_t ms_into_period = 0;
   if ((alarm->is_periodic) && (alarm->period != 0))
     ms_into_period = ((just_now - alarm->creation_time) % alarm->period);
-  alarm->deadline = just_now + (alarm->period - ms_into_period);
-
-  // Add it into the timer list sorted by deadline (earliest deadline first).
-  if (list_is_empty(alarms) ||
-      ((alarm_t*)list_front(alarms))->deadline > alarm->deadline) {
-    list_prepend(alarms, alarm);
-  } else {
-    for (list_node_t* node = list_begin(alarms); node != list_end(alarms);
-         node = list_next(node)) {
-      list_node_t* next = list_next(node);
-      if (next == list_end(alarms) ||
-          ((alarm_t*)list_node(next))->deadline > alarm->deadline) {
-        list_insert_after(alarms, node, alarm);
-        break;
-      }
-    }
+  alarm->deadline =
+      deadline_with_slack(just_now + (alarm->period - ms_into_period),
+                          alarm->slack);
+
+  if (alarm_wheel) {
+    timer_wheel_insert(alarm_wheel, &alarm->wheel_node, alarm->deadline,
+                       alarm);
+    if (needs_reschedule || alarm->deadline < root_deadline)
+      reschedule_root_alarm();
+    return;
   }
 
+  // Add it into the timer list sorted by deadline (earliest deadline first),
+  // after the alarms with the same deadline. Alarms are mostly set for later
+  // than the pending ones, so look for the place from the back.
+  alarm_t* prev = alarms.Back();
+  while (prev != NULL && prev->deadline > alarm->deadline)
+    prev = alarms.Prev(prev);
+  if (prev == NULL)
+    alarms.PushFront(alarm);
+  else
+    alarms.InsertAfter(prev, alarm);
+
   // If the new alarm has the earliest deadline, we need to re-evaluate our
   // schedule.
-  if (needs_reschedule ||
-      (!list_is_empty(alarms) && list_front(alarms) == alarm)) {
+  if (needs_reschedule || pending_alarm_is_next(alarm)) {
     reschedule_root_alarm();
   }
 }
@@ -472,30 +599,31 @@ static void schedule_next_instance(alarm_t* alarm) {
 // NOTE: must be called with |alarms_mutex| held
 __attribute__((no_sanitize("integer")))
 static void reschedule_root_alarm(void) {
-  CHECK(alarms != NULL);
+  CHECK(alarms_initialized());
 
   const bool timer_was_set = timer_set;
-  alarm_t* next;
+  period_ms_t next_deadline;
   int64_t next_expiration;
 
   // If used in a zeroed state, disarms the timer.
   struct itimerspec timer_time;
   memset(&timer_time, 0, sizeof(timer_time));
 
-  if (list_is_empty(alarms)) goto done;
+  root_deadline = UINT64_MAX;
+  if (!pending_alarms_next_deadline(&next_deadline)) goto done;
 
-  next = static_cast<alarm_t*>(list_front(alarms));
-  next_expiration = next->deadline - now();
+  root_deadline = next_deadline;
+  next_expiration = next_deadline - now();
   if (next_expiration < TIMER_INTERVAL_FOR_WAKELOCK_IN_MS) {
     if (!timer_set) {
-      if (!wakelock_acquire()) {
+      if (!wakelock_acquire_ref(WAKELOCK_REQUESTER)) {
         LOG_ERROR(LOG_TAG, "%s unable to acquire wake lock", __func__);
         goto done;
       }
     }
 
-    timer_time.it_value.tv_sec = (next->deadline / 1000);
-    timer_time.it_value.tv_nsec = (next->deadline % 1000) * 1000000LL;
+    timer_time.it_value.tv_sec = (next_deadline / 1000);
+    timer_time.it_value.tv_nsec = (next_deadline % 1000) * 1000000LL;
 
     // It is entirely unsafe to call timer_settime(2) with a zeroed timerspec
     // for timers with *_ALARM clock IDs. Although the man page states that the
@@ -520,8 +648,8 @@ static void reschedule_root_alarm(void) {
     struct itimerspec wakeup_time;
     memset(&wakeup_time, 0, sizeof(wakeup_time));
 
-    wakeup_time.it_value.tv_sec = (next->deadline / 1000);
-    wakeup_time.it_value.tv_nsec = (next->deadline % 1000) * 1000000LL;
+    wakeup_time.it_value.tv_sec = (next_deadline / 1000);
+    wakeup_time.it_value.tv_nsec = (next_deadline % 1000) * 1000000LL;
     if (timer_settime(wakeup_timer, TIMER_ABSTIME, &wakeup_time, NULL) == -1)
       LOG_ERROR(LOG_TAG, "%s unable to set wakeup timer: %s", __func__,
                 strerror(errno));
@@ -531,7 +659,7 @@ done:
   timer_set =
       timer_time.it_value.tv_sec != 0 || timer_time.it_value.tv_nsec != 0;
   if (timer_was_set && !timer_set) {
-    wakelock_release();
+    wakelock_release_ref(WAKELOCK_REQUESTER, TIMER_WAKELOCK_LINGER_MS);
   }
 
   if (timer_settime(timer, TIMER_ABSTIME, &timer_time, NULL) == -1)
@@ -600,6 +728,9 @@ static void alarm_ready_generic(alarm_t* alarm,
   std::lock_guard<std::recursive_mutex> cb_lock(*local_mutex_ref);
   lock.unlock();
 
+  period_ms_t start = now();
+  counters_histogram_record(callback_delay,
+                            start > deadline ? start - deadline : 0);
   callback(data);
 }
 
@@ -631,39 +762,39 @@ static void callback_dispatch(UNUSED_ATTR void* context) {
     if (!dispatcher_thread_active) break;
 
     std::lock_guard<std::mutex> lock(alarms_mutex);
-    alarm_t* alarm;
-
-    // Take into account that the alarm may get cancelled before we get to it.
-    // We're done here if there are no alarms or the alarm at the front is in
-    // the future. Exit right away since there's nothing left to do.
-    if (list_is_empty(alarms) ||
-        (alarm = static_cast<alarm_t*>(list_front(alarms)))->deadline > now()) {
-      reschedule_root_alarm();
-      continue;
-    }
-
-    list_remove(alarms, alarm);
-
-    if (alarm->is_periodic) {
-      alarm->prev_deadline = alarm->deadline;
-      schedule_next_instance(alarm);
-      alarm->stats.rescheduled_count++;
-    }
-    reschedule_root_alarm();
 
-    // Enqueue the alarm for processing
-    if (alarm->for_msg_loop) {
-      if (!get_message_loop()) {
-        LOG_ERROR(LOG_TAG, "%s: message loop already NULL. Alarm: %s", __func__,
-                  alarm->stats.name);
-        continue;
+    // Take into account that alarms may get cancelled before we get to them.
+    // Dispatch every alarm that has expired by now in one pass. The pass is
+    // bounded by the number of pending alarms so that a periodic alarm which
+    // is immediately due again cannot starve the rest of the system.
+    const period_ms_t just_now = now();
+    size_t budget = pending_alarms_count();
+    size_t dispatched = 0;
+    alarm_t* alarm;
+    while (budget-- > 0 &&
+           (alarm = pending_alarms_pop_expired(just_now)) != NULL) {
+      if (dispatched++ > 0) coalesced_wakeups++;
+      if (alarm->is_periodic) {
+        alarm->prev_deadline = alarm->deadline;
+        schedule_next_instance(alarm);
+        alarm->stats.rescheduled_count++;
       }
 
-      alarm->closure.i.Reset(Bind(alarm_ready_mloop, alarm));
-      get_message_loop()->task_runner()->PostTask(FROM_HERE, alarm->closure.i.callback());
-    } else {
-      fixed_queue_enqueue(alarm->queue, alarm);
+      // Enqueue the alarm for processing
+      if (alarm->for_msg_loop) {
+        if (!get_message_loop()) {
+          LOG_ERROR(LOG_TAG, "%s: message loop already NULL. Alarm: %s",
+                    __func__, alarm->stats.name);
+          continue;
+        }
+
+        alarm->closure.i.Reset(Bind(alarm_ready_mloop, alarm));
+        get_message_loop()->task_runner()->PostTask(FROM_HERE, alarm->closure.i.callback());
+      } else {
+        fixed_queue_enqueue(alarm->queue, alarm);
+      }
     }
+    reschedule_root_alarm();
   }
 
   LOG_DEBUG(LOG_TAG, "%s Callback thread exited", __func__);
@@ -725,7 +856,7 @@ static void update_scheduling_stats(alarm_stats_t* stats, period_ms_t now_ms,
 }
 #endif
 
-static void dump_stat(int fd, stat_t* stat, const char* description) {
+static void dump_stat(int fd, const stat_t* stat, const char* description) {
   period_ms_t average_time_ms = 0;
   if (stat->count != 0) average_time_ms = stat->total_ms / stat->count;
 
@@ -734,28 +865,68 @@ static void dump_stat(int fd, stat_t* stat, const char* description) {
           (unsigned long long)average_time_ms);
 }
 
+static void collect_pending_alarm(void* context, void* user_data) {
+  static_cast<std::vector<alarm_t*>*>(user_data)->push_back(
+      static_cast<alarm_t*>(context));
+}
+
+// Copy of a pending alarm taken under |alarms_mutex|, so the alarm can be
+// freed or rescheduled while the dump is written.
+typedef struct {
+  std::string name;
+  bool is_periodic;
+  period_ms_t creation_time;
+  period_ms_t period;
+  period_ms_t deadline;
+  alarm_stats_t stats;
+} alarm_snapshot_t;
+
 void alarm_debug_dump(int fd) {
   dprintf(fd, "\nBluetooth Alarms Statistics:\n");
 
-  std::lock_guard<std::mutex> lock(alarms_mutex);
+  std::vector<alarm_snapshot_t> snapshot;
+  size_t wakeups;
+  period_ms_t just_now;
+  {
+    std::lock_guard<std::mutex> lock(alarms_mutex);
 
-  if (alarms == NULL) {
-    dprintf(fd, "  None\n");
-    return;
-  }
+    if (!alarms_initialized()) {
+      dprintf(fd, "  None\n");
+      return;
+    }
 
-  period_ms_t just_now = now();
+    just_now = now();
+    wakeups = coalesced_wakeups;
+
+    // Dump in deadline order regardless of the pending alarm backend.
+    std::vector<alarm_t*> pending;
+    if (alarm_wheel) {
+      timer_wheel_foreach(alarm_wheel, collect_pending_alarm, &pending);
+      std::stable_sort(pending.begin(), pending.end(),
+                       [](const alarm_t* a, const alarm_t* b) {
+                         return a->deadline < b->deadline;
+                       });
+    } else {
+      for (alarm_t& alarm : alarms) pending.push_back(&alarm);
+    }
+
+    snapshot.reserve(pending.size());
+    for (const alarm_t* alarm : pending) {
+      snapshot.push_back({alarm->stats.name ? alarm->stats.name : "",
+                          alarm->is_periodic, alarm->creation_time,
+                          alarm->period, alarm->deadline, alarm->stats});
+    }
+  }
 
-  dprintf(fd, "  Total Alarms: %zu\n\n", list_length(alarms));
+  dprintf(fd, "  Total Alarms: %zu\n", snapshot.size());
+  dprintf(fd, "  Coalesced Wakeups: %zu\n\n", wakeups);
 
   // Dump info for each alarm
-  for (list_node_t* node = list_begin(alarms); node != list_end(alarms);
-       node = list_next(node)) {
-    alarm_t* alarm = (alarm_t*)list_node(node);
-    alarm_stats_t* stats = &alarm->stats;
+  for (const alarm_snapshot_t& alarm : snapshot) {
+    const alarm_stats_t* stats = &alarm.stats;
 
-    dprintf(fd, "  Alarm : %s (%s)\n", stats->name,
-            (alarm->is_periodic) ? "PERIODIC" : "SINGLE");
+    dprintf(fd, "  Alarm : %s (%s)\n", alarm.name.c_str(),
+            (alarm.is_periodic) ? "PERIODIC" : "SINGLE");
 
     dprintf(fd, "%-51s: %zu / %zu / %zu / %zu\n",
             "    Action counts (sched/resched/exec/cancel)",
@@ -768,9 +939,9 @@ void alarm_debug_dump(int fd) {
 
     dprintf(fd, "%-51s: %llu / %llu / %lld\n",
             "    Time in ms (since creation/interval/remaining)",
-            (unsigned long long)(just_now - alarm->creation_time),
-            (unsigned long long)alarm->period,
-            (long long)(alarm->deadline - just_now));
+            (unsigned long long)(just_now - alarm.creation_time),
+            (unsigned long long)alarm.period,
+            (long long)(alarm.deadline - just_now));
 
     dump_stat(fd, &stats->callback_execution,
               "    Callback execution time in ms (total/max/avg)");
@@ -23,13 +23,17 @@
 #include <base/logging.h>
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
+#include <atomic>
 #include <mutex>
 #include <pthread.h>
 #include <unordered_map>
+#include <vector>
 #include <sys/time.h>
 #include <sys/types.h>
 
 #include "osi/include/allocator.h"
+#include "osi/include/allocator_pool.h"
 #include "osi/include/compat.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
@@ -82,6 +86,43 @@ typedef struct {
 
 allocation_debug_t allocation_debug;
 
+// Allocation sampling. Bucket |i| counts sizes up to 16 << i bytes; the last
+// bucket counts everything larger.
+#define SAMPLING_SIZE_BUCKETS 16
+#define SAMPLING_MAX_ALLOCATORS 256
+#define SAMPLING_MAX_THREADS 32
+#define SAMPLING_MAX_CALL_SITES 256  // Must be a power of two.
+#define SAMPLING_TOP_CALL_SITES 10
+
+typedef struct {
+  size_t count;
+  size_t bytes;
+} sample_counter_t;
+
+typedef struct {
+  pid_t tid;
+  char name[16];
+  sample_counter_t counter;
+} sample_thread_t;
+
+typedef struct {
+  const void* caller;
+  sample_counter_t counter;
+} sample_site_t;
+
+static std::atomic<uint32_t> sampling_rate(0);
+static thread_local uint32_t sampling_countdown;
+static std::mutex sampling_lock;
+// The statistics below are guarded by |sampling_lock|.
+static sample_counter_t sampled_allocators[SAMPLING_MAX_ALLOCATORS];
+static sample_counter_t sampled_sizes[SAMPLING_SIZE_BUCKETS];
+static sample_thread_t sampled_threads[SAMPLING_MAX_THREADS];
+static size_t sampled_thread_count;
+static sample_counter_t sampled_other_threads;
+static sample_site_t sampled_sites[SAMPLING_MAX_CALL_SITES];
+static size_t sampled_site_count;
+static sample_counter_t sampled_other_sites;
+
 void allocation_tracker_init(void) {
   std::unique_lock<std::mutex> lock(tracker_lock);
   if (enabled) return;
@@ -255,6 +296,161 @@ size_t allocation_tracker_resize_for_canary(size_t size) {
   return (!enabled) ? size : size + (2 * canary_size);
 }
 
+static void sample_counter_add(sample_counter_t* counter, size_t size) {
+  counter->count++;
+  counter->bytes += size;
+}
+
+static size_t sample_size_bucket(size_t size) {
+  size_t bucket = 0;
+  while (bucket < SAMPLING_SIZE_BUCKETS - 1 && size > ((size_t)16 << bucket))
+    bucket++;
+  return bucket;
+}
+
+static sample_counter_t* sample_thread_counter(void) {
+  pid_t tid = gettid();
+  for (size_t i = 0; i < sampled_thread_count; i++) {
+    if (sampled_threads[i].tid == tid) return &sampled_threads[i].counter;
+  }
+  if (sampled_thread_count == SAMPLING_MAX_THREADS)
+    return &sampled_other_threads;
+
+  sample_thread_t* thread = &sampled_threads[sampled_thread_count++];
+  thread->tid = tid;
+  if (pthread_getname_np(pthread_self(), thread->name, sizeof(thread->name)))
+    thread->name[0] = '\0';
+  return &thread->counter;
+}
+
+static sample_counter_t* sample_site_counter(const void* caller) {
+  // Open addressing; the table is only ever cleared as a whole.
+  size_t mask = SAMPLING_MAX_CALL_SITES - 1;
+  size_t index = (((uintptr_t)caller >> 2) * 0x9E3779B1u) & mask;
+  for (size_t probe = 0; probe < SAMPLING_MAX_CALL_SITES; probe++) {
+    sample_site_t* site = &sampled_sites[(index + probe) & mask];
+    if (site->caller == caller) return &site->counter;
+    if (site->caller == NULL) {
+      // Keep a quarter of the table free so that probes stay short.
+      if (sampled_site_count >= SAMPLING_MAX_CALL_SITES * 3 / 4) break;
+      site->caller = caller;
+      sampled_site_count++;
+      return &site->counter;
+    }
+  }
+  return &sampled_other_sites;
+}
+
+void allocation_tracker_set_sampling_rate(uint32_t rate) {
+  std::unique_lock<std::mutex> lock(sampling_lock);
+
+  memset(sampled_allocators, 0, sizeof(sampled_allocators));
+  memset(sampled_sizes, 0, sizeof(sampled_sizes));
+  memset(sampled_threads, 0, sizeof(sampled_threads));
+  sampled_thread_count = 0;
+  memset(&sampled_other_threads, 0, sizeof(sampled_other_threads));
+  memset(sampled_sites, 0, sizeof(sampled_sites));
+  sampled_site_count = 0;
+  memset(&sampled_other_sites, 0, sizeof(sampled_other_sites));
+
+  sampling_rate.store(rate, std::memory_order_relaxed);
+}
+
+void allocation_tracker_sample_alloc(allocator_id_t allocator_id,
+                                     size_t requested_size,
+                                     const void* caller) {
+  uint32_t rate = sampling_rate.load(std::memory_order_relaxed);
+  if (rate == 0) return;
+
+  // Each thread counts down on its own so that the common case stays free of
+  // locks and shared cache lines.
+  if (sampling_countdown > rate) sampling_countdown = rate;
+  if (sampling_countdown > 1) {
+    sampling_countdown--;
+    return;
+  }
+  sampling_countdown = rate;
+
+  std::unique_lock<std::mutex> lock(sampling_lock);
+  sample_counter_add(&sampled_allocators[allocator_id], requested_size);
+  sample_counter_add(&sampled_sizes[sample_size_bucket(requested_size)],
+                     requested_size);
+  sample_counter_add(sample_thread_counter(), requested_size);
+  sample_counter_add(sample_site_counter(caller), requested_size);
+}
+
+void allocation_tracker_get_sampled(allocator_id_t allocator_id, size_t* count,
+                                    size_t* bytes) {
+  CHECK(count != NULL);
+  CHECK(bytes != NULL);
+
+  std::unique_lock<std::mutex> lock(sampling_lock);
+  *count = sampled_allocators[allocator_id].count;
+  *bytes = sampled_allocators[allocator_id].bytes;
+}
+
+static void sampling_debug_dump(int fd) {
+  uint32_t rate = sampling_rate.load(std::memory_order_relaxed);
+  if (rate == 0) {
+    dprintf(fd, "  Allocation sampling              : disabled\n");
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(sampling_lock);
+
+  dprintf(fd, "  Allocation sampling              : 1 in %u\n", rate);
+  dprintf(fd, "    Sampled counts/octets by allocator:\n");
+  for (size_t i = 0; i < SAMPLING_MAX_ALLOCATORS; i++) {
+    if (sampled_allocators[i].count == 0) continue;
+    dprintf(fd, "      Allocator %3zu : %zu / %zu\n", i,
+            sampled_allocators[i].count, sampled_allocators[i].bytes);
+  }
+
+  dprintf(fd, "    Sampled counts/octets by size:\n");
+  for (size_t i = 0; i < SAMPLING_SIZE_BUCKETS; i++) {
+    if (sampled_sizes[i].count == 0) continue;
+    if (i == SAMPLING_SIZE_BUCKETS - 1)
+      dprintf(fd, "      > %7zu     : %zu / %zu\n",
+              (size_t)16 << (SAMPLING_SIZE_BUCKETS - 2), sampled_sizes[i].count,
+              sampled_sizes[i].bytes);
+    else
+      dprintf(fd, "      <= %7zu    : %zu / %zu\n", (size_t)16 << i,
+              sampled_sizes[i].count, sampled_sizes[i].bytes);
+  }
+
+  dprintf(fd, "    Sampled counts/octets by thread:\n");
+  for (size_t i = 0; i < sampled_thread_count; i++) {
+    dprintf(fd, "      %5d %-16s : %zu / %zu\n", sampled_threads[i].tid,
+            sampled_threads[i].name, sampled_threads[i].counter.count,
+            sampled_threads[i].counter.bytes);
+  }
+  if (sampled_other_threads.count) {
+    dprintf(fd, "      (other threads)        : %zu / %zu\n",
+            sampled_other_threads.count, sampled_other_threads.bytes);
+  }
+
+  std::vector<const sample_site_t*> sites;
+  for (size_t i = 0; i < SAMPLING_MAX_CALL_SITES; i++) {
+    if (sampled_sites[i].caller) sites.push_back(&sampled_sites[i]);
+  }
+  std::sort(sites.begin(), sites.end(),
+            [](const sample_site_t* a, const sample_site_t* b) {
+              return a->counter.bytes > b->counter.bytes;
+            });
+  if (sites.size() > SAMPLING_TOP_CALL_SITES)
+    sites.resize(SAMPLING_TOP_CALL_SITES);
+
+  dprintf(fd, "    Top call sites by sampled octets:\n");
+  for (const sample_site_t* site : sites) {
+    dprintf(fd, "      %p : %zu / %zu\n", site->caller, site->counter.count,
+            site->counter.bytes);
+  }
+  if (sampled_other_sites.count) {
+    dprintf(fd, "      (other call sites)     : %zu / %zu\n",
+            sampled_other_sites.count, sampled_other_sites.bytes);
+  }
+}
+
 void osi_allocator_debug_dump(int fd) {
   dprintf(fd, "\nBluetooth Memory Allocation Statistics:\n");
 
@@ -265,4 +461,7 @@ void osi_allocator_debug_dump(int fd) {
   dprintf(fd, "  Total allocated/free/used octets : %zu / %zu / %zu\n",
           alloc_total_size, free_total_size,
           alloc_total_size - free_total_size);
+
+  allocator_pool_debug_dump(fd);
+  sampling_debug_dump(fd);
 }
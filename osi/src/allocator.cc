@@ -21,6 +21,7 @@
 
 #include "osi/include/allocation_tracker.h"
 #include "osi/include/allocator.h"
+#include "osi/include/allocator_pool.h"
 
 static const allocator_id_t alloc_allocator_id = 42;
 
@@ -29,6 +30,8 @@ char* osi_strdup(const char* str) {
   size_t real_size = allocation_tracker_resize_for_canary(size);
   void* ptr = malloc(real_size);
   CHECK(ptr);
+  allocation_tracker_sample_alloc(alloc_allocator_id, size,
+                                  __builtin_return_address(0));
 
   char* new_string = static_cast<char*>(
       allocation_tracker_notify_alloc(alloc_allocator_id, ptr, size));
@@ -45,6 +48,8 @@ char* osi_strndup(const char* str, size_t len) {
   size_t real_size = allocation_tracker_resize_for_canary(size + 1);
   void* ptr = malloc(real_size);
   CHECK(ptr);
+  allocation_tracker_sample_alloc(alloc_allocator_id, size + 1,
+                                  __builtin_return_address(0));
 
   char* new_string = static_cast<char*>(
       allocation_tracker_notify_alloc(alloc_allocator_id, ptr, size + 1));
@@ -58,21 +63,31 @@ char* osi_strndup(const char* str, size_t len) {
 void* osi_malloc(size_t size) {
   CHECK(static_cast<ssize_t>(size) >= 0);
   size_t real_size = allocation_tracker_resize_for_canary(size);
-  void* ptr = malloc(real_size);
+  void* ptr = allocator_pool_alloc(real_size);
+  if (!ptr) ptr = malloc(real_size);
   CHECK(ptr);
+  allocation_tracker_sample_alloc(alloc_allocator_id, size,
+                                  __builtin_return_address(0));
   return allocation_tracker_notify_alloc(alloc_allocator_id, ptr, size);
 }
 
 void* osi_calloc(size_t size) {
   CHECK(static_cast<ssize_t>(size) >= 0);
   size_t real_size = allocation_tracker_resize_for_canary(size);
-  void* ptr = calloc(1, real_size);
+  void* ptr = allocator_pool_alloc(real_size);
+  if (ptr)
+    memset(ptr, 0, real_size);
+  else
+    ptr = calloc(1, real_size);
   CHECK(ptr);
+  allocation_tracker_sample_alloc(alloc_allocator_id, size,
+                                  __builtin_return_address(0));
   return allocation_tracker_notify_alloc(alloc_allocator_id, ptr, size);
 }
 
 void osi_free(void* ptr) {
-  free(allocation_tracker_notify_free(alloc_allocator_id, ptr));
+  void* real_ptr = allocation_tracker_notify_free(alloc_allocator_id, ptr);
+  if (!allocator_pool_free(real_ptr)) free(real_ptr);
 }
 
 void osi_free_and_reset(void** p_ptr) {
@@ -81,6 +96,10 @@ void osi_free_and_reset(void** p_ptr) {
   *p_ptr = NULL;
 }
 
+void osi_allocator_get_sampled(size_t* count, size_t* bytes) {
+  allocation_tracker_get_sampled(alloc_allocator_id, count, bytes);
+}
+
 const allocator_t allocator_calloc = {osi_calloc, osi_free};
 
 const allocator_t allocator_malloc = {osi_malloc, osi_free};
@@ -0,0 +1,272 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_osi_allocator_pool"
+
+#include "osi/include/allocator_pool.h"
+
+#include <base/logging.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <mutex>
+
+#include "osi/include/log.h"
+
+// Blocks are rounded up to this alignment so that any type can live in them.
+#define POOL_BLOCK_ALIGNMENT 16
+
+// Maximum number of free blocks a thread keeps per class before handing a
+// batch back to the shared free list.
+#define POOL_THREAD_CACHE_MAX 32
+
+// Number of blocks moved between the shared free list and a thread cache in
+// one locked operation.
+#define POOL_THREAD_CACHE_BATCH 8
+
+typedef struct pool_block_t {
+  struct pool_block_t* next;
+} pool_block_t;
+
+typedef struct {
+  size_t block_size;
+  size_t block_count;
+  uint8_t* base;
+  uint8_t* end;
+
+  std::mutex lock;
+  pool_block_t* free_list;  // guarded by |lock|
+
+  std::atomic<size_t> in_use;
+  std::atomic<size_t> high_water;
+  std::atomic<size_t> hits;
+  std::atomic<size_t> misses;
+} pool_class_t;
+
+typedef struct {
+  bool registered;
+  pool_block_t* head[ALLOCATOR_POOL_MAX_CLASSES];
+  size_t count[ALLOCATOR_POOL_MAX_CLASSES];
+} thread_cache_t;
+
+static pool_class_t pool_classes[ALLOCATOR_POOL_MAX_CLASSES];
+static size_t pool_num_classes;
+static size_t pool_min_size;
+static std::atomic<bool> pool_enabled(false);
+static std::mutex pool_init_lock;
+static pthread_key_t pool_cache_key;
+
+static thread_local thread_cache_t thread_cache;
+
+static void thread_cache_flush(pool_class_t* pool_class, thread_cache_t* cache,
+                               size_t index, size_t count);
+static void thread_cache_destroy(void* context);
+
+bool allocator_pool_init(const allocator_pool_class_t* classes,
+                         size_t num_classes, size_t min_size) {
+  CHECK(classes != NULL);
+  CHECK(num_classes > 0 && num_classes <= ALLOCATOR_POOL_MAX_CLASSES);
+
+  std::lock_guard<std::mutex> lock(pool_init_lock);
+  if (pool_enabled.load(std::memory_order_acquire)) return false;
+
+  if (pthread_key_create(&pool_cache_key, thread_cache_destroy) != 0) {
+    LOG_ERROR(LOG_TAG, "%s unable to create thread cache key", __func__);
+    return false;
+  }
+
+  for (size_t i = 0; i < num_classes; i++) {
+    CHECK(classes[i].block_count > 0);
+    CHECK(i == 0 || classes[i].block_size > classes[i - 1].block_size);
+
+    pool_class_t* pool_class = &pool_classes[i];
+    pool_class->block_size =
+        (classes[i].block_size + POOL_BLOCK_ALIGNMENT - 1) &
+        ~(size_t)(POOL_BLOCK_ALIGNMENT - 1);
+    pool_class->block_count = classes[i].block_count;
+
+    size_t arena_size = pool_class->block_size * pool_class->block_count;
+    pool_class->base = static_cast<uint8_t*>(
+        aligned_alloc(POOL_BLOCK_ALIGNMENT, arena_size));
+    CHECK(pool_class->base);
+    pool_class->end = pool_class->base + arena_size;
+
+    pool_class->free_list = NULL;
+    for (size_t j = pool_class->block_count; j > 0; j--) {
+      pool_block_t* block = reinterpret_cast<pool_block_t*>(
+          pool_class->base + (j - 1) * pool_class->block_size);
+      block->next = pool_class->free_list;
+      pool_class->free_list = block;
+    }
+  }
+
+  pool_num_classes = num_classes;
+  pool_min_size = min_size;
+  pool_enabled.store(true, std::memory_order_release);
+
+  LOG_INFO(LOG_TAG, "%s enabled with %zu size classes", __func__, num_classes);
+  return true;
+}
+
+bool allocator_pool_is_enabled(void) {
+  return pool_enabled.load(std::memory_order_acquire);
+}
+
+static thread_cache_t* get_thread_cache(void) {
+  thread_cache_t* cache = &thread_cache;
+  if (!cache->registered) {
+    // The key destructor returns cached blocks when the thread exits.
+    pthread_setspecific(pool_cache_key, cache);
+    cache->registered = true;
+  }
+  return cache;
+}
+
+static void note_block_taken(pool_class_t* pool_class) {
+  pool_class->hits.fetch_add(1, std::memory_order_relaxed);
+  size_t in_use = pool_class->in_use.fetch_add(1, std::memory_order_relaxed) + 1;
+  size_t high_water = pool_class->high_water.load(std::memory_order_relaxed);
+  while (in_use > high_water &&
+         !pool_class->high_water.compare_exchange_weak(
+             high_water, in_use, std::memory_order_relaxed)) {
+  }
+}
+
+void* allocator_pool_alloc(size_t size) {
+  if (!pool_enabled.load(std::memory_order_acquire)) return NULL;
+  if (size < pool_min_size) return NULL;
+
+  size_t index = 0;
+  while (index < pool_num_classes && pool_classes[index].block_size < size)
+    index++;
+  if (index == pool_num_classes) return NULL;
+
+  pool_class_t* pool_class = &pool_classes[index];
+  thread_cache_t* cache = get_thread_cache();
+
+  if (cache->head[index] == NULL) {
+    // Refill the thread cache with a batch from the shared free list.
+    std::lock_guard<std::mutex> lock(pool_class->lock);
+    for (size_t i = 0;
+         i < POOL_THREAD_CACHE_BATCH && pool_class->free_list != NULL; i++) {
+      pool_block_t* block = pool_class->free_list;
+      pool_class->free_list = block->next;
+      block->next = cache->head[index];
+      cache->head[index] = block;
+      cache->count[index]++;
+    }
+  }
+
+  pool_block_t* block = cache->head[index];
+  if (block == NULL) {
+    pool_class->misses.fetch_add(1, std::memory_order_relaxed);
+    return NULL;
+  }
+
+  cache->head[index] = block->next;
+  cache->count[index]--;
+  note_block_taken(pool_class);
+  return block;
+}
+
+bool allocator_pool_free(void* ptr) {
+  if (ptr == NULL || !pool_enabled.load(std::memory_order_acquire))
+    return false;
+
+  uint8_t* address = static_cast<uint8_t*>(ptr);
+  for (size_t index = 0; index < pool_num_classes; index++) {
+    pool_class_t* pool_class = &pool_classes[index];
+    if (address < pool_class->base || address >= pool_class->end) continue;
+
+    CHECK((address - pool_class->base) % pool_class->block_size == 0);
+
+    pool_class->in_use.fetch_sub(1, std::memory_order_relaxed);
+
+    thread_cache_t* cache = get_thread_cache();
+    pool_block_t* block = reinterpret_cast<pool_block_t*>(ptr);
+    block->next = cache->head[index];
+    cache->head[index] = block;
+    cache->count[index]++;
+
+    if (cache->count[index] > POOL_THREAD_CACHE_MAX)
+      thread_cache_flush(pool_class, cache, index,
+                         POOL_THREAD_CACHE_MAX - POOL_THREAD_CACHE_BATCH);
+    return true;
+  }
+
+  return false;
+}
+
+// Moves |count| blocks from the thread cache back to the shared free list.
+static void thread_cache_flush(pool_class_t* pool_class, thread_cache_t* cache,
+                               size_t index, size_t count) {
+  std::lock_guard<std::mutex> lock(pool_class->lock);
+  for (size_t i = 0; i < count && cache->head[index] != NULL; i++) {
+    pool_block_t* block = cache->head[index];
+    cache->head[index] = block->next;
+    cache->count[index]--;
+    block->next = pool_class->free_list;
+    pool_class->free_list = block;
+  }
+}
+
+static void thread_cache_destroy(void* context) {
+  thread_cache_t* cache = static_cast<thread_cache_t*>(context);
+  for (size_t index = 0; index < pool_num_classes; index++) {
+    thread_cache_flush(&pool_classes[index], cache, index,
+                       cache->count[index]);
+  }
+  cache->registered = false;
+}
+
+size_t allocator_pool_get_stats(allocator_pool_stats_t* stats,
+                                size_t max_classes) {
+  CHECK(stats != NULL);
+  if (!pool_enabled.load(std::memory_order_acquire)) return 0;
+
+  size_t count = (max_classes < pool_num_classes) ? max_classes
+                                                  : pool_num_classes;
+  for (size_t i = 0; i < count; i++) {
+    const pool_class_t* pool_class = &pool_classes[i];
+    stats[i].block_size = pool_class->block_size;
+    stats[i].block_count = pool_class->block_count;
+    stats[i].in_use = pool_class->in_use.load(std::memory_order_relaxed);
+    stats[i].high_water =
+        pool_class->high_water.load(std::memory_order_relaxed);
+    stats[i].hits = pool_class->hits.load(std::memory_order_relaxed);
+    stats[i].misses = pool_class->misses.load(std::memory_order_relaxed);
+  }
+  return count;
+}
+
+void allocator_pool_debug_dump(int fd) {
+  allocator_pool_stats_t stats[ALLOCATOR_POOL_MAX_CLASSES];
+  size_t count = allocator_pool_get_stats(stats, ALLOCATOR_POOL_MAX_CLASSES);
+
+  dprintf(fd, "  Buffer pool                      : %s\n",
+          count ? "enabled" : "disabled");
+  for (size_t i = 0; i < count; i++) {
+    dprintf(fd,
+            "    Class %zu (%zu bytes x %zu) in use/high water : %zu / %zu"
+            "  hit/miss : %zu / %zu\n",
+            i, stats[i].block_size, stats[i].block_count, stats[i].in_use,
+            stats[i].high_water, stats[i].hits, stats[i].misses);
+  }
+}
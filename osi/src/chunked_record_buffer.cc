@@ -0,0 +1,97 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "osi/include/chunked_record_buffer.h"
+
+#include <string.h>
+
+#include <base/logging.h>
+
+namespace system_bt_osi {
+
+ChunkedRecordBuffer::ChunkedRecordBuffer(size_t chunk_size, size_t max_bytes,
+                                         size_t max_records)
+    : chunk_size_(chunk_size),
+      max_bytes_(max_bytes),
+      max_records_(max_records),
+      bytes_(0),
+      spare_{nullptr, 0, 0, 0} {
+  CHECK(chunk_size_ > 0);
+}
+
+size_t ChunkedRecordBuffer::Append(const std::string& record) {
+  size_t size = record.size();
+  if (size == 0 || size > max_bytes_ || max_records_ == 0) return 1;
+
+  size_t dropped = 0;
+  while (!record_sizes_.empty() &&
+         (record_sizes_.size() >= max_records_ || bytes_ + size > max_bytes_)) {
+    DropOldest();
+    dropped++;
+  }
+
+  if (chunks_.empty() ||
+      chunks_.back().capacity - chunks_.back().end < size) {
+    chunks_.push_back(NewChunk(size > chunk_size_ ? size : chunk_size_));
+  }
+  Chunk& chunk = chunks_.back();
+  memcpy(chunk.data.get() + chunk.end, record.data(), size);
+  chunk.end += size;
+  record_sizes_.push_back(size);
+  bytes_ += size;
+  return dropped;
+}
+
+void ChunkedRecordBuffer::AppendTo(std::string* out) const {
+  out->reserve(out->size() + bytes_);
+  for (const Chunk& chunk : chunks_) {
+    out->append(reinterpret_cast<const char*>(chunk.data.get() + chunk.begin),
+                chunk.end - chunk.begin);
+  }
+}
+
+void ChunkedRecordBuffer::Clear() {
+  while (!record_sizes_.empty()) DropOldest();
+}
+
+void ChunkedRecordBuffer::DropOldest() {
+  // Records never span chunks, so the oldest one is in the first chunk
+  Chunk& chunk = chunks_.front();
+  chunk.begin += record_sizes_.front();
+  bytes_ -= record_sizes_.front();
+  record_sizes_.pop_front();
+  if (chunk.begin < chunk.end) return;
+
+  if (chunk.capacity == chunk_size_) {
+    spare_ = std::move(chunk);
+    spare_.begin = spare_.end = 0;
+  }
+  chunks_.pop_front();
+}
+
+ChunkedRecordBuffer::Chunk ChunkedRecordBuffer::NewChunk(size_t capacity) {
+  if (capacity == chunk_size_ && spare_.data) {
+    Chunk chunk = std::move(spare_);
+    spare_ = Chunk{nullptr, 0, 0, 0};
+    return chunk;
+  }
+  return Chunk{std::unique_ptr<uint8_t[]>(new uint8_t[capacity]), capacity, 0,
+               0};
+}
+
+}  // namespace system_bt_osi
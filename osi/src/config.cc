@@ -35,6 +35,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <type_traits>
@@ -43,6 +44,7 @@
 #include "osi/include/list.h"
 #include "osi/include/log.h"
 #include "osi/include/compat.h"
+#include "osi/include/osi.h"
 #include "log/log.h"
 #include "bt_target.h"
 #include <inttypes.h>
@@ -53,47 +55,42 @@ static void entry_free(void* ptr);
 
 // Empty definition; this type is aliased to list_node_t.
 void section_t::Set(std::string key, std::string value) {
-  for (entry_t& entry : entries) {
-    if (entry.key == key) {
-      entry.value = value;
-      return;
-    }
+  auto entry = entries.Find(key);
+  if (entry != entries.end()) {
+    entry->value = std::move(value);
+    return;
   }
   // add a new key to the section
   entries.emplace_back(
       entry_t{.key = std::move(key), .value = std::move(value)});
 }
 
-std::list<entry_t>::iterator section_t::Find(const std::string& key) {
-  return std::find_if(
-      entries.begin(), entries.end(),
-      [&key](const entry_t& entry) { return entry.key == key; });
+IndexedList<entry_t, &entry_t::key>::iterator section_t::Find(
+    const std::string& key) {
+  return entries.Find(key);
 }
 
 bool section_t::Has(const std::string& key) {
   return Find(key) != entries.end();
 }
 
-std::list<section_t>::iterator config_t::Find(const std::string& section) {
-  return std::find_if(
-      sections.begin(), sections.end(),
-      [&section](const section_t& sec) { return sec.name == section; });
+IndexedList<section_t, &section_t::name>::iterator config_t::Find(
+    const std::string& section) {
+  return sections.Find(section);
 }
 
 bool config_t::Has(const std::string& key) {
   return Find(key) != sections.end();
 }
 
-static bool config_parse(FILE* fp, config_t* config);
+static bool config_parse(const char* data, size_t size, config_t* config);
 
 template <typename T,
           class = typename std::enable_if<std::is_same<
               config_t, typename std::remove_const<T>::type>::value>>
 
 static auto section_find(T& config, const std::string& section) {
-  return std::find_if(
-      config.sections.begin(), config.sections.end(),
-      [&section](const section_t& sec) { return sec.name == section; });
+  return config.sections.Find(section);
 }
 
 static const entry_t* entry_find(const config_t& config,
@@ -101,10 +98,9 @@ static const entry_t* entry_find(const config_t& config,
                                  const std::string& key) {
   auto sec = section_find(config, section);
   if (sec == config.sections.end()) return nullptr;
-  for (const entry_t& entry : sec->entries) {
-    if (entry.key == key) return &entry;
-  }
-  return nullptr;
+  auto entry = sec->entries.Find(key);
+  if (entry == sec->entries.end()) return nullptr;
+  return &*entry;
 }
 
 std::unique_ptr<config_t> config_new_empty(void) {
@@ -117,20 +113,50 @@ std::unique_ptr<config_t> config_new(const char* filename) {
 
   std::unique_ptr<config_t> config = config_new_empty();
 
-  FILE* fp = fopen(filename, "rt");
-  if (!fp) {
+  int fd;
+  OSI_NO_INTR(fd = open(filename, O_RDONLY | O_CLOEXEC));
+  if (fd < 0) {
     LOG(ERROR) << LOG_TAG <<   ": unable to open file '" << filename
                << "': " << strerror(errno);
-   // config_free(config.get());
     return nullptr;
   }
 
-  if (!config_parse(fp, config.get())) {
-    config.reset();
-    config = NULL;
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    LOG(ERROR) << __func__ << ": unable to stat file '" << filename
+               << "': " << strerror(errno);
+    close(fd);
+    return nullptr;
   }
 
-  fclose(fp);
+  // The file is parsed straight from a read-only mapping, so no line is
+  // copied before its key and value land in the config.
+  size_t size = st.st_size;
+  void* data = MAP_FAILED;
+  if (S_ISREG(st.st_mode) && size > 0)
+    data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  bool parsed;
+  if (data != MAP_FAILED) {
+    madvise(data, size, MADV_SEQUENTIAL);
+    parsed = config_parse(static_cast<const char*>(data), size, config.get());
+    munmap(data, size);
+  } else {
+    // Empty or special files, which cannot be mapped
+    std::string contents;
+    char buf[4096];
+    ssize_t len;
+    while (true) {
+      OSI_NO_INTR(len = read(fd, buf, sizeof(buf)));
+      if (len <= 0) break;
+      contents.append(buf, len);
+    }
+    parsed = len == 0 &&
+             config_parse(contents.data(), contents.size(), config.get());
+  }
+  close(fd);
+
+  if (!parsed) return nullptr;
   return config;
 }
 
@@ -273,11 +299,10 @@ void config_set_string(config_t* config, const std::string& section, const std::
     value_no_newline = value_string;
   }
 
-  for (entry_t& entry : sec->entries) {
-    if (entry.key == key) {
-      entry.value = value;
-        return;
-    }
+  auto entry = sec->entries.Find(key);
+  if (entry != sec->entries.end()) {
+    entry->value = value;
+    return;
   }
 
   sec->entries.emplace_back(entry_t{.key = key, .value = value});
@@ -302,25 +327,22 @@ bool config_remove_key(config_t* config, const char* section, const char* key) {
   if (sec == config->sections.end()) return false;
 
 
-  for (auto entry = sec->entries.begin(); entry != sec->entries.end();
-       ++entry) {
-    if (entry->key == key) {
-      sec->entries.erase(entry);
-      return true;
-    }
-  }
-  return false;
+  auto entry = sec->entries.Find(key);
+  if (entry == sec->entries.end()) return false;
+
+  sec->entries.erase(entry);
+  return true;
 }
 
 
 const config_section_node_t* config_section_begin(const config_t* config) {
   CHECK(config != NULL);
-  return (const config_section_node_t*)list_begin(config->sections);
+  return (const config_section_node_t*)list_begin(config->sections.list());
 }
 
 const config_section_node_t* config_section_end(const config_t* config) {
   CHECK(config != NULL);
-  return (const config_section_node_t*)list_end(config->sections);
+  return (const config_section_node_t*)list_end(config->sections.list());
 }
 
 const config_section_node_t* config_section_next(
@@ -347,7 +369,11 @@ bool config_remove_section_optimal(config_t* config,section_t* section) {
   CHECK(config != NULL);
   CHECK(section != NULL);
 
-  return list_remove(config->sections, section);
+  auto sec = config->sections.Find(section->name);
+  if (sec == config->sections.end() || &*sec != section) return false;
+
+  config->sections.erase(sec);
+  return true;
 }
 
 bool section_has_key(const section_t* section,
@@ -355,13 +381,7 @@ bool section_has_key(const section_t* section,
   CHECK(section != NULL);
   CHECK(key != NULL);
 
-  for (const list_node_t* node = list_begin(section->entries);
-       node != list_end(section->entries); node = list_next(node)) {
-    entry_t* entry = static_cast<entry_t*>(list_node(node));
-    if (!strcmp(entry->key.c_str(), key)) return true;
-  }
-
-  return false;
+  return section->entries.Find(key) != section->entries.end();
 }
 
 #if (BT_IOT_LOGGING_ENABLED == TRUE)
@@ -369,18 +389,18 @@ void config_sections_sort_by_entry_key(config_t* config, compare_func comp) {
   LOG(INFO) << __func__;
   CHECK(config != NULL);
 
-  for (list_node_t* node = list_begin(config->sections);
-      node != list_end(config->sections);
+  for (list_node_t* node = list_begin(config->sections.list());
+      node != list_end(config->sections.list());
       node = list_next(node)) {
     section_t* sec = (section_t*)list_node(node);
-    if (list_length(sec->entries) <= 1)
+    if (sec->entries.size() <= 1)
       continue;
-    list_node_t* p = list_end(sec->entries);
-    list_node_t* head_next = list_next(list_begin(sec->entries));
+    list_node_t* p = list_end(sec->entries.list());
+    list_node_t* head_next = list_next(list_begin(sec->entries.list()));
     bool changed = true;
 
     while (p != head_next && changed) {
-      list_node_t* q = list_begin(sec->entries);
+      list_node_t* q = list_begin(sec->entries.list());
       changed = false;
       for (;list_next(q) && list_next(q) != p; q = list_next(q)) {
         entry_t* first = (entry_t*)list_node(q);
@@ -399,7 +419,8 @@ void config_sections_sort_by_entry_key(config_t* config, compare_func comp) {
       }
       p = q;
     }
-
+    // The keys were swapped in place
+    sec->entries.Reindex();
   }
 }
 #endif
@@ -637,97 +658,86 @@ error2:
   return false;
 }
 
-static char* trim(char* str) {
-  while (isspace(*str)) ++str;
-
-  if (!*str) return str;
-
-  char* end_str = str + strlen(str) - 1;
-  while (end_str > str && isspace(*end_str)) --end_str;
-
-  end_str[1] = '\0';
-  return str;
+// Narrows [|*begin|, |*end|) to leave out the leading and trailing spaces.
+static void trim(const char** begin, const char** end) {
+  while (*begin < *end && isspace(static_cast<unsigned char>(**begin)))
+    ++*begin;
+  while (*end > *begin && isspace(static_cast<unsigned char>((*end)[-1])))
+    --*end;
 }
 
-static bool config_parse(FILE* fp, config_t* config) {
-  CHECK(fp != nullptr);
+// Parses the |size| bytes at |data| into |config|. The text is tokenized in
+// place; only the section names, keys and values are copied.
+static bool config_parse(const char* data, size_t size, config_t* config) {
+  CHECK(data != nullptr || size == 0);
   CHECK(config != nullptr);
 
+  const char* const data_end = data + size;
+
+  // Duplicated section headers are merged, so this only sizes the section
+  // index, which is then built once instead of rehashed as the file grows.
+  size_t headers = (size > 0 && *data == '[') ? 1 : 0;
+  for (const char* p = data;
+       (p = static_cast<const char*>(memchr(p, '\n', data_end - p))) &&
+       ++p < data_end;) {
+    if (*p == '[') ++headers;
+  }
+  config->sections.reserve(headers);
+
   int line_num = 0;
-  char line[1024] = { '\0' };
-  std::string line_new;
-  uint16_t MAX_BUF = 1023;
-  char section[1024] = { '\0' };
-  char comment[1024] = { '\0' };
+  std::string section = CONFIG_DEFAULT_SECTION;
+  // The section of |section|, looked up on its first key
+  auto sec = config->sections.end();
   bool skip_entries = false;
-  strcpy(section, CONFIG_DEFAULT_SECTION);
-
-  while (fgets(line, sizeof(line), fp)) {
-    char* line_ptr = trim(line);
-
-    /* fgets stops when either sizeof(line) = MAX_BUF (buffer_length - 1)character
-     * are read, the newline character is read, or the end-of-file is reached,
-     * whichever comes first.
-     * Hence check if sizeof(line) = MAX_BUF and the last character read is not an
-     * EOF and/or not '\n' then  Read remaining characters of a line.
-     */
-
-    if ((strlen(line) == MAX_BUF) && (line[MAX_BUF - 1] != EOF) &&
-        (line[MAX_BUF - 1] != '\n')) {
-      line_new = line_ptr;
-      while (fgets(line, sizeof(line), fp)) {
-        line_ptr = trim(line);
-        line_new.append(line_ptr);
-
-        //stop reading if '\n' or EOF is reached
-        if (strlen(line) == 0 || line[strlen(line) - 1] == '\n' ||
-            line[strlen(line) - 1] == EOF)
-          break;
-      }
-      line_ptr = &line_new[0];
-    }
+
+  for (const char* line = data; line < data_end;) {
+    const char* newline =
+        static_cast<const char*>(memchr(line, '\n', data_end - line));
+    const char* begin = line;
+    const char* end = newline ? newline : data_end;
+    line = end + 1;
     ++line_num;
 
-    // Skip blanks.
-    if (*line_ptr == '\0')
-      continue;
+    trim(&begin, &end);
 
-    if (*line_ptr == '#') {
-        continue;
-    /*
-        strlcpy(comment, line_ptr, 1024);
-
-        auto sec = section_find(*config, section);
-        if (sec == config->sections.end()) {
-            section_t *sec_t = section_new(comment);
-            if (sec_t)
-                list_append(config->sections, sec_t);
-        }
-*/
-    } else if (*line_ptr == '[') {
-      size_t len = strlen(line_ptr);
-      if (line_ptr[len - 1] != ']') {
+    // Skip blanks and comments.
+    if (begin == end || *begin == '#') continue;
+
+    if (*begin == '[') {
+      if (end - begin < 2 || end[-1] != ']') {
         LOG_DEBUG(LOG_TAG, "%s unterminated section name on line %d.", __func__, line_num);
         skip_entries = true;
         continue;
       }
-      strncpy(section, line_ptr + 1, len - 2);
-      section[len - 2] = '\0';
+      section.assign(begin + 1, end - 1);
+      sec = config->sections.end();
       skip_entries = false;
-    } else {
-      char *split = strchr(line_ptr, '=');
-      if(skip_entries) {
-        LOG_DEBUG(LOG_TAG, "%s skip entries due invalid section line %d.", __func__, line_num);
-        continue;
-      }
-      if (!split) {
-        LOG_DEBUG(LOG_TAG, "%s no key/value separator found on line %d.", __func__, line_num);
-        continue;
-      }
+      continue;
+    }
+
+    if (skip_entries) {
+      LOG_DEBUG(LOG_TAG, "%s skip entries due invalid section line %d.", __func__, line_num);
+      continue;
+    }
+    const char* split = static_cast<const char*>(memchr(begin, '=', end - begin));
+    if (!split) {
+      LOG_DEBUG(LOG_TAG, "%s no key/value separator found on line %d.", __func__, line_num);
+      continue;
+    }
+
+    const char* key_end = split;
+    const char* value_begin = split + 1;
+    trim(&begin, &key_end);
+    trim(&value_begin, &end);
 
-      *split = '\0';
-      config_set_string(config, section, trim(line_ptr), trim(split + 1));
+    if (sec == config->sections.end()) {
+      sec = config->Find(section);
+      if (sec == config->sections.end()) {
+        config->sections.emplace_back(section_t{.name = section});
+        sec = std::prev(config->sections.end());
+      }
     }
+    sec->Set(std::string(begin, key_end), std::string(value_begin, end));
   }
   return true;
 }
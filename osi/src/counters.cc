@@ -0,0 +1,302 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_osi_counters"
+
+#include "osi/include/counters.h"
+
+#include <inttypes.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+#include <mutex>
+
+#include "osi/include/log.h"
+#include "osi/include/metrics.h"
+#include "osi/include/time.h"
+
+// Number of shards of a counter. CPUs beyond it share shards.
+#define COUNTERS_SHARDS 8
+
+typedef struct {
+  alignas(64) std::atomic<uint64_t> value;
+} counters_shard_t;
+
+struct counters_metric_t {
+  const char* module;
+  const char* name;
+  const char* unit;
+  counters_type_t type;
+
+  // Counter value, or histogram sample sum
+  counters_shard_t shards[COUNTERS_SHARDS];
+
+  // Gauge value
+  std::atomic<int64_t> gauge;
+
+  std::atomic<uint64_t> max;
+  std::atomic<uint32_t> buckets[COUNTERS_HISTOGRAM_BUCKETS];
+};
+
+static std::mutex registry_lock;
+static counters_metric_t* registry[COUNTERS_MAX];
+static std::atomic<size_t> registry_count(0);
+
+// The shard of the calling thread. The CPU is looked up once per thread: a
+// thread that migrates keeps its shard, which only costs some sharing.
+static size_t current_shard(void) {
+  static thread_local int shard = -1;
+  if (shard < 0) {
+    int cpu = sched_getcpu();
+    shard = (cpu < 0 ? 0 : cpu) % COUNTERS_SHARDS;
+  }
+  return shard;
+}
+
+static uint64_t sum_shards(const counters_shard_t* shards) {
+  uint64_t sum = 0;
+  for (size_t i = 0; i < COUNTERS_SHARDS; i++)
+    sum += shards[i].value.load(std::memory_order_relaxed);
+  return sum;
+}
+
+static size_t bucket_of(uint64_t value) {
+  if (value < 4) return value;
+  if (value >> 32) return COUNTERS_HISTOGRAM_BUCKETS - 1;
+  size_t exponent = 63 - __builtin_clzll(value);
+  size_t sub_bucket = (value >> (exponent - 2)) & 3;
+  return 4 * (exponent - 1) + sub_bucket;
+}
+
+uint64_t counters_bucket_lower_bound(size_t bucket) {
+  if (bucket < 4) return bucket;
+  size_t exponent = bucket / 4 + 1;
+  return (uint64_t)(4 + bucket % 4) << (exponent - 2);
+}
+
+static counters_metric_t* register_metric(const char* module, const char* name,
+                                          const char* unit,
+                                          counters_type_t type) {
+  std::lock_guard<std::mutex> lock(registry_lock);
+  size_t count = registry_count.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < count; i++) {
+    counters_metric_t* metric = registry[i];
+    if (strcmp(metric->module, module) || strcmp(metric->name, name)) continue;
+    if (metric->type != type) {
+      LOG_ERROR(LOG_TAG, "%s: %s.%s is registered with another type",
+                __func__, module, name);
+      return NULL;
+    }
+    return metric;
+  }
+
+  if (count == COUNTERS_MAX) {
+    LOG_ERROR(LOG_TAG, "%s: no room for %s.%s", __func__, module, name);
+    return NULL;
+  }
+
+  // Value initialization zeroes the atomics
+  counters_metric_t* metric = new counters_metric_t();
+  metric->module = module;
+  metric->name = name;
+  metric->unit = unit ? unit : "";
+  metric->type = type;
+  registry[count] = metric;
+  registry_count.store(count + 1, std::memory_order_release);
+  return metric;
+}
+
+counters_metric_t* counters_register_counter(const char* module,
+                                             const char* name) {
+  return register_metric(module, name, NULL, COUNTERS_TYPE_COUNTER);
+}
+
+counters_metric_t* counters_register_gauge(const char* module,
+                                           const char* name) {
+  return register_metric(module, name, NULL, COUNTERS_TYPE_GAUGE);
+}
+
+counters_metric_t* counters_register_histogram(const char* module,
+                                               const char* name,
+                                               const char* unit) {
+  return register_metric(module, name, unit, COUNTERS_TYPE_HISTOGRAM);
+}
+
+void counters_add(counters_metric_t* counter, uint64_t delta) {
+  if (counter == NULL) return;
+  counter->shards[current_shard()].value.fetch_add(delta,
+                                                   std::memory_order_relaxed);
+}
+
+void counters_gauge_set(counters_metric_t* gauge, int64_t value) {
+  if (gauge == NULL) return;
+  gauge->gauge.store(value, std::memory_order_relaxed);
+}
+
+void counters_gauge_add(counters_metric_t* gauge, int64_t delta) {
+  if (gauge == NULL) return;
+  gauge->gauge.fetch_add(delta, std::memory_order_relaxed);
+}
+
+void counters_histogram_record(counters_metric_t* histogram, uint64_t value) {
+  if (histogram == NULL) return;
+  histogram->shards[current_shard()].value.fetch_add(
+      value, std::memory_order_relaxed);
+  histogram->buckets[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+
+  uint64_t max = histogram->max.load(std::memory_order_relaxed);
+  while (value > max &&
+         !histogram->max.compare_exchange_weak(max, value,
+                                               std::memory_order_relaxed)) {
+  }
+}
+
+int64_t counters_get_value(const counters_metric_t* metric) {
+  if (metric == NULL) return 0;
+  switch (metric->type) {
+    case COUNTERS_TYPE_COUNTER:
+      return (int64_t)sum_shards(metric->shards);
+    case COUNTERS_TYPE_GAUGE:
+      return metric->gauge.load(std::memory_order_relaxed);
+    default:
+      return 0;
+  }
+}
+
+bool counters_get_histogram(const counters_metric_t* histogram,
+                            counters_histogram_t* out) {
+  if (histogram == NULL || histogram->type != COUNTERS_TYPE_HISTOGRAM)
+    return false;
+
+  // Writers aren't stopped, so the total is taken from the buckets copied and
+  // the sum may be a few samples off.
+  out->count = 0;
+  for (size_t i = 0; i < COUNTERS_HISTOGRAM_BUCKETS; i++) {
+    out->buckets[i] = histogram->buckets[i].load(std::memory_order_relaxed);
+    out->count += out->buckets[i];
+  }
+  out->sum = sum_shards(histogram->shards);
+  out->max = histogram->max.load(std::memory_order_relaxed);
+  return true;
+}
+
+uint64_t counters_histogram_percentile(const counters_histogram_t* histogram,
+                                       unsigned percent) {
+  if (histogram->count == 0) return 0;
+  if (percent > 100) percent = 100;
+
+  // Rank of the sample, rounded up so the 100th percentile is the largest
+  uint64_t rank = (histogram->count * percent + 99) / 100;
+  if (rank == 0) rank = 1;
+  uint64_t seen = 0;
+  for (size_t i = 0; i < COUNTERS_HISTOGRAM_BUCKETS; i++) {
+    seen += histogram->buckets[i];
+    if (seen < rank) continue;
+    if (i == COUNTERS_HISTOGRAM_BUCKETS - 1) return histogram->max;
+    uint64_t upper = counters_bucket_lower_bound(i + 1) - 1;
+    return upper < histogram->max ? upper : histogram->max;
+  }
+  return histogram->max;
+}
+
+void counters_clear(void) {
+  std::lock_guard<std::mutex> lock(registry_lock);
+  size_t count = registry_count.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < count; i++) {
+    counters_metric_t* metric = registry[i];
+    for (size_t j = 0; j < COUNTERS_SHARDS; j++) metric->shards[j].value = 0;
+    metric->gauge = 0;
+    metric->max = 0;
+    for (size_t j = 0; j < COUNTERS_HISTOGRAM_BUCKETS; j++)
+      metric->buckets[j] = 0;
+  }
+}
+
+// Returns the registered metrics. Entries are never removed, so they can be
+// read without the lock.
+static size_t get_registry(counters_metric_t* const** metrics) {
+  *metrics = registry;
+  return registry_count.load(std::memory_order_acquire);
+}
+
+void counters_debug_dump(int fd) {
+  counters_metric_t* const* metrics;
+  size_t count = get_registry(&metrics);
+
+  dprintf(fd, "\nPerformance Counters:\n");
+  if (count == 0) {
+    dprintf(fd, "  None\n");
+    return;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    const counters_metric_t* metric = metrics[i];
+    if (metric->type != COUNTERS_TYPE_HISTOGRAM) {
+      dprintf(fd, "  %s.%s: %" PRId64 "\n", metric->module, metric->name,
+              counters_get_value(metric));
+      continue;
+    }
+
+    counters_histogram_t histogram;
+    counters_get_histogram(metric, &histogram);
+    if (histogram.count == 0) {
+      dprintf(fd, "  %s.%s: no samples\n", metric->module, metric->name);
+      continue;
+    }
+    const char* unit = metric->unit;
+    dprintf(fd,
+            "  %s.%s: count %" PRIu64 " avg %" PRIu64 "%s p50 %" PRIu64
+            "%s p90 %" PRIu64 "%s p99 %" PRIu64 "%s max %" PRIu64 "%s\n",
+            metric->module, metric->name, histogram.count,
+            histogram.sum / histogram.count, unit,
+            counters_histogram_percentile(&histogram, 50), unit,
+            counters_histogram_percentile(&histogram, 90), unit,
+            counters_histogram_percentile(&histogram, 99), unit,
+            histogram.max, unit);
+  }
+}
+
+void counters_export_metrics(void) {
+  counters_metric_t* const* metrics;
+  size_t count = get_registry(&metrics);
+  uint64_t timestamp_ms = time_gettimeofday_us() / 1000;
+
+  for (size_t i = 0; i < count; i++) {
+    const counters_metric_t* metric = metrics[i];
+    system_bt_osi::PerformanceCounterMetrics snapshot;
+    snapshot.module = metric->module;
+    snapshot.name = metric->name;
+    snapshot.type = metric->type;
+    if (metric->type != COUNTERS_TYPE_HISTOGRAM) {
+      snapshot.value = counters_get_value(metric);
+    } else {
+      counters_histogram_t histogram;
+      counters_get_histogram(metric, &histogram);
+      snapshot.count = histogram.count;
+      snapshot.sum = histogram.sum;
+      snapshot.max = histogram.max;
+      snapshot.p50 = counters_histogram_percentile(&histogram, 50);
+      snapshot.p90 = counters_histogram_percentile(&histogram, 90);
+      snapshot.p99 = counters_histogram_percentile(&histogram, 99);
+    }
+    system_bt_osi::BluetoothMetricsLogger::GetInstance()
+        ->LogPerformanceCounter(timestamp_ms, snapshot);
+  }
+}
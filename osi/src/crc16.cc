@@ -0,0 +1,202 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+
+#define LOG_TAG "bt_osi_crc16"
+
+#include "osi/include/crc16.h"
+
+#include <string.h>
+
+#include <atomic>
+
+#if defined(__aarch64__) && \
+    (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES))
+#include <arm_neon.h>
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#define CRC16_CLMUL_ARM
+#elif defined(__x86_64__)
+#include <immintrin.h>
+#define CRC16_CLMUL_X86
+#endif
+
+// Reflected form of the generator polynomial without its x^16 term.
+#define CRC16_POLY_REFLECTED 0xA001
+
+// Bit-reversed low 64 bits of floor(x^80 / P), the Barrett constant used to
+// reduce a 64-bit block in one step.
+#define CRC16_BARRETT_MU_REFLECTED 0xf87ff5ffe7ffdfffULL
+
+typedef struct {
+  uint16_t table[8][256];
+} crc16_tables_t;
+
+// table[0] is the usual byte table; table[k][b] is the CRC of byte |b|
+// followed by |k| zero bytes.
+static constexpr crc16_tables_t crc16_make_tables(void) {
+  crc16_tables_t tables{};
+  for (int b = 0; b < 256; b++) {
+    uint16_t crc = b;
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc & 1) ? (crc >> 1) ^ CRC16_POLY_REFLECTED : crc >> 1;
+    tables.table[0][b] = crc;
+  }
+  for (int k = 1; k < 8; k++) {
+    for (int b = 0; b < 256; b++) {
+      uint16_t prev = tables.table[k - 1][b];
+      tables.table[k][b] = (prev >> 8) ^ tables.table[0][prev & 0xff];
+    }
+  }
+  return tables;
+}
+
+static constexpr crc16_tables_t crc16_tables = crc16_make_tables();
+
+uint16_t crc16_update_bytewise(uint16_t crc, const uint8_t* data,
+                               size_t length) {
+  const uint16_t* table = crc16_tables.table[0];
+  while (length--) crc = (crc >> 8) ^ table[(crc ^ *data++) & 0xff];
+  return crc;
+}
+
+uint16_t crc16_update_slice8(uint16_t crc, const uint8_t* data,
+                             size_t length) {
+  const uint16_t(*t)[256] = crc16_tables.table;
+  while (length >= 8) {
+    uint8_t b0 = data[0] ^ (crc & 0xff);
+    uint8_t b1 = data[1] ^ (crc >> 8);
+    crc = t[7][b0] ^ t[6][b1] ^ t[5][data[2]] ^ t[4][data[3]] ^
+          t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^ t[0][data[7]];
+    data += 8;
+    length -= 8;
+  }
+  return crc16_update_bytewise(crc, data, length);
+}
+
+// The carry-less multiply variant folds 16 bytes per iteration into a 128-bit
+// accumulator that stays congruent to the message modulo P:
+//   acc' = next ^ acc.lo * (x^192 mod P) ^ acc.hi * (x^128 mod P)
+// and then reduces the accumulator and any remaining 8-byte blocks with a
+// Barrett step of two multiplications each. All constants are bit-reversed
+// and pre-divided by x to match the reflected CRC.
+#define CRC16_FOLD_192_REFLECTED 0xccd0000000000000ULL
+#define CRC16_FOLD_128_REFLECTED 0xc100000000000000ULL
+
+#if defined(CRC16_CLMUL_ARM)
+#define CRC16_CLMUL_TARGET
+
+static inline uint64_t crc16_clmul(uint64_t a, uint64_t b, uint64_t* high) {
+  uint64x2_t product = vreinterpretq_u64_p128(vmull_p64(a, b));
+  *high = vgetq_lane_u64(product, 1);
+  return vgetq_lane_u64(product, 0);
+}
+
+static bool crc16_cpu_has_clmul(void) {
+  return (getauxval(AT_HWCAP) & HWCAP_PMULL) != 0;
+}
+#elif defined(CRC16_CLMUL_X86)
+#define CRC16_CLMUL_TARGET __attribute__((target("pclmul,sse4.1")))
+
+CRC16_CLMUL_TARGET static inline uint64_t crc16_clmul(uint64_t a, uint64_t b,
+                                                      uint64_t* high) {
+  __m128i product =
+      _mm_clmulepi64_si128(_mm_cvtsi64_si128(a), _mm_cvtsi64_si128(b), 0x00);
+  *high = _mm_extract_epi64(product, 1);
+  return _mm_cvtsi128_si64(product);
+}
+
+static bool crc16_cpu_has_clmul(void) {
+  return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+}
+#endif
+
+#if defined(CRC16_CLMUL_ARM) || defined(CRC16_CLMUL_X86)
+static inline uint64_t crc16_load64(const uint8_t* data) {
+  uint64_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+// Returns the CRC of |crc| followed by the 8-byte little-endian |block|.
+CRC16_CLMUL_TARGET static inline uint16_t crc16_barrett(uint16_t crc,
+                                                        uint64_t block) {
+  uint64_t high;
+  block ^= crc;
+  uint64_t quotient =
+      block ^ (crc16_clmul(block, CRC16_BARRETT_MU_REFLECTED, &high) << 1);
+  uint64_t low = crc16_clmul(quotient, CRC16_POLY_REFLECTED, &high);
+  return ((low >> 63) | (high << 1)) & 0xffff;
+}
+
+CRC16_CLMUL_TARGET static uint16_t crc16_update_clmul(uint16_t crc,
+                                                      const uint8_t* data,
+                                                      size_t length) {
+  if (length >= 32) {
+    uint64_t acc_lo = crc16_load64(data) ^ crc;
+    uint64_t acc_hi = crc16_load64(data + 8);
+    data += 16;
+    length -= 16;
+
+    while (length >= 16) {
+      uint64_t lo_hi, hi_hi;
+      uint64_t lo_lo = crc16_clmul(acc_lo, CRC16_FOLD_192_REFLECTED, &lo_hi);
+      uint64_t hi_lo = crc16_clmul(acc_hi, CRC16_FOLD_128_REFLECTED, &hi_hi);
+      acc_lo = crc16_load64(data) ^ lo_lo ^ hi_lo;
+      acc_hi = crc16_load64(data + 8) ^ lo_hi ^ hi_hi;
+      data += 16;
+      length -= 16;
+    }
+
+    crc = crc16_barrett(crc16_barrett(0, acc_lo), acc_hi);
+  }
+
+  for (; length >= 8; data += 8, length -= 8)
+    crc = crc16_barrett(crc, crc16_load64(data));
+
+  return crc16_update_bytewise(crc, data, length);
+}
+#endif
+
+crc16_update_fn crc16_get_clmul_impl(void) {
+#if defined(CRC16_CLMUL_ARM) || defined(CRC16_CLMUL_X86)
+  if (crc16_cpu_has_clmul()) return crc16_update_clmul;
+#endif
+  return NULL;
+}
+
+// Resolved on first use; concurrent first calls resolve to the same value.
+static std::atomic<crc16_update_fn> crc16_impl(nullptr);
+
+static crc16_update_fn crc16_resolve_impl(void) {
+  crc16_update_fn impl = crc16_impl.load(std::memory_order_relaxed);
+  if (impl) return impl;
+
+  impl = crc16_get_clmul_impl();
+  if (!impl) impl = crc16_update_slice8;
+  crc16_impl.store(impl, std::memory_order_relaxed);
+  return impl;
+}
+
+uint16_t crc16_update(uint16_t crc, const uint8_t* data, size_t length) {
+  return crc16_resolve_impl()(crc, data, length);
+}
+
+const char* crc16_get_impl_name(void) {
+  return crc16_resolve_impl() == crc16_update_slice8 ? "slice8" : "clmul";
+}
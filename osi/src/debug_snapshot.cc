@@ -0,0 +1,87 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_osi_debug_snapshot"
+
+#include "osi/include/debug_snapshot.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#include "osi/include/log.h"
+
+namespace {
+
+// Shared with the posted task, which may outlive the caller on a timeout
+struct snapshot_wait_t {
+  std::mutex lock;
+  std::condition_variable done_cv;
+  bool done = false;
+};
+
+void run_posted_task(void* context) {
+  std::function<void()>* task = static_cast<std::function<void()>*>(context);
+  (*task)();
+  delete task;
+}
+
+}  // namespace
+
+bool debug_snapshot_run(const debug_snapshot_poster_t& post,
+                        const std::function<void()>& task,
+                        period_ms_t timeout_ms) {
+  std::shared_ptr<snapshot_wait_t> wait = std::make_shared<snapshot_wait_t>();
+  bool posted = post([wait, task] {
+    task();
+    std::lock_guard<std::mutex> lock(wait->lock);
+    wait->done = true;
+    wait->done_cv.notify_one();
+  });
+  if (!posted) {
+    LOG_WARN(LOG_TAG, "%s: unable to post the snapshot task", __func__);
+    return false;
+  }
+
+  std::unique_lock<std::mutex> lock(wait->lock);
+  if (!wait->done_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                              [&wait] { return wait->done; })) {
+    LOG_WARN(LOG_TAG, "%s: snapshot not taken within %llu ms", __func__,
+             (unsigned long long)timeout_ms);
+    return false;
+  }
+  return true;
+}
+
+bool debug_snapshot_run_on_thread(thread_t* thread,
+                                  const std::function<void()>& task,
+                                  period_ms_t timeout_ms) {
+  if (thread == NULL || thread_is_self(thread)) {
+    task();
+    return true;
+  }
+
+  return debug_snapshot_run(
+      [thread](const std::function<void()>& posted) {
+        std::function<void()>* context = new std::function<void()>(posted);
+        if (thread_post(thread, run_posted_task, context)) return true;
+        delete context;
+        return false;
+      },
+      task, timeout_ms);
+}
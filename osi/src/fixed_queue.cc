@@ -17,8 +17,12 @@
  ******************************************************************************/
 
 #include <base/logging.h>
+#include <poll.h>
 #include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
+#include <atomic>
 #include <mutex>
 
 #include "osi/include/allocator.h"
@@ -28,7 +32,24 @@
 #include "osi/include/reactor.h"
 #include "osi/include/semaphore.h"
 
+// Lock-free ring used by single-producer/single-consumer queues. |head| is
+// only written by the consumer and |tail| only by the producer. Each eventfd
+// is a level doorbell that is readable while the queue is non-empty (dequeue)
+// or non-full (enqueue); the |*_signaled| flags make sure it is only written
+// on the transition.
+typedef struct spsc_ring_t {
+  alignas(64) std::atomic<size_t> head;
+  std::atomic<bool> space_signaled;
+  alignas(64) std::atomic<size_t> tail;
+  std::atomic<bool> data_signaled;
+  alignas(64) void** slots;
+  size_t mask;
+  int dequeue_fd;
+  int enqueue_fd;
+} spsc_ring_t;
+
 typedef struct fixed_queue_t {
+  spsc_ring_t* ring;  // non-NULL for single-producer/single-consumer queues
   list_t* list;
   semaphore_t* enqueue_sem;
   semaphore_t* dequeue_sem;
@@ -41,6 +62,8 @@ typedef struct fixed_queue_t {
 } fixed_queue_t;
 
 static void internal_dequeue_ready(void* context);
+static bool spsc_try_enqueue(fixed_queue_t* queue, void* data);
+static void* spsc_try_dequeue(fixed_queue_t* queue);
 
 fixed_queue_t* fixed_queue_new(size_t capacity) {
   fixed_queue_t* ret =
@@ -65,11 +88,54 @@ error:
   return NULL;
 }
 
+fixed_queue_t* fixed_queue_new_spsc(size_t capacity) {
+  CHECK(capacity > 0 && capacity <= (SIZE_MAX >> 2));
+
+  fixed_queue_t* ret =
+      static_cast<fixed_queue_t*>(osi_calloc(sizeof(fixed_queue_t)));
+  ret->capacity = capacity;
+
+  size_t slots = 1;
+  while (slots < capacity) slots <<= 1;
+
+  spsc_ring_t* ring = new spsc_ring_t;
+  ring->head = 0;
+  ring->tail = 0;
+  ring->slots = static_cast<void**>(osi_calloc(slots * sizeof(void*)));
+  ring->mask = slots - 1;
+  ring->data_signaled = false;
+  ring->space_signaled = true;
+  ring->dequeue_fd = eventfd(0, EFD_NONBLOCK);
+  ring->enqueue_fd = eventfd(1, EFD_NONBLOCK);
+  ret->ring = ring;
+
+  if (ring->dequeue_fd == INVALID_FD || ring->enqueue_fd == INVALID_FD) {
+    fixed_queue_free(ret, NULL);
+    return NULL;
+  }
+
+  return ret;
+}
+
 void fixed_queue_free(fixed_queue_t* queue, fixed_queue_free_cb free_cb) {
   if (!queue) return;
 
   fixed_queue_unregister_dequeue(queue);
 
+  if (queue->ring) {
+    spsc_ring_t* ring = queue->ring;
+    if (free_cb)
+      for (size_t i = ring->head; i != ring->tail; i++)
+        free_cb(ring->slots[i & ring->mask]);
+
+    if (ring->dequeue_fd != INVALID_FD) close(ring->dequeue_fd);
+    if (ring->enqueue_fd != INVALID_FD) close(ring->enqueue_fd);
+    osi_free(ring->slots);
+    delete ring;
+    osi_free(queue);
+    return;
+  }
+
   if (free_cb)
     for (const list_node_t* node = list_begin(queue->list);
          node != list_end(queue->list); node = list_next(node))
@@ -96,6 +162,10 @@ void fixed_queue_flush(fixed_queue_t* queue, fixed_queue_free_cb free_cb) {
 bool fixed_queue_is_empty(fixed_queue_t* queue) {
   if (queue == NULL) return true;
 
+  if (queue->ring)
+    return queue->ring->head.load(std::memory_order_acquire) ==
+           queue->ring->tail.load(std::memory_order_acquire);
+
   std::lock_guard<std::mutex> lock(*queue->mutex);
   return list_is_empty(queue->list);
 }
@@ -103,6 +173,11 @@ bool fixed_queue_is_empty(fixed_queue_t* queue) {
 size_t fixed_queue_length(fixed_queue_t* queue) {
   if (queue == NULL) return 0;
 
+  if (queue->ring) {
+    size_t head = queue->ring->head.load(std::memory_order_acquire);
+    return queue->ring->tail.load(std::memory_order_acquire) - head;
+  }
+
   std::lock_guard<std::mutex> lock(*queue->mutex);
   return list_length(queue->list);
 }
@@ -117,6 +192,12 @@ void fixed_queue_enqueue(fixed_queue_t* queue, void* data) {
   CHECK(queue != NULL);
   CHECK(data != NULL);
 
+  if (queue->ring) {
+    struct pollfd pfd = {queue->ring->enqueue_fd, POLLIN, 0};
+    while (!spsc_try_enqueue(queue, data)) OSI_NO_INTR(poll(&pfd, 1, -1));
+    return;
+  }
+
   semaphore_wait(queue->enqueue_sem);
 
   {
@@ -130,6 +211,14 @@ void fixed_queue_enqueue(fixed_queue_t* queue, void* data) {
 void* fixed_queue_dequeue(fixed_queue_t* queue) {
   CHECK(queue != NULL);
 
+  if (queue->ring) {
+    struct pollfd pfd = {queue->ring->dequeue_fd, POLLIN, 0};
+    void* ret;
+    while ((ret = spsc_try_dequeue(queue)) == NULL)
+      OSI_NO_INTR(poll(&pfd, 1, -1));
+    return ret;
+  }
+
   semaphore_wait(queue->dequeue_sem);
 
   void* ret = NULL;
@@ -148,6 +237,8 @@ bool fixed_queue_try_enqueue(fixed_queue_t* queue, void* data) {
   CHECK(queue != NULL);
   CHECK(data != NULL);
 
+  if (queue->ring) return spsc_try_enqueue(queue, data);
+
   if (!semaphore_try_wait(queue->enqueue_sem)) return false;
 
   {
@@ -162,6 +253,8 @@ bool fixed_queue_try_enqueue(fixed_queue_t* queue, void* data) {
 void* fixed_queue_try_dequeue(fixed_queue_t* queue) {
   if (queue == NULL) return NULL;
 
+  if (queue->ring) return spsc_try_dequeue(queue);
+
   if (!semaphore_try_wait(queue->dequeue_sem)) return NULL;
 
   void* ret = NULL;
@@ -179,6 +272,13 @@ void* fixed_queue_try_dequeue(fixed_queue_t* queue) {
 void* fixed_queue_try_peek_first(fixed_queue_t* queue) {
   if (queue == NULL) return NULL;
 
+  if (queue->ring) {
+    spsc_ring_t* ring = queue->ring;
+    size_t head = ring->head.load(std::memory_order_relaxed);
+    if (head == ring->tail.load(std::memory_order_acquire)) return NULL;
+    return ring->slots[head & ring->mask];
+  }
+
   std::lock_guard<std::mutex> lock(*queue->mutex);
   return list_is_empty(queue->list) ? NULL : list_front(queue->list);
 }
@@ -186,12 +286,20 @@ void* fixed_queue_try_peek_first(fixed_queue_t* queue) {
 void* fixed_queue_try_peek_last(fixed_queue_t* queue) {
   if (queue == NULL) return NULL;
 
+  if (queue->ring) {
+    spsc_ring_t* ring = queue->ring;
+    size_t tail = ring->tail.load(std::memory_order_acquire);
+    if (tail == ring->head.load(std::memory_order_acquire)) return NULL;
+    return ring->slots[(tail - 1) & ring->mask];
+  }
+
   std::lock_guard<std::mutex> lock(*queue->mutex);
   return list_is_empty(queue->list) ? NULL : list_back(queue->list);
 }
 
 void* fixed_queue_try_remove_from_queue(fixed_queue_t* queue, void* data) {
   if (queue == NULL) return NULL;
+  CHECK(queue->ring == NULL);
 
   bool removed = false;
   {
@@ -212,6 +320,7 @@ void* fixed_queue_try_remove_from_queue(fixed_queue_t* queue, void* data) {
 
 list_t* fixed_queue_get_list(fixed_queue_t* queue) {
   CHECK(queue != NULL);
+  CHECK(queue->ring == NULL);
 
   // NOTE: Using the list in this way is not thread-safe.
   // Using this list in any context where threads can call other functions
@@ -221,11 +330,13 @@ list_t* fixed_queue_get_list(fixed_queue_t* queue) {
 
 int fixed_queue_get_dequeue_fd(const fixed_queue_t* queue) {
   CHECK(queue != NULL);
+  if (queue->ring) return queue->ring->dequeue_fd;
   return semaphore_get_fd(queue->dequeue_sem);
 }
 
 int fixed_queue_get_enqueue_fd(const fixed_queue_t* queue) {
   CHECK(queue != NULL);
+  if (queue->ring) return queue->ring->enqueue_fd;
   return semaphore_get_fd(queue->enqueue_sem);
 }
 
@@ -260,3 +371,70 @@ static void internal_dequeue_ready(void* context) {
   fixed_queue_t* queue = static_cast<fixed_queue_t*>(context);
   queue->dequeue_ready(queue, queue->dequeue_context);
 }
+
+static bool spsc_ring_has_space(const fixed_queue_t* queue) {
+  return queue->ring->tail.load() - queue->ring->head.load() <
+         queue->capacity;
+}
+
+static bool spsc_ring_has_data(const fixed_queue_t* queue) {
+  return queue->ring->head.load() != queue->ring->tail.load();
+}
+
+// Makes |fd| readable unless it already is.
+static void spsc_doorbell_ring(std::atomic<bool>* signaled, int fd) {
+  if (signaled->load()) return;
+  if (!signaled->exchange(true)) eventfd_write(fd, 1);
+}
+
+// Drains |fd| once the condition it announces no longer holds. If the other
+// side raced with us and |pending| holds again by the time the doorbell is
+// cleared, it is rung again so that no wakeup is lost.
+static void spsc_doorbell_clear(const fixed_queue_t* queue,
+                                std::atomic<bool>* signaled, int fd,
+                                bool (*pending)(const fixed_queue_t*)) {
+  eventfd_t value;
+  eventfd_read(fd, &value);
+  signaled->store(false);
+  if (pending(queue)) spsc_doorbell_ring(signaled, fd);
+}
+
+static bool spsc_try_enqueue(fixed_queue_t* queue, void* data) {
+  spsc_ring_t* ring = queue->ring;
+
+  size_t tail = ring->tail.load(std::memory_order_relaxed);
+  if (tail - ring->head.load(std::memory_order_acquire) >= queue->capacity) {
+    spsc_doorbell_clear(queue, &ring->space_signaled, ring->enqueue_fd,
+                        spsc_ring_has_space);
+    return false;
+  }
+
+  ring->slots[tail & ring->mask] = data;
+  ring->tail.store(tail + 1);
+  spsc_doorbell_ring(&ring->data_signaled, ring->dequeue_fd);
+
+  if (!spsc_ring_has_space(queue))
+    spsc_doorbell_clear(queue, &ring->space_signaled, ring->enqueue_fd,
+                        spsc_ring_has_space);
+  return true;
+}
+
+static void* spsc_try_dequeue(fixed_queue_t* queue) {
+  spsc_ring_t* ring = queue->ring;
+
+  size_t head = ring->head.load(std::memory_order_relaxed);
+  if (head == ring->tail.load(std::memory_order_acquire)) {
+    spsc_doorbell_clear(queue, &ring->data_signaled, ring->dequeue_fd,
+                        spsc_ring_has_data);
+    return NULL;
+  }
+
+  void* data = ring->slots[head & ring->mask];
+  ring->head.store(head + 1);
+  spsc_doorbell_ring(&ring->space_signaled, ring->enqueue_fd);
+
+  if (!spsc_ring_has_data(queue))
+    spsc_doorbell_clear(queue, &ring->data_signaled, ring->dequeue_fd,
+                        spsc_ring_has_data);
+  return data;
+}
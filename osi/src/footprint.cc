@@ -0,0 +1,134 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "internal_include/bt_target.h"
+
+#define LOG_TAG "bt_osi_footprint"
+
+#include "osi/include/footprint.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <mutex>
+
+#include "osi/include/log.h"
+#include "osi/include/properties.h"
+
+typedef struct {
+  const char* module;
+  const char* pool;
+  size_t bytes;
+} footprint_entry_t;
+
+static std::mutex footprint_lock;
+static footprint_entry_t entries[FOOTPRINT_MAX];
+static size_t entry_count;
+
+bool footprint_low_memory_mode(void) {
+  static const bool low_memory = osi_property_get_bool(
+      "persist.vendor.btstack.low_memory", BT_LOW_MEMORY_MODE == TRUE);
+  return low_memory;
+}
+
+size_t footprint_pool_entries(const char* pool, size_t max_entries,
+                              size_t low_memory_entries) {
+  if (!footprint_low_memory_mode()) return max_entries;
+
+  char key[PROPERTY_VALUE_MAX];
+  snprintf(key, sizeof(key), "persist.vendor.btstack.%s_size", pool);
+  int32_t entries = osi_property_get_int32(key, low_memory_entries);
+  if (entries < 1) entries = 1;
+  if ((size_t)entries > max_entries) entries = max_entries;
+  LOG_INFO(LOG_TAG, "%s: %s sized for %d of %zu entries", __func__, pool,
+           entries, max_entries);
+  return entries;
+}
+
+// Returns the entry of |pool| of |module|, NULL if it isn't reported.
+static footprint_entry_t* find_entry(const char* module, const char* pool) {
+  for (size_t i = 0; i < entry_count; i++) {
+    if (!strcmp(entries[i].module, module) && !strcmp(entries[i].pool, pool))
+      return &entries[i];
+  }
+  return NULL;
+}
+
+void footprint_set(const char* module, const char* pool, size_t bytes) {
+  std::lock_guard<std::mutex> lock(footprint_lock);
+  footprint_entry_t* entry = find_entry(module, pool);
+  if (entry == NULL) {
+    if (entry_count == FOOTPRINT_MAX) {
+      LOG_WARN(LOG_TAG, "%s: no room to report %s.%s", __func__, module, pool);
+      return;
+    }
+    entry = &entries[entry_count++];
+    entry->module = module;
+    entry->pool = pool;
+  }
+  entry->bytes = bytes;
+}
+
+size_t footprint_get(const char* module, const char* pool) {
+  std::lock_guard<std::mutex> lock(footprint_lock);
+  size_t bytes = 0;
+  for (size_t i = 0; i < entry_count; i++) {
+    if (strcmp(entries[i].module, module)) continue;
+    if (pool == NULL || !strcmp(entries[i].pool, pool))
+      bytes += entries[i].bytes;
+  }
+  return bytes;
+}
+
+void footprint_clear(void) {
+  std::lock_guard<std::mutex> lock(footprint_lock);
+  entry_count = 0;
+}
+
+void footprint_debug_dump(int fd) {
+  std::lock_guard<std::mutex> lock(footprint_lock);
+
+  dprintf(fd, "\nResident Control Blocks:%s\n",
+          footprint_low_memory_mode() ? " (low memory mode)" : "");
+  if (entry_count == 0) {
+    dprintf(fd, "  None\n");
+    return;
+  }
+
+  // Modules in the order they first reported, each followed by its pools
+  size_t total = 0;
+  for (size_t i = 0; i < entry_count; i++) {
+    const char* module = entries[i].module;
+    bool reported = false;
+    for (size_t j = 0; j < i && !reported; j++)
+      reported = !strcmp(entries[j].module, module);
+    if (reported) continue;
+
+    size_t module_bytes = 0;
+    for (size_t j = i; j < entry_count; j++) {
+      if (!strcmp(entries[j].module, module)) module_bytes += entries[j].bytes;
+    }
+    dprintf(fd, "  %s: %zu bytes\n", module, module_bytes);
+    for (size_t j = i; j < entry_count; j++) {
+      if (strcmp(entries[j].module, module)) continue;
+      dprintf(fd, "    %s: %zu bytes\n", entries[j].pool, entries[j].bytes);
+    }
+    total += module_bytes;
+  }
+  dprintf(fd, "  Total: %zu bytes\n", total);
+}
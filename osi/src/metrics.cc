@@ -29,7 +29,7 @@
 #include <base/base64.h>
 #include <base/logging.h>
 
-#include "osi/include/leaky_bonded_queue.h"
+#include "osi/include/chunked_record_buffer.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "osi/include/time.h"
@@ -48,10 +48,14 @@ using clearcut::connectivity::BluetoothSession_ConnectionTechnologyType;
 using clearcut::connectivity::BluetoothSession_DisconnectReasonType;
 using clearcut::connectivity::DeviceInfo;
 using clearcut::connectivity::DeviceInfo_DeviceType;
+using clearcut::connectivity::LinkQualityEvent;
 using clearcut::connectivity::PairEvent;
+using clearcut::connectivity::PerformanceCounter;
+using clearcut::connectivity::PerformanceCounter_CounterType;
 using clearcut::connectivity::ScanEvent;
 using clearcut::connectivity::ScanEvent_ScanTechnologyType;
 using clearcut::connectivity::ScanEvent_ScanEventType;
+using clearcut::connectivity::SmpPairingEvent;
 using clearcut::connectivity::WakeEvent;
 using clearcut::connectivity::WakeEvent_WakeEventType;
 
@@ -223,14 +227,69 @@ static BluetoothSession_DisconnectReasonType get_disconnect_reason_type(
   }
 }
 
+// Serialized events are kept in chunks of this size
+static const size_t kMetricsChunkSize = 4096;
+// Most serialized bytes kept for each kind of event
+static const size_t kMaxMetricsBytesPerField = 64 * 1024;
+
+// Wire type of embedded messages, see the protobuf encoding documentation
+static const uint32_t kWireTypeLengthDelimited = 2;
+
+static void append_varint(std::string* out, uint64_t value) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+/*
+ * A repeated message field of BluetoothLog, kept serialized. Each event is
+ * encoded as the field would be within the serialized BluetoothLog when it is
+ * logged, so writing the log only concatenates the buffers.
+ */
+class LogFieldBuffer {
+ public:
+  LogFieldBuffer(int field_number, size_t max_records)
+      : field_number_(field_number),
+        buffer_(kMetricsChunkSize, kMaxMetricsBytesPerField, max_records) {}
+
+  void Append(const google::protobuf::MessageLite& message) {
+    std::string record;
+    append_varint(&record, (static_cast<uint32_t>(field_number_) << 3) |
+                               kWireTypeLengthDelimited);
+    append_varint(&record, message.ByteSizeLong());
+    if (!message.AppendToString(&record)) {
+      LOG_ERROR(LOG_TAG, "%s: error serializing field %d", __func__,
+                field_number_);
+      return;
+    }
+    buffer_.Append(record);
+  }
+
+  void AppendTo(std::string* out) const { buffer_.AppendTo(out); }
+  void Clear() { buffer_.Clear(); }
+
+ private:
+  const int field_number_;
+  ChunkedRecordBuffer buffer_;
+};
+
 struct BluetoothMetricsLogger::impl {
   impl(size_t max_bluetooth_session, size_t max_pair_event,
-       size_t max_wake_event, size_t max_scan_event)
-      : bt_session_queue_(
-            new LeakyBondedQueue<BluetoothSession>(max_bluetooth_session)),
-        pair_event_queue_(new LeakyBondedQueue<PairEvent>(max_pair_event)),
-        wake_event_queue_(new LeakyBondedQueue<WakeEvent>(max_wake_event)),
-        scan_event_queue_(new LeakyBondedQueue<ScanEvent>(max_scan_event)) {
+       size_t max_wake_event, size_t max_scan_event,
+       size_t max_smp_pairing_event, size_t max_link_quality_event,
+       size_t max_performance_counter)
+      : sessions_(BluetoothLog::kSessionFieldNumber, max_bluetooth_session),
+        pair_events_(BluetoothLog::kPairEventFieldNumber, max_pair_event),
+        wake_events_(BluetoothLog::kWakeEventFieldNumber, max_wake_event),
+        scan_events_(BluetoothLog::kScanEventFieldNumber, max_scan_event),
+        smp_pairing_events_(BluetoothLog::kSmpPairingEventFieldNumber,
+                            max_smp_pairing_event),
+        link_quality_events_(BluetoothLog::kLinkQualityEventFieldNumber,
+                             max_link_quality_event),
+        performance_counters_(BluetoothLog::kPerformanceCounterFieldNumber,
+                              max_performance_counter) {
     bluetooth_log_ = BluetoothLog::default_instance().New();
     bluetooth_session_ = nullptr;
     bluetooth_session_start_time_ms_ = 0;
@@ -238,7 +297,15 @@ struct BluetoothMetricsLogger::impl {
   }
 
   /* Bluetooth log lock protected */
+  // Only holds the event counts, the events are in the buffers below
   BluetoothLog* bluetooth_log_;
+  LogFieldBuffer sessions_;
+  LogFieldBuffer pair_events_;
+  LogFieldBuffer wake_events_;
+  LogFieldBuffer scan_events_;
+  LogFieldBuffer smp_pairing_events_;
+  LogFieldBuffer link_quality_events_;
+  LogFieldBuffer performance_counters_;
   std::recursive_mutex bluetooth_log_lock_;
   /* End Bluetooth log lock protected */
   /* Bluetooth session lock protected */
@@ -247,46 +314,141 @@ struct BluetoothMetricsLogger::impl {
   A2dpSessionMetrics a2dp_session_metrics_;
   std::recursive_mutex bluetooth_session_lock_;
   /* End bluetooth session lock protected */
-  std::unique_ptr<LeakyBondedQueue<BluetoothSession>> bt_session_queue_;
-  std::unique_ptr<LeakyBondedQueue<PairEvent>> pair_event_queue_;
-  std::unique_ptr<LeakyBondedQueue<WakeEvent>> wake_event_queue_;
-  std::unique_ptr<LeakyBondedQueue<ScanEvent>> scan_event_queue_;
 };
 
 BluetoothMetricsLogger::BluetoothMetricsLogger()
     : pimpl_(new impl(kMaxNumBluetoothSession, kMaxNumPairEvent,
-                      kMaxNumWakeEvent, kMaxNumScanEvent)) {}
+                      kMaxNumWakeEvent, kMaxNumScanEvent,
+                      kMaxNumSmpPairingEvent, kMaxNumLinkQualityEvent,
+                      kMaxNumPerformanceCounter)) {}
 
 void BluetoothMetricsLogger::LogPairEvent(uint32_t disconnect_reason,
                                           uint64_t timestamp_ms,
                                           uint32_t device_class,
                                           device_type_t device_type) {
-  PairEvent* event = new PairEvent();
-  DeviceInfo* info = event->mutable_device_paired_with();
+  PairEvent event;
+  DeviceInfo* info = event.mutable_device_paired_with();
   info->set_device_class(device_class);
   info->set_device_type(get_device_type(device_type));
-  event->set_disconnect_reason(disconnect_reason);
-  event->set_event_time_millis(timestamp_ms);
-  pimpl_->pair_event_queue_->Enqueue(event);
+  event.set_disconnect_reason(disconnect_reason);
+  event.set_event_time_millis(timestamp_ms);
   {
     std::lock_guard<std::recursive_mutex> lock(pimpl_->bluetooth_log_lock_);
+    pimpl_->pair_events_.Append(event);
     pimpl_->bluetooth_log_->set_num_pair_event(
         pimpl_->bluetooth_log_->num_pair_event() + 1);
   }
 }
 
+void BluetoothMetricsLogger::LogSmpPairingEvent(
+    uint64_t timestamp_ms, const SmpPairingMetrics& metrics) {
+  SmpPairingEvent event;
+  event.set_event_time_millis(timestamp_ms);
+  if (metrics.status >= 0) event.set_status(metrics.status);
+  event.set_secure_connections(metrics.secure_connections);
+  if (metrics.association_model >= 0)
+    event.set_association_model(metrics.association_model);
+  if (metrics.feature_exchange_ms >= 0)
+    event.set_feature_exchange_millis(metrics.feature_exchange_ms);
+  if (metrics.public_key_exchange_ms >= 0)
+    event.set_public_key_exchange_millis(metrics.public_key_exchange_ms);
+  if (metrics.dhkey_computation_ms >= 0)
+    event.set_dhkey_computation_millis(metrics.dhkey_computation_ms);
+  if (metrics.authentication_ms >= 0)
+    event.set_authentication_millis(metrics.authentication_ms);
+  if (metrics.authentication_round_trips >= 0)
+    event.set_authentication_round_trips(metrics.authentication_round_trips);
+  if (metrics.dhkey_check_ms >= 0)
+    event.set_dhkey_check_millis(metrics.dhkey_check_ms);
+  if (metrics.encryption_ms >= 0)
+    event.set_encryption_millis(metrics.encryption_ms);
+  if (metrics.key_distribution_ms >= 0)
+    event.set_key_distribution_millis(metrics.key_distribution_ms);
+  if (metrics.total_ms >= 0) event.set_total_millis(metrics.total_ms);
+  {
+    std::lock_guard<std::recursive_mutex> lock(pimpl_->bluetooth_log_lock_);
+    pimpl_->smp_pairing_events_.Append(event);
+    pimpl_->bluetooth_log_->set_num_smp_pairing_event(
+        pimpl_->bluetooth_log_->num_smp_pairing_event() + 1);
+  }
+}
+
+void BluetoothMetricsLogger::LogLinkQualityEvent(
+    uint64_t timestamp_ms, const LinkQualityMetrics& metrics) {
+  LinkQualityEvent event;
+  event.set_event_time_millis(timestamp_ms);
+  if (metrics.duration_ms >= 0) event.set_duration_millis(metrics.duration_ms);
+  if (metrics.codec_index >= 0) event.set_codec_index(metrics.codec_index);
+  if (metrics.report_count >= 0) event.set_report_count(metrics.report_count);
+  if (metrics.approach_lsto_count >= 0)
+    event.set_approach_lsto_count(metrics.approach_lsto_count);
+  if (metrics.a2dp_choppy_count >= 0)
+    event.set_a2dp_choppy_count(metrics.a2dp_choppy_count);
+  if (metrics.sco_choppy_count >= 0)
+    event.set_sco_choppy_count(metrics.sco_choppy_count);
+  if (metrics.report_count > 0) {
+    event.set_rssi_average(metrics.rssi_average);
+    event.set_rssi_min(metrics.rssi_min);
+    event.set_rssi_max(metrics.rssi_max);
+  }
+  if (metrics.snr_average >= 0) event.set_snr_average(metrics.snr_average);
+  if (metrics.snr_min >= 0) event.set_snr_min(metrics.snr_min);
+  if (metrics.retransmission_count >= 0)
+    event.set_retransmission_count(metrics.retransmission_count);
+  if (metrics.no_rx_count >= 0) event.set_no_rx_count(metrics.no_rx_count);
+  if (metrics.nak_count >= 0) event.set_nak_count(metrics.nak_count);
+  if (metrics.flow_off_count >= 0)
+    event.set_flow_off_count(metrics.flow_off_count);
+  if (metrics.buffer_overflow_bytes >= 0)
+    event.set_buffer_overflow_bytes(metrics.buffer_overflow_bytes);
+  if (metrics.buffer_underflow_bytes >= 0)
+    event.set_buffer_underflow_bytes(metrics.buffer_underflow_bytes);
+  {
+    std::lock_guard<std::recursive_mutex> lock(pimpl_->bluetooth_log_lock_);
+    pimpl_->link_quality_events_.Append(event);
+    pimpl_->bluetooth_log_->set_num_link_quality_event(
+        pimpl_->bluetooth_log_->num_link_quality_event() + 1);
+  }
+}
+
+void BluetoothMetricsLogger::LogPerformanceCounter(
+    uint64_t timestamp_ms, const PerformanceCounterMetrics& metrics) {
+  PerformanceCounter counter;
+  counter.set_event_time_millis(timestamp_ms);
+  counter.set_module(metrics.module);
+  counter.set_name(metrics.name);
+  if (metrics.type >= 0 &&
+      clearcut::connectivity::PerformanceCounter_CounterType_IsValid(
+          metrics.type))
+    counter.set_type(
+        static_cast<PerformanceCounter_CounterType>(metrics.type));
+  if (metrics.value >= 0) counter.set_value(metrics.value);
+  if (metrics.count >= 0) counter.set_count(metrics.count);
+  if (metrics.sum >= 0) counter.set_sum(metrics.sum);
+  if (metrics.max >= 0) counter.set_max(metrics.max);
+  if (metrics.p50 >= 0) counter.set_p50(metrics.p50);
+  if (metrics.p90 >= 0) counter.set_p90(metrics.p90);
+  if (metrics.p99 >= 0) counter.set_p99(metrics.p99);
+  {
+    std::lock_guard<std::recursive_mutex> lock(pimpl_->bluetooth_log_lock_);
+    pimpl_->performance_counters_.Append(counter);
+    pimpl_->bluetooth_log_->set_num_performance_counter(
+        pimpl_->bluetooth_log_->num_performance_counter() + 1);
+  }
+}
+
 void BluetoothMetricsLogger::LogWakeEvent(wake_event_type_t type,
                                           const std::string& requestor,
                                           const std::string& name,
                                           uint64_t timestamp_ms) {
-  WakeEvent* event = new WakeEvent();
-  event->set_wake_event_type(get_wake_event_type(type));
-  event->set_requestor(requestor);
-  event->set_name(name);
-  event->set_event_time_millis(timestamp_ms);
-  pimpl_->wake_event_queue_->Enqueue(event);
+  WakeEvent event;
+  event.set_wake_event_type(get_wake_event_type(type));
+  event.set_requestor(requestor);
+  event.set_name(name);
+  event.set_event_time_millis(timestamp_ms);
   {
     std::lock_guard<std::recursive_mutex> lock(pimpl_->bluetooth_log_lock_);
+    pimpl_->wake_events_.Append(event);
     pimpl_->bluetooth_log_->set_num_wake_event(
         pimpl_->bluetooth_log_->num_wake_event() + 1);
   }
@@ -296,19 +458,19 @@ void BluetoothMetricsLogger::LogScanEvent(bool start,
                                           const std::string& initator,
                                           scan_tech_t type, uint32_t results,
                                           uint64_t timestamp_ms) {
-  ScanEvent* event = new ScanEvent();
+  ScanEvent event;
   if (start) {
-    event->set_scan_event_type(ScanEvent::SCAN_EVENT_START);
+    event.set_scan_event_type(ScanEvent::SCAN_EVENT_START);
   } else {
-    event->set_scan_event_type(ScanEvent::SCAN_EVENT_STOP);
+    event.set_scan_event_type(ScanEvent::SCAN_EVENT_STOP);
   }
-  event->set_initiator(initator);
-  event->set_scan_technology_type(get_scan_tech_type(type));
-  event->set_number_results(results);
-  event->set_event_time_millis(timestamp_ms);
-  pimpl_->scan_event_queue_->Enqueue(event);
+  event.set_initiator(initator);
+  event.set_scan_technology_type(get_scan_tech_type(type));
+  event.set_number_results(results);
+  event.set_event_time_millis(timestamp_ms);
   {
     std::lock_guard<std::recursive_mutex> lock(pimpl_->bluetooth_log_lock_);
+    pimpl_->scan_events_.Append(event);
     pimpl_->bluetooth_log_->set_num_scan_event(
         pimpl_->bluetooth_log_->num_scan_event() + 1);
   }
@@ -344,13 +506,14 @@ void BluetoothMetricsLogger::LogBluetoothSessionEnd(
   pimpl_->bluetooth_session_->set_session_duration_sec(session_duration_sec);
   pimpl_->bluetooth_session_->set_disconnect_reason_type(
       get_disconnect_reason_type(disconnect_reason));
-  pimpl_->bt_session_queue_->Enqueue(pimpl_->bluetooth_session_);
-  pimpl_->bluetooth_session_ = nullptr;
   {
     std::lock_guard<std::recursive_mutex> log_lock(pimpl_->bluetooth_log_lock_);
+    pimpl_->sessions_.Append(*pimpl_->bluetooth_session_);
     pimpl_->bluetooth_log_->set_num_bluetooth_session(
         pimpl_->bluetooth_log_->num_bluetooth_session() + 1);
   }
+  delete pimpl_->bluetooth_session_;
+  pimpl_->bluetooth_session_ = nullptr;
 }
 
 void BluetoothMetricsLogger::LogBluetoothSessionDeviceInfo(
@@ -399,14 +562,10 @@ void BluetoothMetricsLogger::LogA2dpSession(
 void BluetoothMetricsLogger::WriteString(std::string* serialized, bool clear) {
   std::lock_guard<std::recursive_mutex> lock(pimpl_->bluetooth_log_lock_);
   LOG_DEBUG(LOG_TAG, "%s building metrics", __func__);
-  Build();
-  LOG_DEBUG(LOG_TAG, "%s serializing metrics", __func__);
-  if (!pimpl_->bluetooth_log_->SerializeToString(serialized)) {
-    LOG_ERROR(LOG_TAG, "%s: error serializing metrics", __func__);
-    return;
-  }
+  CutoffSession();
+  Build(serialized);
   if (clear) {
-    pimpl_->bluetooth_log_->Clear();
+    ResetLog();
   }
 }
 
@@ -441,40 +600,48 @@ void BluetoothMetricsLogger::CutoffSession() {
   }
 }
 
-void BluetoothMetricsLogger::Build() {
+void BluetoothMetricsLogger::Build(std::string* serialized) {
   std::lock_guard<std::recursive_mutex> lock(pimpl_->bluetooth_log_lock_);
-  CutoffSession();
-  BluetoothLog* bluetooth_log = pimpl_->bluetooth_log_;
-  while (!pimpl_->bt_session_queue_->Empty() &&
-         static_cast<size_t>(bluetooth_log->session_size()) <=
-             pimpl_->bt_session_queue_->Capacity()) {
-    bluetooth_log->mutable_session()->AddAllocated(
-        pimpl_->bt_session_queue_->Dequeue());
-  }
-  while (!pimpl_->pair_event_queue_->Empty() &&
-         static_cast<size_t>(bluetooth_log->pair_event_size()) <=
-             pimpl_->pair_event_queue_->Capacity()) {
-    bluetooth_log->mutable_pair_event()->AddAllocated(
-        pimpl_->pair_event_queue_->Dequeue());
-  }
-  while (!pimpl_->scan_event_queue_->Empty() &&
-         static_cast<size_t>(bluetooth_log->scan_event_size()) <=
-             pimpl_->scan_event_queue_->Capacity()) {
-    bluetooth_log->mutable_scan_event()->AddAllocated(
-        pimpl_->scan_event_queue_->Dequeue());
-  }
-  while (!pimpl_->wake_event_queue_->Empty() &&
-         static_cast<size_t>(bluetooth_log->wake_event_size()) <=
-             pimpl_->wake_event_queue_->Capacity()) {
-    bluetooth_log->mutable_wake_event()->AddAllocated(
-        pimpl_->wake_event_queue_->Dequeue());
-  }
-  while (!pimpl_->bt_session_queue_->Empty() &&
-         static_cast<size_t>(bluetooth_log->wake_event_size()) <=
-             pimpl_->wake_event_queue_->Capacity()) {
-    bluetooth_log->mutable_wake_event()->AddAllocated(
-        pimpl_->wake_event_queue_->Dequeue());
-  }
+  const BluetoothLog* log = pimpl_->bluetooth_log_;
+
+  // The fields are written in field number order, like SerializeToString()
+  // does, so the result is the same as serializing the whole log.
+  serialized->clear();
+  pimpl_->sessions_.AppendTo(serialized);
+  pimpl_->pair_events_.AppendTo(serialized);
+  pimpl_->wake_events_.AppendTo(serialized);
+  pimpl_->scan_events_.AppendTo(serialized);
+
+  BluetoothLog counts;
+  if (log->has_num_bonded_devices())
+    counts.set_num_bonded_devices(log->num_bonded_devices());
+  if (log->has_num_bluetooth_session())
+    counts.set_num_bluetooth_session(log->num_bluetooth_session());
+  if (log->has_num_pair_event())
+    counts.set_num_pair_event(log->num_pair_event());
+  if (log->has_num_wake_event())
+    counts.set_num_wake_event(log->num_wake_event());
+  if (log->has_num_scan_event())
+    counts.set_num_scan_event(log->num_scan_event());
+  counts.AppendToString(serialized);
+
+  pimpl_->smp_pairing_events_.AppendTo(serialized);
+  counts.Clear();
+  if (log->has_num_smp_pairing_event())
+    counts.set_num_smp_pairing_event(log->num_smp_pairing_event());
+  counts.AppendToString(serialized);
+
+  pimpl_->link_quality_events_.AppendTo(serialized);
+  counts.Clear();
+  if (log->has_num_link_quality_event())
+    counts.set_num_link_quality_event(log->num_link_quality_event());
+  counts.AppendToString(serialized);
+
+  pimpl_->performance_counters_.AppendTo(serialized);
+  counts.Clear();
+  if (log->has_num_performance_counter())
+    counts.set_num_performance_counter(log->num_performance_counter());
+  counts.AppendToString(serialized);
 }
 
 void BluetoothMetricsLogger::ResetSession() {
@@ -490,15 +657,18 @@ void BluetoothMetricsLogger::ResetSession() {
 void BluetoothMetricsLogger::ResetLog() {
   std::lock_guard<std::recursive_mutex> lock(pimpl_->bluetooth_log_lock_);
   pimpl_->bluetooth_log_->Clear();
+  pimpl_->sessions_.Clear();
+  pimpl_->pair_events_.Clear();
+  pimpl_->wake_events_.Clear();
+  pimpl_->scan_events_.Clear();
+  pimpl_->smp_pairing_events_.Clear();
+  pimpl_->link_quality_events_.Clear();
+  pimpl_->performance_counters_.Clear();
 }
 
 void BluetoothMetricsLogger::Reset() {
   ResetSession();
   ResetLog();
-  pimpl_->bt_session_queue_->Clear();
-  pimpl_->pair_event_queue_->Clear();
-  pimpl_->wake_event_queue_->Clear();
-  pimpl_->scan_event_queue_->Clear();
 }
 
 }  // namespace system_bt_osi
@@ -142,6 +142,21 @@ void BluetoothMetricsLogger::LogPairEvent(uint32_t disconnect_reason,
   // TODO(siyuanh): Implement for linux
 }
 
+void BluetoothMetricsLogger::LogSmpPairingEvent(
+    uint64_t timestamp_ms, const SmpPairingMetrics& metrics) {
+  // TODO(siyuanh): Implement for linux
+}
+
+void BluetoothMetricsLogger::LogLinkQualityEvent(
+    uint64_t timestamp_ms, const LinkQualityMetrics& metrics) {
+  // TODO(siyuanh): Implement for linux
+}
+
+void BluetoothMetricsLogger::LogPerformanceCounter(
+    uint64_t timestamp_ms, const PerformanceCounterMetrics& metrics) {
+  // TODO(siyuanh): Implement for linux
+}
+
 void BluetoothMetricsLogger::LogWakeEvent(wake_event_type_t type,
                                           const std::string& requestor,
                                           const std::string& name,
@@ -193,7 +208,7 @@ void BluetoothMetricsLogger::CutoffSession() {
   // TODO(siyuanh): Implement for linux
 }
 
-void BluetoothMetricsLogger::Build() {
+void BluetoothMetricsLogger::Build(std::string* serialized) {
   // TODO(siyuanh): Implement for linux
 }
 
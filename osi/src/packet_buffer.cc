@@ -0,0 +1,354 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_osi_packet_buffer"
+
+#include "osi/include/packet_buffer.h"
+
+#include <base/logging.h>
+#include <string.h>
+
+#include <atomic>
+
+#include "osi/include/allocator.h"
+
+// A storage block. The bytes in [front, back) have been handed out to
+// segments; the bytes outside of it are free headroom and tailroom which a
+// segment adjacent to them may claim.
+typedef struct {
+  std::atomic<size_t> refcount;
+  std::atomic<size_t> front;
+  std::atomic<size_t> back;
+  size_t size;
+  uint8_t* base;
+  packet_buffer_release_cb release;
+  void* context;
+  uint8_t data[];  // Used when the storage is not external.
+} storage_t;
+
+typedef struct segment_t {
+  struct segment_t* next;
+  storage_t* storage;
+  size_t offset;  // Offset of the first byte within |storage|.
+  size_t length;
+} segment_t;
+
+struct packet_buffer_t {
+  segment_t* head;
+  segment_t* tail;
+  size_t length;
+  size_t segment_count;
+};
+
+static storage_t* storage_new(size_t size, size_t front, size_t back) {
+  storage_t* storage =
+      static_cast<storage_t*>(osi_malloc(sizeof(storage_t) + size));
+  new (&storage->refcount) std::atomic<size_t>(0);
+  new (&storage->front) std::atomic<size_t>(front);
+  new (&storage->back) std::atomic<size_t>(back);
+  storage->size = size;
+  storage->base = storage->data;
+  storage->release = NULL;
+  storage->context = NULL;
+  return storage;
+}
+
+static void storage_unref(storage_t* storage) {
+  if (storage->refcount.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+  if (storage->release) storage->release(storage->context);
+  osi_free(storage);
+}
+
+static segment_t* segment_new(storage_t* storage, size_t offset,
+                              size_t length) {
+  segment_t* segment = static_cast<segment_t*>(osi_malloc(sizeof(segment_t)));
+  storage->refcount.fetch_add(1, std::memory_order_relaxed);
+  segment->next = NULL;
+  segment->storage = storage;
+  segment->offset = offset;
+  segment->length = length;
+  return segment;
+}
+
+static void segment_free(segment_t* segment) {
+  storage_unref(segment->storage);
+  osi_free(segment);
+}
+
+static void push_front(packet_buffer_t* packet, segment_t* segment) {
+  segment->next = packet->head;
+  packet->head = segment;
+  if (!packet->tail) packet->tail = segment;
+  packet->length += segment->length;
+  packet->segment_count++;
+}
+
+static void push_back(packet_buffer_t* packet, segment_t* segment) {
+  segment->next = NULL;
+  if (packet->tail)
+    packet->tail->next = segment;
+  else
+    packet->head = segment;
+  packet->tail = segment;
+  packet->length += segment->length;
+  packet->segment_count++;
+}
+
+static segment_t* pop_front(packet_buffer_t* packet) {
+  segment_t* segment = packet->head;
+  packet->head = segment->next;
+  if (!packet->head) packet->tail = NULL;
+  packet->length -= segment->length;
+  packet->segment_count--;
+  segment->next = NULL;
+  return segment;
+}
+
+static packet_buffer_t* packet_new_empty(void) {
+  return static_cast<packet_buffer_t*>(osi_calloc(sizeof(packet_buffer_t)));
+}
+
+packet_buffer_t* packet_buffer_new(size_t headroom, size_t size) {
+  packet_buffer_t* packet = packet_new_empty();
+  storage_t* storage =
+      storage_new(headroom + size, headroom, headroom + size);
+  push_back(packet, segment_new(storage, headroom, size));
+  return packet;
+}
+
+packet_buffer_t* packet_buffer_new_copy(size_t headroom, const void* data,
+                                        size_t size) {
+  CHECK(data != NULL || size == 0);
+
+  packet_buffer_t* packet = packet_buffer_new(headroom, size);
+  if (size) memcpy(packet_buffer_data(packet), data, size);
+  return packet;
+}
+
+packet_buffer_t* packet_buffer_new_external(uint8_t* data, size_t headroom,
+                                            size_t size,
+                                            packet_buffer_release_cb release,
+                                            void* context) {
+  CHECK(data != NULL);
+
+  storage_t* storage = storage_new(0, headroom, headroom + size);
+  storage->size = headroom + size;
+  storage->base = data - headroom;
+  storage->release = release;
+  storage->context = context;
+
+  packet_buffer_t* packet = packet_new_empty();
+  push_back(packet, segment_new(storage, headroom, size));
+  return packet;
+}
+
+packet_buffer_t* packet_buffer_clone(const packet_buffer_t* packet) {
+  CHECK(packet != NULL);
+
+  packet_buffer_t* clone = packet_new_empty();
+  for (const segment_t* segment = packet->head; segment;
+       segment = segment->next) {
+    push_back(clone,
+              segment_new(segment->storage, segment->offset, segment->length));
+  }
+  return clone;
+}
+
+void packet_buffer_free(packet_buffer_t* packet) {
+  if (!packet) return;
+
+  while (packet->head) segment_free(pop_front(packet));
+  osi_free(packet);
+}
+
+size_t packet_buffer_length(const packet_buffer_t* packet) {
+  CHECK(packet != NULL);
+  return packet->length;
+}
+
+size_t packet_buffer_segment_count(const packet_buffer_t* packet) {
+  CHECK(packet != NULL);
+  return packet->segment_count;
+}
+
+size_t packet_buffer_headroom(const packet_buffer_t* packet) {
+  CHECK(packet != NULL);
+
+  const segment_t* head = packet->head;
+  if (!head) return 0;
+  // Headroom that another segment already claimed is not available.
+  if (head->storage->front.load(std::memory_order_relaxed) != head->offset)
+    return 0;
+  return head->offset;
+}
+
+uint8_t* packet_buffer_prepend(packet_buffer_t* packet, size_t size) {
+  CHECK(packet != NULL);
+  CHECK(size > 0);
+
+  segment_t* head = packet->head;
+  if (head) {
+    // Claim the headroom in front of the segment if nobody else has.
+    size_t expected = head->offset;
+    if (expected >= size &&
+        head->storage->front.compare_exchange_strong(expected,
+                                                     expected - size)) {
+      head->offset -= size;
+      head->length += size;
+      packet->length += size;
+      return head->storage->base + head->offset;
+    }
+  }
+
+  size_t headroom = PACKET_BUFFER_DEFAULT_HEADROOM;
+  storage_t* storage = storage_new(headroom + size, headroom, headroom + size);
+  push_front(packet, segment_new(storage, headroom, size));
+  return storage->base + headroom;
+}
+
+uint8_t* packet_buffer_append(packet_buffer_t* packet, size_t size) {
+  CHECK(packet != NULL);
+  CHECK(size > 0);
+
+  segment_t* tail = packet->tail;
+  if (tail) {
+    // Claim the tailroom behind the segment if nobody else has.
+    size_t end = tail->offset + tail->length;
+    size_t expected = end;
+    if (tail->storage->size - end >= size &&
+        tail->storage->back.compare_exchange_strong(expected, end + size)) {
+      tail->length += size;
+      packet->length += size;
+      return tail->storage->base + end;
+    }
+  }
+
+  storage_t* storage = storage_new(size, 0, size);
+  push_back(packet, segment_new(storage, 0, size));
+  return storage->base;
+}
+
+void packet_buffer_concat(packet_buffer_t* packet, packet_buffer_t* tail) {
+  CHECK(packet != NULL);
+  CHECK(tail != NULL);
+  CHECK(packet != tail);
+
+  while (tail->head) push_back(packet, pop_front(tail));
+  osi_free(tail);
+}
+
+void packet_buffer_trim_front(packet_buffer_t* packet, size_t size) {
+  CHECK(packet != NULL);
+  CHECK(size <= packet->length);
+
+  while (size > 0) {
+    segment_t* head = packet->head;
+    if (head->length <= size) {
+      size -= head->length;
+      segment_free(pop_front(packet));
+      continue;
+    }
+    head->offset += size;
+    head->length -= size;
+    packet->length -= size;
+    size = 0;
+  }
+}
+
+void packet_buffer_trim_back(packet_buffer_t* packet, size_t size) {
+  CHECK(packet != NULL);
+  CHECK(size <= packet->length);
+
+  // Split off the bytes to keep, then swap them into |packet| and free the
+  // trimmed remainder.
+  packet_buffer_t* kept = packet_buffer_split(packet, packet->length - size);
+  packet_buffer_t swap = *packet;
+  *packet = *kept;
+  *kept = swap;
+  packet_buffer_free(kept);
+}
+
+packet_buffer_t* packet_buffer_split(packet_buffer_t* packet, size_t size) {
+  CHECK(packet != NULL);
+  CHECK(size <= packet->length);
+
+  packet_buffer_t* front = packet_new_empty();
+  while (size > 0) {
+    segment_t* head = packet->head;
+    if (head->length <= size) {
+      size -= head->length;
+      push_back(front, pop_front(packet));
+      continue;
+    }
+
+    // The segment straddles the split point; both halves share its storage.
+    push_back(front, segment_new(head->storage, head->offset, size));
+    head->offset += size;
+    head->length -= size;
+    packet->length -= size;
+    size = 0;
+  }
+  return front;
+}
+
+size_t packet_buffer_get_iovec(const packet_buffer_t* packet,
+                               struct iovec* iov, size_t max_iov) {
+  CHECK(packet != NULL);
+  CHECK(iov != NULL);
+
+  size_t count = 0;
+  for (const segment_t* segment = packet->head; segment && count < max_iov;
+       segment = segment->next) {
+    if (segment->length == 0) continue;
+    iov[count].iov_base = segment->storage->base + segment->offset;
+    iov[count].iov_len = segment->length;
+    count++;
+  }
+  return count;
+}
+
+size_t packet_buffer_copy_out(const packet_buffer_t* packet, size_t offset,
+                              void* dest, size_t size) {
+  CHECK(packet != NULL);
+  CHECK(dest != NULL || size == 0);
+
+  uint8_t* out = static_cast<uint8_t*>(dest);
+  size_t copied = 0;
+  for (const segment_t* segment = packet->head; segment && copied < size;
+       segment = segment->next) {
+    if (offset >= segment->length) {
+      offset -= segment->length;
+      continue;
+    }
+
+    size_t chunk = segment->length - offset;
+    if (chunk > size - copied) chunk = size - copied;
+    memcpy(out + copied, segment->storage->base + segment->offset + offset,
+           chunk);
+    copied += chunk;
+    offset = 0;
+  }
+  return copied;
+}
+
+uint8_t* packet_buffer_data(const packet_buffer_t* packet) {
+  CHECK(packet != NULL);
+
+  if (packet->segment_count != 1) return NULL;
+  return packet->head->storage->base + packet->head->offset;
+}
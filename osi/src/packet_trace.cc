@@ -0,0 +1,245 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+
+#define LOG_TAG "bt_osi_packet_trace"
+
+#include "osi/include/packet_trace.h"
+
+#include <base/logging.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <mutex>
+
+#include "osi/include/log.h"
+#include "osi/include/osi.h"
+#include "osi/include/time.h"
+
+// Number of packets that can be traced at the same time. The table is direct
+// mapped; a packet hashing to a busy slot evicts the trace stored there.
+#define PACKET_TRACE_TABLE_SIZE 1024
+
+typedef struct {
+  const void* packet;
+  uint64_t first_us;
+  uint64_t last_us;
+  packet_trace_point_t point;
+} trace_entry_t;
+
+static const char* segment_names[PACKET_TRACE_SEGMENT_COUNT] = {
+    "tx_l2cap_queue", "tx_hci", "tx_total", "rx_hci", "rx_l2cap", "rx_total"};
+
+static const char* ftrace_marker_paths[] = {
+    "/sys/kernel/tracing/trace_marker",
+    "/sys/kernel/debug/tracing/trace_marker"};
+
+static std::atomic<bool> trace_enabled(false);
+static std::mutex trace_lock;
+static trace_entry_t trace_table[PACKET_TRACE_TABLE_SIZE];
+static packet_trace_stats_t trace_stats[PACKET_TRACE_SEGMENT_COUNT];
+static uint64_t trace_evictions;
+static int ftrace_fd = INVALID_FD;
+
+static bool is_tx_point(packet_trace_point_t point) {
+  return point <= PACKET_TRACE_TX_HCI_SENT;
+}
+
+static bool is_start_point(packet_trace_point_t point) {
+  return point == PACKET_TRACE_TX_L2CAP_QUEUED ||
+         point == PACKET_TRACE_RX_HCI_RECEIVED;
+}
+
+static bool is_final_point(packet_trace_point_t point) {
+  return point == PACKET_TRACE_TX_HCI_SENT ||
+         point == PACKET_TRACE_RX_DELIVERED;
+}
+
+// Segment ending at |point|. Must not be called for start points.
+static packet_trace_segment_t segment_for(packet_trace_point_t point) {
+  switch (point) {
+    case PACKET_TRACE_TX_L2CAP_SENT:
+      return PACKET_TRACE_SEGMENT_TX_L2CAP_QUEUE;
+    case PACKET_TRACE_TX_HCI_SENT:
+      return PACKET_TRACE_SEGMENT_TX_HCI;
+    case PACKET_TRACE_RX_L2CAP_RECEIVED:
+      return PACKET_TRACE_SEGMENT_RX_HCI;
+    default:
+      return PACKET_TRACE_SEGMENT_RX_L2CAP;
+  }
+}
+
+static trace_entry_t* slot_for(const void* packet) {
+  uint64_t hash = (uint64_t)(uintptr_t)packet * 0x9E3779B97F4A7C15ULL;
+  return &trace_table[(hash >> 32) % PACKET_TRACE_TABLE_SIZE];
+}
+
+static void record_locked(packet_trace_segment_t segment, uint64_t latency_us) {
+  packet_trace_stats_t* stats = &trace_stats[segment];
+  stats->count++;
+  stats->total_us += latency_us;
+  if (latency_us > stats->max_us) stats->max_us = latency_us;
+
+  size_t bucket = 0;
+  while (bucket < PACKET_TRACE_HISTOGRAM_BUCKETS - 1 &&
+         latency_us >= (1ULL << bucket))
+    bucket++;
+  stats->histogram[bucket]++;
+
+  if (ftrace_fd != INVALID_FD) {
+    char line[64];
+    int length = snprintf(line, sizeof(line), "C|%d|bt_%s_us|%" PRIu64 "\n",
+                          getpid(), segment_names[segment], latency_us);
+    // A failed write only loses this sample from the trace.
+    ssize_t ret;
+    OSI_NO_INTR(ret = write(ftrace_fd, line, length));
+  }
+}
+
+void packet_trace_init(bool enabled, bool ftrace_export) {
+  std::lock_guard<std::mutex> lock(trace_lock);
+
+  memset(trace_table, 0, sizeof(trace_table));
+  memset(trace_stats, 0, sizeof(trace_stats));
+  trace_evictions = 0;
+
+  if (ftrace_fd != INVALID_FD) {
+    close(ftrace_fd);
+    ftrace_fd = INVALID_FD;
+  }
+  if (enabled && ftrace_export) {
+    for (const char* path : ftrace_marker_paths) {
+      ftrace_fd = open(path, O_WRONLY | O_CLOEXEC);
+      if (ftrace_fd != INVALID_FD) break;
+    }
+    if (ftrace_fd == INVALID_FD)
+      LOG_WARN(LOG_TAG, "%s unable to open trace marker: %s", __func__,
+               strerror(errno));
+  }
+
+  trace_enabled.store(enabled, std::memory_order_release);
+}
+
+bool packet_trace_is_enabled(void) {
+  return trace_enabled.load(std::memory_order_relaxed);
+}
+
+void packet_trace_mark(const void* packet, packet_trace_point_t point) {
+  CHECK(point < PACKET_TRACE_POINT_COUNT);
+  if (!trace_enabled.load(std::memory_order_relaxed) || packet == NULL) return;
+
+  uint64_t now_us = time_get_os_boottime_us();
+  std::lock_guard<std::mutex> lock(trace_lock);
+
+  trace_entry_t* entry = slot_for(packet);
+  // Partially sent packets pass the same point more than once.
+  if (entry->packet == packet && entry->point == point &&
+      !is_start_point(point))
+    return;
+
+  if (entry->packet == packet && !is_start_point(point) &&
+      is_tx_point(entry->point) == is_tx_point(point) &&
+      entry->point < point) {
+    record_locked(segment_for(point), now_us - entry->last_us);
+    if (is_final_point(point)) {
+      record_locked(is_tx_point(point) ? PACKET_TRACE_SEGMENT_TX_TOTAL
+                                       : PACKET_TRACE_SEGMENT_RX_TOTAL,
+                    now_us - entry->first_us);
+      entry->packet = NULL;
+      return;
+    }
+    entry->point = point;
+    entry->last_us = now_us;
+    return;
+  }
+
+  // A final point without a matching trace has nothing to measure.
+  if (is_final_point(point)) {
+    if (entry->packet == packet) entry->packet = NULL;
+    return;
+  }
+
+  if (entry->packet != NULL && entry->packet != packet) trace_evictions++;
+  entry->packet = packet;
+  entry->first_us = now_us;
+  entry->last_us = now_us;
+  entry->point = point;
+}
+
+void packet_trace_move(const void* from, const void* to) {
+  if (!trace_enabled.load(std::memory_order_relaxed) || from == to) return;
+
+  std::lock_guard<std::mutex> lock(trace_lock);
+  trace_entry_t* source = slot_for(from);
+  if (source->packet != from) return;
+
+  trace_entry_t entry = *source;
+  source->packet = NULL;
+
+  trace_entry_t* destination = slot_for(to);
+  if (destination->packet != NULL) trace_evictions++;
+  *destination = entry;
+  destination->packet = to;
+}
+
+void packet_trace_forget(const void* packet) {
+  if (!trace_enabled.load(std::memory_order_relaxed)) return;
+
+  std::lock_guard<std::mutex> lock(trace_lock);
+  trace_entry_t* entry = slot_for(packet);
+  if (entry->packet == packet) entry->packet = NULL;
+}
+
+void packet_trace_get_stats(packet_trace_segment_t segment,
+                            packet_trace_stats_t* stats) {
+  CHECK(segment < PACKET_TRACE_SEGMENT_COUNT);
+  CHECK(stats != NULL);
+
+  std::lock_guard<std::mutex> lock(trace_lock);
+  *stats = trace_stats[segment];
+}
+
+void packet_trace_debug_dump(int fd) {
+  if (!packet_trace_is_enabled()) return;
+
+  std::lock_guard<std::mutex> lock(trace_lock);
+  dprintf(fd, "\nPacket Latency:\n");
+  dprintf(fd, "  Evicted traces: %" PRIu64 "  ftrace export: %s\n",
+          trace_evictions, ftrace_fd != INVALID_FD ? "enabled" : "disabled");
+  for (size_t i = 0; i < PACKET_TRACE_SEGMENT_COUNT; i++) {
+    const packet_trace_stats_t* stats = &trace_stats[i];
+    dprintf(fd,
+            "  %-14s count: %" PRIu64 "  avg/max us : %" PRIu64 " / %" PRIu64
+            "\n    us:",
+            segment_names[i], stats->count,
+            stats->count ? stats->total_us / stats->count : 0, stats->max_us);
+    for (size_t j = 0; j < PACKET_TRACE_HISTOGRAM_BUCKETS; j++) {
+      if (stats->histogram[j] == 0) continue;
+      if (j == PACKET_TRACE_HISTOGRAM_BUCKETS - 1)
+        dprintf(fd, " >=%llu:%u", 1ULL << (j - 1), stats->histogram[j]);
+      else
+        dprintf(fd, " <%llu:%u", 1ULL << j, stats->histogram[j]);
+    }
+    dprintf(fd, "\n");
+  }
+}
@@ -16,8 +16,17 @@
  *
  ******************************************************************************/
 
+#include <errno.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include <atomic>
+#include <mutex>
+
+#if !defined(OS_GENERIC)
+#include <sys/system_properties.h>
+#endif
+
 #include "osi/include/properties.h"
 #include "hardware/vendor.h"
 #include "bt_target.h"
@@ -28,6 +37,13 @@
 
 bt_property_callout_t* property_callouts = NULL;
 
+static std::mutex cached_property_lock;
+
+#if defined(OS_GENERIC)
+// Stands in for the property area serial, bumped on every write
+static std::atomic<uint32_t> generic_property_serial(1);
+#endif
+
 int osi_property_get(const char* key, char* value, const char* default_value) {
 #if defined(OS_GENERIC)
   #if (OFF_TARGET_TEST_ENABLED == TRUE)
@@ -54,6 +70,7 @@ int osi_property_get(const char* key, char* value, const char* default_value) {
 
 int osi_property_set(const char* key, const char* value) {
 #if defined(OS_GENERIC)
+  generic_property_serial++;
   #if (OFF_TARGET_TEST_ENABLED == TRUE)
     return property_set(key, value);
   #else
@@ -91,4 +108,89 @@ bool osi_property_get_bool(const char* key, bool default_value) {
 
 void set_prop_callouts(bt_property_callout_t* callouts) {
   property_callouts = callouts;
+#if defined(OS_GENERIC)
+  generic_property_serial++;
+#endif
+}
+
+static uint32_t property_area_serial(void) {
+#if defined(OS_GENERIC)
+  return generic_property_serial;
+#else
+  return __system_property_area_serial();
+#endif
+}
+
+// Reads |prop| again if it may have changed since the last read.
+// Must be called with cached_property_lock held.
+static void cached_property_refresh(osi_cached_property_t* prop) {
+  uint32_t area_serial = property_area_serial();
+  if (prop->valid && prop->area_serial == area_serial) return;
+
+#if !defined(OS_GENERIC)
+  // Another property changed, unless this one's own serial moved too
+  if (prop->pi == NULL) prop->pi = __system_property_find(prop->key);
+  uint32_t prop_serial =
+      prop->pi ? __system_property_serial((const prop_info*)prop->pi) : 0;
+  if (prop->valid && prop->pi && prop_serial == prop->prop_serial) {
+    prop->area_serial = area_serial;
+    return;
+  }
+  prop->prop_serial = prop_serial;
+#endif
+
+  prop->len = osi_property_get(prop->key, prop->value, NULL);
+  prop->area_serial = area_serial;
+  prop->valid = true;
+}
+
+int osi_cached_property_get(osi_cached_property_t* prop, char* value,
+                            const char* default_value) {
+  std::lock_guard<std::mutex> lock(cached_property_lock);
+  cached_property_refresh(prop);
+
+  if (prop->len > 0) {
+    memcpy(value, prop->value, prop->len + 1);
+    return prop->len;
+  }
+
+  int len = 0;
+  if (!default_value) return len;
+
+  len = strlen(default_value);
+  if (len >= PROPERTY_VALUE_MAX) len = PROPERTY_VALUE_MAX - 1;
+
+  memcpy(value, default_value, len);
+  value[len] = '\0';
+  return len;
+}
+
+int32_t osi_cached_property_get_int32(osi_cached_property_t* prop,
+                                      int32_t default_value) {
+  char value[PROPERTY_VALUE_MAX];
+  if (osi_cached_property_get(prop, value, NULL) == 0) return default_value;
+
+  // Same parsing as property_get_int32
+  char* end;
+  errno = 0;
+  long long result = strtoll(value, &end, 0);
+  if (end == value || *end != '\0' || errno == ERANGE ||
+      result < INT32_MIN || result > INT32_MAX)
+    return default_value;
+  return (int32_t)result;
+}
+
+bool osi_cached_property_get_bool(osi_cached_property_t* prop,
+                                  bool default_value) {
+  char value[PROPERTY_VALUE_MAX];
+  if (osi_cached_property_get(prop, value, NULL) == 0) return default_value;
+
+  // Same parsing as property_get_bool
+  if (!strcmp(value, "1") || !strcmp(value, "y") || !strcmp(value, "yes") ||
+      !strcmp(value, "on") || !strcmp(value, "true"))
+    return true;
+  if (!strcmp(value, "0") || !strcmp(value, "n") || !strcmp(value, "no") ||
+      !strcmp(value, "off") || !strcmp(value, "false"))
+    return false;
+  return default_value;
 }
@@ -23,12 +23,14 @@
 #include <base/logging.h>
 #include <errno.h>
 #include <pthread.h>
+#include <sched.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
 #include <unistd.h>
 
+#include <atomic>
 #include <mutex>
 
 #include "osi/include/allocator.h"
@@ -47,6 +49,16 @@ struct reactor_t {
   pthread_t run_thread;       // the pthread on which reactor_run is executing.
   bool is_running;            // indicates whether |run_thread| is valid.
   bool object_removed;
+
+  size_t max_events;            // maximum events fetched per epoll_wait.
+  struct epoll_event* events;   // buffer of |max_events| entries.
+
+  // Number of objects added to |invalidation_list| since it was last cleared.
+  // While it is zero the reactor thread dispatches without |list_mutex|.
+  std::atomic<size_t> invalidation_count;
+  // The object whose callbacks the reactor thread is about to run or is
+  // running. |reactor_unregister| waits for it to change before freeing.
+  std::atomic<reactor_object_t*> dispatching;
 };
 
 struct reactor_object_t {
@@ -54,6 +66,7 @@ struct reactor_object_t {
   void* context;       // a context that's passed back to the *_ready functions.
   reactor_t* reactor;  // the reactor instance this object is registered with.
   std::mutex* mutex;  // protects the lifetime of this object and all variables.
+  bool edge_triggered;  // registered with EPOLLET.
 
   void (*read_ready)(void* context);   // function to call when the file
                                        // descriptor becomes readable.
@@ -61,18 +74,35 @@ struct reactor_object_t {
                                        // descriptor becomes writeable.
 };
 
+static reactor_object_t* register_object(reactor_t* reactor, int fd,
+                                         void* context,
+                                         void (*read_ready)(void* context),
+                                         void (*write_ready)(void* context),
+                                         bool edge_triggered);
+static uint32_t object_events(const reactor_object_t* object,
+                              void (*read_ready)(void* context),
+                              void (*write_ready)(void* context));
 static reactor_status_t run_reactor(reactor_t* reactor, int iterations);
 
 static const size_t MAX_EVENTS = 64;
 static const eventfd_t EVENT_REACTOR_STOP = 1;
 
-reactor_t* reactor_new(void) {
+reactor_t* reactor_new(void) { return reactor_new_with_max_events(MAX_EVENTS); }
+
+reactor_t* reactor_new_with_max_events(size_t max_events) {
+  CHECK(max_events > 0);
+
   reactor_t* ret = (reactor_t*)osi_calloc(sizeof(reactor_t));
 
   ret->epoll_fd = INVALID_FD;
   ret->event_fd = INVALID_FD;
+  ret->max_events = max_events;
+  ret->events = (struct epoll_event*)osi_calloc(max_events *
+                                                sizeof(struct epoll_event));
+  new (&ret->invalidation_count) std::atomic<size_t>(0);
+  new (&ret->dispatching) std::atomic<reactor_object_t*>(nullptr);
 
-  ret->epoll_fd = epoll_create(MAX_EVENTS);
+  ret->epoll_fd = epoll_create(max_events);
   if (ret->epoll_fd == INVALID_FD) {
     LOG_ERROR(LOG_TAG, "%s unable to create epoll instance: %s", __func__,
               strerror(errno));
@@ -117,6 +147,7 @@ void reactor_free(reactor_t* reactor) {
   list_free(reactor->invalidation_list);
   close(reactor->event_fd);
   close(reactor->epoll_fd);
+  osi_free(reactor->events);
   osi_free(reactor);
 }
 
@@ -139,6 +170,30 @@ void reactor_stop(reactor_t* reactor) {
 reactor_object_t* reactor_register(reactor_t* reactor, int fd, void* context,
                                    void (*read_ready)(void* context),
                                    void (*write_ready)(void* context)) {
+  return register_object(reactor, fd, context, read_ready, write_ready, false);
+}
+
+reactor_object_t* reactor_register_edge_triggered(
+    reactor_t* reactor, int fd, void* context,
+    void (*read_ready)(void* context), void (*write_ready)(void* context)) {
+  return register_object(reactor, fd, context, read_ready, write_ready, true);
+}
+
+static uint32_t object_events(const reactor_object_t* object,
+                              void (*read_ready)(void* context),
+                              void (*write_ready)(void* context)) {
+  uint32_t events = 0;
+  if (read_ready) events |= (EPOLLIN | EPOLLRDHUP);
+  if (write_ready) events |= EPOLLOUT;
+  if (object->edge_triggered) events |= EPOLLET;
+  return events;
+}
+
+static reactor_object_t* register_object(reactor_t* reactor, int fd,
+                                         void* context,
+                                         void (*read_ready)(void* context),
+                                         void (*write_ready)(void* context),
+                                         bool edge_triggered) {
   CHECK(reactor != NULL);
   CHECK(fd != INVALID_FD);
 
@@ -151,11 +206,11 @@ reactor_object_t* reactor_register(reactor_t* reactor, int fd, void* context,
   object->read_ready = read_ready;
   object->write_ready = write_ready;
   object->mutex = new std::mutex;
+  object->edge_triggered = edge_triggered;
 
   struct epoll_event event;
   memset(&event, 0, sizeof(event));
-  if (read_ready) event.events |= (EPOLLIN | EPOLLRDHUP);
-  if (write_ready) event.events |= EPOLLOUT;
+  event.events = object_events(object, read_ready, write_ready);
   event.data.ptr = object;
 
   if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1) {
@@ -176,8 +231,7 @@ bool reactor_change_registration(reactor_object_t* object,
 
   struct epoll_event event;
   memset(&event, 0, sizeof(event));
-  if (read_ready) event.events |= (EPOLLIN | EPOLLRDHUP);
-  if (write_ready) event.events |= EPOLLOUT;
+  event.events = object_events(object, read_ready, write_ready);
   event.data.ptr = object;
 
   if (epoll_ctl(object->reactor->epoll_fd, EPOLL_CTL_MOD, object->fd, &event) ==
@@ -212,16 +266,21 @@ void reactor_unregister(reactor_object_t* obj) {
   {
     std::unique_lock<std::mutex> lock(*reactor->list_mutex);
     list_append(reactor->invalidation_list, obj);
+    reactor->invalidation_count.fetch_add(1);
   }
 
-  // Taking the object lock here makes sure a callback for |obj| isn't
-  // currently executing. The reactor thread must then either be before
-  // the callbacks or after. If after, we know that the object won't be
-  // referenced because it has been taken out of the epoll set. If before,
-  // it won't be referenced because the reactor thread will check the
-  // invalidation_list and find it in there. So by taking this lock, we
-  // are waiting until the reactor thread drops all references to |obj|.
-  // One the wait completes, we can unlock and destroy |obj| safely.
+  // The reactor thread publishes the object it is about to dispatch in
+  // |dispatching| before it checks |invalidation_count|. Either it saw the
+  // increment above and will find |obj| in the invalidation_list, or |obj|
+  // is published here and we wait until the reactor thread is done with it.
+  // Taking the object lock blocks while a callback for |obj| is executing;
+  // once |dispatching| moves on, the reactor thread holds no reference to
+  // |obj| and we can destroy it safely.
+  while (reactor->dispatching.load() == obj) {
+    obj->mutex->lock();
+    obj->mutex->unlock();
+    sched_yield();
+  }
   obj->mutex->lock();
   obj->mutex->unlock();
   delete obj->mutex;
@@ -237,15 +296,17 @@ static reactor_status_t run_reactor(reactor_t* reactor, int iterations) {
   reactor->run_thread = pthread_self();
   reactor->is_running = true;
 
-  struct epoll_event events[MAX_EVENTS];
+  struct epoll_event* events = reactor->events;
   for (int i = 0; iterations == 0 || i < iterations; ++i) {
     {
       std::lock_guard<std::mutex> lock(*reactor->list_mutex);
       list_clear(reactor->invalidation_list);
+      reactor->invalidation_count.store(0);
     }
 
     int ret;
-    OSI_NO_INTR(ret = epoll_wait(reactor->epoll_fd, events, MAX_EVENTS, -1));
+    OSI_NO_INTR(ret = epoll_wait(reactor->epoll_fd, events,
+                                 reactor->max_events, -1));
     if (ret == -1) {
       LOG_ERROR(LOG_TAG, "%s error in epoll_wait: %s", __func__,
                 strerror(errno));
@@ -266,15 +327,19 @@ static reactor_status_t run_reactor(reactor_t* reactor, int iterations) {
 
       reactor_object_t* object = (reactor_object_t*)events[j].data.ptr;
 
-      std::unique_lock<std::mutex> lock(*reactor->list_mutex);
-      if (list_contains(reactor->invalidation_list, object)) {
-        continue;
+      // Only consult the invalidation_list when something was unregistered
+      // from another thread during this batch. See |reactor_unregister|.
+      reactor->dispatching.store(object);
+      if (reactor->invalidation_count.load() != 0) {
+        std::lock_guard<std::mutex> lock(*reactor->list_mutex);
+        if (list_contains(reactor->invalidation_list, object)) {
+          reactor->dispatching.store(nullptr);
+          continue;
+        }
       }
 
-      // Downgrade the list lock to an object lock.
       {
         std::lock_guard<std::mutex> obj_lock(*object->mutex);
-        lock.unlock();
 
         reactor->object_removed = false;
         if (events[j].events & (EPOLLIN | EPOLLHUP | EPOLLRDHUP | EPOLLERR) &&
@@ -284,6 +349,7 @@ static reactor_status_t run_reactor(reactor_t* reactor, int iterations) {
             object->write_ready)
           object->write_ready(object->context);
       }
+      reactor->dispatching.store(nullptr);
 
       if (reactor->object_removed) {
         delete object->mutex;
@@ -18,6 +18,7 @@
 
 #include <base/logging.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "osi/include/allocator.h"
 #include "osi/include/ringbuffer.h"
@@ -25,6 +26,7 @@
 struct ringbuffer_t {
   size_t total;
   size_t available;
+  size_t mask;  // |total| - 1 if |total| is a power of two, 0 otherwise.
   uint8_t* base;
   uint8_t* head;
   uint8_t* tail;
@@ -37,6 +39,7 @@ ringbuffer_t* ringbuffer_init(const size_t size) {
   p->base = static_cast<uint8_t*>(osi_calloc(size));
   p->head = p->tail = p->base;
   p->total = p->available = size;
+  if (size > 1 && (size & (size - 1)) == 0) p->mask = size - 1;
 
   return p;
 }
@@ -56,19 +59,40 @@ size_t ringbuffer_size(const ringbuffer_t* rb) {
   return rb->total - rb->available;
 }
 
+// Returns the address |offset| bytes past |from|, wrapping around the end of
+// the buffer. |offset| may be at most |rb->total|.
+static uint8_t* advance(const ringbuffer_t* rb, const uint8_t* from,
+                        size_t offset) {
+  size_t index = (from - rb->base) + offset;
+  if (rb->mask)
+    index &= rb->mask;
+  else if (index >= rb->total)
+    index -= rb->total;
+  return rb->base + index;
+}
+
+// Describes the |length| bytes starting at |start| as one or two contiguous
+// regions.
+static void make_span(const ringbuffer_t* rb, uint8_t* start, size_t length,
+                      ringbuffer_span_t* span) {
+  size_t to_end = (rb->base + rb->total) - start;
+  span->first = start;
+  span->first_length = (length < to_end) ? length : to_end;
+  span->second = (length > to_end) ? rb->base : NULL;
+  span->second_length = length - span->first_length;
+}
+
 size_t ringbuffer_insert(ringbuffer_t* rb, const uint8_t* p, size_t length) {
   CHECK(rb);
   CHECK(p);
 
-  if (length > ringbuffer_available(rb)) length = ringbuffer_available(rb);
+  ringbuffer_span_t span;
+  length = ringbuffer_reserve(rb, length, &span);
+  memcpy(span.first, p, span.first_length);
+  if (span.second_length)
+    memcpy(span.second, p + span.first_length, span.second_length);
 
-  for (size_t i = 0; i != length; ++i) {
-    *rb->tail++ = *p++;
-    if (rb->tail >= (rb->base + rb->total)) rb->tail = rb->base;
-  }
-
-  rb->available -= length;
-  return length;
+  return ringbuffer_commit(rb, length);
 }
 
 size_t ringbuffer_delete(ringbuffer_t* rb, size_t length) {
@@ -76,9 +100,7 @@ size_t ringbuffer_delete(ringbuffer_t* rb, size_t length) {
 
   if (length > ringbuffer_size(rb)) length = ringbuffer_size(rb);
 
-  rb->head += length;
-  if (rb->head >= (rb->base + rb->total)) rb->head -= rb->total;
-
+  rb->head = advance(rb, rb->head, length);
   rb->available += length;
   return length;
 }
@@ -90,15 +112,15 @@ size_t ringbuffer_peek(const ringbuffer_t* rb, off_t offset, uint8_t* p,
   CHECK(offset >= 0);
   CHECK((size_t)offset <= ringbuffer_size(rb));
 
-  uint8_t* b = ((rb->head - rb->base + offset) % rb->total) + rb->base;
   const size_t bytes_to_copy = (offset + length > ringbuffer_size(rb))
                                    ? ringbuffer_size(rb) - offset
                                    : length;
 
-  for (size_t copied = 0; copied < bytes_to_copy; ++copied) {
-    *p++ = *b++;
-    if (b >= (rb->base + rb->total)) b = rb->base;
-  }
+  ringbuffer_span_t span;
+  make_span(rb, advance(rb, rb->head, offset), bytes_to_copy, &span);
+  memcpy(p, span.first, span.first_length);
+  if (span.second_length)
+    memcpy(p + span.first_length, span.second, span.second_length);
 
   return bytes_to_copy;
 }
@@ -108,9 +130,39 @@ size_t ringbuffer_pop(ringbuffer_t* rb, uint8_t* p, size_t length) {
   CHECK(p);
 
   const size_t copied = ringbuffer_peek(rb, 0, p, length);
-  rb->head += copied;
-  if (rb->head >= (rb->base + rb->total)) rb->head -= rb->total;
+  return ringbuffer_delete(rb, copied);
+}
+
+size_t ringbuffer_reserve(ringbuffer_t* rb, size_t length,
+                          ringbuffer_span_t* span) {
+  CHECK(rb);
+  CHECK(span);
+
+  if (length > rb->available) length = rb->available;
+  make_span(rb, rb->tail, length, span);
+  return length;
+}
+
+size_t ringbuffer_commit(ringbuffer_t* rb, size_t length) {
+  CHECK(rb);
+
+  if (length > rb->available) length = rb->available;
+
+  rb->tail = advance(rb, rb->tail, length);
+  rb->available -= length;
+  return length;
+}
+
+size_t ringbuffer_acquire(const ringbuffer_t* rb, size_t length,
+                          ringbuffer_span_t* span) {
+  CHECK(rb);
+  CHECK(span);
+
+  if (length > ringbuffer_size(rb)) length = ringbuffer_size(rb);
+  make_span(rb, rb->head, length, span);
+  return length;
+}
 
-  rb->available += copied;
-  return copied;
+size_t ringbuffer_release(ringbuffer_t* rb, size_t length) {
+  return ringbuffer_delete(rb, length);
 }
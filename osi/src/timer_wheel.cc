@@ -0,0 +1,378 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include "osi/include/timer_wheel.h"
+
+#include <base/logging.h>
+
+#include "osi/include/allocator.h"
+
+// Each level has 64 slots. A slot on level L covers 64^L milliseconds, so four
+// levels cover a little more than 4.6 hours; anything further out is parked
+// on the overflow list until it comes within range.
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_MASK ((period_ms_t)WHEEL_SIZE - 1)
+#define WHEEL_LEVELS 4
+#define WHEEL_HORIZON_MS ((period_ms_t)1 << (WHEEL_BITS * WHEEL_LEVELS))
+
+// Level value used for the |ready| and |overflow| lists, which are not
+// tracked in the occupancy bitmaps.
+#define WHEEL_LEVEL_NONE WHEEL_LEVELS
+
+struct timer_wheel_slot_t {
+  timer_wheel_node_t* head;
+  timer_wheel_node_t* tail;
+  uint8_t level;
+  uint8_t index;
+};
+
+struct timer_wheel_t {
+  // First millisecond that has not been processed yet. Every node on level L
+  // expires within 64^(L+1) ms of |base|.
+  period_ms_t base;
+  size_t size;
+  uint64_t bitmap[WHEEL_LEVELS];  // bit N set if slots[L][N] is non-empty
+  timer_wheel_slot_t slots[WHEEL_LEVELS][WHEEL_SIZE];
+  timer_wheel_slot_t ready;     // expired nodes waiting to be popped
+  timer_wheel_slot_t overflow;  // nodes beyond |WHEEL_HORIZON_MS|
+};
+
+static void slot_append(timer_wheel_t* wheel, timer_wheel_slot_t* slot,
+                        timer_wheel_node_t* node) {
+  node->slot = slot;
+  node->next = NULL;
+  node->prev = slot->tail;
+  if (slot->tail)
+    slot->tail->next = node;
+  else
+    slot->head = node;
+  slot->tail = node;
+
+  if (slot->level != WHEEL_LEVEL_NONE)
+    wheel->bitmap[slot->level] |= (1ULL << slot->index);
+}
+
+static void slot_unlink(timer_wheel_t* wheel, timer_wheel_node_t* node) {
+  timer_wheel_slot_t* slot = node->slot;
+
+  if (node->prev)
+    node->prev->next = node->next;
+  else
+    slot->head = node->next;
+  if (node->next)
+    node->next->prev = node->prev;
+  else
+    slot->tail = node->prev;
+
+  if (slot->head == NULL && slot->level != WHEEL_LEVEL_NONE)
+    wheel->bitmap[slot->level] &= ~(1ULL << slot->index);
+
+  node->prev = node->next = NULL;
+  node->slot = NULL;
+}
+
+// Detaches and returns the whole list held by |slot|.
+static timer_wheel_node_t* slot_take_all(timer_wheel_t* wheel,
+                                         timer_wheel_slot_t* slot) {
+  timer_wheel_node_t* head = slot->head;
+  slot->head = slot->tail = NULL;
+  if (slot->level != WHEEL_LEVEL_NONE)
+    wheel->bitmap[slot->level] &= ~(1ULL << slot->index);
+  return head;
+}
+
+// Files |node| into the slot matching its deadline relative to |base|.
+static void place(timer_wheel_t* wheel, timer_wheel_node_t* node) {
+  if (node->deadline < wheel->base) {
+    slot_append(wheel, &wheel->ready, node);
+    return;
+  }
+
+  period_ms_t delta = node->deadline - wheel->base;
+  if (delta >= WHEEL_HORIZON_MS) {
+    slot_append(wheel, &wheel->overflow, node);
+    return;
+  }
+
+  int level = 0;
+  while (delta >= ((period_ms_t)1 << (WHEEL_BITS * (level + 1)))) level++;
+  size_t index = (node->deadline >> (WHEEL_BITS * level)) & WHEEL_MASK;
+  slot_append(wheel, &wheel->slots[level][index], node);
+}
+
+static void place_all(timer_wheel_t* wheel, timer_wheel_node_t* node) {
+  while (node) {
+    timer_wheel_node_t* next = node->next;
+    node->prev = node->next = NULL;
+    node->slot = NULL;
+    place(wheel, node);
+    node = next;
+  }
+}
+
+// Finds the first non-empty slot on |level|, in expiry order. Returns false
+// if the level is empty. Otherwise stores the slot index in |index| and the
+// time at which the slot must be processed in |time_ms|: the exact expiry
+// for level 0, the cascade boundary for the upper levels.
+static bool first_slot(const timer_wheel_t* wheel, int level, size_t* index,
+                       period_ms_t* time_ms) {
+  uint64_t bitmap = wheel->bitmap[level];
+  if (bitmap == 0) return false;
+
+  int shift = WHEEL_BITS * level;
+  period_ms_t cursor = wheel->base >> shift;
+  int current = cursor & WHEEL_MASK;
+  // When |base| sits inside a block, the slot at |current| belongs to the
+  // next rotation because the current block has already been cascaded.
+  bool aligned = (wheel->base & (((period_ms_t)1 << shift) - 1)) == 0;
+
+  uint64_t rotated =
+      current ? (bitmap >> current) | (bitmap << (WHEEL_SIZE - current))
+              : bitmap;
+  int rotation;
+  if (aligned && (rotated & 1ULL))
+    rotation = 0;
+  else if (rotated & ~1ULL)
+    rotation = __builtin_ctzll(rotated & ~1ULL);
+  else
+    rotation = WHEEL_SIZE;
+
+  *index = (current + rotation) & WHEEL_MASK;
+  *time_ms = (cursor + rotation) << shift;
+  return true;
+}
+
+static period_ms_t overflow_min_deadline(const timer_wheel_t* wheel) {
+  period_ms_t min_deadline = UINT64_MAX;
+  for (const timer_wheel_node_t* node = wheel->overflow.head; node;
+       node = node->next)
+    if (node->deadline < min_deadline) min_deadline = node->deadline;
+  return min_deadline;
+}
+
+// Returns the next time at which the wheel has work to do, or false if no
+// node is pending outside the |ready| list.
+static bool next_event(const timer_wheel_t* wheel, period_ms_t* time_ms) {
+  bool found = false;
+  period_ms_t earliest = UINT64_MAX;
+
+  for (int level = 0; level < WHEEL_LEVELS; level++) {
+    size_t index;
+    period_ms_t slot_time;
+    if (first_slot(wheel, level, &index, &slot_time) && slot_time < earliest) {
+      earliest = slot_time;
+      found = true;
+    }
+  }
+
+  if (wheel->overflow.head) {
+    period_ms_t reinsert = overflow_min_deadline(wheel) - (WHEEL_HORIZON_MS - 1);
+    if (reinsert < wheel->base) reinsert = wheel->base;
+    if (reinsert < earliest) earliest = reinsert;
+    found = true;
+  }
+
+  *time_ms = earliest;
+  return found;
+}
+
+// Processes the single millisecond |time_ms|: cascades the upper level slots
+// that start at this boundary and moves the expiring level 0 slot to |ready|.
+static void process(timer_wheel_t* wheel, period_ms_t time_ms) {
+  wheel->base = time_ms;
+
+  for (int level = WHEEL_LEVELS - 1; level > 0; level--) {
+    int shift = WHEEL_BITS * level;
+    if (time_ms & (((period_ms_t)1 << shift) - 1)) continue;
+    size_t index = (time_ms >> shift) & WHEEL_MASK;
+    if (wheel->bitmap[level] & (1ULL << index))
+      place_all(wheel, slot_take_all(wheel, &wheel->slots[level][index]));
+  }
+
+  if (wheel->overflow.head &&
+      overflow_min_deadline(wheel) - time_ms < WHEEL_HORIZON_MS)
+    place_all(wheel, slot_take_all(wheel, &wheel->overflow));
+
+  timer_wheel_slot_t* slot = &wheel->slots[0][time_ms & WHEEL_MASK];
+  timer_wheel_node_t* node = slot_take_all(wheel, slot);
+  while (node) {
+    timer_wheel_node_t* next = node->next;
+    slot_append(wheel, &wheel->ready, node);
+    node = next;
+  }
+
+  wheel->base = time_ms + 1;
+}
+
+static void advance(timer_wheel_t* wheel, period_ms_t now_ms) {
+  period_ms_t time_ms;
+  while (next_event(wheel, &time_ms) && time_ms <= now_ms)
+    process(wheel, time_ms);
+
+  if (wheel->base <= now_ms) wheel->base = now_ms + 1;
+}
+
+timer_wheel_t* timer_wheel_new(period_ms_t now_ms) {
+  timer_wheel_t* wheel =
+      static_cast<timer_wheel_t*>(osi_calloc(sizeof(timer_wheel_t)));
+
+  wheel->base = now_ms;
+  for (int level = 0; level < WHEEL_LEVELS; level++) {
+    for (int index = 0; index < WHEEL_SIZE; index++) {
+      wheel->slots[level][index].level = level;
+      wheel->slots[level][index].index = index;
+    }
+  }
+  wheel->ready.level = WHEEL_LEVEL_NONE;
+  wheel->overflow.level = WHEEL_LEVEL_NONE;
+
+  return wheel;
+}
+
+void timer_wheel_free(timer_wheel_t* wheel) {
+  if (!wheel) return;
+
+  // Make sure no node keeps pointing into the freed slots.
+  timer_wheel_node_t* lists[WHEEL_LEVELS * WHEEL_SIZE + 2];
+  size_t count = 0;
+  lists[count++] = wheel->ready.head;
+  lists[count++] = wheel->overflow.head;
+  for (int level = 0; level < WHEEL_LEVELS; level++)
+    for (int index = 0; index < WHEEL_SIZE; index++)
+      lists[count++] = wheel->slots[level][index].head;
+
+  for (size_t i = 0; i < count; i++) {
+    timer_wheel_node_t* node = lists[i];
+    while (node) {
+      timer_wheel_node_t* next = node->next;
+      node->prev = node->next = NULL;
+      node->slot = NULL;
+      node = next;
+    }
+  }
+
+  osi_free(wheel);
+}
+
+void timer_wheel_insert(timer_wheel_t* wheel, timer_wheel_node_t* node,
+                        period_ms_t deadline_ms, void* context) {
+  CHECK(wheel != NULL);
+  CHECK(node != NULL);
+  CHECK(node->slot == NULL);
+
+  node->deadline = deadline_ms;
+  node->context = context;
+  place(wheel, node);
+  wheel->size++;
+}
+
+void timer_wheel_remove(timer_wheel_t* wheel, timer_wheel_node_t* node) {
+  CHECK(wheel != NULL);
+  CHECK(node != NULL);
+
+  if (node->slot == NULL) return;
+  slot_unlink(wheel, node);
+  wheel->size--;
+}
+
+bool timer_wheel_is_pending(const timer_wheel_node_t* node) {
+  CHECK(node != NULL);
+  return node->slot != NULL;
+}
+
+size_t timer_wheel_size(const timer_wheel_t* wheel) {
+  CHECK(wheel != NULL);
+  return wheel->size;
+}
+
+bool timer_wheel_next_deadline(timer_wheel_t* wheel,
+                               period_ms_t* deadline_ms) {
+  CHECK(wheel != NULL);
+  CHECK(deadline_ms != NULL);
+
+  if (wheel->ready.head) {
+    *deadline_ms = wheel->ready.head->deadline;
+    return true;
+  }
+
+  bool found = false;
+  period_ms_t earliest = UINT64_MAX;
+
+  for (int level = 0; level < WHEEL_LEVELS; level++) {
+    size_t index;
+    period_ms_t slot_time;
+    if (!first_slot(wheel, level, &index, &slot_time)) continue;
+    found = true;
+
+    // Level 0 slots hold a single deadline; upper level slots span a range
+    // and are always earlier than any later slot on the same level.
+    if (level == 0) {
+      if (slot_time < earliest) earliest = slot_time;
+      continue;
+    }
+    for (const timer_wheel_node_t* node = wheel->slots[level][index].head;
+         node; node = node->next)
+      if (node->deadline < earliest) earliest = node->deadline;
+  }
+
+  if (wheel->overflow.head) {
+    period_ms_t overflow_min = overflow_min_deadline(wheel);
+    if (overflow_min < earliest) earliest = overflow_min;
+    found = true;
+  }
+
+  if (found) *deadline_ms = earliest;
+  return found;
+}
+
+void* timer_wheel_pop_expired(timer_wheel_t* wheel, period_ms_t now_ms) {
+  CHECK(wheel != NULL);
+
+  if (!wheel->ready.head) advance(wheel, now_ms);
+
+  timer_wheel_node_t* node = wheel->ready.head;
+  if (!node) return NULL;
+
+  slot_unlink(wheel, node);
+  wheel->size--;
+  return node->context;
+}
+
+void timer_wheel_foreach(const timer_wheel_t* wheel,
+                         timer_wheel_iter_cb callback, void* user_data) {
+  CHECK(wheel != NULL);
+  CHECK(callback != NULL);
+
+  for (const timer_wheel_node_t* node = wheel->ready.head; node;
+       node = node->next)
+    callback(node->context, user_data);
+
+  for (int level = 0; level < WHEEL_LEVELS; level++) {
+    for (int index = 0; index < WHEEL_SIZE; index++) {
+      if (!(wheel->bitmap[level] & (1ULL << index))) continue;
+      for (const timer_wheel_node_t* node = wheel->slots[level][index].head;
+           node; node = node->next)
+        callback(node->context, user_data);
+    }
+  }
+
+  for (const timer_wheel_node_t* node = wheel->overflow.head; node;
+       node = node->next)
+    callback(node->context, user_data);
+}
@@ -0,0 +1,309 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_osi_trace_ring"
+
+#include "osi/include/trace_ring.h"
+
+#include <base/logging.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+#include <mutex>
+
+#include "osi/include/allocator.h"
+#include "osi/include/osi.h"
+#include "osi/include/time.h"
+
+// Longest conversion specification the formatter rebuilds, e.g. "%-+#012.6llx"
+#define TRACE_RING_SPEC_SIZE 32
+
+// Longest line written by |trace_ring_debug_dump|.
+#define TRACE_RING_LINE_SIZE 512
+
+static const char level_names[] = {'?', 'E', 'W', 'I', 'D', 'V'};
+
+static std::atomic<bool> ring_enabled(false);
+static std::mutex ring_lock;
+static trace_ring_record_t ring[TRACE_RING_SIZE];
+static uint64_t ring_head;  // Number of records ever committed
+
+void trace_ring_init(bool enabled) {
+  std::lock_guard<std::mutex> lock(ring_lock);
+  ring_head = 0;
+  ring_enabled = enabled;
+}
+
+bool trace_ring_is_enabled(void) {
+  return ring_enabled.load(std::memory_order_relaxed);
+}
+
+void trace_ring_commit(trace_ring_record_t* record) {
+  record->timestamp_us = time_get_os_boottime_us();
+
+  // Only copy the used part of the string area
+  size_t size = offsetof(trace_ring_record_t, strings) + record->strings_used;
+
+  std::lock_guard<std::mutex> lock(ring_lock);
+  if (!ring_enabled) return;
+  memcpy(&ring[ring_head % TRACE_RING_SIZE], record, size);
+  ring_head++;
+}
+
+// Output cursor of |trace_ring_format|. |used| keeps counting past |size| so
+// the caller can tell the text was truncated.
+typedef struct {
+  char* buffer;
+  size_t size;
+  size_t used;
+} output_t;
+
+static void output_append(output_t* out, const char* text, size_t len) {
+  if (out->used < out->size - 1) {
+    size_t room = out->size - 1 - out->used;
+    memcpy(out->buffer + out->used, text, len < room ? len : room);
+  }
+  out->used += len;
+}
+
+static void output_printf(output_t* out, const char* spec, ...) {
+  char text[TRACE_RING_LINE_SIZE];
+  va_list ap;
+  va_start(ap, spec);
+  int len = vsnprintf(text, sizeof(text), spec, ap);
+  va_end(ap);
+  if (len < 0) return;
+  if ((size_t)len >= sizeof(text)) len = sizeof(text) - 1;
+  output_append(out, text, len);
+}
+
+// Returns the string argument at |index|, or NULL if it isn't one.
+static const char* string_arg(const trace_ring_record_t* record,
+                              uint8_t index) {
+  if (record->kinds[index] != TRACE_RING_ARG_STRING) return NULL;
+  if (record->args[index].value >= record->strings_used) return "";
+  return record->strings + record->args[index].value;
+}
+
+static bool address_arg(const trace_ring_record_t* record, uint8_t index,
+                        char* text, size_t size) {
+  if (record->kinds[index] != TRACE_RING_ARG_ADDRESS) return false;
+  size_t offset = record->args[index].value;
+  if (offset + TRACE_RING_ADDRESS_LEN > record->strings_used) {
+    snprintf(text, size, "<address>");
+    return true;
+  }
+  const uint8_t* b = (const uint8_t*)(record->strings + offset);
+  snprintf(text, size, "%02x:%02x:%02x:%02x:%02x:%02x", b[0], b[1], b[2], b[3],
+           b[4], b[5]);
+  return true;
+}
+
+static bool is_integer_kind(uint8_t kind) {
+  return kind == TRACE_RING_ARG_INT32 || kind == TRACE_RING_ARG_INT64 ||
+         kind == TRACE_RING_ARG_POINTER;
+}
+
+size_t trace_ring_format(const trace_ring_record_t* record, char* buffer,
+                         size_t size) {
+  CHECK(size > 0);
+
+  output_t out = {buffer, size, 0};
+  uint8_t next_arg = 0;
+  const char* p = record->format;
+  while (*p) {
+    if (*p != '%') {
+      const char* start = p;
+      while (*p && *p != '%') p++;
+      output_append(&out, start, p - start);
+      continue;
+    }
+    if (p[1] == '%') {
+      output_append(&out, "%", 1);
+      p += 2;
+      continue;
+    }
+
+    // Rebuild the specification with the length modifiers the stored values
+    // need; '*' width and precision are replaced by their values.
+    char spec[TRACE_RING_SPEC_SIZE];
+    size_t n = 0;
+    const char* start = p++;
+    spec[n++] = '%';
+    bool truncated = false;
+    while (*p && strchr("-+ #0'", *p)) {
+      if (n < sizeof(spec) - 8) spec[n++] = *p;
+      p++;
+    }
+    for (int part = 0; part < 2; part++) {
+      if (part == 1) {
+        if (*p != '.') break;
+        if (n < sizeof(spec) - 8) spec[n++] = *p;
+        p++;
+      }
+      if (*p == '*') {
+        p++;
+        if (next_arg >= record->arg_count ||
+            !is_integer_kind(record->kinds[next_arg])) {
+          truncated = true;
+          break;
+        }
+        int value = (int)(int32_t)record->args[next_arg++].value;
+        size_t room = sizeof(spec) - 8 - n;
+        int len = snprintf(spec + n, room, "%d", value);
+        if (len > 0 && room > 1)
+          n += (size_t)len < room ? (size_t)len : room - 1;
+      } else {
+        while (*p >= '0' && *p <= '9') {
+          if (n < sizeof(spec) - 8) spec[n++] = *p;
+          p++;
+        }
+      }
+    }
+    int shorten = 0;  // 1 for 'h', 2 for "hh"
+    while (*p && strchr("hlLqjzt", *p)) {
+      if (*p == 'h') shorten++;
+      p++;
+    }
+    char conversion = *p;
+    if (conversion) p++;
+
+    if (truncated || conversion == '\0' || next_arg >= record->arg_count) {
+      // Missing argument or malformed specification: show it as written
+      output_append(&out, start, p - start);
+      continue;
+    }
+
+    uint8_t index = next_arg++;
+    uint8_t kind = record->kinds[index];
+    uint64_t raw = record->args[index].value;
+    switch (conversion) {
+      case 'd':
+      case 'i': {
+        if (!is_integer_kind(kind)) break;
+        int64_t value = kind == TRACE_RING_ARG_INT32 ? (int32_t)raw
+                                                     : (int64_t)raw;
+        if (shorten == 1) value = (short)value;
+        if (shorten >= 2) value = (signed char)value;
+        strcpy(spec + n, "lld");
+        output_printf(&out, spec, (long long)value);
+        continue;
+      }
+      case 'o':
+      case 'u':
+      case 'x':
+      case 'X': {
+        if (!is_integer_kind(kind)) break;
+        uint64_t value = kind == TRACE_RING_ARG_INT32 ? (uint32_t)raw : raw;
+        if (shorten == 1) value = (unsigned short)value;
+        if (shorten >= 2) value = (unsigned char)value;
+        spec[n++] = 'l';
+        spec[n++] = 'l';
+        spec[n++] = conversion;
+        spec[n] = '\0';
+        output_printf(&out, spec, (unsigned long long)value);
+        continue;
+      }
+      case 'c':
+        if (!is_integer_kind(kind)) break;
+        spec[n++] = 'c';
+        spec[n] = '\0';
+        output_printf(&out, spec, (int)raw);
+        continue;
+      case 'f':
+      case 'F':
+      case 'e':
+      case 'E':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A': {
+        double value;
+        if (kind == TRACE_RING_ARG_DOUBLE)
+          value = record->args[index].real;
+        else if (is_integer_kind(kind))
+          value = (double)(int64_t)raw;
+        else
+          break;
+        spec[n++] = conversion;
+        spec[n] = '\0';
+        output_printf(&out, spec, value);
+        continue;
+      }
+      case 's': {
+        char address[sizeof("xx:xx:xx:xx:xx:xx")];
+        const char* text = string_arg(record, index);
+        if (!text && address_arg(record, index, address, sizeof(address)))
+          text = address;
+        if (!text) break;
+        spec[n++] = 's';
+        spec[n] = '\0';
+        output_printf(&out, spec, text);
+        continue;
+      }
+      case 'p':
+        if (!is_integer_kind(kind)) break;
+        output_printf(&out, "%p", (void*)(uintptr_t)raw);
+        continue;
+      default:
+        break;
+    }
+
+    // The argument doesn't fit the conversion
+    output_append(&out, "<?>", 3);
+  }
+
+  size_t len = out.used < size - 1 ? out.used : size - 1;
+  buffer[len] = '\0';
+  return len;
+}
+
+void trace_ring_debug_dump(int fd) {
+  if (!trace_ring_is_enabled()) return;
+
+  // Copy the records out so formatting doesn't hold up the writers
+  trace_ring_record_t* records = (trace_ring_record_t*)osi_malloc(
+      sizeof(trace_ring_record_t) * TRACE_RING_SIZE);
+  uint64_t head;
+  size_t count;
+  {
+    std::lock_guard<std::mutex> lock(ring_lock);
+    head = ring_head;
+    count = head < TRACE_RING_SIZE ? head : TRACE_RING_SIZE;
+    for (size_t i = 0; i < count; i++)
+      records[i] = ring[(head - count + i) % TRACE_RING_SIZE];
+  }
+
+  dprintf(fd, "\nTrace Ring:\n");
+  dprintf(fd, "  Records: %" PRIu64 "  shown: %zu\n", head, count);
+  char line[TRACE_RING_LINE_SIZE];
+  for (size_t i = 0; i < count; i++) {
+    const trace_ring_record_t* record = &records[i];
+    trace_ring_format(record, line, sizeof(line));
+    char level = record->level < sizeof(level_names)
+                     ? level_names[record->level]
+                     : level_names[0];
+    dprintf(fd, "  %" PRIu64 ".%06" PRIu64 " %c %s: %s\n",
+            record->timestamp_us / 1000000, record->timestamp_us % 1000000,
+            level, record->tag ? record->tag : "", line);
+  }
+  osi_free(records);
+}
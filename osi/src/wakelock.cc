@@ -30,8 +30,12 @@
 #include <time.h>
 #include <unistd.h>
 
+#include <chrono>
+#include <condition_variable>
+#include <map>
 #include <mutex>
 #include <string>
+#include <thread>
 
 #include "base/logging.h"
 #include "osi/include/alarm.h"
@@ -78,10 +82,34 @@ typedef struct {
 
 static wakelock_stats_t wakelock_stats;
 
+// Wakelock references held on behalf of one requester
+typedef struct {
+  size_t refs;
+  size_t acquired_count;
+  size_t coalesced_count;  // acquired while the kernel wakelock was held
+  period_ms_t last_acquired_timestamp_ms;
+  period_ms_t total_acquired_interval_ms;
+} wakelock_requester_stats_t;
+
+static std::map<std::string, wakelock_requester_stats_t> requester_stats;
+static size_t releases_absorbed;  // delayed releases a new reference undid
+
 // This mutex ensures that the functions that update and dump the statistics
 // are executed serially.
 static std::mutex stats_mutex;
 
+// References of all requesters share the kernel wakelock. Once the last one
+// is released, the kernel wakelock lingers until |release_deadline_ms| so
+// that work following right after does not take it again.
+// |ref_mutex| is taken before |stats_mutex|.
+static std::mutex ref_mutex;
+static std::condition_variable release_cv;
+static std::thread* release_thread = NULL;
+static bool release_thread_exit = false;
+static size_t ref_count = 0;
+static bool kernel_lock_held = false;
+static period_ms_t release_deadline_ms = 0;  // 0 if no release is pending
+
 static bt_status_t wakelock_acquire_callout(void);
 static bt_status_t wakelock_acquire_native(void);
 static bt_status_t wakelock_release_callout(void);
@@ -91,6 +119,9 @@ static void wakelock_initialize_native(void);
 static void reset_wakelock_stats(void);
 static void update_wakelock_acquired_stats(bt_status_t acquired_status);
 static void update_wakelock_released_stats(bt_status_t released_status);
+static void update_requester_stats(const char* requester, bool acquired,
+                                   bool coalesced);
+static period_ms_t now(void);
 
 void wakelock_set_os_callouts(bt_os_callouts_t* callouts) {
   wakelock_os_callouts = callouts;
@@ -99,9 +130,8 @@ void wakelock_set_os_callouts(bt_os_callouts_t* callouts) {
            (is_native) ? "native" : "non-native");
 }
 
-bool wakelock_acquire(void) {
-  pthread_once(&initialized, wakelock_initialize);
-
+// Takes the kernel wakelock. Must be called with |ref_mutex| held.
+static bt_status_t kernel_lock_acquire(void) {
   bt_status_t status = BT_STATUS_FAIL;
 
   if (is_native)
@@ -113,8 +143,68 @@ bool wakelock_acquire(void) {
 
   if (status != BT_STATUS_SUCCESS)
     LOG_ERROR(LOG_TAG, "%s unable to acquire wake lock: %d", __func__, status);
+  else
+    kernel_lock_held = true;
 
-  return (status == BT_STATUS_SUCCESS);
+  return status;
+}
+
+// Gives the kernel wakelock back. Must be called with |ref_mutex| held.
+static bt_status_t kernel_lock_release(void) {
+  bt_status_t status = BT_STATUS_FAIL;
+
+  if (is_native)
+    status = wakelock_release_native();
+  else
+    status = wakelock_release_callout();
+
+  update_wakelock_released_stats(status);
+  kernel_lock_held = false;
+
+  return status;
+}
+
+static void release_thread_run(void) {
+  std::unique_lock<std::mutex> lock(ref_mutex);
+  while (!release_thread_exit) {
+    if (release_deadline_ms == 0) {
+      release_cv.wait(lock);
+      continue;
+    }
+
+    const period_ms_t now_ms = now();
+    if (now_ms < release_deadline_ms) {
+      release_cv.wait_for(
+          lock, std::chrono::milliseconds(release_deadline_ms - now_ms));
+      continue;
+    }
+
+    release_deadline_ms = 0;
+    if (ref_count == 0 && kernel_lock_held) kernel_lock_release();
+  }
+}
+
+bool wakelock_acquire(void) { return wakelock_acquire_ref(WAKE_LOCK_ID); }
+
+bool wakelock_acquire_ref(const char* requester) {
+  pthread_once(&initialized, wakelock_initialize);
+
+  std::lock_guard<std::mutex> lock(ref_mutex);
+
+  if (release_deadline_ms != 0) {
+    // The kernel wakelock is still held, keep it
+    release_deadline_ms = 0;
+    std::lock_guard<std::mutex> stats_lock(stats_mutex);
+    releases_absorbed++;
+  }
+
+  const bool coalesced = kernel_lock_held;
+  if (!kernel_lock_held && kernel_lock_acquire() != BT_STATUS_SUCCESS)
+    return false;
+
+  ref_count++;
+  update_requester_stats(requester, true, coalesced);
+  return true;
 }
 
 static bt_status_t wakelock_acquire_callout(void) {
@@ -147,19 +237,33 @@ static bt_status_t wakelock_acquire_native(void) {
   return BT_STATUS_SUCCESS;
 }
 
-bool wakelock_release(void) {
+bool wakelock_release(void) { return wakelock_release_ref(WAKE_LOCK_ID, 0); }
+
+bool wakelock_release_ref(const char* requester, uint64_t linger_ms) {
   pthread_once(&initialized, wakelock_initialize);
 
-  bt_status_t status = BT_STATUS_FAIL;
+  std::lock_guard<std::mutex> lock(ref_mutex);
 
-  if (is_native)
-    status = wakelock_release_native();
-  else
-    status = wakelock_release_callout();
+  if (ref_count == 0) {
+    LOG_ERROR(LOG_TAG, "%s %s released a wake lock it did not hold", __func__,
+              requester);
+    return false;
+  }
 
-  update_wakelock_released_stats(status);
+  ref_count--;
+  update_requester_stats(requester, false, false);
+  if (ref_count > 0 || !kernel_lock_held) return true;
 
-  return (status == BT_STATUS_SUCCESS);
+  if (linger_ms == 0)
+    return (kernel_lock_release() == BT_STATUS_SUCCESS);
+
+  release_deadline_ms = now() + linger_ms;
+  if (release_thread == NULL) {
+    release_thread_exit = false;
+    release_thread = new std::thread(release_thread_run);
+  }
+  release_cv.notify_one();
+  return true;
 }
 
 static bt_status_t wakelock_release_callout(void) {
@@ -215,10 +319,33 @@ static void wakelock_initialize_native(void) {
 }
 
 void wakelock_cleanup(void) {
-  if(wakelock_stats.is_acquired) {
-    LOG_ERROR(LOG_TAG, "%s releasing wake lock as part of cleanup", __func__);
-    wakelock_release();
+  if (release_thread != NULL) {
+    {
+      std::lock_guard<std::mutex> lock(ref_mutex);
+      release_thread_exit = true;
+    }
+    release_cv.notify_one();
+    release_thread->join();
+    delete release_thread;
+    release_thread = NULL;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(ref_mutex);
+    release_deadline_ms = 0;
+    ref_count = 0;
+    if (kernel_lock_held) {
+      LOG_ERROR(LOG_TAG, "%s releasing wake lock as part of cleanup",
+                __func__);
+      kernel_lock_release();
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    requester_stats.clear();
+    releases_absorbed = 0;
   }
+
   wake_lock_path.clear();
   wake_unlock_path.clear();
   initialized = PTHREAD_ONCE_INIT;
@@ -332,6 +459,33 @@ static void update_wakelock_released_stats(bt_status_t released_status) {
       system_bt_osi::WAKE_EVENT_RELEASED, "", "", now_ms);
 }
 
+//
+// Update the statistics of the references |requester| holds.
+//
+// This function should be called every time |requester| acquired or released
+// a reference. |coalesced| tells that the kernel wakelock was held already.
+// This function is thread-safe.
+//
+static void update_requester_stats(const char* requester, bool acquired,
+                                   bool coalesced) {
+  std::lock_guard<std::mutex> lock(stats_mutex);
+
+  const period_ms_t now_ms = now();
+  wakelock_requester_stats_t& stats = requester_stats[requester];
+
+  if (acquired) {
+    if (stats.refs++ == 0) stats.last_acquired_timestamp_ms = now_ms;
+    stats.acquired_count++;
+    if (coalesced) stats.coalesced_count++;
+    return;
+  }
+
+  if (stats.refs == 0) return;
+  if (--stats.refs == 0)
+    stats.total_acquired_interval_ms +=
+        now_ms - stats.last_acquired_timestamp_ms;
+}
+
 void wakelock_debug_dump(int fd) {
   std::lock_guard<std::mutex> lock(stats_mutex);
 
@@ -376,4 +530,16 @@ void wakelock_debug_dump(int fd) {
   dprintf(
       fd, "  Total run time (ms)            : %llu\n",
       (unsigned long long)(now_ms - wakelock_stats.last_reset_timestamp_ms));
+  dprintf(fd, "  Delayed releases absorbed      : %zu\n", releases_absorbed);
+
+  for (const auto& entry : requester_stats) {
+    const wakelock_requester_stats_t& stats = entry.second;
+    period_ms_t held_ms = stats.total_acquired_interval_ms;
+    if (stats.refs > 0) held_ms += now_ms - stats.last_acquired_timestamp_ms;
+    dprintf(fd,
+            "  Requester %-20s: refs %zu acquired %zu coalesced %zu "
+            "held %llu ms\n",
+            entry.first.c_str(), stats.refs, stats.acquired_count,
+            stats.coalesced_count, (unsigned long long)held_ms);
+  }
 }
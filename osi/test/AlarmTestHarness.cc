@@ -42,6 +42,8 @@ void AlarmTestHarness::SetUp() {
   AllocationTestHarness::SetUp();
 
   TIMER_INTERVAL_FOR_WAKELOCK_IN_MS = 500;
+  // The tests check the wakelock right after the alarms went
+  TIMER_WAKELOCK_LINGER_MS = 0;
 
   wakelock_set_os_callouts(&bt_wakelock_callouts);
 }
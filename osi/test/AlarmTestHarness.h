@@ -21,6 +21,7 @@
 #include "AllocationTestHarness.h"
 
 extern int64_t TIMER_INTERVAL_FOR_WAKELOCK_IN_MS;
+extern uint64_t TIMER_WAKELOCK_LINGER_MS;
 
 class AlarmTestHarness : public AllocationTestHarness {
  protected:
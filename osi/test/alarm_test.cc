@@ -377,3 +377,98 @@ TEST_F(AlarmTest, test_delete_during_callback) {
   }
   alarm_cleanup();
 }
+
+class AlarmTimingWheelTest : public AlarmTest {
+ protected:
+  virtual void SetUp() {
+    alarm_set_timing_wheel(true);
+    AlarmTest::SetUp();
+  }
+
+  virtual void TearDown() {
+    AlarmTest::TearDown();
+    alarm_set_timing_wheel(false);
+  }
+};
+
+TEST_F(AlarmTimingWheelTest, test_set_short_cancel) {
+  alarm_t* alarm[2] = {alarm_new("alarm_test.test_wheel_set_short_cancel_0"),
+                       alarm_new("alarm_test.test_wheel_set_short_cancel_1")};
+
+  alarm_set(alarm[0], 10, cb, NULL);
+  alarm_set(alarm[1], 20, cb, NULL);
+  EXPECT_TRUE(alarm_is_scheduled(alarm[1]));
+  alarm_cancel(alarm[1]);
+  EXPECT_FALSE(alarm_is_scheduled(alarm[1]));
+
+  semaphore_wait(semaphore);
+  EXPECT_EQ(cb_counter, 1);
+  EXPECT_FALSE(alarm_is_scheduled(alarm[0]));
+
+  msleep(20 + EPSILON_MS);
+  EXPECT_EQ(cb_counter, 1);
+  EXPECT_FALSE(WakeLockHeld());
+
+  alarm_free(alarm[0]);
+  alarm_free(alarm[1]);
+}
+
+TEST_F(AlarmTimingWheelTest, test_set_short_periodic) {
+  alarm_t* alarm = alarm_new_periodic("alarm_test.test_wheel_set_periodic");
+
+  alarm_set(alarm, 10, cb, NULL);
+
+  for (int i = 1; i <= 10; i++) {
+    semaphore_wait(semaphore);
+    EXPECT_GE(cb_counter, i);
+  }
+  alarm_cancel(alarm);
+  EXPECT_FALSE(WakeLockHeld());
+
+  alarm_free(alarm);
+}
+
+TEST_F(AlarmTimingWheelTest, test_callback_ordering) {
+  alarm_t* alarms[100];
+
+  for (int i = 0; i < 100; i++) {
+    const std::string alarm_name =
+        "alarm_test.test_wheel_callback_ordering[" + std::to_string(i) + "]";
+    alarms[i] = alarm_new(alarm_name.c_str());
+  }
+
+  // Mix deadlines across wheel levels; same-deadline alarms fire in the
+  // order they were set.
+  for (int i = 0; i < 100; i++) {
+    alarm_set(alarms[i], 50 + (i / 10) * 30, ordered_cb, INT_TO_PTR(i));
+  }
+
+  for (int i = 1; i <= 100; i++) {
+    semaphore_wait(semaphore);
+    EXPECT_GE(cb_counter, i);
+  }
+  EXPECT_EQ(cb_counter, 100);
+  EXPECT_EQ(cb_misordered_counter, 0);
+
+  for (int i = 0; i < 100; i++) alarm_free(alarms[i]);
+
+  EXPECT_FALSE(WakeLockHeld());
+}
+
+TEST_F(AlarmTest, test_set_with_slack) {
+  alarm_t* alarm[2] = {alarm_new("alarm_test.test_set_with_slack_0"),
+                       alarm_new("alarm_test.test_set_with_slack_1")};
+
+  // The second alarm's window covers the first alarm's deadline, so both
+  // should be dispatched from the same wakeup.
+  alarm_set(alarm[0], 50, cb, NULL);
+  alarm_set_with_slack(alarm[1], 40, 100, cb, NULL);
+
+  semaphore_wait(semaphore);
+  semaphore_wait(semaphore);
+  EXPECT_EQ(cb_counter, 2);
+  EXPECT_FALSE(WakeLockHeld());
+
+  alarm_free(alarm[0]);
+  alarm_free(alarm[1]);
+}
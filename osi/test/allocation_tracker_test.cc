@@ -62,3 +62,40 @@ TEST(AllocationTrackerTest, test_canaries_on) {
 
   free(dummy_allocation);
 }
+
+TEST(AllocationTrackerTest, test_sampling_off_by_default) {
+  allocation_tracker_set_sampling_rate(0);
+  allocation_tracker_sample_alloc(allocator_id, 16, NULL);
+
+  size_t count, bytes;
+  allocation_tracker_get_sampled(allocator_id, &count, &bytes);
+  EXPECT_EQ(0U, count);
+  EXPECT_EQ(0U, bytes);
+}
+
+TEST(AllocationTrackerTest, test_sampling_rate) {
+  allocation_tracker_uninit();
+  allocation_tracker_set_sampling_rate(4);
+
+  for (int i = 0; i < 40; i++)
+    allocation_tracker_sample_alloc(allocator_id, 10, (void*)0x1000);
+
+  size_t count, bytes;
+  allocation_tracker_get_sampled(allocator_id, &count, &bytes);
+  EXPECT_EQ(10U, count);
+  EXPECT_EQ(100U, bytes);
+
+  // Changing the rate starts over.
+  allocation_tracker_set_sampling_rate(1);
+  allocation_tracker_get_sampled(allocator_id, &count, &bytes);
+  EXPECT_EQ(0U, count);
+
+  allocation_tracker_sample_alloc(allocator_id, 7, (void*)0x2000);
+  allocation_tracker_sample_alloc(allocator_id + 1, 9, (void*)0x2000);
+  allocation_tracker_get_sampled(allocator_id, &count, &bytes);
+  EXPECT_EQ(1U, count);
+  EXPECT_EQ(7U, bytes);
+
+  allocation_tracker_set_sampling_rate(0);
+}
+
@@ -21,7 +21,9 @@
 
 #include "AllocationTestHarness.h"
 
+#include "osi/include/allocation_tracker.h"
 #include "osi/include/allocator.h"
+#include "osi/include/allocator_pool.h"
 
 class AllocatorTest : public AllocationTestHarness {};
 
@@ -50,3 +52,74 @@ TEST_F(AllocatorTest, test_osi_strndup) {
   EXPECT_EQ(0, strcmp(str, copy_str));
   osi_free(copy_str);
 }
+
+TEST_F(AllocatorTest, test_allocator_pool) {
+  const allocator_pool_class_t classes[] = {{64, 2}, {256, 1}};
+  ASSERT_TRUE(allocator_pool_init(classes, 2, 32));
+  EXPECT_TRUE(allocator_pool_is_enabled());
+  EXPECT_FALSE(allocator_pool_init(classes, 2, 32));
+
+  // Below the minimum size and above the largest class are not pooled.
+  void* small = allocator_pool_alloc(16);
+  EXPECT_EQ(nullptr, small);
+  void* large = allocator_pool_alloc(512);
+  EXPECT_EQ(nullptr, large);
+
+  void* a = allocator_pool_alloc(64);
+  void* b = allocator_pool_alloc(40);
+  void* c = allocator_pool_alloc(48);
+  ASSERT_NE(nullptr, a);
+  ASSERT_NE(nullptr, b);
+  EXPECT_EQ(nullptr, c);  // class exhausted
+
+  void* d = allocator_pool_alloc(200);
+  ASSERT_NE(nullptr, d);
+
+  allocator_pool_stats_t stats[ALLOCATOR_POOL_MAX_CLASSES];
+  ASSERT_EQ(2U, allocator_pool_get_stats(stats, ALLOCATOR_POOL_MAX_CLASSES));
+  EXPECT_EQ(64U, stats[0].block_size);
+  EXPECT_EQ(2U, stats[0].in_use);
+  EXPECT_EQ(2U, stats[0].hits);
+  EXPECT_EQ(1U, stats[0].misses);
+  EXPECT_EQ(1U, stats[1].in_use);
+
+  int local = 0;
+  EXPECT_FALSE(allocator_pool_free(&local));
+  EXPECT_TRUE(allocator_pool_free(a));
+  EXPECT_TRUE(allocator_pool_free(b));
+  EXPECT_TRUE(allocator_pool_free(d));
+
+  ASSERT_EQ(2U, allocator_pool_get_stats(stats, ALLOCATOR_POOL_MAX_CLASSES));
+  EXPECT_EQ(0U, stats[0].in_use);
+  EXPECT_EQ(2U, stats[0].high_water);
+  EXPECT_EQ(0U, stats[1].in_use);
+
+  // osi_malloc and osi_free route through the pool once it is enabled.
+  void* pooled = osi_malloc(40);
+  ASSERT_EQ(1U, allocator_pool_get_stats(stats, 1));
+  EXPECT_EQ(1U, stats[0].in_use);
+  osi_free(pooled);
+  void* zeroed = osi_calloc(40);
+  for (size_t i = 0; i < 40; i++)
+    EXPECT_EQ(0, static_cast<uint8_t*>(zeroed)[i]);
+  osi_free(zeroed);
+  ASSERT_EQ(1U, allocator_pool_get_stats(stats, 1));
+  EXPECT_EQ(0U, stats[0].in_use);
+}
+
+TEST_F(AllocatorTest, test_osi_allocator_get_sampled) {
+  size_t count, bytes;
+  allocation_tracker_set_sampling_rate(1);
+  osi_allocator_get_sampled(&count, &bytes);
+  EXPECT_EQ(0U, count);
+
+  void* a = osi_malloc(24);
+  void* b = osi_calloc(8);
+  osi_allocator_get_sampled(&count, &bytes);
+  EXPECT_EQ(2U, count);
+  EXPECT_EQ(32U, bytes);
+
+  osi_free(a);
+  osi_free(b);
+  allocation_tracker_set_sampling_rate(0);
+}
@@ -0,0 +1,95 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "osi/include/chunked_record_buffer.h"
+
+using system_bt_osi::ChunkedRecordBuffer;
+
+static std::string contents(const ChunkedRecordBuffer& buffer) {
+  std::string out;
+  buffer.AppendTo(&out);
+  return out;
+}
+
+TEST(ChunkedRecordBufferTest, test_append_concatenates_in_order) {
+  ChunkedRecordBuffer buffer(8, 1024, 100);
+  EXPECT_EQ(0u, buffer.Append("abc"));
+  EXPECT_EQ(0u, buffer.Append("defgh"));
+  // Doesn't fit the first chunk, starts another one
+  EXPECT_EQ(0u, buffer.Append("ij"));
+  EXPECT_EQ(3u, buffer.Size());
+  EXPECT_EQ(10u, buffer.Bytes());
+  EXPECT_EQ("abcdefghij", contents(buffer));
+}
+
+TEST(ChunkedRecordBufferTest, test_drops_oldest_beyond_max_records) {
+  ChunkedRecordBuffer buffer(8, 1024, 3);
+  for (char c = 'a'; c <= 'f'; c++) buffer.Append(std::string(2, c));
+  EXPECT_EQ(3u, buffer.Size());
+  EXPECT_EQ("ddeeff", contents(buffer));
+}
+
+TEST(ChunkedRecordBufferTest, test_drops_oldest_beyond_max_bytes) {
+  ChunkedRecordBuffer buffer(4, 10, 100);
+  buffer.Append("aaaa");
+  buffer.Append("bbbb");
+  EXPECT_EQ(1u, buffer.Append("cccc"));
+  EXPECT_EQ(8u, buffer.Bytes());
+  EXPECT_EQ("bbbbcccc", contents(buffer));
+
+  // Too large for the budget on its own
+  EXPECT_EQ(1u, buffer.Append(std::string(11, 'x')));
+  EXPECT_EQ("bbbbcccc", contents(buffer));
+}
+
+TEST(ChunkedRecordBufferTest, test_record_larger_than_chunk) {
+  ChunkedRecordBuffer buffer(4, 1024, 100);
+  buffer.Append("ab");
+  buffer.Append("0123456789");
+  buffer.Append("cd");
+  EXPECT_EQ("ab0123456789cd", contents(buffer));
+}
+
+TEST(ChunkedRecordBufferTest, test_long_run_stays_bounded) {
+  ChunkedRecordBuffer buffer(64, 256, 1000);
+  std::string expected;
+  for (int i = 0; i < 10000; i++) {
+    std::string record = std::to_string(i) + ";";
+    buffer.Append(record);
+    expected += record;
+  }
+  EXPECT_LE(buffer.Bytes(), 256u);
+  std::string text = contents(buffer);
+  EXPECT_EQ(buffer.Bytes(), text.size());
+  EXPECT_EQ(expected.substr(expected.size() - text.size()), text);
+}
+
+TEST(ChunkedRecordBufferTest, test_clear) {
+  ChunkedRecordBuffer buffer(8, 1024, 100);
+  buffer.Append("abc");
+  buffer.Clear();
+  EXPECT_EQ(0u, buffer.Size());
+  EXPECT_EQ(0u, buffer.Bytes());
+  EXPECT_EQ("", contents(buffer));
+  buffer.Append("de");
+  EXPECT_EQ("de", contents(buffer));
+}
@@ -223,4 +223,173 @@ TEST_F(ConfigTest, checksum_save) {
 
   EXPECT_TRUE(base::PathExists(file_path));
 }
-*/
\ No newline at end of file
+*/
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <string>
+
+#include "AllocationTestHarness.h"
+
+#include "osi/include/config.h"
+
+class ConfigIndexTest : public AllocationTestHarness {};
+
+// Enough sections and keys for the lookups to go through the index.
+static std::unique_ptr<config_t> config_new_large(size_t count) {
+  std::unique_ptr<config_t> config = config_new_empty();
+  for (size_t i = 0; i < count; i++) {
+    for (size_t j = 0; j < count; j++) {
+      config_set_int(config.get(), "section" + std::to_string(i),
+                     "key" + std::to_string(j), i * count + j);
+    }
+  }
+  return config;
+}
+
+TEST_F(ConfigIndexTest, lookups_match_insertion) {
+  std::unique_ptr<config_t> config = config_new_large(40);
+  EXPECT_EQ(40u, config->sections.size());
+  for (int i = 0; i < 40; i++) {
+    for (int j = 0; j < 40; j++) {
+      EXPECT_EQ(i * 40 + j,
+                config_get_int(*config, "section" + std::to_string(i),
+                               "key" + std::to_string(j), -1));
+    }
+  }
+  EXPECT_FALSE(config_has_section(*config, "section40"));
+  EXPECT_FALSE(config_has_key(*config, "section0", "key40"));
+}
+
+TEST_F(ConfigIndexTest, iteration_keeps_insertion_order) {
+  std::unique_ptr<config_t> config = config_new_large(20);
+  int i = 0;
+  for (const section_t& section : config->sections) {
+    EXPECT_EQ("section" + std::to_string(i++), section.name);
+    int j = 0;
+    for (const entry_t& entry : section.entries) {
+      EXPECT_EQ("key" + std::to_string(j++), entry.key);
+    }
+  }
+}
+
+TEST_F(ConfigIndexTest, remove_keeps_index_valid) {
+  std::unique_ptr<config_t> config = config_new_large(20);
+  EXPECT_TRUE(config_remove_section(config.get(), "section5"));
+  EXPECT_TRUE(config_remove_key(config.get(), "section6", "key7"));
+  EXPECT_FALSE(config_has_section(*config, "section5"));
+  EXPECT_FALSE(config_has_key(*config, "section6", "key7"));
+  EXPECT_EQ(128, config_get_int(*config, "section6", "key8", -1));
+  EXPECT_EQ(399, config_get_int(*config, "section19", "key19", -1));
+
+  config_set_int(config.get(), "section5", "key0", 1);
+  EXPECT_EQ(1, config_get_int(*config, "section5", "key0", -1));
+  EXPECT_EQ("section5", config->sections.list().back().name);
+}
+
+TEST_F(ConfigIndexTest, clone_has_own_index) {
+  std::unique_ptr<config_t> config = config_new_large(20);
+  std::unique_ptr<config_t> clone = config_new_clone(*config);
+  config_set_int(clone.get(), "section3", "key4", -1);
+  config_remove_section(config.get(), "section3");
+
+  EXPECT_FALSE(config_has_section(*config, "section3"));
+  EXPECT_EQ(-1, config_get_int(*clone, "section3", "key4", 0));
+  EXPECT_EQ(85, config_get_int(*clone, "section4", "key5", 0));
+}
+
+TEST_F(ConfigIndexTest, take_section) {
+  std::unique_ptr<config_t> config = config_new_large(20);
+  auto it = config->Find("section9");
+  ASSERT_TRUE(it != config->sections.end());
+  section_t section = config->sections.Take(it);
+
+  EXPECT_EQ("section9", section.name);
+  EXPECT_TRUE(section.Has("key19"));
+  EXPECT_FALSE(config_has_section(*config, "section9"));
+  EXPECT_TRUE(config_has_section(*config, "section10"));
+}
+
+static const char PARSE_TEST_FILE[] = "/data/local/tmp/config_parse_test.conf";
+
+class ConfigParseTest : public AllocationTestHarness {
+ protected:
+  std::unique_ptr<config_t> Parse(const std::string& content) {
+    FILE* fp = fopen(PARSE_TEST_FILE, "wb");
+    EXPECT_TRUE(fp != nullptr);
+    if (fp == nullptr) return nullptr;
+    fwrite(content.data(), 1, content.size(), fp);
+    fclose(fp);
+    return config_new(PARSE_TEST_FILE);
+  }
+
+  void TearDown() override {
+    unlink(PARSE_TEST_FILE);
+    AllocationTestHarness::TearDown();
+  }
+};
+
+TEST_F(ConfigParseTest, empty_file) {
+  std::unique_ptr<config_t> config = Parse("");
+  ASSERT_TRUE(config != nullptr);
+  EXPECT_TRUE(config->sections.empty());
+}
+
+TEST_F(ConfigParseTest, sections_and_keys) {
+  std::unique_ptr<config_t> config = Parse(
+      "top = level\n"
+      "# comment = ignored\n"
+      "\n"
+      "  [Adapter]  \n"
+      "Address = 00:11:22:33:44:55\r\n"
+      "Name=  phone  \n"
+      "no separator\n"
+      "[Empty]\n"
+      "[Adapter]\n"
+      "Name = renamed\n"
+      "[broken\n"
+      "Lost = key\n"
+      "[Last]\n"
+      "Key=value");
+  ASSERT_TRUE(config != nullptr);
+
+  EXPECT_EQ("level",
+            *config_get_string(*config, CONFIG_DEFAULT_SECTION, "top", nullptr));
+  EXPECT_EQ("00:11:22:33:44:55",
+            *config_get_string(*config, "Adapter", "Address", nullptr));
+  EXPECT_EQ("renamed", *config_get_string(*config, "Adapter", "Name", nullptr));
+  EXPECT_FALSE(config_has_key(*config, "Adapter", "no separator"));
+  EXPECT_FALSE(config_has_section(*config, "Empty"));
+  EXPECT_FALSE(config_has_key(*config, "Last", "Lost"));
+  EXPECT_EQ("value", *config_get_string(*config, "Last", "Key", nullptr));
+  EXPECT_EQ(3u, config->sections.size());
+}
+
+TEST_F(ConfigParseTest, long_line) {
+  std::string value(5000, 'a');
+  std::unique_ptr<config_t> config = Parse("[Long]\nKey = " + value + "\n");
+  ASSERT_TRUE(config != nullptr);
+  EXPECT_EQ(value, *config_get_string(*config, "Long", "Key", nullptr));
+}
+
+TEST_F(ConfigParseTest, save_and_parse) {
+  std::unique_ptr<config_t> config = config_new_large(20);
+  ASSERT_TRUE(config_save(*config, PARSE_TEST_FILE));
+  std::unique_ptr<config_t> parsed = config_new(PARSE_TEST_FILE);
+  ASSERT_TRUE(parsed != nullptr);
+
+  ASSERT_EQ(config->sections.size(), parsed->sections.size());
+  auto section = parsed->sections.begin();
+  for (const section_t& expected : config->sections) {
+    EXPECT_EQ(expected.name, section->name);
+    ASSERT_EQ(expected.entries.size(), section->entries.size());
+    auto entry = section->entries.begin();
+    for (const entry_t& expected_entry : expected.entries) {
+      EXPECT_EQ(expected_entry.key, entry->key);
+      EXPECT_EQ(expected_entry.value, entry->value);
+      ++entry;
+    }
+    ++section;
+  }
+}
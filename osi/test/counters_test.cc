@@ -0,0 +1,134 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "osi/include/counters.h"
+
+// Registrations outlive every test, so each test uses names of its own
+class CountersTest : public ::testing::Test {
+ protected:
+  void SetUp() override { counters_clear(); }
+};
+
+static std::string dump(void) {
+  FILE* fp = tmpfile();
+  counters_debug_dump(fileno(fp));
+  rewind(fp);
+
+  std::string text;
+  char buffer[256];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+    text.append(buffer, read);
+  fclose(fp);
+  return text;
+}
+
+TEST_F(CountersTest, test_register_returns_same_metric) {
+  counters_metric_t* counter = counters_register_counter("test", "same");
+  ASSERT_NE(nullptr, counter);
+  std::string copy = "same";
+  EXPECT_EQ(counter, counters_register_counter("test", copy.c_str()));
+  EXPECT_EQ(nullptr, counters_register_gauge("test", "same"));
+  EXPECT_NE(counter, counters_register_counter("other", "same"));
+}
+
+TEST_F(CountersTest, test_null_metric_ignored) {
+  counters_increment(NULL);
+  counters_gauge_set(NULL, 5);
+  counters_histogram_record(NULL, 5);
+  EXPECT_EQ(0, counters_get_value(NULL));
+  counters_histogram_t histogram;
+  EXPECT_FALSE(counters_get_histogram(NULL, &histogram));
+}
+
+TEST_F(CountersTest, test_counter_sums_threads) {
+  counters_metric_t* counter = counters_register_counter("test", "threads");
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([counter] {
+      for (int j = 0; j < 10000; j++) counters_increment(counter);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  counters_add(counter, 5);
+  EXPECT_EQ(40005, counters_get_value(counter));
+
+  counters_clear();
+  EXPECT_EQ(0, counters_get_value(counter));
+}
+
+TEST_F(CountersTest, test_gauge) {
+  counters_metric_t* gauge = counters_register_gauge("test", "gauge");
+  counters_gauge_set(gauge, 10);
+  counters_gauge_add(gauge, -15);
+  EXPECT_EQ(-5, counters_get_value(gauge));
+}
+
+TEST_F(CountersTest, test_bucket_bounds) {
+  EXPECT_EQ(0u, counters_bucket_lower_bound(0));
+  EXPECT_EQ(3u, counters_bucket_lower_bound(3));
+  EXPECT_EQ(4u, counters_bucket_lower_bound(4));
+  EXPECT_EQ(7u, counters_bucket_lower_bound(7));
+  EXPECT_EQ(8u, counters_bucket_lower_bound(8));
+  EXPECT_EQ(10u, counters_bucket_lower_bound(9));
+  EXPECT_EQ(7ull << 29,
+            counters_bucket_lower_bound(COUNTERS_HISTOGRAM_BUCKETS - 1));
+}
+
+TEST_F(CountersTest, test_histogram_percentiles) {
+  counters_metric_t* histogram =
+      counters_register_histogram("test", "latency", "us");
+  for (uint64_t i = 1; i <= 100; i++) counters_histogram_record(histogram, i);
+
+  counters_histogram_t copy;
+  ASSERT_TRUE(counters_get_histogram(histogram, &copy));
+  EXPECT_EQ(100u, copy.count);
+  EXPECT_EQ(5050u, copy.sum);
+  EXPECT_EQ(100u, copy.max);
+  // 50 lies in [48, 56), 90 in [80, 96); the bounds are at most 25% off
+  EXPECT_EQ(55u, counters_histogram_percentile(&copy, 50));
+  EXPECT_EQ(95u, counters_histogram_percentile(&copy, 90));
+  EXPECT_EQ(100u, counters_histogram_percentile(&copy, 100));
+
+  counters_histogram_record(histogram, UINT64_MAX);
+  ASSERT_TRUE(counters_get_histogram(histogram, &copy));
+  EXPECT_EQ(1u, copy.buckets[COUNTERS_HISTOGRAM_BUCKETS - 1]);
+  EXPECT_EQ(UINT64_MAX, counters_histogram_percentile(&copy, 100));
+}
+
+TEST_F(CountersTest, test_dump) {
+  counters_add(counters_register_counter("dump", "packets"), 3);
+  counters_register_histogram("dump", "empty", "ms");
+  counters_histogram_record(counters_register_histogram("dump", "time", "ms"),
+                            2);
+
+  std::string text = dump();
+  EXPECT_NE(std::string::npos, text.find("Performance Counters:"));
+  EXPECT_NE(std::string::npos, text.find("  dump.packets: 3\n"));
+  EXPECT_NE(std::string::npos, text.find("  dump.empty: no samples\n"));
+  EXPECT_NE(std::string::npos,
+            text.find("  dump.time: count 1 avg 2ms p50 2ms p90 2ms p99 2ms "
+                      "max 2ms\n"));
+}
@@ -0,0 +1,74 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+
+#include <vector>
+
+#include "osi/include/crc16.h"
+
+static const uint8_t check_input[] = {'1', '2', '3', '4', '5',
+                                      '6', '7', '8', '9'};
+
+// CRC-16/ARC check value for "123456789".
+static const uint16_t check_value = 0xbb3d;
+
+static std::vector<crc16_update_fn> all_implementations() {
+  std::vector<crc16_update_fn> impls = {crc16_update_bytewise,
+                                        crc16_update_slice8, crc16_update};
+  if (crc16_get_clmul_impl()) impls.push_back(crc16_get_clmul_impl());
+  return impls;
+}
+
+TEST(Crc16Test, test_check_value) {
+  for (crc16_update_fn impl : all_implementations())
+    EXPECT_EQ(check_value, impl(0, check_input, sizeof(check_input)));
+}
+
+TEST(Crc16Test, test_empty_input_keeps_crc) {
+  for (crc16_update_fn impl : all_implementations())
+    EXPECT_EQ(0x1234, impl(0x1234, NULL, 0));
+}
+
+TEST(Crc16Test, test_incremental_update) {
+  for (crc16_update_fn impl : all_implementations()) {
+    uint16_t crc = impl(0, check_input, 4);
+    EXPECT_EQ(check_value, impl(crc, check_input + 4, 5));
+  }
+}
+
+TEST(Crc16Test, test_implementations_agree) {
+  std::vector<uint8_t> data(1100);
+  srand(42);
+  for (uint8_t& byte : data) byte = rand();
+
+  for (size_t offset = 0; offset < 8; offset++) {
+    for (size_t length = 0; length + offset <= data.size();
+         length += 1 + length / 4) {
+      uint16_t seed = length * 31;
+      uint16_t expected =
+          crc16_update_bytewise(seed, data.data() + offset, length);
+      for (crc16_update_fn impl : all_implementations())
+        EXPECT_EQ(expected, impl(seed, data.data() + offset, length))
+            << "offset " << offset << " length " << length;
+    }
+  }
+}
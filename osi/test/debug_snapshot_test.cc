@@ -0,0 +1,85 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+#include "osi/include/debug_snapshot.h"
+#include "osi/include/semaphore.h"
+#include "osi/include/thread.h"
+
+struct TestSnapshot {
+  bool on_thread = false;
+  int value = 0;
+};
+
+static void wait_semaphore(void* context) {
+  semaphore_wait(static_cast<semaphore_t*>(context));
+}
+
+TEST(DebugSnapshotTest, test_take_on_thread) {
+  thread_t* thread = thread_new("debug_snapshot_test");
+  std::shared_ptr<TestSnapshot> snapshot = debug_snapshot_take<TestSnapshot>(
+      thread, [thread](TestSnapshot* snapshot) {
+        snapshot->on_thread = thread_is_self(thread);
+        snapshot->value = 42;
+      });
+  ASSERT_NE(nullptr, snapshot);
+  EXPECT_TRUE(snapshot->on_thread);
+  EXPECT_EQ(42, snapshot->value);
+  thread_free(thread);
+}
+
+TEST(DebugSnapshotTest, test_take_inline_without_thread) {
+  std::shared_ptr<TestSnapshot> snapshot = debug_snapshot_take<TestSnapshot>(
+      NULL, [](TestSnapshot* snapshot) { snapshot->value = 7; });
+  ASSERT_NE(nullptr, snapshot);
+  EXPECT_EQ(7, snapshot->value);
+}
+
+TEST(DebugSnapshotTest, test_timeout_on_busy_thread) {
+  thread_t* thread = thread_new("debug_snapshot_test");
+  semaphore_t* release = semaphore_new(0);
+  thread_post(thread, wait_semaphore, release);
+
+  std::atomic<bool> filled(false);
+  std::shared_ptr<TestSnapshot> snapshot = debug_snapshot_take<TestSnapshot>(
+      thread,
+      [&filled](TestSnapshot* snapshot) {
+        snapshot->value = 1;
+        filled = true;
+      },
+      50);
+  EXPECT_EQ(nullptr, snapshot);
+  EXPECT_FALSE(filled);
+
+  // The late task still runs, into a snapshot nobody looks at anymore
+  semaphore_post(release);
+  thread_free(thread);
+  EXPECT_TRUE(filled);
+  semaphore_free(release);
+}
+
+TEST(DebugSnapshotTest, test_run_fails_when_not_posted) {
+  bool ran = false;
+  EXPECT_FALSE(debug_snapshot_run(
+      [](const std::function<void()>&) { return false; },
+      [&ran] { ran = true; }, 50));
+  EXPECT_FALSE(ran);
+}
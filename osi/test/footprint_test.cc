@@ -0,0 +1,100 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+
+#include <string>
+
+#include "osi/include/footprint.h"
+
+class FootprintTest : public ::testing::Test {
+ protected:
+  void SetUp() override { footprint_clear(); }
+  void TearDown() override { footprint_clear(); }
+};
+
+static std::string dump(void) {
+  FILE* fp = tmpfile();
+  footprint_debug_dump(fileno(fp));
+  rewind(fp);
+
+  std::string text;
+  char buffer[256];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+    text.append(buffer, read);
+  fclose(fp);
+  return text;
+}
+
+TEST_F(FootprintTest, test_set_and_get) {
+  footprint_set("btm", "inq_db", 1000);
+  footprint_set("btm", "control_block", 200);
+  footprint_set("bta_hh", "devices", 300);
+  EXPECT_EQ(1000u, footprint_get("btm", "inq_db"));
+  EXPECT_EQ(1200u, footprint_get("btm", NULL));
+  EXPECT_EQ(300u, footprint_get("bta_hh", NULL));
+  EXPECT_EQ(0u, footprint_get("bta_ag", NULL));
+
+  // A pool that is freed reports 0 and keeps its place in the dump
+  std::string pool = "inq_db";
+  footprint_set("btm", pool.c_str(), 0);
+  EXPECT_EQ(200u, footprint_get("btm", NULL));
+}
+
+TEST_F(FootprintTest, test_dump_groups_pools_by_module) {
+  EXPECT_NE(std::string::npos, dump().find("None"));
+
+  footprint_set("btm", "inq_db", 1000);
+  footprint_set("bta_hh", "devices", 300);
+  footprint_set("btm", "control_block", 200);
+  std::string text = dump();
+
+  size_t btm = text.find("  btm: 1200 bytes\n");
+  size_t inq_db = text.find("    inq_db: 1000 bytes\n");
+  size_t control_block = text.find("    control_block: 200 bytes\n");
+  size_t bta_hh = text.find("  bta_hh: 300 bytes\n");
+  ASSERT_NE(std::string::npos, btm);
+  ASSERT_NE(std::string::npos, bta_hh);
+  EXPECT_LT(btm, inq_db);
+  EXPECT_LT(inq_db, control_block);
+  EXPECT_LT(control_block, bta_hh);
+  EXPECT_NE(std::string::npos, text.find("  Total: 1500 bytes\n"));
+}
+
+TEST_F(FootprintTest, test_pool_entries_default_to_maximum) {
+  ASSERT_FALSE(footprint_low_memory_mode());
+  EXPECT_EQ(40u, footprint_pool_entries("inq_db", 40, 8));
+}
+
+TEST_F(FootprintTest, test_full_registry_drops_pools) {
+  static const char* const kPools[] = {
+      "p00", "p01", "p02", "p03", "p04", "p05", "p06", "p07", "p08", "p09",
+      "p10", "p11", "p12", "p13", "p14", "p15", "p16", "p17", "p18", "p19",
+      "p20", "p21", "p22", "p23", "p24", "p25", "p26", "p27", "p28", "p29",
+      "p30", "p31", "p32", "p33", "p34", "p35", "p36", "p37", "p38", "p39",
+      "p40", "p41", "p42", "p43", "p44", "p45", "p46", "p47", "p48", "p49",
+      "p50", "p51", "p52", "p53", "p54", "p55", "p56", "p57", "p58", "p59",
+      "p60", "p61", "p62", "p63", "p64"};
+  static_assert(sizeof(kPools) / sizeof(kPools[0]) == FOOTPRINT_MAX + 1,
+                "one pool more than the registry holds");
+  for (const char* pool : kPools) footprint_set("test", pool, 1);
+  EXPECT_EQ((size_t)FOOTPRINT_MAX, footprint_get("test", NULL));
+  EXPECT_EQ(0u, footprint_get("test", "p64"));
+}
@@ -0,0 +1,160 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include <vector>
+
+#include "osi/include/intrusive_list.h"
+
+using system_bt_osi::IntrusiveList;
+using system_bt_osi::IntrusiveListHook;
+
+namespace testing {
+
+struct TestEntry {
+  int value;
+  IntrusiveListHook<TestEntry> hook;
+  IntrusiveListHook<TestEntry> other_hook;
+};
+
+using TestList = IntrusiveList<TestEntry, &TestEntry::hook>;
+
+static std::vector<int> values(const TestList& list) {
+  std::vector<int> result;
+  for (const TestEntry& entry : list) result.push_back(entry.value);
+  return result;
+}
+
+TEST(IntrusiveListTest, test_push_and_iterate) {
+  TestEntry entries[3] = {{1, {}, {}}, {2, {}, {}}, {3, {}, {}}};
+  TestList list;
+  EXPECT_TRUE(list.Empty());
+  EXPECT_EQ(nullptr, list.Front());
+  EXPECT_TRUE(list.begin() == list.end());
+
+  list.PushBack(&entries[1]);
+  list.PushBack(&entries[2]);
+  list.PushFront(&entries[0]);
+  EXPECT_EQ(3u, list.Size());
+  EXPECT_EQ(std::vector<int>({1, 2, 3}), values(list));
+  EXPECT_EQ(&entries[0], list.Front());
+  EXPECT_EQ(&entries[2], list.Back());
+  EXPECT_EQ(&entries[1], TestList::Next(&entries[0]));
+  EXPECT_EQ(nullptr, TestList::Next(&entries[2]));
+  EXPECT_EQ(&entries[1], TestList::Prev(&entries[2]));
+  EXPECT_EQ(nullptr, TestList::Prev(&entries[0]));
+}
+
+TEST(IntrusiveListTest, test_insert_and_remove) {
+  TestEntry entries[4] = {{1, {}, {}}, {2, {}, {}}, {3, {}, {}}, {4, {}, {}}};
+  TestList list;
+  list.PushBack(&entries[1]);
+  list.InsertBefore(&entries[1], &entries[0]);
+  list.InsertAfter(&entries[1], &entries[3]);
+  list.InsertAfter(&entries[1], &entries[2]);
+  EXPECT_EQ(std::vector<int>({1, 2, 3, 4}), values(list));
+
+  EXPECT_TRUE(list.Remove(&entries[2]));
+  EXPECT_FALSE(list.Remove(&entries[2]));
+  EXPECT_FALSE(list.Contains(&entries[2]));
+  EXPECT_EQ(std::vector<int>({1, 2, 4}), values(list));
+
+  EXPECT_TRUE(list.Remove(&entries[3]));
+  EXPECT_EQ(&entries[1], list.Back());
+  EXPECT_EQ(&entries[0], list.PopFront());
+  EXPECT_EQ(&entries[1], list.Front());
+  EXPECT_EQ(1u, list.Size());
+
+  // The only element has no links but is on the list
+  EXPECT_TRUE(list.Contains(&entries[1]));
+  EXPECT_EQ(&entries[1], list.PopFront());
+  EXPECT_FALSE(list.Contains(&entries[1]));
+  EXPECT_EQ(nullptr, list.PopFront());
+  EXPECT_TRUE(list.Empty());
+  EXPECT_EQ(nullptr, list.Back());
+}
+
+TEST(IntrusiveListTest, test_find_and_remove_while_walking) {
+  TestEntry entries[5];
+  TestList list;
+  for (int i = 0; i < 5; i++) {
+    entries[i] = {i, {}, {}};
+    list.PushBack(&entries[i]);
+  }
+
+  EXPECT_EQ(&entries[3], list.Find([](const TestEntry* p_entry) {
+    return p_entry->value == 3;
+  }));
+  EXPECT_EQ(nullptr, list.Find([](const TestEntry* p_entry) {
+    return p_entry->value == 5;
+  }));
+
+  TestEntry* p_next = list.Front();
+  while (p_next != nullptr) {
+    TestEntry* p_entry = p_next;
+    p_next = TestList::Next(p_entry);
+    if (p_entry->value % 2 == 0) list.Remove(p_entry);
+  }
+  EXPECT_EQ(std::vector<int>({1, 3}), values(list));
+
+  list.Clear();
+  EXPECT_TRUE(list.Empty());
+  EXPECT_FALSE(list.Contains(&entries[1]));
+  EXPECT_FALSE(list.Contains(&entries[3]));
+}
+
+TEST(IntrusiveListTest, test_element_on_two_lists) {
+  TestEntry entries[2] = {{1, {}, {}}, {2, {}, {}}};
+  TestList list;
+  IntrusiveList<TestEntry, &TestEntry::other_hook> other_list;
+
+  list.PushBack(&entries[0]);
+  list.PushBack(&entries[1]);
+  other_list.PushBack(&entries[1]);
+  other_list.PushBack(&entries[0]);
+
+  EXPECT_TRUE(list.Remove(&entries[0]));
+  EXPECT_EQ(2u, other_list.Size());
+  EXPECT_EQ(&entries[1], other_list.Front());
+  EXPECT_EQ(&entries[0], other_list.Back());
+  EXPECT_EQ(&entries[1], list.Front());
+}
+
+TEST(IntrusiveListTest, test_zero_initialized_list_is_empty) {
+  struct ControlBlock {
+    int count;
+    TestList list;
+  };
+  alignas(ControlBlock) uint8_t storage[sizeof(ControlBlock)];
+  memset(storage, 0, sizeof(storage));
+  ControlBlock* p_cb = reinterpret_cast<ControlBlock*>(storage);
+  EXPECT_TRUE(p_cb->list.Empty());
+  EXPECT_EQ(0u, p_cb->list.Size());
+
+  TestEntry entry;
+  memset(&entry, 0, sizeof(entry));
+  EXPECT_FALSE(p_cb->list.Contains(&entry));
+  p_cb->list.PushBack(&entry);
+  EXPECT_TRUE(p_cb->list.Contains(&entry));
+  EXPECT_EQ(&entry, p_cb->list.PopFront());
+}
+
+}  // namespace testing
@@ -41,15 +41,19 @@ using clearcut::connectivity::BluetoothSession_ConnectionTechnologyType;
 using clearcut::connectivity::BluetoothSession_DisconnectReasonType;
 using clearcut::connectivity::DeviceInfo;
 using clearcut::connectivity::DeviceInfo_DeviceType;
+using clearcut::connectivity::LinkQualityEvent;
 using clearcut::connectivity::PairEvent;
 using clearcut::connectivity::RFCommSession;
 using clearcut::connectivity::ScanEvent;
 using clearcut::connectivity::ScanEvent_ScanTechnologyType;
 using clearcut::connectivity::ScanEvent_ScanEventType;
+using clearcut::connectivity::SmpPairingEvent;
 using clearcut::connectivity::WakeEvent;
 using clearcut::connectivity::WakeEvent_WakeEventType;
 using system_bt_osi::BluetoothMetricsLogger;
 using system_bt_osi::A2dpSessionMetrics;
+using system_bt_osi::LinkQualityMetrics;
+using system_bt_osi::SmpPairingMetrics;
 
 namespace {
 const size_t kMaxEventGenerationLimit = 5000;
@@ -410,6 +414,80 @@ TEST_F(BluetoothMetricsLoggerTest, PairEventTest) {
   EXPECT_THAT(msg_str, StrEq(bt_log_str_));
 }
 
+TEST_F(BluetoothMetricsLoggerTest, SmpPairingEventTest) {
+  SmpPairingEvent* event = new SmpPairingEvent();
+  event->set_event_time_millis(12345);
+  event->set_status(0);
+  event->set_secure_connections(true);
+  event->set_association_model(5);
+  event->set_feature_exchange_millis(40);
+  event->set_public_key_exchange_millis(60);
+  event->set_dhkey_computation_millis(3);
+  event->set_authentication_millis(2500);
+  event->set_authentication_round_trips(1);
+  event->set_encryption_millis(30);
+  event->set_total_millis(2700);
+  bt_log_->mutable_smp_pairing_event()->AddAllocated(event);
+  bt_log_->set_num_smp_pairing_event(1);
+  UpdateLog();
+
+  // Phases that did not happen stay out of the log
+  SmpPairingMetrics metrics;
+  metrics.status = 0;
+  metrics.secure_connections = true;
+  metrics.association_model = 5;
+  metrics.feature_exchange_ms = 40;
+  metrics.public_key_exchange_ms = 60;
+  metrics.dhkey_computation_ms = 3;
+  metrics.authentication_ms = 2500;
+  metrics.authentication_round_trips = 1;
+  metrics.encryption_ms = 30;
+  metrics.total_ms = 2700;
+  BluetoothMetricsLogger::GetInstance()->LogSmpPairingEvent(12345, metrics);
+  std::string msg_str;
+  BluetoothMetricsLogger::GetInstance()->WriteString(&msg_str, true);
+  EXPECT_THAT(msg_str, StrEq(bt_log_str_));
+}
+
+TEST_F(BluetoothMetricsLoggerTest, LinkQualityEventTest) {
+  LinkQualityEvent* event = new LinkQualityEvent();
+  event->set_event_time_millis(3600000);
+  event->set_duration_millis(3600000);
+  event->set_report_count(4);
+  event->set_approach_lsto_count(0);
+  event->set_a2dp_choppy_count(1);
+  event->set_sco_choppy_count(0);
+  event->set_rssi_average(-70);
+  event->set_rssi_min(-80);
+  event->set_rssi_max(-60);
+  event->set_snr_average(20);
+  event->set_snr_min(12);
+  event->set_retransmission_count(33);
+  event->set_no_rx_count(2);
+  bt_log_->mutable_link_quality_event()->AddAllocated(event);
+  bt_log_->set_num_link_quality_event(1);
+  UpdateLog();
+
+  // No codec and unset counts stay out of the log
+  LinkQualityMetrics metrics;
+  metrics.duration_ms = 3600000;
+  metrics.report_count = 4;
+  metrics.approach_lsto_count = 0;
+  metrics.a2dp_choppy_count = 1;
+  metrics.sco_choppy_count = 0;
+  metrics.rssi_average = -70;
+  metrics.rssi_min = -80;
+  metrics.rssi_max = -60;
+  metrics.snr_average = 20;
+  metrics.snr_min = 12;
+  metrics.retransmission_count = 33;
+  metrics.no_rx_count = 2;
+  BluetoothMetricsLogger::GetInstance()->LogLinkQualityEvent(3600000, metrics);
+  std::string msg_str;
+  BluetoothMetricsLogger::GetInstance()->WriteString(&msg_str, true);
+  EXPECT_THAT(msg_str, StrEq(bt_log_str_));
+}
+
 TEST_F(BluetoothMetricsLoggerTest, WakeEventTest) {
   wake_events_.push_back(
       MakeWakeEvent(WakeEvent_WakeEventType::WakeEvent_WakeEventType_ACQUIRED,
@@ -0,0 +1,114 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+
+#include "osi/include/open_hash_map.h"
+
+using system_bt_osi::OpenHashMap;
+
+namespace testing {
+
+struct TestAddress {
+  uint8_t address[6];
+  bool operator==(const TestAddress& rhs) const {
+    return memcmp(address, rhs.address, sizeof(address)) == 0;
+  }
+};
+
+TEST(OpenHashMapTest, test_insert_find_erase) {
+  OpenHashMap<uint16_t, int> map;
+  EXPECT_TRUE(map.Empty());
+  EXPECT_EQ(nullptr, map.Find(1));
+
+  *map.Insert(1, 10) += 1;
+  map.Insert(2, 20);
+  EXPECT_EQ(2u, map.Size());
+  EXPECT_EQ(11, *map.Find(1));
+  EXPECT_TRUE(map.Contains(2));
+
+  map.Insert(2, 21);
+  EXPECT_EQ(2u, map.Size());
+  EXPECT_EQ(21, *map.Find(2));
+
+  EXPECT_TRUE(map.Erase(1));
+  EXPECT_FALSE(map.Erase(1));
+  EXPECT_EQ(nullptr, map.Find(1));
+  EXPECT_EQ(1u, map.Size());
+
+  map.Clear();
+  EXPECT_TRUE(map.Empty());
+  EXPECT_FALSE(map.Contains(2));
+}
+
+TEST(OpenHashMapTest, test_initial_capacity_avoids_growth) {
+  OpenHashMap<uint16_t, uint16_t> map(64);
+  size_t capacity = map.Capacity();
+  for (uint16_t handle = 0; handle < 64; handle++) map.Insert(handle, handle);
+  EXPECT_EQ(capacity, map.Capacity());
+  EXPECT_EQ(64u, map.Size());
+}
+
+TEST(OpenHashMapTest, test_address_keys) {
+  OpenHashMap<TestAddress, int> map;
+  TestAddress a = {{0x00, 0x11, 0x22, 0x33, 0x44, 0x55}};
+  TestAddress b = {{0x00, 0x11, 0x22, 0x33, 0x44, 0x56}};
+
+  map.Insert(a, 1);
+  EXPECT_EQ(1, *map.Find(a));
+  EXPECT_EQ(nullptr, map.Find(b));
+  map.Insert(b, 2);
+  EXPECT_EQ(2, *map.Find(b));
+
+  int sum = 0;
+  map.ForEach([&sum](const TestAddress&, int value) { sum += value; });
+  EXPECT_EQ(3, sum);
+}
+
+// Compares against std::map under a random mix of operations with a small
+// key space, which exercises collisions, growth and backward-shift erase.
+TEST(OpenHashMapTest, test_matches_std_map) {
+  OpenHashMap<uint16_t, uint32_t> map(4);
+  std::map<uint16_t, uint32_t> model;
+  std::mt19937 rng(42);
+
+  for (uint32_t i = 0; i < 20000; i++) {
+    uint16_t key = rng() % 256;
+    switch (rng() % 3) {
+      case 0:
+        map.Insert(key, i);
+        model[key] = i;
+        break;
+      case 1:
+        EXPECT_EQ(model.erase(key) == 1, map.Erase(key));
+        break;
+      default: {
+        const uint32_t* value = map.Find(key);
+        auto it = model.find(key);
+        ASSERT_EQ(it != model.end(), value != nullptr);
+        if (value) EXPECT_EQ(it->second, *value);
+      }
+    }
+    ASSERT_EQ(model.size(), map.Size());
+  }
+}
+
+}  // namespace testing
@@ -0,0 +1,136 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <string.h>
+
+#include <string>
+
+#include "AllocationTestHarness.h"
+
+#include "osi/include/packet_buffer.h"
+
+class PacketBufferTest : public AllocationTestHarness {};
+
+static std::string contents(const packet_buffer_t* packet) {
+  std::string out(packet_buffer_length(packet), '\0');
+  EXPECT_EQ(out.size(),
+            packet_buffer_copy_out(packet, 0, &out[0], out.size()));
+  return out;
+}
+
+TEST_F(PacketBufferTest, test_new_free) {
+  packet_buffer_t* packet = packet_buffer_new(16, 100);
+  ASSERT_TRUE(packet != NULL);
+  EXPECT_EQ(100u, packet_buffer_length(packet));
+  EXPECT_EQ(1u, packet_buffer_segment_count(packet));
+  EXPECT_EQ(16u, packet_buffer_headroom(packet));
+  packet_buffer_free(packet);
+}
+
+TEST_F(PacketBufferTest, test_free_null) { packet_buffer_free(NULL); }
+
+TEST_F(PacketBufferTest, test_prepend_uses_headroom) {
+  packet_buffer_t* packet = packet_buffer_new_copy(8, "payload", 7);
+  uint8_t* payload = packet_buffer_data(packet);
+
+  uint8_t* header = packet_buffer_prepend(packet, 4);
+  memcpy(header, "hdr:", 4);
+  EXPECT_EQ(header + 4, payload);
+  EXPECT_EQ(1u, packet_buffer_segment_count(packet));
+  EXPECT_EQ(4u, packet_buffer_headroom(packet));
+
+  // Not enough headroom left: a new segment is added.
+  memcpy(packet_buffer_prepend(packet, 6), "outer:", 6);
+  EXPECT_EQ(2u, packet_buffer_segment_count(packet));
+  EXPECT_EQ("outer:hdr:payload", contents(packet));
+
+  packet_buffer_free(packet);
+}
+
+TEST_F(PacketBufferTest, test_clone_does_not_share_headroom) {
+  packet_buffer_t* packet = packet_buffer_new_copy(8, "data", 4);
+  packet_buffer_t* clone = packet_buffer_clone(packet);
+
+  memcpy(packet_buffer_prepend(packet, 2), "a:", 2);
+  memcpy(packet_buffer_prepend(clone, 2), "b:", 2);
+  memcpy(packet_buffer_append(clone, 2), ":b", 2);
+
+  EXPECT_EQ("a:data", contents(packet));
+  EXPECT_EQ("b:data:b", contents(clone));
+  EXPECT_EQ(1u, packet_buffer_segment_count(packet));
+
+  packet_buffer_free(packet);
+  EXPECT_EQ("b:data:b", contents(clone));
+  packet_buffer_free(clone);
+}
+
+TEST_F(PacketBufferTest, test_split_concat_trim) {
+  packet_buffer_t* packet = packet_buffer_new_copy(0, "0123456789", 10);
+
+  packet_buffer_t* front = packet_buffer_split(packet, 4);
+  EXPECT_EQ("0123", contents(front));
+  EXPECT_EQ("456789", contents(packet));
+
+  packet_buffer_trim_front(packet, 1);
+  packet_buffer_trim_back(packet, 2);
+  EXPECT_EQ("567", contents(packet));
+
+  packet_buffer_concat(front, packet);
+  EXPECT_EQ("0123567", contents(front));
+  EXPECT_EQ(2u, packet_buffer_segment_count(front));
+
+  struct iovec iov[4];
+  ASSERT_EQ(2u, packet_buffer_get_iovec(front, iov, 4));
+  EXPECT_EQ(4u, iov[0].iov_len);
+  EXPECT_EQ(3u, iov[1].iov_len);
+
+  char tail[8];
+  EXPECT_EQ(3u, packet_buffer_copy_out(front, 4, tail, sizeof(tail)));
+  EXPECT_EQ(0, memcmp(tail, "567", 3));
+
+  packet_buffer_free(front);
+}
+
+static int release_count;
+
+static void release_cb(void* context) {
+  ++release_count;
+  *static_cast<bool*>(context) = true;
+}
+
+TEST_F(PacketBufferTest, test_external_storage) {
+  uint8_t storage[16];
+  memcpy(storage + 4, "body", 4);
+  bool released = false;
+  release_count = 0;
+
+  packet_buffer_t* packet =
+      packet_buffer_new_external(storage + 4, 4, 4, release_cb, &released);
+  memcpy(packet_buffer_prepend(packet, 4), "head", 4);
+  EXPECT_EQ(storage, packet_buffer_data(packet));
+
+  packet_buffer_t* fragment = packet_buffer_split(packet, 6);
+  packet_buffer_free(packet);
+  EXPECT_FALSE(released);
+  EXPECT_EQ("headbo", contents(fragment));
+
+  packet_buffer_free(fragment);
+  EXPECT_TRUE(released);
+  EXPECT_EQ(1, release_count);
+}
@@ -0,0 +1,99 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include "osi/include/packet_trace.h"
+
+class PacketTraceTest : public ::testing::Test {
+ protected:
+  void SetUp() override { packet_trace_init(true, false); }
+  void TearDown() override { packet_trace_init(false, false); }
+};
+
+static uint64_t sample_count(packet_trace_segment_t segment) {
+  packet_trace_stats_t stats;
+  packet_trace_get_stats(segment, &stats);
+  return stats.count;
+}
+
+TEST_F(PacketTraceTest, test_disabled_records_nothing) {
+  int packet;
+  packet_trace_init(false, false);
+  EXPECT_FALSE(packet_trace_is_enabled());
+
+  packet_trace_mark(&packet, PACKET_TRACE_TX_L2CAP_QUEUED);
+  packet_trace_mark(&packet, PACKET_TRACE_TX_HCI_SENT);
+  EXPECT_EQ(0u, sample_count(PACKET_TRACE_SEGMENT_TX_TOTAL));
+}
+
+TEST_F(PacketTraceTest, test_tx_path) {
+  int packet;
+  packet_trace_mark(&packet, PACKET_TRACE_TX_L2CAP_QUEUED);
+  usleep(1000);
+  packet_trace_mark(&packet, PACKET_TRACE_TX_L2CAP_SENT);
+  // Sending the remainder of a partially sent packet.
+  packet_trace_mark(&packet, PACKET_TRACE_TX_L2CAP_SENT);
+  packet_trace_mark(&packet, PACKET_TRACE_TX_HCI_SENT);
+
+  EXPECT_EQ(1u, sample_count(PACKET_TRACE_SEGMENT_TX_L2CAP_QUEUE));
+  EXPECT_EQ(1u, sample_count(PACKET_TRACE_SEGMENT_TX_HCI));
+  EXPECT_EQ(1u, sample_count(PACKET_TRACE_SEGMENT_TX_TOTAL));
+  EXPECT_EQ(0u, sample_count(PACKET_TRACE_SEGMENT_RX_TOTAL));
+
+  packet_trace_stats_t stats;
+  packet_trace_get_stats(PACKET_TRACE_SEGMENT_TX_L2CAP_QUEUE, &stats);
+  EXPECT_GE(stats.max_us, 1000u);
+  EXPECT_EQ(stats.max_us, stats.total_us);
+
+  // The trace is complete; marking the final point again adds nothing.
+  packet_trace_mark(&packet, PACKET_TRACE_TX_HCI_SENT);
+  EXPECT_EQ(1u, sample_count(PACKET_TRACE_SEGMENT_TX_TOTAL));
+}
+
+TEST_F(PacketTraceTest, test_rx_path_with_move) {
+  int fragment;
+  int reassembled;
+  packet_trace_mark(&fragment, PACKET_TRACE_RX_HCI_RECEIVED);
+  packet_trace_move(&fragment, &reassembled);
+  packet_trace_mark(&fragment, PACKET_TRACE_RX_L2CAP_RECEIVED);
+  EXPECT_EQ(0u, sample_count(PACKET_TRACE_SEGMENT_RX_HCI));
+
+  packet_trace_mark(&reassembled, PACKET_TRACE_RX_L2CAP_RECEIVED);
+  packet_trace_mark(&reassembled, PACKET_TRACE_RX_DELIVERED);
+  EXPECT_EQ(1u, sample_count(PACKET_TRACE_SEGMENT_RX_HCI));
+  EXPECT_EQ(1u, sample_count(PACKET_TRACE_SEGMENT_RX_L2CAP));
+  EXPECT_EQ(1u, sample_count(PACKET_TRACE_SEGMENT_RX_TOTAL));
+}
+
+TEST_F(PacketTraceTest, test_forget_and_restart) {
+  int packet;
+  packet_trace_mark(&packet, PACKET_TRACE_TX_L2CAP_QUEUED);
+  packet_trace_forget(&packet);
+  packet_trace_mark(&packet, PACKET_TRACE_TX_HCI_SENT);
+  EXPECT_EQ(0u, sample_count(PACKET_TRACE_SEGMENT_TX_TOTAL));
+
+  // A packet first seen after L2CAP queued it is traced from there.
+  packet_trace_mark(&packet, PACKET_TRACE_TX_L2CAP_SENT);
+  packet_trace_mark(&packet, PACKET_TRACE_TX_HCI_SENT);
+  EXPECT_EQ(0u, sample_count(PACKET_TRACE_SEGMENT_TX_L2CAP_QUEUE));
+  EXPECT_EQ(1u, sample_count(PACKET_TRACE_SEGMENT_TX_HCI));
+  EXPECT_EQ(1u, sample_count(PACKET_TRACE_SEGMENT_TX_TOTAL));
+}
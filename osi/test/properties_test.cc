@@ -54,3 +54,30 @@ TEST_F(PropertiesTest, test_successfull_set_and_get_value_int32) {
   int32_t received = osi_property_get_int32("very.useful.set.test", 84);
   ASSERT_EQ(received, 42);
 }
+
+TEST_F(PropertiesTest, test_cached_default_value) {
+  static osi_cached_property_t prop =
+      OSI_CACHED_PROPERTY("very.useful.cached.unset.test");
+  char value[PROPERTY_VALUE_MAX] = {0};
+  osi_cached_property_get(&prop, value, "very_useful_value");
+  ASSERT_STREQ(value, "very_useful_value");
+  ASSERT_EQ(42, osi_cached_property_get_int32(&prop, 42));
+  ASSERT_TRUE(osi_cached_property_get_bool(&prop, true));
+}
+
+TEST_F(PropertiesTest, test_cached_value_follows_set) {
+  static osi_cached_property_t prop =
+      OSI_CACHED_PROPERTY("very.useful.cached.test");
+  ASSERT_EQ(0, osi_property_set("very.useful.cached.test", "true"));
+  ASSERT_TRUE(osi_cached_property_get_bool(&prop, false));
+  ASSERT_TRUE(osi_cached_property_get_bool(&prop, false));
+
+  ASSERT_EQ(0, osi_property_set("very.useful.cached.test", "17"));
+  ASSERT_EQ(17, osi_cached_property_get_int32(&prop, 84));
+  // Not a bool
+  ASSERT_FALSE(osi_cached_property_get_bool(&prop, false));
+
+  char value[PROPERTY_VALUE_MAX];
+  ASSERT_EQ(2, osi_cached_property_get(&prop, value, NULL));
+  ASSERT_STREQ(value, "17");
+}
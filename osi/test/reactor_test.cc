@@ -111,3 +111,71 @@ TEST_F(ReactorTest, reactor_unregister_from_separate_thread) {
   close(fd);
   reactor_free(reactor);
 }
+
+static int batch_callback_count;
+
+static void drain_and_count_cb(void* context) {
+  int fd = *(int*)context;
+  eventfd_t value;
+  eventfd_read(fd, &value);
+  ++batch_callback_count;
+}
+
+TEST_F(ReactorTest, reactor_batched_dispatch) {
+  reactor_t* reactor = reactor_new_with_max_events(2);
+  ASSERT_TRUE(reactor != NULL);
+
+  int fds[4];
+  reactor_object_t* objects[4];
+  for (int i = 0; i < 4; ++i) {
+    fds[i] = eventfd(0, 0);
+    objects[i] =
+        reactor_register(reactor, fds[i], &fds[i], drain_and_count_cb, NULL);
+    eventfd_write(fds[i], 1);
+  }
+
+  // Each iteration dispatches at most two ready objects.
+  batch_callback_count = 0;
+  reactor_run_once(reactor);
+  EXPECT_EQ(batch_callback_count, 2);
+  reactor_run_once(reactor);
+  EXPECT_EQ(batch_callback_count, 4);
+
+  for (int i = 0; i < 4; ++i) {
+    reactor_unregister(objects[i]);
+    close(fds[i]);
+  }
+  reactor_free(reactor);
+}
+
+static int edge_callback_count;
+
+static void edge_cb(UNUSED_ATTR void* context) { ++edge_callback_count; }
+
+TEST_F(ReactorTest, reactor_edge_triggered) {
+  reactor_t* reactor = reactor_new();
+
+  int fd = eventfd(0, EFD_NONBLOCK);
+  int stop_fd = eventfd(0, 0);
+  reactor_object_t* object =
+      reactor_register_edge_triggered(reactor, fd, NULL, edge_cb, NULL);
+  reactor_object_t* stop_object =
+      reactor_register(reactor, stop_fd, &stop_fd, drain_and_count_cb, NULL);
+
+  // The callback does not drain |fd|, so a level-triggered registration would
+  // report it again on every iteration.
+  edge_callback_count = 0;
+  eventfd_write(fd, 1);
+  reactor_run_once(reactor);
+  EXPECT_EQ(edge_callback_count, 1);
+
+  eventfd_write(stop_fd, 1);
+  reactor_run_once(reactor);
+  EXPECT_EQ(edge_callback_count, 1);
+
+  reactor_unregister(stop_object);
+  reactor_unregister(object);
+  close(stop_fd);
+  close(fd);
+  reactor_free(reactor);
+}
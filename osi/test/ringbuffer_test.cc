@@ -137,3 +137,62 @@ TEST(RingbufferTest, test_multi_insert_delete) {
 
   ringbuffer_free(rb);
 }
+
+TEST(RingbufferTest, test_reserve_commit_wrap) {
+  ringbuffer_t* rb = ringbuffer_init(8);
+
+  uint8_t fill[6] = {0};
+  ringbuffer_insert(rb, fill, 6);
+  ringbuffer_delete(rb, 6);
+
+  // The free space now wraps around the end of the buffer.
+  ringbuffer_span_t span;
+  EXPECT_EQ((size_t)5, ringbuffer_reserve(rb, 5, &span));
+  EXPECT_EQ((size_t)2, span.first_length);
+  EXPECT_EQ((size_t)3, span.second_length);
+  ASSERT_TRUE(span.second != NULL);
+  for (size_t i = 0; i < span.first_length; ++i) span.first[i] = i + 1;
+  for (size_t i = 0; i < span.second_length; ++i)
+    span.second[i] = span.first_length + i + 1;
+
+  EXPECT_EQ((size_t)0, ringbuffer_size(rb));
+  EXPECT_EQ((size_t)5, ringbuffer_commit(rb, 5));
+  EXPECT_EQ((size_t)5, ringbuffer_size(rb));
+
+  uint8_t expected[5] = {1, 2, 3, 4, 5};
+  uint8_t peek[5] = {0};
+  EXPECT_EQ((size_t)5, ringbuffer_peek(rb, 0, peek, 5));
+  ASSERT_TRUE(0 == memcmp(expected, peek, 5));
+
+  // Reservations are capped by the free space.
+  EXPECT_EQ((size_t)3, ringbuffer_reserve(rb, 10, &span));
+
+  ringbuffer_free(rb);
+}
+
+TEST(RingbufferTest, test_acquire_release) {
+  ringbuffer_t* rb = ringbuffer_init(6);
+
+  uint8_t data[6] = {1, 2, 3, 4, 5, 6};
+  ringbuffer_insert(rb, data, 4);
+  ringbuffer_delete(rb, 3);
+  ringbuffer_insert(rb, data + 4, 2);
+  ringbuffer_insert(rb, data, 2);
+
+  ringbuffer_span_t span;
+  EXPECT_EQ((size_t)5, ringbuffer_acquire(rb, 6, &span));
+  EXPECT_EQ((size_t)3, span.first_length);
+  EXPECT_EQ((size_t)2, span.second_length);
+  EXPECT_EQ(4, span.first[0]);
+  EXPECT_EQ(6, span.first[2]);
+  EXPECT_EQ(1, span.second[0]);
+  EXPECT_EQ((size_t)5, ringbuffer_size(rb));
+
+  EXPECT_EQ((size_t)3, ringbuffer_release(rb, 3));
+  EXPECT_EQ((size_t)2, ringbuffer_acquire(rb, 6, &span));
+  EXPECT_EQ((size_t)2, span.first_length);
+  EXPECT_TRUE(span.second == NULL);
+  EXPECT_EQ(1, span.first[0]);
+
+  ringbuffer_free(rb);
+}
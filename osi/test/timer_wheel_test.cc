@@ -0,0 +1,171 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "AllocationTestHarness.h"
+
+#include "osi/include/osi.h"
+#include "osi/include/timer_wheel.h"
+
+class TimerWheelTest : public AllocationTestHarness {};
+
+struct test_entry_t {
+  timer_wheel_node_t node;
+  period_ms_t deadline;
+  size_t order;
+};
+
+static void count_entries(void* context, void* user_data) {
+  (*static_cast<size_t*>(user_data))++;
+}
+
+TEST_F(TimerWheelTest, test_new_free_empty) {
+  timer_wheel_t* wheel = timer_wheel_new(1000);
+  ASSERT_TRUE(wheel != NULL);
+
+  period_ms_t deadline;
+  EXPECT_EQ(0U, timer_wheel_size(wheel));
+  EXPECT_FALSE(timer_wheel_next_deadline(wheel, &deadline));
+  EXPECT_EQ(nullptr, timer_wheel_pop_expired(wheel, 100000));
+
+  timer_wheel_free(wheel);
+}
+
+TEST_F(TimerWheelTest, test_insert_remove_expire) {
+  timer_wheel_t* wheel = timer_wheel_new(1000);
+  test_entry_t a = {}, b = {}, c = {};
+
+  timer_wheel_insert(wheel, &a.node, 1010, &a);
+  timer_wheel_insert(wheel, &b.node, 1010 + 5000, &b);
+  timer_wheel_insert(wheel, &c.node, 1005, &c);
+  EXPECT_EQ(3U, timer_wheel_size(wheel));
+  EXPECT_TRUE(timer_wheel_is_pending(&a.node));
+
+  period_ms_t deadline;
+  ASSERT_TRUE(timer_wheel_next_deadline(wheel, &deadline));
+  EXPECT_EQ(1005U, deadline);
+
+  timer_wheel_remove(wheel, &c.node);
+  timer_wheel_remove(wheel, &c.node);  // idempotent
+  EXPECT_FALSE(timer_wheel_is_pending(&c.node));
+  ASSERT_TRUE(timer_wheel_next_deadline(wheel, &deadline));
+  EXPECT_EQ(1010U, deadline);
+
+  EXPECT_EQ(nullptr, timer_wheel_pop_expired(wheel, 1009));
+  EXPECT_EQ(&a, timer_wheel_pop_expired(wheel, 1010));
+  EXPECT_EQ(nullptr, timer_wheel_pop_expired(wheel, 1010));
+
+  ASSERT_TRUE(timer_wheel_next_deadline(wheel, &deadline));
+  EXPECT_EQ(6010U, deadline);
+  EXPECT_EQ(&b, timer_wheel_pop_expired(wheel, 7000));
+  EXPECT_EQ(0U, timer_wheel_size(wheel));
+
+  timer_wheel_free(wheel);
+}
+
+TEST_F(TimerWheelTest, test_past_and_far_deadlines) {
+  timer_wheel_t* wheel = timer_wheel_new(50000);
+  test_entry_t past = {}, far = {};
+
+  timer_wheel_insert(wheel, &past.node, 10, &past);
+  EXPECT_EQ(&past, timer_wheel_pop_expired(wheel, 50000));
+
+  // Beyond the wheel horizon (about 4.6 hours)
+  period_ms_t far_deadline = 50000 + 10ULL * 3600 * 1000;
+  timer_wheel_insert(wheel, &far.node, far_deadline, &far);
+  period_ms_t deadline;
+  ASSERT_TRUE(timer_wheel_next_deadline(wheel, &deadline));
+  EXPECT_EQ(far_deadline, deadline);
+
+  EXPECT_EQ(nullptr, timer_wheel_pop_expired(wheel, far_deadline - 1));
+  EXPECT_EQ(&far, timer_wheel_pop_expired(wheel, far_deadline));
+
+  timer_wheel_free(wheel);
+}
+
+TEST_F(TimerWheelTest, test_same_deadline_keeps_insertion_order) {
+  timer_wheel_t* wheel = timer_wheel_new(0);
+  test_entry_t entries[8] = {};
+
+  for (auto& entry : entries) timer_wheel_insert(wheel, &entry.node, 300, &entry);
+  for (auto& entry : entries)
+    EXPECT_EQ(&entry, timer_wheel_pop_expired(wheel, 1000));
+
+  timer_wheel_free(wheel);
+}
+
+TEST_F(TimerWheelTest, test_matches_sorted_order) {
+  timer_wheel_t* wheel = timer_wheel_new(12345);
+  const size_t count = 2000;
+  std::vector<test_entry_t> entries(count);
+
+  period_ms_t start = 12345;
+  for (size_t i = 0; i < count; i++) {
+    // Mix of short, medium and long timeouts spread over all levels.
+    period_ms_t delay = osi_rand() % (1 << (4 + (i % 20)));
+    entries[i].deadline = start + delay;
+    entries[i].order = i;
+    timer_wheel_insert(wheel, &entries[i].node, entries[i].deadline,
+                       &entries[i]);
+  }
+
+  // Cancel every seventh entry.
+  size_t removed = 0;
+  for (size_t i = 0; i < count; i += 7, removed++)
+    timer_wheel_remove(wheel, &entries[i].node);
+  EXPECT_EQ(count - removed, timer_wheel_size(wheel));
+
+  size_t iterated = 0;
+  timer_wheel_foreach(wheel, count_entries, &iterated);
+  EXPECT_EQ(count - removed, iterated);
+
+  std::vector<test_entry_t*> expected;
+  for (size_t i = 0; i < count; i++)
+    if (i % 7) expected.push_back(&entries[i]);
+  std::stable_sort(expected.begin(), expected.end(),
+                   [](const test_entry_t* a, const test_entry_t* b) {
+                     return a->deadline < b->deadline;
+                   });
+
+  size_t popped = 0;
+  period_ms_t now = start;
+  while (popped < expected.size()) {
+    period_ms_t deadline;
+    ASSERT_TRUE(timer_wheel_next_deadline(wheel, &deadline));
+    ASSERT_EQ(expected[popped]->deadline, deadline);
+    ASSERT_GE(deadline, now);
+    now = deadline;
+
+    // Nothing may expire early.
+    if (now > start) ASSERT_EQ(nullptr, timer_wheel_pop_expired(wheel, now - 1));
+
+    test_entry_t* entry;
+    while ((entry = static_cast<test_entry_t*>(
+                timer_wheel_pop_expired(wheel, now))) != NULL) {
+      ASSERT_EQ(expected[popped], entry);
+      popped++;
+    }
+  }
+  EXPECT_EQ(0U, timer_wheel_size(wheel));
+
+  timer_wheel_free(wheel);
+}
@@ -0,0 +1,134 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "osi/include/trace_ring.h"
+
+class TraceRingTest : public ::testing::Test {
+ protected:
+  void SetUp() override { trace_ring_init(true); }
+  void TearDown() override { trace_ring_init(false); }
+};
+
+struct test_address_t {
+  uint8_t address[TRACE_RING_ADDRESS_LEN];
+};
+
+// Builds a record the way TRACE_RING_LOG does and formats it.
+template <typename... Args>
+static std::string format(const char* fmt, Args... args) {
+  trace_ring_record_t record;
+  record.format = fmt;
+  record.arg_count = 0;
+  record.strings_used = 0;
+  int expand[] = {0, (trace_ring_internal::add_arg(&record, args), 0)...};
+  (void)expand;
+
+  char buffer[128];
+  trace_ring_format(&record, buffer, sizeof(buffer));
+  return buffer;
+}
+
+static std::string dump(void) {
+  FILE* fp = tmpfile();
+  trace_ring_debug_dump(fileno(fp));
+  rewind(fp);
+
+  std::string text;
+  char buffer[256];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+    text.append(buffer, read);
+  fclose(fp);
+  return text;
+}
+
+TEST_F(TraceRingTest, test_format_integers) {
+  EXPECT_EQ("-1 65535 ff", format("%d %u %x", -1, (uint16_t)0xffff,
+                                  (uint8_t)0xff));
+  EXPECT_EQ("0xffffffff 4294967295", format("0x%x %u", -1, -1));
+  EXPECT_EQ("-1 ff", format("%hhd %hhx", 0xff, 0x1ff));
+  EXPECT_EQ("  42|042|42  ", format("%4d|%03d|%-4d", 42, 42, 42));
+  EXPECT_EQ("  7", format("%*d", 3, 7));
+  EXPECT_EQ("18446744073709551615 -9",
+            format("%" PRIu64 " %lld", UINT64_MAX, -9LL));
+  EXPECT_EQ("A 100%", format("%c %d%%", 'A', 100));
+}
+
+TEST_F(TraceRingTest, test_format_strings_and_doubles) {
+  char transient[] = "transient";
+  EXPECT_EQ("name=transient", format("name=%s", transient));
+  EXPECT_EQ("[  abc]", format("[%5s]", "abc"));
+  EXPECT_EQ("(null)", format("%s", (const char*)NULL));
+  EXPECT_EQ("1.50", format("%.2f", 1.5));
+
+  test_address_t bda = {{0x00, 0x11, 0x22, 0xaa, 0xbb, 0xcc}};
+  EXPECT_EQ("bda 00:11:22:aa:bb:cc", format("bda %s", TRACE_RING_ADDRESS(bda)));
+}
+
+TEST_F(TraceRingTest, test_format_mismatches) {
+  EXPECT_EQ("<?>", format("%s", 5));
+  EXPECT_EQ("<?>", format("%d", "text"));
+  EXPECT_EQ("1 %d", format("%d %d", 1));
+}
+
+TEST_F(TraceRingTest, test_format_copies_at_most_the_string_area) {
+  std::string longer(TRACE_RING_STRING_SIZE * 2, 'x');
+  std::string text = format("%s|%s", longer.c_str(), "tail");
+  EXPECT_EQ(std::string(TRACE_RING_STRING_SIZE - 1, 'x') + "|", text);
+}
+
+TEST_F(TraceRingTest, test_format_truncates_to_buffer) {
+  trace_ring_record_t record;
+  record.format = "%s";
+  record.arg_count = 0;
+  record.strings_used = 0;
+  trace_ring_internal::add_arg(&record, "0123456789");
+
+  char buffer[5];
+  EXPECT_EQ(4u, trace_ring_format(&record, buffer, sizeof(buffer)));
+  EXPECT_STREQ("0123", buffer);
+}
+
+TEST_F(TraceRingTest, test_disabled_records_nothing) {
+  trace_ring_init(false);
+  TRACE_RING_LOG(INFO, "bt_test", "value %d", 1);
+  EXPECT_EQ("", dump());
+}
+
+TEST_F(TraceRingTest, test_dump_oldest_first) {
+  for (int i = 0; i < TRACE_RING_SIZE + 2; i++)
+    TRACE_RING_LOG(VERBOSE, "bt_test", "record %d of %s", i, "run");
+
+  std::string text = dump();
+  EXPECT_NE(std::string::npos,
+            text.find("Records: " + std::to_string(TRACE_RING_SIZE + 2)));
+  EXPECT_EQ(std::string::npos, text.find("record 1 of run\n"));
+  size_t first = text.find(" V bt_test: record 2 of run\n");
+  size_t last = text.find(
+      "record " + std::to_string(TRACE_RING_SIZE + 1) + " of run\n");
+  EXPECT_NE(std::string::npos, first);
+  EXPECT_NE(std::string::npos, last);
+  EXPECT_LT(first, last);
+}
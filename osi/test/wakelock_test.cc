@@ -23,12 +23,15 @@
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
+
+#include <atomic>
 
 #include "osi/include/wakelock.h"
 
 #include "AllocationTestHarness.h"
 
-static bool is_wake_lock_acquired = false;
+static std::atomic<bool> is_wake_lock_acquired(false);
 
 static int acquire_wake_lock_cb(const char* lock_name) {
   is_wake_lock_acquired = true;
@@ -155,3 +158,49 @@ TEST_F(WakelockTest, test_set_paths) {
     ASSERT_FALSE(IsFileWakeLockAcquired());
   }
 }
+
+static int acquire_count = 0;
+
+static int counting_acquire_wake_lock_cb(const char* lock_name) {
+  acquire_count++;
+  return acquire_wake_lock_cb(lock_name);
+}
+
+static bt_os_callouts_t bt_counting_wakelock_callouts = {
+    sizeof(bt_os_callouts_t), NULL, counting_acquire_wake_lock_cb,
+    release_wake_lock_cb};
+
+TEST_F(WakelockTest, test_refs_share_kernel_lock) {
+  wakelock_set_os_callouts(&bt_counting_wakelock_callouts);
+  acquire_count = 0;
+
+  ASSERT_TRUE(wakelock_acquire_ref("first"));
+  ASSERT_TRUE(wakelock_acquire_ref("second"));
+  ASSERT_EQ(1, acquire_count);
+
+  ASSERT_TRUE(wakelock_release_ref("first", 0));
+  ASSERT_TRUE(is_wake_lock_acquired);
+  ASSERT_TRUE(wakelock_release_ref("second", 0));
+  ASSERT_FALSE(is_wake_lock_acquired);
+
+  // Not held
+  ASSERT_FALSE(wakelock_release_ref("second", 0));
+}
+
+TEST_F(WakelockTest, test_release_lingers) {
+  wakelock_set_os_callouts(&bt_counting_wakelock_callouts);
+  acquire_count = 0;
+
+  ASSERT_TRUE(wakelock_acquire_ref("test"));
+  ASSERT_TRUE(wakelock_release_ref("test", 50));
+  ASSERT_TRUE(is_wake_lock_acquired);
+
+  // Acquired again within the linger time, the kernel lock stays
+  ASSERT_TRUE(wakelock_acquire_ref("test"));
+  ASSERT_EQ(1, acquire_count);
+  ASSERT_TRUE(wakelock_release_ref("test", 10));
+
+  for (int i = 0; i < 100 && is_wake_lock_acquired; i++) usleep(10 * 1000);
+  ASSERT_FALSE(is_wake_lock_acquired);
+  ASSERT_EQ(1, acquire_count);
+}
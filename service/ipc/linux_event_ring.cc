@@ -0,0 +1,238 @@
+//
+//  Copyright (C) 2026 The Android Open Source Project
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at:
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "service/ipc/linux_event_ring.h"
+
+#include <errno.h>
+#include <linux/memfd.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <new>
+
+#include <base/logging.h>
+
+namespace ipc {
+
+namespace {
+
+const uint32_t kRingMagic = 0x42545252;  // "BTRR"
+const size_t kMinCapacity = 4096;
+const size_t kMaxCapacity = 16 * 1024 * 1024;
+
+// Offset of the event data in the mapping, past the header.
+const size_t kDataOffset = 256;
+
+// Type of the header that fills the end of the ring when an event doesn't
+// fit there.
+const uint16_t kEventPadding = UINT16_MAX;
+
+struct EventHeader {
+  uint16_t type;
+  uint16_t length;
+};
+
+size_t AlignedEventSize(size_t length) {
+  return sizeof(EventHeader) + ((length + 3) & ~static_cast<size_t>(3));
+}
+
+}  // namespace
+
+// Lives at the start of the mapping. |head| and |tail| count the bytes ever
+// written and read, the offsets in the ring are taken modulo the capacity,
+// which is a power of two. Each is only written by one side and sits on a
+// cache line of its own.
+struct EventRing::Header {
+  uint32_t magic;
+  uint32_t capacity;
+  alignas(64) std::atomic<uint32_t> head;
+  alignas(64) std::atomic<uint32_t> tail;
+  alignas(64) std::atomic<uint32_t> dropped;
+};
+
+// static
+std::unique_ptr<EventRing> EventRing::Create(size_t capacity) {
+  size_t rounded = kMinCapacity;
+  while (rounded < capacity && rounded < kMaxCapacity) rounded <<= 1;
+
+#if defined(__NR_memfd_create)
+  base::ScopedFD memory_fd(static_cast<int>(
+      syscall(__NR_memfd_create, "bt_event_ring", MFD_CLOEXEC)));
+#else
+  base::ScopedFD memory_fd;
+  errno = ENOSYS;
+#endif
+  if (!memory_fd.is_valid()) {
+    LOG(ERROR) << "Failed to create event ring memory: " << strerror(errno);
+    return nullptr;
+  }
+
+  size_t mapping_size = kDataOffset + rounded;
+  if (ftruncate(memory_fd.get(), mapping_size) < 0) {
+    LOG(ERROR) << "Failed to size event ring memory: " << strerror(errno);
+    return nullptr;
+  }
+
+  base::ScopedFD doorbell_fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
+  if (!doorbell_fd.is_valid()) {
+    LOG(ERROR) << "Failed to create event ring doorbell: " << strerror(errno);
+    return nullptr;
+  }
+
+  void* mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED, memory_fd.get(), 0);
+  if (mapping == MAP_FAILED) {
+    LOG(ERROR) << "Failed to map event ring memory: " << strerror(errno);
+    return nullptr;
+  }
+
+  Header* header = new (mapping) Header();
+  header->magic = kRingMagic;
+  header->capacity = rounded;
+
+  return std::unique_ptr<EventRing>(new EventRing(
+      std::move(memory_fd), std::move(doorbell_fd), mapping, mapping_size));
+}
+
+// static
+std::unique_ptr<EventRing> EventRing::Attach(base::ScopedFD memory_fd,
+                                             base::ScopedFD doorbell_fd) {
+  struct stat info;
+  if (fstat(memory_fd.get(), &info) < 0 ||
+      info.st_size < static_cast<off_t>(kDataOffset + kMinCapacity)) {
+    LOG(ERROR) << "Invalid event ring memory";
+    return nullptr;
+  }
+
+  size_t mapping_size = info.st_size;
+  void* mapping = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED, memory_fd.get(), 0);
+  if (mapping == MAP_FAILED) {
+    LOG(ERROR) << "Failed to map event ring memory: " << strerror(errno);
+    return nullptr;
+  }
+
+  const Header* header = static_cast<const Header*>(mapping);
+  if (header->magic != kRingMagic ||
+      kDataOffset + header->capacity != mapping_size) {
+    LOG(ERROR) << "Invalid event ring header";
+    munmap(mapping, mapping_size);
+    return nullptr;
+  }
+
+  return std::unique_ptr<EventRing>(new EventRing(
+      std::move(memory_fd), std::move(doorbell_fd), mapping, mapping_size));
+}
+
+EventRing::EventRing(base::ScopedFD memory_fd, base::ScopedFD doorbell_fd,
+                     void* mapping, size_t mapping_size)
+    : memory_fd_(std::move(memory_fd)),
+      doorbell_fd_(std::move(doorbell_fd)),
+      mapping_(mapping),
+      mapping_size_(mapping_size),
+      header_(static_cast<Header*>(mapping)),
+      data_(static_cast<uint8_t*>(mapping) + kDataOffset),
+      capacity_(mapping_size - kDataOffset) {
+  static_assert(sizeof(Header) <= kDataOffset,
+                "EventRing header overlaps the event data");
+}
+
+EventRing::~EventRing() { munmap(mapping_, mapping_size_); }
+
+bool EventRing::Write(uint16_t type, const uint8_t* payload, size_t length) {
+  size_t size = AlignedEventSize(length);
+  if (type == kEventPadding || length > kMaxPayloadLength ||
+      size > capacity_) {
+    header_->dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  uint32_t start = header_->head.load(std::memory_order_relaxed);
+  uint32_t tail = header_->tail.load(std::memory_order_acquire);
+  size_t offset = start & (capacity_ - 1);
+  size_t to_end = capacity_ - offset;
+  size_t needed = to_end < size ? to_end + size : size;
+  if (capacity_ - static_cast<uint32_t>(start - tail) < needed) {
+    header_->dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  uint32_t head = start;
+  if (to_end < size) {
+    EventHeader padding = {kEventPadding, 0};
+    memcpy(data_ + offset, &padding, sizeof(padding));
+    head += to_end;
+    offset = 0;
+  }
+
+  EventHeader event = {type, static_cast<uint16_t>(length)};
+  memcpy(data_ + offset, &event, sizeof(event));
+  if (length) memcpy(data_ + offset + sizeof(event), payload, length);
+  header_->head.store(head + size, std::memory_order_seq_cst);
+
+  // Ring only if the client had read everything before this event. Loading
+  // |tail| after publishing |head| pairs with the client loading |head| after
+  // publishing |tail|, so one of the two always sees the other.
+  if (header_->tail.load(std::memory_order_seq_cst) == start)
+    eventfd_write(doorbell_fd_.get(), 1);
+  return true;
+}
+
+bool EventRing::Read(uint16_t* type, std::vector<uint8_t>* payload) {
+  uint32_t tail = header_->tail.load(std::memory_order_relaxed);
+  while (true) {
+    uint32_t head = header_->head.load(std::memory_order_seq_cst);
+    if (head == tail) return false;
+
+    size_t offset = tail & (capacity_ - 1);
+    EventHeader event;
+    memcpy(&event, data_ + offset, sizeof(event));
+    if (event.type == kEventPadding) {
+      tail += capacity_ - offset;
+      header_->tail.store(tail, std::memory_order_seq_cst);
+      continue;
+    }
+
+    // The client only trusts the ring as far as its own mapping goes
+    if (AlignedEventSize(event.length) > capacity_ - offset) {
+      LOG(ERROR) << "Corrupted event ring";
+      return false;
+    }
+
+    *type = event.type;
+    const uint8_t* start = data_ + offset + sizeof(event);
+    payload->assign(start, start + event.length);
+    header_->tail.store(tail + AlignedEventSize(event.length),
+                        std::memory_order_seq_cst);
+    return true;
+  }
+}
+
+void EventRing::ClearDoorbell() {
+  eventfd_t value;
+  eventfd_read(doorbell_fd_.get(), &value);
+}
+
+uint32_t EventRing::dropped() const {
+  return header_->dropped.load(std::memory_order_relaxed);
+}
+
+}  // namespace ipc
@@ -0,0 +1,97 @@
+//
+//  Copyright (C) 2026 The Android Open Source Project
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at:
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include <base/files/scoped_file.h>
+#include <base/macros.h>
+
+namespace ipc {
+
+// A single producer, single consumer ring of events in memory shared between
+// the daemon and one Linux IPC client. The daemon writes high rate events,
+// e.g. scan results, into the ring and the client reads them straight out of
+// the mapping, without a socket message per event. The eventfd doorbell is
+// only signaled when the ring goes from empty to non-empty, so a client that
+// keeps up drains many events per wakeup.
+//
+// Each event is a 4 byte header, the event type and the payload length, and
+// the payload padded to 4 bytes. An event never wraps; when one doesn't fit
+// before the end of the ring the rest of it is skipped. When the ring is full
+// the daemon drops the event and counts it, it never waits for the client.
+class EventRing {
+ public:
+  // Event types. The payload of kEventScanResult is the 6 byte device address
+  // (most significant byte first), the RSSI as an int8_t and the scan record.
+  enum : uint16_t {
+    kEventScanResult = 1,
+  };
+
+  // Largest payload of an event.
+  static const size_t kMaxPayloadLength = UINT16_MAX;
+
+  // Creates a ring of at least |capacity| bytes for the daemon. Returns
+  // nullptr if the shared memory or the doorbell can't be created.
+  static std::unique_ptr<EventRing> Create(size_t capacity);
+
+  // Maps the ring created by the daemon, from the descriptors it sent.
+  // Returns nullptr if |memory_fd| is not a valid ring.
+  static std::unique_ptr<EventRing> Attach(base::ScopedFD memory_fd,
+                                           base::ScopedFD doorbell_fd);
+
+  ~EventRing();
+
+  // Producer side. Returns false if the event was dropped.
+  bool Write(uint16_t type, const uint8_t* payload, size_t length);
+
+  // Consumer side. Reads the oldest event, returns false if there is none.
+  // Poll doorbell_fd() for POLLIN, call ClearDoorbell() and then Read()
+  // until it returns false.
+  bool Read(uint16_t* type, std::vector<uint8_t>* payload);
+  void ClearDoorbell();
+
+  // Returns the number of events the producer dropped because the ring was
+  // full.
+  uint32_t dropped() const;
+
+  size_t capacity() const { return capacity_; }
+  int memory_fd() const { return memory_fd_.get(); }
+  int doorbell_fd() const { return doorbell_fd_.get(); }
+
+ private:
+  struct Header;
+
+  EventRing(base::ScopedFD memory_fd, base::ScopedFD doorbell_fd,
+            void* mapping, size_t mapping_size);
+
+  base::ScopedFD memory_fd_;
+  base::ScopedFD doorbell_fd_;
+  void* mapping_;
+  size_t mapping_size_;
+  Header* header_;
+  uint8_t* data_;
+  size_t capacity_;
+
+  DISALLOW_COPY_AND_ASSIGN(EventRing);
+};
+
+}  // namespace ipc
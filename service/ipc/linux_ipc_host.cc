@@ -28,6 +28,7 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <mutex>
 
 #include <base/base64.h>
 #include <base/strings/string_number_conversions.h>
@@ -36,8 +37,15 @@
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
 #include "service/adapter.h"
+#include "service/ipc/linux_event_ring.h"
+#include "service/low_energy_scanner.h"
+#include "types/raw_address.h"
 
 using bluetooth::Adapter;
+using bluetooth::BLEStatus;
+using bluetooth::BluetoothInstance;
+using bluetooth::LowEnergyScanner;
+using bluetooth::ScanResult;
 using bluetooth::Uuid;
 
 using namespace bluetooth::gatt;
@@ -56,6 +64,11 @@ const char kSetScanResponseCommand[] = "set-scan-response";
 const char kStartServiceCommand[] = "start-service";
 const char kStopServiceCommand[] = "stop-service";
 const char kWriteCharacteristicCommand[] = "write-characteristic";
+const char kOpenEventRingCommand[] = "open-event-ring";
+const char kEventRingReply[] = "event-ring";
+const char kStartScanCommand[] = "start-scan";
+const char kStopScanCommand[] = "stop-scan";
+const char kScanResultEvent[] = "scan-result";
 
 // Useful values for indexing LinuxIPCHost::pfds_
 // Not super general considering that we should be able to support
@@ -68,14 +81,158 @@ enum {
 
 bool TokenBool(const std::string& text) { return text == "true"; }
 
+// Sends |message| on |sockfd| along with the descriptors |fds|.
+bool SendWithFds(int sockfd, const std::string& message,
+                 const std::vector<int>& fds) {
+  struct iovec iov = {const_cast<char*>(message.data()), message.size()};
+  std::vector<char> control(CMSG_SPACE(sizeof(int) * fds.size()));
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.data();
+  msg.msg_controllen = control.size();
+
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+  memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+
+  ssize_t r;
+  OSI_NO_INTR(r = sendmsg(sockfd, &msg, 0));
+  return r == static_cast<ssize_t>(message.size());
+}
+
 }  // namespace
 
 namespace ipc {
 
-LinuxIPCHost::LinuxIPCHost(int sockfd, Adapter* adapter)
-    : adapter_(adapter), pfds_(1, {sockfd, POLLIN, 0}) {}
+// Streams the results of the client's LE scan. Results arrive on the HAL
+// callback thread; they go into the event ring when the client opened one,
+// and as socket messages otherwise.
+class LinuxIPCHost::ScanSession : public LowEnergyScanner::Delegate {
+ public:
+  explicit ScanSession(int sockfd) : sockfd_(sockfd), scan_requested_(false) {}
+
+  ~ScanSession() override {
+    // Unregistering waits for a scan result callback in flight, which takes
+    // |lock_|, so the scanner is destroyed without holding it.
+    std::unique_ptr<LowEnergyScanner> scanner;
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      scanner = std::move(scanner_);
+    }
+  }
+
+  void SetRing(std::unique_ptr<EventRing> ring) {
+    std::lock_guard<std::mutex> lock(lock_);
+    ring_ = std::move(ring);
+  }
+
+  // Returns false if the scan can't be started. The scanner is registered
+  // the first time, the scan starts once registration completes.
+  bool Start(Adapter* adapter, const std::shared_ptr<ScanSession>& self) {
+    std::lock_guard<std::mutex> lock(lock_);
+    scan_requested_ = true;
+    if (scanner_) return scanner_->StartScan(bluetooth::ScanSettings(), {});
+    if (registering_) return true;
+
+    std::weak_ptr<ScanSession> weak_self = self;
+    registering_ = adapter->GetLeScannerFactory()->RegisterInstance(
+        Uuid::GetRandom(),
+        [weak_self](BLEStatus status, const Uuid& app_uuid,
+                    std::unique_ptr<BluetoothInstance> instance) {
+          std::shared_ptr<ScanSession> session = weak_self.lock();
+          if (!session) return;
+          session->OnRegistered(
+              status, std::unique_ptr<LowEnergyScanner>(
+                          static_cast<LowEnergyScanner*>(instance.release())));
+        });
+    return registering_;
+  }
 
-LinuxIPCHost::~LinuxIPCHost() { close(pfds_[0].fd); }
+  bool Stop() {
+    std::lock_guard<std::mutex> lock(lock_);
+    scan_requested_ = false;
+    return scanner_ ? scanner_->StopScan() : true;
+  }
+
+  // LowEnergyScanner::Delegate override:
+  void OnScanResult(LowEnergyScanner* scanner,
+                    const ScanResult& scan_result) override {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (ring_) {
+      WriteToRing(scan_result);
+      return;
+    }
+
+    std::string encoded_record;
+    base::Base64Encode(std::string(scan_result.scan_record().begin(),
+                                   scan_result.scan_record().end()),
+                       &encoded_record);
+    std::string transmit(kScanResultEvent);
+    transmit += "|" + scan_result.device_address();
+    transmit += "|" + std::to_string(scan_result.rssi());
+    transmit += "|" + encoded_record;
+
+    // The socket doesn't block; a result the client has no room for is lost.
+    ssize_t r;
+    OSI_NO_INTR(r = send(sockfd_, transmit.data(), transmit.size(), 0));
+    if (r < 0 && errno != EAGAIN)
+      LOG_ERROR(LOG_TAG, "Error sending scan result: %s", strerror(errno));
+  }
+
+ private:
+  void OnRegistered(BLEStatus status,
+                    std::unique_ptr<LowEnergyScanner> scanner) {
+    std::lock_guard<std::mutex> lock(lock_);
+    registering_ = false;
+    if (status != bluetooth::BLE_STATUS_SUCCESS || !scanner) {
+      LOG_ERROR(LOG_TAG, "Failed to register scanner: %d", status);
+      return;
+    }
+
+    scanner_ = std::move(scanner);
+    scanner_->SetDelegate(this);
+    if (scan_requested_) scanner_->StartScan(bluetooth::ScanSettings(), {});
+  }
+
+  void WriteToRing(const ScanResult& scan_result) {
+    RawAddress address;
+    if (!RawAddress::FromString(scan_result.device_address(), address)) return;
+
+    const std::vector<uint8_t>& record = scan_result.scan_record();
+    payload_.assign(address.address, address.address + RawAddress::kLength);
+    payload_.push_back(static_cast<uint8_t>(scan_result.rssi()));
+    payload_.insert(payload_.end(), record.begin(), record.end());
+    ring_->Write(EventRing::kEventScanResult, payload_.data(),
+                 payload_.size());
+  }
+
+  const int sockfd_;
+
+  // Protects the members below.
+  std::mutex lock_;
+  std::unique_ptr<EventRing> ring_;
+  std::unique_ptr<LowEnergyScanner> scanner_;
+  bool registering_ = false;
+  bool scan_requested_;
+  // Reused for every event written to the ring
+  std::vector<uint8_t> payload_;
+};
+
+LinuxIPCHost::LinuxIPCHost(int sockfd, Adapter* adapter)
+    : adapter_(adapter),
+      pfds_(1, {sockfd, POLLIN, 0}),
+      scan_session_(std::make_shared<ScanSession>(sockfd)) {}
+
+LinuxIPCHost::~LinuxIPCHost() {
+  // Stop streaming before the socket goes away
+  scan_session_.reset();
+  close(pfds_[0].fd);
+}
 
 bool LinuxIPCHost::EventLoop() {
   while (true) {
@@ -244,6 +401,34 @@ bool LinuxIPCHost::OnStopService(const std::string& service_uuid) {
   return gatt_servers_[service_uuid]->Stop();
 }
 
+bool LinuxIPCHost::OnOpenEventRing(const std::string& capacity) {
+  unsigned requested;
+  if (!base::StringToUint(capacity, &requested)) {
+    LOG_ERROR(LOG_TAG, "Invalid event ring capacity: %s", capacity.c_str());
+    return false;
+  }
+
+  std::unique_ptr<EventRing> ring = EventRing::Create(requested);
+  if (!ring) return false;
+
+  std::string transmit(kEventRingReply);
+  transmit += "|" + std::to_string(ring->capacity());
+  if (!SendWithFds(pfds_[kFdIpc].fd, transmit,
+                   {ring->memory_fd(), ring->doorbell_fd()})) {
+    LOG_ERROR(LOG_TAG, "Error sending event ring: %s", strerror(errno));
+    return false;
+  }
+
+  scan_session_->SetRing(std::move(ring));
+  return true;
+}
+
+bool LinuxIPCHost::OnStartScan() {
+  return scan_session_->Start(adapter_, scan_session_);
+}
+
+bool LinuxIPCHost::OnStopScan() { return scan_session_->Stop(); }
+
 bool LinuxIPCHost::OnMessage() {
   std::string ipc_msg;
   ssize_t size;
@@ -271,6 +456,10 @@ bool LinuxIPCHost::OnMessage() {
   std::vector<std::string> tokens = base::SplitString(
       ipc_msg, "|", base::TRIM_WHITESPACE, base::SPLIT_WANT_ALL);
   switch (tokens.size()) {
+    case 1:
+      if (tokens[0] == kStartScanCommand) return OnStartScan();
+      if (tokens[0] == kStopScanCommand) return OnStopScan();
+      break;
     case 2:
       if (tokens[0] == kSetAdapterNameCommand)
         return OnSetAdapterName(tokens[1]);
@@ -279,6 +468,8 @@ bool LinuxIPCHost::OnMessage() {
         return OnDestroyService(tokens[1]);
       if (tokens[0] == kStartServiceCommand) return OnStartService(tokens[1]);
       if (tokens[0] == kStopServiceCommand) return OnStopService(tokens[1]);
+      if (tokens[0] == kOpenEventRingCommand)
+        return OnOpenEventRing(tokens[1]);
       break;
     case 4:
       if (tokens[0] == kSetCharacteristicValueCommand)
@@ -92,6 +92,15 @@ class LinuxIPCHost {
   // Stops service.
   bool OnStopService(const std::string& service_uuid);
 
+  // Creates the shared memory event ring of at least |capacity| bytes and
+  // sends its memory and doorbell descriptors to the client. From then on
+  // high rate events go through the ring instead of the socket.
+  bool OnOpenEventRing(const std::string& capacity);
+
+  // Starts and stops an LE scan, whose results are streamed to the client.
+  bool OnStartScan();
+  bool OnStopScan();
+
   // weak reference.
   bluetooth::Adapter* adapter_;
 
@@ -102,6 +111,12 @@ class LinuxIPCHost {
   // TODO(icoolidge): support many to one for real.
   std::unordered_map<std::string, std::unique_ptr<bluetooth::gatt::Server>>
       gatt_servers_;
+
+  // Scanner of this client and the transport of its results. Shared with the
+  // asynchronous scanner registration, which may complete after this host is
+  // gone.
+  class ScanSession;
+  std::shared_ptr<ScanSession> scan_session_;
 };
 
 }  // namespace ipc
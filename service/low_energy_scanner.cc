@@ -16,6 +16,10 @@
 
 #include "service/low_energy_scanner.h"
 
+#include <strings.h>
+
+#include <algorithm>
+
 #include <base/bind.h>
 #include <base/logging.h>
 
@@ -40,7 +44,7 @@ const size_t kScanRecordLength = 62;
 // Returns the length of the given scan record array. We have to calculate this
 // based on the maximum possible data length and the TLV data. See TODO above
 // |kScanRecordLength|.
-size_t GetScanRecordLength(std::vector<uint8_t> bytes) {
+size_t GetScanRecordLength(const std::vector<uint8_t>& bytes) {
   for (size_t i = 0, field_len = 0; i < kScanRecordLength;
        i += (field_len + 1)) {
     field_len = bytes[i];
@@ -60,25 +64,188 @@ size_t GetScanRecordLength(std::vector<uint8_t> bytes) {
   return kScanRecordLength;
 }
 
+// AD types parsed by ScanRecordIndex, see the Core Specification Supplement.
+const uint8_t kAdTypeIncomplete16BitUuids = 0x02;
+const uint8_t kAdTypeComplete16BitUuids = 0x03;
+const uint8_t kAdTypeIncomplete32BitUuids = 0x04;
+const uint8_t kAdTypeComplete32BitUuids = 0x05;
+const uint8_t kAdTypeIncomplete128BitUuids = 0x06;
+const uint8_t kAdTypeComplete128BitUuids = 0x07;
+const uint8_t kAdTypeShortenedLocalName = 0x08;
+const uint8_t kAdTypeCompleteLocalName = 0x09;
+
 }  // namespace
 
+// Fields of a scan record that scan filters match against. Built at most once
+// per scan result, the first time a client with filters needs it, and shared
+// by all clients.
+class ScanRecordIndex {
+ public:
+  explicit ScanRecordIndex(const ScanResult& scan_result)
+      : scan_result_(scan_result), parsed_(false), has_name_(false) {}
+
+  bool Matches(const ScanFilter& filter) {
+    if (!filter.device_address().empty() &&
+        strcasecmp(filter.device_address().c_str(),
+                   scan_result_.device_address().c_str()))
+      return false;
+
+    Parse();
+    if (!filter.device_name().empty() &&
+        (!has_name_ || local_name_ != filter.device_name()))
+      return false;
+
+    const Uuid* uuid = filter.service_uuid();
+    if (uuid) {
+      const Uuid* mask = filter.service_uuid_mask();
+      if (std::none_of(service_uuids_.begin(), service_uuids_.end(),
+                       [uuid, mask](const Uuid& advertised) {
+                         return UuidMatches(*uuid, mask, advertised);
+                       }))
+        return false;
+    }
+    return true;
+  }
+
+ private:
+  static bool UuidMatches(const Uuid& uuid, const Uuid* mask,
+                          const Uuid& advertised) {
+    if (!mask) return uuid == advertised;
+    const Uuid::UUID128Bit& a = uuid.To128BitBE();
+    const Uuid::UUID128Bit& b = advertised.To128BitBE();
+    const Uuid::UUID128Bit& m = mask->To128BitBE();
+    for (size_t i = 0; i < a.size(); i++) {
+      if ((a[i] ^ b[i]) & m[i]) return false;
+    }
+    return true;
+  }
+
+  void Parse() {
+    if (parsed_) return;
+    parsed_ = true;
+
+    const std::vector<uint8_t>& record = scan_result_.scan_record();
+    size_t i = 0;
+    while (i < record.size() && record[i] != 0) {
+      size_t field_len = record[i];
+      if (i + 1 + field_len > record.size()) break;
+      uint8_t type = record[i + 1];
+      const uint8_t* data = record.data() + i + 2;
+      size_t data_len = field_len - 1;
+
+      switch (type) {
+        case kAdTypeIncomplete16BitUuids:
+        case kAdTypeComplete16BitUuids:
+          for (size_t j = 0; j + 2 <= data_len; j += 2)
+            service_uuids_.push_back(
+                Uuid::From16Bit(data[j] | (data[j + 1] << 8)));
+          break;
+        case kAdTypeIncomplete32BitUuids:
+        case kAdTypeComplete32BitUuids:
+          for (size_t j = 0; j + 4 <= data_len; j += 4)
+            service_uuids_.push_back(Uuid::From32Bit(
+                data[j] | (data[j + 1] << 8) | (data[j + 2] << 16) |
+                (static_cast<uint32_t>(data[j + 3]) << 24)));
+          break;
+        case kAdTypeIncomplete128BitUuids:
+        case kAdTypeComplete128BitUuids:
+          for (size_t j = 0; j + Uuid::kNumBytes128 <= data_len;
+               j += Uuid::kNumBytes128)
+            service_uuids_.push_back(Uuid::From128BitLE(data + j));
+          break;
+        case kAdTypeShortenedLocalName:
+        case kAdTypeCompleteLocalName:
+          // A complete name wins over a shortened one
+          if (!has_name_ || type == kAdTypeCompleteLocalName)
+            local_name_.assign(reinterpret_cast<const char*>(data), data_len);
+          has_name_ = true;
+          break;
+        default:
+          break;
+      }
+      i += field_len + 1;
+    }
+  }
+
+  const ScanResult& scan_result_;
+  bool parsed_;
+  bool has_name_;
+  std::string local_name_;
+  std::vector<Uuid> service_uuids_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScanRecordIndex);
+};
+
+// The scanners of a factory. Shared by the factory and its scanners, so
+// either can go away first.
+class ScanResultFanOut {
+ public:
+  ScanResultFanOut() = default;
+
+  void Add(LowEnergyScanner* scanner) {
+    lock_guard<mutex> lock(lock_);
+    scanners_.push_back(scanner);
+  }
+
+  // Waits for a result being delivered to |scanner|.
+  void Remove(LowEnergyScanner* scanner) {
+    lock_guard<mutex> lock(lock_);
+    scanners_.erase(std::remove(scanners_.begin(), scanners_.end(), scanner),
+                    scanners_.end());
+  }
+
+  // Delivers one immutable copy of the result, and its index, to every
+  // scanner.
+  void Dispatch(const RawAddress& bda, int rssi,
+                const std::vector<uint8_t>& adv_data) {
+    lock_guard<mutex> lock(lock_);
+    if (std::none_of(scanners_.begin(), scanners_.end(),
+                     [](const LowEnergyScanner* scanner) {
+                       return scanner->scan_started_.load();
+                     }))
+      return;
+
+    size_t record_len = GetScanRecordLength(adv_data);
+    std::shared_ptr<const ScanResult> scan_result =
+        std::make_shared<const ScanResult>(
+            BtAddrString(&bda),
+            std::vector<uint8_t>(adv_data.begin(),
+                                 adv_data.begin() + record_len),
+            rssi);
+    ScanRecordIndex index(*scan_result);
+
+    for (LowEnergyScanner* scanner : scanners_)
+      scanner->DeliverScanResult(scan_result, &index);
+  }
+
+ private:
+  mutex lock_;
+  std::vector<LowEnergyScanner*> scanners_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScanResultFanOut);
+};
+
 // LowEnergyScanner implementation
 // ========================================================
 
 LowEnergyScanner::LowEnergyScanner(Adapter& adapter, const Uuid& uuid,
-                                   int scanner_id)
+                                   int scanner_id,
+                                   std::shared_ptr<ScanResultFanOut> fan_out)
     : adapter_(adapter),
       app_identifier_(uuid),
       scanner_id_(scanner_id),
       scan_started_(false),
-      delegate_(nullptr) {}
+      delegate_(nullptr),
+      fan_out_(std::move(fan_out)) {
+  fan_out_->Add(this);
+}
 
 LowEnergyScanner::~LowEnergyScanner() {
   // Automatically unregister the scanner.
   VLOG(1) << "LowEnergyScanner unregistering scanner: " << scanner_id_;
 
-  // Unregister as observer so we no longer receive any callbacks.
-  hal::BluetoothGattInterface::Get()->RemoveScannerObserver(this);
+  // Stop receiving scan results.
+  fan_out_->Remove(this);
 
   hal::BluetoothGattInterface::Get()->GetScannerHALInterface()->Unregister(
       scanner_id_);
@@ -102,6 +269,12 @@ bool LowEnergyScanner::StartScan(const ScanSettings& settings,
     return false;
   }
 
+  {
+    lock_guard<mutex> lock(scan_fields_lock_);
+    scan_settings_ = settings;
+    scan_filters_ = filters;
+  }
+
   // TODO(jpawlowski): Push settings and filtering logic below the HAL.
   bt_status_t status =
       hal::BluetoothGattInterface::Get()->StartScan(scanner_id_);
@@ -137,31 +310,33 @@ const Uuid& LowEnergyScanner::GetAppIdentifier() const {
 
 int LowEnergyScanner::GetInstanceId() const { return scanner_id_; }
 
-void LowEnergyScanner::ScanResultCallback(
-    hal::BluetoothGattInterface* gatt_iface, const RawAddress& bda, int rssi,
-    std::vector<uint8_t> adv_data) {
+void LowEnergyScanner::DeliverScanResult(
+    const std::shared_ptr<const ScanResult>& scan_result,
+    ScanRecordIndex* index) {
   // Ignore scan results if this client didn't start a scan.
   if (!scan_started_.load()) return;
 
+  {
+    lock_guard<mutex> lock(scan_fields_lock_);
+    if (!scan_filters_.empty() &&
+        std::none_of(scan_filters_.begin(), scan_filters_.end(),
+                     [index](const ScanFilter& filter) {
+                       return index->Matches(filter);
+                     }))
+      return;
+  }
+
   lock_guard<mutex> lock(delegate_mutex_);
   if (!delegate_) return;
 
-  // TODO(armansito): Apply software filters here.
-
-  size_t record_len = GetScanRecordLength(adv_data);
-  std::vector<uint8_t> scan_record(adv_data.begin(),
-                                   adv_data.begin() + record_len);
-
-  ScanResult result(BtAddrString(&bda), scan_record, rssi);
-
-  delegate_->OnScanResult(this, result);
+  delegate_->OnSharedScanResult(this, scan_result);
 }
 
 // LowEnergyScannerFactory implementation
 // ========================================================
 
 LowEnergyScannerFactory::LowEnergyScannerFactory(Adapter& adapter)
-    : adapter_(adapter) {
+    : adapter_(adapter), fan_out_(std::make_shared<ScanResultFanOut>()) {
   hal::BluetoothGattInterface::Get()->AddScannerObserver(this);
 }
 
@@ -210,9 +385,7 @@ void LowEnergyScannerFactory::RegisterScannerCallback(
   std::unique_ptr<LowEnergyScanner> scanner;
   BLEStatus result = BLE_STATUS_FAILURE;
   if (status == BT_STATUS_SUCCESS) {
-    scanner.reset(new LowEnergyScanner(adapter_, uuid, scanner_id));
-
-    hal::BluetoothGattInterface::Get()->AddScannerObserver(scanner.get());
+    scanner.reset(new LowEnergyScanner(adapter_, uuid, scanner_id, fan_out_));
 
     result = BLE_STATUS_SUCCESS;
   }
@@ -223,4 +396,10 @@ void LowEnergyScannerFactory::RegisterScannerCallback(
   pending_calls_.erase(iter);
 }
 
+void LowEnergyScannerFactory::ScanResultCallback(
+    hal::BluetoothGattInterface* gatt_iface, const RawAddress& bda, int rssi,
+    std::vector<uint8_t> adv_data) {
+  fan_out_->Dispatch(bda, rssi, adv_data);
+}
+
 }  // namespace bluetooth
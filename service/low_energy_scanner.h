@@ -19,7 +19,9 @@
 #include <atomic>
 #include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 #include <base/macros.h>
 #include <bluetooth/uuid.h>
@@ -36,12 +38,13 @@
 namespace bluetooth {
 
 class Adapter;
+class ScanRecordIndex;
+class ScanResultFanOut;
 
 // A LowEnergyScanner represents an application's handle to perform various
 // Bluetooth Low Energy GAP operations. Instances cannot be created directly and
 // should be obtained through the factory.
-class LowEnergyScanner : private hal::BluetoothGattInterface::ScannerObserver,
-                         public BluetoothInstance {
+class LowEnergyScanner : public BluetoothInstance {
  public:
   // The Delegate interface is used to notify asynchronous events related to LE
   // scan.
@@ -55,6 +58,15 @@ class LowEnergyScanner : private hal::BluetoothGattInterface::ScannerObserver,
     virtual void OnScanResult(LowEnergyScanner* client,
                               const ScanResult& scan_result) = 0;
 
+    // Same as above, for delegates that keep the result beyond the call. The
+    // result is immutable and shared with every other client it is delivered
+    // to, so holding it costs no copy. Defaults to OnScanResult.
+    virtual void OnSharedScanResult(
+        LowEnergyScanner* client,
+        const std::shared_ptr<const ScanResult>& scan_result) {
+      OnScanResult(client, *scan_result);
+    }
+
    private:
     DISALLOW_COPY_AND_ASSIGN(Delegate);
   };
@@ -69,7 +81,8 @@ class LowEnergyScanner : private hal::BluetoothGattInterface::ScannerObserver,
 
   // Initiates a BLE device scan for this client using the given |settings| and
   // |filters|. See the documentation for ScanSettings and ScanFilter for how
-  // these parameters can be configured. Return true on success, false
+  // these parameters can be configured. A result is delivered if |filters| is
+  // empty or it matches any of them. Return true on success, false
   // otherwise. Please see logs for details in case of error.
   bool StartScan(const ScanSettings& settings,
                  const std::vector<ScanFilter>& filters);
@@ -84,16 +97,19 @@ class LowEnergyScanner : private hal::BluetoothGattInterface::ScannerObserver,
   const Uuid& GetAppIdentifier() const override;
   int GetInstanceId() const override;
 
-  void ScanResultCallback(hal::BluetoothGattInterface* gatt_iface,
-                          const RawAddress& bda, int rssi,
-                          std::vector<uint8_t> adv_data) override;
-
  private:
   friend class LowEnergyScannerFactory;
+  friend class ScanResultFanOut;
 
   // Constructor shouldn't be called directly as instances are meant to be
   // obtained from the factory.
-  LowEnergyScanner(Adapter& adapter, const Uuid& uuid, int scanner_id);
+  LowEnergyScanner(Adapter& adapter, const Uuid& uuid, int scanner_id,
+                   std::shared_ptr<ScanResultFanOut> fan_out);
+
+  // Delivers |scan_result| to the delegate if a scan is in progress and the
+  // result passes the scan filters, which are evaluated against |index|.
+  void DeliverScanResult(const std::shared_ptr<const ScanResult>& scan_result,
+                         ScanRecordIndex* index);
 
   // Calls and clears the pending callbacks.
   void InvokeAndClearStartCallback(BLEStatus status);
@@ -109,8 +125,9 @@ class LowEnergyScanner : private hal::BluetoothGattInterface::ScannerObserver,
   // Protects device scan related members below.
   std::mutex scan_fields_lock_;
 
-  // Current scan settings.
+  // Current scan settings and filters.
   ScanSettings scan_settings_;
+  std::vector<ScanFilter> scan_filters_;
 
   // If true, then this client have a BLE device scan in progress.
   std::atomic_bool scan_started_;
@@ -120,6 +137,9 @@ class LowEnergyScanner : private hal::BluetoothGattInterface::ScannerObserver,
   std::mutex delegate_mutex_;
   Delegate* delegate_;
 
+  // Shared with the factory, which fans scan results out through it.
+  std::shared_ptr<ScanResultFanOut> fan_out_;
+
   DISALLOW_COPY_AND_ASSIGN(LowEnergyScanner);
 };
 
@@ -144,6 +164,10 @@ class LowEnergyScannerFactory
   friend class LowEnergyScanner;
 
   // BluetoothGattInterface::ScannerObserver overrides:
+  void ScanResultCallback(hal::BluetoothGattInterface* gatt_iface,
+                          const RawAddress& bda, int rssi,
+                          std::vector<uint8_t> adv_data) override;
+
   void RegisterScannerCallback(const RegisterCallback& callback,
                                const Uuid& app_uuid, uint8_t scanner_id,
                                uint8_t status);
@@ -155,6 +179,10 @@ class LowEnergyScannerFactory
   // Raw pointer to the Adapter that owns this factory.
   Adapter& adapter_;
 
+  // Scanners created by this factory. The factory is the only scan result
+  // observer of the HAL; each result is parsed once and fanned out to them.
+  std::shared_ptr<ScanResultFanOut> fan_out_;
+
   DISALLOW_COPY_AND_ASSIGN(LowEnergyScannerFactory);
 };
 
@@ -0,0 +1,139 @@
+//
+//  Copyright (C) 2026 The Android Open Source Project
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at:
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include <poll.h>
+#include <unistd.h>
+
+#include <memory>
+#include <vector>
+
+#include <base/files/scoped_file.h>
+#include <gtest/gtest.h>
+
+#include "service/ipc/linux_event_ring.h"
+
+namespace ipc {
+namespace {
+
+// Maps the daemon's ring a second time, the way a client would.
+std::unique_ptr<EventRing> AttachClient(const EventRing& ring) {
+  return EventRing::Attach(base::ScopedFD(dup(ring.memory_fd())),
+                           base::ScopedFD(dup(ring.doorbell_fd())));
+}
+
+bool DoorbellSignaled(const EventRing& ring) {
+  struct pollfd pfd = {ring.doorbell_fd(), POLLIN, 0};
+  return poll(&pfd, 1, 0) == 1;
+}
+
+TEST(EventRingTest, WriteAndRead) {
+  std::unique_ptr<EventRing> ring = EventRing::Create(1);
+  ASSERT_NE(nullptr, ring);
+  EXPECT_EQ(4096u, ring->capacity());
+  std::unique_ptr<EventRing> client = AttachClient(*ring);
+  ASSERT_NE(nullptr, client);
+
+  const std::vector<uint8_t> first = {1, 2, 3};
+  const std::vector<uint8_t> second = {4, 5, 6, 7, 8};
+  EXPECT_TRUE(ring->Write(EventRing::kEventScanResult, first.data(),
+                          first.size()));
+  EXPECT_TRUE(ring->Write(7, second.data(), second.size()));
+  EXPECT_TRUE(DoorbellSignaled(*client));
+  client->ClearDoorbell();
+  EXPECT_FALSE(DoorbellSignaled(*client));
+
+  uint16_t type;
+  std::vector<uint8_t> payload;
+  ASSERT_TRUE(client->Read(&type, &payload));
+  EXPECT_EQ(EventRing::kEventScanResult, type);
+  EXPECT_EQ(first, payload);
+  ASSERT_TRUE(client->Read(&type, &payload));
+  EXPECT_EQ(7, type);
+  EXPECT_EQ(second, payload);
+  EXPECT_FALSE(client->Read(&type, &payload));
+}
+
+TEST(EventRingTest, DoorbellOnlyWhenEmpty) {
+  std::unique_ptr<EventRing> ring = EventRing::Create(4096);
+  ASSERT_NE(nullptr, ring);
+  const uint8_t byte = 0;
+
+  EXPECT_TRUE(ring->Write(1, &byte, 1));
+  ring->ClearDoorbell();
+  // The client hasn't caught up, no need to wake it again
+  EXPECT_TRUE(ring->Write(1, &byte, 1));
+  EXPECT_FALSE(DoorbellSignaled(*ring));
+
+  uint16_t type;
+  std::vector<uint8_t> payload;
+  while (ring->Read(&type, &payload)) {
+  }
+  EXPECT_TRUE(ring->Write(1, &byte, 1));
+  EXPECT_TRUE(DoorbellSignaled(*ring));
+}
+
+TEST(EventRingTest, DropsWhenFull) {
+  std::unique_ptr<EventRing> ring = EventRing::Create(4096);
+  ASSERT_NE(nullptr, ring);
+  std::vector<uint8_t> event(1020, 0xaa);
+
+  // Four events of 1024 bytes with their headers fill the ring
+  for (int i = 0; i < 4; i++)
+    EXPECT_TRUE(ring->Write(1, event.data(), event.size()));
+  EXPECT_FALSE(ring->Write(1, event.data(), 1));
+  EXPECT_EQ(1u, ring->dropped());
+
+  std::vector<uint8_t> too_large(EventRing::kMaxPayloadLength + 1);
+  EXPECT_FALSE(ring->Write(1, too_large.data(), too_large.size()));
+  EXPECT_EQ(2u, ring->dropped());
+}
+
+TEST(EventRingTest, EventsWrapAround) {
+  std::unique_ptr<EventRing> ring = EventRing::Create(4096);
+  ASSERT_NE(nullptr, ring);
+  std::unique_ptr<EventRing> client = AttachClient(*ring);
+  ASSERT_NE(nullptr, client);
+
+  // Events of 1000 bytes don't divide the ring, so some of them skip its end
+  uint16_t type;
+  std::vector<uint8_t> payload;
+  for (int i = 0; i < 100; i++) {
+    std::vector<uint8_t> event(996, static_cast<uint8_t>(i));
+    ASSERT_TRUE(ring->Write(1, event.data(), event.size()));
+    ASSERT_TRUE(ring->Write(2, event.data(), event.size()));
+    ASSERT_TRUE(client->Read(&type, &payload));
+    EXPECT_EQ(1, type);
+    EXPECT_EQ(event, payload);
+    ASSERT_TRUE(client->Read(&type, &payload));
+    EXPECT_EQ(2, type);
+    EXPECT_EQ(event, payload);
+  }
+  EXPECT_FALSE(client->Read(&type, &payload));
+  EXPECT_EQ(0u, ring->dropped());
+}
+
+TEST(EventRingTest, AttachRejectsOtherMemory) {
+  base::ScopedFD pipe_fds[2];
+  int fds[2];
+  ASSERT_EQ(0, pipe(fds));
+  pipe_fds[0].reset(fds[0]);
+  pipe_fds[1].reset(fds[1]);
+  EXPECT_EQ(nullptr, EventRing::Attach(std::move(pipe_fds[0]),
+                                       std::move(pipe_fds[1])));
+}
+
+}  // namespace
+}  // namespace ipc
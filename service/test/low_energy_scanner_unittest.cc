@@ -106,6 +106,33 @@ class TestDelegate : public LowEnergyScanner::Delegate {
   DISALLOW_COPY_AND_ASSIGN(TestDelegate);
 };
 
+// Keeps the shared result to check that clients get the same object.
+class SharingDelegate : public LowEnergyScanner::Delegate {
+ public:
+  SharingDelegate() = default;
+  ~SharingDelegate() override = default;
+
+  const std::shared_ptr<const ScanResult>& last_scan_result() const {
+    return last_scan_result_;
+  }
+
+  void OnScanResult(LowEnergyScanner* scanner,
+                    const ScanResult& scan_result) override {
+    FAIL() << "OnSharedScanResult is overridden";
+  }
+
+  void OnSharedScanResult(
+      LowEnergyScanner* scanner,
+      const std::shared_ptr<const ScanResult>& scan_result) override {
+    last_scan_result_ = scan_result;
+  }
+
+ private:
+  std::shared_ptr<const ScanResult> last_scan_result_;
+
+  DISALLOW_COPY_AND_ASSIGN(SharingDelegate);
+};
+
 class LowEnergyScannerTest : public ::testing::Test {
  public:
   LowEnergyScannerTest() = default;
@@ -345,5 +372,82 @@ TEST_F(LowEnergyScannerPostRegisterTest, ScanRecord) {
   le_scanner_->SetDelegate(nullptr);
 }
 
+TEST_F(LowEnergyScannerPostRegisterTest, ScanResultSharedAcrossScanners) {
+  std::unique_ptr<LowEnergyScanner> second_scanner;
+  RegisterTestScanner([&](std::unique_ptr<LowEnergyScanner> scanner) {
+    second_scanner = std::move(scanner);
+  });
+
+  SharingDelegate delegate0;
+  SharingDelegate delegate1;
+  le_scanner_->SetDelegate(&delegate0);
+  second_scanner->SetDelegate(&delegate1);
+
+  EXPECT_CALL(mock_adapter_, IsEnabled()).WillRepeatedly(Return(true));
+  EXPECT_CALL(*mock_handler_, Scan(_)).WillRepeatedly(Return());
+  ScanSettings settings;
+  std::vector<ScanFilter> filters;
+  ASSERT_TRUE(le_scanner_->StartScan(settings, filters));
+  ASSERT_TRUE(second_scanner->StartScan(settings, filters));
+
+  const RawAddress kTestAddress = {{0x01, 0x02, 0x03, 0x0A, 0x0B, 0x0C}};
+  fake_hal_gatt_iface_->NotifyScanResultCallback(
+      kTestAddress, 64, std::vector<uint8_t>({0x02, 0x01, 0x06, 0x00}));
+  ASSERT_TRUE(delegate0.last_scan_result());
+  EXPECT_EQ(delegate0.last_scan_result().get(),
+            delegate1.last_scan_result().get());
+  EXPECT_EQ(3U, delegate0.last_scan_result()->scan_record().size());
+
+  EXPECT_CALL(*mock_handler_, Unregister(_)).Times(1).WillOnce(Return());
+  second_scanner.reset();
+  le_scanner_->SetDelegate(nullptr);
+}
+
+TEST_F(LowEnergyScannerPostRegisterTest, ScanFilters) {
+  TestDelegate delegate;
+  le_scanner_->SetDelegate(&delegate);
+
+  EXPECT_CALL(mock_adapter_, IsEnabled()).WillRepeatedly(Return(true));
+  EXPECT_CALL(*mock_handler_, Scan(_)).WillRepeatedly(Return());
+
+  const RawAddress kTestAddress = {{0x01, 0x02, 0x03, 0x0A, 0x0B, 0x0C}};
+  const std::vector<uint8_t> kHeartRateRecord(
+      {0x03, 0x03, 0x0D, 0x18, 0x03, 0x09, 'h', 'r', 0x00});
+  const std::vector<uint8_t> kBatteryRecord(
+      {0x03, 0x03, 0x0F, 0x18, 0x03, 0x08, 'b', 'a', 0x00});
+
+  ScanSettings settings;
+  ScanFilter uuid_filter;
+  uuid_filter.SetServiceUuid(Uuid::From16Bit(0x180D));
+  ASSERT_TRUE(le_scanner_->StartScan(settings, {uuid_filter}));
+  fake_hal_gatt_iface_->NotifyScanResultCallback(kTestAddress, 64,
+                                                 kHeartRateRecord);
+  EXPECT_EQ(1, delegate.scan_result_count());
+  fake_hal_gatt_iface_->NotifyScanResultCallback(kTestAddress, 64,
+                                                 kBatteryRecord);
+  EXPECT_EQ(1, delegate.scan_result_count());
+
+  // Any of the filters may match
+  ScanFilter name_filter;
+  name_filter.set_device_name("ba");
+  ASSERT_TRUE(le_scanner_->StartScan(settings, {uuid_filter, name_filter}));
+  fake_hal_gatt_iface_->NotifyScanResultCallback(kTestAddress, 64,
+                                                 kBatteryRecord);
+  EXPECT_EQ(2, delegate.scan_result_count());
+
+  ScanFilter address_filter;
+  ASSERT_TRUE(address_filter.SetDeviceAddress("01:02:03:0a:0b:0c"));
+  address_filter.set_device_name("hr");
+  ASSERT_TRUE(le_scanner_->StartScan(settings, {address_filter}));
+  fake_hal_gatt_iface_->NotifyScanResultCallback(kTestAddress, 64,
+                                                 kHeartRateRecord);
+  EXPECT_EQ(3, delegate.scan_result_count());
+  fake_hal_gatt_iface_->NotifyScanResultCallback(kTestAddress, 64,
+                                                 kBatteryRecord);
+  EXPECT_EQ(3, delegate.scan_result_count());
+
+  le_scanner_->SetDelegate(nullptr);
+}
+
 }  // namespace
 }  // namespace bluetooth
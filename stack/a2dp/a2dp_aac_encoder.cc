@@ -37,12 +37,8 @@
 // A2DP AAC encoder interval in milliseconds
 #define A2DP_AAC_ENCODER_INTERVAL_MS 20
 
-// offset
-#if (BTA_AV_CO_CP_SCMS_T == TRUE)
-#define A2DP_AAC_OFFSET (AVDT_MEDIA_OFFSET + 1)
-#else
-#define A2DP_AAC_OFFSET AVDT_MEDIA_OFFSET
-#endif
+// offset, covering the content protection header as well
+#define A2DP_AAC_OFFSET AVDT_MEDIA_HEADROOM(0)
 
 typedef struct {
   uint32_t sample_rate;
@@ -84,6 +80,11 @@ typedef struct {
 
   HANDLE_AACENCODER aac_handle;
   bool has_aac_handle;  // True if aac_handle is valid
+  // The handle outlives a single session: it is only closed when the encoder
+  // is unloaded or cleaned up. These count how often it had to be opened and
+  // how often a (re)started session could pick up the existing one.
+  size_t aac_handle_open_count;
+  size_t aac_handle_reuse_count;
 
   tA2DP_FEEDING_PARAMS feeding_params;
   tA2DP_AAC_ENCODER_PARAMS aac_encoder_params;
@@ -127,9 +128,36 @@ void a2dp_aac_encoder_init(const tA2DP_ENCODER_INIT_PEER_PARAMS* p_peer_params,
     LOG_INFO(LOG_TAG,"aac is running offload mode");
     return;
   }
-  if (a2dp_aac_encoder_cb.has_aac_handle)
-    aacEncClose(&a2dp_aac_encoder_cb.aac_handle);
+  // Keep the encoder handle across a stream restart: opening a new one
+  // allocates and initializes the whole FDK instance, which is the bulk of
+  // the start-of-stream latency after a resume. Only the internal state and
+  // the input buffer are reset, so no samples of the previous session leak
+  // into the new one. The parameters are re-applied below, and the library
+  // only re-runs the parts of its setup that depend on what changed.
+  HANDLE_AACENCODER aac_handle = a2dp_aac_encoder_cb.aac_handle;
+  bool has_aac_handle = a2dp_aac_encoder_cb.has_aac_handle;
+  size_t aac_handle_open_count = a2dp_aac_encoder_cb.aac_handle_open_count;
+  size_t aac_handle_reuse_count = a2dp_aac_encoder_cb.aac_handle_reuse_count;
+  if (has_aac_handle) {
+    AACENC_ERROR aac_error =
+        aacEncoder_SetParam(aac_handle, AACENC_CONTROL_STATE,
+                            AACENC_INIT_STATES | AACENC_RESET_INBUFFER);
+    if (aac_error == AACENC_OK) {
+      aac_handle_reuse_count++;
+    } else {
+      LOG_WARN(LOG_TAG,
+               "%s: Cannot reset the AAC encoder state: AAC error 0x%x, "
+               "reopening the handle",
+               __func__, aac_error);
+      aacEncClose(&aac_handle);
+      has_aac_handle = false;
+    }
+  }
   memset(&a2dp_aac_encoder_cb, 0, sizeof(a2dp_aac_encoder_cb));
+  a2dp_aac_encoder_cb.aac_handle = aac_handle;
+  a2dp_aac_encoder_cb.has_aac_handle = has_aac_handle;
+  a2dp_aac_encoder_cb.aac_handle_open_count = aac_handle_open_count;
+  a2dp_aac_encoder_cb.aac_handle_reuse_count = aac_handle_reuse_count;
 
   a2dp_aac_encoder_cb.stats.session_start_us = time_get_os_boottime_us();
 
@@ -202,6 +230,7 @@ static void a2dp_aac_encoder_update(uint16_t peer_mtu,
       return;  // TODO: Return an error?
     }
     a2dp_aac_encoder_cb.has_aac_handle = true;
+    a2dp_aac_encoder_cb.aac_handle_open_count++;
   }
 
   if (!a2dp_codec_config->copyOutOtaCodecConfig(codec_info)) {
@@ -639,9 +668,7 @@ static void a2dp_aac_encode_frames(uint8_t nb_frame) {
   int written = 0;
 
   while (nb_frame) {
-    BT_HDR* p_buf = (BT_HDR*)osi_malloc(BT_DEFAULT_BUFFER_SIZE);
-    p_buf->offset = A2DP_AAC_OFFSET;
-    p_buf->len = 0;
+    BT_HDR* p_buf = AVDT_MediaBufAlloc(BT_DEFAULT_BUFFER_SIZE, 0);
     p_buf->layer_specific = 0;
     a2dp_aac_encoder_cb.stats.media_read_total_expected_packets++;
 
@@ -767,4 +794,10 @@ void A2dpCodecConfigAac::debug_codec_dump(int fd) {
           "%zu\n",
           stats->media_read_total_expected_read_bytes,
           stats->media_read_total_actual_read_bytes);
+
+  dprintf(fd,
+          "  Encoder handle (opened/reused)                          : %zu / "
+          "%zu\n",
+          a2dp_aac_encoder_cb.aac_handle_open_count,
+          a2dp_aac_encoder_cb.aac_handle_reuse_count);
 }
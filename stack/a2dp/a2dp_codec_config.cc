@@ -59,6 +59,10 @@
 
 #include "a2dp_codec_api.h"
 
+#include <algorithm>
+#include <future>
+#include <map>
+
 #include <base/logging.h>
 #include <inttypes.h>
 #include <utils/Log.h>
@@ -71,6 +75,10 @@
 #include "a2dp_vendor_aptx_hd.h"
 #include "a2dp_vendor_aptx_adaptive.h"
 #include "a2dp_vendor_ldac.h"
+#include "a2dp_vendor_aptx_adaptive_encoder.h"
+#include "a2dp_vendor_aptx_encoder.h"
+#include "a2dp_vendor_aptx_hd_encoder.h"
+#include "a2dp_vendor_ldac_encoder.h"
 #include "osi/include/log.h"
 #include "a2dp_vendor_aptx_tws.h"
 #include "device/include/controller.h"
@@ -142,6 +150,14 @@ A2dpCodecConfig::A2dpCodecConfig(btav_a2dp_codec_index_t codec_index,
   memset(ota_codec_config_, 0, sizeof(ota_codec_config_));
   memset(ota_codec_peer_capability_, 0, sizeof(ota_codec_peer_capability_));
   memset(ota_codec_peer_config_, 0, sizeof(ota_codec_peer_config_));
+
+  memset(negotiated_peer_codec_info_, 0, sizeof(negotiated_peer_codec_info_));
+  memset(negotiated_result_codec_config_, 0,
+         sizeof(negotiated_result_codec_config_));
+  init_btav_a2dp_codec_config(&negotiated_user_config_, codec_index_,
+                              BTAV_A2DP_CODEC_PRIORITY_DEFAULT);
+  init_btav_a2dp_codec_config(&negotiated_audio_config_, codec_index_,
+                              BTAV_A2DP_CODEC_PRIORITY_DEFAULT);
 }
 
 A2dpCodecConfig::~A2dpCodecConfig() {}
@@ -156,6 +172,7 @@ void A2dpCodecConfig::setCodecPriority(
   }
   LOG_DEBUG(LOG_TAG, "%s: codec_priority_: %d", __func__, codec_priority_);
   codec_config_.codec_priority = codec_priority_;
+  invalidateNegotiation();
 }
 
 void A2dpCodecConfig::setDefaultCodecPriority() {
@@ -170,6 +187,158 @@ void A2dpCodecConfig::setDefaultCodecPriority() {
   }
   LOG_DEBUG(LOG_TAG, "%s: codec_priority_: %d", __func__, codec_priority_);
   codec_config_.codec_priority = codec_priority_;
+  invalidateNegotiation();
+}
+
+// Compares every field of |lhs| and |rhs|. The struct has padding, so it
+// cannot be compared with memcmp().
+static bool codec_config_equals(const btav_a2dp_codec_config_t& lhs,
+                                const btav_a2dp_codec_config_t& rhs) {
+  return (lhs.codec_type == rhs.codec_type) &&
+         (lhs.codec_priority == rhs.codec_priority) &&
+         (lhs.sample_rate == rhs.sample_rate) &&
+         (lhs.bits_per_sample == rhs.bits_per_sample) &&
+         (lhs.channel_mode == rhs.channel_mode) &&
+         (lhs.codec_specific_1 == rhs.codec_specific_1) &&
+         (lhs.codec_specific_2 == rhs.codec_specific_2) &&
+         (lhs.codec_specific_3 == rhs.codec_specific_3) &&
+         (lhs.codec_specific_4 == rhs.codec_specific_4);
+}
+
+// Returns the length of the A2DP codec information |p_codec_info|,
+// including the length octet, capped to AVDT_CODEC_SIZE.
+static size_t codec_info_length(const uint8_t* p_codec_info) {
+  size_t length = p_codec_info[0] + 1;
+  return std::min(length, static_cast<size_t>(AVDT_CODEC_SIZE));
+}
+
+bool A2dpCodecConfig::negotiateCodecConfig(const uint8_t* p_peer_codec_info,
+                                           bool is_capability,
+                                           uint8_t* p_result_codec_config) {
+  std::lock_guard<std::recursive_mutex> lock(codec_mutex_);
+  size_t length = codec_info_length(p_peer_codec_info);
+
+  if (negotiation_valid_ && negotiated_is_capability_ == is_capability &&
+      codec_info_length(negotiated_peer_codec_info_) == length &&
+      memcmp(negotiated_peer_codec_info_, p_peer_codec_info, length) == 0 &&
+      codec_config_equals(negotiated_user_config_, codec_user_config_) &&
+      codec_config_equals(negotiated_audio_config_, codec_audio_config_)) {
+    LOG_DEBUG(LOG_TAG, "%s: %s: reusing the negotiated config", __func__,
+              name().c_str());
+    memcpy(p_result_codec_config, negotiated_result_codec_config_,
+           AVDT_CODEC_SIZE);
+    negotiation_reuse_count_++;
+    return true;
+  }
+
+  invalidateNegotiation();
+  negotiation_run_count_++;
+  if (!setCodecConfig(p_peer_codec_info, is_capability,
+                      p_result_codec_config)) {
+    return false;
+  }
+
+  memset(negotiated_peer_codec_info_, 0, sizeof(negotiated_peer_codec_info_));
+  memcpy(negotiated_peer_codec_info_, p_peer_codec_info, length);
+  memcpy(negotiated_result_codec_config_, p_result_codec_config,
+         AVDT_CODEC_SIZE);
+  negotiated_is_capability_ = is_capability;
+  negotiated_user_config_ = codec_user_config_;
+  negotiated_audio_config_ = codec_audio_config_;
+  negotiation_valid_ = true;
+  return true;
+}
+
+void A2dpCodecConfig::invalidateNegotiation() {
+  negotiation_valid_ = false;
+  state_generation_++;
+}
+
+// Creates a codec config of type |T| with priority |codec_priority|.
+template <typename T>
+static A2dpCodecConfig* create_codec_config(
+    btav_a2dp_codec_priority_t codec_priority) {
+  return new T(codec_priority);
+}
+
+// An entry of the codec registry.
+// |load_library| loads the library the codec's init() depends on, or is
+// nullptr if the codec is statically linked.
+typedef struct {
+  btav_a2dp_codec_index_t codec_index;
+  A2dpCodecConfig* (*create)(btav_a2dp_codec_priority_t codec_priority);
+  bool (*load_library)(void);
+} tA2DP_CODEC_FACTORY;
+
+// The codec registry, keyed by codec index. Add an entry for each
+// vendor-specific codec.
+static constexpr tA2DP_CODEC_FACTORY a2dp_codec_factories[] = {
+    {BTAV_A2DP_CODEC_INDEX_SOURCE_SBC, create_codec_config<A2dpCodecConfigSbc>,
+     nullptr},
+    {BTAV_A2DP_CODEC_INDEX_SINK_SBC,
+     create_codec_config<A2dpCodecConfigSbcSink>, nullptr},
+    {BTAV_A2DP_CODEC_INDEX_SOURCE_AAC, create_codec_config<A2dpCodecConfigAac>,
+     nullptr},
+    {BTAV_A2DP_CODEC_INDEX_SOURCE_APTX,
+     create_codec_config<A2dpCodecConfigAptx>, A2DP_VendorLoadEncoderAptx},
+    {BTAV_A2DP_CODEC_INDEX_SOURCE_APTX_HD,
+     create_codec_config<A2dpCodecConfigAptxHd>, A2DP_VendorLoadEncoderAptxHd},
+    {BTAV_A2DP_CODEC_INDEX_SOURCE_APTX_ADAPTIVE,
+     create_codec_config<A2dpCodecConfigAptxAdaptive>,
+     A2DP_VendorLoadEncoderAptxAdaptive},
+    {BTAV_A2DP_CODEC_INDEX_SOURCE_LDAC,
+     create_codec_config<A2dpCodecConfigLdac>, A2DP_VendorLoadEncoderLdac},
+    {BTAV_A2DP_CODEC_INDEX_SOURCE_APTX_TWS,
+     create_codec_config<A2dpCodecConfigAptxTWS>, nullptr},
+};
+
+static const tA2DP_CODEC_FACTORY* a2dp_find_codec_factory(
+    btav_a2dp_codec_index_t codec_index) {
+  for (const auto& factory : a2dp_codec_factories) {
+    if (factory.codec_index == codec_index) return &factory;
+  }
+  return nullptr;
+}
+
+// The library loads started by A2DP_LoadCodecLibraries(), keyed by codec
+// index
+static std::mutex codec_library_mutex;
+static std::map<btav_a2dp_codec_index_t, std::shared_future<bool>>
+    codec_library_loads;
+
+// Waits for the library load of |codec_index| started by
+// A2DP_LoadCodecLibraries(), if any. The codec's init() calls the same
+// loader, so it must not run while the load is still in progress.
+static void a2dp_wait_codec_library(btav_a2dp_codec_index_t codec_index) {
+  std::shared_future<bool> load;
+  {
+    std::lock_guard<std::mutex> lock(codec_library_mutex);
+    auto iter = codec_library_loads.find(codec_index);
+    if (iter == codec_library_loads.end()) return;
+    load = iter->second;
+  }
+  if (!load.get()) {
+    LOG_WARN(LOG_TAG, "%s: cannot load the library of codec %s", __func__,
+             A2DP_CodecIndexStr(codec_index));
+  }
+}
+
+void A2DP_LoadCodecLibraries(void) {
+  std::lock_guard<std::mutex> lock(codec_library_mutex);
+  for (const auto& factory : a2dp_codec_factories) {
+    if (factory.load_library == nullptr) continue;
+    if (!A2DP_IsCodecEnabledInSoftware(factory.codec_index)) continue;
+
+    // A load started by an earlier call must finish before the loader runs
+    // again.
+    auto iter = codec_library_loads.find(factory.codec_index);
+    if (iter != codec_library_loads.end()) iter->second.wait();
+
+    LOG_DEBUG(LOG_TAG, "%s: loading codec %s", __func__,
+              A2DP_CodecIndexStr(factory.codec_index));
+    codec_library_loads[factory.codec_index] =
+        std::async(std::launch::async, factory.load_library).share();
+  }
 }
 
 A2dpCodecConfig* A2dpCodecConfig::createCodec(
@@ -177,39 +346,11 @@ A2dpCodecConfig* A2dpCodecConfig::createCodec(
     btav_a2dp_codec_priority_t codec_priority) {
   LOG_DEBUG(LOG_TAG, "%s: codec %s", __func__, A2DP_CodecIndexStr(codec_index));
 
-  A2dpCodecConfig* codec_config = nullptr;
-  switch (codec_index) {
-    case BTAV_A2DP_CODEC_INDEX_SOURCE_SBC:
-      codec_config = new A2dpCodecConfigSbc(codec_priority);
-      break;
-    case BTAV_A2DP_CODEC_INDEX_SINK_SBC:
-      codec_config = new A2dpCodecConfigSbcSink(codec_priority);
-      break;
-    case BTAV_A2DP_CODEC_INDEX_SOURCE_AAC:
-      codec_config = new A2dpCodecConfigAac(codec_priority);
-      break;
-    case BTAV_A2DP_CODEC_INDEX_SOURCE_APTX:
-      codec_config = new A2dpCodecConfigAptx(codec_priority);
-      break;
-    case BTAV_A2DP_CODEC_INDEX_SOURCE_APTX_HD:
-      codec_config = new A2dpCodecConfigAptxHd(codec_priority);
-      break;
-    case BTAV_A2DP_CODEC_INDEX_SOURCE_APTX_ADAPTIVE:
-      codec_config = new A2dpCodecConfigAptxAdaptive(codec_priority);
-      break;
-    case BTAV_A2DP_CODEC_INDEX_SOURCE_LDAC:
-      codec_config = new A2dpCodecConfigLdac(codec_priority);
-      break;
-    case BTAV_A2DP_CODEC_INDEX_SOURCE_APTX_TWS:
-      codec_config = new A2dpCodecConfigAptxTWS(codec_priority);
-      break;
-    // Add a switch statement for each vendor-specific codec
-    case BTAV_A2DP_CODEC_INDEX_MAX:
-      break;
-    default:
-      break;
-  }
+  const tA2DP_CODEC_FACTORY* factory = a2dp_find_codec_factory(codec_index);
+  if (factory == nullptr) return nullptr;
 
+  a2dp_wait_codec_library(codec_index);
+  A2dpCodecConfig* codec_config = factory->create(codec_priority);
   if (codec_config != nullptr) {
     if (!codec_config->init()) {
       delete codec_config;
@@ -422,8 +563,8 @@ bool A2dpCodecConfig::setCodecUserConfig(
   LOG_DEBUG(LOG_TAG, "%s: codec_audio_config_: ", __func__);
   print_codec_parameters(codec_audio_config_);
 
-  bool success =
-      setCodecConfig(p_peer_codec_info, is_capability, p_result_codec_config);
+  bool success = negotiateCodecConfig(p_peer_codec_info, is_capability,
+                                      p_result_codec_config);
   LOG_DEBUG(LOG_TAG, "%s: success: %d, is_capability:%d", __func__, success, is_capability);
   if (!success) {
     // Restore the local copy of the user and audio config
@@ -618,6 +759,9 @@ void A2dpCodecConfig::debug_codec_dump(int fd) {
 
      result = codecConfig2Str(getCodecLocalCapability());
      dprintf(fd, "  Local capability: %s\n", result.c_str());
+
+     dprintf(fd, "  Negotiations (run / reused): %zu / %zu\n",
+             negotiation_run_count_, negotiation_reuse_count_);
   }
 }
 
@@ -743,8 +887,8 @@ bool A2dpCodecs::setCodecConfig(const uint8_t* p_peer_codec_info,
   std::lock_guard<std::recursive_mutex> lock(codec_mutex_);
   A2dpCodecConfig* a2dp_codec_config = findSourceCodecConfig(p_peer_codec_info);
   if (a2dp_codec_config == nullptr) return false;
-  if (!a2dp_codec_config->setCodecConfig(p_peer_codec_info, is_capability,
-                                         p_result_codec_config)) {
+  if (!a2dp_codec_config->negotiateCodecConfig(
+          p_peer_codec_info, is_capability, p_result_codec_config)) {
     LOG_DEBUG(LOG_TAG, "%s: Codec config didn't set, return false", __func__);
     return false;
   }
@@ -1007,14 +1151,42 @@ bool A2dpCodecs::getCodecConfigAndCapabilities(
     *p_codec_config = codec_config;
   }
 
+  // Reuse the capabilities built by the previous query if no codec changed
+  // since, and the codecs are still in the same order.
+  bool cache_valid =
+      capabilities_generations_.size() == ordered_source_codecs_.size();
+  if (cache_valid) {
+    auto generation = capabilities_generations_.begin();
+    for (auto codec : ordered_source_codecs_) {
+      if (generation->first != codec ||
+          generation->second != codec->state_generation_) {
+        cache_valid = false;
+        break;
+      }
+      ++generation;
+    }
+  }
+  if (cache_valid) {
+    *p_codecs_local_capabilities = cached_local_capabilities_;
+    *p_codecs_selectable_capabilities = cached_selectable_capabilities_;
+    return true;
+  }
+
+  capabilities_generations_.clear();
+  for (auto codec : ordered_source_codecs_) {
+    capabilities_generations_.push_back(
+        std::make_pair(codec, codec->state_generation_));
+  }
+
   std::vector<btav_a2dp_codec_config_t> codecs_capabilities;
-  for (auto codec : orderedSourceCodecs()) {
+  for (auto codec : ordered_source_codecs_) {
     codecs_capabilities.push_back(codec->getCodecLocalCapability());
   }
   *p_codecs_local_capabilities = codecs_capabilities;
+  cached_local_capabilities_ = codecs_capabilities;
 
   codecs_capabilities.clear();
-  for (auto codec : orderedSourceCodecs()) {
+  for (auto codec : ordered_source_codecs_) {
     btav_a2dp_codec_config_t codec_capability =
         codec->getCodecSelectableCapability();
     // Don't add entries that cannot be used
@@ -1027,6 +1199,7 @@ bool A2dpCodecs::getCodecConfigAndCapabilities(
     codecs_capabilities.push_back(codec_capability);
   }
   *p_codecs_selectable_capabilities = codecs_capabilities;
+  cached_selectable_capabilities_ = codecs_capabilities;
 
   LOG_DEBUG(LOG_TAG, "%s: Recursive mutex lock released", __func__);
 
@@ -1052,8 +1225,10 @@ void A2dpCodecs::debug_codec_dump(int fd) {
 
 bool A2dpCodecConfig::updateCodecConfig(const btav_a2dp_codec_config_t& update_codec_config,
                          bool audio_update) {
-    if (audio_update == true)
+    if (audio_update == true) {
       codec_config_ = update_codec_config;
+      invalidateNegotiation();
+    }
     LOG_DEBUG(LOG_TAG, "%s: Updated audio config ", __func__);
     return true;
 }
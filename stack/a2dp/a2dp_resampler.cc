@@ -0,0 +1,312 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  Polyphase FIR resampler. The rate ratio is reduced to L/M and a windowed
+ *  sinc low-pass filter is split into L phases of A2DP_RESAMPLER_TAPS taps.
+ *  Each output sample is the dot product of one phase with the most recent
+ *  input samples. The filter runs in 16 bit fixed point with 32 bit sums, so
+ *  the NEON and SSE2 kernels are bit exact with the C code.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "a2dp_resampler"
+
+#include "a2dp_resampler.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "osi/include/allocator.h"
+#include "osi/include/log.h"
+
+#if defined(__aarch64__) || defined(__ARM_NEON)
+#define A2DP_RESAMPLER_NEON
+#include <arm_neon.h>
+#if !defined(__aarch64__)
+#include <sys/auxv.h>
+#ifndef HWCAP_NEON
+#define HWCAP_NEON (1 << 12)
+#endif
+#endif
+#elif defined(__SSE2__)
+#define A2DP_RESAMPLER_SSE2
+#include <emmintrin.h>
+#endif
+
+/* Taps per phase, a multiple of 8 for the vector kernels */
+#define A2DP_RESAMPLER_TAPS 32
+
+/* Largest number of phases, i.e. the largest reduced output rate */
+#define A2DP_RESAMPLER_MAX_PHASES 1024
+
+/* Fractional bits of the filter coefficients */
+#define A2DP_RESAMPLER_COEFF_BITS 14
+
+/* Cutoff relative to the lower of the two Nyquist frequencies */
+#define A2DP_RESAMPLER_ROLLOFF 0.90
+
+/* Kaiser window shape, trades stopband attenuation for transition width */
+#define A2DP_RESAMPLER_KAISER_BETA 8.0
+
+struct a2dp_resampler_t {
+  uint32_t up;       /* L: phases per input sample */
+  uint32_t down;     /* M: phase advance per output sample */
+  uint8_t bits;      /* bits per input sample */
+  uint8_t n_channels;
+  uint32_t phase;    /* phase of the next output sample */
+  uint32_t pending;  /* input samples to consume before the next output */
+  uint32_t pos;      /* next write position in the history */
+  int16_t* coeffs;   /* up * A2DP_RESAMPLER_TAPS, oldest sample first */
+  /* Every sample is stored twice, A2DP_RESAMPLER_TAPS apart, so that the
+   * most recent A2DP_RESAMPLER_TAPS samples are always contiguous. */
+  int16_t history[2][2 * A2DP_RESAMPLER_TAPS];
+};
+
+static bool a2dp_resampler_simd_supported(void) {
+#if defined(A2DP_RESAMPLER_NEON) && defined(__aarch64__)
+  return true;
+#elif defined(A2DP_RESAMPLER_NEON)
+  return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#elif defined(A2DP_RESAMPLER_SSE2)
+  return true;
+#else
+  return false;
+#endif
+}
+
+static bool a2dp_resampler_simd = a2dp_resampler_simd_supported();
+
+void a2dp_resampler_set_simd_enabled(bool enabled) {
+  a2dp_resampler_simd = enabled && a2dp_resampler_simd_supported();
+}
+
+static uint32_t a2dp_resampler_gcd(uint32_t a, uint32_t b) {
+  while (b != 0) {
+    uint32_t t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+/* Zeroth order modified Bessel function of the first kind */
+static double a2dp_resampler_bessel_i0(double x) {
+  double sum = 1.0;
+  double term = 1.0;
+  for (int k = 1; k < 32; k++) {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+    if (term < sum * 1e-12) break;
+  }
+  return sum;
+}
+
+/* Fills |coeffs| with the |up| phases of a Kaiser windowed sinc low-pass
+ * filter. Every phase is normalized to unity gain at DC, so a constant input
+ * gives a constant output whatever the phase. */
+static void a2dp_resampler_design(int16_t* coeffs, uint32_t up,
+                                  uint32_t down) {
+  const uint32_t length = up * A2DP_RESAMPLER_TAPS;
+  const double center = (length - 1) / 2.0;
+  const double cutoff =
+      A2DP_RESAMPLER_ROLLOFF * 0.5 / (up > down ? up : down);
+  const double i0_beta = a2dp_resampler_bessel_i0(A2DP_RESAMPLER_KAISER_BETA);
+  double taps[A2DP_RESAMPLER_TAPS];
+
+  for (uint32_t p = 0; p < up; p++) {
+    double sum = 0.0;
+    for (uint32_t j = 0; j < A2DP_RESAMPLER_TAPS; j++) {
+      /* Tap j multiplies the input A2DP_RESAMPLER_TAPS - 1 - j samples ago */
+      uint32_t n = p + (A2DP_RESAMPLER_TAPS - 1 - j) * up;
+      double t = n - center;
+      double x = 2.0 * cutoff * t;
+      double sinc = (x == 0.0) ? 1.0 : sin(M_PI * x) / (M_PI * x);
+      double r = t / center;
+      double window =
+          a2dp_resampler_bessel_i0(A2DP_RESAMPLER_KAISER_BETA *
+                                   sqrt(r * r < 1.0 ? 1.0 - r * r : 0.0)) /
+          i0_beta;
+      taps[j] = sinc * window;
+      sum += taps[j];
+    }
+
+    /* Quantize, then put the rounding error on the largest tap */
+    int16_t* phase = coeffs + p * A2DP_RESAMPLER_TAPS;
+    int32_t total = 0;
+    uint32_t largest = 0;
+    for (uint32_t j = 0; j < A2DP_RESAMPLER_TAPS; j++) {
+      phase[j] =
+          (int16_t)lrint(taps[j] / sum * (1 << A2DP_RESAMPLER_COEFF_BITS));
+      total += phase[j];
+      if (abs(phase[j]) > abs(phase[largest])) largest = j;
+    }
+    phase[largest] += (1 << A2DP_RESAMPLER_COEFF_BITS) - total;
+  }
+}
+
+a2dp_resampler_t* a2dp_resampler_new(uint32_t src_sps, uint32_t dst_sps,
+                                     uint8_t bits, uint8_t n_channels) {
+  if (src_sps == 0 || dst_sps == 0 || (bits != 8 && bits != 16) ||
+      (n_channels != 1 && n_channels != 2)) {
+    LOG_ERROR(LOG_TAG, "%s: unsupported format %u Hz to %u Hz, %u bits, %u "
+              "channels", __func__, src_sps, dst_sps, bits, n_channels);
+    return NULL;
+  }
+
+  uint32_t gcd = a2dp_resampler_gcd(src_sps, dst_sps);
+  uint32_t up = dst_sps / gcd;
+  uint32_t down = src_sps / gcd;
+  if (up > A2DP_RESAMPLER_MAX_PHASES) {
+    LOG_ERROR(LOG_TAG, "%s: ratio %u/%u needs too many phases", __func__, up,
+              down);
+    return NULL;
+  }
+
+  a2dp_resampler_t* resampler =
+      (a2dp_resampler_t*)osi_calloc(sizeof(a2dp_resampler_t));
+  resampler->up = up;
+  resampler->down = down;
+  resampler->bits = bits;
+  resampler->n_channels = n_channels;
+  resampler->coeffs =
+      (int16_t*)osi_malloc(up * A2DP_RESAMPLER_TAPS * sizeof(int16_t));
+  a2dp_resampler_design(resampler->coeffs, up, down);
+  a2dp_resampler_reset(resampler);
+
+  LOG_INFO(LOG_TAG, "%s: %u Hz to %u Hz, %u phases of %d taps", __func__,
+           src_sps, dst_sps, up, A2DP_RESAMPLER_TAPS);
+  return resampler;
+}
+
+void a2dp_resampler_free(a2dp_resampler_t* resampler) {
+  if (resampler == NULL) return;
+  osi_free(resampler->coeffs);
+  osi_free(resampler);
+}
+
+void a2dp_resampler_reset(a2dp_resampler_t* resampler) {
+  memset(resampler->history, 0, sizeof(resampler->history));
+  resampler->phase = 0;
+  resampler->pending = 1;
+  resampler->pos = 0;
+}
+
+static int32_t a2dp_resampler_dot(const int16_t* coeffs,
+                                  const int16_t* samples) {
+#if defined(A2DP_RESAMPLER_NEON)
+  if (a2dp_resampler_simd) {
+    int32x4_t acc = vdupq_n_s32(0);
+    for (int i = 0; i < A2DP_RESAMPLER_TAPS; i += 8) {
+      int16x8_t c = vld1q_s16(coeffs + i);
+      int16x8_t x = vld1q_s16(samples + i);
+      acc = vmlal_s16(acc, vget_low_s16(c), vget_low_s16(x));
+      acc = vmlal_s16(acc, vget_high_s16(c), vget_high_s16(x));
+    }
+#if defined(__aarch64__)
+    return vaddvq_s32(acc);
+#else
+    int32x2_t sum = vadd_s32(vget_low_s32(acc), vget_high_s32(acc));
+    return vget_lane_s32(vpadd_s32(sum, sum), 0);
+#endif
+  }
+#elif defined(A2DP_RESAMPLER_SSE2)
+  if (a2dp_resampler_simd) {
+    __m128i acc = _mm_setzero_si128();
+    for (int i = 0; i < A2DP_RESAMPLER_TAPS; i += 8) {
+      __m128i c = _mm_loadu_si128((const __m128i*)(coeffs + i));
+      __m128i x = _mm_loadu_si128((const __m128i*)(samples + i));
+      acc = _mm_add_epi32(acc, _mm_madd_epi16(c, x));
+    }
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(acc);
+  }
+#endif
+
+  int32_t acc = 0;
+  for (int i = 0; i < A2DP_RESAMPLER_TAPS; i++)
+    acc += (int32_t)coeffs[i] * samples[i];
+  return acc;
+}
+
+static int16_t a2dp_resampler_output(int32_t acc) {
+  acc = (acc + (1 << (A2DP_RESAMPLER_COEFF_BITS - 1))) >>
+        A2DP_RESAMPLER_COEFF_BITS;
+  if (acc > INT16_MAX) return INT16_MAX;
+  if (acc < INT16_MIN) return INT16_MIN;
+  return (int16_t)acc;
+}
+
+/* Stores one input frame from |p_src| in the history */
+static void a2dp_resampler_push(a2dp_resampler_t* resampler,
+                                const uint8_t* p_src) {
+  for (uint8_t ch = 0; ch < resampler->n_channels; ch++) {
+    int16_t sample;
+    if (resampler->bits == 16) {
+      memcpy(&sample, p_src + ch * sizeof(int16_t), sizeof(int16_t));
+    } else {
+      sample = (int16_t)((p_src[ch] - 0x80) << 8);
+    }
+    resampler->history[ch][resampler->pos] = sample;
+    resampler->history[ch][resampler->pos + A2DP_RESAMPLER_TAPS] = sample;
+  }
+  resampler->pos = (resampler->pos + 1) % A2DP_RESAMPLER_TAPS;
+}
+
+uint32_t a2dp_resampler_process(a2dp_resampler_t* resampler, const void* p_src,
+                                uint32_t src_len, int16_t* p_dst,
+                                uint32_t dst_len, uint32_t* p_src_used) {
+  const uint8_t* p_in = (const uint8_t*)p_src;
+  const uint32_t frame_size = resampler->n_channels * resampler->bits / 8;
+  uint32_t src_frames = src_len / frame_size;
+  uint32_t dst_frames = dst_len / (2 * sizeof(int16_t));
+  int16_t* p_out = p_dst;
+
+  while (dst_frames > 0) {
+    while (resampler->pending > 0 && src_frames > 0) {
+      a2dp_resampler_push(resampler, p_in);
+      p_in += frame_size;
+      src_frames--;
+      resampler->pending--;
+    }
+    if (resampler->pending > 0) break;
+
+    const int16_t* phase =
+        resampler->coeffs + resampler->phase * A2DP_RESAMPLER_TAPS;
+    int16_t left = a2dp_resampler_output(a2dp_resampler_dot(
+        phase, &resampler->history[0][resampler->pos]));
+    int16_t right =
+        (resampler->n_channels == 2)
+            ? a2dp_resampler_output(a2dp_resampler_dot(
+                  phase, &resampler->history[1][resampler->pos]))
+            : left;
+    *p_out++ = left;
+    *p_out++ = right;
+    dst_frames--;
+
+    resampler->phase += resampler->down;
+    resampler->pending = resampler->phase / resampler->up;
+    resampler->phase %= resampler->up;
+  }
+
+  *p_src_used = p_in - (const uint8_t*)p_src;
+  return (p_out - p_dst) * sizeof(int16_t);
+}
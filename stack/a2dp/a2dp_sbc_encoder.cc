@@ -21,11 +21,13 @@
 
 #include "a2dp_sbc_encoder.h"
 
+#include <algorithm>
 #include <limits.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "a2dp_sbc.h"
+#include "a2dp_resampler.h"
 #include "a2dp_sbc_up_sample.h"
 #include "bt_common.h"
 #include <sbc_encoder.h>
@@ -50,6 +52,10 @@
 
 #define A2DP_SBC_MAX_PCM_ITER_NUM_PER_TICK 3
 
+// Max number of SBC frames in one media packet: the frame count in the media
+// payload header is 4 bits wide.
+#define A2DP_SBC_MAX_FRAMES_PER_PACKET 0x0F
+
 #define A2DP_SBC_MAX_HQ_FRAME_SIZE_44_1 119
 #define A2DP_SBC_MAX_HQ_FRAME_SIZE_48 115
 
@@ -60,16 +66,16 @@
 #define A2DP_SBC_FRAME_HEADER_SIZE_BYTES 4  // A2DP Spec v1.3, 12.4, Table 12.12
 #define A2DP_SBC_SCALE_FACTOR_BITS 4        // A2DP Spec v1.3, 12.4, Table 12.13
 
-/* offset */
 #if (BTA_AV_CO_CP_SCMS_T == TRUE)
 /* A2DP header will contain a CP header of size 1 */
 #define A2DP_HDR_SIZE 2
-#define A2DP_SBC_OFFSET (AVDT_MEDIA_OFFSET + A2DP_SBC_MPL_HDR_LEN + 1)
 #else
 #define A2DP_HDR_SIZE 1
-#define A2DP_SBC_OFFSET (AVDT_MEDIA_OFFSET + A2DP_SBC_MPL_HDR_LEN)
 #endif
 
+/* offset, covering the content protection header as well */
+#define A2DP_SBC_OFFSET AVDT_MEDIA_HEADROOM(A2DP_SBC_MPL_HDR_LEN)
+
 typedef struct {
   uint32_t aa_frame_counter;
   int32_t aa_feed_counter;
@@ -106,7 +112,8 @@ typedef struct {
   SBC_ENC_PARAMS sbc_encoder_params;
   tA2DP_FEEDING_PARAMS feeding_params;
   tA2DP_SBC_FEEDING_STATE feeding_state;
-  int16_t pcmBuffer[SBC_MAX_PCM_BUFFER_SIZE];
+  // Holds the PCM data of a whole media packet when no upsampling is needed
+  int16_t pcmBuffer[A2DP_SBC_MAX_FRAMES_PER_PACKET * SBC_MAX_PCM_BUFFER_SIZE];
 
   a2dp_sbc_encoder_stats_t stats;
 } tA2DP_SBC_ENCODER_CB;
@@ -114,6 +121,9 @@ typedef struct {
 bool enc_update_in_progress = FALSE;
 bool tx_enc_update_initiated = FALSE;
 static tA2DP_SBC_ENCODER_CB a2dp_sbc_encoder_cb;
+// Converts the feeding to the SBC sampling rate when they differ. It is kept
+// out of a2dp_sbc_encoder_cb, which is cleared with memset().
+static a2dp_resampler_t* a2dp_sbc_resampler = NULL;
 
 static void a2dp_sbc_encoder_update(uint16_t peer_mtu,
                                     A2dpCodecConfig* a2dp_codec_config,
@@ -122,6 +132,8 @@ static void a2dp_sbc_encoder_update(uint16_t peer_mtu,
                                     bool* p_config_updated);
 static bool a2dp_sbc_read_feeding(uint32_t* bytes);
 static void a2dp_sbc_encode_frames(uint8_t nb_frame);
+static void a2dp_sbc_encode_frames_batch(uint8_t nb_frame);
+static uint32_t a2dp_sbc_sampling_rate(void);
 static void a2dp_sbc_get_num_frame_iteration(uint8_t* num_of_iterations,
                                              uint8_t* num_of_frames,
                                              uint64_t timestamp_us);
@@ -392,6 +404,8 @@ static void a2dp_sbc_encoder_update(uint16_t peer_mtu,
 }
 
 void a2dp_sbc_encoder_cleanup(void) {
+  a2dp_resampler_free(a2dp_sbc_resampler);
+  a2dp_sbc_resampler = NULL;
   memset(&a2dp_sbc_encoder_cb, 0, sizeof(a2dp_sbc_encoder_cb));
 }
 
@@ -404,6 +418,9 @@ void a2dp_sbc_feeding_reset(void) {
   }
   memset(&a2dp_sbc_encoder_cb.feeding_state, 0,
          sizeof(a2dp_sbc_encoder_cb.feeding_state));
+  /* The feeding parameters may have changed, create it again when needed */
+  a2dp_resampler_free(a2dp_sbc_resampler);
+  a2dp_sbc_resampler = NULL;
 
   a2dp_sbc_encoder_cb.feeding_state.bytes_per_tick =
       (a2dp_sbc_encoder_cb.feeding_params.sample_rate *
@@ -424,6 +441,7 @@ void a2dp_sbc_feeding_flush(void) {
   }
   a2dp_sbc_encoder_cb.feeding_state.counter = 0.0f;
   a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue = 0;
+  if (a2dp_sbc_resampler != NULL) a2dp_resampler_reset(a2dp_sbc_resampler);
 }
 
 period_ms_t a2dp_sbc_get_encoder_interval_ms(void) {
@@ -560,18 +578,137 @@ static void a2dp_sbc_get_num_frame_iteration(uint8_t* num_of_iterations,
   *num_of_iterations = noi;
 }
 
+uint32_t a2dp_sbc_encode_batch(const uint8_t* p_pcm, uint32_t pcm_len,
+                               BT_HDR* p_buf) {
+  SBC_ENC_PARAMS* p_encoder_params = &a2dp_sbc_encoder_cb.sbc_encoder_params;
+  uint32_t pcm_bytes_per_frame =
+      p_encoder_params->s16NumOfSubBands * p_encoder_params->s16NumOfBlocks *
+      p_encoder_params->s16NumOfChannels *
+      a2dp_sbc_encoder_cb.feeding_params.bits_per_sample / 8;
+  uint32_t frame_len = a2dp_sbc_frame_length();
+  uint32_t consumed = 0;
+
+  if (pcm_bytes_per_frame == 0 ||
+      a2dp_sbc_sampling_rate() != a2dp_sbc_encoder_cb.feeding_params.sample_rate)
+    return 0;
+
+  // Same packing rule as the per frame path: the first frame always goes in,
+  // then frames are added while the packet stays below the MTU.
+  while ((pcm_len - consumed) >= pcm_bytes_per_frame &&
+         p_buf->layer_specific < A2DP_SBC_MAX_FRAMES_PER_PACKET &&
+         (p_buf->len == 0 ||
+          (p_buf->len + frame_len) < a2dp_sbc_encoder_cb.TxAaMtuSize)) {
+    uint8_t* output = (uint8_t*)(p_buf + 1) + p_buf->offset + p_buf->len;
+    // SBC_Encode() only reads the PCM samples
+    int16_t* input = (int16_t*)(p_pcm + consumed);
+    p_buf->len += SBC_Encode(p_encoder_params, input, output);
+    p_buf->layer_specific++;
+    consumed += pcm_bytes_per_frame;
+  }
+  return consumed;
+}
+
+// Read the PCM data of a whole media packet with a single read and encode
+// it in one go. Only used when the feeding is at the SBC sampling rate.
+static void a2dp_sbc_encode_frames_batch(uint8_t nb_frame) {
+  SBC_ENC_PARAMS* p_encoder_params = &a2dp_sbc_encoder_cb.sbc_encoder_params;
+  tA2DP_SBC_FEEDING_STATE* p_feeding_state = &a2dp_sbc_encoder_cb.feeding_state;
+  uint8_t* p_pcm = (uint8_t*)a2dp_sbc_encoder_cb.pcmBuffer;
+  uint8_t remain_nb_frame = nb_frame;
+  uint16_t blocm_x_subband =
+      p_encoder_params->s16NumOfSubBands * p_encoder_params->s16NumOfBlocks;
+  uint32_t pcm_bytes_per_frame =
+      blocm_x_subband * p_encoder_params->s16NumOfChannels *
+      a2dp_sbc_encoder_cb.feeding_params.bits_per_sample / 8;
+  uint32_t frame_len = a2dp_sbc_frame_length();
+
+  // Number of frames the per frame path would put in one packet
+  uint8_t frames_per_packet = 1;
+  while (frames_per_packet < A2DP_SBC_MAX_FRAMES_PER_PACKET &&
+         ((frames_per_packet + 1) * frame_len) <
+             a2dp_sbc_encoder_cb.TxAaMtuSize)
+    frames_per_packet++;
+
+  while (nb_frame) {
+    uint8_t packet_frames = std::min(nb_frame, frames_per_packet);
+    uint32_t residue = p_feeding_state->aa_feed_residue;
+    uint32_t read_size = packet_frames * pcm_bytes_per_frame - residue;
+
+    a2dp_sbc_encoder_cb.stats.media_read_total_expected_packets++;
+    a2dp_sbc_encoder_cb.stats.media_read_total_expected_reads_count++;
+    a2dp_sbc_encoder_cb.stats.media_read_total_expected_read_bytes += read_size;
+    uint32_t bytes_read =
+        a2dp_sbc_encoder_cb.read_callback(p_pcm + residue, read_size);
+    a2dp_sbc_encoder_cb.stats.media_read_total_actual_read_bytes += bytes_read;
+
+    uint32_t pcm_len = residue + bytes_read;
+    uint8_t read_frames = pcm_len / pcm_bytes_per_frame;
+    if (bytes_read == read_size)
+      a2dp_sbc_encoder_cb.stats.media_read_total_actual_reads_count++;
+
+    BT_HDR* p_buf = NULL;
+    if (read_frames) {
+      p_buf = AVDT_MediaBufAlloc(A2DP_SBC_BUFFER_SIZE, A2DP_SBC_MPL_HDR_LEN);
+      p_buf->layer_specific = 0;
+      a2dp_sbc_encode_batch(p_pcm, read_frames * pcm_bytes_per_frame, p_buf);
+      nb_frame -= read_frames;
+    }
+
+    if (read_frames < packet_frames) {
+      // Keep the partial frame for the next read
+      p_feeding_state->aa_feed_residue =
+          pcm_len - read_frames * pcm_bytes_per_frame;
+      if (read_frames && p_feeding_state->aa_feed_residue)
+        memmove(p_pcm, p_pcm + read_frames * pcm_bytes_per_frame,
+                p_feeding_state->aa_feed_residue);
+      LOG_WARN(LOG_TAG, "%s: underflow %d, %d", __func__, nb_frame,
+               p_feeding_state->aa_feed_residue);
+      p_feeding_state->counter += nb_frame * pcm_bytes_per_frame;
+      /* no more pcm to read */
+      nb_frame = 0;
+    } else {
+      p_feeding_state->aa_feed_residue = 0;
+    }
+
+    if (p_buf == NULL) {
+      a2dp_sbc_encoder_cb.stats.media_read_total_dropped_packets++;
+      continue;
+    }
+
+    /*
+     * Timestamp of the media packet header represent the TS of the
+     * first SBC frame, i.e the timestamp before including this frame.
+     */
+    *((uint32_t*)(p_buf + 1)) = a2dp_sbc_encoder_cb.timestamp;
+
+    a2dp_sbc_encoder_cb.timestamp += p_buf->layer_specific * blocm_x_subband;
+
+    uint8_t done_nb_frame = remain_nb_frame - nb_frame;
+    remain_nb_frame = nb_frame;
+    if (!a2dp_sbc_encoder_cb.enqueue_callback(p_buf, done_nb_frame,
+                                              bytes_read))
+      return;
+  }
+}
+
 static void a2dp_sbc_encode_frames(uint8_t nb_frame) {
   SBC_ENC_PARAMS* p_encoder_params = &a2dp_sbc_encoder_cb.sbc_encoder_params;
   uint8_t remain_nb_frame = nb_frame;
   uint16_t blocm_x_subband =
       p_encoder_params->s16NumOfSubBands * p_encoder_params->s16NumOfBlocks;
 
+  // Without upsampling the PCM data of a packet can be read at once
+  if (a2dp_sbc_sampling_rate() ==
+      a2dp_sbc_encoder_cb.feeding_params.sample_rate) {
+    a2dp_sbc_encode_frames_batch(nb_frame);
+    return;
+  }
+
   uint8_t last_frame_len = 0;
   while (nb_frame) {
-    BT_HDR* p_buf = (BT_HDR*)osi_malloc(A2DP_SBC_BUFFER_SIZE);
+    BT_HDR* p_buf =
+        AVDT_MediaBufAlloc(A2DP_SBC_BUFFER_SIZE, A2DP_SBC_MPL_HDR_LEN);
     uint32_t bytes_read = 0;
-    p_buf->offset = A2DP_SBC_OFFSET;
-    p_buf->len = 0;
     p_buf->layer_specific = 0;
     a2dp_sbc_encoder_cb.stats.media_read_total_expected_packets++;
 
@@ -631,6 +768,21 @@ static void a2dp_sbc_encode_frames(uint8_t nb_frame) {
   }
 }
 
+// Returns the SBC sampling rate of the current configuration.
+static uint32_t a2dp_sbc_sampling_rate(void) {
+  switch (a2dp_sbc_encoder_cb.sbc_encoder_params.s16SamplingFreq) {
+    case SBC_sf44100:
+      return 44100;
+    case SBC_sf32000:
+      return 32000;
+    case SBC_sf16000:
+      return 16000;
+    case SBC_sf48000:
+    default:
+      return 48000;
+  }
+}
+
 static bool a2dp_sbc_read_feeding(uint32_t* bytes_read) {
   SBC_ENC_PARAMS* p_encoder_params = &a2dp_sbc_encoder_cb.sbc_encoder_params;
   uint16_t blocm_x_subband =
@@ -750,23 +902,39 @@ static bool a2dp_sbc_read_feeding(uint32_t* bytes_read) {
   }
   a2dp_sbc_encoder_cb.stats.media_read_total_actual_reads_count++;
 
-  /* Initialize PCM up-sampling engine */
-  a2dp_sbc_init_up_sample(a2dp_sbc_encoder_cb.feeding_params.sample_rate,
-                          sbc_sampling,
-                          a2dp_sbc_encoder_cb.feeding_params.bits_per_sample,
-                          a2dp_sbc_encoder_cb.feeding_params.channel_count);
+  if (a2dp_sbc_resampler == NULL) {
+    a2dp_sbc_resampler = a2dp_resampler_new(
+        a2dp_sbc_encoder_cb.feeding_params.sample_rate, sbc_sampling,
+        a2dp_sbc_encoder_cb.feeding_params.bits_per_sample,
+        a2dp_sbc_encoder_cb.feeding_params.channel_count);
+  }
 
   /*
    * Re-sample the read buffer.
    * The output PCM buffer will be stereo, 16 bit per sample.
    */
-  dst_size_used = a2dp_sbc_up_sample(
-      (uint8_t*)read_buffer,
-      (uint8_t*)up_sampled_buffer +
-          a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue,
-      nb_byte_read, sizeof(up_sampled_buffer) -
-                        a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue,
-      &src_size_used);
+  if (a2dp_sbc_resampler != NULL) {
+    dst_size_used = a2dp_resampler_process(
+        a2dp_sbc_resampler, read_buffer, nb_byte_read,
+        (int16_t*)((uint8_t*)up_sampled_buffer +
+                   a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue),
+        sizeof(up_sampled_buffer) -
+            a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue,
+        &src_size_used);
+  } else {
+    /* Fall back to the sample and hold engine for unsupported ratios */
+    a2dp_sbc_init_up_sample(a2dp_sbc_encoder_cb.feeding_params.sample_rate,
+                            sbc_sampling,
+                            a2dp_sbc_encoder_cb.feeding_params.bits_per_sample,
+                            a2dp_sbc_encoder_cb.feeding_params.channel_count);
+    dst_size_used = a2dp_sbc_up_sample(
+        (uint8_t*)read_buffer,
+        (uint8_t*)up_sampled_buffer +
+            a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue,
+        nb_byte_read, sizeof(up_sampled_buffer) -
+                          a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue,
+        &src_size_used);
+  }
 
   /* update the residue */
   a2dp_sbc_encoder_cb.feeding_state.aa_feed_residue += dst_size_used;
@@ -881,9 +1049,11 @@ static uint16_t a2dp_sbc_offload_source_rate(bool is_peer_edr) {
   return rate;
 }
 static uint16_t a2dp_sbc_source_rate(void) {
+  static osi_cached_property_t sbc_mq =
+      OSI_CACHED_PROPERTY("persist.vendor.btstack.sbcmq");
   uint16_t rate = A2DP_SBC_DEFAULT_BITRATE;
   char value[PROPERTY_VALUE_MAX] = {'\0'};
-  osi_property_get("persist.vendor.btstack.sbcmq", value, "false");
+  osi_cached_property_get(&sbc_mq, value, "false");
   if (!(strcmp(value,"true"))) {
      LOG_ERROR(LOG_TAG,"%s:MQ enabled",__func__);
      return A2DP_SBC_NON_EDR_MAX_RATE;
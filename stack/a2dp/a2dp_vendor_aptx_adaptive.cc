@@ -374,6 +374,7 @@ static const tA2DP_ENCODER_INTERFACE a2dp_encoder_interface_aptx_adaptive = {
     a2dp_vendor_aptx_adaptive_get_encoder_interval_ms, // _get_encoder_interval_ms
     a2dp_vendor_aptx_adaptive_send_frames,
     nullptr,  // set_transmit_queue_length
+    nullptr,  // encode_batch
 };
 
 UNUSED_ATTR static tA2DP_STATUS A2DP_CodecInfoMatchesCapabilityAptxAdaptive(
@@ -52,13 +52,6 @@ typedef int (*tAPTX_ENCODER_SIZEOF_PARAMS)(void);
 static tAPTX_ENCODER_INIT aptx_encoder_init_func;
 static tAPTX_ENCODER_ENCODE_STEREO aptx_encoder_encode_stereo_func;
 static tAPTX_ENCODER_SIZEOF_PARAMS aptx_encoder_sizeof_params_func;
-// offset
-#if (BTA_AV_CO_CP_SCMS_T == TRUE)
-#define A2DP_APTX_OFFSET (AVDT_MEDIA_OFFSET + 1)
-#else
-// no RTP header for aptX classic
-#define A2DP_APTX_OFFSET (AVDT_MEDIA_OFFSET - AVDT_MEDIA_HDR_SIZE)
-#endif
 
 #define A2DP_APTX_MAX_PCM_BYTES_PER_READ 1024
 
@@ -401,9 +394,9 @@ void a2dp_vendor_aptx_send_frames(uint64_t timestamp_us) {
   tAPTX_FRAMING_PARAMS* framing_params = &a2dp_aptx_encoder_cb.framing_params;
 
   // Prepare the packet to send
-  BT_HDR* p_buf = (BT_HDR*)osi_malloc(BT_DEFAULT_BUFFER_SIZE);
-  p_buf->offset = A2DP_APTX_OFFSET;
-  p_buf->len = 0;
+  // The RTP header is only added with content protection, the headroom
+  // covers both cases
+  BT_HDR* p_buf = AVDT_MediaBufAlloc(BT_DEFAULT_BUFFER_SIZE, 0);
   p_buf->layer_specific = 0;
 
   uint8_t* encoded_ptr = (uint8_t*)(p_buf + 1);
@@ -54,12 +54,6 @@ static tAPTX_HD_ENCODER_INIT aptx_hd_encoder_init_func;
 static tAPTX_HD_ENCODER_ENCODE_STEREO aptx_hd_encoder_encode_stereo_func;
 static tAPTX_HD_ENCODER_SIZEOF_PARAMS aptx_hd_encoder_sizeof_params_func;
 
-// offset
-#if (BTA_AV_CO_CP_SCMS_T == TRUE)
-#define A2DP_APTX_HD_OFFSET (AVDT_MEDIA_OFFSET + 1)
-#else
-#define A2DP_APTX_HD_OFFSET AVDT_MEDIA_OFFSET
-#endif
 
 #define A2DP_APTX_HD_MAX_PCM_BYTES_PER_READ 1024
 
@@ -385,9 +379,7 @@ void a2dp_vendor_aptx_hd_send_frames(uint64_t timestamp_us) {
       &a2dp_aptx_hd_encoder_cb.framing_params;
 
   // Prepare the packet to send
-  BT_HDR* p_buf = (BT_HDR*)osi_malloc(BT_DEFAULT_BUFFER_SIZE);
-  p_buf->offset = A2DP_APTX_HD_OFFSET;
-  p_buf->len = 0;
+  BT_HDR* p_buf = AVDT_MediaBufAlloc(BT_DEFAULT_BUFFER_SIZE, 0);
   p_buf->layer_specific = 0;
 
   uint8_t* encoded_ptr = (uint8_t*)(p_buf + 1);
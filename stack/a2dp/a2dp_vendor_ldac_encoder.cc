@@ -106,12 +106,8 @@ static tLDAC_GET_ERROR_CODE ldac_get_error_code_func;
 #define A2DP_LDAC_ENCODER_INTERVAL_MS 20
 #define A2DP_LDAC_MEDIA_BYTES_PER_FRAME 128
 
-// offset
-#if (BTA_AV_CO_CP_SCMS_T == TRUE)
-#define A2DP_LDAC_OFFSET (AVDT_MEDIA_OFFSET + A2DP_LDAC_MPL_HDR_LEN + 1)
-#else
-#define A2DP_LDAC_OFFSET (AVDT_MEDIA_OFFSET + A2DP_LDAC_MPL_HDR_LEN)
-#endif
+// offset, covering the content protection header as well
+#define A2DP_LDAC_OFFSET AVDT_MEDIA_HEADROOM(A2DP_LDAC_MPL_HDR_LEN)
 
 typedef struct {
   uint32_t sample_rate;
@@ -647,9 +643,8 @@ static void a2dp_ldac_encode_frames(uint8_t nb_frame) {
 
   uint32_t bytes_read = 0;
   while (nb_frame) {
-    BT_HDR* p_buf = (BT_HDR*)osi_malloc(BT_DEFAULT_BUFFER_SIZE);
-    p_buf->offset = A2DP_LDAC_OFFSET;
-    p_buf->len = 0;
+    BT_HDR* p_buf =
+        AVDT_MediaBufAlloc(BT_DEFAULT_BUFFER_SIZE, A2DP_LDAC_MPL_HDR_LEN);
     p_buf->layer_specific = 0;
     a2dp_ldac_encoder_cb.stats.media_read_total_expected_packets++;
 
@@ -85,7 +85,11 @@ typedef struct {
   BT_HDR* p_rx_msg;       /* Message being reassembled */
   uint16_t conflict_lcid; /* L2CAP channel LCID */
   RawAddress peer_addr;   /* BD address of peer */
-  fixed_queue_t* tx_q;    /* Transmit data buffer queue       */
+  fixed_queue_t* tx_q;    /* Messages waiting for p_tx_msg    */
+  BT_HDR* p_tx_msg;       /* Message being fragmented, header of its next
+                             fragment in place */
+  uint8_t tx_label;       /* Label of p_tx_msg */
+  uint8_t tx_cr_ipid;     /* C/R and IPID of p_tx_msg */
   bool cong;              /* true, if congested */
 } tAVCT_LCB;
 
@@ -39,6 +39,8 @@ const uint8_t avct_lcb_pkt_type_len[] = {AVCT_HDR_LEN_SINGLE,
                                          AVCT_HDR_LEN_START, AVCT_HDR_LEN_CONT,
                                          AVCT_HDR_LEN_END};
 
+static void avct_lcb_tx_service(tAVCT_LCB* p_lcb);
+
 /*******************************************************************************
  *
  * Function         avct_lcb_msg_asmbl
@@ -446,19 +448,11 @@ void avct_lcb_cong_ind(tAVCT_LCB* p_lcb, tAVCT_LCB_EVT* p_data) {
   tAVCT_CCB* p_ccb = &avct_cb.ccb[0];
   int i;
   uint8_t event;
-  BT_HDR* p_buf;
 
   /* set event */
   event = (p_data->cong) ? AVCT_CONG_IND_EVT : AVCT_UNCONG_IND_EVT;
   p_lcb->cong = p_data->cong;
-  if (p_lcb->cong == false && !fixed_queue_is_empty(p_lcb->tx_q)) {
-    while (!p_lcb->cong &&
-           (p_buf = (BT_HDR*)fixed_queue_try_dequeue(p_lcb->tx_q)) != NULL) {
-      if (L2CA_DataWrite(p_lcb->ch_lcid, p_buf) == L2CAP_DW_CONGESTED) {
-        p_lcb->cong = true;
-      }
-    }
-  }
+  avct_lcb_tx_service(p_lcb);
 
   /* send event to all ccbs on this lcb */
   for (i = 0; i < AVCT_NUM_CONN; i++, p_ccb++) {
@@ -484,6 +478,65 @@ void avct_lcb_discard_msg(UNUSED_ATTR tAVCT_LCB* p_lcb, tAVCT_LCB_EVT* p_data) {
   osi_free_and_reset((void**)&p_data->ul_msg.p_buf);
 }
 
+/*******************************************************************************
+ *
+ * Function         avct_lcb_tx_service
+ *
+ * Description      Sends the fragments of the queued messages until all are
+ *                  sent or L2CAP is congested. Fragments are cut from the
+ *                  message when they can be sent: all but the last one are
+ *                  copied out of it, the last one is the message buffer
+ *                  itself, and the header of each continuation is written
+ *                  in place over payload already copied out.
+ *
+ *
+ * Returns          Nothing.
+ *
+ ******************************************************************************/
+static void avct_lcb_tx_service(tAVCT_LCB* p_lcb) {
+  while (!p_lcb->cong) {
+    BT_HDR* p_msg = p_lcb->p_tx_msg;
+    uint8_t* p;
+    uint8_t pkt_type;
+
+    if (p_msg == NULL) {
+      p_msg = (BT_HDR*)fixed_queue_try_dequeue(p_lcb->tx_q);
+      if (p_msg == NULL) break;
+
+      p = (uint8_t*)(p_msg + 1) + p_msg->offset;
+      AVCT_PARSE_HDR(p, p_lcb->tx_label, pkt_type, p_lcb->tx_cr_ipid);
+      p_lcb->p_tx_msg = p_msg;
+    }
+
+    BT_HDR* p_buf;
+    if (p_msg->len <= p_lcb->peer_mtu) {
+      /* single or end packet, send the message buffer itself */
+      p_buf = p_msg;
+      p_lcb->p_tx_msg = NULL;
+    } else {
+      /* copy the next fragment out, header included */
+      p_buf = (BT_HDR*)osi_malloc(p_lcb->peer_mtu + L2CAP_MIN_OFFSET +
+                                  BT_HDR_SIZE);
+      p_buf->offset = L2CAP_MIN_OFFSET;
+      p_buf->len = p_lcb->peer_mtu;
+      memcpy((uint8_t*)(p_buf + 1) + p_buf->offset,
+             (uint8_t*)(p_msg + 1) + p_msg->offset, p_buf->len);
+
+      /* the header of the next fragment goes over its last copied byte */
+      p_msg->offset += p_lcb->peer_mtu - AVCT_HDR_LEN_CONT;
+      p_msg->len -= p_lcb->peer_mtu - AVCT_HDR_LEN_CONT;
+      pkt_type = (p_msg->len > p_lcb->peer_mtu) ? AVCT_PKT_TYPE_CONT
+                                                : AVCT_PKT_TYPE_END;
+      p = (uint8_t*)(p_msg + 1) + p_msg->offset;
+      AVCT_BUILD_HDR(p, p_lcb->tx_label, pkt_type, p_lcb->tx_cr_ipid);
+    }
+
+    if (L2CA_DataWrite(p_lcb->ch_lcid, p_buf) == L2CAP_DW_CONGESTED) {
+      p_lcb->cong = true;
+    }
+  }
+}
+
 /*******************************************************************************
  *
  * Function         avct_lcb_send_msg
@@ -495,16 +548,12 @@ void avct_lcb_discard_msg(UNUSED_ATTR tAVCT_LCB* p_lcb, tAVCT_LCB_EVT* p_data) {
  *
  ******************************************************************************/
 void avct_lcb_send_msg(tAVCT_LCB* p_lcb, tAVCT_LCB_EVT* p_data) {
-  uint16_t curr_msg_len;
+  BT_HDR* p_buf = p_data->ul_msg.p_buf;
+  uint16_t curr_msg_len = p_buf->len;
   uint8_t pkt_type;
-  uint8_t hdr_len;
   uint8_t* p;
   uint8_t nosp = 0; /* number of subsequent packets */
   uint16_t temp;
-  uint16_t buf_size = p_lcb->peer_mtu + L2CAP_MIN_OFFSET + BT_HDR_SIZE;
-
-  /* store msg len */
-  curr_msg_len = p_data->ul_msg.p_buf->len;
 
   /* initialize packet type and other stuff */
   if (curr_msg_len <= (p_lcb->peer_mtu - AVCT_HDR_LEN_SINGLE)) {
@@ -516,68 +565,26 @@ void avct_lcb_send_msg(tAVCT_LCB* p_lcb, tAVCT_LCB_EVT* p_data) {
     if ((temp % (p_lcb->peer_mtu - 1)) != 0) nosp++;
   }
 
-  /* while we haven't sent all packets */
-  while (curr_msg_len != 0) {
-    BT_HDR* p_buf;
-
-    /* set header len */
-    hdr_len = avct_lcb_pkt_type_len[pkt_type];
-
-    /* if remaining msg must be fragmented */
-    if (p_data->ul_msg.p_buf->len > (p_lcb->peer_mtu - hdr_len)) {
-      /* get a new buffer for fragment we are sending */
-      p_buf = (BT_HDR*)osi_malloc(buf_size);
-
-      /* copy portion of data from current message to new buffer */
-      p_buf->offset = L2CAP_MIN_OFFSET + hdr_len;
-      p_buf->len = p_lcb->peer_mtu - hdr_len;
-
-      memcpy(
-          (uint8_t*)(p_buf + 1) + p_buf->offset,
-          (uint8_t*)(p_data->ul_msg.p_buf + 1) + p_data->ul_msg.p_buf->offset,
-          p_buf->len);
-
-      p_data->ul_msg.p_buf->offset += p_buf->len;
-      p_data->ul_msg.p_buf->len -= p_buf->len;
-    } else {
-      p_buf = p_data->ul_msg.p_buf;
-    }
-
-    curr_msg_len -= p_buf->len;
-
-    /* set up to build header */
-    p_buf->len += hdr_len;
-    p_buf->offset -= hdr_len;
-    p = (uint8_t*)(p_buf + 1) + p_buf->offset;
-
-    /* build header */
-    AVCT_BUILD_HDR(p, p_data->ul_msg.label, pkt_type, p_data->ul_msg.cr);
-    if (pkt_type == AVCT_PKT_TYPE_START) {
-      UINT8_TO_STREAM(p, nosp);
-    }
-    if ((pkt_type == AVCT_PKT_TYPE_START) ||
-        (pkt_type == AVCT_PKT_TYPE_SINGLE)) {
-      UINT16_TO_BE_STREAM(p, p_data->ul_msg.p_ccb->cc.pid);
-    }
-
-    if (p_lcb->cong == true) {
-      fixed_queue_enqueue(p_lcb->tx_q, p_buf);
-    }
-
-    /* send message to L2CAP */
-    else {
-      if (L2CA_DataWrite(p_lcb->ch_lcid, p_buf) == L2CAP_DW_CONGESTED) {
-        p_lcb->cong = true;
-      }
-    }
+  /* build the header of the first packet in front of the message */
+  p_buf->len += avct_lcb_pkt_type_len[pkt_type];
+  p_buf->offset -= avct_lcb_pkt_type_len[pkt_type];
+  p = (uint8_t*)(p_buf + 1) + p_buf->offset;
+  AVCT_BUILD_HDR(p, p_data->ul_msg.label, pkt_type, p_data->ul_msg.cr);
+  if (pkt_type == AVCT_PKT_TYPE_START) {
+    UINT8_TO_STREAM(p, nosp);
+  }
+  UINT16_TO_BE_STREAM(p, p_data->ul_msg.p_ccb->cc.pid);
 
-    /* update pkt type for next packet */
-    if (curr_msg_len > (p_lcb->peer_mtu - AVCT_HDR_LEN_END)) {
-      pkt_type = AVCT_PKT_TYPE_CONT;
-    } else {
-      pkt_type = AVCT_PKT_TYPE_END;
-    }
+  /* fragments of different messages must not interleave */
+  if (p_lcb->p_tx_msg == NULL && fixed_queue_is_empty(p_lcb->tx_q)) {
+    p_lcb->p_tx_msg = p_buf;
+    p_lcb->tx_label = p_data->ul_msg.label;
+    p_lcb->tx_cr_ipid = p_data->ul_msg.cr;
+  } else {
+    fixed_queue_enqueue(p_lcb->tx_q, p_buf);
   }
+  avct_lcb_tx_service(p_lcb);
+
   AVCT_TRACE_DEBUG("%s tx_q_count:%d", __func__,
                    fixed_queue_length(p_lcb->tx_q));
   return;
@@ -37,7 +37,9 @@
 #include "btm_int.h"
 #include "btm_int_types.h"
 #include "btu.h"
+#include "hcidefs.h"
 #include "l2c_api.h"
+#include "l2cdefs.h"
 #include "stack/include/a2dp_codec_api.h"
 
 /* Control block for AVDT */
@@ -1031,6 +1033,48 @@ uint16_t AVDT_WriteReq(uint8_t handle, BT_HDR* p_pkt, uint32_t time_stamp,
   return AVDT_WriteReqOpt(handle, p_pkt, time_stamp, m_pt, AVDT_DATA_OPT_NONE);
 }
 
+/* The media packet header, L2CAP header, HCI ACL header and HCI packet type
+ * must all fit the reserved headroom. */
+static_assert(AVDT_MEDIA_OFFSET >= AVDT_MEDIA_HDR_SIZE + L2CAP_PKT_OVERHEAD +
+                                       HCI_DATA_PREAMBLE_SIZE + 1,
+              "AVDT_MEDIA_OFFSET is too small for the media packet headers");
+
+/*******************************************************************************
+ *
+ * Function         AVDT_MediaBufAlloc
+ *
+ * Description      Allocate a buffer for a media packet payload with the
+ *                  headroom for all its headers.
+ *
+ * Returns          The buffer.
+ *
+ ******************************************************************************/
+BT_HDR* AVDT_MediaBufAlloc(uint16_t buf_size, uint16_t codec_hdr_len) {
+  CHECK(buf_size > sizeof(BT_HDR) + AVDT_MEDIA_HEADROOM(codec_hdr_len));
+
+  BT_HDR* p_buf = (BT_HDR*)osi_malloc(buf_size);
+  p_buf->offset = AVDT_MEDIA_HEADROOM(codec_hdr_len);
+  p_buf->len = 0;
+  return p_buf;
+}
+
+/*******************************************************************************
+ *
+ * Function         AVDT_MediaBufPrepend
+ *
+ * Description      Grow a media packet at the front for a header.
+ *
+ * Returns          Pointer to the header, NULL if it does not fit.
+ *
+ ******************************************************************************/
+uint8_t* AVDT_MediaBufPrepend(BT_HDR* p_buf, uint16_t len) {
+  if (p_buf->offset < len) return NULL;
+
+  p_buf->offset -= len;
+  p_buf->len += len;
+  return (uint8_t*)(p_buf + 1) + p_buf->offset;
+}
+
 /*******************************************************************************
  *
  * Function         AVDT_ConnectReq
@@ -1239,16 +1239,13 @@ void avdt_scb_hdl_write_req(tAVDT_SCB* p_scb, tAVDT_SCB_EVT* p_data) {
   /* Build a media packet, and add an RTP header if required. */
   if (add_rtp_header) {
     AVDT_TRACE_DEBUG("%s:add rtp header",__func__);
-    if (p_data->apiwrite.p_buf->offset < AVDT_MEDIA_HDR_SIZE) {
+    p = AVDT_MediaBufPrepend(p_data->apiwrite.p_buf, AVDT_MEDIA_HDR_SIZE);
+    if (p == NULL) {
       android_errorWriteWithInfoLog(0x534e4554, "242535997", -1, NULL, 0);
       return;
     }
     ssrc = avdt_scb_gen_ssrc(p_scb);
-
-    p_data->apiwrite.p_buf->len += AVDT_MEDIA_HDR_SIZE;
-    p_data->apiwrite.p_buf->offset -= AVDT_MEDIA_HDR_SIZE;
     p_scb->media_seq++;
-    p = (uint8_t*)(p_data->apiwrite.p_buf + 1) + p_data->apiwrite.p_buf->offset;
 
     UINT8_TO_BE_STREAM(p, AVDT_MEDIA_OCTET1);
     UINT8_TO_BE_STREAM(p, p_data->apiwrite.m_pt);
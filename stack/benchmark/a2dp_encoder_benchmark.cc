@@ -0,0 +1,318 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+// Runs every A2DP source encoder through its tA2DP_ENCODER_INTERFACE over
+// reference PCM, at each sample rate the encoder supports. One iteration is
+// one media task tick. Besides the time per tick, each benchmark reports:
+//   frames           - codec frames encoded, as a rate
+//   ns_per_frame     - encode cost of one codec frame
+//   allocs_per_frame - osi allocations per codec frame
+//   packet_bytes     - mean media packet size
+//   mtu_fill         - mean media packet size as a fraction of the MTU
+// The label carries a hash of the packets of a fixed run from a freshly
+// initialized encoder, so variants such as the SIMD and the scalar SBC
+// analysis can be checked for bit exactness by comparing labels.
+
+#include <benchmark/benchmark.h>
+
+#include <math.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "osi/include/allocation_tracker.h"
+#include "osi/include/allocator.h"
+#include "osi/include/osi.h"
+#include "stack/include/a2dp_codec_api.h"
+#include "stack/include/bt_types.h"
+
+using ::benchmark::Counter;
+using ::benchmark::State;
+
+// A2DP_SetOffloadStatus() needs the controller module, so the benchmark
+// enables the software codecs directly.
+extern bool sbc_sw;
+extern bool aac_sw;
+extern bool aptx_sw;
+extern bool aptxhd_sw;
+extern bool aptx_adaptive_sw;
+extern bool ldac_sw;
+
+// Defined by the SBC encoder, see sbc_enc_func_declare.h
+extern "C" bool SbcSimdForceScalar;
+
+namespace {
+
+constexpr uint16_t kPeerMtu = 895;
+constexpr uint64_t kTickStartUs = 1000000;
+constexpr int kConformanceTicks = 100;
+
+const btav_a2dp_codec_sample_rate_t kSampleRates[] = {
+    BTAV_A2DP_CODEC_SAMPLE_RATE_44100, BTAV_A2DP_CODEC_SAMPLE_RATE_48000,
+    BTAV_A2DP_CODEC_SAMPLE_RATE_88200, BTAV_A2DP_CODEC_SAMPLE_RATE_96000};
+
+struct EncoderRun {
+  uint64_t frames = 0;
+  uint64_t packets = 0;
+  uint64_t packet_bytes = 0;
+  uint32_t hash = 2166136261u;  // FNV-1a offset basis
+};
+
+// The encoder callbacks are plain functions, so they share this state
+std::vector<uint8_t> reference_pcm;
+size_t reference_pcm_offset = 0;
+EncoderRun* current_run = nullptr;
+
+// Fills |reference_pcm| with one second of stereo PCM at |sample_rate| Hz
+// and |bits_per_sample| bits: two tones over a low level of noise.
+void make_reference_pcm(uint32_t sample_rate, uint8_t bits_per_sample) {
+  const size_t bytes_per_sample = bits_per_sample / 8;
+  uint32_t seed = 12345;
+
+  reference_pcm.clear();
+  reference_pcm.reserve(sample_rate * 2 * bytes_per_sample);
+  for (uint32_t i = 0; i < sample_rate; i++) {
+    for (int ch = 0; ch < 2; ch++) {
+      double t = (double)i / sample_rate;
+      double tone = 0.4 * sin(2 * M_PI * (ch ? 1000.0 : 440.0) * t) +
+                    0.2 * sin(2 * M_PI * (ch ? 7300.0 : 5100.0) * t);
+      seed = seed * 1103515245 + 12345;
+      double noise = (int16_t)(seed >> 16) / 32768.0 * 0.01;
+      int32_t sample = (int32_t)((tone + noise) * 2147483647.0);
+      // Little endian, the most significant |bytes_per_sample| octets
+      for (size_t b = 0; b < bytes_per_sample; b++) {
+        reference_pcm.push_back(
+            (uint8_t)(sample >> (8 * (4 - bytes_per_sample + b))));
+      }
+    }
+  }
+  reference_pcm_offset = 0;
+}
+
+uint32_t read_reference_pcm(uint8_t* p_buf, uint32_t len) {
+  for (uint32_t i = 0; i < len; i++) {
+    p_buf[i] = reference_pcm[reference_pcm_offset++];
+    if (reference_pcm_offset == reference_pcm.size()) reference_pcm_offset = 0;
+  }
+  return len;
+}
+
+bool enqueue_packet(BT_HDR* p_buf, size_t frames_n,
+                    UNUSED_ATTR uint32_t bytes_read) {
+  EncoderRun* run = current_run;
+  const uint8_t* p = (const uint8_t*)(p_buf + 1) + p_buf->offset;
+  for (uint16_t i = 0; i < p_buf->len; i++) {
+    run->hash = (run->hash ^ p[i]) * 16777619u;  // FNV-1a prime
+  }
+  run->frames += frames_n;
+  run->packets++;
+  run->packet_bytes += p_buf->len;
+  osi_free(p_buf);
+  return true;
+}
+
+// An encoder set up for one codec configuration
+class A2dpEncoder {
+ public:
+  ~A2dpEncoder() {
+    if (started_) encoder_->encoder_cleanup();
+  }
+
+  // Sets up the encoder of |codec_index| at |sample_rate|, with the peer
+  // supporting every local capability. Returns false if the codec or the
+  // configuration is not available.
+  bool Setup(btav_a2dp_codec_index_t codec_index,
+             btav_a2dp_codec_sample_rate_t sample_rate) {
+    codecs_.reset(new A2dpCodecs(codec_priorities_));
+    codecs_->init(false);
+
+    tAVDT_CFG peer_capability;
+    memset(&peer_capability, 0, sizeof(peer_capability));
+    if (!A2DP_InitCodecConfig(codec_index, &peer_capability)) return false;
+
+    btav_a2dp_codec_config_t user_config;
+    memset(&user_config, 0, sizeof(user_config));
+    user_config.codec_type = codec_index;
+    user_config.codec_priority = BTAV_A2DP_CODEC_PRIORITY_HIGHEST;
+    user_config.sample_rate = sample_rate;
+    user_config.channel_mode = BTAV_A2DP_CODEC_CHANNEL_MODE_STEREO;
+
+    uint8_t result_codec_config[AVDT_CODEC_SIZE];
+    bool restart_input, restart_output, config_updated;
+    peer_params_.is_peer_edr = true;
+    peer_params_.peer_supports_3mbps = true;
+    peer_params_.peer_mtu = kPeerMtu;
+    if (!codecs_->setCodecUserConfig(user_config, &peer_params_,
+                                     peer_capability.codec_info,
+                                     result_codec_config, &restart_input,
+                                     &restart_output, &config_updated)) {
+      return false;
+    }
+    codec_config_ = codecs_->getCurrentCodecConfig();
+    if (codec_config_ == nullptr ||
+        codec_config_->codecIndex() != codec_index ||
+        codec_config_->getCodecConfig().sample_rate != sample_rate)
+      return false;
+
+    encoder_ = A2DP_GetEncoderInterface(result_codec_config);
+    if (encoder_ == nullptr) return false;
+
+    sample_rate_hz_ = A2DP_GetTrackSampleRate(result_codec_config);
+    bits_per_sample_ = codec_config_->getAudioBitsPerSample();
+    return sample_rate_hz_ > 0 && bits_per_sample_ > 0;
+  }
+
+  // (Re)starts the stream from the beginning of the reference PCM
+  void Start(EncoderRun* run) {
+    current_run = run;
+    if (started_) encoder_->encoder_cleanup();
+    started_ = true;
+    make_reference_pcm(sample_rate_hz_, bits_per_sample_);
+    encoder_->encoder_init(&peer_params_, codec_config_, read_reference_pcm,
+                           enqueue_packet);
+    encoder_->feeding_reset();
+    interval_us_ = encoder_->get_encoder_interval_ms() * 1000;
+    timestamp_us_ = kTickStartUs;
+  }
+
+  // Runs one media task tick
+  void Tick() {
+    timestamp_us_ += interval_us_;
+    encoder_->send_frames(timestamp_us_);
+  }
+
+  uint8_t bits_per_sample() const { return bits_per_sample_; }
+
+ private:
+  std::vector<btav_a2dp_codec_config_t> codec_priorities_;
+  std::unique_ptr<A2dpCodecs> codecs_;
+  A2dpCodecConfig* codec_config_ = nullptr;
+  const tA2DP_ENCODER_INTERFACE* encoder_ = nullptr;
+  tA2DP_ENCODER_INIT_PEER_PARAMS peer_params_;
+  int sample_rate_hz_ = 0;
+  uint8_t bits_per_sample_ = 0;
+  uint64_t interval_us_ = 0;
+  uint64_t timestamp_us_ = 0;
+  bool started_ = false;
+};
+
+void BM_A2dpEncode(State& state, btav_a2dp_codec_index_t codec_index,
+                   btav_a2dp_codec_sample_rate_t sample_rate, bool scalar) {
+  SbcSimdForceScalar = scalar;
+  A2dpEncoder encoder;
+  if (!encoder.Setup(codec_index, sample_rate)) {
+    state.SkipWithError("codec configuration not available");
+    SbcSimdForceScalar = false;
+    return;
+  }
+
+  // Conformance: a fixed run from a freshly initialized encoder
+  EncoderRun conformance;
+  encoder.Start(&conformance);
+  for (int i = 0; i < kConformanceTicks; i++) encoder.Tick();
+
+  EncoderRun run;
+  encoder.Start(&run);
+  size_t allocs_start, allocs_end, bytes;
+  allocation_tracker_set_sampling_rate(1);
+  osi_allocator_get_sampled(&allocs_start, &bytes);
+  for (auto _ : state) {
+    encoder.Tick();
+  }
+  osi_allocator_get_sampled(&allocs_end, &bytes);
+  allocation_tracker_set_sampling_rate(0);
+  SbcSimdForceScalar = false;
+
+  if (run.frames == 0) {
+    state.SkipWithError("no frames were encoded");
+    return;
+  }
+  double frames = run.frames;
+  state.counters["frames"] = Counter(frames, Counter::kIsRate);
+  state.counters["ns_per_frame"] =
+      Counter(frames / 1e9, Counter::kIsRate | Counter::kInvert);
+  state.counters["allocs_per_frame"] = (allocs_end - allocs_start) / frames;
+  if (run.packets > 0) {
+    double packet_bytes = (double)run.packet_bytes / run.packets;
+    state.counters["packet_bytes"] = packet_bytes;
+    state.counters["mtu_fill"] = packet_bytes / kPeerMtu;
+  }
+
+  char label[64];
+  snprintf(label, sizeof(label), "bits=%u hash=%08x",
+           encoder.bits_per_sample(), conformance.hash);
+  state.SetLabel(label);
+}
+
+const char* sample_rate_name(btav_a2dp_codec_sample_rate_t sample_rate) {
+  switch (sample_rate) {
+    case BTAV_A2DP_CODEC_SAMPLE_RATE_44100:
+      return "44100";
+    case BTAV_A2DP_CODEC_SAMPLE_RATE_48000:
+      return "48000";
+    case BTAV_A2DP_CODEC_SAMPLE_RATE_88200:
+      return "88200";
+    case BTAV_A2DP_CODEC_SAMPLE_RATE_96000:
+      return "96000";
+    default:
+      return "unknown";
+  }
+}
+
+// Registers a benchmark for each codec configuration that can be set up
+void register_benchmarks() {
+  for (int i = BTAV_A2DP_CODEC_INDEX_SOURCE_MIN;
+       i < BTAV_A2DP_QVA_CODEC_INDEX_SOURCE_MAX; i++) {
+    btav_a2dp_codec_index_t codec_index =
+        static_cast<btav_a2dp_codec_index_t>(i);
+    for (btav_a2dp_codec_sample_rate_t sample_rate : kSampleRates) {
+      {
+        A2dpEncoder probe;
+        if (!probe.Setup(codec_index, sample_rate)) continue;
+      }
+      std::string name = std::string("BM_A2dpEncode/") +
+                         A2DP_CodecIndexStr(codec_index) + "/" +
+                         sample_rate_name(sample_rate);
+      ::benchmark::RegisterBenchmark(name.c_str(), BM_A2dpEncode, codec_index,
+                                     sample_rate, false);
+      if (codec_index == BTAV_A2DP_CODEC_INDEX_SOURCE_SBC) {
+        ::benchmark::RegisterBenchmark((name + "/scalar").c_str(),
+                                       BM_A2dpEncode, codec_index,
+                                       sample_rate, true);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  sbc_sw = true;
+  aac_sw = true;
+  aptx_sw = true;
+  aptxhd_sw = true;
+  aptx_adaptive_sw = true;
+  ldac_sw = true;
+  register_benchmarks();
+
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
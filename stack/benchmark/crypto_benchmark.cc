@@ -0,0 +1,370 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+// Times the LE security primitives of crypto_toolbox, the RPA generation and
+// resolution of btm_ble_addr.cc, and the P-256 operations of SMP. One
+// iteration is one operation, so the reported time is the time per operation.
+// Each AES based benchmark runs once per backend:
+//   software - the table based aes_encrypt
+//   hardware - ARMv8 Crypto Extensions or AES-NI, skipped if the CPU has none
+// BoringSSL is run as a reference for AES-128 and the P-256 multiplication,
+// without a label since it takes its input in the other byte order.
+// The inputs are fixed and the label carries the first bytes of the result,
+// so the backends can be checked for giving the same output by comparing
+// labels.
+
+#include <benchmark/benchmark.h>
+
+#include <openssl/aes.h>
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+#include <openssl/obj_mac.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "stack/btm/btm_int.h"
+#include "stack/crypto_toolbox/aes_hw.h"
+#include "stack/crypto_toolbox/crypto_toolbox.h"
+#include "stack/smp/p_256_ecc_ct.h"
+#include "stack/smp/p_256_ecc_pp.h"
+
+using ::benchmark::State;
+using crypto_toolbox::aes_hw_force_software;
+using crypto_toolbox::aes_hw_supported;
+
+// Defined in btm_ble_addr.cc
+extern RawAddress generate_rpa_from_irk_and_rand(const Octet16& irk,
+                                                 BT_OCTET8 random);
+
+namespace {
+
+enum Backend { kSoftware, kHardware };
+
+const Octet16 kKey{0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+                   0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+
+// Test values of the Core spec, Vol 3, Part H, Appendix D
+const Octet16 kN1{0xff, 0x7b, 0x96, 0xd7, 0x8d, 0x9b, 0x6d, 0xac,
+                  0x4d, 0x2b, 0x57, 0x6d, 0x8a, 0x57, 0x56, 0xd5};
+const Octet16 kN2{0x3c, 0x9a, 0x0d, 0x2f, 0x4f, 0x9b, 0x0d, 0x47,
+                  0x2e, 0x20, 0x3a, 0x5f, 0x31, 0x19, 0x19, 0xa4};
+
+// Selects |backend| for the benchmark. Returns false, after skipping it, if
+// the backend is not available.
+bool select_backend(State& state, Backend backend) {
+  if (backend == kHardware && !aes_hw_supported()) {
+    state.SkipWithError("no AES instructions");
+    return false;
+  }
+  aes_hw_force_software = (backend == kSoftware);
+  return true;
+}
+
+void finish(State& state, const uint8_t* result) {
+  aes_hw_force_software = false;
+  char label[32];
+  snprintf(label, sizeof(label), "out=%02x%02x%02x%02x", result[0], result[1],
+           result[2], result[3]);
+  state.SetLabel(label);
+}
+
+void BM_Aes128(State& state, Backend backend) {
+  if (!select_backend(state, backend)) return;
+  Octet16 out;
+  for (auto _ : state) {
+    out = crypto_toolbox::aes_128(kKey, kN1);
+    benchmark::DoNotOptimize(out);
+  }
+  finish(state, out.data());
+}
+
+void BM_Aes128Schedule(State& state, Backend backend) {
+  if (!select_backend(state, backend)) return;
+  aes_context ctx;
+  crypto_toolbox::aes_128_set_key(kKey, &ctx);
+  Octet16 out;
+  for (auto _ : state) {
+    out = crypto_toolbox::aes_128(ctx, kN1);
+    benchmark::DoNotOptimize(out);
+  }
+  finish(state, out.data());
+}
+
+void BM_Aes128Boringssl(State& state) {
+  AES_KEY key;
+  AES_set_encrypt_key(kKey.data(), 128, &key);
+  Octet16 out;
+  for (auto _ : state) {
+    AES_encrypt(kN1.data(), out.data(), &key);
+    benchmark::DoNotOptimize(out);
+  }
+}
+
+void BM_AesCmac(State& state, Backend backend) {
+  if (!select_backend(state, backend)) return;
+  std::vector<uint8_t> message(state.range(0), 0x5a);
+  Octet16 out{};
+  for (auto _ : state) {
+    out = crypto_toolbox::aes_cmac(kKey, message.data(), message.size());
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetBytesProcessed(state.iterations() * message.size());
+  finish(state, out.data());
+}
+
+void BM_AesCmacSchedule(State& state, Backend backend) {
+  if (!select_backend(state, backend)) return;
+  crypto_toolbox::cmac_context ctx;
+  crypto_toolbox::aes_cmac_set_key(kKey, &ctx);
+  std::vector<uint8_t> message(state.range(0), 0x5a);
+  Octet16 out{};
+  for (auto _ : state) {
+    out = crypto_toolbox::aes_cmac(ctx, message.data(), message.size());
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetBytesProcessed(state.iterations() * message.size());
+  finish(state, out.data());
+}
+
+void BM_F4(State& state, Backend backend) {
+  if (!select_backend(state, backend)) return;
+  uint8_t u[32], v[32];
+  memset(u, 0x20, sizeof(u));
+  memset(v, 0x55, sizeof(v));
+  Octet16 out{};
+  for (auto _ : state) {
+    out = crypto_toolbox::f4(u, v, kN1, 0);
+    benchmark::DoNotOptimize(out);
+  }
+  finish(state, out.data());
+}
+
+void BM_F5(State& state, Backend backend) {
+  if (!select_backend(state, backend)) return;
+  uint8_t w[32], a1[7], a2[7];
+  memset(w, 0xec, sizeof(w));
+  memset(a1, 0x56, sizeof(a1));
+  memset(a2, 0xa7, sizeof(a2));
+  Octet16 mac_key, ltk;
+  for (auto _ : state) {
+    crypto_toolbox::f5(w, kN1, kN2, a1, a2, &mac_key, &ltk);
+    benchmark::DoNotOptimize(ltk);
+  }
+  finish(state, ltk.data());
+}
+
+void BM_F6(State& state, Backend backend) {
+  if (!select_backend(state, backend)) return;
+  uint8_t iocap[3] = {0x01, 0x01, 0x02};
+  uint8_t a1[7], a2[7];
+  memset(a1, 0x56, sizeof(a1));
+  memset(a2, 0xa7, sizeof(a2));
+  Octet16 out;
+  for (auto _ : state) {
+    out = crypto_toolbox::f6(kKey, kN1, kN2, kN1, iocap, a1, a2);
+    benchmark::DoNotOptimize(out);
+  }
+  finish(state, out.data());
+}
+
+void BM_G2(State& state, Backend backend) {
+  if (!select_backend(state, backend)) return;
+  uint8_t u[32], v[32];
+  memset(u, 0x20, sizeof(u));
+  memset(v, 0x55, sizeof(v));
+  uint32_t out = 0;
+  for (auto _ : state) {
+    out = crypto_toolbox::g2(u, v, kN1, kN2);
+    benchmark::DoNotOptimize(out);
+  }
+  uint8_t result[4] = {(uint8_t)(out >> 24), (uint8_t)(out >> 16),
+                       (uint8_t)(out >> 8), (uint8_t)out};
+  finish(state, result);
+}
+
+void BM_H6(State& state, Backend backend) {
+  if (!select_backend(state, backend)) return;
+  Octet16 out;
+  for (auto _ : state) {
+    out = crypto_toolbox::h6(kKey, {0x6c, 0x65, 0x62, 0x72});
+    benchmark::DoNotOptimize(out);
+  }
+  finish(state, out.data());
+}
+
+void BM_H7(State& state, Backend backend) {
+  if (!select_backend(state, backend)) return;
+  Octet16 out;
+  for (auto _ : state) {
+    out = crypto_toolbox::h7(kN1, kKey);
+    benchmark::DoNotOptimize(out);
+  }
+  finish(state, out.data());
+}
+
+void BM_GenerateRpa(State& state, Backend backend) {
+  if (!select_backend(state, backend)) return;
+  BT_OCTET8 random = {0x70, 0x81, 0x94};
+  RawAddress rpa;
+  for (auto _ : state) {
+    rpa = generate_rpa_from_irk_and_rand(kKey, random);
+    benchmark::DoNotOptimize(rpa);
+  }
+  finish(state, rpa.address);
+}
+
+// An RPA resolved against the IRK of a device it does not belong to, which
+// is what most resolutions of an advertising report are
+void BM_RpaMatchesIrk(State& state, Backend backend) {
+  if (!select_backend(state, backend)) return;
+  static tBTM_SEC_DEV_REC dev_rec;
+  dev_rec.device_type = BT_DEVICE_TYPE_BLE;
+  dev_rec.ble.key_type = BTM_LE_KEY_PID;
+  dev_rec.ble.keys.irk = kN2;
+
+  BT_OCTET8 random = {0x70, 0x81, 0x94};
+  RawAddress rpa = generate_rpa_from_irk_and_rand(kKey, random);
+  uint8_t matches[4] = {0};
+  for (auto _ : state) {
+    matches[0] = btm_ble_addr_resolvable(rpa, &dev_rec);
+    benchmark::DoNotOptimize(matches);
+  }
+  finish(state, matches);
+}
+
+// A scalar below the curve order, as smp_create_private_key makes
+void make_scalar(uint32_t scalar[KEY_LENGTH_DWORDS_P256]) {
+  for (int i = 0; i < KEY_LENGTH_DWORDS_P256; i++)
+    scalar[i] = 0x9e3779b9u * (i + 1);
+  scalar[KEY_LENGTH_DWORDS_P256 - 1] &= 0x7fffffff;
+}
+
+// |base| multiplies the curve base point, as the public key generation does,
+// otherwise a peer public key, as the DHKey computation does
+void BM_EccPointMult(State& state, bool base) {
+  p_256_init_curve(KEY_LENGTH_DWORDS_P256);
+  uint32_t scalar[KEY_LENGTH_DWORDS_P256];
+  make_scalar(scalar);
+
+  Point point;
+  memcpy(&point, &curve_p256.G, sizeof(point));
+  if (!base) {
+    ECC_PointMult_Bin_NAF(&point, &curve_p256.G, scalar,
+                          KEY_LENGTH_DWORDS_P256);
+  }
+
+  Point out;
+  for (auto _ : state) {
+    ECC_PointMult_Bin_NAF(&out, &point, scalar, KEY_LENGTH_DWORDS_P256);
+    benchmark::DoNotOptimize(out);
+  }
+  finish(state, (const uint8_t*)out.x);
+}
+
+void BM_EccPointMultBoringssl(State& state) {
+  EC_GROUP* group = EC_GROUP_new_by_curve_name(NID_X9_62_prime256v1);
+  EC_POINT* point = EC_POINT_new(group);
+  EC_POINT* out = EC_POINT_new(group);
+  BN_CTX* ctx = BN_CTX_new();
+  BIGNUM* scalar = BN_new();
+
+  uint32_t words[KEY_LENGTH_DWORDS_P256];
+  make_scalar(words);
+  uint8_t bytes[KEY_LENGTH_DWORDS_P256 * 4];
+  for (int i = 0; i < KEY_LENGTH_DWORDS_P256; i++) {
+    uint32_t word = words[KEY_LENGTH_DWORDS_P256 - 1 - i];
+    bytes[i * 4] = word >> 24;
+    bytes[i * 4 + 1] = word >> 16;
+    bytes[i * 4 + 2] = word >> 8;
+    bytes[i * 4 + 3] = word;
+  }
+  BN_bin2bn(bytes, sizeof(bytes), scalar);
+  EC_POINT_mul(group, point, scalar, NULL, NULL, ctx);
+
+  for (auto _ : state) {
+    EC_POINT_mul(group, out, NULL, point, scalar, ctx);
+  }
+
+  BN_free(scalar);
+  BN_CTX_free(ctx);
+  EC_POINT_free(out);
+  EC_POINT_free(point);
+  EC_GROUP_free(group);
+}
+
+void BM_EccValidatePoint(State& state) {
+  p_256_init_curve(KEY_LENGTH_DWORDS_P256);
+  uint8_t valid[4] = {0};
+  for (auto _ : state) {
+    valid[0] = ECC_ValidatePoint(curve_p256.G);
+    benchmark::DoNotOptimize(valid);
+  }
+  finish(state, valid);
+}
+
+void register_aes_benchmark(const char* name,
+                            void (*fn)(State&, Backend),
+                            const std::vector<int64_t>& lengths = {}) {
+  const Backend backends[] = {kSoftware, kHardware};
+  const char* backend_names[] = {"software", "hardware"};
+  for (int i = 0; i < 2; i++) {
+    std::string full_name = std::string(name) + "/" + backend_names[i];
+    auto* benchmark = ::benchmark::RegisterBenchmark(full_name.c_str(), fn,
+                                                     backends[i]);
+    for (int64_t length : lengths) benchmark->Arg(length);
+  }
+}
+
+void register_benchmarks() {
+  const std::vector<int64_t> cmac_lengths = {16, 65, 128, 512, 1024};
+
+  register_aes_benchmark("BM_Aes128", BM_Aes128);
+  register_aes_benchmark("BM_Aes128Schedule", BM_Aes128Schedule);
+  ::benchmark::RegisterBenchmark("BM_Aes128/boringssl", BM_Aes128Boringssl);
+  register_aes_benchmark("BM_AesCmac", BM_AesCmac, cmac_lengths);
+  register_aes_benchmark("BM_AesCmacSchedule", BM_AesCmacSchedule,
+                         cmac_lengths);
+  register_aes_benchmark("BM_F4", BM_F4);
+  register_aes_benchmark("BM_F5", BM_F5);
+  register_aes_benchmark("BM_F6", BM_F6);
+  register_aes_benchmark("BM_G2", BM_G2);
+  register_aes_benchmark("BM_H6", BM_H6);
+  register_aes_benchmark("BM_H7", BM_H7);
+  register_aes_benchmark("BM_GenerateRpa", BM_GenerateRpa);
+  register_aes_benchmark("BM_RpaMatchesIrk", BM_RpaMatchesIrk);
+  ::benchmark::RegisterBenchmark("BM_EccPointMult/base", BM_EccPointMult,
+                                 true);
+  ::benchmark::RegisterBenchmark("BM_EccPointMult/point", BM_EccPointMult,
+                                 false);
+  ::benchmark::RegisterBenchmark("BM_EccPointMult/boringssl",
+                                 BM_EccPointMultBoringssl);
+  ::benchmark::RegisterBenchmark("BM_EccValidatePoint", BM_EccValidatePoint);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  register_benchmarks();
+
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,242 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+// Times the receive paths of the stack that run once per packet, without a
+// controller. The stack is not started; each benchmark sets up just the
+// control blocks its path reads.
+//   BM_L2capStreamingRx   - l2c_fcr_proc_pdu on a streaming mode channel, of
+//                           I-frames with a |range| byte payload, from the
+//                           FCS check up to the data indication
+//   BM_BleAdvReport       - btm_ble_process_adv_pkt of LE Advertising Report
+//                           events carrying |range| reports, while observing
+//   BM_GattReadByHandle   - gatts_read_attr_value_by_handle of the
+//                           declarations of a service with |range|
+//                           characteristics, which the stack answers itself
+// One iteration is one PDU, event or read.
+
+#include <benchmark/benchmark.h>
+
+#include <string.h>
+#include <vector>
+
+#include "osi/include/allocator.h"
+#include "osi/include/crc16.h"
+#include "stack/btm/btm_ble_int.h"
+#include "stack/btm/btm_int.h"
+#include "stack/gatt/gatt_int.h"
+#include "stack/include/hci_event_view.h"
+#include "stack/include/l2cdefs.h"
+#include "stack/l2cap/l2c_int.h"
+
+using ::benchmark::State;
+using bluetooth::Uuid;
+
+namespace {
+
+/* L2CAP streaming mode */
+
+constexpr uint16_t kLocalCid = 0x0040;
+constexpr int kNumTxSeq = L2CAP_FCR_SEQ_MODULO + 1;
+
+tL2C_LCB lcb;
+tL2C_RCB rcb;
+tL2C_CCB ccb;
+
+void l2cap_data_ind(uint16_t lcid, BT_HDR* p_buf) {
+  benchmark::DoNotOptimize(p_buf->len);
+  osi_free(p_buf);
+}
+
+void setup_streaming_channel() {
+  memset(&lcb, 0, sizeof(lcb));
+  memset(&rcb, 0, sizeof(rcb));
+  memset(&ccb, 0, sizeof(ccb));
+  rcb.in_use = true;
+  rcb.api.pL2CA_DataInd_Cb = l2cap_data_ind;
+  ccb.in_use = true;
+  ccb.chnl_state = CST_OPEN;
+  ccb.local_cid = kLocalCid;
+  ccb.p_lcb = &lcb;
+  ccb.p_rcb = &rcb;
+  ccb.max_rx_mtu = L2CAP_MTU_SIZE;
+  ccb.peer_cfg.fcr.mode = L2CAP_FCR_STREAM_MODE;
+}
+
+// An unsegmented I-frame with sequence number |tx_seq|, as l2c_rcv_acl_data
+// hands it over: the basic header before the offset, the control word at it.
+std::vector<uint8_t> make_i_frame(uint16_t payload_len, uint8_t tx_seq) {
+  uint16_t pdu_len = L2CAP_FCR_OVERHEAD + payload_len + L2CAP_FCS_LEN;
+  std::vector<uint8_t> frame(L2CAP_PKT_OVERHEAD + pdu_len, 0x5a);
+  uint8_t* p = frame.data();
+  UINT16_TO_STREAM(p, pdu_len);
+  UINT16_TO_STREAM(p, kLocalCid);
+  UINT16_TO_STREAM(p, L2CAP_FCR_UNSEG_SDU |
+                          (tx_seq << L2CAP_FCR_TX_SEQ_BITS_SHIFT));
+  uint16_t fcs = crc16_update(L2CAP_FCR_INIT_CRC, frame.data(),
+                              frame.size() - L2CAP_FCS_LEN);
+  p = frame.data() + frame.size() - L2CAP_FCS_LEN;
+  UINT16_TO_STREAM(p, fcs);
+  return frame;
+}
+
+void BM_L2capStreamingRx(State& state) {
+  setup_streaming_channel();
+
+  uint16_t payload_len = state.range(0);
+  std::vector<std::vector<uint8_t>> frames;
+  for (int tx_seq = 0; tx_seq < kNumTxSeq; tx_seq++)
+    frames.push_back(make_i_frame(payload_len, tx_seq));
+
+  size_t i = 0;
+  for (auto _ : state) {
+    const std::vector<uint8_t>& frame = frames[i++ % kNumTxSeq];
+    BT_HDR* p_buf = (BT_HDR*)osi_malloc(sizeof(BT_HDR) + frame.size());
+    memcpy(p_buf->data, frame.data(), frame.size());
+    p_buf->offset = L2CAP_PKT_OVERHEAD;
+    p_buf->len = frame.size() - L2CAP_PKT_OVERHEAD;
+    l2c_fcr_proc_pdu(&ccb, p_buf);
+  }
+
+  osi_free_and_reset((void**)&ccb.fcrb.p_rx_sdu);
+  state.SetBytesProcessed(state.iterations() * payload_len);
+}
+
+/* LE advertising reports */
+
+// Event parameters are at most 255 bytes, which fits six of these reports
+constexpr size_t kMaxEventLen = 255;
+
+// Enough distinct advertisers to cycle through the whole inquiry database
+constexpr int kNumAdvertisers = 2 * BTM_INQ_DB_SIZE;
+constexpr int kNumEvents = 16;
+constexpr uint8_t kAdvNonconnInd = 0x03;
+
+size_t reports_seen;
+
+void obs_results(tBTM_INQ_RESULTS* p_inq_results, uint8_t* p_eir,
+                 uint16_t eir_len) {
+  reports_seen++;
+}
+
+// A beacon: flags, a complete local name and manufacturer data, 31 bytes
+const uint8_t kAdvData[] = {
+    0x02, BTM_BLE_AD_TYPE_FLAG, BTM_BLE_GEN_DISC_FLAG,
+    0x09, BTM_BLE_AD_TYPE_NAME_CMPL, 'b', 'e', 'n', 'c', 'h', 'm', 'k',
+    0x11, HCI_EIR_MANUFACTURER_SPECIFIC_TYPE, 0x4c, 0x00, 0x02, 0x15, 0x01, 0x02, 0x03,
+    0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c,
+};
+
+std::vector<uint8_t> make_adv_report_event(int num_reports,
+                                           int* p_advertiser) {
+  std::vector<uint8_t> event(kMaxEventLen);
+  uint8_t* p = event.data();
+  UINT8_TO_STREAM(p, num_reports);
+  for (int i = 0; i < num_reports; i++) {
+    int advertiser = (*p_advertiser)++ % kNumAdvertisers;
+    UINT8_TO_STREAM(p, kAdvNonconnInd);
+    UINT8_TO_STREAM(p, BLE_ADDR_PUBLIC);
+    /* 00:11:22:33:xx:xx, least significant byte first */
+    UINT16_TO_STREAM(p, advertiser);
+    UINT32_TO_STREAM(p, 0x00112233);
+    UINT8_TO_STREAM(p, sizeof(kAdvData));
+    ARRAY_TO_STREAM(p, kAdvData, (int)sizeof(kAdvData));
+    INT8_TO_STREAM(p, -60 - advertiser % 20);
+  }
+  event.resize(p - event.data());
+  return event;
+}
+
+void BM_BleAdvReport(State& state) {
+  btm_cb.ble_ctr_cb.scan_activity = BTM_LE_OBSERVE_ACTIVE;
+  btm_cb.ble_ctr_cb.inq_var.scan_type = BTM_BLE_SCAN_MODE_PASS;
+  btm_cb.ble_ctr_cb.p_obs_results_cb = obs_results;
+  btm_cb.btm_inq_vars.inq_db_max = BTM_INQ_DB_SIZE;
+  reports_seen = 0;
+
+  int num_reports = state.range(0);
+  int advertiser = 0;
+  std::vector<std::vector<uint8_t>> events;
+  for (int i = 0; i < kNumEvents; i++)
+    events.push_back(make_adv_report_event(num_reports, &advertiser));
+
+  size_t i = 0;
+  for (auto _ : state) {
+    const std::vector<uint8_t>& event = events[i++ % kNumEvents];
+    btm_ble_process_adv_pkt(
+        HciLeAdvertisingReportView(event.data(), event.size()));
+  }
+
+  btm_cb.ble_ctr_cb.scan_activity = 0;
+  btm_cb.ble_ctr_cb.p_obs_results_cb = nullptr;
+  if (reports_seen != state.iterations() * num_reports)
+    state.SkipWithError("reports were dropped");
+  state.SetItemsProcessed(state.iterations() * num_reports);
+}
+
+/* GATT server reads */
+
+constexpr uint16_t kServiceHandle = 0x0010;
+
+void BM_GattReadByHandle(State& state) {
+  int num_chars = state.range(0);
+  tGATT_SVC_DB db;
+  std::vector<uint16_t> handles;
+
+  // Each characteristic is a declaration, a value and an extended properties
+  // descriptor
+  gatts_init_service_db(db, Uuid::From16Bit(0x180f), true, kServiceHandle,
+                        1 + 3 * num_chars);
+  handles.push_back(kServiceHandle);
+  for (int i = 0; i < num_chars; i++) {
+    uint16_t value_handle = gatts_add_characteristic(
+        db, GATT_PERM_READ,
+        GATT_CHAR_PROP_BIT_READ | GATT_CHAR_PROP_BIT_EXT_PROP,
+        Uuid::From16Bit(0x2a19 + i));
+    handles.push_back(value_handle - 1);
+    handles.push_back(gatts_add_char_ext_prop_descr(db, 0x0001));
+  }
+
+  tGATT_TCB& tcb = gatt_cb.tcb[0];
+  uint8_t value[GATT_DEF_BLE_MTU_SIZE];
+  size_t i = 0;
+  for (auto _ : state) {
+    uint16_t len = 0;
+    tGATT_STATUS status = gatts_read_attr_value_by_handle(
+        tcb, L2CAP_ATT_CID, &db, GATT_REQ_READ, handles[i++ % handles.size()],
+        0, value, &len, sizeof(value), GATT_SEC_FLAG_ENCRYPTED, 16, 0);
+    if (status != GATT_SUCCESS) {
+      state.SkipWithError("read failed");
+      break;
+    }
+    benchmark::DoNotOptimize(value[0]);
+  }
+}
+
+}  // namespace
+
+BENCHMARK(BM_L2capStreamingRx)->Arg(64)->Arg(672)->Arg(1008);
+BENCHMARK(BM_BleAdvReport)->Arg(1)->Arg(4)->Arg(6);
+BENCHMARK(BM_GattReadByHandle)->Arg(1)->Arg(16)->Arg(64);
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
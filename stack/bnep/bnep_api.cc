@@ -423,6 +423,26 @@ tBNEP_RESULT BNEP_WriteBuf(uint16_t handle, const RawAddress& p_dest_addr,
   return (BNEP_SUCCESS);
 }
 
+/*******************************************************************************
+ *
+ * Function         BNEP_IsTxQueueFull
+ *
+ * Description      This function tells if BNEP_WriteBuf on the connection
+ *                  would fail with BNEP_Q_SIZE_EXCEEDED, so that a caller can
+ *                  hold on to its buffer instead.
+ *
+ * Parameters:      handle       - handle of the connection
+ *
+ * Returns          true if the transmit queue is full
+ *
+ ******************************************************************************/
+bool BNEP_IsTxQueueFull(uint16_t handle) {
+  if ((!handle) || (handle > BNEP_MAX_CONNECTIONS)) return false;
+
+  return fixed_queue_length(bnep_cb.bcb[handle - 1].xmit_q) >=
+         BNEP_MAX_XMITQ_DEPTH;
+}
+
 /*******************************************************************************
  *
  * Function         BNEP_Write
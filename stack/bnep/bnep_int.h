@@ -72,6 +72,16 @@
 /* 802.1p protocol packet will have actual protocol field in side the payload */
 #define BNEP_802_1_P_PROTOCOL 0x8100
 
+/* Protocol types the compiled peer protocol filter keeps a verdict for, so
+ * that the bulk of the traffic needs no range lookup */
+#define BNEP_IPV4_PROTOCOL 0x0800
+#define BNEP_ARP_PROTOCOL 0x0806
+#define BNEP_IPV6_PROTOCOL 0x86DD
+
+#define BNEP_PROT_ALLOWED_IPV4 0x01
+#define BNEP_PROT_ALLOWED_ARP 0x02
+#define BNEP_PROT_ALLOWED_IPV6 0x04
+
 /* Timeout definitions.  */
 /* Connection related timeout */
 #define BNEP_CONN_TIMEOUT_MS (20 * 1000)
@@ -141,6 +151,11 @@ typedef struct {
   uint16_t rcvd_num_filters;
   uint16_t rcvd_prot_filter_start[BNEP_MAX_PROT_FILTERS];
   uint16_t rcvd_prot_filter_end[BNEP_MAX_PROT_FILTERS];
+  /* Peer protocol filters sorted by start and merged into disjoint ranges */
+  uint16_t rcvd_prot_ranges;
+  uint16_t rcvd_prot_range_start[BNEP_MAX_PROT_FILTERS];
+  uint16_t rcvd_prot_range_end[BNEP_MAX_PROT_FILTERS];
+  uint8_t rcvd_prot_allowed; /* BNEP_PROT_ALLOWED_* */
 
   uint16_t rcvd_mcast_filters;
   RawAddress rcvd_mcast_filter_start[BNEP_MAX_MULTI_FILTERS];
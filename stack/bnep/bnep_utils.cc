@@ -42,6 +42,8 @@ using bluetooth::Uuid;
 /******************************************************************************/
 static uint8_t* bnepu_init_hdr(BT_HDR* p_buf, uint16_t hdr_len,
                                uint8_t pkt_type);
+static void bnepu_compile_prot_filters(tBNEP_CONN* p_bcb);
+static bool bnepu_prot_in_ranges(const tBNEP_CONN* p_bcb, uint16_t proto);
 
 void bnepu_process_peer_multicast_filter_set(tBNEP_CONN* p_bcb,
                                              uint8_t* p_filters, uint16_t len);
@@ -945,10 +947,96 @@ void bnepu_process_peer_filter_set(tBNEP_CONN* p_bcb, uint8_t* p_filters,
     p_bcb->rcvd_prot_filter_start[xx] = start;
     p_bcb->rcvd_prot_filter_end[xx] = end;
   }
+  bnepu_compile_prot_filters(p_bcb);
 
   bnepu_send_peer_filter_rsp(p_bcb, resp_code);
 }
 
+/*******************************************************************************
+ *
+ * Function         bnepu_compile_prot_filters
+ *
+ * Description      This function turns the protocol filters received from the
+ *                  peer into sorted, disjoint ranges for binary search and
+ *                  precomputes the verdict for the common protocol types.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void bnepu_compile_prot_filters(tBNEP_CONN* p_bcb) {
+  uint16_t num_ranges = 0;
+  uint16_t xx, yy;
+
+  /* Insertion sort on the start value, the peer sends only a few ranges */
+  for (xx = 0; xx < p_bcb->rcvd_num_filters; xx++) {
+    uint16_t start = p_bcb->rcvd_prot_filter_start[xx];
+    uint16_t end = p_bcb->rcvd_prot_filter_end[xx];
+
+    for (yy = num_ranges;
+         yy > 0 && p_bcb->rcvd_prot_range_start[yy - 1] > start; yy--) {
+      p_bcb->rcvd_prot_range_start[yy] = p_bcb->rcvd_prot_range_start[yy - 1];
+      p_bcb->rcvd_prot_range_end[yy] = p_bcb->rcvd_prot_range_end[yy - 1];
+    }
+    p_bcb->rcvd_prot_range_start[yy] = start;
+    p_bcb->rcvd_prot_range_end[yy] = end;
+    num_ranges++;
+  }
+
+  /* Merge overlapping and adjacent ranges */
+  if (num_ranges) {
+    yy = 0;
+    for (xx = 1; xx < num_ranges; xx++) {
+      if (p_bcb->rcvd_prot_range_start[xx] <=
+          (uint32_t)p_bcb->rcvd_prot_range_end[yy] + 1) {
+        if (p_bcb->rcvd_prot_range_end[xx] > p_bcb->rcvd_prot_range_end[yy])
+          p_bcb->rcvd_prot_range_end[yy] = p_bcb->rcvd_prot_range_end[xx];
+      } else {
+        yy++;
+        p_bcb->rcvd_prot_range_start[yy] = p_bcb->rcvd_prot_range_start[xx];
+        p_bcb->rcvd_prot_range_end[yy] = p_bcb->rcvd_prot_range_end[xx];
+      }
+    }
+    num_ranges = yy + 1;
+  }
+  p_bcb->rcvd_prot_ranges = num_ranges;
+
+  p_bcb->rcvd_prot_allowed = 0;
+  if (bnepu_prot_in_ranges(p_bcb, BNEP_IPV4_PROTOCOL))
+    p_bcb->rcvd_prot_allowed |= BNEP_PROT_ALLOWED_IPV4;
+  if (bnepu_prot_in_ranges(p_bcb, BNEP_ARP_PROTOCOL))
+    p_bcb->rcvd_prot_allowed |= BNEP_PROT_ALLOWED_ARP;
+  if (bnepu_prot_in_ranges(p_bcb, BNEP_IPV6_PROTOCOL))
+    p_bcb->rcvd_prot_allowed |= BNEP_PROT_ALLOWED_IPV6;
+
+  BNEP_TRACE_DEBUG("BNEP %d protocol filters compiled to %d ranges",
+                   p_bcb->rcvd_num_filters, num_ranges);
+}
+
+/*******************************************************************************
+ *
+ * Function         bnepu_prot_in_ranges
+ *
+ * Description      This function looks the protocol up in the compiled peer
+ *                  protocol filter ranges.
+ *
+ * Returns          true if one of the ranges holds the protocol
+ *
+ ******************************************************************************/
+static bool bnepu_prot_in_ranges(const tBNEP_CONN* p_bcb, uint16_t proto) {
+  int lo = 0, hi = (int)p_bcb->rcvd_prot_ranges - 1;
+
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    if (proto < p_bcb->rcvd_prot_range_start[mid])
+      hi = mid - 1;
+    else if (proto > p_bcb->rcvd_prot_range_end[mid])
+      lo = mid + 1;
+    else
+      return true;
+  }
+  return false;
+}
+
 /*******************************************************************************
  *
  * Function         bnepu_process_peer_filter_rsp
@@ -1261,7 +1349,8 @@ tBNEP_RESULT bnep_is_packet_allowed(tBNEP_CONN* p_bcb,
                                     uint16_t protocol, bool fw_ext_present,
                                     uint8_t* p_data, uint16_t org_len) {
   if (p_bcb->rcvd_num_filters) {
-    uint16_t i, proto;
+    uint16_t proto;
+    bool allowed;
 
     /* Findout the actual protocol to check for the filtering */
     proto = protocol;
@@ -1290,13 +1379,22 @@ tBNEP_RESULT bnep_is_packet_allowed(tBNEP_CONN* p_bcb,
       BE_STREAM_TO_UINT16(proto, p_data);
     }
 
-    for (i = 0; i < p_bcb->rcvd_num_filters; i++) {
-      if ((p_bcb->rcvd_prot_filter_start[i] <= proto) &&
-          (proto <= p_bcb->rcvd_prot_filter_end[i]))
+    switch (proto) {
+      case BNEP_IPV4_PROTOCOL:
+        allowed = (p_bcb->rcvd_prot_allowed & BNEP_PROT_ALLOWED_IPV4) != 0;
+        break;
+      case BNEP_ARP_PROTOCOL:
+        allowed = (p_bcb->rcvd_prot_allowed & BNEP_PROT_ALLOWED_ARP) != 0;
+        break;
+      case BNEP_IPV6_PROTOCOL:
+        allowed = (p_bcb->rcvd_prot_allowed & BNEP_PROT_ALLOWED_IPV6) != 0;
+        break;
+      default:
+        allowed = bnepu_prot_in_ranges(p_bcb, proto);
         break;
     }
 
-    if (i == p_bcb->rcvd_num_filters) {
+    if (!allowed) {
       BNEP_TRACE_DEBUG("Ignoring protocol 0x%x in BNEP data write", proto);
       return BNEP_IGNORE_CMD;
     }
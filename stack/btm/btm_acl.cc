@@ -42,6 +42,7 @@
 #include "bt_types.h"
 #include "bt_utils.h"
 #include "btm_api.h"
+#include "btm_conn_trace.h"
 #include "btm_int.h"
 #include "btu.h"
 #include "device/include/controller.h"
@@ -49,6 +50,7 @@
 #include "hcidefs.h"
 #include "hcimsgs.h"
 #include "l2c_int.h"
+#include "osi/include/open_hash_map.h"
 #include "osi/include/osi.h"
 #include "device/include/interop_config.h"
 #include "btif_av_co.h"
@@ -76,6 +78,11 @@ extern void btm_iot_save_remote_versions(tACL_CONN *p_acl_cb);
 
 static uint16_t Whitelisted_lmp_manufacture = 0x000a;
 
+/* Caches hci_handle -> acl_db index. Entries are validated against acl_db on
+ * lookup, so a stale entry only costs a fallback scan. */
+static system_bt_osi::OpenHashMap<uint16_t, uint8_t> acl_handle_index(
+    MAX_L2CAP_LINKS);
+
 /*******************************************************************************
  *
  * Function         btm_acl_init
@@ -90,6 +97,7 @@ void btm_acl_init(void) {
   /* Initialize nonzero defaults */
   btm_cb.btm_def_link_super_tout = HCI_DEFAULT_INACT_TOUT;
   btm_cb.acl_disc_reason = 0xff;
+  acl_handle_index.Clear();
 }
 
 /*******************************************************************************
@@ -163,8 +171,16 @@ uint8_t btm_handle_to_acl_index(uint16_t hci_handle) {
   tACL_CONN* p = &btm_cb.acl_db[0];
   uint8_t xx;
   BTM_TRACE_DEBUG("btm_handle_to_acl_index");
+
+  const uint8_t* cached = acl_handle_index.Find(hci_handle);
+  if (cached != nullptr && btm_cb.acl_db[*cached].in_use &&
+      btm_cb.acl_db[*cached].hci_handle == hci_handle) {
+    return (*cached);
+  }
+
   for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p++) {
     if ((p->in_use) && (p->hci_handle == hci_handle)) {
+      acl_handle_index.Insert(hci_handle, xx);
       break;
     }
   }
@@ -243,10 +259,12 @@ void btm_acl_created(const RawAddress& bda, DEV_CLASS dc, BD_NAME bdn,
 
   BTM_TRACE_WARNING("btm_acl_created hci_handle=%d link_role=%d  transport=%d",
                   hci_handle, link_role, transport);
+  btm_conn_trace_mark(bda, transport, BTM_CONN_TRACE_ACL_CONNECTED);
   /* Ensure we don't have duplicates */
   p = btm_bda_to_acl(bda, transport);
   if (p != (tACL_CONN*)NULL) {
     p->hci_handle = hci_handle;
+    acl_handle_index.Insert(hci_handle, p - btm_cb.acl_db);
     p->link_role = link_role;
     p->transport = transport;
     VLOG(1) << "Duplicate btm_acl_created: RemBdAddr: " << bda;
@@ -260,6 +278,7 @@ void btm_acl_created(const RawAddress& bda, DEV_CLASS dc, BD_NAME bdn,
     if (!p->in_use) {
       p->in_use = true;
       p->hci_handle = hci_handle;
+      acl_handle_index.Insert(hci_handle, xx);
       p->link_role = link_role;
       p->link_up_issued = false;
       p->remote_addr = bda;
@@ -315,6 +334,20 @@ void btm_acl_created(const RawAddress& bda, DEV_CLASS dc, BD_NAME bdn,
         BTM_TRACE_DEBUG("device_type=0x%x", p_dev_rec->device_type);
       }
 
+      if (transport == BT_TRANSPORT_BR_EDR) {
+        /* Only what is not known about the device is read, and the reads are
+         * sent together rather than from each other's completion */
+        if (p_dev_rec) btm_sec_load_conn_profile(p_dev_rec);
+
+        if (p_dev_rec && p_dev_rec->rmt_version_known) {
+          p->lmp_version = p_dev_rec->lmp_version;
+          p->manufacturer = p_dev_rec->manufacturer;
+          p->lmp_subversion = p_dev_rec->lmp_subversion;
+        } else {
+          btsnd_hcic_rmt_ver_req(p->hci_handle);
+        }
+      }
+
       if (p_dev_rec && !(transport == BT_TRANSPORT_LE)) {
         /* If remote features already known, copy them and continue connection
          * setup */
@@ -340,6 +373,11 @@ void btm_acl_created(const RawAddress& bda, DEV_CLASS dc, BD_NAME bdn,
       }
 
       /* If here, features are not known yet */
+      if (transport == BT_TRANSPORT_BR_EDR) {
+        btm_read_remote_features(p->hci_handle);
+        return;
+      }
+
       if (p_dev_rec && transport == BT_TRANSPORT_LE) {
 #if (BLE_PRIVACY_SPT == TRUE)
         btm_ble_get_acl_remote_addr(p_dev_rec, p->active_remote_addr,
@@ -409,9 +447,11 @@ void btm_acl_removed(const RawAddress& bda, tBT_TRANSPORT transport) {
   tACL_CONN* p;
   tBTM_SEC_DEV_REC* p_dev_rec = NULL;
   BTM_TRACE_DEBUG("btm_acl_removed");
+  btm_conn_trace_disconnected(bda, transport);
   p = btm_bda_to_acl(bda, transport);
   if (p != (tACL_CONN*)NULL) {
     p->in_use = false;
+    acl_handle_index.Erase(p->hci_handle);
 
     /* if the disconnected channel has a pending role switch, clear it now */
     btm_acl_report_role_change(HCI_ERR_NO_CONNECTION, &bda);
@@ -1042,9 +1082,18 @@ void btm_read_remote_version_complete(uint8_t* p) {
         STREAM_TO_UINT8(p_acl_cb->lmp_version, p);
         STREAM_TO_UINT16(p_acl_cb->manufacturer, p);
         STREAM_TO_UINT16(p_acl_cb->lmp_subversion, p);
+        btm_conn_trace_mark(p_acl_cb->remote_addr, p_acl_cb->transport,
+                            BTM_CONN_TRACE_REMOTE_VERSION);
         if (p_acl_cb->transport == BT_TRANSPORT_BR_EDR) {
-          BTM_TRACE_DEBUG("Calling btm_read_remote_features");
-          btm_read_remote_features (p_acl_cb->hci_handle);
+          /* The features were requested with the version, see
+           * btm_acl_created. Keep the version for the next connection. */
+          tBTM_SEC_DEV_REC* p_dev_rec = btm_find_dev_by_handle(handle);
+          if (p_dev_rec) {
+            p_dev_rec->rmt_version_known = true;
+            p_dev_rec->lmp_version = p_acl_cb->lmp_version;
+            p_dev_rec->manufacturer = p_acl_cb->manufacturer;
+            p_dev_rec->lmp_subversion = p_acl_cb->lmp_subversion;
+          }
         }
     }
 
@@ -1407,6 +1456,8 @@ void btm_read_remote_ext_features_failed(uint8_t status, uint16_t handle) {
 void btm_establish_continue(tACL_CONN* p_acl_cb) {
   tBTM_BL_EVENT_DATA evt_data;
   BTM_TRACE_DEBUG("btm_establish_continue");
+  btm_conn_trace_mark(p_acl_cb->remote_addr, p_acl_cb->transport,
+                      BTM_CONN_TRACE_REMOTE_FEATURES);
 #if (BTM_BYPASS_EXTRA_ACL_SETUP == FALSE)
   if (p_acl_cb->transport == BT_TRANSPORT_BR_EDR) {
     /* For now there are a some devices that do not like sending */
@@ -1507,6 +1558,29 @@ tBTM_STATUS BTM_SetLinkSuperTout(const RawAddress& remote_bda,
   return (BTM_UNKNOWN_ADDR);
 }
 
+/*******************************************************************************
+ *
+ * Function         BTM_ExcludeAclPacketTypes
+ *
+ * Description      Restricts the ACL packet types of the link to the ones
+ *                  supported by both devices, minus the EDR packet types in
+ *                  |excluded|. Passing 0 allows all packet types again.
+ *
+ * Returns          status of the operation
+ *
+ ******************************************************************************/
+tBTM_STATUS BTM_ExcludeAclPacketTypes(const RawAddress& remote_bda,
+                                      uint16_t excluded) {
+  tACL_CONN* p = btm_bda_to_acl(remote_bda, BT_TRANSPORT_BR_EDR);
+
+  BTM_TRACE_DEBUG("%s excluded: 0x%04x", __func__, excluded);
+  if (p == NULL) return (BTM_UNKNOWN_ADDR);
+
+  return btm_set_packet_types(
+      p, btm_cb.btm_acl_pkt_types_supported |
+             (excluded & BTM_ACL_EXCEPTION_PKTS_MASK));
+}
+
 /*******************************************************************************
  *
  * Function         BTM_IsAclConnectionUp
@@ -1604,9 +1678,8 @@ uint16_t BTM_GetHCIConnHandle(const RawAddress& remote_bda,
  ******************************************************************************/
 void btm_process_clk_off_comp_evt(uint16_t hci_handle, uint16_t clock_offset) {
   uint8_t xx;
-  BTM_TRACE_DEBUG("btm_process_clk_off_comp_evt ,req remote version");
+  BTM_TRACE_DEBUG("btm_process_clk_off_comp_evt");
 
-  btsnd_hcic_rmt_ver_req(hci_handle);
   /* Look up the connection by handle and set the current mode */
   xx = btm_handle_to_acl_index(hci_handle);
   if (xx < MAX_L2CAP_LINKS) btm_cb.acl_db[xx].clock_offset = clock_offset;
@@ -116,6 +116,7 @@ bool BTM_SecAddBleDevice(const RawAddress& bd_addr, BD_NAME bd_name,
   p_dev_rec->ble.ble_addr_type = addr_type;
 
   p_dev_rec->ble.pseudo_addr = bd_addr;
+  btm_sec_dev_rec_reindex(p_dev_rec);
   /* sync up with the Inq Data base*/
   tBTM_INQ_INFO* p_info = BTM_InqDbRead(bd_addr);
   if (p_info) {
@@ -196,6 +197,52 @@ bool BTM_SecAddBleKey(const RawAddress& bd_addr, tBTM_LE_KEY_VALUE* p_le_key,
   return (true);
 }
 
+/*******************************************************************************
+ *
+ * Function         BTM_BleResolvingListBatch
+ *
+ * Description      Start or end a batch of BTM_SecAddBleKey calls. The
+ *                  identity keys added in the batch are put in the controller
+ *                  resolving list with a single address resolution
+ *                  disable/enable cycle.
+ *
+ * Parameters:      start - true to start a batch, false to end it.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void BTM_BleResolvingListBatch(bool start) {
+#if (BLE_PRIVACY_SPT == TRUE)
+  if (start)
+    btm_ble_resolving_list_batch_start();
+  else
+    btm_ble_resolving_list_batch_end();
+#endif
+}
+
+/*******************************************************************************
+ *
+ * Function         BTM_BleSyncResolvingList
+ *
+ * Description      Bring the controller resolving list in line with the
+ *                  identity keys known to the stack, with a single address
+ *                  resolution disable/enable cycle.
+ *
+ * Parameters:      p_cback - called once when the synchronization completes.
+ *
+ * Returns          BTM_CMD_STARTED if started, BTM_BUSY if one is running,
+ *                  BTM_MODE_UNSUPPORTED without controller based privacy.
+ *
+ ******************************************************************************/
+tBTM_STATUS BTM_BleSyncResolvingList(tBTM_BLE_RL_SYNC_CBACK* p_cback) {
+#if (BLE_PRIVACY_SPT == TRUE)
+  tBTM_STATUS status = btm_ble_resolving_list_sync(BTM_BLE_RL_IDLE, p_cback);
+  return (status == BTM_WRONG_MODE) ? BTM_MODE_UNSUPPORTED : status;
+#else
+  return BTM_MODE_UNSUPPORTED;
+#endif
+}
+
 /*******************************************************************************
  *
  * Function         BTM_BleLoadLocalKeys
@@ -1039,6 +1086,7 @@ void BTM_BleSetPhy(const RawAddress& bd_addr, uint8_t tx_phys, uint8_t rx_phys,
       __func__, all_phys, tx_phys, rx_phys, phy_options);
 
   uint16_t handle = p_acl->hci_handle;
+  p_acl->ble_phy_app_set = true;
 
   // checking if local controller supports it!
   if (!controller_get_interface()->supports_ble_2m_phy() &&
@@ -1459,6 +1507,8 @@ void btm_sec_save_le_key(const RawAddress& bd_addr, tBTM_LE_KEY_TYPE key_type,
         p_rec->ble.identity_addr = p_keys->pid_key.identity_addr;
         p_rec->ble.identity_addr_type = p_keys->pid_key.identity_addr_type;
         p_rec->ble.key_type |= BTM_LE_KEY_PID;
+        btm_sec_dev_rec_reindex(p_rec);
+        btm_ble_resolver_irk_added();
         BTM_TRACE_DEBUG(
             "%s: BTM_LE_KEY_PID key_type=0x%x save peer IRK, change bd_addr=%s "
             "to id_addr=%s id_addr_type=0x%x",
@@ -1473,6 +1523,7 @@ void btm_sec_save_le_key(const RawAddress& bd_addr, tBTM_LE_KEY_TYPE key_type,
 #endif
         /* update device record address as identity address */
         p_rec->bd_addr = p_keys->pid_key.identity_addr;
+        btm_sec_dev_rec_reindex(p_rec);
         /* combine DUMO device security record if needed */
         btm_consolidate_dev(p_rec);
         break;
@@ -2080,6 +2131,7 @@ void btm_ble_connected(const RawAddress& bda, uint16_t handle, uint8_t enc_mode,
   p_dev_rec->ble.ble_addr_type = addr_type;
   /* update pseudo address */
   p_dev_rec->ble.pseudo_addr = bda;
+  btm_sec_dev_rec_reindex(p_dev_rec);
 
   p_dev_rec->role_master = false;
   if (role == HCI_ROLE_MASTER) p_dev_rec->role_master = true;
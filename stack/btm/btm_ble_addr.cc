@@ -25,12 +25,17 @@
 #include <base/bind.h>
 #include <string.h>
 
+#include <algorithm>
+#include <list>
+#include <unordered_map>
+
 #include "bt_types.h"
 #include "btm_int.h"
 #include "btu.h"
 #include "device/include/controller.h"
 #include "gap_api.h"
 #include "hcimsgs.h"
+#include "osi/include/time.h"
 
 #include "btm_ble_int.h"
 #include "stack/crypto_toolbox/crypto_toolbox.h"
@@ -175,15 +180,56 @@ bool btm_ble_init_pseudo_addr(tBTM_SEC_DEV_REC* p_dev_rec,
                               const RawAddress& new_pseudo_addr) {
   if (p_dev_rec->ble.pseudo_addr.IsEmpty()) {
     p_dev_rec->ble.pseudo_addr = new_pseudo_addr;
+    btm_sec_dev_rec_reindex(p_dev_rec);
     return true;
   }
 
   return false;
 }
 
-/* Return true if given Resolvable Privae Address |rpa| matches Identity
- * Resolving Key |irk| */
-static bool rpa_matches_irk(const RawAddress& rpa, const Octet16& irk) {
+namespace {
+
+/* IRK of a device record with its AES key schedule expanded, so resolving an
+ * RPA costs a single block encryption */
+struct IrkSchedule {
+  Octet16 irk;
+  aes_context ctx;
+  bool valid = false;
+};
+
+/* Result of resolving one RPA; |p_dev_rec| is nullptr if no record matched */
+struct RpaCacheEntry {
+  RawAddress rpa;
+  tBTM_SEC_DEV_REC* p_dev_rec;
+  uint64_t time_ms;
+};
+
+/* Number of recently seen RPAs whose resolution is remembered */
+constexpr size_t kRpaCacheSize = 32;
+/* Default RPA rotation interval; a peer is expected to move on to a new RPA
+ * after it, so older results are not worth keeping */
+constexpr uint64_t kRpaCacheTimeoutMs = 15 * 60 * 1000;
+
+std::unordered_map<const tBTM_SEC_DEV_REC*, IrkSchedule> irk_schedules;
+/* Most recently resolved first */
+std::list<RpaCacheEntry> rpa_cache;
+
+const aes_context& irk_schedule(const tBTM_SEC_DEV_REC* p_dev_rec) {
+  IrkSchedule& schedule = irk_schedules[p_dev_rec];
+  if (!schedule.valid || schedule.irk != p_dev_rec->ble.keys.irk) {
+    schedule.irk = p_dev_rec->ble.keys.irk;
+    crypto_toolbox::aes_128_set_key(schedule.irk, &schedule.ctx);
+    schedule.valid = true;
+  }
+  return schedule.ctx;
+}
+
+}  // namespace
+
+/* Return true if given Resolvable Privae Address |rpa| matches the Identity
+ * Resolving Key of |p_dev_rec| */
+static bool rpa_matches_irk(const RawAddress& rpa,
+                            const tBTM_SEC_DEV_REC* p_dev_rec) {
   /* use the 3 MSB of bd address as prand */
   uint8_t rand[3];
   rand[0] = rpa.address[2];
@@ -191,7 +237,7 @@ static bool rpa_matches_irk(const RawAddress& rpa, const Octet16& irk) {
   rand[2] = rpa.address[0];
 
   /* generate X = E irk(R0, R1, R2) and R is random address 3 LSO */
-  Octet16 x = crypto_toolbox::aes_128(irk, &rand[0], 3);
+  Octet16 x = crypto_toolbox::aes_128(irk_schedule(p_dev_rec), &rand[0], 3);
 
   rand[0] = rpa.address[5];
   rand[1] = rpa.address[4];
@@ -205,6 +251,11 @@ static bool rpa_matches_irk(const RawAddress& rpa, const Octet16& irk) {
   return false;
 }
 
+static bool btm_ble_has_irk(const tBTM_SEC_DEV_REC* p_dev_rec) {
+  return (p_dev_rec->device_type & BT_DEVICE_TYPE_BLE) &&
+         (p_dev_rec->ble.key_type & BTM_LE_KEY_PID);
+}
+
 /** This function checks if a RPA is resolvable by the device key.
  *  Returns true is resolvable; false otherwise.
  */
@@ -212,11 +263,10 @@ bool btm_ble_addr_resolvable(const RawAddress& rpa,
                              tBTM_SEC_DEV_REC* p_dev_rec) {
   if (!BTM_BLE_IS_RESOLVE_BDA(rpa)) return false;
 
-  if ((p_dev_rec->device_type & BT_DEVICE_TYPE_BLE) &&
-      (p_dev_rec->ble.key_type & BTM_LE_KEY_PID)) {
+  if (btm_ble_has_irk(p_dev_rec)) {
     BTM_TRACE_DEBUG("%s try to resolve", __func__);
 
-    if (rpa_matches_irk(rpa, p_dev_rec->ble.keys.irk)) {
+    if (rpa_matches_irk(rpa, p_dev_rec)) {
       btm_ble_init_pseudo_addr(p_dev_rec, rpa);
       return true;
     }
@@ -227,30 +277,24 @@ bool btm_ble_addr_resolvable(const RawAddress& rpa,
 /** This function match the random address to the appointed device record,
  * starting from calculating IRK. If the record index exceeds the maximum record
  * number, matching failed and send a callback. */
-static bool btm_ble_match_random_bda(void* data, void* context) {
-  RawAddress* random_bda = (RawAddress*)context;
-
-  tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(data);
-
-
-  if (!(p_dev_rec->device_type & BT_DEVICE_TYPE_BLE) ||
-      !(p_dev_rec->ble.key_type & BTM_LE_KEY_PID)) {
+static bool btm_ble_match_random_bda(const RawAddress& random_bda,
+                                     const tBTM_SEC_DEV_REC* p_dev_rec) {
+  if (!btm_ble_has_irk(p_dev_rec)) {
     BTM_TRACE_EVENT("%s not a LE paired device ,sec_flags = %02x device_type = %d", __func__,
                   p_dev_rec->sec_flags, p_dev_rec->device_type);
-    return true;
+    return false;
   }
 
-  if (rpa_matches_irk(*random_bda, p_dev_rec->ble.keys.irk)) {
+  if (rpa_matches_irk(random_bda, p_dev_rec)) {
     BTM_TRACE_EVENT("%s match is found ,sec_flags = %02x device_type = %d", __func__,
                   p_dev_rec->sec_flags, p_dev_rec->device_type);
-    // if it was match, finish iteration, otherwise continue
-    return false;
+    return true;
   }
 
   // not a match, continue iteration
   BTM_TRACE_DEBUG("%s next iteration ,sec_flags = %02x device_type = %d", __func__,
                   p_dev_rec->sec_flags, p_dev_rec->device_type);
-  return true;
+  return false;
 }
 
 /** This function is called to resolve a random address.
@@ -260,19 +304,57 @@ static bool btm_ble_match_random_bda(void* data, void* context) {
 tBTM_SEC_DEV_REC* btm_ble_resolve_random_addr(const RawAddress& random_bda) {
   BTM_TRACE_EVENT("%s", __func__);
 
+  uint64_t now_ms = time_get_os_boottime_ms();
+  auto it = std::find_if(rpa_cache.begin(), rpa_cache.end(),
+                         [&random_bda](const RpaCacheEntry& entry) {
+                           return entry.rpa == random_bda;
+                         });
+  if (it != rpa_cache.end()) {
+    /* a record that matched is checked again, its keys might have changed */
+    if (now_ms - it->time_ms < kRpaCacheTimeoutMs &&
+        (it->p_dev_rec == nullptr || (btm_ble_has_irk(it->p_dev_rec) &&
+                                      rpa_matches_irk(random_bda,
+                                                      it->p_dev_rec)))) {
+      rpa_cache.splice(rpa_cache.begin(), rpa_cache, it);
+      BTM_TRACE_EVENT("%s:  %sresolved (cached)", __func__,
+                      (it->p_dev_rec == nullptr ? "not " : ""));
+      return it->p_dev_rec;
+    }
+    rpa_cache.erase(it);
+  }
+
   /* start to resolve random address */
   /* check for next security record */
 
-  list_node_t* n = list_foreach(btm_cb.sec_dev_rec, btm_ble_match_random_bda,
-                                (void*)&random_bda);
-  tBTM_SEC_DEV_REC* p_dev_rec = nullptr;
-  if (n != nullptr) p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  tBTM_SEC_DEV_REC* p_dev_rec = btm_cb.sec_dev_rec.Find(
+      [&random_bda](const tBTM_SEC_DEV_REC* p_rec) {
+        return btm_ble_match_random_bda(random_bda, p_rec);
+      });
+
+  rpa_cache.push_front({random_bda, p_dev_rec, now_ms});
+  if (rpa_cache.size() > kRpaCacheSize) rpa_cache.pop_back();
 
   BTM_TRACE_EVENT("%s:  %sresolved", __func__,
                   (p_dev_rec == nullptr ? "not " : ""));
   return p_dev_rec;
 }
 
+/** This function is called when the security record |p_dev_rec| is about to
+ * be freed, and drops everything the RPA resolver remembers about it. */
+void btm_ble_resolver_forget_dev(const tBTM_SEC_DEV_REC* p_dev_rec) {
+  irk_schedules.erase(p_dev_rec);
+  rpa_cache.remove_if([p_dev_rec](const RpaCacheEntry& entry) {
+    return entry.p_dev_rec == p_dev_rec;
+  });
+}
+
+/** This function is called when a peer IRK is stored. RPAs that did not
+ * resolve before might resolve with it, so negative results are dropped. */
+void btm_ble_resolver_irk_added(void) {
+  rpa_cache.remove_if(
+      [](const RpaCacheEntry& entry) { return entry.p_dev_rec == nullptr; });
+}
+
 /*******************************************************************************
  *  address mapping between pseudo address and real connection address
  ******************************************************************************/
@@ -280,21 +362,16 @@ tBTM_SEC_DEV_REC* btm_ble_resolve_random_addr(const RawAddress& random_bda) {
 tBTM_SEC_DEV_REC* btm_find_dev_by_identity_addr(const RawAddress& bd_addr,
                                                 uint8_t addr_type) {
 #if (BLE_PRIVACY_SPT == TRUE)
-  list_node_t* end = list_end(btm_cb.sec_dev_rec);
-  for (list_node_t* node = list_begin(btm_cb.sec_dev_rec); node != end;
-       node = list_next(node)) {
-    tBTM_SEC_DEV_REC* p_dev_rec =
-        static_cast<tBTM_SEC_DEV_REC*>(list_node(node));
-    if (p_dev_rec->ble.identity_addr == bd_addr) {
-      if ((p_dev_rec->ble.identity_addr_type & (~BLE_ADDR_TYPE_ID_BIT)) !=
-          (addr_type & (~BLE_ADDR_TYPE_ID_BIT)))
-        BTM_TRACE_WARNING(
-            "%s find pseudo->random match with diff addr type: %d vs %d",
-            __func__, p_dev_rec->ble.identity_addr_type, addr_type);
-
-      /* found the match */
-      return p_dev_rec;
-    }
+  tBTM_SEC_DEV_REC* p_dev_rec = btm_find_dev_by_identity_addr_index(bd_addr);
+  if (p_dev_rec) {
+    if ((p_dev_rec->ble.identity_addr_type & (~BLE_ADDR_TYPE_ID_BIT)) !=
+        (addr_type & (~BLE_ADDR_TYPE_ID_BIT)))
+      BTM_TRACE_WARNING(
+          "%s find pseudo->random match with diff addr type: %d vs %d",
+          __func__, p_dev_rec->ble.identity_addr_type, addr_type);
+
+    /* found the match */
+    return p_dev_rec;
   }
 #endif
 
@@ -702,7 +702,9 @@ void BTM_LE_PF_set(tBTM_BLE_PF_FILT_INDEX filt_index,
                    std::vector<ApcfCommand> commands,
                    tBTM_BLE_PF_CFG_CBACK cb) {
   if (!is_filtering_supported()) {
-    cb.Run(0, BTM_BLE_PF_ENABLE, 1 /* BTA_FAILURE */);
+    /* Filter on the host when the controller can't */
+    btm_ble_host_filter_add(filt_index, commands);
+    cb.Run(0, BTM_BLE_SCAN_COND_ADD, 0 /* BTA_SUCCESS */);
     return;
   }
 
@@ -840,7 +842,8 @@ void BTM_LE_PF_set(tBTM_BLE_PF_FILT_INDEX filt_index,
 void BTM_LE_PF_clear(tBTM_BLE_PF_FILT_INDEX filt_index,
                      tBTM_BLE_PF_CFG_CBACK cb) {
   if (!is_filtering_supported()) {
-    cb.Run(0, BTM_BLE_PF_ENABLE, 1 /* BTA_FAILURE */);
+    btm_ble_host_filter_clear(filt_index);
+    cb.Run(0, BTM_BLE_SCAN_COND_CLEAR, 0 /* BTA_SUCCESS */);
     return;
   }
 
@@ -933,7 +936,8 @@ void BTM_BleAdvFilterParamSetup(
   uint8_t param[len], *p;
 
   if (!is_filtering_supported()) {
-    cb.Run(0, BTM_BLE_PF_ENABLE, 1 /* BTA_FAILURE */);
+    btm_ble_host_filter_param_setup(action, filt_index, p_filt_params.get());
+    cb.Run(0, action, 0 /* BTA_SUCCESS */);
     return;
   }
 
@@ -1070,7 +1074,8 @@ void enable_cmpl_cback(tBTM_BLE_PF_STATUS_CBACK p_stat_cback, uint8_t* p,
 void BTM_BleEnableDisableFilterFeature(uint8_t enable,
                                        tBTM_BLE_PF_STATUS_CBACK p_stat_cback) {
   if (!is_filtering_supported()) {
-    if (p_stat_cback) p_stat_cback.Run(BTM_BLE_PF_ENABLE, 1 /* BTA_FAILURE */);
+    btm_ble_host_filter_enable(enable != 0);
+    if (p_stat_cback) p_stat_cback.Run(enable, 0 /* BTA_SUCCESS */);
     return;
   }
 
@@ -1123,4 +1128,5 @@ void btm_ble_adv_filter_init(void) {
  ******************************************************************************/
 void btm_ble_adv_filter_cleanup(void) {
   osi_free_and_reset((void**)&btm_ble_adv_filt_cb.p_addr_filter_count);
+  btm_ble_host_filter_cleanup();
 }
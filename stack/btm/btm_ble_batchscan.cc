@@ -29,6 +29,7 @@
 #include "btu.h"
 #include "device/include/controller.h"
 #include "hcimsgs.h"
+#include "osi/include/properties.h"
 
 using base::Bind;
 using base::Callback;
@@ -246,6 +247,52 @@ void btm_ble_read_batchscan_reports(tBTM_BLE_BATCH_SCAN_MODE scan_mode,
   btu_hcif_send_cmd_with_cb(FROM_HERE, HCI_BLE_BATCH_SCAN_OCF, param, len, cb);
 }
 
+/* read reports in streaming mode. Each batch of records is handed to |cb| as
+ * soon as the controller returns it, the end of the buffer is reported with
+ * an empty batch */
+void read_reports_stream_cb(tBTM_BLE_SCAN_REP_CBACK cb, uint8_t* p,
+                            uint16_t len) {
+  if (len < 2) {
+    BTM_TRACE_ERROR("%s: wrong length", __func__);
+    return;
+  }
+
+  uint8_t status, subcode;
+  STREAM_TO_UINT8(status, p);
+  STREAM_TO_UINT8(subcode, p);
+
+  uint8_t expected_opcode = BTM_BLE_BATCH_SCAN_READ_RESULTS;
+  if (subcode != expected_opcode) {
+    BTM_TRACE_ERROR("%s: bad subcode, expected: %d got: %d", __func__,
+                    expected_opcode, subcode);
+    return;
+  }
+
+  if (len < 4) {
+    BTM_TRACE_ERROR("%s: wrong length", __func__);
+    return;
+  }
+
+  uint8_t report_format, num_records;
+  STREAM_TO_UINT8(report_format, p);
+  STREAM_TO_UINT8(num_records, p);
+
+  BTM_TRACE_DEBUG("%s: status=%d,len=%d,rec=%d", __func__, status, len - 4,
+                  num_records);
+
+  if (num_records == 0 || len == 4) {
+    cb.Run(status, report_format, 0, {});
+    return;
+  }
+
+  cb.Run(status, report_format, num_records,
+         std::vector<uint8_t>(p, p + len - 4));
+
+  /* More records could be in the buffer and needs to be pulled out */
+  btm_ble_read_batchscan_reports(report_format,
+                                 base::Bind(&read_reports_stream_cb, cb));
+}
+
 /* read reports. data is accumulated in |data_all|, number of records is
  * accumulated in |num_records_all| */
 void read_reports_cb(std::vector<uint8_t> data_all, uint8_t num_records_all,
@@ -512,6 +559,12 @@ void BTM_BleReadScanReports(tBTM_BLE_BATCH_SCAN_MODE scan_mode,
     return;
   }
 
+  if (ble_batchscan_cb.streaming) {
+    btm_ble_read_batchscan_reports(scan_mode,
+                                   base::Bind(&read_reports_stream_cb, cb));
+    return;
+  }
+
   btm_ble_read_batchscan_reports(
       scan_mode, base::Bind(&read_reports_cb, std::vector<uint8_t>(), 0, cb));
   return;
@@ -546,6 +599,8 @@ void btm_ble_batchscan_init(void) {
   BTM_TRACE_EVENT(" btm_ble_batchscan_init");
   memset(&ble_batchscan_cb, 0, sizeof(tBTM_BLE_BATCH_SCAN_CB));
   memset(&ble_advtrack_cb, 0, sizeof(tBTM_BLE_ADV_TRACK_CB));
+  ble_batchscan_cb.streaming = osi_property_get_bool(
+      "persist.vendor.btstack.enable.batch_scan_streaming", false);
   BTM_RegisterForVSEvents(btm_ble_batchscan_filter_track_adv_vse_cback, true);
 }
 
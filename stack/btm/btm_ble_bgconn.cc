@@ -28,6 +28,7 @@
 
 #include <base/logging.h>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "bt_types.h"
 #include "btm_int.h"
@@ -35,6 +36,8 @@
 #include "device/include/controller.h"
 #include "hcimsgs.h"
 #include "l2c_int.h"
+#include "osi/include/alarm.h"
+#include "osi/include/properties.h"
 
 extern void btm_send_hci_create_connection(
     uint16_t scan_int, uint16_t scan_win, uint8_t init_filter_policy,
@@ -56,6 +59,7 @@ struct BackgroundConnection {
   bool in_controller_wl;
   uint8_t addr_type_in_wl;
   bool pending_removal;
+  bool high_priority;
 };
 
 struct BgConnHash {
@@ -69,12 +73,25 @@ struct BgConnHash {
 static std::unordered_map<RawAddress, BackgroundConnection, BgConnHash>
     background_connections;
 
+/* Devices marked high priority. Kept while they are out of the white list,
+ * so that they are high priority again once they are added back. */
+static std::unordered_set<RawAddress, BgConnHash> high_priority_devices;
+
+static bool background_connection_high_priority(const RawAddress& address) {
+  if (high_priority_devices.count(address)) return true;
+  tBTM_SEC_DEV_REC* p_dev_rec = btm_find_dev(address);
+  return p_dev_rec != NULL &&
+         (high_priority_devices.count(p_dev_rec->bd_addr) ||
+          high_priority_devices.count(p_dev_rec->ble.identity_addr));
+}
+
 static void background_connection_add(uint8_t addr_type,
                                       const RawAddress& address) {
   auto map_iter = background_connections.find(address);
   if (map_iter == background_connections.end()) {
     background_connections[address] =
-        BackgroundConnection{address, addr_type, false, 0, false};
+        BackgroundConnection{address, addr_type, false, 0, false,
+                             background_connection_high_priority(address)};
   } else {
     BackgroundConnection* connection = &map_iter->second;
     if (addr_type != connection->addr_type) {
@@ -138,6 +155,183 @@ static int background_connections_count() {
   return count;
 }
 
+/* Devices can be in the list under their identity address, look for both */
+static BackgroundConnection* background_connection_find(
+    const RawAddress& address) {
+  auto map_iter = background_connections.find(address);
+  if (map_iter == background_connections.end()) {
+    tBTM_SEC_DEV_REC* p_dev_rec = btm_find_dev(address);
+    if (p_dev_rec == NULL || p_dev_rec->ble.identity_addr.IsEmpty())
+      return NULL;
+    map_iter = background_connections.find(p_dev_rec->ble.identity_addr);
+    if (map_iter == background_connections.end()) return NULL;
+  }
+  if (map_iter->second.pending_removal) return NULL;
+  return &map_iter->second;
+}
+
+/* Scan duty used for background connections, from most to least aggressive.
+ * The policy boosts to the first level when a device is about to show up,
+ * then falls back to the default level and halves the duty each time the
+ * list goes stale for the backoff period. */
+typedef struct {
+  uint16_t scan_int;
+  uint16_t scan_win;
+} tBTM_BLE_BG_SCAN_LEVEL;
+
+static const tBTM_BLE_BG_SCAN_LEVEL bg_scan_levels[] = {
+    {BTM_BLE_SCAN_FAST_INT, BTM_BLE_SCAN_FAST_WIN},
+    {BTM_BLE_SCAN_SLOW_INT_1, BTM_BLE_SCAN_SLOW_WIN_1},
+    {BTM_BLE_SCAN_SLOW_INT_2, BTM_BLE_SCAN_SLOW_WIN_2},
+    {2 * BTM_BLE_SCAN_SLOW_INT_2, BTM_BLE_SCAN_SLOW_WIN_2},
+};
+#define BG_SCAN_LEVEL_BOOST 0
+#define BG_SCAN_LEVEL_DEFAULT 1
+#define BG_SCAN_LEVEL_COUNT \
+  (sizeof(bg_scan_levels) / sizeof(bg_scan_levels[0]))
+/* how long a boost lasts */
+#define BG_SCAN_BOOST_MS (30 * 1000)
+/* time at the default level before backing off, doubled on every level */
+#define BG_SCAN_STALE_MS (60 * 1000)
+/* default time during which white list changes are collected */
+#define BG_CONN_UPDATE_BATCH_MS 10
+
+static struct {
+  bool adaptive;
+  uint8_t level;
+  int32_t batch_ms;
+  alarm_t* backoff_timer;
+  alarm_t* update_timer;
+} bg_policy;
+
+static void bg_conn_update_timeout(void* /* data */) {
+  /* the initiator can't use the white list while it changes; once the create
+   * connection is cancelled, the completion restarts it with the changes */
+  if (btm_cb.ble_ctr_cb.wl_state & BTM_BLE_WL_INIT) {
+    btm_ble_stop_auto_conn();
+    return;
+  }
+
+  if (!btm_ble_resume_bg_conn() && btm_ble_get_conn_st() == BLE_CONN_IDLE)
+    btm_execute_wl_dev_operation();
+}
+
+/* Applies white list and scan parameter changes made in the batch window in
+ * a single controller update. */
+static void bg_conn_schedule_update() {
+  if (bg_policy.batch_ms <= 0 || !bg_policy.update_timer) {
+    bg_conn_update_timeout(NULL);
+    return;
+  }
+
+  if (!alarm_is_scheduled(bg_policy.update_timer))
+    alarm_set_on_mloop(bg_policy.update_timer, bg_policy.batch_ms,
+                       bg_conn_update_timeout, NULL);
+}
+
+static void bg_scan_backoff_timeout(void* data);
+
+static void bg_scan_set_level(uint8_t level) {
+  if (!bg_policy.adaptive) return;
+
+  if (bg_policy.backoff_timer) {
+    alarm_cancel(bg_policy.backoff_timer);
+    if (level + 1U < BG_SCAN_LEVEL_COUNT) {
+      period_ms_t period = (level == BG_SCAN_LEVEL_BOOST)
+                               ? BG_SCAN_BOOST_MS
+                               : (period_ms_t)BG_SCAN_STALE_MS
+                                     << (level - BG_SCAN_LEVEL_DEFAULT);
+      alarm_set_on_mloop(bg_policy.backoff_timer, period,
+                         bg_scan_backoff_timeout, NULL);
+    }
+  }
+
+  if (level == bg_policy.level) return;
+
+  VLOG(1) << __func__ << ": level " << +bg_policy.level << " -> " << +level;
+  bg_policy.level = level;
+  if (btm_cb.ble_ctr_cb.wl_state & BTM_BLE_WL_INIT) bg_conn_schedule_update();
+}
+
+static void bg_scan_backoff_timeout(void* /* data */) {
+  bg_scan_set_level(bg_policy.level + 1);
+}
+
+/* Scan window and interval for the background connection. The policy only
+ * drives the default (slow) mode, fast mode asked for by a direct connection
+ * is used as is. */
+static void bg_scan_get_params(uint16_t* scan_int, uint16_t* scan_win) {
+  tBTM_BLE_CB* p_cb = &btm_cb.ble_ctr_cb;
+  bool default_mode = (p_cb->scan_int == BTM_BLE_SCAN_PARAM_UNDEF &&
+                       p_cb->scan_win == BTM_BLE_SCAN_PARAM_UNDEF) ||
+                      (p_cb->scan_int == BTM_BLE_SCAN_SLOW_INT_1 &&
+                       p_cb->scan_win == BTM_BLE_SCAN_SLOW_WIN_1);
+  if (default_mode) {
+    uint8_t level =
+        bg_policy.adaptive ? bg_policy.level : (uint8_t)BG_SCAN_LEVEL_DEFAULT;
+    *scan_int = bg_scan_levels[level].scan_int;
+    *scan_win = bg_scan_levels[level].scan_win;
+    return;
+  }
+
+  *scan_int = p_cb->scan_int;
+  *scan_win = p_cb->scan_win;
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_bgconn_device_seen
+ *
+ * Description      Called for advertising reports. A high priority device
+ *                  pending background connection is about to connect, so
+ *                  the scan duty is raised for a while.
+ *
+ ******************************************************************************/
+void btm_ble_bgconn_device_seen(const RawAddress& bd_addr) {
+  if (background_connections.empty() || bg_policy.level == BG_SCAN_LEVEL_BOOST)
+    return;
+
+  BackgroundConnection* connection = background_connection_find(bd_addr);
+  if (connection == NULL || !connection->high_priority) return;
+  if (BTM_IsAclConnectionUp(connection->address, BT_TRANSPORT_LE)) return;
+
+  VLOG(1) << __func__ << ": " << bd_addr;
+  bg_scan_set_level(BG_SCAN_LEVEL_BOOST);
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_bgconn_link_lost
+ *
+ * Description      Called when an LE link timed out. The device likely went
+ *                  out of range and comes back soon, so if it is in the
+ *                  background connection list the scan duty is raised.
+ *
+ ******************************************************************************/
+void btm_ble_bgconn_link_lost(const RawAddress& bd_addr) {
+  if (background_connection_find(bd_addr) == NULL) return;
+
+  VLOG(1) << __func__ << ": " << bd_addr;
+  bg_scan_set_level(BG_SCAN_LEVEL_BOOST);
+}
+
+/** Marks the device as high priority for background connection */
+void BTM_BackgroundConnectSetHighPriority(const RawAddress& address,
+                                          bool high_priority) {
+  VLOG(1) << __func__ << ": " << address << " high_priority=" << high_priority;
+  if (high_priority) {
+    high_priority_devices.insert(address);
+  } else {
+    high_priority_devices.erase(address);
+  }
+
+  /* the device may also be added to the white list later */
+  BackgroundConnection* connection = background_connection_find(address);
+  if (connection != NULL)
+    connection->high_priority =
+        background_connection_high_priority(connection->address);
+}
+
 /*******************************************************************************
  *
  * Function         btm_update_scanner_filter_policy
@@ -364,6 +558,19 @@ bool btm_execute_wl_dev_operation(void) {
  ******************************************************************************/
 void btm_ble_white_list_init(uint8_t white_list_size) {
   BTM_TRACE_DEBUG("%s white_list_size = %d", __func__, white_list_size);
+
+  bg_policy.adaptive =
+      osi_property_get_bool("persist.vendor.btstack.bgconn_adaptive", true);
+  bg_policy.batch_ms = osi_property_get_int32(
+      "persist.vendor.btstack.bgconn_batch_ms", BG_CONN_UPDATE_BATCH_MS);
+  bg_policy.level = BG_SCAN_LEVEL_DEFAULT;
+  if (!bg_policy.backoff_timer)
+    bg_policy.backoff_timer = alarm_new("btm_ble.bg_scan_backoff");
+  if (!bg_policy.update_timer)
+    bg_policy.update_timer = alarm_new("btm_ble.bg_conn_update");
+  alarm_cancel(bg_policy.update_timer);
+  /* start backing off from the default level */
+  bg_scan_set_level(BG_SCAN_LEVEL_DEFAULT);
 }
 
 uint8_t BTM_GetWhiteListSize() {
@@ -406,12 +613,8 @@ bool btm_ble_start_auto_conn() {
 
   BTM_TRACE_EVENT("%s", __func__);
 
-  uint16_t scan_int = (p_cb->scan_int == BTM_BLE_SCAN_PARAM_UNDEF)
-                          ? BTM_BLE_SCAN_SLOW_INT_1
-                          : p_cb->scan_int;
-  uint16_t scan_win = (p_cb->scan_win == BTM_BLE_SCAN_PARAM_UNDEF)
-                          ? BTM_BLE_SCAN_SLOW_WIN_1
-                          : p_cb->scan_win;
+  uint16_t scan_int, scan_win;
+  bg_scan_get_params(&scan_int, &scan_win);
   uint8_t own_addr_type = p_cb->addr_mgnt_cb.own_addr_type;
   uint8_t peer_addr_type = BLE_ADDR_PUBLIC;
 
@@ -523,31 +726,19 @@ bool BTM_WhiteListAdd(const RawAddress& address) {
     return false;
   }
 
-  if (btm_cb.ble_ctr_cb.wl_state & BTM_BLE_WL_INIT) {
-    btm_ble_stop_auto_conn();
-  }
   btm_add_dev_to_controller(true, address);
-  const bool connected =
-    BTM_IsAclConnectionUp(address, BT_TRANSPORT_LE);
-  BTM_TRACE_DEBUG("%s ACLUP is %d ", __func__, connected);
-  if (!connected) {
-    VLOG(1) << __func__ << ": initiating connection " << address;
-    btm_ble_resume_bg_conn();
-  } else {
-    BTM_TRACE_DEBUG(" %s Executing Whitelist operation ", __func__);
-    btm_execute_wl_dev_operation();
-  }
+  /* the list changed, it is no longer stale */
+  if (bg_policy.level > BG_SCAN_LEVEL_DEFAULT)
+    bg_scan_set_level(BG_SCAN_LEVEL_DEFAULT);
+  bg_conn_schedule_update();
   return true;
 }
 
 /** Removes the device from white list */
 void BTM_WhiteListRemove(const RawAddress& address) {
   VLOG(1) << __func__ << ": " << address;
-  if (btm_cb.ble_ctr_cb.wl_state & BTM_BLE_WL_INIT) {
-    btm_ble_stop_auto_conn();
-  }
   btm_add_dev_to_controller(false, address);
-  btm_ble_resume_bg_conn();
+  bg_conn_schedule_update();
 }
 
 /** clear white list complete */
@@ -561,6 +752,7 @@ void wl_clear_complete(uint8_t* p_data, uint16_t /* evt_len */) {
 void BTM_WhiteListClear() {
   VLOG(1) << __func__;
   if (!controller_get_interface()->supports_ble()) return;
+  if (bg_policy.update_timer) alarm_cancel(bg_policy.update_timer);
   btm_ble_stop_auto_conn();
   btsnd_hcic_ble_clear_white_list(base::Bind(&wl_clear_complete));
   background_connections_clear();
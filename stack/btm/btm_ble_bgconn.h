@@ -40,3 +40,9 @@ extern bool BTM_SetLeConnectionModeToFast();
  * This does not send any requests to controller, instead it changes the
  * parameters that will be used after next add/remove request */
 extern void BTM_SetLeConnectionModeToSlow();
+
+/* Marks a device as high priority for background connection, whether or not
+ * it is in the white list yet. Seeing it advertise while it is in the white
+ * list raises the scan duty of the background connection for a while. */
+extern void BTM_BackgroundConnectSetHighPriority(const RawAddress& address,
+                                                 bool high_priority);
@@ -20,6 +20,7 @@
  ******************************************************************************/
 
 #include "bt_types.h"
+#include "btm_conn_trace.h"
 #include "btm_int.h"
 #include "device/include/controller.h"
 #include "l2c_int.h"
@@ -84,6 +85,11 @@ void btm_send_hci_create_connection(
                                   conn_timeout, min_ce_len, max_ce_len);
   }
 
+  // Connections through the white list are traced from their completion
+  if (init_filter_policy == 0x00)
+    btm_conn_trace_mark(bda_peer, BT_TRANSPORT_LE,
+                        BTM_CONN_TRACE_ACL_REQUESTED);
+
   btm_ble_set_conn_st(BLE_CONNECTING);
 }
 
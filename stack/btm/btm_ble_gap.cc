@@ -34,6 +34,7 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 #include <list>
 #include <vector>
 #include <map>
@@ -49,6 +50,7 @@
 #include "stack_config.h"
 #include "osi/include/osi.h"
 #include "osi/include/time.h"
+#include "osi/include/trace_ring.h"
 
 #include "btif_storage.h"
 
@@ -86,44 +88,32 @@ namespace {
 
 class AdvertisingCache {
  public:
-  /* Set the data to |data| for device |addr_type, addr| */
+  /* Set the data to |data| of length |len| for device |addr_type, addr| */
   const std::vector<uint8_t>& Set(uint8_t addr_type, const RawAddress& addr,
-                                  std::vector<uint8_t> data) {
-    auto it = Find(addr_type, addr);
-    if (it != items.end()) {
-      it->data = std::move(data);
-      return it->data;
-    }
-
-    if (items.size() > cache_max) {
-      items.pop_back();
-    }
+                                  const uint8_t* data, size_t len) {
+    std::vector<uint8_t>& buffer = FindOrAdd(addr_type, addr);
+    buffer.assign(data, data + len);
+    return buffer;
+  }
 
-    items.emplace_front(addr_type, addr, std::move(data));
-    return items.front().data;
+  /* Append |data| of length |len| for device |addr_type, addr| */
+  const std::vector<uint8_t>& Append(uint8_t addr_type, const RawAddress& addr,
+                                     const uint8_t* data, size_t len) {
+    std::vector<uint8_t>& buffer = FindOrAdd(addr_type, addr);
+    buffer.insert(buffer.end(), data, data + len);
+    return buffer;
   }
 
-  /* Append |data| for device |addr_type, addr| */
   const std::vector<uint8_t>& Append(uint8_t addr_type, const RawAddress& addr,
                                      std::vector<uint8_t> data) {
-    auto it = Find(addr_type, addr);
-    if (it != items.end()) {
-      it->data.insert(it->data.end(), data.begin(), data.end());
-      return it->data;
-    }
-
-    if (items.size() > cache_max) {
-      items.pop_back();
-    }
-
-    items.emplace_front(addr_type, addr, std::move(data));
-    return items.front().data;
+    return Append(addr_type, addr, data.data(), data.size());
   }
 
   /* Clear data for device |addr_type, addr| */
   void Clear(uint8_t addr_type, const RawAddress& addr) {
     auto it = Find(addr_type, addr);
     if (it != items.end()) {
+      Recycle(std::move(it->data));
       items.erase(it);
     }
   }
@@ -135,7 +125,7 @@ class AdvertisingCache {
     std::vector<uint8_t> data;
 
     Item(uint8_t addr_type, const RawAddress& addr, std::vector<uint8_t> data)
-        : addr_type(addr_type), addr(addr), data(data) {}
+        : addr_type(addr_type), addr(addr), data(std::move(data)) {}
   };
 
   std::list<Item>::iterator Find(uint8_t addr_type, const RawAddress& addr) {
@@ -147,9 +137,43 @@ class AdvertisingCache {
     return items.end();
   }
 
+  /* Return the buffer of device |addr_type, addr|, taking an empty one from
+   * the pool for a new device */
+  std::vector<uint8_t>& FindOrAdd(uint8_t addr_type, const RawAddress& addr) {
+    auto it = Find(addr_type, addr);
+    if (it != items.end()) return it->data;
+
+    if (items.size() > cache_max) {
+      Recycle(std::move(items.back().data));
+      items.pop_back();
+    }
+
+    std::vector<uint8_t> buffer;
+    if (!pool.empty()) {
+      buffer = std::move(pool.back());
+      pool.pop_back();
+    } else {
+      buffer.reserve(buffer_capacity);
+    }
+    items.emplace_front(addr_type, addr, std::move(buffer));
+    return items.front().data;
+  }
+
+  /* Keep the storage of a released buffer so that following reports are
+   * assembled without allocating */
+  void Recycle(std::vector<uint8_t> buffer) {
+    if (pool.size() > cache_max || buffer.capacity() > buffer_capacity) return;
+    buffer.clear();
+    pool.push_back(std::move(buffer));
+  }
+
   /* we keep maximum 7 devices in the cache */
   const size_t cache_max = 7;
+  /* maximum length of the extended advertising data, which is what one report
+   * chain assembles to; longer buffers are not pooled */
+  const size_t buffer_capacity = 1650;
   std::list<Item> items;
+  std::vector<std::vector<uint8_t>> pool;
 };
 
 /* Devices in this cache are waiting for eiter scan response, or chained packets
@@ -175,9 +199,12 @@ using SyncTransferCb = base::Callback<void(uint8_t /*status*/, RawAddress)>;
 using BigInfoReportCb = base::Callback<void(uint16_t /*sync_handle*/, bool /*encrypted*/)>;
 
 #define MAX_SYNC_TRANSACTION 16
+#define MAX_SYNC_CLIENTS 4
 #define SYNC_TIMEOUT (30 * 1000)
 #define ADV_SYNC_ESTB_EVT_LEN 16
 #define SYNC_LOST_EVT_LEN 3
+/* Create sync option to use the periodic advertiser list */
+#define SYNC_OPTION_USE_LIST 0x01
 typedef enum {
   PERIODIC_SYNC_IDLE = 0,
   PERIODIC_SYNC_PENDING,
@@ -186,6 +213,18 @@ typedef enum {
 }tBTM_BLE_PERIODIC_SYNC_STATE;
 
 struct alarm_t *sync_timeout_alarm;
+
+/* A client interested in a PA train */
+typedef struct {
+  StartSyncCb sync_start_cb;
+  SyncReportCb sync_report_cb;
+  SyncLostCb sync_lost_cb;
+  BigInfoReportCb biginfo_report_cb;
+} tBTM_BLE_PERIODIC_SYNC_CLIENT;
+
+/* One PA train, identified by sid and address, shared by all clients that
+ * asked to sync to it. IDLE means the request is queued, PENDING that it is
+ * part of the outstanding create sync. */
 typedef struct {
   uint8_t sid;
   RawAddress remote_bda;
@@ -193,10 +232,14 @@ typedef struct {
   uint16_t sync_handle;
   uint8_t address_type;
   bool in_use;
-  StartSyncCb sync_start_cb;
-  SyncReportCb sync_report_cb;
-  SyncLostCb sync_lost_cb;
-  BigInfoReportCb biginfo_report_cb;
+  uint16_t skip;
+  uint16_t timeout;
+  uint8_t priority;
+  uint32_t seq;
+  uint8_t phy;
+  uint16_t interval;
+  uint8_t num_clients;
+  tBTM_BLE_PERIODIC_SYNC_CLIENT clients[MAX_SYNC_CLIENTS];
 } tBTM_BLE_PERIODIC_SYNC;
 
 typedef struct {
@@ -206,29 +249,16 @@ typedef struct {
   SyncTransferCb cb;
 } tBTM_BLE_PERIODIC_SYNC_TRANSFER;
 
-static list_t* sync_queue;
-static std::mutex sync_queue_mutex_;
-
-typedef struct {
-  bool busy;
-  uint8_t sid;
-  RawAddress address;
-  uint16_t skip;
-  uint16_t timeout;
-}sync_node_t;
-typedef struct {
-  uint8_t sid;
-  RawAddress address;
-}remove_sync_node_t;
-typedef enum {
-  BTM_QUEUE_SYNC_REQ_EVT,
-  BTM_QUEUE_SYNC_ADVANCE_EVT,
-  BTM_QUEUE_SYNC_CLEANUP_EVT
-} btif_queue_event_t;
-
 typedef struct {
   tBTM_BLE_PERIODIC_SYNC p_sync[MAX_SYNC_TRANSACTION];
   tBTM_BLE_PERIODIC_SYNC_TRANSFER sync_transfer[MAX_SYNC_TRANSACTION];
+  /* a create sync command is outstanding */
+  bool create_pending;
+  bool list_size_read;
+  bool list_disabled;
+  /* entries in the controller's periodic advertiser list */
+  uint8_t list_size;
+  uint32_t next_seq;
 } tBTM_BLE_PA_SYNC_TX_CB;
 tBTM_BLE_PA_SYNC_TX_CB btm_ble_pa_sync_cb;
 StartSyncCb sync_rcvd_cb;
@@ -245,7 +275,7 @@ static void btm_ble_process_adv_pkt_cont(
     uint16_t evt_type, uint8_t addr_type, const RawAddress& bda,
     uint8_t primary_phy, uint8_t secondary_phy, uint8_t advertising_sid,
     int8_t tx_power, int8_t rssi, uint16_t periodic_adv_int, uint8_t data_len,
-    uint8_t* data, const RawAddress& original_bda);
+    const uint8_t* data, const RawAddress& original_bda);
 static uint8_t btm_set_conn_mode_adv_init_addr(tBTM_BLE_INQ_CB* p_cb,
                                                RawAddress& p_peer_addr_ptr,
                                                tBLE_ADDR_TYPE* p_peer_addr_type,
@@ -943,13 +973,8 @@ void BTM_BleEnableCsipOpportunisticScan(bool is_enabled,
 }
 
 #if (BLE_PRIVACY_SPT == TRUE)
-static bool is_resolving_list_bit_set(void* data, void* context) {
-  tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(data);
-
-  if ((p_dev_rec->ble.in_controller_list & BTM_RESOLVING_LIST_BIT) != 0)
-    return false;
-
-  return true;
+static bool is_resolving_list_bit_set(const tBTM_SEC_DEV_REC* p_dev_rec) {
+  return (p_dev_rec->ble.in_controller_list & BTM_RESOLVING_LIST_BIT) != 0;
 }
 #endif
 
@@ -1179,155 +1204,141 @@ std::vector<uint8_t> btm_ble_process_encrypted_adv(const RawAddress& bda,
  * PAST and Periodic Sync helper functions
  ******************************************************************************/
 
-static void sync_queue_add(sync_node_t *p_param) {
-  std::unique_lock<std::mutex> guard(sync_queue_mutex_);
-  if (!sync_queue) {
-    LOG_INFO(LOG_TAG, "%s: allocating sync queue", __func__);
-    sync_queue = list_new(osi_free);
-    CHECK(sync_queue != NULL);
-  }
-
-  // Sanity check
-  CHECK(list_length(sync_queue) < MAX_SYNC_TRANSACTION);
-  sync_node_t* p_node = (sync_node_t*)osi_malloc(sizeof(sync_node_t));
-  memcpy(p_node, p_param, sizeof(sync_node_t));
-  list_append(sync_queue, p_node);
-}
-
-static void sync_queue_advance() {
-  BTM_TRACE_DEBUG("%s",__func__);
-  std::unique_lock<std::mutex> guard(sync_queue_mutex_);
-
-  if (sync_queue && !list_is_empty(sync_queue)) {
-    sync_node_t* p_head = (sync_node_t*)list_front(sync_queue);
-    LOG_INFO(LOG_TAG,"%s: queue_advance", __func__);
-    list_remove(sync_queue, p_head);
-  }
+static void btm_ble_free_psync(tBTM_BLE_PERIODIC_SYNC* p) {
+  *p = tBTM_BLE_PERIODIC_SYNC();
 }
-static void sync_queue_cleanup(remove_sync_node_t *p_param) {
-  std::unique_lock<std::mutex> guard(sync_queue_mutex_);
-  if (!sync_queue) {
-    return;
-  }
 
-  sync_node_t* sync_request;
-  const list_node_t* node = list_begin(sync_queue);
-  while (node && node != list_end(sync_queue)) {
-    sync_request = (sync_node_t*)list_node(node);
-    node = list_next(node);
-    if (sync_request->sid == p_param->sid &&
-      sync_request->address == p_param->address) {
-      LOG_INFO(LOG_TAG,
-               "%s: removing connection request SID=%04X, bd_addr=%s, busy=%d",
-               __func__, sync_request->sid,
-               sync_request->address.ToString().c_str(),
-               sync_request->busy);
-      list_remove(sync_queue, sync_request);
-    }
-  }
-}
-void btm_ble_start_sync_request(uint8_t sid, RawAddress addr, uint16_t skip, uint16_t timeout) {
+/* Returns the address type to create a sync with, and turns |addr| into the
+ * identity address if the controller should resolve it. */
+static uint8_t btm_ble_get_sync_address(RawAddress* addr) {
   uint8_t address_type = BLE_ADDR_RANDOM;
-  tINQ_DB_ENT* p_i = btm_inq_db_find(addr);
+  tINQ_DB_ENT* p_i = btm_inq_db_find(*addr);
   if (p_i) {
     address_type = p_i->inq_info.results.ble_addr_type; //Random
   }
-  btm_random_pseudo_to_identity_addr(&addr,&address_type);
+  btm_random_pseudo_to_identity_addr(addr, &address_type);
   if (address_type & BLE_ADDR_TYPE_ID_BIT) {
 #if (BLE_PRIVACY_SPT == TRUE)
       BTM_TRACE_WARNING("%s:Enable resolving list",__func__);
       btm_ble_enable_resolving_list(BTM_BLE_RL_SCAN);
 #endif
   }
-  address_type &= ~BLE_ADDR_TYPE_ID_BIT;
-  uint8_t options = 0;
-  uint8_t cte_type = 7;
-  int index = btm_ble_get_psync_index(sid, addr);
-  if (index == MAX_SYNC_TRANSACTION) {
-      BTM_TRACE_ERROR("[PSync]%s: index not found", __func__);
-      return;
-  }
-  tBTM_BLE_PERIODIC_SYNC *p = &btm_ble_pa_sync_cb.p_sync[index];
-  p->sync_state = PERIODIC_SYNC_PENDING;
-  btsnd_hcic_ble_create_periodic_sync(options, sid, address_type, addr, skip, timeout,cte_type);
-  alarm_set(sync_timeout_alarm,SYNC_TIMEOUT, btm_ble_start_sync_timeout, NULL);
+  return address_type & ~BLE_ADDR_TYPE_ID_BIT;
+}
+
+static void btm_ble_periodic_adv_list_cmpl(uint8_t* p, uint16_t evt_len) {
+  uint8_t status;
+  STREAM_TO_UINT8(status, p);
+  if (status != HCI_SUCCESS)
+    BTM_TRACE_WARNING("[PSync]%s: status = 0x%02x", __func__, status);
 }
 
-static void btm_queue_sync_next() {
-  if (!sync_queue || list_is_empty(sync_queue)) {
-    BTM_TRACE_DEBUG("%s:sync_queue empty",__func__);
+static void btm_ble_sync_mgr_advance();
+
+static void btm_ble_read_periodic_adv_list_size_cmpl(uint8_t* p,
+                                                     uint16_t evt_len) {
+  uint8_t status, list_size = 0;
+  STREAM_TO_UINT8(status, p);
+  if (status == HCI_SUCCESS && evt_len >= 2) STREAM_TO_UINT8(list_size, p);
+
+  btm_ble_pa_sync_cb.list_size = list_size;
+  BTM_TRACE_DEBUG("[PSync]%s: status = 0x%02x, list_size = %d", __func__,
+                  status, list_size);
+  btm_ble_sync_mgr_advance();
+}
+
+/* Queued requests go first by priority, then in the order they were made */
+static bool btm_ble_sync_goes_before(const tBTM_BLE_PERIODIC_SYNC* a,
+                                     const tBTM_BLE_PERIODIC_SYNC* b) {
+  if (a->priority != b->priority) return a->priority > b->priority;
+  return a->seq < b->seq;
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_sync_mgr_advance
+ *
+ * Description      Sends the next create sync if none is outstanding. With a
+ *                  periodic advertiser list, the most important queued
+ *                  requests that fit in the list are put in it, and the
+ *                  controller syncs to whichever train it finds first,
+ *                  instead of looking for one train after another.
+ *
+ ******************************************************************************/
+static void btm_ble_sync_mgr_advance() {
+  tBTM_BLE_PA_SYNC_TX_CB* p_cb = &btm_ble_pa_sync_cb;
+  if (p_cb->create_pending) return;
+
+  std::vector<tBTM_BLE_PERIODIC_SYNC*> queued;
+  for (int i = 0; i < MAX_SYNC_TRANSACTION; i++) {
+    tBTM_BLE_PERIODIC_SYNC* p = &p_cb->p_sync[i];
+    if (p->in_use && p->sync_state == PERIODIC_SYNC_IDLE) queued.push_back(p);
+  }
+  if (queued.empty()) {
+    BTM_TRACE_DEBUG("%s: no queued sync request", __func__);
     return;
   }
 
-  sync_node_t* p_head = (sync_node_t*)list_front(sync_queue);
-
-  LOG_INFO(LOG_TAG,
-           "%s: executing sync request SID=%04X, bd_addr=%s",
-           __func__, p_head->sid, p_head->address.ToString().c_str());
-  if (p_head->busy) {
-    BTM_TRACE_DEBUG("%s:BUSY",__func__);
+  if (!p_cb->list_size_read && !p_cb->list_disabled) {
+    /* the rest is done once the size is known */
+    p_cb->list_size_read = true;
+    btsnd_hcic_ble_read_periodic_adv_list_size(
+        base::Bind(&btm_ble_read_periodic_adv_list_size_cmpl));
     return;
   }
 
-  p_head->busy = true;
-  alarm_cancel(sync_timeout_alarm);
-  btm_ble_start_sync_request(p_head->sid, p_head->address,p_head->skip, p_head->timeout);
-}
-static void btm_ble_sync_queue_handle(uint16_t event, char *param) {
-  switch(event) {
-    case BTM_QUEUE_SYNC_REQ_EVT:
-      BTM_TRACE_DEBUG("%s: BTIF_QUEUE_SYNC_REQ_EVT",__func__);
-      sync_queue_add((sync_node_t *)param);
-      break;
-    case BTM_QUEUE_SYNC_ADVANCE_EVT:
-      BTM_TRACE_DEBUG("%s: BTIF_QUEUE_ADVANCE_EVT",__func__);
-      sync_queue_advance();
-      break;
-    case BTM_QUEUE_SYNC_CLEANUP_EVT:
-      sync_queue_cleanup((remove_sync_node_t *)param);
-      return;
+  std::sort(queued.begin(), queued.end(), btm_ble_sync_goes_before);
+  /* a list of one brings nothing over a direct create sync */
+  size_t batch = 1;
+  if (!p_cb->list_disabled && p_cb->list_size > 1)
+    batch = std::min<size_t>(p_cb->list_size, queued.size());
+  queued.resize(batch);
+
+  uint8_t options = 0;
+  uint8_t cte_type = 7;
+  tBTM_BLE_PERIODIC_SYNC* p_head = queued.front();
+  RawAddress addr = p_head->remote_bda;
+  uint8_t address_type = btm_ble_get_sync_address(&addr);
+  if (batch > 1) {
+    options = SYNC_OPTION_USE_LIST;
+    btsnd_hcic_ble_clear_periodic_adv_list(
+        base::Bind(&btm_ble_periodic_adv_list_cmpl));
+    for (tBTM_BLE_PERIODIC_SYNC* p : queued) {
+      RawAddress list_addr = p->remote_bda;
+      uint8_t list_address_type = btm_ble_get_sync_address(&list_addr);
+      btsnd_hcic_ble_add_periodic_adv_list(
+          list_address_type, list_addr, p->sid,
+          base::Bind(&btm_ble_periodic_adv_list_cmpl));
+    }
   }
-  btm_queue_sync_next();
-}
-void btm_queue_start_sync_req(uint8_t sid, RawAddress address, uint16_t skip, uint16_t timeout) {
-  BTM_TRACE_DEBUG("%s: address = %s, sid = %d",__func__, address.ToString().c_str(), sid);
-  sync_node_t node;
-  memset(&node, 0, sizeof(node));
-  node.sid = sid;
-  node.address = address;
-  node.skip = skip;
-  node.timeout = timeout;
-  btm_ble_sync_queue_handle(BTM_QUEUE_SYNC_REQ_EVT, (char*)&node);
-}
 
-static void btm_sync_queue_advance() {
-  BTIF_TRACE_DEBUG("%s",__func__);
-  btm_ble_sync_queue_handle(BTM_QUEUE_SYNC_ADVANCE_EVT, NULL);
+  for (tBTM_BLE_PERIODIC_SYNC* p : queued) {
+    LOG_INFO(LOG_TAG, "%s: executing sync request SID=%04X, bd_addr=%s",
+             __func__, p->sid, p->remote_bda.ToString().c_str());
+    p->sync_state = PERIODIC_SYNC_PENDING;
+  }
+
+  p_cb->create_pending = true;
+  btsnd_hcic_ble_create_periodic_sync(options, p_head->sid, address_type, addr,
+                                      p_head->skip, p_head->timeout, cte_type);
+  alarm_set(sync_timeout_alarm, SYNC_TIMEOUT, btm_ble_start_sync_timeout, NULL);
 }
 
 static void btm_ble_start_sync_timeout(void *data) {
   BTIF_TRACE_DEBUG("%s",__func__);
-  sync_node_t* p_head = (sync_node_t*)list_front(sync_queue);
-  uint8_t adv_sid = p_head->sid;
-  RawAddress address = p_head->address;
 
-  int index = btm_ble_get_psync_index(adv_sid, address);
-  if (index == MAX_SYNC_TRANSACTION) {
-      BTM_TRACE_ERROR("[PSync]%s: index not found", __func__);
-      return;
-  }
+  /* every request in the attempt had the whole timeout to be found */
+  for (int i = 0; i < MAX_SYNC_TRANSACTION; i++) {
+    tBTM_BLE_PERIODIC_SYNC* p = &btm_ble_pa_sync_cb.p_sync[i];
+    if (!p->in_use || p->sync_state != PERIODIC_SYNC_PENDING) continue;
 
-  tBTM_BLE_PERIODIC_SYNC *p = &btm_ble_pa_sync_cb.p_sync[index];
+    for (uint8_t j = 0; j < p->num_clients; j++)
+      p->clients[j].sync_start_cb.Run(0x3C, 0, p->sid, 0, p->remote_bda, 0, 0);
+    btm_ble_free_psync(p);
+  }
 
+  /* the next request is sent once the controller confirms the cancel */
   btsnd_hci_ble_cancel_period_sync();
-  p->sync_start_cb.Run(0x3C, 0, p->sid, 0, p->remote_bda, 0, 0);
-
-  p->sync_state =  PERIODIC_SYNC_IDLE;
-  p->in_use = false;
-  p->remote_bda =  RawAddress::kEmpty;
-  p->sid = 0;
-  p->sync_handle = 0;
-  p->in_use = false;
 }
 
 static int btm_ble_get_free_psync_index() {
@@ -1354,7 +1365,8 @@ static int btm_ble_get_psync_index_from_handle(uint16_t handle) {
 static int btm_ble_get_psync_index(uint8_t adv_sid, RawAddress addr) {
   int i;
   for (i = 0; i < MAX_SYNC_TRANSACTION; i++) {
-    if (btm_ble_pa_sync_cb.p_sync[i].sid == adv_sid &&
+    if (btm_ble_pa_sync_cb.p_sync[i].in_use &&
+      btm_ble_pa_sync_cb.p_sync[i].sid == adv_sid &&
       btm_ble_pa_sync_cb.p_sync[i].remote_bda == addr) {
       BTM_TRACE_DEBUG("%s: found index at %d",__func__, i);
       return i;
@@ -1409,6 +1421,7 @@ void btm_ble_periodic_adv_sync_established(uint8_t *param, uint16_t param_len) {
   }
   RawAddress addr;
   alarm_cancel(sync_timeout_alarm);
+  btm_ble_pa_sync_cb.create_pending = false;
   STREAM_TO_UINT8(status, param);
   STREAM_TO_UINT16(sync_handle, param);
   STREAM_TO_UINT8(adv_sid, param);
@@ -1423,22 +1436,38 @@ void btm_ble_periodic_adv_sync_established(uint8_t *param, uint16_t param_len) {
 #endif
   }
   int index = btm_ble_get_psync_index(adv_sid, addr);
+  if (status != BTM_SUCCESS || index == MAX_SYNC_TRANSACTION ||
+      btm_ble_pa_sync_cb.p_sync[index].sync_state != PERIODIC_SYNC_PENDING) {
+    index = MAX_SYNC_TRANSACTION;
+  }
+
+  /* the other requests of the attempt go back to the queue */
+  for (int i = 0; i < MAX_SYNC_TRANSACTION; i++) {
+    tBTM_BLE_PERIODIC_SYNC* p = &btm_ble_pa_sync_cb.p_sync[i];
+    if (i != index && p->in_use && p->sync_state == PERIODIC_SYNC_PENDING)
+      p->sync_state = PERIODIC_SYNC_IDLE;
+  }
+
   if (index == MAX_SYNC_TRANSACTION) {
     BTM_TRACE_WARNING("[PSync]%s: Invalid index for sync established",__func__);
     if (status == BTM_SUCCESS) {
       BTM_TRACE_WARNING("%s: Terminate sync",__func__);
       btsnd_hcic_ble_terminate_periodic_sync(sync_handle);
     }
-    btm_sync_queue_advance();
+    btm_ble_sync_mgr_advance();
     return;
   }
   tBTM_BLE_PERIODIC_SYNC *ps = &btm_ble_pa_sync_cb.p_sync[index];
   ps->sync_handle = sync_handle;
   ps->address_type = address_type;
+  ps->phy = phy;
+  ps->interval = interval;
   ps->sync_state = PERIODIC_SYNC_ESTABLISHED;
-  ps->sync_start_cb.Run(status, sync_handle, adv_sid,
-                                   address_type, addr, phy, interval);
-  btm_sync_queue_advance();
+  for (uint8_t i = 0; i < ps->num_clients; i++) {
+    ps->clients[i].sync_start_cb.Run(status, sync_handle, adv_sid,
+                                     address_type, addr, phy, interval);
+  }
+  btm_ble_sync_mgr_advance();
 }
 
 /*******************************************************************************
@@ -1455,8 +1484,6 @@ void btm_ble_periodic_adv_report(uint8_t *param, uint16_t param_len) {
   uint8_t tx_power, rssi, cte_type, data_status, data_len;
   uint16_t sync_handle;
   std::vector<uint8_t> data;
-  std::vector<uint8_t> tmp;
-  uint8_t periodic_data[255] = {0};
   uint8_t *p = param;
   STREAM_TO_UINT16(sync_handle, p);
   STREAM_TO_INT8(tx_power, p);
@@ -1464,16 +1491,11 @@ void btm_ble_periodic_adv_report(uint8_t *param, uint16_t param_len) {
   STREAM_TO_UINT8(cte_type, p);
   STREAM_TO_UINT8(data_status, p);
   STREAM_TO_UINT8(data_len, p);
-  STREAM_TO_ARRAY(periodic_data, p, data_len);
   BTM_TRACE_DEBUG("[PSync]%s: sync_handle = %d, tx_power = %d, rssi = %d,"
                "cte_type = %d, data_status = %d, data_len = %d", __func__,
                 sync_handle, tx_power, rssi, cte_type, data_status, data_len);
 
-  for(int i = 0;i < data_len; i++) {
-    data.push_back(periodic_data[i]);
-  }
-  if (data_len != 0) tmp.insert(tmp.begin(), data.begin(), data.end());
-
+  std::vector<uint8_t> tmp(p, p + data_len);
 
   int index = btm_ble_get_psync_index_from_handle(sync_handle);
   if (index == MAX_SYNC_TRANSACTION) {
@@ -1505,7 +1527,6 @@ void btm_ble_periodic_adv_report(uint8_t *param, uint16_t param_len) {
   bool encrypted_data = false;
   bool is_decrypt_success = false;
   uint8_t len1;
-  std::vector<uint8_t> decrypted_data = data;
   std::map<int, int> enc_adv_data_map;
   if (btm_cb.enc_adv_data_log_enabled) {
     VLOG(1) << __func__ << " encrypted_data:" << encrypted_data;
@@ -1533,7 +1554,7 @@ void btm_ble_periodic_adv_report(uint8_t *param, uint16_t param_len) {
                   << base::HexEncode(data.data(), data.size());
       }
 
-      decrypted_data = btm_ble_process_encrypted_adv(ps->remote_bda, data, &is_decrypt_success,
+      data = btm_ble_process_encrypted_adv(ps->remote_bda, data, &is_decrypt_success,
           enc_adv_data_map);
       if (!is_decrypt_success) {
         VLOG(1) << __func__ << " Decryption NOT successful, return:";
@@ -1541,14 +1562,22 @@ void btm_ble_periodic_adv_report(uint8_t *param, uint16_t param_len) {
 
       if (btm_cb.enc_adv_data_log_enabled) {
         LOG(INFO) << " PA data after decryption: "
-                  << base::HexEncode(decrypted_data.data(), decrypted_data.size());
+                  << base::HexEncode(data.data(), data.size());
       }
     }
   }
 
   BTM_TRACE_DEBUG("[PSync]%s: invoking callback", __func__);
   periodicCache.Clear(ps->address_type, ps->remote_bda);
-  ps->sync_report_cb.Run(sync_handle, tx_power, rssi, data_status, decrypted_data);
+  /* the last client gets the report itself, the others a copy */
+  for (uint8_t i = 0; i + 1 < ps->num_clients; i++) {
+    ps->clients[i].sync_report_cb.Run(sync_handle, tx_power, rssi, data_status,
+                                      data);
+  }
+  if (ps->num_clients) {
+    ps->clients[ps->num_clients - 1].sync_report_cb.Run(
+        sync_handle, tx_power, rssi, data_status, std::move(data));
+  }
 }
 
 /*******************************************************************************
@@ -1574,15 +1603,11 @@ void btm_ble_periodic_adv_sync_lost(uint8_t *param, uint16_t param_len) {
       return;
   }
   tBTM_BLE_PERIODIC_SYNC *ps = &btm_ble_pa_sync_cb.p_sync[index];
-  if (ps->sync_lost_cb) {
-      ps->sync_lost_cb.Run(sync_handle);
+  for (uint8_t i = 0; i < ps->num_clients; i++) {
+    if (ps->clients[i].sync_lost_cb) ps->clients[i].sync_lost_cb.Run(sync_handle);
   }
 
-  ps->in_use = false;
-  ps->sid = 0;
-  ps->sync_handle = 0;
-  ps->sync_state = PERIODIC_SYNC_IDLE;
-  ps->remote_bda = RawAddress::kEmpty;
+  btm_ble_free_psync(ps);
 }
 
 /*******************************************************************************
@@ -1597,22 +1622,67 @@ void BTM_BleStartPeriodicSync(uint8_t adv_sid, RawAddress address, uint16_t skip
              uint16_t timeout, StartSyncCb syncCb, SyncReportCb reportCb, SyncLostCb lostCb,
              BigInfoReportCb biginfo_reportCb) {
   BTM_TRACE_DEBUG("[PSync]%s",__func__);
-  int index = btm_ble_get_free_psync_index();
+  /* clients of the same train share its sync */
+  int index = btm_ble_get_psync_index(adv_sid, address);
+  bool shared = index != MAX_SYNC_TRANSACTION;
+  if (!shared) index = btm_ble_get_free_psync_index();
 
-  if (index == MAX_SYNC_TRANSACTION) {
+  if (index == MAX_SYNC_TRANSACTION ||
+      btm_ble_pa_sync_cb.p_sync[index].num_clients == MAX_SYNC_CLIENTS) {
     syncCb.Run(BTM_NO_RESOURCES, 0, adv_sid, BLE_ADDR_RANDOM, address, 0, 0);
     return;
   }
   tBTM_BLE_PERIODIC_SYNC *p = &btm_ble_pa_sync_cb.p_sync[index];
 
-  p->in_use = true;
-  p->remote_bda = address;
-  p->sid = adv_sid;
-  p->sync_start_cb = syncCb;
-  p->sync_report_cb = reportCb;
-  p->sync_lost_cb = lostCb;
-  p->biginfo_report_cb = biginfo_reportCb;
-  btm_queue_start_sync_req(adv_sid, address, skip, timeout);
+  if (!shared) {
+    p->in_use = true;
+    p->remote_bda = address;
+    p->sid = adv_sid;
+    p->skip = skip;
+    p->timeout = timeout;
+    p->priority = BTM_BLE_PERIODIC_SYNC_PRIORITY_DEFAULT;
+    p->seq = btm_ble_pa_sync_cb.next_seq++;
+  }
+
+  tBTM_BLE_PERIODIC_SYNC_CLIENT* client = &p->clients[p->num_clients++];
+  client->sync_start_cb = syncCb;
+  client->sync_report_cb = reportCb;
+  client->sync_lost_cb = lostCb;
+  client->biginfo_report_cb = biginfo_reportCb;
+
+  if (p->sync_state == PERIODIC_SYNC_ESTABLISHED) {
+    BTM_TRACE_DEBUG("[PSync]%s: reusing sync handle %d", __func__,
+                    p->sync_handle);
+    syncCb.Run(BTM_SUCCESS, p->sync_handle, p->sid, p->address_type,
+               p->remote_bda, p->phy, p->interval);
+    return;
+  }
+
+  btm_ble_sync_mgr_advance();
+}
+
+/*******************************************************************************
+ *
+ * Function        BTM_BleSetPeriodicSyncPriority
+ *
+ * Description     Set how important the sync to PA associated with address
+ *                 and sid is. Queued requests with higher priority are sent
+ *                 to the controller first.
+ *
+ ******************************************************************************/
+
+void BTM_BleSetPeriodicSyncPriority(uint8_t adv_sid, RawAddress address,
+                                    uint8_t priority) {
+  BTM_TRACE_DEBUG("[PSync]%s: priority = %d", __func__, priority);
+  int index = btm_ble_get_psync_index(adv_sid, address);
+  if (index == MAX_SYNC_TRANSACTION) {
+    BTM_TRACE_ERROR("[PSync]%s:Invalid index",__func__);
+    return;
+  }
+
+  tBTM_BLE_PERIODIC_SYNC* p = &btm_ble_pa_sync_cb.p_sync[index];
+  /* a shared train is as important as its most important client */
+  if (p->num_clients <= 1 || priority > p->priority) p->priority = priority;
 }
 
 /*******************************************************************************
@@ -1632,12 +1702,13 @@ void BTM_BleStopPeriodicSync(uint16_t handle) {
     return;
   }
   tBTM_BLE_PERIODIC_SYNC *p = &btm_ble_pa_sync_cb.p_sync[index];
-  p->sync_state =  PERIODIC_SYNC_IDLE;
-  p->in_use = false;
-  p->remote_bda =  RawAddress::kEmpty;
-  p->sid = 0;
-  p->sync_handle = 0;
-  p->in_use = false;
+  /* clients can't be told apart by handle, the latest one is dropped */
+  if (p->num_clients > 1) {
+    p->clients[--p->num_clients] = tBTM_BLE_PERIODIC_SYNC_CLIENT();
+    return;
+  }
+
+  btm_ble_free_psync(p);
   btsnd_hcic_ble_terminate_periodic_sync(handle);
 }
 
@@ -1658,22 +1729,19 @@ void BTM_BleCancelPeriodicSync(uint8_t adv_sid, RawAddress address) {
     return;
   }
   tBTM_BLE_PERIODIC_SYNC *p = &btm_ble_pa_sync_cb.p_sync[index];
+  if (p->num_clients > 1) {
+    p->clients[--p->num_clients] = tBTM_BLE_PERIODIC_SYNC_CLIENT();
+    return;
+  }
+
   if (p->sync_state == PERIODIC_SYNC_PENDING) {
+    /* the rest of the attempt is queued again once the cancel completes */
     BTM_TRACE_WARNING("[PSync]%s: Sync state is pending",__func__);
     btsnd_hci_ble_cancel_period_sync();
   } else if (p->sync_state == PERIODIC_SYNC_IDLE) {
     BTM_TRACE_DEBUG("[PSync]%s: Removing Sync request from queue",__func__);
-    remove_sync_node_t remove_node;
-    remove_node.sid = adv_sid;
-    remove_node.address = address;
-    btm_ble_sync_queue_handle(BTM_QUEUE_SYNC_CLEANUP_EVT, (char*)&remove_node);
-  }
-  p->sync_state =  PERIODIC_SYNC_IDLE;
-  p->in_use = false;
-  p->remote_bda =  RawAddress::kEmpty;
-  p->sid = 0;
-  p->sync_handle = 0;
-  p->in_use = false;
+  }
+  btm_ble_free_psync(p);
 }
 /*******************************************************************************
  *
@@ -1827,7 +1895,8 @@ void btm_ble_biginfo_adv_report_rcvd(uint8_t *p, uint16_t param_len) {
   }
   tBTM_BLE_PERIODIC_SYNC *ps = &btm_ble_pa_sync_cb.p_sync[index];
   BTM_TRACE_DEBUG("[PSync]%s: invoking callback", __func__);
-  ps->biginfo_report_cb.Run(sync_handle, encryption ? true: false);
+  for (uint8_t i = 0; i < ps->num_clients; i++)
+    ps->clients[i].biginfo_report_cb.Run(sync_handle, encryption ? true : false);
 }
 
 /*******************************************************************************
@@ -1948,13 +2017,11 @@ static uint8_t btm_set_conn_mode_adv_init_addr(
   if ((btm_cb.ble_ctr_cb.privacy_mode == BTM_PRIVACY_1_2 &&
        p_cb->afp != AP_SCAN_CONN_ALL) ||
       btm_cb.ble_ctr_cb.privacy_mode == BTM_PRIVACY_MIXED) {
-    list_node_t* n =
-        list_foreach(btm_cb.sec_dev_rec, is_resolving_list_bit_set, NULL);
-    if (n) {
+    tBTM_SEC_DEV_REC* p_dev_rec =
+        btm_cb.sec_dev_rec.Find(is_resolving_list_bit_set);
+    if (p_dev_rec) {
       /* if enhanced privacy is required, set Identity address and matching IRK
        * peer */
-      tBTM_SEC_DEV_REC* p_dev_rec =
-          static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
       p_peer_addr_ptr = p_dev_rec->ble.identity_addr;
       *p_peer_addr_type = p_dev_rec->ble.identity_addr_type;
 
@@ -2699,7 +2766,7 @@ static void btm_ble_update_adv_flag(uint8_t flag) {
  * condition
  */
 uint8_t btm_ble_is_discoverable(const RawAddress& bda,
-                                std::vector<uint8_t> const& adv_data) {
+                                const AdvertiseDataIndex& adv_data) {
   uint8_t flag = 0, rt = 0;
   uint8_t data_len;
   tBTM_INQ_PARMS* p_cond = &btm_cb.btm_inq_vars.inqparms;
@@ -2716,8 +2783,8 @@ uint8_t btm_ble_is_discoverable(const RawAddress& bda,
   }
 
   if (!adv_data.empty()) {
-    const uint8_t* p_flag = AdvertiseDataParser::GetFieldByType(
-        adv_data, BTM_BLE_AD_TYPE_FLAG, &data_len);
+    const uint8_t* p_flag =
+        adv_data.GetFieldByType(BTM_BLE_AD_TYPE_FLAG, &data_len);
     if (p_flag != NULL && data_len != 0) {
       flag = *p_flag;
 
@@ -2906,7 +2973,7 @@ void btm_ble_update_inq_result(tINQ_DB_ENT* p_i, uint8_t addr_type,
                                uint8_t primary_phy, uint8_t secondary_phy,
                                uint8_t advertising_sid, int8_t tx_power,
                                int8_t rssi, uint16_t periodic_adv_int,
-                               std::vector<uint8_t> const& data) {
+                               const AdvertiseDataIndex& data) {
   tBTM_INQ_RESULTS* p_cur = &p_i->inq_info.results;
   uint8_t len;
   tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
@@ -2940,8 +3007,7 @@ void btm_ble_update_inq_result(tINQ_DB_ENT* p_i, uint8_t addr_type,
   p_i->inq_count = p_inq->inq_counter; /* Mark entry for current inquiry */
 
   if (!data.empty()) {
-    const uint8_t* p_flag =
-        AdvertiseDataParser::GetFieldByType(data, BTM_BLE_AD_TYPE_FLAG, &len);
+    const uint8_t* p_flag = data.GetFieldByType(BTM_BLE_AD_TYPE_FLAG, &len);
     if (p_flag != NULL && len != 0) p_cur->flag = *p_flag;
   }
 
@@ -2955,14 +3021,13 @@ void btm_ble_update_inq_result(tINQ_DB_ENT* p_i, uint8_t addr_type,
      * Otherwise fall back to trying to infer if it is a HID device based on the
      * service class.
      */
-    const uint8_t* p_uuid16 = AdvertiseDataParser::GetFieldByType(
-        data, BTM_BLE_AD_TYPE_APPEARANCE, &len);
+    const uint8_t* p_uuid16 =
+        data.GetFieldByType(BTM_BLE_AD_TYPE_APPEARANCE, &len);
     if (p_uuid16 && len == 2) {
       btm_ble_appearance_to_cod((uint16_t)p_uuid16[0] | (p_uuid16[1] << 8),
                                 p_cur->dev_class);
     } else {
-      p_uuid16 = AdvertiseDataParser::GetFieldByType(
-          data, BTM_BLE_AD_TYPE_16SRV_CMPL, &len);
+      p_uuid16 = data.GetFieldByType(BTM_BLE_AD_TYPE_16SRV_CMPL, &len);
       if (p_uuid16 != NULL) {
         uint8_t i;
         for (i = 0; i + 2 <= len; i = i + 2) {
@@ -3034,13 +3099,13 @@ void btm_clear_all_pending_le_entry(void) {
   uint16_t xx;
   tINQ_DB_ENT* p_ent = btm_cb.btm_inq_vars.inq_db;
 
-  for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
+  for (xx = 0; xx < btm_cb.btm_inq_vars.inq_db_high_water; xx++, p_ent++) {
     /* mark all pending LE entry as unused if an LE only device has scan
      * response outstanding */
     if ((p_ent->in_use) &&
         (p_ent->inq_info.results.device_type == BT_DEVICE_TYPE_BLE) &&
         !p_ent->scan_rsp)
-      p_ent->in_use = false;
+      btm_inq_db_remove(p_ent);
   }
 }
 
@@ -3075,50 +3140,17 @@ void btm_ble_process_adv_addr(RawAddress& bda, uint8_t* addr_type) {
  * It updates the inquiry database. If the inquiry database is full, the oldest
  * entry is discarded.
  */
-void btm_ble_process_ext_adv_pkt(uint8_t data_len, uint8_t* data) {
-  RawAddress bda, direct_address;
-  uint8_t* p = data;
-  uint8_t addr_type, num_reports, pkt_data_len, primary_phy, secondary_phy,
-      advertising_sid;
-  int8_t rssi, tx_power;
-  uint16_t event_type, periodic_adv_int, direct_address_type;
+void btm_ble_process_ext_adv_pkt(HciLeExtAdvertisingReportView event) {
+  HciLeExtAdvReportView report;
 
   /* Only process the results if the inquiry is still active */
   if (!BTM_BLE_IS_SCAN_ACTIVE(btm_cb.ble_ctr_cb.scan_activity)) return;
 
-  /* Extract the number of reports in this event. */
-  STREAM_TO_UINT8(num_reports, p);
-
-  constexpr int extended_report_header_size = 24;
-  while (num_reports--) {
-    if (p + extended_report_header_size > data + data_len) {
-      // TODO(jpawlowski): we should crash the stack here
-      BTM_TRACE_ERROR(
-          "Malformed LE Extended Advertising Report Event from controller - "
-          "can't loop the data");
-      return;
-    }
-
+  while (event.Next(&report)) {
     /* Extract inquiry results */
-    STREAM_TO_UINT16(event_type, p);
-    STREAM_TO_UINT8(addr_type, p);
-    STREAM_TO_BDADDR(bda, p);
-    STREAM_TO_UINT8(primary_phy, p);
-    STREAM_TO_UINT8(secondary_phy, p);
-    STREAM_TO_UINT8(advertising_sid, p);
-    STREAM_TO_INT8(tx_power, p);
-    STREAM_TO_INT8(rssi, p);
-    STREAM_TO_UINT16(periodic_adv_int, p);
-    STREAM_TO_UINT8(direct_address_type, p);
-    STREAM_TO_BDADDR(direct_address, p);
-    STREAM_TO_UINT8(pkt_data_len, p);
-
-    uint8_t* pkt_data = p;
-    p += pkt_data_len; /* Advance to the the next packet*/
-    if (p > data + data_len) {
-      LOG(ERROR) << "Invalid pkt_data_len: " << +pkt_data_len;
-      return;
-    }
+    RawAddress bda = report.address();
+    uint8_t addr_type = report.address_type();
+    int8_t rssi = report.rssi();
 
     if (rssi >= 21 && rssi <= 126) {
       BTM_TRACE_ERROR("%s: bad rssi value in advertising report: %d", __func__,
@@ -3136,9 +3168,18 @@ void btm_ble_process_ext_adv_pkt(uint8_t data_len, uint8_t* data) {
       btm_ble_process_adv_addr(bda, &addr_type);
     }
 
-    btm_ble_process_adv_pkt_cont(event_type, addr_type, bda, primary_phy,
-                                 secondary_phy, advertising_sid, tx_power, rssi,
-                                 periodic_adv_int, pkt_data_len, pkt_data, original_bda);
+    btm_ble_process_adv_pkt_cont(
+        report.event_type(), addr_type, bda, report.primary_phy(),
+        report.secondary_phy(), report.advertising_sid(), report.tx_power(),
+        rssi, report.periodic_adv_interval(), report.data_length(),
+        report.adv_data(), original_bda);
+  }
+
+  if (event.malformed()) {
+    // TODO(jpawlowski): we should crash the stack here
+    BTM_TRACE_ERROR(
+        "Malformed LE Extended Advertising Report Event from controller - "
+        "can't loop the data");
   }
 }
 
@@ -3147,44 +3188,22 @@ void btm_ble_process_ext_adv_pkt(uint8_t data_len, uint8_t* data) {
  * the inquiry database. If the inquiry database is full, the oldest entry is
  * discarded.
  */
-void btm_ble_process_adv_pkt(uint8_t data_len, uint8_t* data) {
-  RawAddress bda;
-  uint8_t* p = data;
-  uint8_t legacy_evt_type, addr_type, num_reports, pkt_data_len;
-  int8_t rssi;
+void btm_ble_process_adv_pkt(HciLeAdvertisingReportView event) {
+  HciLeAdvReportView report;
 
   /* Only process the results if the inquiry is still active */
   if (!BTM_BLE_IS_SCAN_ACTIVE(btm_cb.ble_ctr_cb.scan_activity)) return;
 
-  /* Extract the number of reports in this event. */
-  STREAM_TO_UINT8(num_reports, p);
-
-  constexpr int report_header_size = 10;
-  while (num_reports--) {
-    if (p + report_header_size > data + data_len) {
-      // TODO(jpawlowski): we should crash the stack here
-      BTM_TRACE_ERROR("Malformed LE Advertising Report Event from controller");
-      return;
-    }
-
+  while (event.Next(&report)) {
     /* Extract inquiry results */
-    STREAM_TO_UINT8(legacy_evt_type, p);
-    STREAM_TO_UINT8(addr_type, p);
-    STREAM_TO_BDADDR(bda, p);
-    STREAM_TO_UINT8(pkt_data_len, p);
-
-    uint8_t* pkt_data = p;
-    p += pkt_data_len; /* Advance to the the rssi byte */
-    if (p > data + data_len - sizeof(rssi)) {
-      LOG(ERROR) << "Invalid pkt_data_len: " << +pkt_data_len;
-      return;
-    }
-
-    STREAM_TO_INT8(rssi, p);
+    uint8_t legacy_evt_type = report.event_type();
+    uint8_t addr_type = report.address_type();
+    RawAddress bda = report.address();
+    int8_t rssi = report.rssi();
 
     if (rssi >= 21 && rssi <= 126) {
-      BTM_TRACE_ERROR("%s: bad rssi value in advertising report: ", __func__,
-                      pkt_data_len, rssi);
+      BTM_TRACE_ERROR("%s: bad rssi value in advertising report: %d", __func__,
+                      rssi);
     }
 
     // Pass up the address to GattService#onScanResult to use in
@@ -3215,8 +3234,13 @@ void btm_ble_process_adv_pkt(uint8_t data_len, uint8_t* data) {
 
     btm_ble_process_adv_pkt_cont(
         event_type, addr_type, bda, PHY_LE_1M, PHY_LE_NO_PACKET, NO_ADI_PRESENT,
-        TX_POWER_NOT_PRESENT, rssi, 0x00 /* no periodic adv */, pkt_data_len,
-        pkt_data, original_bda);
+        TX_POWER_NOT_PRESENT, rssi, 0x00 /* no periodic adv */,
+        report.data_length(), report.adv_data(), original_bda);
+  }
+
+  if (event.malformed()) {
+    // TODO(jpawlowski): we should crash the stack here
+    BTM_TRACE_ERROR("Malformed LE Advertising Report Event from controller");
   }
 }
 
@@ -3228,13 +3252,12 @@ static void btm_ble_process_adv_pkt_cont(
     uint16_t evt_type, uint8_t addr_type, const RawAddress& bda,
     uint8_t primary_phy, uint8_t secondary_phy, uint8_t advertising_sid,
     int8_t tx_power, int8_t rssi, uint16_t periodic_adv_int, uint8_t data_len,
-    uint8_t* data, const RawAddress& original_bda) {
+    const uint8_t* data, const RawAddress& original_bda) {
   tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
   bool update = true;
-  VLOG(1) << __func__ << "bda:" << bda;
-  std::vector<uint8_t> tmp;
+  TRACE_RING_LOG(VERBOSE, LOG_TAG, "%s bda:%s evt_type:0x%04x rssi:%d",
+                 __func__, TRACE_RING_ADDRESS(bda), evt_type, rssi);
   std::vector<uint8_t> adv_data_decrypted;
-  if (data_len != 0) tmp.insert(tmp.begin(), data, data + data_len);
 
   bool is_scannable = ble_evt_type_is_scannable(evt_type);
   bool is_scan_resp = ble_evt_type_is_scan_resp(evt_type);
@@ -3243,14 +3266,17 @@ static void btm_ble_process_adv_pkt_cont(
       ble_evt_type_is_legacy(evt_type) && is_scannable && !is_scan_resp;
 
   if (ble_evt_type_is_legacy(evt_type))
-    AdvertiseDataParser::RemoveTrailingZeros(tmp);
+    data_len =
+        AdvertiseDataParser::GetLengthWithoutTrailingZeros(data, data_len);
 
   // We might have send scan request to this device before, but didn't get the
   // response. In such case make sure data is put at start, not appended to
   // already existing data.
-  std::vector<uint8_t> adv_data =
-        is_start ? cache.Set(addr_type, bda, std::move(tmp))
-                 : cache.Append(addr_type, bda, std::move(tmp));
+  // The report is assembled straight into the cache entry, which stays valid
+  // until it is cleared on the way out of this function.
+  const std::vector<uint8_t>& cached_data =
+      is_start ? cache.Set(addr_type, bda, data, data_len)
+               : cache.Append(addr_type, bda, data, data_len);
   bool data_complete;
   if (ble_evt_type_data_status(evt_type) == 0x01) {
     LOG(INFO) << __func__ <<  " Data not complete yet, waiting for more " << bda;
@@ -3271,71 +3297,79 @@ static void btm_ble_process_adv_pkt_cont(
       btm_cb.ble_ctr_cb.inq_var.scan_type == BTM_BLE_SCAN_MODE_ACTI;
   if (is_active_scan && is_scannable && !is_scan_resp) {
     // If we didn't receive scan response yet, don't report the device.
-    VLOG(1) << " Waiting for scan response " << bda;
+    TRACE_RING_LOG(VERBOSE, LOG_TAG, "%s waiting for scan response %s",
+                   __func__, TRACE_RING_ADDRESS(bda));
     return;
   }
 
+  /* one pass over the report locates every AD field used below */
+  AdvertiseDataIndex ad_index(cached_data);
   bool encrypted_data = false;
   bool is_decrypt_success = false;
-  uint8_t len1;
-  int len_enc_data;
-  int enc_data_begin_index = 0;
   std::map<int, int> enc_adv_data_map;
-  std::map<int, std::vector<uint8_t>> decrypted_data_map;
-  VLOG(1) << __func__ << "encrypted_data:" << encrypted_data;
-  if(AdvertiseDataParser::GetFieldByType(adv_data, BTM_BLE_AD_TYPE_ED, &len1)){
-    if(!AdvertiseDataParser::IsValid(adv_data)){
+  if (ad_index.HasField(BTM_BLE_AD_TYPE_ED)) {
+    if (!ad_index.IsValid()) {
         VLOG(1) << __func__ << "Dropping bad advertisement packet: "
-                << base::HexEncode(adv_data.data(), adv_data.size());
+                << base::HexEncode(cached_data.data(), cached_data.size());
       return;
     }
     encrypted_data = true;
     if (btm_cb.enc_adv_data_log_enabled) {
       VLOG(1) << __func__ << "FOUND ENCRYPTED DATA: "
-              << base::HexEncode(adv_data.data(), adv_data.size());
+              << base::HexEncode(cached_data.data(), cached_data.size());
     }
 
-    enc_adv_data_map =
-        AdvertiseDataParser::GetEncAdvFieldsInfo(adv_data.data(), adv_data.size());
+    enc_adv_data_map = AdvertiseDataParser::GetEncAdvFieldsInfo(
+        cached_data.data(), cached_data.size());
   }
   if (btm_cb.enc_adv_data_enabled) {
     if (encrypted_data) {
       if (btm_cb.enc_adv_data_log_enabled) {
         LOG(INFO) << " Adv data before decryption: "
-                  << base::HexEncode(adv_data.data(), adv_data.size());
+                  << base::HexEncode(cached_data.data(), cached_data.size());
       }
 
-      std::vector<uint8_t> decrypted_data =
-          btm_ble_process_encrypted_adv(bda, adv_data, &is_decrypt_success, enc_adv_data_map);
+      adv_data_decrypted = btm_ble_process_encrypted_adv(
+          bda, cached_data, &is_decrypt_success, enc_adv_data_map);
       if (!is_decrypt_success) {
         VLOG(1) << __func__ << " Decryption NOT successful, return:";
       }
 
-      if (!decrypted_data.empty()) {
+      if (!adv_data_decrypted.empty()) {
         LOG(INFO) << " decrypted_data is not empty: ";
-        adv_data.clear();
-        adv_data.insert(adv_data.begin(), decrypted_data.begin(), decrypted_data.end());
+        ad_index.Build(adv_data_decrypted);
       }
     }
   }
 
+  const std::vector<uint8_t>& adv_data =
+      adv_data_decrypted.empty() ? cached_data : adv_data_decrypted;
+
   if (btm_cb.enc_adv_data_log_enabled) {
     LOG(INFO) << " Adv data after decryption: "
               << base::HexEncode(adv_data.data(), adv_data.size());
   }
 
-  if (!AdvertiseDataParser::IsValid(adv_data)) {
+  if (!ad_index.IsValid()) {
     VLOG(1) << __func__ << "Dropping bad advertisement packet: "
             << base::HexEncode(adv_data.data(), adv_data.size());
     return;
   }
 
-  bool include_rsi = false;
-  uint8_t len;
-  if (AdvertiseDataParser::GetFieldByType(adv_data, BTM_BLE_AD_TYPE_RSI, &len)) {
-    include_rsi = true;
+  /* a device waiting for background connection is in range */
+  btm_ble_bgconn_device_seen(bda);
+
+  /* Without APCF the scan filters are evaluated here. Reports no filter asks
+   * for are still needed by an ongoing inquiry, but not by the scanners. */
+  bool host_filtered = !btm_ble_host_filter_match(
+      bda, original_bda, rssi, adv_data.data(), adv_data.size());
+  if (host_filtered && !p_inq->inq_active) {
+    cache.Clear(addr_type, bda);
+    return;
   }
 
+  bool include_rsi = ad_index.HasField(BTM_BLE_AD_TYPE_RSI);
+
   tINQ_DB_ENT* p_i = btm_inq_db_find(bda);
 
   /* Check if this address has already been processed for this inquiry */
@@ -3361,7 +3395,8 @@ static void btm_ble_process_adv_pkt_cont(
       /* updating the entry in INQ database */
       update = true;
     } else {
-      VLOG(1)<< __func__ << " skipped BDA " << bda;
+      TRACE_RING_LOG(VERBOSE, LOG_TAG, "%s skipped BDA %s", __func__,
+                     TRACE_RING_ADDRESS(bda));
       /* if yes, skip it */
       return; /* assumption: one result per event */
     }
@@ -3380,12 +3415,12 @@ static void btm_ble_process_adv_pkt_cont(
     p_inq->inq_cmpl_info.num_resp++;
   }
 
-  p_i->time_of_resp = time_get_os_boottime_ms();
+  btm_inq_db_touch(p_i);
 
   /* update the LE device information in inquiry database */
   btm_ble_update_inq_result(p_i, addr_type, bda, evt_type, primary_phy,
                             secondary_phy, advertising_sid, tx_power, rssi,
-                            periodic_adv_int, adv_data);
+                            periodic_adv_int, ad_index);
   if (include_rsi) {
     (&p_i->inq_info.results)->include_rsi = true;
   }
@@ -3393,8 +3428,7 @@ static void btm_ble_process_adv_pkt_cont(
   if (btm_cb.is_csip_opportunistic_scan_enabled && btm_cb.p_csip_scan_cb) {
       uint8_t data_len = 0;
       const uint8_t* g_data = NULL;
-      g_data = AdvertiseDataParser::GetFieldByType(adv_data, BTM_CSIP_RSI_TYPE,
-                                                   &data_len);
+      g_data = ad_index.GetFieldByType(BTM_CSIP_RSI_TYPE, &data_len);
       if (g_data && data_len == BTM_CSIP_RSI_LEN) {
          uint8_t gid_data[BTM_CSIP_RSI_LEN] = {};
          memcpy(gid_data, g_data, BTM_CSIP_RSI_LEN);
@@ -3402,7 +3436,7 @@ static void btm_ble_process_adv_pkt_cont(
       }
   }
 
-  uint8_t result = btm_ble_is_discoverable(bda, adv_data);
+  uint8_t result = btm_ble_is_discoverable(bda, ad_index);
   if (result == 0) {
     cache.Clear(addr_type, bda);
     LOG_WARN(LOG_TAG,
@@ -3412,6 +3446,7 @@ static void btm_ble_process_adv_pkt_cont(
   }
 
   if (!update) result &= ~BTM_BLE_INQ_RESULT;
+  if (host_filtered) result &= ~BTM_BLE_OBS_RESULT;
   /* If the number of responses found and limited, issue a cancel inquiry */
   if (p_inq->inqparms.max_resps &&
       p_inq->inq_cmpl_info.num_resp == p_inq->inqparms.max_resps) {
@@ -3466,6 +3501,7 @@ void btm_ble_process_phy_update_pkt(uint8_t len, uint8_t* data) {
   STREAM_TO_UINT8(tx_phy, p);
   STREAM_TO_UINT8(rx_phy, p);
 
+  btm_ble_phy_policy_phy_updated(status, handle, tx_phy, rx_phy);
   gatt_notify_phy_updated(status, handle, tx_phy, rx_phy);
 }
 
@@ -3784,6 +3820,7 @@ void btm_ble_read_remote_features_complete(uint8_t* p, uint8_t length) {
     device_iot_config_addr_set_bin(btm_cb.acl_db[idx].remote_addr, key,
             btm_cb.acl_db[idx].peer_le_features, BD_FEATURES_LEN);
 #endif
+    btm_ble_phy_policy_link_up(&btm_cb.acl_db[idx]);
   }
 
   btsnd_hcic_rmt_ver_req(handle);
@@ -4067,6 +4104,8 @@ void btm_ble_init(void) {
       alarm_new("btm_ble_addr.refresh_raddr_timer");
   memset(&btm_ble_pa_sync_cb, 0, sizeof(tBTM_BLE_PA_SYNC_TX_CB));
   sync_timeout_alarm = alarm_new("btm.sync_start_task");
+  btm_ble_pa_sync_cb.list_disabled =
+      !osi_property_get_bool("persist.vendor.btstack.enable.pa_sync_list", true);
 #if (BLE_VND_INCLUDED == FALSE)
   btm_ble_adv_filter_init();
 #endif
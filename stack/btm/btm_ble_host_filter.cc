@@ -0,0 +1,500 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the host side scan filter engine. It evaluates the
+ *  filters set through BTM_LE_PF_set on controllers without APCF support, so
+ *  that reports no filter asks for are dropped before they reach the upper
+ *  layers. Conditions the host cannot evaluate let every report through.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_btm_ble"
+
+#include <base/logging.h>
+#include <string.h>
+
+#include <array>
+#include <unordered_set>
+#include <vector>
+
+#include "bt_types.h"
+#include "btm_ble_api.h"
+#include "btm_int.h"
+#include "stack/crypto_toolbox/crypto_toolbox.h"
+
+using bluetooth::Uuid;
+
+#define BTM_BLE_PF_BIT_TO_MASK(x) (uint16_t)(1 << (x))
+
+/* Service solicitation AD types, not used anywhere else in the stack */
+#define BTM_BLE_AD_TYPE_SOL_SRV_UUID_16 0x14
+#define BTM_BLE_AD_TYPE_SOL_SRV_UUID_32 0x1F
+#define BTM_BLE_AD_TYPE_SOL_SRV_UUID_128 0x15
+
+namespace {
+
+/* Number of filter indexes the host engine keeps */
+constexpr size_t kMaxHostFilters = 32;
+
+struct AddressHash {
+  std::size_t operator()(const RawAddress& x) const {
+    const uint8_t* a = x.address;
+    return a[0] ^ (a[1] << 8) ^ (a[2] << 16) ^ (a[3] << 24) ^ a[4] ^
+           (a[5] << 8);
+  }
+};
+
+/* Identity address filter that also matches the RPAs of its IRK */
+struct IrkFilter {
+  aes_context irk;
+};
+
+struct MaskedUuid {
+  Uuid uuid;
+  Uuid mask;
+};
+
+/* Pattern compared against the start of a field, after |mask| is applied */
+struct MaskedPattern {
+  uint16_t company; /* manufacturer data only */
+  uint16_t company_mask;
+  std::vector<uint8_t> data;
+  std::vector<uint8_t> mask;
+};
+
+struct HostFilter {
+  bool in_use;
+  tBTM_BLE_PF_FILT_INDEX filt_index;
+
+  /* BTM_BLE_PF_BIT_TO_MASK of the condition types that were added */
+  uint16_t features;
+  /* set when a condition the host cannot evaluate was added */
+  bool pass_all;
+
+  /* from BTM_BleAdvFilterParamSetup */
+  bool has_params;
+  uint16_t feat_seln;
+  uint8_t filt_logic_type;
+  int8_t rssi_high_thres;
+
+  std::unordered_set<RawAddress, AddressHash> addresses;
+  std::vector<IrkFilter> irks;
+  /* indexed by BTM_BLE_PF_SRVC_UUID - BTM_BLE_PF_SRVC_UUID and
+   * BTM_BLE_PF_SRVC_SOL_UUID - BTM_BLE_PF_SRVC_UUID */
+  std::unordered_set<Uuid> uuids[2];
+  std::vector<MaskedUuid> masked_uuids[2];
+  std::vector<std::vector<uint8_t>> names;
+  std::vector<MaskedPattern> manu_data;
+  std::vector<MaskedPattern> srvc_data;
+};
+
+bool host_filter_enabled = false;
+std::array<HostFilter, kMaxHostFilters> host_filters;
+
+HostFilter* find_filter(tBTM_BLE_PF_FILT_INDEX filt_index) {
+  for (HostFilter& filter : host_filters) {
+    if (filter.in_use && filter.filt_index == filt_index) return &filter;
+  }
+  return nullptr;
+}
+
+HostFilter* find_or_alloc_filter(tBTM_BLE_PF_FILT_INDEX filt_index) {
+  HostFilter* p_filter = find_filter(filt_index);
+  if (p_filter) return p_filter;
+
+  for (HostFilter& filter : host_filters) {
+    if (!filter.in_use) {
+      filter = HostFilter();
+      filter.in_use = true;
+      filter.filt_index = filt_index;
+      return &filter;
+    }
+  }
+  return nullptr;
+}
+
+/* Returns true if the start of |field| matches |pattern| under its mask */
+bool pattern_matches(const uint8_t* field, uint8_t len,
+                     const std::vector<uint8_t>& pattern,
+                     const std::vector<uint8_t>& mask) {
+  if (len < pattern.size()) return false;
+  for (size_t i = 0; i < pattern.size(); i++) {
+    uint8_t m = i < mask.size() ? mask[i] : 0xFF;
+    if ((field[i] & m) != (pattern[i] & m)) return false;
+  }
+  return true;
+}
+
+bool uuid_matches(const Uuid& uuid, const MaskedUuid& filter) {
+  const Uuid::UUID128Bit& a = uuid.To128BitBE();
+  const Uuid::UUID128Bit& b = filter.uuid.To128BitBE();
+  const Uuid::UUID128Bit& m = filter.mask.To128BitBE();
+  for (size_t i = 0; i < Uuid::kNumBytes128; i++) {
+    if ((a[i] & m[i]) != (b[i] & m[i])) return false;
+  }
+  return true;
+}
+
+bool rpa_matches(const RawAddress& rpa, const aes_context& irk) {
+  uint8_t prand[3] = {rpa.address[2], rpa.address[1], rpa.address[0]};
+  Octet16 hash = crypto_toolbox::aes_128(irk, prand, sizeof(prand));
+  return hash[0] == rpa.address[5] && hash[1] == rpa.address[4] &&
+         hash[2] == rpa.address[3];
+}
+
+/* Adds the UUIDs of size |uuid_len| in the list |p| of |len| bytes to the
+ * matches of |filter| for condition |cond| */
+uint16_t match_uuid_list(const HostFilter& filter, uint8_t cond,
+                         const uint8_t* p, uint8_t len, size_t uuid_len) {
+  const size_t list = cond - BTM_BLE_PF_SRVC_UUID;
+  if (filter.uuids[list].empty() && filter.masked_uuids[list].empty())
+    return 0;
+
+  for (size_t i = 0; i + uuid_len <= len; i += uuid_len) {
+    Uuid uuid;
+    if (uuid_len == Uuid::kNumBytes16)
+      uuid = Uuid::From16Bit(p[i] | (p[i + 1] << 8));
+    else if (uuid_len == Uuid::kNumBytes32)
+      uuid = Uuid::From32Bit(p[i] | (p[i + 1] << 8) | (p[i + 2] << 16) |
+                             ((uint32_t)p[i + 3] << 24));
+    else
+      uuid = Uuid::From128BitLE(p + i);
+
+    if (filter.uuids[list].count(uuid)) return BTM_BLE_PF_BIT_TO_MASK(cond);
+    for (const MaskedUuid& masked : filter.masked_uuids[list]) {
+      if (uuid_matches(uuid, masked)) return BTM_BLE_PF_BIT_TO_MASK(cond);
+    }
+  }
+  return 0;
+}
+
+/* Returns the BTM_BLE_PF_BIT_TO_MASK of the conditions of |filter| matched
+ * by the AD field of |type| with |len| bytes of data at |p| */
+uint16_t match_field(const HostFilter& filter, uint8_t type, const uint8_t* p,
+                     uint8_t len) {
+  switch (type) {
+    case HCI_EIR_MORE_16BITS_UUID_TYPE:
+    case HCI_EIR_COMPLETE_16BITS_UUID_TYPE:
+      return match_uuid_list(filter, BTM_BLE_PF_SRVC_UUID, p, len,
+                             Uuid::kNumBytes16);
+    case HCI_EIR_MORE_32BITS_UUID_TYPE:
+    case HCI_EIR_COMPLETE_32BITS_UUID_TYPE:
+      return match_uuid_list(filter, BTM_BLE_PF_SRVC_UUID, p, len,
+                             Uuid::kNumBytes32);
+    case HCI_EIR_MORE_128BITS_UUID_TYPE:
+    case HCI_EIR_COMPLETE_128BITS_UUID_TYPE:
+      return match_uuid_list(filter, BTM_BLE_PF_SRVC_UUID, p, len,
+                             Uuid::kNumBytes128);
+    case BTM_BLE_AD_TYPE_SOL_SRV_UUID_16:
+      return match_uuid_list(filter, BTM_BLE_PF_SRVC_SOL_UUID, p, len,
+                             Uuid::kNumBytes16);
+    case BTM_BLE_AD_TYPE_SOL_SRV_UUID_32:
+      return match_uuid_list(filter, BTM_BLE_PF_SRVC_SOL_UUID, p, len,
+                             Uuid::kNumBytes32);
+    case BTM_BLE_AD_TYPE_SOL_SRV_UUID_128:
+      return match_uuid_list(filter, BTM_BLE_PF_SRVC_SOL_UUID, p, len,
+                             Uuid::kNumBytes128);
+
+    case HCI_EIR_SHORTENED_LOCAL_NAME_TYPE:
+    case HCI_EIR_COMPLETE_LOCAL_NAME_TYPE:
+      for (const std::vector<uint8_t>& name : filter.names) {
+        /* a shortened name matches the start of the name */
+        if (len > name.size()) continue;
+        if (len < name.size() && type != HCI_EIR_SHORTENED_LOCAL_NAME_TYPE) continue;
+        if (memcmp(p, name.data(), len) == 0)
+          return BTM_BLE_PF_BIT_TO_MASK(BTM_BLE_PF_LOCAL_NAME);
+      }
+      return 0;
+
+    case HCI_EIR_MANUFACTURER_SPECIFIC_TYPE: {
+      if (len < 2) return 0;
+      uint16_t company = p[0] | (p[1] << 8);
+      for (const MaskedPattern& manu : filter.manu_data) {
+        if ((company & manu.company_mask) !=
+            (manu.company & manu.company_mask))
+          continue;
+        if (manu.mask.empty() ||
+            pattern_matches(p + 2, len - 2, manu.data, manu.mask))
+          return BTM_BLE_PF_BIT_TO_MASK(BTM_BLE_PF_MANU_DATA);
+      }
+      return 0;
+    }
+
+    case HCI_EIR_SERVICE_DATA_16BITS_UUID_TYPE:
+    case HCI_EIR_SERVICE_DATA_32BITS_UUID_TYPE:
+    case HCI_EIR_SERVICE_DATA_128BITS_UUID_TYPE: {
+      uint16_t matched = BTM_BLE_PF_BIT_TO_MASK(BTM_BLE_PF_SRVC_DATA);
+      for (const MaskedPattern& srvc : filter.srvc_data) {
+        if (pattern_matches(p, len, srvc.data, srvc.mask)) {
+          matched |= BTM_BLE_PF_BIT_TO_MASK(BTM_BLE_PF_SRVC_DATA_PATTERN);
+          break;
+        }
+      }
+      return matched;
+    }
+
+    default:
+      return 0;
+  }
+}
+
+bool filter_matches(const HostFilter& filter, const RawAddress& bda,
+                    const RawAddress& original_bda, int8_t rssi,
+                    const uint8_t* p_data, size_t data_len) {
+  if (filter.pass_all) return true;
+
+  if (filter.has_params && rssi < filter.rssi_high_thres) return false;
+
+  uint16_t required = filter.features;
+  if (filter.has_params) required &= filter.feat_seln;
+  if (required == 0) return true;
+
+  uint16_t matched = 0;
+  if (filter.addresses.count(bda) || filter.addresses.count(original_bda)) {
+    matched |= BTM_BLE_PF_BIT_TO_MASK(BTM_BLE_PF_ADDR_FILTER);
+  } else if (BTM_BLE_IS_RESOLVE_BDA(original_bda)) {
+    for (const IrkFilter& irk : filter.irks) {
+      if (rpa_matches(original_bda, irk.irk)) {
+        matched |= BTM_BLE_PF_BIT_TO_MASK(BTM_BLE_PF_ADDR_FILTER);
+        break;
+      }
+    }
+  }
+
+  size_t position = 0;
+  while (position < data_len) {
+    uint8_t len = p_data[position];
+    if (len == 0 || position + len >= data_len) break;
+
+    matched |= match_field(filter, p_data[position + 1],
+                           p_data + position + 2, len - 1);
+    position += len + 1;
+  }
+
+  matched &= required;
+  if (filter.has_params && filter.filt_logic_type == BTM_BLE_PF_LOGIC_OR)
+    return matched != 0;
+  return matched == required;
+}
+
+}  // namespace
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_host_filter_add
+ *
+ * Description      This function compiles the filter conditions |commands|
+ *                  into the host filter of |filt_index|.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_ble_host_filter_add(tBTM_BLE_PF_FILT_INDEX filt_index,
+                             const std::vector<ApcfCommand>& commands) {
+  HostFilter* p_filter = find_or_alloc_filter(filt_index);
+  if (!p_filter) {
+    LOG(ERROR) << __func__ << ": no room for filter index " << +filt_index
+               << ", host filtering disabled";
+    host_filter_enabled = false;
+    return;
+  }
+
+  for (const ApcfCommand& cmd : commands) {
+    /* If data is passed, both mask and data have to be the same length */
+    if (cmd.data.size() != cmd.data_mask.size() && cmd.data.size() != 0 &&
+        cmd.data_mask.size() != 0)
+      continue;
+
+    switch (cmd.type) {
+      case BTM_BLE_PF_ADDR_FILTER: {
+        p_filter->addresses.insert(cmd.address);
+        bool has_irk = false;
+        for (uint8_t b : cmd.irk) has_irk |= (b != 0);
+        if (has_irk) {
+          Octet16 irk;
+          std::copy(cmd.irk.begin(), cmd.irk.end(), irk.begin());
+          p_filter->irks.emplace_back();
+          crypto_toolbox::aes_128_set_key(irk, &p_filter->irks.back().irk);
+        }
+        break;
+      }
+
+      case BTM_BLE_PF_SRVC_DATA:
+        break;
+
+      case BTM_BLE_PF_SRVC_UUID:
+      case BTM_BLE_PF_SRVC_SOL_UUID: {
+        size_t list = cmd.type - BTM_BLE_PF_SRVC_UUID;
+        if (cmd.uuid_mask.IsEmpty())
+          p_filter->uuids[list].insert(cmd.uuid);
+        else
+          p_filter->masked_uuids[list].push_back({cmd.uuid, cmd.uuid_mask});
+        break;
+      }
+
+      case BTM_BLE_PF_LOCAL_NAME:
+        p_filter->names.push_back(cmd.name);
+        break;
+
+      case BTM_BLE_PF_MANU_DATA: {
+        MaskedPattern manu;
+        manu.company = cmd.company;
+        manu.company_mask = cmd.company_mask ? cmd.company_mask : 0xFFFF;
+        if (!cmd.data_mask.empty()) {
+          manu.data = cmd.data;
+          manu.mask = cmd.data_mask;
+        }
+        p_filter->manu_data.push_back(std::move(manu));
+        break;
+      }
+
+      case BTM_BLE_PF_SRVC_DATA_PATTERN:
+        p_filter->srvc_data.push_back({0, 0, cmd.data, cmd.data_mask});
+        break;
+
+      default:
+        /* transport discovery and group data are left to the upper layers */
+        VLOG(1) << __func__ << ": filter type " << +cmd.type
+                << " not evaluated on the host";
+        p_filter->pass_all = true;
+        break;
+    }
+    p_filter->features |= BTM_BLE_PF_BIT_TO_MASK(cmd.type);
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_host_filter_clear
+ *
+ * Description      This function removes all conditions of |filt_index|.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_ble_host_filter_clear(tBTM_BLE_PF_FILT_INDEX filt_index) {
+  HostFilter* p_filter = find_filter(filt_index);
+  if (!p_filter) return;
+
+  bool has_params = p_filter->has_params;
+  uint16_t feat_seln = p_filter->feat_seln;
+  uint8_t filt_logic_type = p_filter->filt_logic_type;
+  int8_t rssi_high_thres = p_filter->rssi_high_thres;
+
+  *p_filter = HostFilter();
+  p_filter->filt_index = filt_index;
+  p_filter->in_use = has_params;
+  p_filter->has_params = has_params;
+  p_filter->feat_seln = feat_seln;
+  p_filter->filt_logic_type = filt_logic_type;
+  p_filter->rssi_high_thres = rssi_high_thres;
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_host_filter_param_setup
+ *
+ * Description      This function applies the filter parameters of
+ *                  BTM_BleAdvFilterParamSetup |action| to the host filter of
+ *                  |filt_index|.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_ble_host_filter_param_setup(int action,
+                                     tBTM_BLE_PF_FILT_INDEX filt_index,
+                                     const btgatt_filt_param_setup_t* p_params) {
+  if (action == BTM_BLE_SCAN_COND_CLEAR) {
+    for (HostFilter& filter : host_filters) filter = HostFilter();
+    return;
+  }
+
+  if (action == BTM_BLE_SCAN_COND_DELETE) {
+    HostFilter* p_filter = find_filter(filt_index);
+    if (p_filter) *p_filter = HostFilter();
+    return;
+  }
+
+  HostFilter* p_filter = find_or_alloc_filter(filt_index);
+  if (!p_filter) {
+    LOG(ERROR) << __func__ << ": no room for filter index " << +filt_index
+               << ", host filtering disabled";
+    host_filter_enabled = false;
+    return;
+  }
+
+  p_filter->has_params = true;
+  p_filter->feat_seln = p_params->feat_seln;
+  p_filter->filt_logic_type = p_params->filt_logic_type;
+  p_filter->rssi_high_thres = (int8_t)p_params->rssi_high_thres;
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_host_filter_enable
+ *
+ * Description      This function turns host filtering on or off.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_ble_host_filter_enable(bool enable) { host_filter_enabled = enable; }
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_host_filter_match
+ *
+ * Description      This function checks an advertising report from |bda|,
+ *                  received as |original_bda|, with |rssi| and |data_len|
+ *                  bytes of advertising data at |p_data|, against the host
+ *                  filters.
+ *
+ * Returns          true if the report is to be delivered, false if no filter
+ *                  asks for it.
+ *
+ ******************************************************************************/
+bool btm_ble_host_filter_match(const RawAddress& bda,
+                               const RawAddress& original_bda, int8_t rssi,
+                               const uint8_t* p_data, size_t data_len) {
+  if (!host_filter_enabled) return true;
+
+  bool any_filter = false;
+  for (const HostFilter& filter : host_filters) {
+    if (!filter.in_use) continue;
+    any_filter = true;
+    if (filter_matches(filter, bda, original_bda, rssi, p_data, data_len))
+      return true;
+  }
+  return !any_filter;
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_host_filter_cleanup
+ *
+ * Description      This function drops all host filters.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_ble_host_filter_cleanup(void) {
+  host_filter_enabled = false;
+  for (HostFilter& filter : host_filters) filter = HostFilter();
+}
@@ -36,14 +36,18 @@
 #include "btm_ble_int_types.h"
 #include "btm_int.h"
 #include "btm_int_types.h"
+#include "hci_event_view.h"
 #include "hcidefs.h"
 #include "smp_api.h"
 
 extern bool ble_evt_type_is_connectable(uint16_t evt_type);
 extern void btm_ble_refresh_raddr_timer_timeout(void* data);
-extern void btm_ble_process_adv_pkt(uint8_t len, uint8_t* p);
+extern void btm_ble_process_adv_pkt(HciLeAdvertisingReportView event);
 extern void btm_ble_process_phy_update_pkt(uint8_t len, uint8_t* p);
-extern void btm_ble_process_ext_adv_pkt(uint8_t len, uint8_t* p);
+extern void btm_ble_phy_policy_link_up(tACL_CONN* p_acl);
+extern void btm_ble_phy_policy_phy_updated(uint8_t status, uint16_t handle,
+                                           uint8_t tx_phy, uint8_t rx_phy);
+extern void btm_ble_process_ext_adv_pkt(HciLeExtAdvertisingReportView event);
 extern void btm_ble_proc_scan_rsp_rpt(uint8_t* p);
 extern tBTM_STATUS btm_ble_read_remote_name(const RawAddress& remote_bda,
                                             tBTM_CMPL_CB* p_cb);
@@ -143,6 +147,8 @@ extern void btm_ble_update_mode_operation(uint8_t link_role,
 extern bool btm_execute_wl_dev_operation(void);
 extern void btm_ble_update_link_topology_mask(uint8_t role, bool increase);
 extern void btm_ble_bgconn_cancel_if_disconnected(const RawAddress& bd_addr);
+extern void btm_ble_bgconn_device_seen(const RawAddress& bd_addr);
+extern void btm_ble_bgconn_link_lost(const RawAddress& bd_addr);
 
 /* BLE address management */
 extern void btm_gen_resolvable_private_addr(
@@ -151,6 +157,8 @@ extern void btm_gen_non_resolvable_private_addr(tBTM_BLE_ADDR_CBACK* p_cback,
                                                 void* p);
 extern tBTM_SEC_DEV_REC* btm_ble_resolve_random_addr(
     const RawAddress& random_bda);
+extern void btm_ble_resolver_forget_dev(const tBTM_SEC_DEV_REC* p_dev_rec);
+extern void btm_ble_resolver_irk_added(void);
 extern void btm_gen_resolve_paddr_low(const RawAddress& address);
 extern uint64_t btm_get_next_private_addrress_interval_ms();
 
@@ -177,6 +185,10 @@ extern void btm_read_ble_resolving_list_size_complete(uint8_t* p,
                                                       uint16_t evt_len);
 extern void btm_ble_enable_resolving_list(uint8_t);
 extern bool btm_ble_disable_resolving_list(uint8_t rl_mask, bool to_resume);
+extern void btm_ble_resolving_list_batch_start(void);
+extern void btm_ble_resolving_list_batch_end(void);
+extern tBTM_STATUS btm_ble_resolving_list_sync(uint8_t rl_mask,
+                                               tBTM_BLE_RL_SYNC_CBACK* p_cback);
 extern void btm_ble_enable_resolving_list_for_platform(uint8_t rl_mask);
 extern void btm_ble_enable_resolving_list_for_scan(uint8_t rl_mask);
 extern void btm_ble_resolving_list_init(uint8_t max_irk_list_sz);
@@ -193,6 +205,18 @@ extern void btm_ble_batchscan_init(void);
 extern void btm_ble_batchscan_cleanup(void);
 extern void btm_ble_adv_filter_init(void);
 extern void btm_ble_adv_filter_cleanup(void);
+extern void btm_ble_host_filter_add(tBTM_BLE_PF_FILT_INDEX filt_index,
+                                    const std::vector<ApcfCommand>& commands);
+extern void btm_ble_host_filter_clear(tBTM_BLE_PF_FILT_INDEX filt_index);
+extern void btm_ble_host_filter_param_setup(
+    int action, tBTM_BLE_PF_FILT_INDEX filt_index,
+    const btgatt_filt_param_setup_t* p_params);
+extern void btm_ble_host_filter_enable(bool enable);
+extern bool btm_ble_host_filter_match(const RawAddress& bda,
+                                      const RawAddress& original_bda,
+                                      int8_t rssi, const uint8_t* p_data,
+                                      size_t data_len);
+extern void btm_ble_host_filter_cleanup(void);
 extern bool btm_ble_topology_check(tBTM_BLE_STATE_MASK request);
 extern bool btm_ble_clear_topology_mask(tBTM_BLE_STATE_MASK request_state);
 extern bool btm_ble_set_topology_mask(tBTM_BLE_STATE_MASK request_state);
@@ -24,15 +24,20 @@
 #include "bt_target.h"
 #include "device/include/controller.h"
 #include "osi/include/alarm.h"
+#include "osi/include/properties.h"
 
 #include "stack_config.h"
 #include "ble_advertiser.h"
 #include "ble_advertiser_hci_interface.h"
 #include "btm_int.h"
 #include "btm_int_types.h"
+#include "btm_iso_tx.h"
 #include "stack/btm/btm_ble_int.h"
 
+#include <inttypes.h>
 #include <string.h>
+#include <algorithm>
+#include <map>
 #include <string>
 #include <queue>
 #include <vector>
@@ -88,6 +93,8 @@ struct IsoBIGInstance {
   std::vector<uint16_t> bis_handles;
   uint8_t adv_inst_id;
   bool created_status;
+  uint32_t sdu_int;
+  uint16_t max_sdu;
   CreateBIGCb create_big_cb;
   TerminateBIGCb terminate_big_cb;
 
@@ -96,7 +103,9 @@ struct IsoBIGInstance {
   IsoBIGInstance(int big_handle)
       : big_handle(big_handle),
         in_use(false),
-        created_status(false) {
+        created_status(false),
+        sdu_int(0),
+        max_sdu(0) {
   }
 
   ~IsoBIGInstance() {
@@ -142,6 +151,19 @@ struct AdvertisingInstance {
 
   uint8_t big_handle;
 
+  /* Payloads last written to the controller, indexed by is_scan_rsp. An
+   * update that produces the same payload is not sent again. */
+  std::vector<uint8_t> sent_data[2];
+  bool sent_data_valid[2];
+
+  /* Updates held back until |data_timer| fires, indexed by is_scan_rsp */
+  alarm_t* data_timer[2];
+  TimeTicks data_sent_time[2];
+  bool data_pending[2];
+  std::vector<uint8_t> pending_data[2];
+  std::vector<uint8_t> pending_encr_data[2];
+  MultiAdvCb pending_cb[2];
+
   bool IsEnabled() { return enable_status; }
 
   bool IsConnectable() { return is_connectable(advertising_event_properties); }
@@ -160,7 +182,10 @@ struct AdvertisingInstance {
         skip_rpa_count(0),
         skip_rpa(false),
         enable_status(false),
-        big_handle(INVALID_BIG_HANDLE) {
+        big_handle(INVALID_BIG_HANDLE),
+        sent_data_valid{false, false},
+        data_timer{nullptr, nullptr},
+        data_pending{false, false} {
     adv_raddr_timer = alarm_new_periodic("btm_ble.adv_raddr_timer");
   }
 
@@ -172,6 +197,10 @@ struct AdvertisingInstance {
       alarm_free(timeout_timer);
       timeout_timer = nullptr;
     }
+    for (alarm_t*& timer : data_timer) {
+      alarm_free(timer);
+      timer = nullptr;
+    }
   }
 };
 
@@ -199,6 +228,38 @@ void alarm_set_closure(const base::Location& posted_from, alarm_t* alarm,
   alarm_set_on_mloop(alarm, interval_ms, alarm_closure_cb, data);
 }
 
+/* Logical advertising sets are handed out when all hardware instances are in
+ * use. Their ids start here, well above any controller instance count. */
+constexpr uint8_t kLogicalSetIdBase = 0x80;
+constexpr uint8_t kLogicalSetIdMax = 0xFE;
+
+/* Advertising interval, in 0.625 ms units, that earns a logical set a weight
+ * of 1. Sets asking for faster advertising get proportionally more airtime. */
+constexpr uint32_t kLogicalSetWeightInterval = 1600; /* 1 s */
+constexpr uint32_t kLogicalSetMaxWeight = 16;
+
+/* A non-connectable advertising set without a hardware instance of its own.
+ * The rotation puts it on one of the reserved instances for some of the
+ * time slices. */
+struct LogicalAdvertisingSet {
+  uint8_t id;
+  bool enabled;
+  tBTM_BLE_ADV_PARAMS params;
+  std::vector<uint8_t> advertise_data;
+  std::vector<uint8_t> scan_response_data;
+
+  uint32_t weight;
+  /* smooth weighted round robin state */
+  int64_t credit;
+  /* reserved hardware instance it is on, -1 when off air */
+  int slot;
+
+  /* statistics */
+  uint32_t slices;
+  TimeTicks on_air_since;
+  TimeDelta on_air;
+};
+
 class BleAdvertisingManagerImpl;
 
 /* a temporary type for holding all the data needed in callbacks below*/
@@ -239,19 +300,38 @@ class BleAdvertisingManagerImpl
  public:
   BleAdvertisingManagerImpl(BleAdvertiserHciInterface* interface)
       : hci_interface(interface), weak_factory_(this) {
+    data_update_window_ms = osi_property_get_int32(
+        "persist.vendor.btstack.adv_data_update_window_ms", 0);
+    mux_slot_count =
+        osi_property_get_int32("persist.vendor.btstack.adv_mux_slots", 0);
+    mux_slice_ms =
+        osi_property_get_int32("persist.vendor.btstack.adv_mux_slice_ms", 1000);
     hci_interface->ReadInstanceCount(
         base::Bind(&BleAdvertisingManagerImpl::ReadInstanceCountCb,
                    weak_factory_.GetWeakPtr()));
   }
 
-  ~BleAdvertisingManagerImpl() { adv_inst.clear(); }
+  ~BleAdvertisingManagerImpl() {
+    alarm_free(mux_timer);
+    adv_inst.clear();
+  }
 
   void GetOwnAddress(uint8_t inst_id, GetAddressCallback cb) override {
+    if (IsLogicalSet(inst_id)) {
+      LogicalAdvertisingSet* p_set = FindLogicalSet(inst_id);
+      int slot = p_set && p_set->slot >= 0 ? p_set->slot : FirstMuxSlot();
+      cb.Run(adv_inst[slot].own_address_type, adv_inst[slot].own_address);
+      return;
+    }
+
     cb.Run(adv_inst[inst_id].own_address_type, adv_inst[inst_id].own_address);
   }
 
   void ReadInstanceCountCb(uint8_t instance_count) {
     this->inst_count = instance_count;
+    /* keep at least one instance for sets that can't be multiplexed */
+    if (mux_slot_count >= inst_count) mux_slot_count = inst_count - 1;
+    if (mux_slot_count < 0) mux_slot_count = 0;
     adv_inst.reserve(inst_count);
     /* Initialize adv instance indices and IDs. */
     for (uint8_t i = 0; i < inst_count; i++) {
@@ -552,8 +632,16 @@ class BleAdvertisingManagerImpl
   void RegisterAdvertiserImpl(
       int own_address_type,
       base::Callback<void(uint8_t /* inst_id */, uint8_t /* status */)> cb) {
-    AdvertisingInstance* p_inst = &adv_inst[0];
-    for (uint8_t i = 0; i < inst_count; i++, p_inst++) {
+    /* the instances reserved for logical sets are at the end */
+    RegisterAdvertiserInRange(own_address_type, 0, FirstMuxSlot(),
+                              std::move(cb));
+  }
+
+  void RegisterAdvertiserInRange(
+      int own_address_type, uint8_t first, uint8_t last,
+      base::Callback<void(uint8_t /* inst_id */, uint8_t /* status */)> cb) {
+    AdvertisingInstance* p_inst = &adv_inst[first];
+    for (uint8_t i = first; i < last; i++, p_inst++) {
       if (p_inst->in_use) continue;
 
       p_inst->in_use = true;
@@ -771,6 +859,12 @@ class BleAdvertisingManagerImpl
           return;
         }
 
+        if (status == ADVERTISE_FAILED_TOO_MANY_ADVERTISERS &&
+            c->self->CanMultiplex(c.get())) {
+          c->self->StartLogicalSet(std::move(c));
+          return;
+        }
+
         if (status != 0) {
           LOG(ERROR) << " failed, status: " << +status;
           c->cb.Run(0, 0, status);
@@ -981,6 +1075,12 @@ class BleAdvertisingManagerImpl
   void Enable(uint8_t inst_id, bool enable, MultiAdvCb cb, uint16_t duration,
               uint8_t maxExtAdvEvents, MultiAdvCb timeout_cb) override {
     VLOG(1) << __func__ << " inst_id: " << +inst_id;
+    if (IsLogicalSet(inst_id)) {
+      EnableLogicalSet(inst_id, enable, duration, maxExtAdvEvents,
+                       std::move(cb));
+      return;
+    }
+
     if (inst_id >= inst_count) {
       LOG(ERROR) << "bad instance id " << +inst_id;
       return;
@@ -1042,6 +1142,11 @@ class BleAdvertisingManagerImpl
   void SetParameters(uint8_t inst_id, tBTM_BLE_ADV_PARAMS* p_params,
                      ParametersCb cb) override {
     VLOG(1) << __func__ << " inst_id: " << +inst_id;
+    if (IsLogicalSet(inst_id)) {
+      SetLogicalSetParameters(inst_id, p_params, std::move(cb));
+      return;
+    }
+
     if (inst_id >= inst_count) {
       LOG(ERROR) << "bad instance id " << +inst_id;
       return;
@@ -1097,6 +1202,88 @@ class BleAdvertisingManagerImpl
 
   void SetData(uint8_t inst_id, bool is_scan_rsp, std::vector<uint8_t> data,
                std::vector<uint8_t> encr_data, MultiAdvCb cb) override {
+    if (IsLogicalSet(inst_id)) {
+      SetLogicalSetData(inst_id, is_scan_rsp, std::move(data),
+                        std::move(encr_data), std::move(cb));
+      return;
+    }
+
+    if (data_update_window_ms <= 0 || inst_id >= inst_count) {
+      SetDataImpl(inst_id, is_scan_rsp, std::move(data), std::move(encr_data),
+                  std::move(cb));
+      return;
+    }
+
+    /* Rate limit the updates of each payload to one per window. Updates
+     * arriving within the window replace each other, only the last one is
+     * written once the window is over. */
+    AdvertisingInstance* p_inst = &adv_inst[inst_id];
+    TimeDelta since_sent = TimeTicks::Now() - p_inst->data_sent_time[is_scan_rsp];
+    TimeDelta window = TimeDelta::FromMilliseconds(data_update_window_ms);
+    if (!p_inst->data_pending[is_scan_rsp] && since_sent >= window) {
+      p_inst->data_sent_time[is_scan_rsp] = TimeTicks::Now();
+      SetDataImpl(inst_id, is_scan_rsp, std::move(data), std::move(encr_data),
+                  std::move(cb));
+      return;
+    }
+
+    if (p_inst->data_pending[is_scan_rsp]) {
+      VLOG(1) << __func__ << " inst_id: " << +inst_id
+              << " update superseded before it was written";
+      p_inst->pending_cb[is_scan_rsp].Run(BTM_BLE_MULTI_ADV_SUCCESS);
+    }
+    p_inst->pending_data[is_scan_rsp] = std::move(data);
+    p_inst->pending_encr_data[is_scan_rsp] = std::move(encr_data);
+    p_inst->pending_cb[is_scan_rsp] = std::move(cb);
+    if (p_inst->data_pending[is_scan_rsp]) return;
+
+    p_inst->data_pending[is_scan_rsp] = true;
+    if (!p_inst->data_timer[is_scan_rsp])
+      p_inst->data_timer[is_scan_rsp] = alarm_new("btm_ble.adv_data_timer");
+    alarm_set_closure(
+        FROM_HERE, p_inst->data_timer[is_scan_rsp],
+        (window - since_sent).InMilliseconds(),
+        base::Bind(&BleAdvertisingManagerImpl::SetPendingData,
+                   weak_factory_.GetWeakPtr(), inst_id, is_scan_rsp));
+  }
+
+  void SetPendingData(uint8_t inst_id, bool is_scan_rsp) {
+    AdvertisingInstance* p_inst = &adv_inst[inst_id];
+    if (!p_inst->data_pending[is_scan_rsp]) return;
+
+    p_inst->data_pending[is_scan_rsp] = false;
+    p_inst->data_sent_time[is_scan_rsp] = TimeTicks::Now();
+    SetDataImpl(inst_id, is_scan_rsp,
+                std::move(p_inst->pending_data[is_scan_rsp]),
+                std::move(p_inst->pending_encr_data[is_scan_rsp]),
+                std::move(p_inst->pending_cb[is_scan_rsp]));
+  }
+
+  /* Drops an update held back by SetData, completing it with |status| */
+  void CancelPendingData(AdvertisingInstance* p_inst, uint8_t status) {
+    for (int is_scan_rsp = 0; is_scan_rsp < 2; is_scan_rsp++) {
+      if (p_inst->data_timer[is_scan_rsp])
+        alarm_cancel(p_inst->data_timer[is_scan_rsp]);
+      if (!p_inst->data_pending[is_scan_rsp]) continue;
+
+      p_inst->data_pending[is_scan_rsp] = false;
+      p_inst->pending_data[is_scan_rsp].clear();
+      p_inst->pending_encr_data[is_scan_rsp].clear();
+      MultiAdvCb cb = std::move(p_inst->pending_cb[is_scan_rsp]);
+      cb.Run(status);
+    }
+  }
+
+  /* Completes a payload write started by SetDataImpl */
+  void SetDataSent(uint8_t inst_id, bool is_scan_rsp, MultiAdvCb cb,
+                   uint8_t status) {
+    /* the controller contents are unknown after a failed write */
+    if (status != 0) adv_inst[inst_id].sent_data_valid[is_scan_rsp] = false;
+    cb.Run(status);
+  }
+
+  void SetDataImpl(uint8_t inst_id, bool is_scan_rsp, std::vector<uint8_t> data,
+                   std::vector<uint8_t> encr_data, MultiAdvCb cb) {
     if (!encr_data.empty() && !btm_cb.enc_adv_data_enabled) {
       LOG(ERROR) << __func__ << " Encrypted Advertising Feature" <<
                                 " not Enabled but Encrypted Data is provided";
@@ -1115,8 +1302,10 @@ class BleAdvertisingManagerImpl
     bool restart = false;
     if (((data.size() + encr_data.size()) > EXT_ADV_DATA_LEN_MAX) && p_inst->IsEnabled()) {
       restart = true;
-      GetHciInterface()->Enable(false, inst_id, p_inst->duration,
-                                p_inst->maxExtAdvEvents, base::DoNothing());
+      /* unencrypted data is compared with what the controller has first */
+      if (!encr_data.empty())
+        GetHciInterface()->Enable(false, inst_id, p_inst->duration,
+                                  p_inst->maxExtAdvEvents, base::DoNothing());
     }
     if (is_scan_rsp) {
       if (btm_cb.enc_adv_data_log_enabled) {
@@ -1158,6 +1347,8 @@ class BleAdvertisingManagerImpl
 
     /* This is the check to see if there is any data that needs to be encrypted */
     if (!encr_data.empty()) {
+      /* a new randomizer is generated for every write */
+      p_inst->sent_data_valid[is_scan_rsp] = false;
       GenerateRandomizer(p_inst,
       Bind(
         [](AdvertisingInstance *p_inst, std::vector<uint8_t> data,
@@ -1223,7 +1414,22 @@ class BleAdvertisingManagerImpl
         i += data[i] + 1;
       }
 
+      if (p_inst->sent_data_valid[is_scan_rsp] &&
+          p_inst->sent_data[is_scan_rsp] == data) {
+        VLOG(1) << __func__ << " inst_id: " << +inst_id
+                << " data unchanged, not written";
+        cb.Run(BTM_BLE_MULTI_ADV_SUCCESS);
+        return;
+      }
+      p_inst->sent_data[is_scan_rsp] = data;
+      p_inst->sent_data_valid[is_scan_rsp] = true;
+      cb = base::Bind(&BleAdvertisingManagerImpl::SetDataSent,
+                      weak_factory_.GetWeakPtr(), inst_id, is_scan_rsp,
+                      std::move(cb));
+
       if (restart) {
+        GetHciInterface()->Enable(false, inst_id, p_inst->duration,
+                                  p_inst->maxExtAdvEvents, base::DoNothing());
         DivideAndSendData( p_inst->inst_id, data, false, Bind(
           [](AdvertisingInstance *p_inst, BleAdvertisingManagerImpl *ptr,
             MultiAdvCb cb, uint8_t status) {
@@ -1476,6 +1682,8 @@ class BleAdvertisingManagerImpl
       p_big_inst->big_handle = i;
       p_big_inst->adv_inst_id = inst_id;
       p_big_inst->create_big_cb = cb;
+      p_big_inst->sdu_int = params->sdu_int;
+      p_big_inst->max_sdu = params->max_sdu;
       VLOG(1) << __func__ << "BIG handle allocated:" << +i;
       break;
     }
@@ -1544,10 +1752,15 @@ class BleAdvertisingManagerImpl
   }
 
   void Unregister(uint8_t inst_id) override {
-    AdvertisingInstance* p_inst = &adv_inst[inst_id];
-
     VLOG(1) << __func__ << " inst_id: " << +inst_id;
 
+    if (IsLogicalSet(inst_id)) {
+      RemoveLogicalSet(inst_id);
+      return;
+    }
+
+    AdvertisingInstance* p_inst = &adv_inst[inst_id];
+
     std::lock_guard<std::mutex> lock(lock_);
     if (!BleAdvertisingManager::IsInitialized()) {
       LOG(ERROR) << "Stack already shutdown";
@@ -1565,6 +1778,7 @@ class BleAdvertisingManagerImpl
         IsoBIGInstance* p_big_inst = &iso_big_inst[p_inst->big_handle];
         GetHciInterface()->TerminateBIG(p_inst->big_handle,
                                         HCI_ERR_CONN_CAUSE_LOCAL_HOST);
+        btm_iso_tx_big_terminated(p_inst->big_handle);
 
         p_big_inst->in_use = false;
         p_big_inst->bis_handles.clear();
@@ -1599,6 +1813,9 @@ class BleAdvertisingManagerImpl
     }
 
     alarm_cancel(p_inst->adv_raddr_timer);
+    CancelPendingData(p_inst, BTM_BLE_MULTI_ADV_FAILURE);
+    p_inst->sent_data_valid[0] = false;
+    p_inst->sent_data_valid[1] = false;
     p_inst->in_use = false;
     p_inst->skip_rpa_count = 0;
     p_inst->skip_rpa = false;
@@ -1636,6 +1853,9 @@ class BleAdvertisingManagerImpl
   void Suspend() {
     std::vector<SetEnableData> sets;
 
+    mux_suspended = true;
+    if (mux_timer) alarm_cancel(mux_timer);
+
     for (AdvertisingInstance& inst : adv_inst) {
       if (!inst.in_use || !inst.enable_status) continue;
 
@@ -1662,6 +1882,361 @@ class BleAdvertisingManagerImpl
     }
 
     if (!sets.empty()) GetHciInterface()->Enable(true, sets, base::DoNothing());
+
+    mux_suspended = false;
+    RotateLogicalSets();
+  }
+
+  bool IsLogicalSet(uint8_t inst_id) {
+    return inst_id >= kLogicalSetIdBase && inst_id <= kLogicalSetIdMax;
+  }
+
+  LogicalAdvertisingSet* FindLogicalSet(uint8_t inst_id) {
+    auto it = logical_sets.find(inst_id);
+    return it == logical_sets.end() ? nullptr : &it->second;
+  }
+
+  /* first of the instances reserved for logical sets */
+  uint8_t FirstMuxSlot() { return inst_count - mux_slot_count; }
+
+  /* Only sets whose whole state can be rewritten on every slice are
+   * multiplexed: connectable, periodic, encrypted and timed advertising need
+   * an instance of their own. */
+  bool CanMultiplex(const CreatorParams* c) {
+    if (mux_slot_count <= 0) return false;
+    if (c->params.advertising_event_properties & 0x01) return false;
+    if (c->periodic_params.enable) return false;
+    if (!c->advertise_data_enc.empty() || !c->scan_response_data_enc.empty())
+      return false;
+    if (c->duration || c->maxExtAdvEvents) return false;
+    return logical_sets.size() <= kLogicalSetIdMax - kLogicalSetIdBase;
+  }
+
+  static uint32_t LogicalSetWeight(const tBTM_BLE_ADV_PARAMS& params) {
+    uint32_t interval = std::max<uint32_t>(params.adv_int_min, 1);
+    uint32_t weight = kLogicalSetWeightInterval / interval;
+    return std::min(std::max<uint32_t>(weight, 1), kLogicalSetMaxWeight);
+  }
+
+  void StartLogicalSet(c_type c) {
+    uint8_t id = kLogicalSetIdBase;
+    while (logical_sets.count(id)) id++;
+
+    LogicalAdvertisingSet& set = logical_sets[id];
+    set.id = id;
+    set.enabled = true;
+    set.params = c->params;
+    set.advertise_data = std::move(c->advertise_data);
+    set.scan_response_data = std::move(c->scan_response_data);
+    set.weight = LogicalSetWeight(set.params);
+    set.credit = 0;
+    set.slot = -1;
+    set.slices = 0;
+
+    LOG(INFO) << __func__ << " advertising set " << +id << " shares "
+              << mux_slot_count << " instances, weight " << set.weight;
+
+    RegisterMuxSlots();
+    c->cb.Run(id, c->params.tx_power, BTM_BLE_MULTI_ADV_SUCCESS);
+    RotateLogicalSets();
+  }
+
+  void RegisterMuxSlots() {
+    if (mux_timer) return;
+
+    mux_timer = alarm_new("btm_ble.adv_mux");
+    int own_address_type =
+        BTM_BleLocalPrivacyEnabled() ? BLE_ADDR_RANDOM : BLE_ADDR_PUBLIC;
+    for (uint8_t i = FirstMuxSlot(); i < inst_count; i++) {
+      RegisterAdvertiserInRange(
+          own_address_type, i, i + 1,
+          Bind(&BleAdvertisingManagerImpl::OnMuxSlotRegistered,
+               weak_factory_.GetWeakPtr()));
+    }
+  }
+
+  void OnMuxSlotRegistered(uint8_t inst_id, uint8_t status) {
+    if (status != BTM_BLE_MULTI_ADV_SUCCESS) {
+      LOG(ERROR) << __func__ << " failed to reserve instance " << +inst_id;
+      return;
+    }
+
+    mux_slots.push_back(inst_id);
+    RotateLogicalSets();
+  }
+
+  void EnableLogicalSet(uint8_t inst_id, bool enable, uint16_t duration,
+                        uint8_t maxExtAdvEvents, MultiAdvCb cb) {
+    LogicalAdvertisingSet* p_set = FindLogicalSet(inst_id);
+    if (!p_set) {
+      LOG(ERROR) << "bad instance id " << +inst_id;
+      cb.Run(BTM_BLE_MULTI_ADV_FAILURE);
+      return;
+    }
+
+    if (enable && (duration || maxExtAdvEvents)) {
+      LOG(ERROR) << __func__ << " timed advertising needs its own instance";
+      cb.Run(ADVERTISE_FAILED_FEATURE_UNSUPPORTED);
+      return;
+    }
+
+    p_set->enabled = enable;
+    if (!enable) TakeLogicalSetOffAir(p_set);
+    cb.Run(BTM_BLE_MULTI_ADV_SUCCESS);
+    RotateLogicalSets();
+  }
+
+  void SetLogicalSetParameters(uint8_t inst_id, tBTM_BLE_ADV_PARAMS* p_params,
+                               ParametersCb cb) {
+    LogicalAdvertisingSet* p_set = FindLogicalSet(inst_id);
+    if (!p_set) {
+      LOG(ERROR) << "bad instance id " << +inst_id;
+      cb.Run(BTM_BLE_MULTI_ADV_FAILURE, 0);
+      return;
+    }
+
+    if (p_params->advertising_event_properties & 0x01) {
+      LOG(ERROR) << __func__ << " connectable set needs its own instance";
+      cb.Run(ADVERTISE_FAILED_FEATURE_UNSUPPORTED, 0);
+      return;
+    }
+
+    p_set->params = *p_params;
+    p_set->weight = LogicalSetWeight(p_set->params);
+    /* the new parameters are written when the set is next put on air */
+    TakeLogicalSetOffAir(p_set);
+    cb.Run(BTM_BLE_MULTI_ADV_SUCCESS, p_params->tx_power);
+    RotateLogicalSets();
+  }
+
+  void SetLogicalSetData(uint8_t inst_id, bool is_scan_rsp,
+                         std::vector<uint8_t> data,
+                         std::vector<uint8_t> encr_data, MultiAdvCb cb) {
+    LogicalAdvertisingSet* p_set = FindLogicalSet(inst_id);
+    if (!p_set) {
+      LOG(ERROR) << "bad instance id " << +inst_id;
+      cb.Run(BTM_BLE_MULTI_ADV_FAILURE);
+      return;
+    }
+
+    if (!encr_data.empty()) {
+      LOG(ERROR) << __func__ << " encrypted data needs its own instance";
+      cb.Run(ADVERTISE_FAILED_FEATURE_UNSUPPORTED);
+      return;
+    }
+
+    if (is_scan_rsp)
+      p_set->scan_response_data = data;
+    else
+      p_set->advertise_data = data;
+
+    if (p_set->slot < 0) {
+      cb.Run(BTM_BLE_MULTI_ADV_SUCCESS);
+      return;
+    }
+
+    SetDataImpl(p_set->slot, is_scan_rsp, std::move(data), {}, std::move(cb));
+  }
+
+  void RemoveLogicalSet(uint8_t inst_id) {
+    LogicalAdvertisingSet* p_set = FindLogicalSet(inst_id);
+    if (!p_set) {
+      LOG(ERROR) << "bad instance id " << +inst_id;
+      return;
+    }
+
+    TakeLogicalSetOffAir(p_set);
+    logical_sets.erase(inst_id);
+    RotateLogicalSets();
+  }
+
+  /* Frees the instance |p_set| is on, disabling it right away. */
+  void TakeLogicalSetOffAir(LogicalAdvertisingSet* p_set) {
+    std::vector<SetEnableData> sets;
+    ReleaseMuxSlot(p_set, TimeTicks::Now(), &sets);
+    if (!sets.empty()) EnableMuxSlots(false, std::move(sets));
+  }
+
+  void ReleaseMuxSlot(LogicalAdvertisingSet* p_set, TimeTicks now,
+                      std::vector<SetEnableData>* sets) {
+    if (p_set->slot < 0) return;
+
+    AdvertisingInstance* p_inst = &adv_inst[p_set->slot];
+    if (p_inst->enable_status) {
+      p_set->on_air += now - p_set->on_air_since;
+      p_inst->enable_status = false;
+      sets->emplace_back(SetEnableData{.handle = p_inst->inst_id});
+    }
+    p_set->slot = -1;
+  }
+
+  /* One HCI command for all instances changing state in a slice. */
+  void EnableMuxSlots(bool enable, std::vector<SetEnableData> sets) {
+    mux_hci_enables++;
+    if (mux_suspended) return;
+    GetHciInterface()->Enable(enable, std::move(sets), base::DoNothing());
+  }
+
+  /* Puts the logical sets with the most credit on the reserved instances.
+   * Every slice each enabled set earns credit in proportion to its weight,
+   * and pays for the slices it is on air, so over time each set advertises
+   * for a share of the slices proportional to its weight. */
+  void RotateLogicalSets() {
+    if (!mux_timer) return;
+    alarm_cancel(mux_timer);
+    if (mux_suspended || mux_slots.empty()) return;
+
+    /* fragments of the previous slice are still being written */
+    if (mux_pending_writes) {
+      mux_rotate_again = true;
+      return;
+    }
+
+    std::vector<LogicalAdvertisingSet*> picked;
+    int64_t total_weight = 0;
+    for (auto& it : logical_sets) {
+      if (!it.second.enabled) continue;
+      picked.push_back(&it.second);
+      total_weight += it.second.weight;
+    }
+
+    size_t slot_count = mux_slots.size();
+    bool contended = picked.size() > slot_count;
+    if (contended) {
+      for (LogicalAdvertisingSet* p_set : picked) {
+        p_set->credit += p_set->weight * slot_count;
+        /* a set can't be on air more than once per slice */
+        p_set->credit =
+            std::min(p_set->credit, total_weight * (int64_t)slot_count);
+      }
+
+      std::stable_sort(picked.begin(), picked.end(),
+                       [](const LogicalAdvertisingSet* a,
+                          const LogicalAdvertisingSet* b) {
+                         return a->credit > b->credit;
+                       });
+      picked.resize(slot_count);
+      for (LogicalAdvertisingSet* p_set : picked) p_set->credit -= total_weight;
+    }
+
+    TimeTicks now = TimeTicks::Now();
+    std::vector<SetEnableData> disable;
+    std::vector<uint8_t> free_slots = mux_slots;
+    for (auto& it : logical_sets) {
+      LogicalAdvertisingSet* p_set = &it.second;
+      if (p_set->slot < 0) continue;
+
+      if (std::find(picked.begin(), picked.end(), p_set) == picked.end()) {
+        ReleaseMuxSlot(p_set, now, &disable);
+      } else {
+        free_slots.erase(
+            std::find(free_slots.begin(), free_slots.end(), p_set->slot));
+      }
+    }
+    if (!disable.empty()) EnableMuxSlots(false, std::move(disable));
+
+    mux_rotations++;
+    /* held until all the writes below have been issued */
+    mux_pending_writes = 1;
+    for (LogicalAdvertisingSet* p_set : picked) {
+      p_set->slices++;
+      if (p_set->slot >= 0) continue;
+
+      p_set->slot = free_slots.back();
+      free_slots.pop_back();
+      ConfigureMuxSlot(p_set);
+      mux_enable_pending.emplace_back(
+          SetEnableData{.handle = (uint8_t)p_set->slot});
+    }
+    mux_contended = contended;
+    OnMuxSlotWritten(BTM_BLE_MULTI_ADV_SUCCESS);
+  }
+
+  void ConfigureMuxSlot(LogicalAdvertisingSet* p_set) {
+    uint8_t slot = p_set->slot;
+    AdvertisingInstance* p_inst = &adv_inst[slot];
+    MultiAdvCb done = Bind(&BleAdvertisingManagerImpl::OnMuxSlotWritten,
+                           weak_factory_.GetWeakPtr());
+
+    /* the properties may differ from the previous set, don't trust the
+     * payload the controller holds */
+    p_inst->sent_data_valid[0] = false;
+    p_inst->sent_data_valid[1] = false;
+
+    mux_pending_writes += 3;
+    SetParameters(slot, &p_set->params,
+                  Bind([](MultiAdvCb done, uint8_t status,
+                          int8_t tx_power) { done.Run(status); },
+                       done));
+    if (p_inst->own_address_type == BLE_ADDR_RANDOM) {
+      mux_pending_writes++;
+      GetHciInterface()->SetRandomAddress(slot, p_inst->own_address, done);
+    }
+    SetDataImpl(slot, false, p_set->advertise_data, {}, done);
+    SetDataImpl(slot, true, p_set->scan_response_data, {}, done);
+  }
+
+  void OnMuxSlotWritten(uint8_t status) {
+    if (status != BTM_BLE_MULTI_ADV_SUCCESS)
+      LOG(WARNING) << __func__ << " configuring instance failed: " << +status;
+
+    if (--mux_pending_writes) return;
+
+    TimeTicks now = TimeTicks::Now();
+    std::vector<SetEnableData> sets;
+    for (auto& it : logical_sets) {
+      LogicalAdvertisingSet* p_set = &it.second;
+      if (p_set->slot < 0) continue;
+
+      /* skip instances released while they were being written */
+      for (const SetEnableData& set : mux_enable_pending) {
+        if (set.handle != p_set->slot) continue;
+        adv_inst[set.handle].enable_status = true;
+        adv_inst[set.handle].enable_time = now;
+        p_set->on_air_since = now;
+        sets.push_back(set);
+      }
+    }
+    mux_enable_pending.clear();
+    if (!sets.empty()) EnableMuxSlots(true, std::move(sets));
+
+    if (mux_rotate_again) {
+      mux_rotate_again = false;
+      RotateLogicalSets();
+      return;
+    }
+
+    /* nothing changes until a set is added, removed or updated otherwise */
+    if (mux_contended && !mux_suspended) {
+      alarm_set_closure(FROM_HERE, mux_timer, mux_slice_ms,
+                        Bind(&BleAdvertisingManagerImpl::RotateLogicalSets,
+                             weak_factory_.GetWeakPtr()));
+    }
+  }
+
+  void Dump(int fd) {
+    dprintf(fd, "\nLE advertising multiplexer:\n");
+    if (mux_slot_count <= 0) {
+      dprintf(fd, "  disabled\n");
+      return;
+    }
+
+    TimeTicks now = TimeTicks::Now();
+    dprintf(fd, "  reserved instances: %zu/%d, slice: %d ms\n",
+            mux_slots.size(), mux_slot_count, mux_slice_ms);
+    dprintf(fd, "  rotations: %u, enable commands: %u\n", mux_rotations,
+            mux_hci_enables);
+    for (const auto& it : logical_sets) {
+      const LogicalAdvertisingSet& set = it.second;
+      TimeDelta on_air = set.on_air;
+      if (set.slot >= 0 && adv_inst[set.slot].enable_status)
+        on_air += now - set.on_air_since;
+      dprintf(fd,
+              "  set %d: %s, weight %u, slices %u, on air %" PRId64
+              " ms, instance %d\n",
+              set.id, set.enabled ? "enabled" : "disabled", set.weight,
+              set.slices, on_air.InMilliseconds(), set.slot);
+    }
   }
 
   void OnAdvertisingSetTerminated(
@@ -1730,6 +2305,8 @@ class BleAdvertisingManagerImpl
     if (status == HCI_SUCCESS) {
       p_big_inst->bis_handles = conn_handle_list;
       p_big_inst->created_status = true;
+      btm_iso_tx_big_created(big_handle, p_big_inst->sdu_int,
+                             p_big_inst->max_sdu, conn_handle_list);
     }
     else {
       p_big_inst->in_use = false;
@@ -1758,6 +2335,7 @@ class BleAdvertisingManagerImpl
     IsoBIGInstance* p_big_inst = &iso_big_inst[big_handle];
 
     if (!cmd_status) {
+      btm_iso_tx_big_terminated(big_handle);
       p_big_inst->in_use = false;
       p_big_inst->bis_handles.clear();
       p_big_inst->created_status = false;
@@ -1785,7 +2363,12 @@ class BleAdvertisingManagerImpl
       if (p_inst->adv_raddr_timer) {
         alarm_cancel(p_inst->adv_raddr_timer);
       }
+      for (alarm_t* timer : p_inst->data_timer) {
+        if (timer) alarm_cancel(timer);
+      }
     }
+
+    if (mux_timer) alarm_cancel(mux_timer);
   }
 
  private:
@@ -1796,6 +2379,22 @@ class BleAdvertisingManagerImpl
   uint8_t inst_count;
   bool rpa_gen_offload_enabled;
   std::vector<IsoBIGInstance> iso_big_inst;
+  /* minimum time between two writes of the same payload, 0 means no limit */
+  int32_t data_update_window_ms;
+
+  /* instances reserved for logical sets, and the length of a time slice */
+  int32_t mux_slot_count;
+  int32_t mux_slice_ms;
+  std::vector<uint8_t> mux_slots;
+  std::map<uint8_t, LogicalAdvertisingSet> logical_sets;
+  alarm_t* mux_timer = nullptr;
+  bool mux_suspended = false;
+  bool mux_contended = false;
+  bool mux_rotate_again = false;
+  int mux_pending_writes = 0;
+  std::vector<SetEnableData> mux_enable_pending;
+  uint32_t mux_rotations = 0;
+  uint32_t mux_hci_enables = 0;
 
   // Member variables should appear before the WeakPtrFactory, to ensure
   // that any WeakPtrs are invalidated before its members
@@ -1820,6 +2419,11 @@ base::WeakPtr<BleAdvertisingManager> BleAdvertisingManager::Get() {
   return instance_weakptr;
 };
 
+void BleAdvertisingManager::DebugDump(int fd) {
+  BleAdvertisingManagerImpl* ptr = instance_weakptr.get();
+  if (ptr) ptr->Dump(fd);
+}
+
 void BleAdvertisingManager::CleanUp() {
   if (instance_weakptr.get()) instance_weakptr.get()->CancelAdvAlarms();
 
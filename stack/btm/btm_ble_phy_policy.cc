@@ -0,0 +1,216 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This module picks the LE PHY of a connection no app has chosen one for:
+ *  2M once both sides are known to support it, then 1M or Coded while the
+ *  link quality reports show the peer getting out of range, and back again
+ *  once it comes closer.
+ *
+ ******************************************************************************/
+
+#include <base/bind.h>
+#include <stdlib.h>
+
+#include "bt_target.h"
+#include "btm_ble_int.h"
+#include "btm_int.h"
+#include "btu.h"
+#include "device/include/controller.h"
+#include "hcidefs.h"
+#include "hcimsgs.h"
+#include "osi/include/properties.h"
+
+/* Below this RSSI (dBm) the link steps down from 2M to 1M */
+#ifndef BTM_BLE_PHY_POLICY_LOW_RSSI
+#define BTM_BLE_PHY_POLICY_LOW_RSSI (-80)
+#endif
+
+/* Below this RSSI (dBm) the link steps down from 1M to Coded */
+#ifndef BTM_BLE_PHY_POLICY_CODED_RSSI
+#define BTM_BLE_PHY_POLICY_CODED_RSSI (-90)
+#endif
+
+/* Above this RSSI (dBm) the link steps up again */
+#ifndef BTM_BLE_PHY_POLICY_HIGH_RSSI
+#define BTM_BLE_PHY_POLICY_HIGH_RSSI (-68)
+#endif
+
+/* Consecutive reports needed before switching */
+#ifndef BTM_BLE_PHY_POLICY_VOTES
+#define BTM_BLE_PHY_POLICY_VOTES 3
+#endif
+
+static bool btm_ble_phy_policy_enabled(void) {
+  static bool enabled =
+      osi_property_get_bool("persist.vendor.btstack.ble_phy_policy", false);
+  return enabled;
+}
+
+static bool btm_ble_phy_supported(const tACL_CONN* p_acl, uint8_t phy) {
+  const controller_t* controller = controller_get_interface();
+  switch (phy) {
+    case PHY_LE_1M:
+      return true;
+    case PHY_LE_2M:
+      return controller->supports_ble_2m_phy() &&
+             HCI_LE_2M_PHY_SUPPORTED(p_acl->peer_le_features);
+    case PHY_LE_CODED:
+      return controller->supports_ble_coded_phy() &&
+             HCI_LE_CODED_PHY_SUPPORTED(p_acl->peer_le_features);
+  }
+  return false;
+}
+
+static uint8_t btm_ble_phy_current(const tACL_CONN* p_acl) {
+  if (p_acl->ble_phy_target) return p_acl->ble_phy_target;
+  return p_acl->ble_tx_phy ? p_acl->ble_tx_phy : PHY_LE_1M;
+}
+
+/* LE PHY Update Complete reports the PHY as 1, 2 or 3 for Coded; the policy
+ * keeps the PHY_LE_* mask values of LE Set PHY */
+static uint8_t btm_ble_phy_from_event(uint8_t phy) {
+  switch (phy) {
+    case 1:
+      return PHY_LE_1M;
+    case 2:
+      return PHY_LE_2M;
+    case 3:
+      return PHY_LE_CODED;
+  }
+  return 0;
+}
+
+/* the outcome comes with the LE PHY Update Complete event */
+static void btm_ble_phy_policy_cmd_cmpl(uint8_t* p, uint16_t len) {}
+
+static void btm_ble_phy_policy_set(tACL_CONN* p_acl, uint8_t phy) {
+  BTM_TRACE_DEBUG("%s: handle 0x%04x PHY 0x%02x -> 0x%02x", __func__,
+                  p_acl->hci_handle, btm_ble_phy_current(p_acl), phy);
+  p_acl->ble_phy_target = phy;
+  p_acl->ble_phy_votes = 0;
+
+  uint8_t data[HCIC_PARAM_SIZE_BLE_SET_PHY];
+  uint8_t* pp = data;
+  UINT16_TO_STREAM(pp, p_acl->hci_handle);
+  UINT8_TO_STREAM(pp, 0); /* all_phys: both directions given */
+  UINT8_TO_STREAM(pp, phy);
+  UINT8_TO_STREAM(pp, phy);
+  UINT16_TO_STREAM(pp, 0); /* no preferred Coded PHY coding */
+  btu_hcif_send_cmd_with_cb(FROM_HERE, HCI_BLE_SET_PHY, data, sizeof(data),
+                            base::Bind(btm_ble_phy_policy_cmd_cmpl));
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_phy_policy_link_up
+ *
+ * Description      Called once the LE features of the peer are known. Moves
+ *                  the link to 2M if both sides support it.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_ble_phy_policy_link_up(tACL_CONN* p_acl) {
+  if (!btm_ble_phy_policy_enabled() || p_acl->ble_phy_app_set) return;
+
+  if (btm_ble_phy_current(p_acl) != PHY_LE_2M &&
+      btm_ble_phy_supported(p_acl, PHY_LE_2M)) {
+    btm_ble_phy_policy_set(p_acl, PHY_LE_2M);
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_phy_policy_phy_updated
+ *
+ * Description      Track the PHY of the link from the LE PHY Update Complete
+ *                  event.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_ble_phy_policy_phy_updated(uint8_t status, uint16_t handle,
+                                    uint8_t tx_phy, uint8_t rx_phy) {
+  uint8_t idx = btm_handle_to_acl_index(handle);
+  if (idx == MAX_L2CAP_LINKS) return;
+  tACL_CONN* p_acl = &btm_cb.acl_db[idx];
+
+  if (status != HCI_SUCCESS) {
+    /* stay where the link is, rather than asking again on every report */
+    BTM_TRACE_WARNING("%s: handle 0x%04x status 0x%02x", __func__, handle,
+                      status);
+    p_acl->ble_phy_target = p_acl->ble_tx_phy;
+    return;
+  }
+  p_acl->ble_tx_phy = btm_ble_phy_from_event(tx_phy);
+  p_acl->ble_rx_phy = btm_ble_phy_from_event(rx_phy);
+  p_acl->ble_phy_target = p_acl->ble_tx_phy;
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_phy_policy_link_quality
+ *
+ * Description      Called with the RSSI of a link quality report. Steps the
+ *                  PHY of an LE link down or up once enough reports in a row
+ *                  are past the thresholds, which are apart far enough not
+ *                  to switch back and forth.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_ble_phy_policy_link_quality(uint16_t hci_handle, int8_t rssi) {
+  if (!btm_ble_phy_policy_enabled()) return;
+
+  uint8_t idx = btm_handle_to_acl_index(hci_handle & 0x0FFF);
+  if (idx == MAX_L2CAP_LINKS) return;
+  tACL_CONN* p_acl = &btm_cb.acl_db[idx];
+  if (p_acl->transport != BT_TRANSPORT_LE || p_acl->ble_phy_app_set) return;
+
+  uint8_t phy = btm_ble_phy_current(p_acl);
+  uint8_t next = phy;
+  int8_t vote = 0;
+  if (rssi < BTM_BLE_PHY_POLICY_LOW_RSSI) {
+    vote = -1;
+    if (phy == PHY_LE_2M) {
+      next = PHY_LE_1M;
+    } else if (phy == PHY_LE_1M && rssi < BTM_BLE_PHY_POLICY_CODED_RSSI &&
+               btm_ble_phy_supported(p_acl, PHY_LE_CODED)) {
+      next = PHY_LE_CODED;
+    }
+  } else if (rssi > BTM_BLE_PHY_POLICY_HIGH_RSSI) {
+    vote = 1;
+    if (phy == PHY_LE_CODED) {
+      next = PHY_LE_1M;
+    } else if (phy == PHY_LE_1M && btm_ble_phy_supported(p_acl, PHY_LE_2M)) {
+      next = PHY_LE_2M;
+    }
+  }
+
+  if (next == phy) {
+    p_acl->ble_phy_votes = 0;
+    return;
+  }
+  if ((vote > 0) != (p_acl->ble_phy_votes > 0)) p_acl->ble_phy_votes = 0;
+  p_acl->ble_phy_votes += vote;
+  if (abs(p_acl->ble_phy_votes) >= BTM_BLE_PHY_POLICY_VOTES) {
+    btm_ble_phy_policy_set(p_acl, next);
+  }
+}
@@ -22,6 +22,7 @@
  *
  ******************************************************************************/
 #include <string.h>
+#include <deque>
 #include "bt_target.h"
 
 #if (BLE_PRIVACY_SPT == TRUE)
@@ -48,6 +49,30 @@
 #define BTM_BLE_META_READ_IRK_LEN 2
 #define BTM_BLE_META_ADD_WL_ATTR_LEN 9
 
+/* Resolving list loads inside a batch are deferred to a single
+ * btm_ble_resolving_list_sync at the end of the batch. */
+static bool rl_batch_active = false;
+
+/* State of the bulk resolving list synchronization. While it runs, address
+ * resolution stays disabled and the enable/disable requests of other modules
+ * are accumulated in rl_sync_state, to be applied once at the end. */
+typedef struct {
+  RawAddress pseudo_addr;
+  bool add;
+} tBTM_BLE_RL_SYNC_OP;
+
+static bool rl_sync_active = false;
+static bool rl_sync_rerun = false;
+static bool rl_sync_suspended = false;
+static uint8_t rl_sync_state = BTM_BLE_RL_IDLE;
+static uint8_t rl_sync_added = 0;
+static uint8_t rl_sync_removed = 0;
+static tBTM_STATUS rl_sync_status = BTM_SUCCESS;
+static tBTM_BLE_RL_SYNC_CBACK* rl_sync_cback = NULL;
+static std::deque<tBTM_BLE_RL_SYNC_OP> rl_sync_ops;
+
+static void btm_ble_resolving_list_sync_continue(uint8_t status);
+
 /*******************************************************************************
  *         Functions implemented controller based privacy using Resolving List
  ******************************************************************************/
@@ -127,6 +152,28 @@ bool btm_ble_deq_resolving_pending(RawAddress& pseudo_addr) {
   return false;
 }
 
+/*******************************************************************************
+ *
+ * Function         btm_ble_resolving_pending_room
+ *
+ * Description      number of operations that can still be added to the
+ *                  resolving pending operation queue
+ *
+ * Returns          free entries in the queue
+ *
+ ******************************************************************************/
+static uint8_t btm_ble_resolving_pending_room(void) {
+  const tBTM_BLE_RESOLVE_Q* p_q = &btm_cb.ble_ctr_cb.resolving_list_pend_q;
+  const int max_size =
+      controller_get_interface()->get_ble_resolving_list_max_size();
+
+  if (max_size == 0) return 0;
+
+  /* q_next == q_pending means empty, so one slot always stays unused */
+  const int used = (p_q->q_next + max_size - p_q->q_pending) % max_size;
+  return (uint8_t)(max_size - 1 - used);
+}
+
 /*******************************************************************************
  *
  * Function         btm_ble_clear_irk_index
@@ -206,12 +253,6 @@ void btm_ble_update_resolving_list(const RawAddress& pseudo_bda, bool add) {
   }
 }
 
-bool clear_resolving_list_bit(void* data, void* context) {
-  tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(data);
-  p_dev_rec->ble.in_controller_list &= ~BTM_RESOLVING_LIST_BIT;
-  return true;
-}
-
 /*******************************************************************************
  *
  * Function         btm_ble_clear_resolving_list_complete
@@ -258,7 +299,8 @@ void btm_ble_clear_resolving_list_complete(uint8_t* p, uint16_t evt_len) {
     BTM_TRACE_DEBUG("%s resolving_list_avail_size=%d", __func__,
                     btm_cb.ble_ctr_cb.resolving_list_avail_size);
 
-    list_foreach(btm_cb.sec_dev_rec, clear_resolving_list_bit, NULL);
+    for (tBTM_SEC_DEV_REC& dev_rec : btm_cb.sec_dev_rec)
+      dev_rec.ble.in_controller_list &= ~BTM_RESOLVING_LIST_BIT;
   }
 }
 
@@ -304,6 +346,8 @@ void btm_ble_add_resolving_list_entry_complete(uint8_t* p, uint16_t evt_len) {
     btm_cb.ble_ctr_cb.resolving_list_avail_size = 0;
     BTM_TRACE_DEBUG("%s Resolving list Full ", __func__);
   }
+
+  btm_ble_resolving_list_sync_continue(status);
 }
 
 /*******************************************************************************
@@ -338,6 +382,8 @@ void btm_ble_remove_resolving_list_entry_complete(uint8_t* p,
     } else
       btm_cb.ble_ctr_cb.resolving_list_avail_size++;
   }
+
+  btm_ble_resolving_list_sync_continue(status);
 }
 
 /*******************************************************************************
@@ -663,6 +709,12 @@ bool btm_ble_disable_resolving_list(uint8_t rl_mask, bool to_resume) {
   if (controller_get_interface()->get_ble_resolving_list_max_size() == 0)
     return false;
 
+  /* resolution is already off, only the state to restore changes */
+  if (rl_sync_active) {
+    rl_sync_state &= ~rl_mask;
+    return true;
+  }
+
   btm_cb.ble_ctr_cb.rl_state &= ~rl_mask;
   BTM_TRACE_DEBUG("%s rl_state %d :: btm_cb.ble_ctr_cb.rl_state %d", __func__,
                    rl_state, btm_cb.ble_ctr_cb.rl_state);
@@ -680,6 +732,61 @@ bool btm_ble_disable_resolving_list(uint8_t rl_mask, bool to_resume) {
   return true;
 }
 
+/*******************************************************************************
+ *
+ * Function         btm_ble_add_resolving_list_entry
+ *
+ * Description      This function sends the command adding a device to the
+ *                  controller resolving list. Address resolution must be
+ *                  disabled.
+ *
+ * Parameters       pointer to device security record
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void btm_ble_add_resolving_list_entry(tBTM_SEC_DEV_REC* p_dev_rec) {
+  btm_ble_update_resolving_list(p_dev_rec->bd_addr, true);
+  if (controller_get_interface()->supports_ble_privacy()) {
+    const Octet16& peer_irk = p_dev_rec->ble.keys.irk;
+    const Octet16& local_irk = btm_cb.devcb.id_keys.irk;
+
+    if (p_dev_rec->ble.identity_addr.IsEmpty()) {
+      p_dev_rec->ble.identity_addr = p_dev_rec->bd_addr;
+      p_dev_rec->ble.identity_addr_type = p_dev_rec->ble.ble_addr_type;
+      btm_sec_dev_rec_reindex(p_dev_rec);
+    }
+
+    BTM_TRACE_DEBUG("%s: adding device %s to controller resolving list",
+                    __func__, p_dev_rec->ble.identity_addr.ToString().c_str());
+
+    // use identical IRK for now
+    btsnd_hcic_ble_add_device_resolving_list(p_dev_rec->ble.identity_addr_type,
+                                             p_dev_rec->ble.identity_addr,
+                                             peer_irk, local_irk);
+
+    if (controller_get_interface()->supports_ble_set_privacy_mode()) {
+      BTM_TRACE_DEBUG("%s: adding device privacy mode", __func__);
+      btsnd_hcic_ble_set_privacy_mode(p_dev_rec->ble.identity_addr_type,
+                                      p_dev_rec->ble.identity_addr, 0x01);
+    }
+  } else {
+    uint8_t param[40] = {0};
+    uint8_t* p = param;
+
+    UINT8_TO_STREAM(p, BTM_BLE_META_ADD_IRK_ENTRY);
+    ARRAY_TO_STREAM(p, p_dev_rec->ble.keys.irk, OCTET16_LEN);
+    UINT8_TO_STREAM(p, p_dev_rec->ble.identity_addr_type);
+    BDADDR_TO_STREAM(p, p_dev_rec->ble.identity_addr);
+
+    BTM_VendorSpecificCommand(HCI_VENDOR_BLE_RPA_VSC, BTM_BLE_META_ADD_IRK_LEN,
+                              param, btm_ble_resolving_list_vsc_op_cmpl);
+  }
+
+  btm_ble_enq_resolving_list_pending(p_dev_rec->bd_addr,
+                                     BTM_BLE_META_ADD_IRK_ENTRY);
+}
+
 /*******************************************************************************
  *
  * Function         btm_ble_resolving_list_load_dev
@@ -728,57 +835,272 @@ bool btm_ble_resolving_list_load_dev(tBTM_SEC_DEV_REC* p_dev_rec) {
     return false;
   }
 
+  if (rl_batch_active) {
+    /* loaded by btm_ble_resolving_list_batch_end */
+    return true;
+  }
+
+  if (rl_sync_active) {
+    /* picked up by the next diff of the running synchronization */
+    rl_sync_rerun = true;
+    return true;
+  }
+
   if (rl_state && !btm_ble_disable_resolving_list(rl_state, false)) {
     BTM_TRACE_DEBUG("%s: btm_ble_disable_resolving_list ", __func__);
     return false;
   }
 
-  btm_ble_update_resolving_list(p_dev_rec->bd_addr, true);
-  if (controller_get_interface()->supports_ble_privacy()) {
-    const Octet16& peer_irk = p_dev_rec->ble.keys.irk;
-    const Octet16& local_irk = btm_cb.devcb.id_keys.irk;
+  btm_ble_add_resolving_list_entry(p_dev_rec);
 
-    if (p_dev_rec->ble.identity_addr.IsEmpty()) {
-      p_dev_rec->ble.identity_addr = p_dev_rec->bd_addr;
-      p_dev_rec->ble.identity_addr_type = p_dev_rec->ble.ble_addr_type;
+  /* if resolving list has been turned on, re-enable it */
+  if (rl_state)
+    btm_ble_enable_resolving_list(rl_state);
+  else
+    btm_ble_enable_resolving_list(BTM_BLE_RL_INIT);
+
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_resolving_list_sync_wanted
+ *
+ * Description      check whether a device belongs in the controller resolving
+ *                  list
+ *
+ * Returns          true if the device has an identity key to resolve
+ *
+ ******************************************************************************/
+static bool btm_ble_resolving_list_sync_wanted(
+    const tBTM_SEC_DEV_REC* p_dev_rec) {
+  return (p_dev_rec->ble.key_type & (BTM_LE_KEY_PID | BTM_LE_KEY_LID)) != 0;
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_resolving_list_sync_collect
+ *
+ * Description      Diff the security records against the resolving list
+ *                  state and queue the operations bringing the controller in
+ *                  line. Removals go first so that they make room for the
+ *                  additions.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void btm_ble_resolving_list_sync_collect(void) {
+  std::deque<RawAddress> adds;
+  int room = btm_cb.ble_ctr_cb.resolving_list_avail_size;
+
+  for (tBTM_SEC_DEV_REC& dev_rec : btm_cb.sec_dev_rec) {
+    tBTM_SEC_DEV_REC* p_dev_rec = &dev_rec;
+    const bool in_list =
+        (p_dev_rec->ble.in_controller_list & BTM_RESOLVING_LIST_BIT) != 0;
+    const bool wanted = btm_ble_resolving_list_sync_wanted(p_dev_rec);
+
+    if (in_list && !wanted) {
+      rl_sync_ops.push_back({p_dev_rec->bd_addr, false});
+      room++;
+    } else if (!in_list && wanted) {
+      adds.push_back(p_dev_rec->bd_addr);
     }
+  }
 
-    BTM_TRACE_DEBUG("%s: adding device %s to controller resolving list",
-                    __func__, p_dev_rec->ble.identity_addr.ToString().c_str());
+  if ((int)adds.size() > room) {
+    BTM_TRACE_WARNING("%s: resolving list full, %d devices left out",
+                      __func__, (int)adds.size() - room);
+    rl_sync_status = BTM_NO_RESOURCES;
+  }
 
-    // use identical IRK for now
-    btsnd_hcic_ble_add_device_resolving_list(p_dev_rec->ble.identity_addr_type,
-                                             p_dev_rec->ble.identity_addr,
-                                             peer_irk, local_irk);
+  for (const RawAddress& bd_addr : adds) {
+    if (room-- <= 0) break;
+    rl_sync_ops.push_back({bd_addr, true});
+  }
+}
 
-    if (controller_get_interface()->supports_ble_set_privacy_mode()) {
-      BTM_TRACE_DEBUG("%s: adding device privacy mode", __func__);
-      btsnd_hcic_ble_set_privacy_mode(p_dev_rec->ble.identity_addr_type,
-                                      p_dev_rec->ble.identity_addr, 0x01);
+/*******************************************************************************
+ *
+ * Function         btm_ble_resolving_list_sync_pump
+ *
+ * Description      Send the queued operations back to back, as long as the
+ *                  pending operation queue has room for their completions.
+ *                  The HCI layer paces them with the controller command
+ *                  credits.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void btm_ble_resolving_list_sync_pump(void) {
+  while (!rl_sync_ops.empty() && btm_ble_resolving_pending_room() > 0) {
+    const tBTM_BLE_RL_SYNC_OP op = rl_sync_ops.front();
+    rl_sync_ops.pop_front();
+
+    /* the record may have changed or gone since the diff */
+    tBTM_SEC_DEV_REC* p_dev_rec = btm_find_dev(op.pseudo_addr);
+    if (p_dev_rec == NULL) continue;
+
+    const bool in_list =
+        (p_dev_rec->ble.in_controller_list & BTM_RESOLVING_LIST_BIT) != 0;
+    if (op.add) {
+      if (in_list || !btm_ble_resolving_list_sync_wanted(p_dev_rec)) continue;
+      btm_ble_add_resolving_list_entry(p_dev_rec);
+      rl_sync_added++;
+    } else {
+      if (!in_list || btm_ble_brcm_find_resolving_pending_entry(
+                          p_dev_rec->bd_addr, BTM_BLE_META_REMOVE_IRK_ENTRY))
+        continue;
+      btm_ble_update_resolving_list(p_dev_rec->bd_addr, false);
+      btm_ble_remove_resolving_list_entry(p_dev_rec);
+      rl_sync_removed++;
     }
-  } else {
-    uint8_t param[40] = {0};
-    uint8_t* p = param;
+  }
+}
 
-    UINT8_TO_STREAM(p, BTM_BLE_META_ADD_IRK_ENTRY);
-    ARRAY_TO_STREAM(p, p_dev_rec->ble.keys.irk, OCTET16_LEN);
-    UINT8_TO_STREAM(p, p_dev_rec->ble.identity_addr_type);
-    BDADDR_TO_STREAM(p, p_dev_rec->ble.identity_addr);
+/*******************************************************************************
+ *
+ * Function         btm_ble_resolving_list_sync_continue
+ *
+ * Description      Called when a resolving list operation completes. Keeps
+ *                  the running synchronization going and, once everything
+ *                  sent has completed, re-enables address resolution and
+ *                  reports the result.
+ *
+ * Parameters       status: HCI status of the completed operation
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void btm_ble_resolving_list_sync_continue(uint8_t status) {
+  if (!rl_sync_active) return;
+
+  if (status != HCI_SUCCESS && rl_sync_status == BTM_SUCCESS)
+    rl_sync_status =
+        (status == HCI_ERR_MEMORY_FULL) ? BTM_NO_RESOURCES : BTM_ERR_PROCESSING;
+
+  const tBTM_BLE_RESOLVE_Q* p_q = &btm_cb.ble_ctr_cb.resolving_list_pend_q;
+  for (;;) {
+    btm_ble_resolving_list_sync_pump();
+    if (!rl_sync_ops.empty() || p_q->q_next != p_q->q_pending) return;
+
+    /* devices loaded while running get a second diff */
+    if (!rl_sync_rerun) break;
+    rl_sync_rerun = false;
+    btm_ble_resolving_list_sync_collect();
+  }
 
-    BTM_VendorSpecificCommand(HCI_VENDOR_BLE_RPA_VSC, BTM_BLE_META_ADD_IRK_LEN,
-                              param, btm_ble_resolving_list_vsc_op_cmpl);
+  uint8_t rl_mask = rl_sync_state;
+  if (rl_sync_added) rl_mask |= BTM_BLE_RL_INIT;
+
+  tBTM_BLE_RL_SYNC_CBACK* p_cback = rl_sync_cback;
+  const tBTM_STATUS sync_status = rl_sync_status;
+  const uint8_t added = rl_sync_added;
+  const uint8_t removed = rl_sync_removed;
+  const bool suspended = rl_sync_suspended;
+
+  rl_sync_active = false;
+  rl_sync_suspended = false;
+  rl_sync_state = BTM_BLE_RL_IDLE;
+  rl_sync_cback = NULL;
+
+  BTM_TRACE_EVENT("%s: status %d, %d added, %d removed, avail %d", __func__,
+                  sync_status, added, removed,
+                  btm_cb.ble_ctr_cb.resolving_list_avail_size);
+
+  if (rl_mask)
+    btm_ble_enable_resolving_list(rl_mask);
+  else if (suspended)
+    btm_ble_resume_resolving_list_activity();
+
+  if (p_cback) (*p_cback)(sync_status, added, removed);
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_resolving_list_sync
+ *
+ * Description      Bring the controller resolving list in line with the
+ *                  security records: address resolution is disabled once,
+ *                  all additions and removals are sent back to back, and
+ *                  resolution is re-enabled when the last one completes.
+ *
+ * Parameters       rl_mask: resolution state to restore on top of the current
+ *                           one
+ *                  p_cback: called once with the result, possibly before this
+ *                           function returns
+ *
+ * Returns          BTM_CMD_STARTED, BTM_BUSY if a synchronization with a
+ *                  callback is running, BTM_WRONG_MODE if the controller has
+ *                  no resolving list
+ *
+ ******************************************************************************/
+tBTM_STATUS btm_ble_resolving_list_sync(uint8_t rl_mask,
+                                        tBTM_BLE_RL_SYNC_CBACK* p_cback) {
+  const uint8_t rl_state = btm_cb.ble_ctr_cb.rl_state;
+
+  if (controller_get_interface()->get_ble_resolving_list_max_size() == 0)
+    return BTM_WRONG_MODE;
+
+  if (rl_sync_active) {
+    if (p_cback) return BTM_BUSY;
+    /* fold into the running one */
+    rl_sync_state |= rl_mask;
+    rl_sync_rerun = true;
+    return BTM_CMD_STARTED;
   }
 
-  btm_ble_enq_resolving_list_pending(p_dev_rec->bd_addr,
-                                     BTM_BLE_META_ADD_IRK_ENTRY);
+  if (rl_state && !btm_ble_disable_resolving_list(rl_state, false)) {
+    BTM_TRACE_DEBUG("%s: btm_ble_disable_resolving_list failed", __func__);
+    return BTM_NO_RESOURCES;
+  }
 
-  /* if resolving list has been turned on, re-enable it */
-  if (rl_state)
-    btm_ble_enable_resolving_list(rl_state);
-  else
-    btm_ble_enable_resolving_list(BTM_BLE_RL_INIT);
+  rl_sync_active = true;
+  rl_sync_rerun = false;
+  rl_sync_suspended = (rl_state != BTM_BLE_RL_IDLE);
+  rl_sync_state = rl_state | rl_mask;
+  rl_sync_added = 0;
+  rl_sync_removed = 0;
+  rl_sync_status = BTM_SUCCESS;
+  rl_sync_cback = p_cback;
+
+  btm_ble_resolving_list_sync_collect();
+  btm_ble_resolving_list_sync_continue(HCI_SUCCESS);
+  return BTM_CMD_STARTED;
+}
 
-  return true;
+/*******************************************************************************
+ *
+ * Function         btm_ble_resolving_list_batch_start
+ *
+ * Description      Defer the resolving list loads until
+ *                  btm_ble_resolving_list_batch_end, which adds all of them
+ *                  with a single synchronization.
+ *
+ * Returns          none
+ *
+ ******************************************************************************/
+void btm_ble_resolving_list_batch_start(void) {
+  if (controller_get_interface()->get_ble_resolving_list_max_size() == 0)
+    return;
+
+  rl_batch_active = true;
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_ble_resolving_list_batch_end
+ *
+ * Description      Synchronize the resolving list with the devices loaded
+ *                  since btm_ble_resolving_list_batch_start.
+ *
+ * Returns          none
+ *
+ ******************************************************************************/
+void btm_ble_resolving_list_batch_end(void) {
+  if (!rl_batch_active) return;
+
+  rl_batch_active = false;
+  btm_ble_resolving_list_sync(BTM_BLE_RL_IDLE, NULL);
 }
 
 /*******************************************************************************
@@ -825,6 +1147,12 @@ void btm_ble_resolving_list_remove_dev(tBTM_SEC_DEV_REC* p_dev_rec) {
 void btm_ble_enable_resolving_list(uint8_t rl_mask) {
   uint8_t rl_state = btm_cb.ble_ctr_cb.rl_state;
 
+  /* applied when the synchronization completes */
+  if (rl_sync_active) {
+    rl_sync_state |= rl_mask;
+    return;
+  }
+
   btm_cb.ble_ctr_cb.rl_state |= rl_mask;
   if (rl_state == BTM_BLE_RL_IDLE &&
       btm_cb.ble_ctr_cb.rl_state != BTM_BLE_RL_IDLE &&
@@ -848,26 +1176,24 @@ bool btm_ble_resolving_list_empty(void) {
           btm_cb.ble_ctr_cb.resolving_list_avail_size);
 }
 
-bool is_on_resolving_list(void* data, void* context) {
-  tBTM_SEC_DEV_REC* p_dev = static_cast<tBTM_SEC_DEV_REC*>(data);
+static bool is_on_resolving_list(const tBTM_SEC_DEV_REC* p_dev) {
   if ((p_dev->ble.in_controller_list & BTM_RESOLVING_LIST_BIT) &&
       (p_dev->ble.in_controller_list & BTM_WHITE_LIST_BIT)) {
     BTM_TRACE_DEBUG("%s is_on_resolving_list %d", __func__,
                      p_dev->ble.in_controller_list);
-    return false;
+    return true;
   }
 
-  return true;
+  return false;
 }
 
-bool is_on_resolving_list_scan(void* data, void* context) {
-  tBTM_SEC_DEV_REC* p_dev = static_cast<tBTM_SEC_DEV_REC*>(data);
+static bool is_on_resolving_list_scan(const tBTM_SEC_DEV_REC* p_dev) {
   if (p_dev->ble.in_controller_list & BTM_RESOLVING_LIST_BIT) {
     BTM_TRACE_DEBUG("%s ", __func__);
-    return false;
+    return true;
   }
 
-  return true;
+  return false;
 }
 
 void btm_ble_enable_resolving_list_for_scan(uint8_t rl_mask) {
@@ -886,8 +1212,7 @@ void btm_ble_enable_resolving_list_for_scan(uint8_t rl_mask) {
     return;
   }
 
-  list_node_t* n = list_foreach(btm_cb.sec_dev_rec, is_on_resolving_list_scan, NULL);
-  if (n) {
+  if (btm_cb.sec_dev_rec.Find(is_on_resolving_list_scan)) {
     btm_ble_enable_resolving_list(rl_mask);
   } else {
     btm_ble_disable_resolving_list(rl_mask, true);
@@ -920,8 +1245,7 @@ void btm_ble_enable_resolving_list_for_platform(uint8_t rl_mask) {
     return;
   }
 
-  list_node_t* n = list_foreach(btm_cb.sec_dev_rec, is_on_resolving_list, NULL);
-  if (n) {
+  if (btm_cb.sec_dev_rec.Find(is_on_resolving_list)) {
     btm_ble_enable_resolving_list(rl_mask);
   } else {
     btm_ble_disable_resolving_list(rl_mask, true);
@@ -981,6 +1305,14 @@ void btm_ble_resolving_list_cleanup(void) {
   controller_get_interface()->set_ble_resolving_list_max_size(0);
 
   osi_free_and_reset((void**)&btm_cb.ble_ctr_cb.irk_list_mask);
+
+  rl_batch_active = false;
+  rl_sync_active = false;
+  rl_sync_rerun = false;
+  rl_sync_suspended = false;
+  rl_sync_state = BTM_BLE_RL_IDLE;
+  rl_sync_cback = NULL;
+  rl_sync_ops.clear();
 }
 
 /*******************************************************************************
@@ -0,0 +1,328 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_btm_conn_trace"
+
+#include "btm_conn_trace.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <deque>
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include "osi/include/time.h"
+
+// Links traced at once and devices whose history is kept. The oldest entry
+// makes room when either is full.
+#define BTM_CONN_TRACE_MAX_OPEN 16
+#define BTM_CONN_TRACE_MAX_DEVICES 16
+#define BTM_CONN_TRACE_HISTORY 4
+
+#define NO_MILESTONE BTM_CONN_TRACE_MILESTONE_COUNT
+
+typedef struct {
+  uint64_t on_path;  // Traces whose critical path went through the milestone.
+  uint64_t total_us;
+  uint64_t max_us;
+  uint64_t longest;  // Traces in which it was the longest step.
+} milestone_stats_t;
+
+typedef std::pair<RawAddress, tBT_TRANSPORT> link_key_t;
+
+static const char* milestone_names[BTM_CONN_TRACE_MILESTONE_COUNT] = {
+    "acl_requested",  "acl_connected",    "remote_version",
+    "remote_features", "authenticated",   "encrypted",
+    "sdp_started",    "sdp_complete",     "l2cap_configured",
+    "profile"};
+
+#define MILESTONE_BIT(milestone) (1u << BTM_CONN_TRACE_##milestone)
+
+// The milestones each one has to wait for. A prerequisite that was not
+// reached is replaced by its own prerequisites.
+static const uint32_t prerequisites[BTM_CONN_TRACE_MILESTONE_COUNT] = {
+    0,                                // ACL_REQUESTED
+    MILESTONE_BIT(ACL_REQUESTED),     // ACL_CONNECTED
+    MILESTONE_BIT(ACL_CONNECTED),     // REMOTE_VERSION
+    MILESTONE_BIT(ACL_CONNECTED),     // REMOTE_FEATURES
+    MILESTONE_BIT(REMOTE_FEATURES),   // AUTHENTICATED
+    MILESTONE_BIT(AUTHENTICATED) |    // ENCRYPTED
+        MILESTONE_BIT(REMOTE_FEATURES),
+    MILESTONE_BIT(ACL_CONNECTED),     // SDP_STARTED
+    MILESTONE_BIT(SDP_STARTED),       // SDP_COMPLETE
+    MILESTONE_BIT(ENCRYPTED) |        // L2CAP_CONFIGURED
+        MILESTONE_BIT(REMOTE_FEATURES),
+    MILESTONE_BIT(L2CAP_CONFIGURED) |  // PROFILE_CONNECTED
+        MILESTONE_BIT(SDP_COMPLETE) | MILESTONE_BIT(ENCRYPTED),
+};
+
+static std::mutex trace_lock;
+static std::map<link_key_t, btm_conn_trace_t> open_traces;
+static std::map<RawAddress, std::deque<btm_conn_trace_t>> history;
+static milestone_stats_t stats[BTM_CONN_TRACE_MILESTONE_COUNT];
+static uint64_t traces_complete;
+static uint64_t traces_aborted;
+static uint64_t traces_evicted;
+static uint64_t total_us_sum;
+static uint64_t total_us_max;
+
+static bool reached(const btm_conn_trace_t& trace, int milestone) {
+  return trace.milestone_us[milestone] != 0;
+}
+
+static uint64_t first_us(const btm_conn_trace_t& trace) {
+  uint64_t first = UINT64_MAX;
+  for (uint64_t us : trace.milestone_us)
+    if (us != 0 && us < first) first = us;
+  return first;
+}
+
+static uint64_t last_us(const btm_conn_trace_t& trace) {
+  uint64_t last = 0;
+  for (uint64_t us : trace.milestone_us)
+    if (us > last) last = us;
+  return last;
+}
+
+// Returns the reached prerequisite of |milestone|, direct or through
+// unreached ones, that completed last but not after |limit_us|.
+static int gating_milestone(const btm_conn_trace_t& trace, int milestone,
+                            uint64_t limit_us) {
+  int gate = NO_MILESTONE;
+  for (int prerequisite = 0; prerequisite < BTM_CONN_TRACE_MILESTONE_COUNT;
+       prerequisite++) {
+    if (!(prerequisites[milestone] & (1u << prerequisite))) continue;
+    int candidate = prerequisite;
+    if (!reached(trace, prerequisite) ||
+        trace.milestone_us[prerequisite] > limit_us)
+      candidate = gating_milestone(trace, prerequisite, limit_us);
+    if (candidate == NO_MILESTONE) continue;
+    if (gate == NO_MILESTONE ||
+        trace.milestone_us[candidate] > trace.milestone_us[gate])
+      gate = candidate;
+  }
+  return gate;
+}
+
+// Fills in the critical path of |trace| and adds it to the statistics.
+static void close_trace_locked(btm_conn_trace_t* trace, bool complete) {
+  trace->complete = complete;
+
+  int last = NO_MILESTONE;
+  for (int i = 0; i < BTM_CONN_TRACE_MILESTONE_COUNT; i++) {
+    if (!reached(*trace, i)) continue;
+    if (last == NO_MILESTONE ||
+        trace->milestone_us[i] >= trace->milestone_us[last])
+      last = i;
+  }
+  if (reached(*trace, BTM_CONN_TRACE_PROFILE_CONNECTED))
+    last = BTM_CONN_TRACE_PROFILE_CONNECTED;
+
+  // Walk back from the last milestone, then reverse
+  btm_conn_trace_milestone_t reversed[BTM_CONN_TRACE_MILESTONE_COUNT];
+  uint8_t length = 0;
+  for (int current = last; current != NO_MILESTONE;
+       current = gating_milestone(*trace, current,
+                                  trace->milestone_us[current])) {
+    reversed[length++] = static_cast<btm_conn_trace_milestone_t>(current);
+  }
+  trace->path_length = length;
+  for (uint8_t i = 0; i < length; i++)
+    trace->path[i] = reversed[length - 1 - i];
+
+  trace->longest = trace->path[0];
+  trace->longest_us = 0;
+  trace->total_us = trace->milestone_us[trace->path[length - 1]] -
+                    trace->milestone_us[trace->path[0]];
+
+  for (uint8_t i = 1; i < length; i++) {
+    uint64_t step_us = trace->milestone_us[trace->path[i]] -
+                       trace->milestone_us[trace->path[i - 1]];
+    milestone_stats_t* step = &stats[trace->path[i]];
+    step->on_path++;
+    step->total_us += step_us;
+    if (step_us > step->max_us) step->max_us = step_us;
+    if (i == 1 || step_us > trace->longest_us) {
+      trace->longest = trace->path[i];
+      trace->longest_us = step_us;
+    }
+  }
+  if (length > 1) stats[trace->longest].longest++;
+
+  if (complete)
+    traces_complete++;
+  else
+    traces_aborted++;
+  total_us_sum += trace->total_us;
+  if (trace->total_us > total_us_max) total_us_max = trace->total_us;
+
+  std::deque<btm_conn_trace_t>* device = &history[trace->bda];
+  device->push_back(*trace);
+  if (device->size() > BTM_CONN_TRACE_HISTORY) device->pop_front();
+
+  if (history.size() > BTM_CONN_TRACE_MAX_DEVICES) {
+    auto oldest = history.begin();
+    for (auto it = history.begin(); it != history.end(); ++it) {
+      if (last_us(it->second.back()) < last_us(oldest->second.back()))
+        oldest = it;
+    }
+    history.erase(oldest);
+  }
+}
+
+static btm_conn_trace_t* open_trace_locked(const link_key_t& key) {
+  if (open_traces.size() >= BTM_CONN_TRACE_MAX_OPEN) {
+    auto oldest = open_traces.begin();
+    for (auto it = open_traces.begin(); it != open_traces.end(); ++it) {
+      if (first_us(it->second) < first_us(oldest->second)) oldest = it;
+    }
+    open_traces.erase(oldest);
+    traces_evicted++;
+  }
+
+  btm_conn_trace_t* trace = &open_traces[key];
+  *trace = btm_conn_trace_t();
+  trace->bda = key.first;
+  trace->transport = key.second;
+  return trace;
+}
+
+void btm_conn_trace_mark(const RawAddress& bda, tBT_TRANSPORT transport,
+                         btm_conn_trace_milestone_t milestone) {
+  btm_conn_trace_mark_at(bda, transport, milestone, time_get_os_boottime_us());
+}
+
+void btm_conn_trace_mark_at(const RawAddress& bda, tBT_TRANSPORT transport,
+                            btm_conn_trace_milestone_t milestone,
+                            uint64_t timestamp_us) {
+  if (milestone >= BTM_CONN_TRACE_MILESTONE_COUNT || timestamp_us == 0) return;
+
+  link_key_t key(bda, transport);
+  std::lock_guard<std::mutex> lock(trace_lock);
+  auto it = open_traces.find(key);
+  btm_conn_trace_t* trace;
+  if (it != open_traces.end()) {
+    trace = &it->second;
+  } else if (milestone == BTM_CONN_TRACE_ACL_REQUESTED ||
+             milestone == BTM_CONN_TRACE_ACL_CONNECTED) {
+    trace = open_trace_locked(key);
+  } else {
+    // Not a link we saw come up
+    return;
+  }
+
+  if (reached(*trace, milestone)) return;
+  trace->milestone_us[milestone] = timestamp_us;
+}
+
+void btm_conn_trace_profile_connected(const RawAddress& bda,
+                                      tBT_TRANSPORT transport,
+                                      const char* profile) {
+  uint64_t now_us = time_get_os_boottime_us();
+  link_key_t key(bda, transport);
+  std::lock_guard<std::mutex> lock(trace_lock);
+  auto it = open_traces.find(key);
+  if (it == open_traces.end()) return;
+
+  btm_conn_trace_t trace = it->second;
+  open_traces.erase(it);
+  trace.milestone_us[BTM_CONN_TRACE_PROFILE_CONNECTED] = now_us;
+  trace.profile = profile;
+  close_trace_locked(&trace, true);
+}
+
+void btm_conn_trace_disconnected(const RawAddress& bda,
+                                 tBT_TRANSPORT transport) {
+  link_key_t key(bda, transport);
+  std::lock_guard<std::mutex> lock(trace_lock);
+  auto it = open_traces.find(key);
+  if (it == open_traces.end()) return;
+
+  btm_conn_trace_t trace = it->second;
+  open_traces.erase(it);
+  close_trace_locked(&trace, false);
+}
+
+bool btm_conn_trace_get_last(const RawAddress& bda, btm_conn_trace_t* trace) {
+  std::lock_guard<std::mutex> lock(trace_lock);
+  auto it = history.find(bda);
+  if (it == history.end() || it->second.empty()) return false;
+  *trace = it->second.back();
+  return true;
+}
+
+void btm_conn_trace_reset(void) {
+  std::lock_guard<std::mutex> lock(trace_lock);
+  open_traces.clear();
+  history.clear();
+  memset(stats, 0, sizeof(stats));
+  traces_complete = 0;
+  traces_aborted = 0;
+  traces_evicted = 0;
+  total_us_sum = 0;
+  total_us_max = 0;
+}
+
+static void dump_trace(int fd, const btm_conn_trace_t& trace) {
+  dprintf(fd, "    %s %s %" PRIu64 " ms%s%s, longest %s %" PRIu64 " ms\n     ",
+          trace.transport == BT_TRANSPORT_LE ? "LE" : "BR/EDR",
+          trace.complete ? "connected" : "aborted", trace.total_us / 1000,
+          trace.profile ? " by " : "", trace.profile ? trace.profile : "",
+          milestone_names[trace.longest], trace.longest_us / 1000);
+  for (uint8_t i = 0; i < trace.path_length; i++) {
+    if (i == 0) {
+      dprintf(fd, " %s", milestone_names[trace.path[i]]);
+      continue;
+    }
+    dprintf(fd, " -%" PRIu64 "-> %s",
+            (trace.milestone_us[trace.path[i]] -
+             trace.milestone_us[trace.path[i - 1]]) /
+                1000,
+            milestone_names[trace.path[i]]);
+  }
+  dprintf(fd, "\n");
+}
+
+void btm_conn_trace_debug_dump(int fd) {
+  std::lock_guard<std::mutex> lock(trace_lock);
+  uint64_t traces = traces_complete + traces_aborted;
+  dprintf(fd, "\nConnection Setup Critical Path:\n");
+  dprintf(fd,
+          "  Traces: %" PRIu64 " connected, %" PRIu64 " aborted, %" PRIu64
+          " evicted, %zu open  avg/max ms : %" PRIu64 " / %" PRIu64 "\n",
+          traces_complete, traces_aborted, traces_evicted, open_traces.size(),
+          traces ? total_us_sum / traces / 1000 : 0, total_us_max / 1000);
+  for (int i = 0; i < BTM_CONN_TRACE_MILESTONE_COUNT; i++) {
+    const milestone_stats_t* step = &stats[i];
+    if (step->on_path == 0) continue;
+    dprintf(fd,
+            "  %-16s on path: %" PRIu64 "  longest: %" PRIu64
+            "  avg/max ms : %" PRIu64 " / %" PRIu64 "\n",
+            milestone_names[i], step->on_path, step->longest,
+            step->total_us / step->on_path / 1000, step->max_us / 1000);
+  }
+
+  for (const auto& device : history) {
+    dprintf(fd, "  %s\n", device.first.ToString().c_str());
+    for (auto it = device.second.rbegin(); it != device.second.rend(); ++it)
+      dump_trace(fd, *it);
+  }
+}
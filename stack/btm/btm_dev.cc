@@ -68,6 +68,9 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <type_traits>
+#include <unordered_map>
+
 #include "bt_common.h"
 #include "bt_types.h"
 #include "btm_api.h"
@@ -77,9 +80,212 @@
 #include "hcidefs.h"
 #include "hcimsgs.h"
 #include "l2c_api.h"
+#include "sdp_api.h"
 #include "btif_util.h"
 #include "btif_storage.h"
 
+static tBTM_SEC_DEV_LOADER* btm_sec_dev_loader = NULL;
+static tBTM_CONN_PROFILE_LOADER* btm_conn_profile_loader = NULL;
+
+/* Hash indexes of btm_cb.sec_dev_rec by address and by HCI handle. A record
+ * is reindexed by btm_sec_dev_rec_reindex() whenever one of its keys changes
+ * and dropped by btm_sec_dev_rec_unindex() when it is freed. Empty addresses
+ * and invalid handles are not indexed, lookups for them scan the list. */
+namespace {
+
+struct SecDevAddrHash {
+  std::size_t operator()(const RawAddress& x) const {
+    const uint8_t* a = x.address;
+    return a[0] ^ (a[1] << 8) ^ (a[2] << 16) ^ (a[3] << 24) ^ a[4] ^
+           (a[5] << 8);
+  }
+};
+
+/* The keys a record is indexed under */
+struct SecDevIndexKeys {
+  uint32_t order; /* position in btm_cb.sec_dev_rec, oldest first */
+  RawAddress bd_addr;
+  RawAddress pseudo_addr;
+  RawAddress identity_addr;
+  uint16_t hci_handle;
+  uint16_t ble_hci_handle;
+};
+
+template <typename Key>
+using SecDevIndex =
+    std::unordered_multimap<Key, tBTM_SEC_DEV_REC*,
+                            typename std::conditional<
+                                std::is_same<Key, RawAddress>::value,
+                                SecDevAddrHash, std::hash<Key>>::type>;
+
+std::unordered_map<const tBTM_SEC_DEV_REC*, SecDevIndexKeys> sec_dev_keys;
+/* bd_addr and pseudo_addr */
+SecDevIndex<RawAddress> sec_dev_by_addr;
+SecDevIndex<RawAddress> sec_dev_by_identity;
+/* hci_handle and ble_hci_handle */
+SecDevIndex<uint16_t> sec_dev_by_handle;
+uint32_t sec_dev_order = 0;
+
+template <typename Key>
+void sec_dev_index_add(SecDevIndex<Key>& index, const Key& key,
+                       tBTM_SEC_DEV_REC* p_dev_rec) {
+  index.emplace(key, p_dev_rec);
+}
+
+template <typename Key>
+void sec_dev_index_remove(SecDevIndex<Key>& index, const Key& key,
+                          const tBTM_SEC_DEV_REC* p_dev_rec) {
+  auto range = index.equal_range(key);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second == p_dev_rec) {
+      index.erase(it);
+      return;
+    }
+  }
+}
+
+void sec_dev_index_remove_keys(const tBTM_SEC_DEV_REC* p_dev_rec,
+                               const SecDevIndexKeys& keys) {
+  if (!keys.bd_addr.IsEmpty())
+    sec_dev_index_remove(sec_dev_by_addr, keys.bd_addr, p_dev_rec);
+  if (!keys.pseudo_addr.IsEmpty() && keys.pseudo_addr != keys.bd_addr)
+    sec_dev_index_remove(sec_dev_by_addr, keys.pseudo_addr, p_dev_rec);
+  if (!keys.identity_addr.IsEmpty())
+    sec_dev_index_remove(sec_dev_by_identity, keys.identity_addr, p_dev_rec);
+  if (keys.hci_handle != BTM_SEC_INVALID_HANDLE)
+    sec_dev_index_remove(sec_dev_by_handle, keys.hci_handle, p_dev_rec);
+  if (keys.ble_hci_handle != BTM_SEC_INVALID_HANDLE &&
+      keys.ble_hci_handle != keys.hci_handle)
+    sec_dev_index_remove(sec_dev_by_handle, keys.ble_hci_handle, p_dev_rec);
+}
+
+/* Returns the oldest record indexed under |key| for which |matches| holds.
+ * |matches| checks the record still has the key. */
+template <typename Key, typename Pred>
+tBTM_SEC_DEV_REC* sec_dev_index_find(const SecDevIndex<Key>& index,
+                                     const Key& key, Pred matches) {
+  tBTM_SEC_DEV_REC* p_found = NULL;
+  uint32_t found_order = 0;
+
+  auto range = index.equal_range(key);
+  for (auto it = range.first; it != range.second; ++it) {
+    tBTM_SEC_DEV_REC* p_dev_rec = it->second;
+    if (!matches(p_dev_rec)) continue;
+
+    uint32_t order = sec_dev_keys[p_dev_rec].order;
+    if (p_found == NULL || order < found_order) {
+      p_found = p_dev_rec;
+      found_order = order;
+    }
+  }
+  return p_found;
+}
+
+}  // namespace
+
+/*******************************************************************************
+ *
+ * Function         btm_sec_dev_rec_reindex
+ *
+ * Description      Updates the device record indexes after the address, pseudo
+ *                  address, identity address or an HCI handle of |p_dev_rec|
+ *                  changed. A record seen for the first time is added.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_sec_dev_rec_reindex(tBTM_SEC_DEV_REC* p_dev_rec) {
+  auto it = sec_dev_keys.find(p_dev_rec);
+  if (it == sec_dev_keys.end()) {
+    it = sec_dev_keys.emplace(p_dev_rec, SecDevIndexKeys{}).first;
+    it->second.order = sec_dev_order++;
+    it->second.hci_handle = BTM_SEC_INVALID_HANDLE;
+    it->second.ble_hci_handle = BTM_SEC_INVALID_HANDLE;
+  } else {
+    sec_dev_index_remove_keys(p_dev_rec, it->second);
+  }
+
+  SecDevIndexKeys& keys = it->second;
+  keys.bd_addr = p_dev_rec->bd_addr;
+  keys.pseudo_addr = p_dev_rec->ble.pseudo_addr;
+  keys.identity_addr = p_dev_rec->ble.identity_addr;
+  keys.hci_handle = p_dev_rec->hci_handle;
+  keys.ble_hci_handle = p_dev_rec->ble_hci_handle;
+
+  if (!keys.bd_addr.IsEmpty())
+    sec_dev_index_add(sec_dev_by_addr, keys.bd_addr, p_dev_rec);
+  if (!keys.pseudo_addr.IsEmpty() && keys.pseudo_addr != keys.bd_addr)
+    sec_dev_index_add(sec_dev_by_addr, keys.pseudo_addr, p_dev_rec);
+  if (!keys.identity_addr.IsEmpty())
+    sec_dev_index_add(sec_dev_by_identity, keys.identity_addr, p_dev_rec);
+  if (keys.hci_handle != BTM_SEC_INVALID_HANDLE)
+    sec_dev_index_add(sec_dev_by_handle, keys.hci_handle, p_dev_rec);
+  if (keys.ble_hci_handle != BTM_SEC_INVALID_HANDLE &&
+      keys.ble_hci_handle != keys.hci_handle)
+    sec_dev_index_add(sec_dev_by_handle, keys.ble_hci_handle, p_dev_rec);
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_sec_dev_rec_unindex
+ *
+ * Description      Drops |p_dev_rec| from the device record indexes, called
+ *                  when the record is freed.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_sec_dev_rec_unindex(const tBTM_SEC_DEV_REC* p_dev_rec) {
+  auto it = sec_dev_keys.find(p_dev_rec);
+  if (it == sec_dev_keys.end()) return;
+
+  sec_dev_index_remove_keys(p_dev_rec, it->second);
+  sec_dev_keys.erase(it);
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_sec_dev_rec_remove
+ *
+ * Description      Unlinks |p_dev_rec| from btm_cb.sec_dev_rec and frees it,
+ *                  dropping what the indexes and the RPA resolver remember of
+ *                  it. Nothing is done if the record is not on the list.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_sec_dev_rec_remove(tBTM_SEC_DEV_REC* p_dev_rec) {
+  if (!btm_cb.sec_dev_rec.Remove(p_dev_rec)) return;
+
+  btm_ble_resolver_forget_dev(p_dev_rec);
+  btm_sec_dev_rec_unindex(p_dev_rec);
+  osi_free(p_dev_rec);
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_find_dev_by_identity_addr_index
+ *
+ * Description      Looks up the oldest record whose LE identity address is
+ *                  |bd_addr|.
+ *
+ * Returns          Pointer to the record or NULL
+ *
+ ******************************************************************************/
+tBTM_SEC_DEV_REC* btm_find_dev_by_identity_addr_index(
+    const RawAddress& bd_addr) {
+  if (bd_addr.IsEmpty()) {
+    return btm_cb.sec_dev_rec.Find([](const tBTM_SEC_DEV_REC* p_dev_rec) {
+      return p_dev_rec->ble.identity_addr.IsEmpty();
+    });
+  }
+
+  return sec_dev_index_find(sec_dev_by_identity, bd_addr,
+                            [&bd_addr](const tBTM_SEC_DEV_REC* p_dev_rec) {
+                              return p_dev_rec->ble.identity_addr == bd_addr;
+                            });
+}
+
 /*******************************************************************************
  *
  * Function         BTM_SecAddDevice
@@ -117,6 +323,7 @@ bool BTM_SecAddDevice(const RawAddress& bd_addr, DEV_CLASS dev_class,
     p_dev_rec->bd_addr = bd_addr;
 
     p_dev_rec->hci_handle = BTM_GetHCIConnHandle(bd_addr, BT_TRANSPORT_BR_EDR);
+    btm_sec_dev_rec_reindex(p_dev_rec);
 
     /* use default value for background connection params */
     /* update conn params, use default value for background connection params */
@@ -194,6 +401,95 @@ bool BTM_SecAddDevice(const RawAddress& bd_addr, DEV_CLASS dev_class,
   return true;
 }
 
+/*******************************************************************************
+ *
+ * Function         BTM_SecRegisterDevLoader
+ *
+ * Description      Register the loader called by btm_find_dev for the devices
+ *                  which have no security record yet.
+ *
+ ******************************************************************************/
+void BTM_SecRegisterDevLoader(tBTM_SEC_DEV_LOADER* p_loader) {
+  btm_sec_dev_loader = p_loader;
+}
+
+/*******************************************************************************
+ *
+ * Function         BTM_SecRegisterConnProfileLoader
+ *
+ * Description      Register the loader called by btm_sec_load_conn_profile.
+ *
+ ******************************************************************************/
+void BTM_SecRegisterConnProfileLoader(tBTM_CONN_PROFILE_LOADER* p_loader) {
+  btm_conn_profile_loader = p_loader;
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_sec_load_conn_profile
+ *
+ * Description      Restore the cached version and features of |p_dev_rec| on
+ *                  its first connection, unless they are known already. The
+ *                  loader is asked once per record.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_sec_load_conn_profile(tBTM_SEC_DEV_REC* p_dev_rec) {
+  if (p_dev_rec->conn_profile_loaded || btm_conn_profile_loader == NULL)
+    return;
+  p_dev_rec->conn_profile_loaded = true;
+
+  tBTM_CONN_PROFILE profile;
+  memset(&profile, 0, sizeof(profile));
+  if (!(*btm_conn_profile_loader)(p_dev_rec->bd_addr, &profile)) return;
+
+  if (p_dev_rec->num_read_pages == 0 && profile.num_read_pages &&
+      profile.num_read_pages <= HCI_EXT_FEATURES_PAGE_MAX + 1) {
+    memcpy(p_dev_rec->feature_pages, profile.feature_pages,
+           sizeof(p_dev_rec->feature_pages));
+    p_dev_rec->num_read_pages = profile.num_read_pages;
+  }
+
+  if (!p_dev_rec->rmt_version_known && profile.version_known) {
+    p_dev_rec->rmt_version_known = true;
+    p_dev_rec->lmp_version = profile.lmp_version;
+    p_dev_rec->manufacturer = profile.manufacturer;
+    p_dev_rec->lmp_subversion = profile.lmp_subversion;
+  }
+
+  BTM_TRACE_DEBUG("%s: %s pages=%d version=%d", __func__,
+                  p_dev_rec->bd_addr.ToString().c_str(),
+                  p_dev_rec->num_read_pages, p_dev_rec->rmt_version_known);
+}
+
+/*******************************************************************************
+ *
+ * Function         BTM_SecReadConnProfile
+ *
+ * Description      Read the remote version and features known for |bd_addr|.
+ *
+ * Returns          true if the device has a security record
+ *
+ ******************************************************************************/
+bool BTM_SecReadConnProfile(const RawAddress& bd_addr,
+                            tBTM_CONN_PROFILE* p_profile) {
+  tBTM_SEC_DEV_REC* p_dev_rec = btm_find_dev(bd_addr);
+  if (p_dev_rec == NULL) return false;
+
+  memset(p_profile, 0, sizeof(tBTM_CONN_PROFILE));
+  if (p_dev_rec->num_read_pages <= HCI_EXT_FEATURES_PAGE_MAX + 1) {
+    memcpy(p_profile->feature_pages, p_dev_rec->feature_pages,
+           sizeof(p_profile->feature_pages));
+    p_profile->num_read_pages = p_dev_rec->num_read_pages;
+  }
+  p_profile->version_known = p_dev_rec->rmt_version_known;
+  p_profile->lmp_version = p_dev_rec->lmp_version;
+  p_profile->manufacturer = p_dev_rec->manufacturer;
+  p_profile->lmp_subversion = p_dev_rec->lmp_subversion;
+  return true;
+}
+
 /** Free resources associated with the device associated with |bd_addr| address.
  *
  * *** WARNING ***
@@ -227,6 +523,9 @@ bool BTM_SecDeleteDevice(const RawAddress& bd_addr) {
     BTM_DeleteStoredLinkKey(&bda, NULL);
   }
 
+  /* The services of a device that is paired again are discovered afresh */
+  SDP_FlushRemoteCache(bd_addr);
+
   return true;
 }
 
@@ -345,6 +644,7 @@ tBTM_SEC_DEV_REC* btm_sec_alloc_dev(const RawAddress& bd_addr) {
 
   p_dev_rec->ble_hci_handle = BTM_GetHCIConnHandle(bd_addr, BT_TRANSPORT_LE);
   p_dev_rec->hci_handle = BTM_GetHCIConnHandle(bd_addr, BT_TRANSPORT_BR_EDR);
+  btm_sec_dev_rec_reindex(p_dev_rec);
 
   return (p_dev_rec);
 }
@@ -365,7 +665,7 @@ void btm_sec_free_dev(tBTM_SEC_DEV_REC* p_dev_rec) {
 
   /* Clear out any saved BLE keys */
   btm_sec_clear_ble_keys(p_dev_rec);
-  list_remove(btm_cb.sec_dev_rec, p_dev_rec);
+  btm_sec_dev_rec_remove(p_dev_rec);
 }
 
 /*******************************************************************************
@@ -416,16 +716,6 @@ bool btm_dev_support_switch(const RawAddress& bd_addr) {
   return (false);
 }
 
-bool is_handle_equal(void* data, void* context) {
-  tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(data);
-  uint16_t* handle = static_cast<uint16_t*>(context);
-
-  if (p_dev_rec->hci_handle == *handle || p_dev_rec->ble_hci_handle == *handle)
-    return false;
-
-  return true;
-}
-
 /*******************************************************************************
  *
  * Function         btm_find_dev_by_handle
@@ -437,23 +727,24 @@ bool is_handle_equal(void* data, void* context) {
  *
  ******************************************************************************/
 tBTM_SEC_DEV_REC* btm_find_dev_by_handle(uint16_t handle) {
-  list_node_t* n = list_foreach(btm_cb.sec_dev_rec, is_handle_equal, &handle);
-  if (n) return static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
-
-  return NULL;
+  auto matches = [handle](const tBTM_SEC_DEV_REC* p_dev_rec) {
+    return p_dev_rec->hci_handle == handle ||
+           p_dev_rec->ble_hci_handle == handle;
+  };
+  if (handle == BTM_SEC_INVALID_HANDLE)
+    return btm_cb.sec_dev_rec.Find(matches);
+
+  return sec_dev_index_find(sec_dev_by_handle, handle, matches);
 }
 
-bool is_address_equal(void* data, void* context) {
-  tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(data);
-  const RawAddress* bd_addr = ((RawAddress*)context);
-
-  if (*bd_addr == RawAddress::kEmpty) return true;
-  if (p_dev_rec->bd_addr == *bd_addr) return false;
+static bool is_address_equal(const tBTM_SEC_DEV_REC* p_dev_rec,
+                             const RawAddress& bd_addr) {
+  if (bd_addr == RawAddress::kEmpty) return false;
+  if (p_dev_rec->bd_addr == bd_addr) return true;
   // If a LE random address is looking for device record
-  if (p_dev_rec->ble.pseudo_addr == *bd_addr) return false;
+  if (p_dev_rec->ble.pseudo_addr == bd_addr) return true;
 
-  if (btm_ble_addr_resolvable(*bd_addr, p_dev_rec)) return false;
-  return true;
+  return btm_ble_addr_resolvable(bd_addr, p_dev_rec);
 }
 
 /*******************************************************************************
@@ -466,12 +757,31 @@ bool is_address_equal(void* data, void* context) {
  * Returns          Pointer to the record or NULL
  *
  ******************************************************************************/
+static tBTM_SEC_DEV_REC* btm_find_dev_in_list(const RawAddress& bd_addr) {
+  if (bd_addr.IsEmpty()) return NULL;
+
+  tBTM_SEC_DEV_REC* p_dev_rec = sec_dev_index_find(
+      sec_dev_by_addr, bd_addr, [&bd_addr](const tBTM_SEC_DEV_REC* p_rec) {
+        return p_rec->bd_addr == bd_addr || p_rec->ble.pseudo_addr == bd_addr;
+      });
+  if (p_dev_rec) return p_dev_rec;
+
+  /* Only a resolvable private address can match any other record */
+  if (!BTM_BLE_IS_RESOLVE_BDA(bd_addr)) return NULL;
+
+  return btm_cb.sec_dev_rec.Find(
+      [&bd_addr](const tBTM_SEC_DEV_REC* p_rec) {
+        return is_address_equal(p_rec, bd_addr);
+      });
+}
+
 tBTM_SEC_DEV_REC* btm_find_dev(const RawAddress& bd_addr) {
-  if (btm_cb.sec_dev_rec == NULL) return NULL;
+  tBTM_SEC_DEV_REC* p_dev_rec = btm_find_dev_in_list(bd_addr);
+  if (p_dev_rec) return p_dev_rec;
 
-  list_node_t* n =
-      list_foreach(btm_cb.sec_dev_rec, is_address_equal, (void*)&bd_addr);
-  if (n) return static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
+  /* A bonded device which was not loaded at startup */
+  if (btm_sec_dev_loader != NULL && btm_sec_dev_loader(bd_addr))
+    return btm_find_dev_in_list(bd_addr);
 
   return NULL;
 }
@@ -490,19 +800,19 @@ void btm_consolidate_dev(tBTM_SEC_DEV_REC* p_target_rec) {
 
   BTM_TRACE_DEBUG("%s", __func__);
 
-  list_node_t* end = list_end(btm_cb.sec_dev_rec);
-  list_node_t* node = list_begin(btm_cb.sec_dev_rec);
-  while (node != end) {
-    tBTM_SEC_DEV_REC* p_dev_rec =
-        static_cast<tBTM_SEC_DEV_REC*>(list_node(node));
+  tBTM_SEC_DEV_REC* p_next = btm_cb.sec_dev_rec.Front();
+  while (p_next != NULL) {
+    tBTM_SEC_DEV_REC* p_dev_rec = p_next;
 
-    // we do list_remove in some cases, must grab next before removing
-    node = list_next(node);
+    // we remove records in some cases, must grab next before removing
+    p_next = btm_cb.sec_dev_rec.Next(p_dev_rec);
 
     if (p_target_rec == p_dev_rec) continue;
 
     if (p_dev_rec->bd_addr == p_target_rec->bd_addr) {
       memcpy(p_target_rec, p_dev_rec, sizeof(tBTM_SEC_DEV_REC));
+      // the target stays where it is on the list
+      p_target_rec->list_hook = temp_rec.list_hook;
       p_target_rec->ble = temp_rec.ble;
       p_target_rec->ble_hci_handle = temp_rec.ble_hci_handle;
       p_target_rec->enc_key_size = temp_rec.enc_key_size;
@@ -514,10 +824,11 @@ void btm_consolidate_dev(tBTM_SEC_DEV_REC* p_target_rec) {
           temp_rec.new_encryption_key_is_p256;
       p_target_rec->no_smp_on_br = temp_rec.no_smp_on_br;
       p_target_rec->bond_type = temp_rec.bond_type;
+      btm_sec_dev_rec_reindex(p_target_rec);
 
       /* remove the combined record */
-      list_remove(btm_cb.sec_dev_rec, p_dev_rec);
-      //p_dev_rec gets freed in list_remove, we should not  access it further
+      btm_sec_dev_rec_remove(p_dev_rec);
+      // p_dev_rec is freed, we should not access it further
       continue;
     }
 
@@ -528,7 +839,7 @@ void btm_consolidate_dev(tBTM_SEC_DEV_REC* p_target_rec) {
         p_target_rec->device_type |= p_dev_rec->device_type;
 
         /* remove the combined record */
-        list_remove(btm_cb.sec_dev_rec, p_dev_rec);
+        btm_sec_dev_rec_remove(p_dev_rec);
       }
     }
   }
@@ -572,11 +883,8 @@ static tBTM_SEC_DEV_REC* btm_find_oldest_dev_rec(void) {
   tBTM_SEC_DEV_REC* p_oldest_paired = NULL;
   uint32_t ts_oldest_paired = 0xFFFFFFFF;
 
-  list_node_t* end = list_end(btm_cb.sec_dev_rec);
-  for (list_node_t* node = list_begin(btm_cb.sec_dev_rec); node != end;
-       node = list_next(node)) {
-    tBTM_SEC_DEV_REC* p_dev_rec =
-        static_cast<tBTM_SEC_DEV_REC*>(list_node(node));
+  for (tBTM_SEC_DEV_REC& dev_rec : btm_cb.sec_dev_rec) {
+    tBTM_SEC_DEV_REC* p_dev_rec = &dev_rec;
 
     if ((p_dev_rec->sec_flags &
          (BTM_SEC_LINK_KEY_KNOWN | BTM_SEC_LE_LINK_KEY_KNOWN)) == 0) {
@@ -615,14 +923,15 @@ static tBTM_SEC_DEV_REC* btm_find_oldest_dev_rec(void) {
 tBTM_SEC_DEV_REC* btm_sec_allocate_dev_rec(void) {
   tBTM_SEC_DEV_REC* p_dev_rec = NULL;
 
-  if (list_length(btm_cb.sec_dev_rec) > BTM_SEC_MAX_DEVICE_RECORDS) {
+  if (btm_cb.sec_dev_rec.Size() > BTM_SEC_MAX_DEVICE_RECORDS) {
     p_dev_rec = btm_find_oldest_dev_rec();
-    list_remove(btm_cb.sec_dev_rec, p_dev_rec);
+    btm_sec_dev_rec_remove(p_dev_rec);
   }
 
   p_dev_rec =
       static_cast<tBTM_SEC_DEV_REC*>(osi_calloc(sizeof(tBTM_SEC_DEV_REC)));
-  list_append(btm_cb.sec_dev_rec, p_dev_rec);
+  btm_cb.sec_dev_rec.PushBack(p_dev_rec);
+  btm_sec_dev_rec_reindex(p_dev_rec);
 
   // Initialize defaults
   p_dev_rec->sec_flags = BTM_SEC_IN_USE;
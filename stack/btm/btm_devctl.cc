@@ -166,12 +166,6 @@ static void btm_db_reset(void) {
   }
 }
 
-bool set_sec_state_idle(void* data, void* context) {
-  tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(data);
-  p_dev_rec->sec_state = BTM_SEC_STATE_IDLE;
-  return true;
-}
-
 static void reset_complete(void* result) {
   CHECK(result == FUTURE_SUCCESS);
   const controller_t* controller = controller_get_interface();
@@ -180,7 +174,8 @@ static void reset_complete(void* result) {
   l2cu_device_reset();
 
   /* Clear current security state */
-  list_foreach(btm_cb.sec_dev_rec, set_sec_state_idle, NULL);
+  for (tBTM_SEC_DEV_REC& dev_rec : btm_cb.sec_dev_rec)
+    dev_rec.sec_state = BTM_SEC_STATE_IDLE;
 
   /* After the reset controller should restore all parameters to defaults. */
   btm_cb.btm_inq_vars.inq_counter = 1;
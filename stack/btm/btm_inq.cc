@@ -32,6 +32,7 @@
 #include <string.h>
 
 #include "device/include/controller.h"
+#include "osi/include/footprint.h"
 #include "osi/include/osi.h"
 #include "osi/include/time.h"
 
@@ -1056,7 +1057,7 @@ tBTM_INQ_INFO* BTM_InqDbFirst(void) {
   uint16_t xx;
   tINQ_DB_ENT* p_ent = btm_cb.btm_inq_vars.inq_db;
 
-  for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
+  for (xx = 0; xx < btm_cb.btm_inq_vars.inq_db_high_water; xx++, p_ent++) {
     if (p_ent->in_use) return (&p_ent->inq_info);
   }
 
@@ -1083,8 +1084,8 @@ tBTM_INQ_INFO* BTM_InqDbNext(tBTM_INQ_INFO* p_cur) {
     p_ent = (tINQ_DB_ENT*)((uint8_t*)p_cur - offsetof(tINQ_DB_ENT, inq_info));
     inx = (uint16_t)((p_ent - btm_cb.btm_inq_vars.inq_db) + 1);
 
-    for (p_ent = &btm_cb.btm_inq_vars.inq_db[inx]; inx < BTM_INQ_DB_SIZE;
-         inx++, p_ent++) {
+    for (p_ent = &btm_cb.btm_inq_vars.inq_db[inx];
+         inx < btm_cb.btm_inq_vars.inq_db_high_water; inx++, p_ent++) {
       if (p_ent->in_use) return (&p_ent->inq_info);
     }
 
@@ -1242,10 +1243,23 @@ void btm_inq_db_init(void) {
   btm_cb.btm_inq_vars.remote_name_timer =
       alarm_new("btm_inq.remote_name_timer");
   btm_cb.btm_inq_vars.no_inc_ssp = BTM_NO_SSP_ON_INQUIRY;
+  btm_cb.btm_inq_vars.inq_db_max = footprint_pool_entries(
+      "inq_db", BTM_INQ_DB_SIZE, BTM_INQ_DB_LOW_MEMORY_SIZE);
 }
 
 void btm_inq_db_free(void) {
-  alarm_free(btm_cb.btm_inq_vars.remote_name_timer);
+  tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
+
+  alarm_free(p_inq->remote_name_timer);
+
+  osi_free_and_reset((void**)&p_inq->inq_db);
+  memset(p_inq->inq_db_hash, 0, sizeof(p_inq->inq_db_hash));
+  p_inq->inq_db_free = 0;
+  p_inq->inq_db_high_water = 0;
+  p_inq->inq_db_oldest = 0;
+  p_inq->inq_db_newest = 0;
+  p_inq->inq_db_keep_count = 0;
+  footprint_set("btm", "inq_db", 0);
 }
 
 /*******************************************************************************
@@ -1318,13 +1332,12 @@ void btm_clr_inq_db(const RawAddress* p_bda) {
   BTM_TRACE_DEBUG("btm_clr_inq_db: inq_active:0x%x state:%d",
                   btm_cb.btm_inq_vars.inq_active, btm_cb.btm_inq_vars.state);
 #endif
-  for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
-    if (p_ent->in_use) {
-      /* If this is the specified BD_ADDR or clearing all devices */
-      if (p_bda == NULL || (p_ent->inq_info.results.remote_bd_addr == *p_bda)) {
-        p_ent->in_use = false;
-      }
-    }
+  if (p_bda != NULL) {
+    p_ent = btm_inq_db_find(*p_bda);
+    if (p_ent) btm_inq_db_remove(p_ent);
+  } else {
+    for (xx = 0; xx < p_inq->inq_db_high_water; xx++, p_ent++)
+      btm_inq_db_remove(p_ent);
   }
 #if (BTM_INQ_DEBUG == TRUE)
   BTM_TRACE_DEBUG("inq_active:0x%x state:%d", btm_cb.btm_inq_vars.inq_active,
@@ -1386,6 +1399,46 @@ bool btm_inq_find_bdaddr(const RawAddress& p_bda, tBT_DEVICE_TYPE p_dev_type) {
   return (false);
 }
 
+static_assert((BTM_INQ_DB_HASH_SIZE & (BTM_INQ_DB_HASH_SIZE - 1)) == 0,
+              "BTM_INQ_DB_HASH_SIZE must be a power of two");
+static_assert(BTM_INQ_DB_SIZE < UINT16_MAX,
+              "BTM_INQ_DB_SIZE does not fit the inquiry database links");
+
+/* Returns the entry |link| refers to, or NULL for the end of a list */
+static tINQ_DB_ENT* btm_inq_db_entry(uint16_t link) {
+  return link ? &btm_cb.btm_inq_vars.inq_db[link - 1] : NULL;
+}
+
+static uint16_t btm_inq_db_link(const tINQ_DB_ENT* p_ent) {
+  return (uint16_t)(p_ent - btm_cb.btm_inq_vars.inq_db + 1);
+}
+
+static uint16_t* btm_inq_db_bucket(const RawAddress& bda) {
+  uint32_t hash = 0;
+  for (size_t i = 0; i < RawAddress::kLength; i++)
+    hash = hash * 31 + bda.address[i];
+  return &btm_cb.btm_inq_vars.inq_db_hash[hash & (BTM_INQ_DB_HASH_SIZE - 1)];
+}
+
+static void btm_inq_db_age_unlink(tINQ_DB_ENT* p_ent) {
+  tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
+  tINQ_DB_ENT* p_prev = btm_inq_db_entry(p_ent->age_prev);
+  tINQ_DB_ENT* p_next = btm_inq_db_entry(p_ent->age_next);
+
+  if (p_prev)
+    p_prev->age_next = p_ent->age_next;
+  else
+    p_inq->inq_db_oldest = p_ent->age_next;
+
+  if (p_next)
+    p_next->age_prev = p_ent->age_prev;
+  else
+    p_inq->inq_db_newest = p_ent->age_prev;
+
+  p_ent->age_prev = 0;
+  p_ent->age_next = 0;
+}
+
 /*******************************************************************************
  *
  * Function         btm_inq_db_find
@@ -1397,77 +1450,135 @@ bool btm_inq_find_bdaddr(const RawAddress& p_bda, tBT_DEVICE_TYPE p_dev_type) {
  *
  ******************************************************************************/
 tINQ_DB_ENT* btm_inq_db_find(const RawAddress& p_bda) {
-  uint16_t xx;
-  tINQ_DB_ENT* p_ent = btm_cb.btm_inq_vars.inq_db;
+  tINQ_DB_ENT* p_ent;
 
-  for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
-    if (p_ent->in_use && p_ent->inq_info.results.remote_bd_addr == p_bda)
-      return (p_ent);
+  for (uint16_t link = *btm_inq_db_bucket(p_bda); link;
+       link = p_ent->hash_next) {
+    p_ent = btm_inq_db_entry(link);
+    if (p_ent->inq_info.results.remote_bd_addr == p_bda) return (p_ent);
   }
 
   /* If here, not found */
   return (NULL);
 }
 
+/*******************************************************************************
+ *
+ * Function         btm_inq_db_touch
+ *
+ * Description      This function records that a response was just received
+ *                  for the in-use entry |p_ent|, making it the last one to be
+ *                  reused by btm_inq_db_new.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_inq_db_touch(tINQ_DB_ENT* p_ent) {
+  tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
+
+  p_ent->time_of_resp = time_get_os_boottime_ms();
+
+  btm_inq_db_age_unlink(p_ent);
+  p_ent->age_prev = p_inq->inq_db_newest;
+  if (p_inq->inq_db_newest)
+    btm_inq_db_entry(p_inq->inq_db_newest)->age_next = btm_inq_db_link(p_ent);
+  else
+    p_inq->inq_db_oldest = btm_inq_db_link(p_ent);
+  p_inq->inq_db_newest = btm_inq_db_link(p_ent);
+}
+
+/*******************************************************************************
+ *
+ * Function         btm_inq_db_remove
+ *
+ * Description      This function releases the inquiry database entry |p_ent|.
+ *                  Entries that are not in use are ignored.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void btm_inq_db_remove(tINQ_DB_ENT* p_ent) {
+  tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
+
+  if (!p_ent->in_use) return;
+
+  uint16_t link = btm_inq_db_link(p_ent);
+  uint16_t* p_link = btm_inq_db_bucket(p_ent->inq_info.results.remote_bd_addr);
+  while (*p_link != link) p_link = &btm_inq_db_entry(*p_link)->hash_next;
+  *p_link = p_ent->hash_next;
+
+  btm_inq_db_age_unlink(p_ent);
+  if (p_ent->keep) p_inq->inq_db_keep_count--;
+
+  p_ent->in_use = false;
+  p_ent->hash_next = p_inq->inq_db_free;
+  p_inq->inq_db_free = link;
+}
+
 /*******************************************************************************
  *
  * Function         btm_inq_db_new
  *
- * Description      This function looks through the inquiry database for an
- *                  unused entry. If no entry is free, it allocates the oldest
- *                  entry.
+ * Description      This function takes an unused entry from the inquiry
+ *                  database. If no entry is free, it reuses the one with the
+ *                  oldest response that is not kept.
  *
  * Returns          pointer to entry
  *
  ******************************************************************************/
 tINQ_DB_ENT* btm_inq_db_new(const RawAddress& p_bda, bool keep) {
-  uint16_t xx;
-  tINQ_DB_ENT* p_ent = btm_cb.btm_inq_vars.inq_db;
-  tINQ_DB_ENT* p_old = btm_cb.btm_inq_vars.inq_db;
-  uint32_t ot = 0xFFFFFFFF;
-  uint8_t keep_counter = 0;
-
-  for (xx = 0; xx < BTM_INQ_DB_SIZE; xx++, p_ent++) {
-    if (!p_ent->in_use) {
-      memset(p_ent, 0, sizeof(tINQ_DB_ENT));
-      p_ent->inq_info.results.remote_bd_addr = p_bda;
-      p_ent->in_use = true;
-      /* The keep flag is set as true only for the first 4 HID devices */
-      if (keep_counter < BTM_INQ_DB_HID_KEEP_MAX)
-        p_ent->keep = keep;
-      else
-        p_ent->keep = false;
-
-      return (p_ent);
-    }
+  tBTM_INQUIRY_VAR_ST* p_inq = &btm_cb.btm_inq_vars;
+  tINQ_DB_ENT* p_ent;
 
-    if (p_ent->keep) {
-      keep_counter++;
-    }
+  if (p_inq->inq_db == NULL) {
+    p_inq->inq_db =
+        (tINQ_DB_ENT*)osi_calloc(p_inq->inq_db_max * sizeof(tINQ_DB_ENT));
+    footprint_set("btm", "inq_db", p_inq->inq_db_max * sizeof(tINQ_DB_ENT));
+  }
 
-    if (p_ent->time_of_resp < ot) {
-      if (p_ent->keep) {
-        LOG(INFO) << __func__ << ": keep "
-                  << p_ent->inq_info.results.remote_bd_addr;
-      } else {
+  if (!p_inq->inq_db_free && p_inq->inq_db_high_water == p_inq->inq_db_max) {
+    /* If here, no free entry found. Reuse the oldest. */
+    tINQ_DB_ENT* p_old = btm_inq_db_entry(p_inq->inq_db_oldest);
+    for (p_ent = p_old; p_ent; p_ent = btm_inq_db_entry(p_ent->age_next)) {
+      if (!p_ent->keep) {
         p_old = p_ent;
-        ot = p_ent->time_of_resp;
+        break;
       }
+      LOG(INFO) << __func__ << ": keep "
+                << p_ent->inq_info.results.remote_bd_addr;
     }
+    btm_inq_db_remove(p_old);
   }
 
-  /* If here, no free entry found. Return the oldest. */
+  if (p_inq->inq_db_free) {
+    p_ent = btm_inq_db_entry(p_inq->inq_db_free);
+    p_inq->inq_db_free = p_ent->hash_next;
+  } else {
+    p_ent = &p_inq->inq_db[p_inq->inq_db_high_water++];
+  }
 
-  memset(p_old, 0, sizeof(tINQ_DB_ENT));
-  p_old->inq_info.results.remote_bd_addr = p_bda;
-  p_old->in_use = true;
+  memset(p_ent, 0, sizeof(tINQ_DB_ENT));
+  p_ent->inq_info.results.remote_bd_addr = p_bda;
+  p_ent->in_use = true;
   /* The keep flag is set as true only for the first 4 HID devices */
-  if (keep_counter < BTM_INQ_DB_HID_KEEP_MAX)
-    p_old->keep = keep;
+  if (keep && p_inq->inq_db_keep_count < BTM_INQ_DB_HID_KEEP_MAX) {
+    p_ent->keep = true;
+    p_inq->inq_db_keep_count++;
+  }
+
+  uint16_t* p_bucket = btm_inq_db_bucket(p_bda);
+  p_ent->hash_next = *p_bucket;
+  *p_bucket = btm_inq_db_link(p_ent);
+
+  /* Until a response is recorded the entry counts as the oldest one */
+  p_ent->age_next = p_inq->inq_db_oldest;
+  if (p_inq->inq_db_oldest)
+    btm_inq_db_entry(p_inq->inq_db_oldest)->age_prev = btm_inq_db_link(p_ent);
   else
-    p_old->keep = false;
+    p_inq->inq_db_newest = btm_inq_db_link(p_ent);
+  p_inq->inq_db_oldest = btm_inq_db_link(p_ent);
 
-  return (p_old);
+  return (p_ent);
 }
 
 /*******************************************************************************
@@ -1684,9 +1795,10 @@ static void btm_initiate_inquiry(tBTM_INQUIRY_VAR_ST* p_inq) {
 
   /* Make sure the number of responses doesn't overflow the database
    * configuration */
-  p_inqparms->max_resps = (uint8_t)((p_inqparms->max_resps <= BTM_INQ_DB_SIZE)
-                                        ? p_inqparms->max_resps
-                                        : BTM_INQ_DB_SIZE);
+  p_inqparms->max_resps =
+      (uint8_t)((p_inqparms->max_resps <= p_inq->inq_db_max)
+                    ? p_inqparms->max_resps
+                    : p_inq->inq_db_max);
 
   lap = (p_inq->inq_active & BTM_LIMITED_INQUIRY_ACTIVE) ? &limited_inq_lap
                                                          : &general_inq_lap;
@@ -1895,7 +2007,7 @@ void btm_process_inq_results(uint8_t* p, uint8_t hci_evt_len,
       BTM_TRACE_WARNING ("btm_process_inq_results: Dev class: %02x-%02x-%02x",
                   p_cur->dev_class[0], p_cur->dev_class[1], p_cur->dev_class[2]);
 
-      p_i->time_of_resp = time_get_os_boottime_ms();
+      btm_inq_db_touch(p_i);
 
       if (p_i->inq_count != p_inq->inq_counter)
         p_inq->inq_cmpl_info.num_resp++; /* A new response was found */
@@ -1964,9 +2076,10 @@ void btm_sort_inq_result(void) {
   int size;
   tINQ_DB_ENT* p_tmp = (tINQ_DB_ENT*)osi_malloc(sizeof(tINQ_DB_ENT));
 
-  num_resp = (btm_cb.btm_inq_vars.inq_cmpl_info.num_resp < BTM_INQ_DB_SIZE)
+  num_resp = (btm_cb.btm_inq_vars.inq_cmpl_info.num_resp <
+              btm_cb.btm_inq_vars.inq_db_high_water)
                  ? btm_cb.btm_inq_vars.inq_cmpl_info.num_resp
-                 : BTM_INQ_DB_SIZE;
+                 : btm_cb.btm_inq_vars.inq_db_high_water;
 
   size = sizeof(tINQ_DB_ENT);
   for (xx = 0; xx < num_resp - 1; xx++, p_ent++) {
@@ -74,6 +74,8 @@ extern void btm_event_filter_complete(uint8_t* p);
 extern void btm_inq_stop_on_ssp(void);
 extern void btm_inq_clear_ssp(void);
 extern tINQ_DB_ENT* btm_inq_db_find(const RawAddress& p_bda);
+extern void btm_inq_db_touch(tINQ_DB_ENT* p_ent);
+extern void btm_inq_db_remove(tINQ_DB_ENT* p_ent);
 extern bool btm_inq_find_bdaddr(const RawAddress& p_bda, tBT_DEVICE_TYPE p_dev_type);
 
 /* Internal functions provided by btm_acl.cc
@@ -93,6 +95,8 @@ extern void btm_cont_rswitch(tACL_CONN* p, tBTM_SEC_DEV_REC* p_dev_rec,
 extern uint8_t btm_handle_to_acl_index(uint16_t hci_handle);
 extern void btm_read_link_policy_complete(uint8_t* p);
 
+extern void btm_ble_phy_policy_link_quality(uint16_t hci_handle, int8_t rssi);
+
 extern void btm_read_rssi_timeout(void* data);
 extern void btm_read_rssi_complete(uint8_t* p, uint16_t evt_len);
 
@@ -222,6 +226,12 @@ extern void btm_sec_free_dev(tBTM_SEC_DEV_REC* p_dev_rec);
 extern tBTM_SEC_DEV_REC* btm_find_dev(const RawAddress& bd_addr);
 extern tBTM_SEC_DEV_REC* btm_find_or_alloc_dev(const RawAddress& bd_addr);
 extern tBTM_SEC_DEV_REC* btm_find_dev_by_handle(uint16_t handle);
+extern void btm_sec_dev_rec_reindex(tBTM_SEC_DEV_REC* p_dev_rec);
+extern void btm_sec_load_conn_profile(tBTM_SEC_DEV_REC* p_dev_rec);
+extern void btm_sec_dev_rec_unindex(const tBTM_SEC_DEV_REC* p_dev_rec);
+extern void btm_sec_dev_rec_remove(tBTM_SEC_DEV_REC* p_dev_rec);
+extern tBTM_SEC_DEV_REC* btm_find_dev_by_identity_addr_index(
+    const RawAddress& bd_addr);
 extern tBTM_BOND_TYPE btm_get_bond_type_dev(const RawAddress& bd_addr);
 extern bool btm_set_bond_type_dev(const RawAddress& bd_addr,
                                   tBTM_BOND_TYPE bond_type);
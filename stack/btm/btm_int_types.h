@@ -28,6 +28,7 @@
 #include "btm_ble_int_types.h"
 #include "hcidefs.h"
 #include "osi/include/alarm.h"
+#include "osi/include/intrusive_list.h"
 #include "osi/include/list.h"
 #include "rfcdefs.h"
 
@@ -124,6 +125,13 @@ typedef struct {
   /* available when qll_features_state is BTM_QLL_FEATURES_STATE_FEATURE_COMPLETE */
   BD_FEATURES remote_qll_features;
 
+  /* LE PHY state kept by btm_ble_phy_policy.cc */
+  uint8_t ble_tx_phy;      /* PHY_LE_*, 0 until a PHY update is seen */
+  uint8_t ble_rx_phy;
+  uint8_t ble_phy_target;  /* PHY last requested by the policy */
+  int8_t ble_phy_votes;    /* consecutive reports voting up (>0) or down */
+  bool ble_phy_app_set;    /* an app chose the PHY, the policy stays out */
+
 } tACL_CONN;
 
 /* Define the Device Management control structure
@@ -257,6 +265,10 @@ typedef struct {
   bool in_use;
   bool scan_rsp;
   bool keep; /* keep the devices in the inquriy database to get the name */
+  /* Links into the database, as index + 1 into inq_db with 0 ending a list */
+  uint16_t hash_next; /* next entry in the address bucket or the free list */
+  uint16_t age_prev;  /* next older entry */
+  uint16_t age_next;  /* next newer entry */
 } tINQ_DB_ENT;
 
 enum { INQ_NONE, INQ_LE_OBSERVE, INQ_GENERAL };
@@ -300,7 +312,19 @@ typedef struct {
   tINQ_BDADDR* p_bd_db;    /* Pointer to memory that holds bdaddrs */
   uint16_t num_bd_entries; /* Number of entries in database */
   uint16_t max_bd_entries; /* Maximum number of entries that can be stored */
-  tINQ_DB_ENT inq_db[BTM_INQ_DB_SIZE];
+  /* Allocated for inq_db_max entries on first use, see btm_inq_db_new */
+  tINQ_DB_ENT* inq_db;
+  uint16_t inq_db_max;
+  /* Index of inq_db. Entries are found through buckets hashed by address and
+   * kept on an age list from the oldest to the most recent response, so that
+   * neither lookup nor eviction has to walk inq_db. All links are index + 1,
+   * 0 meaning none; inq_db itself keeps its order for BTM_InqDbFirst/Next. */
+  uint16_t inq_db_hash[BTM_INQ_DB_HASH_SIZE];
+  uint16_t inq_db_free;       /* released entries, linked through hash_next */
+  uint16_t inq_db_high_water; /* entries from here on were never used */
+  uint16_t inq_db_oldest;
+  uint16_t inq_db_newest;
+  uint16_t inq_db_keep_count; /* entries in use with the keep flag set */
   tBTM_INQ_PARMS inqparms; /* Contains the parameters for the current inquiry */
   tBTM_INQUIRY_CMPL
       inq_cmpl_info; /* Status and number of responses from the last inquiry */
@@ -519,7 +543,9 @@ typedef uint8_t tBTM_BOND_TYPE;
  * Define structure for Security Device Record.
  * A record exists for each device authenticated with this device
 */
-typedef struct {
+typedef struct tBTM_SEC_DEV_REC {
+  /* links in btm_cb.sec_dev_rec, kept by btm_consolidate_dev */
+  system_bt_osi::IntrusiveListHook<tBTM_SEC_DEV_REC> list_hook;
   tBTM_SEC_SERV_REC* p_cur_service;
   tBTM_SEC_CALLBACK* p_callback;
   void* p_ref_data;
@@ -562,6 +588,11 @@ typedef struct {
   BD_FEATURES feature_pages[HCI_EXT_FEATURES_PAGE_MAX +
                             1]; /* Features supported by the device */
   uint8_t num_read_pages;
+  bool conn_profile_loaded; /* the profile loader was asked for the device */
+  bool rmt_version_known;   /* the version below is valid */
+  uint8_t lmp_version;
+  uint16_t manufacturer;
+  uint16_t lmp_subversion;
 
 #define BTM_SEC_STATE_IDLE 0
 #define BTM_SEC_STATE_AUTHENTICATING 1
@@ -904,7 +935,9 @@ typedef struct {
   uint16_t disc_handle;             /* for legacy devices */
   uint8_t disc_reason;              /* for legacy devices */
   tBTM_SEC_SERV_REC sec_serv_rec[BTM_SEC_MAX_SERVICE_RECORDS];
-  list_t* sec_dev_rec; /* list of tBTM_SEC_DEV_REC */
+  /* oldest first */
+  system_bt_osi::IntrusiveList<tBTM_SEC_DEV_REC, &tBTM_SEC_DEV_REC::list_hook>
+      sec_dev_rec;
   tBTM_SEC_SERV_REC* p_out_serv;
   tBTM_MKEY_CALLBACK* mkey_cback;
 
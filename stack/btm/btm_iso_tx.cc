@@ -0,0 +1,500 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_btm_iso_tx"
+
+#include "btm_iso_tx.h"
+
+#include <base/bind.h>
+#include <base/logging.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <mutex>
+
+#include "bt_common.h"
+#include "device/include/controller.h"
+#include "hcidefs.h"
+#include "hcimsgs.h"
+#include "osi/include/alarm.h"
+#include "osi/include/osi.h"
+#include "osi/include/time.h"
+
+// Buffers kept ready for each BIS, and SDUs it may have queued ahead.
+#define BTM_ISO_TX_POOL_DEPTH 4
+#define BTM_ISO_TX_MAX_QUEUED 8
+
+// Transmit timestamp requests before a BIS settles for sequence numbers.
+#define BTM_ISO_TX_SYNC_ATTEMPTS 3
+
+// HCI ISO data packet
+#define ISO_PB_FIRST_FRAGMENT 0x00
+#define ISO_PB_CONTINUATION 0x01
+#define ISO_PB_COMPLETE_SDU 0x02
+#define ISO_PB_LAST_FRAGMENT 0x03
+#define ISO_TS_FLAG 0x4000
+#define ISO_HDR_SIZE 4
+#define ISO_TS_SIZE 4
+#define ISO_SDU_HDR_SIZE 4
+#define ISO_SDU_LENGTH_MASK 0x0FFF
+
+static_assert(BTM_ISO_TX_HEADROOM ==
+                  ISO_HDR_SIZE + ISO_TS_SIZE + ISO_SDU_HDR_SIZE,
+              "the headroom holds the largest first fragment header");
+
+typedef struct {
+  uint32_t interval;  // SDU interval since the BIG was created.
+  BT_HDR* p_buf;
+  bool waited;  // Already counted as waiting for controller buffers.
+} iso_tx_sdu_t;
+
+typedef struct {
+  uint16_t handle;
+  std::deque<iso_tx_sdu_t> queue;
+  std::vector<BT_HDR*> pool;
+  uint32_t next_interval;  // Interval the next SDU written goes to.
+  uint32_t last_sent;      // Interval of the last SDU sent.
+  uint16_t unacked;        // Packets the controller has not completed.
+  uint8_t sync_attempts;
+  bool sync_pending;
+  // Controller timestamp of the anchor of interval |ts_ref_interval|.
+  bool ts_synced;
+  uint32_t ts_ref;
+  uint32_t ts_ref_interval;
+  tBTM_ISO_TX_STATS stats;
+} iso_tx_bis_t;
+
+typedef struct {
+  uint8_t big_handle;
+  uint32_t sdu_interval_us;
+  uint16_t max_sdu;
+  uint64_t anchor_us;  // Boottime of the start of interval 0.
+  alarm_t* timer;
+  bool timer_armed;
+  uint32_t timer_interval;  // Interval the timer fires at.
+  std::vector<iso_tx_bis_t> bis;
+} iso_tx_big_t;
+
+static std::mutex iso_lock;
+static std::map<uint8_t, iso_tx_big_t> bigs;
+// Controller ISO buffers, if the controller reports them.
+static bool credits_limited;
+static bool credits_known;
+static uint16_t credits_total;
+static uint16_t credits;
+
+static void btm_iso_tx_interval_timeout(void* data);
+
+static iso_tx_bis_t* find_bis(uint16_t handle, iso_tx_big_t** pp_big) {
+  for (auto& entry : bigs) {
+    for (auto& bis : entry.second.bis) {
+      if (bis.handle != handle) continue;
+      if (pp_big) *pp_big = &entry.second;
+      return &bis;
+    }
+  }
+  return NULL;
+}
+
+static uint32_t current_interval(const iso_tx_big_t& big, uint64_t now_us) {
+  if (now_us < big.anchor_us) return 0;
+  return (now_us - big.anchor_us) / big.sdu_interval_us;
+}
+
+static BT_HDR* alloc_buf(uint16_t sdu_len) {
+  BT_HDR* p_buf =
+      (BT_HDR*)osi_malloc(BT_HDR_SIZE + BTM_ISO_TX_HEADROOM + sdu_len);
+  p_buf->event = 0;
+  p_buf->offset = BTM_ISO_TX_HEADROOM;
+  p_buf->len = 0;
+  p_buf->layer_specific = 0;
+  return p_buf;
+}
+
+static void free_bis(iso_tx_bis_t* p_bis) {
+  for (auto& sdu : p_bis->queue) osi_free(sdu.p_buf);
+  p_bis->queue.clear();
+  for (BT_HDR* p_buf : p_bis->pool) osi_free(p_buf);
+  p_bis->pool.clear();
+}
+
+static void arm_timer(iso_tx_big_t* p_big, uint32_t after_interval,
+                      uint64_t now_us) {
+  bool pending = false;
+  uint32_t next = UINT32_MAX;
+  for (const auto& bis : p_big->bis) {
+    if (bis.queue.empty()) continue;
+    pending = true;
+    next = std::min(next, bis.queue.front().interval);
+  }
+  if (!pending) return;
+
+  next = std::max(next, after_interval + 1);
+  if (p_big->timer_armed && p_big->timer_interval <= next) return;
+
+  uint64_t due_us = p_big->anchor_us + (uint64_t)next * p_big->sdu_interval_us;
+  period_ms_t delay_ms = due_us > now_us ? (due_us - now_us + 999) / 1000 : 0;
+  p_big->timer_armed = true;
+  p_big->timer_interval = next;
+  alarm_set_on_mloop(p_big->timer, delay_ms, btm_iso_tx_interval_timeout,
+                     UINT_TO_PTR(p_big->big_handle));
+}
+
+static void btm_iso_tx_sync_cmpl(uint8_t* param, uint16_t param_len) {
+  uint8_t status;
+  uint16_t handle;
+  uint16_t seq;
+  uint32_t time_stamp;
+
+  if (param_len < 3) {
+    LOG(WARNING) << __func__ << ": insufficient return parameters";
+    return;
+  }
+  STREAM_TO_UINT8(status, param);
+  STREAM_TO_UINT16(handle, param);
+
+  std::lock_guard<std::mutex> lock(iso_lock);
+  iso_tx_bis_t* p_bis = find_bis(handle, NULL);
+  if (p_bis == NULL) return;
+  p_bis->sync_pending = false;
+
+  if (status != HCI_SUCCESS || param_len < 9) {
+    VLOG(1) << __func__ << ": BIS " << loghex(handle)
+            << " no transmit sync, status " << loghex(status);
+    return;
+  }
+  STREAM_TO_UINT16(seq, param);
+  STREAM_TO_UINT32(time_stamp, param);
+
+  // The sequence number is that of an SDU we sent; the newest interval with
+  // the same low bits is the one it was sent for
+  p_bis->ts_ref_interval =
+      p_bis->last_sent - (uint16_t)((uint16_t)p_bis->last_sent - seq);
+  p_bis->ts_ref = time_stamp;
+  p_bis->ts_synced = true;
+  VLOG(1) << __func__ << ": BIS " << loghex(handle) << " interval "
+          << p_bis->ts_ref_interval << " at " << time_stamp;
+}
+
+// Hands |p_sdu| to HCI, fragmented if it does not fit in one ISO data
+// packet. The first fragment is built in the SDU's own buffer.
+static bool send_sdu(const iso_tx_big_t& big, iso_tx_bis_t* p_bis,
+                     iso_tx_sdu_t* p_sdu) {
+  BT_HDR* p_buf = p_sdu->p_buf;
+  uint16_t sdu_len = p_buf->len;
+  uint16_t sdu_hdr = (p_bis->ts_synced ? ISO_TS_SIZE : 0) + ISO_SDU_HDR_SIZE;
+  uint16_t max_load = controller_get_interface()->get_ble_iso_data_packet_len();
+  if (max_load <= sdu_hdr) max_load = sdu_hdr + sdu_len;
+
+  uint16_t first_len = std::min<uint16_t>(sdu_len, max_load - sdu_hdr);
+  uint16_t num_packets = 1 + (sdu_len - first_len + max_load - 1) / max_load;
+  if (credits_limited && credits < num_packets) return false;
+
+  if (p_buf->offset < ISO_HDR_SIZE + sdu_hdr) {
+    // Not one of our buffers; make room for the header
+    BT_HDR* p_copy = alloc_buf(sdu_len);
+    memcpy((uint8_t*)(p_copy + 1) + p_copy->offset,
+           (uint8_t*)(p_buf + 1) + p_buf->offset, sdu_len);
+    p_copy->len = sdu_len;
+    osi_free(p_buf);
+    p_buf = p_copy;
+  }
+
+  const uint8_t* p_data = (uint8_t*)(p_buf + 1) + p_buf->offset;
+  std::vector<BT_HDR*> fragments;
+  for (uint16_t pos = first_len; pos < sdu_len;) {
+    uint16_t len = std::min<uint16_t>(max_load, sdu_len - pos);
+    BT_HDR* p_frag = (BT_HDR*)osi_malloc(BT_HDR_SIZE + ISO_HDR_SIZE + len);
+    uint8_t* p = (uint8_t*)(p_frag + 1);
+    uint16_t pb = (pos + len < sdu_len) ? ISO_PB_CONTINUATION
+                                        : ISO_PB_LAST_FRAGMENT;
+    p_frag->offset = 0;
+    p_frag->len = ISO_HDR_SIZE + len;
+    p_frag->layer_specific = 0;
+    UINT16_TO_STREAM(p, p_bis->handle | (pb << 12));
+    UINT16_TO_STREAM(p, len);
+    memcpy(p, p_data + pos, len);
+    fragments.push_back(p_frag);
+    pos += len;
+  }
+
+  uint16_t pb = fragments.empty() ? ISO_PB_COMPLETE_SDU : ISO_PB_FIRST_FRAGMENT;
+  p_buf->offset -= ISO_HDR_SIZE + sdu_hdr;
+  p_buf->len = ISO_HDR_SIZE + sdu_hdr + first_len;
+  uint8_t* p = (uint8_t*)(p_buf + 1) + p_buf->offset;
+  UINT16_TO_STREAM(p, p_bis->handle | (pb << 12) |
+                          (p_bis->ts_synced ? ISO_TS_FLAG : 0));
+  UINT16_TO_STREAM(p, sdu_hdr + first_len);
+  if (p_bis->ts_synced) {
+    UINT32_TO_STREAM(p, p_bis->ts_ref + (p_sdu->interval -
+                                         p_bis->ts_ref_interval) *
+                                            big.sdu_interval_us);
+  }
+  UINT16_TO_STREAM(p, (uint16_t)p_sdu->interval);
+  UINT16_TO_STREAM(p, sdu_len & ISO_SDU_LENGTH_MASK);
+
+  uint16_t event = BT_EVT_TO_LM_HCI_ISO | LOCAL_BLE_CONTROLLER_ID;
+  bte_main_hci_send(p_buf, event);
+  for (BT_HDR* p_frag : fragments) bte_main_hci_send(p_frag, event);
+
+  if (credits_limited) credits -= num_packets;
+  p_bis->unacked += num_packets;
+  p_bis->last_sent = p_sdu->interval;
+  p_bis->stats.sdus_sent++;
+
+  if (!p_bis->ts_synced && !p_bis->sync_pending &&
+      p_bis->sync_attempts < BTM_ISO_TX_SYNC_ATTEMPTS) {
+    p_bis->sync_pending = true;
+    p_bis->sync_attempts++;
+    btsnd_hcic_ble_read_iso_tx_sync(p_bis->handle,
+                                    base::Bind(&btm_iso_tx_sync_cmpl));
+  }
+  return true;
+}
+
+// Drops the SDUs whose interval passed and sends those due in |interval|,
+// for all the BISes of the BIG in one pass.
+static void send_due(iso_tx_big_t* p_big, uint32_t interval) {
+  for (auto& bis : p_big->bis) {
+    while (!bis.queue.empty() && bis.queue.front().interval < interval) {
+      osi_free(bis.queue.front().p_buf);
+      bis.queue.pop_front();
+      bis.stats.late_drops++;
+    }
+  }
+
+  for (auto& bis : p_big->bis) {
+    if (bis.queue.empty() || bis.queue.front().interval != interval) continue;
+
+    iso_tx_sdu_t* p_sdu = &bis.queue.front();
+    if (send_sdu(*p_big, &bis, p_sdu)) {
+      bis.queue.pop_front();
+    } else if (!p_sdu->waited) {
+      p_sdu->waited = true;
+      bis.stats.credit_waits++;
+    }
+  }
+}
+
+static void btm_iso_tx_interval_timeout(void* data) {
+  uint8_t big_handle = PTR_TO_UINT(data);
+  std::lock_guard<std::mutex> lock(iso_lock);
+  auto it = bigs.find(big_handle);
+  if (it == bigs.end()) return;
+
+  iso_tx_big_t* p_big = &it->second;
+  p_big->timer_armed = false;
+
+  uint64_t now_us = time_get_os_boottime_us();
+  uint32_t interval = current_interval(*p_big, now_us);
+  uint64_t due_us =
+      p_big->anchor_us + (uint64_t)p_big->timer_interval * p_big->sdu_interval_us;
+  uint32_t lateness_us = now_us > due_us ? now_us - due_us : 0;
+
+  for (auto& bis : p_big->bis) {
+    if (bis.queue.empty()) continue;
+    bis.stats.max_tick_lateness_us =
+        std::max(bis.stats.max_tick_lateness_us, lateness_us);
+  }
+
+  send_due(p_big, interval);
+
+  // Replace the buffers handed to HCI away from the producers' path
+  for (auto& bis : p_big->bis) {
+    while (bis.pool.size() < BTM_ISO_TX_POOL_DEPTH)
+      bis.pool.push_back(alloc_buf(p_big->max_sdu));
+  }
+
+  arm_timer(p_big, interval, now_us);
+}
+
+void btm_iso_tx_big_created(uint8_t big_handle, uint32_t sdu_interval_us,
+                            uint16_t max_sdu,
+                            const std::vector<uint16_t>& bis_handles) {
+  if (sdu_interval_us == 0 || bis_handles.empty()) return;
+
+  btm_iso_tx_big_terminated(big_handle);
+
+  std::lock_guard<std::mutex> lock(iso_lock);
+  if (!credits_known) {
+    credits_known = true;
+    credits_total = controller_get_interface()->get_ble_iso_num_data_packets();
+    credits_limited = credits_total != 0;
+    credits = credits_total;
+  }
+
+  iso_tx_big_t* p_big = &bigs[big_handle];
+  p_big->big_handle = big_handle;
+  p_big->sdu_interval_us = sdu_interval_us;
+  p_big->max_sdu = max_sdu;
+  p_big->anchor_us = time_get_os_boottime_us();
+  p_big->timer = alarm_new("btm_iso_tx.interval_timer");
+  p_big->timer_armed = false;
+  p_big->timer_interval = 0;
+  p_big->bis.resize(bis_handles.size());
+  for (size_t i = 0; i < bis_handles.size(); i++) {
+    iso_tx_bis_t* p_bis = &p_big->bis[i];
+    p_bis->handle = bis_handles[i];
+    p_bis->next_interval = 0;
+    p_bis->last_sent = 0;
+    p_bis->unacked = 0;
+    p_bis->sync_attempts = 0;
+    p_bis->sync_pending = false;
+    p_bis->ts_synced = false;
+    memset(&p_bis->stats, 0, sizeof(p_bis->stats));
+    for (int j = 0; j < BTM_ISO_TX_POOL_DEPTH; j++)
+      p_bis->pool.push_back(alloc_buf(max_sdu));
+  }
+
+  LOG(INFO) << __func__ << ": BIG " << +big_handle << " " << bis_handles.size()
+            << " BIS, SDU interval " << sdu_interval_us << " us, max SDU "
+            << max_sdu;
+}
+
+void btm_iso_tx_big_terminated(uint8_t big_handle) {
+  alarm_t* timer;
+  {
+    std::lock_guard<std::mutex> lock(iso_lock);
+    auto it = bigs.find(big_handle);
+    if (it == bigs.end()) return;
+
+    // The controller drops what it still held for the BISes
+    for (auto& bis : it->second.bis) {
+      if (credits_limited)
+        credits = std::min<uint16_t>(credits + bis.unacked, credits_total);
+      free_bis(&bis);
+    }
+    timer = it->second.timer;
+    bigs.erase(it);
+  }
+
+  // Outside the lock, a running timeout may be waiting for it
+  alarm_free(timer);
+}
+
+BT_HDR* btm_iso_tx_get_buf(uint16_t bis_handle) {
+  std::lock_guard<std::mutex> lock(iso_lock);
+  iso_tx_big_t* p_big;
+  iso_tx_bis_t* p_bis = find_bis(bis_handle, &p_big);
+  if (p_bis == NULL) return NULL;
+
+  if (p_bis->pool.empty()) {
+    p_bis->stats.pool_misses++;
+    return alloc_buf(p_big->max_sdu);
+  }
+
+  BT_HDR* p_buf = p_bis->pool.back();
+  p_bis->pool.pop_back();
+  p_buf->offset = BTM_ISO_TX_HEADROOM;
+  p_buf->len = 0;
+  return p_buf;
+}
+
+bool btm_iso_tx_write(uint16_t bis_handle, BT_HDR* p_sdu) {
+  std::lock_guard<std::mutex> lock(iso_lock);
+  iso_tx_big_t* p_big;
+  iso_tx_bis_t* p_bis = find_bis(bis_handle, &p_big);
+  if (p_bis == NULL || p_sdu->len > p_big->max_sdu) {
+    LOG(WARNING) << __func__ << ": dropping SDU of " << p_sdu->len
+                 << " bytes for BIS " << loghex(bis_handle);
+    osi_free(p_sdu);
+    return false;
+  }
+
+  if (p_bis->queue.size() >= BTM_ISO_TX_MAX_QUEUED) {
+    p_bis->stats.overflows++;
+    osi_free(p_sdu);
+    return false;
+  }
+
+  uint64_t now_us = time_get_os_boottime_us();
+  uint32_t interval = current_interval(*p_big, now_us);
+  if (p_bis->next_interval <= interval) {
+    if (p_bis->stats.sdus_queued != 0) p_bis->stats.underruns++;
+    p_bis->next_interval = interval + 1;
+  }
+
+  p_bis->queue.push_back({p_bis->next_interval++, p_sdu, false});
+  p_bis->stats.sdus_queued++;
+
+  arm_timer(p_big, interval, now_us);
+  return true;
+}
+
+bool btm_iso_tx_packets_completed(uint16_t handle, uint16_t num_packets) {
+  std::lock_guard<std::mutex> lock(iso_lock);
+  iso_tx_bis_t* p_bis = find_bis(handle, NULL);
+  if (p_bis == NULL) return false;
+
+  num_packets = std::min(num_packets, p_bis->unacked);
+  p_bis->unacked -= num_packets;
+  if (credits_limited)
+    credits = std::min<uint16_t>(credits + num_packets, credits_total);
+  return true;
+}
+
+void btm_iso_tx_service(void) {
+  std::lock_guard<std::mutex> lock(iso_lock);
+  uint64_t now_us = time_get_os_boottime_us();
+  for (auto& entry : bigs) {
+    send_due(&entry.second, current_interval(entry.second, now_us));
+  }
+}
+
+bool btm_iso_tx_get_stats(uint16_t bis_handle, tBTM_ISO_TX_STATS* p_stats) {
+  std::lock_guard<std::mutex> lock(iso_lock);
+  iso_tx_bis_t* p_bis = find_bis(bis_handle, NULL);
+  if (p_bis == NULL) return false;
+
+  *p_stats = p_bis->stats;
+  return true;
+}
+
+void btm_iso_tx_debug_dump(int fd) {
+  std::lock_guard<std::mutex> lock(iso_lock);
+  if (bigs.empty()) return;
+
+  dprintf(fd, "\nISO Broadcast TX:\n");
+  if (credits_limited)
+    dprintf(fd, "  Controller buffers: %u of %u free\n", credits,
+            credits_total);
+  for (const auto& entry : bigs) {
+    const iso_tx_big_t& big = entry.second;
+    dprintf(fd, "  BIG %u: SDU interval %u us, max SDU %u\n", entry.first,
+            big.sdu_interval_us, big.max_sdu);
+    for (const auto& bis : big.bis) {
+      const tBTM_ISO_TX_STATS& stats = bis.stats;
+      dprintf(fd,
+              "    BIS 0x%04x: queued %zu  pooled %zu  unacked %u  "
+              "timestamps %s\n",
+              bis.handle, bis.queue.size(), bis.pool.size(), bis.unacked,
+              bis.ts_synced ? "yes" : "no");
+      dprintf(fd,
+              "      SDUs %u queued, %u sent  late %u  underruns %u  "
+              "overflows %u  pool misses %u  credit waits %u  "
+              "max wakeup delay %u us\n",
+              stats.sdus_queued, stats.sdus_sent, stats.late_drops,
+              stats.underruns, stats.overflows, stats.pool_misses,
+              stats.credit_waits, stats.max_tick_lateness_us);
+    }
+  }
+}
@@ -27,6 +27,7 @@
 #include "bt_types.h"
 #include "btm_int.h"
 #include "stack_config.h"
+#include "osi/include/footprint.h"
 #include "osi/include/properties.h"
 
 #if (OFF_TARGET_TEST_ENABLED == TRUE)
@@ -37,7 +38,6 @@
 */
 tBTM_CB btm_cb;
 
-
 /*******************************************************************************
  *
  * Function         btm_init
@@ -72,6 +72,7 @@ void btm_init(void) {
 #else
   btm_cb.trace_level = BT_TRACE_LEVEL_NONE; /* No traces */
 #endif
+  footprint_set("btm", "control_block", sizeof(tBTM_CB));
   /* Initialize BTM component structures */
   btm_inq_db_init(); /* Inquiry Database and Structures */
   btm_acl_init();    /* ACL Database and Structures */
@@ -84,8 +85,6 @@ void btm_init(void) {
   btm_sco_init(); /* SCO Database and Structures (If included) */
 #endif
 
-  btm_cb.sec_dev_rec = list_new(osi_free);
-
   btm_dev_init(); /* Device Manager Structures & HCI_Reset */
 }
 
@@ -101,8 +100,8 @@ void btm_free(void) {
 
   btm_inq_db_free();
 
-  list_free(btm_cb.sec_dev_rec);
-  btm_cb.sec_dev_rec = NULL;
+  while (!btm_cb.sec_dev_rec.Empty())
+    btm_sec_dev_rec_remove(btm_cb.sec_dev_rec.Front());
 
   alarm_free(btm_cb.sec_collision_timer);
   btm_cb.sec_collision_timer = NULL;
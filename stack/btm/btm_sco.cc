@@ -33,6 +33,7 @@
 #include "btm_api.h"
 #include "btm_int.h"
 #include "btm_int_types.h"
+#include "btm_sco_msbc.h"
 #include "btu.h"
 #include "device/include/controller.h"
 #include "device/include/esco_parameters.h"
@@ -86,10 +87,40 @@ void btm_sco_flush_sco_data(uint16_t sco_inx) {
       osi_free(p_buf);
   }
 }
-}
 #else
 void btm_sco_flush_sco_data(UNUSED_ATTR uint16_t sco_inx) {}
 #endif
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+/*******************************************************************************
+ *
+ * Function         btm_sco_set_host_codec_path
+ *
+ * Description      When SCO is routed over HCI, mSBC is coded on the host.
+ *                  The controller is set up to carry the frames unchanged.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void btm_sco_set_host_codec_path(enh_esco_params_t* p_setup) {
+  if (btm_cb.sco_cb.sco_route != ESCO_DATA_PATH_HCI ||
+      p_setup->transmit_coding_format.coding_format != ESCO_CODING_FORMAT_MSBC)
+    return;
+
+  p_setup->transmit_coding_format.coding_format = ESCO_CODING_FORMAT_TRANSPNT;
+  p_setup->receive_coding_format.coding_format = ESCO_CODING_FORMAT_TRANSPNT;
+  p_setup->input_coding_format.coding_format = ESCO_CODING_FORMAT_TRANSPNT;
+  p_setup->output_coding_format.coding_format = ESCO_CODING_FORMAT_TRANSPNT;
+  p_setup->input_bandwidth = p_setup->transmit_bandwidth;
+  p_setup->output_bandwidth = p_setup->receive_bandwidth;
+  p_setup->input_coded_data_size = 8;
+  p_setup->output_coded_data_size = 8;
+  p_setup->input_pcm_data_format = ESCO_PCM_DATA_FORMAT_NA;
+  p_setup->output_pcm_data_format = ESCO_PCM_DATA_FORMAT_NA;
+  p_setup->input_pcm_payload_msb_position = 0;
+  p_setup->output_pcm_payload_msb_position = 0;
+}
+#endif
+
 /*******************************************************************************
  *
  * Function         btm_sco_init
@@ -195,6 +226,9 @@ static void btm_esco_conn_rsp(uint16_t sco_inx, uint8_t hci_status,
       /* Use the saved SCO routing */
       p_setup->input_data_path = p_setup->output_data_path =
           btm_cb.sco_cb.sco_route;
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+      btm_sco_set_host_codec_path(p_setup);
+#endif
 
       BTM_TRACE_DEBUG(
           "%s: txbw 0x%x, rxbw 0x%x, lat 0x%x, retrans 0x%02x, "
@@ -270,7 +304,28 @@ void btm_route_sco_data(BT_HDR* p_msg) {
   STREAM_TO_UINT8(pkt_size, p);
 
   sco_inx = btm_find_scb_by_handle(handle);
-  if (sco_inx != BTM_MAX_SCO_LINKS) {
+  if (sco_inx != BTM_MAX_SCO_LINKS && btm_sco_msbc_is_active(sco_inx)) {
+    /* Hand decoded PCM up instead of the mSBC packet */
+    btm_sco_msbc_put_rx_data(sco_inx, p, pkt_size,
+                             (tBTM_SCO_DATA_FLAG)pkt_status);
+    osi_free(p_msg);
+
+    tBTM_SCO_DATA_FLAG status;
+    BT_HDR* p_pcm;
+    while ((p_pcm = btm_sco_msbc_get_rx_pcm(sco_inx, &status)) != NULL) {
+      if (!btm_cb.sco_cb.p_data_cb) {
+        osi_free(p_pcm);
+        continue;
+      }
+      /* Rebuild the packet preamble ahead of the PCM data */
+      p_pcm->offset -= HCI_SCO_PREAMBLE_SIZE;
+      p = (uint8_t*)(p_pcm + 1) + p_pcm->offset;
+      UINT16_TO_STREAM(p, handle | ((uint16_t)status << HCI_DATA_EVENT_OFFSET));
+      UINT8_TO_STREAM(p, (uint8_t)p_pcm->len);
+      p_pcm->len += HCI_SCO_PREAMBLE_SIZE;
+      (*btm_cb.sco_cb.p_data_cb)(sco_inx, p_pcm, status);
+    }
+  } else if (sco_inx != BTM_MAX_SCO_LINKS) {
     /* send data callback */
     if (!btm_cb.sco_cb.p_data_cb)
       /* if no data callback registered,  just free the buffer  */
@@ -310,9 +365,34 @@ void btm_route_sco_data(BT_HDR* p_msg) {
  *
  ******************************************************************************/
 #if (BTM_SCO_HCI_INCLUDED == TRUE && BTM_MAX_SCO_LINKS > 0)
+/* Writes the HCI header ahead of |p_buf| and queues it for sending. The
+ * buffer must carry an offset of at least HCI_SCO_PREAMBLE_SIZE bytes. */
+static tBTM_STATUS btm_sco_enqueue_data(tSCO_CONN* p_ccb, BT_HDR* p_buf) {
+  uint8_t* p;
+  tBTM_STATUS status = BTM_SUCCESS;
+
+  /* Step back 3 bytes to add the headers */
+  p_buf->offset -= HCI_SCO_PREAMBLE_SIZE;
+  /* Set the pointer to the beginning of the data */
+  p = (uint8_t*)(p_buf + 1) + p_buf->offset;
+  /* add HCI handle */
+  UINT16_TO_STREAM(p, p_ccb->hci_handle);
+  /* only sent the first BTM_SCO_DATA_SIZE_MAX bytes data if more than max,
+     and set warning status */
+  if (p_buf->len > BTM_SCO_DATA_SIZE_MAX) {
+    p_buf->len = BTM_SCO_DATA_SIZE_MAX;
+    status = BTM_SCO_BAD_LENGTH;
+  }
+
+  UINT8_TO_STREAM(p, (uint8_t)p_buf->len);
+  p_buf->len += HCI_SCO_PREAMBLE_SIZE;
+
+  fixed_queue_enqueue(p_ccb->xmit_data_q, p_buf);
+  return status;
+}
+
 tBTM_STATUS BTM_WriteScoData(uint16_t sco_inx, BT_HDR* p_buf) {
   tSCO_CONN* p_ccb = &btm_cb.sco_cb.sco_db[sco_inx];
-  uint8_t* p;
   tBTM_STATUS status = BTM_SUCCESS;
 
   if (sco_inx < BTM_MAX_SCO_LINKS && btm_cb.sco_cb.p_data_cb &&
@@ -323,25 +403,20 @@ tBTM_STATUS BTM_WriteScoData(uint16_t sco_inx, BT_HDR* p_buf) {
                       p_buf->offset);
       osi_free(p_buf);
       status = BTM_ILLEGAL_VALUE;
-    } else /* write HCI header */
-    {
-      /* Step back 3 bytes to add the headers */
-      p_buf->offset -= HCI_SCO_PREAMBLE_SIZE;
-      /* Set the pointer to the beginning of the data */
-      p = (uint8_t*)(p_buf + 1) + p_buf->offset;
-      /* add HCI handle */
-      UINT16_TO_STREAM(p, p_ccb->hci_handle);
-      /* only sent the first BTM_SCO_DATA_SIZE_MAX bytes data if more than max,
-         and set warning status */
-      if (p_buf->len > BTM_SCO_DATA_SIZE_MAX) {
-        p_buf->len = BTM_SCO_DATA_SIZE_MAX;
-        status = BTM_SCO_BAD_LENGTH;
-      }
+    } else if (btm_sco_msbc_is_active(sco_inx)) {
+      /* The PCM is coded on the host; send the packets that are complete */
+      btm_sco_msbc_encode(sco_inx, (uint8_t*)(p_buf + 1) + p_buf->offset,
+                          p_buf->len);
+      osi_free(p_buf);
 
-      UINT8_TO_STREAM(p, (uint8_t)p_buf->len);
-      p_buf->len += HCI_SCO_PREAMBLE_SIZE;
+      BT_HDR* p_pkt;
+      while ((p_pkt = btm_sco_msbc_get_tx_pkt(sco_inx)) != NULL)
+        btm_sco_enqueue_data(p_ccb, p_pkt);
 
-      fixed_queue_enqueue(p_ccb->xmit_data_q, p_buf);
+      btm_sco_check_send_pkts(sco_inx);
+    } else /* write HCI header */
+    {
+      status = btm_sco_enqueue_data(p_ccb, p_buf);
 
       btm_sco_check_send_pkts(sco_inx);
     }
@@ -457,6 +532,9 @@ static tBTM_STATUS btm_send_connect_request(uint16_t acl_handle,
       /* Use the saved SCO routing */
       p_setup->input_data_path = p_setup->output_data_path =
           btm_cb.sco_cb.sco_route;
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+      btm_sco_set_host_codec_path(p_setup);
+#endif
 
       LOG(INFO) << __func__ << std::hex << ": enhanced parameter list"
                 << " txbw=0x" << unsigned(p_setup->transmit_bandwidth)
@@ -1038,6 +1116,14 @@ void btm_sco_connected(uint8_t hci_status, const RawAddress* bda,
         if (p_esco_data) p->esco.data = *p_esco_data;
       }
 
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+      /* Transparent data over HCI carries mSBC coded on the host */
+      if (p->esco.setup.input_data_path == ESCO_DATA_PATH_HCI &&
+          p->esco.setup.input_coding_format.coding_format ==
+              ESCO_CODING_FORMAT_TRANSPNT)
+        btm_sco_msbc_init(xx, p->esco.data.tx_pkt_len);
+#endif
+
       (*p->p_conn_cb)(xx);
 
       return;
@@ -1177,6 +1263,9 @@ void btm_sco_removed(uint16_t hci_handle, uint8_t reason) {
     if ((p->state != SCO_ST_UNUSED) && (p->state != SCO_ST_LISTENING) &&
         (p->hci_handle == hci_handle)) {
       btm_sco_flush_sco_data(xx);
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+      btm_sco_msbc_cleanup(xx);
+#endif
 
       p->state = SCO_ST_UNUSED;
       p->hci_handle = BTM_INVALID_HCI_HANDLE;
@@ -1595,6 +1684,9 @@ tBTM_STATUS BTM_ChangeEScoLinkParms(uint16_t sco_inx,
       /* Use the saved SCO routing */
       p_setup->input_data_path = p_setup->output_data_path =
           btm_cb.sco_cb.sco_route;
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+      btm_sco_set_host_codec_path(p_setup);
+#endif
 
       btsnd_hcic_enhanced_set_up_synchronous_connection(p_sco->hci_handle,
                                                         p_setup);
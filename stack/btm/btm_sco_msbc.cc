@@ -0,0 +1,519 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  Host side mSBC codec for wideband speech over an HCI routed eSCO link.
+ *
+ *  Every 7.5 ms unit on the link carries a two byte H2 header, one 57 byte
+ *  mSBC frame and a padding byte. Units do not need to line up with the HCI
+ *  packets, so received data is reassembled and the receiver locks onto the
+ *  H2 header and mSBC syncword. Frames that are lost, flagged erroneous by
+ *  the controller or fail to decode are concealed by pattern matching as
+ *  described in the HFP specification, so the upper layer always gets one
+ *  PCM frame per unit.
+ *
+ *  All state is preallocated in one control block; nothing is allocated on
+ *  the audio path except the buffers handed over to the caller.
+ *
+ ******************************************************************************/
+
+#include "btm_sco_msbc.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "btm_int.h"
+#include "hcidefs.h"
+#include "oi_codec_sbc.h"
+#include "oi_status.h"
+#include "osi/include/osi.h"
+#include "sbc_encoder.h"
+
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+
+/* First byte of the H2 header. The second byte is the sequence number 0-3
+ * with both of its bits doubled. */
+#define BTM_MSBC_H2_SYNC 0x01
+static const uint8_t btm_msbc_h2_seq[4] = {0x08, 0x38, 0xC8, 0xF8};
+
+/* Decoded frames waiting for the upper layer */
+#define BTM_MSBC_RX_FRAMES 8
+/* Received bytes kept while looking for the next unit */
+#define BTM_MSBC_RX_BUF_LEN (BTM_MSBC_PKT_LEN * 4)
+/* Encoded bytes waiting to be sent */
+#define BTM_MSBC_TX_BUF_LEN (BTM_MSBC_PKT_LEN * 8)
+/* Units with a broken header in good data before the receiver resyncs */
+#define BTM_MSBC_MAX_BAD_HEADERS 4
+
+/* Concealment: the last PLC_TEMPLATE samples are searched for in the
+ * PLC_SEARCH older samples, and the signal that followed the best match is
+ * repeated at the energy of the template. PLC_OLAL samples are overlap-added
+ * into the following frame. */
+#define BTM_MSBC_PLC_TEMPLATE 64
+#define BTM_MSBC_PLC_SEARCH 256
+#define BTM_MSBC_PLC_OLAL 16
+#define BTM_MSBC_PLC_HIST                                               \
+  (BTM_MSBC_PLC_SEARCH + BTM_MSBC_SAMPLES_PER_FRAME + BTM_MSBC_PLC_TEMPLATE + \
+   BTM_MSBC_PLC_OLAL)
+#define BTM_MSBC_PLC_MAX_SCALE 1.2f
+/* Consecutive lost frames played at full level, and the count at which the
+ * output is muted */
+#define BTM_MSBC_PLC_FULL_FRAMES 2
+#define BTM_MSBC_PLC_MUTE_FRAMES 8
+
+typedef struct {
+  int16_t pcm[BTM_MSBC_SAMPLES_PER_FRAME];
+  bool concealed;
+} tBTM_MSBC_PCM_FRAME;
+
+typedef struct {
+  bool in_use;
+  uint16_t sco_inx;
+  uint16_t tx_pkt_len;
+
+  /* Decoder */
+  OI_CODEC_SBC_DECODER_CONTEXT dec_context;
+  uint32_t dec_data[CODEC_DATA_WORDS(1, SBC_CODEC_FAST_FILTER_BUFFERS)];
+
+  /* Receive reassembly */
+  uint8_t rx_buf[BTM_MSBC_RX_BUF_LEN];
+  bool rx_bad[BTM_MSBC_RX_BUF_LEN]; /* byte came from an erroneous packet */
+  uint16_t rx_len;
+  bool rx_synced;
+  uint8_t rx_seq; /* expected sequence number */
+  uint8_t rx_bad_headers;
+
+  /* Decoded frames */
+  tBTM_MSBC_PCM_FRAME rx_frames[BTM_MSBC_RX_FRAMES];
+  uint8_t rx_frame_head;
+  uint8_t rx_frame_count;
+
+  /* Concealment */
+  float plc_hist[BTM_MSBC_PLC_HIST];
+  float plc_tail[BTM_MSBC_PLC_OLAL]; /* continuation of the concealed frame */
+  uint8_t plc_lost;                  /* consecutive lost frames */
+  bool plc_primed;                   /* history holds received audio */
+
+  /* Encoder */
+  SBC_ENC_PARAMS enc_params;
+  int16_t tx_pcm[BTM_MSBC_SAMPLES_PER_FRAME];
+  uint16_t tx_pcm_len; /* in bytes */
+  uint8_t tx_seq;
+  uint8_t tx_buf[BTM_MSBC_TX_BUF_LEN];
+  uint16_t tx_len;
+
+  /* Statistics */
+  uint32_t frames_decoded;
+  uint32_t frames_concealed;
+  uint32_t frames_encoded;
+  uint32_t rx_overruns;
+  uint32_t tx_overruns;
+} tBTM_MSBC_CB;
+
+static tBTM_MSBC_CB btm_msbc_cb;
+
+static int16_t btm_msbc_saturate(float value) {
+  if (value > INT16_MAX) return INT16_MAX;
+  if (value < INT16_MIN) return INT16_MIN;
+  return (int16_t)value;
+}
+
+/* Level of the |lost|-th consecutive concealed frame */
+static float btm_msbc_plc_gain(uint8_t lost) {
+  if (lost <= BTM_MSBC_PLC_FULL_FRAMES) return 1.0f;
+  if (lost >= BTM_MSBC_PLC_MUTE_FRAMES) return 0.0f;
+  return 1.0f - (float)(lost - BTM_MSBC_PLC_FULL_FRAMES) /
+                    (BTM_MSBC_PLC_MUTE_FRAMES - BTM_MSBC_PLC_FULL_FRAMES);
+}
+
+static void btm_msbc_plc_push_history(tBTM_MSBC_CB* p_cb, const int16_t* pcm) {
+  memmove(p_cb->plc_hist, p_cb->plc_hist + BTM_MSBC_SAMPLES_PER_FRAME,
+          (BTM_MSBC_PLC_HIST - BTM_MSBC_SAMPLES_PER_FRAME) * sizeof(float));
+  float* p_dst =
+      p_cb->plc_hist + BTM_MSBC_PLC_HIST - BTM_MSBC_SAMPLES_PER_FRAME;
+  for (int i = 0; i < BTM_MSBC_SAMPLES_PER_FRAME; i++) p_dst[i] = pcm[i];
+}
+
+/* Overlap-adds the continuation of the last concealed frame into the first
+ * samples of |p_out| */
+static void btm_msbc_plc_overlap(const tBTM_MSBC_CB* p_cb, float* p_out) {
+  for (int i = 0; i < BTM_MSBC_PLC_OLAL; i++) {
+    float w = (float)(i + 1) / (BTM_MSBC_PLC_OLAL + 1);
+    p_out[i] = w * p_out[i] + (1.0f - w) * p_cb->plc_tail[i];
+  }
+}
+
+/* A frame was received intact: smooth the transition out of concealment and
+ * remember it */
+static void btm_msbc_plc_good_frame(tBTM_MSBC_CB* p_cb, int16_t* pcm) {
+  if (p_cb->plc_lost > 0) {
+    float head[BTM_MSBC_PLC_OLAL];
+    for (int i = 0; i < BTM_MSBC_PLC_OLAL; i++) head[i] = pcm[i];
+    btm_msbc_plc_overlap(p_cb, head);
+    for (int i = 0; i < BTM_MSBC_PLC_OLAL; i++)
+      pcm[i] = btm_msbc_saturate(head[i]);
+  }
+  p_cb->plc_lost = 0;
+  p_cb->plc_primed = true;
+  btm_msbc_plc_push_history(p_cb, pcm);
+}
+
+/* A frame was lost: synthesize |pcm| from the history */
+static void btm_msbc_plc_bad_frame(tBTM_MSBC_CB* p_cb, int16_t* pcm) {
+  if (!p_cb->plc_primed) {
+    /* Nothing received yet to repeat */
+    memset(pcm, 0, BTM_MSBC_PCM_FRAME_LEN);
+    return;
+  }
+
+  const float* p_tmpl =
+      p_cb->plc_hist + BTM_MSBC_PLC_HIST - BTM_MSBC_PLC_TEMPLATE;
+  float tmpl_energy = 0.0f;
+  for (int k = 0; k < BTM_MSBC_PLC_TEMPLATE; k++)
+    tmpl_energy += p_tmpl[k] * p_tmpl[k];
+
+  /* Best normalized cross correlation. xcorr * |xcorr| / energy keeps the
+   * sign and avoids a square root per candidate. */
+  int best = 0;
+  float best_score = -INFINITY;
+  float best_energy = 0.0f;
+  for (int i = 0; i < BTM_MSBC_PLC_SEARCH; i++) {
+    const float* p_seg = p_cb->plc_hist + i;
+    float xcorr = 0.0f;
+    float energy = 0.0f;
+    for (int k = 0; k < BTM_MSBC_PLC_TEMPLATE; k++) {
+      xcorr += p_seg[k] * p_tmpl[k];
+      energy += p_seg[k] * p_seg[k];
+    }
+    if (energy <= 0.0f) continue;
+    float score = xcorr * fabsf(xcorr) / energy;
+    if (score > best_score) {
+      best_score = score;
+      best = i;
+      best_energy = energy;
+    }
+  }
+
+  float scale = 0.0f;
+  if (best_energy > 0.0f) {
+    scale = sqrtf(tmpl_energy / best_energy);
+    if (scale > BTM_MSBC_PLC_MAX_SCALE) scale = BTM_MSBC_PLC_MAX_SCALE;
+  }
+
+  /* Fade across the frame from the level of the previous frame */
+  float gain_start = btm_msbc_plc_gain(p_cb->plc_lost);
+  if (p_cb->plc_lost < UINT8_MAX) p_cb->plc_lost++;
+  float gain_end = btm_msbc_plc_gain(p_cb->plc_lost);
+
+  const float* p_src = p_cb->plc_hist + best + BTM_MSBC_PLC_TEMPLATE;
+  float out[BTM_MSBC_SAMPLES_PER_FRAME + BTM_MSBC_PLC_OLAL];
+  for (int i = 0; i < BTM_MSBC_SAMPLES_PER_FRAME + BTM_MSBC_PLC_OLAL; i++) {
+    float gain = gain_end;
+    if (i < BTM_MSBC_SAMPLES_PER_FRAME)
+      gain = gain_start +
+             (gain_end - gain_start) * i / BTM_MSBC_SAMPLES_PER_FRAME;
+    out[i] = p_src[i] * scale * gain;
+  }
+  /* A second lost frame continues the previous synthesis */
+  if (p_cb->plc_lost > 1) btm_msbc_plc_overlap(p_cb, out);
+
+  memcpy(p_cb->plc_tail, out + BTM_MSBC_SAMPLES_PER_FRAME,
+         sizeof(p_cb->plc_tail));
+  for (int i = 0; i < BTM_MSBC_SAMPLES_PER_FRAME; i++)
+    pcm[i] = btm_msbc_saturate(out[i]);
+  btm_msbc_plc_push_history(p_cb, pcm);
+}
+
+/* Returns the next free slot of the decoded frame queue, dropping the oldest
+ * frame if the upper layer fell behind */
+static tBTM_MSBC_PCM_FRAME* btm_msbc_next_rx_frame(tBTM_MSBC_CB* p_cb) {
+  if (p_cb->rx_frame_count == BTM_MSBC_RX_FRAMES) {
+    p_cb->rx_frame_head = (p_cb->rx_frame_head + 1) % BTM_MSBC_RX_FRAMES;
+    p_cb->rx_frame_count--;
+    p_cb->rx_overruns++;
+  }
+  uint8_t idx =
+      (p_cb->rx_frame_head + p_cb->rx_frame_count) % BTM_MSBC_RX_FRAMES;
+  p_cb->rx_frame_count++;
+  return &p_cb->rx_frames[idx];
+}
+
+static void btm_msbc_conceal_frame(tBTM_MSBC_CB* p_cb) {
+  tBTM_MSBC_PCM_FRAME* p_frame = btm_msbc_next_rx_frame(p_cb);
+  btm_msbc_plc_bad_frame(p_cb, p_frame->pcm);
+  p_frame->concealed = true;
+  p_cb->frames_concealed++;
+}
+
+static void btm_msbc_decode_frame(tBTM_MSBC_CB* p_cb, const uint8_t* p_data) {
+  tBTM_MSBC_PCM_FRAME* p_frame = btm_msbc_next_rx_frame(p_cb);
+  const OI_BYTE* p_frame_data = p_data;
+  uint32_t frame_bytes = BTM_MSBC_FRAME_LEN;
+  uint32_t pcm_bytes = BTM_MSBC_PCM_FRAME_LEN;
+
+  OI_STATUS status =
+      OI_CODEC_SBC_DecodeFrame(&p_cb->dec_context, &p_frame_data, &frame_bytes,
+                               p_frame->pcm, &pcm_bytes);
+  if (!OI_SUCCESS(status) || pcm_bytes != BTM_MSBC_PCM_FRAME_LEN) {
+    BTM_TRACE_DEBUG("%s: decoding failure: %d", __func__, status);
+    btm_msbc_plc_bad_frame(p_cb, p_frame->pcm);
+    p_frame->concealed = true;
+    p_cb->frames_concealed++;
+    return;
+  }
+  btm_msbc_plc_good_frame(p_cb, p_frame->pcm);
+  p_frame->concealed = false;
+  p_cb->frames_decoded++;
+}
+
+/* Returns true if |p_data| holds an H2 header and the mSBC syncword.
+ * |p_seq| is set to the sequence number of the header. */
+static bool btm_msbc_is_unit_start(const uint8_t* p_data, uint8_t* p_seq) {
+  if (p_data[0] != BTM_MSBC_H2_SYNC) return false;
+  if (p_data[BTM_MSBC_H2_HEADER_LEN] != SBC_MSBC_SYNC_WORD) return false;
+  for (uint8_t seq = 0; seq < 4; seq++) {
+    if (p_data[1] == btm_msbc_h2_seq[seq]) {
+      *p_seq = seq;
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Decodes or conceals every complete unit in the reassembly buffer */
+static void btm_msbc_process_rx(tBTM_MSBC_CB* p_cb) {
+  uint16_t used = 0;
+  uint8_t seq;
+
+  while (p_cb->rx_len - used >= BTM_MSBC_PKT_LEN) {
+    const uint8_t* p_data = p_cb->rx_buf + used;
+    const bool* p_bad = p_cb->rx_bad + used;
+
+    if (!p_cb->rx_synced) {
+      /* Look for the start of a unit in good data. If there is none, the
+       * unit worth of data is concealed to keep the audio clock running. */
+      uint16_t avail = p_cb->rx_len - used;
+      uint16_t skip;
+      bool found = false;
+      for (skip = 0; skip < BTM_MSBC_PKT_LEN &&
+                     skip + BTM_MSBC_H2_HEADER_LEN + 1 <= avail;
+           skip++) {
+        if (!p_bad[skip] && !p_bad[skip + 1] && !p_bad[skip + 2] &&
+            btm_msbc_is_unit_start(p_data + skip, &seq)) {
+          found = true;
+          break;
+        }
+      }
+      used += skip;
+      if (found) {
+        p_cb->rx_synced = true;
+        p_cb->rx_seq = seq;
+        p_cb->rx_bad_headers = 0;
+      } else if (skip == BTM_MSBC_PKT_LEN) {
+        btm_msbc_conceal_frame(p_cb);
+      }
+      continue;
+    }
+
+    bool lost = false;
+    for (int i = 0; i < BTM_MSBC_H2_HEADER_LEN + BTM_MSBC_FRAME_LEN; i++) {
+      if (p_bad[i]) {
+        lost = true;
+        break;
+      }
+    }
+
+    if (!lost && btm_msbc_is_unit_start(p_data, &seq)) {
+      /* Units missing from the stream are concealed */
+      for (uint8_t gap = (seq - p_cb->rx_seq) & 3; gap > 0; gap--)
+        btm_msbc_conceal_frame(p_cb);
+      btm_msbc_decode_frame(p_cb, p_data + BTM_MSBC_H2_HEADER_LEN);
+      p_cb->rx_seq = (seq + 1) & 3;
+      p_cb->rx_bad_headers = 0;
+    } else {
+      btm_msbc_conceal_frame(p_cb);
+      p_cb->rx_seq = (p_cb->rx_seq + 1) & 3;
+      if (!lost && ++p_cb->rx_bad_headers >= BTM_MSBC_MAX_BAD_HEADERS) {
+        BTM_TRACE_WARNING("%s: lost frame sync", __func__);
+        p_cb->rx_synced = false;
+      }
+    }
+    used += BTM_MSBC_PKT_LEN;
+  }
+
+  p_cb->rx_len -= used;
+  memmove(p_cb->rx_buf, p_cb->rx_buf + used, p_cb->rx_len);
+  memmove(p_cb->rx_bad, p_cb->rx_bad + used, p_cb->rx_len * sizeof(bool));
+}
+
+static void btm_msbc_encode_frame(tBTM_MSBC_CB* p_cb) {
+  if (p_cb->tx_len + BTM_MSBC_PKT_LEN > BTM_MSBC_TX_BUF_LEN) {
+    /* The controller does not keep up; drop the new frame so the data
+     * already queued stays aligned */
+    p_cb->tx_overruns++;
+    return;
+  }
+
+  uint8_t* p = p_cb->tx_buf + p_cb->tx_len;
+  p[0] = BTM_MSBC_H2_SYNC;
+  p[1] = btm_msbc_h2_seq[p_cb->tx_seq];
+  SBC_Encode(&p_cb->enc_params, p_cb->tx_pcm, p + BTM_MSBC_H2_HEADER_LEN);
+  p[BTM_MSBC_PKT_LEN - 1] = 0;
+
+  p_cb->tx_seq = (p_cb->tx_seq + 1) & 3;
+  p_cb->tx_len += BTM_MSBC_PKT_LEN;
+  p_cb->frames_encoded++;
+}
+
+bool btm_sco_msbc_init(uint16_t sco_inx, uint16_t tx_pkt_len) {
+  tBTM_MSBC_CB* p_cb = &btm_msbc_cb;
+
+  if (p_cb->in_use) {
+    BTM_TRACE_WARNING("%s: codec in use by sco_inx %d, sco_inx %d rejected",
+                      __func__, p_cb->sco_inx, sco_inx);
+    return false;
+  }
+
+  memset(p_cb, 0, sizeof(*p_cb));
+  OI_STATUS status = OI_CODEC_SBC_DecoderReset(
+      &p_cb->dec_context, p_cb->dec_data, sizeof(p_cb->dec_data), 1, 1, FALSE);
+  if (OI_SUCCESS(status))
+    status = OI_CODEC_SBC_DecoderConfigureMSbc(&p_cb->dec_context);
+  if (!OI_SUCCESS(status)) {
+    BTM_TRACE_ERROR("%s: decoder setup failed with error code %d", __func__,
+                    status);
+    return false;
+  }
+
+  p_cb->enc_params.Format = SBC_FORMAT_MSBC;
+  SBC_Encoder_Init(&p_cb->enc_params);
+
+  if (tx_pkt_len == 0 || tx_pkt_len > BTM_MSBC_TX_BUF_LEN)
+    tx_pkt_len = BTM_MSBC_PKT_LEN;
+  p_cb->tx_pkt_len = tx_pkt_len;
+  p_cb->sco_inx = sco_inx;
+  p_cb->in_use = true;
+
+  BTM_TRACE_EVENT("%s: sco_inx %d, tx_pkt_len %d", __func__, sco_inx,
+                  tx_pkt_len);
+  return true;
+}
+
+void btm_sco_msbc_cleanup(uint16_t sco_inx) {
+  tBTM_MSBC_CB* p_cb = &btm_msbc_cb;
+
+  if (!btm_sco_msbc_is_active(sco_inx)) return;
+
+  BTM_TRACE_EVENT(
+      "%s: sco_inx %d, decoded %u, concealed %u, encoded %u, rx overruns %u, "
+      "tx overruns %u",
+      __func__, sco_inx, p_cb->frames_decoded, p_cb->frames_concealed,
+      p_cb->frames_encoded, p_cb->rx_overruns, p_cb->tx_overruns);
+  p_cb->in_use = false;
+}
+
+bool btm_sco_msbc_is_active(uint16_t sco_inx) {
+  return btm_msbc_cb.in_use && btm_msbc_cb.sco_inx == sco_inx;
+}
+
+void btm_sco_msbc_put_rx_data(uint16_t sco_inx, const uint8_t* p_data,
+                              uint16_t len, tBTM_SCO_DATA_FLAG status) {
+  tBTM_MSBC_CB* p_cb = &btm_msbc_cb;
+
+  if (!btm_sco_msbc_is_active(sco_inx)) return;
+
+  bool bad = (status != BTM_SCO_DATA_CORRECT);
+  while (len > 0) {
+    /* Processing leaves less than a unit behind, so there is always room */
+    uint16_t n = BTM_MSBC_RX_BUF_LEN - p_cb->rx_len;
+    if (n > len) n = len;
+    memcpy(p_cb->rx_buf + p_cb->rx_len, p_data, n);
+    for (uint16_t i = 0; i < n; i++) p_cb->rx_bad[p_cb->rx_len + i] = bad;
+    p_cb->rx_len += n;
+    p_data += n;
+    len -= n;
+    btm_msbc_process_rx(p_cb);
+  }
+}
+
+BT_HDR* btm_sco_msbc_get_rx_pcm(uint16_t sco_inx,
+                                tBTM_SCO_DATA_FLAG* p_status) {
+  tBTM_MSBC_CB* p_cb = &btm_msbc_cb;
+
+  if (!btm_sco_msbc_is_active(sco_inx) || p_cb->rx_frame_count == 0)
+    return NULL;
+
+  const tBTM_MSBC_PCM_FRAME* p_frame = &p_cb->rx_frames[p_cb->rx_frame_head];
+  BT_HDR* p_buf = (BT_HDR*)osi_malloc(sizeof(BT_HDR) + HCI_SCO_PREAMBLE_SIZE +
+                                      BTM_MSBC_PCM_FRAME_LEN);
+  p_buf->event = 0;
+  p_buf->layer_specific = 0;
+  p_buf->offset = HCI_SCO_PREAMBLE_SIZE;
+  p_buf->len = BTM_MSBC_PCM_FRAME_LEN;
+  memcpy((uint8_t*)(p_buf + 1) + p_buf->offset, p_frame->pcm,
+         BTM_MSBC_PCM_FRAME_LEN);
+  *p_status =
+      p_frame->concealed ? BTM_SCO_DATA_PAR_LOST : BTM_SCO_DATA_CORRECT;
+
+  p_cb->rx_frame_head = (p_cb->rx_frame_head + 1) % BTM_MSBC_RX_FRAMES;
+  p_cb->rx_frame_count--;
+  return p_buf;
+}
+
+void btm_sco_msbc_encode(uint16_t sco_inx, const uint8_t* p_pcm,
+                         uint16_t len) {
+  tBTM_MSBC_CB* p_cb = &btm_msbc_cb;
+
+  if (!btm_sco_msbc_is_active(sco_inx)) return;
+
+  while (len > 0) {
+    uint16_t n = BTM_MSBC_PCM_FRAME_LEN - p_cb->tx_pcm_len;
+    if (n > len) n = len;
+    memcpy((uint8_t*)p_cb->tx_pcm + p_cb->tx_pcm_len, p_pcm, n);
+    p_cb->tx_pcm_len += n;
+    p_pcm += n;
+    len -= n;
+    if (p_cb->tx_pcm_len == BTM_MSBC_PCM_FRAME_LEN) {
+      btm_msbc_encode_frame(p_cb);
+      p_cb->tx_pcm_len = 0;
+    }
+  }
+}
+
+BT_HDR* btm_sco_msbc_get_tx_pkt(uint16_t sco_inx) {
+  tBTM_MSBC_CB* p_cb = &btm_msbc_cb;
+
+  if (!btm_sco_msbc_is_active(sco_inx) || p_cb->tx_len < p_cb->tx_pkt_len)
+    return NULL;
+
+  BT_HDR* p_buf = (BT_HDR*)osi_malloc(sizeof(BT_HDR) + HCI_SCO_PREAMBLE_SIZE +
+                                      p_cb->tx_pkt_len);
+  p_buf->event = 0;
+  p_buf->layer_specific = 0;
+  p_buf->offset = HCI_SCO_PREAMBLE_SIZE;
+  p_buf->len = p_cb->tx_pkt_len;
+  memcpy((uint8_t*)(p_buf + 1) + p_buf->offset, p_cb->tx_buf,
+         p_cb->tx_pkt_len);
+
+  p_cb->tx_len -= p_cb->tx_pkt_len;
+  memmove(p_cb->tx_buf, p_cb->tx_buf + p_cb->tx_pkt_len, p_cb->tx_len);
+  return p_buf;
+}
+
+#endif /* BTM_SCO_HCI_INCLUDED == TRUE */
@@ -0,0 +1,86 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  Host side mSBC codec for wideband speech over an HCI routed eSCO link.
+ *  Received transparent packets are reassembled into H2 framed mSBC frames,
+ *  decoded and concealed when lost, and outgoing PCM is encoded into H2
+ *  framed packets of the negotiated size.
+ *
+ ******************************************************************************/
+
+#ifndef BTM_SCO_MSBC_H
+#define BTM_SCO_MSBC_H
+
+#include <stdint.h>
+
+#include "bt_common.h"
+#include "bt_target.h"
+#include "btm_api_types.h"
+
+/* Size of an mSBC frame */
+#define BTM_MSBC_FRAME_LEN 57
+/* Size of the H2 synchronization header ahead of every frame */
+#define BTM_MSBC_H2_HEADER_LEN 2
+/* H2 header, mSBC frame and one padding byte: one 7.5 ms unit */
+#define BTM_MSBC_PKT_LEN (BTM_MSBC_H2_HEADER_LEN + BTM_MSBC_FRAME_LEN + 1)
+/* Samples in one mSBC frame: 7.5 ms at 16 kHz */
+#define BTM_MSBC_SAMPLES_PER_FRAME 120
+/* Bytes of 16 bit PCM in one mSBC frame */
+#define BTM_MSBC_PCM_FRAME_LEN (BTM_MSBC_SAMPLES_PER_FRAME * 2)
+
+#if (BTM_SCO_HCI_INCLUDED == TRUE)
+
+/* Starts the codec for SCO link |sco_inx|. Encoded data is handed out in
+ * payloads of |tx_pkt_len| bytes. Only one link can run the codec at a time.
+ * Returns false if the codec is already in use or cannot be set up. */
+extern bool btm_sco_msbc_init(uint16_t sco_inx, uint16_t tx_pkt_len);
+
+/* Stops the codec if it runs for SCO link |sco_inx|. */
+extern void btm_sco_msbc_cleanup(uint16_t sco_inx);
+
+/* Returns true if the codec runs for SCO link |sco_inx|. */
+extern bool btm_sco_msbc_is_active(uint16_t sco_inx);
+
+/* Feeds |len| bytes of a received SCO packet payload |p_data| received with
+ * the packet status |status|. */
+extern void btm_sco_msbc_put_rx_data(uint16_t sco_inx, const uint8_t* p_data,
+                                     uint16_t len, tBTM_SCO_DATA_FLAG status);
+
+/* Returns the next decoded frame of BTM_MSBC_PCM_FRAME_LEN bytes, or NULL if
+ * there is none. The buffer keeps HCI_SCO_PREAMBLE_SIZE bytes of headroom
+ * ahead of the PCM data and is owned by the caller. |p_status| is set to
+ * BTM_SCO_DATA_PAR_LOST if the frame was concealed, BTM_SCO_DATA_CORRECT
+ * otherwise. */
+extern BT_HDR* btm_sco_msbc_get_rx_pcm(uint16_t sco_inx,
+                                       tBTM_SCO_DATA_FLAG* p_status);
+
+/* Encodes |len| bytes of 16 bit mono PCM at 16 kHz in |p_pcm|. Samples that
+ * do not fill a frame are kept for the next call. */
+extern void btm_sco_msbc_encode(uint16_t sco_inx, const uint8_t* p_pcm,
+                                uint16_t len);
+
+/* Returns the next encoded payload of the negotiated packet size, or NULL if
+ * not enough data is encoded. The buffer keeps HCI_SCO_PREAMBLE_SIZE bytes
+ * of headroom ahead of the payload and is owned by the caller. */
+extern BT_HDR* btm_sco_msbc_get_tx_pkt(uint16_t sco_inx);
+
+#endif /* BTM_SCO_HCI_INCLUDED == TRUE */
+
+#endif /* BTM_SCO_MSBC_H */
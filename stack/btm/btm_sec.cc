@@ -40,6 +40,7 @@
 #include "bt_types.h"
 #include "bt_utils.h"
 #include "btif_storage.h"
+#include "btm_conn_trace.h"
 #include "btm_int.h"
 #include "btu.h"
 #include "hcimsgs.h"
@@ -2115,6 +2116,7 @@ tBTM_STATUS btm_sec_l2cap_access_req(const RawAddress& bd_addr, uint16_t psm,
   p_dev_rec = btm_find_or_alloc_dev(bd_addr);
 
   p_dev_rec->hci_handle = handle;
+  btm_sec_dev_rec_reindex(p_dev_rec);
 
   /* Find the service record for the PSM */
   p_serv_rec = btm_sec_find_first_serv(conn_type, psm);
@@ -3051,13 +3053,8 @@ static tBTM_STATUS btm_sec_dd_create_conn(tBTM_SEC_DEV_REC* p_dev_rec) {
   return (BTM_CMD_STARTED);
 }
 
-bool is_state_getting_name(void* data, void* context) {
-  tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(data);
-
-  if (p_dev_rec->sec_state == BTM_SEC_STATE_GETTING_NAME) {
-    return false;
-  }
-  return true;
+static bool is_state_getting_name(const tBTM_SEC_DEV_REC* p_dev_rec) {
+  return p_dev_rec->sec_state == BTM_SEC_STATE_GETTING_NAME;
 }
 
 /*******************************************************************************
@@ -3088,14 +3085,8 @@ void btm_sec_rmt_name_request_complete(const RawAddress* p_bd_addr,
   if (p_bd_addr)
     p_dev_rec = btm_find_dev(*p_bd_addr);
   else {
-    list_node_t* node =
-        list_foreach(btm_cb.sec_dev_rec, is_state_getting_name, NULL);
-    if (node != NULL) {
-      p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(list_node(node));
-      p_bd_addr = &p_dev_rec->bd_addr;
-    } else {
-      p_dev_rec = NULL;
-    }
+    p_dev_rec = btm_cb.sec_dev_rec.Find(is_state_getting_name);
+    if (p_dev_rec != NULL) p_bd_addr = &p_dev_rec->bd_addr;
   }
 
   /* Commenting out trace due to obf/compilation problems.
@@ -4081,6 +4072,10 @@ void btm_sec_auth_complete(uint16_t handle, uint8_t status) {
 
   btm_cb.collision_start_time = 0;
 
+  if (p_dev_rec && status == HCI_SUCCESS)
+    btm_conn_trace_mark(p_dev_rec->bd_addr, BT_TRANSPORT_BR_EDR,
+                        BTM_CONN_TRACE_AUTHENTICATED);
+
   btm_restore_mode();
 
   /* Check if connection was made just to do bonding.  If we authenticate
@@ -4273,6 +4268,11 @@ void btm_sec_encrypt_change(uint16_t handle, uint8_t status,
 
   if (!p_dev_rec) return;
 
+  if ((status == HCI_SUCCESS) && encr_enable && acl_idx < MAX_L2CAP_LINKS)
+    btm_conn_trace_mark(btm_cb.acl_db[acl_idx].remote_addr,
+                        btm_cb.acl_db[acl_idx].transport,
+                        BTM_CONN_TRACE_ENCRYPTED);
+
   if ((status == HCI_SUCCESS) && encr_enable) {
     if (p_dev_rec->hci_handle == handle) {
       p_dev_rec->sec_flags |= (BTM_SEC_AUTHENTICATED | BTM_SEC_ENCRYPTED);
@@ -4669,6 +4669,7 @@ void btm_sec_connected(const RawAddress& bda, uint16_t handle, uint8_t status,
   }
 
   p_dev_rec->hci_handle = handle;
+  btm_sec_dev_rec_reindex(p_dev_rec);
 
   /* role may not be correct here, it will be updated by l2cap, but we need to
    */
@@ -4831,6 +4832,9 @@ void btm_sec_disconnected(uint16_t handle, uint8_t reason) {
     }
   }
 
+  if (transport == BT_TRANSPORT_LE && reason == HCI_ERR_CONNECTION_TOUT)
+    btm_ble_bgconn_link_lost(p_dev_rec->bd_addr);
+
   btm_ble_update_mode_operation(HCI_ROLE_UNKNOWN, &p_dev_rec->bd_addr,
                                 HCI_SUCCESS);
   /* see sec_flags processing in btm_acl_removed */
@@ -4839,10 +4843,12 @@ void btm_sec_disconnected(uint16_t handle, uint8_t reason) {
 
   if (transport == BT_TRANSPORT_LE) {
     p_dev_rec->ble_hci_handle = BTM_SEC_INVALID_HANDLE;
+    btm_sec_dev_rec_reindex(p_dev_rec);
     p_dev_rec->sec_flags &= ~(BTM_SEC_LE_AUTHENTICATED | BTM_SEC_LE_ENCRYPTED);
     p_dev_rec->enc_key_size = 0;
   } else {
     p_dev_rec->hci_handle = BTM_SEC_INVALID_HANDLE;
+    btm_sec_dev_rec_reindex(p_dev_rec);
     p_dev_rec->sec_flags &=
         ~(BTM_SEC_AUTHORIZED | BTM_SEC_AUTHENTICATED | BTM_SEC_ENCRYPTED |
           BTM_SEC_ROLE_SWITCHED | BTM_SEC_16_DIGIT_PIN_AUTHED |
@@ -5887,15 +5893,6 @@ static void btm_restore_mode(void) {
   }
 }
 
-bool is_sec_state_equal(void* data, void* context) {
-  tBTM_SEC_DEV_REC* p_dev_rec = static_cast<tBTM_SEC_DEV_REC*>(data);
-  uint8_t* state = static_cast<uint8_t*>(context);
-
-  if (p_dev_rec->sec_state == *state) return false;
-
-  return true;
-}
-
 /*******************************************************************************
  *
  * Function         btm_sec_find_dev_by_sec_state
@@ -5907,10 +5904,9 @@ bool is_sec_state_equal(void* data, void* context) {
  *
  ******************************************************************************/
 tBTM_SEC_DEV_REC* btm_sec_find_dev_by_sec_state(uint8_t state) {
-  list_node_t* n = list_foreach(btm_cb.sec_dev_rec, is_sec_state_equal, &state);
-  if (n) return static_cast<tBTM_SEC_DEV_REC*>(list_node(n));
-
-  return NULL;
+  return btm_cb.sec_dev_rec.Find([state](const tBTM_SEC_DEV_REC* p_dev_rec) {
+    return p_dev_rec->sec_state == state;
+  });
 }
 
 /*******************************************************************************
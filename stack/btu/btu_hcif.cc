@@ -78,6 +78,7 @@
 #include "btm_int.h"
 #include "btu.h"
 #include "device/include/controller.h"
+#include "hci_event_view.h"
 #include "hci_evt_length.h"
 #include "hci_layer.h"
 #include "hcimsgs.h"
@@ -113,10 +114,12 @@ static void btu_hcif_extended_inquiry_result_evt(uint8_t* p,
 
 static void btu_hcif_connection_comp_evt(uint8_t* p, uint8_t evt_len);
 static void btu_hcif_connection_request_evt(uint8_t* p);
-static void btu_hcif_disconnection_comp_evt(uint8_t* p);
+static void btu_hcif_disconnection_comp_evt(
+    const HciDisconnectionCompleteView& event);
 static void btu_hcif_authentication_comp_evt(uint8_t* p);
 static void btu_hcif_rmt_name_request_comp_evt(uint8_t* p, uint16_t evt_len);
-static void btu_hcif_encryption_change_evt(uint8_t* p);
+static void btu_hcif_encryption_change_evt(
+    const HciEncryptionChangeView& event);
 static void btu_hcif_read_rmt_features_comp_evt(uint8_t* p);
 static void btu_hcif_read_rmt_ext_features_comp_evt(uint8_t* p,
                                                     uint8_t evt_len);
@@ -166,7 +169,8 @@ static void btu_hcif_ssr_evt(uint8_t* p, uint16_t evt_len);
 
 static void btu_ble_ll_conn_complete_evt(uint8_t* p, uint16_t evt_len);
 static void btu_ble_read_remote_feat_evt(uint8_t* p, uint8_t length);
-static void btu_ble_ll_conn_param_upd_evt(uint8_t* p, uint16_t evt_len);
+static void btu_ble_ll_conn_param_upd_evt(
+    const HciLeConnectionUpdateCompleteView& event);
 static void btu_ble_proc_ltk_req(uint8_t* p);
 static void btu_hcif_encryption_key_refresh_cmpl_evt(uint8_t* p);
 static void btu_ble_data_length_change_evt(uint8_t* p, uint16_t evt_len);
@@ -192,7 +196,7 @@ static void do_in_hci_thread(const base::Location& from_here,
     return;
   }
 
-  hci_message_loop->task_runner()->PostTask(from_here, task);
+  do_in_main_thread_prio(BTU_TASK_PRIO_CONN, from_here, task);
 }
 
 /*******************************************************************************
@@ -239,7 +243,8 @@ void btu_hcif_process_event(UNUSED_ATTR uint8_t controller_id, BT_HDR* p_msg) {
       btu_hcif_connection_request_evt(p);
       break;
     case HCI_DISCONNECTION_COMP_EVT:
-      btu_hcif_disconnection_comp_evt(p);
+      btu_hcif_disconnection_comp_evt(
+          HciDisconnectionCompleteView(p, hci_evt_len));
       break;
     case HCI_AUTHENTICATION_COMP_EVT:
       btu_hcif_authentication_comp_evt(p);
@@ -248,7 +253,7 @@ void btu_hcif_process_event(UNUSED_ATTR uint8_t controller_id, BT_HDR* p_msg) {
       btu_hcif_rmt_name_request_comp_evt(p, hci_evt_len);
       break;
     case HCI_ENCRYPTION_CHANGE_EVT:
-      btu_hcif_encryption_change_evt(p);
+      btu_hcif_encryption_change_evt(HciEncryptionChangeView(p, hci_evt_len));
       break;
     case HCI_ENCRYPTION_KEY_REFRESH_COMP_EVT:
       btu_hcif_encryption_key_refresh_cmpl_evt(p);
@@ -382,13 +387,14 @@ void btu_hcif_process_event(UNUSED_ATTR uint8_t controller_id, BT_HDR* p_msg) {
       switch (ble_sub_code) {
         case HCI_BLE_ADV_PKT_RPT_EVT: /* result of inquiry */
           HCI_TRACE_EVENT("HCI_BLE_ADV_PKT_RPT_EVT");
-          btm_ble_process_adv_pkt(ble_evt_len, p);
+          btm_ble_process_adv_pkt(HciLeAdvertisingReportView(p, ble_evt_len));
           break;
         case HCI_BLE_CONN_COMPLETE_EVT:
           btu_ble_ll_conn_complete_evt(p, hci_evt_len);
           break;
         case HCI_BLE_LL_CONN_PARAM_UPD_EVT:
-          btu_ble_ll_conn_param_upd_evt(p, ble_evt_len);
+          btu_ble_ll_conn_param_upd_evt(
+              HciLeConnectionUpdateCompleteView(p, ble_evt_len));
           break;
         case HCI_BLE_READ_REMOTE_FEAT_CMPL_EVT:
           btu_ble_read_remote_feat_evt(p, ble_evt_len);
@@ -415,7 +421,8 @@ void btu_hcif_process_event(UNUSED_ATTR uint8_t controller_id, BT_HDR* p_msg) {
           break;
 
         case HCI_LE_EXTENDED_ADVERTISING_REPORT_EVT:
-          btm_ble_process_ext_adv_pkt(hci_evt_len, p);
+          btm_ble_process_ext_adv_pkt(
+              HciLeExtAdvertisingReportView(p, ble_evt_len));
           break;
 
         case HCI_LE_PERIODIC_ADV_SYNC_ESTABLISHED_EVT:
@@ -806,16 +813,17 @@ static void btu_hcif_connection_request_evt(uint8_t* p) {
  * Returns          void
  *
  ******************************************************************************/
-static void btu_hcif_disconnection_comp_evt(uint8_t* p) {
-  uint16_t handle;
-  uint8_t reason;
-  uint8_t status;
-
-  STREAM_TO_UINT8(status, p)
-  STREAM_TO_UINT16(handle, p);
-  STREAM_TO_UINT8(reason, p);
+static void btu_hcif_disconnection_comp_evt(
+    const HciDisconnectionCompleteView& event) {
+  if (!event.IsValid()) {
+    HCI_TRACE_WARNING("%s: malformed event of size %zu", __func__,
+                      event.length());
+    return;
+  }
 
-  handle = HCID_GET_HANDLE(handle);
+  uint8_t status = event.status();
+  uint16_t handle = HCID_GET_HANDLE(event.handle());
+  uint8_t reason = event.reason();
 
   if (btm_ble_is_cis_handle(handle)) {
     btm_ble_cis_disconnected(status, handle, reason);
@@ -933,14 +941,17 @@ static void read_encryption_key_size_complete_after_encryption_change(
  * Returns          void
  *
  ******************************************************************************/
-static void btu_hcif_encryption_change_evt(uint8_t* p) {
-  uint8_t status;
-  uint16_t handle;
-  uint8_t encr_enable;
+static void btu_hcif_encryption_change_evt(
+    const HciEncryptionChangeView& event) {
+  if (!event.IsValid()) {
+    HCI_TRACE_WARNING("%s: malformed event of size %zu", __func__,
+                      event.length());
+    return;
+  }
 
-  STREAM_TO_UINT8(status, p);
-  STREAM_TO_UINT16(handle, p);
-  STREAM_TO_UINT8(encr_enable, p);
+  uint8_t status = event.status();
+  uint16_t handle = event.handle();
+  uint8_t encr_enable = event.encryption_enabled();
 
   if (status == HCI_ERR_CONNECTION_TOUT) {
     smp_cancel_start_encryption_attempt();
@@ -1596,7 +1607,7 @@ static void btu_hcif_role_change_evt(uint8_t* p) {
  ******************************************************************************/
 static void btu_hcif_num_compl_data_pkts_evt(uint8_t* p, uint8_t evt_len) {
   /* Process for L2CAP and SCO */
-  l2c_link_process_num_completed_pkts(p, evt_len);
+  l2c_link_process_num_completed_pkts(HciNumCompletedPacketsView(p, evt_len));
 
   /* Send on to SCO */
   /*?? No SCO for now */
@@ -2054,26 +2065,20 @@ extern void gatt_notify_subrate_change(uint16_t handle, uint16_t subrate_factor,
                                        uint16_t latency, uint16_t cont_num,
                                        uint16_t timeout, uint8_t status);
 
-static void btu_ble_ll_conn_param_upd_evt(uint8_t* p, uint16_t evt_len) {
+static void btu_ble_ll_conn_param_upd_evt(
+    const HciLeConnectionUpdateCompleteView& event) {
   /* LE connection update has completed successfully as a master. */
   /* We can enable the update request if the result is a success. */
-  /* extract the HCI handle first */
-  uint8_t status;
-  uint16_t handle;
-  uint16_t interval;
-  uint16_t latency;
-  uint16_t timeout;
-
-  if (evt_len < 9) {
+  if (!event.IsValid()) {
     LOG_ERROR(LOG_TAG, "Bogus event packet, too short");
     return;
   }
 
-  STREAM_TO_UINT8(status, p);
-  STREAM_TO_UINT16(handle, p);
-  STREAM_TO_UINT16(interval, p);
-  STREAM_TO_UINT16(latency, p);
-  STREAM_TO_UINT16(timeout, p);
+  uint8_t status = event.status();
+  uint16_t handle = event.handle();
+  uint16_t interval = event.interval();
+  uint16_t latency = event.latency();
+  uint16_t timeout = event.timeout();
 
   l2cble_process_conn_update_evt(handle, status, interval, latency, timeout);
 
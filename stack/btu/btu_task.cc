@@ -27,13 +27,20 @@
 #include <base/logging.h>
 #include <base/run_loop.h>
 #include <base/threading/thread.h>
+#include <mutex>
+
+#include "common/priority_task_queue.h"
+#include "common/task_profiler.h"
+#include "common/worker_pool.h"
 
 #include "bta/sys/bta_sys.h"
 #include "btcore/include/module.h"
 #include "bte.h"
 #include "btif/include/btif_common.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
 #include "osi/include/thread.h"
+#include "osi/include/time.h"
 #include "stack/btm/btm_int.h"
 #include "stack/include/btu.h"
 #include "stack/l2cap/l2c_int.h"
@@ -49,6 +56,29 @@ static base::MessageLoop* message_loop_ = NULL;
 static base::RunLoop* run_loop_ = NULL;
 static thread_t* message_loop_thread_;
 
+/* A task queued in a lower lane runs ahead of the higher lanes after this */
+static const uint64_t BTU_TASK_MAX_WAIT_US = 100 * 1000;
+/* Tasks run per pump before other work posted to the message loop */
+static const int BTU_TASK_PUMP_BATCH = 16;
+
+static std::mutex task_lanes_mutex_;
+static bluetooth::common::PriorityTaskQueue<base::Closure> task_lanes_(
+    BTU_TASK_PRIO_MAX, BTU_TASK_MAX_WAIT_US);
+static bool task_pump_pending_ = false;
+static const char* const task_lane_names_[BTU_TASK_PRIO_MAX] = {
+    "media", "connection", "bulk"};
+
+/* Worker threads for CPU heavy work such as P-256 and AES-CMAC */
+static const size_t BTU_WORKER_THREADS = 2;
+static bluetooth::common::WorkerPool worker_pool_("bt_worker");
+
+/* Per posting location profile of the main thread tasks, off unless the
+ * property is set */
+static const char* BTU_TASK_PROFILING_PROPERTY =
+    "persist.bluetooth.task_profiling";
+static const size_t BTU_TASK_PROFILE_DUMP_ENTRIES = 20;
+static bluetooth::common::TaskProfiler task_profiler_("bt_main_thread");
+
 void btu_hci_msg_process(BT_HDR* p_msg) {
   /* Determine the input message type. */
   switch (p_msg->event & BT_EVT_MASK) {
@@ -85,6 +115,115 @@ void btu_hci_msg_process(BT_HDR* p_msg) {
 
 base::MessageLoop* get_message_loop() { return message_loop_; }
 
+static void btu_task_pump(void) {
+  for (int i = 0; i < BTU_TASK_PUMP_BATCH; i++) {
+    base::Closure task;
+    {
+      std::lock_guard<std::mutex> lock(task_lanes_mutex_);
+      if (!task_lanes_.Pop(&task, time_get_os_boottime_us())) {
+        task_pump_pending_ = false;
+        return;
+      }
+    }
+    task.Run();
+  }
+
+  std::lock_guard<std::mutex> lock(task_lanes_mutex_);
+  if (task_lanes_.IsEmpty() || !message_loop_) {
+    task_pump_pending_ = false;
+    return;
+  }
+  message_loop_->task_runner()->PostTask(FROM_HERE,
+                                         base::Bind(&btu_task_pump));
+}
+
+/*******************************************************************************
+ *
+ * Function         do_in_main_thread_prio
+ *
+ * Description      Queue |task| in lane |prio| of the main thread. The lanes
+ *                  are served in priority order by a pump posted to the
+ *                  message loop, at most BTU_TASK_PUMP_BATCH tasks at a time.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void btu_run_profiled_task(const base::Location& from_here,
+                                  uint64_t posted_us,
+                                  const base::Closure& task) {
+  bluetooth::common::TaskProfiler::ScopedRun run(&task_profiler_, from_here,
+                                                 posted_us);
+  task.Run();
+}
+
+void do_in_main_thread_prio(tBTU_TASK_PRIO prio,
+                            const base::Location& from_here,
+                            const base::Closure& task) {
+  std::lock_guard<std::mutex> lock(task_lanes_mutex_);
+  if (!message_loop_ || !message_loop_->task_runner().get()) {
+    LOG_ERROR(LOG_TAG, "%s: main message loop not running, accessed from %s",
+              __func__, from_here.ToString().c_str());
+    return;
+  }
+
+  if (task_profiler_.IsEnabled()) {
+    task_lanes_.Push(prio,
+                     base::Bind(&btu_run_profiled_task, from_here,
+                                bluetooth::common::TaskProfiler::NowUs(), task),
+                     time_get_os_boottime_us());
+  } else {
+    task_lanes_.Push(prio, task, time_get_os_boottime_us());
+  }
+  if (task_pump_pending_) return;
+
+  task_pump_pending_ = true;
+  message_loop_->task_runner()->PostTask(FROM_HERE,
+                                         base::Bind(&btu_task_pump));
+}
+
+static void btu_run_worker_task(const base::Location& from_here,
+                                const base::Closure& task,
+                                const base::Closure& reply) {
+  task.Run();
+  do_in_main_thread_prio(BTU_TASK_PRIO_CONN, from_here, reply);
+}
+
+void do_in_worker_thread_and_reply(const base::Location& from_here,
+                                   const base::Closure& task,
+                                   const base::Closure& reply) {
+  base::Closure work =
+      base::Bind(&btu_run_worker_task, from_here, task, reply);
+  if (!worker_pool_.IsRunning() || !worker_pool_.PostTask(from_here, work)) {
+    work.Run();
+  }
+}
+
+void BTU_DumpTaskLanes(int fd) {
+  std::lock_guard<std::mutex> lock(task_lanes_mutex_);
+
+  dprintf(fd, "\nBTU main thread task lanes:\n");
+  for (size_t i = 0; i < task_lanes_.NumLanes(); i++) {
+    const auto& stats = task_lanes_.GetStats(i);
+    uint64_t avg_delay_us =
+        stats.popped ? stats.total_delay_us / stats.popped : 0;
+    dprintf(fd,
+            "  %-10s queued: %zu run: %llu aged: %llu delay avg/max: "
+            "%llu/%llu ms max depth: %zu\n",
+            task_lane_names_[i], task_lanes_.Size(i),
+            (unsigned long long)stats.popped, (unsigned long long)stats.aged,
+            (unsigned long long)(avg_delay_us / 1000),
+            (unsigned long long)(stats.max_delay_us / 1000), stats.max_depth);
+  }
+
+  bluetooth::common::WorkerPool::Stats worker_stats = worker_pool_.GetStats();
+  dprintf(fd, "  workers: %zu posted: %llu run: %llu stolen: %llu\n",
+          worker_pool_.NumThreads(), (unsigned long long)worker_stats.posted,
+          (unsigned long long)worker_stats.run,
+          (unsigned long long)worker_stats.stolen);
+
+  task_profiler_.Dump(fd, BTU_TASK_PROFILE_DUMP_ENTRIES);
+}
+
 void btu_message_loop_run(UNUSED_ATTR void* context) {
   message_loop_ = new base::MessageLoop();
   run_loop_ = new base::RunLoop();
@@ -96,8 +235,23 @@ void btu_message_loop_run(UNUSED_ATTR void* context) {
 
   run_loop_->Run();
 
-  delete message_loop_;
-  message_loop_ = NULL;
+  /* Tasks queued ahead of the quit still run, as they would from a single
+   * queue, so that the buffers they own are freed. The lanes are closed once
+   * they are found empty. */
+  base::MessageLoop* message_loop = message_loop_;
+  while (true) {
+    base::Closure task;
+    {
+      std::lock_guard<std::mutex> lock(task_lanes_mutex_);
+      if (!task_lanes_.Pop(&task, time_get_os_boottime_us())) {
+        task_pump_pending_ = false;
+        message_loop_ = NULL;
+        break;
+      }
+    }
+    task.Run();
+  }
+  delete message_loop;
 
   delete run_loop_;
   run_loop_ = NULL;
@@ -131,9 +285,15 @@ void btu_task_start_up(UNUSED_ATTR void* context) {
   thread_set_rt_priority(message_loop_thread_, THREAD_RT_PRIORITY);
   thread_post(message_loop_thread_, btu_message_loop_run, nullptr);
 
+  worker_pool_.StartUp(BTU_WORKER_THREADS);
+  task_profiler_.SetEnabled(
+      osi_property_get_bool(BTU_TASK_PROFILING_PROPERTY, false));
+
 }
 
 void btu_task_shut_down(UNUSED_ATTR void* context) {
+  worker_pool_.ShutDown();
+
   // Shutdown message loop on task completed
   if (run_loop_ && message_loop_) {
     message_loop_->task_runner()->PostTask(FROM_HERE, run_loop_->QuitClosure());
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/******************************************************************************
+ *
+ *  This file contains the AES block encryption using the ARMv8 Crypto
+ *  Extensions or AES-NI. The key schedule is the one aes_set_key expands,
+ *  its round keys are already in the byte order the instructions use.
+ *
+ ******************************************************************************/
+
+#include "stack/crypto_toolbox/aes_hw.h"
+
+#if defined(__aarch64__)
+#define AES_HW_ARM
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#ifndef HWCAP_AES
+#define HWCAP_AES (1 << 3)
+#endif
+#elif defined(__x86_64__) || defined(__i386__)
+#define AES_HW_X86
+#include <wmmintrin.h>
+#endif
+
+namespace crypto_toolbox {
+
+namespace {
+
+bool aes_hw_detect() {
+#if defined(AES_HW_ARM)
+  return (getauxval(AT_HWCAP) & HWCAP_AES) != 0;
+#elif defined(AES_HW_X86)
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("aes");
+#else
+  return false;
+#endif
+}
+
+#if defined(AES_HW_ARM)
+/* AESE + AESMC. Inline assembly, so the rest of the file can be built for
+ * CPUs without the Crypto Extensions. */
+inline uint8x16_t aes_round(uint8x16_t state, uint8x16_t round_key) {
+  asm(".arch_extension crypto\n"
+      "aese %0.16b, %1.16b\n"
+      "aesmc %0.16b, %0.16b\n"
+      : "+w"(state)
+      : "w"(round_key));
+  return state;
+}
+
+inline uint8x16_t aes_last_round(uint8x16_t state, uint8x16_t round_key,
+                                 uint8x16_t last_key) {
+  asm(".arch_extension crypto\n"
+      "aese %0.16b, %1.16b\n"
+      : "+w"(state)
+      : "w"(round_key));
+  return veorq_u8(state, last_key);
+}
+#endif
+
+}  // namespace
+
+bool aes_hw_force_software = false;
+
+bool aes_hw_supported() {
+  static const bool supported = aes_hw_detect();
+  return supported;
+}
+
+#if defined(AES_HW_ARM)
+void aes_hw_encrypt(const uint8_t in[N_BLOCK], uint8_t out[N_BLOCK],
+                    const aes_context& ctx) {
+  const uint8_t* rk = ctx.ksch;
+  uint8x16_t state = vld1q_u8(in);
+
+  for (int r = 0; r < ctx.rnd - 1; r++)
+    state = aes_round(state, vld1q_u8(rk + r * N_BLOCK));
+  state = aes_last_round(state, vld1q_u8(rk + (ctx.rnd - 1) * N_BLOCK),
+                         vld1q_u8(rk + ctx.rnd * N_BLOCK));
+  vst1q_u8(out, state);
+}
+#elif defined(AES_HW_X86)
+__attribute__((target("aes,sse2"))) void aes_hw_encrypt(
+    const uint8_t in[N_BLOCK], uint8_t out[N_BLOCK], const aes_context& ctx) {
+  const __m128i* rk = (const __m128i*)ctx.ksch;
+  __m128i state = _mm_loadu_si128((const __m128i*)in);
+
+  state = _mm_xor_si128(state, _mm_loadu_si128(rk));
+  for (int r = 1; r < ctx.rnd; r++)
+    state = _mm_aesenc_si128(state, _mm_loadu_si128(rk + r));
+  state = _mm_aesenclast_si128(state, _mm_loadu_si128(rk + ctx.rnd));
+  _mm_storeu_si128((__m128i*)out, state);
+}
+#else
+void aes_hw_encrypt(const uint8_t in[N_BLOCK], uint8_t out[N_BLOCK],
+                    const aes_context& ctx) {
+  aes_encrypt(in, out, &ctx);
+}
+#endif
+
+void aes_encrypt_block(const uint8_t in[N_BLOCK], uint8_t out[N_BLOCK],
+                       const aes_context& ctx) {
+  if (!aes_hw_force_software && aes_hw_supported())
+    aes_hw_encrypt(in, out, ctx);
+  else
+    aes_encrypt(in, out, &ctx);
+}
+
+}  // namespace crypto_toolbox
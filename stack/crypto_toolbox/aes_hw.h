@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "stack/crypto_toolbox/aes.h"
+
+namespace crypto_toolbox {
+
+/* Returns true if the CPU has AES instructions (ARMv8 Crypto Extensions or
+ * AES-NI) and aes_hw_encrypt can be used. */
+extern bool aes_hw_supported();
+
+/* Encrypts one block with the key schedule |ctx| made by aes_set_key, in the
+ * byte order of aes_encrypt. Only call it if aes_hw_supported(). */
+extern void aes_hw_encrypt(const uint8_t in[N_BLOCK], uint8_t out[N_BLOCK],
+                           const aes_context& ctx);
+
+/* Set to true to make aes_encrypt_block use aes_encrypt even if the CPU has
+ * AES instructions, to compare the two in tests and benchmarks. */
+extern bool aes_hw_force_software;
+
+/* Encrypts one block with the AES instructions if the CPU has them, else
+ * with aes_encrypt. */
+extern void aes_encrypt_block(const uint8_t in[N_BLOCK], uint8_t out[N_BLOCK],
+                              const aes_context& ctx);
+
+}  // namespace crypto_toolbox
@@ -16,13 +16,31 @@
 
 #pragma once
 
+#include "stack/crypto_toolbox/aes.h"
 #include "stack/include/bt_types.h"
 
 namespace crypto_toolbox {
 
+/* AES-CMAC key schedule and subkeys, see aes_cmac_set_key */
+typedef struct {
+  aes_context aes;
+  uint8_t k1[OCTET16_LEN];
+  uint8_t k2[OCTET16_LEN];
+} cmac_context;
+
 extern Octet16 aes_128(const Octet16& key, const Octet16& message);
+/* Expands the key schedule of |key| into |p_ctx|, for keys that encrypt many
+ * messages. Use it with the aes_128 overloads taking an aes_context. */
+extern void aes_128_set_key(const Octet16& key, aes_context* p_ctx);
+extern Octet16 aes_128(const aes_context& ctx, const Octet16& message);
 extern Octet16 aes_cmac(const Octet16& key, const uint8_t* message,
                         uint16_t length);
+/* Expands the key schedule and subkeys of the CMAC key |key| into |p_ctx|,
+ * for keys that sign many messages. Use it with the aes_cmac overload taking
+ * a cmac_context. */
+extern void aes_cmac_set_key(const Octet16& key, cmac_context* p_ctx);
+extern Octet16 aes_cmac(const cmac_context& ctx, const uint8_t* message,
+                        uint16_t length);
 extern Octet16 f4(uint8_t* u, uint8_t* v, const Octet16& x, uint8_t z);
 extern void f5(uint8_t* w, const Octet16& n1, const Octet16& n2, uint8_t* a1,
                uint8_t* a2, Octet16* mac_key, Octet16* ltk);
@@ -45,6 +63,15 @@ inline Octet16 aes_128(const Octet16& key, const uint8_t* message,
   return aes_128(key, msg);
 }
 
+/* Same as above, with the key schedule |ctx| set up by aes_128_set_key */
+inline Octet16 aes_128(const aes_context& ctx, const uint8_t* message,
+                       const uint8_t length) {
+  CHECK(length <= OCTET16_LEN) << "you tried aes_128 more than 16 bytes!";
+  Octet16 msg{0};
+  std::copy(message, message + length, msg.begin());
+  return aes_128(ctx, msg);
+}
+
 // |tlen| - lenth of mac desired
 // |p_signature| - data pointer to where signed data to be stored, tlen long.
 inline void aes_cmac(const Octet16& key, const uint8_t* message,
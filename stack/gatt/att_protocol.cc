@@ -356,7 +356,7 @@ BT_HDR* attp_build_multi_ntf_cmd(uint16_t payload_size, tGATT_MULTI_NOTIF multi_
       UINT16_TO_STREAM(p, handle);
       UINT16_TO_STREAM(p, len);
       value = multi_ntf.values[i];
-      for (uint8_t j=0; j<len; j++) {
+      for (uint16_t j=0; j<len; j++) {
         *p = value[j];
         p++;
       }
@@ -388,6 +388,9 @@ tGATT_STATUS attp_send_msg_to_l2cap(tGATT_TCB& tcb, uint16_t cid, BT_HDR* p_toL2
   else
     lcid = tcb.att_lcid;
 
+  /* L2CAP owns the buffer once it is handed over */
+  uint16_t len = p_toL2CAP->len;
+
   if (lcid == L2CAP_ATT_CID)
     l2cap_ret = L2CA_SendFixedChnlData(L2CAP_ATT_CID, tcb.peer_bda, p_toL2CAP);
   else
@@ -396,7 +399,11 @@ tGATT_STATUS attp_send_msg_to_l2cap(tGATT_TCB& tcb, uint16_t cid, BT_HDR* p_toL2
   if (l2cap_ret == L2CAP_DW_FAILED) {
     LOG(ERROR) << __func__ << ": failed to write data to L2CAP";
     return GATT_INTERNAL_ERROR;
-  } else if (l2cap_ret == L2CAP_DW_CONGESTED) {
+  }
+
+  gatt_cl_stats_pdu_sent(tcb, lcid, len);
+
+  if (l2cap_ret == L2CAP_DW_CONGESTED) {
     VLOG(1) << StringPrintf("ATT congested, message accepted");
     return GATT_CONGESTED;
   } else if (l2cap_ret == L2CAP_DW_NO_CREDITS) {
@@ -515,6 +522,15 @@ tGATT_STATUS attp_cl_send_cmd(tGATT_TCB& tcb, tGATT_CLCB* p_clcb, uint16_t lcid,
     cl_cmd_q = tcb.cl_cmd_q;
   }
 
+  if (cmd_code == GATT_CMD_WRITE && p_clcb && p_clcb->p_reg &&
+      p_clcb->p_reg->write_pack_ms && cl_cmd_q.empty() &&
+      (!tcb.is_eatt_supported || lcid == L2CAP_ATT_CID)) {
+    return gatt_cl_pack_add(tcb, p_cmd, p_clcb->p_reg->write_pack_ms);
+  }
+
+  /* write commands held back go out before anything sent after them */
+  gatt_cl_pack_flush(tcb);
+
   if (!cl_cmd_q.empty() && cmd_code != GATT_HANDLE_VALUE_CONF) {
     gatt_cmd_enq(tcb, p_clcb, p_eatt_bcb, true, cmd_code, p_cmd);
     return GATT_CMD_STARTED;
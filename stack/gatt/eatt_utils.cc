@@ -409,17 +409,46 @@ tGATT_EBCB* gatt_find_eatt_bcb_by_cid_in_progress(RawAddress bda, uint16_t lcid)
   return p_eatt_bcb;
 }
 
-bool compare_num_apps_in_ebcb_list(tGATT_APPS_EBCB a, tGATT_APPS_EBCB b) {
-  return(a.num_apps < b.num_apps);
+/* Response time assumed for a bearer that hasn't answered a request yet */
+#define GATT_EATT_DEFAULT_RTT_MS 30
+/* Operations a bearer without credits is assumed to be behind */
+#define GATT_EATT_NO_CREDITS_COST 4
+
+/*******************************************************************************
+ *
+ * Function         gatt_eatt_bcb_cost
+ *
+ * Description      Estimates how long, in ms, a new operation on the bearer
+ *                  would wait: the operations queued on it, a penalty when it
+ *                  is out of credits, and the apps already bound to it, each
+ *                  taking the bearer's smoothed response time.
+ *
+ * Returns          the estimated time
+ *
+ ******************************************************************************/
+static uint32_t gatt_eatt_bcb_cost(const tGATT_EBCB& eatt_bcb) {
+  uint32_t pending = eatt_bcb.cl_cmd_q.size() + eatt_bcb.notif_q.size() +
+                     eatt_bcb.gatt_rsp_q.size() +
+                     eatt_bcb.gatt_disc_rsp_q.size() + eatt_bcb.apps.size();
+  if (eatt_bcb.pending_ind_q)
+    pending += fixed_queue_length(eatt_bcb.pending_ind_q);
+  if (eatt_bcb.indicate_handle) pending++;
+  if (eatt_bcb.no_credits) pending += GATT_EATT_NO_CREDITS_COST;
+
+  uint32_t rtt_ms = eatt_bcb.stats.srtt_ms ? eatt_bcb.stats.srtt_ms
+                                           : GATT_EATT_DEFAULT_RTT_MS;
+  return (pending + 1) * rtt_ms;
 }
 
 /*******************************************************************************
  *
  * Function         gatt_find_best_eatt_bcb
  *
- * Description      The function searches for the least burdened EATT bearer.
- *                  If no suitable EATT bearers are available, ATT channel will
- *                  be selected.
+ * Description      The function searches for the least burdened EATT bearer,
+ *                  the one a new operation would wait the least on. The app
+ *                  stays on it afterwards, which keeps its operations in
+ *                  order. If no suitable EATT bearers are available, ATT
+ *                  channel will be selected.
  *
  * Returns          pointer to the selected eatt_bcb.
  *
@@ -427,8 +456,8 @@ bool compare_num_apps_in_ebcb_list(tGATT_APPS_EBCB a, tGATT_APPS_EBCB b) {
 tGATT_EBCB* gatt_find_best_eatt_bcb(tGATT_TCB* p_tcb, tGATT_IF gatt_if, uint16_t old_cid, bool opportunistic) {
   uint16_t i = 0;
   tGATT_EBCB* p_eatt_bcb = NULL;
-  std::vector<tGATT_APPS_EBCB> apps_in_ebcb_list;
-  tGATT_APPS_EBCB apps_in_ebcb;
+  tGATT_EBCB* p_best_bcb = NULL;
+  uint32_t best_cost = 0;
   uint16_t conn_id = 0;
   tGATT_EBCB* p_eatt_bcb_old = gatt_find_eatt_bcb_by_cid(p_tcb, old_cid);
   tGATT_REG* p_reg = gatt_get_regcb(gatt_if);
@@ -443,21 +472,19 @@ tGATT_EBCB* gatt_find_best_eatt_bcb(tGATT_TCB* p_tcb, tGATT_IF gatt_if, uint16_t
           continue;
         }
       }
-      p_eatt_bcb = &gatt_cb.eatt_bcb[i];
-
-      if (p_eatt_bcb) {
-        apps_in_ebcb.lcid = p_eatt_bcb->cid;
-        apps_in_ebcb.num_apps = p_eatt_bcb->apps.size();
-        apps_in_ebcb_list.push_back(apps_in_ebcb);
+      uint32_t cost = gatt_eatt_bcb_cost(gatt_cb.eatt_bcb[i]);
+      VLOG(1) << __func__ << " cid:" << +gatt_cb.eatt_bcb[i].cid
+              << " cost:" << cost;
+      if (!p_best_bcb || cost < best_cost) {
+        p_best_bcb = &gatt_cb.eatt_bcb[i];
+        best_cost = cost;
       }
     }
   }
 
   //EATT channels available to select
-  if(apps_in_ebcb_list.size() > 0) {
-    //Select the least burdened EATT channel
-    std::sort(apps_in_ebcb_list.begin(), apps_in_ebcb_list.end(), compare_num_apps_in_ebcb_list);
-    p_eatt_bcb = gatt_find_eatt_bcb_by_cid(p_tcb, apps_in_ebcb_list[0].lcid);
+  if (p_best_bcb) {
+    p_eatt_bcb = p_best_bcb;
   }
   // Unable to find any suitable EATT channel, use ATT
   else {
@@ -145,11 +145,14 @@ static void gatt_update_last_srv_info() {
   for (tGATT_SRV_LIST_ELEM& el : *gatt_cb.srv_list_info) {
     gatt_cb.last_service_handle = el.s_hdl;
   }
+
+  gatt_sr_update_srv_range_index();
+  gatts_invalidate_read_by_type_cache();
 }
 
 /** Update database hash and client status */
 static void gatt_update_for_database_change() {
-  gatt_cb.database_hash = gatts_calculate_database_hash(gatt_cb.srv_list_info);
+  gatts_invalidate_database_hash();
 
   uint8_t i = 0;
   for (i = 0; i < GATT_MAX_PHY_CHANNEL; i++) {
@@ -489,6 +492,9 @@ tGATT_STATUS GATTS_HandleValueIndication(uint16_t conn_id, uint16_t attr_handle,
 
   if (!GATT_HANDLE_IS_VALID(attr_handle)) return GATT_ILLEGAL_PARAMETER;
 
+  /* notifications sent before the indication go out first */
+  gatt_sr_ntf_batch_flush(*p_tcb);
+
   tGATT_VALUE indication;
   indication.conn_id = conn_id;
   indication.handle = attr_handle;
@@ -613,6 +619,11 @@ tGATT_STATUS GATTS_HandleValueNotification(uint16_t conn_id,
     }
   }
 
+  if (p_reg->ntf_coalesce_ms || gatt_sr_ntf_in_burst(*p_tcb)) {
+    return gatt_sr_ntf_batch_add(*p_tcb, conn_id, lcid, attr_handle, val_len,
+                                 p_val, p_reg->ntf_coalesce_ms);
+  }
+
   tGATT_STATUS cmd_sent;
   tGATT_SR_MSG gatt_sr_msg;
   gatt_sr_msg.attr_value = notif;
@@ -29,6 +29,7 @@
 #include "bt_utils.h"
 #include "gatt_int.h"
 #include "l2c_int.h"
+#include "osi/include/time.h"
 #include "log/log.h"
 #include "osi/include/osi.h"
 #include "stack/gatt/eatt_int.h"
@@ -658,7 +659,10 @@ void gatt_process_prep_write_rsp(tGATT_TCB& tcb, tGATT_CLCB* p_clcb,
  ******************************************************************************/
 void gatt_process_notification(tGATT_TCB& tcb, uint16_t lcid, uint8_t op_code,
                                uint16_t len, uint8_t* p_data) {
-  tGATT_VALUE value;
+  /* the value is parsed straight into the completion handed to the apps, so
+   * it is copied out of the PDU only once */
+  tGATT_CL_COMPLETE gatt_cl_complete;
+  tGATT_VALUE& value = gatt_cl_complete.att_value;
   tGATT_REG* p_reg;
   uint16_t conn_id;
   tGATT_STATUS encrypt_status;
@@ -677,8 +681,11 @@ void gatt_process_notification(tGATT_TCB& tcb, uint16_t lcid, uint8_t op_code,
     return;
   }
 
-  memset(&value, 0, sizeof(value));
+  value.conn_id = 0;
   STREAM_TO_UINT16(value.handle, p);
+  value.offset = 0;
+  value.auth_req = 0;
+  value.read_sub_type = 0;
   value.len = len - 2;
   if (value.len > GATT_MAX_ATTR_LEN) {
     LOG(ERROR) << "value.len larger than GATT_MAX_ATTR_LEN, discard";
@@ -686,6 +693,8 @@ void gatt_process_notification(tGATT_TCB& tcb, uint16_t lcid, uint8_t op_code,
   }
   memcpy(value.value, p, value.len);
 
+  gatt_cl_stats_value_rcvd(tcb, event == GATTC_OPTYPE_INDICATION, value.len);
+
   if (!GATT_HANDLE_IS_VALID(value.handle)) {
     /* illegal handle, send ack now */
     if (op_code == GATT_HANDLE_VALUE_IND)
@@ -727,8 +736,6 @@ void gatt_process_notification(tGATT_TCB& tcb, uint16_t lcid, uint8_t op_code,
   }
 
   encrypt_status = gatt_get_link_encrypt_status(tcb);
-  tGATT_CL_COMPLETE gatt_cl_complete;
-  gatt_cl_complete.att_value = value;
 
   if (tcb.is_eatt_supported) {
     p_eatt_bcb = gatt_find_eatt_bcb_by_cid(&tcb, lcid);
@@ -798,6 +805,8 @@ void gatt_process_multi_notification(tGATT_TCB& tcb, uint16_t lcid,
     memcpy(value.value, p, value.len);
     p += value.len;
 
+    gatt_cl_stats_value_rcvd(tcb, false, value.len);
+
     encrypt_status = gatt_get_link_encrypt_status(tcb);
     tGATT_CL_COMPLETE gatt_cl_complete;
     gatt_cl_complete.att_value = value;
@@ -1246,6 +1255,7 @@ bool gatt_cl_send_next_cmd_inq(tGATT_TCB& tcb, uint16_t lcid) {
 
     cmd.to_send = false;
     cmd.p_cmd = NULL;
+    cmd.sent_ms = time_get_os_boottime_ms();
 
     if (cmd.op_code == GATT_CMD_WRITE || cmd.op_code == GATT_SIGN_CMD_WRITE) {
       /* dequeue the request if is write command or sign write */
@@ -1311,7 +1321,8 @@ void gatt_client_handle_server_rsp(tGATT_TCB& tcb, uint16_t lcid, uint8_t op_cod
   }
 
   uint8_t cmd_code = 0;
-  tGATT_CLCB* p_clcb = gatt_cmd_dequeue(tcb, lcid, &cmd_code);
+  uint64_t sent_ms = 0;
+  tGATT_CLCB* p_clcb = gatt_cmd_dequeue(tcb, lcid, &cmd_code, &sent_ms);
 
   //No credits, check if uncongestion needs to be sent
   if (p_eatt_bcb && p_eatt_bcb->send_uncongestion) {
@@ -1338,6 +1349,7 @@ void gatt_client_handle_server_rsp(tGATT_TCB& tcb, uint16_t lcid, uint8_t op_cod
 
   alarm_cancel(p_clcb->gatt_rsp_timer_ent);
   p_clcb->retry_count = 0;
+  gatt_cl_stats_rsp_rcvd(tcb, lcid, cmd_code, sent_ms);
 
   VLOG(1) << __func__ << " op_code: " << +op_code << ", len = " << +len
                       << "rsp_code: " << +rsp_code;
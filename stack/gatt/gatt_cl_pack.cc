@@ -0,0 +1,156 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the GATT client write command packing. Write Commands
+ *  an application sends within its packing window are held back and handed
+ *  to L2CAP together, so that the controller has a connection event worth
+ *  of packets queued instead of receiving them one at a time.
+ *
+ ******************************************************************************/
+
+#include <base/logging.h>
+
+#include "bt_common.h"
+#include "device/include/controller.h"
+#include "gatt_api.h"
+#include "gatt_int.h"
+#include "l2cdefs.h"
+#include "osi/include/osi.h"
+
+/* Bytes the controller can take in one go: its LE ACL buffers, full. */
+static uint32_t gatt_cl_pack_budget(void) {
+  const controller_t* controller = controller_get_interface();
+  return (uint32_t)controller->get_acl_buffer_count_ble() *
+         controller->get_acl_data_size_ble();
+}
+
+static void gatt_cl_pack_timeout(void* data) {
+  tGATT_TCB* p_tcb = gatt_get_tcb_by_idx(PTR_TO_UINT(data));
+  if (p_tcb == NULL) return;
+
+  gatt_cl_pack_flush(*p_tcb);
+}
+
+/*******************************************************************************
+ *
+ * Function         gatt_cl_pack_add
+ *
+ * Description      Holds back the Write Command |p_cmd| for the ATT bearer of
+ *                  |tcb|. The writes are sent once |window_ms| expired or
+ *                  they fill the controller buffers.
+ *
+ * Returns          GATT_SUCCESS if the command was queued, otherwise the
+ *                  status of sending the queued commands.
+ *
+ ******************************************************************************/
+tGATT_STATUS gatt_cl_pack_add(tGATT_TCB& tcb, BT_HDR* p_cmd,
+                              uint16_t window_ms) {
+  tGATT_STATUS status = GATT_SUCCESS;
+  uint32_t budget = gatt_cl_pack_budget();
+  /* each PDU also carries the L2CAP header */
+  uint32_t len = p_cmd->len + L2CAP_PKT_OVERHEAD;
+
+  if (!tcb.write_pack_q.empty() && tcb.write_pack_bytes + len > budget) {
+    status = gatt_cl_pack_flush(tcb);
+  }
+
+  tcb.write_pack_q.push_back(p_cmd);
+  tcb.write_pack_bytes += len;
+  tcb.cl_stats.writes_packed++;
+
+  if (tcb.write_pack_bytes >= budget ||
+      tcb.write_pack_q.size() >=
+          controller_get_interface()->get_acl_buffer_count_ble()) {
+    return gatt_cl_pack_flush(tcb);
+  }
+
+  if (!alarm_is_scheduled(tcb.write_pack_timer)) {
+    alarm_set_on_mloop(tcb.write_pack_timer, window_ms, gatt_cl_pack_timeout,
+                       UINT_TO_PTR(tcb.tcb_idx));
+  }
+  return status;
+}
+
+/*******************************************************************************
+ *
+ * Function         gatt_cl_pack_flush
+ *
+ * Description      Sends the Write Commands held back for |tcb|, back to back.
+ *
+ * Returns          GATT_SUCCESS or GATT_CONGESTED if sent, error otherwise.
+ *
+ ******************************************************************************/
+tGATT_STATUS gatt_cl_pack_flush(tGATT_TCB& tcb) {
+  /* called before every client command, keep it cheap when there is none */
+  if (tcb.write_pack_q.empty()) return GATT_SUCCESS;
+  alarm_cancel(tcb.write_pack_timer);
+
+  std::vector<BT_HDR*> batch;
+  batch.swap(tcb.write_pack_q);
+  tcb.write_pack_bytes = 0;
+  tcb.cl_stats.pack_flushes++;
+
+  tGATT_STATUS status = GATT_SUCCESS;
+  for (BT_HDR* p_cmd : batch) {
+    tGATT_STATUS ret = attp_send_msg_to_l2cap(tcb, L2CAP_ATT_CID, p_cmd);
+    if (ret != GATT_SUCCESS) {
+      VLOG(1) << __func__ << ": write command status=" << +ret;
+      status = ret;
+    }
+  }
+  return status;
+}
+
+/*******************************************************************************
+ *
+ * Function         gatt_cl_pack_free
+ *
+ * Description      Drops the Write Commands held back for |tcb|, e.g. when the
+ *                  link went down.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void gatt_cl_pack_free(tGATT_TCB& tcb) {
+  alarm_cancel(tcb.write_pack_timer);
+  for (BT_HDR* p_cmd : tcb.write_pack_q) osi_free(p_cmd);
+  tcb.write_pack_q.clear();
+  tcb.write_pack_bytes = 0;
+}
+
+void GATTC_SetWritePacking(tGATT_IF gatt_if, uint16_t window_ms) {
+  tGATT_REG* p_reg = gatt_get_regcb(gatt_if);
+  if (p_reg == NULL) {
+    LOG(ERROR) << __func__ << ": invalid gatt_if=" << +gatt_if;
+    return;
+  }
+
+  VLOG(1) << __func__ << ": gatt_if=" << +gatt_if
+          << " window_ms=" << window_ms;
+  p_reg->write_pack_ms = window_ms;
+
+  /* do not keep writes waiting for a window that no longer exists */
+  if (window_ms == 0) {
+    for (int i = 0; i < GATT_MAX_PHY_CHANNEL; i++) {
+      tGATT_TCB& tcb = gatt_cb.tcb[i];
+      if (tcb.in_use) gatt_cl_pack_flush(tcb);
+    }
+  }
+}
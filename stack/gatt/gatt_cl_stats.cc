@@ -0,0 +1,125 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the GATT client latency and throughput counters: ATT
+ *  response times per request opcode, received notifications and the traffic
+ *  of every bearer of a link.
+ *
+ ******************************************************************************/
+
+#include <base/logging.h>
+
+#include "bt_common.h"
+#include "gatt_api.h"
+#include "gatt_int.h"
+#include "osi/include/time.h"
+#include "stack/gatt/eatt_int.h"
+
+static const uint32_t rtt_hist_bounds_ms[GATTC_RTT_HIST_BUCKETS - 1] =
+    GATTC_RTT_HIST_BOUNDS_MS;
+
+/* Counters of the bearer |lcid| of |tcb|. */
+static tGATT_BEARER_STATS& gatt_cl_stats_bearer(tGATT_TCB& tcb,
+                                                uint16_t lcid) {
+  if (tcb.is_eatt_supported) {
+    tGATT_EBCB* p_eatt_bcb = gatt_find_eatt_bcb_by_cid(&tcb, lcid);
+    if (p_eatt_bcb) return p_eatt_bcb->stats;
+  }
+  return tcb.att_bearer_stats;
+}
+
+void gatt_cl_stats_pdu_sent(tGATT_TCB& tcb, uint16_t lcid, uint16_t len) {
+  tGATT_BEARER_STATS& stats = gatt_cl_stats_bearer(tcb, lcid);
+  stats.tx_pdus++;
+  stats.tx_bytes += len;
+}
+
+void gatt_cl_stats_pdu_rcvd(tGATT_TCB& tcb, uint16_t lcid, uint16_t len) {
+  tGATT_BEARER_STATS& stats = gatt_cl_stats_bearer(tcb, lcid);
+  stats.rx_pdus++;
+  stats.rx_bytes += len;
+}
+
+void gatt_cl_stats_rsp_rcvd(tGATT_TCB& tcb, uint16_t lcid,
+                            uint8_t req_op_code, uint64_t sent_ms) {
+  uint8_t slot = req_op_code / 2;
+  if (sent_ms == 0 || slot >= GATTC_RTT_OPCODE_SLOTS) return;
+
+  uint64_t now_ms = time_get_os_boottime_ms();
+  uint32_t rtt_ms = (now_ms > sent_ms) ? (uint32_t)(now_ms - sent_ms) : 0;
+
+  /* Smoothed like the TCP RTT estimate, with a gain of 1/8 */
+  tGATT_BEARER_STATS& bearer = gatt_cl_stats_bearer(tcb, lcid);
+  if (bearer.srtt_ms == 0)
+    bearer.srtt_ms = rtt_ms ? rtt_ms : 1;
+  else
+    bearer.srtt_ms = (bearer.srtt_ms * 7 + rtt_ms) / 8;
+
+  tGATTC_RTT_STATS& stats = tcb.cl_stats.rtt[slot];
+  stats.count++;
+  stats.total_ms += rtt_ms;
+  if (rtt_ms > stats.max_ms) stats.max_ms = rtt_ms;
+
+  int bucket = 0;
+  while (bucket < GATTC_RTT_HIST_BUCKETS - 1 &&
+         rtt_ms >= rtt_hist_bounds_ms[bucket])
+    bucket++;
+  stats.hist[bucket]++;
+}
+
+void gatt_cl_stats_value_rcvd(tGATT_TCB& tcb, bool is_indication,
+                              uint16_t len) {
+  if (is_indication)
+    tcb.cl_stats.ind_rcvd++;
+  else
+    tcb.cl_stats.ntf_rcvd++;
+  tcb.cl_stats.value_bytes_rcvd += len;
+}
+
+bool GATTC_GetConnStats(uint16_t conn_id, tGATTC_CONN_STATS* p_stats) {
+  CHECK(p_stats != NULL);
+
+  tGATT_TCB* p_tcb = gatt_get_tcb_by_idx(GATT_GET_TCB_IDX(conn_id));
+  if (p_tcb == NULL) return false;
+
+  *p_stats = p_tcb->cl_stats;
+  p_stats->num_bearers = 0;
+
+  if (!p_tcb->is_eatt_supported) {
+    tGATT_BEARER_STATS& bearer = p_stats->bearers[p_stats->num_bearers++];
+    bearer = p_tcb->att_bearer_stats;
+    bearer.lcid = p_tcb->att_lcid;
+    bearer.num_apps = p_tcb->app_hold_link.size();
+    return true;
+  }
+
+  for (int i = 0; i < GATT_MAX_EATT_CHANNELS; i++) {
+    const tGATT_EBCB& eatt_bcb = gatt_cb.eatt_bcb[i];
+    if (!eatt_bcb.in_use || eatt_bcb.p_tcb != p_tcb) continue;
+    if (p_stats->num_bearers == GATTC_STATS_MAX_BEARERS) break;
+
+    tGATT_BEARER_STATS& bearer = p_stats->bearers[p_stats->num_bearers++];
+    bearer = eatt_bcb.stats;
+    bearer.lcid = eatt_bcb.cid;
+    bearer.num_apps =
+        eatt_bcb.apps.size() + eatt_bcb.opportunistic_apps.size();
+  }
+  return true;
+}
@@ -451,14 +451,18 @@ uint16_t gatts_add_char_descr(tGATT_SVC_DB& db, tGATT_PERM perm,
 /* Service Attribute Database Query Utility Functions */
 /******************************************************************************/
 tGATT_ATTR* find_attr_by_handle(tGATT_SVC_DB* p_db, uint16_t handle) {
-  if (!p_db) return nullptr;
+  if (!p_db || p_db->attr_list.empty()) return nullptr;
 
-  for (auto& attr : p_db->attr_list) {
-    if (attr.handle == handle) return &attr;
-    if (attr.handle > handle) return nullptr;
-  }
+  /* Handles are allocated consecutively from the service start handle, so the
+   * attribute lives at its offset from the first one. */
+  uint16_t s_hdl = p_db->attr_list.front().handle;
+  if (handle < s_hdl) return nullptr;
+
+  size_t idx = handle - s_hdl;
+  if (idx >= p_db->attr_list.size()) return nullptr;
 
-  return nullptr;
+  tGATT_ATTR& attr = p_db->attr_list[idx];
+  return attr.handle == handle ? &attr : nullptr;
 }
 
 /*******************************************************************************
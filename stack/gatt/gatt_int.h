@@ -216,6 +216,8 @@ typedef struct {
   std::vector<tGATT_ATTR> attr_list; /* pointer to the attributes */
   uint16_t end_handle;       /* Last handle number           */
   uint16_t next_handle;      /* Next usable handle value     */
+  /* declarations serialized for the database hash, see gatt_sr_hash.cc */
+  std::vector<uint8_t> hash_info;
 } tGATT_SVC_DB;
 
 /* Data Structure used for GATT server */
@@ -230,6 +232,8 @@ typedef struct {
   bool in_use;
   uint8_t listening; /* if adv for all has been enabled */
   bool eatt_support;
+  uint16_t ntf_coalesce_ms; /* notification coalescing window, 0 if off */
+  uint16_t write_pack_ms;   /* write command packing window, 0 if off */
 } tGATT_REG;
 
 struct tGATT_CLCB;
@@ -240,6 +244,7 @@ typedef struct {
   tGATT_CLCB* p_clcb;
   uint8_t op_code;
   bool to_send;
+  uint64_t sent_ms; /* when the request went to L2CAP, 0 while queued */
 } tGATT_CMD_Q;
 
 #if GATT_MAX_SR_PROFILES <= 8
@@ -291,6 +296,29 @@ typedef struct hdl_list_elem {
   tGATT_SVC_DB svc_db;
 } tGATT_HDL_LIST_ELEM;
 
+/* A notification held back for coalescing */
+typedef struct {
+  uint16_t conn_id;
+  uint16_t lcid;
+  uint16_t handle;
+  std::vector<uint8_t> value;
+} tGATT_NTF_BATCH_ENTRY;
+
+/* Read By Type response built from static attributes only. It depends on the
+ * request, the payload size and the link security, see
+ * gatts_process_read_by_type_req */
+typedef struct {
+  uint16_t s_hdl;
+  uint16_t e_hdl;
+  bluetooth::Uuid type;
+  uint16_t payload_size;
+  tGATT_SEC_FLAG sec_flag;
+  uint8_t key_size;
+  tGATT_STATUS reason; /* GATT_SUCCESS, or the error that was sent */
+  uint16_t err_hdl;
+  std::vector<uint8_t> rsp; /* response PDU if reason is GATT_SUCCESS */
+} tGATT_RBT_CACHE_ENTRY;
+
 /* Data Structure used for GATT server                                        */
 /* A GATT registration record consists of a handle, and 1 or more attributes  */
 /* A service registration information record consists of beginning and ending */
@@ -337,6 +365,20 @@ typedef struct {
   std::queue<tGATT_CMD_Q> cl_cmd_q;
   alarm_t* ind_ack_timer; /* local app confirm to indication timer */
 
+  /* notifications waiting to be coalesced, all for the same bearer */
+  std::vector<tGATT_NTF_BATCH_ENTRY> ntf_batch;
+  alarm_t* ntf_batch_timer;
+  tGATTS_NTF_STATS ntf_stats;
+
+  /* write commands waiting to be packed, all for the ATT fixed channel */
+  std::vector<BT_HDR*> write_pack_q;
+  uint32_t write_pack_bytes;
+  alarm_t* write_pack_timer;
+
+  /* client latency and throughput counters, see GATTC_GetConnStats */
+  tGATTC_CONN_STATS cl_stats;
+  tGATT_BEARER_STATS att_bearer_stats; /* used when EATT is not supported */
+
   // TODO(hylo): support byte array data
   /* Client supported feature*/
   uint8_t cl_supp_feat;
@@ -404,12 +446,9 @@ typedef struct {
 
   std::vector<uint16_t> ind_no_credits_apps;
   std::vector<uint16_t> notif_no_credits_apps;
-} tGATT_EBCB;
 
-typedef struct {
-  uint16_t lcid;
-  uint8_t num_apps;
-} tGATT_APPS_EBCB;
+  tGATT_BEARER_STATS stats;
+} tGATT_EBCB;
 
 typedef struct {
   uint16_t conn_id;
@@ -527,6 +566,10 @@ typedef struct {
   tGATT_IF gatt_if;
   std::list<tGATT_HDL_LIST_ELEM>* hdl_list_info;
   std::list<tGATT_SRV_LIST_ELEM>* srv_list_info;
+  /* services of srv_list_info ordered by start handle, for binary search */
+  std::vector<std::list<tGATT_SRV_LIST_ELEM>::iterator> srv_range_index;
+  /* recently sent Read By Type responses, most recently used first */
+  std::list<tGATT_RBT_CACHE_ENTRY> read_by_type_cache;
 
   fixed_queue_t* srv_chg_clt_q; /* service change clients queue */
   tGATT_REG cl_rcb[GATT_MAX_APPS];
@@ -546,6 +589,8 @@ typedef struct {
 
   uint16_t handle_of_database_hash;
   Octet16 database_hash;
+  bool database_hash_dirty; /* database_hash needs to be computed again */
+  bool database_hash_pending; /* a background database_hash is in flight */
 
   tGATT_APPL_INFO cb_info;
 
@@ -666,6 +711,8 @@ extern bool gatt_auto_connect_dev_remove(tGATT_IF gatt_if,
 /* server function */
 extern std::list<tGATT_SRV_LIST_ELEM>::iterator gatt_sr_find_i_rcb_by_handle(
     uint16_t handle);
+extern void gatt_sr_update_srv_range_index();
+extern void gatts_invalidate_read_by_type_cache();
 extern tGATT_STATUS gatt_sr_process_app_rsp(tGATT_TCB& tcb, tGATT_IF gatt_if,
                                             uint32_t trans_id, uint8_t op_code,
                                             tGATT_STATUS status,
@@ -724,7 +771,9 @@ extern void gatt_end_operation(tGATT_CLCB* p_clcb, tGATT_STATUS status,
 extern void gatt_act_discovery(tGATT_CLCB* p_clcb);
 extern void gatt_act_read(tGATT_CLCB* p_clcb, uint16_t offset);
 extern void gatt_act_write(tGATT_CLCB* p_clcb, uint8_t sec_act);
-extern tGATT_CLCB* gatt_cmd_dequeue(tGATT_TCB& tcb, uint16_t lcid, uint8_t* p_opcode);
+extern tGATT_CLCB* gatt_cmd_dequeue(tGATT_TCB& tcb, uint16_t lcid,
+                                    uint8_t* p_opcode,
+                                    uint64_t* p_sent_ms = NULL);
 extern void gatt_cmd_enq(tGATT_TCB& tcb, tGATT_CLCB* p_clcb, tGATT_EBCB* p_eatt_bcb,
                          bool to_send, uint8_t op_code, BT_HDR* p_buf);
 extern void gatt_client_handle_server_rsp(tGATT_TCB& tcb, uint16_t lcid, uint8_t op_code,
@@ -770,6 +819,7 @@ extern tGATT_STATUS gatts_read_attr_perm_check(tGATT_SVC_DB* p_db, bool is_long,
                                                tGATT_SEC_FLAG sec_flag,
                                                uint8_t key_size);
 extern bluetooth::Uuid* gatts_get_service_uuid(tGATT_SVC_DB* p_db);
+extern tGATT_ATTR* find_attr_by_handle(tGATT_SVC_DB* p_db, uint16_t handle);
 extern void gatt_free_pending_ind(tGATT_TCB* p_tcb, uint16_t lcid);
 
 extern bool gatt_profile_sr_is_eatt_supported(uint16_t conn_id, uint16_t handle);
@@ -778,9 +828,36 @@ extern uint16_t gatt_get_db_hash_char_handle();
 
 extern void gatt_notify_eatt_congestion(tGATT_TCB* p_tcb, uint16_t cid, bool congested);
 
+/* gatt_sr_ntf.cc */
+extern tGATT_STATUS gatt_sr_ntf_batch_add(tGATT_TCB& tcb, uint16_t conn_id,
+                                          uint16_t lcid, uint16_t handle,
+                                          uint16_t len, uint8_t* p_val,
+                                          uint16_t window_ms);
+extern tGATT_STATUS gatt_sr_ntf_batch_flush(tGATT_TCB& tcb);
+extern bool gatt_sr_ntf_in_burst(tGATT_TCB& tcb);
+extern void gatt_sr_ntf_batch_free(tGATT_TCB& tcb);
+
+/* gatt_cl_pack.cc */
+extern tGATT_STATUS gatt_cl_pack_add(tGATT_TCB& tcb, BT_HDR* p_cmd,
+                                     uint16_t window_ms);
+extern tGATT_STATUS gatt_cl_pack_flush(tGATT_TCB& tcb);
+extern void gatt_cl_pack_free(tGATT_TCB& tcb);
+
+/* gatt_cl_stats.cc */
+extern void gatt_cl_stats_pdu_sent(tGATT_TCB& tcb, uint16_t lcid,
+                                   uint16_t len);
+extern void gatt_cl_stats_pdu_rcvd(tGATT_TCB& tcb, uint16_t lcid,
+                                   uint16_t len);
+extern void gatt_cl_stats_rsp_rcvd(tGATT_TCB& tcb, uint16_t lcid,
+                                   uint8_t req_op_code, uint64_t sent_ms);
+extern void gatt_cl_stats_value_rcvd(tGATT_TCB& tcb, bool is_indication,
+                                     uint16_t len);
+
 /* gatt_sr_hash.cc */
 extern Octet16 gatts_calculate_database_hash(
     std::list<tGATT_SRV_LIST_ELEM>* lst_ptr);
+extern void gatts_invalidate_database_hash();
+extern const Octet16& gatts_get_database_hash();
 
 // Saves DB hash
 extern void gatt_save_cl_db_hash(tGATT_TCB tcb);
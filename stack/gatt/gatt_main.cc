@@ -270,6 +270,13 @@ void gatt_free(void) {
     alarm_free(gatt_cb.tcb[i].ind_ack_timer);
     gatt_cb.tcb[i].ind_ack_timer = NULL;
 
+    alarm_free(gatt_cb.tcb[i].ntf_batch_timer);
+    gatt_cb.tcb[i].ntf_batch_timer = NULL;
+
+    gatt_cl_pack_free(gatt_cb.tcb[i]);
+    alarm_free(gatt_cb.tcb[i].write_pack_timer);
+    gatt_cb.tcb[i].write_pack_timer = NULL;
+
     fixed_queue_free(gatt_cb.tcb[i].sr_cmd.multi_rsp_q, NULL);
     gatt_cb.tcb[i].sr_cmd.multi_rsp_q = NULL;
   }
@@ -296,6 +303,8 @@ void gatt_free(void) {
     gatt_cb.hdl_list_info = nullptr;
   }
 
+  gatt_cb.srv_range_index.clear();
+  gatt_cb.read_by_type_cache.clear();
   if (gatt_cb.srv_list_info != nullptr) {
     gatt_cb.srv_list_info->clear();
     delete(gatt_cb.srv_list_info);
@@ -1720,6 +1729,8 @@ void gatt_data_process(tGATT_TCB& tcb, uint16_t lcid, BT_HDR* p_buf) {
     return;
   }
 
+  gatt_cl_stats_pdu_rcvd(tcb, lcid, p_buf->len);
+
   uint16_t msg_len = p_buf->len - 1;
   STREAM_TO_UINT8(op_code, p);
 
@@ -961,6 +961,39 @@ static void gatts_process_mtu_req(tGATT_TCB& tcb, uint16_t lcid, uint16_t len,
   }
 }
 
+/* Number of Read By Type responses kept by gatts_process_read_by_type_req */
+#define GATT_RBT_CACHE_SIZE 16
+
+/** Drops all cached Read By Type responses, called when the database changes */
+void gatts_invalidate_read_by_type_cache() { gatt_cb.read_by_type_cache.clear(); }
+
+static tGATT_RBT_CACHE_ENTRY* gatts_read_by_type_cache_find(
+    uint16_t s_hdl, uint16_t e_hdl, const Uuid& type, uint16_t payload_size,
+    tGATT_SEC_FLAG sec_flag, uint8_t key_size) {
+  std::list<tGATT_RBT_CACHE_ENTRY>& cache = gatt_cb.read_by_type_cache;
+  for (auto it = cache.begin(); it != cache.end(); it++) {
+    if (it->s_hdl != s_hdl || it->e_hdl != e_hdl || it->type != type ||
+        it->payload_size != payload_size || it->sec_flag != sec_flag ||
+        it->key_size != key_size)
+      continue;
+
+    cache.splice(cache.begin(), cache, it);
+    return &cache.front();
+  }
+  return NULL;
+}
+
+static void gatts_send_read_by_type_rsp(tGATT_TCB& tcb, uint16_t lcid,
+                                        BT_HDR* p_msg) {
+  tGATT_STATUS cmd_sent = attp_send_sr_msg(tcb, lcid, p_msg);
+  if (cmd_sent == GATT_NO_CREDITS) {
+    tGATT_EBCB* p_eatt_bcb = gatt_find_eatt_bcb_by_cid(&tcb, lcid);
+    if (tcb.is_eatt_supported && p_eatt_bcb) {
+      eatt_disc_rsp_enq(&tcb, p_eatt_bcb->cid, p_msg);
+    }
+  }
+}
+
 /*******************************************************************************
  *
  * Function         gatts_process_read_by_type_req
@@ -1002,8 +1035,34 @@ void gatts_process_read_by_type_req(tGATT_TCB& tcb, uint16_t lcid, uint8_t op_co
   }
 
   uint16_t payload_size = gatt_get_payload_size(&tcb, lcid);
+  uint8_t sec_flag, key_size;
+  gatt_sr_get_sec_info(tcb.peer_bda, tcb.transport, &sec_flag, &key_size);
 
   size_t msg_len = sizeof(BT_HDR) + payload_size + L2CAP_MIN_OFFSET;
+
+  /* Responses that only carry static attributes, e.g. characteristic
+   * discovery, are the same for every client with the same MTU and security,
+   * so they are answered from the cache */
+  tGATT_RBT_CACHE_ENTRY* p_cached = gatts_read_by_type_cache_find(
+      s_hdl, e_hdl, uuid, payload_size, sec_flag, key_size);
+  if (p_cached) {
+    if (p_cached->reason != GATT_SUCCESS) {
+      gatt_send_error_rsp(tcb, lcid, p_cached->reason, op_code,
+                          p_cached->err_hdl, false);
+      return;
+    }
+
+    BT_HDR* p_msg = (BT_HDR*)osi_malloc(msg_len);
+    p_msg->event = 0;
+    p_msg->layer_specific = 0;
+    p_msg->offset = L2CAP_MIN_OFFSET;
+    p_msg->len = p_cached->rsp.size();
+    memcpy((uint8_t*)(p_msg + 1) + L2CAP_MIN_OFFSET, p_cached->rsp.data(),
+           p_cached->rsp.size());
+    gatts_send_read_by_type_rsp(tcb, lcid, p_msg);
+    return;
+  }
+
   BT_HDR* p_msg = (BT_HDR*)osi_calloc(msg_len);
   uint8_t* p = (uint8_t*)(p_msg + 1) + L2CAP_MIN_OFFSET;
 
@@ -1012,12 +1071,11 @@ void gatts_process_read_by_type_req(tGATT_TCB& tcb, uint16_t lcid, uint8_t op_co
   p_msg->len = 2;
   uint16_t buf_len = payload_size - 2;
 
+  /* s_hdl is overwritten with the handle in error */
+  uint16_t cache_s_hdl = s_hdl;
   reason = GATT_NOT_FOUND;
   for (tGATT_SRV_LIST_ELEM& el : *gatt_cb.srv_list_info) {
     if (el.s_hdl <= e_hdl && el.e_hdl >= s_hdl) {
-      uint8_t sec_flag, key_size;
-      gatt_sr_get_sec_info(tcb.peer_bda, tcb.transport, &sec_flag, &key_size);
-
       tGATT_STATUS ret = gatts_db_read_attr_value_by_type(
           tcb, lcid, el.p_db, op_code, p_msg, s_hdl, e_hdl, uuid, &buf_len, sec_flag,
           key_size, 0, &err_hdl);
@@ -1035,6 +1093,26 @@ void gatts_process_read_by_type_req(tGATT_TCB& tcb, uint16_t lcid, uint8_t op_co
   *p = (uint8_t)p_msg->offset;
   p_msg->offset = L2CAP_MIN_OFFSET;
 
+  /* A pending application read means the response is not static */
+  if (reason != GATT_PENDING && reason != GATT_BUSY) {
+    std::list<tGATT_RBT_CACHE_ENTRY>& cache = gatt_cb.read_by_type_cache;
+    if (cache.size() >= GATT_RBT_CACHE_SIZE) cache.pop_back();
+
+    uint8_t* p_rsp = (uint8_t*)(p_msg + 1) + L2CAP_MIN_OFFSET;
+    cache.push_front(tGATT_RBT_CACHE_ENTRY{
+        .s_hdl = cache_s_hdl,
+        .e_hdl = e_hdl,
+        .type = uuid,
+        .payload_size = payload_size,
+        .sec_flag = sec_flag,
+        .key_size = key_size,
+        .reason = reason,
+        .err_hdl = s_hdl,
+        .rsp = (reason == GATT_SUCCESS)
+                   ? std::vector<uint8_t>(p_rsp, p_rsp + p_msg->len)
+                   : std::vector<uint8_t>()});
+  }
+
   if (reason != GATT_SUCCESS) {
     osi_free(p_msg);
 
@@ -1046,13 +1124,7 @@ void gatts_process_read_by_type_req(tGATT_TCB& tcb, uint16_t lcid, uint8_t op_co
     return;
   }
 
-  tGATT_STATUS cmd_sent = attp_send_sr_msg(tcb, lcid, p_msg);
-  if (cmd_sent == GATT_NO_CREDITS) {
-    tGATT_EBCB* p_eatt_bcb = gatt_find_eatt_bcb_by_cid(&tcb, lcid);
-    if (tcb.is_eatt_supported && p_eatt_bcb) {
-      eatt_disc_rsp_enq(&tcb, p_eatt_bcb->cid, p_msg);
-    }
-  }
+  gatts_send_read_by_type_rsp(tcb, lcid, p_msg);
 }
 
 /**
@@ -1245,32 +1317,30 @@ void gatts_process_attribute_req(tGATT_TCB& tcb, uint16_t lcid, uint8_t op_code,
 #endif
 
   if (GATT_HANDLE_IS_VALID(handle)) {
-    for (auto& el : *gatt_cb.srv_list_info) {
-      if (el.s_hdl <= handle && el.e_hdl >= handle) {
-        for (const auto& attr : el.p_db->attr_list) {
-          if (attr.handle == handle) {
-            switch (op_code) {
-              case GATT_REQ_READ: /* read char/char descriptor value */
-              case GATT_REQ_READ_BLOB:
-                gatts_process_read_req(tcb, lcid, el, op_code, handle, len, p);
-                break;
-
-              case GATT_REQ_WRITE: /* write char/char descriptor value */
-              case GATT_CMD_WRITE:
-              case GATT_SIGN_CMD_WRITE:
-              case GATT_REQ_PREPARE_WRITE:
-                gatts_process_write_req(tcb, lcid, el, handle, op_code, len, p,
-                                        attr.gatt_type);
-                break;
-              default:
-                break;
-            }
-            status = GATT_SUCCESS;
-            break;
-          }
-        }
-        break;
+    auto it = gatt_sr_find_i_rcb_by_handle(handle);
+    tGATT_ATTR* p_attr = nullptr;
+    if (it != gatt_cb.srv_list_info->end())
+      p_attr = find_attr_by_handle(it->p_db, handle);
+
+    if (p_attr) {
+      tGATT_SRV_LIST_ELEM& el = *it;
+      switch (op_code) {
+        case GATT_REQ_READ: /* read char/char descriptor value */
+        case GATT_REQ_READ_BLOB:
+          gatts_process_read_req(tcb, lcid, el, op_code, handle, len, p);
+          break;
+
+        case GATT_REQ_WRITE: /* write char/char descriptor value */
+        case GATT_CMD_WRITE:
+        case GATT_SIGN_CMD_WRITE:
+        case GATT_REQ_PREPARE_WRITE:
+          gatts_process_write_req(tcb, lcid, el, handle, op_code, len, p,
+                                  p_attr->gatt_type);
+          break;
+        default:
+          break;
       }
+      status = GATT_SUCCESS;
     }
   }
 
@@ -1431,13 +1501,12 @@ void gatts_process_value_conf(tGATT_TCB& tcb, uint16_t lcid, uint8_t op_code) {
   if (continue_processing) {
     tGATTS_DATA gatts_data;
     gatts_data.handle = handle;
-    for (auto& el : *gatt_cb.srv_list_info) {
-      if (el.s_hdl <= handle && el.e_hdl >= handle) {
-        uint32_t trans_id = gatt_sr_enqueue_cmd(tcb, lcid, op_code, handle);
-        uint16_t conn_id = GATT_CREATE_CONN_ID(tcb.tcb_idx, el.gatt_if);
-        gatt_sr_send_req_callback(conn_id, trans_id, GATTS_REQ_TYPE_CONF,
-                                  &gatts_data);
-      }
+    auto it = gatt_sr_find_i_rcb_by_handle(handle);
+    if (it != gatt_cb.srv_list_info->end()) {
+      uint32_t trans_id = gatt_sr_enqueue_cmd(tcb, lcid, op_code, handle);
+      uint16_t conn_id = GATT_CREATE_CONN_ID(tcb.tcb_idx, it->gatt_if);
+      gatt_sr_send_req_callback(conn_id, trans_id, GATTS_REQ_TYPE_CONF,
+                                &gatts_data);
     }
   }
 }
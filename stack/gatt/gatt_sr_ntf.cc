@@ -0,0 +1,300 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the GATT server notification coalescing. Notifications
+ *  an application sends to a client within its coalescing window are held
+ *  back and sent together, packed into one Multiple Handle Value Notification
+ *  PDU when the client supports it, or back to back otherwise.
+ *
+ ******************************************************************************/
+
+#include <base/logging.h>
+#include <base/strings/stringprintf.h>
+#include <stdio.h>
+
+#include <algorithm>
+
+#include "bt_common.h"
+#include "btif_storage.h"
+#include "gatt_api.h"
+#include "gatt_int.h"
+#include "osi/include/osi.h"
+#include "stack/gatt/eatt_int.h"
+
+using base::StringPrintf;
+
+/* Set between GATTS_NotificationBurstStart and GATTS_NotificationBurstEnd,
+ * with the links that got notifications in the burst. */
+static bool ntf_burst;
+static std::vector<uint8_t> ntf_burst_tcbs;
+
+/* Size of the Multiple Handle Value Notification PDU the batch would need. */
+static uint16_t gatt_sr_ntf_batch_size(const tGATT_TCB& tcb) {
+  uint16_t size = 1;
+  for (const tGATT_NTF_BATCH_ENTRY& entry : tcb.ntf_batch)
+    size += 4 + entry.value.size();
+  return size;
+}
+
+static void gatt_sr_ntf_batch_timeout(void* data) {
+  tGATT_TCB* p_tcb = gatt_get_tcb_by_idx(PTR_TO_UINT(data));
+  if (p_tcb == NULL || p_tcb->ntf_batch.empty()) return;
+
+  p_tcb->ntf_stats.flush_timeout++;
+  gatt_sr_ntf_batch_flush(*p_tcb);
+}
+
+/* Sends |entry| as a Handle Value Notification. */
+static tGATT_STATUS gatt_sr_ntf_send_single(tGATT_TCB& tcb,
+                                            tGATT_NTF_BATCH_ENTRY& entry) {
+  tGATT_SR_MSG gatt_sr_msg;
+  tGATT_VALUE& notif = gatt_sr_msg.attr_value;
+
+  notif.handle = entry.handle;
+  notif.len = entry.value.size();
+  memcpy(notif.value, entry.value.data(), notif.len);
+  notif.auth_req = GATT_AUTH_REQ_NONE;
+  notif.conn_id = entry.conn_id;
+
+  BT_HDR* p_buf = attp_build_sr_msg(tcb, entry.lcid, GATT_HANDLE_VALUE_NOTIF,
+                                    &gatt_sr_msg);
+  tGATT_STATUS status = attp_send_sr_msg(tcb, entry.lcid, p_buf);
+
+  if (status == GATT_NO_CREDITS) {
+    /* keep it for the EATT bearer to send once credits come back */
+    gatt_notif_enq(&tcb, entry.lcid, &notif);
+    status = GATT_CONGESTED;
+  }
+  return status;
+}
+
+/*******************************************************************************
+ *
+ * Function         gatt_sr_ntf_batch_add
+ *
+ * Description      Holds back a notification of |len| bytes at |p_val| for
+ *                  |handle| of |conn_id| on bearer |lcid|. The batch is sent once
+ *                  |window_ms| expired or no further notification fits it.
+ *
+ * Returns          GATT_SUCCESS if the notification was queued, otherwise the
+ *                  status of sending the batch.
+ *
+ ******************************************************************************/
+tGATT_STATUS gatt_sr_ntf_batch_add(tGATT_TCB& tcb, uint16_t conn_id,
+                                   uint16_t lcid, uint16_t handle,
+                                   uint16_t len, uint8_t* p_val,
+                                   uint16_t window_ms) {
+  tGATT_STATUS status = GATT_SUCCESS;
+  uint16_t payload_size = gatt_get_payload_size(&tcb, lcid);
+
+  /* a batch only ever holds notifications for one bearer */
+  if (!tcb.ntf_batch.empty() && tcb.ntf_batch.front().lcid != lcid)
+    status = gatt_sr_ntf_batch_flush(tcb);
+
+  if (!tcb.ntf_batch.empty() &&
+      gatt_sr_ntf_batch_size(tcb) + 4 + len > payload_size) {
+    tcb.ntf_stats.flush_full++;
+    status = gatt_sr_ntf_batch_flush(tcb);
+  }
+
+  tcb.ntf_batch.push_back(
+      {.conn_id = conn_id,
+       .lcid = lcid,
+       .handle = handle,
+       .value = std::vector<uint8_t>(p_val, p_val + len)});
+  tcb.ntf_stats.ntf_queued++;
+
+  if (tcb.ntf_batch.size() >= GATT_MAX_MULTI_HANDLE_NOTIF ||
+      gatt_sr_ntf_batch_size(tcb) + 4 >= payload_size) {
+    tcb.ntf_stats.flush_full++;
+    return gatt_sr_ntf_batch_flush(tcb);
+  }
+
+  /* without a window it waits for the end of the burst */
+  if (window_ms != 0 && !alarm_is_scheduled(tcb.ntf_batch_timer)) {
+    alarm_set_on_mloop(tcb.ntf_batch_timer, window_ms,
+                       gatt_sr_ntf_batch_timeout, UINT_TO_PTR(tcb.tcb_idx));
+  }
+  return status;
+}
+
+/*******************************************************************************
+ *
+ * Function         gatt_sr_ntf_batch_flush
+ *
+ * Description      Sends the notifications held back for |tcb|.
+ *
+ * Returns          GATT_SUCCESS or GATT_CONGESTED if sent, error otherwise.
+ *
+ ******************************************************************************/
+tGATT_STATUS gatt_sr_ntf_batch_flush(tGATT_TCB& tcb) {
+  alarm_cancel(tcb.ntf_batch_timer);
+  if (tcb.ntf_batch.empty()) return GATT_SUCCESS;
+
+  std::vector<tGATT_NTF_BATCH_ENTRY> batch;
+  batch.swap(tcb.ntf_batch);
+
+  uint16_t lcid = batch.front().lcid;
+  uint8_t cl_supp_feat = btif_storage_get_cl_supp_feat(tcb.peer_bda);
+  tGATT_STATUS status = GATT_SUCCESS;
+
+  if (batch.size() > 1 && (cl_supp_feat & CL_MULTI_NOTIF_SUPPORTED)) {
+    tGATT_MULTI_NOTIF multi_ntf;
+    multi_ntf.conn_id = 0;
+    multi_ntf.auth_req = GATT_AUTH_REQ_NONE;
+    multi_ntf.num_attr = batch.size();
+    for (uint8_t i = 0; i < multi_ntf.num_attr; i++) {
+      multi_ntf.handles[i] = batch[i].handle;
+      multi_ntf.lens[i] = batch[i].value.size();
+      multi_ntf.values.push_back(batch[i].value);
+    }
+
+    BT_HDR* p_buf =
+        attp_build_multi_ntf_cmd(gatt_get_payload_size(&tcb, lcid), multi_ntf);
+    status = attp_send_sr_msg(tcb, lcid, p_buf);
+    if (status == GATT_SUCCESS || status == GATT_CONGESTED) {
+      tcb.ntf_stats.multi_ntf_pdus++;
+      tcb.ntf_stats.multi_ntf_attrs += batch.size();
+      return status;
+    }
+
+    /* otherwise fall back to one PDU per notification, which also requeues
+     * them on a bearer that ran out of credits */
+    VLOG(1) << __func__ << ": multi notification not sent, status=" << +status;
+  }
+
+  for (tGATT_NTF_BATCH_ENTRY& entry : batch) {
+    tGATT_STATUS ret = gatt_sr_ntf_send_single(tcb, entry);
+    if (ret == GATT_SUCCESS || ret == GATT_CONGESTED) {
+      tcb.ntf_stats.single_ntf_pdus++;
+    } else {
+      tcb.ntf_stats.ntf_failed++;
+    }
+    if (ret != GATT_SUCCESS) status = ret;
+  }
+  return status;
+}
+
+/*******************************************************************************
+ *
+ * Function         gatt_sr_ntf_in_burst
+ *
+ * Description      Checks whether a notification burst is running, and if so
+ *                  remembers that |tcb| has to be flushed at its end.
+ *
+ * Returns          true if notifications to |tcb| are to be coalesced.
+ *
+ ******************************************************************************/
+bool gatt_sr_ntf_in_burst(tGATT_TCB& tcb) {
+  if (!ntf_burst) return false;
+
+  if (std::find(ntf_burst_tcbs.begin(), ntf_burst_tcbs.end(), tcb.tcb_idx) ==
+      ntf_burst_tcbs.end())
+    ntf_burst_tcbs.push_back(tcb.tcb_idx);
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         gatt_sr_ntf_batch_free
+ *
+ * Description      Drops the notifications held back for |tcb|, e.g. when the
+ *                  link went down.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void gatt_sr_ntf_batch_free(tGATT_TCB& tcb) {
+  alarm_cancel(tcb.ntf_batch_timer);
+  tcb.ntf_stats.ntf_failed += tcb.ntf_batch.size();
+  tcb.ntf_batch.clear();
+}
+
+void GATTS_SetNotificationCoalescing(tGATT_IF gatt_if, uint16_t window_ms) {
+  tGATT_REG* p_reg = gatt_get_regcb(gatt_if);
+  if (p_reg == NULL) {
+    LOG(ERROR) << __func__ << ": invalid gatt_if=" << +gatt_if;
+    return;
+  }
+
+  VLOG(1) << __func__ << ": gatt_if=" << +gatt_if
+          << " window_ms=" << window_ms;
+  p_reg->ntf_coalesce_ms = window_ms;
+
+  /* do not keep notifications waiting for a window that no longer exists */
+  if (window_ms == 0) {
+    for (int i = 0; i < GATT_MAX_PHY_CHANNEL; i++) {
+      tGATT_TCB& tcb = gatt_cb.tcb[i];
+      if (tcb.in_use) gatt_sr_ntf_batch_flush(tcb);
+    }
+  }
+}
+
+void GATTS_NotificationBurstStart(void) {
+  VLOG(1) << __func__;
+  ntf_burst = true;
+}
+
+void GATTS_NotificationBurstEnd(void) {
+  VLOG(1) << __func__ << ": links=" << ntf_burst_tcbs.size();
+  ntf_burst = false;
+
+  std::vector<uint8_t> tcbs;
+  tcbs.swap(ntf_burst_tcbs);
+  for (uint8_t tcb_idx : tcbs) {
+    tGATT_TCB* p_tcb = gatt_get_tcb_by_idx(tcb_idx);
+    if (p_tcb == NULL || p_tcb->ntf_batch.empty()) continue;
+
+    p_tcb->ntf_stats.flush_burst++;
+    gatt_sr_ntf_batch_flush(*p_tcb);
+  }
+}
+
+bool GATTS_GetNotificationStats(const RawAddress& bd_addr,
+                                tBT_TRANSPORT transport,
+                                tGATTS_NTF_STATS* p_stats) {
+  CHECK(p_stats != NULL);
+
+  tGATT_TCB* p_tcb = gatt_find_tcb_by_addr(bd_addr, transport);
+  if (p_tcb == NULL) return false;
+
+  *p_stats = p_tcb->ntf_stats;
+  return true;
+}
+
+void GATTS_DumpNotificationStats(int fd) {
+  dprintf(fd, "\nGATT server notification coalescing:\n");
+
+  for (int i = 0; i < GATT_MAX_PHY_CHANNEL; i++) {
+    const tGATT_TCB& tcb = gatt_cb.tcb[i];
+    if (!tcb.in_use) continue;
+
+    const tGATTS_NTF_STATS& stats = tcb.ntf_stats;
+    dprintf(fd, "  %s: pending=%zu queued=%u\n",
+            tcb.peer_bda.ToString().c_str(), tcb.ntf_batch.size(),
+            stats.ntf_queued);
+    dprintf(fd,
+            "    multi_pdus=%u multi_attrs=%u single_pdus=%u "
+            "flush_timeout=%u flush_full=%u flush_burst=%u failed=%u\n",
+            stats.multi_ntf_pdus, stats.multi_ntf_attrs, stats.single_ntf_pdus,
+            stats.flush_timeout, stats.flush_full, stats.flush_burst,
+            stats.ntf_failed);
+  }
+}
@@ -58,6 +58,7 @@
 #include "bt_utils.h"
 #include "osi/include/osi.h"
 #include "osi/include/properties.h"
+#include "osi/include/time.h"
 
 #include <string.h>
 #include "bt_common.h"
@@ -535,6 +536,8 @@ tGATT_TCB* gatt_allocate_tcb_by_bdaddr(const RawAddress& bda,
     p_tcb->pending_ind_q = fixed_queue_new(SIZE_MAX);
     p_tcb->conf_timer = alarm_new("gatt.conf_timer");
     p_tcb->ind_ack_timer = alarm_new("gatt.ind_ack_timer");
+    p_tcb->ntf_batch_timer = alarm_new("gatt.ntf_batch_timer");
+    p_tcb->write_pack_timer = alarm_new("gatt.write_pack_timer");
     p_tcb->in_use = true;
     p_tcb->tcb_idx = i;
     p_tcb->transport = transport;
@@ -542,6 +545,7 @@ tGATT_TCB* gatt_allocate_tcb_by_bdaddr(const RawAddress& bda,
     p_tcb->pending_user_mtu_exchange_value = 0;
     p_tcb->conn_ids_waiting_for_mtu_exchange = std::list<uint16_t>();
     p_tcb->max_user_mtu = 0;
+    p_tcb->cl_stats.start_ms = time_get_os_boottime_ms();
 
     if (stack_config_get_interface()->get_pts_configure_svc_chg_indication())
       p_tcb->svc_chg_cccd = btif_storage_get_svc_chg_cccd(bda);
@@ -955,15 +959,49 @@ void gatt_ind_ack_eatt_timeout(void* data) {
  ******************************************************************************/
 std::list<tGATT_SRV_LIST_ELEM>::iterator gatt_sr_find_i_rcb_by_handle(
     uint16_t handle) {
-  auto it = gatt_cb.srv_list_info->begin();
+  const auto& index = gatt_cb.srv_range_index;
 
-  for (; it != gatt_cb.srv_list_info->end(); it++) {
-    if (it->s_hdl <= handle && it->e_hdl >= handle) {
-      return it;
-    }
+  /* find the last service starting at or before the handle */
+  auto pos = std::upper_bound(
+      index.begin(), index.end(), handle,
+      [](uint16_t hdl, const std::list<tGATT_SRV_LIST_ELEM>::iterator& el) {
+        return hdl < el->s_hdl;
+      });
+  if (pos != index.begin()) {
+    auto it = *(pos - 1);
+    if (it->e_hdl >= handle) return it;
   }
 
-  return it;
+  return gatt_cb.srv_list_info->end();
+}
+
+/*******************************************************************************
+ *
+ * Function         gatt_sr_update_srv_range_index
+ *
+ * Description      Rebuild the handle range index of the registered services.
+ *                  Must be called whenever a service is added to or removed
+ *                  from gatt_cb.srv_list_info.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void gatt_sr_update_srv_range_index() {
+  gatt_cb.srv_range_index.clear();
+  if (gatt_cb.srv_list_info == nullptr) return;
+
+  gatt_cb.srv_range_index.reserve(gatt_cb.srv_list_info->size());
+  for (auto it = gatt_cb.srv_list_info->begin();
+       it != gatt_cb.srv_list_info->end(); it++) {
+    gatt_cb.srv_range_index.push_back(it);
+  }
+
+  std::stable_sort(
+      gatt_cb.srv_range_index.begin(), gatt_cb.srv_range_index.end(),
+      [](const std::list<tGATT_SRV_LIST_ELEM>::iterator& a,
+         const std::list<tGATT_SRV_LIST_ELEM>::iterator& b) {
+        return a->s_hdl < b->s_hdl;
+      });
 }
 
 /*******************************************************************************
@@ -1455,6 +1493,7 @@ void gatt_cmd_enq(tGATT_TCB& tcb, tGATT_CLCB* p_clcb, tGATT_EBCB* p_eatt_bcb,
   cmd.op_code = op_code;
   cmd.p_cmd = p_buf;
   cmd.p_clcb = p_clcb;
+  cmd.sent_ms = to_send ? 0 : time_get_os_boottime_ms();
 
   if (!to_send) {
     // TODO: WTF why do we clear the queue here ?!
@@ -1475,7 +1514,8 @@ void gatt_cmd_enq(tGATT_TCB& tcb, tGATT_CLCB* p_clcb, tGATT_EBCB* p_eatt_bcb,
 }
 
 /** dequeue the command in the client CCB command queue */
-tGATT_CLCB* gatt_cmd_dequeue(tGATT_TCB& tcb, uint16_t lcid, uint8_t* p_op_code) {
+tGATT_CLCB* gatt_cmd_dequeue(tGATT_TCB& tcb, uint16_t lcid, uint8_t* p_op_code,
+                             uint64_t* p_sent_ms) {
   std::queue<tGATT_CMD_Q>* cl_cmd_q = &tcb.cl_cmd_q;
   tGATT_EBCB* p_eatt_bcb;
 
@@ -1497,6 +1537,7 @@ tGATT_CLCB* gatt_cmd_dequeue(tGATT_TCB& tcb, uint16_t lcid, uint8_t* p_op_code)
   tGATT_CMD_Q cmd = cl_cmd_q->front();
   tGATT_CLCB* p_clcb = cmd.p_clcb;
   *p_op_code = cmd.op_code;
+  if (p_sent_ms) *p_sent_ms = cmd.sent_ms;
   cl_cmd_q->pop();
 
   return p_clcb;
@@ -1645,6 +1686,13 @@ void gatt_cleanup_upon_disc(const RawAddress& bda, uint16_t reason,
   alarm_cancel(p_tcb->conf_timer);
   alarm_free(p_tcb->conf_timer);
   p_tcb->conf_timer = NULL;
+
+  gatt_sr_ntf_batch_free(*p_tcb);
+  alarm_free(p_tcb->ntf_batch_timer);
+  p_tcb->ntf_batch_timer = NULL;
+  gatt_cl_pack_free(*p_tcb);
+  alarm_free(p_tcb->write_pack_timer);
+  p_tcb->write_pack_timer = NULL;
   fixed_queue_free(p_tcb->sr_cmd.multi_rsp_q, NULL);
   p_tcb->sr_cmd.multi_rsp_q = NULL;
 
@@ -1347,6 +1347,35 @@ void btsnd_hci_ble_cancel_period_sync() {
   btu_hcif_send_cmd(LOCAL_BR_EDR_CONTROLLER_ID, p);
 }
 
+void btsnd_hcic_ble_add_periodic_adv_list(
+    uint8_t address_type, const RawAddress& bda, uint8_t adv_sid,
+    base::Callback<void(uint8_t*, uint16_t)> cb) {
+  const int param_len = 8;
+  uint8_t param[param_len];
+  uint8_t* pp = param;
+
+  UINT8_TO_STREAM(pp, address_type);
+  BDADDR_TO_STREAM(pp, bda);
+  UINT8_TO_STREAM(pp, adv_sid);
+
+  btu_hcif_send_cmd_with_cb(FROM_HERE,
+                            HCI_LE_ADD_DEVICE_TO_PERIODIC_ADVERTISER_LIST,
+                            param, param_len, std::move(cb));
+}
+
+void btsnd_hcic_ble_clear_periodic_adv_list(
+    base::Callback<void(uint8_t*, uint16_t)> cb) {
+  btu_hcif_send_cmd_with_cb(FROM_HERE, HCI_LE_CLEAR_PERIODIC_ADVERTISER_LIST,
+                            nullptr, 0, std::move(cb));
+}
+
+void btsnd_hcic_ble_read_periodic_adv_list_size(
+    base::Callback<void(uint8_t*, uint16_t)> cb) {
+  btu_hcif_send_cmd_with_cb(FROM_HERE,
+                            HCI_LE_READ_PERIODIC_ADVERTISER_LIST_SIZE, nullptr,
+                            0, std::move(cb));
+}
+
 void btsnd_hcic_ble_pa_sync_tx(uint16_t conn_handle,
                                uint16_t service_data,
                                uint16_t sync_handle,
@@ -532,6 +532,9 @@ static void hidh_l2cif_config_ind(uint16_t l2cap_cid, tL2CAP_CFG_INFO* p_cfg) {
     p_hcon->conn_state = HID_CONN_STATE_CONNECTED;
     /* Reset disconnect reason to success, as connection successful */
     p_hcon->disc_reason = HID_SUCCESS;
+#if (HID_HOST_LOW_LATENCY == TRUE)
+    L2CA_SetTxPriority(p_hcon->intr_cid, L2CAP_CHNL_PRIORITY_HIGH);
+#endif
 
     hh_cb.devices[dhandle].state = HID_DEV_CONNECTED;
     hh_cb.callback(dhandle, hh_cb.devices[dhandle].addr, HID_HDEV_EVT_OPEN, 0,
@@ -614,6 +617,9 @@ static void hidh_l2cif_config_cfm(uint16_t l2cap_cid, tL2CAP_CFG_INFO* p_cfg) {
     p_hcon->conn_state = HID_CONN_STATE_CONNECTED;
     /* Reset disconnect reason to success, as connection successful */
     p_hcon->disc_reason = HID_SUCCESS;
+#if (HID_HOST_LOW_LATENCY == TRUE)
+    L2CA_SetTxPriority(p_hcon->intr_cid, L2CAP_CHNL_PRIORITY_HIGH);
+#endif
 
     hh_cb.devices[dhandle].state = HID_DEV_CONNECTED;
     hh_cb.callback(dhandle, hh_cb.devices[dhandle].addr, HID_HDEV_EVT_OPEN, 0,
@@ -32,6 +32,8 @@
 #include <map>
 #include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <hardware/bt_av.h>
 
@@ -156,6 +158,20 @@ bool getCodecSpecificConfig(tBT_A2DP_OFFLOAD* p_a2dp_offload);
                               bool is_capability,
                               uint8_t* p_result_codec_config) = 0;
 
+  // Same as |setCodecConfig|, but reuses the result of the last successful
+  // negotiation when the inputs are unchanged: the same |p_peer_codec_info|
+  // and |is_capability|, the same user and audio configuration, and no other
+  // change to the codec state since. The result codec configuration is
+  // stored in |p_result_codec_config|.
+  // Returns true on success, othewise false.
+  bool negotiateCodecConfig(const uint8_t* p_peer_codec_info,
+                            bool is_capability,
+                            uint8_t* p_result_codec_config);
+
+  // Drops the memoized negotiation result. Must be called whenever the codec
+  // state is changed other than through |negotiateCodecConfig|.
+  void invalidateNegotiation();
+
   // Sets the user prefered codec configuration.
   // |codec_user_config| contains the preferred codec user configuration.
   // |codec_audio_config| contains the selected audio feeding configuration.
@@ -271,6 +287,20 @@ bool getCodecSpecificConfig(tBT_A2DP_OFFLOAD* p_a2dp_offload);
   btav_a2dp_codec_config_t codec_audio_config_;
 
   uint8_t ota_codec_peer_capability_[AVDT_CODEC_SIZE];
+
+  // The inputs and the result of the last successful negotiation, see
+  // |negotiateCodecConfig|.
+  bool negotiation_valid_ = false;
+  bool negotiated_is_capability_ = false;
+  uint8_t negotiated_peer_codec_info_[AVDT_CODEC_SIZE];
+  uint8_t negotiated_result_codec_config_[AVDT_CODEC_SIZE];
+  btav_a2dp_codec_config_t negotiated_user_config_;
+  btav_a2dp_codec_config_t negotiated_audio_config_;
+  size_t negotiation_run_count_ = 0;
+  size_t negotiation_reuse_count_ = 0;
+
+  // Moves on whenever the codec state may have changed
+  uint32_t state_generation_ = 0;
 };
 
 class A2dpCodecs {
@@ -448,6 +478,14 @@ class A2dpCodecs {
   std::list<A2dpCodecConfig*> ordered_sink_codecs_;
 
   std::map<RawAddress, IndexedCodecs*, CompareBtBdaddr> peer_codecs_;
+
+  // Capabilities last built by |getCodecConfigAndCapabilities|. They are
+  // reused while the Source codecs are in the same order and each codec is
+  // still at the state generation recorded in |capabilities_generations_|.
+  std::vector<std::pair<const A2dpCodecConfig*, uint32_t>>
+      capabilities_generations_;
+  std::vector<btav_a2dp_codec_config_t> cached_local_capabilities_;
+  std::vector<btav_a2dp_codec_config_t> cached_selectable_capabilities_;
 };
 
 /**
@@ -508,6 +546,17 @@ typedef struct {
 
   // Set transmit queue length for the A2DP encoder.
   void (*set_transmit_queue_length)(size_t transmit_queue_length);
+
+  // Encode whole frames from the |pcm_len| octets of contiguous PCM data at
+  // |p_pcm| directly into the media payload of |p_buf|, behind the
+  // |p_buf->len| octets already there. The PCM data must be in the feeding
+  // format the encoder was initialized with. Encoding stops when the PCM data
+  // runs out or the next frame would not fit the packet. |p_buf->len| and the
+  // frame count in |p_buf->layer_specific| are updated.
+  // Returns the number of PCM octets consumed.
+  // May be NULL if the codec can only encode through |send_frames|.
+  uint32_t (*encode_batch)(const uint8_t* p_pcm, uint32_t pcm_len,
+                           BT_HDR* p_buf);
 } tA2DP_ENCODER_INTERFACE;
 
 // Gets peer sink endpoint codec type.
@@ -689,6 +738,13 @@ bool A2DP_IsScramblingSupported();
 bool A2DP_Is44p1kFreqSupported();
 bool A2DP_IsCodecEnabled(btav_a2dp_codec_index_t codec_index);
 bool A2DP_IsCodecEnabledInSoftware(btav_a2dp_codec_index_t codec_index);
+
+// Starts loading the libraries of all codecs enabled in software, each on
+// its own worker thread, so the libraries load in parallel rather than one
+// after the other in |A2dpCodecs::init|. Must be called after
+// |A2DP_SetOffloadStatus|. |A2dpCodecConfig::createCodec| waits for the load
+// of the codec it creates.
+void A2DP_LoadCodecLibraries(void);
 bool A2DP_Get_AAC_VBR_Status(const RawAddress *remote_bdaddr);
 bool A2DP_Get_Aptx_AdaptiveR2_1_Supported();
 bool A2DP_Get_Aptx_AdaptiveR2_2_Supported();
@@ -0,0 +1,104 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  Interface to the polyphase FIR resampler used to feed codecs with PCM at
+ *  a different sample rate than the audio source provides.
+ *
+ ******************************************************************************/
+#ifndef A2DP_RESAMPLER_H
+#define A2DP_RESAMPLER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct a2dp_resampler_t a2dp_resampler_t;
+
+/*******************************************************************************
+ *
+ * Function         a2dp_resampler_new
+ *
+ * Description      Create a resampler that converts PCM at |src_sps| samples
+ *                  per second to |dst_sps|. The input has |bits| bits per
+ *                  sample (8 or 16) and |n_channels| channels (1 or 2). The
+ *                  output is always 16 bits per sample stereo, mono input is
+ *                  duplicated to both channels. The filter coefficients are
+ *                  computed here, so that streaming does not compute any.
+ *
+ * Returns          The resampler, to be freed with a2dp_resampler_free(), or
+ *                  NULL if the conversion is not supported.
+ *
+ ******************************************************************************/
+a2dp_resampler_t* a2dp_resampler_new(uint32_t src_sps, uint32_t dst_sps,
+                                     uint8_t bits, uint8_t n_channels);
+
+/*******************************************************************************
+ *
+ * Function         a2dp_resampler_free
+ *
+ * Description      Free |resampler|. It may be NULL.
+ *
+ * Returns          none
+ *
+ ******************************************************************************/
+void a2dp_resampler_free(a2dp_resampler_t* resampler);
+
+/*******************************************************************************
+ *
+ * Function         a2dp_resampler_reset
+ *
+ * Description      Clear the filter history of |resampler|, e.g. after the
+ *                  audio stream was flushed.
+ *
+ * Returns          none
+ *
+ ******************************************************************************/
+void a2dp_resampler_reset(a2dp_resampler_t* resampler);
+
+/*******************************************************************************
+ *
+ * Function         a2dp_resampler_process
+ *
+ * Description      Resample the |src_len| bytes of PCM at |p_src| into the
+ *                  |dst_len| bytes at |p_dst|. The state carries over from
+ *                  one call to the next, so a stream can be resampled in
+ *                  chunks of any size.
+ *
+ * Returns          The number of bytes written to p_dst
+ *                  The number of bytes used from p_src (in *p_src_used)
+ *
+ ******************************************************************************/
+uint32_t a2dp_resampler_process(a2dp_resampler_t* resampler, const void* p_src,
+                                uint32_t src_len, int16_t* p_dst,
+                                uint32_t dst_len, uint32_t* p_src_used);
+
+/*******************************************************************************
+ *
+ * Function         a2dp_resampler_set_simd_enabled
+ *
+ * Description      Allow or forbid the NEON and SSE2 kernels. They are used
+ *                  by default when the CPU supports them. The output is bit
+ *                  exact either way, this lets tests and benchmarks compare.
+ *
+ * Returns          none
+ *
+ ******************************************************************************/
+void a2dp_resampler_set_simd_enabled(bool enabled);
+
+#endif  // A2DP_RESAMPLER_H
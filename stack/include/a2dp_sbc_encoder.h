@@ -60,6 +60,13 @@ period_ms_t a2dp_sbc_get_encoder_interval_ms(void);
 // |timestamp_us| is the current timestamp (in microseconds).
 void a2dp_sbc_send_frames(uint64_t timestamp_us);
 
+// Encode SBC frames from the |pcm_len| octets of contiguous PCM data at
+// |p_pcm| directly into the media payload of |p_buf|. The PCM data must be at
+// the SBC sampling rate - no upsampling is done here.
+// Returns the number of PCM octets consumed.
+uint32_t a2dp_sbc_encode_batch(const uint8_t* p_pcm, uint32_t pcm_len,
+                               BT_HDR* p_buf);
+
 // Calculsate sbc bitrate for offload mode
 // |a2dp_codec_config| is codec config
 // |peer_edr| flag for peer supports edr
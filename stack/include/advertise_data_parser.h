@@ -34,6 +34,8 @@ static constexpr std::array<uint8_t, 18> trx_quirk{
      0x00, 0xE8, 0x03, 0x02, 0x0A, 0x00}};
 
 class AdvertiseDataParser {
+  friend class AdvertiseDataIndex;
+
   // Return true if the packet is malformed, but should be considered valid for
   // compatibility with already existing devices
   static bool MalformedPacketQuirk(const std::vector<uint8_t>& ad,
@@ -52,10 +54,14 @@ class AdvertiseDataParser {
   }
 
  public:
-  static void RemoveTrailingZeros(std::vector<uint8_t>& ad) {
+  /**
+   * Return the length of the |ad| array of length |ad_len| once the zero
+   * padding at its end is cut, see |RemoveTrailingZeros|.
+   */
+  static size_t GetLengthWithoutTrailingZeros(const uint8_t* ad,
+                                              size_t ad_len) {
     size_t position = 0;
 
-    size_t ad_len = ad.size();
     while (position < ad_len) {
       uint8_t len = ad[position];
 
@@ -64,17 +70,18 @@ class AdvertiseDataParser {
       // end of advertisement. If this is the case, cut the zero padding from
       // end of the packet. Otherwise i.e. gluing scan response to advertise
       // data will result in data with zero padding in the middle.
-      if (len == 0) {
-        ad.erase(ad.begin() + position, ad.end());
-        return;
-      }
+      if (len == 0) return position;
 
-      if (position + len >= ad_len) {
-        return;
-      }
+      if (position + len >= ad_len) return ad_len;
 
       position += len + 1;
     }
+
+    return ad_len;
+  }
+
+  static void RemoveTrailingZeros(std::vector<uint8_t>& ad) {
+    ad.resize(GetLengthWithoutTrailingZeros(ad.data(), ad.size()));
   }
 
   /**
@@ -178,3 +185,82 @@ class AdvertiseDataParser {
     return enc_adv_map;
   }
 };
+
+/**
+ * Index of the fields of advertising data, built in a single pass. It records
+ * where the first field of each AD type is located, which is the field
+ * |AdvertiseDataParser::GetFieldByType| would return, and whether the data is
+ * valid as per |AdvertiseDataParser::IsValid|. The index points into the data
+ * it was built from, which must outlive it and must not be modified.
+ */
+class AdvertiseDataIndex {
+ public:
+  explicit AdvertiseDataIndex(const std::vector<uint8_t>& ad) { Build(ad); }
+
+  /* Rebuild the index from |ad|, e.g. after the data was rewritten */
+  void Build(const std::vector<uint8_t>& ad) {
+    data_ = ad.data();
+    size_ = ad.size();
+    valid_ = true;
+    offset_.fill(0);
+    length_.fill(0);
+
+    size_t position = 0;
+    while (position < size_) {
+      uint8_t len = data_[position];
+
+      // Zero padding ends the fields; the data is valid only if nothing but
+      // zeros follows.
+      if (len == 0) {
+        for (size_t i = position + 1; i < size_; i++) {
+          if (data_[i] != 0) {
+            valid_ = false;
+            break;
+          }
+        }
+        return;
+      }
+
+      if (position + len >= size_) {
+        valid_ = AdvertiseDataParser::MalformedPacketQuirk(ad, position);
+        return;
+      }
+
+      uint8_t type = data_[position + 1];
+      if (offset_[type] == 0) {
+        /* the field data always starts after the length and type octets, so
+         * an offset of 0 means the type is not present */
+        offset_[type] = position + 2;
+        length_[type] = len - 1;
+      }
+
+      position += len + 1;
+    }
+  }
+
+  /* Return true if the indexed data is properly formatted */
+  bool IsValid() const { return valid_; }
+
+  /* Return true if a field of |type| is present */
+  bool HasField(uint8_t type) const { return offset_[type] != 0; }
+
+  /**
+   * Return a pointer to first field of |type|, together with its length in
+   * |p_length|, or NULL if there is no such field.
+   */
+  const uint8_t* GetFieldByType(uint8_t type, uint8_t* p_length) const {
+    *p_length = length_[type];
+    return offset_[type] ? data_ + offset_[type] : NULL;
+  }
+
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+ private:
+  const uint8_t* data_;
+  size_t size_;
+  bool valid_;
+  std::array<uint32_t, 256> offset_;
+  std::array<uint8_t, 256> length_;
+};
@@ -82,6 +82,19 @@
 */
 #define AVDT_MEDIA_OFFSET 23
 
+/* The size in bytes of the content protection header of a media packet. */
+#define AVDT_CP_HDR_SIZE 1
+
+/* The headroom to reserve in front of the payload of a media packet that
+ * carries a codec specific header of |codec_hdr_len| bytes. It covers the
+ * worst case of the headers prepended on the way to HCI: codec header,
+ * content protection header, media packet header, L2CAP and HCI headers.
+ * Since the headers are built in place, a packet allocated with this headroom
+ * is never copied before it reaches the HCI transport.
+*/
+#define AVDT_MEDIA_HEADROOM(codec_hdr_len) \
+  (AVDT_MEDIA_OFFSET + AVDT_CP_HDR_SIZE + (codec_hdr_len))
+
 /* The marker bit is used by the application to mark significant events such
  * as frame boundaries in the data stream.  This constant is used to check or
  * set the marker bit in the m_pt parameter of an AVDT_WriteReq()
@@ -890,6 +903,36 @@ extern uint16_t AVDT_WriteReqOpt(uint8_t handle, BT_HDR* p_pkt,
                                  uint32_t time_stamp, uint8_t m_pt,
                                  tAVDT_DATA_OPT_MASK opt);
 
+/*******************************************************************************
+ *
+ * Function         AVDT_MediaBufAlloc
+ *
+ * Description      Allocate a buffer of |buf_size| bytes, including the
+ *                  BT_HDR, for an encoder to write a media packet payload
+ *                  into. The offset is set to
+ *                  AVDT_MEDIA_HEADROOM(|codec_hdr_len|) and the length to 0,
+ *                  so that all headers can be prepended without a copy.
+ *
+ * Returns          The buffer, to be freed with osi_free() or passed to
+ *                  AVDT_WriteReq().
+ *
+ ******************************************************************************/
+extern BT_HDR* AVDT_MediaBufAlloc(uint16_t buf_size, uint16_t codec_hdr_len);
+
+/*******************************************************************************
+ *
+ * Function         AVDT_MediaBufPrepend
+ *
+ * Description      Grow the media packet |p_buf| by |len| bytes at the front
+ *                  and return a pointer to them for a header to be written.
+ *                  The headroom is never reallocated.
+ *
+ * Returns          Pointer to the header, or NULL if the headroom left in
+ *                  |p_buf| is smaller than |len|.
+ *
+ ******************************************************************************/
+extern uint8_t* AVDT_MediaBufPrepend(BT_HDR* p_buf, uint16_t len);
+
 /*******************************************************************************
  *
  * Function         AVDT_ConnectReq
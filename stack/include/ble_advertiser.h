@@ -108,6 +108,9 @@ class BleAdvertisingManager {
   static bool IsInitialized();
   static base::WeakPtr<BleAdvertisingManager> Get();
 
+  /* Dumps the state of the advertising multiplexer into |fd|. */
+  static void DebugDump(int fd);
+
   /* Register an advertising instance, status will be returned in |cb|
    * callback, with assigned id, if operation succeeds. Instance is freed when
    * advertising is disabled by calling |BTM_BleDisableAdvInstance|, or when any
@@ -311,6 +311,21 @@ extern tBNEP_RESULT BNEP_WriteBuf(uint16_t handle,
                                   const RawAddress* p_src_addr,
                                   bool fw_ext_present);
 
+/*******************************************************************************
+ *
+ * Function         BNEP_IsTxQueueFull
+ *
+ * Description      This function tells if BNEP_WriteBuf on the connection
+ *                  would fail with BNEP_Q_SIZE_EXCEEDED, so that a caller can
+ *                  hold on to its buffer instead.
+ *
+ * Parameters:      handle       - handle of the connection
+ *
+ * Returns          true if the transmit queue is full
+ *
+ ******************************************************************************/
+extern bool BNEP_IsTxQueueFull(uint16_t handle);
+
 /*******************************************************************************
  *
  * Function         BNEP_Write
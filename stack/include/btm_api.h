@@ -845,6 +845,21 @@ extern void BTM_SetDefaultLinkSuperTout(uint16_t timeout);
  ******************************************************************************/
 extern tBTM_STATUS BTM_SetLinkSuperTout(const RawAddress& remote_bda,
                                         uint16_t timeout);
+
+/*******************************************************************************
+ *
+ * Function         BTM_ExcludeAclPacketTypes
+ *
+ * Description      Restricts the ACL packet types of the link to the ones
+ *                  supported by both devices, minus the EDR packet types in
+ *                  |excluded| (BTM_ACL_PKT_TYPES_MASK_NO_* bits). Passing 0
+ *                  allows all packet types again.
+ *
+ * Returns          BTM_CMD_STARTED if successfully initiated, otherwise error
+ *
+ ******************************************************************************/
+extern tBTM_STATUS BTM_ExcludeAclPacketTypes(const RawAddress& remote_bda,
+                                             uint16_t excluded);
 /*******************************************************************************
  *
  * Function         BTM_GetLinkSuperTout
@@ -1518,6 +1533,53 @@ extern bool BTM_SecAddDevice(const RawAddress& bd_addr, DEV_CLASS dev_class,
                              uint8_t key_type, tBTM_IO_CAP io_cap,
                              uint8_t pin_length);
 
+/* Called with the address of a device which is not in the security database,
+ * so that it can be restored from NVRAM. Returns true if it was added with
+ * BTM_SecAddDevice. */
+typedef bool(tBTM_SEC_DEV_LOADER)(const RawAddress& bd_addr);
+
+/*******************************************************************************
+ *
+ * Function         BTM_SecRegisterDevLoader
+ *
+ * Description      Register |p_loader| to be called when a device is looked
+ *                  up but has no security record, to let bonded devices be
+ *                  added on first use instead of at startup. NULL clears it.
+ *
+ ******************************************************************************/
+extern void BTM_SecRegisterDevLoader(tBTM_SEC_DEV_LOADER* p_loader);
+
+/* Called on the first BR/EDR connection of a device in the security database
+ * to restore its cached connection profile. Returns true if |p_profile| was
+ * filled with values recent enough to be trusted. */
+typedef bool(tBTM_CONN_PROFILE_LOADER)(const RawAddress& bd_addr,
+                                       tBTM_CONN_PROFILE* p_profile);
+
+/*******************************************************************************
+ *
+ * Function         BTM_SecRegisterConnProfileLoader
+ *
+ * Description      Register |p_loader| to restore the remote version and
+ *                  features of bonded devices, so that their connections do
+ *                  not read them again. NULL clears it.
+ *
+ ******************************************************************************/
+extern void BTM_SecRegisterConnProfileLoader(
+    tBTM_CONN_PROFILE_LOADER* p_loader);
+
+/*******************************************************************************
+ *
+ * Function         BTM_SecReadConnProfile
+ *
+ * Description      Read the remote version and features known for |bd_addr|,
+ *                  either read on a connection or restored by the loader.
+ *
+ * Returns          true if the device has a security record
+ *
+ ******************************************************************************/
+extern bool BTM_SecReadConnProfile(const RawAddress& bd_addr,
+                                   tBTM_CONN_PROFILE* p_profile);
+
 /** Free resources associated with the device associated with |bd_addr| address.
  *
  * *** WARNING ***
@@ -882,6 +882,18 @@ typedef uint16_t tBTM_BL_EVENT_MASK;
 #define BTM_FEATURE_BYTES_PER_PAGE HCI_FEATURE_BYTES_PER_PAGE
 #define BTM_EXT_FEATURES_PAGE_MAX HCI_EXT_FEATURES_PAGE_MAX
 
+/* What a BR/EDR connection reads from the remote device before it is set up.
+ * Cached for bonded devices so that a reconnection can skip the reads. */
+typedef struct {
+  uint8_t feature_pages[BTM_EXT_FEATURES_PAGE_MAX + 1]
+                       [BTM_FEATURE_BYTES_PER_PAGE];
+  uint8_t num_read_pages; /* 0 if the features are not known */
+  bool version_known;
+  uint8_t lmp_version;
+  uint16_t manufacturer;
+  uint16_t lmp_subversion;
+} tBTM_CONN_PROFILE;
+
 /* the data type associated with BTM_BL_CONN_EVT */
 typedef struct {
   tBTM_BL_EVENT event;     /* The event reported. */
@@ -382,6 +382,37 @@ extern bool BTM_ReadRemoteConnectionAddr(const RawAddress& pseudo_addr,
 extern void BTM_BleLoadLocalKeys(uint8_t key_type, tBTM_BLE_LOCAL_KEYS* p_key);
 
 
+/*******************************************************************************
+ *
+ * Function         BTM_BleResolvingListBatch
+ *
+ * Description      Start or end a batch of BTM_SecAddBleKey calls, whose
+ *                  identity keys go to the controller resolving list with a
+ *                  single address resolution disable/enable cycle.
+ *
+ * Parameters:      start - true to start a batch, false to end it.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+extern void BTM_BleResolvingListBatch(bool start);
+
+/*******************************************************************************
+ *
+ * Function         BTM_BleSyncResolvingList
+ *
+ * Description      Bring the controller resolving list in line with the
+ *                  identity keys known to the stack, with a single address
+ *                  resolution disable/enable cycle.
+ *
+ * Parameters:      p_cback - called once when the synchronization completes.
+ *
+ * Returns          BTM_CMD_STARTED if started, BTM_BUSY if one is running,
+ *                  BTM_MODE_UNSUPPORTED without controller based privacy.
+ *
+ ******************************************************************************/
+extern tBTM_STATUS BTM_BleSyncResolvingList(tBTM_BLE_RL_SYNC_CBACK* p_cback);
+
 /********************************************************
  *
  * Function         BTM_BleSetPrefConnParams
@@ -1408,6 +1439,24 @@ extern void BTM_BleStopPeriodicSync(uint16_t handle);
  ******************************************************************************/
 extern void BTM_BleCancelPeriodicSync(uint8_t adv_sid, RawAddress address);
 
+#define BTM_BLE_PERIODIC_SYNC_PRIORITY_DEFAULT 0
+/*******************************************************************************
+ *
+ * Function         BTM_BleSetPeriodicSyncPriority
+ *
+ * Description      This function is called to set how important the sync to
+ *                  a PA train is. When several syncs are waiting for the
+ *                  controller, the ones with higher priority are requested
+ *                  first.
+ *
+ * Parameters       adv sid, address corrosponds to PA train, priority
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+extern void BTM_BleSetPeriodicSyncPriority(uint8_t adv_sid, RawAddress address,
+                                           uint8_t priority);
+
 using SyncTransferCb = base::Callback<void(uint8_t /*status*/, RawAddress)>;
 
 /*******************************************************************************
@@ -429,6 +429,9 @@ typedef struct {
   tBLE_ADDR_TYPE addr_type;
   tBTM_BLE_DISCARD_RULE discard_rule;
   tBTM_BLE_SCAN_THRESHOLD_CBACK* p_thres_cback;
+  /* deliver each controller read as it completes instead of the whole buffer
+   * at once */
+  bool streaming;
   tBTM_BLE_REF_VALUE ref_value;
 } tBTM_BLE_BATCH_SCAN_CB;
 
@@ -573,6 +576,10 @@ typedef struct {
 
 typedef void(tBTM_BLE_CTRL_FEATURES_CBACK)(tBTM_STATUS status);
 
+/* Result of a resolving list synchronization */
+typedef void(tBTM_BLE_RL_SYNC_CBACK)(tBTM_STATUS status, uint8_t num_added,
+                                     uint8_t num_removed);
+
 typedef void (*tBLE_SCAN_PARAM_SETUP_CBACK)(tGATT_IF client_if,
                                             tBTM_STATUS status);
 
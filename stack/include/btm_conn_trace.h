@@ -0,0 +1,95 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bt_types.h"
+
+// Connection setup tracing. Each layer marks the milestones it completes for
+// a link; a trace opens when the ACL is requested or, for incoming links,
+// connected, and closes when the first profile reports it is connected or the
+// ACL goes away. A closed trace is reduced to its critical path: starting from
+// the last milestone, each step goes back to the prerequisite that completed
+// last, so the path is the chain of serial waits that set the overall setup
+// time. Only the first mark of each milestone counts. All functions are
+// thread safe.
+
+typedef enum {
+  BTM_CONN_TRACE_ACL_REQUESTED = 0,  // Create Connection sent.
+  BTM_CONN_TRACE_ACL_CONNECTED,      // Connection Complete received.
+  BTM_CONN_TRACE_REMOTE_VERSION,
+  BTM_CONN_TRACE_REMOTE_FEATURES,  // Including the extended feature pages.
+  BTM_CONN_TRACE_AUTHENTICATED,
+  BTM_CONN_TRACE_ENCRYPTED,
+  BTM_CONN_TRACE_SDP_STARTED,  // Our SDP client asked for a channel.
+  BTM_CONN_TRACE_SDP_COMPLETE,
+  BTM_CONN_TRACE_L2CAP_CONFIGURED,  // The first non-SDP channel is open.
+  BTM_CONN_TRACE_PROFILE_CONNECTED,
+  BTM_CONN_TRACE_MILESTONE_COUNT,
+} btm_conn_trace_milestone_t;
+
+typedef struct {
+  RawAddress bda;
+  tBT_TRANSPORT transport;
+  // Boottime of each milestone, zero if it was not reached.
+  uint64_t milestone_us[BTM_CONN_TRACE_MILESTONE_COUNT];
+  // The profile that closed the trace, or NULL.
+  const char* profile;
+  bool complete;  // Closed by a profile rather than by a disconnection.
+
+  // The critical path from its first to its last milestone.
+  uint8_t path_length;
+  btm_conn_trace_milestone_t path[BTM_CONN_TRACE_MILESTONE_COUNT];
+  uint64_t total_us;
+  // The step of the path that took longest, and how long it took.
+  btm_conn_trace_milestone_t longest;
+  uint64_t longest_us;
+} btm_conn_trace_t;
+
+// Records that the link to |bda| over |transport| reached |milestone| now.
+void btm_conn_trace_mark(const RawAddress& bda, tBT_TRANSPORT transport,
+                         btm_conn_trace_milestone_t milestone);
+
+// As |btm_conn_trace_mark|, at |timestamp_us| on the boottime clock.
+void btm_conn_trace_mark_at(const RawAddress& bda, tBT_TRANSPORT transport,
+                            btm_conn_trace_milestone_t milestone,
+                            uint64_t timestamp_us);
+
+// Marks |BTM_CONN_TRACE_PROFILE_CONNECTED| for |profile|, which must be a
+// string literal, and closes the trace.
+void btm_conn_trace_profile_connected(const RawAddress& bda,
+                                      tBT_TRANSPORT transport,
+                                      const char* profile);
+
+// Closes the trace of a link that went down before a profile connected.
+void btm_conn_trace_disconnected(const RawAddress& bda,
+                                 tBT_TRANSPORT transport);
+
+// Copies the most recent closed trace of |bda| to |trace|. Returns false if
+// there is none.
+bool btm_conn_trace_get_last(const RawAddress& bda, btm_conn_trace_t* trace);
+
+// Drops all traces and statistics.
+void btm_conn_trace_reset(void);
+
+// Dumps how often each milestone gated setup, and the recent traces of each
+// device, to |fd|.
+void btm_conn_trace_debug_dump(int fd);
@@ -0,0 +1,82 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "bt_types.h"
+
+// Host transmit path of the BISes of the BIGs we broadcast. Each SDU is
+// written by its producer into a pooled buffer that already has room for the
+// HCI ISO data header, and is tagged with the SDU interval it belongs to. On
+// every SDU interval of the BIG, the SDUs of all its BISes that are due are
+// handed to HCI in one pass, with packet sequence numbers counted from the
+// creation of the BIG and, once the controller reported a transmit timestamp,
+// with timestamps on the same grid. An SDU whose interval passed before it
+// could be sent is dropped and counted. The BISes must use the HCI data path.
+// All functions are thread safe.
+
+// Room a buffer keeps in front of the SDU for the HCI ISO data header:
+// handle and length, timestamp, sequence number and SDU length.
+#define BTM_ISO_TX_HEADROOM 12
+
+typedef struct {
+  uint32_t sdus_queued;
+  uint32_t sdus_sent;
+  uint32_t late_drops;    // SDUs whose interval passed before they were sent
+  uint32_t underruns;     // Writes that found the producer behind the BIG
+  uint32_t overflows;     // SDUs dropped because the queue was full
+  uint32_t pool_misses;   // Buffers allocated because the pool was empty
+  uint32_t credit_waits;  // Due SDUs held back for controller buffers
+  uint32_t max_tick_lateness_us;  // Worst wakeup delay on an interval
+} tBTM_ISO_TX_STATS;
+
+// Starts serving the BIS handles of a BIG that was just created.
+void btm_iso_tx_big_created(uint8_t big_handle, uint32_t sdu_interval_us,
+                            uint16_t max_sdu,
+                            const std::vector<uint16_t>& bis_handles);
+
+// Drops the queued SDUs and buffers of a terminated BIG.
+void btm_iso_tx_big_terminated(uint8_t big_handle);
+
+// Returns a buffer for an SDU of up to the BIG's max SDU size on
+// |bis_handle|, with its offset past BTM_ISO_TX_HEADROOM and a zero length,
+// or NULL if the BIS is not served.
+BT_HDR* btm_iso_tx_get_buf(uint16_t bis_handle);
+
+// Queues |p_sdu| for the SDU interval after the previous one written to
+// |bis_handle|, or for the next interval if the producer fell behind. Takes
+// ownership of |p_sdu| in all cases. Returns false if it was dropped.
+bool btm_iso_tx_write(uint16_t bis_handle, BT_HDR* p_sdu);
+
+// Returns controller buffers for |num_packets| completed packets of
+// |handle|. Returns false if |handle| is not a served BIS.
+bool btm_iso_tx_packets_completed(uint16_t handle, uint16_t num_packets);
+
+// Sends the due SDUs that waited for controller buffers.
+void btm_iso_tx_service(void);
+
+// Copies the counters of |bis_handle|. Returns false if it is not served.
+bool btm_iso_tx_get_stats(uint16_t bis_handle, tBTM_ISO_TX_STATS* p_stats);
+
+// Dumps the state and counters of every served BIS to |fd|.
+void btm_iso_tx_debug_dump(int fd);
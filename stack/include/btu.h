@@ -64,6 +64,30 @@ void btu_free_core(void);
 */
 base::MessageLoop* get_message_loop();
 
+/* Priority lanes of the main thread. Work posted with
+ * do_in_main_thread_prio() runs in lane order, a task that waited too long
+ * runs ahead of higher lanes. Tasks of one lane run in order.
+ */
+typedef enum {
+  BTU_TASK_PRIO_MEDIA = 0, /* A2DP media, HID reports */
+  BTU_TASK_PRIO_CONN,      /* HCI events, ACL, connections and security */
+  BTU_TASK_PRIO_BULK,      /* Advertising reports, discovery */
+  BTU_TASK_PRIO_MAX
+} tBTU_TASK_PRIO;
+
+void do_in_main_thread_prio(tBTU_TASK_PRIO prio,
+                            const base::Location& from_here,
+                            const base::Closure& task);
+void BTU_DumpTaskLanes(int fd);
+
+/* Run |task| on a worker thread, then |reply| in the connection lane of the
+ * main thread. |task| must only touch the state it is bound to. Without
+ * worker threads |task| runs inline.
+ */
+void do_in_worker_thread_and_reply(const base::Location& from_here,
+                                   const base::Closure& task,
+                                   const base::Closure& reply);
+
 void BTU_StartUp(void);
 void BTU_ShutDown(void);
 
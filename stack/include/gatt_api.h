@@ -531,6 +531,66 @@ typedef struct {
   tGATT_AUTH_REQ auth_req;          /*  authentication request */
 } tGATT_MULTI_NOTIF;
 
+/* Notification coalescing counters of a client, see
+ * GATTS_SetNotificationCoalescing */
+typedef struct {
+  uint32_t ntf_queued;      /* notifications held back for coalescing */
+  uint32_t multi_ntf_pdus;  /* Multiple Handle Value Notification PDUs sent */
+  uint32_t multi_ntf_attrs; /* notifications carried by those PDUs */
+  uint32_t single_ntf_pdus; /* Handle Value Notification PDUs sent on flush */
+  uint32_t flush_timeout;   /* flushes because the window expired */
+  uint32_t flush_full;      /* flushes because the PDU was full */
+  uint32_t flush_burst;     /* flushes at the end of a notification burst */
+  uint32_t ntf_failed;      /* coalesced notifications that were not sent */
+} tGATTS_NTF_STATS;
+
+/* Buckets of the ATT response time histogram. Bucket i counts responses that
+ * took less than GATTC_RTT_HIST_BOUNDS_MS[i], the last one everything slower.
+ */
+#define GATTC_RTT_HIST_BUCKETS 8
+#define GATTC_RTT_HIST_BOUNDS_MS \
+  { 10, 20, 50, 100, 200, 500, 1000 }
+
+/* ATT request opcodes are even and below 0x22, the response time counters are
+ * indexed by opcode / 2 */
+#define GATTC_RTT_OPCODE_SLOTS 17
+
+/* Bearers of one link reported by GATTC_GetConnStats */
+#define GATTC_STATS_MAX_BEARERS 8
+
+/* Response times of one ATT request opcode */
+typedef struct {
+  uint32_t count;
+  uint32_t max_ms;
+  uint64_t total_ms;
+  uint32_t hist[GATTC_RTT_HIST_BUCKETS];
+} tGATTC_RTT_STATS;
+
+/* Traffic of one ATT or EATT bearer */
+typedef struct {
+  uint16_t lcid;
+  uint16_t num_apps; /* applications assigned to the bearer */
+  uint32_t tx_pdus;
+  uint32_t rx_pdus;
+  uint64_t tx_bytes;
+  uint64_t rx_bytes;
+  uint32_t srtt_ms; /* smoothed response time, 0 before the first response */
+} tGATT_BEARER_STATS;
+
+/* Client latency and throughput counters of a link, see GATTC_GetConnStats */
+typedef struct {
+  uint64_t start_ms; /* when the link was set up, base for the rates */
+  tGATTC_RTT_STATS rtt[GATTC_RTT_OPCODE_SLOTS];
+  uint32_t ntf_rcvd;
+  uint32_t ind_rcvd;
+  uint64_t value_bytes_rcvd; /* value bytes of notifications and indications */
+  uint32_t writes_packed;    /* write commands held back, see
+                                GATTC_SetWritePacking */
+  uint32_t pack_flushes;     /* times held back write commands were sent */
+  uint8_t num_bearers;
+  tGATT_BEARER_STATS bearers[GATTC_STATS_MAX_BEARERS];
+} tGATTC_CONN_STATS;
+
 typedef struct {
   tGATT_AUTH_REQ auth_req;
   uint16_t num_handles;                          /* number of handles to read */
@@ -876,6 +936,105 @@ extern tGATT_STATUS GATTS_HandleValueNotification(uint16_t conn_id,
                                                   uint16_t val_len,
                                                   uint8_t* p_val);
 
+/*******************************************************************************
+ *
+ * Function        GATTS_SetNotificationCoalescing
+ *
+ * Description     Enables coalescing of the notifications an application
+ *                 sends with GATTS_HandleValueNotification. Notifications to
+ *                 the same client within |window_ms| are packed into one
+ *                 Multiple Handle Value Notification PDU when the client
+ *                 supports it, and sent back to back otherwise.
+ *
+ * Parameter       gatt_if: application interface.
+ *                 window_ms: coalescing window, 0 disables coalescing.
+ *
+ * Returns         void
+ *
+ ******************************************************************************/
+extern void GATTS_SetNotificationCoalescing(tGATT_IF gatt_if,
+                                            uint16_t window_ms);
+
+/*******************************************************************************
+ *
+ * Function        GATTS_NotificationBurstStart
+ *
+ * Description     Starts a burst of notifications. Until
+ *                 GATTS_NotificationBurstEnd, the notifications sent with
+ *                 GATTS_HandleValueNotification are coalesced per client as
+ *                 if their application had a coalescing window.
+ *
+ * Returns         void
+ *
+ ******************************************************************************/
+extern void GATTS_NotificationBurstStart(void);
+
+/*******************************************************************************
+ *
+ * Function        GATTS_NotificationBurstEnd
+ *
+ * Description     Ends a burst of notifications and sends what it held back.
+ *
+ * Returns         void
+ *
+ ******************************************************************************/
+extern void GATTS_NotificationBurstEnd(void);
+
+/*******************************************************************************
+ *
+ * Function        GATTS_GetNotificationStats
+ *
+ * Description     Get the notification coalescing counters of a client.
+ *
+ * Returns         true if the client is connected and |p_stats| was filled.
+ *
+ ******************************************************************************/
+extern bool GATTS_GetNotificationStats(const RawAddress& bd_addr,
+                                       tBT_TRANSPORT transport,
+                                       tGATTS_NTF_STATS* p_stats);
+
+/*******************************************************************************
+ *
+ * Function        GATTS_DumpNotificationStats
+ *
+ * Description     Dump the notification coalescing counters of all clients.
+ *
+ * Returns         void
+ *
+ ******************************************************************************/
+extern void GATTS_DumpNotificationStats(int fd);
+
+/*******************************************************************************
+ *
+ * Function        GATTC_SetWritePacking
+ *
+ * Description     Enables packing of the Write Commands an application sends
+ *                 with GATTC_Write on the ATT fixed channel. Commands within
+ *                 |window_ms| are held back and handed to L2CAP together, at
+ *                 the latest once they fill the controller LE ACL buffers, so
+ *                 that more of them go out in one connection event. Longer
+ *                 windows trade latency for throughput.
+ *
+ * Parameter       gatt_if: application interface.
+ *                 window_ms: packing window, 0 disables packing.
+ *
+ * Returns         void
+ *
+ ******************************************************************************/
+extern void GATTC_SetWritePacking(tGATT_IF gatt_if, uint16_t window_ms);
+
+/*******************************************************************************
+ *
+ * Function        GATTC_GetConnStats
+ *
+ * Description     Get the ATT response times, received notification counts
+ *                 and bearer traffic of the link |conn_id| belongs to.
+ *
+ * Returns         true if the connection exists and |p_stats| was filled.
+ *
+ ******************************************************************************/
+extern bool GATTC_GetConnStats(uint16_t conn_id, tGATTC_CONN_STATS* p_stats);
+
 /*******************************************************************************
  *
  * Function        GATTS_MultiHandleValueNotifications
@@ -0,0 +1,330 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <type_traits>
+
+#include "raw_address.h"
+
+/**
+ * Views over the parameters of the HCI events received most often, read in
+ * place from the BT_HDR they came in. Each event is described by its fields,
+ * whose offsets follow from one another at compile time; a view only reads a
+ * field once it checked the event is long enough to hold it, so a malformed
+ * event from the controller is rejected instead of read past its end.
+ *
+ * All offsets are relative to the event parameters, i.e. after the event code
+ * and parameter length, and for LE Meta events after the subevent code too.
+ */
+
+/* A little endian integer field at |kOffset|. */
+template <typename T, size_t kOffset>
+struct HciField {
+  static_assert(std::is_integral<T>::value, "HCI fields are integers");
+
+  typedef T Type;
+  static constexpr size_t offset = kOffset;
+  static constexpr size_t end = kOffset + sizeof(T);
+
+  static T Get(const uint8_t* data) {
+    typedef typename std::make_unsigned<T>::type Unsigned;
+    Unsigned value = 0;
+    for (size_t i = 0; i < sizeof(T); i++) {
+      value |= (Unsigned)data[kOffset + i] << (8 * i);
+    }
+    return (T)value;
+  }
+};
+
+/* A Bluetooth device address at |kOffset|, least significant octet first. */
+template <size_t kOffset>
+struct HciAddressField {
+  typedef RawAddress Type;
+  static constexpr size_t offset = kOffset;
+  static constexpr size_t end = kOffset + RawAddress::kLength;
+
+  static RawAddress Get(const uint8_t* data) {
+    RawAddress address;
+    for (size_t i = 0; i < RawAddress::kLength; i++) {
+      address.address[RawAddress::kLength - 1 - i] = data[kOffset + i];
+    }
+    return address;
+  }
+};
+
+class HciView {
+ public:
+  HciView() : data_(nullptr), length_(0) {}
+  HciView(const uint8_t* data, size_t length) : data_(data), length_(length) {}
+
+  const uint8_t* data() const { return data_; }
+  size_t length() const { return length_; }
+
+ protected:
+  template <typename Field>
+  typename Field::Type Get() const {
+    return Field::Get(data_);
+  }
+
+  const uint8_t* data_;
+  size_t length_;
+};
+
+/* Fixed size events; |IsValid| tells whether all the fields are there. */
+template <size_t kSize>
+class HciFixedView : public HciView {
+ public:
+  using HciView::HciView;
+
+  bool IsValid() const { return length_ >= kSize; }
+};
+
+typedef HciField<uint8_t, 0> HciDisconnectionCompleteStatus;
+typedef HciField<uint16_t, HciDisconnectionCompleteStatus::end>
+    HciDisconnectionCompleteHandle;
+typedef HciField<uint8_t, HciDisconnectionCompleteHandle::end>
+    HciDisconnectionCompleteReason;
+
+class HciDisconnectionCompleteView
+    : public HciFixedView<HciDisconnectionCompleteReason::end> {
+ public:
+  using HciFixedView::HciFixedView;
+
+  uint8_t status() const { return Get<HciDisconnectionCompleteStatus>(); }
+  uint16_t handle() const { return Get<HciDisconnectionCompleteHandle>(); }
+  uint8_t reason() const { return Get<HciDisconnectionCompleteReason>(); }
+};
+
+typedef HciField<uint8_t, 0> HciEncryptionChangeStatus;
+typedef HciField<uint16_t, HciEncryptionChangeStatus::end>
+    HciEncryptionChangeHandle;
+typedef HciField<uint8_t, HciEncryptionChangeHandle::end>
+    HciEncryptionChangeEnabled;
+
+class HciEncryptionChangeView
+    : public HciFixedView<HciEncryptionChangeEnabled::end> {
+ public:
+  using HciFixedView::HciFixedView;
+
+  uint8_t status() const { return Get<HciEncryptionChangeStatus>(); }
+  uint16_t handle() const { return Get<HciEncryptionChangeHandle>(); }
+  uint8_t encryption_enabled() const {
+    return Get<HciEncryptionChangeEnabled>();
+  }
+};
+
+typedef HciField<uint8_t, 0> HciLeConnectionUpdateStatus;
+typedef HciField<uint16_t, HciLeConnectionUpdateStatus::end>
+    HciLeConnectionUpdateHandle;
+typedef HciField<uint16_t, HciLeConnectionUpdateHandle::end>
+    HciLeConnectionUpdateInterval;
+typedef HciField<uint16_t, HciLeConnectionUpdateInterval::end>
+    HciLeConnectionUpdateLatency;
+typedef HciField<uint16_t, HciLeConnectionUpdateLatency::end>
+    HciLeConnectionUpdateTimeout;
+
+class HciLeConnectionUpdateCompleteView
+    : public HciFixedView<HciLeConnectionUpdateTimeout::end> {
+ public:
+  using HciFixedView::HciFixedView;
+
+  uint8_t status() const { return Get<HciLeConnectionUpdateStatus>(); }
+  uint16_t handle() const { return Get<HciLeConnectionUpdateHandle>(); }
+  uint16_t interval() const { return Get<HciLeConnectionUpdateInterval>(); }
+  uint16_t latency() const { return Get<HciLeConnectionUpdateLatency>(); }
+  uint16_t timeout() const { return Get<HciLeConnectionUpdateTimeout>(); }
+};
+
+typedef HciField<uint8_t, 0> HciNumCompletedPacketsNumHandles;
+/* Each handle entry, relative to its start */
+typedef HciField<uint16_t, 0> HciNumCompletedPacketsHandle;
+typedef HciField<uint16_t, HciNumCompletedPacketsHandle::end>
+    HciNumCompletedPacketsCount;
+
+class HciNumCompletedPacketsView : public HciView {
+ public:
+  static constexpr size_t kEntrySize = HciNumCompletedPacketsCount::end;
+
+  using HciView::HciView;
+
+  bool IsValid() const {
+    return length_ >= HciNumCompletedPacketsNumHandles::end;
+  }
+
+  /* The number of handles the event claims to have */
+  size_t announced_handles() const {
+    return IsValid() ? Get<HciNumCompletedPacketsNumHandles>() : 0;
+  }
+
+  /* The number of handles the event has room for, at most the announced */
+  size_t num_handles() const {
+    if (!IsValid()) return 0;
+    return std::min(announced_handles(),
+                    (length_ - HciNumCompletedPacketsNumHandles::end) /
+                        kEntrySize);
+  }
+
+  /* Entry |i| below |num_handles| */
+  uint16_t handle(size_t i) const {
+    return HciNumCompletedPacketsHandle::Get(entry(i));
+  }
+  uint16_t num_packets(size_t i) const {
+    return HciNumCompletedPacketsCount::Get(entry(i));
+  }
+
+ private:
+  const uint8_t* entry(size_t i) const {
+    return data_ + HciNumCompletedPacketsNumHandles::end + i * kEntrySize;
+  }
+};
+
+/* One report of an LE Advertising Report event */
+typedef HciField<uint8_t, 0> HciLeAdvReportEventType;
+typedef HciField<uint8_t, HciLeAdvReportEventType::end>
+    HciLeAdvReportAddressType;
+typedef HciAddressField<HciLeAdvReportAddressType::end> HciLeAdvReportAddress;
+typedef HciField<uint8_t, HciLeAdvReportAddress::end> HciLeAdvReportDataLength;
+
+class HciLeAdvReportView : public HciView {
+ public:
+  /* The advertising data and the RSSI follow the header */
+  static constexpr size_t kHeaderSize = HciLeAdvReportDataLength::end;
+
+  using HciView::HciView;
+
+  /* The report, including its advertising data and RSSI, fits |length| */
+  bool IsValid() const { return length_ >= kHeaderSize && length_ >= size(); }
+  size_t size() const { return kHeaderSize + data_length() + sizeof(int8_t); }
+
+  uint8_t event_type() const { return Get<HciLeAdvReportEventType>(); }
+  uint8_t address_type() const { return Get<HciLeAdvReportAddressType>(); }
+  RawAddress address() const { return Get<HciLeAdvReportAddress>(); }
+  uint8_t data_length() const { return Get<HciLeAdvReportDataLength>(); }
+  const uint8_t* adv_data() const { return data_ + kHeaderSize; }
+  int8_t rssi() const { return (int8_t)data_[kHeaderSize + data_length()]; }
+};
+
+/* One report of an LE Extended Advertising Report event */
+typedef HciField<uint16_t, 0> HciLeExtAdvReportEventType;
+typedef HciField<uint8_t, HciLeExtAdvReportEventType::end>
+    HciLeExtAdvReportAddressType;
+typedef HciAddressField<HciLeExtAdvReportAddressType::end>
+    HciLeExtAdvReportAddress;
+typedef HciField<uint8_t, HciLeExtAdvReportAddress::end>
+    HciLeExtAdvReportPrimaryPhy;
+typedef HciField<uint8_t, HciLeExtAdvReportPrimaryPhy::end>
+    HciLeExtAdvReportSecondaryPhy;
+typedef HciField<uint8_t, HciLeExtAdvReportSecondaryPhy::end>
+    HciLeExtAdvReportSid;
+typedef HciField<int8_t, HciLeExtAdvReportSid::end> HciLeExtAdvReportTxPower;
+typedef HciField<int8_t, HciLeExtAdvReportTxPower::end> HciLeExtAdvReportRssi;
+typedef HciField<uint16_t, HciLeExtAdvReportRssi::end>
+    HciLeExtAdvReportPeriodicInterval;
+typedef HciField<uint8_t, HciLeExtAdvReportPeriodicInterval::end>
+    HciLeExtAdvReportDirectAddressType;
+typedef HciAddressField<HciLeExtAdvReportDirectAddressType::end>
+    HciLeExtAdvReportDirectAddress;
+typedef HciField<uint8_t, HciLeExtAdvReportDirectAddress::end>
+    HciLeExtAdvReportDataLength;
+
+class HciLeExtAdvReportView : public HciView {
+ public:
+  /* The advertising data follows the header */
+  static constexpr size_t kHeaderSize = HciLeExtAdvReportDataLength::end;
+
+  using HciView::HciView;
+
+  /* The report, including its advertising data, fits |length| */
+  bool IsValid() const { return length_ >= kHeaderSize && length_ >= size(); }
+  size_t size() const { return kHeaderSize + data_length(); }
+
+  uint16_t event_type() const { return Get<HciLeExtAdvReportEventType>(); }
+  uint8_t address_type() const { return Get<HciLeExtAdvReportAddressType>(); }
+  RawAddress address() const { return Get<HciLeExtAdvReportAddress>(); }
+  uint8_t primary_phy() const { return Get<HciLeExtAdvReportPrimaryPhy>(); }
+  uint8_t secondary_phy() const {
+    return Get<HciLeExtAdvReportSecondaryPhy>();
+  }
+  uint8_t advertising_sid() const { return Get<HciLeExtAdvReportSid>(); }
+  int8_t tx_power() const { return Get<HciLeExtAdvReportTxPower>(); }
+  int8_t rssi() const { return Get<HciLeExtAdvReportRssi>(); }
+  uint16_t periodic_adv_interval() const {
+    return Get<HciLeExtAdvReportPeriodicInterval>();
+  }
+  uint8_t direct_address_type() const {
+    return Get<HciLeExtAdvReportDirectAddressType>();
+  }
+  RawAddress direct_address() const {
+    return Get<HciLeExtAdvReportDirectAddress>();
+  }
+  uint8_t data_length() const { return Get<HciLeExtAdvReportDataLength>(); }
+  const uint8_t* adv_data() const { return data_ + kHeaderSize; }
+};
+
+typedef HciField<uint8_t, 0> HciAdvReportListNumReports;
+
+/**
+ * The reports of an LE (Extended) Advertising Report event, walked one after
+ * the other with |Next|.
+ */
+template <typename ReportView>
+class HciAdvReportListView : public HciView {
+ public:
+  HciAdvReportListView(const uint8_t* data, size_t length)
+      : HciView(data, length),
+        offset_(HciAdvReportListNumReports::end),
+        remaining_(0),
+        malformed_(length < HciAdvReportListNumReports::end) {
+    if (!malformed_) remaining_ = Get<HciAdvReportListNumReports>();
+  }
+
+  /**
+   * Sets |report| to the next report. Returns false after the last one, or
+   * if the next one does not fit the event, see |malformed|.
+   */
+  bool Next(ReportView* report) {
+    if (malformed_ || remaining_ == 0) return false;
+
+    ReportView next(data_ + offset_, length_ - offset_);
+    if (!next.IsValid()) {
+      malformed_ = true;
+      return false;
+    }
+    *report = next;
+    offset_ += next.size();
+    remaining_--;
+    return true;
+  }
+
+  /* The event ended before the reports it announced did */
+  bool malformed() const { return malformed_; }
+
+ private:
+  size_t offset_;
+  size_t remaining_;
+  bool malformed_;
+};
+
+typedef HciAdvReportListView<HciLeAdvReportView> HciLeAdvertisingReportView;
+typedef HciAdvReportListView<HciLeExtAdvReportView>
+    HciLeExtAdvertisingReportView;
@@ -426,6 +426,10 @@
 #define HCI_LE_PERIODIC_ADVERTISING_CREATE_SYNC (0x0044 | HCI_GRP_BLE_CMDS)
 #define HCI_LE_PERIODIC_ADVERTISING_CREATE_SYNC_CANCEL (0x0045 | HCI_GRP_BLE_CMDS)
 #define HCI_LE_PERIODIC_ADVERTISING_TERMINATE_SYNC (0x0046 | HCI_GRP_BLE_CMDS)
+#define HCI_LE_ADD_DEVICE_TO_PERIODIC_ADVERTISER_LIST \
+  (0x0047 | HCI_GRP_BLE_CMDS)
+#define HCI_LE_CLEAR_PERIODIC_ADVERTISER_LIST (0x0049 | HCI_GRP_BLE_CMDS)
+#define HCI_LE_READ_PERIODIC_ADVERTISER_LIST_SIZE (0x004A | HCI_GRP_BLE_CMDS)
 #define HCI_BLE_SET_PRIVACY_MODE (0x004E | HCI_GRP_BLE_CMDS)
 #define HCI_LE_SET_PERIODIC_ADVERTISING_RECEIVE_ENABLE \
   (0x0059 | HCI_GRP_BLE_CMDS)
@@ -1111,6 +1111,13 @@ extern void btsnd_hcic_ble_create_periodic_sync(uint8_t options, uint8_t adv_sid
                                                 uint8_t sync_cte_type);
 extern void btsnd_hcic_ble_terminate_periodic_sync(uint16_t sync_handle);
 extern void btsnd_hci_ble_cancel_period_sync();
+extern void btsnd_hcic_ble_add_periodic_adv_list(
+    uint8_t address_type, const RawAddress& bda, uint8_t adv_sid,
+    base::Callback<void(uint8_t*, uint16_t)> cb);
+extern void btsnd_hcic_ble_clear_periodic_adv_list(
+    base::Callback<void(uint8_t*, uint16_t)> cb);
+extern void btsnd_hcic_ble_read_periodic_adv_list_size(
+    base::Callback<void(uint8_t*, uint16_t)> cb);
 extern void btsnd_hcic_ble_pa_sync_tx(uint16_t conn_handle,
                                       uint16_t service_data,
                                       uint16_t sync_handle,
@@ -476,6 +476,35 @@ typedef struct {
 
 } tL2CAP_ERTM_INFO;
 
+/* Traffic and queueing counters of a channel, see L2CA_GetChannelStats.
+ * Times are in milliseconds and include a period still in progress.
+ */
+typedef struct {
+  uint64_t tx_bytes;             /* SDU bytes queued for the peer */
+  uint64_t rx_bytes;             /* SDU bytes delivered to the upper layer */
+  uint32_t tx_sdus;              /* SDUs queued for the peer */
+  uint32_t rx_sdus;              /* SDUs delivered to the upper layer */
+  uint32_t tx_queue_high_water;  /* Deepest xmit_hold_q, in SDUs */
+  uint32_t rx_queue_high_water;  /* Deepest ECFC receive queue, in SDUs */
+  uint32_t congested_count;      /* Times the channel reported congestion */
+  uint64_t congested_ms;         /* Time spent above the buffer quota */
+  uint32_t credit_stall_count;   /* CoC: times data waited for peer credits */
+  uint64_t credit_stall_ms;      /* CoC: time data waited for peer credits */
+  uint32_t ertm_retransmissions; /* ERTM I-frames sent again */
+} tL2CAP_CHNL_STATS;
+
+/* ACL counters of a link, see L2CA_GetLinkStats. The Number Of Completed
+ * Packets latency is sampled on one packet in flight at a time.
+ */
+typedef struct {
+  uint32_t acl_credits_used;     /* Controller ACL buffers consumed */
+  uint32_t acl_credits_returned; /* Buffers returned by NOCP events */
+  uint32_t peak_outstanding;     /* Most ACL packets in the controller */
+  uint32_t nocp_samples;         /* Latency samples taken */
+  uint32_t nocp_latency_avg_ms;  /* Average send to NOCP latency */
+  uint32_t nocp_latency_max_ms;  /* Largest send to NOCP latency */
+} tL2CAP_LINK_STATS;
+
 #define L2CA_REGISTER(a, b, c) L2CA_Register(a, (tL2CAP_APPL_INFO*)(b), c)
 #define L2CA_DEREGISTER(a) L2CA_Deregister(a)
 #define L2CA_CONNECT_REQ(a, b, c) L2CA_ErtmConnectReq(a, b, c)
@@ -1632,4 +1661,53 @@ extern bool L2CA_SubrateRequest(const RawAddress& rem_bda,
                                 uint16_t max_latency, uint16_t cont_num,
                                 uint16_t timeout);
 
+/*******************************************************************************
+ *
+ *  Function        L2CA_DumpAclScheduler
+ *
+ *  Description     Writes the active ACL scheduler, the controller windows
+ *                  and the credit usage of every link to |fd|.
+ *
+ *  Return value:   void
+ *
+ ******************************************************************************/
+extern void L2CA_DumpAclScheduler(int fd);
+
+/*******************************************************************************
+ *
+ *  Function        L2CA_GetChannelStats
+ *
+ *  Description     Copies the traffic and queueing counters of the channel
+ *                  with local CID |lcid| to |p_stats|.
+ *
+ *  Return value:   true if the channel exists
+ *
+ ******************************************************************************/
+extern bool L2CA_GetChannelStats(uint16_t lcid, tL2CAP_CHNL_STATS* p_stats);
+
+/*******************************************************************************
+ *
+ *  Function        L2CA_GetLinkStats
+ *
+ *  Description     Copies the ACL counters of the link to |bd_addr| on
+ *                  |transport| to |p_stats|.
+ *
+ *  Return value:   true if the link exists
+ *
+ ******************************************************************************/
+extern bool L2CA_GetLinkStats(const RawAddress& bd_addr,
+                              tBT_TRANSPORT transport,
+                              tL2CAP_LINK_STATS* p_stats);
+
+/*******************************************************************************
+ *
+ *  Function        L2CA_DumpChannelStats
+ *
+ *  Description     Writes the counters of every link and channel to |fd|.
+ *
+ *  Return value:   void
+ *
+ ******************************************************************************/
+extern void L2CA_DumpChannelStats(int fd);
+
 #endif /* L2C_API_H */
@@ -354,6 +354,21 @@ extern tPAN_RESULT PAN_WriteBuf(uint16_t handle, const RawAddress& dst,
                                 const RawAddress& src, uint16_t protocol,
                                 BT_HDR* p_buf, bool ext);
 
+/*******************************************************************************
+ *
+ * Function         PAN_IsTxQueueFull
+ *
+ * Description      This tells if a unicast PAN_WriteBuf on the handle would
+ *                  fail with PAN_Q_SIZE_EXCEEDED and drop the buffer. The
+ *                  connection is picked the way PAN_WriteBuf picks it.
+ *
+ * Parameters:      handle   - handle for the connection
+ *
+ * Returns          true if the transmit queue of the connection is full
+ *
+ ******************************************************************************/
+extern bool PAN_IsTxQueueFull(uint16_t handle);
+
 /*******************************************************************************
  *
  * Function         PAN_SetProtocolFilters
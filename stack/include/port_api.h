@@ -104,6 +104,8 @@ typedef int(tPORT_DATA_CALLBACK)(uint16_t port_handle, void* p_data,
 #define DATA_CO_CALLBACK_TYPE_INCOMING 1
 #define DATA_CO_CALLBACK_TYPE_OUTGOING_SIZE 2
 #define DATA_CO_CALLBACK_TYPE_OUTGOING 3
+/* p_buf points to an array of len struct iovec, all of which must be filled */
+#define DATA_CO_CALLBACK_TYPE_OUTGOING_IOV 4
 typedef int(tPORT_DATA_CO_CALLBACK)(uint16_t port_handle, uint8_t* p_buf,
                                     uint16_t len, int type);
 
@@ -505,6 +507,17 @@ typedef struct {
 extern int PORT_ClearError(uint16_t handle, uint16_t* p_errors,
                            tPORT_STATUS* p_status);
 
+/* Data and flow control counters of a DLC */
+typedef struct {
+  uint32_t tx_bytes;
+  uint32_t tx_frames;
+  uint32_t rx_bytes;
+  uint32_t rx_frames;
+  uint32_t credit_stalls; /* Times tx stopped on running out of credits */
+  uint32_t congested_ms;  /* Time tx was flow controlled by the peer */
+  uint16_t credit_rx_max; /* Current rx credit window */
+} tPORT_DLC_STATS;
+
 /*******************************************************************************
  *
  * Function         PORT_SendError
@@ -530,6 +543,31 @@ extern int PORT_SendError(uint16_t handle, uint8_t errors);
  ******************************************************************************/
 extern int PORT_GetQueueStatus(uint16_t handle, tPORT_STATUS* p_status);
 
+/*******************************************************************************
+ *
+ * Function         PORT_GetDlcStats
+ *
+ * Description      This function copies the data and flow control counters
+ *                  of a connection.
+ *
+ * Parameters:      handle     - Handle returned in the RFCOMM_CreateConnection
+ *                  p_stats    - pointer to the tPORT_DLC_STATS structure to
+ *                               receive the counters
+ *
+ ******************************************************************************/
+extern int PORT_GetDlcStats(uint16_t handle, tPORT_DLC_STATS* p_stats);
+
+/*******************************************************************************
+ *
+ * Function         PORT_DumpDlcStats
+ *
+ * Description      Writes the counters of every open DLC to |fd|.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+extern void PORT_DumpDlcStats(int fd);
+
 /*******************************************************************************
  *
  * Function         PORT_Purge
@@ -54,6 +54,7 @@
 #define SDP_API_H
 
 #include "bt_target.h"
+#include "sdp_flat_db.h"
 #include "sdpdefs.h"
 
 /*****************************************************************************
@@ -671,6 +672,34 @@ uint16_t SDP_GetDiRecord(uint8_t getRecordIndex,
  ******************************************************************************/
 uint8_t SDP_SetTraceLevel(uint8_t new_level);
 
+/*******************************************************************************
+ *
+ * Function         SDP_FlushRemoteCache
+ *
+ * Description      This function drops the cached service search attribute
+ *                  results of a remote device, e.g. when its bond is removed.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void SDP_FlushRemoteCache(const RawAddress& bd_addr);
+
+/*******************************************************************************
+ *
+ * Function         SDP_GetRemoteFlatDb
+ *
+ * Description      This function returns the cached result of the search of
+ *                  the discovery db with a remote device as a flat database,
+ *                  e.g. to look its records up by service UUID once the
+ *                  discovery completed.
+ *
+ * Returns          The database, owned by SDP and valid until the next SDP
+ *                  call, or NULL if no result is cached
+ *
+ ******************************************************************************/
+const tSDP_FLAT_DB* SDP_GetRemoteFlatDb(const RawAddress& bd_addr,
+                                        tSDP_DISCOVERY_DB* p_db);
+
 /*******************************************************************************
  *
  * Function         SDP_FindServiceUUIDInRec
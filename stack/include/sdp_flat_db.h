@@ -0,0 +1,157 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <bluetooth/uuid.h>
+
+/*****************************************************************************
+ *  A flat SDP database holds the records of a service search attribute
+ *  response in one allocation, with no pointers: every reference is an index
+ *  or an offset, so the database can be copied, stored and reloaded as is.
+ *
+ *  It is laid out as
+ *      tSDP_FLAT_DB                header
+ *      tSDP_FLAT_REC[num_recs]     records, in the order the server sent them
+ *      tSDP_FLAT_ATTR[num_attrs]   attributes, grouped by record and sorted by
+ *                                  ID within a record
+ *      tSDP_FLAT_UUID[num_uuids]   service class UUIDs, sorted by UUID and
+ *                                  record
+ *      uint8_t[data_len]           the attribute lists of the records
+ *
+ *  The data area keeps each record's attribute list exactly as received, so
+ *  the response can be rebuilt from it. Attribute values are data elements,
+ *  header included, at offsets into the data area; nested sequences are
+ *  left for the caller to walk.
+ *
+ *  The layout uses the host byte order, it is not meant to be exchanged
+ *  between devices. SDP_FlatDbIsValid checks a database read back from
+ *  storage before it is used.
+ *****************************************************************************/
+
+#define SDP_FLAT_DB_MAGIC 0x53445046 /* "SDPF" */
+#define SDP_FLAT_DB_VERSION 1
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t num_recs;
+  uint16_t num_attrs;
+  uint16_t num_uuids;
+  uint16_t data_len;
+  uint16_t reserved;
+} tSDP_FLAT_DB;
+
+typedef struct {
+  uint16_t offset; /* Attribute list of the record in the data area */
+  uint16_t len;
+  uint16_t first_attr;
+  uint16_t num_attrs;
+} tSDP_FLAT_REC;
+
+typedef struct {
+  uint16_t attr_id;
+  uint16_t offset; /* Value data element in the data area */
+  uint16_t len;
+} tSDP_FLAT_ATTR;
+
+typedef struct {
+  uint8_t uuid[bluetooth::Uuid::kNumBytes128]; /* Big endian */
+  uint16_t rec;
+} tSDP_FLAT_UUID;
+
+/*******************************************************************************
+ *
+ * Function         SDP_FlatDbBuild
+ *
+ * Description      This function builds a flat database from the attribute
+ *                  lists of a service search attribute response, i.e. a data
+ *                  element sequence of attribute lists.
+ *
+ * Returns          The database, to be freed with osi_free, or NULL if the
+ *                  lists are malformed.
+ *
+ ******************************************************************************/
+tSDP_FLAT_DB* SDP_FlatDbBuild(const uint8_t* p_lists, uint16_t len);
+
+/*******************************************************************************
+ *
+ * Function         SDP_FlatDbIsValid
+ *
+ * Description      This function checks that |len| bytes read back from
+ *                  storage hold a consistent flat database, whose indexes
+ *                  and offsets all stay within it.
+ *
+ * Returns          true if they do
+ *
+ ******************************************************************************/
+bool SDP_FlatDbIsValid(const uint8_t* p, uint32_t len);
+
+/*******************************************************************************
+ *
+ * Function         SDP_FlatDbSize
+ *
+ * Description      This function returns the size in bytes of a database, to
+ *                  copy or store it.
+ *
+ ******************************************************************************/
+uint32_t SDP_FlatDbSize(const tSDP_FLAT_DB* p_db);
+
+/*******************************************************************************
+ *
+ * Function         SDP_FlatDbFindService
+ *
+ * Description      This function looks up the next record after |start_rec|
+ *                  whose service class ID list holds |uuid|. Pass -1 as
+ *                  |start_rec| to search from the first record.
+ *
+ * Returns          The index of the record, or -1 if there is none
+ *
+ ******************************************************************************/
+int SDP_FlatDbFindService(const tSDP_FLAT_DB* p_db,
+                          const bluetooth::Uuid& uuid, int start_rec);
+
+/*******************************************************************************
+ *
+ * Function         SDP_FlatDbFindAttribute
+ *
+ * Description      This function looks up an attribute of a record, and sets
+ *                  |pp_value| and |p_len| to its value data element.
+ *
+ * Returns          true if the record has the attribute
+ *
+ ******************************************************************************/
+bool SDP_FlatDbFindAttribute(const tSDP_FLAT_DB* p_db, uint16_t rec,
+                             uint16_t attr_id, const uint8_t** pp_value,
+                             uint16_t* p_len);
+
+/*******************************************************************************
+ *
+ * Function         SDP_FlatDbWriteLists
+ *
+ * Description      This function rebuilds the attribute lists the database
+ *                  was built from, as a data element sequence, into the
+ *                  |max_len| bytes at |p_out|.
+ *
+ * Returns          The number of bytes written, 0 if they do not fit
+ *
+ ******************************************************************************/
+uint16_t SDP_FlatDbWriteLists(const tSDP_FLAT_DB* p_db, uint8_t* p_out,
+                              uint16_t max_len);
@@ -206,5 +206,16 @@ extern void smp_link_encrypted(const RawAddress& bda, uint8_t encr_enable);
 extern Octet16 SMP_DeriveBrEdrLinkKey(const RawAddress& peer_eb_addr,
   const Octet16& key);
 
+/*******************************************************************************
+ *
+ * Function         SMP_DumpPairingStats
+ *
+ * Description      Dump the per-phase timing histograms of LE pairings.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+extern void SMP_DumpPairingStats(int fd);
+
 
 #endif /* SMP_API_H */
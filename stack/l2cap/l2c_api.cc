@@ -647,6 +647,7 @@ uint16_t L2CA_ConnectLECocReq(uint16_t psm, const RawAddress& p_bd_addr,
   if (p_cfg) {
     memcpy(&p_ccb->local_conn_cfg, p_cfg, sizeof(tL2CAP_COC_CFG_INFO));
     p_ccb->remote_credit_count = p_cfg->credits;
+    l2c_credit_tune_cfg(p_ccb);
   }
 
   /* If link is up, start the L2CAP connection */
@@ -720,6 +721,7 @@ bool L2CA_ConnectLECocRsp(const RawAddress& p_bd_addr, uint8_t id,
   if (p_cfg) {
     memcpy(&p_ccb->local_conn_cfg, p_cfg, sizeof(tL2CAP_COC_CFG_INFO));
     p_ccb->remote_credit_count = p_cfg->credits;
+    l2c_credit_tune_cfg(p_ccb);
   }
 
   if (result == L2CAP_CONN_OK)
@@ -825,6 +827,7 @@ int8_t L2CA_ConnectCocReq(tL2CAP_COC_CONN_REQ* conn_req) {
       p_ccb[i]->local_conn_cfg.mtu = conn_req->mtu;
       p_ccb[i]->local_conn_cfg.mps = mps;
       p_ccb[i]->local_conn_cfg.credits = L2CAP_COC_CREDIT_DEFAULT;
+      l2c_credit_tune_cfg(p_ccb[i]);
       p_ccb[i]->coc_cmd_info.num_coc_chnls = chnls_allocated;
       p_ccb[i]->peer_cfg.fcr.mode = L2CAP_FCR_ECFC_MODE;
       conn_req->sr_cids[i] = p_ccb[i]->local_cid;
@@ -973,6 +976,7 @@ bool L2CA_ConnectCocRsp(tL2CAP_COC_CONN_REQ *p_conn_req,
         p_ccb[i]->local_conn_cfg.mtu = p_conn_req->mtu;
         p_ccb[i]->local_conn_cfg.mps = mps;
         p_ccb[i]->local_conn_cfg.credits = L2CAP_COC_CREDIT_DEFAULT;
+        l2c_credit_tune_cfg(p_ccb[i]);
         p_ccb[i]->coc_cmd_info.ecfc_conn_result = result;
       }
     }
@@ -1208,10 +1212,19 @@ bool L2CA_ConfigReq(uint16_t cid, tL2CAP_CFG_INFO* p_cfg) {
     }
   }
 
+  /* Propose what the peer accepted last time, or skip the request if it
+   * already went out early */
+  bool sent_early = l2c_cfg_memo_apply(p_ccb, p_cfg);
+
   /* Save the adjusted configuration in case it needs to be used for
    * renegotiation */
   p_ccb->our_cfg = *p_cfg;
 
+  if (sent_early) {
+    l2c_cfg_memo_release_early_rsp(p_ccb);
+    return (true);
+  }
+
   l2c_csm_execute(p_ccb, L2CEVT_L2CA_CONFIG_REQ, p_cfg);
 
   return (true);
@@ -1735,7 +1748,7 @@ uint16_t L2CA_LocalLoopbackReq(uint16_t psm, uint16_t handle,
   }
 
   p_lcb->link_state = LST_CONNECTED;
-  p_lcb->handle = handle;
+  l2cu_set_lcb_handle(p_lcb, handle);
 
   /* Allocate a channel control block */
   p_ccb = l2cu_allocate_ccb(p_lcb, 0);
@@ -2872,5 +2885,73 @@ BT_HDR* L2CA_ReadData (uint16_t cid) {
   }
 
   p_data = (BT_HDR *)fixed_queue_dequeue(p_ccb->rx_buf.rcv_data_q);
+  if (l2c_credit_is_managed()) l2c_credit_sdu_consumed(p_ccb);
   return (p_data);
 }
+
+/*******************************************************************************
+ *
+ * Function         L2CA_DumpAclScheduler
+ *
+ * Description      Writes the active ACL scheduler, the controller windows
+ *                  and the credit usage of every link to |fd|.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void L2CA_DumpAclScheduler(int fd) { l2c_sched_debug_dump(fd); }
+
+/*******************************************************************************
+ *
+ * Function         L2CA_GetChannelStats
+ *
+ * Description      Copies the throughput and queueing counters of the channel
+ *                  |lcid| to |p_stats|.
+ *
+ * Returns          true if the channel exists, false otherwise
+ *
+ ******************************************************************************/
+bool L2CA_GetChannelStats(uint16_t lcid, tL2CAP_CHNL_STATS* p_stats) {
+  tL2C_CCB* p_ccb = l2cu_find_ccb_by_cid(NULL, lcid);
+  if (p_ccb == NULL || p_stats == NULL) {
+    L2CAP_TRACE_WARNING("%s: no channel for CID: 0x%04x", __func__, lcid);
+    return false;
+  }
+
+  l2c_stats_get_channel(p_ccb, p_stats);
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         L2CA_GetLinkStats
+ *
+ * Description      Copies the ACL buffer counters of the link to |bd_addr|
+ *                  on |transport| to |p_stats|.
+ *
+ * Returns          true if the link exists, false otherwise
+ *
+ ******************************************************************************/
+bool L2CA_GetLinkStats(const RawAddress& bd_addr, tBT_TRANSPORT transport,
+                       tL2CAP_LINK_STATS* p_stats) {
+  tL2C_LCB* p_lcb = l2cu_find_lcb_by_bd_addr(bd_addr, transport);
+  if (p_lcb == NULL || p_stats == NULL) {
+    L2CAP_TRACE_WARNING("%s: no link to %s", __func__,
+                        bd_addr.ToString().c_str());
+    return false;
+  }
+
+  l2c_stats_get_link(p_lcb, p_stats);
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         L2CA_DumpChannelStats
+ *
+ * Description      Writes the counters of every link and channel to |fd|.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void L2CA_DumpChannelStats(int fd) { l2c_stats_debug_dump(fd); }
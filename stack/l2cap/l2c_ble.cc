@@ -341,7 +341,7 @@ void l2cble_conn_comp(uint16_t handle, uint8_t role, const RawAddress& bda,
   if (role == HCI_ROLE_MASTER) alarm_cancel(p_lcb->l2c_lcb_timer);
 
   /* Save the handle */
-  p_lcb->handle = handle;
+  l2cu_set_lcb_handle(p_lcb, handle);
 
   /* Connected OK. Change state to connected, we were scanning so we are master
    */
@@ -1002,6 +1002,11 @@ void l2c_ble_link_adjust_allocation(void) {
     return;
   }
 
+  if (l2cb.acl_sched == L2C_ACL_SCHED_DRR) {
+    l2c_sched_redistribute();
+    return;
+  }
+
   /* First, count the links */
   for (yy = 0, p_lcb = &l2cb.lcb_pool[0]; yy < MAX_L2CAP_LINKS; yy++, p_lcb++) {
     if (p_lcb->in_use && p_lcb->transport == BT_TRANSPORT_LE) {
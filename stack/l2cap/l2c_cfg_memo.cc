@@ -0,0 +1,397 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the configuration memo of BR/EDR channels. When a
+ *  channel opens, the request the upper layer asked for and the request the
+ *  peer finally accepted are remembered for the peer and PSM. If the peer
+ *  made us renegotiate, the next channel to the same PSM proposes the
+ *  accepted request straight away instead of going through the rejection
+ *  again.
+ *
+ *  Optionally the accepted request is also sent as soon as the channel
+ *  enters the configuration state, without waiting for the upper layer. A
+ *  response that arrives before the upper layer configures the channel is
+ *  held and handed over once it asks for the same configuration; if it asks
+ *  for something else, its request is sent as usual and supersedes the early
+ *  one.
+ *
+ ******************************************************************************/
+
+#include <base/bind.h>
+#include <string.h>
+
+#include "bt_common.h"
+#include "bt_types.h"
+#include "btu.h"
+#include "l2c_api.h"
+#include "l2c_int.h"
+#include "l2cdefs.h"
+#include "osi/include/properties.h"
+
+#define L2C_EARLY_CFG_REQ_PROPERTY "persist.vendor.bt.l2cap_early_cfg_req"
+
+/* Compares the options two configuration requests put on the air. The FCR
+ * timeouts are left out as they are always zero in a BR/EDR request. */
+static bool l2c_cfg_memo_same_req(const tL2CAP_CFG_INFO* p_a,
+                                  const tL2CAP_CFG_INFO* p_b) {
+  if (p_a->mtu_present != p_b->mtu_present ||
+      (p_a->mtu_present && p_a->mtu != p_b->mtu))
+    return false;
+
+  if (p_a->flush_to_present != p_b->flush_to_present ||
+      (p_a->flush_to_present && p_a->flush_to != p_b->flush_to))
+    return false;
+
+  if (p_a->qos_present != p_b->qos_present ||
+      (p_a->qos_present &&
+       (p_a->qos.service_type != p_b->qos.service_type ||
+        p_a->qos.token_rate != p_b->qos.token_rate ||
+        p_a->qos.token_bucket_size != p_b->qos.token_bucket_size ||
+        p_a->qos.peak_bandwidth != p_b->qos.peak_bandwidth ||
+        p_a->qos.latency != p_b->qos.latency ||
+        p_a->qos.delay_variation != p_b->qos.delay_variation)))
+    return false;
+
+  if (p_a->fcr_present != p_b->fcr_present ||
+      (p_a->fcr_present &&
+       (p_a->fcr.mode != p_b->fcr.mode ||
+        p_a->fcr.tx_win_sz != p_b->fcr.tx_win_sz ||
+        p_a->fcr.max_transmit != p_b->fcr.max_transmit ||
+        p_a->fcr.mps != p_b->fcr.mps)))
+    return false;
+
+  if (p_a->fcs_present != p_b->fcs_present ||
+      (p_a->fcs_present && p_a->fcs != p_b->fcs))
+    return false;
+
+  return p_a->ext_flow_spec_present == p_b->ext_flow_spec_present;
+}
+
+static bool l2c_cfg_memo_is_eligible(const tL2C_CCB* p_ccb) {
+  return p_ccb->p_rcb != NULL && p_ccb->p_lcb != NULL &&
+         p_ccb->p_lcb->transport == BT_TRANSPORT_BR_EDR &&
+         p_ccb->chnl_state == CST_CONFIG &&
+         !(p_ccb->config_done & RECONFIG_FLAG);
+}
+
+static tL2C_CFG_MEMO* l2c_cfg_memo_find(const tL2C_CCB* p_ccb) {
+  for (int i = 0; i < L2C_CFG_MEMO_SIZE; i++) {
+    tL2C_CFG_MEMO* p_memo = &l2cb.cfg_memo[i];
+    if (p_memo->in_use && p_memo->psm == p_ccb->p_rcb->psm &&
+        p_memo->bda == p_ccb->p_lcb->remote_bd_addr)
+      return p_memo;
+  }
+  return NULL;
+}
+
+static void l2c_cfg_memo_forget(const tL2C_CCB* p_ccb) {
+  tL2C_CFG_MEMO* p_memo = l2c_cfg_memo_find(p_ccb);
+  if (p_memo == NULL) return;
+
+  L2CAP_TRACE_DEBUG("%s PSM 0x%04x", __func__, p_memo->psm);
+  p_memo->in_use = false;
+}
+
+/* Tells whether the upper layer of the channel allows |p_cfg|'s mode. */
+static bool l2c_cfg_memo_mode_allowed(const tL2C_CCB* p_ccb,
+                                      const tL2CAP_CFG_INFO* p_cfg) {
+  uint8_t allowed = p_ccb->ertm_info.allowed_modes;
+
+  if (!p_cfg->fcr_present || p_cfg->fcr.mode == L2CAP_FCR_BASIC_MODE)
+    return allowed == 0 || (allowed & L2CAP_FCR_CHAN_OPT_BASIC);
+  if (p_cfg->fcr.mode == L2CAP_FCR_ERTM_MODE)
+    return allowed & L2CAP_FCR_CHAN_OPT_ERTM;
+  if (p_cfg->fcr.mode == L2CAP_FCR_STREAM_MODE)
+    return allowed & L2CAP_FCR_CHAN_OPT_STREAM;
+  return false;
+}
+
+/* Hands a held response to the channel, unless it went away or
+ * renegotiated in the meantime. */
+static void l2c_cfg_memo_replay(uint16_t local_cid) {
+  tL2C_CCB* p_ccb = l2cu_find_ccb_by_cid(NULL, local_cid);
+  if (p_ccb == NULL || p_ccb->cfg_memo.early_state != L2C_EARLY_CFG_HELD)
+    return;
+
+  tL2CAP_CFG_INFO rsp = p_ccb->cfg_memo.held_rsp;
+  p_ccb->cfg_memo.early_state = L2C_EARLY_CFG_NONE;
+  l2c_csm_execute(p_ccb, L2CEVT_L2CAP_CONFIG_RSP, &rsp);
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_cfg_memo_init
+ *
+ * Description      Clears the memo and reads whether the accepted request is
+ *                  sent ahead of the upper layer, which is enabled by setting
+ *                  l2cap_early_cfg_req to true.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_cfg_memo_init(void) {
+  char value[PROPERTY_VALUE_MAX] = {0};
+
+  memset(l2cb.cfg_memo, 0, sizeof(l2cb.cfg_memo));
+  l2cb.memo_clock = 0;
+
+  osi_property_get(L2C_EARLY_CFG_REQ_PROPERTY, value, "false");
+  l2cb.early_cfg_req = strcmp(value, "true") == 0;
+
+  L2CAP_TRACE_EVENT("%s early cfg req %d", __func__, l2cb.early_cfg_req);
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_cfg_memo_apply
+ *
+ * Description      Called with the upper layer's adjusted configuration
+ *                  request. If the early request matches it, |p_cfg| is
+ *                  replaced by what was sent. Otherwise, if the peer made us
+ *                  renegotiate the same request before, |p_cfg| is replaced
+ *                  by the request it accepted.
+ *
+ * Returns          true if the request was already sent early; the caller
+ *                  then hands over the peer's response with
+ *                  l2c_cfg_memo_release_early_rsp instead of sending it
+ *
+ ******************************************************************************/
+bool l2c_cfg_memo_apply(tL2C_CCB* p_ccb, tL2CAP_CFG_INFO* p_cfg) {
+  tL2C_CCB_CFG* p_state = &p_ccb->cfg_memo;
+
+  if (!l2c_cfg_memo_is_eligible(p_ccb)) return false;
+
+  tL2C_CFG_MEMO* p_memo = l2c_cfg_memo_find(p_ccb);
+
+  if (p_state->early_state != L2C_EARLY_CFG_NONE) {
+    if (p_memo != NULL && l2c_cfg_memo_same_req(p_cfg, &p_memo->requested)) {
+      L2CAP_TRACE_DEBUG("%s CID 0x%04x: request was sent early", __func__,
+                        p_ccb->local_cid);
+      p_state->requested = *p_cfg;
+      *p_cfg = p_state->sent;
+      p_memo->last_used = ++l2cb.memo_clock;
+      return true;
+    }
+
+    /* Sending the upper layer's request gives it a new identifier, so a
+     * late response to the early one is dropped */
+    L2CAP_TRACE_DEBUG("%s CID 0x%04x: request differs from the early one",
+                      __func__, p_ccb->local_cid);
+    p_state->early_state = L2C_EARLY_CFG_NONE;
+    p_state->from_memo = false;
+    p_state->req_count = 0;
+  }
+
+  if (p_state->req_count == 0) p_state->requested = *p_cfg;
+
+  if (p_memo != NULL && p_memo->renegotiated &&
+      l2c_cfg_memo_same_req(p_cfg, &p_memo->requested) &&
+      l2c_cfg_memo_mode_allowed(p_ccb, &p_memo->accepted)) {
+    L2CAP_TRACE_DEBUG("%s CID 0x%04x: proposing mode %d accepted before",
+                      __func__, p_ccb->local_cid, p_memo->accepted.fcr.mode);
+    *p_cfg = p_memo->accepted;
+    p_state->from_memo = true;
+    p_memo->last_used = ++l2cb.memo_clock;
+  }
+
+  return false;
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_cfg_memo_release_early_rsp
+ *
+ * Description      Hands the peer's response to the early request over to
+ *                  the channel now that the upper layer has configured it.
+ *                  A response that is still outstanding is processed as
+ *                  usual when it arrives.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_cfg_memo_release_early_rsp(tL2C_CCB* p_ccb) {
+  tL2C_CCB_CFG* p_state = &p_ccb->cfg_memo;
+
+  if (p_state->early_state == L2C_EARLY_CFG_SENT) {
+    p_state->early_state = L2C_EARLY_CFG_NONE;
+  } else if (p_state->early_state == L2C_EARLY_CFG_HELD) {
+    /* Not from within L2CA_ConfigReq: the upper layer may still be updating
+     * its own state after the call */
+    do_in_main_thread_prio(BTU_TASK_PRIO_CONN, FROM_HERE,
+                           base::Bind(&l2c_cfg_memo_replay, p_ccb->local_cid));
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_cfg_memo_note_req
+ *
+ * Description      Records a configuration request sent during channel
+ *                  bring-up.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_cfg_memo_note_req(tL2C_CCB* p_ccb, const tL2CAP_CFG_INFO* p_cfg) {
+  tL2C_CCB_CFG* p_state = &p_ccb->cfg_memo;
+
+  if (p_ccb->config_done & RECONFIG_FLAG) return;
+
+  p_state->sent = *p_cfg;
+  if (p_state->req_count < UINT8_MAX) p_state->req_count++;
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_cfg_memo_check_rsp
+ *
+ * Description      Called with a configuration response of the peer in the
+ *                  configuration state. A rejected memo is forgotten, and a
+ *                  response to the early request is held until the upper
+ *                  layer configures the channel.
+ *
+ * Returns          true if the response was consumed
+ *
+ ******************************************************************************/
+bool l2c_cfg_memo_check_rsp(tL2C_CCB* p_ccb, uint16_t event,
+                            tL2CAP_CFG_INFO* p_cfg) {
+  tL2C_CCB_CFG* p_state = &p_ccb->cfg_memo;
+
+  if (p_ccb->p_rcb == NULL) return false;
+
+  if (event == L2CEVT_L2CAP_CONFIG_RSP_NEG && p_state->from_memo) {
+    l2c_cfg_memo_forget(p_ccb);
+    p_state->from_memo = false;
+  }
+
+  if (p_state->early_state != L2C_EARLY_CFG_SENT) return false;
+
+  if (event == L2CEVT_L2CAP_CONFIG_RSP) {
+    /* Wait for the final response */
+    if (p_cfg->result == L2CAP_CFG_PENDING) return true;
+
+    L2CAP_TRACE_DEBUG("%s CID 0x%04x: holding the response", __func__,
+                      p_ccb->local_cid);
+    p_state->held_rsp = *p_cfg;
+    p_state->early_state = L2C_EARLY_CFG_HELD;
+    return true;
+  }
+
+  /* The upper layer never asked for the early request, so the rejection is
+   * not its business; its own request is sent as usual */
+  L2CAP_TRACE_DEBUG("%s CID 0x%04x: early request rejected", __func__,
+                    p_ccb->local_cid);
+  p_state->early_state = L2C_EARLY_CFG_NONE;
+  p_state->req_count = 0;
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_cfg_memo_learn
+ *
+ * Description      Remembers the configuration of a channel that has just
+ *                  opened, replacing the least recently used entry if the
+ *                  memo is full.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_cfg_memo_learn(tL2C_CCB* p_ccb) {
+  tL2C_CCB_CFG* p_state = &p_ccb->cfg_memo;
+
+  if (p_state->req_count == 0 || p_ccb->p_rcb == NULL ||
+      p_ccb->p_lcb->transport != BT_TRANSPORT_BR_EDR)
+    return;
+
+  /* Extended flow specs are negotiated with pending responses; leave them
+   * to the upper layer */
+  if (p_state->requested.ext_flow_spec_present ||
+      p_state->sent.ext_flow_spec_present) {
+    p_state->req_count = 0;
+    return;
+  }
+
+  tL2C_CFG_MEMO* p_memo = l2c_cfg_memo_find(p_ccb);
+  /* A request taken from the memo stands for the renegotiation behind it */
+  bool renegotiated = p_state->req_count > 1 ||
+                      (p_state->from_memo && p_memo && p_memo->renegotiated);
+  if (p_memo == NULL) {
+    p_memo = &l2cb.cfg_memo[0];
+    for (int i = 0; i < L2C_CFG_MEMO_SIZE; i++) {
+      if (!l2cb.cfg_memo[i].in_use) {
+        p_memo = &l2cb.cfg_memo[i];
+        break;
+      }
+      if (l2cb.cfg_memo[i].last_used < p_memo->last_used)
+        p_memo = &l2cb.cfg_memo[i];
+    }
+    p_memo->in_use = true;
+    p_memo->bda = p_ccb->p_lcb->remote_bd_addr;
+    p_memo->psm = p_ccb->p_rcb->psm;
+  }
+
+  p_memo->requested = p_state->requested;
+  p_memo->accepted = p_state->sent;
+  p_memo->renegotiated = renegotiated;
+  p_memo->last_used = ++l2cb.memo_clock;
+
+  L2CAP_TRACE_DEBUG("%s PSM 0x%04x mode %d requests %d renegotiated %d",
+                    __func__, p_memo->psm, p_memo->accepted.fcr.mode,
+                    p_state->req_count, p_memo->renegotiated);
+
+  p_state->req_count = 0;
+  p_state->from_memo = false;
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_cfg_memo_send_early
+ *
+ * Description      Called when a channel enters the configuration state. If
+ *                  early requests are enabled and the peer accepted a
+ *                  request for the PSM before, sends it right away.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_cfg_memo_send_early(tL2C_CCB* p_ccb) {
+  tL2C_CCB_CFG* p_state = &p_ccb->cfg_memo;
+
+  if (!l2cb.early_cfg_req || !l2c_cfg_memo_is_eligible(p_ccb) ||
+      p_state->req_count != 0 || p_state->early_state != L2C_EARLY_CFG_NONE)
+    return;
+
+  tL2C_CFG_MEMO* p_memo = l2c_cfg_memo_find(p_ccb);
+  if (p_memo == NULL || !l2c_cfg_memo_mode_allowed(p_ccb, &p_memo->accepted))
+    return;
+
+  L2CAP_TRACE_DEBUG("%s CID 0x%04x PSM 0x%04x", __func__, p_ccb->local_cid,
+                    p_memo->psm);
+
+  tL2CAP_CFG_INFO cfg = p_memo->accepted;
+  p_ccb->our_cfg = cfg;
+  l2cu_process_our_cfg_req(p_ccb, &cfg);
+  l2cu_send_peer_config_req(p_ccb, &cfg);
+
+  p_state->from_memo = true;
+  p_state->early_state = L2C_EARLY_CFG_SENT;
+  p_memo->last_used = ++l2cb.memo_clock;
+}
@@ -0,0 +1,438 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the credit return policy of LE credit based channels.
+ *  Credits are handed back to the peer in batches once a share of the credit
+ *  window has been consumed, or when a short flush timer expires, instead of
+ *  one signaling PDU per threshold crossing. Optionally the window and our
+ *  MPS are tuned from the observed credit round trip time and the rate at
+ *  which the upper layer drains received data.
+ *
+ *  The channels of an ECFC connection request are served as one group: they
+ *  share a single flush timer, and when one of them returns credits the
+ *  partial batches of the others go out with it.
+ *
+ ******************************************************************************/
+
+#include <base/logging.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "bt_common.h"
+#include "bt_types.h"
+#include "device/include/controller.h"
+#include "l2c_api.h"
+#include "l2c_int.h"
+#include "l2cdefs.h"
+#include "osi/include/alarm.h"
+#include "osi/include/properties.h"
+#include "osi/include/time.h"
+
+#define L2C_CREDIT_BATCH_PROPERTY "persist.vendor.bt.l2cap_coc_credit_batch"
+#define L2C_CREDIT_FLUSH_PROPERTY "persist.vendor.bt.l2cap_coc_credit_flush_ms"
+#define L2C_CREDIT_AUTOTUNE_PROPERTY \
+  "persist.vendor.bt.l2cap_coc_credit_autotune"
+
+/* Share of the window returned at once if only autotuning is enabled. */
+#define L2C_CREDIT_DEFAULT_BATCH_PCT 25
+
+/* Length of a consumer drain rate sample. */
+#define L2C_CREDIT_DRAIN_SAMPLE_MS 250
+
+/* The tuned window covers this many credit round trips worth of PDUs. */
+#define L2C_CREDIT_RTT_HEADROOM 2
+
+static bool l2c_credit_is_ecfc(const tL2C_CCB* p_ccb) {
+  return p_ccb->peer_cfg.fcr.mode == L2CAP_FCR_ECFC_MODE;
+}
+
+/* Largest window the channel can take: in ECFC mode received SDUs are held
+ * in rcv_data_q until the upper layer reads them. */
+static uint16_t l2c_credit_window_max(const tL2C_CCB* p_ccb) {
+  return l2c_credit_is_ecfc(p_ccb) ? p_ccb->rx_buf.rx_data_q_size
+                                   : L2CAP_LE_CREDIT_MAX;
+}
+
+static uint16_t l2c_credit_window(tL2C_CCB* p_ccb) {
+  tL2C_CREDIT_CTRL* p_ctrl = &p_ccb->credit_ctrl;
+  if (p_ctrl->window == 0) {
+    p_ctrl->window = l2c_credit_is_ecfc(p_ccb) ? L2CAP_COC_CREDIT_DEFAULT
+                                               : L2CAP_LE_CREDIT_DEFAULT;
+  }
+  return p_ctrl->window;
+}
+
+/* Credits still tied up in SDUs the upper layer has not read yet. */
+static uint32_t l2c_credit_held(const tL2C_CCB* p_ccb) {
+  if (!l2c_credit_is_ecfc(p_ccb) || !p_ccb->rx_buf.rcv_data_q) return 0;
+
+  uint16_t mps = p_ccb->local_conn_cfg.mps;
+  uint32_t credits_per_sdu =
+      mps ? (p_ccb->local_conn_cfg.mtu + mps - 1) / mps : 1;
+  return fixed_queue_length(p_ccb->rx_buf.rcv_data_q) * credits_per_sdu;
+}
+
+static uint16_t l2c_credit_returnable(tL2C_CCB* p_ccb) {
+  uint32_t window = l2c_credit_window(p_ccb);
+  uint32_t in_use = p_ccb->remote_credit_count + l2c_credit_held(p_ccb);
+  return in_use >= window ? 0 : window - in_use;
+}
+
+static uint16_t l2c_credit_batch(tL2C_CCB* p_ccb) {
+  uint8_t pct = l2cb.credit_batch_pct ? l2cb.credit_batch_pct
+                                      : L2C_CREDIT_DEFAULT_BATCH_PCT;
+  uint32_t batch = (uint32_t)l2c_credit_window(p_ccb) * pct / 100;
+  return std::max<uint32_t>(batch, 1);
+}
+
+/* Rounds |mps| down so that a K-frame fills whole LE ACL packets and does
+ * not end in a short fragment. */
+static uint16_t l2c_credit_align_mps(uint16_t mps) {
+  uint16_t acl_size = controller_get_interface()->get_acl_data_size_ble();
+  uint32_t frame = mps + L2CAP_PKT_OVERHEAD;
+  if (acl_size == 0 || frame <= acl_size) return mps;
+
+  uint32_t aligned = (frame / acl_size) * acl_size - L2CAP_PKT_OVERHEAD;
+  return aligned >= L2CAP_LE_MIN_MPS ? aligned : mps;
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_credit_autotune
+ *
+ * Description      Grows the credit window to cover the PDUs the upper layer
+ *                  drains during L2C_CREDIT_RTT_HEADROOM credit round trips.
+ *                  The window never shrinks below what the peer was granted.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void l2c_credit_autotune(tL2C_CCB* p_ccb) {
+  tL2C_CREDIT_CTRL* p_ctrl = &p_ccb->credit_ctrl;
+  if (!l2cb.credit_autotune || p_ctrl->rtt_ms == 0 ||
+      p_ctrl->drain_per_sec == 0)
+    return;
+
+  uint64_t target = (uint64_t)p_ctrl->drain_per_sec * p_ctrl->rtt_ms *
+                        L2C_CREDIT_RTT_HEADROOM / 1000 +
+                    l2c_credit_batch(p_ccb);
+  target = std::min<uint64_t>(target, l2c_credit_window_max(p_ccb));
+  if (target <= l2c_credit_window(p_ccb)) return;
+
+  L2CAP_TRACE_DEBUG("%s CID: 0x%04x window %u -> %u (rtt %u ms, %u pdu/s)",
+                    __func__, p_ccb->local_cid, p_ctrl->window,
+                    (uint16_t)target, p_ctrl->rtt_ms, p_ctrl->drain_per_sec);
+  p_ctrl->window = (uint16_t)target;
+}
+
+static void l2c_credit_count_drained(tL2C_CCB* p_ccb) {
+  tL2C_CREDIT_CTRL* p_ctrl = &p_ccb->credit_ctrl;
+  uint64_t now = time_get_os_boottime_ms();
+
+  if (p_ctrl->drain_start_ms == 0) p_ctrl->drain_start_ms = now;
+  p_ctrl->drain_count++;
+
+  uint64_t elapsed = now - p_ctrl->drain_start_ms;
+  if (elapsed < L2C_CREDIT_DRAIN_SAMPLE_MS) return;
+
+  uint32_t rate = (uint32_t)(p_ctrl->drain_count * 1000 / elapsed);
+  p_ctrl->drain_per_sec =
+      p_ctrl->drain_per_sec ? (3 * p_ctrl->drain_per_sec + rate) / 4 : rate;
+  p_ctrl->drain_start_ms = now;
+  p_ctrl->drain_count = 0;
+}
+
+static void l2c_credit_grant(tL2C_CCB* p_ccb, uint16_t credits) {
+  tL2C_CREDIT_CTRL* p_ctrl = &p_ccb->credit_ctrl;
+
+  /* A stalled peer sends again as soon as the credits arrive, which gives
+   * us a sample of the credit round trip time. */
+  if (p_ccb->remote_credit_count == 0)
+    p_ctrl->grant_ms = time_get_os_boottime_ms();
+
+  p_ccb->remote_credit_count += credits;
+  alarm_cancel(p_ctrl->flush_timer);
+  l2c_csm_execute(p_ccb, L2CEVT_L2CA_SEND_FLOW_CONTROL_CREDIT, &credits);
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_credit_get_group
+ *
+ * Description      Collects the channels that were set up in the same ECFC
+ *                  connection request as |p_ccb|, including |p_ccb| itself.
+ *                  A CID of the group may have been reused by an unrelated
+ *                  channel since, so only channels that list the same group
+ *                  are members.
+ *
+ * Returns          Number of channels stored in |group|
+ *
+ ******************************************************************************/
+static uint8_t l2c_credit_get_group(
+    tL2C_CCB* p_ccb, tL2C_CCB* group[L2C_MAX_ECFC_CHNLS_PER_CONN]) {
+  const uint16_t* cids = p_ccb->coc_cmd_info.ecfc_cids_group;
+  uint8_t count = 0;
+  bool found_self = false;
+
+  if (l2c_credit_is_ecfc(p_ccb)) {
+    for (int i = 0; i < L2C_MAX_ECFC_CHNLS_PER_CONN; i++) {
+      if (cids[i] == 0) continue;
+
+      tL2C_CCB* p_member = l2cu_find_ccb_by_cid(p_ccb->p_lcb, cids[i]);
+      if (p_member == NULL || !l2c_credit_is_ecfc(p_member) ||
+          memcmp(p_member->coc_cmd_info.ecfc_cids_group, cids,
+                 sizeof(p_member->coc_cmd_info.ecfc_cids_group)) != 0)
+        continue;
+
+      if (p_member == p_ccb) found_self = true;
+      group[count++] = p_member;
+    }
+  }
+
+  if (!found_self && count < L2C_MAX_ECFC_CHNLS_PER_CONN)
+    group[count++] = p_ccb;
+  return count;
+}
+
+/* Returns the group member whose flush timer is running, if any. */
+static tL2C_CCB* l2c_credit_group_flush_owner(tL2C_CCB* p_ccb) {
+  tL2C_CCB* group[L2C_MAX_ECFC_CHNLS_PER_CONN];
+  uint8_t count = l2c_credit_get_group(p_ccb, group);
+
+  for (uint8_t i = 0; i < count; i++) {
+    if (alarm_is_scheduled(group[i]->credit_ctrl.flush_timer)) return group[i];
+  }
+  return NULL;
+}
+
+/* Returns the credits every member of the group of |p_ccb| is holding. */
+static void l2c_credit_flush_group(tL2C_CCB* p_ccb) {
+  tL2C_CCB* group[L2C_MAX_ECFC_CHNLS_PER_CONN];
+  uint8_t count = l2c_credit_get_group(p_ccb, group);
+
+  for (uint8_t i = 0; i < count; i++) {
+    alarm_cancel(group[i]->credit_ctrl.flush_timer);
+    uint16_t credits = l2c_credit_returnable(group[i]);
+    if (credits) l2c_credit_grant(group[i], credits);
+  }
+}
+
+static void l2c_credit_flush_timeout(void* data) {
+  tL2C_CCB* p_ccb = (tL2C_CCB*)data;
+  if (!p_ccb->in_use) return;
+
+  l2c_credit_flush_group(p_ccb);
+}
+
+static void l2c_credit_arm_flush_timer(tL2C_CCB* p_ccb) {
+  tL2C_CREDIT_CTRL* p_ctrl = &p_ccb->credit_ctrl;
+
+  if (!p_ctrl->flush_timer)
+    p_ctrl->flush_timer = alarm_new("l2c_ccb.credit_flush_timer");
+  alarm_set_on_mloop(p_ctrl->flush_timer, l2cb.credit_flush_ms,
+                     l2c_credit_flush_timeout, p_ccb);
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_credit_evaluate
+ *
+ * Description      Returns the consumed credits to the peer once a batch is
+ *                  complete, otherwise arms the flush timer of the group so
+ *                  a partial batch does not sit with us while the peer runs
+ *                  dry. Partial batches held by the rest of the group are
+ *                  returned along with a complete one, since they would be
+ *                  flushed shortly anyway.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void l2c_credit_evaluate(tL2C_CCB* p_ccb) {
+  l2c_credit_autotune(p_ccb);
+
+  uint16_t credits = l2c_credit_returnable(p_ccb);
+  if (credits == 0) return;
+
+  /* Never let the peer run out while we are holding a partial batch */
+  if (credits >= l2c_credit_batch(p_ccb) || p_ccb->remote_credit_count == 0) {
+    if (l2cb.credit_flush_ms != 0)
+      l2c_credit_flush_group(p_ccb);
+    else
+      l2c_credit_grant(p_ccb, credits);
+    return;
+  }
+
+  if (l2cb.credit_flush_ms == 0) return;
+  if (l2c_credit_group_flush_owner(p_ccb) == NULL)
+    l2c_credit_arm_flush_timer(p_ccb);
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_credit_init
+ *
+ * Description      Reads the credit return policy. Batching is enabled by
+ *                  setting l2cap_coc_credit_batch to the percentage of the
+ *                  window that has to be consumed before credits are
+ *                  returned, l2cap_coc_credit_flush_ms bounds how long a
+ *                  partial batch is held and l2cap_coc_credit_autotune
+ *                  enables window and MPS tuning. Without any of them the
+ *                  legacy threshold based credit return is used.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_credit_init(void) {
+  char value[PROPERTY_VALUE_MAX] = {0};
+
+  osi_property_get(L2C_CREDIT_BATCH_PROPERTY, value, "0");
+  l2cb.credit_batch_pct = std::min(std::max(atoi(value), 0), 100);
+
+  osi_property_get(L2C_CREDIT_FLUSH_PROPERTY, value, "0");
+  l2cb.credit_flush_ms = std::min(std::max(atoi(value), 0), 1000);
+
+  osi_property_get(L2C_CREDIT_AUTOTUNE_PROPERTY, value, "false");
+  l2cb.credit_autotune = strcmp(value, "true") == 0;
+
+  L2CAP_TRACE_EVENT("%s batch %u%%  flush %u ms  autotune %d", __func__,
+                    l2cb.credit_batch_pct, l2cb.credit_flush_ms,
+                    l2cb.credit_autotune);
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_credit_is_managed
+ *
+ * Description      Tells whether credits are returned by this policy instead
+ *                  of the legacy threshold check.
+ *
+ * Returns          true if batching or autotuning is enabled
+ *
+ ******************************************************************************/
+bool l2c_credit_is_managed(void) {
+  return l2cb.credit_batch_pct != 0 || l2cb.credit_autotune;
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_credit_tune_cfg
+ *
+ * Description      Called once the local configuration of an LE credit based
+ *                  channel is known. Starts the credit window at the initial
+ *                  credits and, when autotuning, raises them to the window
+ *                  learnt on earlier channels of the same PSM and aligns our
+ *                  MPS to the LE ACL packet size.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_credit_tune_cfg(tL2C_CCB* p_ccb) {
+  CHECK(p_ccb != NULL);
+  tL2CAP_COC_CFG_INFO* p_cfg = &p_ccb->local_conn_cfg;
+
+  if (l2cb.credit_autotune) {
+    if (p_ccb->p_rcb && p_ccb->p_rcb->coc_tuned_credits > p_cfg->credits)
+      p_cfg->credits = p_ccb->p_rcb->coc_tuned_credits;
+    p_cfg->mps = l2c_credit_align_mps(p_cfg->mps);
+    p_ccb->remote_credit_count = p_cfg->credits;
+  }
+
+  p_ccb->credit_ctrl.window = p_cfg->credits;
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_credit_pdu_received
+ *
+ * Description      Called for every K-frame received on a managed channel
+ *                  after the peer's credit count has been decremented.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_credit_pdu_received(tL2C_CCB* p_ccb) {
+  CHECK(p_ccb != NULL);
+  tL2C_CREDIT_CTRL* p_ctrl = &p_ccb->credit_ctrl;
+
+  if (p_ctrl->grant_ms) {
+    uint32_t sample = (uint32_t)(time_get_os_boottime_ms() - p_ctrl->grant_ms);
+    sample = std::max<uint32_t>(sample, 1);
+    p_ctrl->rtt_ms = p_ctrl->rtt_ms ? (7 * p_ctrl->rtt_ms + sample) / 8 : sample;
+    p_ctrl->grant_ms = 0;
+  }
+
+  /* Outside of ECFC mode the data goes straight to the upper layer */
+  if (!l2c_credit_is_ecfc(p_ccb)) l2c_credit_count_drained(p_ccb);
+
+  l2c_credit_evaluate(p_ccb);
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_credit_sdu_consumed
+ *
+ * Description      Called when the upper layer reads an SDU of an ECFC
+ *                  channel, which frees the credits it was holding.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_credit_sdu_consumed(tL2C_CCB* p_ccb) {
+  CHECK(p_ccb != NULL);
+
+  l2c_credit_count_drained(p_ccb);
+  l2c_credit_evaluate(p_ccb);
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_credit_release
+ *
+ * Description      Frees the credit state of a channel and remembers a tuned
+ *                  window for later channels of the same PSM. A flush timer
+ *                  the channel was running for its group is handed to
+ *                  another member.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_credit_release(tL2C_CCB* p_ccb) {
+  CHECK(p_ccb != NULL);
+  tL2C_CREDIT_CTRL* p_ctrl = &p_ccb->credit_ctrl;
+
+  if (l2cb.credit_autotune && p_ccb->p_rcb && !l2c_credit_is_ecfc(p_ccb) &&
+      p_ctrl->window > p_ccb->p_rcb->coc_tuned_credits)
+    p_ccb->p_rcb->coc_tuned_credits = p_ctrl->window;
+
+  if (alarm_is_scheduled(p_ctrl->flush_timer)) {
+    tL2C_CCB* group[L2C_MAX_ECFC_CHNLS_PER_CONN];
+    uint8_t count = l2c_credit_get_group(p_ccb, group);
+    for (uint8_t i = 0; i < count; i++) {
+      if (group[i] == p_ccb) continue;
+      l2c_credit_arm_flush_timer(group[i]);
+      break;
+    }
+  }
+
+  alarm_free(p_ctrl->flush_timer);
+  memset(p_ctrl, 0, sizeof(tL2C_CREDIT_CTRL));
+}
@@ -28,14 +28,17 @@
 
 #include "bt_common.h"
 #include "bt_target.h"
+#include "btm_conn_trace.h"
 #include "btm_int.h"
 #include "btu.h"
 #include "hcidefs.h"
 #include "hcimsgs.h"
 #include "l2c_int.h"
 #include "l2cdefs.h"
+#include "sdp_api.h"
 #include "device/include/interop.h"
 #include "hci/include/btsnoop.h"
+#include "osi/include/packet_trace.h"
 
 /******************************************************************************/
 /*            L O C A L    F U N C T I O N     P R O T O T Y P E S            */
@@ -74,6 +77,7 @@ void l2c_csm_execute(tL2C_CCB* p_ccb, uint16_t event, void* p_data) {
     return;
   }
 
+  tL2C_CHNL_STATE old_state = p_ccb->chnl_state;
   switch (p_ccb->chnl_state) {
     case CST_CLOSED:
       l2c_csm_closed(p_ccb, event, p_data);
@@ -115,6 +119,12 @@ void l2c_csm_execute(tL2C_CCB* p_ccb, uint16_t event, void* p_data) {
       L2CAP_TRACE_DEBUG("Unhandled event! event = %d", event);
       break;
   }
+
+  if (old_state != CST_OPEN && p_ccb->in_use &&
+      p_ccb->chnl_state == CST_OPEN && p_ccb->p_rcb &&
+      p_ccb->p_rcb->psm != SDP_PSM)
+    btm_conn_trace_mark(p_ccb->p_lcb->remote_bd_addr, p_ccb->p_lcb->transport,
+                        BTM_CONN_TRACE_L2CAP_CONFIGURED);
 }
 
 /*******************************************************************************
@@ -994,6 +1004,7 @@ static void l2c_csm_w4_l2cap_connect_rsp(tL2C_CCB* p_ccb, uint16_t event,
         p_ccb->chnl_state = CST_CONFIG;
         alarm_set_on_mloop(p_ccb->l2c_ccb_timer, L2CAP_CHNL_CFG_TIMEOUT_MS,
                            l2c_ccb_timer_timeout, p_ccb);
+        l2c_cfg_memo_send_early(p_ccb);
       }
       L2CAP_TRACE_API("L2CAP - Calling Connect_Cfm_Cb(), CID: 0x%04x, Success",
                       p_ccb->local_cid);
@@ -1266,6 +1277,7 @@ static void l2c_csm_w4_l2ca_connect_rsp(tL2C_CCB* p_ccb, uint16_t event,
           p_ccb->chnl_state = CST_CONFIG;
           alarm_set_on_mloop(p_ccb->l2c_ccb_timer, L2CAP_CHNL_CFG_TIMEOUT_MS,
                              l2c_ccb_timer_timeout, p_ccb);
+          l2c_cfg_memo_send_early(p_ccb);
         } else {
           /* If pending, stay in same state and start extended timer */
           l2cu_send_peer_connect_rsp(p_ccb, p_ci->l2cap_result,
@@ -1450,6 +1462,9 @@ static void l2c_csm_config(tL2C_CCB* p_ccb, uint16_t event, void* p_data) {
       break;
 
     case L2CEVT_L2CAP_CONFIG_RSP: /* Peer config response  */
+      /* Held if it answers a request sent ahead of the upper layer */
+      if (l2c_cfg_memo_check_rsp(p_ccb, event, p_cfg)) break;
+
       l2cu_process_peer_cfg_rsp(p_ccb, p_cfg);
 
       if (p_cfg->result != L2CAP_CFG_PENDING) {
@@ -1480,6 +1495,7 @@ static void l2c_csm_config(tL2C_CCB* p_ccb, uint16_t event, void* p_data) {
           p_ccb->chnl_state = CST_OPEN;
           l2c_link_adjust_chnl_allocation();
           alarm_cancel(p_ccb->l2c_ccb_timer);
+          l2c_cfg_memo_learn(p_ccb);
 
           /* If using eRTM and waiting for an ACK, restart the ACK timer */
           if (p_ccb->fcrb.wait_ack) l2c_fcr_start_timer(p_ccb);
@@ -1522,7 +1538,9 @@ static void l2c_csm_config(tL2C_CCB* p_ccb, uint16_t event, void* p_data) {
       break;
 
     case L2CEVT_L2CAP_CONFIG_RSP_NEG: /* Peer config error rsp */
-                                      /* Disable the Timer */
+      if (l2c_cfg_memo_check_rsp(p_ccb, event, p_cfg)) break;
+
+      /* Disable the Timer */
       alarm_cancel(p_ccb->l2c_ccb_timer);
 
       /* If failure was channel mode try to renegotiate */
@@ -1601,6 +1619,7 @@ static void l2c_csm_config(tL2C_CCB* p_ccb, uint16_t event, void* p_data) {
         p_ccb->chnl_state = CST_OPEN;
         l2c_link_adjust_chnl_allocation();
         alarm_cancel(p_ccb->l2c_ccb_timer);
+        l2c_cfg_memo_learn(p_ccb);
       }
 
       l2cu_send_peer_config_rsp(p_ccb, p_cfg);
@@ -1712,18 +1731,22 @@ static void l2c_csm_config(tL2C_CCB* p_ccb, uint16_t event, void* p_data) {
           p_ccb->local_cid <= L2CAP_LAST_FIXED_CHNL) {
         if (p_ccb->local_cid < L2CAP_BASE_APPL_CID) {
           if (l2cb.fixed_reg[p_ccb->local_cid - L2CAP_FIRST_FIXED_CHNL]
-                  .pL2CA_FixedData_Cb)
+                  .pL2CA_FixedData_Cb) {
+            packet_trace_mark(p_data, PACKET_TRACE_RX_DELIVERED);
             (*l2cb.fixed_reg[p_ccb->local_cid - L2CAP_FIRST_FIXED_CHNL]
                   .pL2CA_FixedData_Cb)(p_ccb->local_cid,
                                        p_ccb->p_lcb->remote_bd_addr,
                                        (BT_HDR*)p_data);
-          else
+          } else {
             osi_free(p_data);
+          }
           break;
         }
       }
 #endif
       if (p_ccb->p_rcb && p_ccb->p_rcb->api.pL2CA_DataInd_Cb) {
+        l2c_stats_rx_sdu(p_ccb, ((BT_HDR*)p_data)->len);
+        packet_trace_mark(p_data, PACKET_TRACE_RX_DELIVERED);
         (*p_ccb->p_rcb->api.pL2CA_DataInd_Cb)(p_ccb->local_cid, (BT_HDR*)p_data);
       }
       break;
@@ -1764,6 +1787,7 @@ static void l2c_csm_config(tL2C_CCB* p_ccb, uint16_t event, void* p_data) {
                                l2c_ccb_timer_timeout, p_ccb);
       } else {
         p_ccb->peer_conn_cfg.credits += *credit;
+        if (*credit) l2c_stats_credit_stall(p_ccb, false);
 
         tL2CA_CREDITS_RECEIVED_CB* cr_cb = NULL;
         if (p_ccb->p_rcb) {
@@ -1945,9 +1969,12 @@ static void l2c_csm_open(tL2C_CCB* p_ccb, uint16_t event, void* p_data) {
         l2cu_post_data_ind_cb_to_btu(p_ccb);
         break;
       }
-      if ((p_ccb->p_rcb) && (p_ccb->p_rcb->api.pL2CA_DataInd_Cb))
+      if ((p_ccb->p_rcb) && (p_ccb->p_rcb->api.pL2CA_DataInd_Cb)) {
+        l2c_stats_rx_sdu(p_ccb, ((BT_HDR*)p_data)->len);
+        packet_trace_mark(p_data, PACKET_TRACE_RX_DELIVERED);
         (*p_ccb->p_rcb->api.pL2CA_DataInd_Cb)(p_ccb->local_cid,
                                               (BT_HDR*)p_data);
+      }
       break;
 
     case L2CEVT_L2CA_DISCONNECT_REQ: /* Upper wants to disconnect */
@@ -2031,6 +2058,7 @@ static void l2c_csm_open(tL2C_CCB* p_ccb, uint16_t event, void* p_data) {
                                l2c_ccb_timer_timeout, p_ccb);
       } else {
         p_ccb->peer_conn_cfg.credits += *credit;
+        if (*credit) l2c_stats_credit_stall(p_ccb, false);
 
         if ((p_ccb->p_lcb->transport == BT_TRANSPORT_LE ||
             p_ccb->peer_cfg.fcr.mode == L2CAP_FCR_LE_COC_MODE) && p_ccb->p_rcb) {
@@ -2381,6 +2409,9 @@ static const char* l2c_csm_get_event_name(uint16_t event) {
  ******************************************************************************/
 void l2c_enqueue_peer_data(tL2C_CCB* p_ccb, BT_HDR* p_buf) {
   uint8_t* p;
+  uint16_t sdu_len = p_buf->len;
+
+  packet_trace_mark(p_buf, PACKET_TRACE_TX_L2CAP_QUEUED);
 
   if (p_ccb->peer_cfg.fcr.mode != L2CAP_FCR_BASIC_MODE) {
     p_buf->event = 0;
@@ -2410,6 +2441,7 @@ void l2c_enqueue_peer_data(tL2C_CCB* p_ccb, BT_HDR* p_buf) {
     fixed_queue_enqueue(p_ccb->xmit_hold_q, p_buf);
   }
 
+  l2c_stats_tx_sdu(p_ccb, sdu_len);
   l2cu_check_channel_congestion(p_ccb);
 
 #if (L2CAP_ROUND_ROBIN_CHANNEL_SERVICE == TRUE)
@@ -65,6 +65,7 @@
 #include "bt_common.h"
 #include "btm_api.h"
 #include "btm_ble_api.h"
+#include "hci_event_view.h"
 #include "l2c_api.h"
 #include "l2cdefs.h"
 #include "osi/include/alarm.h"
@@ -280,7 +281,7 @@ typedef struct {
   fixed_queue_t*
       waiting_for_ack_q;          /* Buffers sent and waiting for peer to ack */
   fixed_queue_t* srej_rcv_hold_q; /* Buffers rcvd but held pending SREJ rsp */
-  fixed_queue_t* retrans_q;       /* Buffers being retransmitted */
+  fixed_queue_t* retrans_q;       /* Frames in waiting_for_ack_q to resend */
 
   alarm_t* ack_timer;         /* Timer delaying RR */
   alarm_t* mon_retrans_timer; /* Timer Monitor or Retransmission */
@@ -341,6 +342,7 @@ typedef struct {
 
   tL2CAP_APPL_INFO api;
   tL2CAP_COC_APPL_INFO coc_api;
+  uint16_t coc_tuned_credits; /* Credit window learnt by credit autotuning */
 } tL2C_RCB;
 
 #ifndef L2CAP_CBB_DEFAULT_DATA_RATE_BUFF_QUOTA
@@ -399,6 +401,65 @@ typedef struct {
   alarm_t* l2c_coc_credit_mon_timer;  /* CCB Timer Entry */
 } tL2CAP_COC_RX_BUF;
 
+/* State of the LE credit return policy of a channel (l2c_credit.cc) */
+typedef struct {
+  uint16_t window;         /* Credits the peer is topped up to */
+  alarm_t* flush_timer;    /* Returns a partial batch of credits */
+  uint64_t grant_ms;       /* When credits were granted to a stalled peer */
+  uint32_t rtt_ms;         /* Smoothed credit round trip time */
+  uint64_t drain_start_ms; /* Start of the current drain rate sample */
+  uint32_t drain_count;    /* PDUs consumed in the current sample */
+  uint32_t drain_per_sec;  /* Smoothed consumer drain rate in PDUs/s */
+} tL2C_CREDIT_CTRL;
+
+/* Configuration request of a channel early sent from the memo */
+#define L2C_EARLY_CFG_NONE 0 /* Nothing sent ahead of the upper layer */
+#define L2C_EARLY_CFG_SENT 1 /* Sent, waiting for the peer's response */
+#define L2C_EARLY_CFG_HELD 2 /* Response held for the upper layer's request */
+
+/* Configuration memo state of a channel during bring-up (l2c_cfg_memo.cc) */
+typedef struct {
+  tL2CAP_CFG_INFO requested; /* Upper layer's first request, adjusted */
+  tL2CAP_CFG_INFO sent;      /* Last configuration request sent to the peer */
+  uint8_t req_count;         /* Configuration requests sent during bring-up */
+  bool from_memo;            /* The last request was taken from the memo */
+  uint8_t early_state;       /* L2C_EARLY_CFG_* */
+  tL2CAP_CFG_INFO held_rsp;  /* Peer's response to the early request */
+} tL2C_CCB_CFG;
+
+/* Outcome of the configuration of a channel, remembered per peer and PSM */
+typedef struct {
+  bool in_use;
+  RawAddress bda;
+  uint16_t psm;
+  uint32_t last_used; /* Memo clock when last learnt or applied */
+  tL2CAP_CFG_INFO requested; /* Upper layer's request */
+  tL2CAP_CFG_INFO accepted;  /* Request the peer finally accepted */
+  bool renegotiated;         /* More than one request was needed */
+} tL2C_CFG_MEMO;
+
+#ifndef L2C_CFG_MEMO_SIZE
+#define L2C_CFG_MEMO_SIZE 16
+#endif
+
+/* LCBs are indexed by connection handle. Handles are 12 bits and values of
+ * 0x0F00 and above are reserved. */
+#define L2C_MAX_ACL_HANDLES 0x0F00
+
+/* Number of buckets of the LCB address hash, must be a power of two */
+#define L2C_LCB_ADDR_HASH_SIZE 32
+
+/* The lookup tables store LCB indexes + 1 and use 0 for an empty entry */
+static_assert(MAX_L2CAP_LINKS < 0xFF, "LCB index must fit the lookup tables");
+
+/* Counters of a channel and the start of the periods being timed
+ * (l2c_stats.cc) */
+typedef struct {
+  tL2CAP_CHNL_STATS counters;
+  uint64_t congested_since_ms; /* 0 while not congested */
+  uint64_t stalled_since_ms;   /* 0 while the peer has credits */
+} tL2C_CCB_STATS;
+
 /* Define a channel control block (CCB). There may be many channel control
  * blocks between the same two Bluetooth devices (i.e. on the same link).
  * Each CCB has unique local and remote CIDs. All channel control blocks on
@@ -489,6 +550,9 @@ typedef struct t_l2c_ccb {
       pending_inc_cfg;      /* pending incoming config params be applied after
                                   getting reconfig response from upper layer*/
   tL2CAP_COC_RX_BUF rx_buf; /* buffer to store incoming l2cap packets in ECFC mode*/
+  tL2C_CREDIT_CTRL credit_ctrl; /* Credit return batching and tuning */
+  tL2C_CCB_STATS stats;         /* Traffic and queueing counters */
+  tL2C_CCB_CFG cfg_memo;        /* Configuration memo and early request */
 
 } tL2C_CCB;
 
@@ -525,6 +589,29 @@ typedef struct {
 
 #endif /* (L2CAP_ROUND_ROBIN_CHANNEL_SERVICE == TRUE) */
 
+/* ACL credit usage of one link, collected for every scheduler.
+*/
+typedef struct {
+  uint32_t credits_used;     /* ACL packets handed to the controller */
+  uint32_t credits_returned; /* Packets reported as completed */
+  uint32_t rounds_served;    /* Scheduler rounds in which the link sent */
+  uint16_t peak_outstanding; /* Highest sent_not_acked seen */
+} tL2C_SCHED_LINK_STATS;
+
+/* Send to Number Of Completed Packets latency of a link (l2c_stats.cc) */
+typedef struct {
+  uint32_t probe_seq;      /* credits_used count that completes the probe */
+  uint64_t probe_ms;       /* When the probed packet was sent, 0 if none */
+  uint32_t samples;        /* Latency samples taken */
+  uint64_t latency_sum_ms; /* Sum of all samples */
+  uint32_t latency_max_ms; /* Largest sample */
+} tL2C_NOCP_STATS;
+
+/* ACL schedulers sharing the controller buffers between links.
+*/
+#define L2C_ACL_SCHED_LEGACY 0 /* Static quotas and round robin fallback */
+#define L2C_ACL_SCHED_DRR 1    /* Deficit round robin, see l2c_sched.cc */
+
 /* Define a link control block. There is one link control block between
  * this device and any other device (i.e. BD ADDR).
 */
@@ -533,7 +620,8 @@ typedef struct t_l2c_linkcb {
   tL2C_LINK_STATE link_state;
 
   alarm_t* l2c_lcb_timer; /* Timer entry for timeout evt */
-  uint16_t handle;        /* The handle used with LM */
+  uint16_t handle;        /* The handle used with LM, see l2cu_set_lcb_handle */
+  uint8_t addr_hash_next; /* Next LCB index + 1 in the address hash bucket */
 
   tL2C_CCB_Q ccb_queue; /* Queue of CCBs on this LCB */
 
@@ -619,6 +707,11 @@ typedef struct t_l2c_linkcb {
 
   uint8_t subrate_req_mask;
 
+  uint16_t sched_weight;  /* DRR quantum, 0 while the link is idle */
+  uint16_t sched_deficit; /* DRR credits left in the current round */
+  tL2C_SCHED_LINK_STATS sched_stats;
+  tL2C_NOCP_STATS nocp_stats;
+
 #if (L2CAP_ROUND_ROBIN_CHANNEL_SERVICE == TRUE)
   /* each priority group is limited burst transmission */
   /* round robin service for the same priority channels */
@@ -639,7 +732,21 @@ typedef struct {
 
   bool is_cong_cback_context;
 
+  uint8_t acl_sched;       /* L2C_ACL_SCHED_LEGACY or L2C_ACL_SCHED_DRR */
+  bool sched_in_service;   /* Guards against re-entering the DRR loop */
+  uint8_t sched_next_link; /* LCB index the next DRR round starts at */
+
+  uint8_t credit_batch_pct; /* Window share consumed before credits return */
+  uint16_t credit_flush_ms; /* Delay before a partial batch is returned */
+  bool credit_autotune;     /* Tune credit window and MPS from RTT/drain */
+
+  bool early_cfg_req;    /* Send the memo's configuration with the connect */
+  uint32_t memo_clock;   /* Ticks on every use of the configuration memo */
+  tL2C_CFG_MEMO cfg_memo[L2C_CFG_MEMO_SIZE]; /* Negotiated configurations */
+
   tL2C_LCB lcb_pool[MAX_L2CAP_LINKS];    /* Link Control Block pool */
+  uint8_t lcb_by_handle[L2C_MAX_ACL_HANDLES];    /* LCB index + 1 by handle */
+  uint8_t lcb_addr_hash[L2C_LCB_ADDR_HASH_SIZE]; /* First LCB index + 1 */
   tL2C_CCB ccb_pool[MAX_L2CAP_CHANNELS]; /* Channel Control Block pool */
   tL2C_RCB rcb_pool[MAX_L2CAP_CLIENTS];  /* Registration info pool */
 
@@ -770,6 +877,7 @@ extern void l2cu_release_lcb(tL2C_LCB* p_lcb);
 extern tL2C_LCB* l2cu_find_lcb_by_bd_addr(const RawAddress& p_bd_addr,
                                           tBT_TRANSPORT transport);
 extern tL2C_LCB* l2cu_find_lcb_by_handle(uint16_t handle);
+extern void l2cu_set_lcb_handle(tL2C_LCB* p_lcb, uint16_t handle);
 extern void l2cu_update_lcb_4_bonding(const RawAddress& p_bd_addr,
                                       bool is_bonding);
 
@@ -951,7 +1059,8 @@ extern void l2c_info_resp_timer_timeout(void* data);
 extern void l2c_link_check_send_pkts(tL2C_LCB* p_lcb, tL2C_CCB* p_ccb,
                                      BT_HDR* p_buf);
 extern void l2c_link_adjust_allocation(void);
-extern void l2c_link_process_num_completed_pkts(uint8_t* p, uint8_t evt_len);
+extern void l2c_link_process_num_completed_pkts(
+    const HciNumCompletedPacketsView& event);
 extern void l2c_link_process_num_completed_blocks(uint8_t controller_id,
                                                   uint8_t* p, uint16_t evt_len);
 extern void l2c_link_processs_num_bufs(uint16_t num_lm_acl_bufs);
@@ -967,6 +1076,53 @@ extern void l2c_pin_code_request(const RawAddress& bd_addr);
 extern void l2c_link_adjust_chnl_allocation(void);
 
 extern void l2c_link_processs_ble_num_bufs(uint16_t num_lm_acl_bufs);
+extern bool l2c_link_send_to_lower(tL2C_LCB* p_lcb, BT_HDR* p_buf,
+                                   tL2C_TX_COMPLETE_CB_INFO* p_cbi);
+
+/* Functions provided by l2c_sched.cc
+ ***********************************
+*/
+extern void l2c_sched_init(void);
+extern void l2c_sched_redistribute(void);
+extern void l2c_sched_service(void);
+extern void l2c_sched_debug_dump(int fd);
+
+/* Functions provided by l2c_credit.cc
+ ***********************************
+*/
+extern void l2c_credit_init(void);
+extern bool l2c_credit_is_managed(void);
+extern void l2c_credit_tune_cfg(tL2C_CCB* p_ccb);
+extern void l2c_credit_pdu_received(tL2C_CCB* p_ccb);
+extern void l2c_credit_sdu_consumed(tL2C_CCB* p_ccb);
+extern void l2c_credit_release(tL2C_CCB* p_ccb);
+
+/* Functions provided by l2c_cfg_memo.cc
+ ***********************************
+*/
+extern void l2c_cfg_memo_init(void);
+extern bool l2c_cfg_memo_apply(tL2C_CCB* p_ccb, tL2CAP_CFG_INFO* p_cfg);
+extern void l2c_cfg_memo_release_early_rsp(tL2C_CCB* p_ccb);
+extern void l2c_cfg_memo_note_req(tL2C_CCB* p_ccb, const tL2CAP_CFG_INFO* p_cfg);
+extern bool l2c_cfg_memo_check_rsp(tL2C_CCB* p_ccb, uint16_t event,
+                                   tL2CAP_CFG_INFO* p_cfg);
+extern void l2c_cfg_memo_learn(tL2C_CCB* p_ccb);
+extern void l2c_cfg_memo_send_early(tL2C_CCB* p_ccb);
+
+/* Functions provided by l2c_stats.cc
+ ***********************************
+*/
+extern void l2c_stats_tx_sdu(tL2C_CCB* p_ccb, uint16_t len);
+extern void l2c_stats_rx_sdu(tL2C_CCB* p_ccb, uint16_t len);
+extern void l2c_stats_congestion(tL2C_CCB* p_ccb, bool congested);
+extern void l2c_stats_credit_stall(tL2C_CCB* p_ccb, bool stalled);
+extern void l2c_stats_acl_sent(tL2C_LCB* p_lcb);
+extern void l2c_stats_acl_completed(tL2C_LCB* p_lcb);
+extern void l2c_stats_get_channel(const tL2C_CCB* p_ccb,
+                                  tL2CAP_CHNL_STATS* p_stats);
+extern void l2c_stats_get_link(const tL2C_LCB* p_lcb,
+                               tL2CAP_LINK_STATS* p_stats);
+extern void l2c_stats_debug_dump(int fd);
 
 #if (L2CAP_WAKE_PARKED_LINK == TRUE)
 extern bool l2c_link_check_power_mode(tL2C_LCB* p_lcb);
@@ -34,6 +34,7 @@
 #include "bt_utils.h"
 #include "btm_api.h"
 #include "btm_int.h"
+#include "btm_iso_tx.h"
 #include "btu.h"
 #include "device/include/controller.h"
 #include "device/include/interop.h"
@@ -43,12 +44,11 @@
 #include "l2cdefs.h"
 #include "log/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/packet_trace.h"
 #include "device/include/device_iot_config.h"
 #include "btif/include/btif_av.h"
 
 extern bool btif_av_is_split_a2dp_enabled(void);
-static bool l2c_link_send_to_lower(tL2C_LCB* p_lcb, BT_HDR* p_buf,
-                                   tL2C_TX_COMPLETE_CB_INFO* p_cbi);
 
 #define HI_PRI_LINK_QUOTA 2 //Mininum ACL buffer quota for high priority link
 /*******************************************************************************
@@ -208,7 +208,7 @@ bool l2c_link_hci_conn_comp(uint8_t status, uint16_t handle,
   }
 
   /* Save the handle */
-  p_lcb->handle = handle;
+  l2cu_set_lcb_handle(p_lcb, handle);
 
   if (ci.status == HCI_SUCCESS) {
     /* Connected OK. Change state to connected */
@@ -266,7 +266,7 @@ bool l2c_link_hci_conn_comp(uint8_t status, uint16_t handle,
   else if ((ci.status == HCI_ERR_MAX_NUM_OF_CONNECTIONS) &&
            l2cu_lcb_disconnecting()) {
     p_lcb->link_state = LST_CONNECT_HOLDING;
-    p_lcb->handle = HCI_INVALID_HANDLE;
+    l2cu_set_lcb_handle(p_lcb, HCI_INVALID_HANDLE);
   } else {
     /* Just in case app decides to try again in the callback context */
     p_lcb->link_state = LST_DISCONNECTING;
@@ -535,7 +535,7 @@ bool l2c_link_hci_disc_comp(uint16_t handle, uint8_t reason) {
      }
       if (l2cu_create_conn(p_lcb, transport)) {
         lcb_is_free = false; /* still using this lcb */
-        p_lcb->handle = HCI_INVALID_HANDLE;
+        l2cu_set_lcb_handle(p_lcb, HCI_INVALID_HANDLE);
         p_lcb->link_role = HCI_ROLE_MASTER; /* reset to default role */
       }
     }
@@ -773,6 +773,11 @@ void l2c_link_adjust_allocation(void) {
     return;
   }
 
+  if (l2cb.acl_sched == L2C_ACL_SCHED_DRR) {
+    l2c_sched_redistribute();
+    return;
+  }
+
   /* First, count the links */
   for (yy = 0, p_lcb = &l2cb.lcb_pool[0]; yy < MAX_L2CAP_LINKS; yy++, p_lcb++) {
     if (p_lcb->in_use &&
@@ -1080,6 +1085,7 @@ void l2c_link_check_send_pkts(tL2C_LCB* p_lcb, tL2C_CCB* p_ccb, BT_HDR* p_buf) {
 
     p_buf->layer_specific = 0;
     list_append(p_lcb->link_xmit_data_q, p_buf);
+    packet_trace_mark(p_buf, PACKET_TRACE_TX_L2CAP_QUEUED);
 
     if (p_lcb->link_xmit_quota == 0) {
       if (p_lcb->transport == BT_TRANSPORT_LE)
@@ -1095,6 +1101,12 @@ void l2c_link_check_send_pkts(tL2C_LCB* p_lcb, tL2C_CCB* p_ccb, BT_HDR* p_buf) {
   */
   if (l2cb.is_cong_cback_context) return;
 
+  /* The DRR scheduler serves all links itself */
+  if (l2cb.acl_sched == L2C_ACL_SCHED_DRR) {
+    l2c_sched_service();
+    return;
+  }
+
   /* If we are in a scenario where there are not enough buffers for each link to
   ** have at least 1, then do a round-robin for all the LCBs
   */
@@ -1209,12 +1221,14 @@ void l2c_link_check_send_pkts(tL2C_LCB* p_lcb, tL2C_CCB* p_ccb, BT_HDR* p_buf) {
  * Returns          true for success, false for fail
  *
  ******************************************************************************/
-static bool l2c_link_send_to_lower(tL2C_LCB* p_lcb, BT_HDR* p_buf,
-                                   tL2C_TX_COMPLETE_CB_INFO* p_cbi) {
+bool l2c_link_send_to_lower(tL2C_LCB* p_lcb, BT_HDR* p_buf,
+                            tL2C_TX_COMPLETE_CB_INFO* p_cbi) {
   uint16_t num_segs;
   uint16_t xmit_window, acl_data_size;
   const controller_t* controller = controller_get_interface();
 
+  packet_trace_mark(p_buf, PACKET_TRACE_TX_L2CAP_SENT);
+
   if ((p_buf->len <= controller->get_acl_packet_size_classic() &&
        (p_lcb->transport == BT_TRANSPORT_BR_EDR)) ||
       ((p_lcb->transport == BT_TRANSPORT_LE) &&
@@ -1226,6 +1240,8 @@ static bool l2c_link_send_to_lower(tL2C_LCB* p_lcb, BT_HDR* p_buf,
         l2cb.round_robin_unacked++;
     }
     p_lcb->sent_not_acked++;
+    p_lcb->sched_stats.credits_used++;
+    l2c_stats_acl_sent(p_lcb);
     p_buf->layer_specific = 0;
 
     if (p_lcb->transport == BT_TRANSPORT_LE) {
@@ -1276,6 +1292,8 @@ static bool l2c_link_send_to_lower(tL2C_LCB* p_lcb, BT_HDR* p_buf,
     }
 
     p_lcb->sent_not_acked += num_segs;
+    p_lcb->sched_stats.credits_used += num_segs;
+    l2c_stats_acl_sent(p_lcb);
     if (p_lcb->transport == BT_TRANSPORT_LE) {
       bte_main_hci_send(
           p_buf, (uint16_t)(BT_EVT_TO_LM_HCI_ACL | LOCAL_BLE_CONTROLLER_ID));
@@ -1284,6 +1302,9 @@ static bool l2c_link_send_to_lower(tL2C_LCB* p_lcb, BT_HDR* p_buf,
     }
   }
 
+  if (p_lcb->sent_not_acked > p_lcb->sched_stats.peak_outstanding)
+    p_lcb->sched_stats.peak_outstanding = p_lcb->sent_not_acked;
+
 #if (L2CAP_HCI_FLOW_CONTROL_DEBUG == TRUE)
   if (p_lcb->transport == BT_TRANSPORT_LE) {
     L2CAP_TRACE_DEBUG(
@@ -1311,33 +1332,31 @@ static bool l2c_link_send_to_lower(tL2C_LCB* p_lcb, BT_HDR* p_buf,
  *
  * Description      This function is called when a "number-of-completed-packets"
  *                  event is received from the controller. It updates all the
- *                  LCB transmit counts.
+ *                  LCB transmit counts first, then fills the controller
+ *                  again: every link with a quota that got credits back is
+ *                  served once, and the round-robin links in a single scan.
  *
  * Returns          void
  *
  ******************************************************************************/
-void l2c_link_process_num_completed_pkts(uint8_t* p, uint8_t evt_len) {
-  uint8_t num_handles, xx;
+void l2c_link_process_num_completed_pkts(
+    const HciNumCompletedPacketsView& event) {
+  size_t num_handles = event.num_handles();
   uint16_t handle;
   uint16_t num_sent;
   tL2C_LCB* p_lcb;
+  bool credited[MAX_L2CAP_LINKS] = {false};
+  tL2C_LCB* p_rr_lcb = NULL;
+  bool iso_credited = false;
 
-  if (evt_len > 0) {
-    STREAM_TO_UINT8(num_handles, p);
-  } else {
-    num_handles = 0;
-  }
-
-  if (num_handles > evt_len / (2 * sizeof(uint16_t))) {
+  if (num_handles < event.announced_handles()) {
     android_errorWriteLog(0x534e4554, "141617601");
-    num_handles = evt_len / (2 * sizeof(uint16_t));
   }
 
-  for (xx = 0; xx < num_handles; xx++) {
-    STREAM_TO_UINT16(handle, p);
+  for (size_t xx = 0; xx < num_handles; xx++) {
     /* Extract the handle */
-    handle = HCID_GET_HANDLE(handle);
-    STREAM_TO_UINT16(num_sent, p);
+    handle = HCID_GET_HANDLE(event.handle(xx));
+    num_sent = event.num_packets(xx);
 
     p_lcb = l2cu_find_lcb_by_handle(handle);
 
@@ -1378,20 +1397,14 @@ void l2c_link_process_num_completed_pkts(uint8_t* p, uint8_t evt_len) {
       else
         p_lcb->sent_not_acked = 0;
 
-      l2c_link_check_send_pkts(p_lcb, NULL, NULL);
+      p_lcb->sched_stats.credits_returned += num_sent;
+      l2c_stats_acl_completed(p_lcb);
 
-      /* If we were doing round-robin for low priority links, check 'em */
-      if ((p_lcb->acl_priority == L2CAP_PRIORITY_HIGH) &&
-          (l2cb.check_round_robin) &&
-          (l2cb.round_robin_unacked < l2cb.round_robin_quota)) {
-        l2c_link_check_send_pkts(NULL, NULL, NULL);
-      }
-      if ((p_lcb->transport == BT_TRANSPORT_LE) &&
-          (p_lcb->acl_priority == L2CAP_PRIORITY_HIGH) &&
-          ((l2cb.ble_check_round_robin) &&
-           (l2cb.ble_round_robin_unacked < l2cb.ble_round_robin_quota))) {
-        l2c_link_check_send_pkts(NULL, NULL, NULL);
-      }
+      credited[p_lcb - l2cb.lcb_pool] = true;
+      /* The scan starts after the last round-robin link acked */
+      if (p_lcb->link_xmit_quota == 0) p_rr_lcb = p_lcb;
+    } else if (btm_iso_tx_packets_completed(handle, num_sent)) {
+      iso_credited = true;
     }
 
 #if (L2CAP_HCI_FLOW_CONTROL_DEBUG == TRUE)
@@ -1416,6 +1429,41 @@ void l2c_link_process_num_completed_pkts(uint8_t* p, uint8_t evt_len) {
     }
 #endif
   }
+
+  /* SDUs of BISes that waited for ISO buffers go first, they are due now */
+  if (iso_credited) btm_iso_tx_service();
+
+  /* Hand the returned credits to the links that need them most */
+  if (l2cb.acl_sched == L2C_ACL_SCHED_DRR) {
+    if (!l2cb.is_cong_cback_context) {
+      l2c_sched_redistribute();
+      l2c_sched_service();
+    }
+    return;
+  }
+
+  bool round_robin = (p_rr_lcb != NULL);
+  p_lcb = &l2cb.lcb_pool[0];
+  for (int xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
+    if (!credited[xx]) continue;
+
+    if (p_lcb->link_xmit_quota != 0) {
+      l2c_link_check_send_pkts(p_lcb, NULL, NULL);
+    }
+
+    /* If we were doing round-robin for low priority links, check 'em */
+    if ((p_lcb->acl_priority == L2CAP_PRIORITY_HIGH) &&
+        (((l2cb.check_round_robin) &&
+          (l2cb.round_robin_unacked < l2cb.round_robin_quota)) ||
+         ((p_lcb->transport == BT_TRANSPORT_LE) &&
+          (l2cb.ble_check_round_robin) &&
+          (l2cb.ble_round_robin_unacked < l2cb.ble_round_robin_quota)))) {
+      round_robin = true;
+    }
+  }
+
+  /* One scan over all the round-robin links, whatever the number of handles */
+  if (round_robin) l2c_link_check_send_pkts(p_rr_lcb, NULL, NULL);
 }
 
 /*******************************************************************************
@@ -42,8 +42,10 @@
 #include "l2c_int.h"
 #include "l2cdefs.h"
 #include "stack_config.h"
+#include "osi/include/footprint.h"
 #include "osi/include/log.h"
 #include "osi/include/osi.h"
+#include "osi/include/packet_trace.h"
 #if (OFF_TARGET_TEST_ENABLED == TRUE)
 #include "linux_include/log/log.h"
 #endif
@@ -58,6 +60,58 @@ static void process_l2cap_cmd(tL2C_LCB* p_lcb, uint8_t* p, uint16_t pkt_len);
 /******************************************************************************/
 tL2C_CB l2cb;
 
+#if (L2CAP_NUM_FIXED_CHNLS > 0)
+/*******************************************************************************
+ *
+ * Function         l2c_rcv_fixed_chnl_data
+ *
+ * Description      Fast path for data received on a fixed channel, such as ATT
+ *                  or SMP on LE. Once the link is connected and the channel
+ *                  is open in basic mode, the PDU goes straight to the
+ *                  callback registered with L2CA_RegisterFixedChannel(),
+ *                  skipping the link notification and the CCB lookups of the
+ *                  generic receive path.
+ *
+ *                  |p| points to the HCI length of the ACL packet.
+ *
+ * Returns          true if the PDU was delivered, false if the generic
+ *                  receive path has to handle it
+ *
+ ******************************************************************************/
+static bool l2c_rcv_fixed_chnl_data(tL2C_LCB* p_lcb, BT_HDR* p_msg,
+                                    uint8_t* p) {
+  uint16_t hci_len, l2cap_len, rcv_cid;
+
+  if (p_lcb->link_state != LST_CONNECTED) return false;
+
+  STREAM_TO_UINT16(hci_len, p);
+  STREAM_TO_UINT16(l2cap_len, p);
+  STREAM_TO_UINT16(rcv_cid, p);
+
+  if (rcv_cid < L2CAP_FIRST_FIXED_CHNL || rcv_cid > L2CAP_LAST_FIXED_CHNL ||
+      rcv_cid == L2CAP_BLE_SIGNALLING_CID)
+    return false;
+  if (hci_len < L2CAP_PKT_OVERHEAD || l2cap_len == 0 ||
+      l2cap_len != hci_len - L2CAP_PKT_OVERHEAD)
+    return false;
+
+  uint16_t idx = rcv_cid - L2CAP_FIRST_FIXED_CHNL;
+  tL2CA_FIXED_DATA_CB* p_data_cb = l2cb.fixed_reg[idx].pL2CA_FixedData_Cb;
+  tL2C_CCB* p_ccb = p_lcb->p_fixed_ccbs[idx];
+  if (p_data_cb == NULL || p_ccb == NULL || !p_ccb->in_use ||
+      p_ccb->chnl_state != CST_OPEN ||
+      p_ccb->peer_cfg.fcr.mode != L2CAP_FCR_BASIC_MODE)
+    return false;
+
+  p_msg->offset += 4 + L2CAP_PKT_OVERHEAD;
+  p_msg->len = l2cap_len;
+
+  packet_trace_mark(p_msg, PACKET_TRACE_RX_DELIVERED);
+  (*p_data_cb)(rcv_cid, p_lcb->remote_bd_addr, p_msg);
+  return true;
+}
+#endif
+
 /*******************************************************************************
  *
  * Function         l2c_rcv_acl_data
@@ -77,6 +131,8 @@ void l2c_rcv_acl_data(BT_HDR* p_msg) {
   uint16_t l2cap_len, rcv_cid;
   uint16_t soc_log_stats_id;
 
+  packet_trace_mark(p_msg, PACKET_TRACE_RX_L2CAP_RECEIVED);
+
   /* Extract the handle */
   STREAM_TO_UINT16(handle, p);
   pkt_type = HCID_GET_EVENT(handle);
@@ -142,6 +198,10 @@ void l2c_rcv_acl_data(BT_HDR* p_msg) {
     return;
   }
 
+#if (L2CAP_NUM_FIXED_CHNLS > 0)
+  if (l2c_rcv_fixed_chnl_data(p_lcb, p_msg, p)) return;
+#endif
+
   /* Extract the length and update the buffer header */
   STREAM_TO_UINT16(hci_len, p);
   p_msg->offset += 4;
@@ -227,11 +287,13 @@ void l2c_rcv_acl_data(BT_HDR* p_msg) {
                                  .fixed_chnl_opts)) {
       p_ccb = p_lcb->p_fixed_ccbs[rcv_cid - L2CAP_FIRST_FIXED_CHNL];
 
-      if (p_ccb->peer_cfg.fcr.mode != L2CAP_FCR_BASIC_MODE)
+      if (p_ccb->peer_cfg.fcr.mode != L2CAP_FCR_BASIC_MODE) {
         l2c_fcr_proc_pdu(p_ccb, p_msg);
-      else
+      } else {
+        packet_trace_mark(p_msg, PACKET_TRACE_RX_DELIVERED);
         (*l2cb.fixed_reg[rcv_cid - L2CAP_FIRST_FIXED_CHNL].pL2CA_FixedData_Cb)(
             rcv_cid, p_lcb->remote_bd_addr, p_msg);
+      }
     } else
       osi_free(p_msg);
   }
@@ -257,7 +319,9 @@ void l2c_rcv_acl_data(BT_HDR* p_msg) {
         // Got a pkt, valid send out credits to the peer device
 
         /* If the credits left on the remote device are getting low, send some */
-        if (p_ccb->remote_credit_count <= L2CAP_LE_CREDIT_THRESHOLD) {
+        if (l2c_credit_is_managed()) {
+          l2c_credit_pdu_received(p_ccb);
+        } else if (p_ccb->remote_credit_count <= L2CAP_LE_CREDIT_THRESHOLD) {
           if (p_ccb->peer_cfg.fcr.mode == L2CAP_FCR_ECFC_MODE) {
             if (!alarm_is_scheduled(p_ccb->rx_buf.l2c_coc_credit_mon_timer)) {
               l2c_fcr_start_rx_buffer_mon_timer(p_ccb);
@@ -1187,6 +1251,7 @@ void l2c_init(void) {
   int16_t xx;
 
   memset(&l2cb, 0, sizeof(tL2C_CB));
+  footprint_set("l2cap", "control_block", sizeof(tL2C_CB));
   /* the psm is increased by 2 before being used */
   l2cb.dyn_psm = 0xFFF;
 
@@ -1244,6 +1309,10 @@ void l2c_init(void) {
                                   L2CAP_FIXED_CHNL_BLE_SIG_BIT |
                                   L2CAP_FIXED_CHNL_SMP_BIT;
 
+  l2c_sched_init();
+  l2c_credit_init();
+  l2c_cfg_memo_init();
+
   l2cb.rcv_pending_q = list_new(NULL);
   CHECK(l2cb.rcv_pending_q != NULL);
 
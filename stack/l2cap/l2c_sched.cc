@@ -0,0 +1,295 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+
+/******************************************************************************
+ *
+ *  This file contains the deficit round robin ACL scheduler. It shares the
+ *  controller ACL buffers between all connected links: every link that has
+ *  data queued gets a quantum of credits per round according to its weight,
+ *  and the per-link quotas are redistributed whenever the controller returns
+ *  credits, so idle links do not hold buffers a busy link could use.
+ *
+ ******************************************************************************/
+
+#include <base/logging.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "bt_common.h"
+#include "bt_types.h"
+#include "l2c_api.h"
+#include "l2c_int.h"
+#include "osi/include/list.h"
+#include "osi/include/properties.h"
+
+/* Weight of a link by the highest priority class among its channels. */
+#define L2C_SCHED_WEIGHT_HIGH 4
+#define L2C_SCHED_WEIGHT_MEDIUM 2
+#define L2C_SCHED_WEIGHT_LOW 1
+
+/* A link blocked by the controller window keeps at most this many rounds
+ * worth of unused credits. */
+#define L2C_SCHED_MAX_DEFICIT_ROUNDS 2
+
+#define L2C_SCHED_PROPERTY "persist.vendor.bt.l2cap_acl_sched"
+
+static uint16_t l2c_sched_class_weight(tL2CAP_CHNL_PRIORITY priority) {
+  switch (priority) {
+    case L2CAP_CHNL_PRIORITY_HIGH:
+      return L2C_SCHED_WEIGHT_HIGH;
+    case L2CAP_CHNL_PRIORITY_MEDIUM:
+      return L2C_SCHED_WEIGHT_MEDIUM;
+    default:
+      return L2C_SCHED_WEIGHT_LOW;
+  }
+}
+
+static bool l2c_sched_ccb_backlogged(const tL2C_CCB* p_ccb) {
+  return p_ccb->in_use && p_ccb->xmit_hold_q &&
+         !fixed_queue_is_empty(p_ccb->xmit_hold_q);
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_sched_link_weight
+ *
+ * Description      Works out the DRR quantum of a link from the priority of
+ *                  the channels that have data queued. High priority ACL
+ *                  links (e.g. A2DP) always get the high class weight.
+ *
+ * Returns          the weight, or 0 if the link has nothing to send
+ *
+ ******************************************************************************/
+static uint16_t l2c_sched_link_weight(tL2C_LCB* p_lcb) {
+  uint16_t weight = 0;
+
+  if (p_lcb->link_xmit_data_q && !list_is_empty(p_lcb->link_xmit_data_q))
+    weight = L2C_SCHED_WEIGHT_LOW;
+
+  for (tL2C_CCB* p_ccb = p_lcb->ccb_queue.p_first_ccb; p_ccb;
+       p_ccb = p_ccb->p_next_ccb) {
+    if (l2c_sched_ccb_backlogged(p_ccb))
+      weight = std::max(weight, l2c_sched_class_weight(p_ccb->ccb_priority));
+  }
+
+#if (L2CAP_NUM_FIXED_CHNLS > 0)
+  for (int xx = 0; xx < L2CAP_NUM_FIXED_CHNLS; xx++) {
+    tL2C_CCB* p_ccb = p_lcb->p_fixed_ccbs[xx];
+    if (p_ccb && l2c_sched_ccb_backlogged(p_ccb))
+      weight = std::max(weight, l2c_sched_class_weight(p_ccb->ccb_priority));
+  }
+#endif
+
+  if (weight == 0 && p_lcb->sent_not_acked == 0) return 0;
+
+  if (p_lcb->acl_priority == L2CAP_PRIORITY_HIGH)
+    return L2C_SCHED_WEIGHT_HIGH;
+  return std::max(weight, (uint16_t)L2C_SCHED_WEIGHT_LOW);
+}
+
+static uint16_t l2c_sched_window(const tL2C_LCB* p_lcb) {
+  return (p_lcb->transport == BT_TRANSPORT_LE) ? l2cb.controller_le_xmit_window
+                                               : l2cb.controller_xmit_window;
+}
+
+static bool l2c_sched_link_can_send(tL2C_LCB* p_lcb) {
+  return p_lcb->in_use && p_lcb->link_state == LST_CONNECTED &&
+         !p_lcb->partial_segment_being_sent &&
+         p_lcb->sent_not_acked < p_lcb->link_xmit_quota &&
+         l2c_sched_window(p_lcb) > 0 && !L2C_LINK_CHECK_POWER_MODE(p_lcb);
+}
+
+/* Sends the next buffer of |p_lcb|. Returns false if it has nothing queued. */
+static bool l2c_sched_send_next(tL2C_LCB* p_lcb) {
+  if (!list_is_empty(p_lcb->link_xmit_data_q)) {
+    BT_HDR* p_buf = (BT_HDR*)list_front(p_lcb->link_xmit_data_q);
+    list_remove(p_lcb->link_xmit_data_q, p_buf);
+    l2c_link_send_to_lower(p_lcb, p_buf, NULL);
+    return true;
+  }
+
+  tL2C_TX_COMPLETE_CB_INFO cbi;
+  BT_HDR* p_buf = l2cu_get_next_buffer_to_send(p_lcb, &cbi);
+  if (p_buf == NULL) return false;
+
+  l2c_link_send_to_lower(p_lcb, p_buf, &cbi);
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_sched_init
+ *
+ * Description      Selects the ACL scheduler. The deficit round robin
+ *                  scheduler is used if the l2cap_acl_sched property is set
+ *                  to "drr", the legacy quota allocation otherwise.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_sched_init(void) {
+  char value[PROPERTY_VALUE_MAX] = {0};
+  osi_property_get(L2C_SCHED_PROPERTY, value, "legacy");
+
+  l2cb.acl_sched =
+      strcmp(value, "drr") == 0 ? L2C_ACL_SCHED_DRR : L2C_ACL_SCHED_LEGACY;
+  l2cb.sched_in_service = false;
+  l2cb.sched_next_link = 0;
+
+  L2CAP_TRACE_EVENT("%s using %s ACL scheduler", __func__,
+                    l2cb.acl_sched == L2C_ACL_SCHED_DRR ? "DRR" : "legacy");
+}
+
+static void l2c_sched_redistribute_pool(tBT_TRANSPORT transport,
+                                        uint16_t num_bufs) {
+  uint32_t total_weight = 0;
+  tL2C_LCB* p_lcb;
+  int xx;
+
+  for (xx = 0, p_lcb = &l2cb.lcb_pool[0]; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
+    if (!p_lcb->in_use || p_lcb->transport != transport) continue;
+
+    p_lcb->sched_weight = l2c_sched_link_weight(p_lcb);
+    total_weight += p_lcb->sched_weight;
+  }
+
+  for (xx = 0, p_lcb = &l2cb.lcb_pool[0]; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
+    if (!p_lcb->in_use || p_lcb->transport != transport) continue;
+
+    /* Idle links keep a single credit so they can start sending right away;
+     * the rest of the pool is split between the busy links by weight. */
+    uint16_t quota = 1;
+    if (p_lcb->sched_weight > 0)
+      quota = std::max<uint32_t>(
+          1, (uint32_t)num_bufs * p_lcb->sched_weight / total_weight);
+    p_lcb->link_xmit_quota = quota;
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_sched_redistribute
+ *
+ * Description      Recomputes the weight of every link and splits the BR/EDR
+ *                  and LE controller buffers between the links that have data
+ *                  to send or packets outstanding.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_sched_redistribute(void) {
+  l2c_sched_redistribute_pool(BT_TRANSPORT_BR_EDR, l2cb.num_lm_acl_bufs);
+  l2c_sched_redistribute_pool(BT_TRANSPORT_LE, l2cb.num_lm_ble_bufs);
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_sched_service
+ *
+ * Description      Runs deficit round robin rounds over all links until the
+ *                  controller windows are used up or nothing is left to send.
+ *                  Every round gives each link its weight in credits; a link
+ *                  that runs out of data forfeits what is left. A packet
+ *                  needing more segments than the link has credits left is
+ *                  still sent, and the deficit is cleared.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_sched_service(void) {
+  /* Transmit complete callbacks may queue more data; the running loop will
+   * pick it up. */
+  if (l2cb.sched_in_service) return;
+  l2cb.sched_in_service = true;
+
+  bool progress = true;
+  while (progress) {
+    progress = false;
+
+    for (int xx = 0; xx < MAX_L2CAP_LINKS; xx++) {
+      tL2C_LCB* p_lcb =
+          &l2cb.lcb_pool[(l2cb.sched_next_link + xx) % MAX_L2CAP_LINKS];
+      if (!l2c_sched_link_can_send(p_lcb)) continue;
+
+      uint16_t quantum = std::max<uint16_t>(p_lcb->sched_weight, 1);
+      p_lcb->sched_deficit = std::min<uint16_t>(
+          p_lcb->sched_deficit + quantum,
+          quantum * L2C_SCHED_MAX_DEFICIT_ROUNDS);
+
+      bool sent = false;
+      while (p_lcb->sched_deficit > 0 && l2c_sched_link_can_send(p_lcb)) {
+        uint16_t before = p_lcb->sent_not_acked;
+        if (!l2c_sched_send_next(p_lcb)) {
+          p_lcb->sched_deficit = 0;
+          break;
+        }
+
+        uint16_t cost = p_lcb->sent_not_acked - before;
+        p_lcb->sched_deficit =
+            (cost < p_lcb->sched_deficit) ? p_lcb->sched_deficit - cost : 0;
+        sent = true;
+      }
+
+      if (sent) {
+        p_lcb->sched_stats.rounds_served++;
+        progress = true;
+      }
+    }
+
+    l2cb.sched_next_link = (l2cb.sched_next_link + 1) % MAX_L2CAP_LINKS;
+  }
+
+  l2cb.sched_in_service = false;
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_sched_debug_dump
+ *
+ * Description      Writes the controller windows and the credit usage of
+ *                  every link to |fd|.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_sched_debug_dump(int fd) {
+  dprintf(fd, "\nL2CAP ACL scheduler: %s\n",
+          l2cb.acl_sched == L2C_ACL_SCHED_DRR ? "deficit round robin"
+                                              : "legacy");
+  dprintf(fd, "  Controller window BR/EDR: %u / %u  LE: %u / %u\n",
+          l2cb.controller_xmit_window, l2cb.num_lm_acl_bufs,
+          l2cb.controller_le_xmit_window, l2cb.num_lm_ble_bufs);
+
+  const tL2C_LCB* p_lcb = &l2cb.lcb_pool[0];
+  for (int xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
+    if (!p_lcb->in_use) continue;
+
+    const tL2C_SCHED_LINK_STATS* stats = &p_lcb->sched_stats;
+    dprintf(fd,
+            "  Handle 0x%04x (%s) weight: %u quota: %u outstanding: %u "
+            "peak: %u credits used/returned: %u / %u rounds: %u\n",
+            p_lcb->handle,
+            p_lcb->transport == BT_TRANSPORT_LE ? "LE" : "BR/EDR",
+            p_lcb->sched_weight, p_lcb->link_xmit_quota, p_lcb->sent_not_acked,
+            stats->peak_outstanding, stats->credits_used,
+            stats->credits_returned, stats->rounds_served);
+  }
+}
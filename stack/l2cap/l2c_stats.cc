@@ -0,0 +1,364 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the per channel and per link counters used to tell
+ *  where a stalled profile is waiting: on the channel buffer quota, on the
+ *  controller ACL buffers or on the credits of the peer.
+ *
+ ******************************************************************************/
+
+#include <base/bind.h>
+#include <base/logging.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "bt_common.h"
+#include "bt_types.h"
+#include "btu.h"
+#include "l2c_api.h"
+#include "l2c_int.h"
+#include "osi/include/debug_snapshot.h"
+#include "osi/include/time.h"
+
+static void l2c_stats_update_high_water(uint32_t* p_high_water,
+                                        size_t depth) {
+  if (depth > *p_high_water) *p_high_water = depth;
+}
+
+/* Time of the period that started at |since_ms|, 0 if none is running. */
+static uint64_t l2c_stats_elapsed(uint64_t since_ms, uint64_t now) {
+  return since_ms ? now - since_ms : 0;
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_stats_tx_sdu
+ *
+ * Description      Counts an SDU of |len| bytes queued for the peer.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_stats_tx_sdu(tL2C_CCB* p_ccb, uint16_t len) {
+  tL2CAP_CHNL_STATS* p_counters = &p_ccb->stats.counters;
+
+  p_counters->tx_sdus++;
+  p_counters->tx_bytes += len;
+  if (p_ccb->xmit_hold_q)
+    l2c_stats_update_high_water(&p_counters->tx_queue_high_water,
+                                fixed_queue_length(p_ccb->xmit_hold_q));
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_stats_rx_sdu
+ *
+ * Description      Counts an SDU of |len| bytes handed to the upper layer,
+ *                  or queued for it to read in ECFC mode.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_stats_rx_sdu(tL2C_CCB* p_ccb, uint16_t len) {
+  tL2CAP_CHNL_STATS* p_counters = &p_ccb->stats.counters;
+
+  p_counters->rx_sdus++;
+  p_counters->rx_bytes += len;
+  if (p_ccb->rx_buf.rcv_data_q)
+    l2c_stats_update_high_water(&p_counters->rx_queue_high_water,
+                                fixed_queue_length(p_ccb->rx_buf.rcv_data_q));
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_stats_congestion
+ *
+ * Description      Starts or ends a period in which the channel is above its
+ *                  buffer quota.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_stats_congestion(tL2C_CCB* p_ccb, bool congested) {
+  tL2C_CCB_STATS* p_stats = &p_ccb->stats;
+  uint64_t now = time_get_os_boottime_ms();
+
+  if (congested) {
+    if (p_stats->congested_since_ms) return;
+    p_stats->congested_since_ms = now;
+    p_stats->counters.congested_count++;
+  } else {
+    p_stats->counters.congested_ms +=
+        l2c_stats_elapsed(p_stats->congested_since_ms, now);
+    p_stats->congested_since_ms = 0;
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_stats_credit_stall
+ *
+ * Description      Starts a period in which data of a credit based channel
+ *                  waits for the peer to grant credits, or ends it when
+ *                  credits arrive.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_stats_credit_stall(tL2C_CCB* p_ccb, bool stalled) {
+  tL2C_CCB_STATS* p_stats = &p_ccb->stats;
+  uint64_t now = time_get_os_boottime_ms();
+
+  if (stalled) {
+    if (p_stats->stalled_since_ms) return;
+    p_stats->stalled_since_ms = now;
+    p_stats->counters.credit_stall_count++;
+  } else {
+    p_stats->counters.credit_stall_ms +=
+        l2c_stats_elapsed(p_stats->stalled_since_ms, now);
+    p_stats->stalled_since_ms = 0;
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_stats_acl_sent
+ *
+ * Description      Called after ACL buffers of the link have been consumed.
+ *                  Starts timing the last of them if no packet is timed yet.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_stats_acl_sent(tL2C_LCB* p_lcb) {
+  tL2C_NOCP_STATS* p_nocp = &p_lcb->nocp_stats;
+  if (p_nocp->probe_ms) return;
+
+  p_nocp->probe_seq = p_lcb->sched_stats.credits_used;
+  p_nocp->probe_ms = time_get_os_boottime_ms();
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_stats_acl_completed
+ *
+ * Description      Called after a Number Of Completed Packets event returned
+ *                  ACL buffers of the link. The controller completes the
+ *                  packets of a link in order, so the timed packet is done
+ *                  once as many buffers came back as had been used for it.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_stats_acl_completed(tL2C_LCB* p_lcb) {
+  tL2C_NOCP_STATS* p_nocp = &p_lcb->nocp_stats;
+  if (!p_nocp->probe_ms) return;
+  if ((int32_t)(p_lcb->sched_stats.credits_returned - p_nocp->probe_seq) < 0)
+    return;
+
+  uint32_t latency =
+      (uint32_t)(time_get_os_boottime_ms() - p_nocp->probe_ms);
+  p_nocp->samples++;
+  p_nocp->latency_sum_ms += latency;
+  if (latency > p_nocp->latency_max_ms) p_nocp->latency_max_ms = latency;
+  p_nocp->probe_ms = 0;
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_stats_get_channel
+ *
+ * Description      Copies the counters of a channel, including the periods
+ *                  of congestion and credit stall still in progress.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_stats_get_channel(const tL2C_CCB* p_ccb,
+                           tL2CAP_CHNL_STATS* p_stats) {
+  uint64_t now = time_get_os_boottime_ms();
+
+  *p_stats = p_ccb->stats.counters;
+  p_stats->congested_ms +=
+      l2c_stats_elapsed(p_ccb->stats.congested_since_ms, now);
+  p_stats->credit_stall_ms +=
+      l2c_stats_elapsed(p_ccb->stats.stalled_since_ms, now);
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_stats_get_link
+ *
+ * Description      Copies the ACL counters of a link.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_stats_get_link(const tL2C_LCB* p_lcb, tL2CAP_LINK_STATS* p_stats) {
+  const tL2C_NOCP_STATS* p_nocp = &p_lcb->nocp_stats;
+
+  memset(p_stats, 0, sizeof(tL2CAP_LINK_STATS));
+  p_stats->acl_credits_used = p_lcb->sched_stats.credits_used;
+  p_stats->acl_credits_returned = p_lcb->sched_stats.credits_returned;
+  p_stats->peak_outstanding = p_lcb->sched_stats.peak_outstanding;
+  p_stats->nocp_samples = p_nocp->samples;
+  if (p_nocp->samples)
+    p_stats->nocp_latency_avg_ms =
+        (uint32_t)(p_nocp->latency_sum_ms / p_nocp->samples);
+  p_stats->nocp_latency_max_ms = p_nocp->latency_max_ms;
+}
+
+static const char* l2c_stats_mode_name(const tL2C_CCB* p_ccb) {
+  switch (p_ccb->peer_cfg.fcr.mode) {
+    case L2CAP_FCR_BASIC_MODE:
+      return "basic";
+    case L2CAP_FCR_ERTM_MODE:
+      return "ertm";
+    case L2CAP_FCR_STREAM_MODE:
+      return "streaming";
+    case L2CAP_FCR_LE_COC_MODE:
+      return "le_coc";
+    case L2CAP_FCR_ECFC_MODE:
+      return "ecfc";
+    default:
+      return "unknown";
+  }
+}
+
+typedef struct {
+  uint16_t local_cid;
+  uint16_t psm;
+  const char* mode;
+  tL2CAP_CHNL_STATS stats;
+} tL2C_STATS_CHNL_SNAPSHOT;
+
+typedef struct {
+  RawAddress remote_bd_addr;
+  uint16_t handle;
+  tBT_TRANSPORT transport;
+  tL2CAP_LINK_STATS stats;
+  std::vector<tL2C_STATS_CHNL_SNAPSHOT> channels;
+} tL2C_STATS_LINK_SNAPSHOT;
+
+typedef std::vector<tL2C_STATS_LINK_SNAPSHOT> tL2C_STATS_SNAPSHOT;
+
+/*******************************************************************************
+ *
+ * Function         l2c_stats_take_snapshot
+ *
+ * Description      Copies the counters of every link and its channels. Runs
+ *                  on the main thread, which owns them.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void l2c_stats_take_snapshot(tL2C_STATS_SNAPSHOT* p_snapshot) {
+  const tL2C_LCB* p_lcb = &l2cb.lcb_pool[0];
+  for (int xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
+    if (!p_lcb->in_use) continue;
+
+    p_snapshot->emplace_back();
+    tL2C_STATS_LINK_SNAPSHOT& link = p_snapshot->back();
+    link.remote_bd_addr = p_lcb->remote_bd_addr;
+    link.handle = p_lcb->handle;
+    link.transport = p_lcb->transport;
+    l2c_stats_get_link(p_lcb, &link.stats);
+
+    for (const tL2C_CCB* p_ccb = p_lcb->ccb_queue.p_first_ccb; p_ccb;
+         p_ccb = p_ccb->p_next_ccb) {
+      tL2C_STATS_CHNL_SNAPSHOT chnl;
+      chnl.local_cid = p_ccb->local_cid;
+      chnl.psm = p_ccb->p_rcb ? p_ccb->p_rcb->real_psm : 0;
+      chnl.mode = l2c_stats_mode_name(p_ccb);
+      l2c_stats_get_channel(p_ccb, &chnl.stats);
+      link.channels.push_back(chnl);
+    }
+  }
+}
+
+static void l2c_stats_run_task(const std::function<void()>& task) { task(); }
+
+static bool l2c_stats_post_to_main(const std::function<void()>& task) {
+  if (get_message_loop() == NULL) return false;
+  do_in_main_thread_prio(BTU_TASK_PRIO_CONN, FROM_HERE,
+                         base::Bind(&l2c_stats_run_task, task));
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         l2c_stats_debug_dump
+ *
+ * Description      Writes the counters of every link and its channels to
+ *                  |fd|. The counters are copied on the main thread and
+ *                  formatted on the calling one.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2c_stats_debug_dump(int fd) {
+  dprintf(fd, "\nL2CAP channel statistics:\n");
+
+  std::shared_ptr<tL2C_STATS_SNAPSHOT> p_snapshot;
+  if (get_message_loop() == NULL) {
+    // Stack not running, nothing updates the counters
+    p_snapshot = std::make_shared<tL2C_STATS_SNAPSHOT>();
+    l2c_stats_take_snapshot(p_snapshot.get());
+  } else {
+    p_snapshot = debug_snapshot_take_posted<tL2C_STATS_SNAPSHOT>(
+        l2c_stats_post_to_main, l2c_stats_take_snapshot);
+  }
+  if (p_snapshot == nullptr) {
+    dprintf(fd, "  Main thread busy, statistics unavailable\n");
+    return;
+  }
+
+  for (const tL2C_STATS_LINK_SNAPSHOT& link : *p_snapshot) {
+    dprintf(fd,
+            "  Link %s handle 0x%04x (%s) ACL credits used/returned: %u / %u "
+            "peak: %u NOCP latency avg/max: %u / %u ms (%u samples)\n",
+            link.remote_bd_addr.ToString().c_str(), link.handle,
+            link.transport == BT_TRANSPORT_LE ? "LE" : "BR/EDR",
+            link.stats.acl_credits_used, link.stats.acl_credits_returned,
+            link.stats.peak_outstanding, link.stats.nocp_latency_avg_ms,
+            link.stats.nocp_latency_max_ms, link.stats.nocp_samples);
+
+    for (const tL2C_STATS_CHNL_SNAPSHOT& chnl : link.channels) {
+      dprintf(fd,
+              "    CID 0x%04x PSM 0x%04x %s tx: %u SDUs %" PRIu64
+              " bytes rx: %u SDUs %" PRIu64 " bytes\n",
+              chnl.local_cid, chnl.psm, chnl.mode, chnl.stats.tx_sdus,
+              chnl.stats.tx_bytes, chnl.stats.rx_sdus, chnl.stats.rx_bytes);
+      dprintf(fd,
+              "      queue high water tx/rx: %u / %u congested: %u times "
+              "%" PRIu64 " ms credit stalls: %u times %" PRIu64
+              " ms retransmissions: %u\n",
+              chnl.stats.tx_queue_high_water, chnl.stats.rx_queue_high_water,
+              chnl.stats.congested_count, chnl.stats.congested_ms,
+              chnl.stats.credit_stall_count, chnl.stats.credit_stall_ms,
+              chnl.stats.ertm_retransmissions);
+    }
+  }
+}
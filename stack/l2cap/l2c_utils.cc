@@ -30,6 +30,7 @@
 #include "bt_types.h"
 #include "bt_utils.h"
 #include "btm_api.h"
+#include "btm_conn_trace.h"
 #include "btm_int.h"
 #include "btu.h"
 #include "device/include/controller.h"
@@ -60,6 +61,38 @@ bool l2cu_can_allocate_lcb(void) {
   return false;
 }
 
+/* LCBs are chained in l2cb.lcb_addr_hash by remote address */
+static uint8_t l2cu_lcb_addr_bucket(const RawAddress& bd_addr) {
+  uint32_t hash = 2166136261u; /* FNV-1a */
+  for (size_t i = 0; i < RawAddress::kLength; i++) {
+    hash ^= bd_addr.address[i];
+    hash *= 16777619u;
+  }
+  return hash & (L2C_LCB_ADDR_HASH_SIZE - 1);
+}
+
+static void l2cu_lcb_addr_hash_insert(tL2C_LCB* p_lcb) {
+  uint8_t* p_head =
+      &l2cb.lcb_addr_hash[l2cu_lcb_addr_bucket(p_lcb->remote_bd_addr)];
+  p_lcb->addr_hash_next = *p_head;
+  *p_head = (p_lcb - l2cb.lcb_pool) + 1;
+}
+
+static void l2cu_lcb_addr_hash_remove(tL2C_LCB* p_lcb) {
+  uint8_t index = (p_lcb - l2cb.lcb_pool) + 1;
+  uint8_t* p_link =
+      &l2cb.lcb_addr_hash[l2cu_lcb_addr_bucket(p_lcb->remote_bd_addr)];
+
+  while (*p_link) {
+    if (*p_link == index) {
+      *p_link = p_lcb->addr_hash_next;
+      break;
+    }
+    p_link = &l2cb.lcb_pool[*p_link - 1].addr_hash_next;
+  }
+  p_lcb->addr_hash_next = 0;
+}
+
 /*******************************************************************************
  *
  * Function         l2cu_allocate_lcb
@@ -81,6 +114,7 @@ tL2C_LCB* l2cu_allocate_lcb(const RawAddress& p_bd_addr, bool is_bonding,
       memset(p_lcb, 0, sizeof(tL2C_LCB));
 
       p_lcb->remote_bd_addr = p_bd_addr;
+      l2cu_lcb_addr_hash_insert(p_lcb);
 
       p_lcb->in_use = true;
       p_lcb->link_state = LST_DISCONNECTED;
@@ -152,6 +186,9 @@ void l2cu_release_lcb(tL2C_LCB* p_lcb) {
   p_lcb->in_use = false;
   p_lcb->is_bonding = false;
 
+  l2cu_set_lcb_handle(p_lcb, HCI_INVALID_HANDLE);
+  l2cu_lcb_addr_hash_remove(p_lcb);
+
   /* Stop the timers */
   alarm_cancel(p_lcb->l2c_lcb_timer);
   alarm_cancel(p_lcb->info_resp_timer);
@@ -250,22 +287,23 @@ void l2cu_release_lcb(tL2C_LCB* p_lcb) {
  *
  * Function         l2cu_find_lcb_by_bd_addr
  *
- * Description      Look through all active LCBs for a match based on the
- *                  remote BD address.
+ * Description      Look up the active LCB with the remote BD address on
+ *                  |transport| in the LCB address hash.
  *
  * Returns          pointer to matched LCB, or NULL if no match
  *
  ******************************************************************************/
 tL2C_LCB* l2cu_find_lcb_by_bd_addr(const RawAddress& p_bd_addr,
                                    tBT_TRANSPORT transport) {
-  int xx;
-  tL2C_LCB* p_lcb = &l2cb.lcb_pool[0];
+  uint8_t index = l2cb.lcb_addr_hash[l2cu_lcb_addr_bucket(p_bd_addr)];
 
-  for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
+  while (index) {
+    tL2C_LCB* p_lcb = &l2cb.lcb_pool[index - 1];
     if ((p_lcb->in_use) && p_lcb->transport == transport &&
         (p_lcb->remote_bd_addr == p_bd_addr)) {
       return (p_lcb);
     }
+    index = p_lcb->addr_hash_next;
   }
 
   /* If here, no match found */
@@ -629,6 +667,8 @@ void l2cu_send_peer_config_req(tL2C_CCB* p_ccb, tL2CAP_CFG_INFO* p_cfg) {
 
   p_ccb->local_id = p_ccb->p_lcb->id;
 
+  l2c_cfg_memo_note_req(p_ccb, p_cfg);
+
   if (p_cfg->mtu_present)
     cfg_len += L2CAP_CFG_MTU_OPTION_LEN + L2CAP_CFG_OPTION_OVERHEAD;
   if (p_cfg->flush_to_present)
@@ -1589,6 +1629,8 @@ tL2C_CCB* l2cu_allocate_ccb(tL2C_LCB* p_lcb, uint16_t cid) {
 
   p_ccb->bypass_fcs = 0;
   memset(&p_ccb->ertm_info, 0, sizeof(tL2CAP_ERTM_INFO));
+  memset(&p_ccb->stats, 0, sizeof(tL2C_CCB_STATS));
+  memset(&p_ccb->cfg_memo, 0, sizeof(tL2C_CCB_CFG));
   p_ccb->peer_cfg_already_rejected = false;
   p_ccb->fcr_cfg_tries = L2CAP_MAX_FCR_CFG_TRIES;
 
@@ -1730,6 +1772,8 @@ void l2cu_release_ccb(tL2C_CCB* p_ccb) {
     btm_sec_clr_service_by_psm(p_rcb->psm);
   }
 
+  l2c_credit_release(p_ccb);
+
   if (p_ccb->should_free_rcb) {
     osi_free(p_rcb);
     p_ccb->p_rcb = NULL;
@@ -2458,6 +2502,8 @@ bool l2cu_create_conn_after_switch(tL2C_LCB* p_lcb) {
                               HCI_PKT_TYPES_MASK_DM3 | HCI_PKT_TYPES_MASK_DH3 |
                               HCI_PKT_TYPES_MASK_DM5 | HCI_PKT_TYPES_MASK_DH5),
       page_scan_rep_mode, page_scan_mode, clock_offset, allow_switch);
+  btm_conn_trace_mark(p_lcb->remote_bd_addr, BT_TRANSPORT_BR_EDR,
+                      BTM_CONN_TRACE_ACL_REQUESTED);
 
   btm_acl_update_busy_level(BTM_BLI_PAGE_EVT);
 
@@ -3328,26 +3374,47 @@ void l2cu_send_peer_ble_credit_based_disconn_req(tL2C_CCB* p_ccb) {
  *
  * Function         l2cu_find_lcb_by_handle
  *
- * Description      Look through all active LCBs for a match based on the
- *                  HCI handle.
+ * Description      Look up the active LCB with the HCI handle in the handle
+ *                  indexed table.
  *
  * Returns          pointer to matched LCB, or NULL if no match
  *
  ******************************************************************************/
 tL2C_LCB* l2cu_find_lcb_by_handle(uint16_t handle) {
-  int xx;
-  tL2C_LCB* p_lcb = &l2cb.lcb_pool[0];
+  if (handle >= L2C_MAX_ACL_HANDLES) return (NULL);
 
-  for (xx = 0; xx < MAX_L2CAP_LINKS; xx++, p_lcb++) {
-    if ((p_lcb->in_use) && (p_lcb->handle == handle)) {
-      return (p_lcb);
-    }
-  }
+  uint8_t index = l2cb.lcb_by_handle[handle];
+  if (index == 0) return (NULL);
+
+  tL2C_LCB* p_lcb = &l2cb.lcb_pool[index - 1];
+  if ((p_lcb->in_use) && (p_lcb->handle == handle)) return (p_lcb);
 
   /* If here, no match found */
   return (NULL);
 }
 
+/*******************************************************************************
+ *
+ * Function         l2cu_set_lcb_handle
+ *
+ * Description      Sets the connection handle of a link and keeps the handle
+ *                  lookup table up to date. Pass HCI_INVALID_HANDLE when the
+ *                  link loses its handle.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void l2cu_set_lcb_handle(tL2C_LCB* p_lcb, uint16_t handle) {
+  uint8_t index = (p_lcb - l2cb.lcb_pool) + 1;
+
+  if (p_lcb->handle < L2C_MAX_ACL_HANDLES &&
+      l2cb.lcb_by_handle[p_lcb->handle] == index)
+    l2cb.lcb_by_handle[p_lcb->handle] = 0;
+
+  p_lcb->handle = handle;
+  if (handle < L2C_MAX_ACL_HANDLES) l2cb.lcb_by_handle[handle] = index;
+}
+
 /*******************************************************************************
  *
  * Function         l2cu_find_ccb_by_cid
@@ -3621,6 +3688,7 @@ BT_HDR* l2cu_get_next_buffer_to_send(tL2C_LCB* p_lcb,
   if (p_ccb->peer_cfg.fcr.mode == L2CAP_FCR_ECFC_MODE) {
     if (p_ccb->peer_conn_cfg.credits == 0) {
       L2CAP_TRACE_DEBUG("%s No credits to send packets", __func__);
+      l2c_stats_credit_stall(p_ccb, true);
       return NULL;
     }
     p_buf = l2c_lcc_get_next_xmit_sdu_seg(p_ccb, 0);
@@ -3633,6 +3701,7 @@ BT_HDR* l2cu_get_next_buffer_to_send(tL2C_LCB* p_lcb,
     /* Check credits */
     if (p_ccb->peer_conn_cfg.credits == 0) {
       L2CAP_TRACE_DEBUG("%s No credits to send packets", __func__);
+      l2c_stats_credit_stall(p_ccb, true);
       return NULL;
     }
     p_buf = l2c_lcc_get_next_xmit_sdu_seg(p_ccb, 0);
@@ -3746,6 +3815,7 @@ void l2cu_check_channel_congestion(tL2C_CCB* p_ccb) {
       /* If the channel is not congested now, tell the app */
       if (q_count <= (p_ccb->buff_quota / 2)) {
         p_ccb->cong_sent = false;
+        l2c_stats_congestion(p_ccb, false);
         if (p_ccb->p_rcb && p_ccb->p_rcb->api.pL2CA_CongestionStatus_Cb) {
           L2CAP_TRACE_DEBUG(
               "L2CAP - Calling CongestionStatus_Cb (false), CID: 0x%04x  "
@@ -3790,6 +3860,7 @@ void l2cu_check_channel_congestion(tL2C_CCB* p_ccb) {
        */
       if (q_count > p_ccb->buff_quota) {
         p_ccb->cong_sent = true;
+        l2c_stats_congestion(p_ccb, true);
         if (p_ccb->p_rcb && p_ccb->p_rcb->api.pL2CA_CongestionStatus_Cb) {
           L2CAP_TRACE_WARNING(
               "L2CAP - Calling CongestionStatus_Cb "
@@ -4802,7 +4873,8 @@ void l2cu_post_data_ind_cb_to_btu(tL2C_CCB* p_ccb) {
   }
 
   if ((p_ccb->p_rcb) && (p_ccb->p_rcb->coc_api.pL2CA_CocDataInd_Cb)) {
-    btu_message_loop->task_runner()->PostTask(FROM_HERE,
+    do_in_main_thread_prio(
+        BTU_TASK_PRIO_CONN, FROM_HERE,
         base::Bind(*p_ccb->p_rcb->coc_api.pL2CA_CocDataInd_Cb, p_ccb->local_cid));
   }
 }
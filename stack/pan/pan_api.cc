@@ -587,6 +587,42 @@ tPAN_RESULT PAN_WriteBuf(uint16_t handle, const RawAddress& dst,
   return PAN_SUCCESS;
 }
 
+/*******************************************************************************
+ *
+ * Function         PAN_IsTxQueueFull
+ *
+ * Description      This tells if a unicast PAN_WriteBuf on the handle would
+ *                  fail with PAN_Q_SIZE_EXCEEDED and drop the buffer. The
+ *                  connection is picked the way PAN_WriteBuf picks it.
+ *
+ * Parameters:      handle   - handle for the connection
+ *
+ * Returns          true if the transmit queue of the connection is full
+ *
+ ******************************************************************************/
+bool PAN_IsTxQueueFull(uint16_t handle) {
+  tPAN_CONN* pcb = NULL;
+  uint16_t i;
+
+  if (pan_cb.role == PAN_ROLE_INACTIVE || (!(pan_cb.num_conns))) return false;
+
+  if (pan_cb.active_role == PAN_ROLE_CLIENT) {
+    for (i = 0; i < MAX_PAN_CONNS; i++) {
+      if (pan_cb.pcb[i].con_state == PAN_STATE_CONNECTED &&
+          pan_cb.pcb[i].src_uuid == UUID_SERVCLASS_PANU) {
+        pcb = &pan_cb.pcb[i];
+        break;
+      }
+    }
+  } else {
+    pcb = pan_get_pcb_by_handle(handle);
+  }
+
+  if (!pcb || pcb->con_state != PAN_STATE_CONNECTED) return false;
+
+  return BNEP_IsTxQueueFull(pcb->handle);
+}
+
 /*******************************************************************************
  *
  * Function         PAN_SetProtocolFilters
@@ -25,10 +25,13 @@
 #define LOG_TAG "bt_port_api"
 
 #include <base/logging.h>
+#include <stdio.h>
 #include <string.h>
+#include <sys/uio.h>
 
 #include "osi/include/log.h"
 #include "osi/include/mutex.h"
+#include "osi/include/time.h"
 
 #include "bt_common.h"
 #include "btm_api.h"
@@ -1095,6 +1098,72 @@ int PORT_GetQueueStatus(uint16_t handle, tPORT_STATUS* p_status) {
   return (PORT_SUCCESS);
 }
 
+/*******************************************************************************
+ *
+ * Function         PORT_GetDlcStats
+ *
+ * Description      This function copies the data and flow control counters
+ *                  of a connection.
+ *
+ * Parameters:      handle     - Handle returned in the RFCOMM_CreateConnection
+ *                  p_stats    - pointer to the tPORT_DLC_STATS structure to
+ *                               receive the counters
+ *
+ ******************************************************************************/
+int PORT_GetDlcStats(uint16_t handle, tPORT_DLC_STATS* p_stats) {
+  tPORT* p_port;
+
+  if ((handle == 0) || (handle > MAX_RFC_PORTS)) {
+    return (PORT_BAD_HANDLE);
+  }
+
+  p_port = &rfc_cb.port.port[handle - 1];
+
+  if (!p_port->in_use || (p_port->state == PORT_STATE_CLOSED)) {
+    return (PORT_NOT_OPENED);
+  }
+
+  *p_stats = p_port->stats;
+  p_stats->credit_rx_max = p_port->credit_rx_max;
+
+  /* Include the stall that is still going on */
+  if (p_port->tx_stall_start_ms != 0)
+    p_stats->congested_ms +=
+        time_get_os_boottime_ms() - p_port->tx_stall_start_ms;
+
+  return (PORT_SUCCESS);
+}
+
+/*******************************************************************************
+ *
+ * Function         PORT_DumpDlcStats
+ *
+ * Description      Writes the counters of every open DLC to |fd|.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void PORT_DumpDlcStats(int fd) {
+  tPORT_DLC_STATS stats;
+
+  dprintf(fd, "\nRFCOMM DLC Statistics:\n");
+  for (int i = 0; i < MAX_RFC_PORTS; i++) {
+    tPORT* p_port = &rfc_cb.port.port[i];
+    if (PORT_GetDlcStats(p_port->inx, &stats) != PORT_SUCCESS) continue;
+
+    dprintf(fd, "  %s dlci:%d scn:%d handle:%d\n",
+            p_port->bd_addr.ToString().c_str(), p_port->dlci, p_port->scn,
+            p_port->inx);
+    dprintf(fd, "    tx: %u frames %u bytes  rx: %u frames %u bytes\n",
+            stats.tx_frames, stats.tx_bytes, stats.rx_frames, stats.rx_bytes);
+    dprintf(fd,
+            "    credit stalls: %u  congested: %u ms  credit window: %u "
+            "(initial %u)  tx credits: %u\n",
+            stats.credit_stalls, stats.congested_ms, stats.credit_rx_max,
+            p_port->credit_rx_base, p_port->credit_tx);
+  }
+}
+
 /*******************************************************************************
  *
  * Function         PORT_Purge
@@ -1536,41 +1605,68 @@ int PORT_WriteDataCO(uint16_t handle, int* p_len) {
       break;
     }
 
-    /* continue with rfcomm data write */
-    p_buf = (BT_HDR*)osi_malloc(RFCOMM_DATA_BUF_SIZE);
-    p_buf->offset = L2CAP_MIN_OFFSET + RFCOMM_MIN_OFFSET;
-    p_buf->layer_specific = handle;
-
     if (p_port->peer_mtu < length) length = p_port->peer_mtu;
-    if (available < (int)length) length = (uint16_t)available;
-    p_buf->len = length;
-    p_buf->event = BT_EVT_TO_BTU_SP_DATA;
 
-    // memcpy ((uint8_t *)(p_buf + 1) + p_buf->offset, p_data, length);
-    // if(recv(fd, (uint8_t *)(p_buf + 1) + p_buf->offset, (int)length, 0) !=
-    // (int)length)
-    if (p_port->p_data_co_callback(
-            handle, (uint8_t*)(p_buf + 1) + p_buf->offset, length,
-            DATA_CO_CALLBACK_TYPE_OUTGOING) == false) {
+    /* continue with rfcomm data write, filling as many buffers as stay */
+    /* below the high water marks with a single call-out read */
+    BT_HDR* bufs[PORT_CO_MAX_IOV];
+    struct iovec iov[PORT_CO_MAX_IOV];
+    int count = 0;
+    int batch_len = 0;
+    do {
+      uint16_t buf_len = length;
+      if (available - batch_len < (int)buf_len)
+        buf_len = (uint16_t)(available - batch_len);
+
+      p_buf = (BT_HDR*)osi_malloc(RFCOMM_DATA_BUF_SIZE);
+      p_buf->offset = L2CAP_MIN_OFFSET + RFCOMM_MIN_OFFSET;
+      p_buf->layer_specific = handle;
+      p_buf->len = buf_len;
+      p_buf->event = BT_EVT_TO_BTU_SP_DATA;
+
+      iov[count].iov_base = (uint8_t*)(p_buf + 1) + p_buf->offset;
+      iov[count].iov_len = buf_len;
+      bufs[count++] = p_buf;
+      batch_len += buf_len;
+    } while ((count < PORT_CO_MAX_IOV) && (batch_len < available) &&
+             (p_port->tx.queue_size + batch_len <= PORT_TX_HIGH_WM) &&
+             (fixed_queue_length(p_port->tx.queue) + count <=
+              PORT_TX_BUF_HIGH_WM));
+
+    if (p_port->p_data_co_callback(handle, (uint8_t*)iov, count,
+                                   DATA_CO_CALLBACK_TYPE_OUTGOING_IOV) ==
+        false) {
       error(
-          "p_data_co_callback DATA_CO_CALLBACK_TYPE_OUTGOING failed, length:%d",
-          length);
+          "p_data_co_callback DATA_CO_CALLBACK_TYPE_OUTGOING_IOV failed, "
+          "length:%d",
+          batch_len);
+      for (int i = 0; i < count; i++) osi_free(bufs[i]);
       return (PORT_UNKNOWN_ERROR);
     }
 
-    RFCOMM_TRACE_EVENT("PORT_WriteData %d bytes", length);
+    RFCOMM_TRACE_EVENT("PORT_WriteData %d bytes in %d buffers", batch_len,
+                       count);
 
-    rc = port_write(p_port, p_buf);
+    for (int i = 0; i < count; i++) {
+      uint16_t buf_len = bufs[i]->len;
 
-    /* If queue went below the threashold need to send flow control */
-    event |= port_flow_control_user(p_port);
+      rc = port_write(p_port, bufs[i]);
 
-    if (rc == PORT_SUCCESS) event |= PORT_EV_TXCHAR;
+      /* If queue went below the threashold need to send flow control */
+      event |= port_flow_control_user(p_port);
 
-    if ((rc != PORT_SUCCESS) && (rc != PORT_CMD_PENDING)) break;
+      if (rc == PORT_SUCCESS) event |= PORT_EV_TXCHAR;
 
-    *p_len += length;
-    available -= (int)length;
+      if ((rc != PORT_SUCCESS) && (rc != PORT_CMD_PENDING)) {
+        while (++i < count) osi_free(bufs[i]);
+        break;
+      }
+
+      *p_len += buf_len;
+      available -= (int)buf_len;
+    }
+
+    if ((rc != PORT_SUCCESS) && (rc != PORT_CMD_PENDING)) break;
   }
   if (!available && (rc != PORT_CMD_PENDING) && (rc != PORT_TX_QUEUE_DISABLED))
     event |= PORT_EV_TXEMPTY;
@@ -1747,6 +1843,8 @@ void RFCOMM_Init(void) {
 
   rfc_cb.rfc.last_mux = MAX_BD_CONNECTIONS;
 
+  rfc_init_uih_fcs();
+
 #if defined(RFCOMM_INITIAL_TRACE_LEVEL)
   rfc_cb.trace_level = RFCOMM_INITIAL_TRACE_LEVEL;
 #else
@@ -104,6 +104,7 @@ typedef struct {
   uint8_t flow;           /* flow control mechanism for this mux */
   bool l2cap_congested;   /* true if L2CAP is congested */
   bool is_disc_initiator; /* true if initiated disc of port */
+  uint8_t tx_rr_next;     /* Port index served first when the link resumes */
   uint16_t
       pending_lcid; /* store LCID for incoming connection while connecting */
   uint8_t
@@ -200,11 +201,15 @@ typedef struct {
                           /* number of buffers peer is allowed to sent */
   uint16_t
       credit_rx_max; /* Max number of credits we will allow this guy to sent */
+  uint16_t credit_rx_base; /* Credit window selected from the MTU */
   uint16_t credit_rx_low;   /* Number of credits when we send credit update */
   uint16_t rx_buf_critical; /* port receive queue critical watermark level */
   bool keep_port_handle;    /* true if port is not deallocated when closing */
   /* it is set to true for server when allocating port */
   uint16_t keep_mtu; /* Max MTU that port can receive by server */
+
+  tPORT_DLC_STATS stats;
+  uint32_t tx_stall_start_ms; /* When the peer stopped tx, 0 if it did not */
 } tPORT;
 
 /* Define the PORT/RFCOMM control structure
@@ -229,6 +234,7 @@ extern uint32_t port_get_signal_changes(tPORT* p_port, uint8_t old_signals,
                                         uint8_t signal);
 extern uint32_t port_flow_control_user(tPORT* p_port);
 extern void port_flow_control_peer(tPORT* p_port, bool enable, uint16_t count);
+extern void port_update_tx_stall(tPORT* p_port);
 
 /*
  * Functions provided by the port_rfc.cc
@@ -45,6 +45,7 @@
  * Local function definitions
 */
 uint32_t port_rfc_send_tx_data(tPORT* p_port);
+uint32_t port_rfc_send_tx_frames(tPORT* p_port, uint16_t max_frames);
 void port_rfc_closed(tPORT* p_port, uint8_t res);
 void port_get_credits(tPORT* p_port, uint8_t k);
 
@@ -773,6 +774,8 @@ void PORT_DataInd(tRFC_MCB* p_mcb, uint8_t dlci, BT_HDR* p_buf) {
     osi_free(p_buf);
     return;
   }
+  p_port->stats.rx_frames++;
+  p_port->stats.rx_bytes += p_buf->len;
   /* If client registered callout callback with flow control we can just deliver
    * receive data */
   if (p_port->p_data_co_callback) {
@@ -853,28 +856,17 @@ void PORT_DataInd(tRFC_MCB* p_mcb, uint8_t dlci, BT_HDR* p_buf) {
 void PORT_FlowInd(tRFC_MCB* p_mcb, uint8_t dlci, bool enable_data) {
   tPORT* p_port = (tPORT*)NULL;
   uint32_t events = 0;
+  uint32_t tx_events[MAX_RFC_PORTS];
   int i;
 
   RFCOMM_TRACE_EVENT("PORT_FlowInd fc:%d", enable_data);
 
-  if (dlci == 0) {
-    p_mcb->peer_ready = enable_data;
-  } else {
+  if (dlci != 0) {
     p_port = port_find_mcb_dlci_port(p_mcb, dlci);
     if (p_port == NULL) return;
 
     p_port->tx.peer_fc = !enable_data;
-  }
-
-  for (i = 0; i < MAX_RFC_PORTS; i++) {
-    /* If DLCI is 0 event applies to all ports */
-    if (dlci == 0) {
-      p_port = &rfc_cb.port.port[i];
-      if (!p_port->in_use || (p_port->rfc.p_mcb != p_mcb) ||
-          (p_port->rfc.state != RFC_STATE_OPENED))
-        continue;
-    }
-    events = 0;
+    port_update_tx_stall(p_port);
 
     /* Check if flow of data is still enabled */
     events |= port_flow_control_user(p_port);
@@ -887,9 +879,51 @@ void PORT_FlowInd(tRFC_MCB* p_mcb, uint8_t dlci, bool enable_data) {
 
     /* Send event to the application */
     if (p_port->p_callback && events) (p_port->p_callback)(events, p_port->inx);
+    return;
+  }
+
+  /* Event applies to all ports of the multiplexer */
+  p_mcb->peer_ready = enable_data;
+
+  /* Let the ports send PORT_TX_BUF_PER_TURN frames each in turn, starting */
+  /* after the port that sent last time, so that a busy DLC does not starve */
+  /* the others when the link keeps getting congested. */
+  memset(tx_events, 0, sizeof(tx_events));
+  uint8_t start = p_mcb->tx_rr_next;
+  bool sent = true;
+  while (sent && p_mcb->peer_ready) {
+    sent = false;
+    for (i = 0; (i < MAX_RFC_PORTS) && p_mcb->peer_ready; i++) {
+      uint8_t inx = (start + i) % MAX_RFC_PORTS;
+      p_port = &rfc_cb.port.port[inx];
+      if (!p_port->in_use || (p_port->rfc.p_mcb != p_mcb) ||
+          (p_port->rfc.state != RFC_STATE_OPENED) ||
+          (p_port->tx.queue_size == 0) || p_port->tx.peer_fc)
+        continue;
+
+      size_t queued = fixed_queue_length(p_port->tx.queue);
+      tx_events[inx] |= port_rfc_send_tx_frames(p_port, PORT_TX_BUF_PER_TURN);
+      if (fixed_queue_length(p_port->tx.queue) != queued) {
+        sent = true;
+        p_mcb->tx_rr_next = (inx + 1) % MAX_RFC_PORTS;
+      }
+    }
+  }
 
-    /* If DLCI is not 0 event applies to one port only */
-    if (dlci != 0) break;
+  for (i = 0; i < MAX_RFC_PORTS; i++) {
+    p_port = &rfc_cb.port.port[i];
+    if (!p_port->in_use || (p_port->rfc.p_mcb != p_mcb) ||
+        (p_port->rfc.state != RFC_STATE_OPENED))
+      continue;
+
+    /* Check if flow of data is still enabled */
+    events = port_flow_control_user(p_port) | tx_events[i];
+
+    /* Mask out all events that are not of interest to user */
+    events &= p_port->ev_mask;
+
+    /* Send event to the application */
+    if (p_port->p_callback && events) (p_port->p_callback)(events, p_port->inx);
   }
 }
 
@@ -901,6 +935,18 @@ void PORT_FlowInd(tRFC_MCB* p_mcb, uint8_t dlci, bool enable_data) {
  *
  ******************************************************************************/
 uint32_t port_rfc_send_tx_data(tPORT* p_port) {
+  return port_rfc_send_tx_frames(p_port, UINT16_MAX);
+}
+
+/*******************************************************************************
+ *
+ * Function         port_rfc_send_tx_frames
+ *
+ * Description      This function sends up to max_frames queued frames to the
+ *                  peer while it accepts data
+ *
+ ******************************************************************************/
+uint32_t port_rfc_send_tx_frames(tPORT* p_port, uint16_t max_frames) {
   uint32_t events = 0;
   BT_HDR* p_buf;
 
@@ -908,7 +954,7 @@ uint32_t port_rfc_send_tx_data(tPORT* p_port) {
   if (p_port->tx.queue_size > 0) {
     /* while the rfcomm peer is not flow controlling us, and peer is ready */
     while (!p_port->tx.peer_fc && p_port->rfc.p_mcb &&
-           p_port->rfc.p_mcb->peer_ready) {
+           p_port->rfc.p_mcb->peer_ready && max_frames--) {
       /* get data from tx queue and send it */
       mutex_global_lock();
 
@@ -25,6 +25,7 @@
 #include <string.h>
 
 #include "osi/include/mutex.h"
+#include "osi/include/time.h"
 
 #include "bt_common.h"
 #include "bt_target.h"
@@ -117,6 +118,9 @@ void port_set_defaults(tPORT* p_port) {
   p_port->credit_tx = 0;
   p_port->credit_rx = 0;
 
+  memset(&p_port->stats, 0, sizeof(p_port->stats));
+  p_port->tx_stall_start_ms = 0;
+
   memset(&p_port->local_ctrl, 0, sizeof(p_port->local_ctrl));
   memset(&p_port->peer_ctrl, 0, sizeof(p_port->peer_ctrl));
   memset(&p_port->rx, 0, sizeof(p_port->rx));
@@ -181,6 +185,7 @@ void port_select_mtu(tPORT* p_port) {
   p_port->credit_rx_max = (PORT_RX_HIGH_WM / p_port->mtu);
   if (p_port->credit_rx_max > PORT_RX_BUF_HIGH_WM)
     p_port->credit_rx_max = PORT_RX_BUF_HIGH_WM;
+  p_port->credit_rx_base = p_port->credit_rx_max;
   p_port->credit_rx_low = (PORT_RX_LOW_WM / p_port->mtu);
   if (p_port->credit_rx_low > PORT_RX_BUF_LOW_WM)
     p_port->credit_rx_low = PORT_RX_BUF_LOW_WM;
@@ -469,6 +474,18 @@ void port_flow_control_peer(tPORT* p_port, bool enable, uint16_t count) {
         p_port->credit_rx -= count;
       }
 
+      /* The peer used up the whole window and the app took the frame right */
+      /* away, so the window is what limits this DLC. Grow it unless the */
+      /* link is already congested. */
+      if ((count == 1) && (p_port->credit_rx == 0) &&
+          (p_port->p_data_callback || p_port->p_data_co_callback) &&
+          !p_port->rfc.p_mcb->l2cap_congested &&
+          (p_port->credit_rx_max < PORT_CREDIT_RX_MAX)) {
+        p_port->credit_rx_max++;
+        RFCOMM_TRACE_DEBUG("%s: dlci %d credit_rx_max %d", __func__,
+                           p_port->dlci, p_port->credit_rx_max);
+      }
+
       /* If credit count is less than low credit watermark, and user */
       /* did not force flow control, send a credit update */
       /* There might be a special case when we just adjusted rx_max */
@@ -487,6 +504,13 @@ void port_flow_control_peer(tPORT* p_port, bool enable, uint16_t count) {
       /* if client registered data callback, just do what they want */
       if (p_port->p_data_callback || p_port->p_data_co_callback) {
         p_port->rx.peer_fc = true;
+
+        /* The app is not keeping up, fall back towards the initial window */
+        if (p_port->credit_rx_max > p_port->credit_rx_base) {
+          p_port->credit_rx_max = p_port->credit_rx_max / 2;
+          if (p_port->credit_rx_max < p_port->credit_rx_base)
+            p_port->credit_rx_max = p_port->credit_rx_base;
+        }
       }
       /* if queue count reached credit rx max, set peer fc */
       else if (fixed_queue_length(p_port->rx.queue) >= p_port->credit_rx_max) {
@@ -529,3 +553,24 @@ void port_flow_control_peer(tPORT* p_port, bool enable, uint16_t count) {
     }
   }
 }
+
+/*******************************************************************************
+ *
+ * Function         port_update_tx_stall
+ *
+ * Description      Called when the peer flow control state of the port
+ *                  changes. Accumulates the time tx was stopped by the peer.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void port_update_tx_stall(tPORT* p_port) {
+  if (p_port->tx.peer_fc) {
+    if (p_port->tx_stall_start_ms == 0)
+      p_port->tx_stall_start_ms = time_get_os_boottime_ms() | 1;
+  } else if (p_port->tx_stall_start_ms != 0) {
+    p_port->stats.congested_ms +=
+        time_get_os_boottime_ms() - p_port->tx_stall_start_ms;
+    p_port->tx_stall_start_ms = 0;
+  }
+}
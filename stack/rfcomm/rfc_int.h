@@ -254,25 +254,19 @@ extern tRFC_CB rfc_cb;
 #define RFCOMM_ERR_BAD_DISC 4
 #define RFCOMM_ERR_BAD_UIH 5
 
-#ifdef RFCOMM_PRECALC_FCS
-
-#define RFCOMM_SABME_FCS(p_data, cr, dlci) rfc_sabme_fcs[cr][dlci]
-#define RFCOMM_UA_FCS(p_data, cr, dlci) rfc_ua_fcs[cr][dlci]
-#define RFCOMM_DM_FCS(p_data, cr, dlci) rfc_dm_fcs[cr][dlci]
-#define RFCOMM_DISC_FCS(p_data, cr, dlci) rfc_disc_fcs[cr][dlci]
-#define RFCOMM_UIH_FCS(p_data, dlci) rfc_uih_fcs[dlci]
-
-#else
-
 extern uint8_t rfc_calc_fcs(uint16_t len, uint8_t* p);
 
+/* FCS of a UIH frame, which only covers the address and control bytes. */
+/* Indexed by the PF bit of the control byte and by the address byte. */
+extern uint8_t rfc_uih_fcs[2][256];
+extern void rfc_init_uih_fcs(void);
+
 #define RFCOMM_SABME_FCS(p_data, cr, dlci) rfc_calc_fcs(3, p_data)
 #define RFCOMM_UA_FCS(p_data, cr, dlci) rfc_calc_fcs(3, p_data)
 #define RFCOMM_DM_FCS(p_data, cr, dlci) rfc_calc_fcs(3, p_data)
 #define RFCOMM_DISC_FCS(p_data, cr, dlci) rfc_calc_fcs(3, p_data)
-#define RFCOMM_UIH_FCS(p_data, dlci) rfc_calc_fcs(2, p_data)
-
-#endif
+#define RFCOMM_UIH_FCS(p_data, dlci) \
+  rfc_uih_fcs[((p_data)[1] & RFCOMM_PF) >> RFCOMM_PF_OFFSET][(p_data)[0]]
 
 extern void rfc_mx_sm_execute(tRFC_MCB* p_mcb, uint16_t event, void* p_data);
 
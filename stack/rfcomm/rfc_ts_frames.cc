@@ -601,7 +601,7 @@ uint8_t rfc_parse_data(tRFC_MCB* p_mcb, MX_FRAME* p_frame, BT_HDR* p_buf) {
       if (!RFCOMM_VALID_DLCI(p_frame->dlci)) {
         RFCOMM_TRACE_ERROR("Bad UIH - invalid DLCI");
         return (RFC_EVENT_BAD_FRAME);
-      } else if (!rfc_check_fcs(2, p_start, fcs)) {
+      } else if (RFCOMM_UIH_FCS(p_start, p_frame->dlci) != fcs) {
         RFCOMM_TRACE_ERROR("Bad UIH - FCS");
         return (RFC_EVENT_BAD_FRAME);
       } else if (RFCOMM_FRAME_IS_RSP(p_mcb->is_initiator, p_frame->cr)) {
@@ -96,6 +96,28 @@ uint8_t rfc_calc_fcs(uint16_t len, uint8_t* p) {
   return (0xFF - fcs);
 }
 
+/*******************************************************************************
+ *
+ * Function         rfc_init_uih_fcs
+ *
+ * Description      This function fills the UIH FCS table for every address
+ *                  byte, with and without the PF bit in the control byte
+ *
+ ******************************************************************************/
+uint8_t rfc_uih_fcs[2][256];
+
+void rfc_init_uih_fcs(void) {
+  uint8_t hdr[2];
+
+  for (int pf = 0; pf < 2; pf++) {
+    hdr[1] = RFCOMM_UIH | (pf << RFCOMM_PF_OFFSET);
+    for (int addr = 0; addr < 256; addr++) {
+      hdr[0] = (uint8_t)addr;
+      rfc_uih_fcs[pf][addr] = rfc_calc_fcs(2, hdr);
+    }
+  }
+}
+
 /*******************************************************************************
  *
  * Function         rfc_check_fcs
@@ -413,7 +435,11 @@ void rfc_dec_credit(tPORT* p_port) {
 
         RFCOMM_TRACE_EVENT ("rfc_dec_credit:%d", p_port->credit_tx);
 
-    if (p_port->credit_tx == 0) p_port->tx.peer_fc = true;
+    if ((p_port->credit_tx == 0) && !p_port->tx.peer_fc) {
+      p_port->tx.peer_fc = true;
+      p_port->stats.credit_stalls++;
+      port_update_tx_stall(p_port);
+    }
   }
 }
 
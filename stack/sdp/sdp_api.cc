@@ -169,8 +169,9 @@ bool SDP_ServiceSearchAttributeRequest(const RawAddress& p_bd_addr,
                                        tSDP_DISC_CMPL_CB* p_cb) {
   tCONN_CB* p_ccb;
 
-  /* Specific BD address */
-  p_ccb = sdp_conn_originate(p_bd_addr);
+  /* Reuse a recent result for the same peer and filters, else connect */
+  p_ccb = sdp_disc_originate_cached(p_bd_addr, p_db);
+  if (!p_ccb) p_ccb = sdp_conn_originate(p_bd_addr);
 
   if (!p_ccb) return (false);
 
@@ -202,8 +203,9 @@ bool SDP_ServiceSearchAttributeRequest2(const RawAddress& p_bd_addr,
                                         void* user_data) {
   tCONN_CB* p_ccb;
 
-  /* Specific BD address */
-  p_ccb = sdp_conn_originate(p_bd_addr);
+  /* Reuse a recent result for the same peer and filters, else connect */
+  p_ccb = sdp_disc_originate_cached(p_bd_addr, p_db);
+  if (!p_ccb) p_ccb = sdp_conn_originate(p_bd_addr);
 
   if (!p_ccb) return (false);
 
@@ -78,19 +78,242 @@
 /******************************************************************************/
 static bool find_uuid_in_seq(uint8_t* p, uint32_t seq_len, uint8_t* p_his_uuid,
                              uint16_t his_len, int nest_level);
+static void sdp_db_rebuild_uuid_index(void);
+static void sdp_db_update_uuid_index(uint16_t rec_idx);
+static void sdp_db_remove_uuid_index(uint16_t rec_idx);
+
+#define SDP_REC_MASK_TEST(mask, idx) ((mask)[(idx) >> 3] & (1 << ((idx) & 7)))
+#define SDP_REC_MASK_SET(mask, idx) ((mask)[(idx) >> 3] |= (1 << ((idx) & 7)))
+#define SDP_REC_MASK_CLR(mask, idx) \
+  ((mask)[(idx) >> 3] &= ~(1 << ((idx) & 7)))
 
 /*******************************************************************************
  *
- * Function         sdp_db_service_search
+ * Function         sdp_db_find_uuid_index
+ *
+ * Description      This function looks up a 128-bit UUID in the database UUID
+ *                  index. The index is sorted, so this is a binary search.
+ *
+ * Returns          Pointer to the index entry, or NULL if not found. p_pos is
+ *                  set to the position the UUID is, or would be inserted at.
+ *
+ ******************************************************************************/
+static tSDP_UUID_INDEX* sdp_db_find_uuid_index(const uint8_t* p_uuid128,
+                                               uint16_t* p_pos) {
+  tSDP_DB* p_db = &sdp_cb.server_db;
+  uint16_t lo = 0, hi = p_db->num_uuid_index;
+
+  while (lo < hi) {
+    uint16_t mid = (lo + hi) / 2;
+    int cmp = memcmp(p_db->uuid_index[mid].uuid, p_uuid128, 16);
+    if (cmp == 0) {
+      if (p_pos) *p_pos = mid;
+      return &p_db->uuid_index[mid];
+    }
+    if (cmp < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (p_pos) *p_pos = lo;
+  return NULL;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_db_index_uuid
+ *
+ * Description      This function notes in the UUID index that the record in
+ *                  slot rec_idx contains the given UUID.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void sdp_db_index_uuid(uint8_t* p_uuid, uint32_t len, uint16_t rec_idx) {
+  tSDP_DB* p_db = &sdp_cb.server_db;
+  uint8_t uuid128[16];
+  uint16_t pos;
+  tSDP_UUID_INDEX* p_entry;
+
+  if (!sdpu_expand_uuid_to_128(p_uuid, len, uuid128)) return;
+
+  p_entry = sdp_db_find_uuid_index(uuid128, &pos);
+  if (p_entry == NULL) {
+    if (p_db->num_uuid_index >= SDP_MAX_UUID_INDEX) {
+      SDP_TRACE_WARNING("%s: UUID index full, searching without it",
+                        __func__);
+      p_db->uuid_index_overflow = true;
+      return;
+    }
+    memmove(&p_db->uuid_index[pos + 1], &p_db->uuid_index[pos],
+            (p_db->num_uuid_index - pos) * sizeof(tSDP_UUID_INDEX));
+    p_db->num_uuid_index++;
+    p_entry = &p_db->uuid_index[pos];
+    memcpy(p_entry->uuid, uuid128, sizeof(uuid128));
+    memset(p_entry->rec_mask, 0, sizeof(p_entry->rec_mask));
+  }
+  SDP_REC_MASK_SET(p_entry->rec_mask, rec_idx);
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_db_index_seq
+ *
+ * Description      This function adds the UUIDs of a data element sequence to
+ *                  the UUID index, walking it the way find_uuid_in_seq does.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void sdp_db_index_seq(uint8_t* p, uint32_t seq_len, uint16_t rec_idx,
+                             int nest_level) {
+  uint8_t* p_end = p + seq_len;
+  uint8_t type;
+  uint32_t len;
+
+  if (nest_level > 3) return;
+
+  while (p < p_end) {
+    type = *p++;
+    p = sdpu_get_len_from_type(p, p_end, type, &len);
+    if (p == NULL || (p + len) > p_end) break;
+    type = type >> 3;
+    if (type == UUID_DESC_TYPE)
+      sdp_db_index_uuid(p, len, rec_idx);
+    else if (type == DATA_ELE_SEQ_DESC_TYPE)
+      sdp_db_index_seq(p, len, rec_idx, nest_level + 1);
+    p = p + len;
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_db_index_record
+ *
+ * Description      This function adds the UUIDs of the record in slot rec_idx
+ *                  to the UUID index.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void sdp_db_index_record(uint16_t rec_idx) {
+  tSDP_RECORD* p_rec = &sdp_cb.server_db.record[rec_idx];
+  tSDP_ATTRIBUTE* p_attr = &p_rec->attribute[0];
+
+  for (uint16_t xx = 0; xx < p_rec->num_attributes; xx++, p_attr++) {
+    if (p_attr->type == UUID_DESC_TYPE)
+      sdp_db_index_uuid(p_attr->value_ptr, p_attr->len, rec_idx);
+    else if (p_attr->type == DATA_ELE_SEQ_DESC_TYPE)
+      sdp_db_index_seq(p_attr->value_ptr, p_attr->len, rec_idx, 0);
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_db_unindex_record
+ *
+ * Description      This function clears the record in slot rec_idx from the
+ *                  UUID index. If shift is set, the record is being deleted
+ *                  and the slots above it move down by one. Entries left
+ *                  without records are dropped.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void sdp_db_unindex_record(uint16_t rec_idx, bool shift) {
+  tSDP_DB* p_db = &sdp_cb.server_db;
+  uint16_t xx, yy, kept = 0;
+
+  for (xx = 0; xx < p_db->num_uuid_index; xx++) {
+    uint8_t* mask = p_db->uuid_index[xx].rec_mask;
+    bool used = false;
+
+    SDP_REC_MASK_CLR(mask, rec_idx);
+    if (shift) {
+      for (yy = rec_idx; yy + 1 < SDP_MAX_RECORDS; yy++) {
+        if (SDP_REC_MASK_TEST(mask, yy + 1))
+          SDP_REC_MASK_SET(mask, yy);
+        else
+          SDP_REC_MASK_CLR(mask, yy);
+      }
+      SDP_REC_MASK_CLR(mask, SDP_MAX_RECORDS - 1);
+    }
+    for (yy = 0; yy < SDP_REC_MASK_LEN; yy++) used |= (mask[yy] != 0);
+
+    if (used) {
+      if (kept != xx) p_db->uuid_index[kept] = p_db->uuid_index[xx];
+      kept++;
+    }
+  }
+  p_db->num_uuid_index = kept;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_db_rebuild_uuid_index
+ *
+ * Description      This function rebuilds the UUID index from all records.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void sdp_db_rebuild_uuid_index(void) {
+  tSDP_DB* p_db = &sdp_cb.server_db;
+
+  p_db->num_uuid_index = 0;
+  p_db->uuid_index_overflow = false;
+  for (uint16_t xx = 0; xx < p_db->num_records; xx++) sdp_db_index_record(xx);
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_db_update_uuid_index
+ *
+ * Description      This function refreshes the UUID index after attributes of
+ *                  the record in slot rec_idx changed.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void sdp_db_update_uuid_index(uint16_t rec_idx) {
+  if (sdp_cb.server_db.uuid_index_overflow) {
+    sdp_db_rebuild_uuid_index();
+    return;
+  }
+  sdp_db_unindex_record(rec_idx, false);
+  sdp_db_index_record(rec_idx);
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_db_remove_uuid_index
+ *
+ * Description      This function updates the UUID index after the record in
+ *                  slot rec_idx has been deleted.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void sdp_db_remove_uuid_index(uint16_t rec_idx) {
+  if (sdp_cb.server_db.uuid_index_overflow)
+    sdp_db_rebuild_uuid_index();
+  else
+    sdp_db_unindex_record(rec_idx, true);
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_db_service_search_scan
  *
  * Description      This function searches for a record that contains the
- *                  specified UIDs. It is passed either NULL to start at the
- *                  beginning, or the previous record found.
+ *                  specified UIDs by scanning the attributes of every record.
+ *                  It is used when the UUID index is incomplete.
  *
  * Returns          Pointer to the record, or NULL if not found.
  *
  ******************************************************************************/
-tSDP_RECORD* sdp_db_service_search(tSDP_RECORD* p_rec, tSDP_UUID_SEQ* p_seq) {
+static tSDP_RECORD* sdp_db_service_search_scan(tSDP_RECORD* p_rec,
+                                               tSDP_UUID_SEQ* p_seq) {
   uint16_t xx, yy;
   tSDP_ATTRIBUTE* p_attr;
   tSDP_RECORD* p_end = &sdp_cb.server_db.record[sdp_cb.server_db.num_records];
@@ -132,6 +355,50 @@ tSDP_RECORD* sdp_db_service_search(tSDP_RECORD* p_rec, tSDP_UUID_SEQ* p_seq) {
   return (NULL);
 }
 
+/*******************************************************************************
+ *
+ * Function         sdp_db_service_search
+ *
+ * Description      This function searches for a record that contains the
+ *                  specified UIDs. It is passed either NULL to start at the
+ *                  beginning, or the previous record found.
+ *
+ * Returns          Pointer to the record, or NULL if not found.
+ *
+ ******************************************************************************/
+tSDP_RECORD* sdp_db_service_search(tSDP_RECORD* p_rec, tSDP_UUID_SEQ* p_seq) {
+  tSDP_DB* p_db = &sdp_cb.server_db;
+  uint8_t mask[SDP_REC_MASK_LEN];
+  uint8_t uuid128[16];
+  uint16_t xx, yy;
+
+  if (p_db->uuid_index_overflow ||
+      (p_rec && (p_rec < &p_db->record[0] ||
+                 p_rec >= &p_db->record[p_db->num_records])))
+    return sdp_db_service_search_scan(p_rec, p_seq);
+
+  /* A record matches if it contains all the passed UUIDs, so intersect the
+   * record bitmaps of every UUID */
+  memset(mask, 0xFF, sizeof(mask));
+  for (yy = 0; yy < p_seq->num_uids; yy++) {
+    if (!sdpu_expand_uuid_to_128(&p_seq->uuid_entry[yy].value[0],
+                                 p_seq->uuid_entry[yy].len, uuid128))
+      return (NULL);
+    tSDP_UUID_INDEX* p_entry = sdp_db_find_uuid_index(uuid128, NULL);
+    if (p_entry == NULL) return (NULL);
+    for (xx = 0; xx < SDP_REC_MASK_LEN; xx++) mask[xx] &= p_entry->rec_mask[xx];
+  }
+
+  /* If NULL, start at the beginning, else after the specified record */
+  xx = p_rec ? (uint16_t)(p_rec - &p_db->record[0]) + 1 : 0;
+  for (; xx < p_db->num_records; xx++) {
+    if (SDP_REC_MASK_TEST(mask, xx)) return (&p_db->record[xx]);
+  }
+
+  /* If here, no more records found */
+  return (NULL);
+}
+
 /*******************************************************************************
  *
  * Function         find_uuid_in_seq
@@ -182,12 +449,18 @@ static bool find_uuid_in_seq(uint8_t* p, uint32_t seq_len, uint8_t* p_uuid,
  *
  ******************************************************************************/
 tSDP_RECORD* sdp_db_find_record(uint32_t handle) {
-  tSDP_RECORD* p_rec;
-  tSDP_RECORD* p_end = &sdp_cb.server_db.record[sdp_cb.server_db.num_records];
-
-  /* Look through the records for the caller's handle */
-  for (p_rec = &sdp_cb.server_db.record[0]; p_rec < p_end; p_rec++) {
-    if (p_rec->record_handle == handle) return (p_rec);
+  tSDP_RECORD* p_rec = &sdp_cb.server_db.record[0];
+  uint16_t lo = 0, hi = sdp_cb.server_db.num_records;
+
+  /* Handles are handed out in increasing order and deleting a record keeps
+   * the order of the others, so the records are sorted by handle */
+  while (lo < hi) {
+    uint16_t mid = (lo + hi) / 2;
+    if (p_rec[mid].record_handle == handle) return (&p_rec[mid]);
+    if (p_rec[mid].record_handle < handle)
+      lo = mid + 1;
+    else
+      hi = mid;
   }
 
   /* Record with that handle not found. */
@@ -208,14 +481,20 @@ tSDP_RECORD* sdp_db_find_record(uint32_t handle) {
  ******************************************************************************/
 tSDP_ATTRIBUTE* sdp_db_find_attr_in_rec(tSDP_RECORD* p_rec, uint16_t start_attr,
                                         uint16_t end_attr) {
-  tSDP_ATTRIBUTE* p_at;
-  uint16_t xx;
-
-  /* Note that the attributes in a record are assumed to be in sorted order */
-  for (xx = 0, p_at = &p_rec->attribute[0]; xx < p_rec->num_attributes;
-       xx++, p_at++) {
-    if ((p_at->id >= start_attr) && (p_at->id <= end_attr)) return (p_at);
+  tSDP_ATTRIBUTE* p_at = &p_rec->attribute[0];
+  uint16_t lo = 0, hi = p_rec->num_attributes;
+
+  /* The attributes in a record are kept in sorted order, so find the first
+   * one not below start_attr */
+  while (lo < hi) {
+    uint16_t mid = (lo + hi) / 2;
+    if (p_at[mid].id < start_attr)
+      lo = mid + 1;
+    else
+      hi = mid;
   }
+  if (lo < p_rec->num_attributes && p_at[lo].id <= end_attr)
+    return (&p_at[lo]);
 
   /* No matching attribute found */
   return (NULL);
@@ -341,10 +620,14 @@ bool SDP_DeleteRecord(uint32_t handle) {
   if (handle == 0 || sdp_cb.server_db.num_records == 0) {
     /* Delete all records in the database */
     sdp_cb.server_db.num_records = 0;
+    sdp_rsp_cache_invalidate();
 
     /* require new DI record to be created in SDP_SetLocalDiRecord */
     sdp_cb.server_db.di_primary_handle = 0;
 
+    sdp_cb.server_db.num_uuid_index = 0;
+    sdp_cb.server_db.uuid_index_overflow = false;
+
     return (true);
   } else {
     /* Find the record in the database */
@@ -362,6 +645,8 @@ bool SDP_DeleteRecord(uint32_t handle) {
         }
 
         sdp_cb.server_db.num_records--;
+        sdp_db_remove_uuid_index(xx);
+        sdp_rsp_cache_invalidate();
 
         SDP_TRACE_DEBUG("SDP_DeleteRecord ok, num_records:%d",
                         sdp_cb.server_db.num_records);
@@ -455,7 +740,11 @@ bool SDP_AddAttribute(uint32_t handle, uint16_t attr_id, uint8_t attr_type,
                         "full, skip adding the attribute", handle);
         return (false);
       }
-      return SDP_AddAttributeToRecord (p_rec, attr_id, attr_type, attr_len, p_val);
+      sdp_rsp_cache_invalidate();
+      bool added =
+          SDP_AddAttributeToRecord(p_rec, attr_id, attr_type, attr_len, p_val);
+      sdp_db_update_uuid_index(xx);
+      return added;
     }
   }
 #endif
@@ -980,8 +1269,11 @@ bool SDP_DeleteAttribute(uint32_t handle, uint16_t attr_id) {
     if (p_rec->record_handle == handle) {
       SDP_TRACE_API("Deleting attr_id 0x%04x for handle 0x%x",
           attr_id, handle);
-      if (SDP_DeleteAttributeFromRecord (p_rec, attr_id))
+      sdp_rsp_cache_invalidate();
+      if (SDP_DeleteAttributeFromRecord (p_rec, attr_id)) {
+        sdp_db_update_uuid_index(xx);
         return (true);
+      }
     }
   }
 #endif
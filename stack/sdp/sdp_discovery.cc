@@ -34,7 +34,9 @@
 #include "hcimsgs.h"
 #include "l2cdefs.h"
 #include "log/log.h"
+#include "osi/include/time.h"
 #include "sdp_api.h"
+#include "sdp_flat_db.h"
 #include "sdpint.h"
 
 using bluetooth::Uuid;
@@ -55,6 +57,7 @@ static void process_service_search_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
 static uint8_t* save_attr_seq(tCONN_CB* p_ccb, uint8_t* p, uint8_t* p_msg_end);
 static tSDP_DISC_REC* add_record(tSDP_DISCOVERY_DB* p_db,
                                  const RawAddress& p_bda);
+static uint16_t sdp_parse_attr_lists(tCONN_CB* p_ccb);
 static uint8_t* add_attr(uint8_t* p, uint8_t* p_end, tSDP_DISCOVERY_DB* p_db,
                          tSDP_DISC_REC* p_rec, uint16_t attr_id,
                          tSDP_DISC_ATTR* p_parent_attr, uint8_t nest_level);
@@ -62,6 +65,22 @@ static uint8_t* add_attr(uint8_t* p, uint8_t* p_end, tSDP_DISCOVERY_DB* p_db,
 /* Safety check in case we go crazy */
 #define MAX_NEST_LEVELS 5
 
+/* A service search attribute result of a remote device, kept as a flat
+ * database. Its attribute lists can be parsed again into any discovery
+ * database, and profiles can look records up in it directly. */
+typedef struct {
+  RawAddress bd_addr;
+  uint16_t num_uuid_filters;
+  Uuid uuid_filters[SDP_MAX_UUID_FILTERS];
+  uint16_t num_attr_filters;
+  uint16_t attr_filters[SDP_MAX_ATTR_FILTERS];
+  tSDP_FLAT_DB* p_flat_db; /* NULL if the entry is unused */
+  uint64_t expiry_ms;
+} tSDP_REMOTE_CACHE_ENTRY;
+
+static tSDP_REMOTE_CACHE_ENTRY sdp_remote_cache[SDP_REMOTE_CACHE_SIZE];
+static uint8_t sdp_remote_cache_next;
+
 /*******************************************************************************
  *
  * Function         sdpu_build_uuid_seq
@@ -212,6 +231,232 @@ static void sdp_snd_service_search_req(tCONN_CB* p_ccb, uint8_t cont_len,
                      sdp_conn_timer_timeout, p_ccb);
 }
 
+/*******************************************************************************
+ *
+ * Function         sdp_remote_cache_matches
+ *
+ * Description      This function checks if a cache entry holds the result of
+ *                  a search with the peer and filters of the discovery db.
+ *
+ * Returns          true if it does
+ *
+ ******************************************************************************/
+static bool sdp_remote_cache_matches(tSDP_REMOTE_CACHE_ENTRY* p_entry,
+                                     const RawAddress& bd_addr,
+                                     tSDP_DISCOVERY_DB* p_db) {
+  uint16_t xx;
+
+  if (p_entry->bd_addr != bd_addr ||
+      p_entry->num_uuid_filters != p_db->num_uuid_filters ||
+      p_entry->num_attr_filters != p_db->num_attr_filters)
+    return false;
+
+  for (xx = 0; xx < p_db->num_uuid_filters; xx++) {
+    if (p_entry->uuid_filters[xx] != p_db->uuid_filters[xx]) return false;
+  }
+  for (xx = 0; xx < p_db->num_attr_filters; xx++) {
+    if (p_entry->attr_filters[xx] != p_db->attr_filters[xx]) return false;
+  }
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_remote_cache_find
+ *
+ * Description      This function looks up a result for the peer and filters
+ *                  of the discovery db. Expired entries are dropped on the way.
+ *
+ * Returns          Pointer to the entry, or NULL if none
+ *
+ ******************************************************************************/
+static tSDP_REMOTE_CACHE_ENTRY* sdp_remote_cache_find(const RawAddress& bd_addr,
+                                                      tSDP_DISCOVERY_DB* p_db) {
+#if (SDP_BROWSE_PLUS == TRUE)
+  /* Browsing queries one UUID filter at a time, results do not match dbs */
+  return NULL;
+#else
+  uint64_t now_ms = time_get_os_boottime_ms();
+
+  if (p_db == NULL) return NULL;
+
+  for (int i = 0; i < SDP_REMOTE_CACHE_SIZE; i++) {
+    tSDP_REMOTE_CACHE_ENTRY* p_entry = &sdp_remote_cache[i];
+    if (p_entry->p_flat_db == NULL) continue;
+    if (now_ms >= p_entry->expiry_ms) {
+      osi_free_and_reset((void**)&p_entry->p_flat_db);
+      continue;
+    }
+    if (sdp_remote_cache_matches(p_entry, bd_addr, p_db)) return p_entry;
+  }
+  return NULL;
+#endif
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_remote_cache_store
+ *
+ * Description      This function keeps the attribute lists received on the CCB
+ *                  for reuse as a flat database, replacing an older result for
+ *                  the same search or else the oldest entry.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void sdp_remote_cache_store(tCONN_CB* p_ccb) {
+#if (SDP_BROWSE_PLUS != TRUE)
+  tSDP_DISCOVERY_DB* p_db = p_ccb->p_db;
+  tSDP_REMOTE_CACHE_ENTRY* p_entry =
+      sdp_remote_cache_find(p_ccb->device_address, p_db);
+  tSDP_FLAT_DB* p_flat_db = SDP_FlatDbBuild(p_ccb->rsp_list, p_ccb->list_len);
+  uint16_t xx;
+
+  if (p_flat_db == NULL) {
+    SDP_TRACE_WARNING("%s: attribute lists not cached", __func__);
+    if (p_entry != NULL) osi_free_and_reset((void**)&p_entry->p_flat_db);
+    return;
+  }
+
+  if (p_entry == NULL) {
+    p_entry = &sdp_remote_cache[sdp_remote_cache_next];
+    sdp_remote_cache_next = (sdp_remote_cache_next + 1) % SDP_REMOTE_CACHE_SIZE;
+  }
+
+  osi_free(p_entry->p_flat_db);
+  p_entry->bd_addr = p_ccb->device_address;
+  p_entry->num_uuid_filters = p_db->num_uuid_filters;
+  for (xx = 0; xx < p_db->num_uuid_filters; xx++)
+    p_entry->uuid_filters[xx] = p_db->uuid_filters[xx];
+  p_entry->num_attr_filters = p_db->num_attr_filters;
+  for (xx = 0; xx < p_db->num_attr_filters; xx++)
+    p_entry->attr_filters[xx] = p_db->attr_filters[xx];
+  p_entry->p_flat_db = p_flat_db;
+  p_entry->expiry_ms = time_get_os_boottime_ms() + SDP_REMOTE_CACHE_TTL_MS;
+#endif
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_remote_cache_load
+ *
+ * Description      This function copies a cached result for the CCB's peer and
+ *                  discovery db into the CCB response buffer.
+ *
+ * Returns          true if a result was found
+ *
+ ******************************************************************************/
+static bool sdp_remote_cache_load(tCONN_CB* p_ccb) {
+  tSDP_REMOTE_CACHE_ENTRY* p_entry =
+      sdp_remote_cache_find(p_ccb->device_address, p_ccb->p_db);
+
+  if (p_entry == NULL) return false;
+
+  if (p_ccb->rsp_list == NULL)
+    p_ccb->rsp_list = (uint8_t*)osi_malloc(SDP_MAX_LIST_BYTE_COUNT);
+  p_ccb->list_len = SDP_FlatDbWriteLists(p_entry->p_flat_db, p_ccb->rsp_list,
+                                         SDP_MAX_LIST_BYTE_COUNT);
+
+  SDP_TRACE_EVENT("%s: reusing %d bytes of attributes from %s", __func__,
+                  p_ccb->list_len, p_ccb->device_address.ToString().c_str());
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         SDP_FlushRemoteCache
+ *
+ * Description      This function drops the cached service search attribute
+ *                  results of a remote device, e.g. when its bond is removed.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void SDP_FlushRemoteCache(const RawAddress& bd_addr) {
+  for (int i = 0; i < SDP_REMOTE_CACHE_SIZE; i++) {
+    if (sdp_remote_cache[i].bd_addr == bd_addr)
+      osi_free_and_reset((void**)&sdp_remote_cache[i].p_flat_db);
+  }
+}
+
+/*******************************************************************************
+ *
+ * Function         SDP_GetRemoteFlatDb
+ *
+ * Description      This function returns the cached result of the search of
+ *                  the discovery db with a remote device as a flat database,
+ *                  e.g. to look its records up by service UUID once the
+ *                  discovery completed.
+ *
+ * Returns          The database, owned by SDP and valid until the next SDP
+ *                  call, or NULL if no result is cached
+ *
+ ******************************************************************************/
+const tSDP_FLAT_DB* SDP_GetRemoteFlatDb(const RawAddress& bd_addr,
+                                        tSDP_DISCOVERY_DB* p_db) {
+  tSDP_REMOTE_CACHE_ENTRY* p_entry = sdp_remote_cache_find(bd_addr, p_db);
+
+  return p_entry != NULL ? p_entry->p_flat_db : NULL;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_disc_cached_rsp_timeout
+ *
+ * Description      This function completes a discovery answered from the
+ *                  remote cache. It runs from the CCB timer so that the user
+ *                  callback comes after the request API has returned.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void sdp_disc_cached_rsp_timeout(void* data) {
+  tCONN_CB* p_ccb = (tCONN_CB*)data;
+  uint16_t result = sdp_parse_attr_lists(p_ccb);
+
+  SDP_TRACE_EVENT("SDP - cached discovery done, result: %d", result);
+
+  /* Tell the user if he has a callback */
+  if (p_ccb->p_cb)
+    (*p_ccb->p_cb)(result);
+  else if (p_ccb->p_cb2)
+    (*p_ccb->p_cb2)(result, p_ccb->user_data);
+
+  sdpu_release_ccb(p_ccb);
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_disc_originate_cached
+ *
+ * Description      This function starts a service search attribute discovery
+ *                  that is answered from the remote cache, without any L2CAP
+ *                  channel. The CCB stays in the setup state with no channel
+ *                  so that it can be cancelled like one still connecting.
+ *
+ * Returns          The CCB, or NULL if there is no cached result
+ *
+ ******************************************************************************/
+tCONN_CB* sdp_disc_originate_cached(const RawAddress& bd_addr,
+                                    tSDP_DISCOVERY_DB* p_db) {
+  tCONN_CB* p_ccb;
+
+  if (sdp_remote_cache_find(bd_addr, p_db) == NULL) return NULL;
+
+  p_ccb = sdpu_allocate_ccb();
+  if (p_ccb == NULL) return NULL;
+
+  p_ccb->con_flags |= SDP_FLAGS_IS_ORIG;
+  p_ccb->con_state = SDP_STATE_CONN_SETUP;
+  p_ccb->device_address = bd_addr;
+  p_ccb->p_db = p_db;
+  sdp_remote_cache_load(p_ccb);
+
+  alarm_set_on_mloop(p_ccb->sdp_conn_timer, 0, sdp_disc_cached_rsp_timeout,
+                     p_ccb);
+  return p_ccb;
+}
+
 /*******************************************************************************
  *
  * Function         sdp_disc_connected
@@ -226,6 +471,12 @@ void sdp_disc_connected(tCONN_CB* p_ccb) {
   if (p_ccb->is_attr_search) {
     p_ccb->disc_state = SDP_DISC_WAIT_SEARCH_ATTR;
 
+    /* A search queued behind an identical one is answered by its result */
+    if (sdp_remote_cache_load(p_ccb)) {
+      sdp_disconnect(p_ccb, sdp_parse_attr_lists(p_ccb));
+      return;
+    }
+
     process_service_search_attr_rsp(p_ccb, NULL, NULL);
   } else {
     /* First step is to get a list of the handles from the server. */
@@ -608,9 +859,7 @@ static void process_service_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
  ******************************************************************************/
 static void process_service_search_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
                                             uint8_t* p_reply_end) {
-  uint8_t *p, *p_start, *p_end, *p_param_len;
-  uint8_t type;
-  uint32_t seq_len;
+  uint8_t *p_start, *p_param_len;
   uint16_t param_len, lists_byte_count = 0;
   bool cont_request_needed = false;
 
@@ -763,12 +1012,34 @@ static void process_service_search_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
 /* We now have the full response, which is a sequence of sequences */
 /*******************************************************************/
 
+  uint16_t result = sdp_parse_attr_lists(p_ccb);
+  if (result == SDP_SUCCESS) sdp_remote_cache_store(p_ccb);
+
+  /* Since we got everything we need, disconnect the call */
+  sdp_disconnect(p_ccb, result);
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_parse_attr_lists
+ *
+ * Description      This function parses the complete attribute lists of a
+ *                  service search attribute response, held in the CCB response
+ *                  buffer, into the discovery db.
+ *
+ * Returns          SDP_SUCCESS, or the error to disconnect with
+ *
+ ******************************************************************************/
+static uint16_t sdp_parse_attr_lists(tCONN_CB* p_ccb) {
+  uint8_t *p, *p_end;
+  uint8_t type;
+  uint32_t seq_len;
+
 #if (SDP_RAW_DATA_INCLUDED == TRUE)
   SDP_TRACE_WARNING("process_service_search_attr_rsp");
   if (!sdp_copy_raw_data(p_ccb, true)) {
     SDP_TRACE_WARNING("SDP - invalid pdu, terminate sdp connection");
-    sdp_disconnect(p_ccb, SDP_INVALID_PDU);
-    return;
+    return SDP_INVALID_PDU;
   }
 #endif
 
@@ -779,32 +1050,23 @@ static void process_service_search_attr_rsp(tCONN_CB* p_ccb, uint8_t* p_reply,
 
   if ((type >> 3) != DATA_ELE_SEQ_DESC_TYPE) {
     SDP_TRACE_WARNING("SDP - Wrong type: 0x%02x in attr_rsp", type);
-    sdp_disconnect(p_ccb, SDP_INVALID_PDU);
-    return;
+    return SDP_INVALID_PDU;
   }
   p = sdpu_get_len_from_type(p, p + p_ccb->list_len, type, &seq_len);
   if (p == NULL || (p + seq_len) > (p + p_ccb->list_len)) {
     SDP_TRACE_WARNING("%s: bad length", __func__);
-    sdp_disconnect(p_ccb, SDP_INVALID_PDU);
-    return;
+    return SDP_INVALID_PDU;
   }
   p_end = &p_ccb->rsp_list[p_ccb->list_len];
 
-  if ((p + seq_len) != p_end) {
-    sdp_disconnect(p_ccb, SDP_INVALID_CONT_STATE);
-    return;
-  }
+  if ((p + seq_len) != p_end) return SDP_INVALID_CONT_STATE;
 
   while (p < p_end) {
     p = save_attr_seq(p_ccb, p, &p_ccb->rsp_list[p_ccb->list_len]);
-    if (!p) {
-      sdp_disconnect(p_ccb, SDP_DB_FULL);
-      return;
-    }
+    if (!p) return SDP_DB_FULL;
   }
 
-  /* Since we got everything we need, disconnect the call */
-  sdp_disconnect(p_ccb, SDP_SUCCESS);
+  return SDP_SUCCESS;
 }
 
 /*******************************************************************************
@@ -0,0 +1,330 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the flat SDP database built from service search
+ *  attribute responses.
+ *
+ ******************************************************************************/
+
+#include "sdp_flat_db.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "osi/include/allocator.h"
+#include "sdpdefs.h"
+
+using bluetooth::Uuid;
+
+namespace {
+
+/* A data element read from a buffer */
+struct DataElement {
+  uint8_t type;
+  const uint8_t* p_start; /* Header */
+  const uint8_t* p_data;
+  const uint8_t* p_end;
+};
+
+/* Reads the data element at |p|, which must end by |p_end| */
+bool read_element(const uint8_t* p, const uint8_t* p_end, DataElement* p_elem) {
+  if (p >= p_end) return false;
+
+  uint8_t type = *p;
+  const uint8_t* p_data = p + 1;
+  uint32_t len = 0;
+  size_t len_bytes = 0;
+
+  switch (type & 7) {
+    case SIZE_ONE_BYTE:
+      len = (type >> 3) == NULL_DESC_TYPE ? 0 : 1;
+      break;
+    case SIZE_TWO_BYTES:
+      len = 2;
+      break;
+    case SIZE_FOUR_BYTES:
+      len = 4;
+      break;
+    case SIZE_EIGHT_BYTES:
+      len = 8;
+      break;
+    case SIZE_SIXTEEN_BYTES:
+      len = 16;
+      break;
+    case SIZE_IN_NEXT_BYTE:
+      len_bytes = 1;
+      break;
+    case SIZE_IN_NEXT_WORD:
+      len_bytes = 2;
+      break;
+    case SIZE_IN_NEXT_LONG:
+      len_bytes = 4;
+      break;
+  }
+
+  if (len_bytes > (size_t)(p_end - p_data)) return false;
+  for (size_t i = 0; i < len_bytes; i++) len = (len << 8) | *p_data++;
+  if (len > (size_t)(p_end - p_data)) return false;
+
+  p_elem->type = type >> 3;
+  p_elem->p_start = p;
+  p_elem->p_data = p_data;
+  p_elem->p_end = p_data + len;
+  return true;
+}
+
+bool uuid_less(const tSDP_FLAT_UUID& a, const tSDP_FLAT_UUID& b) {
+  int diff = memcmp(a.uuid, b.uuid, sizeof(a.uuid));
+  return diff < 0 || (diff == 0 && a.rec < b.rec);
+}
+
+bool uuid_equal(const tSDP_FLAT_UUID& a, const tSDP_FLAT_UUID& b) {
+  return memcmp(a.uuid, b.uuid, sizeof(a.uuid)) == 0 && a.rec == b.rec;
+}
+
+bool attr_less(const tSDP_FLAT_ATTR& a, const tSDP_FLAT_ATTR& b) {
+  return a.attr_id < b.attr_id;
+}
+
+/* Adds the UUIDs of the service class ID list |list| of record |rec|. Like
+ * SDP_FindServiceInDb, UUIDs nested in one more sequence count too, as some
+ * car kits send them that way. */
+void add_service_uuids(const DataElement& list, uint16_t rec, bool nested,
+                       std::vector<tSDP_FLAT_UUID>* p_uuids) {
+  DataElement elem;
+
+  for (const uint8_t* p = list.p_data;
+       p < list.p_end && read_element(p, list.p_end, &elem); p = elem.p_end) {
+    if (elem.type == DATA_ELE_SEQ_DESC_TYPE && !nested) {
+      add_service_uuids(elem, rec, true, p_uuids);
+      continue;
+    }
+    if (elem.type != UUID_DESC_TYPE) continue;
+
+    const uint8_t* v = elem.p_data;
+    Uuid uuid;
+    switch (elem.p_end - elem.p_data) {
+      case Uuid::kNumBytes16:
+        uuid = Uuid::From16Bit((v[0] << 8) | v[1]);
+        break;
+      case Uuid::kNumBytes32:
+        uuid = Uuid::From32Bit(((uint32_t)v[0] << 24) | (v[1] << 16) |
+                               (v[2] << 8) | v[3]);
+        break;
+      case Uuid::kNumBytes128:
+        uuid = Uuid::From128BitBE(v);
+        break;
+      default:
+        continue;
+    }
+
+    tSDP_FLAT_UUID entry;
+    memcpy(entry.uuid, uuid.To128BitBE().data(), sizeof(entry.uuid));
+    entry.rec = rec;
+    p_uuids->push_back(entry);
+  }
+}
+
+const tSDP_FLAT_REC* flat_recs(const tSDP_FLAT_DB* p_db) {
+  return (const tSDP_FLAT_REC*)(p_db + 1);
+}
+
+const tSDP_FLAT_ATTR* flat_attrs(const tSDP_FLAT_DB* p_db) {
+  return (const tSDP_FLAT_ATTR*)(flat_recs(p_db) + p_db->num_recs);
+}
+
+const tSDP_FLAT_UUID* flat_uuids(const tSDP_FLAT_DB* p_db) {
+  return (const tSDP_FLAT_UUID*)(flat_attrs(p_db) + p_db->num_attrs);
+}
+
+const uint8_t* flat_data(const tSDP_FLAT_DB* p_db) {
+  return (const uint8_t*)(flat_uuids(p_db) + p_db->num_uuids);
+}
+
+}  // namespace
+
+tSDP_FLAT_DB* SDP_FlatDbBuild(const uint8_t* p_lists, uint16_t len) {
+  DataElement lists;
+
+  if (!read_element(p_lists, p_lists + len, &lists) ||
+      lists.type != DATA_ELE_SEQ_DESC_TYPE || lists.p_end != p_lists + len)
+    return NULL;
+
+  std::vector<tSDP_FLAT_REC> recs;
+  std::vector<tSDP_FLAT_ATTR> attrs;
+  std::vector<tSDP_FLAT_UUID> uuids;
+
+  /* The data area is the attribute lists, without the outer sequence */
+  const uint8_t* p_data = lists.p_data;
+  DataElement rec_elem;
+  for (const uint8_t* p = lists.p_data; p < lists.p_end; p = rec_elem.p_end) {
+    if (!read_element(p, lists.p_end, &rec_elem) ||
+        rec_elem.type != DATA_ELE_SEQ_DESC_TYPE)
+      return NULL;
+
+    tSDP_FLAT_REC rec;
+    rec.offset = rec_elem.p_start - p_data;
+    rec.len = rec_elem.p_end - rec_elem.p_start;
+    rec.first_attr = attrs.size();
+
+    DataElement id, value;
+    for (const uint8_t* p_attr = rec_elem.p_data; p_attr < rec_elem.p_end;
+         p_attr = value.p_end) {
+      if (!read_element(p_attr, rec_elem.p_end, &id) ||
+          id.type != UINT_DESC_TYPE || id.p_end - id.p_data != 2 ||
+          !read_element(id.p_end, rec_elem.p_end, &value))
+        return NULL;
+
+      tSDP_FLAT_ATTR attr;
+      attr.attr_id = (id.p_data[0] << 8) | id.p_data[1];
+      attr.offset = value.p_start - p_data;
+      attr.len = value.p_end - value.p_start;
+      attrs.push_back(attr);
+
+      if (attr.attr_id == ATTR_ID_SERVICE_CLASS_ID_LIST &&
+          value.type == DATA_ELE_SEQ_DESC_TYPE)
+        add_service_uuids(value, recs.size(), false, &uuids);
+    }
+
+    /* Servers send attributes in ascending order, but do not rely on it */
+    rec.num_attrs = attrs.size() - rec.first_attr;
+    std::stable_sort(attrs.begin() + rec.first_attr, attrs.end(), attr_less);
+    recs.push_back(rec);
+  }
+
+  std::sort(uuids.begin(), uuids.end(), uuid_less);
+  uuids.erase(std::unique(uuids.begin(), uuids.end(), uuid_equal),
+              uuids.end());
+
+  /* Every count and offset fits in 16 bits as the lists do */
+  tSDP_FLAT_DB hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.magic = SDP_FLAT_DB_MAGIC;
+  hdr.version = SDP_FLAT_DB_VERSION;
+  hdr.num_recs = recs.size();
+  hdr.num_attrs = attrs.size();
+  hdr.num_uuids = uuids.size();
+  hdr.data_len = lists.p_end - lists.p_data;
+
+  tSDP_FLAT_DB* p_db = (tSDP_FLAT_DB*)osi_malloc(SDP_FlatDbSize(&hdr));
+  *p_db = hdr;
+  memcpy((void*)flat_recs(p_db), recs.data(),
+         recs.size() * sizeof(tSDP_FLAT_REC));
+  memcpy((void*)flat_attrs(p_db), attrs.data(),
+         attrs.size() * sizeof(tSDP_FLAT_ATTR));
+  memcpy((void*)flat_uuids(p_db), uuids.data(),
+         uuids.size() * sizeof(tSDP_FLAT_UUID));
+  memcpy((void*)flat_data(p_db), lists.p_data, hdr.data_len);
+  return p_db;
+}
+
+bool SDP_FlatDbIsValid(const uint8_t* p, uint32_t len) {
+  const tSDP_FLAT_DB* p_db = (const tSDP_FLAT_DB*)p;
+
+  if (len < sizeof(tSDP_FLAT_DB) || p_db->magic != SDP_FLAT_DB_MAGIC ||
+      p_db->version != SDP_FLAT_DB_VERSION || SDP_FlatDbSize(p_db) != len)
+    return false;
+
+  const tSDP_FLAT_REC* p_recs = flat_recs(p_db);
+  const tSDP_FLAT_ATTR* p_attrs = flat_attrs(p_db);
+  const tSDP_FLAT_UUID* p_uuids = flat_uuids(p_db);
+
+  for (uint16_t i = 0; i < p_db->num_recs; i++) {
+    const tSDP_FLAT_REC& rec = p_recs[i];
+    if ((uint32_t)rec.offset + rec.len > p_db->data_len ||
+        (uint32_t)rec.first_attr + rec.num_attrs > p_db->num_attrs ||
+        !std::is_sorted(p_attrs + rec.first_attr,
+                        p_attrs + rec.first_attr + rec.num_attrs, attr_less))
+      return false;
+  }
+  for (uint16_t i = 0; i < p_db->num_attrs; i++) {
+    if ((uint32_t)p_attrs[i].offset + p_attrs[i].len > p_db->data_len)
+      return false;
+  }
+  for (uint16_t i = 0; i < p_db->num_uuids; i++) {
+    if (p_uuids[i].rec >= p_db->num_recs) return false;
+  }
+  return std::is_sorted(p_uuids, p_uuids + p_db->num_uuids, uuid_less);
+}
+
+uint32_t SDP_FlatDbSize(const tSDP_FLAT_DB* p_db) {
+  return sizeof(tSDP_FLAT_DB) + p_db->num_recs * sizeof(tSDP_FLAT_REC) +
+         p_db->num_attrs * sizeof(tSDP_FLAT_ATTR) +
+         p_db->num_uuids * sizeof(tSDP_FLAT_UUID) + p_db->data_len;
+}
+
+int SDP_FlatDbFindService(const tSDP_FLAT_DB* p_db, const Uuid& uuid,
+                          int start_rec) {
+  if (start_rec < -1) start_rec = -1;
+  if (start_rec + 1 >= p_db->num_recs) return -1;
+
+  tSDP_FLAT_UUID key;
+  memcpy(key.uuid, uuid.To128BitBE().data(), sizeof(key.uuid));
+  key.rec = start_rec + 1;
+
+  const tSDP_FLAT_UUID* p_begin = flat_uuids(p_db);
+  const tSDP_FLAT_UUID* p_end = p_begin + p_db->num_uuids;
+  const tSDP_FLAT_UUID* p_found =
+      std::lower_bound(p_begin, p_end, key, uuid_less);
+  if (p_found == p_end ||
+      memcmp(p_found->uuid, key.uuid, sizeof(key.uuid)) != 0)
+    return -1;
+  return p_found->rec;
+}
+
+bool SDP_FlatDbFindAttribute(const tSDP_FLAT_DB* p_db, uint16_t rec,
+                             uint16_t attr_id, const uint8_t** pp_value,
+                             uint16_t* p_len) {
+  if (rec >= p_db->num_recs) return false;
+
+  const tSDP_FLAT_REC& flat_rec = flat_recs(p_db)[rec];
+  const tSDP_FLAT_ATTR* p_begin = flat_attrs(p_db) + flat_rec.first_attr;
+  const tSDP_FLAT_ATTR* p_end = p_begin + flat_rec.num_attrs;
+  tSDP_FLAT_ATTR key;
+  key.attr_id = attr_id;
+
+  const tSDP_FLAT_ATTR* p_found =
+      std::lower_bound(p_begin, p_end, key, attr_less);
+  if (p_found == p_end || p_found->attr_id != attr_id) return false;
+
+  *pp_value = flat_data(p_db) + p_found->offset;
+  *p_len = p_found->len;
+  return true;
+}
+
+uint16_t SDP_FlatDbWriteLists(const tSDP_FLAT_DB* p_db, uint8_t* p_out,
+                              uint16_t max_len) {
+  uint16_t data_len = p_db->data_len;
+  uint16_t hdr_len = data_len <= UINT8_MAX ? 2 : 3;
+
+  if ((uint32_t)hdr_len + data_len > max_len) return 0;
+
+  if (hdr_len == 2) {
+    *p_out++ = (DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_BYTE;
+  } else {
+    *p_out++ = (DATA_ELE_SEQ_DESC_TYPE << 3) | SIZE_IN_NEXT_WORD;
+    *p_out++ = data_len >> 8;
+  }
+  *p_out++ = data_len & 0xff;
+  memcpy(p_out, flat_data(p_db), data_len);
+  return hdr_len + data_len;
+}
@@ -37,6 +37,7 @@
 #include "osi/include/osi.h"
 
 #include "btm_api.h"
+#include "btm_conn_trace.h"
 #include "btu.h"
 
 #include "sdp_api.h"
@@ -539,6 +540,8 @@ tCONN_CB* sdp_conn_originate(const RawAddress& p_bd_addr) {
 
   /* Save the BD Address and Channel ID. */
   p_ccb->device_address = p_bd_addr;
+  btm_conn_trace_mark(p_bd_addr, BT_TRANSPORT_BR_EDR,
+                      BTM_CONN_TRACE_SDP_STARTED);
 
   /* Transition to the next appropriate state, waiting for connection confirm.
    */
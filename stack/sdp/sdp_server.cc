@@ -106,6 +106,24 @@ static tSDP_RECORD *sdp_upgrade_mse_record(tSDP_RECORD *p_rec,
 
 static bool check_remote_map_version_104(RawAddress remote_addr);
 
+/* A serialized service search attribute response, replayed to a peer that
+ * repeats the same request pattern. The key is the raw UUID and attribute
+ * sequences of the request; the maximum byte count is left out since the
+ * fragments are served by offset from the whole response. */
+typedef struct {
+  RawAddress bd_addr;
+  uint8_t key[SDP_RSP_CACHE_MAX_KEY_LEN];
+  uint8_t key_len;
+  uint8_t* p_rsp; /* attribute lists, NULL if the entry is unused */
+  uint16_t rsp_len;
+  uint32_t stamp; /* unique per stored response, 0 if unused */
+} tSDP_RSP_CACHE_ENTRY;
+
+static tSDP_RSP_CACHE_ENTRY sdp_rsp_cache[SDP_RSP_CACHE_SIZE];
+static uint8_t sdp_rsp_cache_next;
+static uint32_t sdp_rsp_cache_last_stamp;
+static uint32_t sdp_rsp_cache_db_gen;
+
 /******************************************************************************/
 /*                E R R O R   T E X T   S T R I N G S                         */
 /*                                                                            */
@@ -166,6 +184,22 @@ static bool check_remote_map_version_104(RawAddress remote_addr);
 
 #define MAP_1_4 0x0104
 
+/* Properties read while building responses, see osi_cached_property_get */
+static osi_cached_property_t sdp_pts_pbap_prop =
+    OSI_CACHED_PROPERTY(SDP_ENABLE_PTS_PBAP);
+static osi_cached_property_t sdp_pts_map_prop =
+    OSI_CACHED_PROPERTY(SDP_ENABLE_PTS_MAP);
+static osi_cached_property_t sdp_pts_avrcp_prop =
+    OSI_CACHED_PROPERTY(SDP_ENABLE_PTS_AVRCP);
+static osi_cached_property_t sdp_pts_cert_prop =
+    OSI_CACHED_PROPERTY("vendor.bt.pts.certification");
+static osi_cached_property_t sdp_a2dp_sink_prop =
+    OSI_CACHED_PROPERTY("persist.vendor.service.bt.a2dp.sink");
+#if (OFF_TARGET_TEST_ENABLED == FALSE)
+static osi_cached_property_t sdp_avrcp_version_prop =
+    OSI_CACHED_PROPERTY(AVRCP_VERSION_PROPERTY);
+#endif
+
 struct blacklist_entry
 {
     int ver;
@@ -184,8 +218,8 @@ uint16_t get_dut_avrcp_version() {
     uint16_t profile_version = AVRC_REV_1_0;
     char avrcp_version[PROPERTY_VALUE_MAX] = {0};
 #if (OFF_TARGET_TEST_ENABLED == FALSE)
-    property_get(AVRCP_VERSION_PROPERTY, avrcp_version,
-                     AVRCP_1_6_STRING);
+    osi_cached_property_get(&sdp_avrcp_version_prop, avrcp_version,
+                            AVRCP_1_6_STRING);
 #else
     strlcpy(avrcp_version, AVRCP_1_6_STRING, sizeof(AVRCP_1_6_STRING));
 #endif
@@ -225,7 +259,7 @@ int sdp_get_stored_avrc_tg_version(RawAddress addr)
              __func__, addr.ToString().c_str());
     char pts_property[PROPERTY_VALUE_MAX] = {0};
     int pts_avrcp_version;
-    osi_property_get(SDP_ENABLE_PTS_AVRCP, pts_property, "false");
+    osi_cached_property_get(&sdp_pts_avrcp_prop, pts_property, "false");
     if (!strncmp("true", pts_property, 4)) {
       SDP_TRACE_DEBUG("%s pts running= %s, return AVRCP1.6", __func__, pts_property);
       pts_avrcp_version = AVRC_REV_1_6;
@@ -445,7 +479,7 @@ bool sdp_change_hfp_version (tSDP_ATTRIBUTE *p_attr, RawAddress remote_address)
                                                            &remote_address);
             /* For PTS we should update AG's HFP version as 1.8 */
             if (is_blacklisted_1_8 ||
-                (property_get("vendor.bt.pts.certification", value, "false") &&
+                (osi_cached_property_get(&sdp_pts_cert_prop, value, "false") &&
                 strcmp(value, "true") == 0))
             {
                 SDP_TRACE_DEBUG("%s: HF version is 1.8 for BD addr: %s",\
@@ -840,7 +874,7 @@ static void process_service_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
              (p_attr->len >= SDP_PROFILE_DESC_LENGTH)) {
         if (((p_attr->value_ptr[3] << 8) | (p_attr->value_ptr[4])) ==
                 UUID_SERVCLASS_AV_REMOTE_CONTROL) {
-          property_get("persist.vendor.service.bt.a2dp.sink", a2dp_role, "false");
+          osi_cached_property_get(&sdp_a2dp_sink_prop, a2dp_role, "false");
           if (!strncmp("false", a2dp_role, 5)) {
             profile_version = sdp_get_stored_avrc_tg_version(p_ccb->device_address);
             uint16_t ver = (AVRCP_VERSION_BIT_MASK & profile_version);
@@ -999,6 +1033,144 @@ static void process_service_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
   L2CA_DataWrite(p_ccb->connection_id, p_buf);
 }
 
+/*******************************************************************************
+ *
+ * Function         sdp_rsp_cache_invalidate
+ *
+ * Description      This function drops all cached service search attribute
+ *                  responses. It is called whenever the server database
+ *                  changes. Pending replays fail their next continuation and
+ *                  pending captures are not stored.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void sdp_rsp_cache_invalidate(void) {
+  for (int i = 0; i < SDP_RSP_CACHE_SIZE; i++) {
+    osi_free_and_reset((void**)&sdp_rsp_cache[i].p_rsp);
+    sdp_rsp_cache[i].rsp_len = 0;
+    sdp_rsp_cache[i].stamp = 0;
+  }
+  sdp_rsp_cache_db_gen++;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_rsp_cache_find
+ *
+ * Description      This function finds the cached response stored for the
+ *                  given peer and request pattern.
+ *
+ * Returns          Pointer to the entry, or NULL if none
+ *
+ ******************************************************************************/
+static tSDP_RSP_CACHE_ENTRY* sdp_rsp_cache_find(const RawAddress& bd_addr,
+                                                const uint8_t* p_key,
+                                                uint8_t key_len) {
+  for (int i = 0; i < SDP_RSP_CACHE_SIZE; i++) {
+    tSDP_RSP_CACHE_ENTRY* p_entry = &sdp_rsp_cache[i];
+    if (p_entry->p_rsp != NULL && p_entry->bd_addr == bd_addr &&
+        p_entry->key_len == key_len && !memcmp(p_entry->key, p_key, key_len))
+      return p_entry;
+  }
+  return NULL;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_rsp_cache_find_stamp
+ *
+ * Description      This function finds the cached response a replay started
+ *                  from.
+ *
+ * Returns          Pointer to the entry, or NULL if it has been dropped
+ *
+ ******************************************************************************/
+static tSDP_RSP_CACHE_ENTRY* sdp_rsp_cache_find_stamp(uint32_t stamp) {
+  for (int i = 0; i < SDP_RSP_CACHE_SIZE; i++) {
+    if (sdp_rsp_cache[i].p_rsp != NULL && sdp_rsp_cache[i].stamp == stamp)
+      return &sdp_rsp_cache[i];
+  }
+  return NULL;
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_rsp_cache_store
+ *
+ * Description      This function stores the response captured on the CCB,
+ *                  replacing the oldest entry. The cache takes ownership of
+ *                  the capture buffer.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void sdp_rsp_cache_store(tCONN_CB* p_ccb, uint16_t rsp_len) {
+  tSDP_RSP_CACHE_ENTRY* p_entry = &sdp_rsp_cache[sdp_rsp_cache_next];
+  sdp_rsp_cache_next = (sdp_rsp_cache_next + 1) % SDP_RSP_CACHE_SIZE;
+
+  osi_free(p_entry->p_rsp);
+  p_entry->bd_addr = p_ccb->device_address;
+  memcpy(p_entry->key, p_ccb->rsp_key, p_ccb->rsp_key_len);
+  p_entry->key_len = p_ccb->rsp_key_len;
+  p_entry->p_rsp = p_ccb->p_rsp_capture;
+  p_entry->rsp_len = rsp_len;
+  if (++sdp_rsp_cache_last_stamp == 0) sdp_rsp_cache_last_stamp = 1;
+  p_entry->stamp = sdp_rsp_cache_last_stamp;
+  p_ccb->p_rsp_capture = NULL;
+
+  SDP_TRACE_DEBUG("%s: cached %d bytes for %s", __func__, rsp_len,
+                  p_ccb->device_address.ToString().c_str());
+}
+
+/*******************************************************************************
+ *
+ * Function         sdp_send_cached_rsp
+ *
+ * Description      This function sends the next fragment of a cached service
+ *                  search attribute response, starting at the continuation
+ *                  offset of the CCB.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void sdp_send_cached_rsp(tCONN_CB* p_ccb, uint16_t trans_num,
+                                uint16_t max_list_len,
+                                tSDP_RSP_CACHE_ENTRY* p_entry) {
+  uint16_t len_to_send = p_entry->rsp_len - p_ccb->cont_offset;
+  uint8_t *p_rsp, *p_rsp_start, *p_rsp_param_len;
+
+  if (len_to_send > max_list_len) len_to_send = max_list_len;
+
+  BT_HDR* p_buf = (BT_HDR*)osi_malloc(SDP_DATA_BUF_SIZE);
+  p_buf->offset = L2CAP_MIN_OFFSET;
+  p_rsp = p_rsp_start = (uint8_t*)(p_buf + 1) + L2CAP_MIN_OFFSET;
+
+  UINT8_TO_BE_STREAM(p_rsp, SDP_PDU_SERVICE_SEARCH_ATTR_RSP);
+  UINT16_TO_BE_STREAM(p_rsp, trans_num);
+  p_rsp_param_len = p_rsp;
+  p_rsp += 2;
+
+  UINT16_TO_BE_STREAM(p_rsp, len_to_send);
+  memcpy(p_rsp, p_entry->p_rsp + p_ccb->cont_offset, len_to_send);
+  p_rsp += len_to_send;
+
+  p_ccb->cont_offset += len_to_send;
+
+  if (p_ccb->cont_offset < p_entry->rsp_len) {
+    UINT8_TO_BE_STREAM(p_rsp, SDP_CONTINUATION_LEN);
+    UINT16_TO_BE_STREAM(p_rsp, p_ccb->cont_offset);
+  } else {
+    UINT8_TO_BE_STREAM(p_rsp, 0);
+    p_ccb->rsp_cache_stamp = 0;
+  }
+
+  UINT16_TO_BE_STREAM(p_rsp_param_len, p_rsp - p_rsp_param_len - 2);
+  p_buf->len = p_rsp - p_rsp_start;
+
+  L2CA_DataWrite(p_ccb->connection_id, p_buf);
+}
+
 /*******************************************************************************
  *
  * Function         process_service_search_attr_req
@@ -1032,6 +1204,12 @@ static void process_service_search_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
   uint16_t profile_version;
   bool is_avrcp_browse_bit_set = FALSE;
   bool is_avrcp_cover_bit_set = FALSE;
+  uint8_t* p_key_uuid = p_req;
+  uint8_t* p_key_attr;
+  uint16_t uuid_key_len, key_len;
+  uint8_t key[SDP_RSP_CACHE_MAX_KEY_LEN];
+  bool key_ok;
+  tSDP_RSP_CACHE_ENTRY* p_entry;
   /* Extract the UUID sequence to search for */
   p_req = sdpu_extract_uid_seq(p_req, param_len, &uid_seq);
 
@@ -1056,6 +1234,7 @@ static void process_service_search_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
         max_list_len = p_ccb->rem_mtu_size - SDP_MAX_SERVATTR_RSPHDR_LEN;
 
   param_len = static_cast<uint16_t>(p_req_end - p_req);
+  p_key_attr = p_req;
   p_req = sdpu_extract_attr_seq(p_req, param_len, &attr_seq);
 
   if ((!p_req) || (!attr_seq.num_attr)) {
@@ -1066,6 +1245,15 @@ static void process_service_search_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
 
   memcpy(&attr_seq_sav, &attr_seq, sizeof(tSDP_ATTR_SEQ));
 
+  /* The raw UUID and attribute sequences key the response cache */
+  uuid_key_len = static_cast<uint16_t>(p_key_attr - sizeof(uint16_t) - p_key_uuid);
+  key_len = uuid_key_len + static_cast<uint16_t>(p_req - p_key_attr);
+  key_ok = (key_len <= SDP_RSP_CACHE_MAX_KEY_LEN);
+  if (key_ok) {
+    memcpy(key, p_key_uuid, uuid_key_len);
+    memcpy(key + uuid_key_len, p_key_attr, key_len - uuid_key_len);
+  }
+
   /* Free and reallocate buffer */
   osi_free(p_ccb->rsp_list);
   p_ccb->rsp_list = (uint8_t*)osi_malloc(max_list_len);
@@ -1096,6 +1284,23 @@ static void process_service_search_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
     }
     is_cont = true;
 
+    bool same_key = key_ok && key_len == p_ccb->rsp_key_len &&
+                    !memcmp(key, p_ccb->rsp_key, key_len);
+
+    /* Continue a replay from the response cache */
+    if (p_ccb->rsp_cache_stamp) {
+      p_entry = sdp_rsp_cache_find_stamp(p_ccb->rsp_cache_stamp);
+      if (p_entry == NULL || !same_key) {
+        p_ccb->rsp_cache_stamp = 0;
+        sdpu_build_n_send_error(p_ccb, trans_num, SDP_INVALID_CONT_STATE,
+                                SDP_TEXT_BAD_CONT_INX);
+        return;
+      }
+      sdp_send_cached_rsp(p_ccb, trans_num, max_list_len, p_entry);
+      return;
+    }
+    if (!same_key) osi_free_and_reset((void**)&p_ccb->p_rsp_capture);
+
     /* Initialise for continuation response */
     p_rsp = &p_ccb->rsp_list[0];
     attr_seq.attr_entry[p_ccb->cont_info.next_attr_index].start =
@@ -1114,6 +1319,22 @@ static void process_service_search_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
     p_ccb->cont_info.next_attr_index = 0;
     p_ccb->cont_info.last_attr_seq_desc_sent = false;
     p_ccb->cont_info.attr_offset = 0;
+
+    /* Serve the response from the cache if this peer asked before */
+    p_ccb->rsp_cache_stamp = 0;
+    osi_free_and_reset((void**)&p_ccb->p_rsp_capture);
+    p_ccb->rsp_cacheable = key_ok;
+    if (key_ok) {
+      memcpy(p_ccb->rsp_key, key, key_len);
+      p_ccb->rsp_key_len = (uint8_t)key_len;
+      p_entry = sdp_rsp_cache_find(p_ccb->device_address, key, key_len);
+      if (p_entry != NULL) {
+        p_ccb->rsp_cache_stamp = p_entry->stamp;
+        sdp_send_cached_rsp(p_ccb, trans_num, max_list_len, p_entry);
+        return;
+      }
+      p_ccb->rsp_capture_gen = sdp_rsp_cache_db_gen;
+    }
   }
   bool is_mse_v14_enabled = sdpu_is_map_0104_enabled();
   bool is_pse_v12_enabled = sdpu_is_pbap_0102_enabled();
@@ -1129,6 +1350,8 @@ static void process_service_search_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
     if (is_pse_v12_enabled) {
       p_rec = sdp_upgrade_pse_record(p_rec, p_ccb->device_address);
     }
+    /* Responses tailored to the peer are never cached */
+    if (p_rec != p_prev_rec) p_ccb->rsp_cacheable = false;
     /* Allow space for attribute sequence type and length */
     p_seq_start = p_rsp;
     if (p_ccb->cont_info.last_attr_seq_desc_sent == false) {
@@ -1158,16 +1381,21 @@ static void process_service_search_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
           *  even if remote misbhevaes. If we DUT is not 1.6 then there would be no ca bit
           */
 
-        if (sdp_reset_avrcp_browsing_bit(p_rec->attribute[1], p_attr, p_ccb->device_address))
+        if (sdp_reset_avrcp_browsing_bit(p_rec->attribute[1], p_attr, p_ccb->device_address)) {
           is_avrcp_browse_bit_set = FALSE;
-        if (sdp_reset_avrcp_cover_art_bit(p_rec->attribute[1], p_attr, p_ccb->device_address))
+          p_ccb->rsp_cacheable = false;
+        }
+        if (sdp_reset_avrcp_cover_art_bit(p_rec->attribute[1], p_attr, p_ccb->device_address)) {
           is_avrcp_cover_bit_set = FALSE;
+          p_ccb->rsp_cacheable = false;
+        }
         if ((p_attr->id == ATTR_ID_BT_PROFILE_DESC_LIST) &&
                (p_attr->len >= SDP_PROFILE_DESC_LENGTH)) {
           if (((p_attr->value_ptr[3] << 8) | (p_attr->value_ptr[4])) ==
                   UUID_SERVCLASS_AV_REMOTE_CONTROL) {
-            property_get("persist.vendor.service.bt.a2dp.sink", a2dp_role, "false");
+            osi_cached_property_get(&sdp_a2dp_sink_prop, a2dp_role, "false");
             if (!strncmp("false", a2dp_role, 5)) {
+              p_ccb->rsp_cacheable = false;
               profile_version = sdp_get_stored_avrc_tg_version(p_ccb->device_address);
               uint16_t ver = (AVRCP_VERSION_BIT_MASK & profile_version);
               if (ver >= AVRC_REV_1_4) {
@@ -1188,6 +1416,7 @@ static void process_service_search_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
           }
         }
         is_hfp_fallback = sdp_change_hfp_version (p_attr, p_ccb->device_address);
+        if (is_hfp_fallback) p_ccb->rsp_cacheable = false;
         /* Check if attribute fits. Assume 3-byte value type/length */
         rem_len = max_list_len - (int16_t)(p_rsp - &p_ccb->rsp_list[0]);
 
@@ -1331,6 +1560,7 @@ static void process_service_search_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
         sdp_update_pbap_blacklist_len(p_ccb, &attr_seq_sav, &uid_seq) : 0 ;
     SDP_TRACE_DEBUG("%s p_ccb->list_len = %d bl_update_len = %d",__func__,
         p_ccb->list_len, p_ccb->bl_update_len);
+    if (p_ccb->bl_update_len) p_ccb->rsp_cacheable = false;
 
     /* Put in the sequence header (2 or 3 bytes) */
     if (p_ccb->list_len > 255) {
@@ -1348,6 +1578,10 @@ static void process_service_search_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
       p_ccb->list_len--;
       len_to_send--;
     }
+
+    /* Record the response as it is sent, for the response cache */
+    if (p_ccb->rsp_cacheable)
+      p_ccb->p_rsp_capture = (uint8_t*)osi_malloc(p_ccb->list_len);
   }
 
   /* Get a buffer to use to build the response */
@@ -1370,6 +1604,15 @@ static void process_service_search_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
   memcpy(p_rsp, &p_ccb->rsp_list[cont_offset], len_to_send);
   p_rsp += len_to_send;
 
+  if (p_ccb->p_rsp_capture) {
+    if (p_ccb->rsp_cacheable &&
+        p_ccb->cont_offset + len_to_send <= p_ccb->list_len)
+      memcpy(p_ccb->p_rsp_capture + p_ccb->cont_offset,
+             &p_ccb->rsp_list[cont_offset], len_to_send);
+    else
+      osi_free_and_reset((void**)&p_ccb->p_rsp_capture);
+  }
+
   p_ccb->cont_offset += len_to_send;
 
   SDP_TRACE_DEBUG("%s: p_ccb->bl_update_len %d, cont_offset = %d, p_ccb->list_len = %d",
@@ -1385,6 +1628,13 @@ static void process_service_search_attr_req(tCONN_CB* p_ccb, uint16_t trans_num,
     if (p_ccb->bl_update_len) {
       p_ccb->bl_update_len = 0;
     }
+    /* Keep the complete response unless the database changed meanwhile */
+    if (p_ccb->p_rsp_capture && p_ccb->rsp_cacheable &&
+        p_ccb->cont_offset == p_ccb->list_len &&
+        p_ccb->rsp_capture_gen == sdp_rsp_cache_db_gen)
+      sdp_rsp_cache_store(p_ccb, p_ccb->list_len);
+    else
+      osi_free_and_reset((void**)&p_ccb->p_rsp_capture);
   }
 
   /* Go back and put the parameter length into the buffer */
@@ -1480,7 +1730,7 @@ static uint16_t sdp_update_pbap_blacklist_len(tCONN_CB* p_ccb, tSDP_ATTR_SEQ* at
   bool is_pbap_102_blacklisted = is_device_blacklisted_for_pbap(p_ccb->device_address, true);
   bool running_pts = false;
   char pts_property[PROPERTY_VALUE_MAX] = {0};
-  osi_property_get(SDP_ENABLE_PTS_PBAP, pts_property, "false");
+  osi_cached_property_get(&sdp_pts_pbap_prop, pts_property, "false");
   if (!strncmp("true", pts_property, 4)) {
     SDP_TRACE_DEBUG("%s pts running= %d", __func__, pts_property);
     running_pts = true;
@@ -1573,7 +1823,7 @@ static tSDP_RECORD *sdp_upgrade_pse_record(tSDP_RECORD * p_rec,
   bool is_pbap_102_blacklisted = is_device_blacklisted_for_pbap(remote_address, true);
   bool running_pts = false;
   char pts_property[PROPERTY_VALUE_MAX] = {0};
-  osi_property_get(SDP_ENABLE_PTS_PBAP, pts_property, "false");
+  osi_cached_property_get(&sdp_pts_pbap_prop, pts_property, "false");
   if (!strncmp("true", pts_property, 4)) {
     SDP_TRACE_DEBUG("%s pts running= %d", __func__, pts_property);
     running_pts = true;
@@ -1956,7 +2206,7 @@ static tSDP_RECORD *sdp_upgrade_mse_record(tSDP_RECORD * p_rec,
   is_map_104_supported = check_remote_map_version_104(remote_address);
   bool running_pts = false;
   char pts_property[PROPERTY_VALUE_MAX];
-  osi_property_get(SDP_ENABLE_PTS_MAP, pts_property, "false");
+  osi_cached_property_get(&sdp_pts_map_prop, pts_property, "false");
   if (!strncmp("true", pts_property, 4)) {
     SDP_TRACE_DEBUG("%s pts running= %s", __func__, pts_property);
     running_pts = true;
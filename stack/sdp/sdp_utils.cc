@@ -29,6 +29,7 @@
 
 #include "bt_common.h"
 #include "bt_types.h"
+#include "btm_conn_trace.h"
 
 #include "device/include/interop.h"
 #include "device/include/profile_config.h"
@@ -138,6 +139,11 @@ void sdpu_release_ccb(tCONN_CB* p_ccb) {
   /* Ensure timer is stopped */
   alarm_cancel(p_ccb->sdp_conn_timer);
 
+  if ((p_ccb->con_flags & SDP_FLAGS_IS_ORIG) &&
+      p_ccb->con_state != SDP_STATE_IDLE)
+    btm_conn_trace_mark(p_ccb->device_address, BT_TRANSPORT_BR_EDR,
+                        BTM_CONN_TRACE_SDP_COMPLETE);
+
   /* Drop any response pointer we may be holding */
   p_ccb->con_state = SDP_STATE_IDLE;
   p_ccb->is_attr_search = false;
@@ -145,6 +151,12 @@ void sdpu_release_ccb(tCONN_CB* p_ccb) {
   /* Free the response buffer */
   if (p_ccb->rsp_list) SDP_TRACE_DEBUG("releasing SDP rsp_list");
   osi_free_and_reset((void**)&p_ccb->rsp_list);
+
+#if (SDP_SERVER_ENABLED == TRUE)
+  /* Drop any response being recorded or replayed */
+  osi_free_and_reset((void**)&p_ccb->p_rsp_capture);
+  p_ccb->rsp_cache_stamp = 0;
+#endif
 }
 
 /*******************************************************************************
@@ -721,6 +733,33 @@ bool sdpu_compare_uuid_arrays(uint8_t* p_uuid1, uint32_t len1, uint8_t* p_uuid2,
   }
 }
 
+/*******************************************************************************
+ *
+ * Function         sdpu_expand_uuid_to_128
+ *
+ * Description      This function expands a BE UUID of 2, 4 or 16 bytes to its
+ *                  128-bit form, the way sdpu_compare_uuid_arrays compares
+ *                  UUIDs of different lengths.
+ *
+ * Returns          true if expanded, false if the length is invalid
+ *
+ ******************************************************************************/
+bool sdpu_expand_uuid_to_128(const uint8_t* p_uuid, uint32_t len,
+                             uint8_t* p_uuid128) {
+  if (len == 16) {
+    memcpy(p_uuid128, p_uuid, Uuid::kNumBytes128);
+    return true;
+  }
+  if (len != 2 && len != 4) return false;
+
+  memcpy(p_uuid128, sdp_base_uuid, Uuid::kNumBytes128);
+  if (len == 4)
+    memcpy(p_uuid128, p_uuid, len);
+  else
+    memcpy(p_uuid128 + 2, p_uuid, len);
+  return true;
+}
+
 /*******************************************************************************
  *
  * Function         sdpu_compare_uuid_with_attr
@@ -970,8 +1009,9 @@ uint16_t sdpu_get_active_ccb_cid(RawAddress remote_bd_addr) {
     if ((p_ccb->con_state == SDP_STATE_CONN_SETUP) ||
         (p_ccb->con_state == SDP_STATE_CFG_SETUP)  ||
         (p_ccb->con_state == SDP_STATE_CONNECTED)) {
+      /* Discoveries answered from the remote cache have no channel */
       if ((p_ccb->device_address == remote_bd_addr) &&
-          (p_ccb->con_flags & SDP_FLAGS_IS_ORIG))
+          (p_ccb->con_flags & SDP_FLAGS_IS_ORIG) && p_ccb->connection_id)
         return (p_ccb->connection_id);
     }
   }
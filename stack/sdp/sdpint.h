@@ -125,12 +125,25 @@ typedef struct {
   uint8_t attr_pad[SDP_MAX_PAD_LEN];
 } tSDP_RECORD;
 
+/* An entry of the server database UUID index: a UUID, expanded to 128 bits,
+ * and a bitmap of the record slots that contain it */
+#define SDP_REC_MASK_LEN ((SDP_MAX_RECORDS + 7) / 8)
+typedef struct {
+  uint8_t uuid[16];
+  uint8_t rec_mask[SDP_REC_MASK_LEN];
+} tSDP_UUID_INDEX;
+
 /* Define the SDP database */
 typedef struct {
   uint32_t
       di_primary_handle; /* Device ID Primary record or NULL if nonexistent */
   uint16_t num_records;
   tSDP_RECORD record[SDP_MAX_RECORDS];
+
+  /* UUID to record index, kept sorted by UUID */
+  uint16_t num_uuid_index;
+  bool uuid_index_overflow; /* index incomplete, search scans records */
+  tSDP_UUID_INDEX uuid_index[SDP_MAX_UUID_INDEX];
 } tSDP_DB;
 
 enum {
@@ -205,6 +218,14 @@ typedef struct {
   uint16_t cont_offset;     /* Continuation state data in the server response */
   tSDP_CONT_INFO cont_info; /* structure to hold continuation information for
                                the server response */
+
+  /* Service search attribute response cache, see sdp_server.cc */
+  uint8_t rsp_key[SDP_RSP_CACHE_MAX_KEY_LEN]; /* request pattern */
+  uint8_t rsp_key_len;
+  uint8_t* p_rsp_capture;   /* response being recorded, NULL if none */
+  bool rsp_cacheable;       /* false once a peer specific tweak was applied */
+  uint32_t rsp_capture_gen; /* database generation the capture started at */
+  uint32_t rsp_cache_stamp; /* stamp of the entry being replayed, 0 if none */
 #endif                      /* SDP_SERVER_ENABLED == TRUE */
 
 } tCONN_CB;
@@ -273,6 +294,8 @@ extern uint8_t* sdpu_get_len_from_type(uint8_t* p, uint8_t* p_end, uint8_t type,
 extern bool sdpu_is_base_uuid(uint8_t* p_uuid);
 extern bool sdpu_compare_uuid_arrays(uint8_t* p_uuid1, uint32_t len1,
                                      uint8_t* p_uuid2, uint16_t len2);
+extern bool sdpu_expand_uuid_to_128(const uint8_t* p_uuid, uint32_t len,
+                                    uint8_t* p_uuid128);
 extern bool sdpu_compare_uuid_with_attr(const bluetooth::Uuid& uuid,
                                         tSDP_DISC_ATTR* p_attr);
 
@@ -309,8 +332,10 @@ extern tSDP_ATTRIBUTE* sdp_db_find_attr_in_rec(tSDP_RECORD* p_rec,
  */
 #if (SDP_SERVER_ENABLED == TRUE)
 extern void sdp_server_handle_client_req(tCONN_CB* p_ccb, BT_HDR* p_msg);
+extern void sdp_rsp_cache_invalidate(void);
 #else
 #define sdp_server_handle_client_req(p_ccb, p_msg)
+#define sdp_rsp_cache_invalidate()
 #endif
 
 extern int sdp_get_stored_avrc_tg_version(RawAddress addr);
@@ -319,6 +344,8 @@ extern bool sdp_dev_blacklisted_for_avrcp15 (RawAddress addr);
  */
 extern void sdp_disc_connected(tCONN_CB* p_ccb);
 extern void sdp_disc_server_rsp(tCONN_CB* p_ccb, BT_HDR* p_msg);
+extern tCONN_CB* sdp_disc_originate_cached(const RawAddress& bd_addr,
+                                           tSDP_DISCOVERY_DB* p_db);
 
 extern void update_pce_entry_after_cancelling_bonding(RawAddress remote_addr);
 extern void check_and_store_pce_profile_version(tSDP_DISC_REC* p_sdp_rec);
@@ -0,0 +1,509 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  Constant-time P-256 arithmetic for LE Secure Connections.
+ *
+ *  Field elements are four 64 bit limbs (least significant first) in
+ *  Montgomery form, a * 2^256 mod p. Points use projective coordinates and
+ *  the complete addition and doubling formulas of Renes, Costello and Batina
+ *  for a = -3, so infinity and doubling need no special cases and no branch
+ *  depends on secret data. Scalars are recoded into signed 5 bit windows,
+ *  digits in [-16, 16], and table entries are read by scanning the whole
+ *  table.
+ *
+ ******************************************************************************/
+
+#include "p_256_ecc_ct.h"
+
+#include <string.h>
+#include <mutex>
+
+namespace {
+
+typedef uint64_t fe[4];
+
+typedef struct {
+  fe x;
+  fe y;
+  fe z;
+} ct_point_t;
+
+typedef struct {
+  fe x;
+  fe y;
+} ct_affine_t;
+
+// Number of signed 5 bit windows covering a 256 bit scalar.
+constexpr int kWindows = 52;
+constexpr int kWindowBits = 5;
+// Table entries per window: 1 * P ... 16 * P.
+constexpr int kTableSize = 16;
+// The base point table holds every kCombTeeth'th window, the windows in
+// between are reached with kWindowBits doublings each.
+constexpr int kCombTeeth = 4;
+constexpr int kCombRows = kWindows / kCombTeeth;
+
+const fe kP = {0xffffffffffffffff, 0x00000000ffffffff, 0x0000000000000000,
+               0xffffffff00000001};
+// 2^256 mod p, the Montgomery form of 1.
+const fe kOne = {0x0000000000000001, 0xffffffff00000000, 0xffffffffffffffff,
+                 0x00000000fffffffe};
+// 2^512 mod p, to convert into Montgomery form.
+const fe kR2 = {0x0000000000000003, 0xfffffffbffffffff, 0xfffffffffffffffe,
+                0x00000004fffffffd};
+// Curve coefficient b in Montgomery form.
+const fe kB = {0xd89cdf6229c4bddf, 0xacf005cd78843090, 0xe5a220abf7212ed6,
+               0xdc30061d04874834};
+
+// Returns the low half of a * b and stores the high half in |hi|. With
+// unsigned __int128 this is MUL and UMULH on ARMv8.
+inline uint64_t mul64(uint64_t a, uint64_t b, uint64_t* hi) {
+#if defined(__SIZEOF_INT128__)
+  unsigned __int128 r = (unsigned __int128)a * b;
+  *hi = (uint64_t)(r >> 64);
+  return (uint64_t)r;
+#else
+  uint64_t a0 = (uint32_t)a, a1 = a >> 32;
+  uint64_t b0 = (uint32_t)b, b1 = b >> 32;
+  uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+  uint64_t mid = (p00 >> 32) + (uint32_t)p01 + (uint32_t)p10;
+  *hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+  return (mid << 32) | (uint32_t)p00;
+#endif
+}
+
+// Returns the low half of a * b + c + d, which cannot overflow 128 bits.
+inline uint64_t mac(uint64_t a, uint64_t b, uint64_t c, uint64_t d,
+                    uint64_t* hi) {
+  uint64_t h;
+  uint64_t l = mul64(a, b, &h);
+  l += c;
+  h += (l < c);
+  l += d;
+  h += (l < d);
+  *hi = h;
+  return l;
+}
+
+inline uint64_t add_carry(uint64_t a, uint64_t b, uint64_t* carry) {
+  uint64_t s = a + *carry;
+  uint64_t c = (s < a);
+  s += b;
+  *carry = c | (s < b);
+  return s;
+}
+
+inline uint64_t sub_borrow(uint64_t a, uint64_t b, uint64_t* borrow) {
+  uint64_t d = a - b;
+  uint64_t c = (a < b);
+  c |= (d < *borrow);
+  d -= *borrow;
+  *borrow = c;
+  return d;
+}
+
+// r = mask ? a : r, with |mask| all ones or zero.
+inline void fe_cmov(fe r, const fe a, uint64_t mask) {
+  for (int i = 0; i < 4; i++) r[i] ^= mask & (r[i] ^ a[i]);
+}
+
+// r = t - p if that does not borrow or |carry| is set, else t.
+inline void fe_reduce_once(fe r, const fe t, uint64_t carry) {
+  fe u;
+  uint64_t borrow = 0;
+  for (int i = 0; i < 4; i++) u[i] = sub_borrow(t[i], kP[i], &borrow);
+  uint64_t mask = 0 - (carry | (borrow ^ 1));
+  memcpy(r, t, sizeof(fe));
+  fe_cmov(r, u, mask);
+}
+
+void fe_add(fe r, const fe a, const fe b) {
+  fe t;
+  uint64_t carry = 0;
+  for (int i = 0; i < 4; i++) t[i] = add_carry(a[i], b[i], &carry);
+  fe_reduce_once(r, t, carry);
+}
+
+void fe_sub(fe r, const fe a, const fe b) {
+  fe t;
+  uint64_t borrow = 0;
+  for (int i = 0; i < 4; i++) t[i] = sub_borrow(a[i], b[i], &borrow);
+  // Add p back if it borrowed
+  uint64_t mask = 0 - borrow;
+  uint64_t carry = 0;
+  for (int i = 0; i < 4; i++) r[i] = add_carry(t[i], kP[i] & mask, &carry);
+}
+
+// r = a * b / 2^256 mod p, coarsely integrated Montgomery multiplication.
+// -p^-1 mod 2^64 is 1, so the reduction multiplier is the low limb itself.
+void fe_mul(fe r, const fe a, const fe b) {
+  uint64_t t[6] = {0, 0, 0, 0, 0, 0};
+  for (int i = 0; i < 4; i++) {
+    uint64_t c = 0;
+    for (int j = 0; j < 4; j++) t[j] = mac(a[j], b[i], t[j], c, &c);
+    uint64_t carry = 0;
+    t[4] = add_carry(t[4], c, &carry);
+    t[5] = carry;
+
+    uint64_t m = t[0];
+    mac(m, kP[0], t[0], 0, &c);
+    for (int j = 1; j < 4; j++) t[j - 1] = mac(m, kP[j], t[j], c, &c);
+    carry = 0;
+    t[3] = add_carry(t[4], c, &carry);
+    t[4] = t[5] + carry;
+  }
+  fe_reduce_once(r, t, t[4]);
+}
+
+inline void fe_sqr(fe r, const fe a) { fe_mul(r, a, a); }
+
+void fe_sqr_n(fe r, const fe a, int n) {
+  fe_sqr(r, a);
+  while (--n > 0) fe_sqr(r, r);
+}
+
+// r = a^(p - 2) = 1 / a, with a fixed chain of 255 squarings and 12
+// multiplications. The inverse of 0 is 0.
+void fe_inv(fe r, const fe a) {
+  fe t2, t3, t7, t63, x15, x16, x32, i53, x47, t;
+
+  fe_sqr(t2, a);               // a^2
+  fe_mul(t3, a, t2);           // a^3
+  fe_sqr(t, t3);               // a^6
+  fe_mul(t7, a, t);            // a^7
+  fe_sqr_n(t, t7, 3);          // a^56
+  fe_mul(t63, t7, t);          // a^(2^6 - 1)
+  fe_sqr_n(t, t63, 6);
+  fe_mul(t, t, t63);           // a^(2^12 - 1)
+  fe_sqr_n(t, t, 3);
+  fe_mul(x15, t, t7);          // a^(2^15 - 1)
+  fe_sqr(t, x15);
+  fe_mul(x16, t, a);           // a^(2^16 - 1)
+  fe_sqr_n(t, x16, 16);
+  fe_mul(x32, t, x16);         // a^(2^32 - 1)
+  fe_sqr_n(i53, x32, 15);
+  fe_mul(x47, x15, i53);       // a^(2^47 - 1)
+  fe_sqr_n(t, i53, 17);
+  fe_mul(t, t, a);
+  fe_sqr_n(t, t, 143);
+  fe_mul(t, t, x47);
+  fe_sqr_n(t, t, 47);
+  fe_mul(t, t, x47);
+  fe_sqr_n(t, t, 2);
+  fe_mul(r, t, a);
+}
+
+void fe_from_dwords(fe r, const uint32_t* a) {
+  fe t;
+  for (int i = 0; i < 4; i++)
+    t[i] = (uint64_t)a[2 * i] | ((uint64_t)a[2 * i + 1] << 32);
+  fe_mul(r, t, kR2);
+}
+
+void fe_to_dwords(uint32_t* r, const fe a) {
+  const fe one = {1, 0, 0, 0};
+  fe t;
+  fe_mul(t, a, one);
+  for (int i = 0; i < 4; i++) {
+    r[2 * i] = (uint32_t)t[i];
+    r[2 * i + 1] = (uint32_t)(t[i] >> 32);
+  }
+}
+
+void point_set_infinity(ct_point_t* r) {
+  memset(r->x, 0, sizeof(fe));
+  memcpy(r->y, kOne, sizeof(fe));
+  memset(r->z, 0, sizeof(fe));
+}
+
+// r = p + q, complete for all points on the curve (RCB, algorithm 4).
+void point_add(ct_point_t* r, const ct_point_t* p, const ct_point_t* q) {
+  fe t0, t1, t2, t3, t4, x3, y3, z3;
+
+  fe_mul(t0, p->x, q->x);
+  fe_mul(t1, p->y, q->y);
+  fe_mul(t2, p->z, q->z);
+  fe_add(t3, p->x, p->y);
+  fe_add(t4, q->x, q->y);
+  fe_mul(t3, t3, t4);
+  fe_add(t4, t0, t1);
+  fe_sub(t3, t3, t4);
+  fe_add(t4, p->y, p->z);
+  fe_add(x3, q->y, q->z);
+  fe_mul(t4, t4, x3);
+  fe_add(x3, t1, t2);
+  fe_sub(t4, t4, x3);
+  fe_add(x3, p->x, p->z);
+  fe_add(y3, q->x, q->z);
+  fe_mul(x3, x3, y3);
+  fe_add(y3, t0, t2);
+  fe_sub(y3, x3, y3);
+  fe_mul(z3, kB, t2);
+  fe_sub(x3, y3, z3);
+  fe_add(z3, x3, x3);
+  fe_add(x3, x3, z3);
+  fe_sub(z3, t1, x3);
+  fe_add(x3, t1, x3);
+  fe_mul(y3, kB, y3);
+  fe_add(t1, t2, t2);
+  fe_add(t2, t1, t2);
+  fe_sub(y3, y3, t2);
+  fe_sub(y3, y3, t0);
+  fe_add(t1, y3, y3);
+  fe_add(y3, t1, y3);
+  fe_add(t1, t0, t0);
+  fe_add(t0, t1, t0);
+  fe_sub(t0, t0, t2);
+  fe_mul(t1, t4, y3);
+  fe_mul(t2, t0, y3);
+  fe_mul(y3, x3, z3);
+  fe_add(y3, y3, t2);
+  fe_mul(x3, t3, x3);
+  fe_sub(x3, x3, t1);
+  fe_mul(z3, t4, z3);
+  fe_mul(t1, t3, t0);
+  fe_add(z3, z3, t1);
+
+  memcpy(r->x, x3, sizeof(fe));
+  memcpy(r->y, y3, sizeof(fe));
+  memcpy(r->z, z3, sizeof(fe));
+}
+
+// r = 2p (RCB, algorithm 6).
+void point_double(ct_point_t* r, const ct_point_t* p) {
+  fe t0, t1, t2, t3, x3, y3, z3;
+
+  fe_sqr(t0, p->x);
+  fe_sqr(t1, p->y);
+  fe_sqr(t2, p->z);
+  fe_mul(t3, p->x, p->y);
+  fe_add(t3, t3, t3);
+  fe_mul(z3, p->x, p->z);
+  fe_add(z3, z3, z3);
+  fe_mul(y3, kB, t2);
+  fe_sub(y3, y3, z3);
+  fe_add(x3, y3, y3);
+  fe_add(y3, x3, y3);
+  fe_sub(x3, t1, y3);
+  fe_add(y3, t1, y3);
+  fe_mul(y3, x3, y3);
+  fe_mul(x3, x3, t3);
+  fe_add(t3, t2, t2);
+  fe_add(t2, t2, t3);
+  fe_mul(z3, kB, z3);
+  fe_sub(z3, z3, t2);
+  fe_sub(z3, z3, t0);
+  fe_add(t3, z3, z3);
+  fe_add(z3, z3, t3);
+  fe_add(t3, t0, t0);
+  fe_add(t0, t3, t0);
+  fe_sub(t0, t0, t2);
+  fe_mul(t0, t0, z3);
+  fe_add(y3, y3, t0);
+  fe_mul(t0, p->y, p->z);
+  fe_add(t0, t0, t0);
+  fe_mul(z3, t0, z3);
+  fe_sub(x3, x3, z3);
+  fe_mul(z3, t0, t1);
+  fe_add(z3, z3, z3);
+  fe_add(z3, z3, z3);
+
+  memcpy(r->x, x3, sizeof(fe));
+  memcpy(r->y, y3, sizeof(fe));
+  memcpy(r->z, z3, sizeof(fe));
+}
+
+// y = -y if |mask| is all ones.
+void point_cneg(ct_point_t* r, uint64_t mask) {
+  const fe zero = {0, 0, 0, 0};
+  fe neg;
+  fe_sub(neg, zero, r->y);
+  fe_cmov(r->y, neg, mask);
+}
+
+inline uint64_t ct_eq_mask(uint32_t a, uint32_t b) {
+  uint64_t d = a ^ b;
+  return ((d | (0 - d)) >> 63) - 1;
+}
+
+// Bits [5i - 1, 5i + 4] of |k|, with bit -1 being 0. The window position is
+// public, only the value is secret.
+uint32_t scalar_window(const uint64_t k[4], int i) {
+  int start = kWindowBits * i - 1;
+  if (start < 0) return (uint32_t)(k[0] << 1) & 0x3f;
+  int limb = start / 64;
+  int shift = start % 64;
+  uint64_t w = k[limb] >> shift;
+  if (shift > 64 - 6 && limb < 3) w |= k[limb + 1] << (64 - shift);
+  return (uint32_t)w & 0x3f;
+}
+
+// Signed digit of a window, |*digit| in [0, 16] and |*neg| 0 or 1.
+void booth_recode(uint32_t window, uint32_t* digit, uint32_t* neg) {
+  uint32_t s = ~((window >> 5) - 1);
+  uint32_t d = (1 << 6) - window - 1;
+  d = (d & s) | (window & ~s);
+  *digit = (d >> 1) + (d & 1);
+  *neg = s & 1;
+}
+
+void scalar_from_dwords(uint64_t k[4], const uint32_t* n) {
+  for (int i = 0; i < 4; i++)
+    k[i] = (uint64_t)n[2 * i] | ((uint64_t)n[2 * i + 1] << 32);
+}
+
+// r = digit * P from |table| holding 1 * P ... 16 * P; infinity for 0.
+void table_select(ct_point_t* r, const ct_point_t table[kTableSize],
+                  uint32_t digit) {
+  point_set_infinity(r);
+  for (uint32_t i = 0; i < kTableSize; i++) {
+    uint64_t mask = ct_eq_mask(digit, i + 1);
+    fe_cmov(r->x, table[i].x, mask);
+    fe_cmov(r->y, table[i].y, mask);
+    fe_cmov(r->z, table[i].z, mask);
+  }
+}
+
+void affine_table_select(ct_point_t* r, const ct_affine_t table[kTableSize],
+                         uint32_t digit) {
+  point_set_infinity(r);
+  for (uint32_t i = 0; i < kTableSize; i++) {
+    uint64_t mask = ct_eq_mask(digit, i + 1);
+    fe_cmov(r->x, table[i].x, mask);
+    fe_cmov(r->y, table[i].y, mask);
+    fe_cmov(r->z, kOne, mask);
+  }
+}
+
+// table[i] = (i + 1) * p
+void point_multiples(ct_point_t table[kTableSize], const ct_point_t* p) {
+  table[0] = *p;
+  for (int i = 1; i < kTableSize; i++) {
+    if (i & 1)
+      point_double(&table[i], &table[i / 2]);
+    else
+      point_add(&table[i], &table[i - 1], p);
+  }
+}
+
+void point_to_affine(Point* q, const ct_point_t* p) {
+  fe zinv, t;
+  fe_inv(zinv, p->z);
+  fe_mul(t, p->x, zinv);
+  fe_to_dwords(q->x, t);
+  fe_mul(t, p->y, zinv);
+  fe_to_dwords(q->y, t);
+  memset(q->z, 0, sizeof(q->z));
+  q->z[0] = 1;
+}
+
+// base_table[j][i] = (i + 1) * 2^(20 j) * G, affine.
+ct_affine_t base_table[kCombRows][kTableSize];
+std::once_flag base_table_once;
+
+void build_base_table() {
+  ct_point_t row[kCombRows * kTableSize];
+  ct_point_t base;
+  fe_from_dwords(base.x, curve_p256.G.x);
+  fe_from_dwords(base.y, curve_p256.G.y);
+  memcpy(base.z, kOne, sizeof(fe));
+
+  for (int j = 0; j < kCombRows; j++) {
+    point_multiples(&row[j * kTableSize], &base);
+    for (int d = 0; d < kWindowBits * kCombTeeth; d++)
+      point_double(&base, &base);
+  }
+
+  // One inversion for the whole table: prefix[i] = z_0 * ... * z_i
+  const int count = kCombRows * kTableSize;
+  fe prefix[kCombRows * kTableSize];
+  memcpy(prefix[0], row[0].z, sizeof(fe));
+  for (int i = 1; i < count; i++) fe_mul(prefix[i], prefix[i - 1], row[i].z);
+
+  fe inv;
+  fe_inv(inv, prefix[count - 1]);
+  for (int i = count - 1; i >= 0; i--) {
+    fe zinv;
+    if (i > 0) {
+      fe_mul(zinv, inv, prefix[i - 1]);
+      fe_mul(inv, inv, row[i].z);
+    } else {
+      memcpy(zinv, inv, sizeof(fe));
+    }
+    ct_affine_t* entry = &base_table[i / kTableSize][i % kTableSize];
+    fe_mul(entry->x, row[i].x, zinv);
+    fe_mul(entry->y, row[i].y, zinv);
+  }
+}
+
+}  // namespace
+
+void p_256_ct_point_mult(Point* q, const Point* p, const uint32_t* n) {
+  ct_point_t table[kTableSize];
+  ct_point_t base, r, t;
+  uint64_t k[4];
+
+  fe_from_dwords(base.x, p->x);
+  fe_from_dwords(base.y, p->y);
+  memcpy(base.z, kOne, sizeof(fe));
+  point_multiples(table, &base);
+  scalar_from_dwords(k, n);
+
+  point_set_infinity(&r);
+  for (int i = kWindows - 1; i >= 0; i--) {
+    for (int d = 0; d < kWindowBits; d++) point_double(&r, &r);
+
+    uint32_t digit, neg;
+    booth_recode(scalar_window(k, i), &digit, &neg);
+    table_select(&t, table, digit);
+    point_cneg(&t, 0 - (uint64_t)neg);
+    point_add(&r, &r, &t);
+  }
+
+  point_to_affine(q, &r);
+  memset(k, 0, sizeof(k));
+}
+
+void p_256_ct_base_point_mult(Point* q, const uint32_t* n) {
+  std::call_once(base_table_once, build_base_table);
+
+  ct_point_t r, t;
+  uint64_t k[4];
+  scalar_from_dwords(k, n);
+
+  // Window 4j + s comes from row j, the doublings between passes account
+  // for s.
+  point_set_infinity(&r);
+  for (int s = kCombTeeth - 1; s >= 0; s--) {
+    if (s != kCombTeeth - 1)
+      for (int d = 0; d < kWindowBits; d++) point_double(&r, &r);
+
+    for (int j = 0; j < kCombRows; j++) {
+      uint32_t digit, neg;
+      booth_recode(scalar_window(k, kCombTeeth * j + s), &digit, &neg);
+      affine_table_select(&t, base_table[j], digit);
+      point_cneg(&t, 0 - (uint64_t)neg);
+      point_add(&r, &r, &t);
+    }
+  }
+
+  point_to_affine(q, &r);
+  memset(k, 0, sizeof(k));
+}
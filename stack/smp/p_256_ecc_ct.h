@@ -0,0 +1,36 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  Constant-time P-256 scalar multiplication used by ECC_PointMult.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include "p_256_ecc_pp.h"
+
+// q = n * p, where |n| is a 256 bit scalar in DWORD order (least significant
+// first) and |p| an affine point on the curve. |q| gets the affine result,
+// with z = 1. The running time and memory accesses do not depend on |n|.
+void p_256_ct_point_mult(Point* q, const Point* p, const uint32_t* n);
+
+// q = n * G, for the curve base point G. Same as p_256_ct_point_mult, using a
+// precomputed table of multiples of G built on first use.
+void p_256_ct_base_point_mult(Point* q, const uint32_t* n);
@@ -16,6 +16,7 @@
  *
  ******************************************************************************/
 
+#include <base/bind.h>
 #include <log/log.h>
 #include <string.h>
 #include "btif_api.h"
@@ -23,7 +24,9 @@
 #include "btif_storage.h"
 #include "device/include/interop.h"
 #include "internal_include/bt_target.h"
+#include "osi/include/time.h"
 #include "stack/btm/btm_int.h"
+#include "stack/include/btu.h"
 #include "stack/include/l2c_api.h"
 #include "stack/smp/p_256_ecc_pp.h"
 #include "stack/smp/smp_int.h"
@@ -1546,11 +1549,36 @@ void smp_idle_terminate(tSMP_CB* p_cb, tSMP_INT_DATA* p_data) {
  *              - on slave side invokes sending local public key to the peer.
  *              - invokes SC phase 1 process.
  ******************************************************************************/
-void smp_both_have_public_keys(tSMP_CB* p_cb, tSMP_INT_DATA* p_data) {
-  SMP_TRACE_DEBUG("%s", __func__);
+typedef struct {
+  RawAddress pairing_bda;
+  BT_OCTET32 private_key;
+  tSMP_PUBLIC_KEY peer_publ_key;
+  BT_OCTET32 dhkey;
+  uint64_t compute_us;
+} tSMP_DHKEY_REQ;
+
+static void smp_dhkey_calculate(tSMP_DHKEY_REQ* p_req) {
+  uint64_t start_us = time_get_os_boottime_us();
+  smp_calculate_dhkey(p_req->private_key, p_req->peer_publ_key, p_req->dhkey);
+  p_req->compute_us = time_get_os_boottime_us() - start_us;
+}
 
-  /* invokes DHKey computation */
-  smp_compute_dhkey(p_cb);
+/* Continues smp_both_have_public_keys() on the main thread, unless the
+ * pairing the DHKey was computed for is over */
+static void smp_dhkey_calculated(tSMP_DHKEY_REQ* p_req) {
+  tSMP_CB* p_cb = &smp_cb;
+
+  if (p_cb->state != SMP_STATE_SEC_CONN_PHS1_START ||
+      p_cb->pairing_bda != p_req->pairing_bda ||
+      memcmp(p_cb->private_key, p_req->private_key, BT_OCTET32_LEN) ||
+      memcmp(&p_cb->peer_publ_key, &p_req->peer_publ_key,
+             sizeof(tSMP_PUBLIC_KEY))) {
+    SMP_TRACE_WARNING("%s: pairing changed, DHKey dropped", __func__);
+    return;
+  }
+
+  smp_save_dhkey(p_cb, p_req->dhkey);
+  smp_metrics_dhkey(p_cb, p_req->compute_us);
 
   /* on slave side invokes sending local public key to the peer */
   if (p_cb->role == HCI_ROLE_SLAVE) smp_send_pair_public_key(p_cb, NULL);
@@ -1558,6 +1586,21 @@ void smp_both_have_public_keys(tSMP_CB* p_cb, tSMP_INT_DATA* p_data) {
   smp_sm_event(p_cb, SMP_SC_DHKEY_CMPLT_EVT, NULL);
 }
 
+void smp_both_have_public_keys(tSMP_CB* p_cb, tSMP_INT_DATA* p_data) {
+  SMP_TRACE_DEBUG("%s", __func__);
+
+  /* invokes DHKey computation on a worker thread, the P-256 point
+   * multiplication takes long enough to stall packet processing */
+  tSMP_DHKEY_REQ* p_req = new tSMP_DHKEY_REQ;
+  p_req->pairing_bda = p_cb->pairing_bda;
+  memcpy(p_req->private_key, p_cb->private_key, BT_OCTET32_LEN);
+  p_req->peer_publ_key = p_cb->peer_publ_key;
+
+  do_in_worker_thread_and_reply(
+      FROM_HERE, base::Bind(&smp_dhkey_calculate, p_req),
+      base::Bind(&smp_dhkey_calculated, base::Owned(p_req)));
+}
+
 /*******************************************************************************
  * Function     smp_start_secure_connection_phase1
  * Description  Start Secure Connection phase1 i.e. invokes initialization of
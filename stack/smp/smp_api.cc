@@ -103,6 +103,7 @@ void SMP_Init(void) {
   smp_l2cap_if_init();
   /* initialization of P-256 parameters */
   p_256_init_curve(KEY_LENGTH_DWORDS_P256);
+  smp_key_pool_init();
 
   /* Initialize failure case for certification */
   smp_cb.cert_failure =
@@ -188,6 +189,7 @@ tSMP_STATUS SMP_Pair(const RawAddress& bd_addr) {
   } else {
     p_cb->flags = SMP_PAIR_FLAGS_WE_STARTED_DD;
     p_cb->pairing_bda = bd_addr;
+    smp_key_pool_fill();
 
     if (!L2CA_ConnectFixedChnl(L2CAP_SMP_CID, bd_addr)) {
       tSMP_INT_DATA smp_int_data;
@@ -257,6 +257,31 @@ typedef struct {
   BT_HDR* p_copy;
 } tSMP_REQ_Q_ENTRY;
 
+/* Phases of LE pairing timed by smp_metrics.cc. Every state of the main state
+ * machine belongs to one phase, see smp_metrics_state_change(). */
+enum {
+  SMP_PHASE_FEATURE_EXCH,    /* security request, pairing request/response */
+  SMP_PHASE_PUBLIC_KEY_EXCH, /* SC public key exchange */
+  SMP_PHASE_AUTH,            /* confirm/random or commitment/nonce rounds */
+  SMP_PHASE_DHKEY_CHECK,     /* SC DHKey check exchange */
+  SMP_PHASE_ENCRYPTION,      /* waiting for the link to be encrypted */
+  SMP_PHASE_KEY_DIST,        /* key distribution */
+  SMP_PHASE_COUNT,
+  SMP_PHASE_NONE = SMP_PHASE_COUNT
+};
+typedef uint8_t tSMP_PHASE;
+
+/* Timing of the pairing in progress, in microseconds of boot time */
+typedef struct {
+  uint64_t start_us;       /* 0 while no pairing is timed */
+  uint64_t phase_start_us; /* when |phase| was entered */
+  tSMP_PHASE phase;
+  uint8_t phase_mask; /* bit per phase entered */
+  uint64_t phase_us[SMP_PHASE_COUNT];
+  uint64_t dhkey_us;   /* time spent computing the DHKey */
+  uint8_t round_trips; /* pairing random PDUs received */
+} tSMP_PAIRING_TIMING;
+
 /* SMP control block */
 typedef struct {
   tSMP_CALLBACK* p_callback;
@@ -336,6 +361,7 @@ typedef struct {
   uint8_t cert_failure; /*failure case for certification */
   alarm_t* delayed_auth_timer_ent;
   uint8_t cert_disable_h7_support;
+  tSMP_PAIRING_TIMING timing;
 } tSMP_CB;
 
 /* Server Action functions are of this type */
@@ -472,6 +498,12 @@ extern void smp_calculate_f5_mackey_and_long_term_key(tSMP_CB* p_cb);
 extern void smp_remove_fixed_channel(tSMP_CB* p_cb);
 extern bool smp_request_oob_data(tSMP_CB* p_cb);
 
+/* smp_metrics.cc */
+extern void smp_metrics_state_change(tSMP_CB* p_cb, tSMP_STATE state);
+extern void smp_metrics_event(tSMP_CB* p_cb, tSMP_EVENT event);
+extern void smp_metrics_dhkey(tSMP_CB* p_cb, uint64_t compute_us);
+extern void smp_metrics_pairing_cmpl(tSMP_CB* p_cb);
+
 /* smp_keys.cc */
 extern void smp_generate_srand_mrand_confirm(tSMP_CB* p_cb,
                                              tSMP_INT_DATA* p_data);
@@ -483,6 +515,10 @@ extern void smp_generate_rand_cont(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
 extern void smp_create_private_key(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
 extern void smp_use_oob_private_key(tSMP_CB* p_cb, tSMP_INT_DATA* p_data);
 extern void smp_compute_dhkey(tSMP_CB* p_cb);
+extern void smp_calculate_dhkey(const BT_OCTET32 private_key,
+                                const tSMP_PUBLIC_KEY& peer_publ_key,
+                                BT_OCTET32 dhkey);
+extern void smp_save_dhkey(tSMP_CB* p_cb, const BT_OCTET32 dhkey);
 extern void smp_calculate_local_commitment(tSMP_CB* p_cb);
 extern Octet16 smp_calculate_peer_commitment(tSMP_CB* p_cb);
 extern void smp_calculate_numeric_comparison_display_number(
@@ -516,4 +552,9 @@ extern void smp_xor_128(Octet16* a, const Octet16& b);
 extern void smp_save_local_oob_data(tSMP_CB* p_cb);
 extern void smp_clear_local_oob_data();
 
+/* LE SC key pairs generated ahead of pairing */
+extern void smp_key_pool_init(void);
+extern void smp_key_pool_fill(void);
+extern void smp_key_pool_discard(const BT_OCTET32 private_key);
+
 #endif /* SMP_INT_H */
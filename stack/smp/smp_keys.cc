@@ -35,12 +35,14 @@
 #include "device/include/controller.h"
 #include "hcimsgs.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
 #include "p_256_ecc_pp.h"
 #include "smp_int.h"
 #include "stack/crypto_toolbox/crypto_toolbox.h"
 #include "stack_config.h"
 
 #include <algorithm>
+#include <deque>
 
 using base::Bind;
 using crypto_toolbox::aes_128;
@@ -49,9 +51,20 @@ using crypto_toolbox::aes_128;
 #define SMP_MAX_ENC_REPEAT 3
 #endif
 
+/* Number of ready LE SC key pairs kept in the key pool */
+#ifndef SMP_KEY_POOL_SIZE
+#define SMP_KEY_POOL_SIZE 2
+#endif
+
+/* Number of pairings a pooled key pair may be used for. 1 gives every
+ * pairing a fresh key pair; a key pair is always dropped after a failed
+ * pairing whatever the setting. */
+#define SMP_KEY_REUSE_PROPERTY "persist.vendor.bt.smp.key_reuse_count"
+
 static void smp_process_stk(tSMP_CB* p_cb, Octet16* p);
 static Octet16 smp_calculate_legacy_short_term_key(tSMP_CB* p_cb);
 static void smp_process_private_key(tSMP_CB* p_cb);
+static void smp_process_local_public_key(tSMP_CB* p_cb);
 
 #define SMP_PASSKEY_MASK 0xfff00000
 
@@ -622,6 +635,160 @@ Octet16 smp_calculate_legacy_short_term_key(tSMP_CB* p_cb) {
   return aes_128(p_cb->tk, text);
 }
 
+typedef struct {
+  BT_OCTET32 private_key;
+  tSMP_PUBLIC_KEY publ_key;
+  uint8_t uses;
+} tSMP_POOLED_KEY;
+
+typedef struct {
+  uint32_t generation;
+  tSMP_POOLED_KEY key;
+} tSMP_KEY_POOL_REQ;
+
+/* Key pairs generated ahead of pairing, only accessed on the main thread */
+static std::deque<tSMP_POOLED_KEY> smp_key_pool;
+static bool smp_key_pool_filling = false;
+static uint32_t smp_key_pool_generation = 0;
+static uint8_t smp_key_pool_max_uses = 1;
+
+static void smp_key_pool_erase(std::deque<tSMP_POOLED_KEY>::iterator it) {
+  memset(&*it, 0, sizeof(tSMP_POOLED_KEY));
+  smp_key_pool.erase(it);
+}
+
+/* Runs on a worker thread */
+static void smp_key_pool_calculate(tSMP_KEY_POOL_REQ* p_req) {
+  Point public_key;
+  BT_OCTET32 private_key;
+
+  memcpy(private_key, p_req->key.private_key, BT_OCTET32_LEN);
+  ECC_PointMult(&public_key, &(curve_p256.G), (uint32_t*)private_key,
+                KEY_LENGTH_DWORDS_P256);
+  memcpy(p_req->key.publ_key.x, public_key.x, BT_OCTET32_LEN);
+  memcpy(p_req->key.publ_key.y, public_key.y, BT_OCTET32_LEN);
+  memset(private_key, 0, BT_OCTET32_LEN);
+}
+
+static void smp_key_pool_add(tSMP_KEY_POOL_REQ* p_req) {
+  if (p_req->generation != smp_key_pool_generation) {
+    memset(p_req, 0, sizeof(tSMP_KEY_POOL_REQ));
+    return;
+  }
+
+  smp_key_pool_filling = false;
+  smp_key_pool.push_back(p_req->key);
+  memset(p_req, 0, sizeof(tSMP_KEY_POOL_REQ));
+  SMP_TRACE_DEBUG("%s: %zu key pairs ready", __func__, smp_key_pool.size());
+
+  smp_key_pool_fill();
+}
+
+static void smp_key_pool_rand(tSMP_KEY_POOL_REQ* p_req, uint8_t offset) {
+  btsnd_hcic_ble_rand(Bind(
+      [](tSMP_KEY_POOL_REQ* p_req, uint8_t offset, BT_OCTET8 rand) {
+        memcpy(&p_req->key.private_key[offset], rand, BT_OCTET8_LEN);
+        offset += BT_OCTET8_LEN;
+        if (offset < BT_OCTET32_LEN) {
+          smp_key_pool_rand(p_req, offset);
+          return;
+        }
+
+        do_in_worker_thread_and_reply(
+            FROM_HERE, Bind(&smp_key_pool_calculate, p_req),
+            Bind(&smp_key_pool_add, base::Owned(p_req)));
+      },
+      p_req, offset));
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_key_pool_init
+ *
+ * Description      This function empties the LE SC key pool and reads its
+ *                  reuse policy. Key pairs still being generated are dropped.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void smp_key_pool_init(void) {
+  while (!smp_key_pool.empty()) smp_key_pool_erase(smp_key_pool.begin());
+  smp_key_pool_filling = false;
+  smp_key_pool_generation++;
+
+  int32_t max_uses = osi_property_get_int32(SMP_KEY_REUSE_PROPERTY, 1);
+  smp_key_pool_max_uses = (uint8_t)std::min(std::max(max_uses, 1), 255);
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_key_pool_fill
+ *
+ * Description      This function starts generating a key pair for the LE SC
+ *                  key pool if it holds fewer than SMP_KEY_POOL_SIZE. The
+ *                  private key comes from the controller and the public key
+ *                  is calculated on a worker thread, one key pair at a time.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void smp_key_pool_fill(void) {
+  if (smp_key_pool_filling || smp_key_pool.size() >= SMP_KEY_POOL_SIZE) return;
+  if (!controller_get_interface()->get_is_ready()) return;
+
+  smp_key_pool_filling = true;
+  tSMP_KEY_POOL_REQ* p_req = new tSMP_KEY_POOL_REQ{};
+  p_req->generation = smp_key_pool_generation;
+  smp_key_pool_rand(p_req, 0);
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_key_pool_take
+ *
+ * Description      This function copies a ready key pair from the LE SC key
+ *                  pool into |p_cb| and starts a refill. The key pair stays
+ *                  in the pool until it has been used for the configured
+ *                  number of pairings.
+ *
+ * Returns          true if a key pair was taken, false if the pool is empty
+ *
+ ******************************************************************************/
+static bool smp_key_pool_take(tSMP_CB* p_cb) {
+  if (smp_key_pool.empty()) {
+    smp_key_pool_fill();
+    return false;
+  }
+
+  auto it = smp_key_pool.begin();
+  memcpy(p_cb->private_key, it->private_key, BT_OCTET32_LEN);
+  p_cb->loc_publ_key = it->publ_key;
+  if (++it->uses >= smp_key_pool_max_uses) smp_key_pool_erase(it);
+
+  smp_key_pool_fill();
+  return true;
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_key_pool_discard
+ *
+ * Description      This function drops |private_key| from the LE SC key pool,
+ *                  a key pair must not be reused after a failed pairing.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void smp_key_pool_discard(const BT_OCTET32 private_key) {
+  for (auto it = smp_key_pool.begin(); it != smp_key_pool.end(); ++it) {
+    if (memcmp(it->private_key, private_key, BT_OCTET32_LEN) == 0) {
+      smp_key_pool_erase(it);
+      smp_key_pool_fill();
+      return;
+    }
+  }
+}
+
 /*******************************************************************************
  *
  * Function         smp_create_private_key
@@ -659,6 +826,12 @@ void smp_create_private_key(tSMP_CB* p_cb, tSMP_INT_DATA* p_data) {
     SMP_TRACE_WARNING("OOB Association Model with no saved data present");
   }
 
+  if (smp_key_pool_take(p_cb)) {
+    SMP_TRACE_DEBUG("%s: using pooled key pair", __func__);
+    smp_process_local_public_key(p_cb);
+    return;
+  }
+
   btsnd_hcic_ble_rand(Bind(
       [](tSMP_CB* p_cb, BT_OCTET8 rand) {
         memcpy((void*)p_cb->private_key, rand, BT_OCTET8_LEN);
@@ -732,7 +905,6 @@ void smp_use_oob_private_key(tSMP_CB* p_cb, tSMP_INT_DATA* p_data) {
 void smp_process_private_key(tSMP_CB* p_cb) {
   Point public_key;
   BT_OCTET32 private_key;
-  int generate_invalid_public_key;
 
   SMP_TRACE_DEBUG("%s", __func__);
 
@@ -742,7 +914,21 @@ void smp_process_private_key(tSMP_CB* p_cb) {
   memcpy(p_cb->loc_publ_key.x, public_key.x, BT_OCTET32_LEN);
   memcpy(p_cb->loc_publ_key.y, public_key.y, BT_OCTET32_LEN);
 
-  generate_invalid_public_key =
+  smp_process_local_public_key(p_cb);
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_process_local_public_key
+ *
+ * Description      This function notifies SM that the local private key /
+ *                  public key pair in |p_cb| is ready.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+static void smp_process_local_public_key(tSMP_CB* p_cb) {
+  int generate_invalid_public_key =
       stack_config_get_interface()->get_pts_smp_generate_invalid_public_key();
 
   switch (generate_invalid_public_key) {
@@ -790,20 +976,55 @@ void smp_process_private_key(tSMP_CB* p_cb) {
  *
  ******************************************************************************/
 void smp_compute_dhkey(tSMP_CB* p_cb) {
-  Point peer_publ_key, new_publ_key;
-  BT_OCTET32 private_key;
-  int generate_invalid_public_key;
+  BT_OCTET32 dhkey;
 
   SMP_TRACE_DEBUG("%s", __func__);
 
-  memcpy(private_key, p_cb->private_key, BT_OCTET32_LEN);
-  memcpy(peer_publ_key.x, p_cb->peer_publ_key.x, BT_OCTET32_LEN);
-  memcpy(peer_publ_key.y, p_cb->peer_publ_key.y, BT_OCTET32_LEN);
+  smp_calculate_dhkey(p_cb->private_key, p_cb->peer_publ_key, dhkey);
+  smp_save_dhkey(p_cb, dhkey);
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_calculate_dhkey
+ *
+ * Description      Multiplies |peer_publ_key| with |private_key| and writes
+ *                  the x-coordinate of the result to |dhkey|. Only touches its
+ *                  arguments, so it can run outside of the main thread.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void smp_calculate_dhkey(const BT_OCTET32 private_key,
+                         const tSMP_PUBLIC_KEY& peer_publ_key,
+                         BT_OCTET32 dhkey) {
+  Point peer_point, new_publ_key;
+  BT_OCTET32 key;
+
+  memcpy(key, private_key, BT_OCTET32_LEN);
+  memcpy(peer_point.x, peer_publ_key.x, BT_OCTET32_LEN);
+  memcpy(peer_point.y, peer_publ_key.y, BT_OCTET32_LEN);
 
-  ECC_PointMult(&new_publ_key, &peer_publ_key, (uint32_t*)private_key,
+  ECC_PointMult(&new_publ_key, &peer_point, (uint32_t*)key,
                 KEY_LENGTH_DWORDS_P256);
 
-  memcpy(p_cb->dhkey, new_publ_key.x, BT_OCTET32_LEN);
+  memcpy(dhkey, new_publ_key.x, BT_OCTET32_LEN);
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_save_dhkey
+ *
+ * Description      Saves the DHKey computed by smp_calculate_dhkey() in the
+ *                  control block.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void smp_save_dhkey(tSMP_CB* p_cb, const BT_OCTET32 dhkey) {
+  int generate_invalid_public_key;
+
+  memcpy(p_cb->dhkey, dhkey, BT_OCTET32_LEN);
 
   generate_invalid_public_key =
       stack_config_get_interface()->get_pts_smp_generate_invalid_public_key();
@@ -922,6 +922,7 @@ void smp_set_state(tSMP_STATE state) {
     SMP_TRACE_DEBUG("State change: %s(%d) ==> %s(%d)",
                     smp_get_state_name(smp_cb.state), smp_cb.state,
                     smp_get_state_name(state), state);
+    smp_metrics_state_change(&smp_cb, state);
     smp_cb.state = state;
   } else {
     SMP_TRACE_DEBUG("smp_set_state invalid state =%d", state);
@@ -993,6 +994,8 @@ bool smp_sm_event(tSMP_CB* p_cb, tSMP_EVENT event, tSMP_INT_DATA* p_data) {
     return false;
   }
 
+  smp_metrics_event(p_cb, event);
+
   /* Get possible next state from state table. */
 
   smp_set_state(state_table[entry - 1][SMP_SME_NEXT_STATE]);
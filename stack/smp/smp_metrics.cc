@@ -0,0 +1,281 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+/******************************************************************************
+ *
+ *  This file contains the LE pairing timing. The time the state machine
+ *  spends in each phase of a pairing is accumulated in smp_cb while the
+ *  pairing runs, and added to the histograms below and to the metrics log
+ *  when it completes.
+ *
+ ******************************************************************************/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <mutex>
+
+#include "osi/include/metrics.h"
+#include "osi/include/time.h"
+#include "smp_api.h"
+#include "smp_int.h"
+
+using system_bt_osi::BluetoothMetricsLogger;
+using system_bt_osi::SmpPairingMetrics;
+
+/* Histogram bucket |i| counts samples below 2^i ms; the last bucket counts
+ * everything else. */
+#define SMP_TIMING_BUCKETS 14
+
+typedef struct {
+  uint32_t count;
+  uint64_t total_us;
+  uint64_t max_us;
+  uint32_t histogram[SMP_TIMING_BUCKETS];
+} tSMP_TIMING_HIST;
+
+typedef struct {
+  uint32_t pairings;
+  uint32_t failures;
+  uint32_t round_trips;
+  tSMP_TIMING_HIST phase[SMP_PHASE_COUNT];
+  tSMP_TIMING_HIST dhkey;
+  tSMP_TIMING_HIST total;
+} tSMP_TIMING_STATS;
+
+static const char* const smp_phase_names[SMP_PHASE_COUNT] = {
+    "feature", "pubkey", "auth", "dhkcheck", "encrypt", "keydist"};
+
+static std::mutex smp_timing_lock;
+static tSMP_TIMING_STATS smp_timing_stats;
+
+static void smp_timing_hist_add(tSMP_TIMING_HIST* p_hist, uint64_t elapsed_us) {
+  size_t bucket = 0;
+  while (bucket < SMP_TIMING_BUCKETS - 1 && elapsed_us >= (1000ULL << bucket))
+    bucket++;
+
+  p_hist->histogram[bucket]++;
+  p_hist->count++;
+  p_hist->total_us += elapsed_us;
+  if (elapsed_us > p_hist->max_us) p_hist->max_us = elapsed_us;
+}
+
+static void smp_timing_hist_dump(int fd, const char* name,
+                                 const tSMP_TIMING_HIST* p_hist) {
+  if (p_hist->count == 0) return;
+
+  dprintf(fd, "      %-8s count: %u avg/max ms : %" PRIu64 " / %" PRIu64 "  ms:",
+          name, p_hist->count, p_hist->total_us / p_hist->count / 1000,
+          p_hist->max_us / 1000);
+  for (size_t i = 0; i < SMP_TIMING_BUCKETS; i++) {
+    if (p_hist->histogram[i] == 0) continue;
+    if (i == SMP_TIMING_BUCKETS - 1)
+      dprintf(fd, " >=%u:%u", 1u << (i - 1), p_hist->histogram[i]);
+    else
+      dprintf(fd, " <%u:%u", 1u << i, p_hist->histogram[i]);
+  }
+  dprintf(fd, "\n");
+}
+
+/* Returns the phase |state| belongs to. The application response state is
+ * part of the feature exchange until the pairing got any further. */
+static tSMP_PHASE smp_state_phase(tSMP_STATE state, tSMP_PHASE curr_phase) {
+  switch (state) {
+    case SMP_STATE_SEC_REQ_PENDING:
+    case SMP_STATE_PAIR_REQ_RSP:
+      return SMP_PHASE_FEATURE_EXCH;
+    case SMP_STATE_WAIT_APP_RSP:
+      if (curr_phase == SMP_PHASE_NONE || curr_phase == SMP_PHASE_FEATURE_EXCH)
+        return SMP_PHASE_FEATURE_EXCH;
+      return SMP_PHASE_AUTH;
+    case SMP_STATE_PUBLIC_KEY_EXCH:
+      return SMP_PHASE_PUBLIC_KEY_EXCH;
+    case SMP_STATE_WAIT_CONFIRM:
+    case SMP_STATE_CONFIRM:
+    case SMP_STATE_RAND:
+    case SMP_STATE_SEC_CONN_PHS1_START:
+    case SMP_STATE_WAIT_COMMITMENT:
+    case SMP_STATE_WAIT_NONCE:
+      return SMP_PHASE_AUTH;
+    case SMP_STATE_SEC_CONN_PHS2_START:
+    case SMP_STATE_WAIT_DHK_CHECK:
+    case SMP_STATE_DHK_CHECK:
+      return SMP_PHASE_DHKEY_CHECK;
+    case SMP_STATE_ENCRYPTION_PENDING:
+      return SMP_PHASE_ENCRYPTION;
+    case SMP_STATE_BOND_PENDING:
+      return SMP_PHASE_KEY_DIST;
+    default:
+      return SMP_PHASE_NONE;
+  }
+}
+
+/* Closes the phase in progress at |now_us| and opens |phase|. */
+static void smp_timing_enter_phase(tSMP_PAIRING_TIMING* p_timing,
+                                   tSMP_PHASE phase, uint64_t now_us) {
+  if (phase == p_timing->phase) return;
+
+  if (p_timing->phase != SMP_PHASE_NONE)
+    p_timing->phase_us[p_timing->phase] += now_us - p_timing->phase_start_us;
+
+  p_timing->phase = phase;
+  p_timing->phase_start_us = now_us;
+  if (phase != SMP_PHASE_NONE) p_timing->phase_mask |= 1 << phase;
+}
+
+static int32_t smp_us_to_ms(uint64_t us) {
+  return static_cast<int32_t>(us / 1000);
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_metrics_state_change
+ *
+ * Description      Called before the LE state machine moves to |state|. The
+ *                  first move out of idle starts timing the pairing.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void smp_metrics_state_change(tSMP_CB* p_cb, tSMP_STATE state) {
+  tSMP_PAIRING_TIMING* p_timing = &p_cb->timing;
+
+  if (state >= SMP_STATE_MAX || state == p_cb->state) return;
+
+  tSMP_PHASE phase = smp_state_phase(state, p_timing->phase);
+  if (p_timing->start_us == 0) {
+    if (phase == SMP_PHASE_NONE) return;
+    p_timing->start_us = time_get_os_boottime_us();
+    p_timing->phase = SMP_PHASE_NONE;
+    smp_timing_enter_phase(p_timing, phase, p_timing->start_us);
+    return;
+  }
+
+  smp_timing_enter_phase(p_timing, phase, time_get_os_boottime_us());
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_metrics_event
+ *
+ * Description      Called for each event the LE state machine handles. Counts
+ *                  the pairing random PDUs, one per confirm/random or
+ *                  commitment/nonce round trip.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void smp_metrics_event(tSMP_CB* p_cb, tSMP_EVENT event) {
+  if (p_cb->timing.start_us == 0) return;
+  if (event == SMP_RAND_EVT && p_cb->timing.round_trips < UINT8_MAX)
+    p_cb->timing.round_trips++;
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_metrics_dhkey
+ *
+ * Description      Called when the DHKey of the pairing was computed in
+ *                  |compute_us|.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void smp_metrics_dhkey(tSMP_CB* p_cb, uint64_t compute_us) {
+  if (p_cb->timing.start_us == 0) return;
+  p_cb->timing.dhkey_us += compute_us;
+}
+
+/*******************************************************************************
+ *
+ * Function         smp_metrics_pairing_cmpl
+ *
+ * Description      Called when the pairing completes, before the control block
+ *                  is reset. Adds the pairing to the statistics and the
+ *                  metrics log.
+ *
+ * Returns          void
+ *
+ ******************************************************************************/
+void smp_metrics_pairing_cmpl(tSMP_CB* p_cb) {
+  tSMP_PAIRING_TIMING* p_timing = &p_cb->timing;
+
+  if (p_timing->start_us == 0 || p_cb->smp_over_br) return;
+
+  uint64_t now_us = time_get_os_boottime_us();
+  smp_timing_enter_phase(p_timing, SMP_PHASE_NONE, now_us);
+  uint64_t total_us = now_us - p_timing->start_us;
+  bool sc = p_cb->le_secure_connections_mode_is_used;
+
+  SmpPairingMetrics metrics;
+  metrics.status = p_cb->status;
+  metrics.secure_connections = sc;
+  metrics.association_model = p_cb->selected_association_model;
+  metrics.authentication_round_trips = p_timing->round_trips;
+  metrics.total_ms = smp_us_to_ms(total_us);
+  if (sc) metrics.dhkey_computation_ms = smp_us_to_ms(p_timing->dhkey_us);
+
+  int32_t* phase_ms[SMP_PHASE_COUNT] = {
+      &metrics.feature_exchange_ms, &metrics.public_key_exchange_ms,
+      &metrics.authentication_ms,   &metrics.dhkey_check_ms,
+      &metrics.encryption_ms,       &metrics.key_distribution_ms};
+
+  {
+    std::lock_guard<std::mutex> lock(smp_timing_lock);
+    tSMP_TIMING_STATS* p_stats = &smp_timing_stats;
+
+    p_stats->pairings++;
+    if (p_cb->status != SMP_SUCCESS) p_stats->failures++;
+    p_stats->round_trips += p_timing->round_trips;
+    for (int i = 0; i < SMP_PHASE_COUNT; i++) {
+      if (!(p_timing->phase_mask & (1 << i))) continue;
+      smp_timing_hist_add(&p_stats->phase[i], p_timing->phase_us[i]);
+      *phase_ms[i] = smp_us_to_ms(p_timing->phase_us[i]);
+    }
+    if (sc && p_timing->dhkey_us)
+      smp_timing_hist_add(&p_stats->dhkey, p_timing->dhkey_us);
+    smp_timing_hist_add(&p_stats->total, total_us);
+  }
+
+  SMP_TRACE_DEBUG("%s: status=%d total=%" PRIu64 " us round trips=%d",
+                  __func__, p_cb->status, total_us, p_timing->round_trips);
+
+  BluetoothMetricsLogger::GetInstance()->LogSmpPairingEvent(
+      time_gettimeofday_us() / 1000, metrics);
+
+  memset(p_timing, 0, sizeof(tSMP_PAIRING_TIMING));
+}
+
+void SMP_DumpPairingStats(int fd) {
+  std::lock_guard<std::mutex> lock(smp_timing_lock);
+  const tSMP_TIMING_STATS* p_stats = &smp_timing_stats;
+
+  dprintf(fd, "\nLE Pairing Timing:\n");
+  dprintf(fd, "  Pairings: %u failed: %u\n", p_stats->pairings,
+          p_stats->failures);
+  if (p_stats->pairings == 0) return;
+
+  dprintf(fd, "  Random round trips per pairing: %u.%02u\n",
+          p_stats->round_trips / p_stats->pairings,
+          p_stats->round_trips * 100 / p_stats->pairings % 100);
+  for (int i = 0; i < SMP_PHASE_COUNT; i++)
+    smp_timing_hist_dump(fd, smp_phase_names[i], &p_stats->phase[i]);
+  smp_timing_hist_dump(fd, "dhkey", &p_stats->dhkey);
+  smp_timing_hist_dump(fd, "total", &p_stats->total);
+}
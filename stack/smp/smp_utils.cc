@@ -916,6 +916,11 @@ void smp_proc_pairing_cmpl(tSMP_CB* p_cb) {
 
   RawAddress pairing_bda = p_cb->pairing_bda;
 
+  if (p_cb->status != SMP_SUCCESS &&
+      (p_cb->flags & SMP_PAIR_FLAG_HAVE_LOCAL_PUBL_KEY))
+    smp_key_pool_discard(p_cb->private_key);
+
+  smp_metrics_pairing_cmpl(p_cb);
   smp_reset_control_value(p_cb);
 
   if (p_callback) (*p_callback)(SMP_COMPLT_EVT, pairing_bda, &evt_data);
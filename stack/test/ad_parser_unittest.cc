@@ -176,3 +176,65 @@ TEST(AdvertiseDataParserTest, RemoveTrailingZerosMalformed) {
 
   EXPECT_TRUE(AdvertiseDataParser::IsValid(glued));
 }
+
+TEST(AdvertiseDataParserTest, IndexMatchesParser) {
+  const std::vector<uint8_t> data{0x02, 0x01, 0x02, 0x03, 0x03, 0x12, 0x18,
+                                  0x02, 0x0A, 0x04, 0x03, 0x03, 0xAA, 0xBB,
+                                  0x01, 0x09, 0x00, 0x00};
+  AdvertiseDataIndex index(data);
+  EXPECT_TRUE(index.IsValid());
+  EXPECT_EQ(AdvertiseDataParser::IsValid(data), index.IsValid());
+
+  for (int type = 0; type < 256; type++) {
+    uint8_t parser_len, index_len;
+    const uint8_t* parser_field =
+        AdvertiseDataParser::GetFieldByType(data, type, &parser_len);
+    const uint8_t* index_field = index.GetFieldByType(type, &index_len);
+    EXPECT_EQ(parser_field, index_field) << "type " << type;
+    EXPECT_EQ(parser_len, index_len) << "type " << type;
+    EXPECT_EQ(parser_field != NULL, index.HasField(type)) << "type " << type;
+  }
+
+  // First field of a type wins.
+  uint8_t len;
+  const uint8_t* field = index.GetFieldByType(0x03, &len);
+  ASSERT_EQ(2, len);
+  EXPECT_EQ(0x12, field[0]);
+
+  // Empty field is present with zero length.
+  EXPECT_TRUE(index.HasField(0x09));
+  index.GetFieldByType(0x09, &len);
+  EXPECT_EQ(0, len);
+}
+
+TEST(AdvertiseDataParserTest, IndexIsValid) {
+  const std::vector<uint8_t> empty;
+  EXPECT_TRUE(AdvertiseDataIndex(empty).IsValid());
+
+  // Field length too long.
+  const std::vector<uint8_t> too_long{0x02, 0x02, 0x00, 0x02, 0x00};
+  AdvertiseDataIndex index(too_long);
+  EXPECT_FALSE(index.IsValid());
+  EXPECT_TRUE(index.HasField(0x02));
+
+  // Non-zero padding at end of packet.
+  const std::vector<uint8_t> bad_padding{0x02, 0x01, 0x02, 0x00, 0xBA};
+  EXPECT_FALSE(AdvertiseDataIndex(bad_padding).IsValid());
+
+  // Rebuilding re-indexes the new data.
+  const std::vector<uint8_t> good{0x02, 0x01, 0x02};
+  index.Build(good);
+  EXPECT_TRUE(index.IsValid());
+  EXPECT_FALSE(index.HasField(0x02));
+  EXPECT_TRUE(index.HasField(0x01));
+}
+
+TEST(AdvertiseDataParserTest, GetLengthWithoutTrailingZeros) {
+  const uint8_t data[] = {0x02, 0x01, 0x02, 0x00, 0xFF, 0x00};
+  EXPECT_EQ(3u, AdvertiseDataParser::GetLengthWithoutTrailingZeros(
+                    data, sizeof(data)));
+
+  const uint8_t no_padding[] = {0x02, 0x01, 0x02};
+  EXPECT_EQ(3u, AdvertiseDataParser::GetLengthWithoutTrailingZeros(
+                    no_padding, sizeof(no_padding)));
+}
@@ -63,6 +63,10 @@ void btm_gen_resolvable_private_addr(
     base::Callback<void(const RawAddress& rpa)> cb) {
   cb.Run(RawAddress::kEmpty);
 }
+void btm_iso_tx_big_created(uint8_t big_handle, uint32_t sdu_interval_us,
+                            uint16_t max_sdu,
+                            const std::vector<uint16_t>& bis_handles) {}
+void btm_iso_tx_big_terminated(uint8_t big_handle) {}
 void btsnd_hcic_ble_rand(base::Callback<void(BT_OCTET8)> cb){
     /* STUB */
 }
@@ -748,6 +752,65 @@ TEST_F(BleAdvertisingManagerTest, test_data_sender) {
   EXPECT_EQ(BTM_BLE_MULTI_ADV_SUCCESS, set_data_status);
 }
 
+/* This test makes sure that writing the same data again does not reach the
+ * controller, unless the previous write failed. */
+TEST_F(BleAdvertisingManagerTest, test_set_data_unchanged) {
+  std::vector<uint8_t> data{0x03, 0xFF, 0x01, 0x02};
+
+  BleAdvertisingManager::Get()->RegisterAdvertiser(
+      Bind(&BleAdvertisingManagerTest::RegistrationCb, base::Unretained(this)));
+  EXPECT_EQ(BTM_BLE_MULTI_ADV_SUCCESS, reg_status);
+  int advertiser_id = reg_inst_id;
+
+  status_cb set_data_cb;
+  EXPECT_CALL(*hci_mock, SetAdvertisingData(advertiser_id, _, _, _, _, _))
+      .Times(1)
+      .WillOnce(SaveArg<5>(&set_data_cb));
+  BleAdvertisingManager::Get()->SetData(
+      advertiser_id, false, data, std::vector<uint8_t>(),
+      Bind(&BleAdvertisingManagerTest::SetDataCb, base::Unretained(this)));
+  set_data_cb.Run(0x00);
+  ::testing::Mock::VerifyAndClearExpectations(hci_mock.get());
+  EXPECT_EQ(BTM_BLE_MULTI_ADV_SUCCESS, set_data_status);
+
+  // Same data again completes right away
+  set_data_status = -1;
+  EXPECT_CALL(*hci_mock, SetAdvertisingData(advertiser_id, _, _, _, _, _))
+      .Times(Exactly(0));
+  BleAdvertisingManager::Get()->SetData(
+      advertiser_id, false, data, std::vector<uint8_t>(),
+      Bind(&BleAdvertisingManagerTest::SetDataCb, base::Unretained(this)));
+  ::testing::Mock::VerifyAndClearExpectations(hci_mock.get());
+  EXPECT_EQ(BTM_BLE_MULTI_ADV_SUCCESS, set_data_status);
+
+  // Scan response is tracked on its own
+  EXPECT_CALL(*hci_mock, SetScanResponseData(advertiser_id, _, _, _, _, _))
+      .Times(1)
+      .WillOnce(SaveArg<5>(&set_data_cb));
+  BleAdvertisingManager::Get()->SetData(
+      advertiser_id, true, data, std::vector<uint8_t>(),
+      Bind(&BleAdvertisingManagerTest::SetDataCb, base::Unretained(this)));
+  set_data_cb.Run(0x00);
+  ::testing::Mock::VerifyAndClearExpectations(hci_mock.get());
+
+  // Changed data is written, a failed write is retried
+  data[3] = 0x03;
+  EXPECT_CALL(*hci_mock, SetAdvertisingData(advertiser_id, _, _, _, _, _))
+      .Times(2)
+      .WillRepeatedly(SaveArg<5>(&set_data_cb));
+  BleAdvertisingManager::Get()->SetData(
+      advertiser_id, false, data, std::vector<uint8_t>(),
+      Bind(&BleAdvertisingManagerTest::SetDataCb, base::Unretained(this)));
+  set_data_cb.Run(0x01);
+  EXPECT_EQ(0x01, set_data_status);
+  BleAdvertisingManager::Get()->SetData(
+      advertiser_id, false, data, std::vector<uint8_t>(),
+      Bind(&BleAdvertisingManagerTest::SetDataCb, base::Unretained(this)));
+  set_data_cb.Run(0x00);
+  ::testing::Mock::VerifyAndClearExpectations(hci_mock.get());
+  EXPECT_EQ(BTM_BLE_MULTI_ADV_SUCCESS, set_data_status);
+}
+
 /* This test makes sure that conectable advertisment with timeout will get it's
  * address updated once the timeout passes and one tries to enable it again.*/
 TEST_F(BleAdvertisingManagerTest,
@@ -0,0 +1,127 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "btm_conn_trace.h"
+
+static const RawAddress kPeer({0x00, 0x11, 0x22, 0x33, 0x44, 0x55});
+
+class BtmConnTraceTest : public ::testing::Test {
+ protected:
+  void SetUp() override { btm_conn_trace_reset(); }
+  void TearDown() override { btm_conn_trace_reset(); }
+
+  void mark(btm_conn_trace_milestone_t milestone, uint64_t ms) {
+    btm_conn_trace_mark_at(kPeer, BT_TRANSPORT_BR_EDR, milestone,
+                           1000000 + ms * 1000);
+  }
+
+  btm_conn_trace_t last() {
+    btm_conn_trace_t trace;
+    EXPECT_TRUE(btm_conn_trace_get_last(kPeer, &trace));
+    return trace;
+  }
+};
+
+TEST_F(BtmConnTraceTest, test_path_follows_latest_prerequisite) {
+  mark(BTM_CONN_TRACE_ACL_REQUESTED, 0);
+  mark(BTM_CONN_TRACE_ACL_CONNECTED, 100);
+  mark(BTM_CONN_TRACE_REMOTE_VERSION, 110);
+  mark(BTM_CONN_TRACE_REMOTE_FEATURES, 120);
+  mark(BTM_CONN_TRACE_SDP_STARTED, 130);
+  mark(BTM_CONN_TRACE_AUTHENTICATED, 150);
+  mark(BTM_CONN_TRACE_ENCRYPTED, 160);
+  mark(BTM_CONN_TRACE_L2CAP_CONFIGURED, 180);
+  // SDP finishes last, so it gates the profile rather than the channel
+  mark(BTM_CONN_TRACE_SDP_COMPLETE, 700);
+  mark(BTM_CONN_TRACE_PROFILE_CONNECTED, 720);
+  btm_conn_trace_disconnected(kPeer, BT_TRANSPORT_BR_EDR);
+
+  btm_conn_trace_t trace = last();
+  EXPECT_FALSE(trace.complete);
+  ASSERT_EQ(5, trace.path_length);
+  EXPECT_EQ(BTM_CONN_TRACE_ACL_REQUESTED, trace.path[0]);
+  EXPECT_EQ(BTM_CONN_TRACE_ACL_CONNECTED, trace.path[1]);
+  EXPECT_EQ(BTM_CONN_TRACE_SDP_STARTED, trace.path[2]);
+  EXPECT_EQ(BTM_CONN_TRACE_SDP_COMPLETE, trace.path[3]);
+  EXPECT_EQ(BTM_CONN_TRACE_PROFILE_CONNECTED, trace.path[4]);
+  EXPECT_EQ(720000u, trace.total_us);
+  EXPECT_EQ(BTM_CONN_TRACE_SDP_COMPLETE, trace.longest);
+  EXPECT_EQ(570000u, trace.longest_us);
+}
+
+TEST_F(BtmConnTraceTest, test_skips_unreached_prerequisites) {
+  // An incoming link, already encrypted by the time the features are in
+  mark(BTM_CONN_TRACE_ACL_CONNECTED, 0);
+  mark(BTM_CONN_TRACE_REMOTE_FEATURES, 20);
+  mark(BTM_CONN_TRACE_L2CAP_CONFIGURED, 300);
+  btm_conn_trace_disconnected(kPeer, BT_TRANSPORT_BR_EDR);
+
+  btm_conn_trace_t trace = last();
+  ASSERT_EQ(3, trace.path_length);
+  EXPECT_EQ(BTM_CONN_TRACE_ACL_CONNECTED, trace.path[0]);
+  EXPECT_EQ(BTM_CONN_TRACE_REMOTE_FEATURES, trace.path[1]);
+  EXPECT_EQ(BTM_CONN_TRACE_L2CAP_CONFIGURED, trace.path[2]);
+  EXPECT_EQ(BTM_CONN_TRACE_L2CAP_CONFIGURED, trace.longest);
+}
+
+TEST_F(BtmConnTraceTest, test_profile_closes_trace) {
+  btm_conn_trace_mark(kPeer, BT_TRANSPORT_BR_EDR,
+                      BTM_CONN_TRACE_ACL_CONNECTED);
+  btm_conn_trace_profile_connected(kPeer, BT_TRANSPORT_BR_EDR, "A2DP");
+
+  btm_conn_trace_t trace = last();
+  EXPECT_TRUE(trace.complete);
+  EXPECT_STREQ("A2DP", trace.profile);
+  EXPECT_EQ(2, trace.path_length);
+
+  // Later marks and profiles have no open trace to go to
+  btm_conn_trace_mark(kPeer, BT_TRANSPORT_BR_EDR,
+                      BTM_CONN_TRACE_L2CAP_CONFIGURED);
+  btm_conn_trace_profile_connected(kPeer, BT_TRANSPORT_BR_EDR, "HFP");
+  EXPECT_STREQ("A2DP", last().profile);
+}
+
+TEST_F(BtmConnTraceTest, test_first_mark_counts) {
+  mark(BTM_CONN_TRACE_ACL_REQUESTED, 0);
+  mark(BTM_CONN_TRACE_ACL_REQUESTED, 50);
+  mark(BTM_CONN_TRACE_ACL_CONNECTED, 80);
+  btm_conn_trace_disconnected(kPeer, BT_TRANSPORT_BR_EDR);
+  EXPECT_EQ(80000u, last().total_us);
+}
+
+TEST_F(BtmConnTraceTest, test_ignores_links_not_seen_coming_up) {
+  mark(BTM_CONN_TRACE_ENCRYPTED, 10);
+  btm_conn_trace_disconnected(kPeer, BT_TRANSPORT_BR_EDR);
+  btm_conn_trace_t trace;
+  EXPECT_FALSE(btm_conn_trace_get_last(kPeer, &trace));
+}
+
+TEST_F(BtmConnTraceTest, test_transports_are_traced_apart) {
+  mark(BTM_CONN_TRACE_ACL_CONNECTED, 0);
+  btm_conn_trace_mark_at(kPeer, BT_TRANSPORT_LE, BTM_CONN_TRACE_ACL_CONNECTED,
+                         1000000 + 5000);
+  btm_conn_trace_mark_at(kPeer, BT_TRANSPORT_LE, BTM_CONN_TRACE_ENCRYPTED,
+                         1000000 + 40000);
+  btm_conn_trace_disconnected(kPeer, BT_TRANSPORT_LE);
+
+  btm_conn_trace_t trace = last();
+  EXPECT_EQ(BT_TRANSPORT_LE, trace.transport);
+  EXPECT_EQ(35000u, trace.total_us);
+}
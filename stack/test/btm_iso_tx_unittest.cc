@@ -0,0 +1,228 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <base/bind.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "btm_iso_tx.h"
+#include "device/include/controller.h"
+#include "osi/include/alarm.h"
+#include "osi/include/allocator.h"
+
+static const uint8_t kBigHandle = 1;
+static const uint32_t kSduIntervalUs = 10000;
+static const uint16_t kMaxSdu = 120;
+
+/* Below are methods that must be implemented if we don't want to compile the
+ * whole stack. */
+static uint64_t now_us;
+uint64_t time_get_os_boottime_us(void) { return now_us; }
+
+static alarm_callback_t timer_cb;
+static void* timer_data;
+static period_ms_t timer_delay_ms;
+static bool timer_armed;
+alarm_t* alarm_new(const char* name) { return (alarm_t*)&timer_cb; }
+void* alarm_free(alarm_t* alarm) { return NULL; }
+void alarm_set_on_mloop(alarm_t* alarm, period_ms_t interval_ms,
+                        alarm_callback_t cb, void* data) {
+  timer_cb = cb;
+  timer_data = data;
+  timer_delay_ms = interval_ms;
+  timer_armed = true;
+}
+
+static uint16_t iso_data_packet_len = 251;
+static uint16_t get_ble_iso_data_packet_len(void) {
+  return iso_data_packet_len;
+}
+static uint8_t get_ble_iso_num_data_packets(void) { return 2; }
+static controller_t controller;
+const controller_t* controller_get_interface() {
+  controller.get_ble_iso_data_packet_len = get_ble_iso_data_packet_len;
+  controller.get_ble_iso_num_data_packets = get_ble_iso_num_data_packets;
+  return &controller;
+}
+
+static std::vector<std::vector<uint8_t>> sent;
+void bte_main_hci_send(BT_HDR* p_msg, uint16_t event) {
+  const uint8_t* p = (uint8_t*)(p_msg + 1) + p_msg->offset;
+  sent.emplace_back(p, p + p_msg->len);
+  osi_free(p_msg);
+}
+
+static base::Callback<void(uint8_t*, uint16_t)> sync_cb;
+void btsnd_hcic_ble_read_iso_tx_sync(
+    uint16_t conn_handle, base::Callback<void(uint8_t*, uint16_t)> cb) {
+  sync_cb = std::move(cb);
+}
+
+static uint16_t le16(const std::vector<uint8_t>& packet, size_t pos) {
+  return packet[pos] | (packet[pos + 1] << 8);
+}
+
+class BtmIsoTxTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    now_us = 1000000;
+    timer_armed = false;
+    sent.clear();
+    btm_iso_tx_big_created(kBigHandle, kSduIntervalUs, kMaxSdu,
+                           {0x0010, 0x0011});
+  }
+
+  void TearDown() override {
+    btm_iso_tx_big_terminated(kBigHandle);
+    sync_cb = base::Callback<void(uint8_t*, uint16_t)>();
+  }
+
+  void write(uint16_t handle, uint16_t len) {
+    BT_HDR* p_buf = btm_iso_tx_get_buf(handle);
+    ASSERT_NE(nullptr, p_buf);
+    memset((uint8_t*)(p_buf + 1) + p_buf->offset, 0xa5, len);
+    p_buf->len = len;
+    EXPECT_TRUE(btm_iso_tx_write(handle, p_buf));
+  }
+
+  // Runs the interval timer at the time it was armed for, plus |late_us|.
+  void fire(uint64_t late_us = 0) {
+    ASSERT_TRUE(timer_armed);
+    timer_armed = false;
+    now_us += timer_delay_ms * 1000 + late_us;
+    timer_cb(timer_data);
+  }
+
+  tBTM_ISO_TX_STATS stats(uint16_t handle) {
+    tBTM_ISO_TX_STATS stats;
+    EXPECT_TRUE(btm_iso_tx_get_stats(handle, &stats));
+    return stats;
+  }
+};
+
+TEST_F(BtmIsoTxTest, test_all_bises_sent_on_their_interval) {
+  write(0x0010, 100);
+  write(0x0011, 100);
+  EXPECT_TRUE(sent.empty());
+  EXPECT_EQ(10u, timer_delay_ms);
+
+  fire();
+  ASSERT_EQ(2u, sent.size());
+  const std::vector<uint8_t>& packet = sent[0];
+  EXPECT_EQ(0x2010, le16(packet, 0));  // complete SDU, no timestamp
+  EXPECT_EQ(104, le16(packet, 2));
+  EXPECT_EQ(1, le16(packet, 4));  // the first interval after creation
+  EXPECT_EQ(100, le16(packet, 6));
+  EXPECT_EQ(108u, packet.size());
+  EXPECT_EQ(0x2011, le16(sent[1], 0));
+  EXPECT_FALSE(timer_armed);
+}
+
+TEST_F(BtmIsoTxTest, test_waits_for_controller_buffers) {
+  write(0x0010, 100);
+  write(0x0010, 100);
+  write(0x0011, 100);
+  fire();
+  ASSERT_EQ(2u, sent.size());
+
+  // Both controller buffers are taken, the second SDU of 0x0010 waits
+  fire();
+  EXPECT_EQ(2u, sent.size());
+  EXPECT_EQ(1u, stats(0x0010).credit_waits);
+
+  EXPECT_TRUE(btm_iso_tx_packets_completed(0x0010, 1));
+  btm_iso_tx_service();
+  ASSERT_EQ(3u, sent.size());
+  EXPECT_EQ(2, le16(sent[2], 4));
+  EXPECT_FALSE(btm_iso_tx_packets_completed(0x0020, 1));
+}
+
+TEST_F(BtmIsoTxTest, test_late_sdus_are_dropped) {
+  write(0x0010, 100);
+  write(0x0010, 100);
+  // The timer runs more than an interval late
+  fire(kSduIntervalUs + 500);
+  ASSERT_EQ(1u, sent.size());
+  EXPECT_EQ(2, le16(sent[0], 4));
+
+  tBTM_ISO_TX_STATS bis_stats = stats(0x0010);
+  EXPECT_EQ(1u, bis_stats.late_drops);
+  EXPECT_EQ(1u, bis_stats.sdus_sent);
+  EXPECT_EQ(kSduIntervalUs + 500, bis_stats.max_tick_lateness_us);
+}
+
+TEST_F(BtmIsoTxTest, test_producer_behind_resyncs) {
+  write(0x0010, 100);
+  fire();
+  now_us += 5 * kSduIntervalUs;
+  write(0x0010, 100);
+  fire();
+  ASSERT_EQ(2u, sent.size());
+  EXPECT_EQ(7, le16(sent[1], 4));
+  EXPECT_EQ(1u, stats(0x0010).underruns);
+}
+
+TEST_F(BtmIsoTxTest, test_timestamps_follow_transmit_sync) {
+  write(0x0010, 100);
+  fire();
+  btm_iso_tx_packets_completed(0x0010, 1);
+
+  // Interval 1 was sent at controller time 50000
+  uint8_t rsp[] = {0x00, 0x10, 0x00, 0x01, 0x00, 0x50, 0xc3, 0x00, 0x00,
+                   0x00, 0x00, 0x00};
+  sync_cb.Run(rsp, sizeof(rsp));
+
+  write(0x0010, 100);
+  fire();
+  ASSERT_EQ(2u, sent.size());
+  const std::vector<uint8_t>& packet = sent[1];
+  EXPECT_EQ(0x6010, le16(packet, 0));
+  EXPECT_EQ(108, le16(packet, 2));
+  uint32_t time_stamp = le16(packet, 4) | (le16(packet, 6) << 16);
+  EXPECT_EQ(50000u + kSduIntervalUs, time_stamp);
+  EXPECT_EQ(2, le16(packet, 8));
+}
+
+TEST_F(BtmIsoTxTest, test_large_sdu_is_fragmented) {
+  iso_data_packet_len = 60;
+  write(0x0010, 100);
+  fire();
+  iso_data_packet_len = 251;
+
+  ASSERT_EQ(2u, sent.size());
+  EXPECT_EQ(0x0010, le16(sent[0], 0));  // first fragment
+  EXPECT_EQ(60, le16(sent[0], 2));
+  EXPECT_EQ(100, le16(sent[0], 6));
+  EXPECT_EQ(0x3010, le16(sent[1], 0));  // last fragment
+  EXPECT_EQ(44, le16(sent[1], 2));
+  EXPECT_EQ(48u, sent[1].size());
+}
+
+TEST_F(BtmIsoTxTest, test_queue_overflow_and_oversized_sdus) {
+  for (int i = 0; i < 8; i++) write(0x0010, 10);
+  BT_HDR* p_buf = btm_iso_tx_get_buf(0x0010);
+  p_buf->len = 10;
+  EXPECT_FALSE(btm_iso_tx_write(0x0010, p_buf));
+  EXPECT_EQ(1u, stats(0x0010).overflows);
+
+  p_buf = btm_iso_tx_get_buf(0x0011);
+  p_buf->len = kMaxSdu + 1;
+  EXPECT_FALSE(btm_iso_tx_write(0x0011, p_buf));
+  EXPECT_EQ(nullptr, btm_iso_tx_get_buf(0x0020));
+}
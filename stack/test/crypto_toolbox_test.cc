@@ -20,6 +20,7 @@
 #include <gtest/gtest.h>
 
 #include "stack/crypto_toolbox/aes.h"
+#include "stack/crypto_toolbox/aes_hw.h"
 #include "stack/crypto_toolbox/crypto_toolbox.h"
 
 #include <base/logging.h>
@@ -397,4 +398,81 @@ TEST(CryptoToolboxTest, bt_spec_example_d_12_test) {
   EXPECT_EQ(expected_ltk, ltk);
 }
 
+// The expanded key schedule must give the same result as expanding the key
+// on every call, for every message encrypted with it.
+TEST(CryptoToolboxTest, aes_128_expanded_key_test) {
+  Octet16 key{0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+              0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+
+  aes_context ctx;
+  aes_128_set_key(key, &ctx);
+
+  for (uint8_t i = 0; i < 16; i++) {
+    Octet16 message{0};
+    message[0] = i;
+    message[15] = 0xff - i;
+    EXPECT_EQ(aes_128(key, message), aes_128(ctx, message));
+  }
+
+  uint8_t prand[] = {0x94, 0x81, 0x70};
+  EXPECT_EQ(aes_128(key, prand, sizeof(prand)),
+            aes_128(ctx, prand, sizeof(prand)));
+}
+
+// The AES instructions must give the same result as the software AES
+TEST(CryptoToolboxTest, aes_hw_encrypt_test) {
+  if (!aes_hw_supported()) return;
+
+  uint8_t key[OCTET16_LEN];
+  uint8_t block[OCTET16_LEN];
+  for (int i = 0; i < OCTET16_LEN; i++) {
+    key[i] = i * 17 + 3;
+    block[i] = 0xff - i * 5;
+  }
+
+  aes_context ctx;
+  aes_set_key(key, sizeof(key), &ctx);
+  for (int n = 0; n < 64; n++) {
+    uint8_t sw[OCTET16_LEN];
+    uint8_t hw[OCTET16_LEN];
+    aes_encrypt(block, sw, &ctx);
+    aes_hw_encrypt(block, hw, ctx);
+    EXPECT_THAT(hw, ElementsAreArray(sw, OCTET16_LEN));
+    memcpy(block, sw, OCTET16_LEN);
+  }
+}
+
+// The CMAC key schedule must give the same signature as the key, for
+// messages of every length and block alignment.
+TEST(CryptoToolboxTest, aes_cmac_expanded_key_test) {
+  Octet16 key{0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+              0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c};
+  std::reverse(std::begin(key), std::end(key));
+
+  cmac_context ctx;
+  aes_cmac_set_key(key, &ctx);
+
+  std::vector<uint8_t> message(80);
+  for (size_t i = 0; i < message.size(); i++) message[i] = i * 7;
+
+  for (uint16_t len = 0; len <= message.size(); len++) {
+    EXPECT_EQ(aes_cmac(key, message.data(), len),
+              aes_cmac(ctx, message.data(), len));
+  }
+
+  // BT Spec 5.0 | Vol 3, Part H D.1.4, with a cached key
+  Octet16 expected{0x51, 0xf0, 0xbe, 0xbf, 0x7e, 0x3b, 0x9d, 0x92,
+                   0xfc, 0x49, 0x74, 0x17, 0x79, 0x36, 0x3c, 0xfe};
+  std::reverse(std::begin(expected), std::end(expected));
+  uint8_t m[] = {0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96, 0xe9, 0x3d,
+                 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a, 0xae, 0x2d, 0x8a, 0x57,
+                 0x1e, 0x03, 0xac, 0x9c, 0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf,
+                 0x8e, 0x51, 0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11,
+                 0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef, 0xf6, 0x9f,
+                 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17, 0xad, 0x2b, 0x41, 0x7b,
+                 0xe6, 0x6c, 0x37, 0x10};
+  std::reverse(std::begin(m), std::end(m));
+  EXPECT_EQ(expected, aes_cmac(ctx, m, sizeof(m)));
+}
+
 }  // namespace crypto_toolbox
@@ -0,0 +1,154 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "hci_event_view.h"
+
+static_assert(HciLeConnectionUpdateTimeout::end == 9,
+              "LE Connection Update Complete is 9 octets");
+static_assert(HciLeExtAdvReportView::kHeaderSize == 24,
+              "an extended advertising report header is 24 octets");
+
+TEST(HciEventViewTest, DisconnectionComplete) {
+  const std::vector<uint8_t> event{0x00, 0x42, 0x20, 0x13};
+  HciDisconnectionCompleteView view(event.data(), event.size());
+  ASSERT_TRUE(view.IsValid());
+  EXPECT_EQ(0x00, view.status());
+  EXPECT_EQ(0x2042, view.handle());
+  EXPECT_EQ(0x13, view.reason());
+
+  EXPECT_FALSE(
+      HciDisconnectionCompleteView(event.data(), event.size() - 1).IsValid());
+}
+
+TEST(HciEventViewTest, LeConnectionUpdateComplete) {
+  const std::vector<uint8_t> event{0x00, 0x01, 0x00, 0x28, 0x00,
+                                   0x02, 0x00, 0xf4, 0x01};
+  HciLeConnectionUpdateCompleteView view(event.data(), event.size());
+  ASSERT_TRUE(view.IsValid());
+  EXPECT_EQ(0x0001, view.handle());
+  EXPECT_EQ(0x0028, view.interval());
+  EXPECT_EQ(0x0002, view.latency());
+  EXPECT_EQ(0x01f4, view.timeout());
+}
+
+TEST(HciEventViewTest, NumCompletedPackets) {
+  const std::vector<uint8_t> event{0x02, 0x01, 0x00, 0x03,
+                                   0x00, 0x02, 0x10, 0x01, 0x00};
+  HciNumCompletedPacketsView view(event.data(), event.size());
+  ASSERT_EQ(2u, view.num_handles());
+  EXPECT_EQ(0x0001, view.handle(0));
+  EXPECT_EQ(3, view.num_packets(0));
+  EXPECT_EQ(0x1002, view.handle(1));
+  EXPECT_EQ(1, view.num_packets(1));
+}
+
+TEST(HciEventViewTest, NumCompletedPacketsTruncated) {
+  // Announces three handles but only has room for one and a half
+  const std::vector<uint8_t> event{0x03, 0x01, 0x00, 0x03, 0x00, 0x02, 0x10};
+  HciNumCompletedPacketsView view(event.data(), event.size());
+  EXPECT_EQ(3u, view.announced_handles());
+  EXPECT_EQ(1u, view.num_handles());
+
+  EXPECT_EQ(0u, HciNumCompletedPacketsView(event.data(), 0).num_handles());
+}
+
+TEST(HciEventViewTest, LeAdvertisingReport) {
+  const std::vector<uint8_t> event{
+      0x02,                                            // two reports
+      0x00, 0x01, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01,  // ADV_IND, random
+      0x03, 0x02, 0x01, 0x06, 0xc4,                    // data, rssi
+      0x04, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06,  // SCAN_RSP, public
+      0x00, 0xb0};                                     // no data, rssi
+  HciLeAdvertisingReportView view(event.data(), event.size());
+  HciLeAdvReportView report;
+
+  ASSERT_TRUE(view.Next(&report));
+  EXPECT_EQ(0x00, report.event_type());
+  EXPECT_EQ(0x01, report.address_type());
+  EXPECT_EQ(RawAddress({0x01, 0x02, 0x03, 0x04, 0x05, 0x06}),
+            report.address());
+  ASSERT_EQ(3, report.data_length());
+  EXPECT_EQ(0x06, report.adv_data()[2]);
+  EXPECT_EQ(-60, report.rssi());
+
+  ASSERT_TRUE(view.Next(&report));
+  EXPECT_EQ(0x04, report.event_type());
+  EXPECT_EQ(0, report.data_length());
+  EXPECT_EQ(-80, report.rssi());
+
+  EXPECT_FALSE(view.Next(&report));
+  EXPECT_FALSE(view.malformed());
+}
+
+TEST(HciEventViewTest, LeAdvertisingReportMalformed) {
+  // The data length runs past the end of the event
+  const std::vector<uint8_t> event{0x01, 0x00, 0x00, 0x01, 0x02, 0x03,
+                                   0x04, 0x05, 0x06, 0x1f, 0x02, 0x01};
+  HciLeAdvertisingReportView view(event.data(), event.size());
+  HciLeAdvReportView report;
+  EXPECT_FALSE(view.Next(&report));
+  EXPECT_TRUE(view.malformed());
+
+  // Announces more reports than it has
+  const std::vector<uint8_t> short_event{0x02, 0x00, 0x00, 0x01, 0x02,
+                                         0x03, 0x04, 0x05, 0x06, 0x00,
+                                         0xc4};
+  HciLeAdvertisingReportView short_view(short_event.data(),
+                                        short_event.size());
+  EXPECT_TRUE(short_view.Next(&report));
+  EXPECT_FALSE(short_view.Next(&report));
+  EXPECT_TRUE(short_view.malformed());
+}
+
+TEST(HciEventViewTest, LeExtendedAdvertisingReport) {
+  std::vector<uint8_t> event{
+      0x01,                                // one report
+      0x13, 0x00,                          // connectable scannable legacy
+      0x00,                                // public
+      0x01, 0x02, 0x03, 0x04, 0x05, 0x06,  // address
+      0x01, 0x00, 0xff,                    // 1M, none, no ADI
+      0x7f, 0xc4,                          // no tx power, rssi
+      0x00, 0x00,                          // no periodic advertising
+      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // no direct address
+      0x02, 0x01, 0x06};                         // data
+  HciLeExtAdvertisingReportView view(event.data(), event.size());
+  HciLeExtAdvReportView report;
+
+  ASSERT_TRUE(view.Next(&report));
+  EXPECT_EQ(0x0013, report.event_type());
+  EXPECT_EQ(RawAddress({0x06, 0x05, 0x04, 0x03, 0x02, 0x01}),
+            report.address());
+  EXPECT_EQ(0x01, report.primary_phy());
+  EXPECT_EQ(0x00, report.secondary_phy());
+  EXPECT_EQ(0xff, report.advertising_sid());
+  EXPECT_EQ(127, report.tx_power());
+  EXPECT_EQ(-60, report.rssi());
+  ASSERT_EQ(2, report.data_length());
+  EXPECT_EQ(0x06, report.adv_data()[1]);
+  EXPECT_FALSE(view.Next(&report));
+  EXPECT_FALSE(view.malformed());
+
+  event.pop_back();
+  HciLeExtAdvertisingReportView truncated(event.data(), event.size());
+  EXPECT_FALSE(truncated.Next(&report));
+  EXPECT_TRUE(truncated.malformed());
+}
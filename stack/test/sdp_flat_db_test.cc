@@ -0,0 +1,116 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+#include <vector>
+
+#include "osi/include/allocator.h"
+#include "stack/include/sdp_flat_db.h"
+
+using bluetooth::Uuid;
+
+namespace {
+
+// Two records: an A2DP sink with its attributes out of order, and a record
+// whose 128 bit service class UUID sits in a nested sequence.
+const std::vector<uint8_t> kLists = {
+    0x35, 0x32,  // Sequence of attribute lists
+    0x35, 0x10,  // Record 0
+    0x09, 0x00, 0x04,  // Protocol descriptor list
+    0x35, 0x03, 0x19, 0x01, 0x00,  // L2CAP
+    0x09, 0x00, 0x01,  // Service class ID list
+    0x35, 0x03, 0x19, 0x11, 0x0b,  // Audio sink
+    0x35, 0x1e,  // Record 1
+    0x09, 0x00, 0x01,  // Service class ID list
+    0x35, 0x13, 0x35, 0x11, 0x1c, 0x00, 0x00, 0x11, 0x0b, 0x00, 0x00, 0x10,
+    0x00, 0x80, 0x00, 0x00, 0x80, 0x5f, 0x9b, 0x34, 0xfb,  // Audio sink
+    0x09, 0x01, 0x00,  // Service name
+    0x25, 0x01, 'A',
+};
+
+}  // namespace
+
+TEST(SdpFlatDbTest, test_find_service_and_attribute) {
+  tSDP_FLAT_DB* p_db = SDP_FlatDbBuild(kLists.data(), kLists.size());
+  ASSERT_NE(nullptr, p_db);
+  EXPECT_EQ(2, p_db->num_recs);
+  EXPECT_EQ(4, p_db->num_attrs);
+
+  Uuid sink = Uuid::From16Bit(0x110b);
+  EXPECT_EQ(0, SDP_FlatDbFindService(p_db, sink, -1));
+  EXPECT_EQ(1, SDP_FlatDbFindService(p_db, sink, 0));
+  EXPECT_EQ(-1, SDP_FlatDbFindService(p_db, sink, 1));
+  EXPECT_EQ(-1, SDP_FlatDbFindService(p_db, Uuid::From16Bit(0x110a), -1));
+
+  const uint8_t* p_value;
+  uint16_t len;
+  ASSERT_TRUE(SDP_FlatDbFindAttribute(p_db, 0, 0x0004, &p_value, &len));
+  EXPECT_EQ(5, len);
+  EXPECT_EQ(0, memcmp(p_value, &kLists[7], len));
+  ASSERT_TRUE(SDP_FlatDbFindAttribute(p_db, 1, 0x0100, &p_value, &len));
+  EXPECT_EQ(3, len);
+  EXPECT_EQ('A', p_value[2]);
+  EXPECT_FALSE(SDP_FlatDbFindAttribute(p_db, 0, 0x0100, &p_value, &len));
+  EXPECT_FALSE(SDP_FlatDbFindAttribute(p_db, 2, 0x0001, &p_value, &len));
+  osi_free(p_db);
+}
+
+TEST(SdpFlatDbTest, test_copy_and_rebuild_lists) {
+  tSDP_FLAT_DB* p_db = SDP_FlatDbBuild(kLists.data(), kLists.size());
+  ASSERT_NE(nullptr, p_db);
+
+  // A copy of the bytes is a database of its own
+  uint32_t size = SDP_FlatDbSize(p_db);
+  std::vector<uint8_t> copy((const uint8_t*)p_db, (const uint8_t*)p_db + size);
+  osi_free(p_db);
+  ASSERT_TRUE(SDP_FlatDbIsValid(copy.data(), copy.size()));
+  EXPECT_FALSE(SDP_FlatDbIsValid(copy.data(), copy.size() - 1));
+
+  const tSDP_FLAT_DB* p_copy = (const tSDP_FLAT_DB*)copy.data();
+  EXPECT_EQ(1, SDP_FlatDbFindService(p_copy, Uuid::From16Bit(0x110b), 0));
+
+  std::vector<uint8_t> lists(kLists.size());
+  EXPECT_EQ(0, SDP_FlatDbWriteLists(p_copy, lists.data(), lists.size() - 1));
+  EXPECT_EQ(kLists.size(),
+            SDP_FlatDbWriteLists(p_copy, lists.data(), lists.size()));
+  EXPECT_EQ(kLists, lists);
+
+  // Corrupt offsets are caught before use
+  tSDP_FLAT_REC* p_rec = (tSDP_FLAT_REC*)(copy.data() + sizeof(tSDP_FLAT_DB));
+  p_rec->len = 0xffff;
+  EXPECT_FALSE(SDP_FlatDbIsValid(copy.data(), copy.size()));
+}
+
+TEST(SdpFlatDbTest, test_reject_malformed_lists) {
+  std::vector<uint8_t> lists = kLists;
+
+  // Truncated
+  EXPECT_EQ(nullptr, SDP_FlatDbBuild(lists.data(), lists.size() - 1));
+
+  // Attribute ID that is not a 16 bit unsigned integer
+  lists[4] = 0x0a;
+  EXPECT_EQ(nullptr, SDP_FlatDbBuild(lists.data(), lists.size()));
+
+  // Value running past its record
+  lists = kLists;
+  lists[8] = 0x0f;
+  EXPECT_EQ(nullptr, SDP_FlatDbBuild(lists.data(), lists.size()));
+}
@@ -18,6 +18,7 @@
 
 #include <dlfcn.h>
 
+#include <algorithm>
 #include <set>
 #include <vector>
 
@@ -26,6 +27,7 @@
 #include "stack/include/a2dp_aac.h"
 #include "stack/include/a2dp_api.h"
 #include "stack/include/a2dp_codec_api.h"
+#include "stack/include/a2dp_resampler.h"
 #include "stack/include/a2dp_sbc.h"
 #include "stack/include/a2dp_vendor.h"
 namespace {
@@ -849,6 +851,32 @@ TEST_F(A2dpCodecConfigTest, createCodec) {
   }
 }
 
+TEST_F(A2dpCodecConfigTest, createCodecAfterLoadingLibraries) {
+  A2DP_LoadCodecLibraries();
+
+  for (int i = BTAV_A2DP_CODEC_INDEX_MIN; i < BTAV_A2DP_CODEC_INDEX_MAX; i++) {
+    btav_a2dp_codec_index_t codec_index =
+        static_cast<btav_a2dp_codec_index_t>(i);
+
+    // Ignore codecs that are not supported on the device
+    if (!has_codec_support(codec_index)) {
+      continue;
+    }
+
+    A2dpCodecConfig* codec_config = A2dpCodecConfig::createCodec(codec_index);
+    EXPECT_NE(codec_config, nullptr);
+    EXPECT_EQ(codec_config->codecIndex(), codec_index);
+    delete codec_config;
+  }
+
+  // Loading again waits for the previous loads and keeps the codecs usable
+  A2DP_LoadCodecLibraries();
+  A2dpCodecConfig* codec_config =
+      A2dpCodecConfig::createCodec(BTAV_A2DP_CODEC_INDEX_SOURCE_SBC);
+  EXPECT_NE(codec_config, nullptr);
+  delete codec_config;
+}
+
 TEST_F(A2dpCodecConfigTest, setCodecConfig) {
   uint8_t codec_info_result[AVDT_CODEC_SIZE];
   btav_a2dp_codec_index_t peer_codec_index;
@@ -934,6 +962,60 @@ TEST_F(A2dpCodecConfigTest, setCodecConfig) {
   delete a2dp_codecs;
 }
 
+TEST_F(A2dpCodecConfigTest, setCodecConfigReusesNegotiation) {
+  uint8_t codec_info_result[AVDT_CODEC_SIZE];
+  uint8_t codec_info_result2[AVDT_CODEC_SIZE];
+  btav_a2dp_codec_config_t codec_config;
+  std::vector<btav_a2dp_codec_config_t> local_capabilities;
+  std::vector<btav_a2dp_codec_config_t> selectable_capabilities;
+  std::vector<btav_a2dp_codec_config_t> selectable_capabilities2;
+  std::vector<btav_a2dp_codec_config_t> default_priorities;
+  A2dpCodecs a2dp_codecs(default_priorities);
+
+  EXPECT_TRUE(a2dp_codecs.init());
+
+  // Negotiating twice with the same peer capability gives the same result
+  memset(codec_info_result, 0, sizeof(codec_info_result));
+  memset(codec_info_result2, 0, sizeof(codec_info_result2));
+  EXPECT_TRUE(a2dp_codecs.setCodecConfig(
+      codec_info_sbc_sink_capability, true /* is_capability */,
+      codec_info_result, true /* select_current_codec */));
+  EXPECT_TRUE(a2dp_codecs.setCodecConfig(
+      codec_info_sbc_sink_capability, true /* is_capability */,
+      codec_info_result2, true /* select_current_codec */));
+  EXPECT_EQ(0, memcmp(codec_info_result, codec_info_result2,
+                      sizeof(codec_info_result)));
+  for (size_t i = 0; i < codec_info_sbc[0] + 1; i++) {
+    EXPECT_EQ(codec_info_result2[i], codec_info_sbc[i]);
+  }
+
+  // Only SBC has been negotiated, so only SBC is selectable
+  EXPECT_TRUE(a2dp_codecs.getCodecConfigAndCapabilities(
+      &codec_config, &local_capabilities, &selectable_capabilities));
+  ASSERT_EQ(1u, selectable_capabilities.size());
+  EXPECT_EQ(BTAV_A2DP_CODEC_INDEX_SOURCE_SBC,
+            selectable_capabilities[0].codec_type);
+  EXPECT_EQ(a2dp_codecs.orderedSourceCodecs().size(),
+            local_capabilities.size());
+
+  // A repeated query gives the same answer
+  EXPECT_TRUE(a2dp_codecs.getCodecConfigAndCapabilities(
+      &codec_config, &local_capabilities, &selectable_capabilities2));
+  ASSERT_EQ(selectable_capabilities.size(), selectable_capabilities2.size());
+  EXPECT_EQ(selectable_capabilities[0].sample_rate,
+            selectable_capabilities2[0].sample_rate);
+
+  // Negotiating another codec is seen by the next query
+  memset(codec_info_result, 0, sizeof(codec_info_result));
+  EXPECT_TRUE(a2dp_codecs.setCodecConfig(
+      codec_info_aac_sink_capability, true /* is_capability */,
+      codec_info_result, false /* select_current_codec */));
+  EXPECT_TRUE(a2dp_codecs.getCodecConfigAndCapabilities(
+      &codec_config, &local_capabilities, &selectable_capabilities));
+  EXPECT_EQ(2u, selectable_capabilities.size());
+  EXPECT_EQ(BTAV_A2DP_CODEC_INDEX_SOURCE_SBC, codec_config.codec_type);
+}
+
 TEST_F(A2dpCodecConfigTest, init) {
   std::vector<btav_a2dp_codec_config_t> default_priorities;
   A2dpCodecs codecs(default_priorities);
@@ -948,3 +1030,92 @@ TEST_F(A2dpCodecConfigTest, init) {
       codecs.orderedSinkCodecs();
   EXPECT_FALSE(orderedSinkCodecs.empty());
 }
+
+// Returns |frames| frames of deterministic stereo noise
+static std::vector<int16_t> resampler_test_input(size_t frames) {
+  std::vector<int16_t> pcm(frames * 2);
+  uint32_t seed = 12345;
+  for (auto& sample : pcm) {
+    seed = seed * 1103515245 + 12345;
+    sample = (int16_t)(seed >> 16);
+  }
+  return pcm;
+}
+
+// Resamples |input| in chunks of |chunk_frames| input frames
+static std::vector<int16_t> resampler_test_run(
+    a2dp_resampler_t* resampler, const std::vector<int16_t>& input,
+    size_t chunk_frames) {
+  std::vector<int16_t> output;
+  // Room for up to 3x upsampling of one chunk
+  std::vector<int16_t> buffer(chunk_frames * 2 * 3 + 64);
+  for (size_t i = 0; i < input.size(); i += chunk_frames * 2) {
+    size_t samples = std::min(chunk_frames * 2, input.size() - i);
+    uint32_t src_used = 0;
+    uint32_t dst_used = a2dp_resampler_process(
+        resampler, &input[i], samples * sizeof(int16_t), buffer.data(),
+        buffer.size() * sizeof(int16_t), &src_used);
+    EXPECT_EQ(samples * sizeof(int16_t), src_used);
+    output.insert(output.end(), buffer.begin(),
+                  buffer.begin() + dst_used / sizeof(int16_t));
+  }
+  return output;
+}
+
+TEST(A2dpResamplerTest, unsupported_format) {
+  EXPECT_EQ(nullptr, a2dp_resampler_new(44100, 48000, 24, 2));
+  EXPECT_EQ(nullptr, a2dp_resampler_new(44100, 48000, 16, 3));
+  EXPECT_EQ(nullptr, a2dp_resampler_new(0, 48000, 16, 2));
+}
+
+TEST(A2dpResamplerTest, dc_gain) {
+  a2dp_resampler_t* resampler = a2dp_resampler_new(16000, 48000, 16, 2);
+  ASSERT_NE(nullptr, resampler);
+
+  std::vector<int16_t> input(2 * 1000, 1000);
+  std::vector<int16_t> output = resampler_test_run(resampler, input, 100);
+  ASSERT_EQ(3 * input.size(), output.size());
+  // Past the filter delay a constant input gives the same constant output
+  for (size_t i = 2 * 3 * 64; i < output.size(); i++)
+    EXPECT_EQ(1000, output[i]) << "at " << i;
+  a2dp_resampler_free(resampler);
+}
+
+TEST(A2dpResamplerTest, output_rate) {
+  const uint32_t rates[][2] = {
+      {44100, 48000}, {48000, 44100}, {16000, 48000}, {32000, 48000}};
+  for (const auto& rate : rates) {
+    a2dp_resampler_t* resampler = a2dp_resampler_new(rate[0], rate[1], 16, 2);
+    ASSERT_NE(nullptr, resampler);
+    std::vector<int16_t> output =
+        resampler_test_run(resampler, resampler_test_input(rate[0]), 441);
+    EXPECT_NEAR(2 * rate[1], output.size(), 2) << rate[0] << " to " << rate[1];
+    a2dp_resampler_free(resampler);
+  }
+}
+
+TEST(A2dpResamplerTest, streaming_state) {
+  std::vector<int16_t> input = resampler_test_input(4410);
+  a2dp_resampler_t* resampler = a2dp_resampler_new(44100, 48000, 16, 2);
+  ASSERT_NE(nullptr, resampler);
+
+  std::vector<int16_t> whole = resampler_test_run(resampler, input, 4410);
+  a2dp_resampler_reset(resampler);
+  std::vector<int16_t> chunked = resampler_test_run(resampler, input, 7);
+  EXPECT_EQ(whole, chunked);
+  a2dp_resampler_free(resampler);
+}
+
+TEST(A2dpResamplerTest, simd_matches_scalar) {
+  std::vector<int16_t> input = resampler_test_input(4410);
+  a2dp_resampler_t* resampler = a2dp_resampler_new(44100, 48000, 16, 2);
+  ASSERT_NE(nullptr, resampler);
+
+  std::vector<int16_t> simd = resampler_test_run(resampler, input, 441);
+  a2dp_resampler_reset(resampler);
+  a2dp_resampler_set_simd_enabled(false);
+  std::vector<int16_t> scalar = resampler_test_run(resampler, input, 441);
+  a2dp_resampler_set_simd_enabled(true);
+  EXPECT_EQ(scalar, simd);
+  a2dp_resampler_free(resampler);
+}
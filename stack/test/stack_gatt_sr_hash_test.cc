@@ -20,11 +20,26 @@
 
 #include "crypto_toolbox/crypto_toolbox.h"
 #include "stack/gatt/gatt_int.h"
+#include "stack/include/btu.h"
 
 using bluetooth::Uuid;
 
 tGATT_CB gatt_cb;
 
+// The main and worker threads are the test thread
+void do_in_main_thread_prio(tBTU_TASK_PRIO prio,
+                            const base::Location& from_here,
+                            const base::Closure& task) {
+  task.Run();
+}
+
+void do_in_worker_thread_and_reply(const base::Location& from_here,
+                                   const base::Closure& task,
+                                   const base::Closure& reply) {
+  task.Run();
+  reply.Run();
+}
+
 static void add_item_to_list(std::list<tGATT_SRV_LIST_ELEM>& srv_list_info,
                       tGATT_SVC_DB* db, bool is_primary) {
   srv_list_info.emplace_back();
@@ -34,10 +49,9 @@ static void add_item_to_list(std::list<tGATT_SRV_LIST_ELEM>& srv_list_info,
 }
 
 // BT Spec 5.2, Vol 3, Part G, Appendix B
-TEST(GattDatabaseTest, matchExampleInBtSpecV52) {
-  tGATT_SVC_DB local_db[4];
+static void build_example_database(tGATT_SVC_DB local_db[4],
+                                   std::list<tGATT_SRV_LIST_ELEM>& srv_list_info) {
   for (int i=0; i<4; i++) local_db[i] = tGATT_SVC_DB();
-  std::list<tGATT_SRV_LIST_ELEM> srv_list_info;
 
   // 0x1800
   add_item_to_list(srv_list_info, &local_db[0], true);
@@ -74,6 +88,12 @@ TEST(GattDatabaseTest, matchExampleInBtSpecV52) {
   gatts_init_service_db(local_db[3], Uuid::From16Bit(0x180F), false, 0x0014, 3);
   gatts_add_characteristic(local_db[3], GATT_PERM_READ,  GATT_CHAR_PROP_BIT_READ,
     Uuid::From16Bit(0x2A19));
+}
+
+TEST(GattDatabaseTest, matchExampleInBtSpecV52) {
+  tGATT_SVC_DB local_db[4];
+  std::list<tGATT_SRV_LIST_ELEM> srv_list_info;
+  build_example_database(local_db, srv_list_info);
 
   Octet16 expected_hash{0xF1, 0xCA, 0x2D, 0x48, 0xEC, 0xF5, 0x8B, 0xAC,
                         0x8A, 0x88, 0x30, 0xBB, 0xB9, 0xFB, 0xA9, 0x90};
@@ -83,3 +103,35 @@ TEST(GattDatabaseTest, matchExampleInBtSpecV52) {
 
   ASSERT_EQ(result_hash, expected_hash);
 }
+
+TEST(GattDatabaseTest, reuseServiceInfoAfterListChange) {
+  tGATT_SVC_DB local_db[4];
+  std::list<tGATT_SRV_LIST_ELEM> srv_list_info;
+  build_example_database(local_db, srv_list_info);
+
+  Octet16 full_hash = gatts_calculate_database_hash(&srv_list_info);
+
+  tGATT_SRV_LIST_ELEM last = srv_list_info.back();
+  srv_list_info.pop_back();
+  Octet16 partial_hash = gatts_calculate_database_hash(&srv_list_info);
+  ASSERT_NE(partial_hash, full_hash);
+
+  srv_list_info.push_back(last);
+  ASSERT_EQ(gatts_calculate_database_hash(&srv_list_info), full_hash);
+}
+
+TEST(GattDatabaseTest, invalidateComputesHashInBackground) {
+  tGATT_SVC_DB local_db[4];
+  std::list<tGATT_SRV_LIST_ELEM> srv_list_info;
+  build_example_database(local_db, srv_list_info);
+
+  gatt_cb = tGATT_CB();
+  gatt_cb.srv_list_info = &srv_list_info;
+  gatts_invalidate_database_hash();
+
+  ASSERT_FALSE(gatt_cb.database_hash_dirty);
+  ASSERT_FALSE(gatt_cb.database_hash_pending);
+  ASSERT_EQ(gatt_cb.database_hash,
+            gatts_calculate_database_hash(&srv_list_info));
+  gatt_cb.srv_list_info = nullptr;
+}
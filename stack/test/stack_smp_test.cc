@@ -23,6 +23,7 @@
 #include "bt_trace.h"
 #include "hcidefs.h"
 #include "stack/include/smp_api.h"
+#include "stack/smp/p_256_ecc_pp.h"
 #include "stack/smp/smp_int.h"
 
 /*
@@ -207,4 +208,118 @@ TEST_F(SmpCalculateConfirmTest, test_smp_calculate_comfirm_as_master) {
   dump_uint128_reverse(output, confirm_str);
   ASSERT_THAT(confirm_str, StrEq(expected_confirm_str));
 }
+
+// Test vectors for P-256 scalar multiplication. Values are written MSB first,
+// the debug keys come from the Core specification (Vol 3, Part H, 2.3.5.6.1).
+class SmpEccTest : public Test {
+ protected:
+  void SetUp() override { p_256_init_curve(KEY_LENGTH_DWORDS_P256); }
+
+  // Converts a 64 digit hex string into little endian DWORDs
+  static void from_hex(const char* str, uint32_t* out) {
+    for (int i = 0; i < KEY_LENGTH_DWORDS_P256; i++) {
+      char word[9] = {0};
+      memcpy(word, str + 8 * (KEY_LENGTH_DWORDS_P256 - 1 - i), 8);
+      out[i] = strtoul(word, nullptr, 16);
+    }
+  }
+
+  static void make_point(const char* x, const char* y, Point* p) {
+    memset(p, 0, sizeof(Point));
+    from_hex(x, p->x);
+    from_hex(y, p->y);
+    p->z[0] = 1;
+  }
+
+  static void expect_mult(Point* p, const char* k, const char* x,
+                          const char* y) {
+    uint32_t scalar[KEY_LENGTH_DWORDS_P256];
+    Point expected;
+    Point q;
+    from_hex(k, scalar);
+    make_point(x, y, &expected);
+    ECC_PointMult(&q, p, scalar, KEY_LENGTH_DWORDS_P256);
+    EXPECT_EQ(0, memcmp(q.x, expected.x, sizeof(q.x)));
+    EXPECT_EQ(0, memcmp(q.y, expected.y, sizeof(q.y)));
+  }
+};
+
+const char kPrivateA[] =
+    "3f49f6d4a3c55f3874c9b3e3d2103f504aff607beb40b7995899b8a6cd3c1abd";
+const char kPublicAX[] =
+    "20b003d2f297be2c5e2c83a7e9f9a5b9eff49111acf4fddbcc0301480e359de6";
+const char kPublicAY[] =
+    "dc809c49652aeb6d63329abf5a52155c766345c28fed3024741c8ed01589d28b";
+const char kPrivateB[] =
+    "55188b3d32f6bb9a900afcfbeed4e72a59cb9ac2f19d7cfb6b4fdd49f47fc5fd";
+const char kPublicBX[] =
+    "1ea1f0f01faf1d9609592284f19e4c0047b58afd8615a69f559077b22faaa190";
+const char kPublicBY[] =
+    "4c55f33e429dad377356703a9ab85160472d1130e28e36765f89aff915b1214a";
+const char kDhKey[] =
+    "ec0234a357c8ad05341010a60a397d9b99796b13b4f866f1868d34f373bfa698";
+
+TEST_F(SmpEccTest, test_public_key_generation) {
+  expect_mult(&curve_p256.G, kPrivateA, kPublicAX, kPublicAY);
+  expect_mult(&curve_p256.G, kPrivateB, kPublicBX, kPublicBY);
+}
+
+TEST_F(SmpEccTest, test_dhkey_generation) {
+  uint32_t scalar[KEY_LENGTH_DWORDS_P256];
+  uint32_t expected[KEY_LENGTH_DWORDS_P256];
+  Point peer;
+  Point q;
+  from_hex(kDhKey, expected);
+
+  make_point(kPublicBX, kPublicBY, &peer);
+  from_hex(kPrivateA, scalar);
+  ECC_PointMult(&q, &peer, scalar, KEY_LENGTH_DWORDS_P256);
+  EXPECT_EQ(0, memcmp(q.x, expected, sizeof(expected)));
+  EXPECT_TRUE(ECC_ValidatePoint(q));
+
+  make_point(kPublicAX, kPublicAY, &peer);
+  from_hex(kPrivateB, scalar);
+  ECC_PointMult(&q, &peer, scalar, KEY_LENGTH_DWORDS_P256);
+  EXPECT_EQ(0, memcmp(q.x, expected, sizeof(expected)));
+}
+
+TEST_F(SmpEccTest, test_base_point_edge_scalars) {
+  expect_mult(
+      &curve_p256.G,
+      "0000000000000000000000000000000000000000000000000000000000000001",
+      "6b17d1f2e12c4247f8bce6e563a440f277037d812deb33a0f4a13945d898c296",
+      "4fe342e2fe1a7f9b8ee7eb4a7c0f9e162bce33576b315ececbb6406837bf51f5");
+  expect_mult(
+      &curve_p256.G,
+      "0000000000000000000000000000000000000000000000000000000000000002",
+      "7cf27b188d034f7e8a52380304b51ac3c08969e277f21b35a60b48fc47669978",
+      "07775510db8ed040293d9ac69f7430dbba7dade63ce982299e04b79d227873d1");
+  // n - 1, which gives -G
+  expect_mult(
+      &curve_p256.G,
+      "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632550",
+      "6b17d1f2e12c4247f8bce6e563a440f277037d812deb33a0f4a13945d898c296",
+      "b01cbd1c01e58065711814b583f061e9d431cca994cea1313449bf97c840ae0a");
+  expect_mult(
+      &curve_p256.G,
+      "8000000000000000000000000000000000000000000000000000000000003039",
+      "37936c6a2b0125cf9dbe930274075817c7fa3cdbadecb85204292502d88d17bc",
+      "16b9fd9da1b864148efae6a94264737e67d8a7f83f762ee7084f9548c0302eb4");
+}
+
+TEST_F(SmpEccTest, test_variable_point_mult) {
+  // 5G
+  Point p;
+  make_point("51590b7a515140d2d784c85608668fdfef8c82fd1f5be52421554a0dc3d033ed",
+             "e0c17da8904a727d8ae1bf36bf8a79260d012f00d4d80888d1d0bb44fda16da4",
+             &p);
+  expect_mult(
+      &p, "7a9abd2a625c4cbc88126eb08ed72d0d568cec2b740a7798d6f1813481854f8a",
+      "7125b104eab3c738946dee501d7f01d7a4a67901b0c50ab9f86401e9bc26a20c",
+      "efdf6f26b7134bcd62b0051dbccf0f77994fdf20508255192e4b7e293727f615");
+  expect_mult(
+      &p, "ffffffff00000000ffffffffffffffffbce6faada7179e84f3b9cac2fc632550",
+      "51590b7a515140d2d784c85608668fdfef8c82fd1f5be52421554a0dc3d033ed",
+      "1f3e82566fb58d83751e40c9407586d9f2fed1002b27f7772e2f44bb025e925b");
+}
 }  // namespace testing
@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+"""
+This script compares two Google Benchmark JSON outputs, as written by
+--benchmark_out=<file> --benchmark_out_format=json, and reports the change
+in CPU time of every benchmark found in both.
+
+When the benchmarks were run with repetitions, the median is compared,
+otherwise each benchmark's single run is.
+
+Example usage:
+  $ ./test/compare_benchmarks.py baseline/bluetooth_benchmark_osi.json \
+        bluetooth_benchmark_osi.json
+
+The script exits with 1 if any benchmark is slower than the baseline by more
+than the threshold, so it can gate a change.
+"""
+
+
+import argparse
+import json
+import sys
+
+
+# Google Benchmark time units, in nanoseconds
+TIME_UNITS = {'ns': 1, 'us': 1e3, 'ms': 1e6, 's': 1e9}
+
+
+def load_cpu_times(path):
+  """Returns a dict of benchmark name to CPU time in nanoseconds."""
+  with open(path) as f:
+    benchmarks = json.load(f).get('benchmarks', [])
+
+  medians = {}
+  runs = {}
+  for benchmark in benchmarks:
+    if 'error_occurred' in benchmark and benchmark['error_occurred']:
+      continue
+    cpu_time = benchmark['cpu_time'] * TIME_UNITS[benchmark.get('time_unit',
+                                                                'ns')]
+    if benchmark.get('run_type') == 'aggregate':
+      if benchmark.get('aggregate_name') == 'median':
+        medians[benchmark['run_name']] = cpu_time
+    else:
+      runs.setdefault(benchmark.get('run_name', benchmark['name']), cpu_time)
+
+  runs.update(medians)
+  return runs
+
+
+def format_time(ns):
+  for unit in ('s', 'ms', 'us'):
+    if ns >= TIME_UNITS[unit]:
+      return '%.3f %s' % (ns / TIME_UNITS[unit], unit)
+  return '%.1f ns' % ns
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description='Compares two Google Benchmark JSON outputs.')
+  parser.add_argument('baseline', help='JSON output of the baseline run')
+  parser.add_argument('contender', help='JSON output of the run to check')
+  parser.add_argument('--threshold', type=float, default=5.0,
+                      help='slowdown in percent reported as a regression '
+                      '(default: %(default)s)')
+  args = parser.parse_args()
+
+  baseline = load_cpu_times(args.baseline)
+  contender = load_cpu_times(args.contender)
+
+  names = [name for name in contender if name in baseline]
+  if not names:
+    sys.stderr.write('No benchmark in common between %s and %s.\n' %
+                     (args.baseline, args.contender))
+    sys.exit(2)
+
+  width = max(len(name) for name in names)
+  print('%-*s %14s %14s %9s' % (width, 'Benchmark', 'Baseline', 'Contender',
+                                'Change'))
+  regressions = []
+  for name in names:
+    change = (contender[name] - baseline[name]) * 100.0 / baseline[name]
+    marker = ''
+    if change > args.threshold:
+      marker = ' !!!'
+      regressions.append(name)
+    print('%-*s %14s %14s %+8.1f%%%s' % (width, name,
+                                          format_time(baseline[name]),
+                                          format_time(contender[name]),
+                                          change, marker))
+
+  for name in sorted(set(baseline) - set(contender)):
+    print('%-*s missing from %s' % (width, name, args.contender))
+
+  if regressions:
+    print('%d benchmark(s) slower than the baseline by more than %.1f%%' %
+          (len(regressions), args.threshold))
+    sys.exit(1)
+
+
+if __name__ == '__main__':
+  main()
@@ -6,15 +6,31 @@
 # Example usage:
 #   $ cd system/bt
 #   $ ./test/run_benchmarks.sh bluetooth_benchmark_example
+#
+# To check a change for regressions, save a baseline before it and compare
+# against it after:
+#   $ ./test/run_benchmarks.sh --save-baseline /tmp/bt_baseline --all
+#   $ ./test/run_benchmarks.sh --compare /tmp/bt_baseline --all
 
 known_benchmarks=(
+  bluetooth_benchmark_crc16
+  bluetooth_benchmark_lru
+  bluetooth_benchmark_osi
+  bluetooth_benchmark_packet_fragmenter
+  bluetooth_benchmark_stack_hot_paths
+  bluetooth_benchmark_stack_load
   bluetooth_benchmark_thread_performance
 )
 
 usage() {
   binary="$(basename "$0")"
   echo "Usage: ${binary} --help"
-  echo "       ${binary} [-i <iterations>] [-s <specific device>] [--all] [<benchmark name>[.<filter>] ...] [--<arg> ...]"
+  echo "       ${binary} [-i <iterations>] [-s <specific device>] [--all] [--save-baseline <dir> | --compare <dir>] [<benchmark name>[.<filter>] ...] [--<arg> ...]"
+  echo
+  echo "--save-baseline writes the JSON results of each benchmark to <dir>,"
+  echo "--compare checks them against the ones saved there and fails on"
+  echo "regressions. Only the last iteration is kept; pass"
+  echo "--benchmark_repetitions=<n> to compare medians instead."
   echo
   echo "Unknown long arguments are passed to the benchmark."
   echo
@@ -28,6 +44,8 @@ usage() {
 
 iterations=1
 device=
+baseline_mode=
+baseline_dir=
 benchmarks=()
 benchmark_args=()
 while [ $# -gt 0 ]
@@ -61,6 +79,17 @@ do
       benchmarks+=( "${known_benchmarks[@]}" )
       shift
       ;;
+    --save-baseline|--compare)
+      baseline_mode="$1"
+      shift
+      if [ $# -eq 0 ]; then
+        echo "error: baseline directory expected" 1>&2
+        usage
+        exit 2
+      fi
+      baseline_dir="$1"
+      shift
+      ;;
     --*)
       benchmark_args+=( "$1" )
       shift
@@ -81,10 +110,17 @@ if [ -n "${device}" ]; then
   adb+=( "-s" "${device}" )
 fi
 
+if [ "${baseline_mode}" = "--save-baseline" ]; then
+  mkdir -p "${baseline_dir}"
+elif [ "${baseline_mode}" = "--compare" ]; then
+  contender_dir="$(mktemp -d)"
+fi
+
 source ${ANDROID_BUILD_TOP}/build/envsetup.sh
 target_arch=$(gettargetarch)
 
 failed_benchmarks=()
+regressed_benchmarks=()
 for spec in "${benchmarks[@]}"
 do
   name="${spec%%.*}"
@@ -101,6 +137,10 @@ do
     benchmark_command+=( "--benchmark_filter=${filter}" )
   fi
   benchmark_command+=( "${benchmark_args[@]}" )
+  result="/data/local/tmp/${name}.json"
+  if [ -n "${baseline_mode}" ]; then
+    benchmark_command+=( "--benchmark_out=${result}" "--benchmark_out_format=json" )
+  fi
 
   echo "--- ${name} ---"
   echo "pushing..."
@@ -114,9 +154,20 @@ do
 
   if [ $failed_count != 0 ]; then
     failed_benchmarks+=( "${name} ${failed_count}/${iterations}" )
+  elif [ "${baseline_mode}" = "--save-baseline" ]; then
+    "${adb[@]}" pull "${result}" "${baseline_dir}/${name}.json"
+  elif [ "${baseline_mode}" = "--compare" ]; then
+    "${adb[@]}" pull "${result}" "${contender_dir}/${name}.json"
+    echo "comparing..."
+    "$(dirname "$0")/compare_benchmarks.py" "${baseline_dir}/${name}.json" \
+        "${contender_dir}/${name}.json" || regressed_benchmarks+=( "${name}" )
   fi
 done
 
+if [ -n "${contender_dir}" ]; then
+  rm -rf "${contender_dir}"
+fi
+
 if [ "${#failed_benchmarks[@]}" -ne 0 ]; then
   for failed_benchmark in "${failed_benchmarks[@]}"
   do
@@ -125,4 +176,12 @@ if [ "${#failed_benchmarks[@]}" -ne 0 ]; then
   exit 1
 fi
 
+if [ "${#regressed_benchmarks[@]}" -ne 0 ]; then
+  for regressed_benchmark in "${regressed_benchmarks[@]}"
+  do
+    echo "!!! REGRESSED: ${regressed_benchmark} !!!"
+  done
+  exit 1
+fi
+
 exit 0
@@ -0,0 +1,84 @@
+#!/usr/bin/env python
+"""
+This script converts a rolling snoop log (btsnoop_hci.log.rolling) into a
+regular btsnoop log file which can be viewed using standard tools like
+Wireshark.
+
+The rolling log is a fixed-size circular file written by the Bluetooth
+stack when persist.vendor.bt.btsnoop_rolling_size is set. It can be
+described as:
+
+  header {
+    magic        char[8] = "btsnoopr"
+    version      uint32
+    header_size  uint32
+    data_size    uint64
+    head         uint64
+    tail         uint64
+    used         uint64
+  }
+  data[data_size]
+
+where |used| bytes of btsnoop records start at offset |tail| of |data| and
+wrap around at its end. All header fields are little endian.
+
+While the stack is running, the same log is available already converted
+from the "--btsnoop-rolling" dump argument of the Bluetooth service.
+"""
+
+
+import struct
+import sys
+
+
+HEADER_FORMAT = '<8sIIQQQQ'
+MAGIC = b'btsnoopr'
+BTSNOOP_FILE_HEADER = b'btsnoop\x00\x00\x00\x00\x01\x00\x00\x03\xea'
+
+
+def linearize(contents):
+  """
+  Returns the records of the rolling log |contents| with the oldest first.
+  """
+  header_length = struct.calcsize(HEADER_FORMAT)
+  if len(contents) < header_length:
+    raise ValueError('file is too short')
+
+  magic, version, header_size, data_size, head, tail, used = struct.unpack(
+      HEADER_FORMAT, contents[:header_length])
+  if magic != MAGIC:
+    raise ValueError('not a rolling snoop log')
+  if version != 1:
+    raise ValueError('unsupported version %d' % version)
+
+  data = contents[header_size : header_size + data_size]
+  if len(data) != data_size or tail >= max(data_size, 1) or used > data_size:
+    raise ValueError('truncated or corrupt rolling snoop log')
+
+  end = tail + used
+  if end <= data_size:
+    return data[tail:end]
+  return data[tail:] + data[:end - data_size]
+
+
+def main():
+  if len(sys.argv) != 3:
+    sys.stderr.write('Usage: %s <rolling log> <btsnoop output>\n' % sys.argv[0])
+    exit(1)
+
+  with open(sys.argv[1], 'rb') as f:
+    contents = f.read()
+
+  try:
+    records = linearize(contents)
+  except ValueError as e:
+    sys.stderr.write('%s: %s\n' % (sys.argv[1], e))
+    exit(1)
+
+  with open(sys.argv[2], 'wb') as f:
+    f.write(BTSNOOP_FILE_HEADER)
+    f.write(records)
+
+
+if __name__ == '__main__':
+  main()
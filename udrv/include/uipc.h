@@ -45,6 +45,7 @@ typedef enum {
 #define UIPC_REG_CBACK 2
 #define UIPC_REG_REMOVE_ACTIVE_READSET 3
 #define UIPC_SET_READ_POLL_TMO 4
+#define UIPC_REQ_RX_AVAILABLE 5 /* param: uint32_t*, bytes ready to read */
 
 typedef void(tUIPC_RCV_CBACK)(
     tUIPC_CH_ID ch_id,
@@ -118,7 +119,8 @@ uint32_t UIPC_Read(tUIPC_CH_ID ch_id, uint16_t* p_msg_evt, uint8_t* p_buf,
  *
  * Description      Called to control UIPC.
  *
- * Returns          void
+ * Returns          true if UIPC_REQ_RX_AVAILABLE stored a byte count, false
+ *                  otherwise.
  *
  ******************************************************************************/
 bool UIPC_Ioctl(tUIPC_CH_ID ch_id, uint32_t request, void* param);
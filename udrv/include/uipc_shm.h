@@ -0,0 +1,84 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// A single producer, single consumer ring of PCM bytes shared between the
+// audio HAL and the stack through a mapped file. The stack creates the ring
+// next to the UIPC data socket and reads from it; the HAL attaches to it once
+// the data socket is connected and writes into it. Both sides wait on futexes
+// inside the mapping when the ring is empty or full, so no bytes cross the
+// socket while the ring is attached. The socket stays connected and keeps
+// signalling start, stop and peer loss.
+
+typedef struct uipc_shm_t uipc_shm_t;
+
+// Default ring size. It matches the audio socket buffer rounded up to a power
+// of two so the amount of PCM queued between HAL and stack stays the same.
+#define UIPC_SHM_DEFAULT_SIZE (32 * 1024)
+
+// The ring of a UIPC channel lives next to its socket, at the socket path with
+// this suffix appended.
+#define UIPC_SHM_PATH_SUFFIX "_shm"
+
+// Creates the ring file at |path| with room for |size| bytes and maps it.
+// |size| must be a power of two. Any stale file at |path| is replaced.
+// Returns NULL on failure. The returned ring must be freed with
+// |uipc_shm_free|, which also removes the file.
+uipc_shm_t* uipc_shm_create(const char* path, size_t size);
+
+// Maps the ring created at |path| and marks the writer as attached. Returns
+// NULL if there is no valid ring at |path|, in which case the caller keeps
+// using the socket. The returned ring must be freed with |uipc_shm_free|.
+uipc_shm_t* uipc_shm_attach(const char* path);
+
+// Detaches the calling side from |shm| and wakes up the peer, but keeps the
+// ring mapped so a concurrent reader or writer on this side does not touch
+// freed memory. Once the creating side shuts down, the file is removed and
+// pending and future writes fail. |shm| may not be NULL.
+void uipc_shm_shutdown(uipc_shm_t* shm);
+
+// Shuts |shm| down if needed and unmaps it. |shm| may be NULL.
+void uipc_shm_free(uipc_shm_t* shm);
+
+// Returns true if a writer is attached to |shm|. |shm| may not be NULL.
+bool uipc_shm_writer_attached(const uipc_shm_t* shm);
+
+// Returns the number of bytes queued in |shm|. |shm| may not be NULL.
+size_t uipc_shm_available(const uipc_shm_t* shm);
+
+// Copies |len| bytes from |data| into |shm|, waiting up to |timeout_ms| in
+// total for the reader to free space. Returns |len|, or -1 if the reader went
+// away or the timeout expired; bytes written until then stay queued. |shm|
+// may not be NULL.
+ssize_t uipc_shm_write(uipc_shm_t* shm, const void* data, size_t len,
+                       int timeout_ms);
+
+// Copies up to |len| bytes from |shm| into |buf|, waiting up to |timeout_ms|
+// in total for the writer to produce them. Returns the number of bytes read,
+// which is less than |len| if the timeout expired. |shm| may not be NULL.
+size_t uipc_shm_read(uipc_shm_t* shm, void* buf, size_t len, int timeout_ms);
+
+// Drops all bytes queued in |shm| and wakes up a waiting writer. Must be
+// called from the reading side. |shm| may not be NULL.
+void uipc_shm_flush(uipc_shm_t* shm);
@@ -26,10 +26,12 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <sys/poll.h>
 #include <sys/prctl.h>
@@ -49,12 +51,16 @@
 #include "a2dp_hal_sim/audio_a2dp_hal.h"
 #endif
 
+#include "audio_hearing_aid_hw/include/audio_hearing_aid_hw.h"
+
 #include "bt_common.h"
 #include "bt_types.h"
 #include "bt_utils.h"
 #include "osi/include/osi.h"
+#include "osi/include/properties.h"
 #include "osi/include/socket_utils/sockets.h"
 #include "uipc.h"
+#include "uipc_shm.h"
 
 /*****************************************************************************
  *  Constants & Macros
@@ -77,6 +83,11 @@
 #define CHAN_CREATE_WAIT_TIME_MS 30
 #define CHAN_CREATE_RETRY_COUNT 10
 
+/* Carry the audio channel PCM through a shared memory ring instead of the
+   socket if the audio HAL attaches to it */
+#define UIPC_PCM_SHM_PROPERTY "persist.vendor.bt.a2dp.pcm_shm"
+#define UIPC_HA_PCM_SHM_PROPERTY "persist.vendor.bt.hearing_aid.pcm_shm"
+
 /*****************************************************************************
  *  Local type definitions
  *****************************************************************************/
@@ -91,6 +102,7 @@ typedef struct {
   int read_poll_tmo_ms;
   int task_evt_flags; /* event flags pending to be processed in read task */
   tUIPC_RCV_CBACK* cback;
+  uipc_shm_t* shm; /* PCM ring next to the socket, audio channel only */
 } tUIPC_CHAN;
 
 typedef struct {
@@ -261,7 +273,11 @@ void uipc_main_cleanup(void) {
   OSI_NO_INTR(close(uipc_main.signal_fds[1]));
 
   /* close any open channels */
-  for (i = 0; i < UIPC_CH_NUM; i++) uipc_close_ch_locked(i);
+  for (i = 0; i < UIPC_CH_NUM; i++) {
+    uipc_close_ch_locked(i);
+    uipc_shm_free(uipc_main.ch[i].shm);
+    uipc_main.ch[i].shm = NULL;
+  }
 }
 
 /* check pending events in read task */
@@ -342,6 +358,35 @@ static inline void uipc_wakeup_locked(void) {
   OSI_NO_INTR(send(uipc_main.signal_fds[1], &sig_on, sizeof(sig_on), 0));
 }
 
+static void uipc_setup_shm_locked(tUIPC_CH_ID ch_id, const char* name) {
+  char path[PATH_MAX];
+
+  snprintf(path, sizeof(path), "%s%s", name, UIPC_SHM_PATH_SUFFIX);
+
+  /* the ring of a previous session was shut down on close, the reader is
+     done with it by the time the channel is opened again */
+  uipc_shm_free(uipc_main.ch[ch_id].shm);
+  uipc_main.ch[ch_id].shm = NULL;
+
+  /* the audio channel carries either A2DP or hearing aid PCM */
+  const char* property = strcmp(name, HEARING_AID_DATA_PATH) == 0
+                             ? UIPC_HA_PCM_SHM_PROPERTY
+                             : UIPC_PCM_SHM_PROPERTY;
+  if (!osi_property_get_bool(property, false)) {
+    /* make sure the HAL does not attach to a stale ring */
+    unlink(path);
+    return;
+  }
+
+  uipc_main.ch[ch_id].shm = uipc_shm_create(path, UIPC_SHM_DEFAULT_SIZE);
+  if (uipc_main.ch[ch_id].shm == NULL) {
+    BTIF_TRACE_ERROR("failed to create PCM ring %s, using socket", path);
+    return;
+  }
+
+  BTIF_TRACE_EVENT("created PCM ring %s", path);
+}
+
 static int uipc_setup_server_locked(tUIPC_CH_ID ch_id, const char* name,
                                     tUIPC_RCV_CBACK* cback) {
   int fd;
@@ -379,6 +424,8 @@ static int uipc_setup_server_locked(tUIPC_CH_ID ch_id, const char* name,
   uipc_main.ch[ch_id].cback = cback;
   uipc_main.ch[ch_id].read_poll_tmo_ms = DEFAULT_READ_POLL_TMO_MS;
 
+  if (ch_id == UIPC_CH_ID_AV_AUDIO) uipc_setup_shm_locked(ch_id, name);
+
   /* trigger main thread to update read set */
   uipc_wakeup_locked();
 
@@ -434,6 +481,7 @@ static void uipc_flush_locked(tUIPC_CH_ID ch_id) {
 
     case UIPC_CH_ID_AV_AUDIO:
       uipc_flush_ch_locked(UIPC_CH_ID_AV_AUDIO);
+      if (uipc_main.ch[ch_id].shm) uipc_shm_flush(uipc_main.ch[ch_id].shm);
       break;
   }
 }
@@ -461,6 +509,10 @@ static int uipc_close_ch_locked(tUIPC_CH_ID ch_id) {
     wakeup = 1;
   }
 
+  /* fail further writes of the HAL; the ring stays mapped until the next
+     open or cleanup since UIPC_Read does not hold the lock */
+  if (uipc_main.ch[ch_id].shm) uipc_shm_shutdown(uipc_main.ch[ch_id].shm);
+
   /* notify this connection is closed */
   if (uipc_main.ch[ch_id].cback)
     uipc_main.ch[ch_id].cback(ch_id, UIPC_CLOSE_EVT);
@@ -662,6 +714,34 @@ bool UIPC_Send(tUIPC_CH_ID ch_id, UNUSED_ATTR uint16_t msg_evt,
   return false;
 }
 
+/* Reads PCM from the shared ring while the socket only tells whether the HAL
+   is still there */
+static uint32_t uipc_read_shm(tUIPC_CH_ID ch_id, int fd, uipc_shm_t* shm,
+                              uint8_t* p_buf, uint32_t len) {
+  size_t n_read =
+      uipc_shm_read(shm, p_buf, len, uipc_main.ch[ch_id].read_poll_tmo_ms);
+  if (n_read == len) return n_read;
+
+  struct pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = POLLHUP;
+  pfd.revents = 0;
+
+  int poll_ret;
+  OSI_NO_INTR(poll_ret = poll(&pfd, 1, 0));
+  if (poll_ret > 0 && (pfd.revents & (POLLHUP | POLLNVAL))) {
+    BTIF_TRACE_WARNING("UIPC_Read : channel detached remotely");
+    std::lock_guard<std::recursive_mutex> lock(uipc_main.mutex);
+    uipc_close_locked(ch_id);
+    return 0;
+  }
+
+  if (uipc_shm_writer_attached(shm))
+    BTIF_TRACE_WARNING("PCM ring read timeout (%d ms)",
+                       uipc_main.ch[ch_id].read_poll_tmo_ms);
+  return n_read;
+}
+
 /*******************************************************************************
  **
  ** Function         UIPC_Read
@@ -690,6 +770,10 @@ uint32_t UIPC_Read(tUIPC_CH_ID ch_id, UNUSED_ATTR uint16_t* p_msg_evt,
     return 0;
   }
 
+  uipc_shm_t* shm = uipc_main.ch[ch_id].shm;
+  if (shm != NULL && uipc_shm_writer_attached(shm))
+    return uipc_read_shm(ch_id, fd, shm, p_buf, len);
+
   while (n_read < (int)len) {
     pfd.fd = fd;
     pfd.events = POLLIN | POLLHUP;
@@ -742,6 +826,22 @@ uint32_t UIPC_Read(tUIPC_CH_ID ch_id, UNUSED_ATTR uint16_t* p_msg_evt,
   return n_read;
 }
 
+static bool uipc_rx_available_locked(tUIPC_CH_ID ch_id, uint32_t* p_bytes) {
+  if (ch_id >= UIPC_CH_NUM || p_bytes == NULL) return false;
+  if (uipc_main.ch[ch_id].fd == UIPC_DISCONNECTED) return false;
+
+  uipc_shm_t* shm = uipc_main.ch[ch_id].shm;
+  if (shm != NULL && uipc_shm_writer_attached(shm)) {
+    *p_bytes = uipc_shm_available(shm);
+    return true;
+  }
+
+  int bytes = 0;
+  if (ioctl(uipc_main.ch[ch_id].fd, FIONREAD, &bytes) < 0) return false;
+  *p_bytes = bytes;
+  return true;
+}
+
 /*******************************************************************************
  *
  * Function         UIPC_Ioctl
@@ -785,6 +885,9 @@ extern bool UIPC_Ioctl(tUIPC_CH_ID ch_id, uint32_t request, void* param) {
                        uipc_main.ch[ch_id].read_poll_tmo_ms);
       break;
 
+    case UIPC_REQ_RX_AVAILABLE:
+      return uipc_rx_available_locked(ch_id, (uint32_t*)param);
+
     default:
       BTIF_TRACE_EVENT("UIPC_Ioctl : request not handled (%d)", request);
       break;
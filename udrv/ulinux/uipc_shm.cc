@@ -0,0 +1,316 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+#define LOG_TAG "bt_uipc_shm"
+
+#include "uipc_shm.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <new>
+
+#include "osi/include/log.h"
+
+#define UIPC_SHM_MAGIC 0x42544d50 /* "BTMP" */
+#define UIPC_SHM_VERSION 1
+
+// Lives at the start of the mapping, followed by the ring itself. Positions
+// are free running byte counters, so |write_pos - read_pos| is the number of
+// queued bytes. The producer and consumer fields sit on separate cache lines.
+// |data_seq| and |space_seq| are the futex words the reader and the writer
+// sleep on; they change whenever data is produced or space is freed.
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t size;
+  std::atomic<uint32_t> reader_attached;
+  std::atomic<uint32_t> writer_attached;
+
+  alignas(64) std::atomic<uint32_t> write_pos;
+  std::atomic<uint32_t> data_seq;
+  std::atomic<uint32_t> reader_waiting;
+
+  alignas(64) std::atomic<uint32_t> read_pos;
+  std::atomic<uint32_t> space_seq;
+  std::atomic<uint32_t> writer_waiting;
+} shm_header_t;
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "shared ring needs address free atomics");
+
+struct uipc_shm_t {
+  shm_header_t* header;
+  uint8_t* data;
+  size_t map_size;
+  uint32_t mask;
+  bool creator;
+  bool attached;
+  char* path;
+};
+
+static uint64_t now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// The mapping is shared between processes, so the non private futex
+// operations are required.
+static void futex_wait(std::atomic<uint32_t>* word, uint32_t value,
+                       uint64_t timeout_ms) {
+  struct timespec ts;
+  ts.tv_sec = timeout_ms / 1000;
+  ts.tv_nsec = (timeout_ms % 1000) * 1000000;
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, value,
+          &ts, NULL, 0);
+}
+
+static void futex_wake(std::atomic<uint32_t>* word) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, INT_MAX,
+          NULL, NULL, 0);
+}
+
+// Bumps |seq| and wakes up the other side if it announced it is sleeping on
+// it. Paired with the check in |wait_on|: either the sleeper sees the new
+// sequence number or the waker sees the waiting flag.
+static void notify(std::atomic<uint32_t>* seq,
+                   std::atomic<uint32_t>* waiting) {
+  seq->fetch_add(1);
+  if (waiting->exchange(0)) futex_wake(seq);
+}
+
+static void wait_on(std::atomic<uint32_t>* seq, std::atomic<uint32_t>* waiting,
+                    uint32_t seen, uint64_t timeout_ms) {
+  waiting->store(1);
+  futex_wait(seq, seen, timeout_ms);
+  waiting->store(0);
+}
+
+static uipc_shm_t* shm_new(int fd, size_t map_size, bool creator,
+                           const char* path) {
+  void* map =
+      mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (map == MAP_FAILED) {
+    LOG_ERROR(LOG_TAG, "%s unable to map %s: %s", __func__, path,
+              strerror(errno));
+    return NULL;
+  }
+
+  uipc_shm_t* shm = static_cast<uipc_shm_t*>(calloc(1, sizeof(uipc_shm_t)));
+  shm->header = static_cast<shm_header_t*>(map);
+  shm->data = static_cast<uint8_t*>(map) + sizeof(shm_header_t);
+  shm->map_size = map_size;
+  shm->creator = creator;
+  shm->path = strdup(path);
+  return shm;
+}
+
+uipc_shm_t* uipc_shm_create(const char* path, size_t size) {
+  if (size == 0 || (size & (size - 1)) != 0 || size > (1u << 30)) {
+    LOG_ERROR(LOG_TAG, "%s invalid ring size %zu", __func__, size);
+    return NULL;
+  }
+
+  unlink(path);
+  int fd = open(path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0660);
+  if (fd < 0) {
+    LOG_ERROR(LOG_TAG, "%s unable to create %s: %s", __func__, path,
+              strerror(errno));
+    return NULL;
+  }
+
+  size_t map_size = sizeof(shm_header_t) + size;
+  uipc_shm_t* shm = NULL;
+  if (ftruncate(fd, map_size) == 0) {
+    shm = shm_new(fd, map_size, true, path);
+  } else {
+    LOG_ERROR(LOG_TAG, "%s unable to size %s: %s", __func__, path,
+              strerror(errno));
+  }
+  close(fd);
+  if (!shm) {
+    unlink(path);
+    return NULL;
+  }
+
+  shm_header_t* header = shm->header;
+  new (header) shm_header_t();
+  header->version = UIPC_SHM_VERSION;
+  header->size = size;
+  header->reader_attached.store(1);
+  shm->mask = size - 1;
+  shm->attached = true;
+
+  // Publish the magic last so a writer never sees a half initialized ring.
+  std::atomic_thread_fence(std::memory_order_release);
+  header->magic = UIPC_SHM_MAGIC;
+  return shm;
+}
+
+uipc_shm_t* uipc_shm_attach(const char* path) {
+  int fd = open(path, O_RDWR | O_CLOEXEC);
+  if (fd < 0) return NULL;
+
+  struct stat st;
+  uipc_shm_t* shm = NULL;
+  if (fstat(fd, &st) == 0 && (size_t)st.st_size > sizeof(shm_header_t))
+    shm = shm_new(fd, st.st_size, false, path);
+  close(fd);
+  if (!shm) return NULL;
+
+  shm_header_t* header = shm->header;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (header->magic != UIPC_SHM_MAGIC || header->version != UIPC_SHM_VERSION ||
+      sizeof(shm_header_t) + header->size != shm->map_size ||
+      !header->reader_attached.load()) {
+    LOG_WARN(LOG_TAG, "%s ignoring stale or invalid ring at %s", __func__,
+             path);
+    uipc_shm_free(shm);
+    return NULL;
+  }
+
+  shm->mask = header->size - 1;
+  shm->attached = true;
+  header->writer_attached.store(1);
+  return shm;
+}
+
+void uipc_shm_shutdown(uipc_shm_t* shm) {
+  if (!shm->attached) return;
+  shm->attached = false;
+
+  shm_header_t* header = shm->header;
+  if (shm->creator) {
+    header->reader_attached.store(0);
+    notify(&header->space_seq, &header->writer_waiting);
+    unlink(shm->path);
+  } else {
+    header->writer_attached.store(0);
+    notify(&header->data_seq, &header->reader_waiting);
+  }
+}
+
+void uipc_shm_free(uipc_shm_t* shm) {
+  if (!shm) return;
+
+  uipc_shm_shutdown(shm);
+  munmap(shm->header, shm->map_size);
+  free(shm->path);
+  free(shm);
+}
+
+bool uipc_shm_writer_attached(const uipc_shm_t* shm) {
+  return shm->header->writer_attached.load(std::memory_order_acquire) != 0;
+}
+
+size_t uipc_shm_available(const uipc_shm_t* shm) {
+  const shm_header_t* header = shm->header;
+  return header->write_pos.load(std::memory_order_acquire) -
+         header->read_pos.load(std::memory_order_acquire);
+}
+
+ssize_t uipc_shm_write(uipc_shm_t* shm, const void* data, size_t len,
+                       int timeout_ms) {
+  shm_header_t* header = shm->header;
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  const uint64_t deadline = now_ms() + timeout_ms;
+  size_t written = 0;
+
+  while (written < len) {
+    if (!header->reader_attached.load(std::memory_order_acquire)) return -1;
+
+    uint32_t seen = header->space_seq.load();
+    uint32_t wp = header->write_pos.load(std::memory_order_relaxed);
+    uint32_t space = header->size -
+                     (wp - header->read_pos.load(std::memory_order_acquire));
+    if (space == 0) {
+      uint64_t now = now_ms();
+      if (now >= deadline) break;
+      wait_on(&header->space_seq, &header->writer_waiting, seen,
+              deadline - now);
+      continue;
+    }
+
+    size_t chunk = len - written;
+    if (chunk > space) chunk = space;
+    size_t offset = wp & shm->mask;
+    size_t first = header->size - offset;
+    if (first > chunk) first = chunk;
+    memcpy(shm->data + offset, p + written, first);
+    memcpy(shm->data, p + written + first, chunk - first);
+
+    header->write_pos.store(wp + chunk, std::memory_order_release);
+    notify(&header->data_seq, &header->reader_waiting);
+    written += chunk;
+  }
+
+  if (written < len) return -1;
+  return written;
+}
+
+size_t uipc_shm_read(uipc_shm_t* shm, void* buf, size_t len, int timeout_ms) {
+  shm_header_t* header = shm->header;
+  uint8_t* p = static_cast<uint8_t*>(buf);
+  const uint64_t deadline = now_ms() + timeout_ms;
+  size_t n_read = 0;
+
+  while (n_read < len) {
+    uint32_t seen = header->data_seq.load();
+    uint32_t rp = header->read_pos.load(std::memory_order_relaxed);
+    uint32_t used = header->write_pos.load(std::memory_order_acquire) - rp;
+    if (used == 0) {
+      uint64_t now = now_ms();
+      if (now >= deadline || !uipc_shm_writer_attached(shm)) break;
+      wait_on(&header->data_seq, &header->reader_waiting, seen,
+              deadline - now);
+      continue;
+    }
+
+    size_t chunk = len - n_read;
+    if (chunk > used) chunk = used;
+    size_t offset = rp & shm->mask;
+    size_t first = header->size - offset;
+    if (first > chunk) first = chunk;
+    memcpy(p + n_read, shm->data + offset, first);
+    memcpy(p + n_read + first, shm->data, chunk - first);
+
+    header->read_pos.store(rp + chunk, std::memory_order_release);
+    notify(&header->space_seq, &header->writer_waiting);
+    n_read += chunk;
+  }
+
+  return n_read;
+}
+
+void uipc_shm_flush(uipc_shm_t* shm) {
+  shm_header_t* header = shm->header;
+  header->read_pos.store(header->write_pos.load(std::memory_order_acquire),
+                         std::memory_order_release);
+  notify(&header->space_seq, &header->writer_waiting);
+}
@@ -0,0 +1,396 @@
+/******************************************************************************
+ *
+ *  Copyright (C) 2026 The Android Open Source Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at:
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ ******************************************************************************/
+
+// Drives the HCI data paths of the stack with controller traffic built by
+// test_vendor_lib: many ACL links reassembling L2CAP CoC SDUs, bulk CoC
+// transmit, A2DP media packets and a beacon swarm flooding LE advertising
+// reports. Every benchmark reports throughput, CPU time per packet and
+// latency percentiles, so hot path regressions show up without a controller.
+//
+// Example:
+//   $ bluetooth_benchmark_stack_load --benchmark_filter=BM_BeaconFlood
+
+#include <benchmark/benchmark.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "acl_packet.h"
+#include "bt_address.h"
+#include "bt_target.h"
+#include "device/include/controller.h"
+#include "event_packet.h"
+#include "hci/include/adv_report_filter.h"
+#include "hci/include/packet_fragmenter.h"
+#include "osi/include/allocator.h"
+#include "stack/include/btm_ble_api_types.h"
+#include "stack/include/hcidefs.h"
+
+using ::benchmark::Counter;
+using ::benchmark::State;
+using test_vendor_lib::AclPacket;
+using test_vendor_lib::BtAddress;
+using test_vendor_lib::EventPacket;
+
+namespace {
+
+constexpr uint16_t kAclDataSizeBle = 251;
+constexpr uint16_t kFirstHandle = 0x0040;
+constexpr uint16_t kFirstDynamicCid = 0x0040;
+constexpr size_t kL2capHeaderSize = 4;
+constexpr size_t kCocSduLengthSize = 2;
+
+uint64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Collects per-packet latencies and reports them as benchmark counters.
+class LatencyRecorder {
+ public:
+  void Add(uint64_t latency_ns) { samples_.push_back(latency_ns); }
+
+  void Report(State& state) {
+    if (samples_.empty()) return;
+    std::sort(samples_.begin(), samples_.end());
+    state.counters["p50_us"] = Percentile(0.50) / 1000.0;
+    state.counters["p99_us"] = Percentile(0.99) / 1000.0;
+    state.counters["max_us"] = samples_.back() / 1000.0;
+  }
+
+ private:
+  double Percentile(double fraction) const {
+    size_t index = static_cast<size_t>(fraction * (samples_.size() - 1));
+    return samples_[index];
+  }
+
+  std::vector<uint64_t> samples_;
+};
+
+void report_packets(State& state, size_t packets, size_t bytes) {
+  state.SetItemsProcessed(packets);
+  state.SetBytesProcessed(bytes);
+  state.counters["cpu_per_packet"] =
+      Counter(packets, Counter::kIsRate | Counter::kInvert);
+}
+
+BT_HDR* bt_hdr_from(const std::vector<uint8_t>& bytes, uint16_t event) {
+  BT_HDR* packet =
+      static_cast<BT_HDR*>(osi_malloc(sizeof(BT_HDR) + bytes.size()));
+  packet->event = event;
+  packet->len = bytes.size();
+  packet->offset = 0;
+  packet->layer_specific = 0;
+  memcpy(packet->data, bytes.data(), bytes.size());
+  return packet;
+}
+
+// Builds an ACL packet carrying one L2CAP CoC SDU of |sdu_size| bytes.
+AclPacket coc_acl_packet(uint16_t handle, uint16_t cid, size_t sdu_size,
+                         AclPacket::PacketBoundaryFlags boundary) {
+  AclPacket acl(handle, boundary, AclPacket::PointToPoint);
+  acl.AddPayloadOctets2(kCocSduLengthSize + sdu_size);
+  acl.AddPayloadOctets2(cid);
+  acl.AddPayloadOctets2(sdu_size);
+  acl.AddPayloadOctets(sdu_size, std::vector<uint8_t>(sdu_size, 0xa5));
+  return acl;
+}
+
+// Splits the L2CAP payload of |acl| into controller-sized ACL fragments, the
+// way a controller hands them to the host.
+std::vector<std::vector<uint8_t>> controller_fragments(const AclPacket& acl,
+                                                       uint16_t max_size) {
+  const std::vector<uint8_t>& raw = acl.GetPacket();
+  std::vector<uint8_t> l2cap(raw.begin() + HCI_ACL_PREAMBLE_SIZE, raw.end());
+
+  std::vector<std::vector<uint8_t>> fragments;
+  for (size_t offset = 0; offset < l2cap.size(); offset += max_size) {
+    size_t length = std::min<size_t>(max_size, l2cap.size() - offset);
+    AclPacket fragment(acl.GetChannel(),
+                       offset == 0 ? AclPacket::FirstAutomaticallyFlushable
+                                   : AclPacket::Continuing,
+                       AclPacket::PointToPoint);
+    fragment.AddPayloadOctets(
+        length, std::vector<uint8_t>(l2cap.begin() + offset,
+                                     l2cap.begin() + offset + length));
+    fragments.push_back(fragment.GetPacket());
+  }
+  return fragments;
+}
+
+// Controller and fragmenter callbacks. The fragmenter only keeps plain
+// function pointers, so the state they touch is file-scoped.
+uint16_t acl_data_size_classic = 1021;
+
+uint16_t get_acl_data_size_classic(void) { return acl_data_size_classic; }
+uint16_t get_acl_data_size_ble(void) { return kAclDataSizeBle; }
+
+LatencyRecorder* latency_recorder;
+std::vector<uint64_t> link_start_ns;
+uint64_t tx_start_ns;
+size_t packets_delivered;
+size_t bytes_delivered;
+
+void on_fragmented(BT_HDR* packet, bool send_transmit_finished) {
+  packets_delivered++;
+  bytes_delivered += packet->len;
+  if (send_transmit_finished) {
+    latency_recorder->Add(now_ns() - tx_start_ns);
+    osi_free(packet);
+  }
+}
+
+void on_fragments_ready(BT_HDR* packet, const acl_fragment_t* fragments,
+                        size_t count, bool send_transmit_finished) {
+  for (size_t i = 0; i < count; i++) {
+    packets_delivered++;
+    bytes_delivered += HCI_ACL_PREAMBLE_SIZE + fragments[i].payload_length;
+  }
+  if (send_transmit_finished) {
+    latency_recorder->Add(now_ns() - tx_start_ns);
+    osi_free(packet);
+  }
+}
+
+void on_reassembled(BT_HDR* packet) {
+  uint16_t handle = (packet->data[0] | (packet->data[1] << 8)) & 0x0fff;
+  latency_recorder->Add(now_ns() - link_start_ns[handle - kFirstHandle]);
+  packets_delivered++;
+  bytes_delivered += packet->len;
+  osi_free(packet);
+}
+
+void on_transmit_finished(BT_HDR* packet, bool all_fragments_sent) {
+  if (all_fragments_sent) osi_free(packet);
+}
+
+const packet_fragmenter_t* start_fragmenter(bool batched) {
+  static controller_t controller;
+  controller.get_acl_data_size_classic = get_acl_data_size_classic;
+  controller.get_acl_data_size_ble = get_acl_data_size_ble;
+
+  static packet_fragmenter_callbacks_t callbacks;
+  callbacks.fragmented = on_fragmented;
+  callbacks.reassembled = on_reassembled;
+  callbacks.transmit_finished = on_transmit_finished;
+  callbacks.fragments_ready = batched ? on_fragments_ready : NULL;
+
+  const packet_fragmenter_t* fragmenter =
+      packet_fragmenter_get_test_interface(&controller, &allocator_malloc);
+  fragmenter->init(&callbacks);
+  packets_delivered = 0;
+  bytes_delivered = 0;
+  return fragmenter;
+}
+
+// Sends |sdus_per_link| 1000 byte CoC SDUs from each of range(0) LE links.
+// Fragments of different links interleave, so every link has a partial
+// packet pending at the same time.
+void BM_AclLinksReassembly(State& state) {
+  const size_t links = state.range(0);
+  const size_t sdu_size = 1000;
+
+  std::vector<std::vector<std::vector<uint8_t>>> link_fragments;
+  for (size_t i = 0; i < links; i++) {
+    AclPacket sdu =
+        coc_acl_packet(kFirstHandle + i, kFirstDynamicCid + i, sdu_size,
+                       AclPacket::FirstAutomaticallyFlushable);
+    link_fragments.push_back(controller_fragments(sdu, kAclDataSizeBle));
+  }
+  const size_t rounds = link_fragments[0].size();
+
+  LatencyRecorder recorder;
+  latency_recorder = &recorder;
+  link_start_ns.assign(links, 0);
+  const packet_fragmenter_t* fragmenter = start_fragmenter(false);
+
+  for (auto _ : state) {
+    for (size_t round = 0; round < rounds; round++) {
+      for (size_t i = 0; i < links; i++) {
+        if (round == 0) link_start_ns[i] = now_ns();
+        fragmenter->reassemble_and_dispatch(
+            bt_hdr_from(link_fragments[i][round], MSG_HC_TO_STACK_HCI_ACL));
+      }
+    }
+  }
+
+  fragmenter->cleanup();
+  report_packets(state, state.iterations() * links * rounds, bytes_delivered);
+  recorder.Report(state);
+}
+
+// Transmits range(0) byte CoC SDUs over an LE link. range(1) selects the
+// batched fragment path used by HALs that take header/payload pairs.
+void BM_CocBulkTransmit(State& state) {
+  const size_t sdu_size = state.range(0);
+  const bool batched = state.range(1);
+
+  AclPacket sdu = coc_acl_packet(kFirstHandle, kFirstDynamicCid, sdu_size,
+                                 AclPacket::FirstNonAutomaticallyFlushable);
+
+  LatencyRecorder recorder;
+  latency_recorder = &recorder;
+  const packet_fragmenter_t* fragmenter = start_fragmenter(batched);
+
+  for (auto _ : state) {
+    tx_start_ns = now_ns();
+    fragmenter->fragment_and_dispatch(bt_hdr_from(
+        sdu.GetPacket(), MSG_STACK_TO_HC_HCI_ACL | LOCAL_BLE_CONTROLLER_ID));
+  }
+
+  fragmenter->cleanup();
+  report_packets(state, packets_delivered, bytes_delivered);
+  recorder.Report(state);
+}
+
+// Streams A2DP media packets (AVDTP/RTP header and seven 119 byte SBC
+// frames) over a classic link whose controller takes range(0) byte ACL
+// packets. Smaller controller buffers force every media packet to fragment.
+void BM_A2dpStream(State& state) {
+  const size_t media_size = 13 + 7 * 119;
+  acl_data_size_classic = state.range(0);
+
+  AclPacket media(kFirstHandle, AclPacket::FirstNonAutomaticallyFlushable,
+                  AclPacket::PointToPoint);
+  media.AddPayloadOctets2(media_size);
+  media.AddPayloadOctets2(kFirstDynamicCid);
+  media.AddPayloadOctets(media_size, std::vector<uint8_t>(media_size, 0x9c));
+
+  LatencyRecorder recorder;
+  latency_recorder = &recorder;
+  const packet_fragmenter_t* fragmenter = start_fragmenter(false);
+
+  for (auto _ : state) {
+    tx_start_ns = now_ns();
+    fragmenter->fragment_and_dispatch(bt_hdr_from(
+        media.GetPacket(),
+        MSG_STACK_TO_HC_HCI_ACL | LOCAL_BR_EDR_CONTROLLER_ID));
+  }
+
+  fragmenter->cleanup();
+  acl_data_size_classic = 1021;
+  report_packets(state, packets_delivered, bytes_delivered);
+  recorder.Report(state);
+}
+
+// Advertising report filter callbacks.
+uint64_t adv_oldest_pending_ns;
+
+void on_adv_dispatched(BT_HDR* packet) {
+  if (adv_oldest_pending_ns) {
+    latency_recorder->Add(now_ns() - adv_oldest_pending_ns);
+    adv_oldest_pending_ns = 0;
+  }
+  packets_delivered++;
+  bytes_delivered += packet->len;
+  osi_free(packet);
+}
+
+// range(0) beacons, modelled on BeaconSwarm, each advertise once per
+// millisecond of simulated time. Reports go through the advertising report
+// filter with a duplicate window of range(1) ms and batches of up to eight
+// reports; zero disables filtering so the raw dispatch cost is measured.
+void BM_BeaconFlood(State& state) {
+  const size_t beacons = state.range(0);
+  const period_ms_t duplicate_window_ms = state.range(1);
+
+  std::vector<uint8_t> adv_data = {0x02, BTM_BLE_AD_TYPE_FLAG,
+                                   BTM_BLE_BREDR_NOT_SPT,
+                                   0x0d, BTM_BLE_AD_TYPE_NAME_CMPL,
+                                   'c', 'b', 'e', 'a', 'c', 'o', 'n', ' '};
+  BtAddress address;
+  address.FromString("da:4c:10:de:17:00");
+
+  std::vector<std::vector<uint8_t>> events;
+  for (size_t i = 0; i < beacons; i++) {
+    std::unique_ptr<EventPacket> event =
+        EventPacket::CreateLeAdvertisingReportEvent();
+    event->AddLeAdvertisingReport(BTM_BLE_NON_CONNECT_EVT, BLE_ADDR_RANDOM,
+                                  address, adv_data, 0xc0);
+    std::vector<uint8_t> bytes = event->GetHeader();
+    bytes.insert(bytes.end(), event->GetPayload().begin(),
+                 event->GetPayload().end());
+    events.push_back(bytes);
+
+    // Same address rotation as BeaconSwarm::TimerTick.
+    std::vector<uint8_t> next;
+    address.ToVector(next);
+    next[0]++;
+    if (next[0] == 0) next[1]++;
+    address.FromVector(next);
+  }
+
+  adv_report_filter_config_t config = {duplicate_window_ms,
+                                       duplicate_window_ms ? 8u : 0u};
+  LatencyRecorder recorder;
+  latency_recorder = &recorder;
+  packets_delivered = 0;
+  bytes_delivered = 0;
+  const adv_report_filter_t* filter =
+      adv_report_filter_get_test_interface(&allocator_malloc);
+  filter->init(&config, on_adv_dispatched);
+
+  period_ms_t now_ms = 1;
+  for (auto _ : state) {
+    for (const std::vector<uint8_t>& event : events) {
+      if (!adv_oldest_pending_ns) adv_oldest_pending_ns = now_ns();
+      filter->process(bt_hdr_from(event, MSG_HC_TO_STACK_HCI_EVT), now_ms);
+    }
+    filter->flush();
+    adv_oldest_pending_ns = 0;
+    now_ms++;
+  }
+
+  adv_report_filter_stats_t stats;
+  filter->get_stats(&stats);
+  filter->cleanup();
+
+  report_packets(state, stats.reports_received, bytes_delivered);
+  state.counters["dropped"] = stats.duplicates_dropped;
+  state.counters["dispatched"] = packets_delivered;
+  recorder.Report(state);
+}
+
+}  // namespace
+
+// The fragmenter is only used through its test interface, which takes the
+// controller above.
+const controller_t* controller_get_interface() { return nullptr; }
+
+BENCHMARK(BM_AclLinksReassembly)->Arg(1)->Arg(8)->Arg(32);
+BENCHMARK(BM_CocBulkTransmit)
+    ->Args({512, 0})
+    ->Args({512, 1})
+    ->Args({4000, 0})
+    ->Args({4000, 1});
+BENCHMARK(BM_A2dpStream)->Arg(1021)->Arg(679)->Arg(367);
+BENCHMARK(BM_BeaconFlood)
+    ->Args({64, 0})
+    ->Args({64, 100})
+    ->Args({512, 100});
+
+int main(int argc, char** argv) {
+  ::benchmark::Initialize(&argc, argv);
+  if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  ::benchmark::RunSpecifiedBenchmarks();
+}
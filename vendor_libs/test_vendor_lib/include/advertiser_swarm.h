@@ -0,0 +1,105 @@
+//
+// Copyright 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "bt_address.h"
+#include "device.h"
+#include "stack/include/btm_ble_api.h"
+
+namespace test_vendor_lib {
+
+// Models a dense environment of non-connectable LE advertisers: each one has
+// its own advertising interval, a resolvable private address that it rotates
+// and advertising data that changes over time. The advertisers are kept in a
+// heap ordered by their next advertising event, so that a scan only touches
+// the advertisers it reports.
+class AdvertiserSwarm : public Device {
+ public:
+  AdvertiserSwarm();
+  virtual ~AdvertiserSwarm() = default;
+
+  // Set the number of advertisers, the range of their advertising intervals,
+  // the address rotation and data change periods and the random seed from
+  // string args:
+  //   advertiser_swarm <count> <min_ms> <max_ms> <rpa_ms> <data_ms> <seed>
+  virtual void Initialize(const std::vector<std::string>& args) override;
+
+  // Return a string representation of the type of device.
+  virtual std::string GetTypeString() const override {
+    return "advertiser_swarm";
+  }
+
+  // The advertisers are reported through ReportAdvertisements.
+  virtual bool IsAdvertisementAvailable(
+      std::chrono::milliseconds /* scan_time */) const override {
+    return false;
+  }
+
+  virtual void ReportAdvertisements(
+      std::chrono::milliseconds scan_time,
+      const AdvertisementCallback& report) override;
+
+  // Return the number of advertisers modelled.
+  size_t GetAdvertiserCount() const { return advertisers_.size(); }
+
+ private:
+  struct Advertiser {
+    BtAddress address;
+    uint8_t rssi;
+    std::chrono::milliseconds interval;
+    std::chrono::steady_clock::time_point next_event;
+    std::chrono::steady_clock::time_point address_expiry;
+    std::chrono::steady_clock::time_point data_expiry;
+    uint16_t data_counter;
+    std::vector<uint8_t> adv_data;
+  };
+
+  // Start every advertiser at a random point of its interval.
+  void CreateAdvertisers(size_t count);
+
+  void RotateAddress(Advertiser& advertiser);
+
+  void ChangeData(size_t index, Advertiser& advertiser);
+
+  std::chrono::milliseconds min_interval_ms_;
+  std::chrono::milliseconds max_interval_ms_;
+  std::chrono::milliseconds address_rotation_ms_;
+  std::chrono::milliseconds data_change_ms_;
+
+  std::mt19937 random_;
+  std::vector<Advertiser> advertisers_;
+
+  // Orders the heap so that the advertiser with the earliest event is first.
+  struct LaterEvent {
+    const AdvertiserSwarm* swarm;
+    bool operator()(size_t a, size_t b) const {
+      return swarm->advertisers_[a].next_event >
+             swarm->advertisers_[b].next_event;
+    }
+  };
+
+  // Indices into advertisers_, a heap on their next_event.
+  std::vector<size_t> schedule_;
+
+  static const size_t kMaxAdvertisers = 65536;
+};
+
+}  // namespace test_vendor_lib
@@ -18,6 +18,7 @@
 
 #include <chrono>
 #include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -81,6 +82,19 @@ class Device {
   virtual bool IsAdvertisementAvailable(
       std::chrono::milliseconds scan_time) const;
 
+  // Called with the advertising type, address type, address, advertising data
+  // and RSSI of each advertisement reported by ReportAdvertisements.
+  using AdvertisementCallback =
+      std::function<void(uint8_t, uint8_t, const BtAddress&,
+                         const std::vector<uint8_t>&, uint8_t)>;
+
+  // Calls |report| for each advertisement the host could see in the next
+  // |scan_time| milliseconds from the advertisers this device models, for
+  // devices that stand for more than one advertiser.
+  virtual void ReportAdvertisements(
+      std::chrono::milliseconds /* scan_time */,
+      const AdvertisementCallback& /* report */) {}
+
   // Returns true if the host could see a page scan now.
   virtual bool IsPageScanAvailable() const;
 
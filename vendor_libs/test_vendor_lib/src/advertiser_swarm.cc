@@ -0,0 +1,181 @@
+//
+// Copyright 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#define LOG_TAG "advertiser_swarm"
+
+#include "advertiser_swarm.h"
+
+#include <algorithm>
+
+#include "osi/include/log.h"
+#include "stack/include/hcidefs.h"
+
+using std::vector;
+
+namespace test_vendor_lib {
+
+// Advertising data bytes that change besides the counter.
+static const size_t kMaxChurnBytes = 16;
+
+// Manufacturer id reserved for testing.
+static const uint16_t kTestManufacturerId = 0xFFFF;
+
+// Bluetooth Core Specification Version 4.2, Volume 6, Part B, Section 4.4.2.2
+// Every advertising event is delayed by up to 10 ms, and the interval is at
+// least 20 ms.
+static const int kMaxAdvDelayMs = 10;
+static const int kMinIntervalMs = 20;
+
+AdvertiserSwarm::AdvertiserSwarm()
+    : min_interval_ms_(100),
+      max_interval_ms_(1280),
+      // The default rotation of the resolvable private address, 15 minutes.
+      address_rotation_ms_(15 * 60 * 1000),
+      data_change_ms_(1000) {
+  advertising_interval_ms_ = std::chrono::milliseconds(0);
+  advertising_type_ = BTM_BLE_NON_CONNECT_EVT;
+  address_type_ = kBtAddressTypeRandom;
+}
+
+void AdvertiserSwarm::Initialize(const vector<std::string>& args) {
+  size_t count = 1000;
+  if (args.size() > 1) count = std::stoul(args[1]);
+  if (args.size() > 2)
+    min_interval_ms_ = std::chrono::milliseconds(std::stoi(args[2]));
+  if (args.size() > 3)
+    max_interval_ms_ = std::chrono::milliseconds(std::stoi(args[3]));
+  if (args.size() > 4)
+    address_rotation_ms_ = std::chrono::milliseconds(std::stoi(args[4]));
+  if (args.size() > 5)
+    data_change_ms_ = std::chrono::milliseconds(std::stoi(args[5]));
+  if (args.size() > 6) random_.seed(std::stoul(args[6]));
+
+  min_interval_ms_ =
+      std::max(min_interval_ms_, std::chrono::milliseconds(kMinIntervalMs));
+  max_interval_ms_ = std::max(max_interval_ms_, min_interval_ms_);
+  if (count > kMaxAdvertisers) {
+    LOG_WARN(LOG_TAG, "%s: %zu advertisers, limited to %zu", __func__, count,
+             kMaxAdvertisers);
+    count = kMaxAdvertisers;
+  }
+
+  CreateAdvertisers(count);
+}
+
+void AdvertiserSwarm::CreateAdvertisers(size_t count) {
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  std::uniform_int_distribution<int> interval(min_interval_ms_.count(),
+                                              max_interval_ms_.count());
+  std::uniform_int_distribution<int> rssi(-100, -40);
+
+  advertisers_.clear();
+  advertisers_.resize(count);
+  schedule_.clear();
+  for (size_t i = 0; i < count; i++) {
+    Advertiser& advertiser = advertisers_[i];
+    advertiser.interval = std::chrono::milliseconds(interval(random_));
+    advertiser.rssi = static_cast<uint8_t>(rssi(random_));
+    advertiser.data_counter = 0;
+
+    // Spread the events, rotations and changes so they do not happen at once
+    std::uniform_int_distribution<int> offset(0, advertiser.interval.count());
+    advertiser.next_event = now + std::chrono::milliseconds(offset(random_));
+    RotateAddress(advertiser);
+    ChangeData(i, advertiser);
+    if (address_rotation_ms_.count() > 0) {
+      std::uniform_int_distribution<int> rotation(0,
+                                                  address_rotation_ms_.count());
+      advertiser.address_expiry =
+          now + std::chrono::milliseconds(rotation(random_));
+    }
+    if (data_change_ms_.count() > 0) {
+      std::uniform_int_distribution<int> change(0, data_change_ms_.count());
+      advertiser.data_expiry = now + std::chrono::milliseconds(change(random_));
+    }
+    schedule_.push_back(i);
+  }
+  std::make_heap(schedule_.begin(), schedule_.end(), LaterEvent{this});
+}
+
+void AdvertiserSwarm::RotateAddress(Advertiser& advertiser) {
+  // Bluetooth Core Specification Version 4.2, Volume 6, Part B, Section 1.3.2.2
+  // The two most significant bits of a resolvable private address are 0b01.
+  // The hash is random as well, like that of a peer the host has no IRK for.
+  vector<uint8_t> octets(BtAddress::kOctets);
+  for (auto& octet : octets) octet = static_cast<uint8_t>(random_());
+  uint8_t& msb = octets[BtAddress::kOctets - 1];
+  msb = (msb & 0x3f) | 0x40;
+  advertiser.address.FromVector(octets);
+  advertiser.address_expiry += address_rotation_ms_;
+}
+
+void AdvertiserSwarm::ChangeData(size_t index, Advertiser& advertiser) {
+  std::uniform_int_distribution<size_t> churn(0, kMaxChurnBytes);
+  size_t churn_bytes = churn(random_);
+
+  advertiser.data_counter++;
+  advertiser.adv_data = {0x02,  // Length
+                         BTM_BLE_AD_TYPE_FLAG,
+                         BTM_BLE_BREDR_NOT_SPT,
+                         static_cast<uint8_t>(7 + churn_bytes),  // Length
+                         HCI_EIR_MANUFACTURER_SPECIFIC_TYPE,
+                         kTestManufacturerId & 0xff,
+                         kTestManufacturerId >> 8,
+                         static_cast<uint8_t>(index & 0xff),
+                         static_cast<uint8_t>(index >> 8),
+                         static_cast<uint8_t>(advertiser.data_counter & 0xff),
+                         static_cast<uint8_t>(advertiser.data_counter >> 8)};
+  for (size_t i = 0; i < churn_bytes; i++) {
+    advertiser.adv_data.push_back(static_cast<uint8_t>(random_()));
+  }
+  advertiser.data_expiry += data_change_ms_;
+}
+
+void AdvertiserSwarm::ReportAdvertisements(
+    std::chrono::milliseconds scan_time, const AdvertisementCallback& report) {
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point horizon = now + scan_time;
+  std::uniform_int_distribution<int> adv_delay(0, kMaxAdvDelayMs);
+
+  while (!schedule_.empty() &&
+         advertisers_[schedule_.front()].next_event <= horizon) {
+    std::pop_heap(schedule_.begin(), schedule_.end(), LaterEvent{this});
+    size_t index = schedule_.back();
+    Advertiser& advertiser = advertisers_[index];
+
+    if (address_rotation_ms_.count() > 0 && advertiser.address_expiry <= now) {
+      advertiser.address_expiry = now;
+      RotateAddress(advertiser);
+    }
+    if (data_change_ms_.count() > 0 && advertiser.data_expiry <= now) {
+      advertiser.data_expiry = now;
+      ChangeData(index, advertiser);
+    }
+
+    report(advertising_type_, address_type_, advertiser.address,
+           advertiser.adv_data, advertiser.rssi);
+
+    // Once per scan at most, even if the host did not scan for a while
+    advertiser.next_event += advertiser.interval +
+                             std::chrono::milliseconds(adv_delay(random_));
+    if (advertiser.next_event <= horizon) {
+      advertiser.next_event = horizon + std::chrono::milliseconds(1);
+    }
+    std::push_heap(schedule_.begin(), schedule_.end(), LaterEvent{this});
+  }
+}
+
+}  // namespace test_vendor_lib
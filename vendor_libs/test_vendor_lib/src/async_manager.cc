@@ -22,12 +22,14 @@
 
 #include <algorithm>
 #include <atomic>
+#include <cerrno>
 #include <condition_variable>
+#include <cstring>
 #include <mutex>
 #include <thread>
 #include <vector>
 #include "fcntl.h"
-#include "sys/select.h"
+#include "sys/epoll.h"
 #include "unistd.h"
 
 namespace test_vendor_lib {
@@ -41,9 +43,11 @@ namespace test_vendor_lib {
 // After construction of this objects nothing happens beyond some very simple
 // member initialization. When the first FD is set up for watching the object
 // starts a new thread which watches the given (and later provided) FDs using
-// select() inside a loop. A special FD (a pipe) is also watched which is
-// used to notify the thread of internal changes on the object state (like
-// the addition of new FDs to watch on). Every access to internal state is
+// epoll inside a loop, so that the cost of a wake up does not grow with the
+// number of FDs watched and FDs are not limited to FD_SETSIZE. FDs are added
+// to and removed from the epoll set as they are (un)watched. A special FD (a
+// pipe) is also watched which is used to wake the thread up when it has to
+// stop. Every access to internal state is
 // synchronized using a single internal mutex. The thread is only stopped on
 // destruction of the object, by modifying a flag, which is the only member
 // variable accessed without acquiring the lock (because the notification to
@@ -59,10 +63,12 @@ namespace test_vendor_lib {
 // is started which monitors a queue of tasks. The queue is peeked to see
 // when the next task should be carried out and then the thread performs a
 // (absolute) timed wait on a condition variable. The wait ends because of a
-// time out or a notify on the cond var, the former means a task is due
-// for execution while the later means there has been a change in internal
-// state, like a task has been scheduled/canceled or the flag to stop has
-// been set. Setting and querying the stop flag or modifying the task queue
+// time out or a notify on the cond var, the former means one or more tasks
+// are due for execution while the later means there has been a change in
+// internal state, like a task has been scheduled/canceled or the flag to stop
+// has been set. All the tasks that are due are run before waiting again, and
+// a periodic task that fell more than a period behind skips the runs it
+// missed rather than running them back to back. Setting and querying the stop flag or modifying the task queue
 // and subsequent notification on the cond var is done atomically (e.g while
 // holding the lock on the internal mutex) to ensure that the thread never
 // misses the notification, since notifying a cond var is not persistent as
@@ -81,6 +87,9 @@ static const uint16_t kMaxTaskId =
 static inline AsyncTaskId NextAsyncTaskId(const AsyncTaskId id) {
   return (id == kMaxTaskId) ? 1 : id + 1;
 }
+// Maximum number of FD events handled per wake up of the watcher thread
+static const int kMaxEpollEvents = 64;
+
 // The buffer is only 10 bytes because the expected number of bytes
 // written on this socket is 1. It is possible that the thread is notified
 // more than once but highly unlikely, so a buffer of size 10 seems enough
@@ -98,12 +107,6 @@ class AsyncManager::AsyncFdWatcher {
  public:
   int WatchFdForNonBlockingReads(
       int file_descriptor, const ReadCallback& on_read_fd_ready_callback) {
-    // add file descriptor and callback
-    {
-      std::unique_lock<std::mutex> guard(internal_mutex_);
-      watched_shared_fds_[file_descriptor] = on_read_fd_ready_callback;
-    }
-
     // start the thread if not started yet
     int started = tryStartThread();
     if (started != 0) {
@@ -111,15 +114,29 @@ class AsyncManager::AsyncFdWatcher {
       return started;
     }
 
-    // notify the thread so that it knows of the new FD
-    notifyThread();
-
+    // add file descriptor and callback, the thread sees it on its next wait
+    std::unique_lock<std::mutex> guard(internal_mutex_);
+    bool watched = watched_shared_fds_.count(file_descriptor) != 0;
+    watched_shared_fds_[file_descriptor] = on_read_fd_ready_callback;
+    if (watched) return 0;
+
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = file_descriptor;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, file_descriptor, &event) < 0) {
+      LOG_ERROR(LOG_TAG, "%s: Unable to watch fd %d: %s", __func__,
+                file_descriptor, strerror(errno));
+      watched_shared_fds_.erase(file_descriptor);
+      return -1;
+    }
     return 0;
   }
 
   void StopWatchingFileDescriptor(int file_descriptor) {
     std::unique_lock<std::mutex> guard(internal_mutex_);
-    watched_shared_fds_.erase(file_descriptor);
+    if (watched_shared_fds_.erase(file_descriptor) == 0) return;
+    // events already returned for the FD are dropped since it has no callback
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, file_descriptor, NULL);
   }
 
   AsyncFdWatcher() = default;
@@ -133,8 +150,10 @@ class AsyncManager::AsyncFdWatcher {
 
     notifyThread();
 
+    bool joined = false;
     if (std::this_thread::get_id() != thread_.get_id()) {
       thread_.join();
+      joined = true;
     } else {
       LOG_WARN(LOG_TAG,
                "%s: Starting thread stop from inside the reading thread itself",
@@ -144,6 +163,13 @@ class AsyncManager::AsyncFdWatcher {
     {
       std::unique_lock<std::mutex> guard(internal_mutex_);
       watched_shared_fds_.clear();
+      // a thread still running would wait on the closed FDs otherwise
+      if (joined) {
+        close(epoll_fd_);
+        close(notification_listen_fd_);
+        close(notification_write_fd_);
+        epoll_fd_ = -1;
+      }
     }
 
     return 0;
@@ -171,6 +197,20 @@ class AsyncManager::AsyncFdWatcher {
     notification_listen_fd_ = pipe_fds[0];
     notification_write_fd_ = pipe_fds[1];
 
+    {
+      std::unique_lock<std::mutex> guard(internal_mutex_);
+      epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+      struct epoll_event event = {};
+      event.events = EPOLLIN;
+      event.data.fd = notification_listen_fd_;
+      if (epoll_fd_ < 0 || epoll_ctl(epoll_fd_, EPOLL_CTL_ADD,
+                                     notification_listen_fd_, &event) < 0) {
+        LOG_ERROR(LOG_TAG, "%s: Unable to set up epoll: %s", __func__,
+                  strerror(errno));
+        return -1;
+      }
+    }
+
     thread_ = std::thread([this]() { ThreadRoutine(); });
     if (!thread_.joinable()) {
       LOG_ERROR(LOG_TAG, "%s: Unable to start reading thread", __func__);
@@ -189,62 +229,42 @@ class AsyncManager::AsyncFdWatcher {
     return 0;
   }
 
-  int setUpFileDescriptorSet(fd_set& read_fds) {
-    // add comm channel to the set
-    FD_SET(notification_listen_fd_, &read_fds);
-    int nfds = notification_listen_fd_;
-
-    // add watched FDs to the set
-    {
-      std::unique_lock<std::mutex> guard(internal_mutex_);
-      for (auto& fdp : watched_shared_fds_) {
-        FD_SET(fdp.first, &read_fds);
-        nfds = std::max(fdp.first, nfds);
-      }
+  // read everything there is on the comm channel
+  void consumeThreadNotifications() {
+    char buffer[kNotificationBufferSize];
+    while (TEMP_FAILURE_RETRY(read(notification_listen_fd_, buffer,
+                                   kNotificationBufferSize)) ==
+           kNotificationBufferSize) {
     }
-    return nfds;
   }
 
-  // check the comm channel and read everything there
-  bool consumeThreadNotifications(fd_set& read_fds) {
-    if (FD_ISSET(notification_listen_fd_, &read_fds)) {
-      char buffer[kNotificationBufferSize];
-      while (TEMP_FAILURE_RETRY(read(notification_listen_fd_, buffer,
-                                     kNotificationBufferSize)) ==
-             kNotificationBufferSize) {
-      }
-      return true;
-    }
-    return false;
-  }
+  // call the callbacks of the FDs that are ready
+  void runAppropriateCallbacks(const struct epoll_event* events, int count) {
+    for (int i = 0; i < count; i++) {
+      int fd = events[i].data.fd;
+      if (fd == notification_listen_fd_) continue;
 
-  // check all file descriptors and call callbacks if necesary
-  void runAppropriateCallbacks(fd_set& read_fds) {
-    // not a good idea to call a callback while holding the FD lock,
-    // nor to release the lock while traversing the map
-    std::vector<decltype(watched_shared_fds_)::value_type> fds;
-    {
-      std::unique_lock<std::mutex> guard(internal_mutex_);
-      for (auto& fdc : watched_shared_fds_) {
-        if (FD_ISSET(fdc.first, &read_fds)) {
-          fds.push_back(fdc);
-        }
+      // not a good idea to call a callback while holding the FD lock, and an
+      // earlier callback may have stopped watching this FD
+      ReadCallback callback;
+      {
+        std::unique_lock<std::mutex> guard(internal_mutex_);
+        auto it = watched_shared_fds_.find(fd);
+        if (it == watched_shared_fds_.end()) continue;
+        callback = it->second;
       }
-    }
-    for (auto& p : fds) {
-      p.second(p.first);
+      // hang ups are reported too, the callback reads the EOF
+      callback(fd);
     }
   }
 
   void ThreadRoutine() {
+    struct epoll_event events[kMaxEpollEvents];
     while (running_) {
-      fd_set read_fds;
-      FD_ZERO(&read_fds);
-      int nfds = setUpFileDescriptorSet(read_fds);
-
       // wait until there is data available to read on some FD
-      int retval = select(nfds + 1, &read_fds, NULL, NULL, NULL);
-      if (retval <= 0) {  // there was some error or a timeout
+      int count = epoll_wait(epoll_fd_, events, kMaxEpollEvents, -1);
+      if (count <= 0) {  // there was some error or an interrupt
+        if (count < 0 && errno == EINTR) continue;
         LOG_ERROR(LOG_TAG,
                   "%s: There was an error while waiting for data on the file "
                   "descriptors",
@@ -252,14 +272,18 @@ class AsyncManager::AsyncFdWatcher {
         continue;
       }
 
-      consumeThreadNotifications(read_fds);
+      for (int i = 0; i < count; i++) {
+        if (events[i].data.fd == notification_listen_fd_) {
+          consumeThreadNotifications();
+        }
+      }
 
       // Do not read if there was a call to stop running
       if (!running_) {
         break;
       }
 
-      runAppropriateCallbacks(read_fds);
+      runAppropriateCallbacks(events, count);
     }
   }
 
@@ -269,6 +293,9 @@ class AsyncManager::AsyncFdWatcher {
 
   std::map<int, ReadCallback> watched_shared_fds_;
 
+  // The epoll instance the watched FDs and the comm channel are added to
+  int epoll_fd_ = -1;
+
   // A pair of FD to send information to the reading thread
   int notification_listen_fd_;
   int notification_write_fd_;
@@ -422,29 +449,45 @@ class AsyncManager::AsyncTaskManager {
     return 0;
   }
 
+  // Take the first task of the queue if it is due at |now|. The task is
+  // removed, or moved to its next period, before it runs so that it can
+  // cancel or reschedule itself.
+  bool takeDueTask(std::chrono::steady_clock::time_point now,
+                   TaskCallback* callback) {
+    std::unique_lock<std::mutex> guard(internal_mutex_);
+    if (task_queue_.empty()) return false;
+    std::shared_ptr<Task> task_p = *(task_queue_.begin());
+    if (task_p->time > now) return false;
+
+    *callback = task_p->callback;
+    task_queue_.erase(task_queue_.begin());  // need to remove and add again if
+                                             // periodic to update order
+    if (task_p->isPeriodic()) {
+      task_p->time += task_p->period;
+      if (task_p->time <= now) {
+        // skip the periods that were missed, a zero period runs once a round
+        task_p->time =
+            task_p->period.count() > 0
+                ? task_p->time +
+                      ((now - task_p->time) / task_p->period + 1) *
+                          task_p->period
+                : now + std::chrono::steady_clock::duration(1);
+      }
+      task_queue_.insert(task_p);
+    } else {
+      tasks_by_id.erase(task_p->task_id);
+    }
+    return true;
+  }
+
   void ThreadRoutine() {
     while (1) {
+      // run everything that is due now, a task becoming due while the others
+      // run is left for the next round so that the loop always ends
+      std::chrono::steady_clock::time_point now =
+          std::chrono::steady_clock::now();
       TaskCallback callback;
-      bool run_it = false;
-      {
-        std::unique_lock<std::mutex> guard(internal_mutex_);
-        if (!task_queue_.empty()) {
-          std::shared_ptr<Task> task_p = *(task_queue_.begin());
-          if (task_p->time < std::chrono::steady_clock::now()) {
-            run_it = true;
-            callback = task_p->callback;
-            task_queue_.erase(task_p);  // need to remove and add again if
-                                        // periodic to update order
-            if (task_p->isPeriodic()) {
-              task_p->time += task_p->period;
-              task_queue_.insert(task_p);
-            } else {
-              tasks_by_id.erase(task_p->task_id);
-            }
-          }
-        }
-      }
-      if (run_it) {
+      while (takeDueTask(now, &callback)) {
         callback();
       }
       {
@@ -17,6 +17,7 @@
 #define LOG_TAG "device_factory"
 
 #include "device_factory.h"
+#include "advertiser_swarm.h"
 #include "beacon.h"
 #include "beacon_swarm.h"
 #include "broken_adv.h"
@@ -35,6 +36,8 @@ std::shared_ptr<Device> DeviceFactory::Create(const vector<std::string>& args) {
 
   std::shared_ptr<Device> new_device = nullptr;
 
+  if (args[0] == "advertiser_swarm")
+    new_device = std::make_shared<AdvertiserSwarm>();
   if (args[0] == "beacon") new_device = std::make_shared<Beacon>();
   if (args[0] == "beacon_swarm") new_device = std::make_shared<BeaconSwarm>();
   if (args[0] == "broken_adv") new_device = std::make_shared<BrokenAdv>();
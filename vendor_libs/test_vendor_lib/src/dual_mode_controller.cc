@@ -315,6 +315,25 @@ void DualModeController::Connections() {
 void DualModeController::LeScan() {
   std::unique_ptr<EventPacket> le_adverts =
       EventPacket::CreateLeAdvertisingReportEvent();
+  if (le_scan_enable_) {
+    auto report = [this, &le_adverts](uint8_t adv_type, uint8_t addr_type,
+                                      const BtAddress& addr,
+                                      const vector<uint8_t>& ad,
+                                      uint8_t rssi) {
+      if (!le_adverts->AddLeAdvertisingReport(adv_type, addr_type, addr, ad,
+                                              rssi)) {
+        send_event_(std::move(le_adverts));
+        le_adverts = EventPacket::CreateLeAdvertisingReportEvent();
+        CHECK(le_adverts->AddLeAdvertisingReport(adv_type, addr_type, addr, ad,
+                                                 rssi));
+      }
+    };
+    for (size_t dev = 0; dev < devices_.size(); dev++) {
+      devices_[dev]->ReportAdvertisements(
+          std::chrono::milliseconds(le_scan_window_), report);
+    }
+  }
+
   vector<uint8_t> ad;
   for (size_t dev = 0; dev < devices_.size(); dev++) {
     uint8_t adv_type;
@@ -0,0 +1,86 @@
+//
+// Copyright 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "advertiser_swarm.h"
+
+#include <gtest/gtest.h>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::vector;
+
+namespace test_vendor_lib {
+
+class AdvertiserSwarmTest : public ::testing::Test {
+ protected:
+  // Scan for |scan_time| and return the data reported per address.
+  std::map<std::string, vector<vector<uint8_t>>> Scan(
+      std::chrono::milliseconds scan_time) {
+    std::map<std::string, vector<vector<uint8_t>>> reports;
+    swarm_.ReportAdvertisements(
+        scan_time, [&reports](uint8_t adv_type, uint8_t addr_type,
+                              const BtAddress& addr, const vector<uint8_t>& ad,
+                              uint8_t /* rssi */) {
+          EXPECT_EQ(BTM_BLE_NON_CONNECT_EVT, adv_type);
+          EXPECT_EQ(+Device::kBtAddressTypeRandom, addr_type);
+          EXPECT_GE(31u, ad.size());
+          reports[addr.ToString()].push_back(ad);
+        });
+    return reports;
+  }
+
+  AdvertiserSwarm swarm_;
+};
+
+TEST_F(AdvertiserSwarmTest, EveryAdvertiserOncePerScan) {
+  swarm_.Initialize({"advertiser_swarm", "3000", "20", "40", "0", "0", "1"});
+  EXPECT_EQ(3000u, swarm_.GetAdvertiserCount());
+
+  auto reports = Scan(std::chrono::milliseconds(1000));
+  EXPECT_EQ(3000u, reports.size());
+  for (const auto& report : reports) {
+    EXPECT_EQ(1u, report.second.size());
+    // Resolvable private addresses, 0b01 in the two most significant bits
+    EXPECT_NE(std::string::npos, std::string("4567").find(report.first[0]));
+  }
+}
+
+TEST_F(AdvertiserSwarmTest, AddressesAndDataChange) {
+  swarm_.Initialize({"advertiser_swarm", "500", "20", "40", "1", "1", "2"});
+
+  auto first = Scan(std::chrono::milliseconds(100));
+  EXPECT_EQ(500u, first.size());
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+  auto second = Scan(std::chrono::milliseconds(1000));
+  EXPECT_EQ(500u, second.size());
+  for (const auto& report : second) {
+    EXPECT_EQ(0u, first.count(report.first));
+  }
+}
+
+TEST_F(AdvertiserSwarmTest, SilentUntilNextInterval) {
+  swarm_.Initialize({"advertiser_swarm", "100", "1000", "1000", "0", "0", "3"});
+
+  // Every advertiser reported once in the first interval
+  EXPECT_EQ(100u, Scan(std::chrono::milliseconds(1000)).size());
+  // but none again before it starts over
+  EXPECT_EQ(0u, Scan(std::chrono::milliseconds(0)).size());
+}
+
+}  // namespace test_vendor_lib
@@ -16,8 +16,10 @@
 
 #include "async_manager.h"
 #include <gtest/gtest.h>
+#include <atomic>
 #include <cstdint>
 #include <cstring>
+#include <thread>
 #include <vector>
 
 #include <netdb.h>
@@ -171,4 +173,32 @@ TEST_F(AsyncManagerSocketTest, TestMultipleConnections) {
   }
 }
 
+TEST(AsyncManagerTaskTest, TestManyTasksDueTogether) {
+  static const int num_tasks = 5000;
+  AsyncManager async_manager;
+  std::atomic<int> runs(0);
+  for (int i = 0; i < num_tasks; i++) {
+    EXPECT_NE(kInvalidTaskId,
+              async_manager.ExecAsync(std::chrono::milliseconds(10),
+                                      [&runs]() { runs++; }));
+  }
+  for (int i = 0; i < 200 && runs < num_tasks; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(num_tasks, runs);
+}
+
+TEST(AsyncManagerTaskTest, TestPeriodicTaskCancelsItself) {
+  AsyncManager async_manager;
+  std::atomic<int> runs(0);
+  std::atomic<AsyncTaskId> task_id(kInvalidTaskId);
+  task_id = async_manager.ExecAsyncPeriodically(
+      std::chrono::milliseconds(0), std::chrono::milliseconds(1),
+      [&async_manager, &runs, &task_id]() {
+        if (++runs == 3) async_manager.CancelAsyncTask(task_id);
+      });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(3, runs);
+}
+
 }  // namespace test_vendor_lib